@@ -0,0 +1,37 @@
+# ------------------------------------------------------------------------------------------------ #
+#                                This file is part of CosmoScout VR                                #
+# ------------------------------------------------------------------------------------------------ #
+
+# SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+# SPDX-License-Identifier: MIT
+
+# Locate header.
+find_path(ITT_INCLUDE_DIR ittnotify.h
+    HINTS ${ITT_ROOT_DIR}/include)
+
+# Locate library.
+find_library(ITT_LIBRARY NAMES ittnotify libittnotify ittnotify64 libittnotify64
+    HINTS ${ITT_ROOT_DIR}/lib ${ITT_ROOT_DIR}/lib64)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ITT DEFAULT_MSG ITT_INCLUDE_DIR ITT_LIBRARY)
+
+# Add imported target.
+if(ITT_FOUND)
+    set(ITT_INCLUDE_DIRS "${ITT_INCLUDE_DIR}")
+
+    if(NOT ITT_FIND_QUIETLY)
+        message(STATUS "ITT_INCLUDE_DIRS .............. ${ITT_INCLUDE_DIR}")
+        message(STATUS "ITT_LIBRARY ................... ${ITT_LIBRARY}")
+    endif()
+
+    if(NOT TARGET itt::itt)
+        add_library(itt::itt UNKNOWN IMPORTED)
+        set_target_properties(itt::itt PROPERTIES
+            INTERFACE_INCLUDE_DIRECTORIES "${ITT_INCLUDE_DIRS}"
+            INTERFACE_LINK_LIBRARIES "${CMAKE_DL_LIBS}")
+
+        set_property(TARGET itt::itt APPEND PROPERTY
+            IMPORTED_LOCATION "${ITT_LIBRARY}")
+    endif()
+endif()
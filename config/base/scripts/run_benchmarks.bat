@@ -0,0 +1,31 @@
+@echo off
+
+rem ---------------------------------------------------------------------------------------------- #
+rem                               This file is part of CosmoScout VR                               #
+rem ---------------------------------------------------------------------------------------------- #
+
+rem SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+rem SPDX-License-Identifier: CC0-1.0
+
+rem If a file name is passed to this script, the results are appended to this file as JSON lines.
+if not "%~1"=="" set COSMOSCOUT_BENCHMARK_REPORT=%~f1
+
+rem Change working directory to the location of this script.
+set SCRIPT_DIR=%~dp0
+set CURRENT_DIR=%cd%
+cd "%SCRIPT_DIR%"
+
+rem Set paths so that all libraries are found.
+set PATH=%SCRIPT_DIR%\..\lib;%PATH%
+
+rem Run only the micro benchmarks. They are skipped by default, so --no-skip is required.
+cosmoscout.exe --run-tests --no-skip --test-case="*[benchmark]*"
+set RESULT=%ERRORLEVEL%
+
+rem Go back to where we came from
+cd "%CURRENT_DIR%"
+
+@echo on
+
+@rem Return the result of the benchmarks.
+@exit /b %RESULT%
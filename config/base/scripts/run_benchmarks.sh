@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# ------------------------------------------------------------------------------------------------ #
+#                                This file is part of CosmoScout VR                                #
+# ------------------------------------------------------------------------------------------------ #
+
+# SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+# SPDX-License-Identifier: CC0-1.0
+
+# If a file name is passed to this script, the results are appended to this file as JSON lines.
+if [ -n "$1" ]; then
+  export COSMOSCOUT_BENCHMARK_REPORT="$( cd "$( dirname "$1" )" && pwd )/$( basename "$1" )"
+fi
+
+# Change working directory to the location of this script.
+SCRIPT_DIR="$( cd "$( dirname "$0" )" && pwd )"
+cd "$SCRIPT_DIR"
+
+# Set paths so that all libraries are found.
+export LD_LIBRARY_PATH=../lib:../lib/DriverPlugins:$LD_LIBRARY_PATH
+
+# Run only the micro benchmarks. They are skipped by default, so --no-skip is required.
+./cosmoscout --run-tests --no-skip --test-case="*[benchmark]*"
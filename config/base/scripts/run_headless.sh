@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# ------------------------------------------------------------------------------------------------ #
+#                                This file is part of CosmoScout VR                                #
+# ------------------------------------------------------------------------------------------------ #
+
+# SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+# SPDX-License-Identifier: CC0-1.0
+
+# This script runs a benchmark script without a physical display. It can be used on continuous
+# integration machines to track the rendering performance. Usage:
+#   ./run_headless.sh <benchmark.json> [settings.json]
+
+if [ -z "$1" ]; then
+  echo "Usage: $0 <benchmark.json> [settings.json]"
+  exit 1
+fi
+
+# Relative paths inside the benchmark script are resolved relative to the bin directory.
+BENCHMARK="$( cd "$( dirname "$1" )" && pwd )/$( basename "$1" )"
+
+# Change working directory to the location of this script.
+SCRIPT_DIR="$( cd "$( dirname "$0" )" && pwd )"
+cd "$SCRIPT_DIR"
+
+# Scene config file can be passed as second parameter.
+SETTINGS="${2:-../share/config/simple_desktop.json}"
+
+# Set paths so that all libraries are found.
+export LD_LIBRARY_PATH=../lib:../lib/DriverPlugins:$LD_LIBRARY_PATH
+export VISTACORELIBS_DRIVER_PLUGIN_DIRS=../lib/DriverPlugins
+
+# An X-Server with a virtual framebuffer provides the window. Without further setup, MESA's software
+# rasterizer is used for rendering. If VirtualGL is installed and VGL_DISPLAY points to a GPU (for
+# example VGL_DISPLAY=egl or VGL_DISPLAY=/dev/dri/card0), the OpenGL commands are executed on this
+# GPU using EGL instead. This way, the GPU of a continuous integration runner can be used without a
+# display attached to it.
+LAUNCHER=""
+if [ -n "$VGL_DISPLAY" ] && command -v vglrun > /dev/null; then
+  LAUNCHER="vglrun -d $VGL_DISPLAY"
+fi
+
+xvfb-run --auto-servernum --server-args="-screen 0 1280x720x24" \
+  $LAUNCHER ./cosmoscout --settings="$SETTINGS" \
+  --benchmark="$BENCHMARK" -vistaini vista_headless.ini
@@ -117,10 +117,17 @@ class CSL_NODE_EDITOR_EXPORT Node {
   void writeOutput(std::string const& socket, T const& value) {
     auto connections = mGraph->getOutputConnections(mID, socket);
 
+    // The value is only copied once for all connections which need an update.
+    std::shared_ptr<std::any const> data;
+
     for (auto& c : connections) {
-      if (!c->mData.has_value() || std::any_cast<T>(c->mData) != value) {
+      if (!c->mData || std::any_cast<T const&>(*c->mData) != value) {
+        if (!data) {
+          data = std::make_shared<std::any const>(value);
+        }
+
         mGraph->queueProcess(c->mToNode);
-        c->mData = value;
+        c->mData = data;
       }
     }
   }
@@ -135,8 +142,8 @@ class CSL_NODE_EDITOR_EXPORT Node {
   T readInput(std::string const& socket, T defaultValue) {
     auto const* connection = mGraph->getInputConnection(mID, socket);
 
-    if (connection && connection->mData.has_value()) {
-      return std::any_cast<T>(connection->mData);
+    if (connection && connection->mData) {
+      return std::any_cast<T>(*connection->mData);
     }
 
     return std::move(defaultValue);
@@ -221,6 +221,9 @@ void NodeEditor::update() {
   } catch (std::exception const& e) {
     logger().error("Failed to process node graph: {}", e.what());
   }
+
+  // All messages which have been sent to the client during this frame are sent at once.
+  mSocket->flushEvents();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -38,6 +38,16 @@ std::optional<CommunicationChannel::Event> CommunicationChannel::getNextEvent()
   if (!mEventQueue.empty()) {
     auto event = mEventQueue.front();
     mEventQueue.pop();
+
+    // A new client does not know any previous messages. If the JavaScript counterpart of a node
+    // sends a message, its state may have changed, so the next message to it has to be sent in any
+    // case.
+    if (event.mType == Event::Type::eConnectionEstablished) {
+      mLastNodeMessages.clear();
+    } else if (event.mType == Event::Type::eNodeMessage) {
+      mLastNodeMessages.erase(event.mData.value("toNode", 0U));
+    }
+
     return event;
   }
 
@@ -47,13 +57,38 @@ std::optional<CommunicationChannel::Event> CommunicationChannel::getNextEvent()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void CommunicationChannel::sendEvent(CommunicationChannel::Event const& event) const {
-  if (isConnected()) {
+  if (!isConnected()) {
+    return;
+  }
 
-    nlohmann::json json   = {{"type", event.mType}, {"data", event.mData}};
-    auto           string = json.dump();
+  // Loading a graph re-creates all nodes on the client.
+  if (event.mType == Event::Type::eLoadGraph) {
+    mLastNodeMessages.clear();
+  }
 
+  if (event.mType == Event::Type::eNodeMessage) {
+    uint32_t toNode = event.mData["toNode"];
+    auto     last   = mLastNodeMessages.find(toNode);
+
+    if (last != mLastNodeMessages.end() && last->second == event.mData["message"]) {
+      return;
+    }
+
+    mLastNodeMessages[toNode] = event.mData["message"];
+  }
+
+  mOutgoingEvents.push_back({{"type", event.mType}, {"data", event.mData}});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CommunicationChannel::flushEvents() {
+  if (isConnected() && !mOutgoingEvents.empty()) {
+    auto string = mOutgoingEvents.dump();
     mg_websocket_write(mConnection, MG_WEBSOCKET_OPCODE_TEXT, string.c_str(), string.size());
   }
+
+  mOutgoingEvents = nlohmann::json::array();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,8 @@
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <queue>
+#include <unordered_map>
+#include <vector>
 
 namespace csl::nodeeditor {
 
@@ -121,11 +123,18 @@ class CommunicationChannel : public CivetWebSocketHandler {
   /// @return The next event from the event queue.
   std::optional<Event> getNextEvent();
 
-  /// Sends an event to the connected client (if any).
+  /// Queues an event for the connected client (if any). The events are sent by flushEvents().
+  /// A node message is dropped if it is identical to the last message sent to its node, as the
+  /// JavaScript counterpart of the node already received it.
   /// @param event The event to send. The data object must contain the type-dependent fields as
   ///              described above.
   void sendEvent(Event const& event) const;
 
+  /// Sends all events queued since the last call as a single web socket message containing a JSON
+  /// array of events. This is called by the node editor once each frame, so that a graph updating
+  /// at frame rate does not flood the web socket with small messages.
+  void flushEvents();
+
   /// Get whether there is a client connected currently.
   /// @return True if there is a client connected.
   bool isConnected() const;
@@ -140,6 +149,10 @@ class CommunicationChannel : public CivetWebSocketHandler {
   std::queue<Event> mEventQueue;
   std::mutex        mEventQueueMutex;
 
+  // These are only accessed from the main thread.
+  mutable nlohmann::json                               mOutgoingEvents = nlohmann::json::array();
+  mutable std::unordered_map<uint32_t, nlohmann::json> mLastNodeMessages;
+
   mg_connection* mConnection = nullptr;
 };
 
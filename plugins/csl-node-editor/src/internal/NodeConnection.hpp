@@ -9,13 +9,15 @@
 #define CSL_NODE_EDITOR_NODE_CONNECTION_HPP
 
 #include <any>
+#include <memory>
 #include <string>
 
 namespace csl::nodeeditor {
 
 /// A NodeConnection is the C++ counterpart of the wiggly line connecting an output socket to an
 /// input socket of two nodes. It is used for transmitting data from one node to the other by means
-/// of a std::any.
+/// of a std::any. All connections of an output socket share the same instance of the written value,
+/// so large values are not copied for each connection.
 struct NodeConnection {
   NodeConnection(uint32_t fromNode, std::string fromSocket, uint32_t toNode, std::string toSocket)
       : mFromNode(fromNode)
@@ -30,7 +32,7 @@ struct NodeConnection {
   uint32_t    mToNode;
   std::string mToSocket;
 
-  mutable std::any mData;
+  mutable std::shared_ptr<std::any const> mData;
 };
 
 } // namespace csl::nodeeditor
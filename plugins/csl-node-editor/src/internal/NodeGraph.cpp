@@ -9,6 +9,9 @@
 
 #include "../Node.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace csl::nodeeditor {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -65,18 +68,24 @@ void NodeGraph::clear() {
   mNodes.clear();
   mDirtyNodes.clear();
   mConnections.clear();
+  mInputConnections.clear();
+  mOutputConnections.clear();
+  mExecutionOrder.clear();
+  mExecutionOrderDirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void NodeGraph::addNode(uint32_t id, std::unique_ptr<Node> node) {
   mNodes.emplace(id, std::move(node));
+  mExecutionOrderDirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void NodeGraph::removeNode(uint32_t id) {
   mNodes.erase(id);
+  mExecutionOrderDirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -106,7 +115,12 @@ void NodeGraph::addConnection(
 
   mDirtyNodes.insert(fromNode);
 
-  mConnections.emplace_back(fromNode, std::move(fromSocket), toNode, std::move(toSocket));
+  auto const& c =
+      mConnections.emplace_back(fromNode, std::move(fromSocket), toNode, std::move(toSocket));
+
+  mInputConnections[toNode].push_back(&c);
+  mOutputConnections[fromNode].push_back(&c);
+  mExecutionOrderDirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -116,10 +130,21 @@ void NodeGraph::removeConnection(uint32_t fromNode, std::string const& fromSocke
 
   mDirtyNodes.insert(toNode);
 
-  mConnections.remove_if([&](NodeConnection const& c) {
-    return c.mFromNode == fromNode && c.mFromSocket == fromSocket && c.mToNode == toNode &&
-           c.mToSocket == toSocket;
-  });
+  auto matches = [&](NodeConnection const* c) {
+    return c->mFromNode == fromNode && c->mFromSocket == fromSocket && c->mToNode == toNode &&
+           c->mToSocket == toSocket;
+  };
+
+  // The indices have to be updated before the connections are actually removed.
+  auto& inputs = mInputConnections[toNode];
+  inputs.erase(std::remove_if(inputs.begin(), inputs.end(), matches), inputs.end());
+
+  auto& outputs = mOutputConnections[fromNode];
+  outputs.erase(std::remove_if(outputs.begin(), outputs.end(), matches), outputs.end());
+
+  mConnections.remove_if([&](NodeConnection const& c) { return matches(&c); });
+
+  mExecutionOrderDirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,29 +152,33 @@ void NodeGraph::removeConnection(uint32_t fromNode, std::string const& fromSocke
 NodeConnection const* NodeGraph::getInputConnection(
     uint32_t toNode, std::string const& toSocket) const {
 
-  auto it = std::find_if(mConnections.begin(), mConnections.end(),
-      [&](NodeConnection const& c) { return c.mToNode == toNode && c.mToSocket == toSocket; });
+  auto connections = mInputConnections.find(toNode);
 
-  if (it == mConnections.end()) {
+  if (connections == mInputConnections.end()) {
     return nullptr;
   }
 
-  return &(*it);
+  auto it = std::find_if(connections->second.begin(), connections->second.end(),
+      [&](NodeConnection const* c) { return c->mToSocket == toSocket; });
+
+  if (it == connections->second.end()) {
+    return nullptr;
+  }
+
+  return *it;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::vector<NodeConnection const*> NodeGraph::getInputConnections(uint32_t toNode) const {
 
-  std::vector<NodeConnection const*> result;
+  auto connections = mInputConnections.find(toNode);
 
-  for (auto const& c : mConnections) {
-    if (c.mToNode == toNode) {
-      result.push_back(&c);
-    }
+  if (connections == mInputConnections.end()) {
+    return {};
   }
 
-  return result;
+  return connections->second;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -159,9 +188,13 @@ std::vector<NodeConnection const*> NodeGraph::getOutputConnections(
 
   std::vector<NodeConnection const*> result;
 
-  for (auto const& c : mConnections) {
-    if (c.mFromNode == fromNode && c.mFromSocket == fromSocket) {
-      result.push_back(&c);
+  auto connections = mOutputConnections.find(fromNode);
+
+  if (connections != mOutputConnections.end()) {
+    for (auto const* c : connections->second) {
+      if (c->mFromSocket == fromSocket) {
+        result.push_back(c);
+      }
     }
   }
 
@@ -172,78 +205,33 @@ std::vector<NodeConnection const*> NodeGraph::getOutputConnections(
 
 std::vector<NodeConnection const*> NodeGraph::getOutputConnections(uint32_t fromNode) const {
 
-  std::vector<NodeConnection const*> result;
+  auto connections = mOutputConnections.find(fromNode);
 
-  for (auto const& c : mConnections) {
-    if (c.mFromNode == fromNode) {
-      result.push_back(&c);
-    }
+  if (connections == mOutputConnections.end()) {
+    return {};
   }
 
-  return result;
+  return connections->second;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void NodeGraph::process() {
 
-  // A naive implementation of this method would simply pop nodes from mDirtyNodes and process them
-  // until mDirtyNodes is empty. This would work as new nodes are added to mDirtyNodes if a node
-  // produces a new output value during its process() method.
-  // However, this approach would lead to too many calls to process(). In the worst case, the
-  // process() method of a node would be called once for each connected input. To prevent this, we
-  // first collect all nodes which may need to be processed. Then, we process them one by one,
-  // always choosing a node for which all input nodes have already been processed.
-
-  // All dirty nodes will need to be processed.
-  auto processNodes = mDirtyNodes;
-
-  // Processing them will most likely result in changed output values, so we will process all
-  // connected output nodes as well. This could lead to nodes being processed for which the input
-  // actually did not change. However, once a node produces a new output, all connected nodes will
-  // be put into mDirtyNodes automatically. So we can check if mDirtyNodes contains a specific node
-  // before calling process() on it. This way, we can ensure that process() is only called for nodes
-  // which have changed input values.
-
-  // Recursively traverse the graph starting from all dirty nodes and push all visited nodes into
-  // processNodes. We abort after too many iterations - in this case there must be a cycle in the
-  // graph!
-  auto     heap       = processNodes;
-  uint32_t iterations = 0;
-
-  while (!heap.empty()) {
-    auto nodes = getOutputNodes(*heap.begin());
-    heap.erase(heap.begin());
-
-    processNodes.insert(nodes.begin(), nodes.end());
-    heap.insert(nodes.begin(), nodes.end());
-
-    if (++iterations > mNodes.size() * mNodes.size()) {
-      throw std::runtime_error("Cycle detected!");
-    }
+  if (mDirtyNodes.empty()) {
+    return;
   }
-  // Now that we have all nodes which should be processed, we process them one by one. We always
-  // choose a node which does not receive input from a node which is still pending to be processed.
-  while (!processNodes.empty()) {
-    auto it = std::find_if(processNodes.begin(), processNodes.end(), [&](uint32_t node) {
-      for (uint32_t inputNode : getInputNodes(node)) {
-        if (processNodes.find(inputNode) != processNodes.end()) {
-          return false;
-        }
-      }
-      return true;
-    });
 
-    // Only call process() on nodes which were marked as being dirty.
-    if (mDirtyNodes.find(*it) != mDirtyNodes.end()) {
-      auto node = mNodes.find(*it);
+  // The nodes are processed in topological order. A node which produces a new output value puts
+  // all connected nodes into mDirtyNodes. As these come later in the execution order, each node is
+  // processed at most once, after all of its input nodes have been processed. Nodes which are not
+  // downstream of a changed value are skipped.
+  updateExecutionOrder();
 
-      if (node != mNodes.end()) {
-        node->second->process();
-      }
+  for (uint32_t id : mExecutionOrder) {
+    if (mDirtyNodes.erase(id) > 0) {
+      mNodes.at(id)->process();
     }
-
-    processNodes.erase(it);
   }
 
   mDirtyNodes.clear();
@@ -257,30 +245,48 @@ void NodeGraph::handleNodeMessage(uint32_t toNode, nlohmann::json const& message
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<uint32_t> NodeGraph::getOutputNodes(uint32_t node) const {
-  std::vector<uint32_t> result;
-
-  for (auto const& c : mConnections) {
-    if (c.mFromNode == node) {
-      result.push_back(c.mToNode);
-    }
+void NodeGraph::updateExecutionOrder() {
+  if (!mExecutionOrderDirty) {
+    return;
   }
 
-  return result;
-}
+  // Kahn's algorithm: Nodes without input nodes come first. Any other node is appended once all of
+  // its input nodes have been appended.
+  std::unordered_map<uint32_t, size_t> pendingInputs;
+  std::vector<uint32_t>                order;
+  order.reserve(mNodes.size());
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  for (auto const& [id, node] : mNodes) {
+    size_t count = 0;
+    for (auto const* c : getInputConnections(id)) {
+      if (mNodes.find(c->mFromNode) != mNodes.end()) {
+        ++count;
+      }
+    }
 
-std::vector<uint32_t> NodeGraph::getInputNodes(uint32_t node) const {
-  std::vector<uint32_t> result;
+    pendingInputs[id] = count;
 
-  for (auto const& c : mConnections) {
-    if (c.mToNode == node) {
-      result.push_back(c.mFromNode);
+    if (count == 0) {
+      order.push_back(id);
     }
   }
 
-  return result;
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (auto const* c : getOutputConnections(order[i])) {
+      auto pending = pendingInputs.find(c->mToNode);
+      if (pending != pendingInputs.end() && --pending->second == 0) {
+        order.push_back(c->mToNode);
+      }
+    }
+  }
+
+  // Nodes which are part of a cycle never run out of pending inputs.
+  if (order.size() != mNodes.size()) {
+    throw std::runtime_error("Cycle detected!");
+  }
+
+  mExecutionOrder      = std::move(order);
+  mExecutionOrderDirty = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -137,17 +137,24 @@ class CSL_NODE_EDITOR_EXPORT NodeGraph {
   void clear();
 
  private:
-  // Returns all nodes which are currently connected to an output socket of the given node.
-  std::vector<uint32_t> getOutputNodes(uint32_t node) const;
-
-  // Returns all nodes which are currently connected to an input socket of the given node.
-  std::vector<uint32_t> getInputNodes(uint32_t node) const;
+  // Sorts all nodes topologically, so that each node comes after all nodes it receives input from.
+  // Throws a std::runtime_error if the graph contains a cycle.
+  void updateExecutionOrder();
 
   // Actually, this map should store unique pointers to the nodes. However, for some reason MSVC
   // does not like this...
   std::unordered_map<uint32_t, std::shared_ptr<Node>> mNodes;
   std::unordered_set<uint32_t>                        mDirtyNodes;
   std::list<NodeConnection>                           mConnections;
+
+  // The connections to and from each node. The elements of mConnections have stable addresses, so
+  // these refer to them directly instead of searching through all connections.
+  std::unordered_map<uint32_t, std::vector<NodeConnection const*>> mInputConnections;
+  std::unordered_map<uint32_t, std::vector<NodeConnection const*>> mOutputConnections;
+
+  // The order in which the nodes are processed. It is only re-computed if the graph changes.
+  std::vector<uint32_t> mExecutionOrder;
+  bool                  mExecutionOrderDirty = true;
 };
 
 } // namespace csl::nodeeditor
@@ -14,6 +14,7 @@
 #include "../../../src/cs-gui/WorldSpaceGuiArea.hpp"
 #include "../../../src/cs-scene/CelestialObject.hpp"
 
+#include <VistaKernel/GraphicsManager/VistaGroupNode.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
 #include <VistaKernel/GraphicsManager/VistaTransformNode.h>
@@ -24,59 +25,169 @@ namespace csl::tools {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DeletableMark::DeletableMark(std::shared_ptr<cs::core::InputManager> pInputManager,
-    std::shared_ptr<cs::core::SolarSystem>                           pSolarSystem,
-    std::shared_ptr<cs::core::Settings> settings, std::string objectName)
-    : Mark(std::move(pInputManager), std::move(pSolarSystem), std::move(settings),
-          std::move(objectName))
-    , mGuiArea(new cs::gui::WorldSpaceGuiArea(65, 75))
-    , mGuiItem(new cs::gui::GuiItem("file://../share/resources/gui/deletable_mark.html")) {
+/// The delete symbol which is shared by all DeletableMarks. It is attached to the scene graph node
+/// of the mark which has been selected last.
+class DeleteButton {
+ public:
+  /// Returns the shared instance. It is created if there is none.
+  static std::shared_ptr<DeleteButton> get(
+      std::shared_ptr<cs::core::InputManager> const& inputManager);
 
-  initData();
-}
+  explicit DeleteButton(std::shared_ptr<cs::core::InputManager> inputManager);
+
+  DeleteButton(DeleteButton const& other) = delete;
+  DeleteButton(DeleteButton&& other)      = delete;
+
+  DeleteButton& operator=(DeleteButton const& other) = delete;
+  DeleteButton& operator=(DeleteButton&& other)      = delete;
+
+  ~DeleteButton();
+
+  /// Moves the symbol to the given mark and shows it.
+  void show(DeletableMark* mark, VistaTransformNode* markTransform);
+
+  /// Hides the symbol if it is currently shown for the given mark.
+  void hide(DeletableMark const* mark);
+
+  /// Moves the symbol away from the given mark if it is attached to it. This has to be called
+  /// before the mark's scene graph nodes are deleted.
+  void detach(DeletableMark const* mark);
+
+ private:
+  void reparent(VistaGroupNode* parent);
+
+  std::shared_ptr<cs::core::InputManager>     mInputManager;
+  std::unique_ptr<cs::gui::WorldSpaceGuiArea> mGuiArea;
+  std::unique_ptr<cs::gui::GuiItem>           mGuiItem;
+  std::unique_ptr<VistaTransformNode>         mGuiTransform;
+  std::unique_ptr<VistaOpenGLNode>            mGuiNode;
+
+  DeletableMark* mMark = nullptr;
+};
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DeletableMark::~DeletableMark() {
-  if (mGuiNode) {
-    mGuiItem->unregisterCallback("deleteMe");
-    mInputManager->unregisterSelectable(mGuiNode);
-    mGuiArea->removeItem(mGuiItem.get());
+std::shared_ptr<DeleteButton> DeleteButton::get(
+    std::shared_ptr<cs::core::InputManager> const& inputManager) {
+  static std::weak_ptr<DeleteButton> instance;
 
-    delete mGuiNode;
+  auto button = instance.lock();
+  if (!button) {
+    button   = std::make_shared<DeleteButton>(inputManager);
+    instance = button;
   }
+
+  return button;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void DeletableMark::initData() {
+DeleteButton::DeleteButton(std::shared_ptr<cs::core::InputManager> inputManager)
+    : mInputManager(std::move(inputManager))
+    , mGuiArea(std::make_unique<cs::gui::WorldSpaceGuiArea>(65, 75))
+    , mGuiItem(
+          std::make_unique<cs::gui::GuiItem>("file://../share/resources/gui/deletable_mark.html")) {
+
   auto* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
 
-  auto* pGuiTransform = pSG->NewTransformNode(mTransform.get());
+  // The symbol is attached to the root until a mark is selected.
+  mGuiTransform.reset(pSG->NewTransformNode(pSG->GetRoot()));
 
-  pGuiTransform->Translate(0.F, 0.75F, 0.F);
+  mGuiTransform->Translate(0.F, 0.75F, 0.F);
 
   float const scale = 0.0005F;
-  pGuiTransform->Scale(scale * static_cast<float>(mGuiArea->getWidth()),
+  mGuiTransform->Scale(scale * static_cast<float>(mGuiArea->getWidth()),
       scale * static_cast<float>(mGuiArea->getHeight()), 1.F);
 
-  pGuiTransform->Rotate(VistaAxisAndAngle(VistaVector3D(0.0, 1.0, 0.0), -glm::pi<float>() / 2.F));
+  mGuiTransform->Rotate(
+      VistaAxisAndAngle(VistaVector3D(0.0, 1.0, 0.0), -glm::pi<float>() / 2.F));
   mGuiArea->addItem(mGuiItem.get());
 
   mGuiItem->setCursorChangeCallback([](cs::gui::Cursor c) { cs::core::GuiManager::setCursor(c); });
   mGuiItem->setCanScroll(false);
 
-  mGuiNode = pSG->NewOpenGLNode(pGuiTransform, mGuiArea.get());
-  mInputManager->registerSelectable(mGuiNode);
+  mGuiNode.reset(pSG->NewOpenGLNode(mGuiTransform.get(), mGuiArea.get()));
+  mInputManager->registerSelectable(mGuiNode.get());
 
   VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-      pGuiTransform, static_cast<int>(cs::utils::DrawOrder::eTransparentItems));
+      mGuiTransform.get(), static_cast<int>(cs::utils::DrawOrder::eTransparentItems));
+
+  mGuiItem->registerCallback("deleteMe", "Call this to remove the tool.", std::function([this]() {
+    if (mMark) {
+      mMark->pShouldDelete = true;
+    }
+  }));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeleteButton::~DeleteButton() {
+  mGuiItem->unregisterCallback("deleteMe");
+  mInputManager->unregisterSelectable(mGuiNode.get());
+  mGuiArea->removeItem(mGuiItem.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeleteButton::show(DeletableMark* mark, VistaTransformNode* markTransform) {
+  if (mMark != mark) {
+    mMark = mark;
+    reparent(markTransform);
+  }
 
-  mGuiItem->registerCallback("deleteMe", "Call this to remove the tool.",
-      std::function([this]() { pShouldDelete = true; }));
+  mGuiItem->callJavascript("setMinimized", false);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeleteButton::hide(DeletableMark const* mark) {
+  if (mMark == mark) {
+    mGuiItem->callJavascript("setMinimized", true);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeleteButton::detach(DeletableMark const* mark) {
+  if (mMark == mark) {
+    hide(mark);
+    mMark = nullptr;
+    reparent(GetVistaSystem()->GetGraphicsManager()->GetSceneGraph()->GetRoot());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeleteButton::reparent(VistaGroupNode* parent) {
+  if (mGuiTransform->GetParent()) {
+    mGuiTransform->GetParent()->DisconnectChild(mGuiTransform.get());
+  }
+  parent->AddChild(mGuiTransform.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeletableMark::DeletableMark(std::shared_ptr<cs::core::InputManager> pInputManager,
+    std::shared_ptr<cs::core::SolarSystem>                           pSolarSystem,
+    std::shared_ptr<cs::core::Settings> settings, std::string objectName)
+    : Mark(std::move(pInputManager), std::move(pSolarSystem), std::move(settings),
+          std::move(objectName))
+    , mDeleteButton(DeleteButton::get(mInputManager)) {
+
+  mSelfSelectedConnection = pSelected.connect([this](bool val) {
+    if (val) {
+      mDeleteButton->show(this, mTransform.get());
+    } else {
+      mDeleteButton->hide(this);
+    }
+  });
+}
 
-  mSelfSelectedConnection =
-      pSelected.connect([this](bool val) { mGuiItem->callJavascript("setMinimized", !val); });
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeletableMark::~DeletableMark() {
+  pSelected.disconnect(mSelfSelectedConnection);
+  mDeleteButton->detach(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,14 +10,12 @@
 
 #include "Mark.hpp"
 
-namespace cs::gui {
-class GuiItem;
-class WorldSpaceGuiArea;
-} // namespace cs::gui
-
 namespace csl::tools {
 
-/// A Mark with a delete symbol above when it is selected.
+class DeleteButton;
+
+/// A Mark with a delete symbol above when it is selected. As only one mark can be selected at a
+/// time, all DeletableMarks share one delete symbol (and therefore one web page).
 class CSL_TOOLS_EXPORT DeletableMark : public Mark {
  public:
   DeletableMark(std::shared_ptr<cs::core::InputManager> pInputManager,
@@ -33,11 +31,7 @@ class CSL_TOOLS_EXPORT DeletableMark : public Mark {
   ~DeletableMark() override;
 
  private:
-  void initData();
-
-  VistaOpenGLNode*                            mGuiNode = nullptr;
-  std::unique_ptr<cs::gui::WorldSpaceGuiArea> mGuiArea;
-  std::unique_ptr<cs::gui::GuiItem>           mGuiItem;
+  std::shared_ptr<DeleteButton> mDeleteButton;
 
   int mSelfSelectedConnection = -1;
 };
@@ -7,6 +7,8 @@
 
 #include "Mark.hpp"
 
+#include "MarkRenderer.hpp"
+
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/InputManager.hpp"
 #include "../../../src/cs-core/Settings.hpp"
@@ -31,42 +33,6 @@ namespace csl::tools {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static const char* SHADER_VERT = R"(
-#version 330
-
-layout(location=0) in vec3 iPosition;
-
-uniform mat4 uMatModelView;
-uniform mat4 uMatProjection;
-
-void main()
-{
-    vec3 pos    = (uMatModelView * vec4(iPosition*0.005, 1.0)).xyz;
-    gl_Position = uMatProjection * vec4(pos, 1.0);
-}
-)";
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-static const char* SHADER_FRAG = R"(
-#version 330
-
-uniform vec3 uHoverSelectActive;
-uniform vec3 uColor;
-
-layout(location = 0) out vec3 oColor;
-
-void main()
-{
-    oColor = uColor;
-    if (uHoverSelectActive.x > 0) oColor = mix(oColor, vec3(1, 1, 1), 0.2);
-    if (uHoverSelectActive.y > 0) oColor = mix(oColor, vec3(1, 1, 1), 0.5);
-    if (uHoverSelectActive.z > 0) oColor = mix(oColor, vec3(1, 1, 1), 0.8);
-}
-)";
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 Mark::Mark(std::shared_ptr<cs::core::InputManager> pInputManager,
     std::shared_ptr<cs::core::SolarSystem>         pSolarSystem,
     std::shared_ptr<cs::core::Settings> settings, std::string objectName)
@@ -75,10 +41,8 @@ Mark::Mark(std::shared_ptr<cs::core::InputManager> pInputManager,
     , mSolarSystem(std::move(pSolarSystem))
     , mSettings(std::move(settings))
     , mPosition(0.0, 0.0, 0.0)
-    , mVAO(std::make_unique<VistaVertexArrayObject>())
-    , mVBO(std::make_unique<VistaBufferObject>())
-    , mIBO(std::make_unique<VistaBufferObject>())
-    , mShader(std::make_unique<VistaGLSLShader>()) {
+    , mRenderer(MarkRenderer::get())
+    , mRendererMark(mRenderer->addMark()) {
 
   initData();
 }
@@ -97,10 +61,8 @@ Mark::Mark(Mark const& other)
     , mSolarSystem(other.mSolarSystem)
     , mSettings(other.mSettings)
     , mPosition(other.mPosition)
-    , mVAO(std::make_unique<VistaVertexArrayObject>())
-    , mVBO(std::make_unique<VistaBufferObject>())
-    , mIBO(std::make_unique<VistaBufferObject>())
-    , mShader(std::make_unique<VistaGLSLShader>()) {
+    , mRenderer(other.mRenderer)
+    , mRendererMark(mRenderer->addMark()) {
 
   initData();
 }
@@ -120,6 +82,10 @@ Mark::~Mark() {
   if (mParent) {
     mInputManager->unregisterSelectable(mParent.get());
   }
+
+  if (mRenderer) {
+    mRenderer->removeMark(mRendererMark);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -147,31 +113,16 @@ void Mark::update() {
   auto transform = object->getObserverRelativeTransform(mPosition, rotation, scale);
 
   mTransform->SetTransform(glm::value_ptr(transform), true);
+
+  glm::vec3 hoverSelectActive(
+      pHovered.get() ? 1.F : 0.F, pSelected.get() ? 1.F : 0.F, pActive.get() ? 1.F : 0.F);
+  mRenderer->setMark(mRendererMark, transform, pColor.get(), hoverSelectActive);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool Mark::Do() {
-  std::array<GLfloat, 16> glMatMV{};
-  std::array<GLfloat, 16> glMatP{};
-  glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
-  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
-
-  mShader->Bind();
-  mVAO->Bind();
-  glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
-  glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
-  mShader->SetUniform(mUniforms.hoverSelectActive, pHovered.get() ? 1.F : 0.F,
-      pSelected.get() ? 1.F : 0.F, pActive.get() ? 1.F : 0.F);
-  mShader->SetUniform(mUniforms.color, pColor.get().x, pColor.get().y, pColor.get().z);
-
-  glDisable(GL_CULL_FACE);
-  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mIndexCount), GL_UNSIGNED_INT, nullptr);
-  glEnable(GL_CULL_FACE);
-
-  mVAO->Release();
-  mShader->Release();
-
+  // The mark is drawn by the MarkRenderer.
   return true;
 }
 
@@ -191,15 +142,6 @@ bool Mark::GetBoundingBox(VistaBoundingBox& bb) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Mark::initData() {
-  mShader->InitVertexShaderFromString(SHADER_VERT);
-  mShader->InitFragmentShaderFromString(SHADER_FRAG);
-  mShader->Link();
-
-  mUniforms.modelViewMatrix   = mShader->GetUniformLocation("uMatModelView");
-  mUniforms.projectionMatrix  = mShader->GetUniformLocation("uMatProjection");
-  mUniforms.hoverSelectActive = mShader->GetUniformLocation("uHoverSelectActive");
-  mUniforms.color             = mShader->GetUniformLocation("uColor");
-
   auto* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
 
   mTransform.reset(pSG->NewTransformNode(pSG->GetRoot()));
@@ -209,67 +151,6 @@ void Mark::initData() {
   VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
       mTransform.get(), static_cast<int>(cs::utils::DrawOrder::eOpaqueNonHDR));
 
-  const std::array<glm::vec3, 26> POSITIONS = {glm::vec3(1, -1, 1), glm::vec3(-1, -1, -1),
-      glm::vec3(1, -1, -1), glm::vec3(-1, 1, -1), glm::vec3(1, 1, 1), glm::vec3(1, 1, -1),
-      glm::vec3(1, 1, -1), glm::vec3(1, -1, 1), glm::vec3(1, -1, -1), glm::vec3(1, 1, 1),
-      glm::vec3(-1, -1, 1), glm::vec3(1, -1, 1), glm::vec3(-1, -1, 1), glm::vec3(-1, 1, -1),
-      glm::vec3(-1, -1, -1), glm::vec3(1, -1, -1), glm::vec3(-1, 1, -1), glm::vec3(1, 1, -1),
-      glm::vec3(-1, -1, 1), glm::vec3(-1, 1, 1), glm::vec3(1, 1, -1), glm::vec3(1, 1, 1),
-      glm::vec3(1, -1, 1), glm::vec3(-1, 1, 1), glm::vec3(-1, 1, 1), glm::vec3(-1, -1, -1)};
-
-  const std::array<uint32_t, 36> INDICES = {
-      0,
-      1,
-      2,
-      3,
-      4,
-      5,
-      6,
-      7,
-      8,
-      9,
-      10,
-      11,
-      12,
-      13,
-      14,
-      15,
-      16,
-      17,
-      0,
-      18,
-      1,
-      3,
-      19,
-      4,
-      20,
-      21,
-      22,
-      9,
-      23,
-      10,
-      12,
-      24,
-      13,
-      15,
-      25,
-      16,
-  };
-
-  mIndexCount = INDICES.size();
-
-  mIBO->Bind(GL_ELEMENT_ARRAY_BUFFER);
-  mIBO->BufferData(INDICES.size() * sizeof(uint32_t), INDICES.data(), GL_STATIC_DRAW);
-  mIBO->Release();
-  mVAO->SpecifyIndexBufferObject(mIBO.get());
-
-  mVBO->Bind(GL_ARRAY_BUFFER);
-  mVBO->BufferData(POSITIONS.size() * sizeof(glm::vec3), POSITIONS.data(), GL_STATIC_DRAW);
-  mVBO->Release();
-
-  mVAO->EnableAttributeArray(0);
-  mVAO->SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, mVBO.get());
-
   // update hover state
   mHoveredNodeConnection = mInputManager->pHoveredNode.connect([this](IVistaNode* node) {
     if (node == mParent.get() && !pHovered.get()) {
@@ -37,7 +37,10 @@ class Settings;
 
 namespace csl::tools {
 
-/// A mark is a single point on the surface. It is selectable and draggable.
+class MarkRenderer;
+
+/// A mark is a single point on the surface. It is selectable and draggable. All marks are drawn by
+/// a shared MarkRenderer, the scene graph node of the mark is only used for selection.
 class CSL_TOOLS_EXPORT Mark : public IVistaOpenGLDraw, public Tool {
  public:
   /// Observable properties to get updates on state changes.
@@ -85,19 +88,8 @@ class CSL_TOOLS_EXPORT Mark : public IVistaOpenGLDraw, public Tool {
 
   glm::dvec3 mPosition;
 
-  std::unique_ptr<VistaVertexArrayObject> mVAO;
-  std::unique_ptr<VistaBufferObject>      mVBO;
-  std::unique_ptr<VistaBufferObject>      mIBO;
-  std::unique_ptr<VistaGLSLShader>        mShader;
-
-  struct {
-    uint32_t modelViewMatrix   = 0;
-    uint32_t projectionMatrix  = 0;
-    uint32_t hoverSelectActive = 0;
-    uint32_t color             = 0;
-  } mUniforms;
-
-  size_t mIndexCount{};
+  std::shared_ptr<MarkRenderer> mRenderer;
+  int                           mRendererMark = -1;
 
   int mSelfLngLatConnection = -1, mHoveredNodeConnection = -1, mSelectedNodeConnection = -1,
       mButtonsConnection = -1, mHoveredPlanetConnection = -1, mHeightScaleConnection = -1;
@@ -0,0 +1,248 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "MarkRenderer.hpp"
+
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <VistaMath/VistaBoundingBox.h>
+
+#include <algorithm>
+#include <array>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace csl::tools {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// number of vec4 stored for each instance
+std::size_t const texelsPerInstance = 6;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const MarkRenderer::SHADER_VERT = R"(
+#version 330
+
+layout(location=0) in vec3 iPosition;
+
+uniform mat4 uMatProjection;
+uniform samplerBuffer uInstances;
+
+flat out vec3 vColor;
+flat out vec3 vHoverSelectActive;
+
+void main()
+{
+  int base = gl_InstanceID * 6;
+  mat4 modelView = mat4(texelFetch(uInstances, base), texelFetch(uInstances, base + 1),
+                        texelFetch(uInstances, base + 2), texelFetch(uInstances, base + 3));
+  vColor             = texelFetch(uInstances, base + 4).rgb;
+  vHoverSelectActive = texelFetch(uInstances, base + 5).xyz;
+
+  gl_Position = uMatProjection * modelView * vec4(iPosition * 0.005, 1.0);
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const MarkRenderer::SHADER_FRAG = R"(
+#version 330
+
+flat in vec3 vColor;
+flat in vec3 vHoverSelectActive;
+
+layout(location = 0) out vec3 oColor;
+
+void main()
+{
+    oColor = vColor;
+    if (vHoverSelectActive.x > 0) oColor = mix(oColor, vec3(1, 1, 1), 0.2);
+    if (vHoverSelectActive.y > 0) oColor = mix(oColor, vec3(1, 1, 1), 0.5);
+    if (vHoverSelectActive.z > 0) oColor = mix(oColor, vec3(1, 1, 1), 0.8);
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<MarkRenderer> MarkRenderer::get() {
+  static std::weak_ptr<MarkRenderer> instance;
+
+  auto renderer = instance.lock();
+  if (!renderer) {
+    renderer = std::make_shared<MarkRenderer>();
+    instance = renderer;
+  }
+
+  return renderer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MarkRenderer::MarkRenderer() {
+  mShader.InitVertexShaderFromString(SHADER_VERT);
+  mShader.InitFragmentShaderFromString(SHADER_FRAG);
+  mShader.Link();
+
+  mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
+  mUniforms.instances        = mShader.GetUniformLocation("uInstances");
+
+  const std::array<glm::vec3, 26> POSITIONS = {glm::vec3(1, -1, 1), glm::vec3(-1, -1, -1),
+      glm::vec3(1, -1, -1), glm::vec3(-1, 1, -1), glm::vec3(1, 1, 1), glm::vec3(1, 1, -1),
+      glm::vec3(1, 1, -1), glm::vec3(1, -1, 1), glm::vec3(1, -1, -1), glm::vec3(1, 1, 1),
+      glm::vec3(-1, -1, 1), glm::vec3(1, -1, 1), glm::vec3(-1, -1, 1), glm::vec3(-1, 1, -1),
+      glm::vec3(-1, -1, -1), glm::vec3(1, -1, -1), glm::vec3(-1, 1, -1), glm::vec3(1, 1, -1),
+      glm::vec3(-1, -1, 1), glm::vec3(-1, 1, 1), glm::vec3(1, 1, -1), glm::vec3(1, 1, 1),
+      glm::vec3(1, -1, 1), glm::vec3(-1, 1, 1), glm::vec3(-1, 1, 1), glm::vec3(-1, -1, -1)};
+
+  const std::array<uint32_t, 36> INDICES = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+      16, 17, 0, 18, 1, 3, 19, 4, 20, 21, 22, 9, 23, 10, 12, 24, 13, 15, 25, 16};
+
+  mIndexCount = INDICES.size();
+
+  mIBO.Bind(GL_ELEMENT_ARRAY_BUFFER);
+  mIBO.BufferData(INDICES.size() * sizeof(uint32_t), INDICES.data(), GL_STATIC_DRAW);
+  mIBO.Release();
+  mVAO.SpecifyIndexBufferObject(&mIBO);
+
+  mVBO.Bind(GL_ARRAY_BUFFER);
+  mVBO.BufferData(POSITIONS.size() * sizeof(glm::vec3), POSITIONS.data(), GL_STATIC_DRAW);
+  mVBO.Release();
+
+  mVAO.EnableAttributeArray(0);
+  mVAO.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, &mVBO);
+
+  glGenBuffers(1, &mInstanceBuffer);
+  glGenTextures(1, &mInstanceTexture);
+
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  mGLNode.reset(sceneGraph->NewOpenGLNode(sceneGraph->GetRoot(), this));
+  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+      mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::eOpaqueNonHDR));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MarkRenderer::~MarkRenderer() {
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  sceneGraph->GetRoot()->DisconnectChild(mGLNode.get());
+
+  glDeleteTextures(1, &mInstanceTexture);
+  glDeleteBuffers(1, &mInstanceBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int MarkRenderer::addMark() {
+  auto it = std::find_if(mMarks.begin(), mMarks.end(), [](Mark const& m) { return !m.mUsed; });
+
+  if (it == mMarks.end()) {
+    it = mMarks.emplace(mMarks.end());
+  }
+
+  *it       = Mark();
+  it->mUsed = true;
+
+  return static_cast<int>(it - mMarks.begin());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MarkRenderer::removeMark(int mark) {
+  mMarks.at(static_cast<std::size_t>(mark)) = Mark();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MarkRenderer::setMark(int mark, glm::dmat4 const& transform, glm::vec3 const& color,
+    glm::vec3 const& hoverSelectActive) {
+  auto& m              = mMarks.at(static_cast<std::size_t>(mark));
+  m.mTransform         = transform;
+  m.mColor             = color;
+  m.mHoverSelectActive = hoverSelectActive;
+  m.mVisible           = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool MarkRenderer::Do() {
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
+
+  std::array<GLfloat, 16> glMatMV{};
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+  auto matMV = glm::dmat4(glm::make_mat4x4(glMatMV.data()));
+
+  // The transformations are combined in double precision, as the marks may be very far away.
+  mInstances.clear();
+
+  for (auto const& mark : mMarks) {
+    if (mark.mUsed && mark.mVisible) {
+      auto modelView = glm::mat4(matMV * mark.mTransform);
+      for (int c = 0; c < 4; ++c) {
+        mInstances.push_back(modelView[c]);
+      }
+      mInstances.emplace_back(mark.mColor, 0.F);
+      mInstances.emplace_back(mark.mHoverSelectActive, 0.F);
+    }
+  }
+
+  if (mInstances.empty()) {
+    return true;
+  }
+
+  glBindBuffer(GL_TEXTURE_BUFFER, mInstanceBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(mInstances.size() * sizeof(glm::vec4)),
+      mInstances.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  mShader.Bind();
+  mVAO.Bind();
+  glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, mInstanceTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mInstanceBuffer);
+  mShader.SetUniform(mUniforms.instances, 0);
+
+  glDisable(GL_CULL_FACE);
+  glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(mIndexCount), GL_UNSIGNED_INT,
+      nullptr, static_cast<GLsizei>(mInstances.size() / texelsPerInstance));
+  glEnable(GL_CULL_FACE);
+
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+  mVAO.Release();
+  mShader.Release();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool MarkRenderer::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csl::tools
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSL_TOOLS_MARK_RENDERER_HPP
+#define CSL_TOOLS_MARK_RENDERER_HPP
+
+#include "../../../src/cs-utils/FrameStats.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaOGLExt/VistaBufferObject.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <VistaOGLExt/VistaVertexArrayObject.h>
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+class VistaOpenGLNode;
+
+namespace csl::tools {
+
+/// Draws all Marks with a single instanced draw call. The Marks still have their own scene graph
+/// nodes, but these are only used for the intersection tests of the InputManager. This is much
+/// cheaper than compiling a shader and issuing a draw call for each of possibly hundreds of Marks.
+///
+/// All Marks share one MarkRenderer. It is created with the first Mark and destroyed with the last.
+class MarkRenderer : public IVistaOpenGLDraw {
+ public:
+  /// Returns the shared instance. It is created if there is none.
+  static std::shared_ptr<MarkRenderer> get();
+
+  MarkRenderer();
+
+  MarkRenderer(MarkRenderer const& other) = delete;
+  MarkRenderer(MarkRenderer&& other)      = delete;
+
+  MarkRenderer& operator=(MarkRenderer const& other) = delete;
+  MarkRenderer& operator=(MarkRenderer&& other)      = delete;
+
+  ~MarkRenderer() override;
+
+  /// Allocates a new mark. It is not drawn before setMark() has been called for it. The returned
+  /// index is used for the other methods.
+  int  addMark();
+  void removeMark(int mark);
+
+  /// Updates the mark. The transformation maps the mark's geometry to its position relative to the
+  /// root of the scene graph. The components of hoverSelectActive are 1.0 if the mark is hovered,
+  /// selected or active respectively and 0.0 otherwise.
+  void setMark(int mark, glm::dmat4 const& transform, glm::vec3 const& color,
+      glm::vec3 const& hoverSelectActive);
+
+  /// Inherited from IVistaOpenGLDraw.
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  struct Mark {
+    glm::dmat4 mTransform{1.0};
+    glm::vec3  mColor{1.F};
+    glm::vec3  mHoverSelectActive{0.F};
+    bool       mUsed    = false;
+    bool       mVisible = false;
+  };
+
+  std::unique_ptr<VistaOpenGLNode> mGLNode;
+
+  VistaVertexArrayObject mVAO;
+  VistaBufferObject      mVBO;
+  VistaBufferObject      mIBO;
+  VistaGLSLShader        mShader;
+  size_t                 mIndexCount = 0;
+
+  std::vector<Mark> mMarks;
+
+  // Each instance consists of the four columns of its modelview matrix, its color and its state.
+  std::vector<glm::vec4> mInstances;
+  uint32_t               mInstanceBuffer  = 0;
+  uint32_t               mInstanceTexture = 0;
+
+  struct {
+    uint32_t projectionMatrix = 0;
+    uint32_t instances        = 0;
+  } mUniforms;
+
+  cs::utils::FrameStats::TimerId mTimerId = cs::utils::FrameStats::intern("Tool Marks");
+
+  static const char* const SHADER_VERT;
+  static const char* const SHADER_FRAG;
+};
+
+} // namespace csl::tools
+
+#endif // CSL_TOOLS_MARK_RENDERER_HPP
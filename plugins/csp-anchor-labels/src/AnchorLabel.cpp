@@ -7,6 +7,7 @@
 
 #include "AnchorLabel.hpp"
 
+#include "LabelAtlas.hpp"
 #include "logger.hpp"
 
 #include "../../../src/cs-core/GuiManager.hpp"
@@ -33,32 +34,80 @@ namespace csp::anchorlabels {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// height of the labels relative to their width
+float const labelAspect =
+    static_cast<float>(LabelAtlas::sCellHeight) / static_cast<float>(LabelAtlas::sCellWidth);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 AnchorLabel::AnchorLabel(std::string const&           name,
     std::shared_ptr<const cs::scene::CelestialObject> object,
     std::shared_ptr<Plugin::Settings>                 pluginSettings,
     std::shared_ptr<cs::core::SolarSystem>            solarSystem,
     std::shared_ptr<cs::core::GuiManager>             guiManager,
-    std::shared_ptr<cs::core::InputManager>           inputManager)
+    std::shared_ptr<cs::core::InputManager>           inputManager,
+    std::shared_ptr<LabelAtlas>                       atlas)
     : mObject(std::move(object))
     , mPluginSettings(std::move(pluginSettings))
     , mSolarSystem(std::move(solarSystem))
     , mGuiManager(std::move(guiManager))
     , mInputManager(std::move(inputManager))
-    , mGuiArea(std::make_unique<cs::gui::WorldSpaceGuiArea>(150, 30))
-    , mGuiItem(
-          std::make_unique<cs::gui::GuiItem>("file://../share/resources/gui/anchor_label.html")) {
+    , mAtlas(std::move(atlas)) {
   auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
 
   mObjectTransform.reset(sceneGraph->NewTransformNode(sceneGraph->GetRoot()));
 
   mGuiTransform.reset(sceneGraph->NewTransformNode(mObjectTransform.get()));
-  mGuiTransform->SetScale(1.2F,
-      1.2F * static_cast<float>(mGuiArea->getHeight()) / static_cast<float>(mGuiArea->getWidth()),
-      1.0F);
+  mGuiTransform->SetScale(1.2F, 1.2F * labelAspect, 1.0F);
   mGuiTransform->SetTranslation(
       0.0F, static_cast<float>(mPluginSettings->mLabelOffset.get()), 0.0F);
   mGuiTransform->Rotate(VistaAxisAndAngle(VistaVector3D(0.0, 1.0, 0.0), -glm::pi<float>() / 2.F));
 
+  mOffsetConnection = mPluginSettings->mLabelOffset.connect([this](double newOffset) {
+    mGuiTransform->SetTranslation(0.0F, static_cast<float>(newOffset), 0.0F);
+  });
+
+  if (mAtlas) {
+    // The label is drawn by the atlas, the node is only used for selecting it.
+    mHitArea = std::make_unique<LabelHitArea>();
+    mGuiNode.reset(sceneGraph->NewOpenGLNode(mGuiTransform.get(), mHitArea.get()));
+    mInputManager->registerSelectable(mGuiNode.get());
+
+    mAtlasCell = mAtlas->addLabel(name);
+
+    mHoveredNodeConnection = mInputManager->pHoveredNode.connect([this](IVistaNode* node) {
+      if (node == mGuiNode.get() && !mIsHovered) {
+        mIsHovered = true;
+        mAtlas->setHoveredLabel(mAtlasCell);
+        cs::core::GuiManager::setCursor(cs::gui::Cursor::eHand);
+      } else if (node != mGuiNode.get() && mIsHovered) {
+        mIsHovered = false;
+        mAtlas->setHoveredLabel(-1);
+        cs::core::GuiManager::setCursor(cs::gui::Cursor::ePointer);
+      }
+    });
+
+    mButtonConnection = mInputManager->pButtons[0].connect([this](bool pressed) {
+      if (!pressed && mIsHovered) {
+        flyToObject();
+      }
+    });
+
+    return;
+  }
+
+  mGuiArea = std::make_unique<cs::gui::WorldSpaceGuiArea>(
+      LabelAtlas::sCellWidth, LabelAtlas::sCellHeight);
+  mGuiItem = std::make_unique<cs::gui::GuiItem>("file://../share/resources/gui/anchor_label.html");
+
   mGuiNode.reset(sceneGraph->NewOpenGLNode(mGuiTransform.get(), mGuiArea.get()));
   mInputManager->registerSelectable(mGuiNode.get());
 
@@ -68,23 +117,30 @@ AnchorLabel::AnchorLabel(std::string const&           name,
   mGuiItem->setCanScroll(false);
   mGuiItem->waitForFinishedLoading();
 
-  mGuiItem->registerCallback(
-      "flyToBody", "Makes the observer fly to the planet marked by this anchor label.", [this] {
-        mSolarSystem->flyObserverTo(mObject->getCenterName(), mObject->getFrameName(), 5.0);
-        mGuiManager->showNotification("Travelling", "to " + mObject->getCenterName(), "send");
-      });
+  mGuiItem->registerCallback("flyToBody",
+      "Makes the observer fly to the planet marked by this anchor label.",
+      [this] { flyToObject(); });
 
   mGuiItem->callJavascript("setLabelText", name);
-
-  mOffsetConnection = mPluginSettings->mLabelOffset.connect([this](double newOffset) {
-    mGuiTransform->SetTranslation(0.0F, static_cast<float>(newOffset), 0.0F);
-  });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 AnchorLabel::~AnchorLabel() {
-  mGuiItem->unregisterCallback("flyToBody");
+  if (mGuiItem) {
+    mGuiItem->unregisterCallback("flyToBody");
+  }
+
+  if (mAtlas) {
+    mInputManager->pHoveredNode.disconnect(mHoveredNodeConnection);
+    mInputManager->pButtons[0].disconnect(mButtonConnection);
+
+    if (mIsHovered) {
+      cs::core::GuiManager::setCursor(cs::gui::Cursor::ePointer);
+    }
+
+    mAtlas->removeLabel(mAtlasCell);
+  }
 
   mGuiTransform->DisconnectChild(mGuiNode.get());
   auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
@@ -100,7 +156,7 @@ AnchorLabel::~AnchorLabel() {
 void AnchorLabel::update() {
   mRelativeAnchorPosition = mObject->getObserverRelativePosition();
 
-  if (mObject->getIsOrbitVisible()) {
+  if (!shouldBeHidden()) {
     double distanceToObserver = distanceToCamera();
 
     double const scaleFactor = 0.05;
@@ -129,6 +185,7 @@ void AnchorLabel::update() {
     mat = glm::scale(mat, glm::dvec3(scale, scale, scale));
 
     mObjectTransform->SetTransform(glm::value_ptr(mat), true);
+    mObjectMatrix = mat;
   }
 }
 
@@ -136,9 +193,9 @@ void AnchorLabel::update() {
 
 glm::dvec4 AnchorLabel::getScreenSpaceBB() const {
   double const width =
-      mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getWidth()) * 0.0005;
+      mPluginSettings->mLabelScale.get() * static_cast<double>(LabelAtlas::sCellWidth) * 0.0005;
   double const height =
-      mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getHeight()) * 0.0005;
+      mPluginSettings->mLabelScale.get() * static_cast<double>(LabelAtlas::sCellHeight) * 0.0005;
 
   auto const screenPos = (mRelativeAnchorPosition.xyz() / mRelativeAnchorPosition.z).xy();
 
@@ -150,14 +207,20 @@ glm::dvec4 AnchorLabel::getScreenSpaceBB() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void AnchorLabel::enable() const {
-  mObjectTransform->SetIsEnabled(true);
+void AnchorLabel::enable() {
+  if (!mIsEnabled) {
+    mIsEnabled = true;
+    mObjectTransform->SetIsEnabled(true);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void AnchorLabel::disable() const {
-  mObjectTransform->SetIsEnabled(false);
+void AnchorLabel::disable() {
+  if (mIsEnabled) {
+    mIsEnabled = false;
+    mObjectTransform->SetIsEnabled(false);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -169,7 +232,8 @@ std::shared_ptr<const cs::scene::CelestialObject> const& AnchorLabel::getObject(
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool AnchorLabel::shouldBeHidden() const {
-  return !mObject->getIsOrbitVisible();
+  // Labels of objects which are behind another body are hidden as well.
+  return !mObject->getIsOrbitVisible() || mObject->getIsBodyOccluded();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -186,8 +250,34 @@ double AnchorLabel::distanceToCamera() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void AnchorLabel::setSortKey(int key) const {
-  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mGuiTransform.get(), key);
+void AnchorLabel::setSortKey(int key) {
+  if (mSortKey != key) {
+    mSortKey = key;
+    VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mGuiTransform.get(), key);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AnchorLabel::addToAtlas() const {
+  if (!mAtlas) {
+    return;
+  }
+
+  // This is the same transformation as the one of mGuiTransform.
+  auto mat = glm::translate(
+      mObjectMatrix, glm::dvec3(0.0, mPluginSettings->mLabelOffset.get(), 0.0));
+  mat = glm::rotate(mat, -glm::pi<double>() / 2.0, glm::dvec3(0.0, 1.0, 0.0));
+  mat = glm::scale(mat, glm::dvec3(1.2, 1.2 * labelAspect, 1.0));
+
+  mAtlas->addInstance(mat, mAtlasCell);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AnchorLabel::flyToObject() const {
+  mSolarSystem->flyObserverTo(mObject->getCenterName(), mObject->getFrameName(), 5.0);
+  mGuiManager->showNotification("Travelling", "to " + mObject->getCenterName(), "send");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
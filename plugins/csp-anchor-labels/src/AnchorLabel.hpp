@@ -12,6 +12,8 @@
 #include "../../../src/cs-utils/Property.hpp"
 #include "Plugin.hpp"
 
+#include <optional>
+
 class VistaOpenGLNode;
 class VistaTransformNode;
 
@@ -32,13 +34,18 @@ class InputManager;
 } // namespace cs::core
 
 namespace csp::anchorlabels {
+class LabelAtlas;
+class LabelHitArea;
+
 class AnchorLabel {
  public:
+  /// If an atlas is given, the label is drawn by the atlas. Else the label uses its own GuiItem.
   AnchorLabel(std::string const& name, std::shared_ptr<const cs::scene::CelestialObject> object,
       std::shared_ptr<Plugin::Settings>       pluginSettings,
       std::shared_ptr<cs::core::SolarSystem>  solarSystem,
       std::shared_ptr<cs::core::GuiManager>   guiManager,
-      std::shared_ptr<cs::core::InputManager> inputManager);
+      std::shared_ptr<cs::core::InputManager> inputManager,
+      std::shared_ptr<LabelAtlas>             atlas = nullptr);
 
   ~AnchorLabel();
 
@@ -56,29 +63,50 @@ class AnchorLabel {
   double bodySize() const;
   double distanceToCamera() const;
 
-  void setSortKey(int key) const;
+  /// Sets the sort key of the label's scene graph nodes. This does nothing if the key has not
+  /// changed since the last call.
+  void setSortKey(int key);
+
+  /// Adds this label to the instances drawn by the atlas in this frame. This does nothing if the
+  /// label has no atlas.
+  void addToAtlas() const;
 
-  void enable() const;
-  void disable() const;
+  /// Shows or hides the label. The scene graph is only touched if the state changes.
+  void enable();
+  void disable();
 
   glm::dvec4 getScreenSpaceBB() const;
 
  private:
+  void flyToObject() const;
+
   std::shared_ptr<const cs::scene::CelestialObject> mObject;
 
   std::shared_ptr<Plugin::Settings>       mPluginSettings;
   std::shared_ptr<cs::core::SolarSystem>  mSolarSystem;
   std::shared_ptr<cs::core::GuiManager>   mGuiManager;
   std::shared_ptr<cs::core::InputManager> mInputManager;
+  std::shared_ptr<LabelAtlas>             mAtlas;
 
   std::unique_ptr<cs::gui::WorldSpaceGuiArea> mGuiArea;
   std::unique_ptr<cs::gui::GuiItem>           mGuiItem;
+  std::unique_ptr<LabelHitArea>               mHitArea;
   std::unique_ptr<VistaOpenGLNode>            mGuiNode;
   std::unique_ptr<VistaTransformNode>         mObjectTransform;
   std::unique_ptr<VistaTransformNode>         mGuiTransform;
 
   glm::dvec3 mRelativeAnchorPosition{};
+  glm::dmat4 mObjectMatrix{};
   int        mOffsetConnection = -1;
+
+  bool               mIsEnabled = true;
+  std::optional<int> mSortKey;
+
+  // Only used if the label is drawn by the atlas.
+  int  mAtlasCell             = -1;
+  bool mIsHovered             = false;
+  int  mHoveredNodeConnection = -1;
+  int  mButtonConnection      = -1;
 };
 } // namespace csp::anchorlabels
 
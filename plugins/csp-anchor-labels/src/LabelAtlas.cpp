@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "LabelAtlas.hpp"
+
+#include "../../../src/cs-gui/GuiItem.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <VistaMath/VistaBoundingBox.h>
+
+#include <algorithm>
+#include <array>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// number of cells in each row of the atlas
+int const atlasColumns = 8;
+
+// number of rows of the atlas when it is created, it grows by doubling this
+int const initialAtlasRows = 8;
+
+// number of vec4 stored for each instance
+std::size_t const texelsPerInstance = 5;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const LabelAtlas::SHADER_VERT = R"(
+#version 330
+
+vec2 positions[4] = vec2[](
+    vec2(-0.5, 0.5),
+    vec2(0.5, 0.5),
+    vec2(-0.5, -0.5),
+    vec2(0.5, -0.5)
+);
+
+uniform mat4 uMatProjection;
+uniform samplerBuffer uInstances;
+
+out vec2 vTexCoords;
+flat out ivec2 vCell;
+
+void main()
+{
+  int base = gl_InstanceID * 5;
+  mat4 modelView = mat4(texelFetch(uInstances, base), texelFetch(uInstances, base + 1),
+                        texelFetch(uInstances, base + 2), texelFetch(uInstances, base + 3));
+  vCell = ivec2(texelFetch(uInstances, base + 4).xy);
+
+  vec2 p = positions[gl_VertexID];
+  vTexCoords = vec2(p.x, -p.y) + 0.5;
+  gl_Position = uMatProjection * modelView * vec4(p, 0, 1);
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const LabelAtlas::SHADER_FRAG = R"(
+#version 330
+
+in vec2 vTexCoords;
+flat in ivec2 vCell;
+
+uniform samplerBuffer uTexture;
+uniform ivec2 uTexSize;
+uniform ivec2 uCellSize;
+
+layout(location = 0) out vec4 vOutColor;
+
+// The texels are clamped to the cell, so that neighbouring labels do not bleed in.
+vec4 getTexel(ivec2 p) {
+  ivec2 cellMin = vCell * uCellSize;
+  p = clamp(p, cellMin, cellMin + uCellSize - ivec2(1));
+  return texelFetch(uTexture, p.y * uTexSize.x + p.x).bgra;
+}
+
+vec4 getPixel(vec2 position) {
+  vec2 absolutePosition = vec2(vCell * uCellSize) + position * vec2(uCellSize) - 0.5;
+  ivec2 iPosition = ivec2(absolutePosition);
+
+  vec4 tl = getTexel(iPosition);
+  vec4 tr = getTexel(iPosition + ivec2(1, 0));
+  vec4 bl = getTexel(iPosition + ivec2(0, 1));
+  vec4 br = getTexel(iPosition + ivec2(1, 1));
+
+  vec2 d = fract(absolutePosition);
+
+  vec4 top = mix(tl, tr, d.x);
+  vec4 bot = mix(bl, br, d.x);
+
+  return mix(top, bot, d.y);
+}
+
+void main() {
+  // The page may not have been redrawn yet after the atlas has grown.
+  if (any(greaterThan((vCell + 1) * uCellSize, uTexSize))) discard;
+
+  vOutColor = getPixel(vTexCoords);
+  if (vOutColor.a == 0.0) discard;
+
+  vOutColor.rgb /= vOutColor.a;
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelAtlas::LabelAtlas()
+    : mGuiItem(std::make_unique<cs::gui::GuiItem>(
+          "file://../share/resources/gui/anchor_label_atlas.html")) {
+
+  mGuiItem->setCanScroll(false);
+  resizeAtlas(initialAtlasRows);
+  mGuiItem->waitForFinishedLoading();
+
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  mGLNode.reset(sceneGraph->NewOpenGLNode(sceneGraph->GetRoot(), this));
+  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+      mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::eTransparentItems));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelAtlas::~LabelAtlas() {
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  sceneGraph->GetRoot()->DisconnectChild(mGLNode.get());
+
+  glDeleteTextures(1, &mInstanceTexture);
+  glDeleteBuffers(1, &mInstanceBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int LabelAtlas::addLabel(std::string const& text) {
+  auto it = std::find(mUsedCells.begin(), mUsedCells.end(), false);
+
+  if (it == mUsedCells.end()) {
+    resizeAtlas(mRows * 2);
+    it = std::find(mUsedCells.begin(), mUsedCells.end(), false);
+  }
+
+  *it       = true;
+  auto cell = static_cast<int>(it - mUsedCells.begin());
+
+  mGuiItem->callJavascript("setLabelText", cell, text);
+
+  return cell;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelAtlas::removeLabel(int cell) {
+  mUsedCells.at(static_cast<std::size_t>(cell)) = false;
+  mGuiItem->callJavascript("setLabelText", cell, "");
+
+  if (mHoveredLabel == cell) {
+    setHoveredLabel(-1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelAtlas::setHoveredLabel(int cell) {
+  if (mHoveredLabel != cell) {
+    mHoveredLabel = cell;
+    mGuiItem->callJavascriptCoalesced("setHoveredLabel", cell);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelAtlas::clearInstances() {
+  mTransforms.clear();
+  mCells.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelAtlas::addInstance(glm::dmat4 const& transform, int cell) {
+  mTransforms.push_back(transform);
+  mCells.push_back(cell);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelAtlas::Do() {
+  if (mTransforms.empty()) {
+    return true;
+  }
+
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
+
+  // The atlas is not part of a GuiArea, so the page would be paused if this was not called.
+  mGuiItem->markDrawn();
+
+  if (mShaderDirty) {
+    mShader = VistaGLSLShader();
+    mShader.InitVertexShaderFromString(SHADER_VERT);
+    mShader.InitFragmentShaderFromString(SHADER_FRAG);
+    mShader.Link();
+
+    mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
+    mUniforms.instances        = mShader.GetUniformLocation("uInstances");
+    mUniforms.texture          = mShader.GetUniformLocation("uTexture");
+    mUniforms.texSize          = mShader.GetUniformLocation("uTexSize");
+    mUniforms.cellSize         = mShader.GetUniformLocation("uCellSize");
+
+    glGenBuffers(1, &mInstanceBuffer);
+    glGenTextures(1, &mInstanceTexture);
+
+    mShaderDirty = false;
+  }
+
+  std::array<GLfloat, 16> glMatMV{};
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+  auto matMV = glm::dmat4(glm::make_mat4x4(glMatMV.data()));
+
+  // The transformations are combined in double precision, as the labels may be very far away.
+  mInstances.clear();
+  mInstances.reserve(mTransforms.size() * texelsPerInstance);
+
+  for (std::size_t i = 0; i < mTransforms.size(); ++i) {
+    auto modelView = glm::mat4(matMV * mTransforms[i]);
+    for (int c = 0; c < 4; ++c) {
+      mInstances.push_back(modelView[c]);
+    }
+    mInstances.emplace_back(
+        static_cast<float>(mCells[i] % atlasColumns), static_cast<float>(mCells[i] / atlasColumns),
+        0.F, 0.F);
+  }
+
+  glBindBuffer(GL_TEXTURE_BUFFER, mInstanceBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(mInstances.size() * sizeof(glm::vec4)),
+      mInstances.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  mShader.Bind();
+  glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+  glUniform2i(mUniforms.texSize, mGuiItem->getTextureSizeX(), mGuiItem->getTextureSizeY());
+  glUniform2i(mUniforms.cellSize, sCellWidth, sCellHeight);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, mGuiItem->getTexture());
+  mShader.SetUniform(mUniforms.texture, 0);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_BUFFER, mInstanceTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mInstanceBuffer);
+  mShader.SetUniform(mUniforms.instances, 1);
+
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(mTransforms.size()));
+
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+  mShader.Release();
+  glPopAttrib();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelAtlas::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelAtlas::resizeAtlas(int rows) {
+  mRows = rows;
+  mUsedCells.resize(static_cast<std::size_t>(mRows * atlasColumns), false);
+  mGuiItem->onAreaResize(atlasColumns * sCellWidth, mRows * sCellHeight);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelHitArea::Do() {
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelHitArea::GetBoundingBox(VistaBoundingBox& bb) {
+  float const          epsilon = 0.000001F;
+  std::array<float, 3> fMin    = {-0.5F, -0.5F, -epsilon};
+  std::array<float, 3> fMax    = {0.5F, 0.5F, epsilon};
+
+  bb.SetBounds(fMin.data(), fMax.data());
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_ANCHOR_LABELS_LABEL_ATLAS_HPP
+#define CSP_ANCHOR_LABELS_LABEL_ATLAS_HPP
+
+#include "../../../src/cs-utils/FrameStats.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VistaOpenGLNode;
+
+namespace cs::gui {
+class GuiItem;
+} // namespace cs::gui
+
+namespace csp::anchorlabels {
+
+/// Renders the text of all anchor labels into one shared web page and draws all visible labels
+/// with a single instanced draw call. The page is a grid of cells with the size of one label, each
+/// AnchorLabel occupies one cell. This is much cheaper than having one browser per label.
+///
+/// The labels have to be added with addInstance() each frame, back to front.
+class LabelAtlas : public IVistaOpenGLDraw {
+ public:
+  /// The size of one label in pixels.
+  static constexpr int sCellWidth  = 150;
+  static constexpr int sCellHeight = 30;
+
+  LabelAtlas();
+
+  LabelAtlas(LabelAtlas const& other) = delete;
+  LabelAtlas(LabelAtlas&& other)      = delete;
+
+  LabelAtlas& operator=(LabelAtlas const& other) = delete;
+  LabelAtlas& operator=(LabelAtlas&& other)      = delete;
+
+  ~LabelAtlas() override;
+
+  /// Allocates a cell showing the given text. The returned index is used for the other methods.
+  int  addLabel(std::string const& text);
+  void removeLabel(int cell);
+
+  /// Shows the given cell with the hover style. Pass -1 if no label is hovered.
+  void setHoveredLabel(int cell);
+
+  /// Removes all instances which have been added in the last frame.
+  void clearInstances();
+
+  /// Draws the given cell in this frame. The transformation maps the quad [-0.5, 0.5]² to the
+  /// label's position relative to the root of the scene graph.
+  void addInstance(glm::dmat4 const& transform, int cell);
+
+  /// Inherited from IVistaOpenGLDraw.
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  void resizeAtlas(int rows);
+
+  std::unique_ptr<cs::gui::GuiItem> mGuiItem;
+  std::unique_ptr<VistaOpenGLNode>  mGLNode;
+
+  VistaGLSLShader mShader;
+  bool            mShaderDirty = true;
+
+  std::vector<glm::dmat4> mTransforms;
+  std::vector<int>        mCells;
+
+  // Each instance consists of the four columns of its modelview matrix and its cell position.
+  std::vector<glm::vec4> mInstances;
+  uint32_t               mInstanceBuffer  = 0;
+  uint32_t               mInstanceTexture = 0;
+
+  std::vector<bool> mUsedCells;
+  int               mRows         = 0;
+  int               mHoveredLabel = -1;
+
+  struct {
+    uint32_t projectionMatrix = 0;
+    uint32_t texSize          = 0;
+    uint32_t cellSize         = 0;
+    uint32_t texture          = 0;
+    uint32_t instances        = 0;
+  } mUniforms;
+
+  cs::utils::FrameStats::TimerId mTimerId = cs::utils::FrameStats::intern("Anchor Labels");
+
+  static const char* const SHADER_VERT;
+  static const char* const SHADER_FRAG;
+};
+
+/// An invisible quad [-0.5, 0.5]². It is used to make the labels of the LabelAtlas selectable via
+/// the InputManager.
+class LabelHitArea : public IVistaOpenGLDraw {
+ public:
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_LABEL_ATLAS_HPP
@@ -7,6 +7,7 @@
 
 #include "Plugin.hpp"
 #include "AnchorLabel.hpp"
+#include "LabelAtlas.hpp"
 
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/PluginBase.hpp"
@@ -15,6 +16,9 @@
 #include "../../../src/cs-utils/utils.hpp"
 #include "logger.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <iostream>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,6 +46,7 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::deserialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::deserialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::deserialize(j, "useAtlas", o.mUseAtlas);
   cs::core::Settings::deserialize(j, "blacklist", o.mBlacklist);
 }
 
@@ -52,6 +57,7 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::serialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::serialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::serialize(j, "useAtlas", o.mUseAtlas);
   cs::core::Settings::serialize(j, "blacklist", o.mBlacklist);
 }
 
@@ -61,11 +67,15 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-anchor-labels")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   mGuiManager->addSettingsSectionToSideBarFromHTML(
-      "Anchor Labels", "location_on", "../share/resources/gui/anchor_labels_settings.html");
+      "Anchor Labels", "location_on", "../share/resources/gui/anchor_labels_settings.html", true);
 
   mGuiManager->executeJavascriptFile("../share/resources/gui/js/csp-anchor-labels.js");
 
@@ -74,7 +84,7 @@ void Plugin::init() {
       mAllSettings->mObjects.onAdd().connect([this](auto const& name, auto const& object) {
         if (mPluginSettings->mBlacklist.find(name) == mPluginSettings->mBlacklist.end()) {
           mAnchorLabels.emplace_back(std::make_unique<AnchorLabel>(
-              name, object, mPluginSettings, mSolarSystem, mGuiManager, mInputManager));
+              name, object, mPluginSettings, mSolarSystem, mGuiManager, mInputManager, mAtlas));
 
           mNeedsResort = true;
         }
@@ -149,63 +159,118 @@ void Plugin::update() {
       label->update();
     }
 
-    std::unordered_set<AnchorLabel*> labelsToDraw;
+    // The labels are placed greedily in the order of their priority, which is the size of their
+    // body. A label is drawn if it does not collide with any label which has been placed before.
+    // As all labels have the same size on screen, the placed labels are stored in a grid whose
+    // cells have the size of one label. So each label only has to be tested against the labels in
+    // the at most four cells it covers.
+    mPlacedLabels.clear();
+    mGridCells.clear();
+    mGridEntries.clear();
+
+    auto getCellKey = [](int64_t x, int64_t y) {
+      auto key = (static_cast<uint64_t>(x) << 32U) | (static_cast<uint64_t>(y) & 0xFFFFFFFFU);
+      return static_cast<int64_t>(key);
+    };
+
     for (auto const& label : mAnchorLabels) {
       if (label->shouldBeHidden()) {
+        label->disable();
         continue;
       }
 
       glm::dvec4 A             = label->getScreenSpaceBB();
       double     distToCameraA = label->distanceToCamera();
 
+      // Labels very close to the camera plane may have infinite bounds. These never collide.
+      std::array<int64_t, 4> cells{};
+      bool useGrid = std::isfinite(A.x) && std::isfinite(A.y) && A.z > 0.0 && A.w > 0.0;
+
+      if (useGrid) {
+        double const maxCell = 1 << 30;
+        cells[0] = static_cast<int64_t>(std::clamp(std::floor(A.x / A.z), -maxCell, maxCell));
+        cells[1] = static_cast<int64_t>(std::clamp(std::floor(A.y / A.w), -maxCell, maxCell));
+        cells[2] = cells[0] + 1;
+        cells[3] = cells[1] + 1;
+      }
+
       bool canBeAdded = true;
-      for (auto&& drawLabel : labelsToDraw) {
-        if (mPluginSettings->mEnableDepthOverlap.get()) {
-          // Check the distance relative to each other. If they are far apart we can display both.
-          double distToCameraB    = drawLabel->distanceToCamera();
-          double relativeDistance = distToCameraA < distToCameraB ? distToCameraB / distToCameraA
-                                                                  : distToCameraA / distToCameraB;
-          if (relativeDistance > 1 + mPluginSettings->mIgnoreOverlapThreshold.get()) {
+
+      for (int64_t x = cells[0]; useGrid && canBeAdded && x <= cells[2]; ++x) {
+        for (int64_t y = cells[1]; canBeAdded && y <= cells[3]; ++y) {
+          auto cell = mGridCells.find(getCellKey(x, y));
+
+          if (cell == mGridCells.end()) {
             continue;
           }
-        }
 
-        // Check if they are colliding. If they collide the bigger label survives. Since the list
-        // is sorted by body size, it is assured that the bigger label gets displayed.
-        glm::dvec4 B   = drawLabel->getScreenSpaceBB();
-        bool collision = B.x + B.z > A.x && B.y + B.w > A.y && A.x + A.z > B.x && A.y + A.w > B.y;
-        if (collision) {
-          canBeAdded = false;
-          break;
+          for (int32_t e = cell->second; canBeAdded && e >= 0; e = mGridEntries[e].mNext) {
+            auto const& drawLabel = mPlacedLabels[mGridEntries[e].mLabel];
+
+            if (mPluginSettings->mEnableDepthOverlap.get()) {
+              // Check the distance relative to each other. If they are far apart we can display
+              // both.
+              double distToCameraB    = drawLabel.mDistance;
+              double relativeDistance = distToCameraA < distToCameraB
+                                            ? distToCameraB / distToCameraA
+                                            : distToCameraA / distToCameraB;
+              if (relativeDistance > 1 + mPluginSettings->mIgnoreOverlapThreshold.get()) {
+                continue;
+              }
+            }
+
+            // Check if they are colliding. If they collide the bigger label survives. Since the
+            // list is sorted by body size, it is assured that the bigger label gets displayed.
+            glm::dvec4 const& B = drawLabel.mBB;
+            canBeAdded = !(B.x + B.z > A.x && B.y + B.w > A.y && A.x + A.z > B.x &&
+                           A.y + A.w > B.y);
+          }
         }
       }
 
-      if (canBeAdded) {
-        labelsToDraw.insert(label.get());
+      if (!canBeAdded) {
+        label->disable();
+        continue;
       }
-    }
 
-    for (auto&& label : mAnchorLabels) {
-      if (labelsToDraw.find(label.get()) != labelsToDraw.end()) {
-        label->enable();
-      } else {
-        label->disable();
+      label->enable();
+
+      auto index = static_cast<int32_t>(mPlacedLabels.size());
+      mPlacedLabels.push_back({label.get(), A, distToCameraA});
+
+      for (int64_t x = cells[0]; useGrid && x <= cells[2]; ++x) {
+        for (int64_t y = cells[1]; y <= cells[3]; ++y) {
+          auto cell = mGridCells.try_emplace(getCellKey(x, y), -1).first;
+          mGridEntries.push_back({index, cell->second});
+          cell->second = static_cast<int32_t>(mGridEntries.size() - 1);
+        }
       }
     }
 
-    std::vector<AnchorLabel*> sortedLabels(labelsToDraw.begin(), labelsToDraw.end());
-    std::sort(sortedLabels.begin(), sortedLabels.end(), [](AnchorLabel* a, AnchorLabel* b) {
-      return a->distanceToCamera() < b->distanceToCamera();
-    });
+    std::sort(mPlacedLabels.begin(), mPlacedLabels.end(),
+        [](PlacedLabel const& a, PlacedLabel const& b) { return a.mDistance < b.mDistance; });
 
-    for (int i = 0; i < static_cast<int>(sortedLabels.size()); ++i) {
-      // a little bit hacky... It probably breaks, when more than 100 labels are present.
-      sortedLabels[i]->setSortKey(static_cast<int>(cs::utils::DrawOrder::eTransparentItems) - i);
+    if (mAtlas) {
+      // The atlas draws its instances in the given order, so we add them back to front.
+      mAtlas->clearInstances();
+      for (auto it = mPlacedLabels.rbegin(); it != mPlacedLabels.rend(); ++it) {
+        it->mLabel->addToAtlas();
+      }
+    } else {
+      for (int i = 0; i < static_cast<int>(mPlacedLabels.size()); ++i) {
+        // a little bit hacky... It probably breaks, when more than 100 labels are present.
+        mPlacedLabels[i].mLabel->setSortKey(
+            static_cast<int>(cs::utils::DrawOrder::eTransparentItems) - i);
+      }
     }
   } else {
     for (auto&& label : mAnchorLabels) {
       label->disable();
     }
+
+    if (mAtlas) {
+      mAtlas->clearInstances();
+    }
   }
 }
 
@@ -218,6 +283,7 @@ void Plugin::deInit() {
   onSave();
 
   mAnchorLabels.clear();
+  mAtlas.reset();
 
   mAllSettings->mObjects.onAdd().disconnect(mAddObjectConnection);
   mAllSettings->mObjects.onRemove().disconnect(mRemoveObjectConnection);
@@ -245,12 +311,17 @@ void Plugin::onLoad() {
 
   // Remove all labels first.
   mAnchorLabels.clear();
+  mAtlas.reset();
+
+  if (mPluginSettings->mUseAtlas.get()) {
+    mAtlas = std::make_shared<LabelAtlas>();
+  }
 
   // Then create labels for all bodies that already exist.
   for (auto const& [name, object] : mAllSettings->mObjects) {
     if (mPluginSettings->mBlacklist.find(name) == mPluginSettings->mBlacklist.end()) {
       mAnchorLabels.emplace_back(std::make_unique<AnchorLabel>(
-          name, object, mPluginSettings, mSolarSystem, mGuiManager, mInputManager));
+          name, object, mPluginSettings, mSolarSystem, mGuiManager, mInputManager, mAtlas));
 
       mNeedsResort = true;
     }
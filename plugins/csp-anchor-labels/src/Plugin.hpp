@@ -10,12 +10,15 @@
 
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/Settings.hpp"
+#include "../../../src/cs-utils/FlatHashMap.hpp"
 #include "../../../src/cs-utils/Property.hpp"
+#include <glm/glm.hpp>
 #include <memory>
 #include <unordered_set>
 
 namespace csp::anchorlabels {
 class AnchorLabel;
+class LabelAtlas;
 
 /// This plugin puts labels over anchors in space. It uses the object names as text. If you click on
 /// the label you are being flown to the anchor. The plugin is configurable via the application
@@ -49,6 +52,10 @@ class Plugin : public cs::core::PluginBase {
     /// The value describes the labels height over the anchor.
     cs::utils::DefaultProperty<double> mLabelOffset{0.2};
 
+    /// If set to true, all labels are rendered by one shared web page and drawn with a single draw
+    /// call. Else each label uses its own web page. This is read when the settings are loaded.
+    cs::utils::DefaultProperty<bool> mUseAtlas{false};
+
     /// Celestial objects with these names will not have an associated label.
     std::unordered_set<std::string> mBlacklist;
   };
@@ -63,9 +70,29 @@ class Plugin : public cs::core::PluginBase {
 
   std::shared_ptr<Settings>                 mPluginSettings = std::make_shared<Settings>();
   std::vector<std::unique_ptr<AnchorLabel>> mAnchorLabels;
+  std::shared_ptr<LabelAtlas>               mAtlas;
 
   bool mNeedsResort = true; ///< When a new label gets added resort the vector
 
+  /// The labels which are drawn in the current frame, see update().
+  struct PlacedLabel {
+    AnchorLabel* mLabel;
+    glm::dvec4   mBB;
+    double       mDistance;
+  };
+
+  /// The placed labels are stored in a screen-space grid. For each cell, mGridCells contains the
+  /// index of the cell's last entry in mGridEntries. The entries of a cell form a linked list. All
+  /// of this is reused from frame to frame, so no memory is allocated in the steady state.
+  struct GridEntry {
+    int32_t mLabel; ///< The index into mPlacedLabels.
+    int32_t mNext;  ///< The previous entry of the same cell or -1.
+  };
+
+  std::vector<PlacedLabel>                 mPlacedLabels;
+  cs::utils::FlatHashMap<int64_t, int32_t> mGridCells;
+  std::vector<GridEntry>                   mGridEntries;
+
   int mAddObjectConnection    = -1;
   int mRemoveObjectConnection = -1;
   int mOnLoadConnection       = -1;
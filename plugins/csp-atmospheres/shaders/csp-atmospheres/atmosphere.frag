@@ -40,8 +40,34 @@ uniform float uWaterLevel;
 uniform sampler2D uCloudTexture;
 uniform float     uCloudAltitude;
 
+// RENDER_PASS is replaced by the Atmosphere class: 0 renders the atmosphere at full resolution, 1
+// renders multiplier and offset (see getAtmosphereContribution()) at a reduced resolution and 2
+// upsamples the result of pass 1 to full resolution.
+#if RENDER_PASS == 2
+uniform sampler2D uLowResMultiplier;
+uniform sampler2D uLowResOffset;
+#endif
+
+// ENABLE_TEMPORAL is replaced by the Atmosphere class as well. If set, the result of pass 1 is
+// blended with the reprojected result of the previous frame. uMatPreviousMVP transforms from the
+// atmosphere's model space to the clip space of the previous frame, uPreviousObserver is the
+// position of the observer in the previous frame in model space. uHistoryWeight is zero if there is
+// no valid history.
+#if RENDER_PASS == 1 && ENABLE_TEMPORAL
+uniform sampler2D uHistoryMultiplier;
+uniform sampler2D uHistoryOffset;
+uniform mat4      uMatPreviousMVP;
+uniform vec3      uPreviousObserver;
+uniform float     uHistoryWeight;
+#endif
+
 // outputs
+#if RENDER_PASS == 1
+layout(location = 0) out vec4 oMultiplier; // The surface distance is stored in the alpha channel.
+layout(location = 1) out vec3 oOffset;
+#else
 layout(location = 0) out vec3 oColor;
+#endif
 
 // -------------------------------------------------------------------------------------------------
 
@@ -448,34 +474,39 @@ float getCloudShadow(vec3 rayOrigin, vec3 rayDir) {
 
 // -------------------------------------------------------------------------------------------------
 
+// All operations which the atmosphere applies to the planet / background color are linear. Hence
+// the final color of a pixel can be written as multiplier * background + offset. This is used for
+// rendering the atmosphere at a reduced resolution: Only multiplier and offset are computed at a
+// low resolution and are then applied to the full-resolution background.
+
+// Applies color = factor * color + summand to the color given by multiplier and offset.
+void applyLinear(inout vec3 multiplier, inout vec3 offset, vec3 factor, vec3 summand) {
+  multiplier *= factor;
+  offset = factor * offset + summand;
+}
+
 // We start with the planet / background color without any atmosphere. First, we will overlay the
 // water color (if enabled). Thereafter, we compute the atmospheric scattering and overlay the
 // resulting atmosphere color. Finally, we will compute the color of the clouds and overlay them as
-// well.
-void main() {
-  vec3 rayDir = normalize(vsIn.rayDir);
-
-  // Get the planet / background color without any atmosphere.
-  oColor = getFramebufferColor();
+// well. The result is returned as multiplier and offset in linear color space, see above. If the
+// atmosphere has no effect on the given ray, false is returned.
+bool getAtmosphereContribution(vec3 rayOrigin, vec3 rayDir, float surfaceDistance,
+    out vec3 multiplier, out vec3 offset) {
+  multiplier = vec3(1.0);
+  offset     = vec3(0.0);
 
   // If the ray does not actually hit the atmosphere or the exit is already behind camera, we do not
   // have to modify the color any further.
-  vec2 atmosphereIntersections = intersectAtmosphere(vsIn.rayOrigin, rayDir);
+  vec2 atmosphereIntersections = intersectAtmosphere(rayOrigin, rayDir);
   if (atmosphereIntersections.x > atmosphereIntersections.y || atmosphereIntersections.y < 0) {
-    return;
+    return false;
   }
 
   // If something is in front of the atmosphere, we do not have to do anything either.
-  float surfaceDistance = getSurfaceDistance(vsIn.rayOrigin, rayDir);
   if (surfaceDistance < atmosphereIntersections.x) {
-    return;
+    return false;
   }
 
-  // Always operate in linear color space.
-#if !ENABLE_HDR
-  oColor = sRGBtoLinear(oColor);
-#endif
-
   // The ray hits an object if the distance to the depth buffer is smaller than the ray exit.
   bool hitsSurface = surfaceDistance < atmosphereIntersections.y;
   bool underWater  = false;
@@ -487,7 +518,7 @@ void main() {
 
   // We hit a water body if the ocean sphere is intersected and if the nearest surface is farther
   // away than the closest ocean sphere intersection (e.g. the ocean floor).
-  vec2 oceanIntersections = intersectOceansphere(vsIn.rayOrigin, rayDir);
+  vec2 oceanIntersections = intersectOceansphere(rayOrigin, rayDir);
   bool hitsOcean = oceanIntersections.y > 0.0 && oceanIntersections.x < oceanIntersections.y;
 
   if (hitsOcean && surfaceDistance > oceanIntersections.x) {
@@ -503,7 +534,7 @@ void main() {
     // Looking down onto the ocean.
     if (oceanIntersections.x > 0) {
 
-      vec3 oceanSurface = vsIn.rayOrigin + rayDir * oceanIntersections.x;
+      vec3 oceanSurface = rayOrigin + rayDir * oceanIntersections.x;
       vec3 idealNormal  = normalize(oceanSurface);
 
 #if ENABLE_WAVES
@@ -525,7 +556,7 @@ void main() {
       // As the waves produce a very noise aliasing pattern when seen from a large distance, we will
       // gradually hide them at large distances.
       float waveFade =
-          pow(1 - clamp(distance(oceanSurface, vsIn.rayOrigin) / WAVE_MAX_DISTANCE, 0, 1), 4);
+          pow(1 - clamp(distance(oceanSurface, rayOrigin) / WAVE_MAX_DISTANCE, 0, 1), 4);
 
       // Intuitively, we should have accumulated all three noise fields to get a height field of the
       // waves. Then we should have computed the gradient of the height field to get the ocean
@@ -592,8 +623,8 @@ void main() {
     // If the ray hits the ground, we have to compute the amount of light reaching the ground as
     // well as how much of the reflected light is attenuated on its path to the observer.
     vec3 skyIlluminance;
-    vec3 surfacePoint = vsIn.rayOrigin + rayDir * surfaceDistance;
-    inScatter        = GetSkyLuminanceToPoint(vsIn.rayOrigin, surfacePoint, uSunDir, transmittance);
+    vec3 surfacePoint = rayOrigin + rayDir * surfaceDistance;
+    inScatter        = GetSkyLuminanceToPoint(rayOrigin, surfacePoint, uSunDir, transmittance);
     vec3 illuminance = GetSunAndSkyIlluminance(surfacePoint, uSunDir, skyIlluminance);
     illuminance += skyIlluminance;
 
@@ -613,19 +644,19 @@ void main() {
     // atmosphere will be drawn later, it only can assume that it is in direct sun light. However,
     // if there is an atmosphere, actually less light reaches the surface. So we have to divide by
     // the direct sun illuminance and multiply by the attenuated illuminance.
-    oColor = cloudShadow * oColor * illuminance / uSunIlluminance;
+    applyLinear(multiplier, offset, cloudShadow * illuminance / uSunIlluminance, vec3(0.0));
 
     oceanSurfaceColor.rgb *= cloudShadow;
 
   } else {
 
     // If the ray leaves the atmosphere unblocked, we only need to compute the luminance of the sky.
-    inScatter = GetSkyLuminance(vsIn.rayOrigin, rayDir, uSunDir, transmittance);
+    inScatter = GetSkyLuminance(rayOrigin, rayDir, uSunDir, transmittance);
 
     // We also incorporate eclipse shadows. However, we only evaluate at the ray exit point. There
     // is no actual shadow volume in the atmosphere.
     vec3 exitPoint =
-        vsIn.rayOrigin + rayDir * (atmosphereIntersections.x > 0.0 ? atmosphereIntersections.x
+        rayOrigin + rayDir * (atmosphereIntersections.x > 0.0 ? atmosphereIntersections.x
                                                                    : atmosphereIntersections.y);
     eclipseShadow = getEclipseShadow((uMatM * vec4(exitPoint, 1.0)).xyz);
   }
@@ -638,35 +669,200 @@ void main() {
 
 #if ENABLE_WATER
   if (!underWater) {
-    oColor = mix(oColor, oColor * oceanWaterShade.rgb, oceanWaterShade.a);
-    oColor = mix(oColor, oceanSurfaceColor.rgb, oceanSurfaceColor.a);
+    applyLinear(multiplier, offset, mix(vec3(1.0), oceanWaterShade.rgb, oceanWaterShade.a),
+        vec3(0.0));
+    applyLinear(multiplier, offset, vec3(1.0 - oceanSurfaceColor.a),
+        oceanSurfaceColor.rgb * oceanSurfaceColor.a);
   }
 #endif
 
-  oColor = transmittance * oColor + inScatter;
+  applyLinear(multiplier, offset, transmittance, inScatter);
 
 #if ENABLE_WATER
   if (underWater) {
-    oColor = mix(oColor, oColor * oceanWaterShade.rgb, oceanWaterShade.a);
+    applyLinear(multiplier, offset, mix(vec3(1.0), oceanWaterShade.rgb, oceanWaterShade.a),
+        vec3(0.0));
   }
 #endif
 
 // Last, but not least, add the clouds.
 #if ENABLE_CLOUDS
   if (!underWater) {
-    vec4 cloudColor = getCloudColor(vsIn.rayOrigin, rayDir, uSunDir, surfaceDistance);
+    vec4 cloudColor = getCloudColor(rayOrigin, rayDir, uSunDir, surfaceDistance);
     cloudColor.rgb *= eclipseShadow;
 
 #if !ENABLE_HDR
     cloudColor.rgb = tonemap(cloudColor.rgb / uSunIlluminance);
 #endif
 
-    oColor = mix(oColor, cloudColor.rgb, cloudColor.a);
+    applyLinear(
+        multiplier, offset, vec3(1.0 - cloudColor.a), cloudColor.rgb * cloudColor.a);
   }
 #endif
 
-// If HDR-mode is disabled, we have to convert to sRGB color space.
-#if !ENABLE_HDR
-  oColor = linearToSRGB(oColor);
+  return true;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+#if RENDER_PASS == 2
+
+// If the surface distance of a low-resolution sample differs by more than this fraction from the
+// surface distance of the current pixel, there is a depth discontinuity (e.g. the limb of the
+// planet or an object in front of the atmosphere). In this case, the atmosphere is evaluated at
+// full resolution for the current pixel.
+const float MAX_DISTANCE_DIFFERENCE = 0.05;
+
+// If the in-scattered light of the low-resolution samples varies by more than this factor, the
+// atmosphere is evaluated at full resolution as well. This is the case close to the horizon.
+const float MAX_OFFSET_RATIO = 2.0;
+
+// Interpolates multiplier and offset from the four nearest low-resolution samples. The bilinear
+// weights are reduced for samples with a different surface distance. If the samples cannot be
+// interpolated reliably, false is returned.
+bool upsampleAtmosphereContribution(float surfaceDistance, out vec3 multiplier, out vec3 offset) {
+  ivec2 lowResSize = textureSize(uLowResMultiplier, 0);
+  vec2  position   = vsIn.texcoords * vec2(lowResSize) - 0.5;
+  ivec2 base       = ivec2(floor(position));
+  vec2  fraction   = position - floor(position);
+
+  multiplier = vec3(0.0);
+  offset     = vec3(0.0);
+
+  float totalWeight = 0.0;
+  float minOffset   = 1e38;
+  float maxOffset   = 0.0;
+
+  for (int i = 0; i < 4; ++i) {
+    ivec2 corner = ivec2(i & 1, i >> 1);
+    ivec2 texel  = clamp(base + corner, ivec2(0), lowResSize - 1);
+
+    vec4 sampleMultiplier = texelFetch(uLowResMultiplier, texel, 0);
+    vec3 sampleOffset     = texelFetch(uLowResOffset, texel, 0).rgb;
+
+    float difference = abs(sampleMultiplier.a - surfaceDistance) /
+                       max(max(sampleMultiplier.a, surfaceDistance), 1e-6);
+    if (difference > MAX_DISTANCE_DIFFERENCE) {
+      return false;
+    }
+
+    float luminance = dot(sampleOffset, vec3(0.2126, 0.7152, 0.0722));
+    minOffset       = min(minOffset, luminance);
+    maxOffset       = max(maxOffset, luminance);
+
+    vec2  bilinear = mix(1.0 - fraction, fraction, vec2(corner));
+    float weight   = bilinear.x * bilinear.y * (1.0 - difference / MAX_DISTANCE_DIFFERENCE) + 1e-6;
+
+    multiplier += sampleMultiplier.rgb * weight;
+    offset += sampleOffset * weight;
+    totalWeight += weight;
+  }
+
+  if (maxOffset > minOffset * MAX_OFFSET_RATIO + 1e-6) {
+    return false;
+  }
+
+  multiplier /= totalWeight;
+  offset /= totalWeight;
+
+  return true;
+}
+
 #endif
-}
\ No newline at end of file
+
+// -------------------------------------------------------------------------------------------------
+
+#if RENDER_PASS == 1 && ENABLE_TEMPORAL
+
+// If the surface distance stored in the history differs by more than this fraction from the
+// distance of the reprojected point to the previous observer, the point was not visible in the
+// previous frame (e.g. it was occluded by an object or outside the field of view). The history is
+// rejected in this case.
+const float MAX_HISTORY_DISTANCE_DIFFERENCE = 0.02;
+
+// Blends multiplier and offset with the result of the previous frame at the same surface point.
+void applyHistory(vec3 rayOrigin, vec3 rayDir, float surfaceDistance, inout vec3 multiplier,
+    inout vec3 offset) {
+  if (uHistoryWeight == 0.0) {
+    return;
+  }
+
+  vec3 surfacePoint = rayOrigin + rayDir * surfaceDistance;
+  vec4 previousPos  = uMatPreviousMVP * vec4(surfacePoint, 1.0);
+
+  if (previousPos.w <= 0.0) {
+    return;
+  }
+
+  vec2 texcoords = previousPos.xy / previousPos.w * 0.5 + 0.5;
+
+  if (any(lessThan(texcoords, vec2(0.0))) || any(greaterThan(texcoords, vec2(1.0)))) {
+    return;
+  }
+
+  vec4 historyMultiplier = texture(uHistoryMultiplier, texcoords);
+  vec3 historyOffset     = texture(uHistoryOffset, texcoords).rgb;
+
+  float expectedDistance = length(surfacePoint - uPreviousObserver);
+  float difference       = abs(historyMultiplier.a - expectedDistance) /
+                     max(max(historyMultiplier.a, expectedDistance), 1e-6);
+
+  if (difference > MAX_HISTORY_DISTANCE_DIFFERENCE) {
+    return;
+  }
+
+  multiplier = mix(multiplier, historyMultiplier.rgb, uHistoryWeight);
+  offset     = mix(offset, historyOffset, uHistoryWeight);
+}
+
+#endif
+
+// -------------------------------------------------------------------------------------------------
+
+void main() {
+  vec3  rayDir          = normalize(vsIn.rayDir);
+  float surfaceDistance = getSurfaceDistance(vsIn.rayOrigin, rayDir);
+
+  vec3 multiplier, offset;
+
+#if RENDER_PASS == 1
+  getAtmosphereContribution(vsIn.rayOrigin, rayDir, surfaceDistance, multiplier, offset);
+#if ENABLE_TEMPORAL
+  applyHistory(vsIn.rayOrigin, rayDir, surfaceDistance, multiplier, offset);
+#endif
+  oMultiplier = vec4(multiplier, surfaceDistance);
+  oOffset     = offset;
+#else
+
+  // Get the planet / background color without any atmosphere.
+  oColor = getFramebufferColor();
+
+#if RENDER_PASS == 2
+  bool affected = upsampleAtmosphereContribution(surfaceDistance, multiplier, offset);
+
+  // If the low-resolution samples could not be interpolated, we fall back to full resolution.
+  if (!affected) {
+    affected =
+        getAtmosphereContribution(vsIn.rayOrigin, rayDir, surfaceDistance, multiplier, offset);
+  } else if (multiplier == vec3(1.0) && offset == vec3(0.0)) {
+    affected = false;
+  }
+#else
+  bool affected =
+      getAtmosphereContribution(vsIn.rayOrigin, rayDir, surfaceDistance, multiplier, offset);
+#endif
+
+  if (!affected) {
+    return;
+  }
+
+  // The contribution of the atmosphere has to be applied in linear color space. If HDR-mode is
+  // disabled, we have to convert from and to sRGB color space.
+#if ENABLE_HDR
+  oColor = multiplier * oColor + offset;
+#else
+  oColor = linearToSRGB(multiplier * sRGBtoLinear(oColor) + offset);
+#endif
+
+#endif
+}
@@ -13,6 +13,10 @@ const float PI = 3.141592653589793;
 // uniforms
 uniform float uSunIlluminance;
 
+// The position of the samples within each segment of the primary ray. This is 0.5 unless the
+// atmosphere is accumulated over several frames. In this case, it changes each frame.
+uniform float uSampleJitter;
+
 // This atmospheric model uses a pretty basic implementation of single scattering. It requires no
 // preprocessing. For each pixel, a primary ray is cast through the atmosphere and at specific
 // sample positions, secondary rays are cast towards the Sun. The sun light is attenuated along the
@@ -123,7 +127,7 @@ vec3 _getInscatter(
 
   for (float i = 0; i < PRIMARY_RAY_STEPS; i++) {
     float tSegmentBegin = tStart + pow((i + 0.0) / (PRIMARY_RAY_STEPS), fExponent) * dist;
-    float tMid          = tStart + pow((i + 0.5) / (PRIMARY_RAY_STEPS), fExponent) * dist;
+    float tMid          = tStart + pow((i + uSampleJitter) / PRIMARY_RAY_STEPS, fExponent) * dist;
     float tSegmentEnd   = tStart + pow((i + 1.0) / (PRIMARY_RAY_STEPS), fExponent) * dist;
 
     vec3  position = camera + viewRay * tMid;
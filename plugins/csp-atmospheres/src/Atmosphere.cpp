@@ -14,6 +14,7 @@
 
 #include "../../../src/cs-core/GraphicsEngine.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-graphics/FramebufferCopy.hpp"
 #include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
@@ -22,16 +23,71 @@
 #include <VistaKernel/GraphicsManager/VistaGroupNode.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaFrameLoop.h>
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 #include <VistaOGLExt/VistaTexture.h>
 
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 namespace csp::atmospheres {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// The weight of the reprojected result of the previous frame when temporal accumulation is enabled.
+// Larger values reduce the noise further but make changes of the lighting appear delayed.
+float const TEMPORAL_HISTORY_WEIGHT = 0.9F;
+
+// Successive multiples of this distribute the jittered sample positions evenly along the rays.
+double const GOLDEN_RATIO_CONJUGATE = 0.6180339887498949;
+
+// Returns the screen-space rectangle (x, y, width, height) covered by an ellipsoid with the given
+// radii in the given viewport. The ellipsoid is centered at the origin of the model space of the
+// given model-view-projection matrix. The rectangle is computed conservatively by projecting the
+// corners of the bounding box of the ellipsoid. If any of them is behind the observer, the entire
+// viewport is returned. If the ellipsoid is not in the viewport, width and height are zero.
+std::array<int, 4> getScreenRect(
+    glm::dmat4 const& matMVP, glm::dvec3 const& radii, std::array<GLint, 4> const& viewport) {
+  glm::dvec2 minNDC(1.0);
+  glm::dvec2 maxNDC(-1.0);
+
+  for (int i = 0; i < 8; ++i) {
+    glm::dvec4 corner(((i & 1) != 0 ? 1.0 : -1.0) * radii.x, ((i & 2) != 0 ? 1.0 : -1.0) * radii.y,
+        ((i & 4) != 0 ? 1.0 : -1.0) * radii.z, 1.0);
+
+    glm::dvec4 projected = matMVP * corner;
+
+    if (projected.w <= 0.0) {
+      return viewport;
+    }
+
+    glm::dvec2 ndc = glm::dvec2(projected) / projected.w;
+    minNDC         = glm::min(minNDC, ndc);
+    maxNDC         = glm::max(maxNDC, ndc);
+  }
+
+  minNDC = glm::clamp(minNDC, -1.0, 1.0);
+  maxNDC = glm::clamp(maxNDC, -1.0, 1.0);
+
+  int x0 = viewport.at(0) + static_cast<int>(std::floor((minNDC.x * 0.5 + 0.5) * viewport.at(2)));
+  int y0 = viewport.at(1) + static_cast<int>(std::floor((minNDC.y * 0.5 + 0.5) * viewport.at(3)));
+  int x1 = viewport.at(0) + static_cast<int>(std::ceil((maxNDC.x * 0.5 + 0.5) * viewport.at(2)));
+  int y1 = viewport.at(1) + static_cast<int>(std::ceil((maxNDC.y * 0.5 + 0.5) * viewport.at(3)));
+
+  return {x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0)};
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Atmosphere::Atmosphere(std::shared_ptr<Plugin::Settings> pluginSettings,
     std::shared_ptr<cs::core::Settings>                  allSettings,
     std::shared_ptr<cs::core::SolarSystem>               solarSystem,
@@ -41,7 +97,10 @@ Atmosphere::Atmosphere(std::shared_ptr<Plugin::Settings> pluginSettings,
     , mSolarSystem(std::move(solarSystem))
     , mGraphicsEngine(std::move(graphicsEngine))
     , mObjectName(std::move(objectName))
+    , mTimerId(cs::utils::FrameStats::intern("Atmosphere of " + mObjectName))
     , mEclipseShadowReceiver(
+          std::make_shared<cs::core::EclipseShadowReceiver>(mAllSettings, mSolarSystem, false))
+    , mLowResEclipseShadowReceiver(
           std::make_shared<cs::core::EclipseShadowReceiver>(mAllSettings, mSolarSystem, false)) {
 
   // Recompile the shader if HDR mode was toggled.
@@ -61,30 +120,6 @@ Atmosphere::Atmosphere(std::shared_ptr<Plugin::Settings> pluginSettings,
   mAtmosphereNode->SetIsEnabled(false);
   VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
       mAtmosphereNode.get(), static_cast<int>(cs::utils::DrawOrder::eAtmospheres));
-
-  // Create depth and color buffer textures for each viewport. We need these to read the current
-  // values from the framebuffer.
-  for (auto const& viewport : GetVistaSystem()->GetDisplayManager()->GetViewports()) {
-    GBufferData bufferData;
-
-    bufferData.mDepthBuffer = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
-    bufferData.mDepthBuffer->Bind();
-    bufferData.mDepthBuffer->SetWrapS(GL_CLAMP);
-    bufferData.mDepthBuffer->SetWrapT(GL_CLAMP);
-    bufferData.mDepthBuffer->SetMinFilter(GL_NEAREST);
-    bufferData.mDepthBuffer->SetMagFilter(GL_NEAREST);
-    bufferData.mDepthBuffer->Unbind();
-
-    bufferData.mColorBuffer = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
-    bufferData.mColorBuffer->Bind();
-    bufferData.mColorBuffer->SetWrapS(GL_CLAMP);
-    bufferData.mColorBuffer->SetWrapT(GL_CLAMP);
-    bufferData.mColorBuffer->SetMinFilter(GL_NEAREST);
-    bufferData.mColorBuffer->SetMagFilter(GL_NEAREST);
-    bufferData.mColorBuffer->Unbind();
-
-    mGBufferData.emplace(viewport.second, std::move(bufferData));
-  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -94,6 +129,16 @@ Atmosphere::~Atmosphere() {
   pSG->GetRoot()->DisconnectChild(mAtmosphereNode.get());
 
   mAllSettings->mGraphics.pEnableHDR.disconnect(mEnableHDRConnection);
+
+  for (auto& [viewport, data] : mGBufferData) {
+    if (data.mLowResFramebuffer != 0) {
+      glDeleteFramebuffers(1, &data.mLowResFramebuffer);
+      glDeleteTextures(1, &data.mLowResMultiplier);
+      glDeleteTextures(1, &data.mLowResOffset);
+      glDeleteTextures(1, &data.mHistoryMultiplier);
+      glDeleteTextures(1, &data.mHistoryOffset);
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,7 +172,11 @@ void Atmosphere::configure(Plugin::Settings::Atmosphere const& settings) {
     // Reload the cloud texture if required.
     if (mSettings.mCloudTexture != settings.mCloudTexture) {
       if (settings.mCloudTexture.has_value() && !settings.mCloudTexture.value().empty()) {
-        mCloudTexture = cs::graphics::TextureLoader::loadFromFile(settings.mCloudTexture.value());
+        mCloudTexture =
+            cs::graphics::TextureLoader::loadFromFileAsync(settings.mCloudTexture.value());
+
+        // Only the coarse mip levels are loaded until the clouds are seen from closer, see Do().
+        cs::graphics::TextureLoader::setRequiredWidth(mCloudTexture.get(), 0.0);
       } else {
         mCloudTexture.reset();
       }
@@ -142,7 +191,8 @@ void Atmosphere::configure(Plugin::Settings::Atmosphere const& settings) {
 
     if (mSettings.mHeight != settings.mHeight || mSettings.mEnableWater != settings.mEnableWater ||
         mSettings.mEnableWaves != settings.mEnableWaves ||
-        mSettings.mEnableClouds != settings.mEnableClouds) {
+        mSettings.mEnableClouds != settings.mEnableClouds ||
+        mSettings.mEnableTemporalAccumulation != settings.mEnableTemporalAccumulation) {
       mShaderDirty = true;
     }
 
@@ -153,13 +203,30 @@ void Atmosphere::configure(Plugin::Settings::Atmosphere const& settings) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Atmosphere::updateShader() {
-  mAtmoShader = VistaGLSLShader();
+
+  // If the atmosphere is rendered at a reduced resolution or accumulated over several frames,
+  // mAtmoShader is used for the upsampling.
+  if (mUseLowResPass) {
+    compileShader(mLowResShader, mLowResUniforms, *mLowResEclipseShadowReceiver, 1);
+    compileShader(mAtmoShader, mUniforms, *mEclipseShadowReceiver, 2);
+  } else {
+    mLowResShader = VistaGLSLShader();
+    compileShader(mAtmoShader, mUniforms, *mEclipseShadowReceiver, 0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Atmosphere::compileShader(VistaGLSLShader& shader, Uniforms& uniforms,
+    cs::core::EclipseShadowReceiver& eclipseShadowReceiver, int renderPass) {
+  shader = VistaGLSLShader();
 
   auto sVert = cs::utils::filesystem::loadToString(
       "../share/resources/shaders/csp-atmospheres/atmosphere.vert");
   auto sFrag = cs::utils::filesystem::loadToString(
       "../share/resources/shaders/csp-atmospheres/atmosphere.frag");
 
+  cs::utils::replaceString(sFrag, "RENDER_PASS", std::to_string(renderPass));
   cs::utils::replaceString(sFrag, "PLANET_RADIUS", std::to_string(mRadii[0]));
   cs::utils::replaceString(
       sFrag, "ATMOSPHERE_RADIUS", std::to_string(mRadii[0] + mSettings.mHeight));
@@ -168,36 +235,95 @@ void Atmosphere::updateShader() {
   cs::utils::replaceString(sFrag, "ENABLE_WATER", std::to_string(mSettings.mEnableWater.get()));
   cs::utils::replaceString(sFrag, "ENABLE_WAVES", std::to_string(mSettings.mEnableWaves.get()));
   cs::utils::replaceString(sFrag, "ENABLE_HDR", std::to_string(mHDRBuffer != nullptr));
+  cs::utils::replaceString(sFrag, "ENABLE_TEMPORAL",
+      std::to_string(mSettings.mEnableTemporalAccumulation.get()));
   cs::utils::replaceString(sFrag, "HDR_SAMPLES",
       mHDRBuffer == nullptr ? "0" : std::to_string(mHDRBuffer->getMultiSamples()));
   cs::utils::replaceString(
-      sFrag, "ECLIPSE_SHADER_SNIPPET", mEclipseShadowReceiver->getShaderSnippet());
+      sFrag, "ECLIPSE_SHADER_SNIPPET", eclipseShadowReceiver.getShaderSnippet());
 
-  mAtmoShader.InitVertexShaderFromString(sVert);
-  mAtmoShader.InitFragmentShaderFromString(sFrag);
+  shader.InitVertexShaderFromString(sVert);
+  shader.InitFragmentShaderFromString(sFrag);
 
   // Add the fragment shader from the atmospheric model.
-  glAttachShader(mAtmoShader.GetProgram(), mModel->getShader());
-
-  mAtmoShader.Link();
-
-  mUniforms.sunDir                  = mAtmoShader.GetUniformLocation("uSunDir");
-  mUniforms.sunIlluminance          = mAtmoShader.GetUniformLocation("uSunIlluminance");
-  mUniforms.sunLuminance            = mAtmoShader.GetUniformLocation("uSunLuminance");
-  mUniforms.time                    = mAtmoShader.GetUniformLocation("uTime");
-  mUniforms.depthBuffer             = mAtmoShader.GetUniformLocation("uDepthBuffer");
-  mUniforms.colorBuffer             = mAtmoShader.GetUniformLocation("uColorBuffer");
-  mUniforms.waterLevel              = mAtmoShader.GetUniformLocation("uWaterLevel");
-  mUniforms.cloudTexture            = mAtmoShader.GetUniformLocation("uCloudTexture");
-  mUniforms.cloudAltitude           = mAtmoShader.GetUniformLocation("uCloudAltitude");
-  mUniforms.inverseModelViewMatrix  = mAtmoShader.GetUniformLocation("uMatInvMV");
-  mUniforms.inverseProjectionMatrix = mAtmoShader.GetUniformLocation("uMatInvP");
-  mUniforms.scaleMatrix             = mAtmoShader.GetUniformLocation("uMatScale");
-  mUniforms.modelMatrix             = mAtmoShader.GetUniformLocation("uMatM");
+  glAttachShader(shader.GetProgram(), mModel->getShader());
+
+  shader.Link();
+
+  uniforms.sunDir                  = shader.GetUniformLocation("uSunDir");
+  uniforms.sunIlluminance          = shader.GetUniformLocation("uSunIlluminance");
+  uniforms.sunLuminance            = shader.GetUniformLocation("uSunLuminance");
+  uniforms.time                    = shader.GetUniformLocation("uTime");
+  uniforms.depthBuffer             = shader.GetUniformLocation("uDepthBuffer");
+  uniforms.colorBuffer             = shader.GetUniformLocation("uColorBuffer");
+  uniforms.waterLevel              = shader.GetUniformLocation("uWaterLevel");
+  uniforms.cloudTexture            = shader.GetUniformLocation("uCloudTexture");
+  uniforms.cloudAltitude           = shader.GetUniformLocation("uCloudAltitude");
+  uniforms.inverseModelViewMatrix  = shader.GetUniformLocation("uMatInvMV");
+  uniforms.inverseProjectionMatrix = shader.GetUniformLocation("uMatInvP");
+  uniforms.scaleMatrix             = shader.GetUniformLocation("uMatScale");
+  uniforms.modelMatrix             = shader.GetUniformLocation("uMatM");
+  uniforms.lowResMultiplier        = shader.GetUniformLocation("uLowResMultiplier");
+  uniforms.lowResOffset            = shader.GetUniformLocation("uLowResOffset");
+  uniforms.historyMultiplier       = shader.GetUniformLocation("uHistoryMultiplier");
+  uniforms.historyOffset           = shader.GetUniformLocation("uHistoryOffset");
+  uniforms.historyWeight           = shader.GetUniformLocation("uHistoryWeight");
+  uniforms.previousMatrix          = shader.GetUniformLocation("uMatPreviousMVP");
+  uniforms.previousObserver        = shader.GetUniformLocation("uPreviousObserver");
+  uniforms.sampleJitter            = shader.GetUniformLocation("uSampleJitter");
 
   // We bind the eclipse shadow map to texture unit 3. The color and depth buffer are bound to 0 and
   // 1, 2 is used for the cloud map.
-  mEclipseShadowReceiver->init(&mAtmoShader, 3);
+  eclipseShadowReceiver.init(&shader, 3);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Atmosphere::updateLowResTargets(GBufferData& data, int width, int height) {
+  if (data.mLowResFramebuffer != 0 && data.mLowResWidth == width &&
+      data.mLowResHeight == height) {
+    return;
+  }
+
+  if (data.mLowResFramebuffer == 0) {
+    glGenFramebuffers(1, &data.mLowResFramebuffer);
+    glGenTextures(1, &data.mLowResMultiplier);
+    glGenTextures(1, &data.mLowResOffset);
+    glGenTextures(1, &data.mHistoryMultiplier);
+    glGenTextures(1, &data.mHistoryOffset);
+  }
+
+  data.mLowResWidth  = width;
+  data.mLowResHeight = height;
+
+  // The history cannot be reprojected to the new size.
+  data.mHistoryFrame = -1;
+
+  // Both targets use 32 bit floats, as the in-scattered luminance in HDR mode and the surface
+  // distance in the alpha channel of the multiplier exceed the range of half floats.
+  for (auto texture : {data.mLowResMultiplier, data.mLowResOffset, data.mHistoryMultiplier,
+           data.mHistoryOffset}) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  GLint framebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, data.mLowResFramebuffer);
+  glFramebufferTexture2D(
+      GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, data.mLowResMultiplier, 0);
+  glFramebufferTexture2D(
+      GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, data.mLowResOffset, 0);
+
+  std::array<GLenum, 2> bufs = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, bufs.data());
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -205,6 +331,24 @@ void Atmosphere::updateShader() {
 void Atmosphere::update(double time) {
   auto object = mSolarSystem->getObject(mObjectName);
 
+  // The resolution is reduced further if the dynamic quality is low. Only switching between full
+  // and reduced resolution requires recompiling the shaders.
+  int divisor = mSettings.mResolutionDivisor.get();
+  if (mGraphicsEngine->pDynamicQuality.get() < 0.5F) {
+    divisor = std::min(divisor * 2, 4);
+  }
+
+  // Temporal accumulation is applied to the result of the low-resolution pass, so this pass is
+  // also used at full resolution in this case.
+  bool useLowResPass = divisor > 1 || mSettings.mEnableTemporalAccumulation.get();
+
+  if (useLowResPass != mUseLowResPass) {
+    mShaderDirty = true;
+  }
+
+  mResolutionDivisor = divisor;
+  mUseLowResPass     = useLowResPass;
+
   if (object && object->getIsBodyVisible() && mPluginSettings->mEnable.get()) {
     mTime           = time;
     mSunIlluminance = mSolarSystem->getSunIlluminance(object->getObserverRelativePosition());
@@ -213,6 +357,7 @@ void Atmosphere::update(double time) {
     mObserverRelativeTransformation = object->getObserverRelativeTransform();
     mSceneScale                     = mSolarSystem->getObserver().getScale();
     mEclipseShadowReceiver->update(*object);
+    mLowResEclipseShadowReceiver->update(*object);
 
     // update brightness value -------------------------------------------------
     // This is a crude approximation of the overall scene brightness due to
@@ -249,10 +394,11 @@ void Atmosphere::update(double time) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool Atmosphere::Do() {
-  cs::utils::FrameStats::ScopedTimer          timer("Atmosphere of " + mObjectName);
-  cs::utils::FrameStats::ScopedSamplesCounter samplesCounter("Atmosphere of " + mObjectName);
+  cs::utils::FrameStats::ScopedTimer          timer(mTimerId);
+  cs::utils::FrameStats::ScopedSamplesCounter samplesCounter(mTimerId);
 
-  if (mShaderDirty || mEclipseShadowReceiver->needsRecompilation()) {
+  if (mShaderDirty || mEclipseShadowReceiver->needsRecompilation() ||
+      mLowResEclipseShadowReceiver->needsRecompilation()) {
     updateShader();
     mShaderDirty = false;
   }
@@ -265,22 +411,6 @@ bool Atmosphere::Do() {
   glEnable(GL_TEXTURE_2D);
   glDepthMask(GL_FALSE);
 
-  // copy depth buffer -------------------------------------------------------
-  if (!mHDRBuffer) {
-    std::array<GLint, 4> iViewport{};
-    glGetIntegerv(GL_VIEWPORT, iViewport.data());
-
-    auto* viewport   = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
-    auto const& data = mGBufferData[viewport];
-
-    data.mDepthBuffer->Bind();
-    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, iViewport.at(0), iViewport.at(1),
-        iViewport.at(2), iViewport.at(3), 0);
-    data.mColorBuffer->Bind();
-    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, iViewport.at(0), iViewport.at(1), iViewport.at(2),
-        iViewport.at(3), 0);
-  }
-
   // get matrices and related values -----------------------------------------
 
   std::array<GLfloat, 16> glMatV{};
@@ -313,58 +443,232 @@ bool Atmosphere::Do() {
 
   glm::vec3 sunDir = glm::normalize(glm::vec3(matInvWorld * glm::vec4(mSunDirection, 0)));
 
-  // set uniforms ------------------------------------------------------------
-  mAtmoShader.Bind();
+  auto* viewport = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
+  auto& data     = mGBufferData[viewport];
+
+  // compute the scissor rectangle -------------------------------------------
+  // Only the pixels covered by the atmosphere are evaluated. If it is not visible at all, nothing
+  // has to be done.
+  if (mHDRBuffer) {
+    mHDRBuffer->bind();
+  }
+
+  std::array<GLint, 4> iViewport{};
+  glGetIntegerv(GL_VIEWPORT, iViewport.data());
+
+  double atmosphereScale = 1.0 + mSettings.mHeight / mRadii[0];
+  auto   scissor         = getScreenRect(
+      glm::make_mat4x4(glMatP.data()) * matV * mObserverRelativeTransformation,
+      mRadii * atmosphereScale, iViewport);
+
+  if (scissor.at(2) <= 0 || scissor.at(3) <= 0) {
+    glDepthMask(GL_TRUE);
+    glPopAttrib();
+    return true;
+  }
+
+  // The finer mip levels of the cloud texture are loaded once they are required. The texture
+  // wraps around the planet once, close to the surface the texel density depends on the altitude.
+  if (mSettings.mEnableClouds.get() && mCloudTexture) {
+    double scale    = glm::length(mObserverRelativeTransformation[0]);
+    double radius   = std::max({mRadii[0], mRadii[1], mRadii[2]}) * scale;
+    double distance = glm::length(glm::dvec3(mObserverRelativeTransformation[3]));
+    double altitude = std::max(distance - radius, 0.001 * radius);
+    double pixels   = 2.0 * glm::pi<double>() * radius / altitude * glMatP[5] * iViewport[3] * 0.5;
+    cs::graphics::TextureLoader::setRequiredWidth(mCloudTexture.get(), pixels);
+  }
+
+  // get the current depth and color of the framebuffer ---------------------
+  // In HDR mode, the attachments of the HDRBuffer are sampled directly. Else we use the copies
+  // which are shared with all other atmospheres and drawables.
+  VistaTexture* depthBuffer = nullptr;
+  VistaTexture* colorBuffer = nullptr;
 
-  mAtmoShader.SetUniform(mUniforms.sunIlluminance, static_cast<float>(mSunIlluminance));
-  mAtmoShader.SetUniform(mUniforms.sunLuminance, static_cast<float>(mSunLuminance));
-  mAtmoShader.SetUniform(mUniforms.sunDir, sunDir[0], sunDir[1], sunDir[2]);
+  if (!mHDRBuffer) {
+    auto const& framebufferCopy = mGraphicsEngine->getFramebufferCopy();
+    int         stage           = static_cast<int>(cs::utils::DrawOrder::eAtmospheres);
 
-  // The noise shader does not like huge numbers. So we rather loop the time.
-  mAtmoShader.SetUniform(mUniforms.time, static_cast<float>(std::fmod(mTime, 1.0e4)));
+    depthBuffer = framebufferCopy->get(cs::graphics::FramebufferCopy::Attachment::eDepth, stage);
+    colorBuffer = framebufferCopy->get(cs::graphics::FramebufferCopy::Attachment::eColor, stage);
+  }
 
+  // bind textures -----------------------------------------------------------
   if (mHDRBuffer) {
     mHDRBuffer->doPingPong();
     mHDRBuffer->bind();
+    mHDRBuffer->preserveOutside({scissor.at(0) - iViewport.at(0), scissor.at(1) - iViewport.at(1),
+        scissor.at(2), scissor.at(3)});
     mHDRBuffer->getDepthAttachment()->Bind(GL_TEXTURE0);
     mHDRBuffer->getCurrentReadAttachment()->Bind(GL_TEXTURE1);
   } else {
-    auto* viewport   = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
-    auto const& data = mGBufferData[viewport];
-    data.mDepthBuffer->Bind(GL_TEXTURE0);
-    data.mColorBuffer->Bind(GL_TEXTURE1);
-  }
-
-  mAtmoShader.SetUniform(mUniforms.depthBuffer, 0);
-  mAtmoShader.SetUniform(mUniforms.colorBuffer, 1);
-
-  if (mSettings.mEnableWater.get()) {
-    mAtmoShader.SetUniform(mUniforms.waterLevel,
-        mSettings.mWaterLevel.get() * mAllSettings->mGraphics.pHeightScale.get());
+    depthBuffer->Bind(GL_TEXTURE0);
+    colorBuffer->Bind(GL_TEXTURE1);
   }
 
   if (mSettings.mEnableClouds.get() && mCloudTexture) {
     mCloudTexture->Bind(GL_TEXTURE2);
-    mAtmoShader.SetUniform(mUniforms.cloudTexture, 2);
-    mAtmoShader.SetUniform(mUniforms.cloudAltitude, mSettings.mCloudAltitude.get());
   }
 
-  glUniformMatrix4fv(
-      mUniforms.inverseModelViewMatrix, 1, GL_FALSE, glm::value_ptr(glm::mat4(matInvMV)));
-  glUniformMatrix4fv(mUniforms.scaleMatrix, 1, GL_FALSE, glm::value_ptr(glm::mat4(matScale)));
-  glUniformMatrix4fv(mUniforms.inverseProjectionMatrix, 1, GL_FALSE, glm::value_ptr(matInvP));
-  glUniformMatrix4fv(mUniforms.modelMatrix, 1, GL_FALSE, glm::value_ptr(glm::mat4(matM)));
+  // Sets the uniforms which are common to all render passes. This returns the first texture unit
+  // which is not used by the atmospheric model.
+  auto setUniforms = [&](VistaGLSLShader& shader, Uniforms const& uniforms) {
+    shader.SetUniform(uniforms.sunIlluminance, static_cast<float>(mSunIlluminance));
+    shader.SetUniform(uniforms.sunLuminance, static_cast<float>(mSunLuminance));
+    shader.SetUniform(uniforms.sunDir, sunDir[0], sunDir[1], sunDir[2]);
+
+    // The noise shader does not like huge numbers. So we rather loop the time.
+    shader.SetUniform(uniforms.time, static_cast<float>(std::fmod(mTime, 1.0e4)));
+
+    shader.SetUniform(uniforms.depthBuffer, 0);
+    shader.SetUniform(uniforms.colorBuffer, 1);
+
+    if (mSettings.mEnableWater.get()) {
+      shader.SetUniform(uniforms.waterLevel,
+          mSettings.mWaterLevel.get() * mAllSettings->mGraphics.pHeightScale.get());
+    }
+
+    if (mSettings.mEnableClouds.get() && mCloudTexture) {
+      shader.SetUniform(uniforms.cloudTexture, 2);
+      shader.SetUniform(uniforms.cloudAltitude, mSettings.mCloudAltitude.get());
+    }
+
+    glUniformMatrix4fv(
+        uniforms.inverseModelViewMatrix, 1, GL_FALSE, glm::value_ptr(glm::mat4(matInvMV)));
+    glUniformMatrix4fv(uniforms.scaleMatrix, 1, GL_FALSE, glm::value_ptr(glm::mat4(matScale)));
+    glUniformMatrix4fv(uniforms.inverseProjectionMatrix, 1, GL_FALSE, glm::value_ptr(matInvP));
+    glUniformMatrix4fv(uniforms.modelMatrix, 1, GL_FALSE, glm::value_ptr(glm::mat4(matM)));
+
+    // Ray-marching models place their samples in the center of each ray segment by default.
+    shader.SetUniform(uniforms.sampleJitter, 0.5F);
+
+    return mModel->setUniforms(shader.GetProgram(), 4);
+  };
+
+  // low-resolution pass -----------------------------------------------------
+  bool lowRes   = mUseLowResPass;
+  bool temporal = lowRes && mSettings.mEnableTemporalAccumulation.get();
+
+  glPushAttrib(GL_SCISSOR_BIT);
+  glEnable(GL_SCISSOR_TEST);
+
+  if (lowRes) {
+    int width  = (iViewport.at(2) + mResolutionDivisor - 1) / mResolutionDivisor;
+    int height = (iViewport.at(3) + mResolutionDivisor - 1) / mResolutionDivisor;
+    updateLowResTargets(data, width, height);
+
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, data.mLowResFramebuffer);
+
+    // The low-resolution scissor rectangle has a margin of one pixel, as the upsampling in the
+    // full-resolution pass reads the neighbouring samples.
+    int x0 = std::max((scissor.at(0) - iViewport.at(0)) / mResolutionDivisor - 1, 0);
+    int y0 = std::max((scissor.at(1) - iViewport.at(1)) / mResolutionDivisor - 1, 0);
+    int x1 = std::min(
+        (scissor.at(0) - iViewport.at(0) + scissor.at(2)) / mResolutionDivisor + 2, width);
+    int y1 = std::min(
+        (scissor.at(1) - iViewport.at(1) + scissor.at(3)) / mResolutionDivisor + 2, height);
+
+    glPushAttrib(GL_VIEWPORT_BIT | GL_SCISSOR_BIT);
+    glViewport(0, 0, width, height);
+    glScissor(x0, y0, x1 - x0, y1 - y0);
+
+    mLowResShader.Bind();
+    auto lowResTextureUnit = setUniforms(mLowResShader, mLowResUniforms);
+    mLowResEclipseShadowReceiver->preRender();
+
+    // For temporal accumulation, the result of the previous frame is reprojected with the matrices
+    // which were used back then. The samples of ray-marching models are jittered along the rays so
+    // that the accumulated result converges to a higher sample count.
+    int        frame     = GetVistaSystem()->GetFrameLoop()->GetFrameCount();
+    glm::dmat4 matP      = glm::make_mat4x4(glMatP.data());
+    glm::dmat4 matVM     = matV * matM;
+    bool       isHistory = temporal && data.mHistoryFrame == frame - 1;
+
+    if (temporal) {
+      glm::dmat4 matPreviousMVP   = data.mHistoryProjection * data.mHistoryModelView;
+      glm::vec3  previousObserver = glm::inverse(data.mHistoryModelView)[3];
+
+      glUniformMatrix4fv(mLowResUniforms.previousMatrix, 1, GL_FALSE,
+          glm::value_ptr(glm::mat4(matPreviousMVP)));
+      mLowResShader.SetUniform(mLowResUniforms.previousObserver, previousObserver.x,
+          previousObserver.y, previousObserver.z);
+      mLowResShader.SetUniform(
+          mLowResUniforms.historyWeight, isHistory ? TEMPORAL_HISTORY_WEIGHT : 0.F);
+      mLowResShader.SetUniform(mLowResUniforms.sampleJitter,
+          static_cast<float>(std::fmod(0.5 + frame * GOLDEN_RATIO_CONJUGATE, 1.0)));
+
+      glActiveTexture(GL_TEXTURE0 + lowResTextureUnit);
+      glBindTexture(GL_TEXTURE_2D, data.mHistoryMultiplier);
+      mLowResShader.SetUniform(
+          mLowResUniforms.historyMultiplier, static_cast<int>(lowResTextureUnit));
+
+      glActiveTexture(GL_TEXTURE0 + lowResTextureUnit + 1);
+      glBindTexture(GL_TEXTURE_2D, data.mHistoryOffset);
+      mLowResShader.SetUniform(
+          mLowResUniforms.historyOffset, static_cast<int>(lowResTextureUnit + 1));
+      glActiveTexture(GL_TEXTURE0);
+    }
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    if (temporal) {
+      glActiveTexture(GL_TEXTURE0 + lowResTextureUnit + 1);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      glActiveTexture(GL_TEXTURE0 + lowResTextureUnit);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      glActiveTexture(GL_TEXTURE0);
+
+      // The accumulated result becomes the history of the next frame.
+      glCopyImageSubData(data.mLowResMultiplier, GL_TEXTURE_2D, 0, 0, 0, 0,
+          data.mHistoryMultiplier, GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+      glCopyImageSubData(data.mLowResOffset, GL_TEXTURE_2D, 0, 0, 0, 0, data.mHistoryOffset,
+          GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+
+      data.mHistoryFrame      = frame;
+      data.mHistoryModelView  = matVM;
+      data.mHistoryProjection = matP;
+    }
+
+    mLowResEclipseShadowReceiver->postRender();
+    mLowResShader.Release();
+
+    glPopAttrib();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+  }
+
+  // full-resolution pass ----------------------------------------------------
+  glScissor(scissor.at(0), scissor.at(1), scissor.at(2), scissor.at(3));
+
+  mAtmoShader.Bind();
+
+  auto textureUnit = setUniforms(mAtmoShader, mUniforms);
 
   // Initialize eclipse shadow-related uniforms and textures.
   mEclipseShadowReceiver->preRender();
 
-  mModel->setUniforms(mAtmoShader.GetProgram(), 4);
+  if (lowRes) {
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D, data.mLowResMultiplier);
+    mAtmoShader.SetUniform(mUniforms.lowResMultiplier, static_cast<int>(textureUnit));
+
+    glActiveTexture(GL_TEXTURE0 + textureUnit + 1);
+    glBindTexture(GL_TEXTURE_2D, data.mLowResOffset);
+    mAtmoShader.SetUniform(mUniforms.lowResOffset, static_cast<int>(textureUnit + 1));
+  }
 
   // draw --------------------------------------------------------------------
   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
   // clean up ----------------------------------------------------------------
 
+  if (lowRes) {
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+  }
+
   // Reset eclipse shadow-related texture units.
   mEclipseShadowReceiver->postRender();
 
@@ -372,18 +676,22 @@ bool Atmosphere::Do() {
     mHDRBuffer->getDepthAttachment()->Unbind(GL_TEXTURE0);
     mHDRBuffer->getCurrentReadAttachment()->Unbind(GL_TEXTURE1);
   } else {
-    auto* viewport   = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
-    auto const& data = mGBufferData[viewport];
-    data.mDepthBuffer->Unbind(GL_TEXTURE0);
-    data.mColorBuffer->Unbind(GL_TEXTURE1);
+    depthBuffer->Unbind(GL_TEXTURE0);
+    colorBuffer->Unbind(GL_TEXTURE1);
+
+    // The atmosphere replaces the color of the framebuffer, so other atmospheres have to copy it
+    // again. The depth is not modified.
+    mGraphicsEngine->getFramebufferCopy()->invalidate(
+        cs::graphics::FramebufferCopy::Attachment::eColor);
   }
 
   if (mSettings.mEnableClouds.get() && mCloudTexture) {
-    mCloudTexture->Unbind(GL_TEXTURE3);
+    mCloudTexture->Unbind(GL_TEXTURE2);
   }
 
   mAtmoShader.Release();
 
+  glPopAttrib();
   glDepthMask(GL_TRUE);
 
   glPopAttrib();
@@ -10,6 +10,8 @@
 
 #include "Plugin.hpp"
 
+#include "../../../src/cs-utils/FrameStats.hpp"
+
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 
@@ -29,6 +31,13 @@ class ModelBase;
 
 /// This class draws a configurable atmosphere. It will be attached to the celestial object
 /// identified by the objectName given to the constructor.
+///
+/// If the resolutionDivisor of the atmosphere settings is larger than one, the atmosphere is drawn
+/// in two passes. The first pass evaluates the scattering at a reduced resolution into an
+/// offscreen framebuffer. The second pass applies the result to the full-resolution framebuffer
+/// with a depth-aware upsampling. Pixels for which the low-resolution samples cannot be
+/// interpolated reliably are evaluated at full resolution in the second pass. If the dynamic
+/// quality of the GraphicsEngine drops below one half, the resolution divisor is doubled.
 class Atmosphere : public IVistaOpenGLDraw {
  public:
   explicit Atmosphere(std::shared_ptr<Plugin::Settings> pluginSettings,
@@ -50,17 +59,53 @@ class Atmosphere : public IVistaOpenGLDraw {
   bool GetBoundingBox(VistaBoundingBox& bb) override;
 
  private:
+  struct Uniforms {
+    uint32_t sunDir                  = 0;
+    uint32_t sunIlluminance          = 0;
+    uint32_t sunLuminance            = 0;
+    uint32_t time                    = 0;
+    uint32_t depthBuffer             = 0;
+    uint32_t colorBuffer             = 0;
+    uint32_t waterLevel              = 0;
+    uint32_t cloudTexture            = 0;
+    uint32_t cloudAltitude           = 0;
+    uint32_t inverseModelViewMatrix  = 0;
+    uint32_t inverseProjectionMatrix = 0;
+    uint32_t scaleMatrix             = 0;
+    uint32_t modelMatrix             = 0;
+    uint32_t lowResMultiplier        = 0;
+    uint32_t lowResOffset            = 0;
+    uint32_t historyMultiplier       = 0;
+    uint32_t historyOffset           = 0;
+    uint32_t historyWeight           = 0;
+    uint32_t previousMatrix          = 0;
+    uint32_t previousObserver        = 0;
+    uint32_t sampleJitter            = 0;
+  };
+
   void updateShader();
 
+  /// Compiles the atmosphere shader for the given render pass. See atmosphere.frag for the meaning
+  /// of the passes.
+  void compileShader(VistaGLSLShader& shader, Uniforms& uniforms,
+      cs::core::EclipseShadowReceiver& eclipseShadowReceiver, int renderPass);
+
+  struct GBufferData;
+
+  /// (Re-)creates the targets of the low-resolution pass if their size does not match.
+  static void updateLowResTargets(GBufferData& data, int width, int height);
+
   std::shared_ptr<Plugin::Settings>                mPluginSettings;
   std::shared_ptr<cs::core::Settings>              mAllSettings;
   std::shared_ptr<cs::core::SolarSystem>           mSolarSystem;
   std::shared_ptr<cs::core::GraphicsEngine>        mGraphicsEngine;
   std::string                                      mObjectName;
+  cs::utils::FrameStats::TimerId                   mTimerId;
   std::unique_ptr<VistaOpenGLNode>                 mAtmosphereNode;
   std::shared_ptr<cs::graphics::HDRBuffer>         mHDRBuffer;
   std::shared_ptr<cs::core::EclipseShadowReceiver> mEclipseShadowReceiver;
-  std::unique_ptr<VistaTexture>                    mCloudTexture;
+  std::shared_ptr<cs::core::EclipseShadowReceiver> mLowResEclipseShadowReceiver;
+  std::shared_ptr<VistaTexture>                    mCloudTexture;
 
   glm::dvec3                   mRadii                          = glm::dvec3(1.0, 1.0, 1.0);
   glm::dmat4                   mObserverRelativeTransformation = glm::dmat4(1.0);
@@ -70,35 +115,37 @@ class Atmosphere : public IVistaOpenGLDraw {
   int mEnableHDRConnection = -1;
 
   VistaGLSLShader mAtmoShader;
+  VistaGLSLShader mLowResShader;
 
   struct GBufferData {
-    std::unique_ptr<VistaTexture> mDepthBuffer;
-    std::unique_ptr<VistaTexture> mColorBuffer;
+    // The targets of the low-resolution pass. They are created on demand.
+    uint32_t mLowResFramebuffer = 0;
+    uint32_t mLowResMultiplier  = 0;
+    uint32_t mLowResOffset      = 0;
+    int      mLowResWidth       = 0;
+    int      mLowResHeight      = 0;
+
+    // Copies of the low-resolution targets from the previous frame. These are used for temporal
+    // accumulation together with the matrices which were used to draw them.
+    uint32_t   mHistoryMultiplier = 0;
+    uint32_t   mHistoryOffset     = 0;
+    int        mHistoryFrame      = -1;
+    glm::dmat4 mHistoryModelView  = glm::dmat4(1.0);
+    glm::dmat4 mHistoryProjection = glm::dmat4(1.0);
   };
 
   std::unordered_map<VistaViewport*, GBufferData> mGBufferData;
 
-  bool       mShaderDirty    = true;
-  double     mSunIlluminance = 1.0;
-  double     mSunLuminance   = 1.0;
-  glm::dvec3 mSunDirection   = glm::dvec3(1.0, 0.0, 0.0);
-  double     mTime           = 0.0;
+  bool       mShaderDirty       = true;
+  int        mResolutionDivisor = 1;
+  bool       mUseLowResPass     = false;
+  double     mSunIlluminance    = 1.0;
+  double     mSunLuminance      = 1.0;
+  glm::dvec3 mSunDirection      = glm::dvec3(1.0, 0.0, 0.0);
+  double     mTime              = 0.0;
 
-  struct {
-    uint32_t sunDir                  = 0;
-    uint32_t sunIlluminance          = 0;
-    uint32_t sunLuminance            = 0;
-    uint32_t time                    = 0;
-    uint32_t depthBuffer             = 0;
-    uint32_t colorBuffer             = 0;
-    uint32_t waterLevel              = 0;
-    uint32_t cloudTexture            = 0;
-    uint32_t cloudAltitude           = 0;
-    uint32_t inverseModelViewMatrix  = 0;
-    uint32_t inverseProjectionMatrix = 0;
-    uint32_t scaleMatrix             = 0;
-    uint32_t modelMatrix             = 0;
-  } mUniforms;
+  Uniforms mUniforms;
+  Uniforms mLowResUniforms;
 
   std::unique_ptr<ModelBase> mModel;
 };
@@ -68,6 +68,8 @@ void from_json(nlohmann::json const& j, Plugin::Settings::Atmosphere& o) {
   cs::core::Settings::deserialize(j, "enableClouds", o.mEnableClouds);
   cs::core::Settings::deserialize(j, "cloudTexture", o.mCloudTexture);
   cs::core::Settings::deserialize(j, "cloudAltitude", o.mCloudAltitude);
+  cs::core::Settings::deserialize(j, "resolutionDivisor", o.mResolutionDivisor);
+  cs::core::Settings::deserialize(j, "enableTemporalAccumulation", o.mEnableTemporalAccumulation);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings::Atmosphere const& o) {
@@ -80,6 +82,8 @@ void to_json(nlohmann::json& j, Plugin::Settings::Atmosphere const& o) {
   cs::core::Settings::serialize(j, "enableClouds", o.mEnableClouds);
   cs::core::Settings::serialize(j, "cloudTexture", o.mCloudTexture);
   cs::core::Settings::serialize(j, "cloudAltitude", o.mCloudAltitude);
+  cs::core::Settings::serialize(j, "resolutionDivisor", o.mResolutionDivisor);
+  cs::core::Settings::serialize(j, "enableTemporalAccumulation", o.mEnableTemporalAccumulation);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -100,11 +104,15 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-atmospheres")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   mGuiManager->addSettingsSectionToSideBarFromHTML(
-      "Atmospheres", "blur_circular", "../share/resources/gui/atmospheres_settings.html");
+      "Atmospheres", "blur_circular", "../share/resources/gui/atmospheres_settings.html", true);
   mGuiManager->executeJavascriptFile("../share/resources/gui/js/csp-atmospheres.js");
 
   // Most settings of the sidebar are stored per-atmosphere. If the observer moves from one planet
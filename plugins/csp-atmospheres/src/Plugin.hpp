@@ -48,6 +48,17 @@ class Plugin : public cs::core::PluginBase {
       cs::utils::DefaultProperty<bool>  mEnableClouds{true};
       std::optional<std::string>        mCloudTexture;          ///< Path to the cloud texture.
       cs::utils::DefaultProperty<float> mCloudAltitude{3000.F}; ///< In meters.
+
+      /// The atmosphere is evaluated at the full resolution divided by this factor and then
+      /// upsampled to full resolution. Pixels at depth discontinuities, such as the limb of the
+      /// planet, are always evaluated at full resolution. Supported values are 1, 2 and 4.
+      cs::utils::DefaultProperty<int> mResolutionDivisor{1};
+
+      /// If enabled, the result of the reduced-resolution pass is accumulated over several frames.
+      /// The previous result is reprojected with the matrices of the previous frame and discarded
+      /// at disocclusions. This allows using fewer samples per frame, for example by reducing the
+      /// primaryRaySteps of the CosmoScout VR model. This is best suited for slow camera motion.
+      cs::utils::DefaultProperty<bool> mEnableTemporalAccumulation{false};
     };
 
     std::unordered_map<std::string, Atmosphere> mAtmospheres;
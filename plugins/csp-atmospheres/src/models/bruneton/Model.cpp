@@ -8,6 +8,7 @@
 
 #include "Model.hpp"
 
+#include "../../../../src/cs-utils/filesystem.hpp"
 #include "../../logger.hpp"
 
 #include <glm/gtc/constants.hpp>
@@ -80,6 +81,7 @@ void from_json(nlohmann::json const& j, Model::Settings& o) {
   cs::core::Settings::deserialize(j, "miePhaseFunctionG", o.mMiePhaseFunctionG);
   cs::core::Settings::deserialize(j, "groundAlbedo", o.mGroundAlbedo);
   cs::core::Settings::deserialize(j, "useOzone", o.mUseOzone);
+  cs::core::Settings::deserialize(j, "cacheDirectory", o.mCacheDirectory);
 }
 
 void to_json(nlohmann::json& j, Model::Settings const& o) {
@@ -93,6 +95,7 @@ void to_json(nlohmann::json& j, Model::Settings const& o) {
   cs::core::Settings::serialize(j, "miePhaseFunctionG", o.mMiePhaseFunctionG);
   cs::core::Settings::serialize(j, "groundAlbedo", o.mGroundAlbedo);
   cs::core::Settings::serialize(j, "useOzone", o.mUseOzone);
+  cs::core::Settings::serialize(j, "cacheDirectory", o.mCacheDirectory);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -156,10 +159,35 @@ bool Model::init(
       groundAlbedo, maxSunZenithAngle, 1.0, LUMINANCE_MODE == PRECOMPUTED ? 15 : 3,
       COMBINED_TEXTURES, HALF_PRECISION));
 
+  // The precomputed textures are loaded from the cache directory if they have been computed for
+  // the same parameters before.
+  std::string cacheFile;
+
+  if (!settings.mCacheDirectory.get().empty()) {
+    cacheFile = settings.mCacheDirectory.get() + "/bruneton-" + mModel->GetCacheKey() + ".bin";
+
+    if (mModel->LoadTextures(cacheFile)) {
+      logger().debug("Loaded precomputed atmosphere textures from '{}'.", cacheFile);
+      return true;
+    }
+  }
+
   glDisable(GL_CULL_FACE);
   mModel->Init();
   glEnable(GL_CULL_FACE);
 
+  if (!cacheFile.empty()) {
+    try {
+      cs::utils::filesystem::createDirectoryRecursively(settings.mCacheDirectory.get());
+
+      if (!mModel->SaveTextures(cacheFile)) {
+        logger().warn("Failed to write precomputed atmosphere textures to '{}'!", cacheFile);
+      }
+    } catch (std::exception const& e) {
+      logger().warn("Failed to create atmosphere cache directory: {}", e.what());
+    }
+  }
+
   return true;
 }
 
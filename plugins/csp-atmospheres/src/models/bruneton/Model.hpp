@@ -36,6 +36,11 @@ class Model : public ModelBase {
 
     cs::utils::DefaultProperty<double> mGroundAlbedo{0.1};
     cs::utils::DefaultProperty<bool>   mUseOzone{false};
+
+    /// The precomputed textures are stored in this directory. They are reused whenever an
+    /// atmosphere with the same parameters is initialized. Set this to an empty string to always
+    /// precompute the textures.
+    cs::utils::DefaultProperty<std::string> mCacheDirectory{"../share/cache/csp-atmospheres"};
   };
 
   /// Whenever the model parameters are changed, this method needs to be called. It will return true
@@ -41,8 +41,12 @@ of the following C++ code.
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <sstream>
 
 /*
 <p>The rest of this file is organized in 3 parts:
@@ -559,6 +563,63 @@ void ComputeSpectralRadianceToLuminanceFactors(const std::vector<double>& wavele
   *k_b *= MAX_LUMINOUS_EFFICACY * dlambda;
 }
 
+/*
+<p>The precomputed textures can be stored in a file, so that they do not need to
+be precomputed again for the same atmosphere parameters (this is not part of the
+original implementation). The file starts with a small header, followed by the
+texels of each texture as 32 bit floats:
+*/
+
+constexpr uint32_t kCacheMagic   = 0x4e555242; // "BRUN"
+constexpr uint32_t kCacheVersion = 1;
+
+int NumComponents(GLenum format) {
+  return format == GL_RGBA ? 4 : 3;
+}
+
+bool WriteTexture(std::ofstream& stream, GLenum target, GLuint texture, GLenum format,
+    int width, int height, int depth) {
+  std::vector<float> data(static_cast<size_t>(width) * height * depth * NumComponents(format));
+  glBindTexture(target, texture);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glGetTexImage(target, 0, format, GL_FLOAT, data.data());
+  glBindTexture(target, 0);
+  stream.write(reinterpret_cast<const char*>(data.data()),
+      static_cast<std::streamsize>(data.size() * sizeof(float)));
+  return stream.good();
+}
+
+bool ReadTexture(std::ifstream& stream, GLenum target, GLuint texture, GLenum format, int width,
+    int height, int depth) {
+  std::vector<float> data(static_cast<size_t>(width) * height * depth * NumComponents(format));
+  stream.read(reinterpret_cast<char*>(data.data()),
+      static_cast<std::streamsize>(data.size() * sizeof(float)));
+  if (!stream.good()) {
+    return false;
+  }
+  glBindTexture(target, texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  if (target == GL_TEXTURE_3D) {
+    glTexSubImage3D(target, 0, 0, 0, 0, width, height, depth, format, GL_FLOAT, data.data());
+  } else {
+    glTexSubImage2D(target, 0, 0, 0, width, height, format, GL_FLOAT, data.data());
+  }
+  glBindTexture(target, 0);
+  return true;
+}
+
+// 64 bit FNV-1a hash. std::hash is not used, as its result may differ between
+// implementations and the cache files may be shared.
+uint64_t Hash(const std::string& data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
 } // anonymous namespace
 
 /*<h3 id="implementation">Model implementation</h3>
@@ -922,6 +983,101 @@ void Model::SetProgramUniforms(GLuint program, GLuint transmittance_texture_unit
   }
 }
 
+/*
+<p>The cache key is computed from the GLSL headers for all wavelengths used by
+<code>Init</code> (these contain all atmosphere parameters), the number of
+scattering orders and the texture formats. The wavelengths have to be computed
+exactly as in <code>Init</code>:
+*/
+
+std::string Model::GetCacheKey(unsigned int num_scattering_orders) const {
+  std::string data = glsl_header_factory_({kLambdaR, kLambdaG, kLambdaB});
+  if (num_precomputed_wavelengths_ > 3) {
+    constexpr double kLambdaMin     = 360.0;
+    constexpr double kLambdaMax     = 830.0;
+    int              num_iterations = (num_precomputed_wavelengths_ + 2) / 3;
+    double           dlambda        = (kLambdaMax - kLambdaMin) / (3 * num_iterations);
+    for (int i = 0; i < num_iterations; ++i) {
+      data += glsl_header_factory_({kLambdaMin + (3 * i + 0.5) * dlambda,
+          kLambdaMin + (3 * i + 1.5) * dlambda, kLambdaMin + (3 * i + 2.5) * dlambda});
+    }
+  }
+  data += std::to_string(num_precomputed_wavelengths_) + "," +
+          std::to_string(num_scattering_orders) + "," + std::to_string(half_precision_) + "," +
+          std::to_string(rgb_format_supported_) + "," +
+          std::to_string(optional_single_mie_scattering_texture_ == 0);
+
+  std::ostringstream key;
+  key << std::hex << std::setw(16) << std::setfill('0') << Hash(data);
+  return key.str();
+}
+
+/*
+<p>The textures are stored in the formats they have been allocated with in the
+constructor:
+*/
+
+bool Model::SaveTextures(const std::string& file) const {
+  std::ofstream stream(file, std::ios::binary);
+  if (!stream) {
+    return false;
+  }
+
+  stream.write(reinterpret_cast<const char*>(&kCacheMagic), sizeof(kCacheMagic));
+  stream.write(reinterpret_cast<const char*>(&kCacheVersion), sizeof(kCacheVersion));
+
+  bool combined = optional_single_mie_scattering_texture_ == 0;
+  bool success  = WriteTexture(stream, GL_TEXTURE_2D, transmittance_texture_, GL_RGBA,
+      TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT, 1);
+  success = success && WriteTexture(stream, GL_TEXTURE_3D, scattering_texture_,
+                           combined || !rgb_format_supported_ ? GL_RGBA : GL_RGB,
+                           SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT,
+                           SCATTERING_TEXTURE_DEPTH);
+  if (!combined) {
+    success = success && WriteTexture(stream, GL_TEXTURE_3D,
+                             optional_single_mie_scattering_texture_,
+                             rgb_format_supported_ ? GL_RGB : GL_RGBA, SCATTERING_TEXTURE_WIDTH,
+                             SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH);
+  }
+  success = success && WriteTexture(stream, GL_TEXTURE_2D, irradiance_texture_, GL_RGBA,
+                           IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT, 1);
+  return success;
+}
+
+bool Model::LoadTextures(const std::string& file) {
+  std::ifstream stream(file, std::ios::binary);
+  if (!stream) {
+    return false;
+  }
+
+  uint32_t magic   = 0;
+  uint32_t version = 0;
+  stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+  if (!stream.good() || magic != kCacheMagic || version != kCacheVersion) {
+    return false;
+  }
+
+  bool combined = optional_single_mie_scattering_texture_ == 0;
+  bool success  = ReadTexture(stream, GL_TEXTURE_2D, transmittance_texture_, GL_RGBA,
+      TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT, 1);
+  success = success && ReadTexture(stream, GL_TEXTURE_3D, scattering_texture_,
+                           combined || !rgb_format_supported_ ? GL_RGBA : GL_RGB,
+                           SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT,
+                           SCATTERING_TEXTURE_DEPTH);
+  if (!combined) {
+    success = success && ReadTexture(stream, GL_TEXTURE_3D,
+                             optional_single_mie_scattering_texture_,
+                             rgb_format_supported_ ? GL_RGB : GL_RGBA, SCATTERING_TEXTURE_WIDTH,
+                             SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH);
+  }
+  success = success && ReadTexture(stream, GL_TEXTURE_2D, irradiance_texture_, GL_RGBA,
+                           IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT, 1);
+
+  // The file must not contain any further data.
+  return success && stream.peek() == std::ifstream::traits_type::eof();
+}
+
 /*
 <p>The utility method <code>ConvertSpectrumToLinearSrgb</code> is implemented
 with a simple numerical integration of the given function, times the CIE color
@@ -285,6 +285,19 @@ class Model {
       GLuint scattering_texture_unit, GLuint irradiance_texture_unit,
       GLuint optional_single_mie_scattering_texture_unit = 0) const;
 
+  // Returns a hash of everything which influences the result of Init(), i.e.
+  // the atmosphere parameters, the precomputed wavelengths, the texture formats
+  // and the GLSL code of the precomputation shaders. This is not part of the
+  // original implementation.
+  std::string GetCacheKey(unsigned int num_scattering_orders = 4) const;
+
+  // Writes the precomputed textures to the given file or reads them from it
+  // instead of calling Init(). LoadTextures() returns false if the file does
+  // not exist or does not match the texture formats of this model. These are
+  // not part of the original implementation.
+  bool SaveTextures(const std::string& file) const;
+  bool LoadTextures(const std::string& file);
+
   // Utility method to convert a function of the wavelength to linear sRGB.
   // 'wavelengths' and 'spectrum' must have the same size. The integral of
   // 'spectrum' times each CIE_2_DEG_COLOR_MATCHING_FUNCTIONS (and times
@@ -117,7 +117,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-custom-web-ui")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // Load initial settings.
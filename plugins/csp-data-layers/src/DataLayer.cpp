@@ -0,0 +1,554 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "DataLayer.hpp"
+
+#include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+#include "logger.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_access.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stdexcept>
+
+namespace csp::datalayers {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The data is split into 2^TILE_LEVEL times 2^(TILE_LEVEL+1) tiles.
+uint32_t const TILE_LEVEL = 4;
+
+// At most this many bytes of vertex data are uploaded each frame. Tiles are never split, so if a
+// single tile is larger, it is uploaded on its own.
+std::size_t const MAX_UPLOAD_BYTES_PER_FRAME = 16 * 1024 * 1024;
+
+// The shader storage buffer binding point of the points.
+uint32_t const POINT_BINDING = 0;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* DataLayer::POINT_VERT = R"(
+#version 430
+
+// The high and the low parts of the positions of all points one after another.
+layout(std430, binding = 0) readonly buffer Points {
+  float uPoints[];
+};
+
+uniform mat4 uMatModelView;
+uniform mat4 uMatProjection;
+uniform vec2 uPointSize;
+
+out vec2 vTexCoords;
+
+RELATIVE_TO_EYE_SNIPPET
+
+void main()
+{
+    int  i    = gl_InstanceID * 6;
+    vec3 high = vec3(uPoints[i + 0], uPoints[i + 1], uPoints[i + 2]);
+    vec3 low  = vec3(uPoints[i + 3], uPoints[i + 4], uPoints[i + 5]);
+
+    vec4 pos = uMatProjection * uMatModelView * vec4(relativeToEye(high, low), 1.0);
+
+    // The quad is expanded in screen space, so that all points have the same size in pixels.
+    vTexCoords = vec2(gl_VertexID % 2, gl_VertexID / 2) * 2.0 - 1.0;
+    pos.xy += vTexCoords * uPointSize * pos.w;
+
+    gl_Position = pos;
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* DataLayer::POINT_FRAG = R"(
+#version 430
+
+uniform vec3 uColor;
+
+in vec2 vTexCoords;
+
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    // The points are drawn as discs with a smooth edge.
+    float dist = length(vTexCoords);
+
+    if (dist > 1.0) {
+      discard;
+    }
+
+    oColor = vec4(uColor, 1.0 - smoothstep(0.7, 1.0, dist));
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* DataLayer::LINE_VERT = R"(
+#version 430
+
+layout(location=0) in vec3 iPositionHigh;
+layout(location=1) in vec3 iPositionLow;
+
+uniform mat4 uMatModelView;
+uniform mat4 uMatProjection;
+
+RELATIVE_TO_EYE_SNIPPET
+
+void main()
+{
+    vec3 position = relativeToEye(iPositionHigh, iPositionLow);
+    gl_Position   = uMatProjection * uMatModelView * vec4(position, 1.0);
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* DataLayer::LINE_FRAG = R"(
+#version 430
+
+uniform vec3 uColor;
+
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    oColor = vec4(uColor, 1.0);
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DataLayer::GPUTile::GPUTile() {
+  glGenBuffers(1, &mPointBuffer);
+
+  mLineVAO.EnableAttributeArray(0);
+  mLineVAO.SpecifyAttributeArrayFloat(
+      0, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), 0, &mLineVBO);
+  mLineVAO.EnableAttributeArray(1);
+  mLineVAO.SpecifyAttributeArrayFloat(
+      1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), sizeof(glm::vec3), &mLineVBO);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DataLayer::GPUTile::~GPUTile() {
+  glDeleteBuffers(1, &mPointBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DataLayer::DataLayer(std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string name)
+    : mSolarSystem(std::move(solarSystem))
+    , mName(std::move(name))
+    , mTimerId(cs::utils::FrameStats::intern("Data layer " + mName)) {
+
+  std::string pointVert(POINT_VERT);
+  cs::utils::replaceString(
+      pointVert, "RELATIVE_TO_EYE_SNIPPET", cs::scene::RelativeToEye::getShaderSnippet());
+
+  mPointShader.InitVertexShaderFromString(pointVert);
+  mPointShader.InitFragmentShaderFromString(POINT_FRAG);
+  mPointShader.Link();
+
+  mPointRelativeToEye.init(&mPointShader);
+
+  mPointUniforms.modelViewMatrix  = mPointShader.GetUniformLocation("uMatModelView");
+  mPointUniforms.projectionMatrix = mPointShader.GetUniformLocation("uMatProjection");
+  mPointUniforms.pointSize        = mPointShader.GetUniformLocation("uPointSize");
+  mPointUniforms.color            = mPointShader.GetUniformLocation("uColor");
+
+  std::string lineVert(LINE_VERT);
+  cs::utils::replaceString(
+      lineVert, "RELATIVE_TO_EYE_SNIPPET", cs::scene::RelativeToEye::getShaderSnippet());
+
+  mLineShader.InitVertexShaderFromString(lineVert);
+  mLineShader.InitFragmentShaderFromString(LINE_FRAG);
+  mLineShader.Link();
+
+  mLineRelativeToEye.init(&mLineShader);
+
+  mLineUniforms.modelViewMatrix  = mLineShader.GetUniformLocation("uMatModelView");
+  mLineUniforms.projectionMatrix = mLineShader.GetUniformLocation("uMatProjection");
+  mLineUniforms.color            = mLineShader.GetUniformLocation("uColor");
+
+  // All vertices are drawn relative to the observer, therefore we do not want any transformation.
+  auto* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
+
+  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+      mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::eOpaqueNonHDR));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DataLayer::~DataLayer() {
+  auto* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  pSG->GetRoot()->DisconnectChild(mGLNode.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DataLayer::configure(Plugin::Settings::Layer const& settings) {
+  bool reload = mLayerSettings.mFile != settings.mFile ||
+                mLayerSettings.mObject != settings.mObject ||
+                mLayerSettings.mHeightOffset != settings.mHeightOffset ||
+                mLayerSettings.mClampToSurface != settings.mClampToSurface;
+
+  mLayerSettings = settings;
+
+  if (reload) {
+    loadFile();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& DataLayer::getName() const {
+  return mName;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& DataLayer::getObjectName() const {
+  return mLayerSettings.mObject;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DataLayer::loadFile() {
+  auto object = mSolarSystem->getObject(mLayerSettings.mObject);
+
+  if (!object) {
+    logger().warn("Cannot load data layer '{}': There is no object called '{}'!", mName,
+        mLayerSettings.mObject);
+    return;
+  }
+
+  // The current data is drawn until the new data is loaded.
+  mHeightQuery.reset();
+  mHeightsClamped = false;
+
+  mPendingDataSet = std::async(std::launch::async,
+      [name = mName, file = mLayerSettings.mFile, radii = object->getRadii(),
+          heightOffset = mLayerSettings.mHeightOffset.get()]() {
+        DataSet dataSet;
+
+        try {
+          std::ifstream stream(file);
+
+          if (!stream) {
+            throw std::runtime_error("Cannot open file '" + file + "'!");
+          }
+
+          dataSet = parseGeoJSON(nlohmann::json::parse(stream), TILE_LEVEL);
+          computePositions(dataSet, radii, heightOffset);
+
+        } catch (std::exception const& e) {
+          logger().error("Failed to load data layer '{}': {}", name, e.what());
+        }
+
+        return dataSet;
+      });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DataLayer::update() {
+  if (mPendingDataSet.valid() &&
+      mPendingDataSet.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    mDataSet = mPendingDataSet.get();
+
+    mGPUTiles.clear();
+    for (std::size_t i = 0; i < mDataSet.mTiles.size(); ++i) {
+      mGPUTiles.push_back(std::make_unique<GPUTile>());
+    }
+
+    mNextUpload = 0;
+  }
+
+  auto object = mSolarSystem->getObject(mLayerSettings.mObject);
+
+  // Once the data is loaded, the heights of all points and line vertices are requested from the
+  // surface with one batched query.
+  if (object && mLayerSettings.mClampToSurface.get() && !mHeightsClamped &&
+      !mPendingDataSet.valid() && !mDataSet.mTiles.empty()) {
+
+    if (!mHeightQuery && object->getSurface()) {
+      std::vector<glm::dvec2> lngLats;
+
+      for (auto const& tile : mDataSet.mTiles) {
+        for (auto const* lngLatHeights : {&tile.mPointLngLatHeights, &tile.mLineLngLatHeights}) {
+          for (auto const& lngLatHeight : *lngLatHeights) {
+            lngLats.emplace_back(lngLatHeight);
+          }
+        }
+      }
+
+      mHeightQuery = object->getSurface()->requestHeights(std::move(lngLats));
+    }
+
+    if (mHeightQuery && mHeightQuery->mReady) {
+      auto height = mHeightQuery->mHeights.begin();
+
+      for (auto& tile : mDataSet.mTiles) {
+        for (auto* lngLatHeights : {&tile.mPointLngLatHeights, &tile.mLineLngLatHeights}) {
+          for (auto& lngLatHeight : *lngLatHeights) {
+            lngLatHeight.z = *height++;
+          }
+        }
+      }
+
+      // All tiles are uploaded again, the old positions are drawn until then.
+      computePositions(mDataSet, object->getRadii(), mLayerSettings.mHeightOffset.get());
+      mHeightQuery.reset();
+      mHeightsClamped = true;
+      mNextUpload     = 0;
+    }
+  }
+
+  std::size_t uploadedBytes = 0;
+
+  while (mNextUpload < mGPUTiles.size() && uploadedBytes < MAX_UPLOAD_BYTES_PER_FRAME) {
+    uploadedBytes += uploadTile(mNextUpload);
+    ++mNextUpload;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DataLayer::uploadTile(std::size_t index) {
+  auto const& tile    = mDataSet.mTiles[index];
+  auto&       gpuTile = *mGPUTiles[index];
+
+  auto points = cs::scene::RelativeToEye::splitInterleaved(tile.mPointPositions);
+  auto lines  = cs::scene::RelativeToEye::splitInterleaved(tile.mLinePositions);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuTile.mPointBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+      static_cast<GLsizeiptr>(points.size() * sizeof(glm::vec3)), points.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  gpuTile.mLineVBO.Bind(GL_ARRAY_BUFFER);
+  gpuTile.mLineVBO.BufferData(lines.size() * sizeof(glm::vec3), lines.data(), GL_STATIC_DRAW);
+  gpuTile.mLineVBO.Release();
+
+  gpuTile.mUploaded = true;
+
+  return (points.size() + lines.size()) * sizeof(glm::vec3);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<nlohmann::json> DataLayer::pick(
+    glm::dvec3 const& position, double maxDistance) const {
+  std::optional<uint32_t> closestFeature;
+  double                  closestDistance = maxDistance;
+
+  for (auto const& tile : mDataSet.mTiles) {
+    if (glm::distance(tile.mCenter, position) > tile.mRadius + closestDistance) {
+      continue;
+    }
+
+    for (std::size_t i = 0; i < tile.mPointPositions.size(); ++i) {
+      double distance = glm::distance(tile.mPointPositions[i], position);
+      if (distance < closestDistance) {
+        closestDistance = distance;
+        closestFeature  = tile.mPointFeatures[i];
+      }
+    }
+
+    for (std::size_t i = 0; i < tile.mLineFirsts.size(); ++i) {
+      auto first = static_cast<std::size_t>(tile.mLineFirsts[i]);
+      auto last  = first + static_cast<std::size_t>(tile.mLineCounts[i]) - 1;
+
+      for (std::size_t j = first; j < last; ++j) {
+        glm::dvec3 a = tile.mLinePositions[j];
+        glm::dvec3 b = tile.mLinePositions[j + 1];
+
+        // The distance to the closest point on the segment.
+        double length2 = glm::dot(b - a, b - a);
+        double t = length2 > 0.0 ? glm::clamp(glm::dot(position - a, b - a) / length2, 0.0, 1.0)
+                                 : 0.0;
+        double distance = glm::distance(a + t * (b - a), position);
+
+        if (distance < closestDistance) {
+          closestDistance = distance;
+          closestFeature  = tile.mLineFeatures[i];
+        }
+      }
+    }
+  }
+
+  if (!closestFeature) {
+    return std::nullopt;
+  }
+
+  return mDataSet.mProperties[*closestFeature];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DataLayer::Do() {
+  auto object = mSolarSystem->getObject(mLayerSettings.mObject);
+
+  if (!object || !object->getIsBodyVisible() || mGPUTiles.empty()) {
+    return true;
+  }
+
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
+
+  // Only the position of the observer relative to the body changes, the vertices stay the same.
+  auto const& transform = object->getObserverRelativeTransform();
+  double      scale     = glm::length(glm::dvec3(transform[0]));
+  mPointRelativeToEye.update(transform);
+  mLineRelativeToEye.update(transform);
+
+  std::array<GLfloat, 16> glMatMV{};
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+
+  std::array<GLint, 4> viewport{};
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
+
+  // The tiles are culled against the four side planes of the view frustum, like in the DrawList.
+  glm::dmat4 matVP =
+      glm::dmat4(glm::make_mat4x4(glMatP.data())) * glm::dmat4(glm::make_mat4x4(glMatMV.data()));
+
+  std::array<glm::dvec4, 4> planes{
+      glm::row(matVP, 3) + glm::row(matVP, 0),
+      glm::row(matVP, 3) - glm::row(matVP, 0),
+      glm::row(matVP, 3) + glm::row(matVP, 1),
+      glm::row(matVP, 3) - glm::row(matVP, 1),
+  };
+
+  for (auto& plane : planes) {
+    plane /= glm::length(glm::dvec3(plane));
+  }
+
+  mVisibleTiles.clear();
+
+  for (std::size_t i = 0; i < mGPUTiles.size(); ++i) {
+    auto const& tile = mDataSet.mTiles[i];
+
+    if (!mGPUTiles[i]->mUploaded || (tile.mPointPositions.empty() && tile.mLineFirsts.empty())) {
+      continue;
+    }
+
+    glm::dvec3 center(transform * glm::dvec4(tile.mCenter, 1.0));
+    double     radius = tile.mRadius * scale;
+
+    bool visible = std::all_of(planes.begin(), planes.end(), [&](glm::dvec4 const& plane) {
+      return glm::dot(glm::dvec3(plane), center) + plane.w > -radius;
+    });
+
+    if (!visible) {
+      continue;
+    }
+
+    // Distant tiles only draw a prefix of their points, which is an evenly distributed subset. The
+    // number of points depends on the area the tile covers on screen.
+    auto   pointCount = static_cast<double>(tile.mPointPositions.size());
+    double distance   = glm::length(center);
+
+    if (distance > radius) {
+      double pixels   = radius / distance * glMatP[5] * viewport[3] * 0.5;
+      double area     = glm::pi<double>() * pixels * pixels;
+      double maxCount = area * mLayerSettings.mPointDensity.get();
+      pointCount      = std::min(pointCount, std::max(1.0, maxCount));
+    }
+
+    mVisibleTiles.emplace_back(i, static_cast<int32_t>(pointCount));
+  }
+
+  if (mVisibleTiles.empty()) {
+    return true;
+  }
+
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_LINE_BIT);
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  glEnable(GL_LINE_SMOOTH);
+  glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+  glLineWidth(mLayerSettings.mLineWidth.get());
+
+  glm::vec3 color = mLayerSettings.mColor.get();
+
+  // The half size of the points in normalized device coordinates.
+  glm::vec2 pointSize =
+      glm::vec2(mLayerSettings.mPointSize.get()) / glm::vec2(viewport[2], viewport[3]);
+
+  mPointShader.Bind();
+  glUniformMatrix4fv(mPointUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
+  glUniformMatrix4fv(mPointUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+  mPointShader.SetUniform(mPointUniforms.pointSize, pointSize.x, pointSize.y);
+  mPointShader.SetUniform(mPointUniforms.color, color.r, color.g, color.b);
+  mPointRelativeToEye.bind();
+
+  for (auto const& [index, pointCount] : mVisibleTiles) {
+    if (pointCount > 0) {
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_BINDING, mGPUTiles[index]->mPointBuffer);
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, pointCount);
+    }
+  }
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_BINDING, 0);
+  mPointShader.Release();
+
+  mLineShader.Bind();
+  glUniformMatrix4fv(mLineUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
+  glUniformMatrix4fv(mLineUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+  mLineShader.SetUniform(mLineUniforms.color, color.r, color.g, color.b);
+  mLineRelativeToEye.bind();
+
+  for (auto const& visibleTile : mVisibleTiles) {
+    auto        index = visibleTile.first;
+    auto const& tile  = mDataSet.mTiles[index];
+
+    if (!tile.mLineFirsts.empty()) {
+      mGPUTiles[index]->mLineVAO.Bind();
+      glMultiDrawArrays(GL_LINE_STRIP, tile.mLineFirsts.data(), tile.mLineCounts.data(),
+          static_cast<GLsizei>(tile.mLineFirsts.size()));
+      mGPUTiles[index]->mLineVAO.Release();
+    }
+  }
+
+  mLineShader.Release();
+
+  glPopAttrib();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DataLayer::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::datalayers
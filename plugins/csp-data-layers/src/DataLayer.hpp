@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_DATA_LAYERS_DATA_LAYER_HPP
+#define CSP_DATA_LAYERS_DATA_LAYER_HPP
+
+#include "../../../src/cs-scene/CelestialSurface.hpp"
+#include "../../../src/cs-scene/RelativeToEye.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "DataTiles.hpp"
+#include "Plugin.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
+#include <VistaOGLExt/VistaBufferObject.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <VistaOGLExt/VistaVertexArrayObject.h>
+
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cs::core {
+class SolarSystem;
+} // namespace cs::core
+
+namespace csp::datalayers {
+
+/// A DataLayer draws the points and lines of one GeoJSON file on a celestial body. The file is
+/// parsed and tiled on a background thread. Afterwards, the tiles are uploaded to the GPU over
+/// several frames, so that even files with millions of points do not cause a stutter. All points of
+/// a tile are drawn as instanced quads with one draw call, the line strips of a tile with one
+/// glMultiDrawArrays() call. The vertices are stored relative to the body and drawn with the
+/// relative-to-eye scheme, so they are never uploaded again when the observer moves.
+class DataLayer : public IVistaOpenGLDraw {
+ public:
+  DataLayer(std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string name);
+
+  DataLayer(DataLayer const& other) = delete;
+  DataLayer(DataLayer&& other)      = delete;
+
+  DataLayer& operator=(DataLayer const& other) = delete;
+  DataLayer& operator=(DataLayer&& other) = delete;
+
+  ~DataLayer() override;
+
+  /// Configures the layer according to the given values. The file is only loaded again if the file,
+  /// the object or one of the height settings changed.
+  void configure(Plugin::Settings::Layer const& settings);
+
+  std::string const& getName() const;
+  std::string const& getObjectName() const;
+
+  /// Takes over the loaded data and uploads some of the tiles to the GPU.
+  void update();
+
+  /// Returns the properties of the feature whose point or line is closest to the given position,
+  /// if it is not further away than maxDistance. The position and the distance are given in meters
+  /// in the frame of the object.
+  std::optional<nlohmann::json> pick(glm::dvec3 const& position, double maxDistance) const;
+
+  /// Interface implementation of IVistaOpenGLDraw.
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  // The GPU resources of one DataTile. The points are read from a shader storage buffer by
+  // gl_InstanceID, the lines are drawn from a vertex buffer.
+  struct GPUTile {
+    GPUTile();
+    ~GPUTile();
+
+    GPUTile(GPUTile const& other) = delete;
+    GPUTile(GPUTile&& other)      = delete;
+
+    GPUTile& operator=(GPUTile const& other) = delete;
+    GPUTile& operator=(GPUTile&& other) = delete;
+
+    uint32_t               mPointBuffer = 0;
+    VistaVertexArrayObject mLineVAO;
+    VistaBufferObject      mLineVBO;
+    bool                   mUploaded = false;
+  };
+
+  void loadFile();
+
+  // Returns the number of uploaded bytes.
+  std::size_t uploadTile(std::size_t index);
+
+  std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
+  std::string                            mName;
+  Plugin::Settings::Layer                mLayerSettings;
+  cs::utils::FrameStats::TimerId         mTimerId;
+
+  std::unique_ptr<VistaOpenGLNode> mGLNode;
+
+  std::future<DataSet>                  mPendingDataSet;
+  DataSet                               mDataSet;
+  std::vector<std::unique_ptr<GPUTile>> mGPUTiles;
+
+  // All tiles with a smaller index have been uploaded after the data or its heights changed.
+  std::size_t mNextUpload = 0;
+
+  // If mClampToSurface is set, the heights of all points are requested once from the surface.
+  std::shared_ptr<cs::scene::CelestialSurface::HeightQuery const> mHeightQuery;
+  bool                                                            mHeightsClamped = false;
+
+  VistaGLSLShader          mPointShader;
+  VistaGLSLShader          mLineShader;
+  cs::scene::RelativeToEye mPointRelativeToEye;
+  cs::scene::RelativeToEye mLineRelativeToEye;
+
+  struct {
+    uint32_t modelViewMatrix  = 0;
+    uint32_t projectionMatrix = 0;
+    uint32_t pointSize        = 0;
+    uint32_t color            = 0;
+  } mPointUniforms;
+
+  struct {
+    uint32_t modelViewMatrix  = 0;
+    uint32_t projectionMatrix = 0;
+    uint32_t color            = 0;
+  } mLineUniforms;
+
+  // The index of each visible tile and the number of its points which are drawn. This is reused
+  // for each view, so that no memory has to be allocated during drawing.
+  std::vector<std::pair<std::size_t, int32_t>> mVisibleTiles;
+
+  static const char* POINT_VERT;
+  static const char* POINT_FRAG;
+  static const char* LINE_VERT;
+  static const char* LINE_FRAG;
+};
+
+} // namespace csp::datalayers
+
+#endif // CSP_DATA_LAYERS_DATA_LAYER_HPP
@@ -0,0 +1,231 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "DataTiles.hpp"
+
+#include "../../../src/cs-utils/convert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace csp::datalayers {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 toLngLatHeight(nlohmann::json const& position) {
+  if (!position.is_array() || position.size() < 2) {
+    throw std::runtime_error("Invalid GeoJSON position '" + position.dump() + "'!");
+  }
+
+  double height = position.size() > 2 ? position[2].get<double>() : 0.0;
+
+  return {cs::utils::convert::toRadians(position[0].get<double>()),
+      cs::utils::convert::toRadians(position[1].get<double>()), height};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t getTileIndex(glm::dvec3 const& lngLatHeight, uint32_t level) {
+  std::size_t rows = std::size_t(1) << level;
+  std::size_t cols = 2 * rows;
+
+  // Longitudes outside of [-pi, pi) are wrapped around.
+  double u = (lngLatHeight.x + glm::pi<double>()) / (2.0 * glm::pi<double>());
+  u -= std::floor(u);
+
+  double v = std::max((lngLatHeight.y + 0.5 * glm::pi<double>()) / glm::pi<double>(), 0.0);
+
+  auto x = std::min(static_cast<std::size_t>(u * static_cast<double>(cols)), cols - 1);
+  auto y = std::min(static_cast<std::size_t>(v * static_cast<double>(rows)), rows - 1);
+
+  return y * cols + x;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void addPoint(DataSet& dataSet, uint32_t level, nlohmann::json const& position, uint32_t feature) {
+  auto  lngLatHeight = toLngLatHeight(position);
+  auto& tile         = dataSet.mTiles[getTileIndex(lngLatHeight, level)];
+
+  tile.mPointLngLatHeights.push_back(lngLatHeight);
+  tile.mPointFeatures.push_back(feature);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void addLineString(
+    DataSet& dataSet, uint32_t level, nlohmann::json const& positions, uint32_t feature) {
+  if (!positions.is_array() || positions.size() < 2) {
+    throw std::runtime_error("Invalid GeoJSON line string '" + positions.dump() + "'!");
+  }
+
+  // The entire strip is stored in the tile of its first vertex. As the bounding sphere of the tile
+  // includes all vertices, the tile is still culled correctly.
+  auto& tile = dataSet.mTiles[getTileIndex(toLngLatHeight(positions[0]), level)];
+
+  tile.mLineFirsts.push_back(static_cast<int32_t>(tile.mLineLngLatHeights.size()));
+  tile.mLineCounts.push_back(static_cast<int32_t>(positions.size()));
+  tile.mLineFeatures.push_back(feature);
+
+  for (auto const& position : positions) {
+    tile.mLineLngLatHeights.push_back(toLngLatHeight(position));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void addGeometry(
+    DataSet& dataSet, uint32_t level, nlohmann::json const& geometry, uint32_t feature) {
+  auto type = geometry.at("type").get<std::string>();
+
+  if (type == "GeometryCollection") {
+    for (auto const& child : geometry.at("geometries")) {
+      addGeometry(dataSet, level, child, feature);
+    }
+    return;
+  }
+
+  auto const& coordinates = geometry.at("coordinates");
+
+  if (type == "Point") {
+    addPoint(dataSet, level, coordinates, feature);
+  } else if (type == "MultiPoint") {
+    for (auto const& position : coordinates) {
+      addPoint(dataSet, level, position, feature);
+    }
+  } else if (type == "LineString") {
+    addLineString(dataSet, level, coordinates, feature);
+  } else if (type == "MultiLineString" || type == "Polygon") {
+    // The rings of a polygon are already closed, as their first and last positions are the same.
+    for (auto const& lineString : coordinates) {
+      addLineString(dataSet, level, lineString, feature);
+    }
+  } else if (type == "MultiPolygon") {
+    for (auto const& polygon : coordinates) {
+      for (auto const& ring : polygon) {
+        addLineString(dataSet, level, ring, feature);
+      }
+    }
+  } else {
+    throw std::runtime_error("Unsupported GeoJSON geometry type '" + type + "'!");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void addFeature(DataSet& dataSet, uint32_t level, nlohmann::json const& feature) {
+  auto index = static_cast<uint32_t>(dataSet.mProperties.size());
+  dataSet.mProperties.push_back(feature.value("properties", nlohmann::json::object()));
+
+  // Features without a geometry are allowed by the GeoJSON specification.
+  auto const& geometry = feature.at("geometry");
+  if (!geometry.is_null()) {
+    addGeometry(dataSet, level, geometry, index);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DataSet parseGeoJSON(nlohmann::json const& geoJSON, uint32_t level) {
+  DataSet dataSet;
+  dataSet.mTiles.resize(std::size_t(2) << (2 * level));
+
+  try {
+    auto type = geoJSON.at("type").get<std::string>();
+
+    if (type == "FeatureCollection") {
+      for (auto const& feature : geoJSON.at("features")) {
+        addFeature(dataSet, level, feature);
+      }
+    } else if (type == "Feature") {
+      addFeature(dataSet, level, geoJSON);
+    } else {
+      dataSet.mProperties.emplace_back(nlohmann::json::object());
+      addGeometry(dataSet, level, geoJSON, 0);
+    }
+  } catch (nlohmann::json::exception const& e) {
+    throw std::runtime_error(std::string("Invalid GeoJSON: ") + e.what());
+  }
+
+  // Shuffle the points of each tile, so that any prefix is an evenly distributed subset. A fixed
+  // seed makes sure that the same points are shown each time the data is loaded.
+  std::mt19937 generator(0);
+
+  for (auto& tile : dataSet.mTiles) {
+    std::vector<std::size_t> order(tile.mPointLngLatHeights.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), generator);
+
+    std::vector<glm::dvec3> lngLatHeights(order.size());
+    std::vector<uint32_t>   features(order.size());
+
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      lngLatHeights[i] = tile.mPointLngLatHeights[order[i]];
+      features[i]      = tile.mPointFeatures[order[i]];
+    }
+
+    tile.mPointLngLatHeights = std::move(lngLatHeights);
+    tile.mPointFeatures      = std::move(features);
+  }
+
+  return dataSet;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void computePositions(DataSet& dataSet, glm::dvec3 const& radii, double heightOffset) {
+  auto convert = [&](std::vector<glm::dvec3> const& lngLatHeights,
+                     std::vector<glm::dvec3>&       positions) {
+    positions.resize(lngLatHeights.size());
+
+    for (std::size_t i = 0; i < lngLatHeights.size(); ++i) {
+      positions[i] = cs::utils::convert::toCartesian(
+          glm::dvec2(lngLatHeights[i]), radii, lngLatHeights[i].z + heightOffset);
+    }
+  };
+
+  for (auto& tile : dataSet.mTiles) {
+    convert(tile.mPointLngLatHeights, tile.mPointPositions);
+    convert(tile.mLineLngLatHeights, tile.mLinePositions);
+
+    // The bounding sphere is centered at the average of all positions.
+    std::size_t count = tile.mPointPositions.size() + tile.mLinePositions.size();
+
+    if (count == 0) {
+      tile.mCenter = glm::dvec3(0.0);
+      tile.mRadius = 0.0;
+      continue;
+    }
+
+    glm::dvec3 sum = std::accumulate(
+        tile.mPointPositions.begin(), tile.mPointPositions.end(), glm::dvec3(0.0));
+    sum = std::accumulate(tile.mLinePositions.begin(), tile.mLinePositions.end(), sum);
+
+    tile.mCenter = sum / static_cast<double>(count);
+    tile.mRadius = 0.0;
+
+    for (auto const* positions : {&tile.mPointPositions, &tile.mLinePositions}) {
+      for (auto const& position : *positions) {
+        tile.mRadius = std::max(tile.mRadius, glm::distance(tile.mCenter, position));
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::datalayers
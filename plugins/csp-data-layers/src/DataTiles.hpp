@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_DATA_LAYERS_DATA_TILES_HPP
+#define CSP_DATA_LAYERS_DATA_TILES_HPP
+
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::datalayers {
+
+/// The data of a layer is split into tiles of a longitude / latitude grid. Each tile contains the
+/// points and the line strips which start in this tile. The points of a tile are stored in a
+/// progressive order: any prefix of them is an evenly distributed subset of all points of the
+/// tile. Hence, distant tiles can be drawn by drawing only the first few points.
+struct DataTile {
+  /// Longitude and latitude in radians and the height above the ellipsoid in meters.
+  std::vector<glm::dvec3> mPointLngLatHeights;
+  std::vector<uint32_t>   mPointFeatures;
+
+  /// The vertices of all line strips one after another. The first vertex and the number of
+  /// vertices of each strip are stored in mLineFirsts and mLineCounts, the index of the feature it
+  /// belongs to in mLineFeatures.
+  std::vector<glm::dvec3> mLineLngLatHeights;
+  std::vector<int32_t>    mLineFirsts;
+  std::vector<int32_t>    mLineCounts;
+  std::vector<uint32_t>   mLineFeatures;
+
+  /// The cartesian positions of the points and line vertices in the body's frame. These and the
+  /// bounding sphere around them are computed by computePositions().
+  std::vector<glm::dvec3> mPointPositions;
+  std::vector<glm::dvec3> mLinePositions;
+  glm::dvec3              mCenter{0.0};
+  double                  mRadius = 0.0;
+};
+
+/// All tiles of one layer together with the properties of the features the points and lines
+/// belong to.
+struct DataSet {
+  std::vector<DataTile>       mTiles;
+  std::vector<nlohmann::json> mProperties;
+};
+
+/// Parses a GeoJSON object. This can be a FeatureCollection, a single Feature, or a bare geometry.
+/// Points and line strings, including their multi-part variants, are supported. Of polygons, only
+/// the outlines are stored as closed line strips. Coordinates are given in degrees; the optional
+/// third coordinate is the height above the ellipsoid in meters. The data is split into 2^level
+/// times 2^(level+1) tiles. This throws a std::runtime_error if the object is not valid GeoJSON.
+DataSet parseGeoJSON(nlohmann::json const& geoJSON, uint32_t level);
+
+/// Computes the cartesian positions and the bounding spheres of all tiles for an ellipsoid with the
+/// given radii. The height offset is added to the height of each point. This can be called again
+/// whenever the heights change.
+void computePositions(DataSet& dataSet, glm::dvec3 const& radii, double heightOffset);
+
+} // namespace csp::datalayers
+
+#endif // CSP_DATA_LAYERS_DATA_TILES_HPP
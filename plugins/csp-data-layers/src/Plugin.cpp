@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Plugin.hpp"
+
+#include "../../../src/cs-core/GuiManager.hpp"
+#include "../../../src/cs-core/InputManager.hpp"
+#include "../../../src/cs-core/Settings.hpp"
+#include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-utils/logger.hpp"
+#include "DataLayer.hpp"
+#include "logger.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EXPORT_FN cs::core::PluginBase* create() {
+  return new csp::datalayers::Plugin;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EXPORT_FN void destroy(cs::core::PluginBase* pluginBase) {
+  delete pluginBase; // NOLINT(cppcoreguidelines-owning-memory)
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace csp::datalayers {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// A feature is picked if it is closer to the point under the mouse pointer than this fraction of
+// the distance between the observer and this point.
+double const PICK_TOLERANCE = 0.005;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void from_json(nlohmann::json const& j, Plugin::Settings::Layer& o) {
+  cs::core::Settings::deserialize(j, "object", o.mObject);
+  cs::core::Settings::deserialize(j, "file", o.mFile);
+  cs::core::Settings::deserialize(j, "color", o.mColor);
+  cs::core::Settings::deserialize(j, "pointSize", o.mPointSize);
+  cs::core::Settings::deserialize(j, "lineWidth", o.mLineWidth);
+  cs::core::Settings::deserialize(j, "pointDensity", o.mPointDensity);
+  cs::core::Settings::deserialize(j, "clampToSurface", o.mClampToSurface);
+  cs::core::Settings::deserialize(j, "heightOffset", o.mHeightOffset);
+}
+
+void to_json(nlohmann::json& j, Plugin::Settings::Layer const& o) {
+  cs::core::Settings::serialize(j, "object", o.mObject);
+  cs::core::Settings::serialize(j, "file", o.mFile);
+  cs::core::Settings::serialize(j, "color", o.mColor);
+  cs::core::Settings::serialize(j, "pointSize", o.mPointSize);
+  cs::core::Settings::serialize(j, "lineWidth", o.mLineWidth);
+  cs::core::Settings::serialize(j, "pointDensity", o.mPointDensity);
+  cs::core::Settings::serialize(j, "clampToSurface", o.mClampToSurface);
+  cs::core::Settings::serialize(j, "heightOffset", o.mHeightOffset);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void from_json(nlohmann::json const& j, Plugin::Settings& o) {
+  cs::core::Settings::deserialize(j, "layers", o.mLayers);
+}
+
+void to_json(nlohmann::json& j, Plugin::Settings const& o) {
+  cs::core::Settings::serialize(j, "layers", o.mLayers);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::init() {
+
+  logger().info("Loading plugin...");
+
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-data-layers")) {
+      onLoad();
+    }
+  });
+  mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
+
+  // Show the properties of a feature when it is clicked.
+  mOnClickConnection = mInputManager->pButtons[0].connect([this](bool pressed) {
+    if (!pressed && !mInputManager->pHoveredGuiItem.get()) {
+      onClick();
+    }
+  });
+
+  // Load settings.
+  onLoad();
+
+  logger().info("Loading done.");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::deInit() {
+  logger().info("Unloading plugin...");
+
+  // Save settings as this plugin may get reloaded.
+  onSave();
+
+  mAllSettings->onLoad().disconnect(mOnLoadConnection);
+  mAllSettings->onSave().disconnect(mOnSaveConnection);
+  mInputManager->pButtons[0].disconnect(mOnClickConnection);
+
+  logger().info("Unloading done.");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::update() {
+  for (auto const& [name, layer] : mDataLayers) {
+    layer->update();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::onLoad() {
+  // Read settings from JSON.
+  from_json(mAllSettings->mPlugins.at("csp-data-layers"), mPluginSettings);
+
+  // First try to re-configure existing layers. Layers which are not in the settings anymore are
+  // deleted.
+  auto layer = mDataLayers.begin();
+  while (layer != mDataLayers.end()) {
+    auto settings = mPluginSettings.mLayers.find(layer->first);
+    if (settings != mPluginSettings.mLayers.end()) {
+      layer->second->configure(settings->second);
+
+      ++layer;
+    } else {
+      layer = mDataLayers.erase(layer);
+    }
+  }
+
+  // Then add new layers.
+  for (auto const& settings : mPluginSettings.mLayers) {
+    if (mDataLayers.find(settings.first) != mDataLayers.end()) {
+      continue;
+    }
+
+    auto layer = std::make_shared<DataLayer>(mSolarSystem, settings.first);
+    layer->configure(settings.second);
+
+    mDataLayers.emplace(settings.first, layer);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::onSave() {
+  mAllSettings->mPlugins["csp-data-layers"] = mPluginSettings;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::onClick() {
+  auto const& intersection = mInputManager->pHoveredObject.get();
+
+  if (!intersection.mObject) {
+    return;
+  }
+
+  // The position of the observer in the frame of the object.
+  glm::dvec3 observer(
+      glm::inverse(intersection.mObject->getObserverRelativeTransform()) * glm::dvec4(0, 0, 0, 1));
+  double tolerance = PICK_TOLERANCE * glm::distance(observer, intersection.mPosition);
+
+  for (auto const& [name, layer] : mDataLayers) {
+    if (layer->getObjectName() != intersection.mObjectName) {
+      continue;
+    }
+
+    auto properties = layer->pick(intersection.mPosition, tolerance);
+
+    if (properties) {
+      // If the feature has a name, this is shown instead of all of its properties.
+      auto text = properties->contains("name") && properties->at("name").is_string()
+                      ? properties->at("name").get<std::string>()
+                      : properties->dump();
+
+      mGuiManager->showNotification(name, text, "place");
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::datalayers
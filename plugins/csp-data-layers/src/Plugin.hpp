@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_DATA_LAYERS_PLUGIN_HPP
+#define CSP_DATA_LAYERS_PLUGIN_HPP
+
+#include "../../../src/cs-core/PluginBase.hpp"
+#include "../../../src/cs-utils/DefaultProperty.hpp"
+
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace csp::datalayers {
+
+class DataLayer;
+
+/// This plugin draws large sets of points and lines from GeoJSON files on the surface of celestial
+/// bodies. The data is loaded in the background, split into tiles and drawn with a level of detail
+/// which depends on the apparent size of each tile. Clicking on a point or line shows the
+/// properties of its feature. The configuration of this plugin is done via the provided json
+/// config. See README.md for details.
+class Plugin : public cs::core::PluginBase {
+ public:
+  struct Settings {
+    struct Layer {
+      /// The name of the object the data is drawn on.
+      std::string mObject;
+
+      /// The path to the GeoJSON file.
+      std::string mFile;
+
+      /// The color of the points and lines.
+      cs::utils::DefaultProperty<glm::vec3> mColor{glm::vec3(1.F, 0.6F, 0.F)};
+
+      /// The diameter of the points and the width of the lines in pixels.
+      cs::utils::DefaultProperty<float> mPointSize{6.F};
+      cs::utils::DefaultProperty<float> mLineWidth{2.F};
+
+      /// The maximum number of points which are drawn per square pixel of a tile. Smaller values
+      /// thin out the points of distant tiles more strongly.
+      cs::utils::DefaultProperty<float> mPointDensity{0.05F};
+
+      /// If set to true, the heights given in the file are replaced by the height of the surface
+      /// of the object once the data is loaded.
+      cs::utils::DefaultProperty<bool> mClampToSurface{false};
+
+      /// This is added to the height of each point in meters.
+      cs::utils::DefaultProperty<double> mHeightOffset{0.0};
+    };
+
+    /// All layers with their name as key.
+    std::map<std::string, Layer> mLayers;
+  };
+
+  void init() override;
+  void deInit() override;
+  void update() override;
+
+ private:
+  void onLoad();
+  void onSave();
+  void onClick();
+
+  Settings                                          mPluginSettings;
+  std::map<std::string, std::shared_ptr<DataLayer>> mDataLayers;
+
+  int mOnLoadConnection  = -1;
+  int mOnSaveConnection  = -1;
+  int mOnClickConnection = -1;
+};
+
+} // namespace csp::datalayers
+
+#endif // CSP_DATA_LAYERS_PLUGIN_HPP
@@ -0,0 +1,23 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "logger.hpp"
+
+#include "../../../src/cs-utils/logger.hpp"
+
+namespace csp::datalayers {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+spdlog::logger& logger() {
+  static auto logger = cs::utils::createLogger("csp-data-layers");
+  return *logger;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::datalayers
@@ -0,0 +1,21 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_DATA_LAYERS_LOGGER_HPP
+#define CSP_DATA_LAYERS_LOGGER_HPP
+
+#include <spdlog/spdlog.h>
+
+namespace csp::datalayers {
+
+/// This creates the default singleton logger for "csp-data-layers" when called for the first time
+/// and returns it. See cs-utils/logger.hpp for more logging details.
+spdlog::logger& logger();
+
+} // namespace csp::datalayers
+
+#endif // CSP_DATA_LAYERS_LOGGER_HPP
@@ -49,7 +49,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-demo-node-editor")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // Restart the node editor if the port changes.
@@ -9,8 +9,13 @@
 
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-core/TimeControl.hpp"
+#include "../../../src/cs-scene/CelestialSurface.hpp"
 #include "logger.hpp"
 
+#include <algorithm>
+#include <glm/gtx/quaternion.hpp>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 EXPORT_FN cs::core::PluginBase* create() {
@@ -29,10 +34,58 @@ namespace csp::flytolocations {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void from_json(nlohmann::json const& j, Plugin::Settings& o) {
+  cs::core::Settings::deserialize(j, "warmUpCaches", o.mWarmUpCaches);
+  cs::core::Settings::deserialize(j, "warmUpIdleTime", o.mWarmUpIdleTime);
+  cs::core::Settings::deserialize(j, "warmUpTimeout", o.mWarmUpTimeout);
+}
+
+void to_json(nlohmann::json& j, Plugin::Settings const& o) {
+  cs::core::Settings::serialize(j, "warmUpCaches", o.mWarmUpCaches);
+  cs::core::Settings::serialize(j, "warmUpIdleTime", o.mWarmUpIdleTime);
+  cs::core::Settings::serialize(j, "warmUpTimeout", o.mWarmUpTimeout);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns a downward-facing rotation for an observer at the given position. This matches the
+// rotation chosen by SolarSystem::flyObserverTo() for bookmarks without a rotation.
+glm::dquat getDownwardRotation(glm::dvec3 const& position) {
+  glm::dvec3 y = glm::dvec3(0, -1, 0);
+  glm::dvec3 z = position;
+  glm::dvec3 x = glm::cross(z, y);
+  y            = glm::cross(z, x);
+
+  x = glm::normalize(x);
+  y = glm::normalize(y);
+  z = glm::normalize(z);
+
+  return glm::toQuat(glm::dmat3(x, y, z));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::init() {
 
   logger().info("Loading plugin...");
 
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-fly-to-locations")) {
+      onLoad();
+    }
+  });
+  mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
+
+  onLoad();
+
   mGuiManager->executeJavascriptFile("../share/resources/gui/js/csp-fly-to-locations.js");
   mGuiManager->addCSS("css/csp-fly-to-locations.css");
 
@@ -50,6 +103,14 @@ void Plugin::init() {
       [this](uint32_t bookmarkID, cs::core::Settings::Bookmark const& /*bookmark*/) {
         mGuiManager->getGui()->callJavascript(
             "CosmoScout.flyToLocations.removeBookmark", bookmarkID);
+
+        auto queued = std::find(mWarmUpQueue.begin(), mWarmUpQueue.end(), bookmarkID);
+        if (queued != mWarmUpQueue.end()) {
+          if (queued == mWarmUpQueue.begin()) {
+            mWarmUpStart.reset();
+          }
+          mWarmUpQueue.erase(queued);
+        }
       });
 
   // Update bookmark-list if active body changes.
@@ -94,14 +155,82 @@ void Plugin::deInit() {
 
   mSolarSystem->pActiveObject.disconnect(mActiveBodyConnection);
 
+  mAllSettings->onLoad().disconnect(mOnLoadConnection);
+  mAllSettings->onSave().disconnect(mOnSaveConnection);
+
   logger().info("Unloading done.");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::update() {
+  if (!mPluginSettings.mWarmUpCaches.get() || mWarmUpQueue.empty()) {
+    return;
+  }
+
+  auto const& observer = mSolarSystem->getObserver();
+  auto        now      = std::chrono::steady_clock::now();
+
+  // Any movement of the observer postpones warming the caches. The bandwidth is then required for
+  // the current view and the bodies prefetch tiles along the path of the observer instead.
+  if (observer.isAnimationInProgress() || observer.getCenterName() != mLastObserverCenter ||
+      observer.getPosition() != mLastObserverPosition ||
+      observer.getRotation() != mLastObserverRotation) {
+    mLastObserverCenter   = observer.getCenterName();
+    mLastObserverPosition = observer.getPosition();
+    mLastObserverRotation = observer.getRotation();
+    mLastObserverMovement = now;
+    mWarmUpStart.reset();
+    return;
+  }
+
+  if (std::chrono::duration<double>(now - mLastObserverMovement).count() <
+      mPluginSettings.mWarmUpIdleTime.get()) {
+    return;
+  }
+
+  // The bookmarks are warmed one after another. Bookmarks which cannot be warmed are skipped.
+  while (!mWarmUpQueue.empty()) {
+    auto bookmark = mGuiManager->getBookmarks().find(mWarmUpQueue.front());
+
+    if (bookmark != mGuiManager->getBookmarks().end()) {
+      glm::dvec3 position;
+      glm::dquat rotation;
+
+      auto surface = getWarmUpView(bookmark->second, position, rotation);
+
+      if (surface) {
+        if (!mWarmUpStart) {
+          mWarmUpStart = now;
+        }
+
+        bool done    = surface->warmUp(position, rotation);
+        bool timeout = std::chrono::duration<double>(now - *mWarmUpStart).count() >
+                       mPluginSettings.mWarmUpTimeout.get();
+
+        if (!done && !timeout) {
+          return;
+        }
+
+        logger().debug("{} warming the caches for bookmark '{}'.", done ? "Finished" : "Stopped",
+            bookmark->second.mName);
+      }
+    }
+
+    mWarmUpQueue.pop_front();
+    mWarmUpStart.reset();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::onAddBookmark(uint32_t bookmarkID, cs::core::Settings::Bookmark const& bookmark) {
   // We only show bookmarks with locations.
   if (bookmark.mLocation) {
+    if (bookmark.mLocation.value().mPosition) {
+      mWarmUpQueue.push_back(bookmarkID);
+    }
+
     if (bookmark.mIcon && !bookmark.mIcon.value().empty()) {
       // Add as grid-bookmark if it has an icon.
       mGuiManager->getGui()->callJavascript("CosmoScout.flyToLocations.addGridBookmark", bookmarkID,
@@ -118,4 +247,52 @@ void Plugin::onAddBookmark(uint32_t bookmarkID, cs::core::Settings::Bookmark con
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<cs::scene::CelestialSurface> Plugin::getWarmUpView(
+    cs::core::Settings::Bookmark const& bookmark, glm::dvec3& position,
+    glm::dquat& rotation) const {
+
+  if (!bookmark.mLocation || !bookmark.mLocation.value().mPosition) {
+    return nullptr;
+  }
+
+  auto const& location = bookmark.mLocation.value();
+  auto        object   = mSolarSystem->getObjectByCenterName(location.mCenter);
+
+  if (!object || !object->getSurface()) {
+    return nullptr;
+  }
+
+  // The bookmark may be given in another frame than the object, so its view is transformed to the
+  // coordinate system of the object.
+  cs::scene::CelestialAnchor anchor(location.mCenter, location.mFrame);
+  anchor.setPosition(location.mPosition.value());
+  anchor.setRotation(
+      location.mRotation.value_or(getDownwardRotation(location.mPosition.value())));
+
+  try {
+    auto transform = object->getRelativeTransform(mTimeControl->pSimulationTime.get(), anchor);
+    position       = transform[3];
+    rotation       = glm::quat_cast(glm::dmat3(transform));
+  } catch (std::runtime_error const&) {
+    return nullptr;
+  }
+
+  return object->getSurface();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::onLoad() {
+  // Read settings from JSON.
+  from_json(mAllSettings->mPlugins.at("csp-fly-to-locations"), mPluginSettings);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::onSave() {
+  mAllSettings->mPlugins["csp-fly-to-locations"] = mPluginSettings;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::flytolocations
@@ -10,29 +10,82 @@
 
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/Settings.hpp"
+#include "../../../src/cs-utils/DefaultProperty.hpp"
 
+#include <chrono>
+#include <deque>
 #include <map>
 #include <optional>
 #include <string>
 #include <vector>
 
+namespace cs::scene {
+class CelestialSurface;
+} // namespace cs::scene
+
 namespace csp::flytolocations {
 
-/// This is a very simple plugin with no configuration options. It just shows the bookmarks in the
-/// sidebar. It will only show bookmarks which have an associated location. Bookmarks which have an
-/// icon and only a center & frame will be shown in a grid of buttons. Bookmarks which have an
-/// additional position will be shown in a list when a body with the same center name is currently
-/// active.
+/// This is a very simple plugin. It just shows the bookmarks in the sidebar. It will only show
+/// bookmarks which have an associated location. Bookmarks which have an icon and only a center &
+/// frame will be shown in a grid of buttons. Bookmarks which have an additional position will be
+/// shown in a list when a body with the same center name is currently active.
+///
+/// Optionally, the caches of the bodies are warmed for the views of all bookmarks with a position
+/// while the observer does not move. For this, the views are passed one after another to
+/// cs::scene::CelestialSurface::warmUp() of the body at the center of the bookmark.
 class Plugin : public cs::core::PluginBase {
  public:
+  struct Settings {
+    /// If enabled, the data for the views of all bookmarks with a position is loaded in the
+    /// background while the observer does not move. Jumping to a bookmark then shows the terrain
+    /// in full resolution right away.
+    cs::utils::DefaultProperty<bool> mWarmUpCaches{false};
+
+    /// The observer has to stand still for this many seconds before the caches are warmed.
+    cs::utils::DefaultProperty<double> mWarmUpIdleTime{10.0};
+
+    /// At most this many seconds are spent on each bookmark. This limits the bandwidth used for
+    /// bookmarks whose views require very many tiles.
+    cs::utils::DefaultProperty<double> mWarmUpTimeout{30.0};
+  };
+
   void init() override;
   void deInit() override;
+  void update() override;
 
  private:
   void onAddBookmark(uint32_t bookmarkID, cs::core::Settings::Bookmark const& bookmark);
-  int  mActiveBodyConnection        = -1;
-  int  mOnBookmarkAddedConnection   = -1;
-  int  mOnBookmarkRemovedConnection = -1;
+  void onLoad();
+  void onSave();
+
+  /// Computes the observer position and rotation of the given bookmark in the coordinate system of
+  /// the object at its center. Returns nullptr if the bookmark has no position, the object has no
+  /// surface, or the transformation cannot be computed.
+  std::shared_ptr<cs::scene::CelestialSurface> getWarmUpView(
+      cs::core::Settings::Bookmark const& bookmark, glm::dvec3& position,
+      glm::dquat& rotation) const;
+
+  Settings mPluginSettings;
+
+  int mActiveBodyConnection        = -1;
+  int mOnBookmarkAddedConnection   = -1;
+  int mOnBookmarkRemovedConnection = -1;
+  int mOnLoadConnection            = -1;
+  int mOnSaveConnection            = -1;
+
+  // The IDs of the bookmarks whose views have not been warmed yet. The first one is warmed at the
+  // moment.
+  std::deque<uint32_t> mWarmUpQueue;
+
+  // The observer has to stay at this location for mWarmUpIdleTime seconds before the caches are
+  // warmed.
+  std::string                           mLastObserverCenter;
+  glm::dvec3                            mLastObserverPosition{0.0};
+  glm::dquat                            mLastObserverRotation{1.0, 0.0, 0.0, 0.0};
+  std::chrono::steady_clock::time_point mLastObserverMovement;
+
+  // The time at which warming the first bookmark in mWarmUpQueue started.
+  std::optional<std::chrono::steady_clock::time_point> mWarmUpStart;
 };
 
 } // namespace csp::flytolocations
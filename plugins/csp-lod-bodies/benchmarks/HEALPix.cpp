@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/HEALPix.hpp"
+#include "../../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+namespace csp::lodbodies {
+TEST_CASE("csp::lodbodies::HEALPix [benchmark]" * doctest::skip()) {
+  using cs::utils::MicroBenchmark;
+  using cs::utils::doNotOptimize;
+
+  // All patches of a rather deep level are visited, so that the bit manipulations cannot be
+  // constant-folded.
+  HEALPixLevel const& level   = HEALPix::getLevel(10);
+  glm::int64 const    patches = 4096;
+  glm::dvec3 const    radii(6378137.0, 6378137.0, 6356752.3);
+
+  MicroBenchmark::run(
+      "HEALPix getBaseXY / getPatchIdx",
+      [&]() {
+        for (glm::int64 i = 0; i < patches; ++i) {
+          doNotOptimize(level.getPatchIdx(level.getBaseXY(i * 997)));
+        }
+      },
+      patches);
+
+  MicroBenchmark::run(
+      "HEALPix getNeighbours",
+      [&]() {
+        for (glm::int64 i = 0; i < patches; ++i) {
+          doNotOptimize(level.getNeighbours(i * 997));
+        }
+      },
+      patches);
+
+  MicroBenchmark::run(
+      "HEALPix getCornersCartesian",
+      [&]() {
+        for (glm::int64 i = 0; i < patches; ++i) {
+          doNotOptimize(level.getCornersCartesian(i * 997, radii));
+        }
+      },
+      patches);
+}
+} // namespace csp::lodbodies
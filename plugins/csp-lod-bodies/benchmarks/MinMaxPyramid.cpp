@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/MinMaxPyramid.hpp"
+#include "../../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/TileData.hpp"
+
+namespace csp::lodbodies {
+TEST_CASE("csp::lodbodies::MinMaxPyramid [benchmark]" * doctest::skip()) {
+
+  // The first one is the default resolution of elevation tiles.
+  for (uint32_t resolution : {128U, 256U}) {
+    TileData<float> tile(resolution);
+
+    for (uint32_t i = 0; i < resolution * resolution; ++i) {
+      tile.data()[i] = static_cast<float>((i * 7919U) % 1009U) - 500.F;
+    }
+
+    cs::utils::MicroBenchmark::run(
+        "MinMaxPyramid construction (" + std::to_string(resolution) + "px)", [&]() {
+          MinMaxPyramid pyramid(&tile);
+          cs::utils::doNotOptimize(pyramid);
+        });
+  }
+}
+} // namespace csp::lodbodies
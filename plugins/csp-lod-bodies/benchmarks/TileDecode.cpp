@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <boost/filesystem.hpp>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+#include <stb_image_write.h>
+#include <tiffio.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::lodbodies {
+
+// The tiles are decoded in the same way as in TileSourceWebMapService: Elevation tiles are read
+// scanline by scanline with libtiff, image tiles are loaded with stb_image. The files are written
+// to a temporary directory before.
+TEST_CASE("csp::lodbodies::TileDecode [benchmark]" * doctest::skip()) {
+  using cs::utils::MicroBenchmark;
+
+  auto directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  boost::filesystem::create_directories(directory);
+
+  // These are the default resolutions of elevation and image tiles.
+  uint32_t const demResolution = 128;
+  uint32_t const imgResolution = 512;
+
+  std::string const tiffFile = (directory / "tile.tiff").string();
+  std::string const pngFile  = (directory / "tile.png").string();
+
+  {
+    std::vector<float> heights(demResolution * demResolution);
+    for (std::size_t i = 0; i < heights.size(); ++i) {
+      heights[i] = static_cast<float>((i * 7919U) % 1009U) - 500.F;
+    }
+
+    auto* tiff = TIFFOpen(tiffFile.c_str(), "w");
+    REQUIRE(tiff);
+
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, demResolution);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, demResolution);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 32);
+    TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+
+    for (uint32_t y = 0; y < demResolution; ++y) {
+      TIFFWriteScanline(tiff, &heights[demResolution * y], y);
+    }
+
+    TIFFClose(tiff);
+  }
+
+  {
+    std::vector<glm::u8vec4> pixels(imgResolution * imgResolution);
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+      pixels[i] = glm::u8vec4(i % 251U, (i * 7U) % 241U, (i * 13U) % 239U, 255U);
+    }
+
+    REQUIRE(stbi_write_png(pngFile.c_str(), static_cast<int>(imgResolution),
+        static_cast<int>(imgResolution), 4, pixels.data(), static_cast<int>(imgResolution * 4)));
+  }
+
+  std::vector<float> heights(demResolution * demResolution);
+
+  MicroBenchmark::run("Decode TIFF elevation tile (128px)", [&]() {
+    TIFFSetWarningHandler(nullptr);
+    auto* tiff = TIFFOpen(tiffFile.c_str(), "r");
+
+    int imagelength{};
+    TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &imagelength);
+
+    for (int y = 0; y < imagelength; y++) {
+      TIFFReadScanline(tiff, &heights[demResolution * y], y);
+    }
+
+    TIFFClose(tiff);
+    cs::utils::doNotOptimize(heights);
+  });
+
+  MicroBenchmark::run("Decode PNG image tile (512px)", [&]() {
+    int width{};
+    int height{};
+    int bpp{};
+
+    auto* data = stbi_load(pngFile.c_str(), &width, &height, &bpp, 4);
+    cs::utils::doNotOptimize(data);
+    stbi_image_free(data);
+  });
+
+  boost::filesystem::remove_all(directory);
+}
+
+} // namespace csp::lodbodies
@@ -18,8 +18,9 @@ uniform float ambientOcclusion;
 uniform float texGamma;
 uniform vec4  uSunDirIlluminance;
 
-uniform sampler1D heightTex;
-uniform sampler2D fontTex;
+uniform sampler1DArray heightTex;
+uniform float          heightTexLayer;
+uniform sampler2D      fontTex;
 
 // ==========================================================================
 // include eclipse shadow computation code
@@ -103,7 +104,7 @@ void main() {
   {
     float height      = clamp(fsIn.height, heightMin, heightMax);
     float height_norm = (height - heightMin) / (heightMax - heightMin);
-    fragColor *= texture(heightTex, height_norm);
+    fragColor *= texture(heightTex, vec2(height_norm, heightTexLayer));
   }
 #endif
 
@@ -111,7 +112,7 @@ void main() {
   {
     float slope = acos(dot(idealNormal, surfaceNormal));
     float fac   = clamp((slope - slopeMin) / (slopeMax - slopeMin), 0.0, 1.0);
-    fragColor *= texture(heightTex, fac);
+    fragColor *= texture(heightTex, vec2(fac, heightTexLayer));
   }
 #endif
 
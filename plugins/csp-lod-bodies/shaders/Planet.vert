@@ -1,4 +1,5 @@
 #version 430
+#extension GL_ARB_shader_viewport_layer_array : enable
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //                               This file is part of CosmoScout VR                               //
@@ -35,22 +36,35 @@ out VS_OUT
 
 void main(void)
 {
+    VP_tileIndex = VP_firstTile + gl_InstanceID;
+
+    vec2 position = VP_getMorphedPosition();
+
     // all in view space
-    vsOut.position = VP_getVertexPosition(VP_iPosition, $TERRAIN_PROJECTION_TYPE);
+    vsOut.position = VP_getVertexPosition(position, $TERRAIN_PROJECTION_TYPE);
     gl_Position    = VP_matProjection * VP_matView * vec4(vsOut.position, 1);
 
+#ifdef GL_ARB_shader_viewport_layer_array
+    // In a layered shadow map pass, the tile is drawn into the cascade stored with the tile.
+    if (VP_shadowMapLayered)
+    {
+        gl_Position = VP_shadowProjectionViewMatrices[VP_shadowLayer] * vec4(vsOut.position, 1);
+        gl_Layer    = VP_shadowLayer;
+    }
+#endif
+
     if (!VP_shadowMapMode)
     {
         #if $LIGHTING_QUALITY > 2
-            vsOut.normal         = VP_getVertexNormal(VP_iPosition, $TERRAIN_PROJECTION_TYPE);
+            vsOut.normal         = VP_getVertexNormalPrecomputed(position);
         #elif $LIGHTING_QUALITY > 1
-            vsOut.normal         = VP_getVertexNormalLow(vsOut.position, VP_iPosition, $TERRAIN_PROJECTION_TYPE);
+            vsOut.normal         = VP_getVertexNormalLow(vsOut.position, position, $TERRAIN_PROJECTION_TYPE);
         #endif
         vsOut.sunDir         = (VP_matModel * vec4(uSunDirIlluminance.xyz, 0)).xyz;
         vsOut.planetCenter   = (VP_matModel * vec4(0,0,0,1)).xyz;
-        vsOut.tileCoords     = VP_getTileCoords(VP_iPosition);
-        vsOut.height         = VP_getVertexHeight(VP_iPosition);
-        vsOut.lngLat         = VP_convertXY2lnglat(VP_getXY(VP_iPosition));
-        vsOut.vertexPosition = VP_iPosition;
+        vsOut.tileCoords     = VP_getTileCoords(position);
+        vsOut.height         = VP_getVertexHeight(position);
+        vsOut.lngLat         = VP_convertXY2lnglat(VP_getXY(position));
+        vsOut.vertexPosition = position;
     }
 }
@@ -6,6 +6,16 @@
 // SPDX-License-Identifier: MIT
 
 layout(location = 0) in ivec2 VP_iPosition;
+layout(location = 1) in ivec2 VP_iMorphTarget;
+
+// Returns the vertex position of the current tile's grid after morphing it towards the next
+// coarser level. The result is given in pixels of the elevation tile, like VP_iPosition. Skirt
+// vertices always morph towards other skirt vertices, so they stay on the skirt.
+vec2 VP_getMorphedPosition()
+{
+    vec2 position = vec2(VP_iPosition);
+    return position + (vec2(VP_iMorphTarget) - position) * VP_morphFactor;
+}
 
 float VP_getJR(vec2 posXY)
 {
@@ -22,7 +32,7 @@ vec2 VP_getTileCoords(vec2 iPosition)
 
 //  Calculates the position (in [0,1]^2) relative to the base patch from
 //  integer vertex coordinates @a vtxPos (in [0,256]^2).
-vec2 VP_getXY(ivec2 iPosition)
+vec2 VP_getXY(vec2 iPosition)
 {
     // First convert vtxPos to a relative position ([0,1]^2) within the patch.
     // Then apply VP_offsetScale to obtain relative position within the
@@ -34,15 +44,16 @@ vec2 VP_getXY(ivec2 iPosition)
 // outer-most ring of vertices create the skirt around the tile and are therefore moved down. The
 // distance which they are moved, depends on the topography of the tile: Flat tiles have a smaller
 // skirt than mountainous tiles.
-float VP_getVertexHeight(ivec2 iPosition)
+float VP_getVertexHeight(vec2 iPosition)
 {
     // Make sure to sample at the pixel centers.
     float pixelSize = 1.0 / VP_getResolutionDEM();
     vec2 texcoords = VP_getTileCoords(iPosition) * (1.0 - pixelSize) + 0.5 * pixelSize;
     float height = texture(VP_texDEM, vec3(texcoords, VP_dataLayers.x)).x;
+    height = VP_heightRange.x + VP_heightRange.y * height;
 
     // Move skirt vertices down by half the maximum elevation difference inside the tile.
-    if (any(equal(iPosition, ivec2(0.0))) || any(equal(iPosition, ivec2(VP_getResolutionDEM() + 1)))) {
+    if (any(equal(iPosition, vec2(0.0))) || any(equal(iPosition, vec2(VP_getResolutionDEM() + 1)))) {
         height -= VP_heightInfo.y * 0.5;
     }
 
@@ -106,7 +117,7 @@ vec3 VP_toCartesian(vec2 lnglat, vec3 radii)
 // HEALPix projection. This works well if the celestial body is rather small or if the view is far
 // from the surface. If the viewer is close to the surface of a large body, precision issues will
 // arise.
-vec3 VP_getVertexPositionHEALPix(ivec2 iPosition)
+vec3 VP_getVertexPositionHEALPix(vec2 iPosition)
 {
     vec2  posXY  = VP_getXY(iPosition);
     vec2  lnglat = VP_convertXY2lnglat(posXY);
@@ -123,7 +134,7 @@ vec3 VP_getVertexPositionHEALPix(ivec2 iPosition)
 // interpolation of the CPU-based cartesian coordinates given in VP_corners. This results in a
 // piece-wise linear celestial body. However, if the observer is close to the surface of a large
 // body, the approximation error is very small and there are no precision issues.
-vec3 VP_getVertexPositionInterpolated(ivec2 iPosition)
+vec3 VP_getVertexPositionInterpolated(vec2 iPosition)
 {
     //   direction   index      alpha
     //  
@@ -165,7 +176,7 @@ vec3 VP_getVertexPositionInterpolated(ivec2 iPosition)
 // Given integer vertex coordinates @a vtxPos calculate the model space
 // position of the vertex taking into account the elevation data sampled from
 // VP_texDEM.
-vec3 VP_getVertexPosition(ivec2 iPosition, int mode)
+vec3 VP_getVertexPosition(vec2 iPosition, int mode)
 {
     if (mode == 0) {
         return VP_getVertexPositionHEALPix(iPosition);
@@ -185,22 +196,53 @@ vec3 VP_getVertexPosition(ivec2 iPosition, int mode)
 
 }
 
+// Calculates the model space normal for the vertex at the given position from the precomputed
+// gradients of the elevation data. The tangents of the surface below the terrain are derived from
+// the tile corners, so only one texture lookup is required. See TileTextureArray for how the
+// gradients are computed.
+vec3 VP_getVertexNormalPrecomputed(vec2 iPosition)
+{
+    float resolution = VP_getResolutionDEM();
+    vec2  alpha      = VP_getTileCoords(iPosition);
+
+    // Make sure to sample at the pixel centers, the same way as in VP_getVertexHeight().
+    float pixelSize = 1.0 / resolution;
+    vec2  texcoords = alpha * (1.0 - pixelSize) + 0.5 * pixelSize;
+    vec2  gradient  = texture(VP_texGradients, vec3(texcoords, VP_dataLayers.x)).xy;
+
+    // The height difference in the same units as the corner positions per pixel.
+    gradient *= length(VP_matModel[0]) * VP_heightScale * VP_heightRange.y;
+
+    vec3 normalSW = mix(VP_normals[2], VP_normals[1], alpha.y);
+    vec3 normalNE = mix(VP_normals[3], VP_normals[0], alpha.y);
+    vec3 normal   = normalize(mix(normalSW, normalNE, alpha.x));
+
+    // The tangents of the tile per pixel, averaged over the southern and the northern triangle.
+    vec3 dx = 0.5 * (VP_corners[3] - VP_corners[2] + VP_corners[0] - VP_corners[1]);
+    vec3 dy = 0.5 * (VP_corners[1] - VP_corners[2] + VP_corners[0] - VP_corners[3]);
+
+    dx = dx / (resolution - 1.0) + gradient.x * normal;
+    dy = dy / (resolution - 1.0) + gradient.y * normal;
+
+    return normalize(cross(dx, dy));
+}
+
 // Given integer vertex coordinates @a vtxPos calculate model space normal
 // for the vertex taking into account the elevation data sampled from
 // VP_texDEM.
-vec3 VP_getVertexNormal(ivec2 iPosition, int mode)
+vec3 VP_getVertexNormal(vec2 iPosition, int mode)
 {
-    int resolution = VP_getResolutionDEM();
+    float resolution = VP_getResolutionDEM();
 
     // Make sure to handle bottom skirt vertices the same as top skirt vertices.
-    iPosition = clamp(iPosition, ivec2(1), ivec2(resolution));
+    iPosition = clamp(iPosition, vec2(1.0), vec2(resolution));
 
     // Neighbour vertices (p: positive direction, n: negative direction). We clamp the positions to
     // the upper border of the tiles in order to not sample at the bottom of the skirt.
-    ivec2 pp = ivec2(min(iPosition.x + 1, resolution), iPosition.y);
-    ivec2 nn = ivec2(max(iPosition.x - 1, 1), iPosition.y);
-    ivec2 np = ivec2(iPosition.x, min(iPosition.y + 1, resolution));
-    ivec2 pn = ivec2(iPosition.x, max(iPosition.y - 1, 1));
+    vec2 pp = vec2(min(iPosition.x + 1.0, resolution), iPosition.y);
+    vec2 nn = vec2(max(iPosition.x - 1.0, 1.0), iPosition.y);
+    vec2 np = vec2(iPosition.x, min(iPosition.y + 1.0, resolution));
+    vec2 pn = vec2(iPosition.x, max(iPosition.y - 1.0, 1.0));
 
     // euclidian position of neighbour vertices
     vec3 p_pp = VP_getVertexPosition(pp, mode);
@@ -219,15 +261,18 @@ vec3 VP_getVertexNormal(ivec2 iPosition, int mode)
 // Given integer vertex coordinates @a vtxPos calculate model space normal
 // for the vertex taking into account the elevation data sampled from
 // VP_texDEM.
-vec3 VP_getVertexNormalLow(vec3 centerPos, ivec2 iPosition, int mode)
+vec3 VP_getVertexNormalLow(vec3 centerPos, vec2 iPosition, int mode)
 {
     // Make sure to handle bottom skirt vertices the same as top skirt vertices.
-    iPosition = clamp(iPosition, ivec2(1), ivec2(VP_getResolutionDEM()));
+    iPosition = clamp(iPosition, vec2(1.0), vec2(VP_getResolutionDEM()));
 
     // Sample neighbour vertices. If we are close to a border, we sample in the other direction
-    // instead. At iPosition.x == 0 is the bottom skirt vertex.
-    ivec2 px = ivec2(iPosition.x == 1 ? 2 : iPosition.x - 1, iPosition.y);
-    ivec2 py = ivec2(iPosition.x, iPosition.y == 1 ? 2 : iPosition.y - 1);
+    // instead. At iPosition.x == 0 is the bottom skirt vertex. Morphed positions are not
+    // necessarily integers, hence the neighbours are always one pixel away.
+    bool flipX = iPosition.x < 2.0;
+    bool flipY = iPosition.y < 2.0;
+    vec2 px = vec2(flipX ? iPosition.x + 1.0 : iPosition.x - 1.0, iPosition.y);
+    vec2 py = vec2(iPosition.x, flipY ? iPosition.y + 1.0 : iPosition.y - 1.0);
 
     // euclidian position of neighbour vertices
     vec3 p_px = VP_getVertexPosition(px, mode);
@@ -239,7 +284,7 @@ vec3 VP_getVertexNormalLow(vec3 centerPos, ivec2 iPosition, int mode)
 
     // If we sampled close to either of the sides, we flipped the lookup and hence have to flip the
     // normal as well.
-    if (iPosition.x == 1 ^^ iPosition.y == 1) {
+    if (flipX ^^ flipY) {
         dx = -dx;
     }
 
@@ -25,31 +25,70 @@ uniform vec3 VP_radii;
 uniform sampler2DArray VP_texDEM;
 uniform sampler2DArray VP_texIMG;
 
-// uniforms - current tile -----------------------------------------------------
+// The gradients of the values stored in VP_texDEM with respect to the pixel coordinates. They are
+// stored in the same layers as the elevation data.
+uniform sampler2DArray VP_texGradients;
 
-// The first component contains the average height value of the tile.
-// The second component contains the maximum height difference in the tile.
-uniform vec2 VP_heightInfo;
+// per-tile data --------------------------------------------------------------
 
-// offset (xy) and total number of patches (z) (relative to base patch)
-uniform ivec3 VP_offsetScale;
+// All tiles of a planet which use the same grid level are drawn with one instanced draw call. The
+// data of each tile is stored in this buffer and indexed by the instance ID, starting at
+// VP_firstTile. The layout has to match TileRenderer::TileData.
+struct VP_TileData {
+  // The first component contains the average height value of the tile.
+  // The second component contains the maximum height difference in the tile.
+  // The last two components contain the offset and the scale which have to be applied to the
+  // values sampled from VP_texDEM, as elevation data may be stored quantized.
+  vec4 heightInfo;
 
-// patch coordinate parameters f1, f2 (indirectly specifies base patch)
-uniform ivec2 VP_f1f2;
+  // offset (xy) and total number of patches (z) (relative to base patch)
+  ivec4 offsetScale;
 
-// Layers of VP_texDEM and VP_texIMG where the current patch's elevation (.x) and image
-// data (.y) are stored.
-uniform ivec2 VP_dataLayers;
+  // patch coordinate parameters f1, f2 (xy) (indirectly specifies base patch) and the layers of
+  // VP_texDEM and VP_texIMG where the patch's elevation (z) and image data (w) are stored
+  ivec4 f1f2DataLayers;
 
-uniform vec3 VP_corners[4];
-uniform vec3 VP_normals[4];
+  vec3 corners[4];
+  vec3 normals[4];
+
+  // The factor by which the grid is morphed towards the next coarser level (x) and the cascade
+  // this tile is drawn into in a layered shadow map pass (y).
+  vec4 gridMorph;
+};
+
+layout(std430, binding = 0) readonly buffer VP_TileBuffer {
+  VP_TileData VP_tiles[];
+};
+
+// The vertex shader has to write the tile index to VP_tileIndex so that the fragment shader can
+// access the data of the current tile as well.
+#ifdef VP_VERTEX_SHADER
+uniform int VP_firstTile;
+flat out int VP_tileIndex;
+#define VP_currentTile VP_tiles[VP_firstTile + gl_InstanceID]
+#else
+flat in int VP_tileIndex;
+#define VP_currentTile VP_tiles[VP_tileIndex]
+#endif
+
+// These can be used like uniforms.
+#define VP_heightInfo  (VP_currentTile.heightInfo.xy)
+#define VP_heightRange (VP_currentTile.heightInfo.zw)
+#define VP_offsetScale (VP_currentTile.offsetScale.xyz)
+#define VP_f1f2        (VP_currentTile.f1f2DataLayers.xy)
+#define VP_dataLayers  (VP_currentTile.f1f2DataLayers.zw)
+#define VP_corners     (VP_currentTile.corners)
+#define VP_normals     (VP_currentTile.normals)
+#define VP_morphFactor (VP_currentTile.gridMorph.x)
+#define VP_shadowLayer (int(VP_currentTile.gridMorph.y))
 
 // uniforms - shadow stuff -----------------------------------------------------
-uniform bool            VP_shadowMapMode;
-uniform sampler2DShadow VP_shadowMaps[5];
-uniform mat4            VP_shadowProjectionViewMatrices[5];
-uniform float           VP_shadowBias = 0.0001;
-uniform int             VP_shadowCascades;
+uniform bool                 VP_shadowMapMode;
+uniform bool                 VP_shadowMapLayered;
+uniform sampler2DArrayShadow VP_shadowMaps;
+uniform mat4                 VP_shadowProjectionViewMatrices[5];
+uniform float                VP_shadowBias = 0.0001;
+uniform int                  VP_shadowCascades;
 
 // Returns the resolution of the square-shaped image tiles.
 int VP_getResolutionIMG() {
@@ -7,13 +7,16 @@
 
 #include "BaseTileData.hpp"
 
+#include "../../../src/cs-utils/TrackedMemoryResource.hpp"
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* explicit */
 BaseTileData::BaseTileData(uint32_t resolution)
-    : mResolution(resolution) {
+    : mResolution(resolution)
+    , mCompressedData(getMemoryResource()) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -36,4 +39,23 @@ uint32_t BaseTileData::getResolution() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::pmr::vector<uint8_t> const& BaseTileData::getCompressedData() const {
+  return mCompressedData;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::pmr::vector<uint8_t>& BaseTileData::getCompressedData() {
+  return mCompressedData;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::pmr::memory_resource* BaseTileData::getMemoryResource() {
+  static auto* resource = &cs::utils::TrackedMemoryResource::get("LOD Tiles");
+  return resource;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::lodbodies
@@ -14,7 +14,9 @@
 #include "TileId.hpp"
 
 #include <memory>
+#include <memory_resource>
 #include <typeinfo>
+#include <vector>
 
 namespace csp::lodbodies {
 
@@ -55,12 +57,23 @@ class BaseTileData {
   int  getTexLayer() const;
   void setTexLayer(int layer);
 
+  /// Color tiles may be compressed on the loader threads already, see TileSource::
+  /// setCompressColorTiles(). In this case, this contains the BC1 blocks which are uploaded to
+  /// the GPU instead of the pixel data. Else it is empty.
+  std::pmr::vector<uint8_t> const& getCompressedData() const;
+  std::pmr::vector<uint8_t>&       getCompressedData();
+
+  /// All data of the tiles is allocated from this resource. It tracks the memory used by the tiles
+  /// as the "LOD Tiles" subsystem of cs::utils::TrackedMemoryResource.
+  static std::pmr::memory_resource* getMemoryResource();
+
  protected:
   explicit BaseTileData(uint32_t resolution);
 
  private:
-  uint32_t mResolution;
-  int      mTexLayer{-1};
+  uint32_t                  mResolution;
+  int                       mTexLayer{-1};
+  std::pmr::vector<uint8_t> mCompressedData;
 };
 
 template <typename T>
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "DepthPicker.hpp"
+
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// A point which has been read is only used for rays which pass it in at most this distance,
+// relative to its distance from the ray origin. This is about a quarter of a degree.
+double const RAY_TOLERANCE = 0.005;
+
+// A point is only considered to be on the surface of a body if its distance to the center,
+// relative to the radii, differs by at most this much from one.
+double const SURFACE_TOLERANCE = 0.1;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DepthPicker::DepthPicker() {
+  glGenBuffers(1, &mBuffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, mBuffer);
+  glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(float), nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DepthPicker::~DepthPicker() {
+  if (mFence) {
+    glDeleteSync(mFence);
+  }
+
+  glDeleteBuffers(1, &mBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DepthPicker::setRay(glm::dvec3 const& rayPos, glm::dvec3 const& rayDir) {
+  mRayPos = rayPos;
+  mRayDir = glm::normalize(rayDir);
+  mHasRay = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DepthPicker::read(glm::dmat4 const& transform) {
+
+  // First check whether the previous readback has finished. The fence is polled without waiting.
+  if (mFence) {
+    auto status = glClientWaitSync(mFence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      return;
+    }
+
+    glDeleteSync(mFence);
+    mFence = nullptr;
+
+    float depth = 0.F;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mBuffer);
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(float), &depth);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // As we are using a reverse infinite projection, a depth of zero means that nothing has been
+    // drawn at this pixel.
+    if (depth <= 0.F) {
+      mPoint = std::nullopt;
+    } else {
+      glm::dvec4 ndc((mPixel.x - mViewport.at(0) + 0.5) / mViewport.at(2) * 2.0 - 1.0,
+          (mPixel.y - mViewport.at(1) + 0.5) / mViewport.at(3) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+
+      glm::dvec4 world = mInverseViewProjection * ndc;
+      mPoint           = glm::dvec3(mInverseTransform * (world / world.w));
+    }
+  }
+
+  if (!mHasRay) {
+    return;
+  }
+
+  // Multisampled framebuffers cannot be read with glReadPixels().
+  GLint sampleBuffers = 0;
+  glGetIntegerv(GL_SAMPLE_BUFFERS, &sampleBuffers);
+  if (sampleBuffers > 0) {
+    return;
+  }
+
+  std::array<GLfloat, 16> glMat{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMat.data());
+  glm::dmat4 view(glm::make_mat4x4(glMat.data()));
+  glGetFloatv(GL_PROJECTION_MATRIX, glMat.data());
+  glm::dmat4 projection(glm::make_mat4x4(glMat.data()));
+
+  // The pixel hit by the ray is found by projecting its direction. This is only correct if the ray
+  // starts at the eye. For other rays, the point will not lie on the ray and getIntersection() will
+  // reject it.
+  glm::dvec4 clip = projection * view * glm::dvec4(mRayDir, 0.0);
+  if (clip.w <= 0.0) {
+    return;
+  }
+
+  glGetIntegerv(GL_VIEWPORT, mViewport.data());
+
+  glm::dvec2 ndc(clip.x / clip.w, clip.y / clip.w);
+  if (glm::any(glm::greaterThan(glm::abs(ndc), glm::dvec2(1.0)))) {
+    return;
+  }
+
+  mPixel = glm::ivec2(mViewport.at(0) + (ndc.x * 0.5 + 0.5) * mViewport.at(2),
+      mViewport.at(1) + (ndc.y * 0.5 + 0.5) * mViewport.at(3));
+  mPixel = glm::min(mPixel, glm::ivec2(mViewport.at(0) + mViewport.at(2) - 1,
+                                mViewport.at(1) + mViewport.at(3) - 1));
+
+  mInverseViewProjection = glm::inverse(projection * view);
+  mInverseTransform      = glm::inverse(transform);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, mBuffer);
+  glReadPixels(mPixel.x, mPixel.y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DepthPicker::getIntersection(glm::dvec3 const& rayPos, glm::dvec3 const& rayDir,
+    glm::dmat4 const& transform, glm::dvec3 const& radii, glm::dvec3& pos) const {
+
+  if (!mPoint) {
+    return false;
+  }
+
+  // The point may belong to another body which has been drawn before.
+  double radius = glm::length(*mPoint / radii);
+  if (std::abs(radius - 1.0) > SURFACE_TOLERANCE) {
+    return false;
+  }
+
+  glm::dvec3 dir   = glm::normalize(rayDir);
+  glm::dvec3 point = glm::dvec3(transform * glm::dvec4(*mPoint, 1.0));
+  double     t     = glm::dot(point - rayPos, dir);
+
+  if (t <= 0.0 || glm::length(point - (rayPos + t * dir)) > t * RAY_TOLERANCE) {
+    return false;
+  }
+
+  pos = glm::dvec3(glm::inverse(transform) * glm::dvec4(rayPos + t * dir, 1.0));
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_DEPTH_PICKER_HPP
+#define CSP_LOD_BODIES_DEPTH_PICKER_HPP
+
+#include <GL/glew.h>
+#include <array>
+#include <glm/glm.hpp>
+#include <optional>
+
+namespace csp::lodbodies {
+
+/// The DepthPicker computes the intersection of a body with a pointer ray from the depth buffer
+/// instead of intersecting the tiles on the CPU. The depth of the pixel which is hit by the ray is
+/// read asynchronously into a pixel buffer object and unprojected once the GPU has finished, which
+/// usually is one frame later. This only works for rays which start at the eye, such as the mouse
+/// ray in desktop mode. For all other rays, getIntersection() returns false and the caller should
+/// fall back to ray casting on the CPU.
+class DepthPicker {
+ public:
+  DepthPicker();
+
+  DepthPicker(DepthPicker const& other) = delete;
+  DepthPicker(DepthPicker&& other)      = delete;
+
+  DepthPicker& operator=(DepthPicker const& other) = delete;
+  DepthPicker& operator=(DepthPicker&& other)      = delete;
+
+  ~DepthPicker();
+
+  /// Sets the ray in world space for which the depth will be read during the next call to read().
+  void setRay(glm::dvec3 const& rayPos, glm::dvec3 const& rayDir);
+
+  /// This has to be called right after the body has been drawn, as it uses the current modelview
+  /// and projection matrices. The given transformation maps from the coordinate system of the body
+  /// to world space. If the previous readback has finished, its result is unprojected. Then the
+  /// depth of the pixel hit by the current ray is read. This never waits for the GPU.
+  void read(glm::dmat4 const& transform);
+
+  /// Returns true if the last point which has been read lies close to the given ray and on the
+  /// surface of the body. The given transformation and radii are the current ones of the body. The
+  /// point is projected onto the ray and returned in the coordinate system of the body.
+  bool getIntersection(glm::dvec3 const& rayPos, glm::dvec3 const& rayDir,
+      glm::dmat4 const& transform, glm::dvec3 const& radii, glm::dvec3& pos) const;
+
+ private:
+  uint32_t mBuffer = 0;
+  GLsync   mFence  = nullptr;
+
+  glm::dvec3 mRayPos{};
+  glm::dvec3 mRayDir{};
+  bool       mHasRay = false;
+
+  // The state at the time the current readback was started. This is required for unprojecting
+  // the depth value.
+  glm::dmat4           mInverseViewProjection{};
+  glm::dmat4           mInverseTransform{};
+  std::array<GLint, 4> mViewport{};
+  glm::ivec2           mPixel{};
+
+  // The last point which has been read, in the coordinate system of the body.
+  std::optional<glm::dvec3> mPoint;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_DEPTH_PICKER_HPP
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "HEALPixCache.hpp"
+
+#include "../../../src/cs-utils/convert.hpp"
+#include "HEALPix.hpp"
+
+#include <algorithm>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HEALPixCache::SurfacePoint getSurfacePoint(glm::dvec2 const& lngLat, glm::dvec3 const& radii) {
+  return {cs::utils::convert::toCartesian(lngLat, radii),
+      cs::utils::convert::lngLatToNormal(lngLat)};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<HEALPixCache> HEALPixCache::get(glm::dvec3 const& radii) {
+  static std::vector<std::weak_ptr<HEALPixCache>> caches;
+
+  // Remove the caches which are not used anymore.
+  caches.erase(std::remove_if(caches.begin(), caches.end(),
+                   [](std::weak_ptr<HEALPixCache> const& c) { return c.expired(); }),
+      caches.end());
+
+  for (auto const& c : caches) {
+    auto cache = c.lock();
+    if (cache->getRadii() == radii) {
+      return cache;
+    }
+  }
+
+  auto cache = std::make_shared<HEALPixCache>(radii);
+  caches.push_back(cache);
+
+  return cache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HEALPixCache::HEALPixCache(glm::dvec3 const& radii)
+    : mRadii(radii)
+    , mPrecomputedPatches(sPrecomputedLevels) {
+
+  for (int level = 0; level < sPrecomputedLevels; ++level) {
+    auto& patches = mPrecomputedPatches[level];
+    auto  count   = HEALPix::getLevel(level).getTotalPatchCount();
+
+    patches.reserve(count);
+
+    for (glm::int64 patchIdx = 0; patchIdx < count; ++patchIdx) {
+      patches.push_back(computePatch(TileId(level, patchIdx), mRadii));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 const& HEALPixCache::getRadii() const {
+  return mRadii;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HEALPixCache::Patch const& HEALPixCache::getPatch(TileId const& tileId) {
+  if (tileId.level() < sPrecomputedLevels) {
+    return mPrecomputedPatches[tileId.level()][tileId.patchIdx()];
+  }
+
+  auto& patches = mLazyPatches.at(HEALPix::getRootIdx(tileId));
+
+  auto it = patches.find(tileId);
+  if (it != patches.end()) {
+    return it->second;
+  }
+
+  // The visible tiles will be added again during the next frames.
+  if (patches.size() >= sMaxLazyPatches) {
+    patches.clear();
+  }
+
+  return patches.emplace(tileId, computePatch(tileId, mRadii)).first->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HEALPixCache::Patch HEALPixCache::computePatch(TileId const& tileId, glm::dvec3 const& radii) {
+  Patch patch;
+  patch.mNeighbours = HEALPix::getNeighbourIds(tileId);
+  patch.mCenter     = getSurfacePoint(HEALPix::getCenterLngLat(tileId), radii);
+
+  auto corners = HEALPix::getCornersLngLat(tileId);
+  auto edges   = HEALPix::getEdgeCentersLngLat(tileId);
+
+  for (std::size_t i = 0; i < 4; ++i) {
+    patch.mCorners.at(i)     = getSurfacePoint(corners.at(i), radii);
+    patch.mEdgeCenters.at(i) = getSurfacePoint(edges.at(i), radii);
+  }
+
+  return patch;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_HEALPIXCACHE_HPP
+#define CSP_LOD_BODIES_HEALPIXCACHE_HPP
+
+#include "../../../src/cs-utils/FlatHashMap.hpp"
+#include "TileId.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// Caches the neighbours and the surface geometry of HEALPix patches for an ellipsoid with given
+/// radii. Computing these involves several trigonometric functions and has to be done for each
+/// visible tile whenever its bounds are computed and whenever it is drawn.
+///
+/// The patches of the first sPrecomputedLevels levels are computed when the cache is created. The
+/// patches of deeper levels are computed when they are first accessed. As there are far too many
+/// of them to keep them all, the lazily computed patches of a root patch are discarded once there
+/// are more than sMaxLazyPatches of them.
+///
+/// Use get() to obtain a cache, all bodies with the same radii share the same instance. get() must
+/// only be called on the main thread. getPatch() may be called concurrently for tiles of different
+/// root patches, as the LODVisitor does.
+class HEALPixCache {
+ public:
+  /// A point on the surface of the ellipsoid together with the geodetic surface normal at this
+  /// point. The cartesian position at a given height is mPosition + height * mNormal.
+  struct SurfacePoint {
+    glm::dvec3 mPosition;
+    glm::dvec3 mNormal;
+  };
+
+  struct Patch {
+    /// The neighbours in the order NE, NW, SW, SE.
+    std::array<TileId, 4> mNeighbours;
+
+    SurfacePoint mCenter;
+
+    /// The corners in the order N, W, S, E.
+    std::array<SurfacePoint, 4> mCorners;
+
+    /// The center points of the edges in the order NE, NW, SW, SE.
+    std::array<SurfacePoint, 4> mEdgeCenters;
+  };
+
+  static int const         sPrecomputedLevels = 5;
+  static std::size_t const sMaxLazyPatches    = 2048;
+
+  /// Returns the cache for the given radii. It is created if no body with these radii holds a
+  /// reference to it anymore.
+  static std::shared_ptr<HEALPixCache> get(glm::dvec3 const& radii);
+
+  explicit HEALPixCache(glm::dvec3 const& radii);
+
+  HEALPixCache(HEALPixCache const& other) = delete;
+  HEALPixCache(HEALPixCache&& other)      = delete;
+
+  HEALPixCache& operator=(HEALPixCache const& other) = delete;
+  HEALPixCache& operator=(HEALPixCache&& other)      = delete;
+
+  ~HEALPixCache() = default;
+
+  glm::dvec3 const& getRadii() const;
+
+  /// Returns the cached patch for tileId. The reference stays valid until the next call to this
+  /// method for a tile of the same root patch.
+  Patch const& getPatch(TileId const& tileId);
+
+  /// Computes the patch for tileId on an ellipsoid with the given radii without using any cache.
+  /// This may be called from any thread.
+  static Patch computePatch(TileId const& tileId, glm::dvec3 const& radii);
+
+ private:
+
+  glm::dvec3 mRadii;
+
+  /// The patches of the first levels, indexed by level and patch index.
+  std::vector<std::vector<Patch>> mPrecomputedPatches;
+
+  /// The patches of deeper levels, one map for each root patch.
+  std::array<cs::utils::FlatHashMap<TileId, Patch>, 12> mLazyPatches;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_HEALPIXCACHE_HPP
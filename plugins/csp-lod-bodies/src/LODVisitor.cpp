@@ -14,13 +14,34 @@
 #include "TreeManager.hpp"
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "../../../src/cs-utils/Tracing.hpp"
+
 #include <VistaBase/VistaStreamUtils.h>
+#include <algorithm>
 #include <glm/gtc/matrix_inverse.hpp>
 
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// All LODVisitors share one pool, the traversal of one body only takes a fraction of a frame.
+cs::utils::ThreadPool& getThreadPool() {
+  static cs::utils::ThreadPool pool(
+      std::max(1U, std::thread::hardware_concurrency()), "LoD Visitor");
+  return pool;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 /* explicit */
 LODVisitor::LODVisitor(PlanetParameters const& params, TreeManager* treeMgr)
     : TileVisitor(treeMgr->getTree())
@@ -36,7 +57,91 @@ LODVisitor::LODVisitor(PlanetParameters const& params, TreeManager* treeMgr)
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::queueRecomputeTileBounds() {
-  mRecomputeTileBounds = true;
+  ++mBoundsRevision;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t LODVisitor::getBoundsRevision() const {
+  return mBoundsRevision;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::setTimeBudget(std::shared_ptr<TimeBudget> budget) {
+  mTimeBudget = std::move(budget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TimeBudget> const& LODVisitor::getTimeBudget() const {
+  return mTimeBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::visit() {
+  CS_TRACE_ZONE("LODVisitor::visit");
+
+  if (preTraverse()) {
+
+    // The previous results are only valid if the traversal would make the same decisions.
+    bool cameraChanged = mUpdateLOD && (mMatVM != mLastMatVM || mMatP != mLastMatP);
+    bool paramsChanged = mParams->mLodFactor != mLastLodFactor ||
+                         mParams->mMinLevel != mLastMinLevel ||
+                         mParams->mMaxLevel != mLastMaxLevel;
+    bool reuseResults  = !cameraChanged && !paramsChanged;
+
+    mLastMatVM     = mMatVM;
+    mLastMatP      = mMatP;
+    mLastLodFactor = mParams->mLodFactor;
+    mLastMinLevel  = mParams->mMinLevel;
+    mLastMaxLevel  = mParams->mMaxLevel;
+
+    // Outdated bounds are only recomputed within the time budget.
+    bool updateBounds = std::any_of(mRootResults.begin(), mRootResults.end(),
+        [this](RootResult const& r) { return r.mBoundsRevision != mBoundsRevision; });
+
+    auto start      = TimeBudget::Clock::now();
+    mBoundsDeadline = TimeBudget::Clock::time_point::max();
+
+    if (mTimeBudget) {
+      mBoundsDeadline = mTimeBudget->getDeadline();
+    }
+
+    // Each root tree only touches its own nodes, so they can be traversed independently.
+    std::vector<std::future<void>> results;
+    results.reserve(TileQuadTree::sNumRoots);
+
+    for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+      results.emplace_back(getThreadPool().enqueue(cs::utils::ThreadPool::Priority::eHigh,
+          [this, i, reuseResults]() { visitRoot(i, reuseResults); }));
+    }
+
+    // Wait for all tasks before retrieving any result, get() may throw an exception.
+    for (auto& result : results) {
+      result.wait();
+    }
+
+    for (auto& result : results) {
+      result.get();
+    }
+
+    if (updateBounds && mTimeBudget) {
+      mTimeBudget->consume(start);
+    }
+
+    for (auto const& result : mRootResults) {
+      mLoadNodes.insert(mLoadNodes.end(), result.mLoadNodes.begin(), result.mLoadNodes.end());
+      mRenderNodes.insert(
+          mRenderNodes.end(), result.mRenderNodes.begin(), result.mRenderNodes.end());
+    }
+  }
+
+  CS_TRACE_PLOT("LoD Load Nodes", static_cast<int64_t>(mLoadNodes.size()));
+  CS_TRACE_PLOT("LoD Render Nodes", static_cast<int64_t>(mRenderNodes.size()));
+
+  postTraverse();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -70,42 +175,83 @@ bool LODVisitor::preTraverse() {
     minHeight  = std::min(minHeight, tile->getMinMaxPyramid()->getMin());
   }
 
-  mHorizonCullRadius = std::min(mParams->mRadii.x, std::min(mParams->mRadii.y, mParams->mRadii.z)) +
-                       (minHeight * mParams->mHeightScale);
+  // The cache has to be replaced if the radii of the planet changed.
+  if (!mHEALPixCache || mHEALPixCache->getRadii() != mParams->mRadii) {
+    mHEALPixCache = HEALPixCache::get(mParams->mRadii);
+  }
+
+  // The occluding ellipsoid lies below all terrain, so that no visible tiles are culled.
+  mHorizonCullRadii  = glm::max(mParams->mRadii + minHeight * mParams->mHeightScale, 1.0);
+  mHorizonCullCamPos = mCameraData.mCamPos / mHorizonCullRadii;
 
   return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void LODVisitor::postTraverse() {
-  mRecomputeTileBounds = false;
-}
+void LODVisitor::visitRoot(int rootIdx, bool reuseResults) {
+  CS_TRACE_ZONE("LODVisitor::visitRoot");
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  RootResult& result   = mRootResults.at(rootIdx);
+  uint64_t    revision = mTree->getRevision(rootIdx);
+
+  // If nothing changed, the nodes only have to be marked as used again.
+  if (reuseResults && result.mValid && result.mRevision == revision &&
+      result.mBoundsRevision == mBoundsRevision) {
+    for (auto* node : result.mVisitedNodes) {
+      node->setLastFrame(mFrameCount);
+    }
 
-bool LODVisitor::preVisitRoot(TileNode* root) {
-  return visitNode(root);
+    return;
+  }
+
+  result.mLoadNodes.clear();
+  result.mRenderNodes.clear();
+  result.mVisitedNodes.clear();
+  result.mOutdatedBounds = false;
+
+  visitSubtree(mTree->getRoot(rootIdx), result);
+
+  result.mRevision = revision;
+  result.mValid    = true;
+
+  if (!result.mOutdatedBounds) {
+    result.mBoundsRevision = mBoundsRevision;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool LODVisitor::preVisit(TileNode* node) {
-  return visitNode(node);
+void LODVisitor::visitSubtree(TileNode* node, RootResult& result) {
+  if (visitNode(node, result)) {
+    for (int i = 0; i < 4; ++i) {
+      TileNode* child = node->getChild(i);
+
+      if (child) {
+        visitSubtree(child, result);
+      }
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool LODVisitor::visitNode(TileNode* node) {
-
-  // Recompute tile bounds if required.
-  if (!node->hasBounds() || mRecomputeTileBounds) {
-    auto bounds = calcTileBounds(*node, mParams->mRadii, mParams->mHeightScale);
-    node->setBounds(bounds);
+bool LODVisitor::visitNode(TileNode* node, RootResult& result) {
+
+  // Recompute tile bounds if required. Missing bounds are always computed, outdated bounds only
+  // until the time budget is exhausted. These nodes are culled with their old bounds until one of
+  // the next traversals updates them.
+  if (!node->hasBounds() || (node->getBoundsRevision() != mBoundsRevision &&
+                                TimeBudget::Clock::now() < mBoundsDeadline)) {
+    auto bounds = calcTileBounds(*node, *mHEALPixCache, mParams->mHeightScale);
+    node->setBounds(bounds, mBoundsRevision);
+  } else if (node->getBoundsRevision() != mBoundsRevision) {
+    result.mOutdatedBounds = true;
   }
 
   // Mark this node as used to prevent it from being removed.
   node->setLastFrame(mFrameCount);
+  result.mVisitedNodes.push_back(node);
 
   // Node is not visible, do not traverse further.
   if (!testInFrustum(node) || !testFrontFacing(node)) {
@@ -113,9 +259,9 @@ bool LODVisitor::visitNode(TileNode* node) {
   }
 
   // If no refinement is required, we can directly render the node and stop the traversal.
-  bool needRefine = node->getLevel() < mParams->mMaxLevel && testNeedRefine(node);
+  bool needRefine = testNeedRefine(node) && node->getLevel() < mParams->mMaxLevel;
   if (!needRefine) {
-    mRenderNodes.push_back(node);
+    result.mRenderNodes.push_back(node);
     return false;
   }
 
@@ -129,16 +275,17 @@ bool LODVisitor::visitNode(TileNode* node) {
 
   for (int i = 0; i < 4; ++i) {
     if (!node->getChild(i)) {
-      mLoadNodes.push_back(HEALPix::getChildTileId(tileId, i));
+      result.mLoadNodes.push_back(HEALPix::getChildTileId(tileId, i));
     } else {
       // Mark this child as used to avoid it being removed while waiting for its siblings to be
       // loaded.
       node->getChild(i)->setLastFrame(mFrameCount);
+      result.mVisitedNodes.push_back(node->getChild(i));
     }
   }
 
   // Finally draw this node until all children are loaded and stop the traversal.
-  mRenderNodes.push_back(node);
+  result.mRenderNodes.push_back(node);
 
   return false;
 }
@@ -147,10 +294,6 @@ bool LODVisitor::visitNode(TileNode* node) {
 
 bool LODVisitor::testNeedRefine(TileNode* node) const {
 
-  if (mParams->mMinLevel > node->getLevel()) {
-    return true;
-  }
-
   glm::dvec3 const& tbMin    = node->getBounds().getMin();
   glm::dvec3 const& tbMax    = node->getBounds().getMax();
   glm::dvec3        tbCenter = 0.5 * (tbMin + tbMax);
@@ -186,8 +329,11 @@ bool LODVisitor::testNeedRefine(TileNode* node) const {
 
   double ratio = maxAngle / fov * mParams->mLodFactor;
 
-  // The magic number is chosen to bring the configured LoD factor into a sensible range.
-  return ratio > 10.0;
+  if (mStoreScreenSpaceError) {
+    node->setScreenSpaceError(static_cast<float>(ratio));
+  }
+
+  return ratio > sRefineThreshold || mParams->mMinLevel > node->getLevel();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -222,6 +368,18 @@ bool LODVisitor::getUpdateLOD() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LODVisitor::setStoreScreenSpaceError(bool enable) {
+  mStoreScreenSpaceError = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LODVisitor::getStoreScreenSpaceError() const {
+  return mStoreScreenSpaceError;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::vector<TileId> const& LODVisitor::getLoadNodes() const {
   return mLoadNodes;
 }
@@ -277,6 +435,12 @@ bool LODVisitor::testInFrustum(TileNode* node) const {
 
 bool LODVisitor::testFrontFacing(TileNode* node) const {
 
+  // If the camera is inside the occluding ellipsoid (e.g. in a deep crater), nothing is culled.
+  double vhMagnitudeSquared = glm::dot(mHorizonCullCamPos, mHorizonCullCamPos) - 1.0;
+  if (vhMagnitudeSquared <= 0.0) {
+    return true;
+  }
+
   glm::dvec3 const& tbMin = node->getBounds().getMin();
   glm::dvec3 const& tbMax = node->getBounds().getMax();
 
@@ -288,30 +452,18 @@ bool LODVisitor::testFrontFacing(TileNode* node) const {
           glm::dvec3(tbMin.x, tbMax.y, tbMin.z), glm::dvec3(tbMax.x, tbMax.y, tbMin.z),
           glm::dvec3(tbMax.x, tbMax.y, tbMax.z), glm::dvec3(tbMin.x, tbMax.y, tbMax.z)}};
 
-  // Simple ray-sphere intersection test for every corner point.
+  // The set of points which are hidden by the ellipsoid is convex. Hence the bounding box is
+  // hidden if all of its corners are. In the space where the ellipsoid is a unit sphere, a point is
+  // hidden if it lies beyond the plane through the horizon circle and inside the cone tangent to
+  // the sphere. See https://cesium.com/blog/2013/04/25/horizon-culling/.
   for (auto const& tbPoint : tbPoints) {
-    double     dRayLength = glm::length(tbPoint - mCameraData.mCamPos);
-    glm::dvec3 vRayDir    = (tbPoint - mCameraData.mCamPos) / dRayLength;
-    double     b          = glm::dot(mCameraData.mCamPos, vRayDir);
-    double     c          = glm::dot(mCameraData.mCamPos, mCameraData.mCamPos) -
-               mHorizonCullRadius * mHorizonCullRadius;
-    double fDet = b * b - c;
-
-    // No intersection between corner and camera position: Tile visible!
-    if (fDet < 0.0) {
-      return true;
-    }
-
-    fDet = std::sqrt(fDet);
+    glm::dvec3 vt      = tbPoint / mHorizonCullRadii - mHorizonCullCamPos;
+    double     vtDotVc = -glm::dot(vt, mHorizonCullCamPos);
 
-    // Both intersection points are behind the camera but tile is in front (presumes tiles to be
-    // frustum culled already!!!). E.g. While travelling in a deep crater and looking above.
-    if ((-b - fDet) < 0.0 && (-b + fDet) < 0.0) {
-      return true;
-    }
+    bool occluded = vtDotVc > vhMagnitudeSquared &&
+                    vtDotVc * vtDotVc / glm::dot(vt, vt) > vhMagnitudeSquared;
 
-    // Tile in front of planet.
-    if (dRayLength < -b - fDet) {
+    if (!occluded) {
       return true;
     }
   }
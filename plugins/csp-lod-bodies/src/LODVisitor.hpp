@@ -9,9 +9,14 @@
 #define CSP_LOD_BODIES_LODVISITOR_HPP
 
 #include "Frustum.hpp"
+#include "HEALPixCache.hpp"
 #include "TileId.hpp"
+#include "TileQuadTree.hpp"
 #include "TileVisitor.hpp"
+#include "TimeBudget.hpp"
 
+#include <array>
+#include <memory>
 #include <vector>
 
 namespace csp::lodbodies {
@@ -21,13 +26,37 @@ class TreeManager;
 
 /// Specialization of TileVisitor that determines the necessary level of detail for tiles and
 /// produces lists of tiles to load and draw respectively.
+///
+/// The twelve root trees are traversed in parallel on a thread pool shared by all LODVisitors.
+/// Each root tree produces its own load and render lists which are concatenated in root order
+/// afterwards, so the result is the same as for a serial traversal. If neither the camera nor the
+/// LOD parameters changed since the previous traversal, the results of all root trees whose
+/// structure did not change either are reused.
+///
+/// If tile bounds have to be recomputed, only as many bounds as fit into the remaining TimeBudget
+/// of the frame are updated. The other nodes keep their previous bounds until one of the next
+/// traversals gets to them.
 class LODVisitor : public TileVisitor {
  public:
+  /// Nodes are refined if their screen-space error is larger than this. The value is chosen to
+  /// bring the configured LoD factor into a sensible range.
+  static constexpr double sRefineThreshold = 10.0;
+
   LODVisitor(PlanetParameters const& params, TreeManager* treeMgr);
 
-  /// If called, node bounds will be recomputed during the next traversal. This should be called
-  /// whenever the body radius or the elevation scale has been changed.
-  void queueRecomputeTileBounds();
+  /// Traverses all root trees in parallel, see the class description.
+  void visit() override;
+
+  /// If called, node bounds will be recomputed during the next traversals. This should be called
+  /// whenever the body radius or the elevation scale has been changed. All LODVisitors of a
+  /// TreeManager have to be notified, as they share the bounds stored in the nodes.
+  void     queueRecomputeTileBounds();
+  uint64_t getBoundsRevision() const;
+
+  /// The time spent on recomputing tile bounds is subtracted from this budget. If no budget is
+  /// set, all bounds are recomputed in the next traversal.
+  void                               setTimeBudget(std::shared_ptr<TimeBudget> budget);
+  std::shared_ptr<TimeBudget> const& getTimeBudget() const;
 
   /// Used to compute the age of unused tiles.
   void setFrameCount(int frameCount);
@@ -44,6 +73,13 @@ class LODVisitor : public TileVisitor {
   void setUpdateLOD(bool enable);
   bool getUpdateLOD() const;
 
+  /// Controls whether the screen-space error of the visited nodes is stored in the nodes, see
+  /// TileNode::getScreenSpaceError(). This is enabled by default. It has to be disabled for all
+  /// visitors which do not select the rendered nodes, such as the one which prefetches tiles for a
+  /// predicted camera, as the TileRenderer and the TreeManager use the stored value.
+  void setStoreScreenSpaceError(bool enable);
+  bool getStoreScreenSpaceError() const;
+
   /// Returns the nodes that should be loaded. The parent tiles of these have been
   /// determined to not provide sufficient resolution.
   std::vector<TileId> const& getLoadNodes() const;
@@ -60,18 +96,36 @@ class LODVisitor : public TileVisitor {
     glm::dvec3     mCamPos;
   };
 
+  /// The traversal result of one root tree. mVisitedNodes contains all nodes which have been
+  /// marked as used, this is required to mark them again if the result is reused. mBoundsRevision
+  /// is only updated once the bounds of all visited nodes are up-to-date.
+  struct RootResult {
+    std::vector<TileId>    mLoadNodes;
+    std::vector<TileNode*> mRenderNodes;
+    std::vector<TileNode*> mVisitedNodes;
+    uint64_t               mRevision       = 0;
+    uint64_t               mBoundsRevision = 0;
+    bool                   mOutdatedBounds = false;
+    bool                   mValid          = false;
+  };
+
   bool preTraverse() override;
-  void postTraverse() override;
 
-  bool preVisitRoot(TileNode* root) override;
-  bool preVisit(TileNode* node) override;
+  /// Traverses the tree with the given index or reuses the previous result if possible.
+  void visitRoot(int rootIdx, bool reuseResults);
+
+  /// Recursively visits the given node and its children.
+  void visitSubtree(TileNode* node, RootResult& result);
 
   /// Visit the given node. Returns whether children should be visited.
-  bool visitNode(TileNode* node);
+  bool visitNode(TileNode* node, RootResult& result);
 
   /// Returns whether the currently visited node should be refined, i.e. if it's children should be
   /// used to achieve desired resolution. Estimates the screen space size (in pixels) of the node
-  /// and compares that with the desired LOD factor.
+  /// and compares that with the desired LOD factor. Unless disabled with
+  /// setStoreScreenSpaceError(), the estimate is stored in the node, see
+  /// TileNode::getScreenSpaceError(). This is required for all rendered nodes, as the TileRenderer
+  /// chooses the grid resolution based on it.
   bool testNeedRefine(TileNode* node) const;
 
   // Returns if the tile bounds intersect the current frustum. For each plane of the frustum
@@ -83,24 +137,43 @@ class LODVisitor : public TileVisitor {
   // (for example how to avoid testing all 8 corners).
   bool testInFrustum(TileNode* node) const;
 
-  // Returns true if one the eight tile bbox corner points is not occluded by a proxy sphere.
-  // Culls tiles behind the horizon.
+  // Returns true if one the eight tile bbox corner points is not occluded by a proxy ellipsoid.
+  // This ellipsoid has the radii of the body shrunk by the lowest terrain height, so tiles behind
+  // the horizon are culled even on strongly oblate bodies.
   bool testFrontFacing(TileNode* node) const;
 
-  PlanetParameters const* mParams;
-  TreeManager*            mTreeMgr;
-  bool                    mRecomputeTileBounds = false;
+  PlanetParameters const*       mParams;
+  TreeManager*                  mTreeMgr;
+  std::shared_ptr<TimeBudget>   mTimeBudget;
+  std::shared_ptr<HEALPixCache> mHEALPixCache;
+
+  // Incremented by queueRecomputeTileBounds(). Bounds are only recomputed until this deadline.
+  uint64_t                      mBoundsRevision = 0;
+  TimeBudget::Clock::time_point mBoundsDeadline;
 
   glm::dmat4 mMatVM;
   glm::dmat4 mMatP;
   CameraData mCameraData;
-  double     mHorizonCullRadius;
+
+  // The radii of the occluding ellipsoid and the camera position in the space where this ellipsoid
+  // is a unit sphere.
+  glm::dvec3 mHorizonCullRadii{};
+  glm::dvec3 mHorizonCullCamPos{};
 
   std::vector<TileId>    mLoadNodes;
   std::vector<TileNode*> mRenderNodes;
 
+  // These are used to decide whether the results of the previous traversal can be reused.
+  std::array<RootResult, TileQuadTree::sNumRoots> mRootResults;
+  glm::dmat4                                      mLastMatVM{};
+  glm::dmat4                                      mLastMatP{};
+  double                                          mLastLodFactor = 0.0;
+  int                                             mLastMinLevel  = -1;
+  int                                             mLastMaxLevel  = -1;
+
   int  mFrameCount;
   bool mUpdateLOD;
+  bool mStoreScreenSpaceError = true;
 };
 
 } // namespace csp::lodbodies
@@ -12,6 +12,8 @@
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-gui/GuiItem.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/convert.hpp"
+#include "TilePool.hpp"
 #include "utils.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaGroupNode.h>
@@ -19,21 +21,47 @@
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the transformation of an anchor with the given properties relative to its own center and
+// frame. This matches CelestialAnchor::getRelativeTransform().
+glm::dmat4 getAnchorTransform(
+    glm::dvec3 const& position, glm::dquat const& rotation, double scale) {
+  glm::dmat4 mat(1.0);
+  mat = glm::translate(mat, position);
+  mat = glm::rotate(mat, glm::angle(rotation), glm::axis(rotation));
+  mat = glm::scale(mat, glm::dvec3(scale, scale, scale));
+
+  return mat;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
     std::shared_ptr<cs::core::GraphicsEngine>        graphicsEngine,
     std::shared_ptr<cs::core::SolarSystem>           solarSystem,
     std::shared_ptr<Plugin::Settings>                pluginSettings,
-    std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources)
+    std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources,
+    std::shared_ptr<TimeBudget> timeBudget)
     : mSettings(std::move(settings))
     , mGraphicsEngine(std::move(graphicsEngine))
     , mSolarSystem(std::move(solarSystem))
     , mPluginSettings(std::move(pluginSettings))
     , mGuiManager(std::move(pGuiManager))
+    , mTilePool(std::make_shared<TilePool>(0))
     , mEclipseShadowReceiver(
           std::make_shared<cs::core::EclipseShadowReceiver>(mSettings, mSolarSystem, false))
     , mPlanet(std::move(glResources), mPluginSettings->mTileResolutionDEM.get())
@@ -41,11 +69,27 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
 
   mGraphicsEngine->registerCaster(&mPlanet);
   mPlanet.setTerrainShader(&mShader);
+  mPlanet.setTimeBudget(timeBudget);
 
   // scene-wide settings -----------------------------------------------------
   mHeightScaleConnection = mSettings->mGraphics.pHeightScale.connectAndTouch(
       [this](float val) { mPlanet.setHeightScale(val); });
 
+  mTileMemoryBudgetConnection =
+      mPluginSettings->mTileMemoryBudget.connectAndTouch([this](uint32_t val) {
+        mTilePool->setBudget(static_cast<std::size_t>(val) * 1024 * 1024);
+      });
+
+  // The depth picker is only created if required, as it allocates a pixel buffer object.
+  mDepthPickingConnection =
+      mPluginSettings->mEnableDepthPicking.connectAndTouch([this](bool enable) {
+        if (enable) {
+          mDepthPicker = std::make_unique<DepthPicker>();
+        } else {
+          mDepthPicker.reset();
+        }
+      });
+
   mPluginSettings->mLODFactor.connectAndTouch([this](float val) { mPlanet.setLODFactor(val); });
 
   mPluginSettings->mEnableWireframe.connectAndTouch(
@@ -60,8 +104,8 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
   // Add to scenegraph.
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
-  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-      mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::ePlanets));
+  mSortKey = static_cast<int>(cs::utils::DrawOrder::ePlanets);
+  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mGLNode.get(), mSortKey);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -69,6 +113,8 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
 LodBody::~LodBody() {
   mGraphicsEngine->unregisterCaster(&mPlanet);
   mSettings->mGraphics.pHeightScale.disconnect(mHeightScaleConnection);
+  mPluginSettings->mTileMemoryBudget.disconnect(mTileMemoryBudgetConnection);
+  mPluginSettings->mEnableDepthPicking.disconnect(mDepthPickingConnection);
 
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   pSG->GetRoot()->DisconnectChild(mGLNode.get());
@@ -82,9 +128,102 @@ PlanetShader const& LodBody::getShader() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool LodBody::warmUp(glm::dvec3 const& position, glm::dquat const& rotation) {
+  auto parent = mSolarSystem->getObject(mObjectName);
+  if (!parent || !parent->getIsBodyVisible()) {
+    return true;
+  }
+
+  // The view is prefetched with the scene scale the observer would have there. This matters, as
+  // close tiles would be culled by the near clipping plane otherwise. This follows
+  // SolarSystem::updateSceneScale(), but ignores the terrain height.
+  auto const& sceneScale = mSettings->mSceneScale;
+  double altitude = cs::utils::convert::cartesianToLngLatHeight(position, parent->getRadii()).z;
+  double interpolate = 1.0;
+
+  if (sceneScale.mFarRealDistance != sceneScale.mCloseRealDistance) {
+    interpolate = glm::clamp((altitude - sceneScale.mCloseRealDistance) /
+                                 (sceneScale.mFarRealDistance - sceneScale.mCloseRealDistance),
+        0.0, 1.0);
+  }
+
+  double scale = glm::clamp(
+      altitude / glm::mix(sceneScale.mCloseVisualDistance, sceneScale.mFarVisualDistance,
+                     interpolate),
+      sceneScale.mMinScale, sceneScale.mMaxScale);
+
+  glm::dmat4 transform = glm::inverse(getAnchorTransform(position, rotation, scale));
+
+  if (mWarmUpTransform != transform) {
+    mWarmUpTransform = transform;
+    mWarmUpFrames    = 0;
+  }
+
+  mWarmUpRequested = true;
+
+  // Some frames are required until all visible tiles have been requested level by level.
+  int const minFrames = 10;
+  return mWarmUpFrames >= minFrames && getPendingTileCount() == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LodBody::getPendingTileCount() const {
+  TreeManager* treeManager = mPlanet.getTileRenderer().getTreeManager();
+  return treeManager ? treeManager->getPendingCount() : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool LodBody::getIntersection(
     glm::dvec3 const& rayPos, glm::dvec3 const& rayDir, glm::dvec3& pos) const {
-  return utils::intersectPlanet(&mPlanet, rayPos, rayDir, pos);
+
+  // If depth picking is enabled, the depth of the pixel hit by the ray is read in the next frame.
+  // If the point read in a previous frame lies on the given ray, it is used directly.
+  if (mDepthPicker) {
+    mDepthPicker->setRay(rayPos, rayDir);
+
+    if (mDepthPicker->getIntersection(
+            rayPos, rayDir, mPlanet.getWorldTransform(), mPlanet.getRadii(), pos)) {
+      return true;
+    }
+  }
+
+  TreeManager* treeManager = mPlanet.getTileRenderer().getTreeManager();
+
+  if (treeManager == nullptr || treeManager->getTree() == nullptr) {
+    return utils::intersectPlanet(&mPlanet, rayPos, rayDir, pos);
+  }
+
+  // The result only changes if the ray, the body, or the structure of the quadtree changes.
+  Intersection query;
+  query.mRayPos      = rayPos;
+  query.mRayDir      = rayDir;
+  query.mTransform   = mPlanet.getWorldTransform();
+  query.mRadii       = mPlanet.getRadii();
+  query.mHeightScale = mPlanet.getHeightScale();
+  query.mValid       = true;
+
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    query.mRevisions.at(i) = treeManager->getTree()->getRevision(i);
+  }
+
+  for (auto const& cached : mIntersections) {
+    if (cached.mValid && cached.mRayPos == query.mRayPos && cached.mRayDir == query.mRayDir &&
+        cached.mTransform == query.mTransform && cached.mRadii == query.mRadii &&
+        cached.mHeightScale == query.mHeightScale && cached.mRevisions == query.mRevisions) {
+      pos = cached.mPos;
+      return cached.mHit;
+    }
+  }
+
+  query.mHit = utils::intersectPlanet(&mPlanet, rayPos, rayDir, query.mPos);
+  pos        = query.mPos;
+
+  mIntersections.at(mNextIntersection) = query;
+  mNextIntersection                    = (mNextIntersection + 1) % mIntersections.size();
+
+  return query.mHit;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -95,8 +234,70 @@ double LodBody::getHeight(glm::dvec2 lngLat) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LodBody::getHeights(
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const {
+  utils::getHeights(&mPlanet, HeightSamplePrecision::eActual, lngLats, heights, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<cs::scene::CelestialSurface::HeightQuery const> LodBody::requestHeights(
+    std::vector<glm::dvec2> lngLats) {
+  auto query      = std::make_shared<HeightQuery>();
+  query->mLngLats = std::move(lngLats);
+  mHeightQueries.push_back(query);
+
+  return query;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LodBody::answerHeightQueries() {
+  if (mHeightQueries.empty()) {
+    return;
+  }
+
+  // Queries which are not referenced anymore by their callers are skipped.
+  std::vector<std::shared_ptr<HeightQuery>> queries;
+  queries.reserve(mHeightQueries.size());
+
+  mHeightBatchLngLats.clear();
+
+  for (auto const& weakQuery : mHeightQueries) {
+    if (auto query = weakQuery.lock()) {
+      mHeightBatchLngLats.insert(
+          mHeightBatchLngLats.end(), query->mLngLats.begin(), query->mLngLats.end());
+      queries.push_back(std::move(query));
+    }
+  }
+
+  mHeightQueries.clear();
+
+  // All coordinates are sorted along the quadtree together, so tiles which are used by several
+  // queries are only visited once.
+  utils::getHeights(&mPlanet, HeightSamplePrecision::eActual, mHeightBatchLngLats,
+      mHeightBatchHeights, true);
+
+  auto begin = mHeightBatchHeights.begin();
+
+  for (auto const& query : queries) {
+    auto end = begin + static_cast<std::ptrdiff_t>(query->mLngLats.size());
+    query->mHeights.assign(begin, end);
+    query->mReady = true;
+    begin         = end;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void LodBody::setDEMtileSource(std::shared_ptr<TileSource> source, uint32_t maxLevel) {
   if (!source->isSame(mDEMtileSource.get())) {
+    auto const& glResources = mPlanet.getTileRenderer().getTreeManager()->getGLResources();
+
+    // Quantized elevation tiles are also stored quantized in the tile cache.
+    source->setTilePool(mTilePool);
+    source->setCompressElevationTiles(
+        glResources->get(TileDataType::eElevation)->isCompressed());
     mPlanet.setDataSource(TileDataType::eElevation, source.get());
     mDEMtileSource = std::move(source);
   }
@@ -112,6 +313,11 @@ void LodBody::setDEMtileSource(std::shared_ptr<TileSource> source, uint32_t maxL
 void LodBody::setIMGtileSource(std::shared_ptr<TileSource> source, uint32_t maxLevel) {
   if (source) {
     if (!source->isSame(mIMGtileSource.get())) {
+      auto const& glResources = mPlanet.getTileRenderer().getTreeManager()->getGLResources();
+
+      // Compress the tiles already on the loader threads if they are stored compressed anyways.
+      source->setTilePool(mTilePool);
+      source->setCompressColorTiles(glResources->get(TileDataType::eColor)->isCompressed());
       mPlanet.setDataSource(TileDataType::eColor, source.get());
       mShader.pEnableTexture = true;
       mIMGtileSource         = std::move(source);
@@ -149,6 +355,7 @@ std::shared_ptr<TileSource> const& LodBody::getIMGtileSource() const {
 void LodBody::setObjectName(std::string objectName) {
   mShader.setObjectName(objectName);
   mObjectName = std::move(objectName);
+  mTimerId    = cs::utils::FrameStats::intern("LoD-Body " + mObjectName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -160,6 +367,8 @@ std::string const& LodBody::getObjectName() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LodBody::update() {
+  answerHeightQueries();
+
   auto parent  = mSolarSystem->getObject(mObjectName);
   bool visible = parent && parent->getIsBodyVisible();
 
@@ -172,6 +381,15 @@ void LodBody::update() {
     mPlanet.setRadii(parent->getRadii());
     mPlanet.setWorldTransform(parent->getObserverRelativeTransform());
 
+    // If the observer does not move, the view given to warmUp() in the last frame is prefetched.
+    auto prefetchTransform = predictTransform(*parent, transform);
+    if (!prefetchTransform && mWarmUpRequested) {
+      prefetchTransform = mWarmUpTransform;
+      ++mWarmUpFrames;
+    }
+
+    mPlanet.setPrefetchTransform(prefetchTransform);
+
     double sunIlluminance = mSolarSystem->getSunIlluminance(transform[3]);
 
     auto sunDirection = glm::normalize(
@@ -180,19 +398,79 @@ void LodBody::update() {
     mShader.setSun(sunDirection, static_cast<float>(sunIlluminance));
 
     mEclipseShadowReceiver->update(*parent);
+
+    // Bodies closer to the observer are drawn first, so that the terrain of bodies behind them is
+    // rejected by the depth test before it is shaded.
+    auto const& radii    = parent->getRadii();
+    double      scale    = glm::length(glm::dvec3(transform[0]));
+    double      radius   = scale * std::max(radii.x, std::max(radii.y, radii.z));
+    double      distance = glm::length(glm::dvec3(transform[3])) - radius;
+
+    int sortKey = cs::utils::getFrontToBackSortKey(cs::utils::DrawOrder::ePlanets, distance);
+
+    if (sortKey != mSortKey) {
+      mSortKey = sortKey;
+      VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mGLNode.get(), mSortKey);
+    }
   }
+
+  mWarmUpRequested = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<glm::dmat4> LodBody::predictTransform(
+    cs::scene::CelestialObject const& parent, glm::dmat4 const& transform) {
+
+  double prefetchTime = mPluginSettings->mPrefetchTime.get();
+
+  if (prefetchTime <= 0.0) {
+    return std::nullopt;
+  }
+
+  double now =
+      cs::utils::convert::time::toSpice(boost::posix_time::microsec_clock::universal_time());
+
+  // During animations, the observer's animation is evaluated at the prefetch time. Else the
+  // velocity reported by the navigation is extrapolated. The observer's center and frame do not
+  // change in the meantime, so the predicted transform can be computed from the observer transform
+  // without querying SPICE again.
+  auto const& observer  = mSolarSystem->getObserver();
+  glm::dvec3  predicted = observer.getAnimatedPosition(now + prefetchTime);
+
+  // Prefetching is only worthwhile if the observer moves a significant distance relative to its
+  // altitude.
+  if (!observer.isAnimationInProgress()) {
+    auto const& radii    = parent.getRadii();
+    glm::dvec3  position(glm::inverse(transform)[3]);
+    double      altitude = glm::length(position) - std::min(radii.x, std::min(radii.y, radii.z));
+
+    if (glm::length(predicted - observer.getPosition()) < 0.01 * altitude) {
+      return std::nullopt;
+    }
+  }
+
+  glm::dmat4 current =
+      getAnchorTransform(observer.getPosition(), observer.getRotation(), observer.getScale());
+  glm::dmat4 future = getAnchorTransform(
+      predicted, observer.getAnimatedRotation(now + prefetchTime), observer.getScale());
+
+  return glm::inverse(future) * current * transform;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool LodBody::Do() {
-  auto                                           timerName = "LoD-Body " + mObjectName;
-  cs::utils::FrameStats::ScopedTimer             timer(timerName);
-  cs::utils::FrameStats::ScopedSamplesCounter    samplesCounter(timerName);
-  cs::utils::FrameStats::ScopedPrimitivesCounter primitivesCounter(timerName);
+  cs::utils::FrameStats::ScopedTimer             timer(mTimerId);
+  cs::utils::FrameStats::ScopedSamplesCounter    samplesCounter(mTimerId);
+  cs::utils::FrameStats::ScopedPrimitivesCounter primitivesCounter(mTimerId);
 
   mPlanet.draw();
 
+  if (mDepthPicker) {
+    mDepthPicker->read(mPlanet.getWorldTransform());
+  }
+
   return true;
 }
 
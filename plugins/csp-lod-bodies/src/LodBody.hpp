@@ -11,14 +11,18 @@
 #include "../../../src/cs-graphics/Shadows.hpp"
 #include "../../../src/cs-scene/CelestialSurface.hpp"
 #include "../../../src/cs-scene/IntersectableObject.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 
+#include "DepthPicker.hpp"
 #include "PlanetShader.hpp"
 #include "TileSource.hpp"
 #include "TileTextureArray.hpp"
 #include "VistaPlanet.hpp"
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 
+#include <array>
 #include <memory>
+#include <optional>
 
 namespace cs::core {
 class GraphicsEngine;
@@ -41,7 +45,8 @@ class LodBody : public cs::scene::CelestialSurface,
       std::shared_ptr<cs::core::GraphicsEngine> graphicsEngine,
       std::shared_ptr<cs::core::SolarSystem>    solarSystem,
       std::shared_ptr<Plugin::Settings>         pluginSettings,
-      std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources);
+      std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources,
+      std::shared_ptr<TimeBudget> timeBudget);
 
   LodBody(LodBody const& other) = delete;
   LodBody(LodBody&& other)      = delete;
@@ -73,12 +78,40 @@ class LodBody : public cs::scene::CelestialSurface,
       glm::dvec3 const& rayPos, glm::dvec3 const& rayDir, glm::dvec3& pos) const override;
   double getHeight(glm::dvec2 lngLat) const override;
 
+  /// Samples each loaded tile only once and splits large batches among several threads.
+  void getHeights(
+      std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const override;
+
+  /// The queries of all callers are collected and answered together during the next call to
+  /// update(), using a single batch of getHeights().
+  std::shared_ptr<HeightQuery const> requestHeights(std::vector<glm::dvec2> lngLats) override;
+
+  /// While the observer does not move, the tiles visible from the given view are prefetched
+  /// instead of those along the predicted observer path. This returns true once this has been done
+  /// for a couple of frames and no tiles are pending anymore. Bodies which are currently not
+  /// visible do not load any tiles, for them this returns true right away.
+  bool warmUp(glm::dvec3 const& position, glm::dquat const& rotation) override;
+
+  /// Returns the number of tiles which have been requested but not yet been merged into the tile
+  /// quadtree.
+  std::size_t getPendingTileCount() const;
+
   void update();
 
   bool Do() override;
   bool GetBoundingBox(VistaBoundingBox& bb) override;
 
  private:
+  /// Returns the observer-relative transformation the body is expected to have in
+  /// Plugin::Settings::mPrefetchTime seconds. During observer animations, the animation is
+  /// evaluated at this time, else the velocity reported by the navigation is extrapolated. Returns
+  /// std::nullopt if prefetching is disabled or if the observer is not moving significantly.
+  std::optional<glm::dmat4> predictTransform(
+      cs::scene::CelestialObject const& parent, glm::dmat4 const& transform);
+
+  /// Answers all queries passed to requestHeights() since the last call.
+  void answerHeightQueries();
+
   std::shared_ptr<cs::core::Settings>       mSettings;
   std::shared_ptr<cs::core::GraphicsEngine> mGraphicsEngine;
   std::shared_ptr<cs::core::SolarSystem>    mSolarSystem;
@@ -86,11 +119,14 @@ class LodBody : public cs::scene::CelestialSurface,
   std::shared_ptr<cs::core::GuiManager>     mGuiManager;
 
   std::unique_ptr<VistaOpenGLNode>                 mGLNode;
+  int                                              mSortKey = 0;
   std::shared_ptr<TileSource>                      mDEMtileSource;
   std::shared_ptr<TileSource>                      mIMGtileSource;
+  std::shared_ptr<TilePool>                        mTilePool;
   std::shared_ptr<cs::core::EclipseShadowReceiver> mEclipseShadowReceiver;
 
-  std::string mObjectName;
+  std::string                    mObjectName;
+  cs::utils::FrameStats::TimerId mTimerId{};
 
   VistaPlanet  mPlanet;
   PlanetShader mShader;
@@ -98,7 +134,42 @@ class LodBody : public cs::scene::CelestialSurface,
   uint32_t mMaxLevelDEM = 0;
   uint32_t mMaxLevelIMG = 0;
 
-  int mHeightScaleConnection = -1;
+  // The observer-relative transformation of the view given to warmUp(), whether warmUp() has been
+  // called since the last update(), and the number of frames the view has been prefetched.
+  std::optional<glm::dmat4> mWarmUpTransform;
+  bool                      mWarmUpRequested = false;
+  int                       mWarmUpFrames    = 0;
+
+  // The results of the most recent calls to getIntersection(). As the pointer rays and the loaded
+  // tiles usually do not change from one frame to the next, most queries can be answered from
+  // here. There is one entry for each pointer which may be used simultaneously.
+  struct Intersection {
+    glm::dvec3                                    mRayPos{};
+    glm::dvec3                                    mRayDir{};
+    glm::dmat4                                    mTransform{};
+    glm::dvec3                                    mRadii{};
+    double                                        mHeightScale{};
+    std::array<uint64_t, TileQuadTree::sNumRoots> mRevisions{};
+    bool                                          mValid = false;
+    bool                                          mHit   = false;
+    glm::dvec3                                    mPos{};
+  };
+
+  mutable std::array<Intersection, 4> mIntersections;
+  mutable std::size_t                 mNextIntersection = 0;
+
+  // The queries passed to requestHeights() since the last update(). The coordinates of all of
+  // them are sampled at once, the vectors of this batch are kept to reuse their memory.
+  std::vector<std::weak_ptr<HeightQuery>> mHeightQueries;
+  std::vector<glm::dvec2>                 mHeightBatchLngLats;
+  std::vector<double>                     mHeightBatchHeights;
+
+  // This is only set if Plugin::Settings::mEnableDepthPicking is true.
+  std::unique_ptr<DepthPicker> mDepthPicker;
+
+  int mHeightScaleConnection      = -1;
+  int mTileMemoryBudgetConnection = -1;
+  int mDepthPickingConnection     = -1;
 };
 
 } // namespace csp::lodbodies
@@ -8,119 +8,251 @@
 #include "MinMaxPyramid.hpp"
 #include "TileData.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
+// SSE2 is available on all x86-64 CPUs and NEON on all AArch64 CPUs, so no special compiler flags
+// are required for these.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CSP_LOD_BODIES_USE_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CSP_LOD_BODIES_USE_NEON
+#endif
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-// DISCLAIMER: The MinMaxPyramid was ported from a version of CosmoScout VR which used a fixed    //
-// tile resolution of 257x257. There is no guarantee that it still works 100%. This should be     //
-// tested before using it agin :)                                                                 //
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The reduction operations, for single values and for four values at once.
+struct Min {
+  static float apply(float a, float b) {
+    return std::min(a, b);
+  }
+#if defined(CSP_LOD_BODIES_USE_SSE2)
+  static __m128 apply(__m128 a, __m128 b) {
+    return _mm_min_ps(a, b);
+  }
+#elif defined(CSP_LOD_BODIES_USE_NEON)
+  static float32x4_t apply(float32x4_t a, float32x4_t b) {
+    return vminq_f32(a, b);
+  }
+#endif
+};
+
+struct Max {
+  static float apply(float a, float b) {
+    return std::max(a, b);
+  }
+#if defined(CSP_LOD_BODIES_USE_SSE2)
+  static __m128 apply(__m128 a, __m128 b) {
+    return _mm_max_ps(a, b);
+  }
+#elif defined(CSP_LOD_BODIES_USE_NEON)
+  static float32x4_t apply(float32x4_t a, float32x4_t b) {
+    return vmaxq_f32(a, b);
+  }
+#endif
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// out[i] = Op(a[i], b[i]). out may be the same as a or b.
+template <typename Op>
+void combineRows(float const* a, float const* b, float* out, std::size_t count) {
+  std::size_t i = 0;
+
+#if defined(CSP_LOD_BODIES_USE_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(out + i, Op::apply(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+#elif defined(CSP_LOD_BODIES_USE_NEON)
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(out + i, Op::apply(vld1q_f32(a + i), vld1q_f32(b + i)));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    out[i] = Op::apply(a[i], b[i]);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-MinMaxPyramid::MinMaxPyramid(TileData<float>* tile)
-    : mTileResolution(tile->getResolution())
-    , mLevels(static_cast<uint32_t>(std::log2(mTileResolution)) - 1)
-    , mMinPyramid(mLevels)
-    , mMaxPyramid(mLevels) {
+// out[i] = Op(in[2 * i], in[2 * i + 1]). in has to contain at least 2 * count values.
+template <typename Op>
+void combinePairs(float const* in, float* out, std::size_t count) {
+  std::size_t i = 0;
 
-  for (uint32_t i(0); i < mLevels; ++i) {
-    uint32_t resolution = mTileResolution / (1 << (i + 1));
-    mMinPyramid[i] = std::vector<float>(resolution * resolution, std::numeric_limits<float>::max());
-    mMaxPyramid[i] =
-        std::vector<float>(resolution * resolution, std::numeric_limits<float>::lowest());
+#if defined(CSP_LOD_BODIES_USE_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    __m128 lo   = _mm_loadu_ps(in + 2 * i);
+    __m128 hi   = _mm_loadu_ps(in + 2 * i + 4);
+    __m128 even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odd  = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(out + i, Op::apply(even, odd));
+  }
+#elif defined(CSP_LOD_BODIES_USE_NEON)
+  for (; i + 4 <= count; i += 4) {
+    float32x4x2_t v = vld2q_f32(in + 2 * i);
+    vst1q_f32(out + i, Op::apply(v.val[0], v.val[1]));
   }
+#endif
 
-  // Construct first MinMaxPyramid layer by sampling 2x2 values
-  uint32_t halfSize = static_cast<uint32_t>((mTileResolution - 1) / 2);
-  uint32_t x2       = 0;
-  uint32_t y2       = 0;
+  for (; i < count; ++i) {
+    out[i] = Op::apply(in[2 * i], in[2 * i + 1]);
+  }
+}
 
-  for (uint32_t y = 0; y < mTileResolution; ++y) {
-    x2 = 0;
-    for (uint32_t x = 0; x < mTileResolution; ++x) {
-      float const v = tile->data()[y * mTileResolution + x];
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      mMinValue = std::min(mMinValue, v);
-      mMaxValue = std::max(mMaxValue, v);
-      mAvgValue += v / (mTileResolution * mTileResolution);
+// Reduces the given resolution x resolution grid to a (resolution / 2) x (resolution / 2) grid.
+// If the resolution is odd, the last row and column are merged into the last output row and
+// column. The scratch buffer has to hold at least resolution values.
+template <typename Op>
+void reduceLevel(float const* in, uint32_t resolution, float* out, float* scratch) {
+  uint32_t outResolution = resolution / 2;
+  bool     odd           = resolution % 2 == 1;
 
-      x2                                 = std::min(x2, halfSize - 1);
-      y2                                 = std::min(y2, halfSize - 1);
-      mMinPyramid[0][y2 * halfSize + x2] = std::min(mMinPyramid[0][y2 * halfSize + x2], v);
-      mMaxPyramid[0][y2 * halfSize + x2] = std::max(mMaxPyramid[0][y2 * halfSize + x2], v);
+  for (uint32_t y = 0; y < outResolution; ++y) {
+    float const* row = in + static_cast<std::size_t>(2 * y) * resolution;
+    combineRows<Op>(row, row + resolution, scratch, resolution);
 
-      if (x % 2 == 1) {
-        x2 += 1;
-      }
+    if (odd && y == outResolution - 1) {
+      combineRows<Op>(scratch, row + 2 * resolution, scratch, resolution);
     }
 
-    if (y % 2 == 1) {
-      y2 += 1;
+    float* outRow = out + static_cast<std::size_t>(y) * outResolution;
+    combinePairs<Op>(scratch, outRow, outResolution);
+
+    if (odd) {
+      outRow[outResolution - 1] = Op::apply(outRow[outResolution - 1], scratch[resolution - 1]);
     }
   }
+}
 
-  // Build remaining MinMaxPyramid layers
-  for (uint32_t i(1); i < mLevels; ++i) {
-    y2 = 0;
-    for (uint32_t y = 0; y < (mTileResolution - 1) * std::pow(0.5, i); ++y) {
-      x2 = 0;
-      for (uint32_t x = 0; x < (mTileResolution - 1) * std::pow(0.5, i); ++x) {
-        mMinPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)] = std::min(
-            mMinPyramid[i - 1]
-                       [static_cast<uint64_t>(y * (mTileResolution - 1) * std::pow(0.5, i) + x)],
-            mMinPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)]);
-        mMaxPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)] = std::max(
-            mMaxPyramid[i - 1]
-                       [static_cast<uint64_t>(y * (mTileResolution - 1) * std::pow(0.5, i) + x)],
-            mMaxPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)]);
-        if (x % 2 == 1) {
-          x2 += 1;
-        }
-      }
-      if (y % 2 == 1) {
-        y2 += 1;
-      }
-    }
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MinMaxPyramid::MinMaxPyramid(TileData<float> const* tile)
+    : mTileResolution(tile->getResolution()) {
+
+  // Compute the total size of all levels so that the pyramid can be allocated at once.
+  std::size_t size = 0;
+  for (uint32_t resolution = mTileResolution / 2; resolution > 0; resolution /= 2) {
+    size += 2 * static_cast<std::size_t>(resolution) * resolution;
+    ++mLevels;
   }
+
+  mPyramid.resize(size);
+
+  float const* data  = tile->data().data();
+  std::size_t  count = static_cast<std::size_t>(mTileResolution) * mTileResolution;
+
+  double sum = 0.0;
+  for (std::size_t i = 0; i < count; ++i) {
+    sum += data[i];
+  }
+  mAvgValue = static_cast<float>(sum / static_cast<double>(count));
+
+  if (mLevels == 0) {
+    mMinValue = *std::min_element(data, data + count);
+    mMaxValue = *std::max_element(data, data + count);
+    return;
+  }
+
+  std::vector<float> scratch(mTileResolution);
+
+  // The first level is reduced from the tile data, all other levels from the previous level.
+  float const* minInput   = data;
+  float const* maxInput   = data;
+  uint32_t     resolution = mTileResolution;
+
+  for (uint32_t level = 0; level < mLevels; ++level) {
+    std::size_t offset = getLevelOffset(level);
+    float*      minOut = mPyramid.data() + offset;
+    float*      maxOut = minOut + static_cast<std::size_t>(resolution / 2) * (resolution / 2);
+
+    reduceLevel<Min>(minInput, resolution, minOut, scratch.data());
+    reduceLevel<Max>(maxInput, resolution, maxOut, scratch.data());
+
+    minInput = minOut;
+    maxInput = maxOut;
+    resolution /= 2;
+  }
+
+  // The last level contains a single cell.
+  mMinValue = *minInput;
+  mMaxValue = *maxInput;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::vector<float>>& MinMaxPyramid::getMinPyramid() {
-  return mMinPyramid;
+uint32_t MinMaxPyramid::getLevelCount() const {
+  return mLevels;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::vector<float>>& MinMaxPyramid::getMaxPyramid() {
-  return mMaxPyramid;
+uint32_t MinMaxPyramid::getLevelResolution(uint32_t level) const {
+  return mTileResolution >> (level + 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getMin(std::vector<int> const& quadrants) {
-  return getData(mMinPyramid, quadrants);
+float const* MinMaxPyramid::getMinLevel(uint32_t level) const {
+  return mPyramid.data() + getLevelOffset(level);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getMax(std::vector<int> const& quadrants) {
-  return getData(mMaxPyramid, quadrants);
+float const* MinMaxPyramid::getMaxLevel(uint32_t level) const {
+  std::size_t resolution = getLevelResolution(level);
+  return getMinLevel(level) + resolution * resolution;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getData(
-    std::vector<std::vector<float>>& pyramid, std::vector<int> const& quadrants) {
+float MinMaxPyramid::getMin(std::vector<int> const& quadrants) const {
+  return getData(false, quadrants);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float MinMaxPyramid::getMax(std::vector<int> const& quadrants) const {
+  return getData(true, quadrants);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float MinMaxPyramid::getData(bool max, std::vector<int> const& quadrants) const {
   // number of pyramid levels:
-  auto qSize = quadrants.size();
+  auto qSize = static_cast<uint32_t>(quadrants.size());
+
+  if (qSize == 0) {
+    return max ? mMaxValue : mMinValue;
+  }
+
+  if (qSize >= mLevels) {
+    throw std::out_of_range("Too many quadrants given for MinMaxPyramid!");
+  }
+
   // particular pyramid layer,
   // where min max information of the corresponding tile resolution is stored
-  auto layerId = 7 - qSize;
+  uint32_t layerId = mLevels - 1 - qSize;
   // pyramid layer address of searched value
-  int x(0);
-  int y(0);
-  for (size_t i(0); i < qSize; ++i) {
-    int step = int(std::pow(2, qSize - (i + 1)));
+  uint32_t x(0);
+  uint32_t y(0);
+  for (uint32_t i(0); i < qSize; ++i) {
+    uint32_t step = 1U << (qSize - (i + 1));
     switch (quadrants[i]) {
     case 1:
       x += step;
@@ -135,7 +267,19 @@ float MinMaxPyramid::getData(
     }
   }
 
-  return pyramid[layerId][int(y * std::pow(2, qSize) + x)];
+  float const* layer = max ? getMaxLevel(layerId) : getMinLevel(layerId);
+  return layer[y * getLevelResolution(layerId) + x];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t MinMaxPyramid::getLevelOffset(uint32_t level) const {
+  std::size_t offset = 0;
+  for (uint32_t i = 0; i < level; ++i) {
+    std::size_t resolution = getLevelResolution(i);
+    offset += 2 * resolution * resolution;
+  }
+  return offset;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
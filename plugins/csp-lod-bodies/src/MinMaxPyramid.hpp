@@ -8,6 +8,7 @@
 #ifndef CSP_LOD_BODIES_MINMAXPYRAMID_HPP
 #define CSP_LOD_BODIES_MINMAXPYRAMID_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <vector>
@@ -19,10 +20,16 @@ class TileData;
 
 /// The MinMaxPyramid is a data structure for finding lod data in constant time. It's similar
 /// to a quad tree but it contains precomputed min and max values at each level.
+///
+/// Level zero contains the minimum and maximum of each 2x2 block of samples of the tile, each
+/// following level combines 2x2 cells of the previous level. If a level has an odd resolution,
+/// its last row and column are merged into the second-last row and column of the next level. The
+/// last level always contains a single cell. All levels are stored in one contiguous buffer. The
+/// reduction is vectorized with SSE2 or NEON if available.
 class MinMaxPyramid {
 
  public:
-  explicit MinMaxPyramid(TileData<float>* tile);
+  explicit MinMaxPyramid(TileData<float> const* tile);
 
   MinMaxPyramid(MinMaxPyramid const& other) = default;
   MinMaxPyramid(MinMaxPyramid&& other)      = default;
@@ -32,14 +39,23 @@ class MinMaxPyramid {
 
   virtual ~MinMaxPyramid() = default;
 
-  std::vector<std::vector<float>>& getMinPyramid();
-  std::vector<std::vector<float>>& getMaxPyramid();
+  /// Returns the number of levels of the pyramid.
+  uint32_t getLevelCount() const;
+
+  /// Returns the number of cells along one edge of the given level.
+  uint32_t getLevelResolution(uint32_t level) const;
+
+  /// Returns the getLevelResolution(level)^2 minimum or maximum values of the given level in
+  /// row-major order.
+  float const* getMinLevel(uint32_t level) const;
+  float const* getMaxLevel(uint32_t level) const;
 
   /// Returns the minimum value in the given quadrant.
   ///
   /// Requires a list of quadrant indices {[0..3], [0..3], [0..3], ...}
   /// The number of given quadrants (q == 3 -> q0: 4x4, q1: 2x2, q2: 1x1)
-  /// determines the MinMaxPyramid level and the address for the data access.
+  /// determines the MinMaxPyramid level and the address for the data access. This is only
+  /// meaningful if the tile resolution is a power of two or a power of two plus one.
   /// @code
   ///  e.g. [1, 1, 1] = 8
   ///  e.g. [1, 1, 2] = 15
@@ -55,13 +71,13 @@ class MinMaxPyramid {
   /// 49  50  51  52  53  54  55  56
   /// 57  58  59  60  61  62  63  64
   /// @endcode
-  float getMin(std::vector<int> const& quadrants);
+  float getMin(std::vector<int> const& quadrants) const;
   float getMin() const {
     return mMinValue;
   }
 
   /// Returns the maximum value in the given quadrant.
-  float getMax(std::vector<int> const& quadrants);
+  float getMax(std::vector<int> const& quadrants) const;
   float getMax() const {
     return mMaxValue;
   }
@@ -71,15 +87,17 @@ class MinMaxPyramid {
     return mAvgValue;
   }
 
- protected:
-  static float getData(std::vector<std::vector<float>>& pyramid, std::vector<int> const& quadrants);
-
  private:
+  float getData(bool max, std::vector<int> const& quadrants) const;
+
+  // Returns the offset of the minimum values of the given level in mPyramid. The maximum values
+  // follow directly after them.
+  std::size_t getLevelOffset(uint32_t level) const;
+
   uint32_t mTileResolution{};
   uint32_t mLevels{};
 
-  std::vector<std::vector<float>> mMinPyramid;
-  std::vector<std::vector<float>> mMaxPyramid;
+  std::vector<float> mPyramid;
 
   float mMinValue = std::numeric_limits<float>::max();
   float mMaxValue = std::numeric_limits<float>::lowest();
@@ -9,6 +9,7 @@
 
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/Settings.hpp"
+#include "../../../src/cs-graphics/ShaderCache.hpp"
 #include "../../../src/cs-gui/GuiItem.hpp"
 #include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
@@ -135,34 +136,83 @@ void PlanetShader::setSun(glm::vec3 direction, float illuminance) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void PlanetShader::compile() {
-  mVertexSource   = cs::utils::filesystem::loadToString("../share/resources/shaders/Planet.vert");
-  mFragmentSource = cs::utils::filesystem::loadToString("../share/resources/shaders/Planet.frag");
+PlanetShader::Variant PlanetShader::getCurrentVariant() const {
+  Variant variant;
+  variant.mEnableTexture    = pEnableTexture.get();
+  variant.mHeightLines      = mPluginSettings->mEnableHeightlines.get();
+  variant.mColorMappingType = static_cast<int>(mPluginSettings->mColorMappingType.get());
+  variant.mLighting         = mSettings->mGraphics.pEnableLighting.get();
+  variant.mHDR              = mSettings->mGraphics.pEnableHDR.get();
+  variant.mShadowsDebug     = mSettings->mGraphics.pEnableShadowsDebug.get();
+  variant.mShadows          = mSettings->mGraphics.pEnableShadows.get();
+  variant.mLightingQuality  = mSettings->mGraphics.pLightingQuality.get();
+  variant.mTilesDebug       = mPluginSettings->mEnableTilesDebug.get();
+  variant.mLatLongGrid      = mPluginSettings->mEnableLatLongGrid.get();
+  variant.mProjectionType   = static_cast<int>(mPluginSettings->mTerrainProjectionType.get());
+  return variant;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<PlanetShader::Variant> PlanetShader::getNeighbouringVariants(Variant const& variant) {
+  std::vector<Variant> variants;
+
+  auto toggle = [&variants, &variant](bool Variant::*member) {
+    Variant other = variant;
+    other.*member = !(variant.*member);
+    variants.push_back(other);
+  };
+
+  // These are the settings which are usually toggled at runtime. The texture is disabled
+  // automatically while no image channel is available, the others are toggled in the user
+  // interface.
+  toggle(&Variant::mEnableTexture);
+  toggle(&Variant::mHeightLines);
+  toggle(&Variant::mLatLongGrid);
+  toggle(&Variant::mLighting);
+  toggle(&Variant::mShadows);
+
+  for (int type = 0; type < 3; ++type) {
+    if (type != variant.mColorMappingType) {
+      Variant other           = variant;
+      other.mColorMappingType = type;
+      variants.push_back(other);
+    }
+  }
+
+  return variants;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PlanetShader::buildSources(
+    Variant const& variant, std::string& vertexSource, std::string& fragmentSource) const {
+  vertexSource   = cs::utils::filesystem::loadToString("../share/resources/shaders/Planet.vert");
+  fragmentSource = cs::utils::filesystem::loadToString("../share/resources/shaders/Planet.frag");
 
-  cs::utils::replaceString(mFragmentSource, "$SHOW_HEIGHT_LINES",
-      cs::utils::toString(mPluginSettings->mEnableHeightlines.get()));
   cs::utils::replaceString(
-      mFragmentSource, "$SHOW_TEXTURE", cs::utils::toString(pEnableTexture.get()));
-  cs::utils::replaceString(mFragmentSource, "$COLOR_MAPPING_TYPE",
-      cs::utils::toString(static_cast<int>(mPluginSettings->mColorMappingType.get())));
-  cs::utils::replaceString(mFragmentSource, "$ENABLE_LIGHTING",
-      cs::utils::toString(mSettings->mGraphics.pEnableLighting.get()));
+      fragmentSource, "$SHOW_HEIGHT_LINES", cs::utils::toString(variant.mHeightLines));
+  cs::utils::replaceString(
+      fragmentSource, "$SHOW_TEXTURE", cs::utils::toString(variant.mEnableTexture));
+  cs::utils::replaceString(
+      fragmentSource, "$COLOR_MAPPING_TYPE", cs::utils::toString(variant.mColorMappingType));
+  cs::utils::replaceString(
+      fragmentSource, "$ENABLE_LIGHTING", cs::utils::toString(variant.mLighting));
+  cs::utils::replaceString(fragmentSource, "$ENABLE_HDR", cs::utils::toString(variant.mHDR));
+  cs::utils::replaceString(
+      fragmentSource, "$ENABLE_SHADOWS_DEBUG", cs::utils::toString(variant.mShadowsDebug));
+  cs::utils::replaceString(
+      fragmentSource, "$ENABLE_SHADOWS", cs::utils::toString(variant.mShadows));
+  cs::utils::replaceString(
+      fragmentSource, "$LIGHTING_QUALITY", cs::utils::toString(variant.mLightingQuality));
+  cs::utils::replaceString(
+      fragmentSource, "$SHOW_TILE_BORDER", cs::utils::toString(variant.mTilesDebug));
+  cs::utils::replaceString(
+      fragmentSource, "$SHOW_LAT_LONG_LABELS", cs::utils::toString(variant.mLatLongGrid));
   cs::utils::replaceString(
-      mFragmentSource, "$ENABLE_HDR", cs::utils::toString(mSettings->mGraphics.pEnableHDR.get()));
-  cs::utils::replaceString(mFragmentSource, "$ENABLE_SHADOWS_DEBUG",
-      cs::utils::toString(mSettings->mGraphics.pEnableShadowsDebug.get()));
-  cs::utils::replaceString(mFragmentSource, "$ENABLE_SHADOWS",
-      cs::utils::toString(mSettings->mGraphics.pEnableShadows.get()));
-  cs::utils::replaceString(mFragmentSource, "$LIGHTING_QUALITY",
-      cs::utils::toString(mSettings->mGraphics.pLightingQuality.get()));
-  cs::utils::replaceString(mFragmentSource, "$SHOW_TILE_BORDER",
-      cs::utils::toString(mPluginSettings->mEnableTilesDebug.get()));
-  cs::utils::replaceString(mFragmentSource, "$SHOW_LAT_LONG_LABELS",
-      cs::utils::toString(mPluginSettings->mEnableLatLongGrid.get()));
-  cs::utils::replaceString(mFragmentSource, "$SHOW_LAT_LONG",
-      cs::utils::toString(mPluginSettings->mEnableLatLongGrid.get()));
+      fragmentSource, "$SHOW_LAT_LONG", cs::utils::toString(variant.mLatLongGrid));
   cs::utils::replaceString(
-      mFragmentSource, "$ECLIPSE_SHADER_SNIPPET", mEclipseShadowReceiver->getShaderSnippet());
+      fragmentSource, "$ECLIPSE_SHADER_SNIPPET", mEclipseShadowReceiver->getShaderSnippet());
 
   // Include the BRDFs together with their parameters and arguments.
   Plugin::Settings::BRDF const& brdfHdr = mPluginSettings->mBodies[mObjectName].mBrdfHdr.get();
@@ -183,20 +233,49 @@ void PlanetShader::compile() {
   // inject the functions in the fragment shader
   cs::utils::replaceString(brdfHdrSource, "$BRDF", "BRDF_HDR");
   cs::utils::replaceString(brdfNonHdrSource, "$BRDF", "BRDF_NON_HDR");
-  cs::utils::replaceString(mFragmentSource, "$BRDF_HDR", brdfHdrSource);
-  cs::utils::replaceString(mFragmentSource, "$BRDF_NON_HDR", brdfNonHdrSource);
+  cs::utils::replaceString(fragmentSource, "$BRDF_HDR", brdfHdrSource);
+  cs::utils::replaceString(fragmentSource, "$BRDF_NON_HDR", brdfNonHdrSource);
 
-  cs::utils::replaceString(mFragmentSource, "$AVG_LINEAR_IMG_INTENSITY",
+  cs::utils::replaceString(fragmentSource, "$AVG_LINEAR_IMG_INTENSITY",
       std::to_string(mPluginSettings->mBodies[mObjectName].mAvgLinearImgIntensity.get()));
 
-  cs::utils::replaceString(mVertexSource, "$LIGHTING_QUALITY",
-      cs::utils::toString(mSettings->mGraphics.pLightingQuality.get()));
-  cs::utils::replaceString(mVertexSource, "$TERRAIN_PROJECTION_TYPE",
-      cs::utils::toString(static_cast<int>(mPluginSettings->mTerrainProjectionType.get())));
+  cs::utils::replaceString(
+      vertexSource, "$LIGHTING_QUALITY", cs::utils::toString(variant.mLightingQuality));
+  cs::utils::replaceString(
+      vertexSource, "$TERRAIN_PROJECTION_TYPE", cs::utils::toString(variant.mProjectionType));
+
+  injectTerrainFunctions(vertexSource, fragmentSource);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PlanetShader::compile() {
+  Variant variant = getCurrentVariant();
+  buildSources(variant, mVertexSource, mFragmentSource);
 
-  TerrainShader::compile();
+  mShader = cs::graphics::ShaderCache::get().getShader(mVertexSource, mFragmentSource);
 
-  mEclipseShadowReceiver->init(&mShader, TEX_UNIT_ECLIPSES);
+  mEclipseShadowReceiver->init(mShader.get(), TEX_UNIT_ECLIPSES);
+
+  // The variants which are most likely requested next are compiled during the following frames.
+  // Once the user toggles one of the corresponding settings, the linked program is taken from the
+  // ShaderCache without any delay.
+  mPendingVariants = getNeighbouringVariants(variant);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PlanetShader::precompileNextVariant() {
+  if (mPendingVariants.empty()) {
+    return;
+  }
+
+  std::string vertexSource;
+  std::string fragmentSource;
+  buildSources(mPendingVariants.back(), vertexSource, fragmentSource);
+  mPendingVariants.pop_back();
+
+  cs::graphics::ShaderCache::get().getShader(vertexSource, fragmentSource);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -207,38 +286,44 @@ void PlanetShader::bind() {
     mShaderDirty = true;
   }
 
+  // Compile at most one of the variants which are not used yet per frame, so that the frame time
+  // is hardly affected. This must happen before binding our own program.
+  if (!mShaderDirty) {
+    precompileNextVariant();
+  }
+
   TerrainShader::bind();
 
   GLint loc = -1;
-  loc       = mShader.GetUniformLocation("heightTex");
-  mShader.SetUniform(loc, TEX_UNIT_LUT);
+  loc       = mShader->GetUniformLocation("heightTex");
+  mShader->SetUniform(loc, TEX_UNIT_LUT);
 
-  loc = mShader.GetUniformLocation("fontTex");
-  mShader.SetUniform(loc, TEX_UNIT_FONT);
+  loc = mShader->GetUniformLocation("fontTex");
+  mShader->SetUniform(loc, TEX_UNIT_FONT);
 
-  loc = mShader.GetUniformLocation("heightMin");
-  mShader.SetUniform(loc, mPluginSettings->mHeightRange.get().x * 1000);
+  loc = mShader->GetUniformLocation("heightMin");
+  mShader->SetUniform(loc, mPluginSettings->mHeightRange.get().x * 1000);
 
-  loc = mShader.GetUniformLocation("heightMax");
-  mShader.SetUniform(loc, mPluginSettings->mHeightRange.get().y * 1000);
+  loc = mShader->GetUniformLocation("heightMax");
+  mShader->SetUniform(loc, mPluginSettings->mHeightRange.get().y * 1000);
 
-  loc = mShader.GetUniformLocation("slopeMin");
-  mShader.SetUniform(loc, cs::utils::convert::toRadians(mPluginSettings->mSlopeRange.get().x));
+  loc = mShader->GetUniformLocation("slopeMin");
+  mShader->SetUniform(loc, cs::utils::convert::toRadians(mPluginSettings->mSlopeRange.get().x));
 
-  loc = mShader.GetUniformLocation("slopeMax");
-  mShader.SetUniform(loc, cs::utils::convert::toRadians(mPluginSettings->mSlopeRange.get().y));
+  loc = mShader->GetUniformLocation("slopeMax");
+  mShader->SetUniform(loc, cs::utils::convert::toRadians(mPluginSettings->mSlopeRange.get().y));
 
-  loc = mShader.GetUniformLocation("ambientBrightness");
-  mShader.SetUniform(loc, mSettings->mGraphics.pAmbientBrightness.get());
+  loc = mShader->GetUniformLocation("ambientBrightness");
+  mShader->SetUniform(loc, mSettings->mGraphics.pAmbientBrightness.get());
 
-  loc = mShader.GetUniformLocation("ambientOcclusion");
-  mShader.SetUniform(loc, mSettings->mGraphics.pAmbientOcclusion.get());
+  loc = mShader->GetUniformLocation("ambientOcclusion");
+  mShader->SetUniform(loc, mSettings->mGraphics.pAmbientOcclusion.get());
 
-  loc = mShader.GetUniformLocation("texGamma");
-  mShader.SetUniform(loc, mPluginSettings->mTextureGamma.get());
+  loc = mShader->GetUniformLocation("texGamma");
+  mShader->SetUniform(loc, mPluginSettings->mTextureGamma.get());
 
-  loc = mShader.GetUniformLocation("uSunDirIlluminance");
-  mShader.SetUniform(loc, mSunDirection.x, mSunDirection.y, mSunDirection.z, mSunIlluminance);
+  loc = mShader->GetUniformLocation("uSunDirIlluminance");
+  mShader->SetUniform(loc, mSunDirection.x, mSunDirection.y, mSunDirection.z, mSunIlluminance);
 
   if (mPluginSettings->mEnableLatLongGrid.get()) {
     mFontTexture->Bind(GL_TEXTURE0 + TEX_UNIT_FONT);
@@ -249,6 +334,9 @@ void PlanetShader::bind() {
     if (it != mColorMaps.end()) {
       it->second.bind(GL_TEXTURE0 + TEX_UNIT_LUT);
 
+      loc = mShader->GetUniformLocation("heightTexLayer");
+      mShader->SetUniform(loc, static_cast<float>(it->second.getLayer()));
+
       // Enable alpha blending if the color map uses the alpha channel.
       if (it->second.getUsesAlpha()) {
         glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
@@ -27,7 +27,11 @@ class Settings;
 
 namespace csp::lodbodies {
 
-/// The shader for rendering a planet.
+/// The shader for rendering a planet. The shader is specialized for the current settings, all
+/// disabled features are removed by the preprocessor. Whenever a shader has been compiled, the
+/// variants which differ in one of the commonly toggled settings are compiled as well, one per
+/// frame. As all programs are kept by the cs::graphics::ShaderCache, toggling such a setting later
+/// swaps the program without any compilation.
 class PlanetShader : public TerrainShader {
  public:
   cs::utils::Property<bool> pEnableTexture = true; ///< If false the image data will not be drawn.
@@ -55,7 +59,30 @@ class PlanetShader : public TerrainShader {
   void release() override;
 
  private:
+  /// All settings which are compiled into the shader, apart from the eclipse shadows and the
+  /// BRDFs. These cannot change without calling setObjectName() or recompiling all variants.
+  struct Variant {
+    bool mEnableTexture    = true;
+    bool mHeightLines      = false;
+    int  mColorMappingType = 0;
+    bool mLighting         = false;
+    bool mHDR              = false;
+    bool mShadowsDebug     = false;
+    bool mShadows          = false;
+    int  mLightingQuality  = 0;
+    bool mTilesDebug       = false;
+    bool mLatLongGrid      = false;
+    int  mProjectionType   = 0;
+  };
+
+  Variant                     getCurrentVariant() const;
+  static std::vector<Variant> getNeighbouringVariants(Variant const& variant);
+
+  void buildSources(
+      Variant const& variant, std::string& vertexSource, std::string& fragmentSource) const;
+
   void compile() override;
+  void precompileNextVariant();
 
   std::shared_ptr<cs::core::Settings>              mSettings;
   std::shared_ptr<cs::core::GuiManager>            mGuiManager;
@@ -71,6 +98,8 @@ class PlanetShader : public TerrainShader {
   int                                              mLightingQualityConnection    = -1;
   int                                              mEnableHDRConnection          = -1;
 
+  std::vector<Variant> mPendingVariants;
+
   static std::map<std::string, cs::graphics::ColorMap> mColorMaps;
 };
 
@@ -17,6 +17,8 @@
 #include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 
+#include <algorithm>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 EXPORT_FN cs::core::PluginBase* create() {
@@ -37,20 +39,60 @@ namespace csp::lodbodies {
 
 void from_json(nlohmann::json const& j, Plugin::Settings::Dataset& o) {
   cs::core::Settings::deserialize(j, "copyright", o.mCopyright);
-  cs::core::Settings::deserialize(j, "layers", o.mLayers);
+  cs::core::Settings::deserialize(j, "file", o.mFile);
   cs::core::Settings::deserialize(j, "maxLevel", o.mMaxLevel);
-  cs::core::Settings::deserialize(j, "url", o.mURL);
+
+  // The web map service parameters are not required if the data is read from a GeoTIFF file.
+  if (!o.mFile || j.contains("layers")) {
+    cs::core::Settings::deserialize(j, "layers", o.mLayers);
+  }
+
+  if (!o.mFile || j.contains("url")) {
+    cs::core::Settings::deserialize(j, "url", o.mURL);
+  }
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings::Dataset const& o) {
   cs::core::Settings::serialize(j, "copyright", o.mCopyright);
-  cs::core::Settings::serialize(j, "layers", o.mLayers);
+  cs::core::Settings::serialize(j, "file", o.mFile);
   cs::core::Settings::serialize(j, "maxLevel", o.mMaxLevel);
-  cs::core::Settings::serialize(j, "url", o.mURL);
+
+  if (!o.mFile || !o.mLayers.empty()) {
+    cs::core::Settings::serialize(j, "layers", o.mLayers);
+  }
+
+  if (!o.mFile || !o.mURL.empty()) {
+    cs::core::Settings::serialize(j, "url", o.mURL);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Creates a TileSourceGeoTiff if the dataset refers to a file, a TileSourceWebMapService else.
+std::shared_ptr<TileSource> createTileSource(Plugin::Settings const& pluginSettings,
+    Plugin::Settings::Dataset const& dataset, TileDataType type, uint32_t resolution) {
+  if (dataset.mFile) {
+    auto source = std::make_shared<TileSourceGeoTiff>(resolution);
+    source->setFile(*dataset.mFile);
+    source->setDataType(type);
+    return source;
+  }
+
+  auto source = std::make_shared<TileSourceWebMapService>(resolution);
+  source->setCacheDirectory(pluginSettings.mMapCache.get());
+  source->setTileCacheSize(pluginSettings.mTileCacheSize.get());
+  source->setLayers(dataset.mLayers);
+  source->setUrl(dataset.mURL);
+  source->setDataType(type);
+  return source;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void from_json(nlohmann::json const& j, Plugin::Settings::Body& o) {
   cs::core::Settings::deserialize(j, "activeDemDataset", o.mActiveDemDataset);
   cs::core::Settings::deserialize(j, "activeImgDataset", o.mActiveImgDataset);
@@ -106,7 +148,15 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "maxGPUTilesDEM", o.mMaxGPUTilesDEM);
   cs::core::Settings::deserialize(j, "tileResolutionDEM", o.mTileResolutionDEM);
   cs::core::Settings::deserialize(j, "tileResolutionIMG", o.mTileResolutionIMG);
+  cs::core::Settings::deserialize(j, "compressTiles", o.mCompressTiles);
+  cs::core::Settings::deserialize(j, "sparseTiles", o.mSparseTiles);
   cs::core::Settings::deserialize(j, "mapCache", o.mMapCache);
+  cs::core::Settings::deserialize(j, "tileCacheSize", o.mTileCacheSize);
+  cs::core::Settings::deserialize(j, "prefetchTime", o.mPrefetchTime);
+  cs::core::Settings::deserialize(j, "tileMemoryBudget", o.mTileMemoryBudget);
+  cs::core::Settings::deserialize(j, "targetFrameRate", o.mTargetFrameRate);
+  cs::core::Settings::deserialize(j, "tileUpdateTimeRange", o.mTileUpdateTimeRange);
+  cs::core::Settings::deserialize(j, "enableDepthPicking", o.mEnableDepthPicking);
   cs::core::Settings::deserialize(j, "bodies", o.mBodies);
 }
 
@@ -131,7 +181,15 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "maxGPUTilesDEM", o.mMaxGPUTilesDEM);
   cs::core::Settings::serialize(j, "tileResolutionDEM", o.mTileResolutionDEM);
   cs::core::Settings::serialize(j, "tileResolutionIMG", o.mTileResolutionIMG);
+  cs::core::Settings::serialize(j, "compressTiles", o.mCompressTiles);
+  cs::core::Settings::serialize(j, "sparseTiles", o.mSparseTiles);
   cs::core::Settings::serialize(j, "mapCache", o.mMapCache);
+  cs::core::Settings::serialize(j, "tileCacheSize", o.mTileCacheSize);
+  cs::core::Settings::serialize(j, "prefetchTime", o.mPrefetchTime);
+  cs::core::Settings::serialize(j, "tileMemoryBudget", o.mTileMemoryBudget);
+  cs::core::Settings::serialize(j, "targetFrameRate", o.mTargetFrameRate);
+  cs::core::Settings::serialize(j, "tileUpdateTimeRange", o.mTileUpdateTimeRange);
+  cs::core::Settings::serialize(j, "enableDepthPicking", o.mEnableDepthPicking);
   cs::core::Settings::serialize(j, "bodies", o.mBodies);
 }
 
@@ -141,7 +199,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-lod-bodies")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   mGuiManager->addPluginTabToSideBarFromHTML(
@@ -393,6 +455,20 @@ void Plugin::init() {
     }
   });
 
+  mPluginSettings->mTileCacheSize.connect([this](uint32_t val) {
+    for (auto&& body : mLodBodies) {
+      auto src =
+          std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getDEMtileSource());
+      if (src) {
+        src->setTileCacheSize(val);
+      }
+      src = std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getIMGtileSource());
+      if (src) {
+        src->setTileCacheSize(val);
+      }
+    }
+  });
+
   onLoad();
 
   logger().info("Loading done.");
@@ -447,7 +523,14 @@ void Plugin::deInit() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Plugin::update() {
-  if (mPluginSettings->mAutoLOD.get()) {
+
+  // If the dynamic quality of the GraphicsEngine is enabled, it controls the level-of-detail
+  // together with all other quality knobs.
+  if (mPluginSettings->mAutoLOD.get() && mAllSettings->mGraphics.pEnableDynamicQuality.get()) {
+    glm::vec2 lodRange = mPluginSettings->mAutoLODRange.get();
+    mPluginSettings->mLODFactor =
+        glm::mix(lodRange.x, lodRange.y, mGraphicsEngine->pDynamicQuality.get());
+  } else if (mPluginSettings->mAutoLOD.get()) {
 
     double minLODFactor = mPluginSettings->mAutoLODRange.get().x;
     double maxLODFactor = mPluginSettings->mAutoLODRange.get().y;
@@ -468,6 +551,14 @@ void Plugin::update() {
     }
   }
 
+  // All bodies share one budget for updating their tile trees. It is adapted to the frame time of
+  // the last-but-one frame, which is the most recent one with GPU timings available.
+  double    targetFrameTime = 1000.0 / std::max(mPluginSettings->mTargetFrameRate.get(), 1.F);
+  glm::vec2 timeRange       = mPluginSettings->mTileUpdateTimeRange.get();
+
+  mTimeBudget->startFrame(
+      targetFrameTime, cs::utils::FrameStats::get().pFrameTime.get(), timeRange.x, timeRange.y);
+
   for (auto const& [name, body] : mLodBodies) {
     body->update();
   }
@@ -475,6 +566,13 @@ void Plugin::update() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool Plugin::getIsLoading() const {
+  return std::any_of(mLodBodies.begin(), mLodBodies.end(),
+      [](auto const& body) { return body.second->getPendingTileCount() > 0; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::onLoad() {
 
   // Read settings from JSON.
@@ -484,7 +582,8 @@ void Plugin::onLoad() {
   if (!mGLResources) {
     mGLResources = std::make_shared<csp::lodbodies::GLResources>(
         mPluginSettings->mMaxGPUTilesDEM.get(), mPluginSettings->mMaxGPUTilesColor.get(),
-        mPluginSettings->mTileResolutionDEM.get(), mPluginSettings->mTileResolutionIMG.get());
+        mPluginSettings->mTileResolutionDEM.get(), mPluginSettings->mTileResolutionIMG.get(),
+        mPluginSettings->mCompressTiles.get(), mPluginSettings->mSparseTiles.get());
 
     mPluginSettings->mMaxGPUTilesColor.connect([](uint32_t /*val*/) {
       logger().warn("Changing the maximum number of allocated color tiles at run-time is not "
@@ -505,6 +604,16 @@ void Plugin::onLoad() {
       logger().warn("Changing the tile resolution at run-time is not supported. Please restart "
                     "CosmoScout VR!");
     });
+
+    mPluginSettings->mCompressTiles.connect([](bool /*val*/) {
+      logger().warn("Changing the tile compression at run-time is not supported. Please restart "
+                    "CosmoScout VR!");
+    });
+
+    mPluginSettings->mSparseTiles.connect([](bool /*val*/) {
+      logger().warn("Changing the sparse tile storage at run-time is not supported. Please "
+                    "restart CosmoScout VR!");
+    });
   }
 
   // First try to re-configure existing lodBodies. We assume that they are similar if they have
@@ -535,8 +644,8 @@ void Plugin::onLoad() {
       continue;
     }
 
-    auto body = std::make_shared<LodBody>(
-        mAllSettings, mGraphicsEngine, mSolarSystem, mPluginSettings, mGuiManager, mGLResources);
+    auto body = std::make_shared<LodBody>(mAllSettings, mGraphicsEngine, mSolarSystem,
+        mPluginSettings, mGuiManager, mGLResources, mTimeBudget);
 
     body->setObjectName(settings.first);
 
@@ -595,12 +704,8 @@ void Plugin::setImageSource(std::shared_ptr<LodBody> const& body, std::string co
 
     settings.mActiveImgDataset = dataset->first;
 
-    auto source =
-        std::make_shared<TileSourceWebMapService>(mPluginSettings->mTileResolutionIMG.get());
-    source->setCacheDirectory(mPluginSettings->mMapCache.get());
-    source->setLayers(dataset->second.mLayers);
-    source->setUrl(dataset->second.mURL);
-    source->setDataType(TileDataType::eColor);
+    auto source = createTileSource(*mPluginSettings, dataset->second, TileDataType::eColor,
+        mPluginSettings->mTileResolutionIMG.get());
 
     body->setIMGtileSource(source, dataset->second.mMaxLevel);
 
@@ -625,12 +730,8 @@ void Plugin::setElevationSource(
 
   settings.mActiveDemDataset = dataset->first;
 
-  auto source =
-      std::make_shared<TileSourceWebMapService>(mPluginSettings->mTileResolutionDEM.get());
-  source->setCacheDirectory(mPluginSettings->mMapCache.get());
-  source->setLayers(dataset->second.mLayers);
-  source->setUrl(dataset->second.mURL);
-  source->setDataType(TileDataType::eElevation);
+  auto source = createTileSource(*mPluginSettings, dataset->second, TileDataType::eElevation,
+      mPluginSettings->mTileResolutionDEM.get());
 
   body->setDEMtileSource(source, dataset->second.mMaxLevel);
 
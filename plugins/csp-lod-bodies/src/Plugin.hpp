@@ -12,9 +12,12 @@
 #include "../../../src/cs-utils/DefaultProperty.hpp"
 
 #include "TileDataType.hpp"
+#include "TileSourceGeoTiff.hpp"
 #include "TileSourceWebMapService.hpp"
+#include "TimeBudget.hpp"
 
 #include <glm/gtc/constants.hpp>
+#include <optional>
 #include <vector>
 
 class VistaOpenGLNode;
@@ -50,7 +53,8 @@ class Plugin : public cs::core::PluginBase {
     cs::utils::DefaultProperty<glm::vec2> mAutoLODRange{glm::vec2(10.F, 40.F)};
 
     /// The plugin will attempt to adjust the level-of-detail in such a way that the frame time
-    /// stays between these values.
+    /// stays between these values. If the enableDynamicQuality graphics setting is enabled, this
+    /// is not used. The level-of-detail then follows the dynamic quality of the GraphicsEngine.
     cs::utils::DefaultProperty<glm::vec2> mAutoLODFrameTimeRange{glm::vec2(13.5F, 14.5F)};
 
     /// A multiplier for the brightness of the image channel.
@@ -103,9 +107,53 @@ class Plugin : public cs::core::PluginBase {
     /// The image channel resolution used for the tile textures.
     cs::utils::DefaultProperty<uint32_t> mTileResolutionIMG{512};
 
+    /// If set to true, color tiles are stored on the GPU compressed to BC1 and elevation tiles are
+    /// quantized to 16 bit. This reduces the GPU memory of the color tiles by a factor of eight and
+    /// of the elevation tiles by a factor of two, so that mMaxGPUTilesColor and mMaxGPUTilesDEM
+    /// can be increased accordingly. The tiles are stored in the same format in the tile caches,
+    /// which halves the size of the elevation tiles there and decodes them without libtiff.
+    cs::utils::DefaultProperty<bool> mCompressTiles{false};
+
+    /// If set to true and GL_ARB_sparse_texture is supported, the tile array textures only reserve
+    /// address space. GPU memory is committed for each tile when it is uploaded and decommitted
+    /// when it is released. The number of tiles on the GPU is then limited by the GPU memory
+    /// budget instead of mMaxGPUTilesColor and mMaxGPUTilesDEM.
+    cs::utils::DefaultProperty<bool> mSparseTiles{false};
+
     /// Path to the map cache folder, can be absolute or relative to the cosmoscout executable.
     cs::utils::DefaultProperty<std::string> mMapCache{"map-cache"};
 
+    /// If set to a value larger than zero, decoded tiles are stored in single-file caches in the
+    /// map cache folder instead of one file per tile. Loading a tile from there requires no image
+    /// decoding at all. This is the maximum size in megabytes of each of these files; there is one
+    /// for each tile resolution and data type.
+    cs::utils::DefaultProperty<uint32_t> mTileCacheSize{1024};
+
+    /// Tiles which will be required in this many seconds are requested with a lower priority
+    /// ahead of time. The required tiles are predicted from the running observer animation or by
+    /// extrapolating the current observer velocity. Set to zero to disable prefetching.
+    cs::utils::DefaultProperty<float> mPrefetchTime{3.F};
+
+    /// The maximum amount of memory in megabytes which each body may use for tile data in main
+    /// memory. Unused tiles are recycled within this budget. If it is exhausted, no further tiles
+    /// are loaded until others have been pruned. Set to zero to disable the limit.
+    cs::utils::DefaultProperty<uint32_t> mTileMemoryBudget{1024};
+
+    /// The frame rate in Hz which should be maintained while tiles are loaded. The time spent on
+    /// merging and uploading tiles and on recomputing tile bounds is adapted each frame, so that
+    /// the measured frame time approaches the frame time of this rate.
+    cs::utils::DefaultProperty<float> mTargetFrameRate{60.F};
+
+    /// The time in milliseconds per frame which is spent on merging and uploading tiles and on
+    /// recomputing tile bounds of all bodies stays in this range. The lower bound ensures that
+    /// tiles are still loaded if the target frame rate cannot be reached.
+    cs::utils::DefaultProperty<glm::vec2> mTileUpdateTimeRange{glm::vec2(0.5F, 4.F)};
+
+    /// If enabled, pointer rays starting at the eye are intersected with the bodies by reading the
+    /// depth buffer of the previous frame. This has a constant cost but one frame of latency. All
+    /// other rays are still intersected with the tiles on the CPU.
+    cs::utils::DefaultProperty<bool> mEnableDepthPicking{false};
+
     /// A struct that represents a BRDF, given its source code and material properties.
     struct BRDF {
       std::string source; ///< The source code of the BRDF in GLSL-like form.
@@ -125,6 +173,10 @@ class Plugin : public cs::core::PluginBase {
       std::string mCopyright;  ///< The copyright holder of the data set (also shown in the UI).
       std::string mLayers;     ///< A comma,seperated list of WMS layers.
       uint32_t    mMaxLevel{}; ///< The maximum quadtree depth to load.
+
+      /// If set, the data is read from this GeoTIFF file or http(s) URL instead of a web map
+      /// service. In this case, mURL and mLayers are ignored.
+      std::optional<std::string> mFile;
     };
 
     /// The startup settings for a planet.
@@ -149,6 +201,9 @@ class Plugin : public cs::core::PluginBase {
   void deInit() override;
   void update() override;
 
+  /// Returns true as long as any body has pending tiles.
+  bool getIsLoading() const override;
+
  private:
   void onLoad();
   void onSave();
@@ -160,6 +215,7 @@ class Plugin : public cs::core::PluginBase {
 
   std::shared_ptr<Settings>                       mPluginSettings = std::make_shared<Settings>();
   std::shared_ptr<GLResources>                    mGLResources;
+  std::shared_ptr<TimeBudget>                     mTimeBudget = std::make_shared<TimeBudget>();
   std::map<std::string, std::shared_ptr<LodBody>> mLodBodies;
   float                                           mNonAutoLod{};
 
@@ -168,6 +224,10 @@ class Plugin : public cs::core::PluginBase {
   int mOnSaveConnection       = -1;
 };
 
+/// These are also used by the tile-cache-seeder tool to read the settings of the plugin.
+void from_json(nlohmann::json const& j, Plugin::Settings& o);
+void to_json(nlohmann::json& j, Plugin::Settings const& o);
+
 } // namespace csp::lodbodies
 
 #endif // CSP_LOD_BODIES_PLUGIN_HPP
@@ -7,6 +7,7 @@
 
 #include "TerrainShader.hpp"
 
+#include "../../../src/cs-graphics/ShaderCache.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
@@ -32,36 +33,39 @@ void TerrainShader::bind() {
     mShaderDirty = false;
   }
 
-  mShader.Bind();
+  mShader->Bind();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TerrainShader::release() {
-  mShader.Release();
+  mShader->Release();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TerrainShader::compile() {
-  cs::utils::replaceString(mVertexSource, "$VP_TERRAIN_SHADER_FUNCTIONS",
+  injectTerrainFunctions(mVertexSource, mFragmentSource);
+  mShader = cs::graphics::ShaderCache::get().getShader(mVertexSource, mFragmentSource);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TerrainShader::injectTerrainFunctions(std::string& vertexSource, std::string& fragmentSource) {
+  cs::utils::replaceString(vertexSource, "$VP_TERRAIN_SHADER_FUNCTIONS",
       cs::utils::filesystem::loadToString(
           "../share/resources/shaders/VistaPlanetTerrainShaderFunctions.vert"));
-  cs::utils::replaceString(mVertexSource, "$VP_TERRAIN_SHADER_UNIFORMS",
-      cs::utils::filesystem::loadToString(
-          "../share/resources/shaders/VistaPlanetTerrainShaderUniforms.glsl"));
+  cs::utils::replaceString(vertexSource, "$VP_TERRAIN_SHADER_UNIFORMS",
+      "#define VP_VERTEX_SHADER\n" +
+          cs::utils::filesystem::loadToString(
+              "../share/resources/shaders/VistaPlanetTerrainShaderUniforms.glsl"));
 
-  cs::utils::replaceString(mFragmentSource, "$VP_TERRAIN_SHADER_FUNCTIONS",
+  cs::utils::replaceString(fragmentSource, "$VP_TERRAIN_SHADER_FUNCTIONS",
       cs::utils::filesystem::loadToString(
           "../share/resources/shaders/VistaPlanetTerrainShaderFunctions.frag"));
-  cs::utils::replaceString(mFragmentSource, "$VP_TERRAIN_SHADER_UNIFORMS",
+  cs::utils::replaceString(fragmentSource, "$VP_TERRAIN_SHADER_UNIFORMS",
       cs::utils::filesystem::loadToString(
           "../share/resources/shaders/VistaPlanetTerrainShaderUniforms.glsl"));
-
-  mShader = VistaGLSLShader();
-  mShader.InitVertexShaderFromString(mVertexSource);
-  mShader.InitFragmentShaderFromString(mFragmentSource);
-  mShader.Link();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
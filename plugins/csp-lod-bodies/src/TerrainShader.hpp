@@ -16,6 +16,8 @@
 namespace csp::lodbodies {
 
 /// The base class for the PlanetShader. It builds the shader from various sources and links it.
+/// The linked programs are taken from the cs::graphics::ShaderCache, so switching back to a
+/// previously used combination of sources does not require any compilation.
 class TerrainShader {
  public:
   TerrainShader() = default;
@@ -37,10 +39,13 @@ class TerrainShader {
  protected:
   virtual void compile();
 
-  bool            mShaderDirty = true;
-  std::string     mVertexSource;
-  std::string     mFragmentSource;
-  VistaGLSLShader mShader;
+  /// Replaces the placeholders for the shared terrain shader functions and uniforms.
+  static void injectTerrainFunctions(std::string& vertexSource, std::string& fragmentSource);
+
+  bool                             mShaderDirty = true;
+  std::string                      mVertexSource;
+  std::string                      mFragmentSource;
+  std::shared_ptr<VistaGLSLShader> mShader;
 };
 
 } // namespace csp::lodbodies
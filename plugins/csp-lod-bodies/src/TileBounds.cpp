@@ -7,21 +7,19 @@
 
 #include "TileBounds.hpp"
 
-#include "../../../src/cs-utils/convert.hpp"
-#include "HEALPix.hpp"
+#include <limits>
 
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-BoundingBox<double> calcTileBounds(double tmin, double tmax, int tileLevel, glm::int64 patchIdx,
-    glm::dvec3 const& radii, double heightScale) {
+BoundingBox<double> calcTileBounds(
+    double tmin, double tmax, HEALPixCache::Patch const& patch, double heightScale) {
   BoundingBox<double> result;
 
   // min/max elevation of tile, adjusted for heightScale
-  double const        tMin = heightScale * tmin;
-  double const        tMax = heightScale * tmax;
-  HEALPixLevel const& hp   = HEALPix::getLevel(tileLevel);
+  double const tMin = heightScale * tmin;
+  double const tMax = heightScale * tmax;
 
   // min/max corner of the tile's bounding box
   glm::dvec3 bbMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
@@ -33,46 +31,28 @@ BoundingBox<double> calcTileBounds(double tmin, double tmax, int tileLevel, glm:
   // surface in the 4 corners, center of the tile, and center of the edges
   // as if the surface elevation takes the min/max value at those locations.
   // Then take componentwise min/max to get the axis aligned box.
-  glm::dvec2 center = hp.getCenterLngLat(patchIdx);
-
-  // tile center
-  {
-    // lowest/highest point at the center
-    glm::dvec3 pMin(cs::utils::convert::toCartesian(center, radii, tMin));
-    glm::dvec3 pMax(cs::utils::convert::toCartesian(center, radii, tMax));
+  auto addPoint = [&](HEALPixCache::SurfacePoint const& point) {
+    // lowest/highest point at this location
+    glm::dvec3 pMin(point.mPosition + point.mNormal * tMin);
+    glm::dvec3 pMax(point.mPosition + point.mNormal * tMax);
 
     bbMin = glm::min(bbMin, pMin);
     bbMin = glm::min(bbMin, pMax);
     bbMax = glm::max(bbMax, pMin);
     bbMax = glm::max(bbMax, pMax);
-  }
-
-  // tile corners
-  auto corners = hp.getCornersLngLat(patchIdx);
+  };
 
-  for (auto const& corner : corners) {
-    // lowest/highest point at corner
-    glm::dvec3 pMin(cs::utils::convert::toCartesian(corner, radii, tMin));
-    glm::dvec3 pMax(cs::utils::convert::toCartesian(corner, radii, tMax));
+  // tile center
+  addPoint(patch.mCenter);
 
-    bbMin = glm::min(bbMin, pMin);
-    bbMin = glm::min(bbMin, pMax);
-    bbMax = glm::max(bbMax, pMin);
-    bbMax = glm::max(bbMax, pMax);
+  // tile corners
+  for (auto const& corner : patch.mCorners) {
+    addPoint(corner);
   }
 
   // tile edge center points
-  auto edges = hp.getEdgeCentersLngLat(patchIdx);
-
-  for (auto const& edge : edges) {
-    // lowest/highest point at edge center
-    glm::dvec3 pMin(cs::utils::convert::toCartesian(edge, radii, tMin));
-    glm::dvec3 pMax(cs::utils::convert::toCartesian(edge, radii, tMax));
-
-    bbMin = glm::min(bbMin, pMin);
-    bbMin = glm::min(bbMin, pMax);
-    bbMax = glm::max(bbMax, pMin);
-    bbMax = glm::max(bbMax, pMax);
+  for (auto const& edge : patch.mEdgeCenters) {
+    addPoint(edge);
   }
 
   // store results
@@ -84,17 +64,15 @@ BoundingBox<double> calcTileBounds(double tmin, double tmax, int tileLevel, glm:
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Returns the bounds of @a tile for a planet of the given equatorial radius
-// @a radiusE and polar radius @a radiusP
+// Returns the bounds of @a tile for a planet with the radii of @a cache and the given
 // @a heightScale.
 // @note Assumes that @a tile stores elevation data (i.e. a single scalar) and
 // has valid min/max values set.
-BoundingBox<double> calcTileBounds(
-    TileNode const& tile, glm::dvec3 const& radii, double heightScale) {
+BoundingBox<double> calcTileBounds(TileNode const& tile, HEALPixCache& cache, double heightScale) {
 
   if (tile.getMinMaxPyramid()) {
     return calcTileBounds(tile.getMinMaxPyramid()->getMin(), tile.getMinMaxPyramid()->getMax(),
-        tile.getLevel(), tile.getPatchIdx(), radii, heightScale);
+        cache.getPatch(tile.getTileId()), heightScale);
   }
 
   return BoundingBox<double>();
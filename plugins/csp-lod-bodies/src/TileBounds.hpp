@@ -9,19 +9,18 @@
 #define CSP_LOD_BODIES_TILEBOUNDS_HPP
 
 #include "BoundingBox.hpp"
+#include "HEALPixCache.hpp"
 #include "TileNode.hpp"
 
 namespace csp::lodbodies {
 
-/// Returns the bounds of tile for a planet of the given equatorial radius radiusE, polar radius
-/// radiusP, and heightScale.
+/// Returns the bounds of tile for a planet with the radii of the given cache and heightScale.
 ///
 /// Assumes that tile stores elevation data (i.e. a single scalar) and has valid min/max values set.
-BoundingBox<double> calcTileBounds(
-    TileNode const& tile, glm::dvec3 const& radii, double heightScale);
+BoundingBox<double> calcTileBounds(TileNode const& tile, HEALPixCache& cache, double heightScale);
 
-BoundingBox<double> calcTileBounds(double tmin, double tmax, int tileLevel, glm::int64 patchIdx,
-    glm::dvec3 const& radii, double heightScale);
+BoundingBox<double> calcTileBounds(
+    double tmin, double tmax, HEALPixCache::Patch const& patch, double heightScale);
 } // namespace csp::lodbodies
 
 #endif // CSP_LOD_BODIES_TILEBOUNDS_HPP
@@ -0,0 +1,271 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TileCache.hpp"
+
+#include "logger.hpp"
+
+#include "../../../src/cs-utils/Metrics.hpp"
+#include "../../../src/cs-utils/filesystem.hpp"
+
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The file starts with this header. The format version has to be incremented whenever the layout
+// of the file or the layout of the stored payloads changes.
+struct Header {
+  uint64_t mMagic;
+  uint64_t mVersion;
+  uint64_t mPayloadSize;
+  uint64_t mSlotCount;
+};
+
+uint64_t const    fileMagic   = 0x4548434143505343; // "CSPCACHE"
+uint64_t const    fileVersion = 1;
+std::size_t const headerSize  = 64;
+std::size_t const pageSize    = 4096;
+
+// The hit rate of all tile caches is published to the Metrics.
+cs::utils::Metrics::Sample& getCacheHits() {
+  static auto& sample = cs::utils::Metrics::get().getSample("cosmoscout_tile_cache_hits_total",
+      cs::utils::Metrics::Type::eCounter, "The number of tiles which were read from a TileCache.");
+  return sample;
+}
+
+cs::utils::Metrics::Sample& getCacheMisses() {
+  static auto& sample = cs::utils::Metrics::get().getSample("cosmoscout_tile_cache_misses_total",
+      cs::utils::Metrics::Type::eCounter, "The number of tiles which were not in a TileCache.");
+  return sample;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// 64-bit FNV-1a. In contrast to std::hash, this is guaranteed to be the same on all platforms.
+uint64_t hash(void const* data, std::size_t size, uint64_t seed = 0xcbf29ce484222325) {
+  auto const* bytes = static_cast<unsigned char const*>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    seed ^= bytes[i];      // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    seed *= 0x100000001b3; // NOLINT(readability-magic-numbers)
+  }
+  return seed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TileCache> TileCache::get(
+    std::string const& directory, std::size_t payloadSize, std::size_t budget) {
+  static std::mutex                                       mutex;
+  static std::map<std::string, std::weak_ptr<TileCache>> caches;
+
+  std::string file = directory + "/tiles-" + std::to_string(payloadSize) + ".cache";
+
+  std::unique_lock<std::mutex> lock(mutex);
+
+  auto cache = caches[file].lock();
+
+  if (!cache) {
+    cs::utils::filesystem::createDirectoryRecursively(
+        boost::filesystem::absolute(directory), boost::filesystem::perms::all_all);
+    cache        = std::make_shared<TileCache>(file, payloadSize, budget);
+    caches[file] = cache;
+  }
+
+  return cache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TileCache::getKey(TileId const& tileId, TileDataType type, uint32_t resolution,
+    std::string const& url, std::string const& layers) {
+  int        level    = tileId.level();
+  glm::int64 patchIdx = tileId.patchIdx();
+
+  uint64_t key = hash(url.data(), url.size());
+  key          = hash(layers.data(), layers.size(), key);
+  key          = hash(&type, sizeof(type), key);
+  key          = hash(&resolution, sizeof(resolution), key);
+  key          = hash(&level, sizeof(level), key);
+  key          = hash(&patchIdx, sizeof(patchIdx), key);
+
+  // Zero marks empty slots.
+  return key == 0 ? 1 : key;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileCache::TileCache(std::string const& file, std::size_t payloadSize, std::size_t budget)
+    : mFile(file)
+    , mPayloadSize(payloadSize)
+    , mSlotCount(std::max<std::size_t>(budget / payloadSize, 1)) {
+
+  // The payloads start at the first page boundary after the index.
+  std::size_t indexSize = headerSize + mSlotCount * sizeof(uint64_t);
+  mPayloadOffset        = (indexSize + pageSize - 1) / pageSize * pageSize;
+
+  std::size_t fileSize = mPayloadOffset + mSlotCount * mPayloadSize;
+
+  // Check whether there is a compatible cache file already.
+  bool valid = false;
+
+  if (boost::filesystem::exists(mFile) && boost::filesystem::file_size(mFile) == fileSize) {
+    Header        header{};
+    std::ifstream in(mFile, std::ifstream::binary);
+    in.read(reinterpret_cast<char*>(&header), sizeof(Header));
+
+    valid = in && header.mMagic == fileMagic && header.mVersion == fileVersion &&
+            header.mPayloadSize == mPayloadSize && header.mSlotCount == mSlotCount;
+  }
+
+  // Else create a new one. On most file systems, the resized file will be sparse, so it does not
+  // occupy the entire budget right away.
+  if (!valid) {
+    logger().info("Creating tile cache '{}' with {} slots.", mFile, mSlotCount);
+
+    {
+      std::ofstream out(mFile, std::ofstream::binary | std::ofstream::trunc);
+      Header        header{fileMagic, fileVersion, mPayloadSize, mSlotCount};
+      out.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+
+      if (!out) {
+        throw std::runtime_error(fmt::format("Failed to create tile cache '{}'!", mFile));
+      }
+    }
+
+    boost::filesystem::resize_file(mFile, fileSize);
+  }
+
+  mMapping = boost::interprocess::file_mapping(mFile.c_str(), boost::interprocess::read_write);
+  mRegion  = boost::interprocess::mapped_region(mMapping, boost::interprocess::read_write);
+
+  auto* base = static_cast<char*>(mRegion.get_address());
+  mKeys      = reinterpret_cast<uint64_t*>(base + headerSize); // NOLINT
+  mPayloads  = base + mPayloadOffset;                          // NOLINT
+
+  // Build the in-memory index. Empty slots are put at the back of the LRU list so that they are
+  // used first.
+  mLRUPositions.resize(mSlotCount);
+
+  for (uint32_t i = 0; i < mSlotCount; ++i) {
+    uint64_t key = mKeys[i]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    if (key != 0) {
+      mSlots[key]      = i;
+      mLRUPositions[i] = mLRU.insert(mLRU.begin(), i);
+    } else {
+      mLRUPositions[i] = mLRU.insert(mLRU.end(), i);
+    }
+  }
+
+  if (valid) {
+    logger().info("Opened tile cache '{}' with {} of {} slots occupied.", mFile, mSlots.size(),
+        mSlotCount);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileCache::~TileCache() {
+  mRegion.flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileCache::read(uint64_t key, std::function<void(void const*)> const& reader) {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+
+  auto it = mSlots.find(key);
+  if (it == mSlots.end()) {
+    getCacheMisses().add(1.0);
+    return false;
+  }
+
+  getCacheHits().add(1.0);
+  touch(it->second);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  reader(mPayloads + static_cast<std::size_t>(it->second) * mPayloadSize);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileCache::contains(uint64_t key) {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mSlots.find(key) != mSlots.end();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileCache::write(uint64_t key, void const* payload) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+
+  uint32_t slot{};
+
+  auto it = mSlots.find(key);
+  if (it != mSlots.end()) {
+    slot = it->second;
+  } else {
+    {
+      std::unique_lock<std::mutex> lruLock(mLRUMutex);
+      slot = mLRU.back();
+    }
+
+    // Evict the previous payload. The key is cleared before the payload is overwritten so that
+    // the file remains consistent if the application is terminated in between.
+    uint64_t& oldKey = mKeys[slot]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (oldKey != 0) {
+      mSlots.erase(oldKey);
+      oldKey = 0;
+    }
+
+    mSlots[key] = slot;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(mPayloads + static_cast<std::size_t>(slot) * mPayloadSize, payload, mPayloadSize);
+  mKeys[slot] = key; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  touch(slot);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileCache::getPayloadSize() const {
+  return mPayloadSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileCache::getSlotCount() const {
+  return mSlotCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileCache::touch(uint32_t slot) {
+  std::unique_lock<std::mutex> lock(mLRUMutex);
+  mLRU.splice(mLRU.begin(), mLRU, mLRUPositions[slot]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
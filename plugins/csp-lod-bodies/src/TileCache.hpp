@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILECACHE_HPP
+#define CSP_LOD_BODIES_TILECACHE_HPP
+
+#include "TileDataType.hpp"
+#include "TileId.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// The TileCache stores the decoded payload of many tiles in one single, memory-mapped file. As
+/// all tiles of one TileSource have the same size, the file is divided into fixed-size slots. The
+/// start of the file contains an index which maps a 64-bit key (see getKey()) to each occupied
+/// slot. Once all slots are occupied, the least recently used slot is overwritten.
+///
+/// Compared to storing each tile in a separate file, this avoids creating millions of files and
+/// lookups do not require any file system access. Any number of threads can read from the cache
+/// concurrently; writing requires exclusive access for a short moment.
+///
+/// If the payload size or the number of slots of an existing file do not match the parameters
+/// given to the constructor, the file is discarded and a new, empty cache is created.
+class TileCache {
+ public:
+  /// Returns a cache for payloads of the given size in bytes which is stored in the given
+  /// directory. All callers using the same directory and payload size share one instance. The
+  /// budget is the maximum size of the file in bytes; it is only used when the cache is created
+  /// for the first time in this session. May throw a std::exception if the cache file cannot be
+  /// created.
+  static std::shared_ptr<TileCache> get(
+      std::string const& directory, std::size_t payloadSize, std::size_t budget);
+
+  /// Computes a key for the given tile. The key is stable across sessions and platforms.
+  static uint64_t getKey(TileId const& tileId, TileDataType type, uint32_t resolution,
+      std::string const& url, std::string const& layers);
+
+  /// Opens or creates the given file. May throw a std::exception if this fails.
+  TileCache(std::string const& file, std::size_t payloadSize, std::size_t budget);
+
+  TileCache(TileCache const& other) = delete;
+  TileCache(TileCache&& other)      = delete;
+
+  TileCache& operator=(TileCache const& other) = delete;
+  TileCache& operator=(TileCache&& other) = delete;
+
+  ~TileCache();
+
+  /// If a payload is stored for the given key, the given function is called with a pointer to it
+  /// and true is returned. The pointer points directly into the memory-mapped file and is only
+  /// valid during the call, so no additional copy is made.
+  bool read(uint64_t key, std::function<void(void const*)> const& reader);
+
+  /// Returns true if a payload is stored for the given key. In contrast to read(), this neither
+  /// counts as a cache hit nor marks the payload as recently used.
+  bool contains(uint64_t key);
+
+  /// Stores a copy of the given payload, which has to be getPayloadSize() bytes large. If there is
+  /// no free slot, the least recently used payload will be evicted.
+  void write(uint64_t key, void const* payload);
+
+  std::size_t getPayloadSize() const;
+  std::size_t getSlotCount() const;
+
+ private:
+  void touch(uint32_t slot);
+
+  std::string mFile;
+  std::size_t mPayloadSize;
+  std::size_t mSlotCount;
+  std::size_t mPayloadOffset;
+
+  boost::interprocess::file_mapping  mMapping;
+  boost::interprocess::mapped_region mRegion;
+
+  // These point into mRegion.
+  uint64_t* mKeys{};
+  char*     mPayloads{};
+
+  // Maps keys to slot indices.
+  std::unordered_map<uint64_t, uint32_t> mSlots;
+  std::shared_mutex                      mMutex;
+
+  // All slots in least-recently-used order, the most recently used slot is at the front. As
+  // readers only hold a shared lock on mMutex, the list is guarded by a separate mutex.
+  std::list<uint32_t>                        mLRU;
+  std::vector<std::list<uint32_t>::iterator> mLRUPositions;
+  std::mutex                                 mLRUMutex;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILECACHE_HPP
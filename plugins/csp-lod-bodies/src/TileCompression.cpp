@@ -0,0 +1,280 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TileCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace csp::lodbodies::compression {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// each block covers 4x4 pixels and is stored in eight bytes
+uint32_t const blockSize  = 4;
+uint32_t const blockBytes = 8;
+
+// the number of power iterations used for finding the principal axis of the colors of a block
+int const powerIterations = 4;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t getBlockCount(uint32_t resolution) {
+  return (resolution + blockSize - 1) / blockSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint16_t toRGB565(glm::vec3 const& color) {
+  glm::vec3  scaled = glm::clamp(color, 0.F, 255.F) * glm::vec3(31.F, 63.F, 31.F) / 255.F;
+  glm::uvec3 c(glm::round(scaled));
+  return static_cast<uint16_t>((c.r << 11U) | (c.g << 5U) | c.b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 fromRGB565(uint16_t color) {
+  uint32_t r = (color >> 11U) & 31U;
+  uint32_t g = (color >> 5U) & 63U;
+  uint32_t b = color & 31U;
+
+  // Replicate the upper bits so that 31 and 63 map to 255.
+  return glm::vec3((r << 3U) | (r >> 2U), (g << 2U) | (g >> 4U), (b << 3U) | (b >> 2U));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the four colors which can be represented by a block with the given end points. If c0 is
+// not larger than c1, the block uses the three-color mode and the last color is black.
+std::array<glm::vec3, 4> getPalette(uint16_t c0, uint16_t c1) {
+  glm::vec3 p0 = fromRGB565(c0);
+  glm::vec3 p1 = fromRGB565(c1);
+
+  if (c0 > c1) {
+    return {p0, p1, (2.F * p0 + p1) / 3.F, (p0 + 2.F * p1) / 3.F};
+  }
+
+  return {p0, p1, (p0 + p1) * 0.5F, glm::vec3(0.F)};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void encodeBlock(std::array<glm::vec3, 16> const& colors, uint8_t* block) {
+  glm::vec3 mean(0.F);
+  for (auto const& c : colors) {
+    mean += c;
+  }
+  mean /= 16.F;
+
+  // The covariance matrix is symmetric.
+  glm::mat3 covariance(0.F);
+  for (auto const& c : colors) {
+    glm::vec3 d = c - mean;
+    covariance += glm::outerProduct(d, d);
+  }
+
+  // Find the principal axis with a few power iterations. Starting at the luminance axis works well
+  // for most natural images.
+  glm::vec3 axis = glm::normalize(glm::vec3(1.F));
+  for (int i = 0; i < powerIterations; ++i) {
+    glm::vec3 next = covariance * axis;
+    float     len  = glm::length(next);
+
+    if (len < 1e-6F) {
+      break;
+    }
+
+    axis = next / len;
+  }
+
+  float minT = 0.F;
+  float maxT = 0.F;
+  for (auto const& c : colors) {
+    float t = glm::dot(c - mean, axis);
+    minT    = std::min(minT, t);
+    maxT    = std::max(maxT, t);
+  }
+
+  uint16_t c0 = toRGB565(mean + axis * maxT);
+  uint16_t c1 = toRGB565(mean + axis * minT);
+
+  // The four-color mode requires c0 to be larger.
+  if (c0 < c1) {
+    std::swap(c0, c1);
+  }
+
+  uint32_t indices = 0;
+
+  // Else the block is uniform and all indices refer to c0.
+  if (c0 != c1) {
+    auto palette = getPalette(c0, c1);
+
+    for (uint32_t i = 0; i < 16; ++i) {
+      uint32_t best         = 0;
+      float    bestDistance = std::numeric_limits<float>::max();
+
+      for (uint32_t j = 0; j < 4; ++j) {
+        glm::vec3 d        = colors.at(i) - palette.at(j);
+        float     distance = glm::dot(d, d);
+
+        if (distance < bestDistance) {
+          best         = j;
+          bestDistance = distance;
+        }
+      }
+
+      indices |= best << (2U * i);
+    }
+  }
+
+  // All values are stored in little-endian order.
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  block[0] = static_cast<uint8_t>(c0 & 0xFFU);
+  block[1] = static_cast<uint8_t>(c0 >> 8U);
+  block[2] = static_cast<uint8_t>(c1 & 0xFFU);
+  block[3] = static_cast<uint8_t>(c1 >> 8U);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    block[4 + i] = static_cast<uint8_t>((indices >> (8U * i)) & 0xFFU);
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t getBC1Size(uint32_t resolution) {
+  std::size_t blocks = getBlockCount(resolution);
+  return blocks * blocks * blockBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void encodeBC1(glm::u8vec4 const* pixels, uint32_t resolution, uint8_t* blocks) {
+  uint32_t                  blockCount = getBlockCount(resolution);
+  std::array<glm::vec3, 16> colors{};
+
+  for (uint32_t by = 0; by < blockCount; ++by) {
+    for (uint32_t bx = 0; bx < blockCount; ++bx) {
+      for (uint32_t i = 0; i < 16; ++i) {
+        uint32_t x = std::min(bx * blockSize + i % blockSize, resolution - 1);
+        uint32_t y = std::min(by * blockSize + i / blockSize, resolution - 1);
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        colors.at(i) = glm::vec3(pixels[y * resolution + x]);
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      encodeBlock(colors, blocks + (by * blockCount + bx) * blockBytes);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void decodeBC1(uint8_t const* blocks, uint32_t resolution, glm::u8vec4* pixels) {
+  uint32_t blockCount = getBlockCount(resolution);
+
+  for (uint32_t by = 0; by < blockCount; ++by) {
+    for (uint32_t bx = 0; bx < blockCount; ++bx) {
+      // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      uint8_t const* block = blocks + (by * blockCount + bx) * blockBytes;
+
+      auto c0 = static_cast<uint16_t>(block[0] | (block[1] << 8U));
+      auto c1 = static_cast<uint16_t>(block[2] | (block[3] << 8U));
+
+      uint32_t indices = block[4] | (block[5] << 8U) | (block[6] << 16U) |
+                         (static_cast<uint32_t>(block[7]) << 24U);
+      // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+      auto palette = getPalette(c0, c1);
+
+      for (uint32_t i = 0; i < 16; ++i) {
+        uint32_t x = bx * blockSize + i % blockSize;
+        uint32_t y = by * blockSize + i / blockSize;
+
+        if (x < resolution && y < resolution) {
+          glm::vec3 color = palette.at((indices >> (2U * i)) & 3U);
+
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+          pixels[y * resolution + x] = glm::u8vec4(glm::round(color), 255);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void quantizeHeights(
+    float const* heights, std::size_t count, float minHeight, float maxHeight, uint16_t* values) {
+  float range = maxHeight - minHeight;
+  float scale = range > 0.F ? 65535.F / range : 0.F;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    float value = std::round((heights[i] - minHeight) * scale);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    values[i] = static_cast<uint16_t>(std::clamp(value, 0.F, 65535.F));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t getEncodedHeightsSize(uint32_t resolution) {
+  return 2 * sizeof(float) + static_cast<std::size_t>(resolution) * resolution * sizeof(uint16_t);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void encodeHeights(float const* heights, uint32_t resolution, uint8_t* data) {
+  std::size_t const count = static_cast<std::size_t>(resolution) * resolution;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto [minHeight, maxHeight] = std::minmax_element(heights, heights + count);
+
+  std::array<float, 2> range{*minHeight, *maxHeight};
+  std::memcpy(data, range.data(), sizeof(range));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  quantizeHeights(heights, count, range[0], range[1], reinterpret_cast<uint16_t*>(data + 8));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void decodeHeights(uint8_t const* data, uint32_t resolution, float* heights) {
+  std::size_t const count = static_cast<std::size_t>(resolution) * resolution;
+
+  std::array<float, 2> range{};
+  std::memcpy(range.data(), data, sizeof(range));
+
+  float const offset = range[0];
+  float const scale  = (range[1] - range[0]) / 65535.F;
+
+  // This simple loop is vectorized by the compiler.
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto const* values = reinterpret_cast<uint16_t const*>(data + 8);
+  for (std::size_t i = 0; i < count; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    heights[i] = offset + static_cast<float>(values[i]) * scale;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies::compression
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILECOMPRESSION_HPP
+#define CSP_LOD_BODIES_TILECOMPRESSION_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/// Functions for storing tiles on the GPU and in the TileCache in a more compact format than on the
+/// CPU. Color tiles are compressed to BC1 (also known as DXT1), which requires four bits per pixel
+/// instead of 32. The alpha channel is discarded. Elevation tiles are quantized to 16 bit between
+/// the minimum and the maximum height of the tile, which halves their size.
+namespace csp::lodbodies::compression {
+
+/// Returns the size in bytes of a BC1-compressed tile with the given resolution. If the resolution
+/// is not a multiple of four, the blocks at the border are padded by repeating the last row and
+/// column.
+std::size_t getBC1Size(uint32_t resolution);
+
+/// Compresses resolution x resolution pixels to BC1 blocks. The end points of each block are
+/// chosen along the principal axis of its colors. blocks has to be getBC1Size() bytes large. This
+/// is rather expensive and should be done on the loader threads.
+void encodeBC1(glm::u8vec4 const* pixels, uint32_t resolution, uint8_t* blocks);
+
+/// Decompresses BC1 blocks created with encodeBC1(). The alpha channel will be 255.
+void decodeBC1(uint8_t const* blocks, uint32_t resolution, glm::u8vec4* pixels);
+
+/// Maps all heights linearly from [minHeight, maxHeight] to [0, 65535]. If the range is empty,
+/// all values will be zero.
+void quantizeHeights(
+    float const* heights, std::size_t count, float minHeight, float maxHeight, uint16_t* values);
+
+/// Returns the size in bytes of an elevation tile with the given resolution which has been encoded
+/// with encodeHeights().
+std::size_t getEncodedHeightsSize(uint32_t resolution);
+
+/// Stores the minimum and the maximum height of the tile followed by all heights quantized with
+/// quantizeHeights(). The error of each height is at most (maxHeight - minHeight) / 131070. As the
+/// same range is used as for the GPU, quantizing the decoded heights again yields exactly the same
+/// values. data has to be getEncodedHeightsSize() bytes large.
+void encodeHeights(float const* heights, uint32_t resolution, uint8_t* data);
+
+/// Restores the heights of a tile encoded with encodeHeights().
+void decodeHeights(uint8_t const* data, uint32_t resolution, float* heights);
+
+} // namespace csp::lodbodies::compression
+
+#endif // CSP_LOD_BODIES_TILECOMPRESSION_HPP
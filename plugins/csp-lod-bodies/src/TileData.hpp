@@ -35,11 +35,11 @@ class TileData : public BaseTileData {
   void const* getDataPtr() const override;
   void*       getDataPtr() override;
 
-  std::vector<T> const& data() const;
-  std::vector<T>&       data();
+  std::pmr::vector<T> const& data() const;
+  std::pmr::vector<T>&       data();
 
  private:
-  std::vector<T> mData;
+  std::pmr::vector<T> mData;
 };
 
 namespace detail {
@@ -65,7 +65,7 @@ struct DataTypeTrait<glm::u8vec4> {
 template <typename T>
 TileData<T>::TileData(uint32_t resolution)
     : BaseTileData(resolution)
-    , mData(resolution * resolution) {
+    , mData(resolution * resolution, getMemoryResource()) {
 }
 
 template <typename T>
@@ -92,12 +92,12 @@ void* TileData<T>::getDataPtr() {
 }
 
 template <typename T>
-std::vector<T> const& TileData<T>::data() const {
+std::pmr::vector<T> const& TileData<T>::data() const {
   return mData;
 }
 
 template <typename T>
-std::vector<T>& TileData<T>::data() {
+std::pmr::vector<T>& TileData<T>::data() {
   return mData;
 }
 
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TileGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// minimum number of quads in each direction of decimated levels
+uint32_t const minSegments = 4;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the pixel positions of the vertices along one side of a grid with the given number of
+// segments, including the two skirt vertices. Positions are rounded to the closest pixel, so the
+// positions of a level are a subset of the positions of all finer levels.
+std::vector<uint16_t> getPositions(uint32_t tileResolution, uint32_t segments) {
+  std::vector<uint16_t> positions;
+  positions.reserve(segments + 3);
+  positions.push_back(0);
+
+  for (uint32_t k = 0; k <= segments; ++k) {
+    positions.push_back(
+        static_cast<uint16_t>(1 + (k * (tileResolution - 1) + segments / 2) / segments));
+  }
+
+  positions.push_back(static_cast<uint16_t>(tileResolution + 1));
+
+  return positions;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the position of the vertex of the coarser level which a vertex at the given position
+// collapses into. Collapsing all vertices towards smaller positions reproduces the triangulation
+// of the coarser level, as the triangle strips of all levels split their quads along the same
+// diagonal. Skirt vertices stay in the skirt.
+uint16_t getMorphTarget(std::vector<uint16_t> const& coarsePositions, uint16_t position) {
+  return *(std::upper_bound(coarsePositions.begin(), coarsePositions.end(), position) - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileGrid::TileGrid(uint32_t tileResolution) {
+
+  // The first level uses all pixels. The segment counts of all other levels are powers of two so
+  // that each of them is nested in the previous one.
+  std::vector<uint32_t> segments{tileResolution - 1};
+
+  uint32_t decimated = 1;
+  while (decimated * 2 < tileResolution - 1) {
+    decimated *= 2;
+  }
+
+  for (; decimated >= minSegments; decimated /= 2) {
+    segments.push_back(decimated);
+  }
+
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    // The vertices of the coarsest level collapse into themselves.
+    auto positions = getPositions(tileResolution, segments[i]);
+    auto coarse    = positions;
+
+    if (i + 1 < segments.size()) {
+      coarse = getPositions(tileResolution, segments[i + 1]);
+    }
+
+    auto gridResolution = static_cast<uint32_t>(positions.size());
+    auto firstVertex    = static_cast<uint32_t>(mVertices.size() / 4);
+
+    for (uint32_t x = 0; x < gridResolution; ++x) {
+      for (uint32_t y = 0; y < gridResolution; ++y) {
+        mVertices.push_back(positions[x]);
+        mVertices.push_back(positions[y]);
+        mVertices.push_back(getMorphTarget(coarse, positions[x]));
+        mVertices.push_back(getMorphTarget(coarse, positions[y]));
+      }
+    }
+
+    Level level;
+    level.mFirstIndex = static_cast<uint32_t>(mIndices.size());
+    level.mIndexCount = (gridResolution - 1) * (2 + 2 * gridResolution);
+    level.mSegments   = segments[i];
+
+    // One strip per column, they are connected with degenerate triangles.
+    for (uint32_t x = 0; x < gridResolution - 1; ++x) {
+      mIndices.push_back(firstVertex + x * gridResolution);
+      for (uint32_t y = 0; y < gridResolution; ++y) {
+        mIndices.push_back(firstVertex + x * gridResolution + y);
+        mIndices.push_back(firstVertex + (x + 1) * gridResolution + y);
+      }
+      mIndices.push_back(mIndices.back());
+    }
+
+    mLevels.push_back(level);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint16_t> const& TileGrid::getVertices() const {
+  return mVertices;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> const& TileGrid::getIndices() const {
+  return mIndices;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TileGrid::Level> const& TileGrid::getLevels() const {
+  return mLevels;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileGrid::getLevel(float relativeSize, uint32_t& level, float& morphFactor) const {
+
+  auto lastLevel = static_cast<uint32_t>(mLevels.size() - 1);
+
+  // Tiles of unknown size are drawn with the full resolution.
+  float lod = 0.F;
+  if (relativeSize > 0.F) {
+    lod = std::clamp(-std::log2(relativeSize), 0.F, static_cast<float>(lastLevel));
+  }
+
+  level = static_cast<uint32_t>(lod);
+
+  // The coarsest level cannot be morphed any further.
+  if (level == lastLevel) {
+    morphFactor = 0.F;
+    return;
+  }
+
+  morphFactor = std::clamp(2.F * (lod - static_cast<float>(level)) - 1.F, 0.F, 1.F);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
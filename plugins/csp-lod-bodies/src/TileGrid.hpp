@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILEGRID_HPP
+#define CSP_LOD_BODIES_TILEGRID_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// The vertex grids used for drawing terrain tiles. Level zero contains one vertex for each pixel
+/// of the elevation tiles. Each further level halves the number of vertices in both directions,
+/// so that tiles which are small on screen can be drawn with fewer vertices. All levels have a
+/// skirt around the tile.
+///
+/// The vertices of all levels are stored in one vertex array with four components each: The first
+/// two are the position of the vertex in pixels of the elevation tile, where zero and
+/// tileResolution + 1 are the skirt vertices. The other two are the position of the vertex it
+/// collapses into when the grid is morphed towards the next coarser level. At a morph factor of
+/// one, the grid has the same shape as the next level. Hence switching levels does not cause any
+/// popping.
+///
+/// Each level is drawn as one triangle strip. The indices of all levels are stored in one array,
+/// they refer to absolute positions in the vertex array.
+class TileGrid {
+ public:
+  /// The range of the index array which belongs to one level.
+  struct Level {
+    uint32_t mFirstIndex{};
+    uint32_t mIndexCount{};
+
+    /// The number of quads in each direction, excluding the skirt.
+    uint32_t mSegments{};
+  };
+
+  /// Levels are added until the next one would have less than four segments.
+  explicit TileGrid(uint32_t tileResolution);
+
+  std::vector<uint16_t> const& getVertices() const;
+  std::vector<uint32_t> const& getIndices() const;
+  std::vector<Level> const&    getLevels() const;
+
+  /// Chooses the level and the morph factor for a tile based on its size on screen. The size is
+  /// given relative to the size of the smallest tiles which are drawn with the full resolution.
+  /// Each halving of the size selects the next coarser level. Tiles are morphed towards the next
+  /// coarser level during the second half of this range.
+  void getLevel(float relativeSize, uint32_t& level, float& morphFactor) const;
+
+ private:
+  std::vector<uint16_t> mVertices;
+  std::vector<uint32_t> mIndices;
+  std::vector<Level>    mLevels;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEGRID_HPP
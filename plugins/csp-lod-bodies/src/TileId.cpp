@@ -56,6 +56,14 @@ void TileId::patchIdx(glm::int64 pi) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+uint64_t TileId::key() const {
+  // There are 12 * 4^l tiles on level l, hence 4 * (4^level - 1) tiles on all levels above.
+  uint64_t coarserTiles = 4U * ((uint64_t(1) << (2U * static_cast<uint32_t>(mLevel))) - 1U);
+  return coarserTiles + static_cast<uint64_t>(mPatchIdx);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool isValid(TileId const& tileId) {
   return (tileId.level() >= 0 && tileId.patchIdx() >= 0);
 }
@@ -8,7 +8,7 @@
 #ifndef CSP_LOD_BODIES_TILEID_HPP
 #define CSP_LOD_BODIES_TILEID_HPP
 
-#include <boost/functional/hash/hash.hpp>
+#include <cstdint>
 #include <functional>
 #include <glm/glm.hpp>
 
@@ -29,6 +29,12 @@ class TileId {
   glm::int64 patchIdx() const;
   void       patchIdx(glm::int64 pi);
 
+  /// Returns a number which is unique for each valid tile. It is the patch index plus the number of
+  /// tiles on all coarser levels. As the patch indices follow the nested HEALPix scheme, which
+  /// interleaves the bits of the x and y coordinates within each base patch, the keys of nearby
+  /// tiles on the same level are close to each other.
+  uint64_t key() const;
+
  private:
   glm::int64 mPatchIdx{-1};
   int        mLevel{-1};
@@ -48,11 +54,7 @@ namespace std {
 template <>
 struct hash<csp::lodbodies::TileId> {
   std::size_t operator()(csp::lodbodies::TileId const& tileId) const {
-    std::size_t result = 0;
-    boost::hash_combine(result, tileId.level());
-    boost::hash_combine(result, tileId.patchIdx());
-
-    return result;
+    return static_cast<std::size_t>(tileId.key());
   }
 };
 
@@ -9,10 +9,138 @@
 
 #include "HEALPix.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A free-list allocator which carves TileNodes out of slabs. Each slab only contains nodes of one
+// level, so that nodes which are traversed together also lie close to each other in memory. All
+// slabs are aligned to their size, hence the slab of a node and thereby its level can be found by
+// masking its address when it is freed.
+class NodeAllocator {
+ public:
+  /// Nodes on levels deeper than this share one set of slabs.
+  static constexpr int sMaxLevel = 24;
+
+  void* allocate(int level) {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    auto  index    = static_cast<std::size_t>(std::clamp(level, 0, sMaxLevel));
+    auto& freeList = mFreeLists.at(index);
+
+    if (!freeList) {
+      auto* slab   = static_cast<Slab*>(::operator new(sizeof(Slab), std::align_val_t(sSlabBytes)));
+      slab->mLevel = index;
+
+      // The free list is built backwards so that consecutive allocations are adjacent in memory.
+      for (std::size_t i = sSlotsPerSlab; i > 0; --i) {
+        slab->mSlots[i - 1].mNext = freeList;
+        freeList                  = &slab->mSlots[i - 1];
+      }
+    }
+
+    Slot* slot = freeList;
+    freeList   = slot->mNext;
+    return slot;
+  }
+
+  void deallocate(void* pointer) {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    auto  address  = reinterpret_cast<std::uintptr_t>(pointer);         // NOLINT
+    auto* slab     = reinterpret_cast<Slab*>(address & ~(sSlabBytes - 1)); // NOLINT
+    auto& freeList = mFreeLists.at(slab->mLevel);
+
+    auto* slot  = static_cast<Slot*>(pointer);
+    slot->mNext = freeList;
+    freeList    = slot;
+  }
+
+ private:
+  static constexpr std::size_t sSlabBytes = 64 * 1024;
+
+  union Slot {
+    Slot*                       mNext;
+    alignas(TileNode) std::byte mData[sizeof(TileNode)];
+  };
+
+  // The level is stored at the beginning of each slab, followed by the slots.
+  static constexpr std::size_t sHeaderBytes  = std::max(sizeof(std::size_t), alignof(Slot));
+  static constexpr std::size_t sSlotsPerSlab = (sSlabBytes - sHeaderBytes) / sizeof(Slot);
+
+  struct Slab {
+    std::size_t                     mLevel;
+    std::array<Slot, sSlotsPerSlab> mSlots;
+  };
+
+  static_assert(sizeof(Slab) <= sSlabBytes, "TileNodes do not fit into a slab!");
+
+  // The slabs are never freed, see getNodeAllocator().
+  std::array<Slot*, sMaxLevel + 1> mFreeLists{};
+  std::mutex                       mMutex;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+NodeAllocator& getNodeAllocator() {
+  // This is intentionally leaked so that nodes can still be freed during static destruction.
+  static auto* allocator = new NodeAllocator(); // NOLINT(cppcoreguidelines-owning-memory)
+  return *allocator;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* TileNode::operator new(std::size_t size) {
+  return operator new(size, NodeAllocator::sMaxLevel);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* TileNode::operator new(std::size_t size, int level) {
+  // Derived classes are allocated regularly.
+  if (size != sizeof(TileNode)) {
+    return ::operator new(size);
+  }
+
+  return getNodeAllocator().allocate(level);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileNode::operator delete(void* pointer, std::size_t size) {
+  if (size != sizeof(TileNode)) {
+    ::operator delete(pointer);
+    return;
+  }
+
+  getNodeAllocator().deallocate(pointer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileNode::operator delete(void* pointer, int /*level*/) {
+  // This is only called if the constructor throws. There are no derived classes which use the
+  // placement form.
+  getNodeAllocator().deallocate(pointer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 TileNode::TileNode(TileId const& tileId)
     : mTileId(tileId) {
 
@@ -20,7 +148,6 @@ TileNode::TileNode(TileId const& tileId)
   auto baseXY      = HEALPix::getBaseXY(mTileId);
   mTileOffsetScale = glm::ivec3(baseXY.y, baseXY.z, HEALPix::getNSide(mTileId));
   mTileF1F2        = glm::ivec2(HEALPix::getF1(mTileId), HEALPix::getF2(mTileId));
-  mCornersLngLat   = HEALPix::getCornersLngLat(mTileId);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -117,15 +244,28 @@ int TileNode::getAge(int frame) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+float TileNode::getScreenSpaceError() const {
+  return mScreenSpaceError;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileNode::setScreenSpaceError(float error) {
+  mScreenSpaceError = error;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 BoundingBox<double> const& TileNode::getBounds() const {
   return mTb;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileNode::setBounds(BoundingBox<double> const& tb) {
-  mTb        = tb;
-  mHasBounds = true;
+void TileNode::setBounds(BoundingBox<double> const& tb, uint64_t revision) {
+  mTb             = tb;
+  mBoundsRevision = revision;
+  mHasBounds      = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -143,6 +283,12 @@ bool TileNode::hasBounds() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+uint64_t TileNode::getBoundsRevision() const {
+  return mBoundsRevision;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 TileId const& TileNode::getTileId() const {
   return mTileId;
 }
@@ -173,10 +319,4 @@ glm::ivec2 const& TileNode::getTileF1F2() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::array<glm::dvec2, 4> const& TileNode::getCornersLngLat() const {
-  return mCornersLngLat;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 } // namespace csp::lodbodies
@@ -27,6 +27,16 @@ class TileNode {
   TileNode& operator=(TileNode const& other) = delete;
   TileNode& operator=(TileNode&& other) = default;
 
+  /// TileNodes are allocated from slabs which are shared by all bodies. Freed nodes are recycled
+  /// and never returned to the system, this avoids fragmenting the heap as thousands of nodes are
+  /// created and destroyed during long sessions. Each slab only contains nodes of one level, so
+  /// the nodes which are visited together during a traversal are close to each other in memory.
+  /// Use `new (tileId.level()) TileNode(tileId)` to allocate a node from the slabs of its level.
+  static void* operator new(std::size_t size);
+  static void* operator new(std::size_t size, int level);
+  static void  operator delete(void* pointer, std::size_t size);
+  static void  operator delete(void* pointer, int level);
+
   /// Returns the tile data assigned to this. Can be null.
   std::shared_ptr<BaseTileData> const&              getTileData(TileDataType type) const;
   PerDataType<std::shared_ptr<BaseTileData>> const& getTileData() const;
@@ -51,19 +61,27 @@ class TileNode {
   void setLastFrame(int frame);
   int  getAge(int frame) const;
 
+  /// The relative screen-space size of the node as estimated by the LODVisitor the last time the
+  /// node was visible. Larger values mean that removing the node would be more noticeable. This is
+  /// used by the TreeManager to decide which nodes to remove first if memory runs low.
+  float getScreenSpaceError() const;
+  void  setScreenSpaceError(float error);
+
+  /// The revision identifies the body radii and the height scale the bounds have been computed
+  /// for, see LODVisitor::queueRecomputeTileBounds().
   BoundingBox<double> const& getBounds() const;
-  void                       setBounds(BoundingBox<double> const& tb);
+  void                       setBounds(BoundingBox<double> const& tb, uint64_t revision = 0);
   void                       removeBounds();
   bool                       hasBounds() const;
+  uint64_t                   getBoundsRevision() const;
 
   MinMaxPyramid* getMinMaxPyramid() const;
   void           setMinMaxPyramid(std::unique_ptr<MinMaxPyramid> pyramid);
 
   /// These are computed based on the TileId given to the constructor and are required by the
-  /// TileRender.
-  glm::ivec3 const&                getTileOffsetScale() const;
-  glm::ivec2 const&                getTileF1F2() const;
-  std::array<glm::dvec2, 4> const& getCornersLngLat() const;
+  /// TileRender. The corners of the tile are cached in the HEALPixCache instead.
+  glm::ivec3 const& getTileOffsetScale() const;
+  glm::ivec2 const& getTileF1F2() const;
 
   /// Returns if the node is refined, i.e. if its children are loaded.
   bool childrenAvailable() const;
@@ -80,14 +98,15 @@ class TileNode {
   // These are used for visibility checks.
   std::unique_ptr<MinMaxPyramid> mMinMaxPyramid;
   BoundingBox<double>            mTb;
+  uint64_t                       mBoundsRevision{};
   bool                           mHasBounds{false};
 
   // These are precomputed at construction time and are required during rendering.
-  glm::ivec3                mTileOffsetScale;
-  glm::ivec2                mTileF1F2;
-  std::array<glm::dvec2, 4> mCornersLngLat;
+  glm::ivec3 mTileOffsetScale;
+  glm::ivec2 mTileF1F2;
 
-  int mLastFrame{-1};
+  int   mLastFrame{-1};
+  float mScreenSpaceError{};
 };
 
 } // namespace csp::lodbodies
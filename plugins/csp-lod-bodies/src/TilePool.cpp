@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TilePool.hpp"
+
+#include "logger.hpp"
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePool::TilePool(std::size_t budget)
+    : mBudget(budget) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePool::setBudget(std::size_t budget) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mBudget = budget;
+  evict(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TilePool::getBudget() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePool::Statistics TilePool::getStatistics() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mStatistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePool::resetStatistics() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mStatistics.mAllocatedTiles = 0;
+  mStatistics.mRecycledTiles  = 0;
+  mStatistics.mRejectedTiles  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<BaseTileData> TilePool::acquire(
+    Key const& key, std::size_t size, bool& mayAllocate) {
+
+  auto it = mFreeTiles.find(key);
+  if (it != mFreeTiles.end() && !it->second.mTiles.empty()) {
+    auto tile = std::move(it->second.mTiles.back());
+    it->second.mTiles.pop_back();
+
+    mStatistics.mCachedBytes -= size;
+    mStatistics.mUsedBytes += size;
+    ++mStatistics.mRecycledTiles;
+
+    mayAllocate = false;
+    return tile;
+  }
+
+  evict(size);
+
+  mayAllocate = mBudget == 0 || mStatistics.mUsedBytes + size <= mBudget;
+
+  if (mayAllocate) {
+    mStatistics.mUsedBytes += size;
+    ++mStatistics.mAllocatedTiles;
+  } else {
+    // Only report the first rejection, else this would be printed for each tile in each frame.
+    if (mStatistics.mRejectedTiles == 0) {
+      logger().warn("The tile memory budget of {} MB is exhausted. Consider increasing the "
+                    "'tileMemoryBudget' setting.",
+          mBudget / 1024 / 1024);
+    }
+
+    ++mStatistics.mRejectedTiles;
+  }
+
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePool::release(BaseTileData* tile, std::size_t size) {
+  std::unique_ptr<BaseTileData> owner(tile);
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mStatistics.mUsedBytes -= size;
+
+  // Keep the tile for recycling if it fits into the budget. Without a budget, the pool is bounded
+  // by the peak number of tiles used at the same time.
+  if (mBudget == 0 || mStatistics.mUsedBytes + mStatistics.mCachedBytes + size <= mBudget) {
+    auto& freeList     = mFreeTiles[{tile->getDataType(), tile->getResolution()}];
+    freeList.mTileSize = size;
+    freeList.mTiles.push_back(std::move(owner));
+    mStatistics.mCachedBytes += size;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePool::evict(std::size_t size) {
+  if (mBudget == 0) {
+    return;
+  }
+
+  for (auto& [key, freeList] : mFreeTiles) {
+    while (!freeList.mTiles.empty() &&
+           mStatistics.mUsedBytes + mStatistics.mCachedBytes + size > mBudget) {
+      mStatistics.mCachedBytes -= freeList.mTileSize;
+      freeList.mTiles.pop_back();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILEPOOL_HPP
+#define CSP_LOD_BODIES_TILEPOOL_HPP
+
+#include "TileData.hpp"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// The TilePool recycles the TileData objects of one LodBody. When the last reference to a tile
+/// created by the pool is dropped, the tile is not freed but kept for the next call to create()
+/// with the same data type and resolution. This avoids allocating and freeing large payload
+/// buffers whenever tiles are pruned from and merged into the quadtree, which would fragment the
+/// heap over time.
+///
+/// The pool also enforces a memory budget: The payloads of all tiles which are currently in use
+/// plus the payloads of all recycled tiles never exceed it. If a tile is requested which would not
+/// fit, recycled tiles of other kinds are freed first. If this is not sufficient, create() fails.
+///
+/// All methods are thread-safe. Tiles may outlive the pool, they will be freed regularly then.
+class TilePool : public std::enable_shared_from_this<TilePool> {
+ public:
+  /// Some counters which can be used to choose a suitable budget. See getStatistics().
+  struct Statistics {
+    /// The payload size in bytes of all tiles which are currently in use.
+    std::size_t mUsedBytes{};
+
+    /// The payload size in bytes of all tiles which are kept for recycling.
+    std::size_t mCachedBytes{};
+
+    /// The number of tiles which were newly allocated, which were recycled, and which could not be
+    /// created due to the budget since the last call to resetStatistics().
+    std::size_t mAllocatedTiles{};
+    std::size_t mRecycledTiles{};
+    std::size_t mRejectedTiles{};
+  };
+
+  /// Creates a new pool with the given budget in bytes. Zero means that there is no limit.
+  explicit TilePool(std::size_t budget);
+
+  TilePool(TilePool const& other) = delete;
+  TilePool(TilePool&& other)      = delete;
+
+  TilePool& operator=(TilePool const& other) = delete;
+  TilePool& operator=(TilePool&& other) = delete;
+
+  ~TilePool() = default;
+
+  /// Returns a tile of the given resolution. The data of recycled tiles is reset to zero. Returns
+  /// a nullptr if the tile does not fit into the budget. The pool has to be owned by a
+  /// std::shared_ptr when this is called.
+  template <typename T>
+  std::shared_ptr<TileData<T>> create(uint32_t resolution);
+
+  /// Changes the budget in bytes. If the recycled tiles do not fit into the new budget anymore,
+  /// some of them are freed. Tiles which are in use are not affected.
+  void        setBudget(std::size_t budget);
+  std::size_t getBudget() const;
+
+  /// Returns the current memory usage and the counters accumulated since the last call to
+  /// resetStatistics().
+  Statistics getStatistics() const;
+  void       resetStatistics();
+
+ private:
+  using Key = std::pair<TileDataType, uint32_t>;
+
+  struct FreeList {
+    std::size_t                                mTileSize{};
+    std::vector<std::unique_ptr<BaseTileData>> mTiles;
+  };
+
+  /// Returns a recycled tile of the given kind or a nullptr if there is none. In the latter case,
+  /// true is returned if a new tile of the given size fits into the budget, which is then
+  /// accounted for already. mMutex has to be locked.
+  std::unique_ptr<BaseTileData> acquire(Key const& key, std::size_t size, bool& mayAllocate);
+
+  /// Called once a tile created by the pool is not used anymore.
+  void release(BaseTileData* tile, std::size_t size);
+
+  /// Frees recycled tiles until the given amount of bytes fits into the budget in addition to the
+  /// used and recycled tiles. mMutex has to be locked.
+  void evict(std::size_t size);
+
+  std::map<Key, FreeList> mFreeTiles;
+
+  std::size_t        mBudget;
+  Statistics         mStatistics;
+  mutable std::mutex mMutex;
+};
+
+template <typename T>
+std::shared_ptr<TileData<T>> TilePool::create(uint32_t resolution) {
+  std::size_t size = sizeof(T) * resolution * resolution;
+  bool        mayAllocate{};
+
+  std::unique_ptr<TileData<T>> tile;
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    tile.reset(static_cast<TileData<T>*>(
+        acquire({TileData<T>::getStaticDataType(), resolution}, size, mayAllocate).release()));
+  }
+
+  if (tile) {
+    std::fill(tile->data().begin(), tile->data().end(), T{});
+    tile->setTexLayer(-1);
+    tile->getCompressedData().clear();
+  } else if (mayAllocate) {
+    tile = std::make_unique<TileData<T>>(resolution);
+  } else {
+    return nullptr;
+  }
+
+  return std::shared_ptr<TileData<T>>(
+      tile.release(), [pool = weak_from_this(), size](TileData<T>* tile) {
+        if (auto p = pool.lock()) {
+          p->release(tile, size);
+        } else {
+          delete tile; // NOLINT(cppcoreguidelines-owning-memory)
+        }
+      });
+}
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEPOOL_HPP
@@ -21,6 +21,19 @@ TileNode* TileQuadTree::getRoot(int idx) const {
 
 void TileQuadTree::setRoot(int idx, TileNode* root) {
   mRoots.at(idx).reset(root);
+  incrementRevision(idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TileQuadTree::getRevision(int idx) const {
+  return mRevisions.at(idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileQuadTree::incrementRevision(int idx) {
+  ++mRevisions.at(idx);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -45,6 +58,7 @@ bool insertNode(TileQuadTree* tree, TileNode* node) {
       assert(parent->getChild(HEALPix::getChildIdxAtLevel(tileId, tileId.level())) == nullptr);
 
       parent->setChild(HEALPix::getChildIdxAtLevel(tileId, tileId.level()), node);
+      tree->incrementRevision(HEALPix::getRootIdx(tileId));
     } else {
       result = false;
     }
@@ -63,9 +77,12 @@ bool removeNode(TileQuadTree* tree, TileNode* node) {
   // is not in tree or the data structure is corrupt).
   if (parent) {
     int childIdx = HEALPix::getChildIdx(node->getTileId());
+    int rootIdx  = HEALPix::getRootIdx(node->getTileId());
     assert(parent->getChild(childIdx) == node);
 
+    // This deletes node.
     parent->setChild(childIdx, nullptr);
+    tree->incrementRevision(rootIdx);
     result = true;
   } else {
     int childIdx = HEALPix::getChildIdx(node->getTileId());
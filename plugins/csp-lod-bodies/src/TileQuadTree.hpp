@@ -28,8 +28,16 @@ class TileQuadTree {
   /// this.
   void setRoot(int idx, TileNode* root);
 
+  /// Returns a counter which is incremented whenever a node is inserted into or removed from the
+  /// tree idx. This can be used to detect whether the structure of a tree has changed.
+  uint64_t getRevision(int idx) const;
+
+  /// Increments the revision of the tree idx. This is called by insertNode() and removeNode().
+  void incrementRevision(int idx);
+
  private:
   std::array<std::unique_ptr<TileNode>, 12> mRoots;
+  std::array<uint64_t, 12>                  mRevisions{};
 };
 
 /// Inserts node into tree and returns true if it succeeded, false otherwise. Insertion can fail if
@@ -7,13 +7,13 @@
 
 #include "TileRenderer.hpp"
 
+#include "LODVisitor.hpp"
 #include "PlanetParameters.hpp"
 #include "TileNode.hpp"
 #include "TileTextureArray.hpp"
 #include "TreeManager.hpp"
 
 #include "../../../src/cs-graphics/Shadows.hpp"
-#include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 
 #include <VistaBase/VistaStreamUtils.h>
@@ -22,6 +22,8 @@
 #include <VistaOGLExt/VistaShaderRegistry.h>
 #include <VistaOGLExt/VistaTexture.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
 #include <glm/gtx/io.hpp>
 #include <memory>
 
@@ -41,6 +43,15 @@ GLint const  texUnitIMG     = 1;
 
 GLint const texUnitShadow = 2;
 
+GLenum const texUnitNameGradients = GL_TEXTURE3;
+GLint const  texUnitGradients     = 3;
+
+GLuint const tileBufferBinding = 0;
+
+// Tiles are drawn with the full grid resolution down to this screen-space error. This is the size
+// of the smallest tiles resulting from refining a tile which exceeds the LODVisitor's threshold.
+float const fullResolutionError = 0.5F * LODVisitor::sRefineThreshold;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 } // namespace
@@ -70,30 +81,10 @@ TileRenderer::TileRenderer(
     , mEnableWireframe(false)
     , mEnableFaceCulling(true)
     , mTileResolution(tileResolution)
-    , mGridResolution(mTileResolution + 2)
-    , mIndexCount((mGridResolution - 1) * (2 + 2 * mGridResolution)) {
+    , mGrid(mTileResolution) {
 
-  std::vector<uint16_t> vertices(mGridResolution * mGridResolution * 2);
-  std::vector<uint32_t> indices(mIndexCount);
-
-  for (uint32_t x = 0; x < mGridResolution; ++x) {
-    for (uint32_t y = 0; y < mGridResolution; ++y) {
-      vertices[(x * mGridResolution + y) * 2 + 0] = x;
-      vertices[(x * mGridResolution + y) * 2 + 1] = y;
-    }
-  }
-
-  uint32_t index = 0;
-
-  for (uint32_t x = 0; x < mGridResolution - 1; ++x) {
-    indices[index++] = x * mGridResolution;
-    for (uint32_t y = 0; y < mGridResolution; ++y) {
-      indices[index++] = x * mGridResolution + y;
-      indices[index++] = (x + 1) * mGridResolution + y;
-    }
-    indices[index] = indices[index - 1];
-    ++index;
-  }
+  auto const& vertices = mGrid.getVertices();
+  auto const& indices  = mGrid.getIndices();
 
   mVaoTerrain = std::make_unique<VistaVertexArrayObject>();
   mVaoTerrain->Bind();
@@ -106,8 +97,14 @@ TileRenderer::TileRenderer(
   mIboTerrain->Bind(GL_ELEMENT_ARRAY_BUFFER);
   mIboTerrain->BufferData(indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
 
+  // The first attribute is the position of the vertex, the second its morph target.
+  GLsizei const stride = 4 * sizeof(uint16_t);
+
   mVaoTerrain->EnableAttributeArray(0);
-  mVaoTerrain->SpecifyAttributeArrayInteger(0, 2, GL_UNSIGNED_SHORT, 0, 0, mVboTerrain.get());
+  mVaoTerrain->SpecifyAttributeArrayInteger(0, 2, GL_UNSIGNED_SHORT, stride, 0, mVboTerrain.get());
+  mVaoTerrain->EnableAttributeArray(1);
+  mVaoTerrain->SpecifyAttributeArrayInteger(
+      1, 2, GL_UNSIGNED_SHORT, stride, 2 * sizeof(uint16_t), mVboTerrain.get());
 
   mVaoTerrain->Release();
   mIboTerrain->Release();
@@ -118,6 +115,14 @@ TileRenderer::TileRenderer(
   mIboBounds  = makeIBOBounds();
   mVaoBounds  = makeVAOBounds(mVboBounds.get(), mIboBounds.get());
   mProgBounds = makeProgBounds();
+
+  glGenBuffers(1, &mTileBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileRenderer::~TileRenderer() {
+  glDeleteBuffers(1, &mTileBuffer);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -155,6 +160,11 @@ void TileRenderer::preRenderTiles(cs::graphics::ShadowMap* shadowMap) {
   auto const& glDEM = mTreeMgr->getGLResources()->get(TileDataType::eElevation);
   auto const& glIMG = mTreeMgr->getGLResources()->get(TileDataType::eColor);
 
+  // The cache has to be replaced if the radii of the planet changed.
+  if (!mHEALPixCache || mHEALPixCache->getRadii() != mParams->mRadii) {
+    mHEALPixCache = HEALPixCache::get(mParams->mRadii);
+  }
+
   // setup OpenGL state
   glPushAttrib(GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_ENABLE_BIT | GL_LIGHTING_BIT |
                GL_POLYGON_BIT | GL_TEXTURE_BIT);
@@ -176,6 +186,9 @@ void TileRenderer::preRenderTiles(cs::graphics::ShadowMap* shadowMap) {
     glActiveTexture(texUnitNameDEM);
     glBindTexture(GL_TEXTURE_2D, 0);
     glBindTexture(GL_TEXTURE_2D_ARRAY, glDEM->getTextureId());
+
+    glActiveTexture(texUnitNameGradients);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, glDEM->getGradientTextureId());
   }
 
   if (glIMG) {
@@ -186,7 +199,7 @@ void TileRenderer::preRenderTiles(cs::graphics::ShadowMap* shadowMap) {
 
   mVaoTerrain->Bind();
   mProgTerrain->bind();
-  VistaGLSLShader& shader = mProgTerrain->mShader;
+  VistaGLSLShader& shader = *mProgTerrain->mShader;
 
   // update "frame global" uniforms
   GLint loc = shader.GetUniformLocation("VP_matProjection");
@@ -204,94 +217,202 @@ void TileRenderer::preRenderTiles(cs::graphics::ShadowMap* shadowMap) {
   shader.SetUniform(loc, texUnitDEM);
   loc = shader.GetUniformLocation("VP_texIMG");
   shader.SetUniform(loc, texUnitIMG);
+  loc = shader.GetUniformLocation("VP_texGradients");
+  shader.SetUniform(loc, texUnitGradients);
   loc = shader.GetUniformLocation("VP_shadowMapMode");
   shader.SetUniform(loc, shadowMap == nullptr);
+  loc = shader.GetUniformLocation("VP_shadowMapLayered");
+  shader.SetUniform(loc, shadowMap == nullptr && mLayeredShadowMap != nullptr);
 
-  if (shadowMap) {
-    shader.SetUniform(shader.GetUniformLocation("VP_shadowBias"), shadowMap->getBias());
-    shader.SetUniform(shader.GetUniformLocation("VP_shadowCascades"),
-        static_cast<int>(shadowMap->getMaps().size()));
+  // The matrices are required for the lookups as well as for drawing into a layered shadow map.
+  auto const* matricesSource = shadowMap ? shadowMap : mLayeredShadowMap;
 
-    for (size_t i = 0; i < shadowMap->getMaps().size(); ++i) {
-      GLint locSamplers = glGetUniformLocation(
-          shader.GetProgram(), ("VP_shadowMaps[" + std::to_string(i) + "]").c_str());
+  if (matricesSource) {
+    for (size_t i = 0; i < matricesSource->getShadowMatrices().size(); ++i) {
       GLint locMatrices = glGetUniformLocation(shader.GetProgram(),
           ("VP_shadowProjectionViewMatrices[" + std::to_string(i) + "]").c_str());
 
-      shadowMap->getMaps()[i]->Bind(GL_TEXTURE0 + texUnitShadow + static_cast<int>(i));
-      glUniform1i(locSamplers, texUnitShadow + static_cast<int>(i));
-
-      auto mat = shadowMap->getShadowMatrices()[i];
+      auto mat = matricesSource->getShadowMatrices()[i];
       glUniformMatrix4fv(locMatrices, 1, GL_FALSE, mat.GetData());
     }
   }
+
+  if (shadowMap) {
+    shader.SetUniform(shader.GetUniformLocation("VP_shadowBias"), shadowMap->getBias());
+    shader.SetUniform(shader.GetUniformLocation("VP_shadowCascades"),
+        static_cast<int>(shadowMap->getShadowMatrices().size()));
+
+    glActiveTexture(GL_TEXTURE0 + texUnitShadow);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, shadowMap->getTexture());
+    shader.SetUniform(shader.GetUniformLocation("VP_shadowMaps"), texUnitShadow);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TileRenderer::renderTiles(std::vector<TileNode*> const& nodes) {
-  VistaGLSLShader& shader = mProgTerrain->mShader;
-
-  // query uniform locations once and store in locs
-  UniformLocs locs{};
-  locs.heightInfo  = shader.GetUniformLocation("VP_heightInfo");
-  locs.offsetScale = shader.GetUniformLocation("VP_offsetScale");
-  locs.f1f2        = shader.GetUniformLocation("VP_f1f2");
-  locs.dataLayers  = shader.GetUniformLocation("VP_dataLayers");
+  mTileData.clear();
+  mTileData.reserve(nodes.size());
 
   for (auto* node : nodes) {
-    renderTile(node, locs);
+    if (getTileData(node, mTileData.emplace_back())) {
+      continue;
+    }
+
+    mTileData.pop_back();
+  }
+
+  if (mLayeredShadowMap) {
+    assignShadowCascades();
+  }
+
+  if (mTileData.empty()) {
+    return;
+  }
+
+  // The tiles of each grid level are drawn with one draw call.
+  std::stable_sort(mTileData.begin(), mTileData.end(),
+      [](TileData const& a, TileData const& b) { return a.mOffsetScale.w < b.mOffsetScale.w; });
+
+  // Upload the data of all tiles at once. Re-specifying the entire buffer allows the driver to
+  // allocate new storage if the GPU still uses the data of the previous call.
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mTileBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, mTileData.size() * sizeof(TileData), mTileData.data(),
+      GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0U);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, tileBufferBinding, mTileBuffer);
+
+  // draw all tiles
+  GLint firstTileLoc = mProgTerrain->mShader->GetUniformLocation("VP_firstTile");
+
+  for (std::size_t first = 0; first < mTileData.size();) {
+    int  levelIdx = mTileData[first].mOffsetScale.w;
+    auto last     = first + 1;
+
+    while (last < mTileData.size() && mTileData[last].mOffsetScale.w == levelIdx) {
+      ++last;
+    }
+
+    auto const& level = mGrid.getLevels().at(levelIdx);
+
+    mProgTerrain->mShader->SetUniform(firstTileLoc, static_cast<int>(first));
+    glDrawElementsInstanced(GL_TRIANGLE_STRIP, static_cast<GLsizei>(level.mIndexCount),
+        GL_UNSIGNED_INT,
+        reinterpret_cast<void*>(level.mFirstIndex * sizeof(uint32_t)), // NOLINT
+        static_cast<GLsizei>(last - first));
+
+    first = last;
   }
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, tileBufferBinding, 0U);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileRenderer::renderTile(TileNode* node, UniformLocs const& locs) {
+bool TileRenderer::getTileData(TileNode* node, TileData& data) const {
   auto const& dem = node->getTileData(TileDataType::eElevation);
   auto const& img = node->getTileData(TileDataType::eColor);
 
   // Do not attempt to draw tiles with missing data.
   if (dem->getTexLayer() < 0 || (img && img->getTexLayer() < 0)) {
-    return;
+    return false;
   }
 
-  VistaGLSLShader& shader = mProgTerrain->mShader;
-
   float averageHeight = node->getMinMaxPyramid()->getAverage();
   float minHeight     = node->getMinMaxPyramid()->getMin();
   float maxHeight     = node->getMinMaxPyramid()->getMax();
 
-  // update uniforms
-  shader.SetUniform(locs.heightInfo, averageHeight, maxHeight - minHeight);
-  shader.SetUniform(locs.offsetScale, 3, 1, glm::value_ptr(node->getTileOffsetScale()));
-  shader.SetUniform(locs.f1f2, 2, 1, glm::value_ptr(node->getTileF1F2()));
+  // Quantized elevation data is stored relative to the height range of each tile.
+  glm::vec2 heightRange(0.F, 1.F);
+  if (mTreeMgr->getGLResources()->get(TileDataType::eElevation)->isCompressed()) {
+    heightRange = glm::vec2(minHeight, maxHeight - minHeight);
+  }
+
+  // Choose the grid resolution based on the size of the tile on screen.
+  uint32_t level{};
+  float    morphFactor{};
+  mGrid.getLevel(node->getScreenSpaceError() / fullResolutionError, level, morphFactor);
 
-  glUniform2i(locs.dataLayers, dem->getTexLayer(), img ? img->getTexLayer() : 0);
+  data.mHeightInfo     = glm::vec4(averageHeight, maxHeight - minHeight, heightRange);
+  data.mOffsetScale    = glm::ivec4(node->getTileOffsetScale(), level);
+  data.mGridMorph      = glm::vec4(morphFactor, 0.F, 0.F, 0.F);
+  data.mF1F2DataLayers = glm::ivec4(
+      node->getTileF1F2(), dem->getTexLayer(), img ? img->getTexLayer() : 0);
 
   // order of components: N, W, S, E
-  auto const&               cornersLngLat = node->getCornersLngLat();
-  std::array<glm::dvec3, 4> corners{};
-  std::array<glm::dvec3, 4> normals{};
-  std::array<glm::fvec3, 4> cornersWorldSpace{};
-  std::array<glm::fvec3, 4> normalsWorldSpace{};
+  auto const& corners = mHEALPixCache->getPatch(node->getTileId()).mCorners;
+  double      height  = averageHeight * static_cast<float>(mParams->mHeightScale);
 
   // Convert tile corners to camera-relative coordinates in double precision.
-  for (int i(0); i < 4; ++i) {
-    corners.at(i)           = cs::utils::convert::toCartesian(cornersLngLat.at(i), mParams->mRadii,
-        averageHeight * static_cast<float>(mParams->mHeightScale));
-    cornersWorldSpace.at(i) = glm::fvec3(mMatM * glm::dvec4(corners.at(i), 1.0));
+  for (std::size_t i(0); i < 4; ++i) {
+    glm::dvec3 corner = corners.at(i).mPosition + corners.at(i).mNormal * height;
+
+    data.mCorners.at(i) = glm::vec4(mMatM * glm::dvec4(corner, 1.0));
+    data.mNormals.at(i) = glm::vec4(mMatN * glm::dvec4(corners.at(i).mNormal, 0.0));
+  }
 
-    normals.at(i)           = cs::utils::convert::lngLatToNormal(cornersLngLat.at(i));
-    normalsWorldSpace.at(i) = glm::fvec3(mMatN * glm::dvec4(normals.at(i), 0.0));
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileRenderer::assignShadowCascades() {
+  std::vector<std::pair<uint32_t, glm::mat4>> cascades;
+
+  for (auto cascade : mLayeredShadowMap->getUpdatedCascades()) {
+    auto mat = mLayeredShadowMap->getShadowMatrices().at(cascade);
+    cascades.emplace_back(cascade, glm::make_mat4x4(mat.GetData()));
   }
 
-  glUniform3fv(glGetUniformLocation(shader.GetProgram(), "VP_corners"), 9,
-      glm::value_ptr(cornersWorldSpace[0]));
-  glUniform3fv(glGetUniformLocation(shader.GetProgram(), "VP_normals"), 4,
-      glm::value_ptr(normalsWorldSpace[0]));
+  // Each tile is drawn once for each cascade it overlaps. The test uses a bounding sphere around
+  // the tile's corners; as even the base tiles cover only a twelfth of the sphere, the bulge of
+  // the surface between the corners is always contained. Tiles outside all cascades are marked
+  // with -1.
+  std::size_t tileCount = mTileData.size();
+
+  for (std::size_t i = 0; i < tileCount; ++i) {
+    TileData tile = mTileData[i];
+
+    glm::vec3 center(0.F);
+    for (auto const& corner : tile.mCorners) {
+      center += glm::vec3(corner) * 0.25F;
+    }
+
+    float radius = 0.F;
+    for (auto const& corner : tile.mCorners) {
+      radius = std::max(radius, glm::distance(center, glm::vec3(corner)));
+    }
+    radius += tile.mHeightInfo.y * static_cast<float>(mParams->mHeightScale);
+
+    mTileData[i].mGridMorph.y = -1.F;
 
-  // draw tile
-  glDrawElements(GL_TRIANGLE_STRIP, mIndexCount, GL_UNSIGNED_INT, nullptr);
+    for (auto const& [cascade, matrix] : cascades) {
+      glm::vec4 clip = matrix * glm::vec4(center, 1.F);
+
+      // The projection is orthographic, so the radius is scaled by the length of the rows.
+      bool overlaps = true;
+      for (int c = 0; c < 3; ++c) {
+        float extent = radius * glm::length(glm::vec3(matrix[0][c], matrix[1][c], matrix[2][c]));
+        overlaps     = overlaps && std::abs(clip[c]) <= 1.F + extent;
+      }
+
+      if (!overlaps) {
+        continue;
+      }
+
+      if (mTileData[i].mGridMorph.y < 0.F) {
+        mTileData[i].mGridMorph.y = static_cast<float>(cascade);
+      } else {
+        tile.mGridMorph.y = static_cast<float>(cascade);
+        mTileData.push_back(tile);
+      }
+    }
+  }
+
+  mTileData.erase(std::remove_if(mTileData.begin(), mTileData.end(),
+                      [](TileData const& tile) { return tile.mGridMorph.y < 0.F; }),
+      mTileData.end());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -307,6 +428,14 @@ void TileRenderer::postRenderTiles(cs::graphics::ShadowMap* shadowMap) {
   glActiveTexture(texUnitNameIMG);
   glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
 
+  glActiveTexture(texUnitNameGradients);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
+
+  if (shadowMap) {
+    glActiveTexture(GL_TEXTURE0 + texUnitShadow);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
+  }
+
   if (mEnableWireframe) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
   }
@@ -314,12 +443,6 @@ void TileRenderer::postRenderTiles(cs::graphics::ShadowMap* shadowMap) {
   glFrontFace(GL_CW);
 
   glPopAttrib();
-
-  if (shadowMap) {
-    for (auto* map : shadowMap->getMaps()) {
-      map->Unbind();
-    }
-  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -503,6 +626,12 @@ void TileRenderer::setProjection(glm::mat4 const& m) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileRenderer::setLayeredShadowMap(cs::graphics::ShadowMap const* shadowMap) {
+  mLayeredShadowMap = shadowMap;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TileRenderer::setDrawBounds(bool enable) {
   mEnableDrawBounds = enable;
 }
@@ -8,12 +8,15 @@
 #ifndef CSP_LOD_BODIES_TILERENDERER_HPP
 #define CSP_LOD_BODIES_TILERENDERER_HPP
 
+#include "HEALPixCache.hpp"
 #include "TerrainShader.hpp"
+#include "TileGrid.hpp"
 #include "TileId.hpp"
 
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
+#include <array>
 #include <vector>
 
 namespace cs::graphics {
@@ -27,11 +30,17 @@ class TileNode;
 class TreeManager;
 
 /// Renders tiles with elevation (DEM) and optionally image (IMG) data.
+///
+/// Tiles which are small on screen are drawn with a decimated vertex grid, see TileGrid. The grid
+/// is morphed towards the next coarser level before switching to it, so that no popping is
+/// visible. All tiles using the same grid level are drawn with a single instanced draw call. The
+/// per-tile data is written to a shader storage buffer which the shader indexes with the instance
+/// ID and the index of the first tile of the draw call, see VistaPlanetTerrainShaderUniforms.glsl.
 class TileRenderer {
  public:
   explicit TileRenderer(
       PlanetParameters const& params, TreeManager* treeMgr, uint32_t tileResolution);
-  virtual ~TileRenderer() = default;
+  virtual ~TileRenderer();
 
   TileRenderer(TileRenderer const& other) = delete;
   TileRenderer(TileRenderer&& other)      = delete;
@@ -52,6 +61,12 @@ class TileRenderer {
   void setView(glm::mat4 const& m);
   void setProjection(glm::mat4 const& m);
 
+  /// If set, tiles which are rendered without a shadow map (that is, into a shadow map) are drawn
+  /// into all cascades returned by ShadowMap::getUpdatedCascades() in one pass. Each tile is only
+  /// drawn into the cascades it overlaps. This should only be set while
+  /// ShadowMap::getIsRenderingLayered() returns true.
+  void setLayeredShadowMap(cs::graphics::ShadowMap const* shadowMap);
+
   /// Render the given nodes.
   void render(std::vector<TileNode*> const& nodes, cs::graphics::ShadowMap* shadowMap);
 
@@ -68,16 +83,24 @@ class TileRenderer {
   bool getFaceCulling() const;
 
  private:
-  struct UniformLocs {
-    GLint heightInfo;
-    GLint offsetScale;
-    GLint f1f2;
-    GLint dataLayers;
+  /// The per-tile data as stored in the shader storage buffer. This has to match the layout of
+  /// VP_TileData in VistaPlanetTerrainShaderUniforms.glsl (std430).
+  /// The w component of mOffsetScale contains the grid level, it is only used on the CPU. The x
+  /// component of mGridMorph contains the morph factor towards the next coarser level, the y
+  /// component the shadow map cascade in a layered shadow map pass.
+  struct TileData {
+    glm::vec4                mHeightInfo;
+    glm::ivec4               mOffsetScale;
+    glm::ivec4               mF1F2DataLayers;
+    std::array<glm::vec4, 4> mCorners;
+    std::array<glm::vec4, 4> mNormals;
+    glm::vec4                mGridMorph;
   };
 
   void preRenderTiles(cs::graphics::ShadowMap* shadowMap);
   void renderTiles(std::vector<TileNode*> const& nodes);
-  void renderTile(TileNode* node, UniformLocs const& locs);
+  bool getTileData(TileNode* node, TileData& data) const;
+  void assignShadowCascades();
   void postRenderTiles(cs::graphics::ShadowMap* shadowMap);
 
   void        preRenderBounds();
@@ -95,8 +118,9 @@ class TileRenderer {
       VistaBufferObject* vbo, VistaBufferObject* ibo);
   static std::unique_ptr<VistaGLSLShader> makeProgBounds();
 
-  PlanetParameters const* mParams;
-  TreeManager*            mTreeMgr;
+  PlanetParameters const*       mParams;
+  TreeManager*                  mTreeMgr;
+  std::shared_ptr<HEALPixCache> mHEALPixCache;
 
   glm::dmat4 mMatM;
   glm::dmat4 mMatN;
@@ -108,6 +132,13 @@ class TileRenderer {
   static std::unique_ptr<VistaVertexArrayObject> mVaoTerrain;
   TerrainShader*                                 mProgTerrain;
 
+  // The shader storage buffer containing the TileData of all tiles drawn in the current call.
+  // mTileData is only kept as a member to avoid reallocations.
+  GLuint                mTileBuffer{};
+  std::vector<TileData> mTileData;
+
+  cs::graphics::ShadowMap const* mLayeredShadowMap = nullptr;
+
   static std::unique_ptr<VistaBufferObject>      mVboBounds;
   static std::unique_ptr<VistaBufferObject>      mIboBounds;
   static std::unique_ptr<VistaVertexArrayObject> mVaoBounds;
@@ -118,13 +149,10 @@ class TileRenderer {
   bool mEnableFaceCulling;
 
   // The mTileResolution describes the number of vertices which are used in x and y direction for
-  // rendering the elevation data. The mGridResolution is the actual amount of vertices in x and y
-  // direction which is drawn, which also includes the additional vertices required for the skirt
-  // around the tile. mIndexCount contains the number of entries required in the index buffer to
-  // draw this grid.
+  // rendering the elevation data at full resolution. mGrid contains the vertices and indices of all
+  // grid levels, including the additional vertices required for the skirt around the tile.
   const uint32_t mTileResolution;
-  const uint32_t mGridResolution;
-  const uint32_t mIndexCount;
+  const TileGrid mGrid;
 };
 
 } // namespace csp::lodbodies
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILEREQUEST_HPP
+#define CSP_LOD_BODIES_TILEREQUEST_HPP
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "TileId.hpp"
+
+#include <atomic>
+
+namespace csp::lodbodies {
+
+/// A TileRequest is returned by TileSource::loadTileAsync(). It can be used to change the
+/// priority of a request which has not been started yet or to cancel the request altogether. The
+/// TileSource may also abort a request which has already been started if it is cancelled, for
+/// example by aborting the corresponding download.
+/// All methods are thread-safe, the handle is usually modified on the main thread while it is
+/// checked by the loader threads.
+class TileRequest {
+ public:
+  /// Tile requests use the priority classes of the ThreadPool. Tiles which are currently required
+  /// for rendering should use eHigh, tiles which are not immediately required use eNormal.
+  using Priority = cs::utils::ThreadPool::Priority;
+
+  explicit TileRequest(TileId const& tileId, Priority priority = Priority::eHigh)
+      : mTileId(tileId)
+      , mPriority(priority) {
+  }
+
+  TileRequest(TileRequest const& other) = delete;
+  TileRequest(TileRequest&& other)      = delete;
+
+  TileRequest& operator=(TileRequest const& other) = delete;
+  TileRequest& operator=(TileRequest&& other) = delete;
+
+  ~TileRequest() = default;
+
+  TileId const& getTileId() const {
+    return mTileId;
+  }
+
+  /// Requests with a higher priority will be loaded first. Changing the priority has no effect
+  /// once loading of the tile has started.
+  void setPriority(Priority priority) {
+    mPriority = priority;
+  }
+
+  Priority getPriority() const {
+    return mPriority;
+  }
+
+  /// Once a request is cancelled, it cannot be resumed. The callback passed to
+  /// TileSource::loadTileAsync() will still be called, but most likely with a nullptr.
+  void cancel() {
+    mCancelled = true;
+  }
+
+  bool isCancelled() const {
+    return mCancelled;
+  }
+
+ private:
+  TileId                mTileId;
+  std::atomic<Priority> mPriority;
+  std::atomic<bool>     mCancelled{false};
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEREQUEST_HPP
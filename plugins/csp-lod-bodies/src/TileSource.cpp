@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TileSource.hpp"
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSource::setTilePool(std::shared_ptr<TilePool> pool) {
+  mTilePool = std::move(pool);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TilePool> const& TileSource::getTilePool() const {
+  return mTilePool;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSource::setCompressColorTiles(bool enable) {
+  mCompressColorTiles = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileSource::getCompressColorTiles() const {
+  return mCompressColorTiles;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSource::setCompressElevationTiles(bool enable) {
+  mCompressElevationTiles = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileSource::getCompressElevationTiles() const {
+  return mCompressElevationTiles;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -10,10 +10,15 @@
 
 #include "TileDataType.hpp"
 #include "TileId.hpp"
+#include "TileRequest.hpp"
+
+#include <functional>
+#include <memory>
 
 namespace csp::lodbodies {
 
 class BaseTileData;
+class TilePool;
 
 /// Base class/interface for sources of tile data. Defines interfaces for synchronous (blocking) and
 /// asynchronous (non-blocking) loading of tiles, optionally allocating objects as needed or reusing
@@ -50,8 +55,12 @@ class TileSource {
   virtual std::shared_ptr<BaseTileData> loadTile(TileId const& tileId) = 0;
 
   /// Loads a node with given tileId asynchronously (i.e. the call returns immediately).
-  /// Once the node is loaded the given OnLoadCallack is invoked.
-  virtual void loadTileAsync(TileId const& tileId, OnLoadCallback cb) = 0;
+  /// Once the node is loaded the given OnLoadCallack is invoked. The callback is invoked exactly
+  /// once for each call, even if the request is cancelled. In this case, or if loading failed, the
+  /// data passed to the callback will be a nullptr. The returned TileRequest has the given initial
+  /// priority; it can be used to cancel the request or to change its priority.
+  virtual std::shared_ptr<TileRequest> loadTileAsync(
+      TileId const& tileId, TileRequest::Priority priority, OnLoadCallback cb) = 0;
 
   /// Returns the number of currently active async requests.
   virtual int getPendingRequests() = 0;
@@ -59,6 +68,28 @@ class TileSource {
   /// Derived classes should check whether the given TileSource has the same type and members. This
   /// is used to prevent redundant tile source reloading.
   virtual bool isSame(TileSource const* other) const = 0;
+
+  /// If set, derived classes should allocate their tiles from this pool. This has to be set before
+  /// the first tile is requested. Usually, all sources of one body share the same pool.
+  void                             setTilePool(std::shared_ptr<TilePool> pool);
+  std::shared_ptr<TilePool> const& getTilePool() const;
+
+  /// If set, derived classes should compress color tiles to BC1 on their loader threads and store
+  /// the blocks with BaseTileData::getCompressedData(). This should match the TileTextureArray
+  /// the tiles are uploaded to and has to be set before the first tile is requested.
+  void setCompressColorTiles(bool enable);
+  bool getCompressColorTiles() const;
+
+  /// If set, derived classes which cache tiles should store elevation tiles quantized to 16 bit
+  /// with compression::encodeHeights(). This should only be enabled if the TileTextureArray the
+  /// tiles are uploaded to quantizes them anyways, as the heights lose some precision otherwise.
+  void setCompressElevationTiles(bool enable);
+  bool getCompressElevationTiles() const;
+
+ private:
+  std::shared_ptr<TilePool> mTilePool;
+  bool                      mCompressColorTiles     = false;
+  bool                      mCompressElevationTiles = false;
 };
 
 } // namespace csp::lodbodies
@@ -0,0 +1,734 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TileSourceGeoTiff.hpp"
+
+#include "HEALPix.hpp"
+#include "TileCompression.hpp"
+#include "TilePool.hpp"
+#include "logger.hpp"
+
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/HttpClient.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/constants.hpp>
+#include <list>
+#include <type_traits>
+#include <unordered_map>
+
+#include <tiffio.h>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// These GeoTIFF tags are not known to libtiff.
+constexpr uint32_t MODEL_PIXEL_SCALE_TAG = 33550;
+constexpr uint32_t MODEL_TIEPOINT_TAG    = 33922;
+
+// Remote files are fetched in chunks of this size. The most recently used chunks are kept, so that
+// the many small reads libtiff makes when parsing the directories do not result in one request
+// each.
+constexpr uint64_t REMOTE_CHUNK_SIZE  = 64 * 1024;
+constexpr uint64_t REMOTE_CHUNK_COUNT = 32;
+
+// The side length of a HEALPix base patch on the unit sphere in radians.
+const double BASE_PATCH_SIZE = std::sqrt(glm::pi<double>() / 3.0);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TIFFExtendProc parentTagExtender = nullptr;
+std::once_flag tagExtenderFlag;
+
+void extendTags(TIFF* tif) {
+  // libtiff expects non-const names but does not modify them.
+  // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
+  static std::array<TIFFFieldInfo, 2> fields{{
+      {MODEL_PIXEL_SCALE_TAG, -1, -1, TIFF_DOUBLE, FIELD_CUSTOM, 1, 1,
+          const_cast<char*>("ModelPixelScaleTag")},
+      {MODEL_TIEPOINT_TAG, -1, -1, TIFF_DOUBLE, FIELD_CUSTOM, 1, 1,
+          const_cast<char*>("ModelTiepointTag")},
+  }};
+  // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
+
+  TIFFMergeFieldInfo(tif, fields.data(), static_cast<uint32_t>(fields.size()));
+
+  if (parentTagExtender) {
+    parentTagExtender(tif);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A remote file which is read with HTTP range requests. libtiff accesses it through the client
+// procedures below.
+struct RemoteFile {
+  std::string mUrl;
+  uint64_t    mSize   = 0;
+  uint64_t    mOffset = 0;
+
+  // The most recently used chunk is at the front.
+  std::list<std::pair<uint64_t, std::string>> mChunks;
+
+  std::string const& getChunk(uint64_t index) {
+    auto cached = std::find_if(
+        mChunks.begin(), mChunks.end(), [index](auto const& c) { return c.first == index; });
+
+    if (cached != mChunks.end()) {
+      mChunks.splice(mChunks.begin(), mChunks, cached);
+      return mChunks.front().second;
+    }
+
+    uint64_t first = index * REMOTE_CHUNK_SIZE;
+    uint64_t last  = std::min(mSize, first + REMOTE_CHUNK_SIZE) - 1;
+
+    cs::utils::HttpClient::Request request;
+    request.mUrl     = mUrl;
+    request.mHeaders = {"Range: bytes=" + std::to_string(first) + "-" + std::to_string(last)};
+
+    auto response = cs::utils::HttpClient::get().perform(request);
+
+    std::string data;
+    if (response.mResponseCode == 206) {
+      data = std::move(response.mBody);
+    } else if (response.mResponseCode == 200 && response.mBody.size() > first) {
+      // The server ignored the range header and sent the entire file.
+      data = response.mBody.substr(first, last - first + 1);
+    } else {
+      throw std::runtime_error(fmt::format("Failed to read bytes {}-{} of '{}': Response code {}!",
+          first, last, mUrl, response.mResponseCode));
+    }
+
+    mChunks.emplace_front(index, std::move(data));
+
+    if (mChunks.size() > REMOTE_CHUNK_COUNT) {
+      mChunks.pop_back();
+    }
+
+    return mChunks.front().second;
+  }
+};
+
+tmsize_t readRemote(thandle_t handle, void* buffer, tmsize_t size) {
+  auto*    file  = static_cast<RemoteFile*>(handle);
+  auto*    out   = static_cast<char*>(buffer);
+  tmsize_t count = 0;
+
+  try {
+    while (count < size && file->mOffset < file->mSize) {
+      auto const& chunk   = file->getChunk(file->mOffset / REMOTE_CHUNK_SIZE);
+      uint64_t    inChunk = file->mOffset % REMOTE_CHUNK_SIZE;
+
+      if (inChunk >= chunk.size()) {
+        break;
+      }
+
+      uint64_t bytes = std::min<uint64_t>(chunk.size() - inChunk, size - count);
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      std::memcpy(out + count, chunk.data() + inChunk, bytes);
+
+      count += static_cast<tmsize_t>(bytes);
+      file->mOffset += bytes;
+    }
+  } catch (std::exception const& e) {
+    logger().warn("Failed to read GeoTIFF: {}", e.what());
+  }
+
+  return count;
+}
+
+tmsize_t writeRemote(thandle_t /*handle*/, void* /*buffer*/, tmsize_t /*size*/) {
+  return 0;
+}
+
+toff_t seekRemote(thandle_t handle, toff_t offset, int whence) {
+  auto* file = static_cast<RemoteFile*>(handle);
+
+  if (whence == SEEK_SET) {
+    file->mOffset = offset;
+  } else if (whence == SEEK_CUR) {
+    file->mOffset += offset;
+  } else if (whence == SEEK_END) {
+    file->mOffset = file->mSize + offset;
+  }
+
+  return file->mOffset;
+}
+
+// The RemoteFile is owned by the Handle, so there is nothing to do here.
+int closeRemote(thandle_t /*handle*/) {
+  return 0;
+}
+
+toff_t sizeRemote(thandle_t handle) {
+  return static_cast<RemoteFile*>(handle)->mSize;
+}
+
+int mapRemote(thandle_t /*handle*/, void** /*base*/, toff_t* /*size*/) {
+  return 0;
+}
+
+void unmapRemote(thandle_t /*handle*/, void* /*base*/, toff_t /*size*/) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void convertSamples(std::vector<uint8_t> const& raw, std::vector<float>& result) {
+  result.resize(raw.size() / sizeof(T));
+  for (std::size_t i = 0; i < result.size(); ++i) {
+    T value{};
+    std::memcpy(&value, &raw[i * sizeof(T)], sizeof(T));
+    result[i] = static_cast<float>(value);
+  }
+}
+
+void convertSamples(uint16_t format, uint16_t bits, std::vector<uint8_t> const& raw,
+    std::vector<float>& result) {
+  if (format == SAMPLEFORMAT_IEEEFP && bits == 32) {
+    convertSamples<float>(raw, result);
+  } else if (format == SAMPLEFORMAT_INT && bits == 8) {
+    convertSamples<int8_t>(raw, result);
+  } else if (format == SAMPLEFORMAT_INT && bits == 16) {
+    convertSamples<int16_t>(raw, result);
+  } else if (format == SAMPLEFORMAT_INT && bits == 32) {
+    convertSamples<int32_t>(raw, result);
+  } else if (bits == 8) {
+    convertSamples<uint8_t>(raw, result);
+  } else if (bits == 16) {
+    convertSamples<uint16_t>(raw, result);
+  } else {
+    convertSamples<uint32_t>(raw, result);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TileSourceGeoTiff::Handle {
+  TIFF*                       mTiff = nullptr;
+  std::unique_ptr<RemoteFile> mRemote;
+  uint16_t                    mDirectory = 0;
+
+  Handle() = default;
+
+  Handle(Handle const& other) = delete;
+  Handle(Handle&& other)      = delete;
+
+  Handle& operator=(Handle const& other) = delete;
+  Handle& operator=(Handle&& other) = delete;
+
+  ~Handle() {
+    if (mTiff) {
+      TIFFClose(mTiff);
+    }
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceGeoTiff::TileSourceGeoTiff(uint32_t resolution)
+    : mResolution(resolution)
+    , mThreadPool(16, "GeoTIFF Loader") {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceGeoTiff::~TileSourceGeoTiff() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceGeoTiff::init() {
+  if (mIsInitialized) {
+    return;
+  }
+
+  mIsInitialized = true;
+
+  std::unique_ptr<Handle> handle;
+
+  try {
+    handle = acquireHandle();
+  } catch (std::exception const& e) {
+    logger().error("Failed to open GeoTIFF '{}': {}", mFile, e.what());
+    mInitFailed = true;
+    return;
+  }
+
+  TIFF* tif = handle->mTiff;
+
+  uint16_t planarConfig = PLANARCONFIG_CONTIG;
+  TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &mSamplesPerPixel);
+  TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &mBitsPerSample);
+  TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLEFORMAT, &mSampleFormat);
+  TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &planarConfig);
+
+  if (planarConfig != PLANARCONFIG_CONTIG || mSamplesPerPixel < 1 || mSamplesPerPixel > 4 ||
+      (mBitsPerSample != 8 && mBitsPerSample != 16 && mBitsPerSample != 32) ||
+      (mSampleFormat == SAMPLEFORMAT_IEEEFP && mBitsPerSample != 32)) {
+    logger().error("Failed to open GeoTIFF '{}': Unsupported pixel format!", mFile);
+    mInitFailed = true;
+    return;
+  }
+
+  uint32_t width  = 0;
+  uint32_t height = 0;
+  TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+  TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+
+  // The bounds are stored as (west, south, east, north) in degrees. Without geo-referencing, the
+  // raster is assumed to cover the entire body.
+  uint16_t scaleCount    = 0;
+  double*  scale         = nullptr;
+  uint16_t tiepointCount = 0;
+  double*  tiepoint      = nullptr;
+
+  if (TIFFGetField(tif, MODEL_PIXEL_SCALE_TAG, &scaleCount, &scale) && scaleCount >= 2 &&
+      TIFFGetField(tif, MODEL_TIEPOINT_TAG, &tiepointCount, &tiepoint) && tiepointCount >= 6) {
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    mBounds.x = tiepoint[3] - tiepoint[0] * scale[0];
+    mBounds.w = tiepoint[4] + tiepoint[1] * scale[1];
+    mBounds.z = mBounds.x + width * scale[0];
+    mBounds.y = mBounds.w - height * scale[1];
+    mIsGlobal = mBounds.z - mBounds.x >= 360.0 - 0.5 * scale[0];
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+
+  // The first directory contains the full resolution image, the reduced resolution images which
+  // follow are its overviews. Masks are skipped.
+  mLevels.clear();
+
+  do {
+    uint32_t subFileType = 0;
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SUBFILETYPE, &subFileType);
+
+    bool isOverview = subFileType & FILETYPE_REDUCEDIMAGE;
+    bool isMask     = subFileType & FILETYPE_MASK;
+
+    if (mLevels.empty() || (isOverview && !isMask)) {
+      Level level;
+      level.mDirectory = TIFFCurrentDirectory(tif);
+      level.mIsTiled   = TIFFIsTiled(tif);
+      TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &level.mWidth);
+      TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &level.mHeight);
+
+      if (level.mIsTiled) {
+        TIFFGetField(tif, TIFFTAG_TILEWIDTH, &level.mBlockWidth);
+        TIFFGetField(tif, TIFFTAG_TILELENGTH, &level.mBlockHeight);
+      } else {
+        level.mBlockWidth = level.mWidth;
+        TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &level.mBlockHeight);
+        level.mBlockHeight = std::min(level.mBlockHeight, level.mHeight);
+      }
+
+      level.mPixelSize = glm::radians(mBounds.z - mBounds.x) / level.mWidth;
+
+      if (level.mWidth > 0 && level.mHeight > 0 && level.mBlockWidth > 0 &&
+          level.mBlockHeight > 0) {
+        mLevels.push_back(level);
+      }
+    }
+  } while (TIFFReadDirectory(tif));
+
+  if (mLevels.empty()) {
+    logger().error("Failed to open GeoTIFF '{}': The file contains no image!", mFile);
+    mInitFailed = true;
+    return;
+  }
+
+  // The levels are sorted from fine to coarse.
+  std::sort(mLevels.begin(), mLevels.end(),
+      [](Level const& a, Level const& b) { return a.mWidth > b.mWidth; });
+
+  // Reading the directories moved the handle, so it is rewound before it is put back.
+  TIFFSetDirectory(tif, 0);
+  handle->mDirectory = 0;
+
+  releaseHandle(std::move(handle));
+
+  logger().info("Opened GeoTIFF '{}' with {} overview levels.", mFile, mLevels.size() - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceGeoTiff::fini() {
+  std::unique_lock<std::mutex> lock(mHandlesMutex);
+  mHandles.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* virtual */ std::shared_ptr<BaseTileData> TileSourceGeoTiff::loadTile(TileId const& tileId) {
+  if (mFormat == TileDataType::eElevation) {
+    return loadImpl<float>(tileId);
+  }
+  if (mFormat == TileDataType::eColor) {
+    return loadImpl<glm::u8vec4>(tileId);
+  }
+
+  throw std::domain_error(fmt::format("Unsupported format: {}!", mFormat));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::shared_ptr<BaseTileData> TileSourceGeoTiff::loadImpl(TileId const& tileId) {
+  if (!mIsInitialized || mInitFailed) {
+    return nullptr;
+  }
+
+  auto const& pool = getTilePool();
+  auto tile = pool ? pool->create<T>(mResolution) : std::make_shared<TileData<T>>(mResolution);
+
+  // The memory budget of the body is exhausted.
+  if (!tile) {
+    return nullptr;
+  }
+
+  glm::i64vec3 baseXY = HEALPix::getBaseXY(tileId);
+  glm::int64   nSide  = HEALPix::getNSide(tileId);
+
+  // Use the coarsest level which still has at least the resolution of the tile.
+  double       tilePixelSize = BASE_PATCH_SIZE / static_cast<double>(nSide) / (mResolution - 1);
+  Level const* level         = &mLevels.front();
+
+  for (auto const& l : mLevels) {
+    if (l.mPixelSize <= tilePixelSize) {
+      level = &l;
+    }
+  }
+
+  auto handle = acquireHandle();
+
+  if (handle->mDirectory != level->mDirectory) {
+    if (!TIFFSetDirectory(handle->mTiff, level->mDirectory)) {
+      throw std::runtime_error(fmt::format("Failed to read directory {}!", level->mDirectory));
+    }
+    handle->mDirectory = level->mDirectory;
+  }
+
+  // The blocks are decoded on demand and kept until the tile is finished. Blocks which could not
+  // be read are stored as empty vectors, the corresponding pixels are zero.
+  std::unordered_map<uint64_t, std::vector<float>> blocks;
+  std::vector<uint8_t>                             raw;
+
+  uint32_t blocksPerRow = (level->mWidth + level->mBlockWidth - 1) / level->mBlockWidth;
+  uint32_t channels     = mSamplesPerPixel;
+
+  auto getBlock = [&](uint32_t bx, uint32_t by) -> std::vector<float> const& {
+    uint64_t key = static_cast<uint64_t>(by) * blocksPerRow + bx;
+
+    auto [it, isNew] = blocks.try_emplace(key);
+
+    if (isNew) {
+      tmsize_t size = 0;
+
+      if (level->mIsTiled) {
+        raw.resize(TIFFTileSize(handle->mTiff));
+        uint32_t index = TIFFComputeTile(
+            handle->mTiff, bx * level->mBlockWidth, by * level->mBlockHeight, 0, 0);
+        size = TIFFReadEncodedTile(handle->mTiff, index, raw.data(), raw.size());
+      } else {
+        raw.resize(TIFFStripSize(handle->mTiff));
+        uint32_t index = TIFFComputeStrip(handle->mTiff, by * level->mBlockHeight, 0);
+        size           = TIFFReadEncodedStrip(handle->mTiff, index, raw.data(), raw.size());
+      }
+
+      if (size > 0) {
+        raw.resize(size);
+        convertSamples(mSampleFormat, mBitsPerSample, raw, it->second);
+      }
+    }
+
+    return it->second;
+  };
+
+  // Adds the samples of the given pixel, weighted by the given factor, to the result.
+  auto addPixel = [&](int64_t x, int64_t y, float weight, std::array<float, 4>& result) {
+    auto const& block = getBlock(static_cast<uint32_t>(x / level->mBlockWidth),
+        static_cast<uint32_t>(y / level->mBlockHeight));
+
+    std::size_t offset =
+        ((y % level->mBlockHeight) * level->mBlockWidth + x % level->mBlockWidth) * channels;
+
+    if (offset + channels <= block.size()) {
+      for (uint32_t c = 0; c < channels; ++c) {
+        result.at(c) += weight * block[offset + c];
+      }
+    }
+  };
+
+  auto width  = static_cast<int64_t>(level->mWidth);
+  auto height = static_cast<int64_t>(level->mHeight);
+
+  // Pixel (i, j) of the tile is located at the base patch coordinates ((x + i / (R - 1)) / nSide,
+  // (y + j / (R - 1)) / nSide). This is the same mapping the vertex shader uses.
+  std::vector<std::array<float, 4>> samples(static_cast<std::size_t>(mResolution) * mResolution);
+
+  for (uint32_t j = 0; j < mResolution; ++j) {
+    for (uint32_t i = 0; i < mResolution; ++i) {
+      auto& result = samples[j * mResolution + i];
+      result       = {};
+
+      glm::dvec2 lngLat = glm::degrees(HEALPix::convertBaseXY2LngLat(static_cast<int>(baseXY[0]),
+          (static_cast<double>(baseXY[1]) + 1.0 * i / (mResolution - 1)) / nSide,
+          (static_cast<double>(baseXY[2]) + 1.0 * j / (mResolution - 1)) / nSide));
+
+      double lng = mBounds.x + std::fmod(std::fmod(lngLat.x - mBounds.x, 360.0) + 360.0, 360.0);
+
+      if (lng > mBounds.z || lngLat.y < mBounds.y || lngLat.y > mBounds.w) {
+        continue;
+      }
+
+      // The raster covers the bounds with the pixel areas, row zero is the northern-most row.
+      double px = (lng - mBounds.x) / (mBounds.z - mBounds.x) * width - 0.5;
+      double py = (mBounds.w - lngLat.y) / (mBounds.w - mBounds.y) * height - 0.5;
+
+      auto x0 = static_cast<int64_t>(std::floor(px));
+      auto y0 = static_cast<int64_t>(std::floor(py));
+      auto fx = static_cast<float>(px - x0);
+      auto fy = static_cast<float>(py - y0);
+
+      int64_t x1 = x0 + 1;
+      int64_t y1 = std::clamp<int64_t>(y0 + 1, 0, height - 1);
+      y0         = std::clamp<int64_t>(y0, 0, height - 1);
+
+      if (mIsGlobal) {
+        x0 = (x0 + width) % width;
+        x1 = x1 % width;
+      } else {
+        x0 = std::clamp<int64_t>(x0, 0, width - 1);
+        x1 = std::clamp<int64_t>(x1, 0, width - 1);
+      }
+
+      addPixel(x0, y0, (1.F - fx) * (1.F - fy), result);
+      addPixel(x1, y0, fx * (1.F - fy), result);
+      addPixel(x0, y1, (1.F - fx) * fy, result);
+      addPixel(x1, y1, fx * fy, result);
+    }
+  }
+
+  releaseHandle(std::move(handle));
+
+  T* data = tile->template getTypedPtr<T>();
+
+  if constexpr (std::is_same_v<T, float>) {
+    for (std::size_t p = 0; p < samples.size(); ++p) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      data[p] = samples[p][0];
+    }
+  } else {
+    // Colors are scaled to eight bits.
+    float factor = 1.F;
+    if (mSampleFormat == SAMPLEFORMAT_IEEEFP) {
+      factor = 255.F;
+    } else if (mBitsPerSample == 16) {
+      factor = 1.F / 257.F;
+    }
+
+    for (std::size_t p = 0; p < samples.size(); ++p) {
+      glm::vec4 color(samples[p][0], samples[p][0], samples[p][0], 255.F / factor);
+
+      if (channels == 2) {
+        color.a = samples[p][1];
+      } else if (channels >= 3) {
+        color.g = samples[p][1];
+        color.b = samples[p][2];
+        if (channels == 4) {
+          color.a = samples[p][3];
+        }
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      data[p] = glm::u8vec4(glm::clamp(color * factor + 0.5F, 0.F, 255.F));
+    }
+
+    if (getCompressColorTiles()) {
+      tile->getCompressedData().resize(compression::getBC1Size(mResolution));
+      compression::encodeBC1(data, mResolution, tile->getCompressedData().data());
+    }
+  }
+
+  return tile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* virtual */ std::shared_ptr<TileRequest> TileSourceGeoTiff::loadTileAsync(
+    TileId const& tileId, TileRequest::Priority priority, OnLoadCallback cb) {
+  auto request = std::make_shared<TileRequest>(tileId, priority);
+
+  {
+    std::unique_lock<std::mutex> lock(mAsyncRequestsMutex);
+    mAsyncRequests.push_back({request, std::move(cb)});
+  }
+
+  mThreadPool.enqueue(request->getPriority(), [this]() { processAsyncRequest(); });
+
+  return request;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceGeoTiff::processAsyncRequest() {
+  AsyncRequest next;
+
+  {
+    std::unique_lock<std::mutex> lock(mAsyncRequestsMutex);
+
+    auto best = mAsyncRequests.end();
+    for (auto it = mAsyncRequests.begin(); it != mAsyncRequests.end(); ++it) {
+      if (it->mRequest->isCancelled()) {
+        best = it;
+        break;
+      }
+
+      if (best == mAsyncRequests.end() ||
+          it->mRequest->getPriority() < best->mRequest->getPriority()) {
+        best = it;
+      }
+    }
+
+    // There is exactly one call to this method for each request, so this should never happen.
+    if (best == mAsyncRequests.end()) {
+      return;
+    }
+
+    next = std::move(*best);
+    mAsyncRequests.erase(best);
+  }
+
+  TileId const&                 tileId = next.mRequest->getTileId();
+  std::shared_ptr<BaseTileData> tile;
+
+  if (!next.mRequest->isCancelled()) {
+    cs::utils::FrameStats::ScopedTimer timer("Load Tile", cs::utils::FrameStats::TimerMode::eCPU);
+
+    try {
+      tile = loadTile(tileId);
+    } catch (std::exception const& e) {
+      logger().warn("Tile loading failed: {}", e.what());
+    }
+  }
+
+  // The callback has to be invoked in any case, else the TreeManager would wait forever.
+  next.mCallback(tileId, std::move(tile));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileSourceGeoTiff::getPendingRequests() {
+  return static_cast<int>(mThreadPool.getPendingTaskCount() + mThreadPool.getRunningTaskCount());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<TileSourceGeoTiff::Handle> TileSourceGeoTiff::acquireHandle() {
+  {
+    std::unique_lock<std::mutex> lock(mHandlesMutex);
+    if (!mHandles.empty()) {
+      auto handle = std::move(mHandles.back());
+      mHandles.pop_back();
+      return handle;
+    }
+  }
+
+  std::call_once(tagExtenderFlag, []() {
+    parentTagExtender = TIFFSetTagExtender(extendTags);
+    TIFFSetWarningHandler(nullptr);
+  });
+
+  auto handle = std::make_unique<Handle>();
+
+  if (cs::utils::startsWith(mFile, "http://") || cs::utils::startsWith(mFile, "https://")) {
+    cs::utils::HttpClient::Request request;
+    request.mUrl      = mFile;
+    request.mHeadOnly = true;
+
+    auto response = cs::utils::HttpClient::get().perform(request);
+    auto length   = response.mHeaders.find("content-length");
+
+    if (response.mResponseCode != 200 || length == response.mHeaders.end()) {
+      throw std::runtime_error(fmt::format(
+          "Failed to get the size of '{}': Response code {}!", mFile, response.mResponseCode));
+    }
+
+    handle->mRemote        = std::make_unique<RemoteFile>();
+    handle->mRemote->mUrl  = mFile;
+    handle->mRemote->mSize = std::stoull(length->second);
+
+    handle->mTiff = TIFFClientOpen(mFile.c_str(), "rm", handle->mRemote.get(), readRemote,
+        writeRemote, seekRemote, closeRemote, sizeRemote, mapRemote, unmapRemote);
+  } else {
+    handle->mTiff = TIFFOpen(mFile.c_str(), "r");
+  }
+
+  if (!handle->mTiff) {
+    throw std::runtime_error(fmt::format("Failed to open '{}'!", mFile));
+  }
+
+  return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceGeoTiff::releaseHandle(std::unique_ptr<Handle> handle) {
+  std::unique_lock<std::mutex> lock(mHandlesMutex);
+  mHandles.push_back(std::move(handle));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TileSourceGeoTiff::getResolution() const {
+  return mResolution;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceGeoTiff::setFile(std::string const& file) {
+  mFile = file;
+}
+
+std::string const& TileSourceGeoTiff::getFile() const {
+  return mFile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceGeoTiff::setDataType(TileDataType type) {
+  mFormat = type;
+}
+
+TileDataType TileSourceGeoTiff::getDataType() const {
+  return mFormat;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileSourceGeoTiff::isSame(TileSource const* other) const {
+  auto const* casted = dynamic_cast<TileSourceGeoTiff const*>(other);
+
+  return casted != nullptr && mFile == casted->mFile && mFormat == casted->mFormat &&
+         mResolution == casted->mResolution;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILESOURCEGEOTIFF_HPP
+#define CSP_LOD_BODIES_TILESOURCEGEOTIFF_HPP
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "TileData.hpp"
+#include "TileSource.hpp"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// The data of the tiles is read directly from a GeoTIFF file, preferably a Cloud-Optimized
+/// GeoTIFF (COG). The file can either be a local file or an http(s) URL. Remote files are read with
+/// HTTP range requests, so only the parts of the file which are actually required are transferred.
+///
+/// The raster has to be in geographic coordinates (longitude and latitude in degrees, for example
+/// EPSG:4326 or a planetocentric equivalent), other projections are not supported. If no
+/// geo-referencing tags are present, the raster is assumed to cover the entire body. Each tile is
+/// resampled bilinearly from the overview level whose resolution matches the tile best, so coarse
+/// tiles only read a few blocks of the file. Any number of samples per pixel from one to four with
+/// 8, 16 or 32 bits is supported.
+class TileSourceGeoTiff : public TileSource {
+ public:
+  TileSourceGeoTiff(uint32_t resolution);
+
+  TileSourceGeoTiff(TileSourceGeoTiff const& other) = delete;
+  TileSourceGeoTiff(TileSourceGeoTiff&& other)      = delete;
+
+  TileSourceGeoTiff& operator=(TileSourceGeoTiff const& other) = delete;
+  TileSourceGeoTiff& operator=(TileSourceGeoTiff&& other) = delete;
+
+  ~TileSourceGeoTiff() override;
+
+  /// Opens the file and reads the layout of all its overview levels. If this fails, an error is
+  /// logged and no tiles will be loaded.
+  void init() override;
+
+  /// Closes all open file handles.
+  void fini() override;
+
+  std::shared_ptr<BaseTileData> loadTile(TileId const& tileId) override;
+
+  std::shared_ptr<TileRequest> loadTileAsync(
+      TileId const& tileId, TileRequest::Priority priority, OnLoadCallback cb) override;
+  int                          getPendingRequests() override;
+
+  uint32_t getResolution() const;
+
+  /// This can be a path to a local file or an http(s) URL.
+  void               setFile(std::string const& file);
+  std::string const& getFile() const;
+
+  void         setDataType(TileDataType type);
+  TileDataType getDataType() const override;
+
+  bool isSame(TileSource const* other) const override;
+
+ private:
+  /// An asynchronous request which has not been started yet.
+  struct AsyncRequest {
+    std::shared_ptr<TileRequest> mRequest;
+    OnLoadCallback               mCallback;
+  };
+
+  /// One image file directory of the GeoTIFF, either the full resolution image or an overview.
+  struct Level {
+    uint16_t mDirectory   = 0;
+    uint32_t mWidth       = 0;
+    uint32_t mHeight      = 0;
+    uint32_t mBlockWidth  = 0;
+    uint32_t mBlockHeight = 0;
+    bool     mIsTiled     = false;
+
+    /// The size of one pixel in radians along the longitude axis.
+    double mPixelSize = 0.0;
+  };
+
+  /// An open libtiff handle. As libtiff is not thread-safe, each loading thread uses its own.
+  struct Handle;
+
+  /// See the WebMapService tile source. Each call to loadTileAsync() enqueues one call to this
+  /// method which loads the oldest request with the highest priority.
+  void processAsyncRequest();
+
+  template <typename T>
+  std::shared_ptr<BaseTileData> loadImpl(TileId const& tileId);
+
+  std::unique_ptr<Handle> acquireHandle();
+  void                    releaseHandle(std::unique_ptr<Handle> handle);
+
+  std::string  mFile;
+  TileDataType mFormat = TileDataType::eColor;
+  uint32_t     mResolution;
+
+  // These are set by init().
+  bool               mIsInitialized = false;
+  bool               mInitFailed    = false;
+  std::vector<Level> mLevels;
+  glm::dvec4         mBounds{-180.0, -90.0, 180.0, 90.0};
+  bool               mIsGlobal        = true;
+  uint16_t           mSamplesPerPixel = 1;
+  uint16_t           mBitsPerSample   = 8;
+  uint16_t           mSampleFormat    = 1;
+
+  std::vector<std::unique_ptr<Handle>> mHandles;
+  std::mutex                           mHandlesMutex;
+
+  std::vector<AsyncRequest> mAsyncRequests;
+  std::mutex                mAsyncRequestsMutex;
+
+  // The thread pool is declared last so that it is destroyed first. Its destructor waits for all
+  // tasks to be finished and these still access the members above.
+  cs::utils::ThreadPool mThreadPool;
+};
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILESOURCEGEOTIFF_HPP
@@ -8,20 +8,23 @@
 #include "TileSourceWebMapService.hpp"
 
 #include "HEALPix.hpp"
+#include "TileCompression.hpp"
 #include "TileNode.hpp"
+#include "TilePool.hpp"
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/HttpClient.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
+#include <array>
 #include <boost/filesystem.hpp>
-#include <curlpp/Easy.hpp>
-#include <curlpp/Info.hpp>
-#include <curlpp/Infos.hpp>
-#include <curlpp/Options.hpp>
-#include <curlpp/cURLpp.hpp>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -43,20 +46,21 @@ enum class CopyPixels { eAll, eAboveDiagonal, eBelowDiagonal };
 
 template <typename T>
 bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const& tileId, int x,
-    int y, CopyPixels which) {
+    int y, CopyPixels which, TileRequest const* request, bool keepCacheFile) {
   std::optional<std::string> cacheFile;
 
   // First we download the tile data to a local cache file. This will return quickly if the file is
   // already downloaded but will take some time if it needs to be fetched from the server.
   try {
-    cacheFile = source->loadData(tileId, x, y);
+    cacheFile = source->loadData(tileId, x, y, request);
   } catch (std::exception const& e) {
     // This is not critical, the planet will just not refine any further.
     logger().debug("Tile loading failed: {}", e.what());
     return false;
   }
 
-  // Data is not available. That's most likely due to our server being offline.
+  // Data is not available. That's most likely due to our server being offline or the request has
+  // been cancelled.
   if (!cacheFile) {
     return false;
   }
@@ -87,12 +91,15 @@ bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const&
       boost::filesystem::remove(*cacheFile);
       return false;
     }
+    // For partial tiles, each scanline is read into this temporary buffer first. For complete
+    // tiles, the scanlines are read directly into the tile data.
+    std::vector<float> tmp(which == CopyPixels::eAll ? 0 : resolution);
+
     int tiffReturn{};
     for (int y = 0; y < imagelength; y++) {
       if (which == CopyPixels::eAll) {
         tiffReturn = TIFFReadScanline(data, &tileData[resolution * y], y);
       } else if (which == CopyPixels::eAboveDiagonal) {
-        std::vector<float> tmp(resolution);
         tiffReturn = TIFFReadScanline(data, tmp.data(), y);
         int offset = resolution * y;
         int count  = resolution - y - 1;
@@ -100,7 +107,6 @@ bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const&
         // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
         std::memcpy(tileData + offset, tmp.data(), count * sizeof(float));
       } else if (which == CopyPixels::eBelowDiagonal) {
-        std::vector<float> tmp(resolution);
         tiffReturn = TIFFReadScanline(data, tmp.data(), y);
         int offset = resolution * y + (resolution - y);
         int count  = y;
@@ -162,6 +168,11 @@ bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const&
     stbi_image_free(data);
   }
 
+  // If the decoded data is stored in a TileCache, there's no need to keep the downloaded file.
+  if (!keepCacheFile) {
+    boost::filesystem::remove(*cacheFile);
+  }
+
   return true;
 }
 
@@ -180,27 +191,75 @@ void fillDiagonal(BaseTileData* tile) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template <typename T>
-std::shared_ptr<BaseTileData> loadImpl(TileSourceWebMapService* source, TileId const& tileId) {
-  auto tile = std::make_shared<TileData<T>>(source->getResolution());
+std::shared_ptr<BaseTileData> loadImpl(
+    TileSourceWebMapService* source, TileId const& tileId, TileRequest const* request = nullptr) {
+  auto const& pool = source->getTilePool();
+  auto        tile = pool ? pool->create<T>(source->getResolution())
+                          : std::make_shared<TileData<T>>(source->getResolution());
+
+  // The memory budget of the body is exhausted.
+  if (!tile) {
+    return nullptr;
+  }
+
+  // Compressed color tiles are also stored compressed in the TileCache. Elevation tiles which are
+  // quantized on the GPU are stored quantized as well.
+  bool compress = source->getCompressColorTiles() && tile->getDataType() == TileDataType::eColor;
+  bool quantize =
+      source->getCompressElevationTiles() && tile->getDataType() == TileDataType::eElevation;
+
+  // If a TileCache is used, downloading and decoding can be skipped if the tile is already in
+  // there.
+  auto     cache = source->getTileCache();
+  uint64_t key{};
+
+  if (cache) {
+    key = TileCache::getKey(tileId, tile->getDataType(), source->getResolution(),
+        source->getUrl(), source->getLayers());
+
+    if (cache->read(key, [&](void const* payload) {
+          if (compress) {
+            auto const* blocks = static_cast<uint8_t const*>(payload);
+
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            tile->getCompressedData().assign(blocks, blocks + cache->getPayloadSize());
+
+            // Decompressing is cheap, this way the pixel data remains valid as well.
+            compression::decodeBC1(
+                blocks, tile->getResolution(), tile->template getTypedPtr<glm::u8vec4>());
+          } else if (quantize) {
+            compression::decodeHeights(static_cast<uint8_t const*>(payload), tile->getResolution(),
+                tile->template getTypedPtr<float>());
+          } else {
+            std::memcpy(tile->getDataPtr(), payload, cache->getPayloadSize());
+          }
+        })) {
+      return tile;
+    }
+  }
+
+  bool keepCacheFile = cache == nullptr;
 
   int  x{};
   int  y{};
   bool onDiag = csp::lodbodies::TileSourceWebMapService::getXY(tileId, x, y);
   if (onDiag) {
-    if (!loadImpl<T>(source, tile.get(), tileId, x, y, CopyPixels::eBelowDiagonal)) {
+    if (!loadImpl<T>(
+            source, tile.get(), tileId, x, y, CopyPixels::eBelowDiagonal, request, keepCacheFile)) {
       return nullptr;
     }
 
     x += 4 * (1 << tileId.level());
     y -= 4 * (1 << tileId.level());
 
-    if (!loadImpl<T>(source, tile.get(), tileId, x, y, CopyPixels::eAboveDiagonal)) {
+    if (!loadImpl<T>(
+            source, tile.get(), tileId, x, y, CopyPixels::eAboveDiagonal, request, keepCacheFile)) {
       return nullptr;
     }
 
     fillDiagonal<T>(tile.get());
   } else {
-    if (!loadImpl<T>(source, tile.get(), tileId, x, y, CopyPixels::eAll)) {
+    if (!loadImpl<T>(source, tile.get(), tileId, x, y, CopyPixels::eAll, request, keepCacheFile)) {
       return nullptr;
     }
   }
@@ -217,6 +276,20 @@ std::shared_ptr<BaseTileData> loadImpl(TileSourceWebMapService* source, TileId c
         data + (resolution - 1 - i) * resolution);
   }
 
+  if (compress) {
+    tile->getCompressedData().resize(compression::getBC1Size(resolution));
+    compression::encodeBC1(tile->template getTypedPtr<glm::u8vec4>(), resolution,
+        tile->getCompressedData().data());
+  }
+
+  if (cache && quantize) {
+    std::vector<uint8_t> encoded(compression::getEncodedHeightsSize(resolution));
+    compression::encodeHeights(tile->template getTypedPtr<float>(), resolution, encoded.data());
+    cache->write(key, encoded.data());
+  } else if (cache) {
+    cache->write(key, compress ? tile->getCompressedData().data() : tile->getDataPtr());
+  }
+
   return tile;
 }
 
@@ -231,8 +304,18 @@ std::mutex TileSourceWebMapService::mFileSystemMutex;
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 TileSourceWebMapService::TileSourceWebMapService(uint32_t resolution)
-    : mThreadPool(32)
-    , mResolution(resolution) {
+    : mResolution(resolution)
+    , mThreadPool(std::max(1U, std::thread::hardware_concurrency()), "Tile Loader") {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceWebMapService::~TileSourceWebMapService() {
+
+  // The running downloads are aborted by their progress callbacks once mShuttingDown is set.
+  std::unique_lock<std::mutex> lock(mDownloadsMutex);
+  mShuttingDown = true;
+  mDownloadsCondition.wait(lock, [this]() { return mPendingDownloads == 0; });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -278,7 +361,76 @@ bool TileSourceWebMapService::getXY(TileId const& tileId, int& x, int& y) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::optional<std::string> TileSourceWebMapService::loadData(TileId const& tileId, int x, int y) {
+std::optional<std::string> TileSourceWebMapService::loadData(
+    TileId const& tileId, int x, int y, TileRequest const* tileRequest) {
+
+  ImageLocation location = getImageLocation(tileId, x, y);
+
+  // The file is already there, we can return it.
+  if (boost::filesystem::exists(location.mCacheFile) &&
+      boost::filesystem::file_size(location.mCacheFile) > 0) {
+    return location.mCacheFile;
+  }
+
+  // The file is not available but the server is marked as 'offline'. In this case we can do nothing
+  // but return std::nullopt.
+  if (mUrl == "offline") {
+    return std::nullopt;
+  }
+
+  // There is no need to download anything if nobody is interested in the tile anymore.
+  if (tileRequest && tileRequest->isCancelled()) {
+    return std::nullopt;
+  }
+
+  prepareCacheFile(location);
+
+  std::string contentType;
+  {
+    std::ofstream out;
+    out.open(location.mCacheFile, std::ofstream::out | std::ofstream::binary);
+
+    if (!out) {
+      throw std::runtime_error(fmt::format(
+          "Failed to download tile data: Cannot open '{}' for writing!", location.mCacheFile));
+    }
+
+    cs::utils::HttpClient::Request request;
+    request.mUrl    = location.mUrl;
+    request.mOutput = &out;
+
+    // If a TileRequest is given, the transfer is aborted as soon as the request gets cancelled.
+    if (tileRequest) {
+      request.mPriority         = tileRequest->getPriority();
+      request.mProgressCallback = [tileRequest](double /*unused*/, double /*unused*/) {
+        return tileRequest->isCancelled();
+      };
+    }
+
+    // Make sure that no partially downloaded file remains in the cache.
+    try {
+      contentType = cs::utils::HttpClient::get().perform(request).mContentType;
+    } catch (...) {
+      out.close();
+      boost::filesystem::remove(location.mCacheFile);
+
+      if (tileRequest && tileRequest->isCancelled()) {
+        return std::nullopt;
+      }
+
+      throw;
+    }
+  }
+
+  finishCacheFile(location, contentType);
+
+  return location.mCacheFile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceWebMapService::ImageLocation TileSourceWebMapService::getImageLocation(
+    TileId const& tileId, int x, int y) const {
 
   std::string format;
   std::string type;
@@ -347,70 +499,85 @@ std::optional<std::string> TileSourceWebMapService::loadData(TileId const& tileI
       << "&width=" << mResolution << "&height=" << mResolution
       << "&srs=EPSG:900914&format=" << format;
 
-  auto cacheFilePath(boost::filesystem::path(cacheFile.str()));
+  return {url.str(), cacheDir.str(), cacheFile.str()};
+}
 
-  // The file is already there, we can return it.
-  if (boost::filesystem::exists(cacheFilePath) &&
-      boost::filesystem::file_size(cacheFile.str()) > 0) {
-    return cacheFile.str();
-  }
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  // The file is not available but the server is marked as 'offline'. In this case we can do nothing
-  // but return std::nullopt.
+std::vector<TileSourceWebMapService::ImageLocation> TileSourceWebMapService::getMissingImages(
+    TileId const& tileId) {
+
+  // Nothing can be downloaded anyway.
   if (mUrl == "offline") {
-    return std::nullopt;
+    return {};
   }
 
-  {
-    std::unique_lock<std::mutex> lock(mFileSystemMutex);
-
-    // Try to create the cache directory if necessary.
-    auto cacheDirPath(boost::filesystem::absolute(boost::filesystem::path(cacheDir.str())));
-    if (!(boost::filesystem::exists(cacheDirPath))) {
-      try {
-        cs::utils::filesystem::createDirectoryRecursively(
-            cacheDirPath, boost::filesystem::perms::all_all);
-      } catch (std::exception& e) {
-        throw std::runtime_error(fmt::format("Failed to create cache directory '{}'!", e.what()));
-      }
-    }
-
-    // The file is there but obviously corrupt. Remove it.
-    if (boost::filesystem::exists(cacheFilePath) &&
-        boost::filesystem::file_size(cacheFile.str()) == 0) {
-      boost::filesystem::remove(cacheFilePath);
-    }
+  // Decoded tiles do not require any image.
+  auto cache = getTileCache();
+  if (cache && cache->contains(TileCache::getKey(tileId, mFormat, mResolution, mUrl, mLayers))) {
+    return {};
   }
 
-  bool fail = false;
-  {
-    std::ofstream out;
-    out.open(cacheFile.str(), std::ofstream::out | std::ofstream::binary);
+  std::vector<ImageLocation> images;
 
-    if (!out) {
-      throw std::runtime_error(fmt::format(
-          "Failed to download tile data: Cannot open '{}' for writing!", cacheFile.str()));
+  auto addIfMissing = [&](int x, int y) {
+    ImageLocation location = getImageLocation(tileId, x, y);
+    if (!boost::filesystem::exists(location.mCacheFile) ||
+        boost::filesystem::file_size(location.mCacheFile) == 0) {
+      images.push_back(std::move(location));
     }
+  };
+
+  // Tiles on the diagonal of base patch 4 are composed of two images, see loadImpl().
+  int x{};
+  int y{};
+  if (getXY(tileId, x, y)) {
+    addIfMissing(x, y);
+    addIfMissing(x + 4 * (1 << tileId.level()), y - 4 * (1 << tileId.level()));
+  } else {
+    addIfMissing(x, y);
+  }
 
-    curlpp::Easy request;
-    request.setOpt(curlpp::options::Url(url.str()));
-    request.setOpt(curlpp::options::WriteStream(&out));
-    request.setOpt(curlpp::options::NoSignal(true));
+  return images;
+}
 
-    request.perform();
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    auto contentType = curlpp::Info<CURLINFO_CONTENT_TYPE, std::string>::get(request);
+void TileSourceWebMapService::prepareCacheFile(ImageLocation const& location) {
+  std::unique_lock<std::mutex> lock(mFileSystemMutex);
+
+  // Try to create the cache directory if necessary.
+  auto cacheDirPath(boost::filesystem::absolute(boost::filesystem::path(location.mCacheDirectory)));
+  if (!(boost::filesystem::exists(cacheDirPath))) {
+    try {
+      cs::utils::filesystem::createDirectoryRecursively(
+          cacheDirPath, boost::filesystem::perms::all_all);
+    } catch (std::exception& e) {
+      throw std::runtime_error(fmt::format("Failed to create cache directory '{}'!", e.what()));
+    }
+  }
 
-    fail = !cs::utils::contains(contentType, "image/png") &&
-           !cs::utils::contains(contentType, "image/tiff");
+  // The file is there but obviously corrupt. Remove it.
+  if (boost::filesystem::exists(location.mCacheFile) &&
+      boost::filesystem::file_size(location.mCacheFile) == 0) {
+    boost::filesystem::remove(location.mCacheFile);
   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceWebMapService::finishCacheFile(
+    ImageLocation const& location, std::string const& contentType) {
 
-  if (fail) {
-    std::ifstream     in(cacheFile.str());
+  if (!cs::utils::contains(contentType, "image/png") &&
+      !cs::utils::contains(contentType, "image/tiff")) {
     std::stringstream sstr;
-    sstr << in.rdbuf();
+    {
+      std::ifstream in(location.mCacheFile);
+      sstr << in.rdbuf();
+    }
 
-    std::remove(cacheFile.str().c_str());
+    std::remove(location.mCacheFile.c_str());
     throw std::runtime_error(sstr.str());
   }
 
@@ -418,24 +585,228 @@ std::optional<std::string> TileSourceWebMapService::loadData(TileId const& tileI
       boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write |
       boost::filesystem::perms::group_read | boost::filesystem::perms::group_write |
       boost::filesystem::perms::others_read | boost::filesystem::perms::others_write;
-  boost::filesystem::permissions(cacheFilePath, filePerms);
+  boost::filesystem::permissions(location.mCacheFile, filePerms);
+}
 
-  return cacheFile.str();
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* virtual */ std::shared_ptr<TileRequest> TileSourceWebMapService::loadTileAsync(
+    TileId const& tileId, TileRequest::Priority priority, OnLoadCallback cb) {
+  auto request = std::make_shared<TileRequest>(tileId, priority);
+
+  {
+    std::unique_lock<std::mutex> lock(mAsyncRequestsMutex);
+    mAsyncRequests.push_back({request, std::move(cb)});
+  }
+
+  mThreadPool.enqueue(request->getPriority(), [this]() { processAsyncRequest(); });
+
+  return request;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-/* virtual */ void TileSourceWebMapService::loadTileAsync(TileId const& tileId, OnLoadCallback cb) {
-  mThreadPool.enqueue([=]() {
-    auto tile = loadTile(tileId);
-    cb(tileId, std::move(tile));
-  });
+void TileSourceWebMapService::processAsyncRequest() {
+  AsyncRequest next;
+
+  {
+    std::unique_lock<std::mutex> lock(mAsyncRequestsMutex);
+
+    auto best = mAsyncRequests.end();
+    for (auto it = mAsyncRequests.begin(); it != mAsyncRequests.end(); ++it) {
+      if (it->mRequest->isCancelled()) {
+        best = it;
+        break;
+      }
+
+      if (best == mAsyncRequests.end() ||
+          it->mRequest->getPriority() < best->mRequest->getPriority()) {
+        best = it;
+      }
+    }
+
+    // There is exactly one call to this method for each request, so this should never happen.
+    if (best == mAsyncRequests.end()) {
+      return;
+    }
+
+    next = std::move(*best);
+    mAsyncRequests.erase(best);
+  }
+
+  // Cancelled requests are finished right away.
+  if (next.mRequest->isCancelled() || mShuttingDown) {
+    next.mCallback(next.mRequest->getTileId(), nullptr);
+    return;
+  }
+
+  // If some images of the tile have to be downloaded, this thread is not blocked while waiting for
+  // them. Instead, the tile is decoded once they have been received.
+  std::vector<ImageLocation> images;
+
+  try {
+    images = getMissingImages(next.mRequest->getTileId());
+  } catch (std::exception const& e) {
+    logger().warn("Tile loading failed: {}", e.what());
+  }
+
+  if (!images.empty()) {
+    downloadAsync(std::move(next), images);
+    return;
+  }
+
+  decodeAsyncRequest(next);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceWebMapService::downloadAsync(
+    AsyncRequest request, std::vector<ImageLocation> const& images) {
+
+  {
+    std::unique_lock<std::mutex> lock(mDownloadsMutex);
+
+    // No new downloads are started once the destructor waits for the running ones.
+    if (mShuttingDown) {
+      lock.unlock();
+      request.mCallback(request.mRequest->getTileId(), nullptr);
+      return;
+    }
+
+    ++mPendingDownloads;
+  }
+
+  // This is shared by the completion handlers of all downloads of this tile. The last one to
+  // finish continues with decoding the tile.
+  struct Downloads {
+    AsyncRequest      mRequest;
+    std::atomic<int>  mRemaining;
+    std::atomic<bool> mFailed{false};
+  };
+
+  auto downloads        = std::make_shared<Downloads>();
+  downloads->mRequest   = std::move(request);
+  downloads->mRemaining = static_cast<int>(images.size());
+
+  auto onDownloadFinished = [this, downloads](bool success) {
+    if (!success) {
+      downloads->mFailed = true;
+    }
+
+    if (--downloads->mRemaining > 0) {
+      return;
+    }
+
+    // The callback has to be invoked in any case, else the TreeManager would wait forever.
+    if (downloads->mFailed) {
+      downloads->mRequest.mCallback(downloads->mRequest.mRequest->getTileId(), nullptr);
+    } else {
+      mThreadPool.enqueue(downloads->mRequest.mRequest->getPriority(),
+          [this, downloads]() { decodeAsyncRequest(downloads->mRequest); });
+    }
+
+    // The destructor waits until there are no pending downloads and may destroy the condition
+    // variable right afterwards. Hence it has to be notified while the mutex is still held.
+    std::unique_lock<std::mutex> lock(mDownloadsMutex);
+    --mPendingDownloads;
+    mDownloadsCondition.notify_all();
+  };
+
+  TileRequest const* tileRequest = downloads->mRequest.mRequest.get();
+
+  for (auto const& location : images) {
+    std::shared_ptr<std::ofstream> out;
+
+    try {
+      prepareCacheFile(location);
+
+      out = std::make_shared<std::ofstream>(
+          location.mCacheFile, std::ofstream::out | std::ofstream::binary);
+
+      if (!*out) {
+        throw std::runtime_error(fmt::format(
+            "Failed to download tile data: Cannot open '{}' for writing!", location.mCacheFile));
+      }
+    } catch (std::exception const& e) {
+      logger().warn("Tile loading failed: {}", e.what());
+      onDownloadFinished(false);
+      continue;
+    }
+
+    cs::utils::HttpClient::Request httpRequest;
+    httpRequest.mUrl              = location.mUrl;
+    httpRequest.mOutput           = out.get();
+    httpRequest.mPriority         = tileRequest->getPriority();
+    httpRequest.mProgressCallback = [this, tileRequest](double /*unused*/, double /*unused*/) {
+      return tileRequest->isCancelled() || mShuttingDown;
+    };
+
+    // This is executed on the I/O thread of the HttpClient, so it only checks the received file.
+    cs::utils::HttpClient::get().performAsync(std::move(httpRequest),
+        [tileRequest, location, out, onDownloadFinished](
+            cs::utils::HttpClient::Response response, std::exception_ptr const& error) {
+          out->close();
+
+          // Make sure that no partially downloaded file remains in the cache.
+          if (error) {
+            boost::filesystem::remove(location.mCacheFile);
+
+            if (!tileRequest->isCancelled()) {
+              try {
+                std::rethrow_exception(error);
+              } catch (std::exception const& e) {
+                // This is not critical, the planet will just not refine any further.
+                logger().debug("Tile loading failed: {}", e.what());
+              }
+            }
+
+            onDownloadFinished(false);
+            return;
+          }
+
+          try {
+            finishCacheFile(location, response.mContentType);
+          } catch (std::exception const& e) {
+            logger().warn("Tile loading failed: {}", e.what());
+            onDownloadFinished(false);
+            return;
+          }
+
+          onDownloadFinished(true);
+        });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceWebMapService::decodeAsyncRequest(AsyncRequest const& request) {
+  TileId const&                 tileId = request.mRequest->getTileId();
+  std::shared_ptr<BaseTileData> tile;
+
+  if (!request.mRequest->isCancelled()) {
+    cs::utils::FrameStats::ScopedTimer timer("Load Tile", cs::utils::FrameStats::TimerMode::eCPU);
+
+    try {
+      if (mFormat == TileDataType::eElevation) {
+        tile = loadImpl<float>(this, tileId, request.mRequest.get());
+      } else if (mFormat == TileDataType::eColor) {
+        tile = loadImpl<glm::u8vec4>(this, tileId, request.mRequest.get());
+      }
+    } catch (std::exception const& e) {
+      logger().warn("Tile loading failed: {}", e.what());
+    }
+  }
+
+  // The callback has to be invoked in any case, else the TreeManager would wait forever.
+  request.mCallback(tileId, std::move(tile));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 int TileSourceWebMapService::getPendingRequests() {
-  return static_cast<int>(mThreadPool.getPendingTaskCount() + mThreadPool.getRunningTaskCount());
+  std::unique_lock<std::mutex> lock(mDownloadsMutex);
+  return static_cast<int>(mThreadPool.getPendingTaskCount() + mThreadPool.getRunningTaskCount()) +
+         mPendingDownloads;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -448,6 +819,10 @@ uint32_t TileSourceWebMapService::getResolution() const {
 
 void TileSourceWebMapService::setCacheDirectory(std::string const& cacheDirectory) {
   mCache = cacheDirectory;
+
+  std::unique_lock<std::mutex> lock(mTileCacheMutex);
+  mTileCache       = nullptr;
+  mTileCacheFailed = false;
 }
 
 std::string const& TileSourceWebMapService::getCacheDirectory() const {
@@ -456,6 +831,49 @@ std::string const& TileSourceWebMapService::getCacheDirectory() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileSourceWebMapService::setTileCacheSize(uint32_t megabytes) {
+  mTileCacheSize = megabytes;
+
+  std::unique_lock<std::mutex> lock(mTileCacheMutex);
+  mTileCache       = nullptr;
+  mTileCacheFailed = false;
+}
+
+uint32_t TileSourceWebMapService::getTileCacheSize() const {
+  return mTileCacheSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TileCache> TileSourceWebMapService::getTileCache() {
+  std::unique_lock<std::mutex> lock(mTileCacheMutex);
+
+  if (!mTileCache && !mTileCacheFailed && mTileCacheSize > 0) {
+    std::size_t payloadSize = static_cast<std::size_t>(mResolution) * mResolution *
+                              (mFormat == TileDataType::eElevation ? sizeof(float)
+                                                                   : sizeof(glm::u8vec4));
+
+    if (mFormat == TileDataType::eColor && getCompressColorTiles()) {
+      payloadSize = compression::getBC1Size(mResolution);
+    } else if (mFormat == TileDataType::eElevation && getCompressElevationTiles()) {
+      payloadSize = compression::getEncodedHeightsSize(mResolution);
+    }
+
+    try {
+      mTileCache = TileCache::get(
+          mCache, payloadSize, static_cast<std::size_t>(mTileCacheSize) * 1024 * 1024);
+    } catch (std::exception const& e) {
+      logger().warn("Failed to open tile cache in '{}': {} Tiles will be cached as separate files.",
+          mCache, e.what());
+      mTileCacheFailed = true;
+    }
+  }
+
+  return mTileCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TileSourceWebMapService::setLayers(std::string const& layers) {
   mLayers = layers;
 }
@@ -478,6 +896,10 @@ std::string const& TileSourceWebMapService::getUrl() const {
 
 void TileSourceWebMapService::setDataType(TileDataType type) {
   mFormat = type;
+
+  std::unique_lock<std::mutex> lock(mTileCacheMutex);
+  mTileCache       = nullptr;
+  mTileCacheFailed = false;
 }
 
 TileDataType TileSourceWebMapService::getDataType() const {
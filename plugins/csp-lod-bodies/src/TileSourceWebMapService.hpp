@@ -9,16 +9,25 @@
 #define CSP_LOD_BODIES_TILESOURCEWMS_HPP
 
 #include "../../../src/cs-utils/ThreadPool.hpp"
+#include "TileCache.hpp"
 #include "TileData.hpp"
 #include "TileSource.hpp"
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace csp::lodbodies {
 
-/// The data of the tiles is fetched via a web map service.
+/// The data of the tiles is fetched via a web map service. Asynchronous requests are loaded in
+/// stages: The tiles are first looked up in the caches on a worker thread. Missing images are then
+/// downloaded asynchronously via the cs::utils::HttpClient, so no worker thread is blocked while
+/// waiting for the server. Once all images of a tile have been received, the tile is decoded on a
+/// worker thread again. Hence, the thread pool only needs to be as large as the number of cores.
 class TileSourceWebMapService : public TileSource {
  public:
   TileSourceWebMapService(uint32_t resolution);
@@ -29,7 +38,8 @@ class TileSourceWebMapService : public TileSource {
   TileSourceWebMapService& operator=(TileSourceWebMapService const& other) = delete;
   TileSourceWebMapService& operator=(TileSourceWebMapService&& other) = delete;
 
-  ~TileSourceWebMapService() override = default;
+  /// Aborts all running downloads and waits until they have finished.
+  ~TileSourceWebMapService() override;
 
   void init() override {
   }
@@ -39,14 +49,26 @@ class TileSourceWebMapService : public TileSource {
 
   std::shared_ptr<BaseTileData> loadTile(TileId const& tileId) override;
 
-  void loadTileAsync(TileId const& tileId, OnLoadCallback cb) override;
-  int  getPendingRequests() override;
+  std::shared_ptr<TileRequest> loadTileAsync(
+      TileId const& tileId, TileRequest::Priority priority, OnLoadCallback cb) override;
+  int                          getPendingRequests() override;
 
   uint32_t getResolution() const;
 
   void               setCacheDirectory(std::string const& cacheDirectory);
   std::string const& getCacheDirectory() const;
 
+  /// If set to a value larger than zero, decoded tiles are stored in a single TileCache file of
+  /// the given maximum size in megabytes in the cache directory. The downloaded files are removed
+  /// once they have been decoded. If set to zero, each downloaded file is kept in the cache
+  /// directory and decoded whenever it's loaded.
+  void     setTileCacheSize(uint32_t megabytes);
+  uint32_t getTileCacheSize() const;
+
+  /// Returns the TileCache which is currently used. This will be a nullptr if the tile cache size
+  /// is set to zero or the cache could not be created.
+  std::shared_ptr<TileCache> getTileCache();
+
   void               setLayers(std::string const& layers);
   std::string const& getLayers() const;
 
@@ -66,19 +88,81 @@ class TileSourceWebMapService : public TileSource {
   // local map cache and the resulting file name is returned. If the tile is already present in the
   // map cache, no request is made and the cache file name is returned immediately. It may happen
   // that a tile cannot be downloaded (e.g. if the server is offline) - in this case no error is
-  // thrown but std::nullopt is returned. In several other cases (e.g. cache directory is not
-  // writable) a std::runtime_error is thrown.
-  std::optional<std::string> loadData(TileId const& tileId, int x, int y);
+  // thrown but std::nullopt is returned. If a TileRequest is given and it gets cancelled, the
+  // download is aborted and std::nullopt is returned as well. In several other cases (e.g. cache
+  // directory is not writable) a std::runtime_error is thrown.
+  std::optional<std::string> loadData(
+      TileId const& tileId, int x, int y, TileRequest const* tileRequest = nullptr);
 
  private:
+  /// An asynchronous request which has not been started yet.
+  struct AsyncRequest {
+    std::shared_ptr<TileRequest> mRequest;
+    OnLoadCallback               mCallback;
+  };
+
+  /// Each call to loadTileAsync() enqueues one call to this method to the thread pool. It does not
+  /// necessarily process the request which caused the call: Instead, cancelled requests are
+  /// finished first and then the oldest request with the highest priority is loaded. This way,
+  /// requests can be re-prioritized after they have been enqueued.
+  void processAsyncRequest();
+
+  /// The location of one image which is required for a tile.
+  struct ImageLocation {
+    std::string mUrl;
+    std::string mCacheDirectory;
+    std::string mCacheFile;
+  };
+
+  /// Returns the location of the image with the given coordinates, see getXY().
+  ImageLocation getImageLocation(TileId const& tileId, int x, int y) const;
+
+  /// Returns all images of the given tile which are neither in the TileCache nor in the cache
+  /// directory. If the server is marked as 'offline', this will always be empty.
+  std::vector<ImageLocation> getMissingImages(TileId const& tileId);
+
+  /// Creates the cache directory of the given image if necessary and removes corrupt cache files.
+  /// Throws a std::runtime_error if the directory cannot be created.
+  static void prepareCacheFile(ImageLocation const& location);
+
+  /// Checks whether a downloaded image has the expected content type. If not, the cache file is
+  /// removed and a std::runtime_error is thrown which contains the server's response.
+  static void finishCacheFile(ImageLocation const& location, std::string const& contentType);
+
+  /// Downloads the given images of the requested tile asynchronously. Once all of them are there,
+  /// decodeAsyncRequest() is enqueued to the thread pool. If a download fails, the tile's callback
+  /// is invoked without data.
+  void downloadAsync(AsyncRequest request, std::vector<ImageLocation> const& images);
+
+  /// Loads the tile of the given request from the caches and invokes its callback.
+  void decodeAsyncRequest(AsyncRequest const& request);
+
   static std::mutex mFileSystemMutex;
 
+  std::string  mUrl;
+  std::string  mCache = "cache/img";
+  std::string  mLayers;
+  TileDataType mFormat = TileDataType::eColor;
+  uint32_t     mResolution;
+
+  uint32_t                   mTileCacheSize   = 0;
+  bool                       mTileCacheFailed = false;
+  std::shared_ptr<TileCache> mTileCache;
+  std::mutex                 mTileCacheMutex;
+
+  std::vector<AsyncRequest> mAsyncRequests;
+  std::mutex                mAsyncRequestsMutex;
+
+  // The number of tiles whose images are currently being downloaded. The completion handlers of the
+  // downloads access this object, so the destructor waits until this drops to zero.
+  int                     mPendingDownloads = 0;
+  std::atomic<bool>       mShuttingDown{false};
+  std::mutex              mDownloadsMutex;
+  std::condition_variable mDownloadsCondition;
+
+  // The thread pool is declared last so that it is destroyed first. Its destructor waits for all
+  // tasks to be finished and these still access the members above.
   cs::utils::ThreadPool mThreadPool;
-  std::string           mUrl;
-  std::string           mCache = "cache/img";
-  std::string           mLayers;
-  TileDataType          mFormat = TileDataType::eColor;
-  uint32_t              mResolution;
 };
 } // namespace csp::lodbodies
 
@@ -8,10 +8,20 @@
 #include "TileTextureArray.hpp"
 
 #include "BaseTileData.hpp"
+#include "TileCompression.hpp"
 #include "TreeManager.hpp"
+#include "logger.hpp"
+
+#include "../../../src/cs-graphics/GpuMemory.hpp"
 
 #include <VistaBase/VistaStreamUtils.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -20,16 +30,16 @@ namespace {
 
 // functions to obtain texture internal/external format and type
 // from TileDataType value
-GLenum getInternalFormat(TileDataType dataType) {
+GLenum getInternalFormat(TileDataType dataType, bool compressed) {
   GLenum result = GL_NONE;
 
   switch (dataType) {
   case TileDataType::eElevation:
-    result = GL_R32F;
+    result = compressed ? GL_R16 : GL_R32F;
     break;
 
   case TileDataType::eColor:
-    result = GL_RGBA8;
+    result = compressed ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8;
     break;
   }
 
@@ -51,10 +61,10 @@ GLenum getFormat(TileDataType dataType) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-GLenum getType(TileDataType dataType) {
+GLenum getType(TileDataType dataType, bool compressed) {
   switch (dataType) {
   case TileDataType::eElevation:
-    return GL_FLOAT;
+    return compressed ? GL_UNSIGNED_SHORT : GL_FLOAT;
 
   case TileDataType::eColor:
     return GL_UNSIGNED_BYTE;
@@ -65,19 +75,86 @@ GLenum getType(TileDataType dataType) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// The gradients of elevation tiles are stored as two half floats per pixel.
+GLenum const      GRADIENT_FORMAT          = GL_RG16F;
+std::size_t const GRADIENT_BYTES_PER_PIXEL = 4;
+GLuint const      GRADIENT_GROUP_SIZE      = 16;
+
+// Computes the gradient of the values stored in one layer of an elevation tile with respect to
+// the pixel coordinates. Inner pixels use central differences, border pixels one-sided ones. The
+// gradients refer to the values as stored on the GPU, so they have to be scaled by the height
+// range of quantized tiles the same way as the heights themselves.
+char const* const GRADIENT_SHADER = R"(
+#version 430
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0) uniform sampler2DArray uHeights;
+layout(rg16f, binding = 0) writeonly uniform image2DArray uGradients;
+
+uniform int uLayer;
+
+void main() {
+  ivec2 size  = textureSize(uHeights, 0).xy;
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+
+  if (any(greaterThanEqual(pixel, size))) {
+    return;
+  }
+
+  ivec2 lower = max(pixel - 1, ivec2(0));
+  ivec2 upper = min(pixel + 1, size - 1);
+
+  float west  = texelFetch(uHeights, ivec3(lower.x, pixel.y, uLayer), 0).r;
+  float east  = texelFetch(uHeights, ivec3(upper.x, pixel.y, uLayer), 0).r;
+  float south = texelFetch(uHeights, ivec3(pixel.x, lower.y, uLayer), 0).r;
+  float north = texelFetch(uHeights, ivec3(pixel.x, upper.y, uLayer), 0).r;
+
+  vec2 gradient = vec2(east - west, north - south) / vec2(max(upper - lower, ivec2(1)));
+
+  imageStore(uGradients, ivec3(pixel, uLayer), vec4(gradient, 0.0, 0.0));
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// If the GPU memory is not sufficient, the array textures are created with fewer layers. They
+// will always contain at least this many layers, which is enough for a few bodies.
+std::size_t const MIN_LAYER_COUNT = 128;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The texture arrays are shared by all bodies, so there is one sample per data type.
+cs::utils::Metrics::Sample& getSample(
+    std::string const& name, std::string const& help, TileDataType dataType) {
+  return cs::utils::Metrics::get().getSample(name, cs::utils::Metrics::Type::eGauge, help,
+      {{"type", dataType == TileDataType::eElevation ? "elevation" : "color"}});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* explicit */
-TileTextureArray::TileTextureArray(TileDataType dataType, int maxLayerCount, uint32_t resolution)
+TileTextureArray::TileTextureArray(
+    TileDataType dataType, int maxLayerCount, uint32_t resolution, bool compressed, bool sparse)
     : mTexId(0U)
     , mIformat()
     , mFormat()
     , mType()
     , mDataType(dataType)
     , mResolution(resolution)
-    , mNumLayers(maxLayerCount) {
+    , mCompressed(compressed)
+    , mSparse(sparse)
+    , mNumLayers(maxLayerCount)
+    , mTotalLayersSample(getSample("cosmoscout_lod_texture_layers",
+          "The number of layers of the array texture for tiles.", dataType))
+    , mUsedLayersSample(getSample("cosmoscout_lod_texture_used_layers",
+          "The number of layers of the array texture which are occupied by tiles.", dataType))
+    , mPendingUploadsSample(getSample("cosmoscout_lod_texture_pending_uploads",
+          "The number of tiles which are waiting for being uploaded to the GPU.", dataType)) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -94,10 +171,24 @@ TileDataType TileTextureArray::getDataType() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool TileTextureArray::isCompressed() const {
+  return mCompressed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileTextureArray::isSparse() const {
+  return mSparse;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TileTextureArray::allocateGPU(std::shared_ptr<BaseTileData> data) {
-  assert(rdata->getTexLayer() < 0);
+  assert(data->getTexLayer() < 0);
 
-  mUploadQueue.push_back(std::move(data));
+  if (mUploadQueueSlots.try_emplace(data.get(), mUploadQueue.size()).second) {
+    mUploadQueue.push_back(std::move(data));
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -108,30 +199,53 @@ void TileTextureArray::releaseGPU(std::shared_ptr<BaseTileData> const& data) {
     releaseLayer(data);
   } else {
     // TileData is not uploaded, could be in the queue?
-    // XXX TODO Linear search, but mUploadQueue is usually small and
-    //          this case should be rare
-    auto rIt = std::find(mUploadQueue.begin(), mUploadQueue.end(), data);
+    auto it = mUploadQueueSlots.find(data.get());
 
     // avoid erasing an element in the middle of std::vector,
     // just invalidate the pointer and skip NULL entries when uploading
-    if (rIt != mUploadQueue.end()) {
-      rIt->reset();
+    if (it != mUploadQueueSlots.end()) {
+      mUploadQueue[it->second].reset();
+      mUploadQueueSlots.erase(it);
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileTextureArray::processQueue(int maxItems) {
-  if (mUploadQueue.empty()) {
+void TileTextureArray::processQueue(
+    std::size_t maxBytes, std::chrono::steady_clock::time_point deadline) {
+  updateMetrics();
+
+  if (mUploadQueueSlots.empty()) {
+    mUploadQueue.clear();
     return;
   }
 
-  preUpload();
+  // Each segment of the staging buffer can hold a whole number of tiles, but at least one.
+  std::size_t const tileSize    = getTileSize();
+  std::size_t const segmentSize = std::max<std::size_t>(maxBytes / tileSize, 1) * tileSize;
+
+  preUpload(segmentSize);
+
+  // If the GPU has not yet finished reading from the segment we are about to overwrite, we rather
+  // skip uploading in this frame than waiting for the copy to finish.
+  GLsync& fence = mStagingFences.at(mCurrentSegment);
+
+  if (fence) {
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+      postUpload();
+      return;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  std::size_t upload = std::min<std::size_t>(segmentSize / tileSize, mUploadQueueSlots.size());
 
-  std::size_t upload = std::min<std::size_t>(maxItems, mUploadQueue.size());
+  if (getAvailableLayerCount() < upload) {
+    ++mExhaustedCount;
 
-  if (mFreeLayers.size() < upload) {
     // XXX TODO This is bad for performance and visuals, since *all* tiles
     // must be (re)-uploaded to the larger texture
     vstr::warnp() << "[TileTextureArray::processQueue]"
@@ -140,10 +254,18 @@ void TileTextureArray::processQueue(int maxItems) {
                   << std::endl;
   }
 
-  int count = 0;
+  std::size_t        offset = mCurrentSegment * mStagingSegmentSize;
+  std::size_t        end    = offset + mStagingSegmentSize;
+  int                count  = 0;
+  std::vector<GLint> uploadedLayers;
 
-  while (!mUploadQueue.empty() && count < maxItems) {
-    if (mFreeLayers.empty()) {
+  while (!mUploadQueue.empty() && offset + tileSize <= end) {
+    if (getAvailableLayerCount() == 0) {
+      break;
+    }
+
+    // Copying to the staging buffer may be expensive, especially if the tiles are compressed.
+    if (count > 0 && std::chrono::steady_clock::now() >= deadline) {
       break;
     }
 
@@ -152,21 +274,37 @@ void TileTextureArray::processQueue(int maxItems) {
     // data could be NULL if a tile is removed before it is ever
     // uploaded to the GPU, c.f. releaseGPU
     if (data) {
-      allocateLayer(data);
+      mUploadQueueSlots.erase(data.get());
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      copyToStaging(*data, mStagingData + offset);
+      allocateLayer(data, offset);
+      uploadedLayers.push_back(data->getTexLayer());
+      offset += tileSize;
       ++count;
     }
 
     mUploadQueue.pop_back();
   }
 
+  if (mGradientTexId > 0U && count > 0) {
+    computeGradients(uploadedLayers);
+  }
+
+  // The segment may only be reused once the GPU has read all data uploaded in this call.
+  if (count > 0) {
+    fence           = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mCurrentSegment = (mCurrentSegment + 1) % STAGING_SEGMENT_COUNT;
+  }
+
   postUpload();
 
   if (count > 0) {
 #if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
     vstr::outi() << "[TileTextureArray::processQueue]"
-                 << " uploaded/pending/used/free layers " << count << " / " << mUploadQueue.size()
-                 << " / " << (mNumLayers - mFreeLayers.size()) << " / " << mFreeLayers.size()
-                 << std::endl;
+                 << " uploaded/pending/used/free layers " << count << " / "
+                 << mUploadQueueSlots.size() << " / " << mUsedLayers << " / "
+                 << getAvailableLayerCount() << std::endl;
 #endif
   }
 }
@@ -179,14 +317,47 @@ unsigned int TileTextureArray::getTextureId() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+unsigned int TileTextureArray::getGradientTextureId() const {
+  return mGradientTexId;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::size_t TileTextureArray::getTotalLayerCount() const {
-  return mNumLayers;
+  return mUsedLayers + getAvailableLayerCount();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::size_t TileTextureArray::getUsedLayerCount() const {
-  return mNumLayers - mFreeLayers.size();
+  return mUsedLayers;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileTextureArray::Statistics TileTextureArray::getStatistics() const {
+  Statistics statistics;
+  statistics.mTotalLayers    = getTotalLayerCount();
+  statistics.mUsedLayers     = mUsedLayers;
+  statistics.mPeakUsedLayers = mPeakUsedLayers;
+  statistics.mPendingUploads = mUploadQueueSlots.size();
+  statistics.mExhaustedCount = mExhaustedCount;
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::updateMetrics() const {
+  mTotalLayersSample.set(static_cast<double>(getTotalLayerCount()));
+  mUsedLayersSample.set(static_cast<double>(mUsedLayers));
+  mPendingUploadsSample.set(static_cast<double>(mUploadQueueSlots.size()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::resetStatistics() {
+  mPeakUsedLayers = mUsedLayers;
+  mExhaustedCount = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -196,21 +367,63 @@ void TileTextureArray::allocateTexture(TileDataType dataType) {
     return;
   }
 
+  mIformat = getInternalFormat(dataType, mCompressed);
+  mFormat  = getFormat(dataType);
+  mType    = getType(dataType, mCompressed);
+
+  GLint maxSparseLayers = 0;
+
+  if (mSparse && !checkSparseSupport(maxSparseLayers)) {
+    logger().warn("Sparse textures are not supported for {} tiles of resolution {}. Using a fixed "
+                  "number of layers instead!",
+        dataType == TileDataType::eElevation ? "elevation" : "color", mResolution);
+    mSparse = false;
+  }
+
   // allocate a 2D array texture for storing tile data of type dataType
 
   glGenTextures(1, &mTexId);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
 
-  GLsizei const level  = 0;
-  GLsizei const depth  = mNumLayers;
-  GLint const   border = 0;
+  if (mSparse) {
+    // Only address space is reserved here, the memory of each layer is committed in
+    // allocateLayer() and accounted for in the GpuMemory there.
+    mNumLayers = maxSparseLayers;
 
-  mIformat = getInternalFormat(dataType);
-  mFormat  = getFormat(dataType);
-  mType    = getType(dataType);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, mIformat, static_cast<GLsizei>(mResolution),
+        static_cast<GLsizei>(mResolution), mNumLayers);
 
-  glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
-  glTexImage3D(GL_TEXTURE_2D_ARRAY, level, mIformat, mResolution, mResolution, depth, border,
-      mFormat, mType, nullptr);
+  } else {
+    // If the array texture would not fit into the remaining GPU memory, fewer layers are
+    // allocated. Each of the two array textures may use at most half of the remaining memory.
+    auto& gpuMemory = cs::graphics::GpuMemory::get();
+    auto  maxLayers = static_cast<GLint>(std::min<std::size_t>(
+        std::max(gpuMemory.getRemainingBudget() / getLayerSize() / 2, MIN_LAYER_COUNT),
+        static_cast<std::size_t>(std::numeric_limits<GLint>::max())));
+
+    if (maxLayers < mNumLayers) {
+      logger().warn("Reducing the number of {} tiles on the GPU from {} to {} due to limited GPU "
+                    "memory!",
+          dataType == TileDataType::eElevation ? "elevation" : "color", mNumLayers, maxLayers);
+      mNumLayers = maxLayers;
+    }
+
+    gpuMemory.allocate("LOD Tiles", getLayerSize() * static_cast<std::size_t>(mNumLayers));
+
+    GLsizei const level  = 0;
+    GLsizei const depth  = mNumLayers;
+    GLint const   border = 0;
+
+    if (mCompressed && dataType == TileDataType::eColor) {
+      auto const imageSize = static_cast<GLsizei>(getTileSize() * mNumLayers);
+      glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, mIformat, mResolution, mResolution,
+          depth, border, imageSize, nullptr);
+    } else {
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, level, mIformat, mResolution, mResolution, depth, border,
+          mFormat, mType, nullptr);
+    }
+  }
 
   // set filter and wrapping parameters
   glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -220,12 +433,20 @@ void TileTextureArray::allocateTexture(TileDataType dataType) {
 
   glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
 
-  // all layers of newly allocated texture are available for use
-  mFreeLayers.reserve(mNumLayers);
+  if (dataType == TileDataType::eElevation) {
+    allocateGradients();
+  }
+
+  // all layers of newly allocated texture are available for use, the bits beyond the last layer
+  // are never set
+  mFreeLayers.assign((mNumLayers + 63) / 64, ~uint64_t(0));
 
-  for (int i = 0; i < mNumLayers; ++i) {
-    mFreeLayers.push_back(mNumLayers - i - 1);
+  if (mNumLayers % 64 != 0) {
+    mFreeLayers.back() = (uint64_t(1) << (mNumLayers % 64)) - 1;
   }
+
+  mFirstFreeWord = 0;
+  mUsedLayers    = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -235,30 +456,184 @@ void TileTextureArray::releaseTexture() {
     return;
   }
 
+  releaseStagingBuffer();
+
+  // Deleting a sparse texture also frees the memory of all committed layers.
+  std::size_t const layers = mSparse ? mUsedLayers : static_cast<std::size_t>(mNumLayers);
+
   glDeleteTextures(1, &mTexId);
+  cs::graphics::GpuMemory::get().release("LOD Tiles", getLayerSize() * layers);
   mTexId = 0U;
+
+  if (mGradientTexId > 0U) {
+    glDeleteTextures(1, &mGradientTexId);
+    glDeleteProgram(mGradientProgram);
+    mGradientTexId   = 0U;
+    mGradientProgram = 0U;
+  }
+
   mFreeLayers.clear();
+  mFirstFreeWord = 0;
+  mUsedLayers    = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::allocateGradients() {
+  glGenTextures(1, &mGradientTexId);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, mGradientTexId);
+
+  if (mSparse) {
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+  }
+
+  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GRADIENT_FORMAT, static_cast<GLsizei>(mResolution),
+      static_cast<GLsizei>(mResolution), mNumLayers);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
+
+  auto        shader = glCreateShader(GL_COMPUTE_SHADER);
+  const char* source = GRADIENT_SHADER;
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+
+  int rvalue = 0;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto logLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    std::vector<char> v(logLength);
+    glGetShaderInfoLog(shader, logLength, nullptr, v.data());
+    glDeleteShader(shader);
+    throw std::runtime_error(
+        "Failed to compile the tile gradient shader: " + std::string(v.begin(), v.end()));
+  }
+
+  mGradientProgram = glCreateProgram();
+  glAttachShader(mGradientProgram, shader);
+  glLinkProgram(mGradientProgram);
+  glDeleteShader(shader);
+
+  glGetProgramiv(mGradientProgram, GL_LINK_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto logLength = 0;
+    glGetProgramiv(mGradientProgram, GL_INFO_LOG_LENGTH, &logLength);
+    std::vector<char> v(logLength);
+    glGetProgramInfoLog(mGradientProgram, logLength, nullptr, v.data());
+    throw std::runtime_error(
+        "Failed to link the tile gradient shader: " + std::string(v.begin(), v.end()));
+  }
+
+  mGradientLayerLocation = glGetUniformLocation(mGradientProgram, "uLayer");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::computeGradients(std::vector<GLint> const& layers) const {
+  // Uploads to the elevation texture are finished before the compute shader reads from it, as
+  // both are executed in command order.
+  glUseProgram(mGradientProgram);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
+  glBindImageTexture(0, mGradientTexId, 0, GL_TRUE, 0, GL_WRITE_ONLY, GRADIENT_FORMAT);
+
+  auto const groups = (mResolution + GRADIENT_GROUP_SIZE - 1) / GRADIENT_GROUP_SIZE;
+
+  for (GLint layer : layers) {
+    glUniform1i(mGradientLayerLocation, layer);
+    glDispatchCompute(groups, groups, 1);
+  }
+
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GRADIENT_FORMAT);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
+  glUseProgram(0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Uploads tile data from the node associated with @a data to the GPU.
+void TileTextureArray::allocateStagingBuffer(std::size_t segmentSize) {
+  if (mStagingBuffer > 0U && mStagingSegmentSize == segmentSize) {
+    return;
+  }
+
+  // The upload budget has changed. Deleting the buffer is safe even if the GPU is still reading
+  // from it, the driver will defer the deletion until it is not used anymore.
+  releaseStagingBuffer();
+
+  mStagingSegmentSize = segmentSize;
+
+  std::size_t const bufferSize = STAGING_SEGMENT_COUNT * mStagingSegmentSize;
+  GLbitfield const  flags      = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  glGenBuffers(1, &mStagingBuffer);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer);
+  glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, flags);
+  mStagingData =
+      static_cast<char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bufferSize, flags));
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::releaseStagingBuffer() {
+  for (auto& fence : mStagingFences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  if (mStagingBuffer == 0U) {
+    return;
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+  glDeleteBuffers(1, &mStagingBuffer);
+
+  mStagingBuffer      = 0U;
+  mStagingData        = nullptr;
+  mStagingSegmentSize = 0;
+  mCurrentSegment     = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Uploads tile data from the node associated with @a data to the GPU. The data has to be copied to
+// the staging buffer at the given @a offset before.
 // @note May only be called after a call to @c preUpload.
-void TileTextureArray::allocateLayer(std::shared_ptr<BaseTileData> const& data) {
-  assert(!mFreeLayers.empty());
+void TileTextureArray::allocateLayer(
+    std::shared_ptr<BaseTileData> const& data, std::size_t offset) {
+  assert(mUsedLayers < static_cast<std::size_t>(mNumLayers));
   assert(data->getTexLayer() < 0);
 
-  int layer = mFreeLayers.back();
-  mFreeLayers.pop_back();
+  GLint layer = takeFreeLayer();
+
+  if (mSparse) {
+    commitLayer(layer, true);
+  }
 
   GLint const   level   = 0;
   GLint const   xoffset = 0;
   GLint const   yoffset = 0;
   GLsizei const depth   = 1;
-  GLvoid const* pixels  = data->getDataPtr();
 
-  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, xoffset, yoffset, layer, mResolution, mResolution,
-      depth, mFormat, mType, pixels);
+  // With a bound pixel unpack buffer, the pointer is interpreted as an offset into the buffer.
+  auto const* pixels = reinterpret_cast<GLvoid const*>(offset); // NOLINT(performance-no-int-to-ptr)
+
+  if (mCompressed && mDataType == TileDataType::eColor) {
+    glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, xoffset, yoffset, layer, mResolution,
+        mResolution, depth, mIformat, static_cast<GLsizei>(getTileSize()), pixels);
+  } else {
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, xoffset, yoffset, layer, mResolution, mResolution,
+        depth, mFormat, mType, pixels);
+  }
 
   data->setTexLayer(layer);
 }
@@ -268,25 +643,209 @@ void TileTextureArray::allocateLayer(std::shared_ptr<BaseTileData> const& data)
 void TileTextureArray::releaseLayer(std::shared_ptr<BaseTileData> const& data) {
   assert(data->getTexLayer() >= 0);
 
+  if (mSparse) {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
+    commitLayer(data->getTexLayer(), false);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
+  }
+
   // simply mark the layer as available and record that data is not
   // currently on the GPU (i.e. set the texture layer to an invalid value)
-  mFreeLayers.push_back(data->getTexLayer());
+  returnFreeLayer(data->getTexLayer());
   data->setTexLayer(-1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileTextureArray::preUpload() {
+// Marks the free layer with the lowest index as used and returns it. Using the lowest layers first
+// keeps the occupied part of the texture compact.
+// @note May only be called if @c mUsedLayers is smaller than @c mNumLayers.
+GLint TileTextureArray::takeFreeLayer() {
+  while (mFreeLayers[mFirstFreeWord] == 0) {
+    ++mFirstFreeWord;
+  }
+
+  uint64_t& word = mFreeLayers[mFirstFreeWord];
+  GLint     bit  = 0;
+
+  while ((word & (uint64_t(1) << bit)) == 0) {
+    ++bit;
+  }
+
+  word &= ~(uint64_t(1) << bit);
+
+  ++mUsedLayers;
+  mPeakUsedLayers = std::max(mPeakUsedLayers, mUsedLayers);
+
+  return static_cast<GLint>(mFirstFreeWord * 64) + bit;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::returnFreeLayer(GLint layer) {
+  std::size_t const index = layer / 64;
+
+  assert((mFreeLayers[index] & (uint64_t(1) << (layer % 64))) == 0);
+
+  mFreeLayers[index] |= uint64_t(1) << (layer % 64);
+  mFirstFreeWord = std::min(mFirstFreeWord, index);
+
+  --mUsedLayers;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileTextureArray::getAvailableLayerCount() const {
+  std::size_t available = static_cast<std::size_t>(mNumLayers) - mUsedLayers;
+
+  // The layers of sparse textures are only limited by the memory budget.
+  if (mSparse) {
+    auto remaining = cs::graphics::GpuMemory::get().getRemainingBudget();
+    available      = std::min(available, remaining / getLayerSize());
+  }
+
+  return available;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileTextureArray::checkSparseSupport(GLint& maxLayers) const {
+  if (!GLEW_ARB_sparse_texture) {
+    return false;
+  }
+
+  std::vector<GLenum> formats = {mIformat};
+  if (mDataType == TileDataType::eElevation) {
+    formats.push_back(GRADIENT_FORMAT);
+  }
+
+  for (GLenum format : formats) {
+    // Layers are committed as a whole, so the tiles have to consist of whole pages. The default
+    // page size with index zero is used.
+    GLint pageSizes = 0;
+    glGetInternalformativ(
+        GL_TEXTURE_2D_ARRAY, format, GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &pageSizes);
+
+    if (pageSizes == 0) {
+      return false;
+    }
+
+    GLint pageWidth  = 0;
+    GLint pageHeight = 0;
+    glGetInternalformativ(GL_TEXTURE_2D_ARRAY, format, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &pageWidth);
+    glGetInternalformativ(GL_TEXTURE_2D_ARRAY, format, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &pageHeight);
+
+    if (pageWidth <= 0 || pageHeight <= 0 ||
+        mResolution % static_cast<uint32_t>(pageWidth) != 0 ||
+        mResolution % static_cast<uint32_t>(pageHeight) != 0) {
+      return false;
+    }
+  }
+
+  glGetIntegerv(GL_MAX_SPARSE_ARRAY_TEXTURE_LAYERS_ARB, &maxLayers);
+
+  return maxLayers > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::commitLayer(GLint layer, bool commit) {
+  auto const size = static_cast<GLsizei>(mResolution);
+
+  glTexPageCommitmentARB(
+      GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, commit ? GL_TRUE : GL_FALSE);
+
+  if (mGradientTexId > 0U) {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mGradientTexId);
+    glTexPageCommitmentARB(
+        GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, commit ? GL_TRUE : GL_FALSE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
+  }
+
+  if (commit) {
+    cs::graphics::GpuMemory::get().allocate("LOD Tiles", getLayerSize());
+  } else {
+    cs::graphics::GpuMemory::get().release("LOD Tiles", getLayerSize());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::preUpload(std::size_t segmentSize) {
   allocateTexture(mDataType);
+  allocateStagingBuffer(segmentSize);
   glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer);
+
+  // Rows of quantized elevation tiles with an odd resolution are not four-byte aligned.
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TileTextureArray::postUpload() {
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
   glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Copies the data of the given tile to the staging buffer, compressing it if required.
+void TileTextureArray::copyToStaging(BaseTileData const& data, char* target) const {
+  if (!mCompressed) {
+    std::memcpy(target, data.getDataPtr(), getTileSize());
+    return;
+  }
+
+  if (mDataType == TileDataType::eElevation) {
+    // This is the same range as stored in the MinMaxPyramid of the tile.
+    std::size_t const count   = static_cast<std::size_t>(mResolution) * mResolution;
+    float const*      heights = data.getTypedPtr<float>();
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto [minHeight, maxHeight] = std::minmax_element(heights, heights + count);
+    compression::quantizeHeights(
+        heights, count, *minHeight, *maxHeight, reinterpret_cast<uint16_t*>(target));
+
+  } else if (data.getCompressedData().size() == getTileSize()) {
+    std::memcpy(target, data.getCompressedData().data(), getTileSize());
+
+  } else {
+    // The tile source did not compress the tile, so we have to do it here.
+    compression::encodeBC1(
+        data.getTypedPtr<glm::u8vec4>(), mResolution, reinterpret_cast<uint8_t*>(target));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileTextureArray::getTileSize() const {
+  if (mCompressed && mDataType == TileDataType::eColor) {
+    return compression::getBC1Size(mResolution);
+  }
+
+  // Elevation tiles store one float per pixel or one short if they are quantized, color tiles four
+  // bytes.
+  std::size_t bytesPerPixel = 4 * sizeof(uint8_t);
+
+  if (mDataType == TileDataType::eElevation) {
+    bytesPerPixel = mCompressed ? sizeof(uint16_t) : sizeof(float);
+  }
+
+  return bytesPerPixel * mResolution * mResolution;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileTextureArray::getLayerSize() const {
+  if (mDataType == TileDataType::eElevation) {
+    return getTileSize() + GRADIENT_BYTES_PER_PIXEL * mResolution * mResolution;
+  }
+
+  return getTileSize();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::lodbodies
@@ -10,9 +10,13 @@
 
 #include "TileDataType.hpp"
 
+#include "../../../src/cs-utils/Metrics.hpp"
+
 #include <GL/glew.h>
 #include <array>
+#include <chrono>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace csp::lodbodies {
@@ -29,9 +33,54 @@ class TreeManager;
 /// once. If more tiles are needed on the GPU the array texture must be resized (which requires all
 /// tiles to be re-uploaded), this should be avoided to prevent the tile resolution to drop
 /// dramatically while only low resolution tiles are on the GPU.
+///
+/// Uploads are streamed through a persistently mapped pixel unpack buffer. The buffer is divided
+/// into several segments which are used in a round-robin fashion, one per call to processQueue().
+/// Tile data is copied to the current segment and glTexSubImage3D() then sources its data from
+/// the buffer, so the driver can return immediately and perform the copy asynchronously. A fence
+/// per segment ensures that a segment is not overwritten while the GPU still reads from it.
+///
+/// Optionally, the tiles can be stored in a compressed format. Color tiles are then stored as BC1
+/// blocks, which are usually computed on the loader threads already, see BaseTileData::
+/// getCompressedData(). Elevation tiles are quantized to 16 bit between the minimum and maximum
+/// height of each tile while they are copied to the staging buffer. TileRenderer passes this
+/// range to the shaders.
+///
+/// If sparse storage is requested and GL_ARB_sparse_texture supports the tile format, the array
+/// texture is created with as many layers as the driver allows, but only virtual address space is
+/// reserved. Memory is committed for a layer when a tile is uploaded to it and decommitted when
+/// the tile is released. The number of available layers then follows the remaining GPU memory
+/// budget, see cs::graphics::GpuMemory, instead of the fixed layer count.
+///
+/// For elevation tiles, there is a second array texture with the same layers. Once tiles have been
+/// uploaded, a compute shader stores the gradient of each elevation tile in it. The terrain vertex
+/// shader derives the surface normals from these gradients with a single texture lookup instead of
+/// reconstructing the positions of four neighbouring vertices.
 class TileTextureArray {
  public:
-  explicit TileTextureArray(TileDataType dataType, int maxLayerCount, uint32_t resolution);
+  /// Some counters which can be used to choose a suitable layer count for the array texture. See
+  /// getStatistics().
+  struct Statistics {
+    /// The number of layers of the array texture.
+    std::size_t mTotalLayers{};
+
+    /// The number of layers which are currently occupied by tiles.
+    std::size_t mUsedLayers{};
+
+    /// The maximum number of layers which were occupied at the same time since the last call to
+    /// resetStatistics().
+    std::size_t mPeakUsedLayers{};
+
+    /// The number of tiles which are currently waiting for being uploaded.
+    std::size_t mPendingUploads{};
+
+    /// The number of calls to processQueue() since the last call to resetStatistics() in which not
+    /// all pending tiles could be uploaded because all layers were occupied.
+    std::size_t mExhaustedCount{};
+  };
+
+  explicit TileTextureArray(TileDataType dataType, int maxLayerCount, uint32_t resolution,
+      bool compressed = false, bool sparse = false);
 
   TileTextureArray(TileTextureArray const& other) = delete;
   TileTextureArray(TileTextureArray&& other)      = delete;
@@ -43,58 +92,146 @@ class TileTextureArray {
 
   TileDataType getDataType() const;
 
-  /// Requests that data for the tile associated with data be uploaded to the GPU.
+  /// Returns true if the tiles are stored in a compressed format on the GPU.
+  bool isCompressed() const;
+
+  /// Returns true if memory is committed for each layer separately. This is only known once the
+  /// texture has been allocated during the first call to processQueue().
+  bool isSparse() const;
+
+  /// Requests that data for the tile associated with data be uploaded to the GPU. Requesting the
+  /// same data multiple times has no effect.
   void allocateGPU(std::shared_ptr<BaseTileData> data);
 
-  /// Release GPU resources allocated for the tile associated with data.
+  /// Release GPU resources allocated for the tile associated with data. If the data has not been
+  /// uploaded yet, it is removed from the upload queue. Both cases take constant time.
   void releaseGPU(std::shared_ptr<BaseTileData> const& data);
 
-  /// Process up to maxItems upload requests.
-  void processQueue(int maxItems);
+  /// Process upload requests until maxBytes of tile data have been uploaded in this call or the
+  /// given deadline has passed. At least one tile is uploaded per call, even if it is larger than
+  /// maxBytes. If the GPU is still reading from the staging segment which would be used next,
+  /// nothing is uploaded in this call.
+  void processQueue(std::size_t maxBytes, std::chrono::steady_clock::time_point deadline);
 
   /// Returns the OpenGL id of the texture used to store tiles on the GPU. This is an internal
   /// interface for TileRenderer.
   unsigned int getTextureId() const;
 
-  /// Gets Total Layer Count
+  /// Returns the OpenGL id of the array texture which stores the gradients of elevation tiles in
+  /// the same layers as the tiles themselves. This is zero for color tiles.
+  unsigned int getGradientTextureId() const;
+
+  /// Gets Total Layer Count. For sparse textures, this is the number of used layers plus the
+  /// number of layers which fit into the remaining GPU memory budget.
   std::size_t getTotalLayerCount() const;
 
   /// Gets Used Layer Count
   std::size_t getUsedLayerCount() const;
 
+  /// Returns the current occupancy and the counters accumulated since the last call to
+  /// resetStatistics().
+  Statistics getStatistics() const;
+
+  /// Resets the accumulated counters of the statistics.
+  void resetStatistics();
+
  private:
   void allocateTexture(TileDataType dataType);
   void releaseTexture();
 
-  void allocateLayer(std::shared_ptr<BaseTileData> const& data);
+  /// Creates the gradient texture and the compute shader which fills it.
+  void allocateGradients();
+  void computeGradients(std::vector<GLint> const& layers) const;
+
+  void allocateStagingBuffer(std::size_t segmentSize);
+  void releaseStagingBuffer();
+
+  void allocateLayer(std::shared_ptr<BaseTileData> const& data, std::size_t offset);
   void releaseLayer(std::shared_ptr<BaseTileData> const& data);
 
-  void        preUpload();
+  GLint takeFreeLayer();
+  void  returnFreeLayer(GLint layer);
+
+  /// Returns the number of layers which can still be occupied by tiles.
+  std::size_t getAvailableLayerCount() const;
+
+  /// Returns true if a sparse texture with the given format and resolution can be created. The
+  /// maximum number of layers of sparse array textures is stored in maxLayers.
+  bool checkSparseSupport(GLint& maxLayers) const;
+
+  /// Commits or decommits the memory of the given layer of a sparse texture. The texture has to
+  /// be bound.
+  void commitLayer(GLint layer, bool commit);
+
+  void        preUpload(std::size_t segmentSize);
   static void postUpload();
 
+  void copyToStaging(BaseTileData const& data, char* target) const;
+
+  std::size_t getTileSize() const;
+
+  /// The GPU memory of one layer, including the gradients of elevation tiles.
+  std::size_t getLayerSize() const;
+
+  /// Publishes the occupancy of the array texture to the Metrics.
+  void updateMetrics() const;
+
   GLuint       mTexId;
   GLenum       mIformat;
   GLenum       mFormat;
   GLenum       mType;
   TileDataType mDataType;
   uint32_t     mResolution;
-
-  const GLint        mNumLayers;
-  std::vector<GLint> mFreeLayers;
-
-  std::vector<std::shared_ptr<BaseTileData>> mUploadQueue;
+  bool         mCompressed;
+  bool         mSparse;
+
+  GLuint mGradientTexId{};
+  GLuint mGradientProgram{};
+  GLint  mGradientLayerLocation{};
+
+  // This may be reduced when the texture is allocated, if it would not fit into the GPU memory
+  // budget, see cs::graphics::GpuMemory.
+  GLint mNumLayers;
+
+  // One bit per layer which is set if the layer is free. mFirstFreeWord is the index of the first
+  // element which may contain a set bit, all elements before are known to be zero.
+  std::vector<uint64_t> mFreeLayers;
+  std::size_t           mFirstFreeWord{};
+  std::size_t           mUsedLayers{};
+  std::size_t           mPeakUsedLayers{};
+  std::size_t           mExhaustedCount{};
+
+  // Tiles are uploaded from the back of mUploadQueue. If a tile is released before it has been
+  // uploaded, its entry is reset to a nullptr so that the slots of all other entries remain valid.
+  // mUploadQueueSlots maps each queued tile to its slot in mUploadQueue.
+  std::vector<std::shared_ptr<BaseTileData>>           mUploadQueue;
+  std::unordered_map<BaseTileData const*, std::size_t> mUploadQueueSlots;
+
+  // The persistently mapped staging buffer. It consists of STAGING_SEGMENT_COUNT segments of
+  // mStagingSegmentSize bytes each.
+  static constexpr std::size_t STAGING_SEGMENT_COUNT = 3;
+
+  cs::utils::Metrics::Sample& mTotalLayersSample;
+  cs::utils::Metrics::Sample& mUsedLayersSample;
+  cs::utils::Metrics::Sample& mPendingUploadsSample;
+
+  GLuint                                    mStagingBuffer{};
+  char*                                     mStagingData{};
+  std::size_t                               mStagingSegmentSize{};
+  std::size_t                               mCurrentSegment{};
+  std::array<GLsync, STAGING_SEGMENT_COUNT> mStagingFences{};
 };
 
 /// DocTODO
 class GLResources : public PerDataType<std::unique_ptr<TileTextureArray>> {
  public:
   GLResources(int maxElevationLayers, int maxColorLayers, uint32_t elevationResolution,
-      uint32_t colorResolution)
+      uint32_t colorResolution, bool compressed = false, bool sparse = false)
       : PerDataType<std::unique_ptr<TileTextureArray>>(
-            {std::make_unique<TileTextureArray>(
-                 TileDataType::eElevation, maxElevationLayers, elevationResolution),
+            {std::make_unique<TileTextureArray>(TileDataType::eElevation, maxElevationLayers,
+                 elevationResolution, compressed, sparse),
                 std::make_unique<TileTextureArray>(
-                    TileDataType::eColor, maxColorLayers, colorResolution)}) {
+                    TileDataType::eColor, maxColorLayers, colorResolution, compressed, sparse)}) {
   }
 };
 } // namespace csp::lodbodies
@@ -32,9 +32,17 @@ class TileQuadTree;
 class TileVisitor {
  public:
   explicit TileVisitor(TileQuadTree* tree);
+  virtual ~TileVisitor() = default;
 
-  /// Start traversal of the trees passed to the constructor.
-  void visit();
+  TileVisitor(TileVisitor const& other) = delete;
+  TileVisitor(TileVisitor&& other)      = delete;
+
+  TileVisitor& operator=(TileVisitor const& other) = delete;
+  TileVisitor& operator=(TileVisitor&& other) = delete;
+
+  /// Start traversal of the trees passed to the constructor. Derived classes may reimplement this
+  /// to traverse the trees in a different manner, for example in parallel.
+  virtual void visit();
 
  protected:
   void visitRoot(TileNode* root);
@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TimeBudget.hpp"
+
+#include <algorithm>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// fraction of the spare frame time which is added to the budget each frame; the frame time is
+// measured with a delay of two frames, so a larger value would make the budget oscillate
+double const adaptionRate = 0.25;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TimeBudget::startFrame(
+    double targetFrameTime, double frameTime, double minBudget, double maxBudget) {
+  mBudget += adaptionRate * (targetFrameTime - frameTime);
+  mBudget    = std::clamp(mBudget, minBudget, std::max(minBudget, maxBudget));
+  mRemaining = mBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double TimeBudget::getBudget() const {
+  return mBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double TimeBudget::getRemaining() const {
+  return mRemaining;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TimeBudget::isExhausted() const {
+  return mRemaining <= 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TimeBudget::Clock::time_point TimeBudget::getDeadline() const {
+  auto remaining = std::chrono::duration<double, std::milli>(std::max(mRemaining, 0.0));
+  return Clock::now() + std::chrono::duration_cast<Clock::duration>(remaining);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TimeBudget::consume(Clock::time_point start) {
+  mRemaining -= std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TIMEBUDGET_HPP
+#define CSP_LOD_BODIES_TIMEBUDGET_HPP
+
+#include <chrono>
+
+namespace csp::lodbodies {
+
+/// The time which may be spent on updating the tile trees of all bodies in one frame. It is shared
+/// by the TreeManagers and LODVisitors of all bodies. Merging newly loaded tiles, uploading tiles
+/// to the GPU and recomputing tile bounds stop once the budget is exhausted and continue in the
+/// next frame. Each of them still makes some progress in every frame, so that loading never stalls
+/// completely.
+///
+/// The budget is adapted each frame based on the measured frame time: If there is time left until
+/// the target frame time is reached, the budget grows, else it shrinks. This must only be used on
+/// the main thread.
+class TimeBudget {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Computes the budget for the current frame and resets the remaining time to it. frameTime is
+  /// the measured duration of a previous frame, it is compared to targetFrameTime. The budget will
+  /// stay in the range [minBudget, maxBudget]. All values are given in milliseconds.
+  void startFrame(double targetFrameTime, double frameTime, double minBudget, double maxBudget);
+
+  /// Returns the budget of the current frame in milliseconds.
+  double getBudget() const;
+
+  /// Returns the time in milliseconds which is left in the current frame. This may be negative if
+  /// a task took longer than expected.
+  double getRemaining() const;
+
+  /// Returns true if there is no time left in the current frame.
+  bool isExhausted() const;
+
+  /// Returns the point in time at which the remaining budget is used up if a task starts now.
+  Clock::time_point getDeadline() const;
+
+  /// Subtracts the time passed since start from the remaining budget.
+  void consume(Clock::time_point start);
+
+ private:
+  double mBudget    = 0.0;
+  double mRemaining = 0.0;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TIMEBUDGET_HPP
@@ -7,14 +7,21 @@
 
 #include "TreeManager.hpp"
 
+#include "MinMaxPyramid.hpp"
 #include "PlanetParameters.hpp"
+#include "TileBounds.hpp"
 #include "TileData.hpp"
+#include "TilePool.hpp"
 #include "TileSource.hpp"
 #include "TileTextureArray.hpp"
 
 #include <VistaBase/VistaStreamUtils.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
 #include <utility>
 
 namespace csp::lodbodies {
@@ -32,25 +39,60 @@ namespace {
 // number of frames an unused node is kept in the tree before being removed
 int const maxNodeAge = 10;
 
+// number of frames an unused node is kept in the tree at least, even if memory runs low
+int const minNodeAge = 2;
+
+// fraction of the texture array layers and of the tile memory budget which may be occupied before
+// nodes are removed before they reach maxNodeAge
+double const maxResidency = 0.9;
+
 // number of frames a node that can not directly be merged into the tree
 // is kept around
 int const maxUnmergedAge = 500;
 
+// number of frames a requested node may be missing from the requested set
+// before its loading is cancelled
+int const maxPendingAge = 10;
+
 // number of nodes to pre-allocate data structures
 std::size_t const preAllocNodeCount = 500;
 
 // number of nodes to pre-allocate IO data structures
 std::size_t const preAllocIONodeCount = 200;
 
+// number of bytes per frame and texture array which are uploaded to the GPU
+std::size_t const uploadBudget = 4 * 1024 * 1024;
+
+// number of microseconds per frame which may be spent on merging newly loaded nodes if no
+// TimeBudget has been set
+int const mergeBudget = 1000;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Nodes can only be removed once all of their children have been removed.
+bool isLeaf(TileNode const* node, std::unordered_set<TileNode const*> const& removed) {
+  for (int i = 0; i < 4; ++i) {
+    TileNode const* child = node->getChild(i);
+    if (child && removed.find(child) == removed.end()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Function object to compare RDMapValue objects by their age.
-struct TreeManager::AgeLess {
-  explicit AgeLess(int frame);
+// Function object to order nodes for removal, the node which should be removed first compares
+// greatest. Nodes exceeding maxNodeAge are always removed first, oldest first. All other nodes are
+// ordered by their screen-space error divided by their age, so that small and long unused nodes
+// are removed before large or recently used nodes.
+struct TreeManager::RemovalLess {
+  explicit RemovalLess(int frame);
 
   bool operator()(TileNode const* lhs, TileNode const* rhs) const;
 
@@ -60,25 +102,29 @@ struct TreeManager::AgeLess {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* explicit */
-TreeManager::AgeLess::AgeLess(int frame)
+TreeManager::RemovalLess::RemovalLess(int frame)
     : mFrame(frame) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool TreeManager::AgeLess::operator()(TileNode const* lhs, TileNode const* rhs) const {
-  // sort by age (frames since last use), in case of a tie use
-  // tile level - this ensure that child nodes are always sorted
-  // after parent nodes
-
+bool TreeManager::RemovalLess::operator()(TileNode const* lhs, TileNode const* rhs) const {
   int ageLHS = lhs->getAge(mFrame);
   int ageRHS = rhs->getAge(mFrame);
 
-  if (ageLHS == ageRHS) {
-    return lhs->getLevel() < rhs->getLevel();
+  bool expiredLHS = ageLHS > maxNodeAge;
+  bool expiredRHS = ageRHS > maxNodeAge;
+
+  if (expiredLHS != expiredRHS) {
+    return expiredRHS;
+  }
+
+  if (expiredLHS) {
+    return ageLHS < ageRHS;
   }
 
-  return ageLHS < ageRHS;
+  return lhs->getScreenSpaceError() * static_cast<float>(ageRHS) >
+         rhs->getScreenSpaceError() * static_cast<float>(ageLHS);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -99,12 +145,25 @@ TreeManager::TreeManager(std::shared_ptr<GLResources> glResources)
 
   mNodes.reserve(preAllocNodeCount);
   mUnmergedNodes.reserve(preAllocIONodeCount);
-  mLoadedNodes.reserve(preAllocIONodeCount);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManager::setSource(TileDataType type, TileSource* src) {
+  TileSource* previous{};
+
+  {
+    std::unique_lock<std::mutex> lck(mSourcesMtx);
+    previous = mTileDataSources.get(type);
+  }
+
+  // Exchanging the imagery does not change the geometry, so the nodes can be kept. A new
+  // elevation source changes the bounds and the heights of all nodes, so the tree is rebuilt.
+  if (type == TileDataType::eColor && previous && src && mAsyncLoading && !mNodes.empty()) {
+    refillNodes(type, src);
+    return;
+  }
+
   // remove all existing nodes
   clear();
 
@@ -121,21 +180,90 @@ void TreeManager::request(std::vector<TileId> const& tileIds) {
   // load the tile.
   // In the case of async loading, register @c onDataLoaded as the callback
   // that the source invokes when the tile is ready.
-  std::unique_lock<std::mutex> lck(mPendingMtx);
+  std::vector<std::pair<TileId, std::shared_ptr<BaseTileData>>> loadedTiles;
+
+  {
+    std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)> lck(mPendingMtx);
+
+    requestTiles(tileIds, TileRequest::Priority::eHigh, loadedTiles);
+
+    // Pending tiles which have not been requested this frame are not required anymore. They are
+    // demoted so that they do not block the currently required tiles. If they have not been
+    // requested for some frames, they are cancelled altogether.
+    for (auto it = mPendingTiles.begin(); it != mPendingTiles.end();) {
+      auto current = it++;
+      auto age     = mFrameCount - current->second.mLastRequested;
+
+      if (age == 0 || current->second.mCancelled || current->second.mRequests.empty()) {
+        continue;
+      }
+
+      if (age > maxPendingAge) {
+        cancelPendingTile(current);
+      } else {
+        for (auto const& request : current->second.mRequests) {
+          request->setPriority(TileRequest::Priority::eNormal);
+        }
+      }
+    }
+  }
+
+  // Synchronously loaded tiles can only be handled once mPendingMtx has been unlocked.
+  for (auto& [tileId, tileData] : loadedTiles) {
+    onDataLoaded(tileId, std::move(tileData));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::prefetch(std::vector<TileId> const& tileIds) {
+  // Loading tiles synchronously would block the main thread for tiles which are not even required
+  // yet.
+  if (!mAsyncLoading) {
+    return;
+  }
+
+  std::vector<std::pair<TileId, std::shared_ptr<BaseTileData>>> loadedTiles;
+
+  std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)> lck(mPendingMtx);
+  requestTiles(tileIds, TileRequest::Priority::eNormal, loadedTiles);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::requestTiles(std::vector<TileId> const& tileIds, TileRequest::Priority priority,
+    std::vector<std::pair<TileId, std::shared_ptr<BaseTileData>>>& loadedTiles) {
 
   for (auto const& tileId : tileIds) {
-    if (mPendingTiles.count(tileId) == 0) {
-      mPendingTiles[tileId] = new TileNode(tileId);
-
-      for (auto const& src : mTileDataSources.mChannels) {
-        if (src) {
-          if (mAsyncLoading) {
-            src->loadTileAsync(
-                tileId, [this](auto id, auto data) { onDataLoaded(id, std::move(data)); });
-          } else {
-            auto tileData = src->loadTile(tileId);
-            onDataLoaded(tileId, std::move(tileData));
-          }
+    auto it = mPendingTiles.find(tileId);
+
+    // The tile has already been requested. It may have been demoted in a previous frame, so we
+    // make sure that it is loaded with high priority now if it is required.
+    if (it != mPendingTiles.end()) {
+      it->second.mLastRequested = mFrameCount;
+
+      if (priority == TileRequest::Priority::eHigh) {
+        for (auto const& request : it->second.mRequests) {
+          request->setPriority(priority);
+        }
+      }
+
+      continue;
+    }
+
+    auto& pending          = mPendingTiles[tileId];
+    pending.mNode          = new (tileId.level()) TileNode(tileId);
+    pending.mLastRequested = mFrameCount;
+
+    for (auto const& src : mTileDataSources.mChannels) {
+      if (src) {
+        ++pending.mOutstanding;
+
+        if (mAsyncLoading) {
+          pending.mRequests.push_back(src->loadTileAsync(tileId, priority,
+              [this](auto id, auto data) { onDataLoaded(id, std::move(data)); }));
+        } else {
+          loadedTiles.emplace_back(tileId, src->loadTile(tileId));
         }
       }
     }
@@ -149,33 +277,43 @@ void TreeManager::update() {
   // that can then be consumed by newly loaded ones.
   prune();
 
+  auto start = TimeBudget::Clock::now();
+
   // insert new nodes
-  merge();
+  if (mTimeBudget) {
+    merge(mTimeBudget->getDeadline());
+  } else {
+    merge(start + std::chrono::microseconds(mergeBudget));
+  }
+
+  processRefills();
 
   // upload tiles to GPU
+  auto deadline = mTimeBudget ? mTimeBudget->getDeadline() : TimeBudget::Clock::time_point::max();
+
   for (auto const& textureArray : mGLResources->mChannels) {
-    textureArray->processQueue(5);
+    textureArray->processQueue(uploadBudget, deadline);
+  }
+
+  completeRefills();
+
+  if (mTimeBudget) {
+    mTimeBudget->consume(start);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManager::clear() {
-  {
-    std::unique_lock<std::mutex> lck(mLoadedMtx);
-    mLoadedNodes.clear();
-  }
-
-  {
-    std::unique_lock<std::mutex> lck(mPendingMtx);
-    mPendingTiles.clear();
-  }
+  discardUnmergedNodes();
+  cancelRefills();
 
   for (auto* node : mNodes) {
     releaseResources(node);
   }
 
   mNodes.clear();
+  ++mGeneration;
 
   for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
     mTree.setRoot(i, nullptr);
@@ -186,17 +324,10 @@ void TreeManager::clear() {
 
 void TreeManager::onDataLoaded(TileId const& tileId, std::shared_ptr<BaseTileData> tileData) {
 
-  // If tile loading failed, discard the data.
-  if (!tileData) {
-    std::unique_lock<std::mutex> lck(mPendingMtx);
-    mPendingTiles.erase(tileId);
-    return;
-  }
-
   TileNode* node{};
 
   {
-    std::unique_lock<std::mutex> lck(mPendingMtx);
+    std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)> lck(mPendingMtx);
 
     // If the data is not need the tile anymore, discard it.
     auto it = mPendingTiles.find(tileId);
@@ -204,33 +335,79 @@ void TreeManager::onDataLoaded(TileId const& tileId, std::shared_ptr<BaseTileDat
       return;
     }
 
-    node = it->second;
+    // If tile loading failed or the tile has been cancelled, discard the data. The node cannot be
+    // completed anymore, so all other requests for this node are cancelled as well.
+    if (!tileData || it->second.mCancelled) {
+      --it->second.mOutstanding;
+      cancelPendingTile(it);
+      return;
+    }
+
+    node = it->second.mNode;
   }
 
+  // The bounds depend on the elevation data only. They are computed here, so that the node can be
+  // culled tightly as soon as it has been merged and the main thread does not have to do this.
   if (tileData->getDataType() == TileDataType::eElevation) {
     auto demdata = dynamic_cast<TileData<float>*>(tileData.get());
-    node->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(demdata));
+    auto pyramid = std::make_unique<MinMaxPyramid>(demdata);
+
+    BoundsParameters params;
+    {
+      std::unique_lock<std::mutex> lck(mBoundsMtx);
+      params = mBoundsParameters;
+    }
+
+    node->setBounds(calcTileBounds(pyramid->getMin(), pyramid->getMax(),
+                        HEALPixCache::computePatch(tileId, params.mRadii), params.mHeightScale),
+        params.mRevision);
+    node->setMinMaxPyramid(std::move(pyramid));
   }
 
   node->setTileData(std::move(tileData));
 
-  auto dem = node->getTileData(TileDataType::eElevation);
-  auto img = node->getTileData(TileDataType::eColor);
+  {
+    std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)> lck(mPendingMtx);
 
-  bool hasColorChannel = false;
+    // The entry cannot have been removed in the meantime, as we did not yet decrement the number
+    // of outstanding callbacks.
+    auto it = mPendingTiles.find(tileId);
+    --it->second.mOutstanding;
 
-  {
-    std::unique_lock<std::mutex> lck(mSourcesMtx);
-    hasColorChannel = mTileDataSources.get(TileDataType::eColor);
+    if (it->second.mCancelled) {
+      cancelPendingTile(it);
+      return;
+    }
+
+    // Wait for the data of the other tile sources.
+    if (it->second.mOutstanding > 0) {
+      return;
+    }
+
+    // The node cannot be cancelled anymore.
+    it->second.mRequests.clear();
   }
 
-  if (dem && (img || !hasColorChannel)) {
-    // Only add node to list of loaded nodes, actual insertion into the
-    // quad-tree is done in merge().
-    // This ensures that the tree is not modified at unpredictable moments
-    // in time (for example while a traversal is in progress).
-    std::unique_lock<std::mutex> lck(mLoadedMtx);
-    mLoadedNodes.push_back(node);
+  // Only add node to list of loaded nodes, actual insertion into the
+  // quad-tree is done in merge().
+  // This ensures that the tree is not modified at unpredictable moments
+  // in time (for example while a traversal is in progress).
+  mLoadedNodes.push(node);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::cancelPendingTile(
+    cs::utils::FlatHashMap<TileId, PendingTile>::iterator const& it) {
+  for (auto const& request : it->second.mRequests) {
+    request->cancel();
+  }
+
+  it->second.mCancelled = true;
+
+  if (it->second.mOutstanding == 0) {
+    delete it->second.mNode; // NOLINT(cppcoreguidelines-owning-memory): created in request()
+    mPendingTiles.erase(it);
   }
 }
 
@@ -242,9 +419,11 @@ void TreeManager::onNodeInserted(TileNode* node) {
     assert(parent != nullptr);
 
     node->setLastFrame(parent->getLastFrame());
+    refineParentBounds(parent);
   }
 
   mNodes.push_back(node);
+  ++mGeneration;
 
   for (auto const& res : mGLResources->mChannels) {
     auto data = node->getTileData(res->getDataType());
@@ -256,6 +435,36 @@ void TreeManager::onNodeInserted(TileNode* node) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TreeManager::refineParentBounds(TileNode* parent) {
+  if (!parent->childrenAvailable() || !parent->hasBounds()) {
+    return;
+  }
+
+  glm::dvec3 childMin(std::numeric_limits<double>::max());
+  glm::dvec3 childMax(std::numeric_limits<double>::lowest());
+
+  for (int i = 0; i < 4; ++i) {
+    TileNode const* child = parent->getChild(i);
+
+    if (!child->hasBounds() || child->getBoundsRevision() != parent->getBoundsRevision()) {
+      return;
+    }
+
+    childMin = glm::min(childMin, child->getBounds().getMin());
+    childMax = glm::max(childMax, child->getBounds().getMax());
+  }
+
+  glm::dvec3 bbMin = glm::max(parent->getBounds().getMin(), childMin);
+  glm::dvec3 bbMax = glm::min(parent->getBounds().getMax(), childMax);
+
+  // The boxes may not overlap due to numerical inaccuracies if the tile is very flat.
+  if (glm::all(glm::lessThanEqual(bbMin, bbMax))) {
+    parent->setBounds(BoundingBox<double>(bbMin, bbMax), parent->getBoundsRevision());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TreeManager::releaseResources(TileNode* node) {
   for (auto const& res : mGLResources->mChannels) {
     auto data = node->getTileData(res->getDataType());
@@ -263,77 +472,300 @@ void TreeManager::releaseResources(TileNode* node) {
       res->releaseGPU(data);
     }
   }
+
+  auto request = mRefillRequests.find(node);
+  if (request != mRefillRequests.end()) {
+    request->second->cancel();
+    mRefillRequests.erase(request);
+  }
+
+  auto upload = mRefillUploads.find(node);
+  if (upload != mRefillUploads.end()) {
+    mGLResources->get(mRefillType)->releaseGPU(upload->second);
+    mRefillUploads.erase(upload);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TreeManager::prune() {
-  // sort by age, oldest nodes at the back
-  std::sort(mNodes.begin(), mNodes.end(), AgeLess(mFrameCount));
-  int count = 0;
+void TreeManager::discardUnmergedNodes() {
+  // Loaded nodes are neither part of the tree nor referenced by their pending tile anymore.
+  while (auto node = mLoadedNodes.tryPop()) {
+    delete *node; // NOLINT(cppcoreguidelines-owning-memory)
+  }
 
-  while (!mNodes.empty()) {
-    TileNode* node = mNodes.back();
+  for (auto const& unmerged : mUnmergedNodes) {
+    delete unmerged.mNode; // NOLINT(cppcoreguidelines-owning-memory)
+  }
 
-    // remove unnused nodes, but never root nodes
-    if (node->getAge(mFrameCount) > maxNodeAge && node->getLevel() > 0) {
-      releaseResources(node);
+  mUnmergedNodes.clear();
 
-      if (!removeNode(&mTree, node)) {
-        vstr::errp() << "[TreeManager::prune] Failed to remove node " << node << "!" << std::endl;
-      }
+  std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)> lck(mPendingMtx);
+
+  // Nodes which are still being loaded cannot be deleted right away, as the loader threads may
+  // currently access them. They will be deleted once all callbacks have been received.
+  for (auto it = mPendingTiles.begin(); it != mPendingTiles.end();) {
+    auto current = it++;
+
+    if (current->second.mOutstanding > 0) {
+      cancelPendingTile(current);
+    } else {
+      mPendingTiles.erase(current);
+    }
+  }
+}
 
-      // remove entries for node from internal data structures
-      mNodes.pop_back();
-      ++count;
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::refillNodes(TileDataType type, TileSource* src) {
+  cancelRefills();
+
+  // Nodes which are not part of the tree yet contain data of the previous source. They will be
+  // requested again if they are still required.
+  discardUnmergedNodes();
+
+  {
+    std::unique_lock<std::mutex> lck(mSourcesMtx);
+    mTileDataSources.set(type, src);
+  }
+
+  mRefillType = type;
+  ++mRefillGeneration;
+
+  for (auto* node : mNodes) {
+    // Nodes which have been visible recently are reloaded first.
+    auto priority = mFrameCount - node->getLastFrame() <= 1 ? TileRequest::Priority::eHigh
+                                                            : TileRequest::Priority::eNormal;
+
+    mRefillRequests[node] = src->loadTileAsync(node->getTileId(), priority,
+        [this, node, generation = mRefillGeneration](auto /*tileId*/, auto data) {
+          mLoadedRefills.push({node, generation, std::move(data)});
+        });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::processRefills() {
+  auto const& textureArray = mGLResources->get(mRefillType);
+
+  while (auto refill = mLoadedRefills.tryPop()) {
+    if (refill->mGeneration != mRefillGeneration) {
+      continue;
+    }
+
+    // The node may have been removed from the tree in the meantime.
+    auto request = mRefillRequests.find(refill->mNode);
+    if (request == mRefillRequests.end()) {
+      continue;
+    }
+
+    mRefillRequests.erase(request);
+
+    // If loading failed, the node keeps its old data.
+    if (!refill->mData) {
+      continue;
+    }
+
+    auto statistics = textureArray->getStatistics();
+
+    if (statistics.mUsedLayers + statistics.mPendingUploads < statistics.mTotalLayers) {
+      textureArray->allocateGPU(refill->mData);
+      mRefillUploads[refill->mNode] = std::move(refill->mData);
     } else {
-      // The node at the back of mAgeStore can not be removed - stop
-      // The sorting of mAgeStore ensures that there is no node that
-      // could be removed beyond this point.
+      replaceTileData(refill->mNode, std::move(refill->mData));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::completeRefills() {
+  for (auto it = mRefillUploads.begin(); it != mRefillUploads.end();) {
+    if (it->second->getTexLayer() >= 0) {
+      replaceTileData(it->first, std::move(it->second));
+      it = mRefillUploads.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::cancelRefills() {
+  for (auto const& [node, request] : mRefillRequests) {
+    request->cancel();
+  }
+
+  for (auto const& [node, data] : mRefillUploads) {
+    mGLResources->get(mRefillType)->releaseGPU(data);
+  }
+
+  mRefillRequests.clear();
+  mRefillUploads.clear();
+
+  // Data which is still being loaded will be discarded once it arrives.
+  ++mRefillGeneration;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::replaceTileData(TileNode* node, std::shared_ptr<BaseTileData> data) {
+  auto const& textureArray = mGLResources->get(data->getDataType());
+  auto const& previous     = node->getTileData(data->getDataType());
+
+  if (previous) {
+    textureArray->releaseGPU(previous);
+  }
+
+  // This has no effect if the data is already uploaded or queued.
+  textureArray->allocateGPU(data);
+  node->setTileData(std::move(data));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::prune() {
+  // Collect all nodes which could be removed right away. Root nodes are never removed.
+  std::unordered_set<TileNode const*> removed;
+  std::vector<TileNode*>              candidates;
+
+  for (auto* node : mNodes) {
+    if (node->getLevel() > 0 && node->getAge(mFrameCount) >= minNodeAge && isLeaf(node, removed)) {
+      candidates.push_back(node);
+    }
+  }
+
+  // The candidates are kept in a heap so that only the removed nodes have to be ordered. Once a
+  // node has been removed, its parent may become a candidate.
+  RemovalLess less(mFrameCount);
+  std::make_heap(candidates.begin(), candidates.end(), less);
+
+  std::size_t            excess = getExcessNodeCount();
+  std::vector<TileNode*> removalOrder;
+
+  while (!candidates.empty()) {
+    TileNode* node = candidates.front();
+
+    if (node->getAge(mFrameCount) <= maxNodeAge && removalOrder.size() >= excess) {
       break;
     }
+
+    std::pop_heap(candidates.begin(), candidates.end(), less);
+    candidates.pop_back();
+
+    removalOrder.push_back(node);
+    removed.insert(node);
+
+    TileNode* parent = node->getParent();
+    if (parent && parent->getLevel() > 0 && parent->getAge(mFrameCount) >= minNodeAge &&
+        isLeaf(parent, removed)) {
+      candidates.push_back(parent);
+      std::push_heap(candidates.begin(), candidates.end(), less);
+    }
+  }
+
+  if (removalOrder.empty()) {
+    return;
+  }
+
+  ++mGeneration;
+
+  mNodes.erase(std::remove_if(mNodes.begin(), mNodes.end(),
+                   [&](TileNode* node) { return removed.find(node) != removed.end(); }),
+      mNodes.end());
+
+  // Children are always removed before their parents.
+  for (auto* node : removalOrder) {
+    releaseResources(node);
+
+    if (!removeNode(&mTree, node)) {
+      vstr::errp() << "[TreeManager::prune] Failed to remove node " << node << "!" << std::endl;
+    }
   }
 
-  if (count > 0) {
 #if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
-    vstr::outi() << "[TreeManager::prune] nodes removed/kept " << count << " / " << mRdMap.size()
-                 << std::endl;
+  vstr::outi() << "[TreeManager::prune] nodes removed/kept " << removalOrder.size() << " / "
+               << mNodes.size() << std::endl;
 #endif
-  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TreeManager::merge() {
-  // exchange mLoadedNodes and mergeNodes so the lock need not be held
-  // for the duration of the whole merge
-  std::vector<TileNode*> mergeNodes;
-  {
-    std::unique_lock<std::mutex> lck(mLoadedMtx);
+std::size_t TreeManager::getExcessNodeCount() const {
+  if (mNodes.empty()) {
+    return 0;
+  }
 
-    mergeNodes = mLoadedNodes;
-    mLoadedNodes.clear();
+  std::size_t excess = 0;
+
+  // The texture arrays are shared by all bodies. Each body removes a share of the excess layers
+  // which corresponds to the share of layers it occupies.
+  for (auto const& textureArray : mGLResources->mChannels) {
+    auto   statistics = textureArray->getStatistics();
+    double required   = static_cast<double>(statistics.mUsedLayers + statistics.mPendingUploads);
+    double available  = maxResidency * static_cast<double>(statistics.mTotalLayers);
+
+    if (required > available) {
+      double share = static_cast<double>(mNodes.size()) / required;
+      auto   count = static_cast<std::size_t>(std::ceil((required - available) * share));
+      excess       = std::max(excess, count);
+    }
+  }
+
+  // The tile pool contains the tiles of this body only.
+  for (auto const* src : mTileDataSources.mChannels) {
+    if (!src || !src->getTilePool() || src->getTilePool()->getBudget() == 0) {
+      continue;
+    }
+
+    auto   statistics = src->getTilePool()->getStatistics();
+    double used       = static_cast<double>(statistics.mUsedBytes);
+    double available  = maxResidency * static_cast<double>(src->getTilePool()->getBudget());
+
+    if (used > available) {
+      double bytesPerNode = used / static_cast<double>(mNodes.size());
+      auto   count        = static_cast<std::size_t>(std::ceil((used - available) / bytesPerNode));
+      excess              = std::max(excess, count);
+    }
   }
 
-  int merged   = 0;
-  int unmerged = 0;
+  return excess;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::merge(TimeBudget::Clock::time_point deadline) {
+  CS_TRACE_ZONE("TreeManager::merge");
+
+  // Take the loaded nodes from the queue until the deadline has passed. At least one node is
+  // merged in each frame, so that loading progresses even if the budget is exhausted.
+  // The pending tiles of all inserted or discarded nodes are erased at the end with one lock.
+  std::vector<TileId>    finishedTiles;
+  std::vector<TileNode*> unmergedNodes;
+
+  int merged = 0;
+
+  while ((merged == 0 && unmergedNodes.empty()) || TimeBudget::Clock::now() < deadline) {
+    auto next = mLoadedNodes.tryPop();
+
+    if (!next) {
+      break;
+    }
+
+    TileNode* node = *next;
 
-  for (auto& node : mergeNodes) {
     assert(node != nullptr);
-    assert(node->getTile() != nullptr);
 
     if (insertNode(&mTree, node)) {
       onNodeInserted(node);
+      finishedTiles.push_back(node->getTileId());
       ++merged;
-
-      std::unique_lock<std::mutex> lck(mPendingMtx);
-      mPendingTiles.erase(node->getTileId());
-
-      node = nullptr;
     } else {
       // keep track of nodes that could not be inserted, e.g. because
       // their parent is currently not loaded
-      ++unmerged;
+      unmergedNodes.push_back(node);
     }
   }
 
@@ -347,13 +779,14 @@ void TreeManager::merge() {
     if (insertNode(&mTree, node)) {
       // insert succeeded, remove from pending and unmerged and
       // associate render data with node
-      mPendingTiles.erase(node->getTileId());
+      finishedTiles.push_back(node->getTileId());
       mUnmergedNodes.erase(mUnmergedNodes.begin() + i);
 
       onNodeInserted(node);
+      ++merged;
     } else if ((mFrameCount - mUnmergedNodes[i].mFrame) > maxUnmergedAge) {
       // node is waiting for too long to be merged - discard it
-      mPendingTiles.erase(node->getTileId());
+      finishedTiles.push_back(node->getTileId());
       mUnmergedNodes.erase(mUnmergedNodes.begin() + i);
 
       delete node; // NOLINT(cppcoreguidelines-owning-memory): TODO where does it get created?
@@ -362,23 +795,27 @@ void TreeManager::merge() {
     }
   }
 
-  // copy any nodes that where not merged to mUnmergedNodes
-  if (unmerged > 0) {
-    // Store unmerged nodes together with the current frame number.
-    // Attempts to merge these into the tree will be made until their age
-    // exceeds maxUnmergedAge (see mergeUnmerged).
-    for (auto const& node : mergeNodes) {
-      if (node) {
-        mUnmergedNodes.emplace_back(node, mFrameCount);
-        --unmerged;
-      }
+  // Store unmerged nodes together with the current frame number.
+  // Attempts to merge these into the tree will be made until their age
+  // exceeds maxUnmergedAge.
+  for (auto* node : unmergedNodes) {
+    mUnmergedNodes.emplace_back(node, mFrameCount);
+  }
+
+  if (!finishedTiles.empty()) {
+    std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)> lck(mPendingMtx);
+    for (auto const& tileId : finishedTiles) {
+      mPendingTiles.erase(tileId);
     }
   }
 
-  if (merged > 0 || unmerged > 0) {
+  CS_TRACE_PLOT("LoD Merged Nodes", static_cast<int64_t>(merged));
+  CS_TRACE_PLOT("LoD Unmerged Nodes", static_cast<int64_t>(mUnmergedNodes.size()));
+
+  if (merged > 0 || !unmergedNodes.empty()) {
 #if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
-    vstr::outi() << "[TreeManager::merge] nodes merged/unmerged " << merged << " / " << unmerged
-                 << std::endl;
+    vstr::outi() << "[TreeManager::merge] nodes merged/unmerged " << merged << " / "
+                 << unmergedNodes.size() << std::endl;
 #endif
   }
 }
@@ -397,10 +834,45 @@ std::shared_ptr<GLResources> const& TreeManager::getGLResources() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TreeManager::setTimeBudget(std::shared_ptr<TimeBudget> budget) {
+  mTimeBudget = std::move(budget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TimeBudget> const& TreeManager::getTimeBudget() const {
+  return mTimeBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::setBoundsParameters(
+    glm::dvec3 const& radii, double heightScale, uint64_t revision) {
+  std::unique_lock<std::mutex> lck(mBoundsMtx);
+  mBoundsParameters.mRadii       = radii;
+  mBoundsParameters.mHeightScale = heightScale;
+  mBoundsParameters.mRevision    = revision;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TreeManager::setFrameCount(int frameCount) {
   mFrameCount = frameCount;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::size_t TreeManager::getGeneration() const {
+  return mGeneration;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TreeManager::getPendingCount() const {
+  std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)> lck(mPendingMtx);
+  return mPendingTiles.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::lodbodies
@@ -8,11 +8,19 @@
 #ifndef CSP_LOD_BODIES_TREEMANAGER_HPP
 #define CSP_LOD_BODIES_TREEMANAGER_HPP
 
+#include "../../../src/cs-utils/FlatHashMap.hpp"
+#include "../../../src/cs-utils/MPSCQueue.hpp"
+#include "../../../src/cs-utils/Tracing.hpp"
 #include "TileId.hpp"
 #include "TileQuadTree.hpp"
+#include "TileRequest.hpp"
+#include "TimeBudget.hpp"
 
+#include <glm/glm.hpp>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -34,9 +42,17 @@ class TileTextureArray;
 /// time it was used - other classes mark nodes as used (e.g. LODVisitor when testing visibility of
 /// a node).
 ///
-/// In order to quickly find "old" nodes a vector of node pointers is used. The vector is sorted so
-/// that the oldest nodes are at the back and those are removed if their age exceeds a certain
-/// threshold (see TreeManager::prune).
+/// Nodes are removed if their age exceeds a certain threshold. If the layers of the shared
+/// TileTextureArrays or the memory budget of the TilePool of this body are about to be exhausted,
+/// further unused nodes are removed early. These are chosen by their screen-space error and age
+/// (see TreeManager::prune).
+///
+/// Tiles which have been requested but are not part of the requested set anymore (e.g. because the
+/// observer moved on) are first demoted to a lower priority. If they are not requested again for
+/// some frames, their requests are cancelled so that they do not block more important tiles.
+///
+/// Merging loaded tiles and uploading them to the GPU is limited by the TimeBudget shared by all
+/// bodies. Tiles which do not fit into the budget of one frame are processed in the next frames.
 class TreeManager {
  public:
   explicit TreeManager(std::shared_ptr<GLResources> glResources);
@@ -49,7 +65,11 @@ class TreeManager {
 
   virtual ~TreeManager() = default;
 
-  /// Set tile source to use.
+  /// Set tile source to use. If the color source of a tree which already contains nodes is
+  /// exchanged for another one while loading asynchronously, the tree is kept. The color data of
+  /// all nodes is then reloaded from the new source in the background and each node continues to
+  /// be drawn with its old data until the new one has been uploaded. In all other cases, all nodes
+  /// are removed.
   void setSource(TileDataType type, TileSource* src);
 
   /// Returns pointer to the TileQuadTree managed by this.
@@ -57,21 +77,50 @@ class TreeManager {
 
   std::shared_ptr<GLResources> const& getGLResources() const;
 
+  /// The time spent in update() is subtracted from this budget. If no budget is set, merging is
+  /// limited to a fixed duration per frame and uploads are only limited by their size.
+  void                               setTimeBudget(std::shared_ptr<TimeBudget> budget);
+  std::shared_ptr<TimeBudget> const& getTimeBudget() const;
+
   /// Request data tiles with indices tileIds to be loaded and queued to be merged into the quad
-  /// tree (with a subsequent call to update).
+  /// tree (with a subsequent call to update). This should be called once a frame with all tiles
+  /// which are currently required. Pending tiles which are not contained in tileIds are demoted
+  /// and eventually cancelled.
   void request(std::vector<TileId> const& tileIds);
 
+  /// Request data tiles which are likely to be required in the near future. They are loaded with a
+  /// lower priority than the tiles passed to request(). Tiles which have already been requested
+  /// keep their priority. This should be called after request(), as the pending tiles which are
+  /// not passed to either function are demoted and eventually cancelled as well. Prefetching is
+  /// only supported for asynchronous loading; if it is disabled, this does nothing.
+  void prefetch(std::vector<TileId> const& tileIds);
+
   /// Update the TileQuadTree managed by this with the tiles that have been loaded from the
-  /// TileSource since the last call to update.
+  /// TileSource since the last call to update. Tiles which do not fit into the time budget of this
+  /// frame remain queued for the next call.
   void update();
 
   /// Removes all nodes from the tree and frees data associated with them.
   void clear();
 
+  /// The bounds of newly loaded nodes are computed on the loader threads for the given body radii
+  /// and height scale, so that they are available as soon as the node is merged. The revision has
+  /// to be the one of the LODVisitors, see LODVisitor::queueRecomputeTileBounds(). This has to be
+  /// called whenever one of these values changes.
+  void setBoundsParameters(glm::dvec3 const& radii, double heightScale, uint64_t revision);
+
   void setFrameCount(int frameCount);
 
+  /// This is incremented whenever nodes are inserted into or removed from the tree. It can be used
+  /// to detect whether the geometry of the body may have changed.
+  std::size_t getGeneration() const;
+
+  /// Returns the number of tiles which have been requested but not yet been merged into the tree.
+  /// This is thread-safe.
+  std::size_t getPendingCount() const;
+
  private:
-  struct AgeLess;
+  struct RemovalLess;
 
   /// Tracks a node and the frame it was loaded in - for nodes that can not immediately be merged.
   struct NodeAge {
@@ -81,44 +130,134 @@ class TreeManager {
     int       mFrame;
   };
 
-  /// Used as a callback for the TileSource to call when a node is loaded.
+  /// Tracks a node which has been requested from the tile sources.
+  struct PendingTile {
+    TileNode* mNode{};
+
+    /// One request for each tile source. They are cleared once the node has been loaded.
+    std::vector<std::shared_ptr<TileRequest>> mRequests;
+
+    /// The number of tile sources which have not yet invoked onDataLoaded() for this node.
+    int mOutstanding{};
+
+    /// The last frame in which this tile was passed to request() or prefetch().
+    int mLastRequested{};
+
+    /// If set, the node will be deleted once all outstanding callbacks have been received.
+    bool mCancelled{};
+  };
+
+  /// Requests all given tiles which are not pending yet with the given priority. Tiles which are
+  /// loaded synchronously are appended to loadedTiles. This requires mPendingMtx to be locked.
+  void requestTiles(std::vector<TileId> const& tileIds, TileRequest::Priority priority,
+      std::vector<std::pair<TileId, std::shared_ptr<BaseTileData>>>& loadedTiles);
+
+  /// Used as a callback for the TileSource to call when a node is loaded. Once all data of a node
+  /// has been loaded, it is pushed to mLoadedNodes without blocking the main thread.
   void onDataLoaded(TileId const& tileId, std::shared_ptr<BaseTileData> tileData);
 
   /// Helper function to handle processing after node is successfully inserted into the managed
   /// TileQuadTree.
   void onNodeInserted(TileNode* node);
 
+  /// Once all children of the given node are resident, its bounds are intersected with the union of
+  /// the bounds of its children. These sample the surface at more points and are hence tighter.
+  /// This only happens if all bounds have been computed for the same revision.
+  void refineParentBounds(TileNode* parent);
+
+  /// Cancels all outstanding requests of the given pending tile. If there are no outstanding
+  /// callbacks anymore, the tile is removed from mPendingTiles and its node is deleted. This
+  /// requires mPendingMtx to be locked.
+  void cancelPendingTile(cs::utils::FlatHashMap<TileId, PendingTile>::iterator const& it);
+
   /// Helper function to free resources associated with node.
   void releaseResources(TileNode* node);
 
+  /// Deletes all nodes which have been requested or loaded but are not part of the tree yet.
+  void discardUnmergedNodes();
+
+  /// Requests the data of the given type of each node in the tree from the new source, see
+  /// setSource(). The new data is handled by processRefills().
+  void refillNodes(TileDataType type, TileSource* src);
+
+  /// Uploads newly loaded data for nodes in the tree and replaces the old data of the nodes once
+  /// the new data is available on the GPU. New data is uploaded while the old one is still in use
+  /// as long as there are free layers in the texture array; else the old data is released first.
+  void processRefills();
+  void completeRefills();
+
+  /// Cancels all outstanding requests of refillNodes() and releases the data which has not yet
+  /// replaced the data of its node.
+  void cancelRefills();
+
+  /// Releases the current data of the node with the same type and stores the given data instead.
+  void replaceTileData(TileNode* node, std::shared_ptr<BaseTileData> data);
+
   /// Remove nodes from the managed TileQuadTree that have not been used for a number of frames.
-  /// Sort tiles by age (frames since last use, see TreeManager::AgeLess for details) and
-  /// removes those considered too "old".
+  /// If getExcessNodeCount() is larger than zero, this many younger nodes are removed in addition,
+  /// see TreeManager::RemovalLess for details. Only the removed nodes are ordered, so this takes
+  /// linear time if only few nodes are removed.
   void prune();
 
+  /// Returns the number of nodes which should be removed from this tree in order to keep the
+  /// TileTextureArrays and the TilePool of the tile sources below their residency threshold.
+  std::size_t getExcessNodeCount() const;
+
   /// Merge nodes loaded since the last merge into the managed TileQuadTree. It is possible that a
   /// loaded node can not be inserted into the tree, for example because its parent has been removed
   /// in the meantime. These "unmerged" nodes are kept around in mUnmergedNodes for a few frames, in
   /// case the parent node is loaded in the meantime. If this "grace period" has expired and the
   /// node still cannot be inserted into the tree it is deleted.
-  void merge();
+  /// Loaded nodes are only taken from mLoadedNodes until the given deadline has passed, the
+  /// remaining nodes are merged in the next frames.
+  void merge(TimeBudget::Clock::time_point deadline);
 
   std::shared_ptr<GLResources> mGLResources;
+  std::shared_ptr<TimeBudget>  mTimeBudget;
   std::vector<TileNode*>       mNodes;
 
   TileQuadTree             mTree;
   PerDataType<TileSource*> mTileDataSources;
 
-  std::unordered_map<TileId, TileNode*> mPendingTiles;
-  std::vector<NodeAge>                  mUnmergedNodes;
-  std::vector<TileNode*>                mLoadedNodes;
+  cs::utils::FlatHashMap<TileId, PendingTile> mPendingTiles;
+  std::vector<NodeAge>                        mUnmergedNodes;
+  cs::utils::MPSCQueue<TileNode*>             mLoadedNodes;
 
   std::mutex mSourcesMtx;
-  std::mutex mLoadedMtx;
-  std::mutex mPendingMtx;
 
-  int  mFrameCount;
-  bool mAsyncLoading;
+  /// Data which has been loaded for a node which is already part of the tree, see refillNodes().
+  /// The generation is used to discard data of previous calls to refillNodes().
+  struct Refill {
+    TileNode*                     mNode{};
+    uint64_t                      mGeneration{};
+    std::shared_ptr<BaseTileData> mData;
+  };
+
+  // The outstanding requests of refillNodes(), the loaded data which has not yet been processed
+  // and the data which is being uploaded to replace the current data of its node.
+  std::unordered_map<TileNode*, std::shared_ptr<TileRequest>>  mRefillRequests;
+  cs::utils::MPSCQueue<Refill>                                 mLoadedRefills;
+  std::unordered_map<TileNode*, std::shared_ptr<BaseTileData>> mRefillUploads;
+  TileDataType                                                 mRefillType = TileDataType::eColor;
+  uint64_t                                                     mRefillGeneration = 0;
+
+  /// See setBoundsParameters(). These are read by the loader threads.
+  struct BoundsParameters {
+    glm::dvec3 mRadii       = glm::dvec3(1.0);
+    double     mHeightScale = 1.0;
+    uint64_t   mRevision    = 0;
+  };
+
+  BoundsParameters mBoundsParameters;
+  std::mutex       mBoundsMtx;
+
+  /// This is locked by the main thread and the loader threads, so its contention is shown in an
+  /// external profiler.
+  mutable CS_TRACE_MUTEX(std::mutex, mPendingMtx);
+
+  int         mFrameCount;
+  bool        mAsyncLoading;
+  std::size_t mGeneration = 0;
 };
 
 } // namespace csp::lodbodies
@@ -32,6 +32,7 @@ VistaPlanet::VistaPlanet(std::shared_ptr<GLResources> glResources, uint32_t tile
     : mWorldTransform(1.0)
     , mTreeMgr(std::move(glResources))
     , mLodVisitor(mParams, &mTreeMgr)
+    , mPrefetchVisitor(mParams, &mTreeMgr)
     , mRenderer(mParams, &mTreeMgr, tileResolution)
     , mLastFrameClock(GetVistaSystem()->GetFrameClock())
     , mSumFrameClock(0.0)
@@ -39,6 +40,10 @@ VistaPlanet::VistaPlanet(std::shared_ptr<GLResources> glResources, uint32_t tile
     , mSumLoadTiles(0)
     , mMaxDrawTiles(0)
     , mMaxLoadTiles(0) {
+
+  // The tiles which are drawn must get their grid resolution from the actual camera, not from the
+  // predicted one.
+  mPrefetchVisitor.setStoreScreenSpaceError(false);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -70,15 +75,21 @@ void VistaPlanet::draw() {
 
   int frameCount = GetVistaSystem()->GetFrameLoop()->GetFrameCount();
 
+  // In stereo setups, this is called once for each eye. The tile trees are only updated for the
+  // first eye, else a newly uploaded tile could show up in one eye only. Prefetching does not
+  // depend on the eye either, the tiles to draw and load however do.
+  bool isFirstView = frameCount != mLastDrawFrame;
+  mLastDrawFrame   = frameCount;
+
   // get matrices and viewport
   glm::mat4 matV = getViewMatrix();
   glm::mat4 matP = getProjectionMatrix();
 
-  // collect/print statistics
-  updateStatistics(frameCount);
+  if (isFirstView) {
+    // collect/print statistics
+    updateStatistics(frameCount);
 
-  // integrate newly loaded tiles/remove unused tiles
-  {
+    // integrate newly loaded tiles/remove unused tiles
     cs::utils::FrameStats::ScopedTimer timer(
         "Update Tile Trees", cs::utils::FrameStats::TimerMode::eCPU);
     updateTileTrees(frameCount);
@@ -91,11 +102,19 @@ void VistaPlanet::draw() {
     traverseTileTrees(frameCount, mWorldTransform, matV, matP);
   }
 
+  // determine tiles which will be required in the near future
+  bool prefetch = isFirstView && mPrefetchTransform;
+  if (prefetch) {
+    cs::utils::FrameStats::ScopedTimer timer(
+        "Traverse Prefetch Tile Trees", cs::utils::FrameStats::TimerMode::eCPU);
+    traversePrefetchTileTrees(frameCount, matV, matP);
+  }
+
   // pass requests to load tiles to TreeManagers
   {
     cs::utils::FrameStats::ScopedTimer timer(
         "Rrocess Load Requests", cs::utils::FrameStats::TimerMode::eCPU);
-    processLoadRequests();
+    processLoadRequests(prefetch);
   }
 
   // render
@@ -109,6 +128,9 @@ void VistaPlanet::draw() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::drawForShadowMap() {
+  mShadowDirty      = false;
+  mShadowGeneration = mTreeMgr.getGeneration();
+
   if (!mEnabled) {
     return;
   }
@@ -120,13 +142,35 @@ void VistaPlanet::drawForShadowMap() {
 
   traverseTileTrees(frameCount, mWorldTransform, matV, matP);
 
+  // In a layered pass, the projection encloses all cascades and the renderer draws each tile into
+  // the cascades it overlaps.
+  bool layered = mShadowMap && mShadowMap->getIsRenderingLayered();
+  mRenderer.setLayeredShadowMap(layered ? mShadowMap : nullptr);
+
   renderTiles(mWorldTransform, matV, matP, nullptr);
+
+  mRenderer.setLayeredShadowMap(nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool VistaPlanet::getIsShadowDirty() const {
+  return mShadowDirty || mShadowGeneration != mTreeMgr.getGeneration();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool VistaPlanet::getSupportsLayeredRendering() const {
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setWorldTransform(glm::dmat4 const& mat) {
-  mWorldTransform = mat;
+  if (mWorldTransform != mat) {
+    mWorldTransform = mat;
+    mShadowDirty    = true;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -137,8 +181,23 @@ glm::dmat4 VistaPlanet::getWorldTransform() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void VistaPlanet::setPrefetchTransform(std::optional<glm::dmat4> const& mat) {
+  mPrefetchTransform = mat;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<glm::dmat4> const& VistaPlanet::getPrefetchTransform() const {
+  return mPrefetchTransform;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void VistaPlanet::setEnabled(bool enabled) {
-  mEnabled = enabled;
+  if (mEnabled != enabled) {
+    mEnabled     = enabled;
+    mShadowDirty = true;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -167,17 +226,21 @@ void VistaPlanet::setDataSource(TileDataType type, TileSource* src) {
     return;
   }
 
-  // shut down old source
-  if (mTileDataSources.get(type)) {
-    mTileDataSources.get(type)->fini();
-    mTreeMgr.setSource(type, nullptr);
-  }
+  TileSource* previous = mTileDataSources.get(type);
   mTileDataSources.set(type, src);
+  mShadowDirty = true;
 
   // init new source
   if (src) {
     src->init();
-    mTreeMgr.setSource(type, src);
+  }
+
+  // The sources are exchanged in one step, so that the tree manager can keep the nodes if only the
+  // imagery changes. It cancels all requests to the old source before it is shut down.
+  mTreeMgr.setSource(type, src);
+
+  if (previous) {
+    previous->fini();
   }
 }
 
@@ -251,8 +314,30 @@ void VistaPlanet::traverseTileTrees(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void VistaPlanet::processLoadRequests() {
+void VistaPlanet::traversePrefetchTileTrees(
+    int frameCount, glm::mat4 const& matV, glm::mat4 const& matP) {
+
+  // If the tiles are frozen, nothing should be loaded.
+  if (!mLodVisitor.getUpdateLOD()) {
+    return;
+  }
+
+  // The prefetch visitor marks all nodes it visits as used as well. Hence nodes which have been
+  // prefetched will not be removed before they are actually required.
+  mPrefetchVisitor.setFrameCount(frameCount);
+  mPrefetchVisitor.setModelview(glm::dmat4(matV) * *mPrefetchTransform);
+  mPrefetchVisitor.setProjection(matP);
+  mPrefetchVisitor.visit();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void VistaPlanet::processLoadRequests(bool prefetch) {
   mTreeMgr.request(mLodVisitor.getLoadNodes());
+
+  if (prefetch && mLodVisitor.getUpdateLOD()) {
+    mTreeMgr.prefetch(mPrefetchVisitor.getLoadNodes());
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -307,7 +392,11 @@ glm::mat4 VistaPlanet::getProjectionMatrix() {
 void VistaPlanet::setRadii(glm::dvec3 const& radii) {
   if (mParams.mRadii != radii) {
     mParams.mRadii = radii;
+    mShadowDirty   = true;
     mLodVisitor.queueRecomputeTileBounds();
+    mPrefetchVisitor.queueRecomputeTileBounds();
+    mTreeMgr.setBoundsParameters(
+        mParams.mRadii, mParams.mHeightScale, mLodVisitor.getBoundsRevision());
   }
 }
 
@@ -322,7 +411,11 @@ glm::dvec3 const& VistaPlanet::getRadii() const {
 void VistaPlanet::setHeightScale(float scale) {
   if (mParams.mHeightScale != scale) {
     mParams.mHeightScale = scale;
+    mShadowDirty         = true;
     mLodVisitor.queueRecomputeTileBounds();
+    mPrefetchVisitor.queueRecomputeTileBounds();
+    mTreeMgr.setBoundsParameters(
+        mParams.mRadii, mParams.mHeightScale, mLodVisitor.getBoundsRevision());
   }
 }
 
@@ -335,7 +428,10 @@ double VistaPlanet::getHeightScale() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setLODFactor(float lodFactor) {
-  mParams.mLodFactor = lodFactor;
+  if (mParams.mLodFactor != lodFactor) {
+    mParams.mLodFactor = lodFactor;
+    mShadowDirty = true;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -347,7 +443,10 @@ double VistaPlanet::getLODFactor() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setMinLevel(int minLevel) {
-  mParams.mMinLevel = minLevel;
+  if (mParams.mMinLevel != minLevel) {
+    mParams.mMinLevel = minLevel;
+    mShadowDirty = true;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -359,7 +458,10 @@ int VistaPlanet::getMinLevel() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setMaxLevel(int maxLevel) {
-  mParams.mMaxLevel = maxLevel;
+  if (mParams.mMaxLevel != maxLevel) {
+    mParams.mMaxLevel = maxLevel;
+    mShadowDirty = true;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -370,6 +472,14 @@ int VistaPlanet::getMaxLevel() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void VistaPlanet::setTimeBudget(std::shared_ptr<TimeBudget> const& budget) {
+  mTreeMgr.setTimeBudget(budget);
+  mLodVisitor.setTimeBudget(budget);
+  mPrefetchVisitor.setTimeBudget(budget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 TileRenderer& VistaPlanet::getTileRenderer() {
   return mRenderer;
 }
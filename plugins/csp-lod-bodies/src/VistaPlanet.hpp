@@ -15,6 +15,7 @@
 
 #include "../../../src/cs-graphics/Shadows.hpp"
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <optional>
 
 class VistaGLSLShader;
 class VistaSystem;
@@ -58,9 +59,24 @@ class VistaPlanet : public cs::graphics::ShadowCaster {
   void draw();
   void drawForShadowMap() override;
 
+  /// Returns true if the world transform, the parameters or the tiles of the planet have changed
+  /// since the last call to drawForShadowMap().
+  bool getIsShadowDirty() const override;
+
+  /// The tiles are drawn into all cascades of a layered shadow map with one instanced draw call per
+  /// grid level.
+  bool getSupportsLayeredRendering() const override;
+
   void       setWorldTransform(glm::dmat4 const& mat);
   glm::dmat4 getWorldTransform() const;
 
+  /// If set, the tiles which would be required if the planet was seen with the given world
+  /// transform are requested in addition to the currently required tiles, but with a lower
+  /// priority. This should be set to the world transform which is expected for some time in the
+  /// future, so that the tiles are available once they are actually needed.
+  void                             setPrefetchTransform(std::optional<glm::dmat4> const& mat);
+  std::optional<glm::dmat4> const& getPrefetchTransform() const;
+
   void setEnabled(bool enabled);
   bool getEnabled() const;
 
@@ -101,6 +117,10 @@ class VistaPlanet : public cs::graphics::ShadowCaster {
   void setMaxLevel(int maxLevel);
   int  getMaxLevel() const;
 
+  /// Merging and uploading tiles as well as recomputing tile bounds is limited by this budget. It
+  /// is usually shared by all planets.
+  void setTimeBudget(std::shared_ptr<TimeBudget> const& budget);
+
   /// Returns the TileRenderer instance used to render this VistaPlanet.
   TileRenderer&       getTileRenderer();
   TileRenderer const& getTileRenderer() const;
@@ -114,7 +134,8 @@ class VistaPlanet : public cs::graphics::ShadowCaster {
   void updateTileTrees(int frameCount);
   void traverseTileTrees(
       int frameCount, glm::dmat4 const& matM, glm::mat4 const& matV, glm::mat4 const& matP);
-  void processLoadRequests();
+  void traversePrefetchTileTrees(int frameCount, glm::mat4 const& matV, glm::mat4 const& matP);
+  void processLoadRequests(bool prefetch);
   void renderTiles(glm::dmat4 const& matM, glm::mat4 const& matV, glm::mat4 const& matP,
       cs::graphics::ShadowMap* shadowMap);
 
@@ -123,12 +144,23 @@ class VistaPlanet : public cs::graphics::ShadowCaster {
 
   static bool sGlewInitialized;
 
-  glm::dmat4 mWorldTransform;
-  bool       mEnabled = false;
+  glm::dmat4                mWorldTransform;
+  std::optional<glm::dmat4> mPrefetchTransform;
+  bool                      mEnabled = false;
+
+  /// draw() is called once for each view, for example twice per frame in stereo setups. Work which
+  /// does not depend on the view is only done for the first view of each frame.
+  int mLastDrawFrame = -1;
+
+  /// Set whenever the shadow of the planet may have changed. The tree's generation is compared as
+  /// well, as tiles are merged and pruned independently of the other changes.
+  bool        mShadowDirty      = true;
+  std::size_t mShadowGeneration = 0;
 
   PlanetParameters mParams;
   TreeManager      mTreeMgr;
   LODVisitor       mLodVisitor;
+  LODVisitor       mPrefetchVisitor;
   TileRenderer     mRenderer;
 
   PerDataType<TileSource*> mTileDataSources;
@@ -18,10 +18,151 @@
 
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <queue>
+#include <thread>
+
 namespace csp::lodbodies::utils {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// For batched height queries, the position of each point within its root patch is quantized to
+// this many bits per axis. The quadtree is never descended deeper than this.
+int const sampleKeyBits = 30;
+
+// Batches with at least this many points are split among several threads if requested.
+std::size_t const parallelSampleCount = 4096;
+
+// A point of a batched height query. The key contains the root patch index in the upper four bits
+// followed by the interleaved child indices from the root down to sampleKeyBits levels, so sorting
+// by key groups the points by tile on every level of the quadtree.
+struct Sample {
+  uint64_t    mKey;
+  std::size_t mIndex;
+  glm::dvec2  mRelative;
+  glm::uvec2  mCell;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Bilinearly interpolates the elevation data of the given node. relative is in [0, 1].
+double sampleTile(TileNode const* node, glm::dvec2 relative) {
+  uint32_t size = node->getTileData().get(TileDataType::eElevation)->getResolution();
+
+  // Figure out flip
+  std::swap(relative.x, relative.y);
+
+  double u = relative.x * (size - 1);
+  double v = relative.y * (size - 1);
+
+  int uB = static_cast<int>(u);
+  int vB = static_cast<int>(v);
+
+  double uP = u - uB;
+  double vP = v - vB;
+
+  double h{};
+  double hP1{};
+  double hP2{};
+  double hPP{};
+
+  const auto* ptr = node->getTileData().get(TileDataType::eElevation)->getTypedPtr<float>();
+  h               = ptr[vB + size * uB]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  hP1 = ptr[vB + size * (uB + 1)];       // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  hP2 = ptr[vB + 1 + size * uB];         // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  hPP = ptr[vB + 1 + size * (uB + 1)];   // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  double interpol1 = (1.0 - uP) * h + uP * hP1;
+  double interpol2 = (1.0 - uP) * hP2 + uP * hPP;
+  double height    = (1.0 - vP) * interpol1 + vP * interpol2;
+
+  return height;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Samples all given points at the given node. The node is depth levels below the root.
+void sampleNode(TileNode const* node, int depth, Sample const* begin, Sample const* end,
+    std::vector<double>& heights) {
+  double scale = std::ldexp(1.0, depth);
+  int    shift = sampleKeyBits - depth;
+
+  for (auto const* sample = begin; sample != end; ++sample) {
+    glm::dvec2 cell(sample->mCell.x >> shift, sample->mCell.y >> shift);
+    heights[sample->mIndex] = sampleTile(node, sample->mRelative * scale - cell);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Samples all given points which are located in the given node. The points have to be sorted by
+// their key. If a child is not loaded, the points in there are sampled at the node itself.
+void sampleSubtree(TileNode const* node, int depth, Sample const* begin, Sample const* end,
+    std::vector<double>& heights) {
+
+  if (depth == sampleKeyBits) {
+    sampleNode(node, depth, begin, end, heights);
+    return;
+  }
+
+  int  shift    = 2 * (sampleKeyBits - 1 - depth);
+  auto childIdx = [shift](Sample const& s) { return static_cast<int>((s.mKey >> shift) & 3U); };
+
+  while (begin != end) {
+    int  idx      = childIdx(*begin);
+    auto childEnd = std::find_if(begin, end, [&](Sample const& s) { return childIdx(s) != idx; });
+
+    TileNode const* child = node->getChild(idx);
+
+    if (child) {
+      sampleSubtree(child, depth + 1, begin, childEnd, heights);
+    } else {
+      sampleNode(node, depth, begin, childEnd, heights);
+    }
+
+    begin = childEnd;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Samples the given points, which have to be sorted by key, starting at the root nodes.
+void sampleRoots(TileQuadTree const* tree, HeightSamplePrecision precision, Sample const* begin,
+    Sample const* end, std::vector<double>& heights) {
+
+  while (begin != end) {
+    uint64_t root    = begin->mKey >> (2 * sampleKeyBits);
+    auto     rootEnd = std::find_if(
+        begin, end, [&](Sample const& s) { return (s.mKey >> (2 * sampleKeyBits)) != root; });
+
+    TileNode const* node = tree->getRoot(static_cast<int>(root));
+
+    if (!node) {
+      for (auto const* sample = begin; sample != rootEnd; ++sample) {
+        heights[sample->mIndex] = 0.0;
+      }
+    } else if (precision == HeightSamplePrecision::eCoarse) {
+      sampleNode(node, 0, begin, rootEnd, heights);
+    } else {
+      sampleSubtree(node, 0, begin, rootEnd, heights);
+    }
+
+    begin = rootEnd;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 double getHeight(
     VistaPlanet const* planet, HeightSamplePrecision precision, glm::dvec2 const& lngLat) {
 
@@ -116,36 +257,77 @@ double getHeight(
     return 0.0;
   }
 
-  uint32_t size = child->getTileData().get(TileDataType::eElevation)->getResolution();
+  return sampleTile(child, relative1);
+}
 
-  // Figure out flip
-  std::swap(relative1.x, relative1.y);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  double u = relative1.x * (size - 1);
-  double v = relative1.y * (size - 1);
+void getHeights(VistaPlanet const* planet, HeightSamplePrecision precision,
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights, bool parallel) {
 
-  int uB = static_cast<int>(u);
-  int vB = static_cast<int>(v);
+  heights.assign(lngLats.size(), 0.0);
 
-  double uP = u - uB;
-  double vP = v - vB;
+  TreeManager* treeMgr = planet->getTileRenderer().getTreeManager();
 
-  double h{};
-  double hP1{};
-  double hP2{};
-  double hPP{};
+  if (treeMgr == nullptr || treeMgr->getTree() == nullptr) {
+    return;
+  }
 
-  const auto* ptr = child->getTileData().get(TileDataType::eElevation)->getTypedPtr<float>();
-  h               = ptr[vB + size * uB]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  hP1 = ptr[vB + size * (uB + 1)];       // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  hP2 = ptr[vB + 1 + size * uB];         // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  hPP = ptr[vB + 1 + size * (uB + 1)];   // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  // Loading missing tiles modifies the tree, so this cannot be batched.
+  if (precision == HeightSamplePrecision::eFine) {
+    for (std::size_t i = 0; i < lngLats.size(); ++i) {
+      heights[i] = getHeight(planet, precision, lngLats[i]);
+    }
+    return;
+  }
 
-  double interpol1 = (1.0 - uP) * h + uP * hP1;
-  double interpol2 = (1.0 - uP) * hP2 + uP * hPP;
-  double height    = (1.0 - vP) * interpol1 + vP * interpol2;
+  // Compute the key of each point and sort the points along the quadtree.
+  std::vector<Sample> samples(lngLats.size());
+  double              cellCount = std::ldexp(1.0, sampleKeyBits);
 
-  return height;
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    int        root     = HEALPix::convertLngLat2Base(lngLats[i]);
+    glm::dvec2 relative = glm::clamp(
+        HEALPix::convertBaseLngLat2XY(root, lngLats[i]), glm::dvec2(0.0), glm::dvec2(1.0));
+    glm::uvec2 cell(glm::min(relative * cellCount, glm::dvec2(cellCount - 1.0)));
+
+    uint64_t key = static_cast<uint64_t>(root);
+    for (int bit = sampleKeyBits - 1; bit >= 0; --bit) {
+      key = (key << 2U) | (((cell.y >> bit) & 1U) << 1U) | ((cell.x >> bit) & 1U);
+    }
+
+    samples[i] = {key, i, relative, cell};
+  }
+
+  std::sort(samples.begin(), samples.end(),
+      [](Sample const& lhs, Sample const& rhs) { return lhs.mKey < rhs.mKey; });
+
+  TileQuadTree const* tree = treeMgr->getTree();
+
+  // The tree is not modified while this function runs, so the samples can be split among several
+  // threads. Tiles at the chunk boundaries are visited by two threads.
+  std::size_t threads = parallel && samples.size() >= parallelSampleCount
+                            ? std::max(1U, std::thread::hardware_concurrency())
+                            : 1;
+
+  if (threads == 1) {
+    sampleRoots(tree, precision, samples.data(), samples.data() + samples.size(), heights);
+    return;
+  }
+
+  std::vector<std::future<void>> tasks;
+  std::size_t                    chunkSize = (samples.size() + threads - 1) / threads;
+
+  for (std::size_t begin = 0; begin < samples.size(); begin += chunkSize) {
+    std::size_t end = std::min(begin + chunkSize, samples.size());
+    tasks.push_back(std::async(std::launch::async, [&, begin, end]() {
+      sampleRoots(tree, precision, samples.data() + begin, samples.data() + end, heights);
+    }));
+  }
+
+  for (auto& task : tasks) {
+    task.get();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -196,8 +378,15 @@ bool intersectPlanet(
   direction = planet_transformnv * direction;
   direction = glm::normalize(direction);
 
+  glm::dvec3 const& radii       = planet->getRadii();
+  double            heightScale = planet->getHeightScale();
+
+  // Intersected tiles ordered by their entry distance, the closest one is on top. The quadtree
+  // serves as bounding volume hierarchy: subtrees are skipped if the ray misses their root.
+  using Candidate = std::pair<double, TileNode*>;
+  std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> intersected_tiles;
+
   // Determine intersected root patches
-  std::multimap<double, TileNode*> intersected_tiles;
   for (int rootIndex = 0; rootIndex < 12; ++rootIndex) {
 
     TileNode* root_node = planet->getTileRenderer().getTreeManager()->getTree()->getRoot(rootIndex);
@@ -210,7 +399,7 @@ bool intersectPlanet(
     double max_dist{};
     bool intersects = intersectTileBounds(root_node, planet, origin, direction, min_dist, max_dist);
     if (intersects) {
-      intersected_tiles.insert(std::pair<double, TileNode*>(min_dist, root_node));
+      intersected_tiles.emplace(min_dist, root_node);
     }
   }
 
@@ -219,8 +408,8 @@ bool intersectPlanet(
 
   // Process intersected tile patch priority queue:
   while (!intersected_tiles.empty()) {
-    parent = intersected_tiles.begin()->second;
-    intersected_tiles.erase(intersected_tiles.begin());
+    parent = intersected_tiles.top().second;
+    intersected_tiles.pop();
 
     if (parent == nullptr) {
       return false;
@@ -274,42 +463,44 @@ bool intersectPlanet(
           glm::length(sampleDir) / glm::length(tile_bounds.getMax() - tile_bounds.getMin());
       auto step_nr = step_factor * max_bbox_samplings;
 
+      // The HEALPix coordinates of the samples are computed relative to this patch.
+      int  base  = HEALPix::getBasePatch(parent->getTileId());
+      auto scale = HEALPix::getPatchOffsetScale(parent->getTileId());
+
+      // No point of this tile is higher than this. As the ray cannot reach the terrain before it
+      // has descended to this altitude, samples far above it may be skipped.
+      double maxHeight = std::numeric_limits<double>::max();
+      if (parent->getMinMaxPyramid()) {
+        maxHeight = parent->getMinMaxPyramid()->getMax() * heightScale;
+      }
+
+      double segmentLength = glm::length(sampleDir);
+      double stepLength    = segmentLength / step_nr;
+      double steps         = 0.0;
+
       // Sample between entry and exit:
-      for (int step(0); step <= static_cast<int>(step_nr); ++step) {
+      while (steps <= std::floor(step_nr)) {
         lastSampleCartesian    = sampleCartesian;
         lastSampleLngLatHeight = sampleLngLatHeight;
         lastHeight             = height;
 
         // Sample along ray and then convert to polar:
-        sampleCartesian = glm::dvec3(entry[0], entry[1], entry[2]) +
-                          glm::dvec3((step / step_nr) * sampleDir[0],
-                              (step / step_nr) * sampleDir[1], (step / step_nr) * sampleDir[2]);
+        sampleCartesian    = entry.xyz() + (steps / step_nr) * sampleDir;
+        sampleLngLatHeight = cs::utils::convert::cartesianToLngLatHeight(sampleCartesian, radii);
 
-        sampleLngLatHeight =
-            cs::utils::convert::cartesianToLngLatHeight(sampleCartesian, planet->getRadii());
+        // The geodetic height is the distance to the ellipsoid, so the next sample point may be
+        // at least as far away as the current one is above the highest point of the tile.
+        double clearance = sampleLngLatHeight.z - maxHeight;
+        steps += std::max(1.0, std::floor(clearance / stepLength));
 
         // Calc correct HPix coordinate for child patch in relation to base batch
-        int        base   = HEALPix::getBasePatch(parent->getTileId());
-        auto       scale  = HEALPix::getPatchOffsetScale(parent->getTileId());
         glm::dvec2 HPixPt = HEALPix::convertBaseLngLat2XY(base, sampleLngLatHeight.xy());
         HPixPt            = (HPixPt - glm::dvec2(scale[0], scale[1])) / scale[2];
 
-        /* Figure out flip */
-        std::swap(HPixPt.x, HPixPt.y);
-
-        // Calc coords in texture space
-        double u = HPixPt.x * (size - 1);
-        double v = HPixPt.y * (size - 1);
-
-        int uB = static_cast<int>(u);
-        int vB = static_cast<int>(v);
-
-        double uP = u - uB;
-        double vP = v - vB;
+        // Skip samples outside of the tile. sampleTile() swaps the coordinates.
+        int uB = static_cast<int>(HPixPt.y * (size - 1));
+        int vB = static_cast<int>(HPixPt.x * (size - 1));
 
-        double hP1{};
-        double hP2{};
-        double hPP{};
         if (uB >= size - 1 || uB < 0) {
           continue;
         }
@@ -317,21 +508,7 @@ bool intersectPlanet(
           continue;
         }
 
-        // Access height data
-        const auto* ptr = parent->getTileData().get(TileDataType::eElevation)->getTypedPtr<float>();
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        height = ptr[vB + size * uB];
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        hP1 = ptr[vB + size * (uB + 1)];
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        hP2 = ptr[vB + 1 + size * uB];
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        hPP = ptr[vB + 1 + size * (uB + 1)];
-
-        double interpol1 = (1.0 - uP) * height + uP * hP1;
-        double interpol2 = (1.0 - uP) * hP2 + uP * hPP;
-        height           = (1.0 - vP) * interpol1 + vP * interpol2;
-        height *= planet->getHeightScale();
+        height = sampleTile(parent, HPixPt) * heightScale;
 
         // Detect hit as soon as a sample point below the surface is found
         if (sampleLngLatHeight.z < height) {
@@ -370,7 +547,7 @@ bool intersectPlanet(
         double max_dist{};
         bool intersects = intersectTileBounds(child, planet, origin, direction, min_dist, max_dist);
         if (intersects && max_dist > 0.0) {
-          intersected_tiles.insert(std::pair<double, TileNode*>(min_dist, child));
+          intersected_tiles.emplace(min_dist, child);
         }
       }
     }
@@ -12,6 +12,7 @@
 #include <cmath>          // C++ Math
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <vector>
 
 class VistaTransformNode;
 class VistaOpenGLNode;
@@ -38,6 +39,18 @@ namespace utils {
 double getHeight(
     VistaPlanet const* planet, HeightSamplePrecision precision, glm::dvec2 const& lngLat);
 
+/// Retrieve the Planets Height at many lat / long positions at once. The positions are sorted
+/// along the quadtree so that each tile is visited only once, which is much faster than calling
+/// getHeight() for each position. With HeightSamplePrecision::eFine, getHeight() is called for each
+/// position nevertheless.
+/// @param planet    VistaPlanet to get the Heights from
+/// @param precision Defines the Height Sample Precision
+/// @param lngLats   The positions, see getHeight()
+/// @param heights   Receives one height for each position
+/// @param parallel  If set, large batches are split among several threads
+void getHeights(VistaPlanet const* planet, HeightSamplePrecision precision,
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights, bool parallel = false);
+
 /// Intersects a ray with the height field of a VistaPlanet. The Ray is defined by a position
 /// and orientation.
 /// @param planet VistaPlanet to be intersected
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/HEALPixCache.hpp"
+#include "../../../src/cs-utils/convert.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+
+namespace csp::lodbodies {
+TEST_CASE("csp::lodbodies::HEALPixCache::getPatch") {
+  glm::dvec3 radii(6378137.0, 6378137.0, 6356752.3);
+  auto       cache = HEALPixCache::get(radii);
+
+  // Check a precomputed and a lazily computed patch.
+  for (TileId tileId : {TileId(3, 500), TileId(12, 12345678)}) {
+    auto const& patch   = cache->getPatch(tileId);
+    auto        corners = HEALPix::getCornersLngLat(tileId);
+
+    for (std::size_t i = 0; i < 4; ++i) {
+      auto expected = cs::utils::convert::toCartesian(corners.at(i), radii, 100.0);
+      auto actual   = patch.mCorners.at(i).mPosition + patch.mCorners.at(i).mNormal * 100.0;
+
+      CHECK_EQ(glm::distance(expected, actual), doctest::Approx(0.0).epsilon(1e-6));
+      CHECK_EQ(patch.mNeighbours.at(i), HEALPix::getNeighbourIds(tileId).at(i));
+    }
+
+    auto center = cs::utils::convert::toCartesian(HEALPix::getCenterLngLat(tileId), radii);
+    CHECK_EQ(glm::distance(center, patch.mCenter.mPosition), doctest::Approx(0.0).epsilon(1e-6));
+  }
+}
+
+TEST_CASE("csp::lodbodies::HEALPixCache::get") {
+  auto a = HEALPixCache::get(glm::dvec3(1.0, 2.0, 3.0));
+  auto b = HEALPixCache::get(glm::dvec3(1.0, 2.0, 3.0));
+  auto c = HEALPixCache::get(glm::dvec3(3.0, 2.0, 1.0));
+
+  // Caches are shared by all users with the same radii.
+  CHECK_EQ(a, b);
+  CHECK_NE(a, c);
+  CHECK_EQ(c->getRadii(), glm::dvec3(3.0, 2.0, 1.0));
+}
+
+TEST_CASE("csp::lodbodies::HEALPixCache::computePatch") {
+  glm::dvec3 radii(3396190.0, 3396190.0, 3376200.0);
+  auto       cache = HEALPixCache::get(radii);
+
+  // The uncached computation used by the loader threads yields the same geometry.
+  TileId      tileId(9, 54321);
+  auto        patch  = HEALPixCache::computePatch(tileId, radii);
+  auto const& cached = cache->getPatch(tileId);
+
+  CHECK_EQ(patch.mCenter.mPosition, cached.mCenter.mPosition);
+
+  for (std::size_t i = 0; i < 4; ++i) {
+    CHECK_EQ(patch.mCorners.at(i).mPosition, cached.mCorners.at(i).mPosition);
+    CHECK_EQ(patch.mEdgeCenters.at(i).mNormal, cached.mEdgeCenters.at(i).mNormal);
+  }
+}
+} // namespace csp::lodbodies
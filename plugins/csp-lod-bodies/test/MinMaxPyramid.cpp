@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/MinMaxPyramid.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/TileData.hpp"
+
+#include <algorithm>
+
+namespace csp::lodbodies {
+namespace {
+// Computes the minimum and maximum of the samples covered by the given cell in a scalar fashion.
+// With an odd resolution, the last cell of each level also covers the last row and column.
+void getCellRange(TileData<float> const& tile, uint32_t level, uint32_t x, uint32_t y,
+    uint32_t levelResolution, float& minValue, float& maxValue) {
+  uint32_t resolution = tile.getResolution();
+  uint32_t cellSize   = 2U << level;
+
+  uint32_t x1 = x == levelResolution - 1 ? resolution : (x + 1) * cellSize;
+  uint32_t y1 = y == levelResolution - 1 ? resolution : (y + 1) * cellSize;
+
+  minValue = std::numeric_limits<float>::max();
+  maxValue = std::numeric_limits<float>::lowest();
+
+  for (uint32_t j = y * cellSize; j < y1; ++j) {
+    for (uint32_t i = x * cellSize; i < x1; ++i) {
+      minValue = std::min(minValue, tile.data()[j * resolution + i]);
+      maxValue = std::max(maxValue, tile.data()[j * resolution + i]);
+    }
+  }
+}
+} // namespace
+
+TEST_CASE("csp::lodbodies::MinMaxPyramid") {
+  for (uint32_t resolution : {2U, 9U, 128U, 257U}) {
+    TileData<float> tile(resolution);
+
+    for (uint32_t i = 0; i < resolution * resolution; ++i) {
+      tile.data()[i] = static_cast<float>((i * 7919U) % 1009U) - 500.F;
+    }
+
+    MinMaxPyramid pyramid(&tile);
+
+    CHECK_EQ(pyramid.getMin(), *std::min_element(tile.data().begin(), tile.data().end()));
+    CHECK_EQ(pyramid.getMax(), *std::max_element(tile.data().begin(), tile.data().end()));
+    CHECK_EQ(pyramid.getLevelResolution(pyramid.getLevelCount() - 1), 1);
+
+    for (uint32_t level = 0; level < pyramid.getLevelCount(); ++level) {
+      uint32_t levelResolution = pyramid.getLevelResolution(level);
+
+      for (uint32_t y = 0; y < levelResolution; ++y) {
+        for (uint32_t x = 0; x < levelResolution; ++x) {
+          float minValue{};
+          float maxValue{};
+          getCellRange(tile, level, x, y, levelResolution, minValue, maxValue);
+
+          CHECK_EQ(pyramid.getMinLevel(level)[y * levelResolution + x], minValue);
+          CHECK_EQ(pyramid.getMaxLevel(level)[y * levelResolution + x], maxValue);
+        }
+      }
+    }
+  }
+}
+} // namespace csp::lodbodies
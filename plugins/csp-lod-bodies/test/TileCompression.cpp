@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TileCompression.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace csp::lodbodies {
+TEST_CASE("csp::lodbodies::compression::getBC1Size") {
+  CHECK_EQ(compression::getBC1Size(4), 8);
+  CHECK_EQ(compression::getBC1Size(5), 32);
+  CHECK_EQ(compression::getBC1Size(512), 512 * 512 / 2);
+}
+
+TEST_CASE("csp::lodbodies::compression::encodeBC1(uniform)") {
+  // Uniform colors which can be represented exactly are preserved.
+  for (auto color : {glm::u8vec4(255, 0, 0, 255), glm::u8vec4(0, 255, 0, 0),
+           glm::u8vec4(0, 0, 255, 255), glm::u8vec4(0, 0, 0, 255)}) {
+    std::vector<glm::u8vec4> pixels(16, color);
+    std::vector<glm::u8vec4> decoded(16);
+    std::vector<uint8_t>     blocks(compression::getBC1Size(4));
+
+    compression::encodeBC1(pixels.data(), 4, blocks.data());
+    compression::decodeBC1(blocks.data(), 4, decoded.data());
+
+    for (auto const& pixel : decoded) {
+      CHECK_EQ(pixel.x, color.x);
+      CHECK_EQ(pixel.y, color.y);
+      CHECK_EQ(pixel.z, color.z);
+      CHECK_EQ(pixel.w, 255);
+    }
+  }
+}
+
+TEST_CASE("csp::lodbodies::compression::encodeBC1(gradient)") {
+  // Smooth gradients only have a small error.
+  for (uint32_t resolution : {6U, 64U}) {
+    std::vector<glm::u8vec4> pixels(resolution * resolution);
+    std::vector<glm::u8vec4> decoded(resolution * resolution);
+    std::vector<uint8_t>     blocks(compression::getBC1Size(resolution));
+
+    for (uint32_t y = 0; y < resolution; ++y) {
+      for (uint32_t x = 0; x < resolution; ++x) {
+        auto value                 = static_cast<uint8_t>((x + y) * 2);
+        pixels[y * resolution + x] = glm::u8vec4(value, value, 255 - value, 255);
+      }
+    }
+
+    compression::encodeBC1(pixels.data(), resolution, blocks.data());
+    compression::decodeBC1(blocks.data(), resolution, decoded.data());
+
+    int maxError = 0;
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+      maxError = std::max(maxError, std::abs(pixels[i].x - decoded[i].x));
+      maxError = std::max(maxError, std::abs(pixels[i].y - decoded[i].y));
+      maxError = std::max(maxError, std::abs(pixels[i].z - decoded[i].z));
+    }
+
+    CHECK_LE(maxError, 8);
+  }
+}
+
+TEST_CASE("csp::lodbodies::compression::quantizeHeights") {
+  std::vector<float>    heights{-100.F, 25.F, 100.F, 50.F};
+  std::vector<uint16_t> values(heights.size());
+
+  compression::quantizeHeights(heights.data(), heights.size(), -100.F, 100.F, values.data());
+
+  CHECK_EQ(values[0], 0);
+  CHECK_EQ(values[1], 40959);
+  CHECK_EQ(values[2], 65535);
+  CHECK_EQ(values[3], 49151);
+
+  // An empty range maps everything to zero.
+  compression::quantizeHeights(heights.data(), heights.size(), 10.F, 10.F, values.data());
+
+  for (auto value : values) {
+    CHECK_EQ(value, 0);
+  }
+}
+
+TEST_CASE("csp::lodbodies::compression::encodeHeights") {
+  uint32_t const     resolution = 9;
+  std::vector<float> heights(resolution * resolution);
+
+  for (std::size_t i = 0; i < heights.size(); ++i) {
+    heights[i] = -4000.F + static_cast<float>(i * i) * 1.37F;
+  }
+
+  std::vector<uint8_t> data(compression::getEncodedHeightsSize(resolution));
+  std::vector<float>   decoded(heights.size());
+
+  CHECK_EQ(data.size(), 8 + resolution * resolution * 2);
+
+  compression::encodeHeights(heights.data(), resolution, data.data());
+  compression::decodeHeights(data.data(), resolution, decoded.data());
+
+  // All heights are restored within the quantization error.
+  auto [minHeight, maxHeight] = std::minmax_element(heights.begin(), heights.end());
+  CHECK_EQ(decoded.front(), *minHeight);
+
+  float maxError = (*maxHeight - *minHeight) / 131070.F * 1.01F;
+  for (std::size_t i = 0; i < heights.size(); ++i) {
+    CHECK_LE(std::abs(heights[i] - decoded[i]), maxError);
+  }
+
+  // Quantizing the decoded heights for the GPU yields the same values as quantizing the original.
+  std::vector<uint16_t> original(heights.size());
+  std::vector<uint16_t> requantized(heights.size());
+  compression::quantizeHeights(
+      heights.data(), heights.size(), *minHeight, *maxHeight, original.data());
+  compression::quantizeHeights(
+      decoded.data(), decoded.size(), *minHeight, *maxHeight, requantized.data());
+
+  CHECK(original == requantized);
+}
+} // namespace csp::lodbodies
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TileGrid.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <algorithm>
+#include <array>
+#include <set>
+
+namespace csp::lodbodies {
+
+namespace {
+
+using Vertex   = std::array<uint16_t, 2>;
+using Triangle = std::array<Vertex, 3>;
+
+// Returns all non-degenerate triangles of the given level. If morphed is set, the vertices are
+// moved to their morph targets. The vertices of each triangle are sorted, so that triangles can be
+// compared regardless of their winding.
+std::set<Triangle> getTriangles(TileGrid const& grid, std::size_t levelIdx, bool morphed) {
+  auto const& vertices = grid.getVertices();
+  auto const& indices  = grid.getIndices();
+  auto const& level    = grid.getLevels()[levelIdx];
+
+  std::set<Triangle> triangles;
+
+  for (uint32_t i = level.mFirstIndex + 2; i < level.mFirstIndex + level.mIndexCount; ++i) {
+    Triangle triangle{};
+
+    for (uint32_t j = 0; j < 3; ++j) {
+      uint32_t offset = indices[i - 2 + j] * 4 + (morphed ? 2 : 0);
+      triangle.at(j)  = {vertices[offset], vertices[offset + 1]};
+    }
+
+    std::sort(triangle.begin(), triangle.end());
+
+    if (triangle[0] != triangle[1] && triangle[1] != triangle[2]) {
+      triangles.insert(triangle);
+    }
+  }
+
+  return triangles;
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::TileGrid::getLevels") {
+  TileGrid grid(128);
+
+  auto const& levels = grid.getLevels();
+  REQUIRE_EQ(levels.size(), 6);
+
+  CHECK_EQ(levels[0].mSegments, 127);
+  CHECK_EQ(levels[1].mSegments, 64);
+  CHECK_EQ(levels[5].mSegments, 4);
+
+  // The levels are stored one after another.
+  CHECK_EQ(levels[0].mFirstIndex, 0);
+  CHECK_EQ(levels[0].mIndexCount, 129 * (2 + 2 * 130));
+  CHECK_EQ(levels[1].mFirstIndex, levels[0].mIndexCount);
+  CHECK_EQ(levels[5].mFirstIndex + levels[5].mIndexCount, grid.getIndices().size());
+
+  // Small tiles only have one level.
+  CHECK_EQ(TileGrid(4).getLevels().size(), 1);
+}
+
+TEST_CASE("csp::lodbodies::TileGrid::getVertices") {
+  for (uint32_t resolution : {65U, 128U}) {
+    TileGrid grid(resolution);
+
+    // A fully morphed grid has the same shape as the next coarser level.
+    for (std::size_t i = 0; i + 1 < grid.getLevels().size(); ++i) {
+      CHECK(getTriangles(grid, i, true) == getTriangles(grid, i + 1, false));
+    }
+
+    // The coarsest level does not change when morphed.
+    std::size_t last = grid.getLevels().size() - 1;
+    CHECK(getTriangles(grid, last, true) == getTriangles(grid, last, false));
+  }
+}
+
+TEST_CASE("csp::lodbodies::TileGrid::getLevel") {
+  TileGrid grid(128);
+
+  uint32_t level{};
+  float    morphFactor{};
+
+  grid.getLevel(2.F, level, morphFactor);
+  CHECK_EQ(level, 0);
+  CHECK_EQ(morphFactor, 0.F);
+
+  // Unknown sizes use the full resolution.
+  grid.getLevel(0.F, level, morphFactor);
+  CHECK_EQ(level, 0);
+  CHECK_EQ(morphFactor, 0.F);
+
+  grid.getLevel(0.25F, level, morphFactor);
+  CHECK_EQ(level, 2);
+  CHECK_EQ(morphFactor, 0.F);
+
+  // Morphing starts halfway to the next level.
+  grid.getLevel(std::pow(2.F, -2.75F), level, morphFactor);
+  CHECK_EQ(level, 2);
+  CHECK_EQ(morphFactor, doctest::Approx(0.5F));
+
+  // The coarsest level is never morphed.
+  grid.getLevel(0.001F, level, morphFactor);
+  CHECK_EQ(level, 5);
+  CHECK_EQ(morphFactor, 0.F);
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TilePool.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+namespace csp::lodbodies {
+TEST_CASE("csp::lodbodies::TilePool::create") {
+  auto pool = std::make_shared<TilePool>(0);
+
+  auto tile = pool->create<float>(16);
+  REQUIRE(tile);
+  tile->data()[0] = 42.F;
+  tile->setTexLayer(3);
+
+  float* data = tile->data().data();
+  tile.reset();
+
+  // Released tiles are recycled and reset.
+  tile = pool->create<float>(16);
+  REQUIRE(tile);
+  CHECK_EQ(tile->data().data(), data);
+  CHECK_EQ(tile->data()[0], 0.F);
+  CHECK_EQ(tile->getTexLayer(), -1);
+
+  // Tiles of other kinds are not.
+  auto other = pool->create<glm::u8vec4>(16);
+  REQUIRE(other);
+  CHECK_EQ(other->getDataType(), TileDataType::eColor);
+
+  auto statistics = pool->getStatistics();
+  CHECK_EQ(statistics.mAllocatedTiles, 2);
+  CHECK_EQ(statistics.mRecycledTiles, 1);
+  CHECK_EQ(statistics.mUsedBytes, 2 * 16 * 16 * 4);
+  CHECK_EQ(statistics.mCachedBytes, 0);
+}
+
+TEST_CASE("csp::lodbodies::TilePool::setBudget") {
+  std::size_t tileSize = 16 * 16 * sizeof(float);
+  auto        pool     = std::make_shared<TilePool>(2 * tileSize);
+
+  auto a = pool->create<float>(16);
+  auto b = pool->create<float>(16);
+  CHECK(a);
+  CHECK(b);
+
+  // The budget is exhausted.
+  CHECK_FALSE(pool->create<float>(16));
+  CHECK_EQ(pool->getStatistics().mRejectedTiles, 1);
+
+  // Recycled tiles of another kind are freed to make room.
+  a.reset();
+  CHECK_EQ(pool->getStatistics().mCachedBytes, tileSize);
+  auto c = pool->create<float>(8);
+  CHECK(c);
+  CHECK_EQ(pool->getStatistics().mCachedBytes, 0);
+
+  // Shrinking the budget frees recycled tiles.
+  b.reset();
+  pool->setBudget(tileSize / 2);
+  CHECK_EQ(pool->getStatistics().mCachedBytes, 0);
+
+  // Tiles may outlive their pool.
+  auto tile = pool->create<float>(4);
+  pool.reset();
+  tile.reset();
+}
+} // namespace csp::lodbodies
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TileSourceGeoTiff.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <tiffio.h>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// Writes a global, striped float raster whose values increase from west to east.
+std::string writeGradient(uint32_t width, uint32_t height) {
+  auto file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+                  .string() +
+              ".tif";
+
+  TIFF* tif = TIFFOpen(file.c_str(), "w");
+  TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
+  TIFFSetField(tif, TIFFTAG_IMAGELENGTH, height);
+  TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+  TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 32);
+  TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+  TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+  TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, 4);
+
+  std::vector<float> row(width);
+  for (uint32_t x = 0; x < width; ++x) {
+    row[x] = static_cast<float>(x);
+  }
+
+  for (uint32_t y = 0; y < height; ++y) {
+    TIFFWriteScanline(tif, row.data(), y, 0);
+  }
+
+  TIFFClose(tif);
+
+  return file;
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::TileSourceGeoTiff::loadTile") {
+  auto file = writeGradient(360, 180);
+
+  TileSourceGeoTiff source(9);
+  source.setFile(file);
+  source.setDataType(TileDataType::eElevation);
+  source.init();
+
+  auto tile = source.loadTile(TileId(0, 4));
+  REQUIRE(tile);
+
+  // All values lie within the range of the raster and are not all the same.
+  float const* data = tile->getTypedPtr<float>();
+  float        min  = data[0];
+  float        max  = data[0];
+  for (uint32_t i = 0; i < 9 * 9; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    min = std::min(min, data[i]);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    max = std::max(max, data[i]);
+  }
+
+  CHECK_GE(min, 0.F);
+  CHECK_LE(max, 359.F);
+  CHECK_LT(min, max);
+
+  source.fini();
+  boost::filesystem::remove(file);
+}
+
+TEST_CASE("csp::lodbodies::TileSourceGeoTiff::init with a missing file") {
+  TileSourceGeoTiff source(9);
+  source.setFile("this-file-does-not-exist.tif");
+  source.setDataType(TileDataType::eElevation);
+  source.init();
+
+  CHECK_FALSE(source.loadTile(TileId(0, 0)));
+}
+
+} // namespace csp::lodbodies
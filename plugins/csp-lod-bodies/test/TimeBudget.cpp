@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TimeBudget.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <thread>
+
+namespace csp::lodbodies {
+TEST_CASE("csp::lodbodies::TimeBudget::startFrame") {
+  TimeBudget budget;
+
+  // The budget starts at the minimum.
+  budget.startFrame(16.0, 16.0, 1.0, 4.0);
+  CHECK_EQ(budget.getBudget(), 1.0);
+  CHECK_EQ(budget.getRemaining(), 1.0);
+
+  // Spare frame time increases the budget gradually up to the maximum.
+  budget.startFrame(16.0, 12.0, 1.0, 4.0);
+  CHECK_EQ(budget.getBudget(), 2.0);
+
+  for (int i = 0; i < 10; ++i) {
+    budget.startFrame(16.0, 12.0, 1.0, 4.0);
+  }
+
+  CHECK_EQ(budget.getBudget(), 4.0);
+
+  // Frames which take too long decrease it again.
+  budget.startFrame(16.0, 20.0, 1.0, 4.0);
+  CHECK_EQ(budget.getBudget(), 3.0);
+
+  budget.startFrame(16.0, 40.0, 1.0, 4.0);
+  CHECK_EQ(budget.getBudget(), 1.0);
+}
+
+TEST_CASE("csp::lodbodies::TimeBudget::consume") {
+  TimeBudget budget;
+  budget.startFrame(16.0, 16.0, 5.0, 5.0);
+
+  auto start    = TimeBudget::Clock::now();
+  auto deadline = budget.getDeadline();
+
+  CHECK_FALSE(budget.isExhausted());
+  CHECK_GE(deadline, start + std::chrono::milliseconds(5));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(6));
+  budget.consume(start);
+
+  // Once the budget is exhausted, the deadline is the current time.
+  CHECK(budget.isExhausted());
+  CHECK_LT(budget.getRemaining(), 0.0);
+
+  auto now = TimeBudget::Clock::now();
+  CHECK_LE(budget.getDeadline(), now + std::chrono::milliseconds(1));
+
+  // A new frame resets the remaining time.
+  budget.startFrame(16.0, 16.0, 5.0, 5.0);
+  CHECK_EQ(budget.getRemaining(), 5.0);
+}
+} // namespace csp::lodbodies
@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/voronoi/VoronoiGenerator.hpp"
+#include "../../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <cmath>
+
+namespace csp::measurementtools {
+TEST_CASE("csp::measurementtools::VoronoiGenerator [benchmark]" * doctest::skip()) {
+
+  // The PolygonTool triangulates the corners of the polygon and a grid of points inside of it.
+  // The sites are placed on a jittered grid, so that no two sites share a coordinate.
+  for (int count : {100, 1000}) {
+    std::vector<Site> sites;
+    sites.reserve(count);
+
+    auto columns = static_cast<int>(std::sqrt(count));
+    for (int i = 0; i < count; ++i) {
+      double jitterX = std::fmod(i * 0.618034, 1.0) * 0.5;
+      double jitterY = std::fmod(i * 0.414214, 1.0) * 0.5;
+      sites.emplace_back(
+          (i % columns) + jitterX, (i / columns) + jitterY, static_cast<uint16_t>(i));
+    }
+
+    cs::utils::MicroBenchmark::run(
+        "VoronoiGenerator::parse (" + std::to_string(count) + " sites)", [&]() {
+          VoronoiGenerator voronoi;
+          voronoi.parse(sites);
+          cs::utils::doNotOptimize(voronoi.getTriangles());
+        });
+  }
+}
+} // namespace csp::measurementtools
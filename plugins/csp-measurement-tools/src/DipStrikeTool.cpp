@@ -244,18 +244,35 @@ void DipStrikeTool::calculateDipAndStrike() {
     mPosition += mark->getPosition() / static_cast<double>(mPoints.size());
   }
 
+  // The heights of the marks are only queried again if one of them has been moved. All heights are
+  // queried at once, this is much faster than individual queries.
+  std::vector<glm::dvec2> lngLats;
+  lngLats.reserve(mPoints.size());
+  for (auto const& mark : mPoints) {
+    lngLats.push_back(mark->pLngLat.get());
+  }
+
+  if (lngLats != mSampledLngLats) {
+    mSampledLngLats = std::move(lngLats);
+    mSampledHeights.assign(mSampledLngLats.size(), 0.0);
+    if (object->getSurface()) {
+      object->getSurface()->getHeights(mSampledLngLats, mSampledHeights);
+    }
+  }
+
+  // Cartesian coordinates of the marks without height exaggeration
+  std::vector<glm::dvec3> positionsNorm;
+  positionsNorm.reserve(mSampledLngLats.size());
+  for (size_t i = 0; i < mSampledLngLats.size(); ++i) {
+    positionsNorm.push_back(
+        cs::utils::convert::toCartesian(mSampledLngLats[i], radii, mSampledHeights[i]));
+  }
+
   // corrected average position (works for every height scale)
   // average position of the coordinates without height exaggeration
   glm::dvec3 averagePositionNorm(0.0);
-  for (auto const& mark : mPoints) {
-    // LongLat coordinate
-    glm::dvec2 l = cs::utils::convert::cartesianToLngLat(mark->getPosition(), radii);
-    // Height of the point
-    double h = object->getSurface() ? object->getSurface()->getHeight(l) : 0.0;
-    // Cartesian coordinate with height
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
-
-    averagePositionNorm += posNorm / static_cast<double>(mPoints.size());
+  for (auto const& posNorm : positionsNorm) {
+    averagePositionNorm += posNorm / static_cast<double>(positionsNorm.size());
   }
 
   // calculate center of plane and normal
@@ -268,11 +285,7 @@ void DipStrikeTool::calculateDipAndStrike() {
   mSize                 = 0;
   mOffset               = 0.F;
 
-  for (auto const& p : mPoints) {
-    glm::dvec2 l       = cs::utils::convert::cartesianToLngLat(p->getPosition(), radii);
-    double     h       = object->getSurface() ? object->getSurface()->getHeight(l) : 0.0;
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
-
+  for (auto const& posNorm : positionsNorm) {
     glm::dvec3 relativePosition = posNorm - averagePositionNorm;
 
     mSize = std::max(mSize, glm::length(relativePosition));
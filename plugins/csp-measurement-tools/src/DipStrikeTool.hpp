@@ -96,6 +96,10 @@ class DipStrikeTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool
   glm::vec3  mNormal = glm::vec3(0.0), mMip = glm::vec3(0.0);
   float      mOffset{};
 
+  // The coordinates and heights of the marks when they have been sampled last.
+  std::vector<glm::dvec2> mSampledLngLats;
+  std::vector<double>     mSampledHeights;
+
   int mTextConnection  = -1;
   int mScaleConnection = -1;
 
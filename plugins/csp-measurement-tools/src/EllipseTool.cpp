@@ -112,6 +112,7 @@ EllipseTool::EllipseTool(std::shared_ptr<cs::core::InputManager> pInputManager,
     mAxes.at(1) = mHandles.at(1)->getPosition() - center;
 
     mVerticesDirty = true;
+    mSamplesDirty  = true;
   });
 
   for (int i(0); i < 2; ++i) {
@@ -119,6 +120,7 @@ EllipseTool::EllipseTool(std::shared_ptr<cs::core::InputManager> pInputManager,
       auto center    = mCenterHandle.getPosition();
       mAxes.at(i)    = mHandles.at(i)->getPosition() - center;
       mVerticesDirty = true;
+      mSamplesDirty  = true;
     });
   }
 
@@ -159,6 +161,7 @@ void EllipseTool::setObjectName(std::string name) {
   mCenterHandle.setObjectName(getObjectName());
   mHandles.at(0)->setObjectName(getObjectName());
   mHandles.at(1)->setObjectName(getObjectName());
+  mSamplesDirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -202,6 +205,7 @@ csl::tools::Mark& EllipseTool::getSecondHandle() {
 void EllipseTool::setNumSamples(int const& numSamples) {
   mNumSamples    = numSamples;
   mVerticesDirty = true;
+  mSamplesDirty  = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -211,24 +215,55 @@ void EllipseTool::calculateVertices() {
   auto radii  = object->getRadii();
   auto center = mCenterHandle.getPosition();
 
-  std::vector<glm::vec3> vRelativePositions(mNumSamples);
-  for (int i = 0; i < mNumSamples; ++i) {
-    double phi = glm::mix(0.0, 2.0 * glm::pi<double>(), 1.0 * i / (mNumSamples - 1));
-    double x   = std::sin(phi);
-    double y   = std::cos(phi);
+  if (mSamplesDirty) {
+    std::vector<glm::dvec3> absPositions(mNumSamples);
+    for (int i = 0; i < mNumSamples; ++i) {
+      double phi = glm::mix(0.0, 2.0 * glm::pi<double>(), 1.0 * i / (mNumSamples - 1));
+      double x   = std::sin(phi);
+      double y   = std::cos(phi);
 
-    glm::dvec3 absPosition = center + x * mAxes[0] + y * mAxes[1];
-    glm::dvec2 lngLat      = cs::utils::convert::cartesianToLngLat(absPosition, radii);
+      absPositions[i] = center + x * mAxes[0] + y * mAxes[1];
+    }
+
+    // Convert all samples at once, this is faster than individual conversions.
+    mSampledLngLats.resize(mNumSamples);
+    cs::utils::convert::cartesianToLngLat(
+        absPositions.data(), mSampledLngLats.data(), absPositions.size(), radii);
+
+    // Query the heights of all samples at once, this is much faster than individual queries. The
+    // surface may answer the query in the next frame together with the queries of other tools, the
+    // vertices are updated once the heights are available.
+    mSampledHeights.resize(mSampledLngLats.size(), 0.0);
+    if (object->getSurface()) {
+      mHeightQuery = object->getSurface()->requestHeights(mSampledLngLats);
+
+      // Some surfaces answer right away.
+      if (mHeightQuery->mReady) {
+        mSampledHeights = mHeightQuery->mHeights;
+        mHeightQuery.reset();
+      }
+    } else {
+      mSampledHeights.assign(mSampledLngLats.size(), 0.0);
+      mHeightQuery.reset();
+    }
+
+    mSamplesDirty = false;
+  }
+
+  double heightScale = mSettings->mGraphics.pHeightScale.get();
 
-    double height = object->getSurface() ? object->getSurface()->getHeight(lngLat) : 0.0;
-    height *= mSettings->mGraphics.pHeightScale.get();
-    absPosition = cs::utils::convert::toCartesian(lngLat, radii, height);
+  std::vector<glm::vec3> vRelativePositions(mSampledLngLats.size());
+  for (size_t i = 0; i < mSampledLngLats.size(); ++i) {
+    double     height      = mSampledHeights[i] * heightScale;
+    glm::dvec3 absPosition = cs::utils::convert::toCartesian(mSampledLngLats[i], radii, height);
 
     vRelativePositions[i] = absPosition - center;
   }
 
+  // The buffer has to grow if the number of samples has been increased.
   mVBO.Bind(GL_ARRAY_BUFFER);
-  mVBO.BufferSubData(0, vRelativePositions.size() * sizeof(glm::vec3), vRelativePositions.data());
+  mVBO.BufferData(
+      vRelativePositions.size() * sizeof(glm::vec3), vRelativePositions.data(), GL_DYNAMIC_DRAW);
   mVBO.Release();
 }
 
@@ -239,6 +274,12 @@ void EllipseTool::update() {
   mHandles.at(0)->update();
   mHandles.at(1)->update();
 
+  if (mHeightQuery && mHeightQuery->mReady) {
+    mSampledHeights = mHeightQuery->mHeights;
+    mHeightQuery.reset();
+    mVerticesDirty = true;
+  }
+
   if (mVerticesDirty) {
     calculateVertices();
     mVerticesDirty = false;
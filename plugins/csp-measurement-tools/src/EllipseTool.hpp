@@ -8,9 +8,11 @@
 #ifndef CSP_MEASUREMENT_TOOLS_ELLIPSE_HPP
 #define CSP_MEASUREMENT_TOOLS_ELLIPSE_HPP
 
+#include "../../../src/cs-scene/CelestialSurface.hpp"
 #include "FlagTool.hpp"
 
 #include <array>
+#include <vector>
 
 namespace csp::measurementtools {
 
@@ -62,8 +64,17 @@ class EllipseTool : public IVistaOpenGLDraw, public csl::tools::Tool {
   std::unique_ptr<VistaTransformNode> mAnchor;
 
   bool mVerticesDirty = false;
+  bool mSamplesDirty  = true;
   bool mFirstUpdate   = true;
 
+  // The surface coordinates and heights of the samples along the ellipse. They are only taken
+  // again if the ellipse changes, a changed height scale only requires new vertex positions.
+  std::vector<glm::dvec2> mSampledLngLats;
+  std::vector<double>     mSampledHeights;
+
+  // The heights are requested asynchronously. Until they are ready, the previous heights are used.
+  std::shared_ptr<cs::scene::CelestialSurface::HeightQuery const> mHeightQuery;
+
   FlagTool                                         mCenterHandle;
   std::array<glm::dvec3, 2>                        mAxes;
   std::array<std::unique_ptr<csl::tools::Mark>, 2> mHandles;
@@ -28,21 +28,27 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+
 namespace csp::measurementtools {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 const char* PathTool::SHADER_VERT = R"(
-#version 330
+#version 430
 
-layout(location=0) in vec3 iPosition;
+layout(location=0) in vec3 iPositionHigh;
+layout(location=1) in vec3 iPositionLow;
 
 uniform mat4 uMatModelView;
 uniform mat4 uMatProjection;
 
+RELATIVE_TO_EYE_SNIPPET
+
 void main()
 {
-    vec4 pos    = uMatModelView * vec4(iPosition, 1.0);
+    vec3 position = relativeToEye(iPositionHigh, iPositionLow);
+    vec4 pos      = uMatModelView * vec4(position, 1.0);
     gl_Position = uMatProjection * pos;
 }
 )";
@@ -74,10 +80,16 @@ PathTool::PathTool(std::shared_ptr<cs::core::InputManager> pInputManager,
           std::make_unique<cs::gui::GuiItem>("file://{toolZoom}../share/resources/gui/path.html")) {
 
   // create the shader
-  mShader.InitVertexShaderFromString(SHADER_VERT);
+  std::string sVert(SHADER_VERT);
+  cs::utils::replaceString(
+      sVert, "RELATIVE_TO_EYE_SNIPPET", cs::scene::RelativeToEye::getShaderSnippet());
+
+  mShader.InitVertexShaderFromString(sVert);
   mShader.InitFragmentShaderFromString(SHADER_FRAG);
   mShader.Link();
 
+  mRelativeToEye.init(&mShader);
+
   mUniforms.modelViewMatrix  = mShader.GetUniformLocation("uMatModelView");
   mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
   mUniforms.color            = mShader.GetUniformLocation("uColor");
@@ -156,34 +168,14 @@ PathTool::~PathTool() {
 
 void PathTool::setNumSamples(int const& numSamples) {
   if (mNumSamples != numSamples) {
-    mNumSamples    = numSamples;
+    mNumSamples = numSamples;
+    mSegments.clear();
     mVerticesDirty = true;
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-glm::dvec4 PathTool::getInterpolatedPosBetweenTwoMarks(csl::tools::DeletableMark const& l0,
-    csl::tools::DeletableMark const& l1, double value, double const& scale) {
-
-  auto       object = mSolarSystem->getObject(getObjectName());
-  glm::dvec3 radii  = object->getRadii();
-
-  // Get cartesian coordinates for interpolation
-  glm::dvec3 p0              = cs::utils::convert::toCartesian(l0.pLngLat.get(), radii, 0.0);
-  glm::dvec3 p1              = cs::utils::convert::toCartesian(l1.pLngLat.get(), radii, 0.0);
-  glm::dvec3 interpolatedPos = p0 + (value * (p1 - p0));
-
-  // Calc final position
-  glm::dvec2 ll     = cs::utils::convert::cartesianToLngLat(interpolatedPos, radii);
-  double     height = (object->getSurface() ? object->getSurface()->getHeight(ll) : 0.0) * scale;
-  glm::dvec3 pos    = cs::utils::convert::toCartesian(ll, radii, height);
-
-  return glm::dvec4(pos, height);
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 void PathTool::onPointMoved() {
   mVerticesDirty = true;
 }
@@ -217,56 +209,117 @@ void PathTool::updateLineVertices() {
     mPosition += mark->getPosition() / static_cast<double>(mPoints.size());
   }
 
-  double heightScale = mSettings->mGraphics.pHeightScale.get();
-  auto   lastMark    = mPoints.begin();
-  auto   currMark    = ++mPoints.begin();
+  double     heightScale = mSettings->mGraphics.pHeightScale.get();
+  glm::dvec3 radii       = object->getRadii();
+  auto       lastMark    = mPoints.begin();
+  auto       currMark    = ++mPoints.begin();
 
-  std::stringstream json;
-  std::string       jsonSeperator;
-  double            distance = -1;
-  glm::dvec3        lastPos(0.0);
+  // Reuse the samples of all segments whose marks have not been moved. Only the other segments are
+  // sampled again. Segments are identified by the coordinates of their marks, so that adding or
+  // removing a mark only affects its adjacent segments.
+  std::vector<Segment>    segments;
+  std::vector<size_t>     newSegments;
+  std::vector<glm::dvec2> newLngLats;
 
   while (currMark != mPoints.end()) {
-    // generate X points for each line segment
-    for (int vertex_id = 0; vertex_id < mNumSamples; vertex_id++) {
-      glm::dvec4 pos = getInterpolatedPosBetweenTwoMarks(
-          **lastMark, **currMark, (vertex_id / static_cast<double>(mNumSamples)), heightScale);
-      mSampledPositions.push_back(pos.xyz());
-
-      // coordinate normalized by height scale; to count distance correctly
-      glm::dvec4 posNorm = pos;
-      if (heightScale != 1) {
-        posNorm = getInterpolatedPosBetweenTwoMarks(
-            **lastMark, **currMark, (vertex_id / static_cast<double>(mNumSamples)), 1);
-      }
-
-      if (distance < 0) {
-        distance = 0;
-      } else {
-        distance += glm::length(posNorm.xyz() - lastPos);
+    glm::dvec2 start = (*lastMark)->pLngLat.get();
+    glm::dvec2 end   = (*currMark)->pLngLat.get();
+
+    auto cached = std::find_if(mSegments.begin(), mSegments.end(),
+        [&](Segment const& s) { return s.mStart == start && s.mEnd == end; });
+
+    if (cached != mSegments.end()) {
+      segments.push_back(std::move(*cached));
+      mSegments.erase(cached);
+    } else {
+      Segment segment;
+      segment.mStart = start;
+      segment.mEnd   = end;
+
+      // generate X points for the line segment
+      glm::dvec3 p0 = cs::utils::convert::toCartesian(start, radii, 0.0);
+      glm::dvec3 p1 = cs::utils::convert::toCartesian(end, radii, 0.0);
+
+      for (int vertex_id = 0; vertex_id < mNumSamples; vertex_id++) {
+        double value = vertex_id / static_cast<double>(mNumSamples);
+        segment.mLngLats.push_back(
+            cs::utils::convert::cartesianToLngLat(p0 + value * (p1 - p0), radii));
       }
 
-      json << jsonSeperator << "[" << distance << "," << pos.w / heightScale << "]";
-      jsonSeperator = ",";
-
-      lastPos = posNorm.xyz();
+      newLngLats.insert(newLngLats.end(), segment.mLngLats.begin(), segment.mLngLats.end());
+      newSegments.push_back(segments.size());
+      segments.push_back(std::move(segment));
     }
 
     lastMark = currMark;
     ++currMark;
   }
 
-  mGuiItem->callJavascript("setData", "[" + json.str() + "]");
+  // Query the heights of all new samples at once, this is much faster than individual queries.
+  std::vector<double> newHeights(newLngLats.size(), 0.0);
+  if (object->getSurface() && !newLngLats.empty()) {
+    object->getSurface()->getHeights(newLngLats, newHeights);
+  }
+
+  auto nextHeight = newHeights.begin();
+  for (size_t i : newSegments) {
+    auto count = static_cast<std::ptrdiff_t>(segments[i].mLngLats.size());
+    segments[i].mHeights.assign(nextHeight, nextHeight + count);
+    nextHeight += count;
+  }
+
+  mSegments = std::move(segments);
+
+  std::vector<glm::dvec2> lngLats;
+  std::vector<double>     heights;
+  for (auto const& segment : mSegments) {
+    lngLats.insert(lngLats.end(), segment.mLngLats.begin(), segment.mLngLats.end());
+    heights.insert(heights.end(), segment.mHeights.begin(), segment.mHeights.end());
+  }
+
+  std::vector<float> profile;
+  double             distance = -1;
+  glm::dvec3         lastPos(0.0);
+
+  profile.reserve(lngLats.size() * 2);
+
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    mSampledPositions.push_back(
+        cs::utils::convert::toCartesian(lngLats[i], radii, heights[i] * heightScale));
+
+    // coordinate normalized by height scale; to count distance correctly
+    glm::dvec3 posNorm = cs::utils::convert::toCartesian(lngLats[i], radii, heights[i]);
+
+    if (distance < 0) {
+      distance = 0;
+    } else {
+      distance += glm::length(posNorm - lastPos);
+    }
+
+    profile.push_back(static_cast<float>(distance));
+    profile.push_back(static_cast<float>(heights[i]));
+
+    lastPos = posNorm;
+  }
+
+  // The elevation profile is sent as interleaved distances and heights.
+  mGuiItem->callJavascriptWithArray("setData", profile);
 
   mIndexCount = mSampledPositions.size();
 
-  // Upload new data
+  // Upload the new data. Each vertex consists of the high and the low part of its position, the
+  // buffer is only written again if the path changes.
+  auto vertices = cs::scene::RelativeToEye::splitInterleaved(mSampledPositions);
+
   mVBO.Bind(GL_ARRAY_BUFFER);
-  mVBO.BufferData(mSampledPositions.size() * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+  mVBO.BufferData(vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
   mVBO.Release();
 
   mVAO.EnableAttributeArray(0);
-  mVAO.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, &mVBO);
+  mVAO.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), 0, &mVBO);
+  mVAO.EnableAttributeArray(1);
+  mVAO.SpecifyAttributeArrayFloat(
+      1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), sizeof(glm::vec3), &mVBO);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -293,21 +346,9 @@ void PathTool::update() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool PathTool::Do() {
-  // transform all high precision sample points to observer centric
-  // low precision coordinates
-  std::vector<glm::vec3> vRelativePositions(mIndexCount);
-
-  auto object    = mSolarSystem->getObject(getObjectName());
-  auto transform = object->getObserverRelativeTransform(mPosition);
-
-  for (size_t i(0); i < mIndexCount; ++i) {
-    vRelativePositions[i] = (transform * glm::dvec4(mSampledPositions[i] - mPosition, 1.0)).xyz();
-  }
-
-  // upload the new points to the GPU
-  mVBO.Bind(GL_ARRAY_BUFFER);
-  mVBO.BufferSubData(0, vRelativePositions.size() * sizeof(glm::vec3), vRelativePositions.data());
-  mVBO.Release();
+  // Only the position of the observer relative to the body changes, the vertices stay the same.
+  auto object = mSolarSystem->getObject(getObjectName());
+  mRelativeToEye.update(object->getObserverRelativeTransform());
 
   glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_LINE_BIT);
 
@@ -329,6 +370,7 @@ bool PathTool::Do() {
   mVAO.Bind();
   glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
   glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+  mRelativeToEye.bind();
 
   mShader.SetUniform(mUniforms.color, pColor.get().r, pColor.get().g, pColor.get().b);
 
@@ -8,6 +8,7 @@
 #ifndef CSP_MEASUREMENT_TOOLS_PATH_HPP
 #define CSP_MEASUREMENT_TOOLS_PATH_HPP
 
+#include "../../../src/cs-scene/RelativeToEye.hpp"
 #include "../../csl-tools/src/MultiPointTool.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
@@ -58,11 +59,6 @@ class PathTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
  private:
   void updateLineVertices();
 
-  /// Returns the interpolated position in cartesian coordinates. The fourth component is height
-  /// above the surface.
-  glm::dvec4 getInterpolatedPosBetweenTwoMarks(csl::tools::DeletableMark const& l0,
-      csl::tools::DeletableMark const& l1, double value, double const& scale);
-
   /// These are called by the base class MultiPointTool.
   void onPointMoved() override;
   void onPointAdded() override;
@@ -79,12 +75,26 @@ class PathTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   VistaBufferObject      mVBO;
   VistaGLSLShader        mShader;
 
+  // The vertices are uploaded once in body-fixed coordinates, the observer-relative positions are
+  // computed in the vertex shader.
+  cs::scene::RelativeToEye mRelativeToEye;
+
   struct {
     uint32_t modelViewMatrix  = 0;
     uint32_t projectionMatrix = 0;
     uint32_t color            = 0;
   } mUniforms;
 
+  /// The samples of the line segment between two marks. The samples of a segment are only taken
+  /// again if one of its marks is moved or if the number of samples changes.
+  struct Segment {
+    glm::dvec2              mStart{};
+    glm::dvec2              mEnd{};
+    std::vector<glm::dvec2> mLngLats;
+    std::vector<double>     mHeights;
+  };
+
+  std::vector<Segment>    mSegments;
   std::vector<glm::dvec3> mSampledPositions;
   glm::dvec3              mPosition{};
   size_t                  mIndexCount    = 0;
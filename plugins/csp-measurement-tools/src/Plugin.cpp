@@ -37,6 +37,16 @@ EXPORT_FN void destroy(cs::core::PluginBase* pluginBase) {
 
 namespace csp::measurementtools {
 
+// clang-format off
+
+// NOLINTNEXTLINE
+NLOHMANN_JSON_SERIALIZE_ENUM(Triangulator::Type, {
+    {Triangulator::Type::eVoronoi, "voronoi"},
+    {Triangulator::Type::eDelaunay, "delaunay"},
+});
+
+// clang-format on
+
 namespace {
 // These are only used during settings loading, as they are required in the free from_json methods.
 // Loading never happens on multiple threads, so this is a save thing to do.
@@ -239,6 +249,7 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "polygonMaxAttempt", o.mPolygonMaxAttempt);
   cs::core::Settings::deserialize(j, "polygonMaxPoints", o.mPolygonMaxPoints);
   cs::core::Settings::deserialize(j, "polygonSleekness", o.mPolygonSleekness);
+  cs::core::Settings::deserialize(j, "polygonTriangulator", o.mPolygonTriangulator);
   cs::core::Settings::deserialize(j, "ellipseSamples", o.mEllipseSamples);
   cs::core::Settings::deserialize(j, "pathSamples", o.mPathSamples);
 }
@@ -253,6 +264,7 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "polygonMaxAttempt", o.mPolygonMaxAttempt);
   cs::core::Settings::serialize(j, "polygonMaxPoints", o.mPolygonMaxPoints);
   cs::core::Settings::serialize(j, "polygonSleekness", o.mPolygonSleekness);
+  cs::core::Settings::serialize(j, "polygonTriangulator", o.mPolygonTriangulator);
   cs::core::Settings::serialize(j, "ellipseSamples", o.mEllipseSamples);
   cs::core::Settings::serialize(j, "pathSamples", o.mPathSamples);
 }
@@ -263,7 +275,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-measurement-tools")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   mGuiManager->addPluginTabToSideBarFromHTML(
@@ -334,6 +350,7 @@ void Plugin::init() {
         tool->setMaxAttempt(mPluginSettings.mPolygonMaxAttempt.get());
         tool->setMaxPoints(mPluginSettings.mPolygonMaxPoints.get());
         tool->setSleekness(mPluginSettings.mPolygonSleekness.get());
+        tool->setTriangulator(mPluginSettings.mPolygonTriangulator.get());
         tool->pAddPointMode = true;
         tool->addPoint();
         mPluginSettings.mPolygons.push_back(tool);
@@ -376,6 +393,12 @@ void Plugin::init() {
     }
   });
 
+  mPluginSettings.mPolygonTriangulator.connect([this](Triangulator::Type val) {
+    for (auto& p : mPluginSettings.mPolygons) {
+      p->setTriangulator(val);
+    }
+  });
+
   mPluginSettings.mEllipseSamples.connect([this](int32_t val) {
     for (auto& p : mPluginSettings.mEllipses) {
       p->setNumSamples(val);
@@ -10,6 +10,7 @@
 
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-utils/DefaultProperty.hpp"
+#include "voronoi/Triangulator.hpp"
 
 #include <list>
 #include <string>
@@ -44,6 +45,9 @@ class Plugin : public cs::core::PluginBase {
     cs::utils::DefaultProperty<int32_t> mPolygonSleekness{15};
     cs::utils::DefaultProperty<int32_t> mEllipseSamples{100};
     cs::utils::DefaultProperty<int32_t> mPathSamples{256};
+
+    cs::utils::DefaultProperty<Triangulator::Type> mPolygonTriangulator{
+        Triangulator::Type::eVoronoi};
   };
 
   void init() override;
@@ -0,0 +1,1091 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "PolygonMesh.hpp"
+
+#include "../../../src/cs-utils/convert.hpp"
+
+#include "logger.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <tuple>
+
+namespace csp::measurementtools {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The number of points refineMesh() checks on each edge: the middle point, the trisecting points
+// and so on up to j = 5.
+constexpr size_t REFINEMENT_POINTS = 1 + 2 + 3 + 4;
+
+// Resolution of edge sampling when searching intersections with the least squares plane.
+constexpr int EDGE_SAMPLES = 32;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PolygonMesh::PolygonMesh(Parameters const& parameters, HeightSampler sampler)
+    : mParameters(parameters)
+    , mSampler(std::move(sampler)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates a new plane normal to the middle of the polygon and projects the polygon points to
+// this plane and generates a Delaunay-mesh on this plane and calculates the area and volume
+// of the original polygon using this mesh
+std::optional<PolygonMesh::Result> PolygonMesh::compute(
+    std::vector<glm::dvec3> const& points, glm::dvec3 const& center, glm::dvec3 const& radii) {
+  // Returns if no triangle can be created
+  if (points.size() < 3) {
+    return std::nullopt;
+  }
+
+  mCorners.clear();
+  mCornersFine.clear();
+  mRadii = radii;
+
+  Result result;
+
+  // Heights of the points, these are required for the average position and the least squares
+  // plane
+  std::vector<glm::dvec2> pointLngLats;
+  pointLngLats.reserve(points.size());
+  for (auto const& point : points) {
+    glm::dvec3 pos = glm::normalize(point) * radii[0];
+    pointLngLats.push_back(cs::utils::convert::cartesianToLngLat(pos, radii));
+  }
+
+  auto pointHeights = mSampler(pointLngLats);
+  if (!pointHeights) {
+    return std::nullopt;
+  }
+
+  // Corrected average position (works for every height scale)
+  glm::dvec3 averagePositionNorm(0.0);
+  for (size_t i = 0; i < points.size(); ++i) {
+    // Cartesian coordinate with height
+    glm::dvec3 posNorm =
+        cs::utils::convert::toCartesian(pointLngLats[i], radii, (*pointHeights)[i]);
+
+    averagePositionNorm += posNorm / static_cast<double>(points.size());
+  }
+
+  // Longest distance to average position
+  double maxDist = 0;
+  for (auto const& point : points) {
+    double dist = glm::length(center - point);
+    if (dist > maxDist) {
+      maxDist = dist;
+    }
+  }
+
+  // If polygon is to big (disable area calculation and mesh generation)
+  // Voronoi implementation is designed for a maximal area of one hemisphere
+  if (maxDist > radii[0]) {
+    result.mIsTooLarge = true;
+    return result;
+  }
+  // Converts maxDist to Voronoi plane (approx.)
+  // 1.2 is for safety -> makes sure, that the voronoi coordinates are under 1
+  mMaxDist = 1.2 * maxDist * radii[0] / (std::sqrt(std::pow(radii[0], 2) - std::pow(maxDist, 2)));
+
+  // Planes normal is perpendicular to the average position
+  mNormal      = glm::normalize(center);
+  mMiddlePoint = mNormal * radii[0];
+
+  // Coordinate system of the plane
+  if (mNormal.y != 0) {
+    // Normal and north is perpendicular -> dot product is 0
+    double yNorth = (std::pow(mNormal.x, 2) + std::pow(mNormal.z, 2)) / mNormal.y;
+    mNorth        = glm::normalize(glm::dvec3(-mNormal.x, yNorth, -mNormal.z));
+    // Changes south to north on the southern hemisphere
+    if (yNorth < 0) {
+      mNorth = glm::normalize(glm::dvec3(mNormal.x, -yNorth, mNormal.z));
+    }
+  } else {
+    // If plane normal is perpendicular to y axes, north is y
+    mNorth = glm::dvec3(0, 1, 0);
+  }
+
+  mEast = -glm::cross(mNormal, mNorth);
+
+  // Calculates plane for volume calculation
+  // From DipStrikeTool
+  // Based on http://stackoverflow.com/questions/1400213/3d-least-squares-plane
+  glm::dmat3 mat(0);
+  glm::dvec3 vec(0);
+
+  mNormal2 = glm::normalize(averagePositionNorm);
+  mOffset  = 0.F;
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    glm::dvec3 posNorm =
+        cs::utils::convert::toCartesian(pointLngLats[i], radii, (*pointHeights)[i]);
+
+    glm::dvec3 realtivePosition = posNorm - averagePositionNorm;
+
+    mat[0][0] += realtivePosition.x * realtivePosition.x;
+    mat[1][0] += realtivePosition.x * realtivePosition.y;
+    mat[2][0] += realtivePosition.x;
+    mat[0][1] += realtivePosition.x * realtivePosition.y;
+    mat[1][1] += realtivePosition.y * realtivePosition.y;
+    mat[2][1] += realtivePosition.y;
+    mat[0][2] += realtivePosition.x;
+    mat[1][2] += realtivePosition.y;
+    mat[2][2] += 1;
+
+    vec[0] += realtivePosition.x * realtivePosition.z;
+    vec[1] += realtivePosition.y * realtivePosition.z;
+    vec[2] += realtivePosition.z;
+  }
+
+  glm::dvec3 solution = glm::inverse(mat) * vec;
+  mNormal2            = glm::normalize(glm::dvec3(-solution.x, -solution.y, 1.F));
+
+  if (glm::dot(mNormal, mNormal2) < 0) {
+    mNormal2 = -mNormal2;
+  }
+
+  mOffset       = solution.z;
+  mMiddlePoint2 = averagePositionNorm + mNormal2 * radii[0] * mOffset;
+
+  // Projects points to Voronoi plane and calculates their position in the new coordinate system
+  int        addr = 0;
+  glm::dvec3 lastPosition{0};
+
+  for (auto const& currentPosition : points) {
+    // Filters out double points
+    if (currentPosition != lastPosition) {
+      // Corrects distance from origin (average point is inside of the sphere)
+      double     k   = glm::dot(mNormal, mMiddlePoint) / glm::dot(mNormal, currentPosition);
+      glm::dvec3 pos = k * currentPosition;
+
+      // Coordinates on the plane
+      double x = glm::dot(mEast, pos - mMiddlePoint);
+      double y = glm::dot(mNorth, pos - mMiddlePoint);
+
+      // Avoids crashing when moving to the other side of the planet
+      if ((std::isnan(x / mMaxDist)) || (std::isnan(y / mMaxDist))) {
+        return std::nullopt;
+      }
+
+      // Saves coordinates normalized with maxDist
+      mCorners.emplace_back(x / mMaxDist, y / mMaxDist, addr);
+
+      lastPosition = currentPosition;
+      addr++;
+    }
+  }
+
+  // Vector to save triangles from voronoi generator
+  std::vector<Triangle> triangles;
+
+  // Creates Delaunay-mesh of the original polygon
+  createMesh(triangles);
+
+  bool     fine       = false;
+  uint32_t attempt    = 0;
+  size_t   pointCount = 0;
+
+  // Refines triangulation until it is necessary or mMaxAttempt or mMaxPoints
+  while ((!fine) && (attempt < mParameters.mMaxAttempt) && (pointCount < mParameters.mMaxPoints)) {
+    attempt++;
+    fine       = true;
+    pointCount = 0;
+
+    result.mTriangulation.clear();
+
+    // The triangles of the original Delaunay-mesh which are inside of the polygon
+    std::vector<Cell> cells;
+
+    // Goes through every triangle of original Delaunay-mesh separately
+    for (auto const& t : triangles) {
+
+      Site s1(0, 0, 0);
+      Site s2(0, 0, 0);
+      Site s3(0, 0, 0);
+      std::tie(s1, s2, s3) = t;
+
+      // Middle point of the triangle
+      glm::dvec2 avgPoint = glm::dvec2((s1.mX + s2.mX + s3.mX) / 3, (s1.mY + s2.mY + s3.mY) / 3);
+
+      // Checks, if middle point is is the polygon
+      if (checkPoint(avgPoint)) {
+        if (attempt == 1) {
+          // Emplaces back the 3 corners of the triangle
+          std::vector<Site> corners;
+          corners.emplace_back(s1.mX, s1.mY, 0);
+          corners.emplace_back(s2.mX, s2.mY, 1);
+          corners.emplace_back(s3.mX, s3.mY, 2);
+
+          mCornersFine.emplace_back(corners);
+        }
+
+        Cell cell;
+
+        // Checks sleekness of triangles in Delaunay-mesh and refines them, if necessary
+        cell.mRefine = checkSleekness(static_cast<int32_t>(cells.size()));
+
+        // Voronoi inside the original triangles - to refine triangle angles
+        auto voronoiRefine = Triangulator::create(mParameters.mTriangulator);
+        voronoiRefine->parse(mCornersFine[cells.size()]);
+
+        cell.mEdges     = voronoiRefine->getTriangulation();
+        cell.mTriangles = voronoiRefine->getTriangles();
+
+        cells.emplace_back(std::move(cell));
+      } // if (checkPoint(avgPoint))
+    }   // for (auto const& t : triangles)
+
+    // If not too many points are addded in checkSleekness and it is not the the last attempt
+    // than the mesh is refined based on edge length and height differences
+    bool checkTerrain = attempt < mParameters.mMaxAttempt;
+
+    // Samples the heights of all edges at once: their end points and the points used by
+    // refineMesh(), if the edge may be refined
+    std::vector<glm::dvec2> lngLats;
+
+    for (auto const& cell : cells) {
+      for (auto const& s : cell.mEdges) {
+        lngLats.push_back(
+            cs::utils::convert::cartesianToLngLat(toSurface(s.first.mX, s.first.mY), radii));
+        lngLats.push_back(
+            cs::utils::convert::cartesianToLngLat(toSurface(s.second.mX, s.second.mY), radii));
+
+        if (!cell.mRefine && checkTerrain) {
+          addRefinementPoints(s, lngLats);
+        }
+      }
+    }
+
+    auto heights = mSampler(lngLats);
+    if (!heights) {
+      return std::nullopt;
+    }
+
+    size_t next = 0;
+
+    for (size_t triangleCount = 0; triangleCount < cells.size(); ++triangleCount) {
+      auto const& cell = cells[triangleCount];
+
+      // No need for checkPoint, all of the edges are inside the triangle and the polygon
+      for (auto const& s : cell.mEdges) {
+        glm::dvec2 l1 = lngLats[next];
+        glm::dvec2 l2 = lngLats[next + 1];
+        double     h1 = (*heights)[next];
+        double     h2 = (*heights)[next + 1];
+        next += 2;
+
+        // Saves mesh coordinates on planet's surface for display
+        result.mTriangulation.emplace_back(
+            cs::utils::convert::toCartesian(l1, radii, h1 * mParameters.mHeightScale));
+        result.mTriangulation.emplace_back(
+            cs::utils::convert::toCartesian(l2, radii, h2 * mParameters.mHeightScale));
+
+        if (!cell.mRefine && checkTerrain) {
+          if (pointCount < mParameters.mMaxPoints) {
+            refineMesh(s, static_cast<int32_t>(triangleCount), h1, h2, *heights, next, fine);
+          }
+
+          next += REFINEMENT_POINTS;
+        }
+      }
+
+      pointCount += mCornersFine[triangleCount].size();
+    }
+
+    // Area and volume are only calculated for the final mesh
+    if (fine || (attempt >= mParameters.mMaxAttempt) || (pointCount >= mParameters.mMaxPoints)) {
+      std::vector<Triangle> trianglesRefined;
+      for (auto const& cell : cells) {
+        trianglesRefined.insert(
+            trianglesRefined.end(), cell.mTriangles.begin(), cell.mTriangles.end());
+      }
+
+      if (!calculateAreaAndVolume(
+              trianglesRefined, result.mArea, result.mPosVolume, result.mNegVolume)) {
+        return std::nullopt;
+      }
+    }
+  } // while ((!fine) && (attempt < mMaxAttempt) && (pointCount < mMaxPoints))
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Based on
+// https://stackoverflow.com/questions/8721406/how-to-determine-if-a-point-is-inside-a-2d-convex-polygon
+bool PolygonMesh::checkPoint(glm::dvec2 const& point) {
+  bool result = false;
+
+  // Positive x (other directions could be compared, but it works reliable with only one direction)
+  for (size_t i = 0, j = mCorners.size() - 1; i < mCorners.size(); j = i++) {
+    if (((mCorners[i].mY > point.y) != (mCorners[j].mY > point.y) &&
+            (point.x < (mCorners[j].mX - mCorners[i].mX) * (point.y - mCorners[i].mY) /
+                               (mCorners[j].mY - mCorners[i].mY) +
+                           mCorners[i].mX)) ||
+        // Checks surroundings to avoid numerical errors
+        ((mCorners[i].mY > point.y) != (mCorners[j].mY > point.y) &&
+            std::abs(point.x - ((mCorners[j].mX - mCorners[i].mX) * (point.y - mCorners[i].mY) /
+                                       (mCorners[j].mY - mCorners[i].mY) +
+                                   mCorners[i].mX)) < 0.001)) {
+      result = !result;
+    }
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PolygonMesh::findIntersection(Site const& s1, Site const& s2, Site const& s3, Site const& s4,
+    double& intersectionX, double& intersectionY) {
+  // Avoids division with 0
+  if ((s1.mX == 0) || (s2.mX == 0) || (s3.mX == 0) || (s4.mX == 0) || (s1.mY == 0) ||
+      (s2.mY == 0) || (s3.mY == 0) || (s4.mY == 0)) {
+    return false;
+  }
+
+  // Based on
+  // http://www.softwareandfinance.com/Visual_CPP/VCPP_Intersection_Two_lines_EndPoints.html
+
+  // Safety band - to avoid point duplications - set to 1%
+  double safety = 0.01;
+
+  double m1{};
+  double m2{};
+  double c1{};
+  double c2{};
+
+  // Line 1 (y = m1 * x + c1)
+  m1 = (s2.mY - s1.mY) / (s2.mX - s1.mX);
+  c1 = s1.mY - m1 * s1.mX;
+
+  // Line 2 (y = m2 * x + c2)
+  m2 = (s4.mY - s3.mY) / (s4.mX - s3.mX);
+  c2 = s3.mY - m2 * s3.mX;
+
+  // Edges are not exactly parallel
+  if (m1 != m2) {
+    // Intersection of lines
+    intersectionX = (c2 - c1) / (m1 - m2);
+    intersectionY = m1 * (intersectionX) + c1;
+
+    // Checks if intersection point is on the edges or not (between a bounding box)
+    if (((s1.mX > intersectionX) != (s2.mX > intersectionX)) &&
+        ((s3.mX > intersectionX) != (s4.mX > intersectionX)) &&
+        ((s1.mY > intersectionY) != (s2.mY > intersectionY)) &&
+        ((s3.mY > intersectionY) != (s4.mY > intersectionY))) {
+      // Checks all 4 points: do not return with an intersection point within the safety band
+      if (((std::abs((s1.mX - intersectionX) / s1.mX) > safety) ||
+              (std::abs((s1.mY - intersectionY) / s1.mY) > safety)) &&
+          ((std::abs((s2.mX - intersectionX) / s2.mX) > safety) ||
+              (std::abs((s2.mY - intersectionY) / s2.mY) > safety)) &&
+          ((std::abs((s3.mX - intersectionX) / s3.mX) > safety) ||
+              (std::abs((s3.mY - intersectionY) / s3.mY) > safety)) &&
+          ((std::abs((s4.mX - intersectionX) / s4.mX) > safety) ||
+              (std::abs((s4.mY - intersectionY) / s4.mY) > safety))) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PolygonMesh::createMesh(std::vector<Triangle>& triangles) {
+  bool edgesOK = false;
+  int  it      = 0;
+
+  // Does the triangulaiton of the original polygon
+  // Checks and refines the triangulation until all original edges of the polygon are in the
+  // triangulation Quits after 5 iteration to avoid performance issues and displays error message
+  while (!edgesOK && it < 5) {
+    it++;
+
+    // Performs the Delaunay triangulation
+    auto voronoi = Triangulator::create(mParameters.mTriangulator);
+    voronoi->parse(mCorners);
+
+    // Number of the original edges of the polygon
+    size_t countEdges = mCorners.size();
+
+    // Vector of the original edges of the polygon from Delaunay triangulation
+    std::vector<Edge2> voronoiEdges;
+
+    for (auto const& s : voronoi->getTriangulation()) {
+      // Finds original edges based on their addresses
+      if (((std::abs(s.second.mAddr - s.first.mAddr) == 1 ||
+               (std::abs(s.second.mAddr - s.first.mAddr) == mCorners.size() - 1)) &&
+              s.first.mAddr < mCorners.size() && s.second.mAddr < mCorners.size())) {
+        // Counts found edges
+        countEdges--;
+
+        Site site1(0, 0, 0);
+        Site site2(0, 0, 0);
+
+        // Orders addresses of the found edge
+        if (((s.first.mAddr == mCorners.size() - 1) && (s.second.mAddr == 0)) ||
+            ((s.second.mAddr > s.first.mAddr) &&
+                !((s.first.mAddr == 0) && (s.second.mAddr == mCorners.size() - 1)))) {
+          site1 = s.first;
+          site2 = s.second;
+        } else {
+          site1 = s.second;
+          site2 = s.first;
+        }
+        // Saves edges of the triangulation
+        voronoiEdges.emplace_back(site1, site2);
+      }
+    }
+
+    // If some of the polygon edges did not match with a voronoi edge
+    // This means, that some edges are missing, and need to be recovered
+    // Intersection points of the missing edges and voronoi edges need to determined
+    // These points are added to mCorners, and the triangulation hopefully
+    // solves the problem in the next cycle (works for most of the cases)
+    if (countEdges != 0) {
+      // Vector of corners on missing edges - to be added to mCorners
+      std::vector<Site> addCorners;
+
+      // Finds the missing edges: search for every original edge in voronoiEdges
+      // (the original polygon edges have neighbor addresses -> searches for corners)
+      for (size_t i = 0; i < mCorners.size(); i++) {
+        bool       found = false;
+        glm::ivec2 missingAddr;
+
+        // In case of the last line of the polygon
+        if (i == (mCorners.size() - 1)) {
+          for (auto const& v : voronoiEdges) {
+            if ((v.first.mAddr == i) && (v.second.mAddr == 0)) {
+              found = true;
+            }
+          }
+
+          if (!found) {
+            missingAddr = glm::ivec2(i, 0);
+          }
+        }
+        // Every other line
+        else {
+          for (auto const& v : voronoiEdges) {
+            if ((v.first.mAddr == i) && (v.second.mAddr == i + 1)) {
+              found = true;
+            }
+          }
+          if (!found) {
+            missingAddr = glm::ivec2(i, i + 1);
+          }
+        }
+
+        // If this edge is missing
+        if (!found) {
+          // Points of the missing edge
+          Site              site1(0, 0, 0);
+          Site              site2(0, 0, 0);
+          std::vector<Site> sites;
+
+          // Pairs the known addresses of the missing edge with sites
+          for (auto const& s : voronoi->getTriangulation()) {
+            if (s.first.mAddr == missingAddr.x) {
+              site1 = s.first;
+            }
+            if (s.second.mAddr == missingAddr.x) {
+              site1 = s.second;
+            }
+
+            if (s.first.mAddr == missingAddr.y) {
+              site2 = s.first;
+            }
+            if (s.second.mAddr == missingAddr.y) {
+              site2 = s.second;
+            }
+          }
+
+          // Finds intersecting edges (if a triangulation edge intersects the original polygon edge,
+          // it is wrong)
+          for (auto const& s : voronoi->getTriangulation()) {
+            double intersectionX{};
+            double intersectionY{};
+
+            if (findIntersection(site1, site2, s.first, s.second, intersectionX, intersectionY)) {
+              int addrNew =
+                  site1.mAddr + 1; // = site2.mAddr (except for the last edge, where site2.mAddr=0!
+              Site oldCorner(0, 0, 0);
+              bool done = false;
+
+              // Cycles through addCorners vector and saves current intersection into the right
+              // place
+              for (auto& addCorner : addCorners) {
+                // If current intersection is not saved yet
+                if (!done) {
+                  // Compares addresses of the two intersection
+                  if (addCorner.mAddr < addrNew) {
+                    // Skips first elements of vector
+                  } else if (addCorner.mAddr == addrNew) {
+                    // If edges points to positive x
+                    if (intersectionX > site1.mX) {
+                      // Saves intersection only when it is in front of the
+                      // existing intersection; otherwise it will be handled
+                      // in the next cycle
+                      if (addCorner.mX > intersectionX) {
+                        // Saves existing intersection to oldCorner
+                        // will be placed back to vector in the next cycle
+                        oldCorner = addCorner;
+                        addCorner = Site(intersectionX, intersectionY, addrNew);
+                        done      = true;
+                      }
+                    }
+                    // If edges points to negative x
+                    else if (intersectionX < site1.mX) {
+                      if (addCorner.mX < intersectionX) {
+                        oldCorner = addCorner;
+                        addCorner = Site(intersectionX, intersectionY, addrNew);
+                        done      = true;
+                      }
+                    }
+                    // Handles the very rare case of a vertical edge
+                    // Does the same, as before, just now with y coordinates
+                    else if (intersectionX == site1.mX) {
+                      if (intersectionY > site1.mY) {
+                        if (addCorner.mY > intersectionY) {
+                          oldCorner = addCorner;
+                          addCorner = Site(intersectionX, intersectionY, addrNew);
+                          done      = true;
+                        }
+                      } else if (intersectionY < site1.mY) {
+                        if (addCorner.mY < intersectionY) {
+                          oldCorner = addCorner;
+                          addCorner = Site(intersectionX, intersectionY, addrNew);
+                          done      = true;
+                        }
+                      }
+                    } // if (intersectionX==s.first.mX)
+                  }   // if (addCorners[i].mAddr == addrNew)
+                  // if (addCorners[i].mAddr > addrNew)
+                  else {
+                    oldCorner = addCorner;
+                    addCorner = Site(intersectionX, intersectionY, addrNew);
+                    done      = true;
+                  }
+                } // if (!done)
+                else {
+                  // After the current intersecting point is added to the middle of the vector
+                  // shifts back every other element by one position
+                  Site newCorner = addCorner;
+                  addCorner      = oldCorner;
+                  oldCorner      = newCorner;
+                }
+              } // for (int i = 0; i < addCorners.size(); i++)
+
+              // If the current intersection was placed in the vector
+              if (done) {
+                // Emplaces the last element to the end of the vector
+                addCorners.emplace_back(oldCorner);
+              } else {
+                // Emplaces back current intersection to the end of the vector
+                addCorners.emplace_back(Site(intersectionX, intersectionY, addrNew));
+              }
+
+              // Corners needed to be added -> run the cycle again
+              edgesOK = false;
+            } // if (findIntersection(...))
+          }   // for (auto const& s : triangulation)
+        }     // if (!found)
+      }       // for (int i = 0; i < mCorners.size(); i++)
+
+      // Counts the intersection corners already added to mCorners
+      int cornerCount = 0;
+
+      // Goes through the intersection corners and adds them to the right place of mCorners
+      for (auto const& c : addCorners) {
+        // Address of the intersection if it is the only one in the vector
+        int addr3 = c.mAddr;
+        addr3 += cornerCount;
+
+        // If intersection is not between last and first Site
+        if (addr3 < static_cast<int>(mCorners.size())) {
+          // Saves intersection corner to mCorners and element of mCorners to oldSite
+          Site oldSite    = mCorners[addr3];
+          mCorners[addr3] = Site(c.mX, c.mY, addr3);
+
+          addr3++;
+
+          // Shifts every other corner of mCorners behind by one
+          for (; addr3 < static_cast<int>(mCorners.size()); addr3++) {
+            Site newSite    = mCorners[addr3];
+            mCorners[addr3] = Site(oldSite.mX, oldSite.mY, addr3);
+            oldSite         = newSite;
+          }
+
+          // Emplaces back the last corner
+          mCorners.emplace_back(Site(oldSite.mX, oldSite.mY, addr3));
+        } else {
+          // Emplaces back the intersection corner
+          mCorners.emplace_back(Site(c.mX, c.mY, addr3));
+        }
+
+        cornerCount++;
+      }
+    } // if (countEdges != 0)
+    else {
+      // All of the original edges are in voronoiEdges -> no need for an other cycle
+      edgesOK = true;
+    }
+    // Saves the original triangles
+    triangles = voronoi->getTriangles();
+  } // while (!edgesOK && it < 5)
+
+  // If the voronoi edges are still wrong after 5 cycles of refinement, display the problem
+  if (!edgesOK) {
+    logger().warn("Area calculation can be false: Concave or self-intersecting polygon! Check "
+                  "triangulation mesh.");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PolygonMesh::checkSleekness(int count) {
+  // Voronoi inside the original triangles - to check triangle angles
+  auto voronoiCheck = Triangulator::create(mParameters.mTriangulator);
+  voronoiCheck->parse(mCornersFine[count]);
+
+  // Vector to save addresses of added points - to avoid adding the same point twice
+  std::vector<std::pair<int, int>> addedPoints;
+
+  // Checks triangle sleekness and add middle points to vector if they are too sleek
+  // Could be done in multiple iterations for a more precise result
+  for (auto const& t2 : voronoiCheck->getTriangles()) {
+    // Minimun angle criteria (for 2 simple cases, approximately correct in general)
+    float minAngle = mParameters.mSleekness * glm::pi<float>() / 180;
+    // Ratio of two edges in triangle
+    float sleekness1 = 1 / std::sin(minAngle);
+    // Ration between the sum of 2 smaller edges and the long edge in triangle
+    float sleekness2 = 1 / std::cos(minAngle);
+
+    Site si1(0, 0, 0);
+    Site si2(0, 0, 0);
+    Site si3(0, 0, 0);
+    std::tie(si1, si2, si3) = t2;
+
+    // Length of the edges
+    double length1 = glm::length(glm::dvec2(si1.mX, si1.mY) - glm::dvec2(si2.mX, si2.mY));
+    double length2 = glm::length(glm::dvec2(si1.mX, si1.mY) - glm::dvec2(si3.mX, si3.mY));
+    double length3 = glm::length(glm::dvec2(si2.mX, si2.mY) - glm::dvec2(si3.mX, si3.mY));
+
+    // Edge 1 is too long compared to the others
+    if ((length2 * sleekness1 < length1) || (length3 * sleekness1 < length1) ||
+        (length2 + length3 < length1 * sleekness2)) {
+      bool addPoint = true;
+      // Checks previously added points if they are the same
+      for (auto const& addr : addedPoints) {
+        if (((addr.first == si1.mAddr) && (addr.second == si2.mAddr)) ||
+            ((addr.first == si2.mAddr) && (addr.second == si1.mAddr))) {
+          addPoint = false;
+        }
+      }
+      // If not, adds this point to vector
+      if (addPoint) {
+        mCornersFine[count].emplace_back((si1.mX + si2.mX) / 2, (si1.mY + si2.mY) / 2,
+            static_cast<uint16_t>(mCornersFine[count].size()));
+        addedPoints.emplace_back(si1.mAddr, si2.mAddr);
+      }
+    }
+
+    // Edge 2 is too long compared to the others
+    if ((length1 * sleekness1 < length2) || (length3 * sleekness1 < length2) ||
+        (length1 + length3 < length2 * sleekness2)) {
+      bool addPoint = true;
+      for (auto const& addr : addedPoints) {
+        if (((addr.first == si1.mAddr) && (addr.second == si3.mAddr)) ||
+            ((addr.first == si3.mAddr) && (addr.second == si1.mAddr))) {
+          addPoint = false;
+        }
+      }
+      if (addPoint) {
+        mCornersFine[count].emplace_back((si1.mX + si3.mX) / 2, (si1.mY + si3.mY) / 2,
+            static_cast<uint16_t>(mCornersFine[count].size()));
+        addedPoints.emplace_back(si1.mAddr, si3.mAddr);
+      }
+    }
+
+    // Edge 3 is too long compared to the others
+    if ((length1 * sleekness1 < length3) || (length2 * sleekness1 < length3) ||
+        (length1 + length2 < length3 * sleekness2)) {
+      bool addPoint = true;
+      for (auto const& addr : addedPoints) {
+        if (((addr.first == si2.mAddr) && (addr.second == si3.mAddr)) ||
+            ((addr.first == si3.mAddr) && (addr.second == si2.mAddr))) {
+          addPoint = false;
+        }
+      }
+      if (addPoint) {
+        mCornersFine[count].emplace_back((si2.mX + si3.mX) / 2, (si2.mY + si3.mY) / 2,
+            static_cast<uint16_t>(mCornersFine[count].size()));
+        addedPoints.emplace_back(si2.mAddr, si3.mAddr);
+      }
+    }
+  }
+
+  return addedPoints.size() >
+         1.5 * static_cast<double>(mCornersFine[count].size() - addedPoints.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec2 PolygonMesh::getEdgePoint(Edge2 const& edge, int i, int j) {
+  return glm::dvec2((i * edge.first.mX + (j - i) * edge.second.mX) / j,
+      (i * edge.first.mY + (j - i) * edge.second.mY) / j);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PolygonMesh::addRefinementPoints(Edge2 const& edge, std::vector<glm::dvec2>& lngLats) const {
+  // Middle point of the edge
+  glm::dvec2 avgPoint2 = getEdgePoint(edge, 1, 2);
+  lngLats.push_back(
+      cs::utils::convert::cartesianToLngLat(toSurface(avgPoint2.x, avgPoint2.y), mRadii));
+
+  // Trisecting points, etc.
+  for (int j = 3; j < 6; j++) {
+    for (int i = 1; i < j; i++) {
+      glm::dvec2 avgPoint3 = getEdgePoint(edge, i, j);
+      lngLats.push_back(
+          cs::utils::convert::cartesianToLngLat(toSurface(avgPoint3.x, avgPoint3.y), mRadii));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PolygonMesh::refineMesh(Edge2 const& edge, int count, double h1, double h2,
+    std::vector<double> const& heights, size_t offset, bool& fine) {
+
+  // Middle point of the edge on voronoi plane
+  glm::dvec2 avgPoint2 = getEdgePoint(edge, 1, 2);
+
+  // Heights of the points over see level
+  double hAvg = heights[offset++];
+
+  // Checks height of the middle point
+  if ((hAvg / ((h1 + h2) / 2) > mParameters.mHeightDiff) ||
+      (((h1 + h2) / 2) / hAvg > mParameters.mHeightDiff)) {
+    mCornersFine[count].emplace_back(
+        avgPoint2.x, avgPoint2.y, static_cast<uint16_t>(mCornersFine[count].size()));
+    fine = false;
+  }
+  // Checks height of other points between the two Sites
+  else {
+    // Trisecting points, etc.
+    for (int j = 3; j < 6; j++) {
+      // Checks "level" only if no points were emplaced back form the previous cycle
+      if (fine) {
+        for (int i = 1; i < j; i++) {
+          // Point
+          glm::dvec2 avgPoint3 = getEdgePoint(edge, i, j);
+          // Height of the point
+          double heAvg3 = heights[offset + i - 1];
+
+          if ((heAvg3 / ((i * h1 + (j - i) * h2) / j) > mParameters.mHeightDiff) ||
+              (((i * h1 + (j - i) * h2) / j) / heAvg3 > mParameters.mHeightDiff)) {
+            mCornersFine[count].emplace_back(
+                avgPoint3.x, avgPoint3.y, static_cast<uint16_t>(mCornersFine[count].size()));
+            fine = false;
+          }
+        }
+      }
+
+      offset += j - 1;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PolygonMesh::calculateAreaAndVolume(
+    std::vector<Triangle> const& triangles, double& area, double& pvol, double& nvol) {
+  // Samples the heights of all triangle corners at once
+  std::vector<glm::dvec3> corners;
+  std::vector<glm::dvec2> lngLats;
+  corners.reserve(3 * triangles.size());
+  lngLats.reserve(3 * triangles.size());
+
+  for (const auto& triangle : triangles) {
+    Site si1(0, 0, 0);
+    Site si2(0, 0, 0);
+    Site si3(0, 0, 0);
+    std::tie(si1, si2, si3) = triangle;
+
+    // Cartesian coordinates without height
+    for (auto const& si : {si1, si2, si3}) {
+      corners.push_back(toSurface(si.mX, si.mY));
+      lngLats.push_back(cs::utils::convert::cartesianToLngLat(corners.back(), mRadii));
+    }
+  }
+
+  auto heights = mSampler(lngLats);
+  if (!heights) {
+    return false;
+  }
+
+  // Samples the heights along all edges which intersect the least squares plane at once
+  std::vector<glm::dvec2> sampleLngLats;
+
+  auto addEdgeSamples = [&](glm::dvec3 const& pA, glm::dvec3 const& pB) {
+    for (int i = 0; i < EDGE_SAMPLES; i++) {
+      double     frac = static_cast<double>(i) / EDGE_SAMPLES;
+      glm::dvec3 pM   = glm::normalize((1 - frac) * pA + frac * pB) * mRadii[0];
+      sampleLngLats.push_back(cs::utils::convert::cartesianToLngLat(pM, mRadii));
+    }
+  };
+
+  for (size_t i = 0; i < corners.size(); i += 3) {
+    double hl1 = getHeightOverPlane(corners[i], (*heights)[i]);
+    double hl2 = getHeightOverPlane(corners[i + 1], (*heights)[i + 1]);
+    double hl3 = getHeightOverPlane(corners[i + 2], (*heights)[i + 2]);
+
+    if (!(((hl1 > 0) && (hl2 > 0) && (hl3 > 0)) || ((hl1 < 0) && (hl2 < 0) && (hl3 < 0)))) {
+      if ((hl1 > 0) != (hl2 > 0)) {
+        addEdgeSamples(corners[i], corners[i + 1]);
+      }
+      if ((hl1 > 0) != (hl3 > 0)) {
+        addEdgeSamples(corners[i], corners[i + 2]);
+      }
+      if ((hl2 > 0) != (hl3 > 0)) {
+        addEdgeSamples(corners[i + 1], corners[i + 2]);
+      }
+    }
+  }
+
+  auto samples = mSampler(sampleLngLats);
+  if (!samples) {
+    return false;
+  }
+
+  size_t nextSample = 0;
+
+  // Counts area and volume in every triangle
+  for (size_t c = 0; c < corners.size(); c += 3) {
+    // ------------------------------------------ AREA ------------------------------------------
+
+    // Cartesian coordinates without height
+    glm::dvec3 const& p1 = corners[c];
+    glm::dvec3 const& p2 = corners[c + 1];
+    glm::dvec3 const& p3 = corners[c + 2];
+
+    // Heights of the points
+    double h1 = (*heights)[c];
+    double h2 = (*heights)[c + 1];
+    double h3 = (*heights)[c + 2];
+
+    // Cartesian coordinates with height
+    glm::dvec3 r1 = cs::utils::convert::toCartesian(lngLats[c], mRadii, h1);
+    glm::dvec3 r2 = cs::utils::convert::toCartesian(lngLats[c + 1], mRadii, h2);
+    glm::dvec3 r3 = cs::utils::convert::toCartesian(lngLats[c + 2], mRadii, h3);
+
+    // Area is the half of the cross product of two edges in triangle
+    area += glm::length(glm::cross(r2 - r1, r3 - r1)) / 2;
+
+    // ----------------------------------------- Volume -----------------------------------------
+
+    // Heights over the least squares plane
+    double hl1 = getHeightOverPlane(p1, h1);
+    double hl2 = getHeightOverPlane(p2, h2);
+    double hl3 = getHeightOverPlane(p3, h3);
+
+    double baseArea1 = 0;
+    double baseArea2 = 0;
+    double volume    = 0;
+
+    // If all of the triangle's corners' are on the same size of the least square plane
+    if (((hl1 > 0) && (hl2 > 0) && (hl3 > 0)) || ((hl1 < 0) && (hl2 < 0) && (hl3 < 0))) {
+      // Base area: planet surface without heights / least square plane
+      baseArea1 = glm::length(glm::cross(p2 - p1, p3 - p1)) / 2;
+      // Volume is the multiplication of surface and average height over the plane
+      volume = baseArea1 * ((hl1 + hl2 + hl3) / 3);
+
+      // Counts positive and negative volumes separately
+      if (volume > 0) {
+        pvol += volume;
+      } else {
+        nvol += volume;
+      }
+    }
+    // If not: find intersection points with the least square plane
+    // If 2 intersection points are found:
+    // Split the triangle into a smaller triangle and a quadrilateral
+    else {
+      auto   pM1    = glm::dvec3(0.0);
+      auto   pM2    = glm::dvec3(0.0);
+      auto   pM3    = glm::dvec3(0.0);
+      auto   pM     = glm::dvec3(0.0);
+      auto   pMOld  = glm::dvec3(0.0);
+      double hM     = 0;
+      double hlM    = 0;
+      double hlMOld = 0;
+      bool   b1     = false;
+      bool   b2     = false;
+      bool   b3     = false;
+
+      // Resolution of edge sampling
+      int    res  = EDGE_SAMPLES;
+      double frac = 0;
+
+      // If the two points are on the other side of the plane
+      if ((hl1 > 0) != (hl2 > 0)) {
+        // Samples of edge to find the intersection point between edge and plane
+        // (Does not consider multiple intersection points (f.eg.: mountains in triangle)
+        // They have been mostly eliminated with triangulation
+        for (int i = 0; i < res; i++) {
+          frac = static_cast<double>(i) / res;
+          // Point coordinate without height
+          pM = glm::normalize((1 - frac) * p1 + frac * p2) * mRadii[0];
+
+          // Height
+          hM = (*samples)[nextSample + static_cast<size_t>(i)];
+          // Height over least square plane
+          hlM = getHeightOverPlane(pM, hM);
+          // If intersection is between this and previous sample point
+          // Interpolate between this and previous point and end loop
+          if ((hl1 > 0) != (hlM > 0)) {
+            pM1 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
+            // To quit loop
+            i  = res;
+            b1 = true;
+          } else {
+            // Save values for the next cycle
+            pMOld  = pM;
+            hlMOld = hlM;
+          }
+        }
+
+        nextSample += res;
+      }
+
+      if ((hl1 > 0) != (hl3 > 0)) {
+        for (int i = 0; i < res; i++) {
+          frac = static_cast<double>(i) / res;
+          pM   = glm::normalize((1 - frac) * p1 + frac * p3) * mRadii[0];
+          hM   = (*samples)[nextSample + static_cast<size_t>(i)];
+          hlM  = getHeightOverPlane(pM, hM);
+          if ((hl1 > 0) != (hlM > 0)) {
+            pM2 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
+            i   = res;
+            b2  = true;
+          } else {
+            pMOld  = pM;
+            hlMOld = hlM;
+          }
+        }
+
+        nextSample += res;
+      }
+
+      if ((hl2 > 0) != (hl3 > 0)) {
+        for (int i = 0; i < res; i++) {
+          frac = static_cast<double>(i) / res;
+          pM   = glm::normalize((1 - frac) * p2 + frac * p3) * mRadii[0];
+          hM   = (*samples)[nextSample + static_cast<size_t>(i)];
+          hlM  = getHeightOverPlane(pM, hM);
+          if ((hl2 > 0) != (hlM > 0)) {
+            pM3 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
+            i   = res;
+            b3  = true;
+          } else {
+            pMOld  = pM;
+            hlMOld = hlM;
+          }
+        }
+
+        nextSample += res;
+      }
+
+      // If the first two edges have an intersection point with the plane
+      if ((b1 == 1) && (b2 == 1) && (b3 == 0)) {
+        // Area of the smaller triangle
+        baseArea1 = glm::length(glm::cross(pM1 - p1, pM2 - p1)) / 2;
+        // Area of the quadrilateral
+        baseArea2 = glm::length(glm::cross(pM1 - p3, pM2 - p3)) / 2 +
+                    glm::length(glm::cross(pM1 - p2, p3 - p2)) / 2;
+
+        // Decide the sign of the volume based on the
+        // height of the corner in the small triangle
+        // (Heights of intersections are considered to be 0)
+        if (hl1 > 0) {
+          // Add volumes
+          pvol += baseArea1 * hl1 / 3;
+          nvol += baseArea2 * ((hl2 + hl3) / 4);
+        } else {
+          nvol += baseArea1 * hl1 / 3;
+          pvol += baseArea2 * ((hl2 + hl3) / 4);
+        }
+      } else if ((b1 == 1) && (b2 == 0) && (b3 == 1)) {
+        baseArea1 = glm::length(glm::cross(pM1 - p2, pM3 - p2)) / 2;
+        baseArea2 = glm::length(glm::cross(pM1 - p1, pM3 - p1)) / 2 +
+                    glm::length(glm::cross(pM3 - p3, p1 - p3)) / 2;
+
+        if (hl2 > 0) {
+          pvol += baseArea1 * hl2 / 3;
+          nvol += baseArea2 * ((hl1 + hl3) / 4);
+        } else {
+          nvol += baseArea1 * hl2 / 3;
+          pvol += baseArea2 * ((hl1 + hl3) / 4);
+        }
+      } else if ((b1 == 0) && (b2 == 1) && (b3 == 1)) {
+        baseArea1 = glm::length(glm::cross(pM3 - p3, pM2 - p3)) / 2;
+        baseArea2 = glm::length(glm::cross(pM2 - p2, pM3 - p2)) / 2 +
+                    glm::length(glm::cross(pM2 - p1, p2 - p1)) / 2;
+
+        if (hl3 > 0) {
+          pvol += baseArea1 * hl3 / 3;
+          nvol += baseArea2 * ((hl1 + hl2) / 4);
+        } else {
+          nvol += baseArea1 * hl3 / 3;
+          pvol += baseArea2 * ((hl1 + hl2) / 4);
+        }
+      }
+      // If more or fewer as 2 intersection points are found
+      // Calculate volume without spliting the triangle (as in the first case)
+      else {
+        baseArea1 = glm::length(glm::cross(p2 - p1, p3 - p1)) / 2;
+        volume    = baseArea1 * ((hl1 + hl2 + hl3) / 3);
+
+        if (volume > 0) {
+          pvol += volume;
+        } else {
+          nvol += volume;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 PolygonMesh::toSurface(double x, double y) const {
+  return glm::normalize(mMiddlePoint + mMaxDist * x * mEast + mMaxDist * y * mNorth) * mRadii[0];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double PolygonMesh::getHeightOverPlane(glm::dvec3 const& point, double height) const {
+  return height - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, point) - 1) *
+                      glm::length(mMiddlePoint2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::measurementtools
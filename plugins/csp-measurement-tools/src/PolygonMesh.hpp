@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_MEASUREMENT_TOOLS_POLYGON_MESH_HPP
+#define CSP_MEASUREMENT_TOOLS_POLYGON_MESH_HPP
+
+#include "voronoi/Triangulator.hpp"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace csp::measurementtools {
+
+/// Creates a Delaunay-mesh for a polygon on the surface of a body and computes the area and volume
+/// of the polygon with it. This is used by the PolygonTool on a worker thread. The surface of a
+/// body may only be accessed from the main thread, therefore all heights are requested with a
+/// HeightSampler. The heights are requested in a few large batches: one for the corners of the
+/// polygon, one for each refinement attempt and two for the final volume computation.
+class PolygonMesh {
+ public:
+  /// Returns the surface heights in meters for the given coordinates in the Geographic
+  /// Coordinate System format. This may block until the heights are available. If it returns
+  /// std::nullopt, the computation is aborted.
+  using HeightSampler =
+      std::function<std::optional<std::vector<double>>(std::vector<glm::dvec2> const& lngLats)>;
+
+  /// These are the settings of the PolygonTool which control the refinement of the mesh.
+  struct Parameters {
+    float    mHeightDiff  = 1.002F;
+    uint32_t mMaxAttempt  = 10;
+    uint32_t mMaxPoints   = 1000;
+    uint32_t mSleekness   = 15;
+    double   mHeightScale = 1.0;
+
+    /// The algorithm used for all Delaunay triangulations of the mesh.
+    Triangulator::Type mTriangulator = Triangulator::Type::eVoronoi;
+  };
+
+  struct Result {
+    /// This is true if the polygon is larger than one hemisphere. No mesh is created in this case.
+    bool mIsTooLarge = false;
+
+    double mArea      = 0.0;
+    double mPosVolume = 0.0;
+    double mNegVolume = 0.0;
+
+    /// The edges of the mesh as pairs of Cartesian positions on the (height-scaled) surface.
+    std::vector<glm::dvec3> mTriangulation;
+  };
+
+  PolygonMesh(Parameters const& parameters, HeightSampler sampler);
+
+  /// Computes the mesh for the given corners. These are the Cartesian positions of the polygon's
+  /// marks, center is their average. Returns std::nullopt if the computation has been aborted by
+  /// the HeightSampler, if there are less than three points or if the points cannot be projected
+  /// to the mesh plane.
+  std::optional<Result> compute(
+      std::vector<glm::dvec3> const& points, glm::dvec3 const& center, glm::dvec3 const& radii);
+
+ private:
+  /// A triangle of the original Delaunay-mesh together with its refined triangulation.
+  struct Cell {
+    bool                  mRefine{};
+    std::vector<Edge2>    mEdges;
+    std::vector<Triangle> mTriangles;
+  };
+
+  /// Finds the intersection point between two sites
+  static bool findIntersection(Site const& s1, Site const& s2, Site const& s3, Site const& s4,
+      double& intersectionX, double& intersectionY);
+
+  /// Returns the weighted average (i * first + (j - i) * second) / j of the sites of the edge
+  static glm::dvec2 getEdgePoint(Edge2 const& edge, int i, int j);
+
+  /// Creates a Delaunay-mesh and corrects it to match the original polygon
+  /// (especially for concave polygons)
+  void createMesh(std::vector<Triangle>& triangles);
+  /// Checks sleekness of a triangle from the original Delaunay-mesh and its subtriangles
+  /// If a triangle is too sleek, divides it
+  /// Returns true if a lot of new points are added
+  bool checkSleekness(int count);
+  /// Adds the coordinates of the points which are checked by refineMesh() for the given edge
+  void addRefinementPoints(Edge2 const& edge, std::vector<glm::dvec2>& lngLats) const;
+  /// Refines mesh based on edge length and terrain. The heights of the points added by
+  /// addRefinementPoints() start at the given offset
+  void refineMesh(Edge2 const& edge, int count, double h1, double h2,
+      std::vector<double> const& heights, size_t offset, bool& fine);
+  /// Calculates triangle areas and prism volumes. Returns false if the computation was aborted
+  bool calculateAreaAndVolume(
+      std::vector<Triangle> const& triangles, double& area, double& pvol, double& nvol);
+  // Checks if point is inside of the polygon or not
+  bool checkPoint(glm::dvec2 const& point);
+
+  /// Projects a point of the Voronoi plane to the planet's surface (without height)
+  glm::dvec3 toSurface(double x, double y) const;
+  /// Height of a point over the least squares plane
+  double getHeightOverPlane(glm::dvec3 const& point, double height) const;
+
+  Parameters    mParameters;
+  HeightSampler mSampler;
+
+  glm::dvec3 mRadii   = glm::dvec3(1.0);
+  double     mMaxDist = 1.0;
+  glm::dvec3 mEast    = glm::dvec3(0.0);
+  glm::dvec3 mNorth   = glm::dvec3(0.0);
+
+  // For Delaunay-mesh
+  std::vector<Site>              mCorners;
+  std::vector<std::vector<Site>> mCornersFine;
+  glm::dvec3                     mNormal      = glm::dvec3(0.0);
+  glm::dvec3                     mMiddlePoint = glm::dvec3(0.0);
+
+  // For volume calculation
+  double     mOffset{};
+  glm::dvec3 mNormal2      = glm::dvec3(0.0);
+  glm::dvec3 mMiddlePoint2 = glm::dvec3(0.0);
+};
+
+} // namespace csp::measurementtools
+
+#endif // CSP_MEASUREMENT_TOOLS_POLYGON_MESH_HPP
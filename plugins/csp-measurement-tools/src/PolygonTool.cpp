@@ -18,8 +18,6 @@
 
 #include "../../csl-tools/src/DeletableMark.hpp"
 
-#include "logger.hpp"
-
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
 #include <VistaKernel/GraphicsManager/VistaTransformNode.h>
@@ -37,16 +35,20 @@ const int PolygonTool::NUM_SAMPLES = 256;
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 const char* PolygonTool::SHADER_VERT = R"(
-#version 330
+#version 430
 
-layout(location=0) in vec3 iPosition;
+layout(location=0) in vec3 iPositionHigh;
+layout(location=1) in vec3 iPositionLow;
 
 uniform mat4 uMatModelView;
 uniform mat4 uMatProjection;
 
+RELATIVE_TO_EYE_SNIPPET
+
 void main()
 {
-    vec4 pos    = uMatModelView * vec4(iPosition, 1.0);
+    vec3 position = relativeToEye(iPositionHigh, iPositionLow);
+    vec4 pos      = uMatModelView * vec4(position, 1.0);
     gl_Position = uMatProjection * pos;
 }
 )";
@@ -79,10 +81,16 @@ PolygonTool::PolygonTool(std::shared_ptr<cs::core::InputManager> pInputManager,
           "file://{toolZoom}../share/resources/gui/polygon.html")) {
 
   // Create the shader
-  mShader.InitVertexShaderFromString(SHADER_VERT);
+  std::string sVert(SHADER_VERT);
+  cs::utils::replaceString(
+      sVert, "RELATIVE_TO_EYE_SNIPPET", cs::scene::RelativeToEye::getShaderSnippet());
+
+  mShader.InitVertexShaderFromString(sVert);
   mShader.InitFragmentShaderFromString(SHADER_FRAG);
   mShader.Link();
 
+  mRelativeToEye.init(&mShader);
+
   mUniforms.modelViewMatrix  = mShader.GetUniformLocation("uMatModelView");
   mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
   mUniforms.color            = mShader.GetUniformLocation("uColor");
@@ -152,6 +160,18 @@ PolygonTool::PolygonTool(std::shared_ptr<cs::core::InputManager> pInputManager,
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 PolygonTool::~PolygonTool() {
+  // Aborts a running mesh computation, it may be waiting for heights.
+  {
+    std::unique_lock<std::mutex> lock(mHeightMutex);
+    mCancelCalculation = true;
+  }
+
+  mHeightCondition.notify_all();
+
+  if (mPendingMesh.valid()) {
+    mPendingMesh.wait();
+  }
+
   mSettings->mGraphics.pHeightScale.disconnect(mScaleConnection);
   mGuiItem->unregisterCallback("deleteMe");
   mGuiItem->unregisterCallback("setAddPointMode");
@@ -202,6 +222,15 @@ void PolygonTool::setSleekness(uint32_t degree) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void PolygonTool::setTriangulator(Triangulator::Type type) {
+  if (mTriangulator != type) {
+    mTriangulator  = type;
+    mVerticesDirty = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 glm::dvec4 PolygonTool::getInterpolatedPosBetweenTwoMarks(
     std::shared_ptr<cs::scene::CelestialSurface> const& surface,
     csl::tools::DeletableMark const& l0, csl::tools::DeletableMark const& l1, double value) {
@@ -224,729 +253,6 @@ glm::dvec4 PolygonTool::getInterpolatedPosBetweenTwoMarks(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Based on
-// https://stackoverflow.com/questions/8721406/how-to-determine-if-a-point-is-inside-a-2d-convex-polygon
-bool PolygonTool::checkPoint(glm::dvec2 const& point) {
-  bool result = false;
-
-  // Positive x (other directions could be compared, but it works reliable with only one direction)
-  for (size_t i = 0, j = mCorners.size() - 1; i < mCorners.size(); j = i++) {
-    if (((mCorners[i].mY > point.y) != (mCorners[j].mY > point.y) &&
-            (point.x < (mCorners[j].mX - mCorners[i].mX) * (point.y - mCorners[i].mY) /
-                               (mCorners[j].mY - mCorners[i].mY) +
-                           mCorners[i].mX)) ||
-        // Checks surroundings to avoid numerical errors
-        ((mCorners[i].mY > point.y) != (mCorners[j].mY > point.y) &&
-            std::abs(point.x - ((mCorners[j].mX - mCorners[i].mX) * (point.y - mCorners[i].mY) /
-                                       (mCorners[j].mY - mCorners[i].mY) +
-                                   mCorners[i].mX)) < 0.001)) {
-      result = !result;
-    }
-  }
-  return result;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-bool PolygonTool::findIntersection(Site const& s1, Site const& s2, Site const& s3, Site const& s4,
-    double& intersectionX, double& intersectionY) {
-  // Avoids division with 0
-  if ((s1.mX == 0) || (s2.mX == 0) || (s3.mX == 0) || (s4.mX == 0) || (s1.mY == 0) ||
-      (s2.mY == 0) || (s3.mY == 0) || (s4.mY == 0)) {
-    return false;
-  }
-
-  // Based on
-  // http://www.softwareandfinance.com/Visual_CPP/VCPP_Intersection_Two_lines_EndPoints.html
-
-  // Safety band - to avoid point duplications - set to 1%
-  double safety = 0.01;
-
-  double m1{};
-  double m2{};
-  double c1{};
-  double c2{};
-
-  // Line 1 (y = m1 * x + c1)
-  m1 = (s2.mY - s1.mY) / (s2.mX - s1.mX);
-  c1 = s1.mY - m1 * s1.mX;
-
-  // Line 2 (y = m2 * x + c2)
-  m2 = (s4.mY - s3.mY) / (s4.mX - s3.mX);
-  c2 = s3.mY - m2 * s3.mX;
-
-  // Edges are not exactly parallel
-  if (m1 != m2) {
-    // Intersection of lines
-    intersectionX = (c2 - c1) / (m1 - m2);
-    intersectionY = m1 * (intersectionX) + c1;
-
-    // Checks if intersection point is on the edges or not (between a bounding box)
-    if (((s1.mX > intersectionX) != (s2.mX > intersectionX)) &&
-        ((s3.mX > intersectionX) != (s4.mX > intersectionX)) &&
-        ((s1.mY > intersectionY) != (s2.mY > intersectionY)) &&
-        ((s3.mY > intersectionY) != (s4.mY > intersectionY))) {
-      // Checks all 4 points: do not return with an intersection point within the safety band
-      if (((std::abs((s1.mX - intersectionX) / s1.mX) > safety) ||
-              (std::abs((s1.mY - intersectionY) / s1.mY) > safety)) &&
-          ((std::abs((s2.mX - intersectionX) / s2.mX) > safety) ||
-              (std::abs((s2.mY - intersectionY) / s2.mY) > safety)) &&
-          ((std::abs((s3.mX - intersectionX) / s3.mX) > safety) ||
-              (std::abs((s3.mY - intersectionY) / s3.mY) > safety)) &&
-          ((std::abs((s4.mX - intersectionX) / s4.mX) > safety) ||
-              (std::abs((s4.mY - intersectionY) / s4.mY) > safety))) {
-        return true;
-      }
-    }
-  }
-  return false;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void PolygonTool::createMesh(std::vector<Triangle>& triangles) {
-  bool edgesOK = false;
-  int  it      = 0;
-
-  // Does the triangulaiton of the original polygon
-  // Checks and refines the triangulation until all original edges of the polygon are in the
-  // triangulation Quits after 5 iteration to avoid performance issues and displays error message
-  while (!edgesOK && it < 5) {
-    it++;
-
-    // Performs the Delaunay triangulation
-    VoronoiGenerator voronoi;
-    voronoi.parse(mCorners);
-
-    // Number of the original edges of the polygon
-    size_t countEdges = mCorners.size();
-
-    // Vector of the original edges of the polygon from Delaunay triangulation
-    std::vector<Edge2> voronoiEdges;
-
-    for (auto const& s : voronoi.getTriangulation()) {
-      // Finds original edges based on their addresses
-      if (((std::abs(s.second.mAddr - s.first.mAddr) == 1 ||
-               (std::abs(s.second.mAddr - s.first.mAddr) == mCorners.size() - 1)) &&
-              s.first.mAddr < mCorners.size() && s.second.mAddr < mCorners.size())) {
-        // Counts found edges
-        countEdges--;
-
-        Site site1(0, 0, 0);
-        Site site2(0, 0, 0);
-
-        // Orders addresses of the found edge
-        if (((s.first.mAddr == mCorners.size() - 1) && (s.second.mAddr == 0)) ||
-            ((s.second.mAddr > s.first.mAddr) &&
-                !((s.first.mAddr == 0) && (s.second.mAddr == mCorners.size() - 1)))) {
-          site1 = s.first;
-          site2 = s.second;
-        } else {
-          site1 = s.second;
-          site2 = s.first;
-        }
-        // Saves edges of the triangulation
-        voronoiEdges.emplace_back(site1, site2);
-      }
-    }
-
-    // If some of the polygon edges did not match with a voronoi edge
-    // This means, that some edges are missing, and need to be recovered
-    // Intersection points of the missing edges and voronoi edges need to determined
-    // These points are added to mCorners, and the triangulation hopefully
-    // solves the problem in the next cycle (works for most of the cases)
-    if (countEdges != 0) {
-      // Vector of corners on missing edges - to be added to mCorners
-      std::vector<Site> addCorners;
-
-      // Finds the missing edges: search for every original edge in voronoiEdges
-      // (the original polygon edges have neighbor addresses -> searches for corners)
-      for (size_t i = 0; i < mCorners.size(); i++) {
-        bool       found = false;
-        glm::ivec2 missingAddr;
-
-        // In case of the last line of the polygon
-        if (i == (mCorners.size() - 1)) {
-          for (auto const& v : voronoiEdges) {
-            if ((v.first.mAddr == i) && (v.second.mAddr == 0)) {
-              found = true;
-            }
-          }
-
-          if (!found) {
-            missingAddr = glm::ivec2(i, 0);
-          }
-        }
-        // Every other line
-        else {
-          for (auto const& v : voronoiEdges) {
-            if ((v.first.mAddr == i) && (v.second.mAddr == i + 1)) {
-              found = true;
-            }
-          }
-          if (!found) {
-            missingAddr = glm::ivec2(i, i + 1);
-          }
-        }
-
-        // If this edge is missing
-        if (!found) {
-          // Points of the missing edge
-          Site              site1(0, 0, 0);
-          Site              site2(0, 0, 0);
-          std::vector<Site> sites;
-
-          // Pairs the known addresses of the missing edge with sites
-          for (auto const& s : voronoi.getTriangulation()) {
-            if (s.first.mAddr == missingAddr.x) {
-              site1 = s.first;
-            }
-            if (s.second.mAddr == missingAddr.x) {
-              site1 = s.second;
-            }
-
-            if (s.first.mAddr == missingAddr.y) {
-              site2 = s.first;
-            }
-            if (s.second.mAddr == missingAddr.y) {
-              site2 = s.second;
-            }
-          }
-
-          // Finds intersecting edges (if a triangulation edge intersects the original polygon edge,
-          // it is wrong)
-          for (auto const& s : voronoi.getTriangulation()) {
-            double intersectionX{};
-            double intersectionY{};
-
-            if (findIntersection(site1, site2, s.first, s.second, intersectionX, intersectionY)) {
-              int addrNew =
-                  site1.mAddr + 1; // = site2.mAddr (except for the last edge, where site2.mAddr=0!
-              Site oldCorner(0, 0, 0);
-              bool done = false;
-
-              // Cycles through addCorners vector and saves current intersection into the right
-              // place
-              for (auto& addCorner : addCorners) {
-                // If current intersection is not saved yet
-                if (!done) {
-                  // Compares addresses of the two intersection
-                  if (addCorner.mAddr < addrNew) {
-                    // Skips first elements of vector
-                  } else if (addCorner.mAddr == addrNew) {
-                    // If edges points to positive x
-                    if (intersectionX > site1.mX) {
-                      // Saves intersection only when it is in front of the
-                      // existing intersection; otherwise it will be handled
-                      // in the next cycle
-                      if (addCorner.mX > intersectionX) {
-                        // Saves existing intersection to oldCorner
-                        // will be placed back to vector in the next cycle
-                        oldCorner = addCorner;
-                        addCorner = Site(intersectionX, intersectionY, addrNew);
-                        done      = true;
-                      }
-                    }
-                    // If edges points to negative x
-                    else if (intersectionX < site1.mX) {
-                      if (addCorner.mX < intersectionX) {
-                        oldCorner = addCorner;
-                        addCorner = Site(intersectionX, intersectionY, addrNew);
-                        done      = true;
-                      }
-                    }
-                    // Handles the very rare case of a vertical edge
-                    // Does the same, as before, just now with y coordinates
-                    else if (intersectionX == site1.mX) {
-                      if (intersectionY > site1.mY) {
-                        if (addCorner.mY > intersectionY) {
-                          oldCorner = addCorner;
-                          addCorner = Site(intersectionX, intersectionY, addrNew);
-                          done      = true;
-                        }
-                      } else if (intersectionY < site1.mY) {
-                        if (addCorner.mY < intersectionY) {
-                          oldCorner = addCorner;
-                          addCorner = Site(intersectionX, intersectionY, addrNew);
-                          done      = true;
-                        }
-                      }
-                    } // if (intersectionX==s.first.mX)
-                  }   // if (addCorners[i].mAddr == addrNew)
-                  // if (addCorners[i].mAddr > addrNew)
-                  else {
-                    oldCorner = addCorner;
-                    addCorner = Site(intersectionX, intersectionY, addrNew);
-                    done      = true;
-                  }
-                } // if (!done)
-                else {
-                  // After the current intersecting point is added to the middle of the vector
-                  // shifts back every other element by one position
-                  Site newCorner = addCorner;
-                  addCorner      = oldCorner;
-                  oldCorner      = newCorner;
-                }
-              } // for (int i = 0; i < addCorners.size(); i++)
-
-              // If the current intersection was placed in the vector
-              if (done) {
-                // Emplaces the last element to the end of the vector
-                addCorners.emplace_back(oldCorner);
-              } else {
-                // Emplaces back current intersection to the end of the vector
-                addCorners.emplace_back(Site(intersectionX, intersectionY, addrNew));
-              }
-
-              // Corners needed to be added -> run the cycle again
-              edgesOK = false;
-            } // if (findIntersection(...))
-          }   // for (auto const& s : triangulation)
-        }     // if (!found)
-      }       // for (int i = 0; i < mCorners.size(); i++)
-
-      // Counts the intersection corners already added to mCorners
-      int cornerCount = 0;
-
-      // Goes through the intersection corners and adds them to the right place of mCorners
-      for (auto const& c : addCorners) {
-        // Address of the intersection if it is the only one in the vector
-        int addr3 = c.mAddr;
-        addr3 += cornerCount;
-
-        // If intersection is not between last and first Site
-        if (addr3 < static_cast<int>(mCorners.size())) {
-          // Saves intersection corner to mCorners and element of mCorners to oldSite
-          Site oldSite    = mCorners[addr3];
-          mCorners[addr3] = Site(c.mX, c.mY, addr3);
-
-          addr3++;
-
-          // Shifts every other corner of mCorners behind by one
-          for (; addr3 < static_cast<int>(mCorners.size()); addr3++) {
-            Site newSite    = mCorners[addr3];
-            mCorners[addr3] = Site(oldSite.mX, oldSite.mY, addr3);
-            oldSite         = newSite;
-          }
-
-          // Emplaces back the last corner
-          mCorners.emplace_back(Site(oldSite.mX, oldSite.mY, addr3));
-        } else {
-          // Emplaces back the intersection corner
-          mCorners.emplace_back(Site(c.mX, c.mY, addr3));
-        }
-
-        cornerCount++;
-      }
-    } // if (countEdges != 0)
-    else {
-      // All of the original edges are in voronoiEdges -> no need for an other cycle
-      edgesOK = true;
-    }
-    // Saves the original triangles
-    triangles = voronoi.getTriangles();
-  } // while (!edgesOK && it < 5)
-
-  // If the voronoi edges are still wrong after 5 cycles of refinement, display the problem
-  if (!edgesOK) {
-    logger().warn("Area calculation can be false: Concave or self-intersecting polygon! Check "
-                  "triangulation mesh.");
-  }
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-bool PolygonTool::checkSleekness(int count) {
-  // Voronoi inside the original triangles - to check triangle angles
-  VoronoiGenerator voronoiCheck;
-  voronoiCheck.parse(mCornersFine[count]);
-
-  // Vector to save addresses of added points - to avoid adding the same point twice
-  std::vector<std::pair<int, int>> addedPoints;
-
-  // Checks triangle sleekness and add middle points to vector if they are too sleek
-  // Could be done in multiple iterations for a more precise result
-  for (auto const& t2 : voronoiCheck.getTriangles()) {
-    // Minimun angle criteria (for 2 simple cases, approximately correct in general)
-    float minAngle = mSleekness * glm::pi<float>() / 180;
-    // Ratio of two edges in triangle
-    float sleekness1 = 1 / std::sin(minAngle);
-    // Ration between the sum of 2 smaller edges and the long edge in triangle
-    float sleekness2 = 1 / std::cos(minAngle);
-
-    Site si1(0, 0, 0);
-    Site si2(0, 0, 0);
-    Site si3(0, 0, 0);
-    std::tie(si1, si2, si3) = t2;
-
-    // Length of the edges
-    double length1 = glm::length(glm::dvec2(si1.mX, si1.mY) - glm::dvec2(si2.mX, si2.mY));
-    double length2 = glm::length(glm::dvec2(si1.mX, si1.mY) - glm::dvec2(si3.mX, si3.mY));
-    double length3 = glm::length(glm::dvec2(si2.mX, si2.mY) - glm::dvec2(si3.mX, si3.mY));
-
-    // Edge 1 is too long compared to the others
-    if ((length2 * sleekness1 < length1) || (length3 * sleekness1 < length1) ||
-        (length2 + length3 < length1 * sleekness2)) {
-      bool addPoint = true;
-      // Checks previously added points if they are the same
-      for (auto const& addr : addedPoints) {
-        if (((addr.first == si1.mAddr) && (addr.second == si2.mAddr)) ||
-            ((addr.first == si2.mAddr) && (addr.second == si1.mAddr))) {
-          addPoint = false;
-        }
-      }
-      // If not, adds this point to vector
-      if (addPoint) {
-        mCornersFine[count].emplace_back((si1.mX + si2.mX) / 2, (si1.mY + si2.mY) / 2,
-            static_cast<uint16_t>(mCornersFine[count].size()));
-        addedPoints.emplace_back(si1.mAddr, si2.mAddr);
-      }
-    }
-
-    // Edge 2 is too long compared to the others
-    if ((length1 * sleekness1 < length2) || (length3 * sleekness1 < length2) ||
-        (length1 + length3 < length2 * sleekness2)) {
-      bool addPoint = true;
-      for (auto const& addr : addedPoints) {
-        if (((addr.first == si1.mAddr) && (addr.second == si3.mAddr)) ||
-            ((addr.first == si3.mAddr) && (addr.second == si1.mAddr))) {
-          addPoint = false;
-        }
-      }
-      if (addPoint) {
-        mCornersFine[count].emplace_back((si1.mX + si3.mX) / 2, (si1.mY + si3.mY) / 2,
-            static_cast<uint16_t>(mCornersFine[count].size()));
-        addedPoints.emplace_back(si1.mAddr, si3.mAddr);
-      }
-    }
-
-    // Edge 3 is too long compared to the others
-    if ((length1 * sleekness1 < length3) || (length2 * sleekness1 < length3) ||
-        (length1 + length2 < length3 * sleekness2)) {
-      bool addPoint = true;
-      for (auto const& addr : addedPoints) {
-        if (((addr.first == si2.mAddr) && (addr.second == si3.mAddr)) ||
-            ((addr.first == si3.mAddr) && (addr.second == si2.mAddr))) {
-          addPoint = false;
-        }
-      }
-      if (addPoint) {
-        mCornersFine[count].emplace_back((si2.mX + si3.mX) / 2, (si2.mY + si3.mY) / 2,
-            static_cast<uint16_t>(mCornersFine[count].size()));
-        addedPoints.emplace_back(si2.mAddr, si3.mAddr);
-      }
-    }
-  }
-
-  return addedPoints.size() >
-         1.5 * static_cast<double>(mCornersFine[count].size() - addedPoints.size());
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void PolygonTool::displayMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-    Edge2 const& edge, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-    glm::dvec3 const& radii, double scale, double& h1, double& h2) {
-  // Cartesian coordinates without height
-  glm::dvec3 p1 =
-      glm::normalize(mMiddlePoint + mdist * edge.first.mX * e + mdist * edge.first.mY * n) *
-      radii[0];
-  glm::dvec3 p2 =
-      glm::normalize(mMiddlePoint + mdist * edge.second.mX * e + mdist * edge.second.mY * n) *
-      radii[0];
-
-  // LongLat coordinates
-  glm::dvec2 l1 = cs::utils::convert::cartesianToLngLat(p1, radii);
-  glm::dvec2 l2 = cs::utils::convert::cartesianToLngLat(p2, radii);
-
-  // Heights of the points
-  h1 = surface ? surface->getHeight(l1.xy()) : 0.0;
-  h2 = surface ? surface->getHeight(l2.xy()) : 0.0;
-
-  // Cartesian coordinates with height
-  glm::dvec3 r1 = cs::utils::convert::toCartesian(l1, radii, h1 * scale);
-  glm::dvec3 r2 = cs::utils::convert::toCartesian(l2, radii, h2 * scale);
-
-  // Emplaces back points in Cartesian (on planet surface) for display
-  mTriangulation.emplace_back(r1);
-  mTriangulation.emplace_back(r2);
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void PolygonTool::refineMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-    Edge2 const& edge, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-    glm::dvec3 const& radii, int count, double h1, double h2, bool& fine) {
-
-  // Middle point of the edge on voronoi plane
-  glm::dvec2 avgPoint2 =
-      glm::dvec2((edge.first.mX + edge.second.mX) / 2, (edge.first.mY + edge.second.mY) / 2);
-  // Middle point on planet´s surface
-  glm::dvec3 pAvg =
-      glm::normalize(mMiddlePoint + mdist * avgPoint2.x * e + mdist * avgPoint2.y * n) * radii[0];
-
-  // Heights of the points over see level
-  double hAvg =
-      surface ? surface->getHeight(cs::utils::convert::cartesianToLngLat(pAvg, radii)) : 0.0;
-
-  // Checks height of the middle point
-  if ((hAvg / ((h1 + h2) / 2) > mHeightDiff) || (((h1 + h2) / 2) / hAvg > mHeightDiff)) {
-    mCornersFine[count].emplace_back(
-        avgPoint2.x, avgPoint2.y, static_cast<uint16_t>(mCornersFine[count].size()));
-    fine = false;
-  }
-  // Checks height of other points between the two Sites
-  else {
-    // Trisecting points, etc.
-    for (int j = 3; j < 6; j++) {
-      // Checks "level" only if no points were emplaced back form the previous cycle
-      if (fine) {
-        for (int i = 1; i < j; i++) {
-          // Point
-          glm::dvec2 avgPoint3 = glm::dvec2((i * edge.first.mX + (j - i) * edge.second.mX) / j,
-              (i * edge.first.mY + (j - i) * edge.second.mY) / j);
-          // Cartesian coordinate of the point
-          glm::dvec3 cAvg3 =
-              glm::normalize(mMiddlePoint + mdist * avgPoint3.x * e + mdist * avgPoint3.y * n) *
-              radii[0];
-          // Height of the point
-          double heAvg3 =
-              surface ? surface->getHeight(cs::utils::convert::cartesianToLngLat(cAvg3, radii))
-                      : 0.0;
-
-          if ((heAvg3 / ((i * h1 + (j - i) * h2) / j) > mHeightDiff) ||
-              (((i * h1 + (j - i) * h2) / j) / heAvg3 > mHeightDiff)) {
-            mCornersFine[count].emplace_back(
-                avgPoint3.x, avgPoint3.y, static_cast<uint16_t>(mCornersFine[count].size()));
-            fine = false;
-          }
-        }
-      }
-    }
-  }
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void PolygonTool::calculateAreaAndVolume(
-    std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-    std::vector<Triangle> const& triangles, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-    glm::dvec3 const& radii, double& area, double& pvol, double& nvol) {
-  // Counts area and volume in every triangle
-  for (const auto& triangle : triangles) {
-    // ------------------------------------------ AREA ------------------------------------------
-    Site si1(0, 0, 0);
-    Site si2(0, 0, 0);
-    Site si3(0, 0, 0);
-    std::tie(si1, si2, si3) = triangle;
-
-    // Cartesian coordinates without height
-    glm::dvec3 p1 =
-        glm::normalize(mMiddlePoint + mdist * si1.mX * e + mdist * si1.mY * n) * radii[0];
-    glm::dvec3 p2 =
-        glm::normalize(mMiddlePoint + mdist * si2.mX * e + mdist * si2.mY * n) * radii[0];
-    glm::dvec3 p3 =
-        glm::normalize(mMiddlePoint + mdist * si3.mX * e + mdist * si3.mY * n) * radii[0];
-
-    // LongLat coordinates
-    glm::dvec2 l1 = cs::utils::convert::cartesianToLngLat(p1, radii);
-    glm::dvec2 l2 = cs::utils::convert::cartesianToLngLat(p2, radii);
-    glm::dvec2 l3 = cs::utils::convert::cartesianToLngLat(p3, radii);
-
-    // Heights of the points
-    double h1 = surface ? surface->getHeight(l1) : 0.0;
-    double h2 = surface ? surface->getHeight(l2) : 0.0;
-    double h3 = surface ? surface->getHeight(l3) : 0.0;
-
-    // Cartesian coordinates with height
-    glm::dvec3 r1 = cs::utils::convert::toCartesian(l1, radii, h1);
-    glm::dvec3 r2 = cs::utils::convert::toCartesian(l2, radii, h2);
-    glm::dvec3 r3 = cs::utils::convert::toCartesian(l3, radii, h3);
-
-    // Area is the half of the cross product of two edges in triangle
-    area += glm::length(glm::cross(r2 - r1, r3 - r1)) / 2;
-
-    // ----------------------------------------- Volume -----------------------------------------
-
-    // Heights over the least squares plane
-    double hl1 = h1 - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, p1) - 1) *
-                          glm::length(mMiddlePoint2);
-    double hl2 = h2 - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, p2) - 1) *
-                          glm::length(mMiddlePoint2);
-    double hl3 = h3 - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, p3) - 1) *
-                          glm::length(mMiddlePoint2);
-
-    double baseArea1 = 0;
-    double baseArea2 = 0;
-    double volume    = 0;
-
-    // If all of the triangle's corners' are on the same size of the least square plane
-    if (((hl1 > 0) && (hl2 > 0) && (hl3 > 0)) || ((hl1 < 0) && (hl2 < 0) && (hl3 < 0))) {
-      // Base area: planet surface without heights / least square plane
-      baseArea1 = glm::length(glm::cross(p2 - p1, p3 - p1)) / 2;
-      // Volume is the multiplication of surface and average height over the plane
-      volume = baseArea1 * ((hl1 + hl2 + hl3) / 3);
-
-      // Counts positive and negative volumes separately
-      if (volume > 0) {
-        pvol += volume;
-      } else {
-        nvol += volume;
-      }
-    }
-    // If not: find intersection points with the least square plane
-    // If 2 intersection points are found:
-    // Split the triangle into a smaller triangle and a quadrilateral
-    else {
-      auto   pM1    = glm::dvec3(0.0);
-      auto   pM2    = glm::dvec3(0.0);
-      auto   pM3    = glm::dvec3(0.0);
-      auto   pM     = glm::dvec3(0.0);
-      auto   pMOld  = glm::dvec3(0.0);
-      auto   lM     = glm::dvec2(0.0);
-      double hM     = 0;
-      double hlM    = 0;
-      double hlMOld = 0;
-      bool   b1     = false;
-      bool   b2     = false;
-      bool   b3     = false;
-
-      // Resolution of edge sampling
-      int    res  = 32;
-      double frac = 0;
-
-      // If the two points are on the other side of the plane
-      if ((hl1 > 0) != (hl2 > 0)) {
-        // Samples of edge to find the intersection point between edge and plane
-        // (Does not consider multiple intersection points (f.eg.: mountains in triangle)
-        // They have been mostly eliminated with triangulation
-        for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
-          // Point coordinate without height
-          pM = glm::normalize((1 - frac) * p1 + frac * p2) * radii[0];
-
-          // LongLat
-          lM = cs::utils::convert::cartesianToLngLat(pM, radii);
-          // Height
-          hM = surface ? surface->getHeight(lM) : 0.0;
-          // Height over least square plane
-          hlM = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
-                         glm::length(mMiddlePoint2);
-          // If intersection is between this and previous sample point
-          // Interpolate between this and previous point and end loop
-          if ((hl1 > 0) != (hlM > 0)) {
-            pM1 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
-            // To quit loop
-            i  = res;
-            b1 = true;
-          } else {
-            // Save values for the next cycle
-            pMOld  = pM;
-            hlMOld = hlM;
-          }
-        }
-      }
-
-      if ((hl1 > 0) != (hl3 > 0)) {
-        for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
-          pM   = glm::normalize((1 - frac) * p1 + frac * p3) * radii[0];
-          lM   = cs::utils::convert::cartesianToLngLat(pM, radii);
-          hM   = surface ? surface->getHeight(lM) : 0.0;
-          hlM  = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
-                         glm::length(mMiddlePoint2);
-          if ((hl1 > 0) != (hlM > 0)) {
-            pM2 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
-            i   = res;
-            b2  = true;
-          } else {
-            pMOld  = pM;
-            hlMOld = hlM;
-          }
-        }
-      }
-
-      if ((hl2 > 0) != (hl3 > 0)) {
-        for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
-          pM   = glm::normalize((1 - frac) * p2 + frac * p3) * radii[0];
-          lM   = cs::utils::convert::cartesianToLngLat(pM, radii);
-          hM   = surface ? surface->getHeight(lM) : 0.0;
-          hlM  = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
-                         glm::length(mMiddlePoint2);
-          if ((hl2 > 0) != (hlM > 0)) {
-            pM3 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
-            i   = res;
-            b3  = true;
-          } else {
-            pMOld  = pM;
-            hlMOld = hlM;
-          }
-        }
-      }
-
-      // If the first two edges have an intersection point with the plane
-      if ((b1 == 1) && (b2 == 1) && (b3 == 0)) {
-        // Area of the smaller triangle
-        baseArea1 = glm::length(glm::cross(pM1 - p1, pM2 - p1)) / 2;
-        // Area of the quadrilateral
-        baseArea2 = glm::length(glm::cross(pM1 - p3, pM2 - p3)) / 2 +
-                    glm::length(glm::cross(pM1 - p2, p3 - p2)) / 2;
-
-        // Decide the sign of the volume based on the
-        // height of the corner in the small triangle
-        // (Heights of intersections are considered to be 0)
-        if (hl1 > 0) {
-          // Add volumes
-          pvol += baseArea1 * hl1 / 3;
-          nvol += baseArea2 * ((hl2 + hl3) / 4);
-        } else {
-          nvol += baseArea1 * hl1 / 3;
-          pvol += baseArea2 * ((hl2 + hl3) / 4);
-        }
-      } else if ((b1 == 1) && (b2 == 0) && (b3 == 1)) {
-        baseArea1 = glm::length(glm::cross(pM1 - p2, pM3 - p2)) / 2;
-        baseArea2 = glm::length(glm::cross(pM1 - p1, pM3 - p1)) / 2 +
-                    glm::length(glm::cross(pM3 - p3, p1 - p3)) / 2;
-
-        if (hl2 > 0) {
-          pvol += baseArea1 * hl2 / 3;
-          nvol += baseArea2 * ((hl1 + hl3) / 4);
-        } else {
-          nvol += baseArea1 * hl2 / 3;
-          pvol += baseArea2 * ((hl1 + hl3) / 4);
-        }
-      } else if ((b1 == 0) && (b2 == 1) && (b3 == 1)) {
-        baseArea1 = glm::length(glm::cross(pM3 - p3, pM2 - p3)) / 2;
-        baseArea2 = glm::length(glm::cross(pM2 - p2, pM3 - p2)) / 2 +
-                    glm::length(glm::cross(pM2 - p1, p2 - p1)) / 2;
-
-        if (hl3 > 0) {
-          pvol += baseArea1 * hl3 / 3;
-          nvol += baseArea2 * ((hl1 + hl2) / 4);
-        } else {
-          nvol += baseArea1 * hl3 / 3;
-          pvol += baseArea2 * ((hl1 + hl2) / 4);
-        }
-      }
-      // If more or fewer as 2 intersection points are found
-      // Calculate volume without spliting the triangle (as in the first case)
-      else {
-        baseArea1 = glm::length(glm::cross(p2 - p1, p3 - p1)) / 2;
-        volume    = baseArea1 * ((hl1 + hl2 + hl3) / 3);
-
-        if (volume > 0) {
-          pvol += volume;
-        } else {
-          nvol += volume;
-        }
-      }
-    }
-  }
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 void PolygonTool::onPointMoved() {
   // Return if point is not on planet
   for (auto const& mark : mPoints) {
@@ -1058,280 +364,159 @@ void PolygonTool::updateLineVertices() {
 
   mIndexCount = mSampledPositions.size();
 
-  // Upload new data
-  mVBO.Bind(GL_ARRAY_BUFFER);
-  mVBO.BufferData(mSampledPositions.size() * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
-  mVBO.Release();
-
-  mVAO.EnableAttributeArray(0);
-  mVAO.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, &mVBO);
+  // Upload new data. The vertices are stored in body-fixed coordinates, so they only have to be
+  // written again if the polygon changes.
+  uploadVertices(mSampledPositions, mVAO, mVBO);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Creates a new plane normal to the middle of the polygon and projects the polygon points to
-// this plane and generates a Delaunay-mesh on this plane and calculates the area and volume
-// of the original polygon using this mesh
 void PolygonTool::updateCalculation() {
-  // Returns if no triangle can be created
-  if (mPoints.size() < 3) {
-    return;
-  }
-
-  mCorners.clear();
-  mCornersFine.clear();
-  mTriangulation.clear();
+  if (mPendingMesh.valid()) {
+    sampleRequestedHeights();
 
-  auto       object      = mSolarSystem->getObject(getObjectName());
-  auto       surface     = object->getSurface();
-  double     heightScale = mSettings->mGraphics.pHeightScale.get();
-  glm::dvec3 radii       = object->getRadii();
-
-  // Corrected average position (works for every height scale)
-  glm::dvec3 averagePositionNorm(0.0);
-  for (auto const& mark : mPoints) {
-    glm::dvec3 pos = glm::normalize(mark->getPosition()) * radii[0];
-    // LongLat coordinate
-    glm::dvec2 l = cs::utils::convert::cartesianToLngLat(pos, radii);
-    // Height of the point
-    double h = surface ? surface->getHeight(l) : 0.0;
-    // Cartesian coordinate with height
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
-
-    averagePositionNorm += posNorm / static_cast<double>(mPoints.size());
-  }
-
-  // Longest distance to average position
-  double maxDist = 0;
-  for (auto const& mark : mPoints) {
-    double dist = glm::length(mPosition - mark->getPosition());
-    if (dist > maxDist) {
-      maxDist = dist;
+    if (mPendingMesh.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return;
     }
-  }
 
-  // If polygon is to big (disable area calculation and mesh generation)
-  // Voronoi implementation is designed for a maximal area of one hemisphere
-  if (maxDist > radii[0]) {
-    mGuiItem->callJavascript("setArea", 0);
-    mGuiItem->callJavascript("setVolume", 0, 0);
-    pShowMesh = false;
-    return;
-  }
-  // Converts maxDist to Voronoi plane (approx.)
-  // 1.2 is for safety -> makes sure, that the voronoi coordinates are under 1
-  maxDist = 1.2 * maxDist * radii[0] / (std::sqrt(std::pow(radii[0], 2) - std::pow(maxDist, 2)));
-
-  // Planes normal is perpendicular to the average position
-  mNormal      = glm::normalize(mPosition);
-  mMiddlePoint = mNormal * radii[0];
-  // Coordinate system of the plane
-  glm::dvec3 east(0.0);
-  glm::dvec3 north(0.0);
-
-  if (mNormal.y != 0) {
-    // Normal and north is perpendicular -> dot product is 0
-    double yNorth = (std::pow(mNormal.x, 2) + std::pow(mNormal.z, 2)) / mNormal.y;
-    north         = glm::normalize(glm::dvec3(-mNormal.x, yNorth, -mNormal.z));
-    // Changes south to north on the southern hemisphere
-    if (yNorth < 0) {
-      north = glm::normalize(glm::dvec3(mNormal.x, -yNorth, mNormal.z));
+    auto result = mPendingMesh.get();
+    if (result) {
+      applyCalculation(*result);
     }
-  } else {
-    // If plane normal is perpendicular to y axes, north is y
-    north = glm::dvec3(0, 1, 0);
   }
 
-  east = -glm::cross(mNormal, north);
-
-  // Calculates plane for volume calculation
-  // From DipStrikeTool
-  // Based on http://stackoverflow.com/questions/1400213/3d-least-squares-plane
-  glm::dmat3 mat(0);
-  glm::dvec3 vec(0);
-
-  mNormal2 = glm::normalize(averagePositionNorm);
-  mOffset  = 0.F;
-
-  for (auto const& p : mPoints) {
-    glm::dvec3 pos     = glm::normalize(p->getPosition()) * radii[0];
-    glm::dvec2 l       = cs::utils::convert::cartesianToLngLat(pos, radii);
-    double     h       = surface ? surface->getHeight(l) : 0.0;
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
-
-    glm::dvec3 realtivePosition = posNorm - averagePositionNorm;
-
-    mat[0][0] += realtivePosition.x * realtivePosition.x;
-    mat[1][0] += realtivePosition.x * realtivePosition.y;
-    mat[2][0] += realtivePosition.x;
-    mat[0][1] += realtivePosition.x * realtivePosition.y;
-    mat[1][1] += realtivePosition.y * realtivePosition.y;
-    mat[2][1] += realtivePosition.y;
-    mat[0][2] += realtivePosition.x;
-    mat[1][2] += realtivePosition.y;
-    mat[2][2] += 1;
-
-    vec[0] += realtivePosition.x * realtivePosition.z;
-    vec[1] += realtivePosition.y * realtivePosition.z;
-    vec[2] += realtivePosition.z;
-  }
-
-  glm::dvec3 solution = glm::inverse(mat) * vec;
-  mNormal2            = glm::normalize(glm::dvec3(-solution.x, -solution.y, 1.F));
-
-  if (glm::dot(mNormal, mNormal2) < 0) {
-    mNormal2 = -mNormal2;
+  // Returns if no triangle can be created
+  if (!mCalculationDirty || mPoints.size() < 3) {
+    return;
   }
 
-  mOffset       = solution.z;
-  mMiddlePoint2 = averagePositionNorm + mNormal2 * radii[0] * mOffset;
+  mCalculationDirty = false;
 
-  // Projects points to Voronoi plane and calculates their position in the new coordinate system
-  int        addr = 0;
-  glm::dvec3 lastPosition{0};
+  auto object = mSolarSystem->getObject(getObjectName());
 
+  std::vector<glm::dvec3> points;
   for (auto const& mark : mPoints) {
-    glm::dvec3 currentPosition = mark->getPosition();
-
-    // Filters out double points
-    if (currentPosition != lastPosition) {
-      // Corrects distance from origin (average point is inside of the sphere)
-      double     k   = glm::dot(mNormal, mMiddlePoint) / glm::dot(mNormal, currentPosition);
-      glm::dvec3 pos = k * currentPosition;
-
-      // Coordinates on the plane
-      double x = glm::dot(east, pos - mMiddlePoint);
-      double y = glm::dot(north, pos - mMiddlePoint);
-
-      // Avoids crashing when moving to the other side of the planet
-      if ((std::isnan(x / maxDist)) || (std::isnan(y / maxDist))) {
-        return;
-      }
+    points.push_back(mark->getPosition());
+  }
+
+  PolygonMesh::Parameters parameters;
+  parameters.mHeightDiff   = mHeightDiff;
+  parameters.mMaxAttempt   = mMaxAttempt;
+  parameters.mMaxPoints    = mMaxPoints;
+  parameters.mSleekness    = mSleekness;
+  parameters.mTriangulator = mTriangulator;
+  parameters.mHeightScale  = mSettings->mGraphics.pHeightScale.get();
+
+  mPendingMesh = mWorker.enqueue(
+      [this, parameters, points = std::move(points), center = mPosition,
+          radii = object->getRadii()]() -> std::optional<PolygonMesh::Result> {
+        PolygonMesh mesh(parameters, [this](std::vector<glm::dvec2> const& lngLats) {
+          return requestHeights(lngLats);
+        });
+        return mesh.compute(points, center, radii);
+      });
+}
 
-      // Saves coordinates normalized with maxDist
-      mCorners.emplace_back(x / maxDist, y / maxDist, addr);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      lastPosition = currentPosition;
-      addr++;
+void PolygonTool::applyCalculation(PolygonMesh::Result const& result) {
+  // If polygon is to big, area calculation and mesh generation are disabled
+  if (result.mIsTooLarge) {
+    mGuiItem->callJavascript("setArea", 0);
+    mGuiItem->callJavascript("setVolume", 0, 0);
+    pShowMesh = false;
+    mTriangulation.clear();
+  } else {
+    // Displays values
+    if (!std::isnan(result.mArea)) {
+      mGuiItem->callJavascript("setArea", result.mArea);
+    } else {
+      mGuiItem->callJavascript("setArea", 0);
     }
-  }
 
-  // Vector to save triangles from voronoi generator
-  std::vector<Triangle> triangles;
-
-  // Creates Delaunay-mesh of the original polygon
-  createMesh(triangles);
-
-  bool     fine          = false;
-  uint32_t attempt       = 0;
-  double   area          = 0;
-  double   negVolume     = 0;
-  double   posVolume     = 0;
-  size_t   triangleCount = 0;
-  size_t   pointCount    = 0;
+    if ((!std::isnan(result.mPosVolume)) && (!std::isnan(result.mNegVolume))) {
+      mGuiItem->callJavascript("setVolume", result.mPosVolume, result.mNegVolume);
+    } else if (!std::isnan(result.mNegVolume)) {
+      mGuiItem->callJavascript("setVolume", 0, result.mNegVolume);
+    } else if (!std::isnan(result.mPosVolume)) {
+      mGuiItem->callJavascript("setVolume", result.mPosVolume, 0);
+    } else {
+      mGuiItem->callJavascript("setVolume", 0, 0);
+    }
 
-  // Counts points of the original Delaunay-mesh
-  for (auto const& vect : mCornersFine) {
-    pointCount += vect.size();
+    mTriangulation = result.mTriangulation;
   }
 
-  // Refines triangulation until it is necessary or mMaxAttempt or mMaxPoints
-  while ((!fine) && (attempt < mMaxAttempt) && (pointCount < mMaxPoints)) {
-    attempt++;
-    fine = true;
-
-    area          = 0;
-    negVolume     = 0;
-    posVolume     = 0;
-    triangleCount = 0;
-    pointCount    = 0;
-
-    mTriangulation.clear();
-
-    // Goes through every triangle of original Delaunay-mesh separately
-    for (auto const& t : triangles) {
+  mIndexCount2 = mTriangulation.size();
 
-      Site s1(0, 0, 0);
-      Site s2(0, 0, 0);
-      Site s3(0, 0, 0);
-      std::tie(s1, s2, s3) = t;
+  // Uploads new data
+  uploadVertices(mTriangulation, mVAO2, mVBO2);
+}
 
-      // Middle point of the triangle
-      glm::dvec2 avgPoint = glm::dvec2((s1.mX + s2.mX + s3.mX) / 3, (s1.mY + s2.mY + s3.mY) / 3);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      // Checks, if middle point is is the polygon
-      if (checkPoint(avgPoint)) {
-        if (attempt == 1) {
-          // Emplaces back the 3 corners of the triangle
-          std::vector<Site> corners;
-          corners.emplace_back(s1.mX, s1.mY, 0);
-          corners.emplace_back(s2.mX, s2.mY, 1);
-          corners.emplace_back(s3.mX, s3.mY, 2);
+void PolygonTool::uploadVertices(std::vector<glm::dvec3> const& positions,
+    VistaVertexArrayObject& vao, VistaBufferObject& vbo) {
+  auto vertices = cs::scene::RelativeToEye::splitInterleaved(positions);
 
-          mCornersFine.emplace_back(corners);
-        }
+  vbo.Bind(GL_ARRAY_BUFFER);
+  vbo.BufferData(vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+  vbo.Release();
 
-        // Checks sleekness of triangles in Delaunay-mesh and refines them, if necessary
-        bool refine = checkSleekness(static_cast<int32_t>(triangleCount));
+  vao.EnableAttributeArray(0);
+  vao.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), 0, &vbo);
+  vao.EnableAttributeArray(1);
+  vao.SpecifyAttributeArrayFloat(
+      1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), sizeof(glm::vec3), &vbo);
+}
 
-        // Voronoi inside the original triangles - to refine triangle angles
-        VoronoiGenerator voronoiRefine;
-        voronoiRefine.parse(mCornersFine[triangleCount]);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-        // No need for checkPoint, all of the edges are inside the triangle and the polygon
-        for (auto const& s : voronoiRefine.getTriangulation()) {
-          double h1{};
-          double h2{};
+std::optional<std::vector<double>> PolygonTool::requestHeights(
+    std::vector<glm::dvec2> const& lngLats) {
+  std::unique_lock<std::mutex> lock(mHeightMutex);
 
-          // Calculates mesh coordinates on planet's surface and saves these coordinates for display
-          displayMesh(surface, s, maxDist, east, north, radii, heightScale, h1, h2);
+  mRequestedHeights = lngLats;
+  mHeightCondition.wait(lock, [this]() { return mSampledHeights || mCancelCalculation; });
 
-          // If not too many points are addded in checkSleekness and it is not the the last attempt
-          // than refines the mesh based on edge length and height differences
-          if ((!refine) && (pointCount < mMaxPoints) && (attempt < mMaxAttempt)) {
-            refineMesh(surface, s, maxDist, east, north, radii, static_cast<int32_t>(triangleCount),
-                h1, h2, fine);
-          }
-        }
+  if (mCancelCalculation) {
+    return std::nullopt;
+  }
 
-        std::vector<Triangle> trianglesRefined = voronoiRefine.getTriangles();
+  auto heights = std::move(mSampledHeights);
+  mSampledHeights.reset();
+  return heights;
+}
 
-        // Calculates area and volume
-        calculateAreaAndVolume(
-            surface, trianglesRefined, maxDist, east, north, radii, area, posVolume, negVolume);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-        pointCount += mCornersFine[triangleCount].size();
-        triangleCount++;
-      } // if (checkPoint(avgPoint))
-    }   // for (auto const& t : triangles)
+void PolygonTool::sampleRequestedHeights() {
+  std::vector<glm::dvec2> lngLats;
 
-    // Displays values
-    if (!std::isnan(area)) {
-      mGuiItem->callJavascript("setArea", area);
-    } else {
-      mGuiItem->callJavascript("setArea", 0);
+  {
+    std::unique_lock<std::mutex> lock(mHeightMutex);
+    if (!mRequestedHeights) {
+      return;
     }
 
-    if ((!std::isnan(posVolume)) && (!std::isnan(negVolume))) {
-      mGuiItem->callJavascript("setVolume", posVolume, negVolume);
-    } else if (!std::isnan(negVolume)) {
-      mGuiItem->callJavascript("setVolume", 0, negVolume);
-    } else if (!std::isnan(posVolume)) {
-      mGuiItem->callJavascript("setVolume", posVolume, 0);
-    } else {
-      mGuiItem->callJavascript("setVolume", 0, 0);
-    }
-  } // while ((!fine) && (attempt < mMaxAttempt) && (pointCount < mMaxPoints))
+    lngLats = std::move(*mRequestedHeights);
+    mRequestedHeights.reset();
+  }
 
-  mIndexCount2 = mTriangulation.size();
+  // The whole batch is sampled at once, CelestialSurface::getHeights() may use several threads.
+  std::vector<double> heights(lngLats.size(), 0.0);
 
-  // Uploads new data
-  mVBO2.Bind(GL_ARRAY_BUFFER);
-  mVBO2.BufferData(mTriangulation.size() * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
-  mVBO2.Release();
+  auto surface = mSolarSystem->getObject(getObjectName())->getSurface();
+  if (surface) {
+    surface->getHeights(lngLats, heights);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mHeightMutex);
+    mSampledHeights = std::move(heights);
+  }
 
-  mVAO2.EnableAttributeArray(0);
-  mVAO2.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, &mVBO2);
+  mHeightCondition.notify_one();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1341,10 +526,12 @@ void PolygonTool::update() {
 
   if (mVerticesDirty) {
     updateLineVertices();
-    updateCalculation();
-    mVerticesDirty = false;
+    mCalculationDirty = true;
+    mVerticesDirty    = false;
   }
 
+  updateCalculation();
+
   auto object   = mSolarSystem->getObject(getObjectName());
   auto guiScale = mSolarSystem->getScaleBasedOnObserverDistance(
       object, mPosition, pScaleDistance.get(), mSettings->mGraphics.pWorldUIScale.get());
@@ -1357,26 +544,9 @@ void PolygonTool::update() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool PolygonTool::Do() {
-  // Transforms all high precision sample points to observer centric low precision coordinates
-  std::vector<glm::vec3> vRelativePositions(mIndexCount);
-  // For Delaunay
-  std::vector<glm::vec3> vRelativePositions2(mIndexCount2);
-
-  auto object    = mSolarSystem->getObject(getObjectName());
-  auto transform = object->getObserverRelativeTransform(mPosition);
-
-  for (uint32_t i(0); i < mIndexCount; ++i) {
-    vRelativePositions[i] = (transform * glm::dvec4(mSampledPositions[i] - mPosition, 1.0)).xyz();
-  }
-  // For Delaunay
-  for (uint32_t i(0); i < mIndexCount2; ++i) {
-    vRelativePositions2[i] = (transform * glm::dvec4(mTriangulation[i] - mPosition, 1.0)).xyz();
-  }
-
-  // Uploads the new points to the GPU
-  mVBO.Bind(GL_ARRAY_BUFFER);
-  mVBO.BufferSubData(0, vRelativePositions.size() * sizeof(glm::vec3), vRelativePositions.data());
-  mVBO.Release();
+  // Only the position of the observer relative to the body changes, the vertices stay the same.
+  auto object = mSolarSystem->getObject(getObjectName());
+  mRelativeToEye.update(object->getObserverRelativeTransform());
 
   glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_LINE_BIT);
 
@@ -1398,6 +568,7 @@ bool PolygonTool::Do() {
   mVAO.Bind();
   glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
   glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+  mRelativeToEye.bind();
 
   mShader.SetUniform(mUniforms.color, pColor.get().r, pColor.get().g, pColor.get().b, 1.F);
 
@@ -1407,11 +578,6 @@ bool PolygonTool::Do() {
 
   // For Delaunay
   if (pShowMesh.get()) {
-    mVBO2.Bind(GL_ARRAY_BUFFER);
-    mVBO2.BufferSubData(
-        0, vRelativePositions2.size() * sizeof(glm::vec3), vRelativePositions2.data());
-    mVBO2.Release();
-
     glLineWidth(2);
 
     mVAO2.Bind();
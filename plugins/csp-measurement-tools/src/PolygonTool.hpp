@@ -8,15 +8,21 @@
 #ifndef CSP_MEASUREMENT_TOOLS_POLYGONTOOL_HPP
 #define CSP_MEASUREMENT_TOOLS_POLYGONTOOL_HPP
 
+#include "../../../src/cs-scene/RelativeToEye.hpp"
+#include "../../../src/cs-utils/ThreadPool.hpp"
 #include "../../csl-tools/src/MultiPointTool.hpp"
 #include "Plugin.hpp"
+#include "PolygonMesh.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 
 #include <glm/glm.hpp>
-#include <vector>
 
-#include "voronoi/VoronoiGenerator.hpp"
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 namespace cs::scene {
 class CelestialSurface;
@@ -33,6 +39,9 @@ namespace csp::measurementtools {
 
 /// Measures the area and volume of an arbitrary polygon on surface with a Delaunay-mesh. It
 /// displays the bounding box of the selected polygon, which can be copied for cache generator.
+/// The mesh is computed by a PolygonMesh on a worker thread, so that moving the points of large
+/// polygons does not block the user interface. While a computation is running, the previous mesh
+/// is shown. If the points are moved in the meantime, the mesh is computed again once it is done.
 class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
  public:
   /// This text is shown on the ui and can be edited by the user.
@@ -64,10 +73,24 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   void setMaxAttempt(uint32_t att);
   void setMaxPoints(uint32_t points);
   void setSleekness(uint32_t degree);
+  void setTriangulator(Triangulator::Type type);
 
  private:
   void updateLineVertices();
+
+  /// Applies the result of a finished mesh computation and starts a new one if the polygon has
+  /// changed. This also samples the heights requested by the running computation.
   void updateCalculation();
+  void applyCalculation(PolygonMesh::Result const& result);
+
+  /// Uploads the high and low parts of the given body-fixed positions to the given buffer.
+  static void uploadVertices(std::vector<glm::dvec3> const& positions,
+      VistaVertexArrayObject& vao, VistaBufferObject& vbo);
+
+  /// The surface must only be accessed on the main thread. Hence the running computation requests
+  /// heights with this and waits until they have been sampled by sampleRequestedHeights().
+  std::optional<std::vector<double>> requestHeights(std::vector<glm::dvec2> const& lngLats);
+  void                               sampleRequestedHeights();
 
   /// Returns the interpolated position in cartesian coordinates. The fourth component is
   /// height above the surface
@@ -75,32 +98,6 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
       std::shared_ptr<cs::scene::CelestialSurface> const& surface,
       csl::tools::DeletableMark const& l0, csl::tools::DeletableMark const& l1, double value);
 
-  /// Finds the intersection point between two sites
-  static bool findIntersection(Site const& s1, Site const& s2, Site const& s3, Site const& s4,
-      double& intersectionX, double& intersectionY);
-
-  /// Creates a Delaunay-mesh and corrects it to match the original polygon
-  /// (especially for concave polygons)
-  void createMesh(std::vector<Triangle>& triangles);
-  /// Checks sleekness of a triangle from the original Delaunay-mesh and its subtriangles
-  /// If a triangle is too sleek, divides it
-  /// Returns true if a lot of new points are added
-  bool checkSleekness(int count);
-  /// Draws the Delaunay-mesh on the planet's surface
-  void displayMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface, Edge2 const& edge,
-      double mdist, glm::dvec3 const& e, glm::dvec3 const& n, glm::dvec3 const& r, double scale,
-      double& h1, double& h2);
-  /// Refines mesh based on edge length and terrain
-  void refineMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface, Edge2 const& edge,
-      double mdist, glm::dvec3 const& e, glm::dvec3 const& n, glm::dvec3 const& r, int count,
-      double h1, double h2, bool& fine);
-  /// Calculates triangle areas and prism volumes
-  void calculateAreaAndVolume(std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-      std::vector<Triangle> const& triangles, double mdist, glm::dvec3 const& e,
-      glm::dvec3 const& n, glm::dvec3 const& r, double& area, double& pvol, double& nvol);
-  // Checks if point is inside of the polygon or not
-  bool checkPoint(glm::dvec2 const& point);
-
   // These are called by the base class MultiPointTool
   void onPointMoved() override;
   void onPointAdded() override;
@@ -122,6 +119,10 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   VistaBufferObject      mVBO2;
   VistaGLSLShader        mShader;
 
+  // The vertices of both buffers are stored in body-fixed coordinates, the observer-relative
+  // positions are computed in the vertex shader.
+  cs::scene::RelativeToEye mRelativeToEye;
+
   struct {
     uint32_t modelViewMatrix  = 0;
     uint32_t projectionMatrix = 0;
@@ -141,12 +142,8 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   glm::dvec4 mBoundingBox = glm::dvec4(0.0);
 
   // For Delaunay-mesh
-  std::vector<Site>              mCorners;
-  std::vector<std::vector<Site>> mCornersFine;
-  std::vector<glm::dvec3>        mTriangulation;
-  glm::dvec3                     mNormal      = glm::dvec3(0.0);
-  glm::dvec3                     mMiddlePoint = glm::dvec3(0.0);
-  size_t                         mIndexCount2 = 0;
+  std::vector<glm::dvec3> mTriangulation;
+  size_t                  mIndexCount2 = 0;
 
   // For triangle fineness
   float    mHeightDiff = 1.002F;
@@ -154,10 +151,18 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   uint32_t mMaxPoints  = 1000;
   uint32_t mSleekness  = 15;
 
-  // For volume calculation
-  double     mOffset{};
-  glm::dvec3 mNormal2      = glm::dvec3(0.0);
-  glm::dvec3 mMiddlePoint2 = glm::dvec3(0.0);
+  Triangulator::Type mTriangulator = Triangulator::Type::eVoronoi;
+
+  // For the computation on the worker thread
+  std::mutex                             mHeightMutex;
+  std::condition_variable                mHeightCondition;
+  std::optional<std::vector<glm::dvec2>> mRequestedHeights;
+  std::optional<std::vector<double>>     mSampledHeights;
+  bool                                   mCancelCalculation = false;
+
+  cs::utils::ThreadPool                           mWorker{1, "Polygon Tool"};
+  std::future<std::optional<PolygonMesh::Result>> mPendingMesh;
+  bool                                            mCalculationDirty = false;
 
   static const int   NUM_SAMPLES;
   static const char* SHADER_VERT;
@@ -0,0 +1,578 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "DelaunayTriangulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace csp::measurementtools {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The adaptive predicates below follow "Adaptive Precision Floating-Point Arithmetic and Fast
+// Robust Geometric Predicates" by Jonathan Richard Shewchuk. If the floating point result is
+// larger than its error bound, it is returned directly. Else the determinant is recomputed exactly
+// with floating point expansions: a value is represented as the sum of non-overlapping doubles.
+
+constexpr double EPSILON              = std::numeric_limits<double>::epsilon() / 2.0;
+constexpr double ORIENT_ERROR_BOUND   = (3.0 + 16.0 * EPSILON) * EPSILON;
+constexpr double INCIRCLE_ERROR_BOUND = (10.0 + 96.0 * EPSILON) * EPSILON;
+
+using Expansion = std::vector<double>;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Computes sum + error = a + b exactly.
+void twoSum(double a, double b, double& sum, double& error) {
+  sum             = a + b;
+  double bVirtual = sum - a;
+  double aVirtual = sum - bVirtual;
+  error           = (a - aVirtual) + (b - bVirtual);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Adds b to the expansion. The components are sorted by increasing magnitude, zeros are removed.
+void grow(Expansion& e, double b) {
+  double      q     = b;
+  std::size_t count = 0;
+
+  for (double component : e) {
+    double sum{};
+    double error{};
+    twoSum(q, component, sum, error);
+    q = sum;
+
+    if (error != 0.0) {
+      e[count++] = error;
+    }
+  }
+
+  e.resize(count);
+
+  if (q != 0.0) {
+    e.push_back(q);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Expansion difference(double a, double b) {
+  Expansion e;
+  grow(e, a);
+  grow(e, -b);
+  return e;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Expansion sum(Expansion e, Expansion const& f, double sign = 1.0) {
+  for (double component : f) {
+    grow(e, sign * component);
+  }
+  return e;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Expansion product(Expansion const& e, Expansion const& f) {
+  Expansion result;
+  for (double a : e) {
+    for (double b : f) {
+      double p = a * b;
+      grow(result, std::fma(a, b, -p));
+      grow(result, p);
+    }
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The largest component determines the sign of an expansion.
+double sign(Expansion const& e) {
+  return e.empty() ? 0.0 : e.back();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns a positive value if a, b and c are in counter-clockwise order, a negative value if they
+// are in clockwise order and zero if they are collinear.
+double orient2d(double ax, double ay, double bx, double by, double cx, double cy) {
+  double left  = (ax - cx) * (by - cy);
+  double right = (ay - cy) * (bx - cx);
+  double det   = left - right;
+  double bound = ORIENT_ERROR_BOUND * (std::abs(left) + std::abs(right));
+
+  if (det > bound || -det > bound) {
+    return det;
+  }
+
+  return sign(sum(product(difference(ax, cx), difference(by, cy)),
+      product(difference(ay, cy), difference(bx, cx)), -1.0));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns a positive value if d is inside of the circle through a, b and c if these are in
+// counter-clockwise order (a negative value for clockwise order) and zero if d is on the circle.
+double incircle(
+    double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+  double adx = ax - dx;
+  double ady = ay - dy;
+  double bdx = bx - dx;
+  double bdy = by - dy;
+  double cdx = cx - dx;
+  double cdy = cy - dy;
+
+  double bdxcdy = bdx * cdy;
+  double cdxbdy = cdx * bdy;
+  double cdxady = cdx * ady;
+  double adxcdy = adx * cdy;
+  double adxbdy = adx * bdy;
+  double bdxady = bdx * ady;
+
+  double alift = adx * adx + ady * ady;
+  double blift = bdx * bdx + bdy * bdy;
+  double clift = cdx * cdx + cdy * cdy;
+
+  double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+  double bound = INCIRCLE_ERROR_BOUND * ((std::abs(bdxcdy) + std::abs(cdxbdy)) * alift +
+                                            (std::abs(cdxady) + std::abs(adxcdy)) * blift +
+                                            (std::abs(adxbdy) + std::abs(bdxady)) * clift);
+
+  if (det > bound || -det > bound) {
+    return det;
+  }
+
+  Expansion eadx = difference(ax, dx);
+  Expansion eady = difference(ay, dy);
+  Expansion ebdx = difference(bx, dx);
+  Expansion ebdy = difference(by, dy);
+  Expansion ecdx = difference(cx, dx);
+  Expansion ecdy = difference(cy, dy);
+
+  Expansion ealift = sum(product(eadx, eadx), product(eady, eady));
+  Expansion eblift = sum(product(ebdx, ebdx), product(ebdy, ebdy));
+  Expansion eclift = sum(product(ecdx, ecdx), product(ecdy, ecdy));
+
+  Expansion bc = sum(product(ebdx, ecdy), product(ecdx, ebdy), -1.0);
+  Expansion ca = sum(product(ecdx, eady), product(eadx, ecdy), -1.0);
+  Expansion ab = sum(product(eadx, ebdy), product(ebdx, eady), -1.0);
+
+  return sign(sum(sum(product(ealift, bc), product(eblift, ca)), product(eclift, ab)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the squared radius of the circle through a, b and c.
+double circumradius(double ax, double ay, double bx, double by, double cx, double cy) {
+  double dx = bx - ax;
+  double dy = by - ay;
+  double ex = cx - ax;
+  double ey = cy - ay;
+  double bl = dx * dx + dy * dy;
+  double cl = ex * ex + ey * ey;
+  double d  = 0.5 / (dx * ey - dy * ex);
+  double x  = (ey * bl - dy * cl) * d;
+  double y  = (dx * cl - ex * bl) * d;
+  return x * x + y * y;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void circumcenter(
+    double ax, double ay, double bx, double by, double cx, double cy, double& x, double& y) {
+  double dx = bx - ax;
+  double dy = by - ay;
+  double ex = cx - ax;
+  double ey = cy - ay;
+  double bl = dx * dx + dy * dy;
+  double cl = ex * ex + ey * ey;
+  double d  = 0.5 / (dx * ey - dy * ex);
+  x         = ax + (ey * bl - dy * cl) * d;
+  y         = ay + (dx * cl - ex * bl) * d;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double squaredDistance(double ax, double ay, double bx, double by) {
+  double dx = ax - bx;
+  double dy = ay - by;
+  return dx * dx + dy * dy;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Monotonically increases with the real angle, but does not require expensive trigonometry.
+double pseudoAngle(double dx, double dy) {
+  double p = dx / (std::abs(dx) + std::abs(dy));
+  return (dy > 0.0 ? 3.0 - p : 1.0 + p) / 4.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DelaunayTriangulator::parse(std::vector<Site> const& sites) {
+  mTriangulationEdges.clear();
+  mTriangles.clear();
+  mVertices.clear();
+  mOpposites.clear();
+
+  if (sites.size() < 3 || sites.size() >= INVALID / 3) {
+    return;
+  }
+
+  auto n = static_cast<uint32_t>(sites.size());
+
+  mX.resize(n);
+  mY.resize(n);
+
+  double minX = std::numeric_limits<double>::infinity();
+  double minY = std::numeric_limits<double>::infinity();
+  double maxX = -std::numeric_limits<double>::infinity();
+  double maxY = -std::numeric_limits<double>::infinity();
+
+  for (uint32_t i = 0; i < n; ++i) {
+    mX[i] = sites[i].mX;
+    mY[i] = sites[i].mY;
+    minX  = std::min(minX, mX[i]);
+    minY  = std::min(minY, mY[i]);
+    maxX  = std::max(maxX, mX[i]);
+    maxY  = std::max(maxY, mY[i]);
+  }
+
+  double centerX = (minX + maxX) / 2.0;
+  double centerY = (minY + maxY) / 2.0;
+
+  // The seed triangle consists of the site closest to the center, its closest neighbor and the
+  // site which forms the smallest circumcircle with those two.
+  uint32_t i0      = 0;
+  double   minDist = std::numeric_limits<double>::infinity();
+  for (uint32_t i = 0; i < n; ++i) {
+    double d = squaredDistance(centerX, centerY, mX[i], mY[i]);
+    if (d < minDist) {
+      i0      = i;
+      minDist = d;
+    }
+  }
+
+  uint32_t i1 = INVALID;
+  minDist     = std::numeric_limits<double>::infinity();
+  for (uint32_t i = 0; i < n; ++i) {
+    double d = squaredDistance(mX[i0], mY[i0], mX[i], mY[i]);
+    if (i != i0 && d < minDist && d > 0.0) {
+      i1      = i;
+      minDist = d;
+    }
+  }
+
+  if (i1 == INVALID) {
+    return;
+  }
+
+  uint32_t i2        = INVALID;
+  double   minRadius = std::numeric_limits<double>::infinity();
+  for (uint32_t i = 0; i < n; ++i) {
+    if (i == i0 || i == i1) {
+      continue;
+    }
+
+    double r = circumradius(mX[i0], mY[i0], mX[i1], mY[i1], mX[i], mY[i]);
+    if (r < minRadius && orient2d(mX[i0], mY[i0], mX[i1], mY[i1], mX[i], mY[i]) != 0.0) {
+      i2        = i;
+      minRadius = r;
+    }
+  }
+
+  // All sites are collinear.
+  if (i2 == INVALID) {
+    return;
+  }
+
+  // All triangles are stored in clockwise order.
+  if (orient2d(mX[i0], mY[i0], mX[i1], mY[i1], mX[i2], mY[i2]) > 0.0) {
+    std::swap(i1, i2);
+  }
+
+  circumcenter(mX[i0], mY[i0], mX[i1], mY[i1], mX[i2], mY[i2], mCenterX, mCenterY);
+
+  // The sites are added in the order of their distance to the circumcenter of the seed triangle.
+  // Identical sites have the same distance, for equal distances the sites are sorted by their
+  // coordinates. Therefore identical sites are next to each other.
+  std::vector<double> dists(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    dists[i] = squaredDistance(mX[i], mY[i], mCenterX, mCenterY);
+  }
+
+  std::vector<uint32_t> ids(n);
+  std::iota(ids.begin(), ids.end(), 0U);
+  std::sort(ids.begin(), ids.end(), [&](uint32_t a, uint32_t b) {
+    if (dists[a] != dists[b]) {
+      return dists[a] < dists[b];
+    }
+    return mX[a] != mX[b] ? mX[a] < mX[b] : mY[a] < mY[b];
+  });
+
+  // The seed triangle is the initial convex hull.
+  auto hashSize = static_cast<uint32_t>(std::ceil(std::sqrt(n)));
+  mHullHash.assign(hashSize, INVALID);
+  mHullPrev.assign(n, 0);
+  mHullNext.assign(n, 0);
+  mHullTriangles.assign(n, 0);
+
+  mHullStart = i0;
+
+  mHullNext[i0] = mHullPrev[i2] = i1;
+  mHullNext[i1] = mHullPrev[i0] = i2;
+  mHullNext[i2] = mHullPrev[i1] = i0;
+
+  mHullTriangles[i0] = 0;
+  mHullTriangles[i1] = 1;
+  mHullTriangles[i2] = 2;
+
+  mHullHash[getHashKey(mX[i0], mY[i0])] = i0;
+  mHullHash[getHashKey(mX[i1], mY[i1])] = i1;
+  mHullHash[getHashKey(mX[i2], mY[i2])] = i2;
+
+  uint32_t maxTriangles = 2 * n - 5;
+  mVertices.reserve(3 * maxTriangles);
+  mOpposites.reserve(3 * maxTriangles);
+
+  addTriangle(i0, i1, i2, INVALID, INVALID, INVALID);
+
+  for (uint32_t k = 0; k < n; ++k) {
+    uint32_t i = ids[k];
+    double   x = mX[i];
+    double   y = mY[i];
+
+    // Skips duplicate sites and the sites of the seed triangle.
+    if ((k > 0 && x == mX[ids[k - 1]] && y == mY[ids[k - 1]]) || i == i0 || i == i1 ||
+        i == i2) {
+      continue;
+    }
+
+    // Finds a visible edge on the convex hull using the edge hash.
+    uint32_t start = 0;
+    uint32_t key   = getHashKey(x, y);
+    for (uint32_t j = 0; j < hashSize; ++j) {
+      start = mHullHash[(key + j) % hashSize];
+      if (start != INVALID && start != mHullNext[start]) {
+        break;
+      }
+    }
+
+    start = mHullPrev[start];
+
+    uint32_t e = start;
+    uint32_t q = mHullNext[e];
+    while (orient2d(x, y, mX[e], mY[e], mX[q], mY[q]) <= 0.0) {
+      e = q;
+      if (e == start) {
+        e = INVALID;
+        break;
+      }
+      q = mHullNext[e];
+    }
+
+    // The site is on the hull, this only happens for duplicates of the seed sites.
+    if (e == INVALID) {
+      continue;
+    }
+
+    // Adds the first triangle from the site and flips triangles until they satisfy the Delaunay
+    // condition.
+    uint32_t t        = addTriangle(e, i, mHullNext[e], INVALID, INVALID, mHullTriangles[e]);
+    mHullTriangles[i] = legalize(t + 2);
+    mHullTriangles[e] = t;
+
+    // Walks forward through the hull, adding more triangles and flipping recursively.
+    uint32_t next = mHullNext[e];
+    q             = mHullNext[next];
+    while (orient2d(x, y, mX[next], mY[next], mX[q], mY[q]) > 0.0) {
+      t = addTriangle(next, i, q, mHullTriangles[i], INVALID, mHullTriangles[next]);
+      mHullTriangles[i] = legalize(t + 2);
+      mHullNext[next]   = next;
+      next              = q;
+      q                 = mHullNext[next];
+    }
+
+    // Walks backward from the other side, adding more triangles and flipping.
+    if (e == start) {
+      q = mHullPrev[e];
+      while (orient2d(x, y, mX[q], mY[q], mX[e], mY[e]) > 0.0) {
+        t = addTriangle(q, i, e, INVALID, mHullTriangles[e], mHullTriangles[q]);
+        legalize(t + 2);
+        mHullTriangles[q] = t;
+        mHullNext[e]      = e;
+        e                 = q;
+        q                 = mHullPrev[e];
+      }
+    }
+
+    // Updates the hull and saves the two new hull sites in the hash.
+    mHullStart = mHullPrev[i] = e;
+    mHullNext[e] = mHullPrev[next] = i;
+    mHullNext[i]                   = next;
+
+    mHullHash[getHashKey(x, y)]         = i;
+    mHullHash[getHashKey(mX[e], mY[e])] = e;
+  }
+
+  mTriangles.reserve(mVertices.size() / 3);
+  for (std::size_t t = 0; t < mVertices.size(); t += 3) {
+    mTriangles.emplace_back(sites[mVertices[t]], sites[mVertices[t + 1]], sites[mVertices[t + 2]]);
+  }
+
+  // Each inner edge consists of two half-edges, only the one with the larger index is stored.
+  mTriangulationEdges.reserve(mVertices.size() / 2 + 1);
+  for (uint32_t e = 0; e < mVertices.size(); ++e) {
+    if (mOpposites[e] == INVALID || mOpposites[e] < e) {
+      uint32_t end = (e % 3 == 2) ? e - 2 : e + 1;
+      mTriangulationEdges.emplace_back(sites[mVertices[e]], sites[mVertices[end]]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Edge2> const& DelaunayTriangulator::getTriangulation() const {
+  return mTriangulationEdges;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Triangle> const& DelaunayTriangulator::getTriangles() const {
+  return mTriangles;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t DelaunayTriangulator::addTriangle(
+    uint32_t i0, uint32_t i1, uint32_t i2, uint32_t a, uint32_t b, uint32_t c) {
+  auto t = static_cast<uint32_t>(mVertices.size());
+
+  mVertices.push_back(i0);
+  mVertices.push_back(i1);
+  mVertices.push_back(i2);
+  mOpposites.resize(mOpposites.size() + 3, INVALID);
+
+  link(t, a);
+  link(t + 1, b);
+  link(t + 2, c);
+
+  return t;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DelaunayTriangulator::link(uint32_t a, uint32_t b) {
+  mOpposites[a] = b;
+  if (b != INVALID) {
+    mOpposites[b] = a;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Flips the edge a and, recursively, the edges of the new triangles, until all of them satisfy the
+// Delaunay condition. The edge a is shared by the triangles (p0, pr, pl) and (p1, pl, pr); if p1 is
+// inside of the circumcircle of the first triangle, the edge is replaced by the edge (p0, p1).
+// Returns the half-edge which starts at the new site.
+uint32_t DelaunayTriangulator::legalize(uint32_t a) {
+  uint32_t ar = 0;
+
+  mEdgeStack.clear();
+
+  while (true) {
+    uint32_t b  = mOpposites[a];
+    uint32_t a0 = a - a % 3;
+    ar          = a0 + (a + 2) % 3;
+
+    // Edges on the convex hull cannot be flipped.
+    if (b == INVALID) {
+      if (mEdgeStack.empty()) {
+        break;
+      }
+      a = mEdgeStack.back();
+      mEdgeStack.pop_back();
+      continue;
+    }
+
+    uint32_t b0 = b - b % 3;
+    uint32_t al = a0 + (a + 1) % 3;
+    uint32_t bl = b0 + (b + 2) % 3;
+
+    uint32_t p0 = mVertices[ar];
+    uint32_t pr = mVertices[a];
+    uint32_t pl = mVertices[al];
+    uint32_t p1 = mVertices[bl];
+
+    // The triangles are clockwise, so p1 is inside of the circumcircle if this is negative.
+    bool illegal = incircle(mX[p0], mY[p0], mX[pr], mY[pr], mX[pl], mY[pl], mX[p1], mY[p1]) < 0.0;
+
+    if (illegal) {
+      mVertices[a] = p1;
+      mVertices[b] = p0;
+
+      // If the flipped edge is on the hull, its reference in the hull has to be updated.
+      uint32_t hbl = mOpposites[bl];
+      if (hbl == INVALID) {
+        uint32_t e = mHullStart;
+        do {
+          if (mHullTriangles[e] == bl) {
+            mHullTriangles[e] = a;
+            break;
+          }
+          e = mHullPrev[e];
+        } while (e != mHullStart);
+      }
+
+      link(a, hbl);
+      link(b, mOpposites[ar]);
+      link(ar, bl);
+
+      mEdgeStack.push_back(b0 + (b + 1) % 3);
+    } else {
+      if (mEdgeStack.empty()) {
+        break;
+      }
+      a = mEdgeStack.back();
+      mEdgeStack.pop_back();
+    }
+  }
+
+  return ar;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t DelaunayTriangulator::getHashKey(double x, double y) const {
+  auto   size  = static_cast<uint32_t>(mHullHash.size());
+  double angle = pseudoAngle(x - mCenterX, y - mCenterY);
+
+  // A site at the center has no angle.
+  if (std::isnan(angle)) {
+    return 0;
+  }
+
+  return static_cast<uint32_t>(std::floor(angle * size)) % size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::measurementtools
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_MEASUREMENT_TOOLS_DELAUNAY_TRIANGULATOR_HPP
+#define CSP_MEASUREMENT_TOOLS_DELAUNAY_TRIANGULATOR_HPP
+
+#include "Triangulator.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::measurementtools {
+
+/// Computes the Delaunay triangulation of a set of sites with a sweep-hull algorithm (like the
+/// Delaunator library). The sites are sorted by their distance to a seed triangle and added one
+/// after another to the convex hull of the previous ones; afterwards, illegal edges are flipped.
+///
+/// In contrast to the VoronoiGenerator, no tree nodes are allocated: the triangulation is stored as
+/// half-edges in flat arrays (the start vertex and the opposite half-edge of each half-edge). The
+/// orientation and in-circle tests are adaptive: they are evaluated with plain floating point
+/// arithmetic if the result is certain and exactly otherwise. Hence, the triangulation is valid
+/// even for degenerate input such as sites on a regular grid.
+///
+/// Duplicate sites are ignored. If all sites are collinear, the triangulation is empty.
+class DelaunayTriangulator : public Triangulator {
+ public:
+  void parse(std::vector<Site> const& sites) override;
+
+  std::vector<Edge2> const&    getTriangulation() const override;
+  std::vector<Triangle> const& getTriangles() const override;
+
+ private:
+  static constexpr uint32_t INVALID = UINT32_MAX;
+
+  uint32_t addTriangle(uint32_t i0, uint32_t i1, uint32_t i2, uint32_t a, uint32_t b, uint32_t c);
+  void     link(uint32_t a, uint32_t b);
+  uint32_t legalize(uint32_t a);
+  uint32_t getHashKey(double x, double y) const;
+
+  // The coordinates of the sites.
+  std::vector<double> mX;
+  std::vector<double> mY;
+
+  // Half-edge e belongs to triangle e / 3. It starts at site mVertices[e] and mOpposites[e] is the
+  // half-edge of the neighboring triangle in opposite direction, or INVALID on the convex hull.
+  std::vector<uint32_t> mVertices;
+  std::vector<uint32_t> mOpposites;
+
+  // The convex hull is a doubly linked list of sites. mHullTriangles contains the half-edge on the
+  // hull starting at each hull site. The hash is used to quickly find a hull site by angle.
+  std::vector<uint32_t> mHullPrev;
+  std::vector<uint32_t> mHullNext;
+  std::vector<uint32_t> mHullTriangles;
+  std::vector<uint32_t> mHullHash;
+  uint32_t              mHullStart = 0;
+  double                mCenterX   = 0.0;
+  double                mCenterY   = 0.0;
+
+  std::vector<uint32_t> mEdgeStack;
+
+  std::vector<Edge2>    mTriangulationEdges;
+  std::vector<Triangle> mTriangles;
+};
+
+} // namespace csp::measurementtools
+
+#endif // CSP_MEASUREMENT_TOOLS_DELAUNAY_TRIANGULATOR_HPP
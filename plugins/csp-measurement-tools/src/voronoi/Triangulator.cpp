@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Triangulator.hpp"
+
+#include "DelaunayTriangulator.hpp"
+#include "VoronoiGenerator.hpp"
+
+namespace csp::measurementtools {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<Triangulator> Triangulator::create(Type type) {
+  if (type == Type::eDelaunay) {
+    return std::make_unique<DelaunayTriangulator>();
+  }
+
+  return std::make_unique<VoronoiGenerator>();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::measurementtools
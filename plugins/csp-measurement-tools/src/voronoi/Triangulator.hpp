@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_MEASUREMENT_TOOLS_TRIANGULATOR_HPP
+#define CSP_MEASUREMENT_TOOLS_TRIANGULATOR_HPP
+
+#include "Site.hpp"
+
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace csp::measurementtools {
+
+using Edge2    = std::pair<Site, Site>;
+using Triangle = std::tuple<Site, Site, Site>;
+
+/// The common interface of the VoronoiGenerator and the DelaunayTriangulator. Both compute the
+/// Delaunay triangulation of a set of sites. The sites of the resulting edges and triangles are
+/// copies of the given sites, so they can be identified by their mAddr.
+class Triangulator {
+ public:
+  /// The available implementations.
+  enum class Type {
+    eVoronoi, ///< The VoronoiGenerator, which uses Fortune's sweep line algorithm.
+    eDelaunay ///< The DelaunayTriangulator, which uses a sweep-hull algorithm.
+  };
+
+  /// Creates a triangulator of the given type.
+  static std::unique_ptr<Triangulator> create(Type type);
+
+  Triangulator() = default;
+
+  Triangulator(Triangulator const& other) = default;
+  Triangulator(Triangulator&& other)      = default;
+
+  Triangulator& operator=(Triangulator const& other) = default;
+  Triangulator& operator=(Triangulator&& other)      = default;
+
+  virtual ~Triangulator() = default;
+
+  /// Triangulates the given sites. Any previous results are discarded.
+  virtual void parse(std::vector<Site> const& sites) = 0;
+
+  /// Each edge of the triangulation is contained once.
+  virtual std::vector<Edge2> const& getTriangulation() const = 0;
+
+  /// The order of the corners of the triangles is not specified.
+  virtual std::vector<Triangle> const& getTriangles() const = 0;
+};
+
+} // namespace csp::measurementtools
+
+#endif // CSP_MEASUREMENT_TOOLS_TRIANGULATOR_HPP
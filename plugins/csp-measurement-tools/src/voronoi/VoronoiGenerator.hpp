@@ -11,6 +11,7 @@
 #include "Beachline.hpp"
 #include "Circle.hpp"
 #include "Site.hpp"
+#include "Triangulator.hpp"
 #include "Vector2f.hpp"
 
 #include <map>
@@ -19,15 +20,15 @@
 
 namespace csp::measurementtools {
 
-using Edge     = std::pair<Vector2f, Vector2f>;
-using Edge2    = std::pair<Site, Site>;
-using Triangle = std::tuple<Site, Site, Site>;
+using Edge = std::pair<Vector2f, Vector2f>;
 
-class VoronoiGenerator {
+/// Computes the Voronoi diagram and the Delaunay triangulation of a set of sites with Fortune's
+/// sweep line algorithm.
+class VoronoiGenerator : public Triangulator {
  public:
   VoronoiGenerator();
 
-  void parse(std::vector<Site> const& sites);
+  void parse(std::vector<Site> const& sites) override;
 
   double sweepLine() const;
 
@@ -36,8 +37,8 @@ class VoronoiGenerator {
 
   std::vector<Site> const&                     getSites() const;
   std::vector<Edge> const&                     getEdges() const;
-  std::vector<Edge2> const&                    getTriangulation() const;
-  std::vector<Triangle> const&                 getTriangles() const;
+  std::vector<Edge2> const&                    getTriangulation() const override;
+  std::vector<Triangle> const&                 getTriangles() const override;
   std::map<uint16_t, std::vector<Site>> const& getNeighbors() const;
 
   void addTriangulationEdge(Site const& site1, Site const& site2);
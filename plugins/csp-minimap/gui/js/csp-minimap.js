@@ -16,7 +16,7 @@
      */
     name = 'minimap';
 
-    _bookmarks = {};
+    _bookmarks = null;
     _baselayer = null;
 
     _lastLng = 0;
@@ -119,22 +119,10 @@
         crs: L.CRS.EPSG4326
       });
 
-      // Bookmarks will be shown in this cluster layer.
-      this._bookmarkLayer = L.markerClusterGroup({
-        spiderfyOnMaxZoom: true,
-        showCoverageOnHover: false,
-        zoomToBoundsOnClick: true,
-        animateAddingMarkers: true,
-        maxClusterRadius: 40,
-        iconCreateFunction: (cluster) => {
-          return L.divIcon({
-            className: 'minimap-bookmark-cluster',
-            html: '<div>' + cluster.getChildCount() + '</div>',
-            iconSize: [22, 22],
-            iconAnchor: [11, 25]
-          });
-        }
-      });
+      // Bookmarks will be shown in this layer. The clusters for each zoom level are computed by
+      // the plugin, so on zoom changes we only have to pick the markers of the new level.
+      this._bookmarkLayer = L.layerGroup().addTo(this._map);
+      this._map.on('zoomend', () => this._updateBookmarkLayer());
 
       // Add our custom buttons.
       this._map.addControl(new this._customControls());
@@ -218,11 +206,17 @@
           this._map.options.crs = L.CRS.EPSG4326;
         }
 
+        // Only load new tiles once panning or zooming has finished and keep some tiles around the
+        // visible area, so that the map does not request the same tiles again and again while the
+        // observer moves. These can be overridden in the settings.
+        let config = Object.assign(
+            {updateWhenIdle: true, updateWhenZooming: false, keepBuffer: 4}, settings.config);
+
         // Create new layer.
         if (settings.type == "wms") {
-          this._baselayer = L.tileLayer.wms(settings.url, settings.config);
+          this._baselayer = L.tileLayer.wms(settings.url, config);
         } else {
-          this._baselayer = L.tileLayer(settings.url, settings.config);
+          this._baselayer = L.tileLayer(settings.url, config);
         }
       }
 
@@ -231,53 +225,78 @@
       this._map.setZoom(2);
     }
 
-    addBookmark(bookmarkID, bookmarkColor, lng, lat) {
-      this._bookmarks[bookmarkID] =
-          L.marker([lat, lng], {
-             icon: L.divIcon({
-               className: 'minimap-bookmark-icon',
-               html: `<div style="background-color: ${bookmarkColor}"></div>`,
-               iconSize: [22, 22],
-               iconAnchor: [11, 26],
-             })
-           }).addTo(this._bookmarkLayer);
-
-      L.DomEvent.on(this._bookmarks[bookmarkID], 'mouseover', () => {
-        let pos = this._map.latLngToContainerPoint(this._bookmarks[bookmarkID].getLatLng());
+    // The given JSON contains all bookmarks of the current body and the clusters for each zoom
+    // level: {"bookmarks": [{"id", "color", "lng", "lat"}, ...],
+    //         "levels": [[{"lng", "lat", "members": [indices into bookmarks]}, ...], ...]}
+    setBookmarks(json) {
+      this._bookmarks = JSON.parse(json);
+      this._updateBookmarkLayer();
+    }
+
+    // Replaces the markers on the map with the clusters of the current zoom level.
+    _updateBookmarkLayer() {
+      this._bookmarkLayer.clearLayers();
+
+      if (!this._bookmarks || this._bookmarks.levels.length == 0) {
+        return;
+      }
+
+      let level = Math.min(Math.max(Math.round(this._map.getZoom()), 0),
+                           this._bookmarks.levels.length - 1);
+
+      for (let cluster of this._bookmarks.levels[level]) {
+        if (cluster.members.length == 1) {
+          this._addBookmarkMarker(this._bookmarks.bookmarks[cluster.members[0]]);
+        } else {
+          this._addClusterMarker(cluster);
+        }
+      }
+    }
+
+    _addBookmarkMarker(bookmark) {
+      let marker = L.marker([bookmark.lat, bookmark.lng], {
+                      icon: L.divIcon({
+                        className: 'minimap-bookmark-icon',
+                        html: `<div style="background-color: ${bookmark.color}"></div>`,
+                        iconSize: [22, 22],
+                        iconAnchor: [11, 26],
+                      })
+                    }).addTo(this._bookmarkLayer);
+
+      L.DomEvent.on(marker, 'mouseover', () => {
+        let pos = this._map.latLngToContainerPoint(marker.getLatLng());
         let box = this._mapDiv.getBoundingClientRect();
         CosmoScout.callbacks.bookmark.showTooltip(
-            bookmarkID, box.x + pos.x + 2, box.y + pos.y - 12);
+            bookmark.id, box.x + pos.x + 2, box.y + pos.y - 12);
       });
 
-      L.DomEvent.on(this._bookmarks[bookmarkID], 'mouseout',
-          () => { CosmoScout.callbacks.bookmark.hideTooltip(); });
+      L.DomEvent.on(marker, 'mouseout', () => { CosmoScout.callbacks.bookmark.hideTooltip(); });
 
-      L.DomEvent.on(this._bookmarks[bookmarkID], 'click', (e) => {
-        CosmoScout.callbacks.bookmark.gotoLocation(bookmarkID);
+      L.DomEvent.on(marker, 'click', (e) => {
+        CosmoScout.callbacks.bookmark.gotoLocation(bookmark.id);
         L.DomEvent.stop(e);
       });
-
-      // The markerClusterGroup wants to be added to the map AFTER the first marker has been added.
-      // So we have to do this here...
-      if (!this._bookmarkLayerAdded) {
-        this._map.addLayer(this._bookmarkLayer);
-        this._bookmarkLayerAdded = true;
-      }
     }
 
-    removeBookmark(bookmarkID) {
-      if (bookmarkID in this._bookmarks) {
-        this._bookmarks[bookmarkID].removeFrom(this._bookmarkLayer);
-        delete this._bookmarks[bookmarkID];
-      }
-    }
-
-    removeBookmarks() {
-      for (let i in this._bookmarks) {
-        this._bookmarks[i].removeFrom(this._bookmarkLayer);
-      }
-
-      this._bookmarks = {};
+    _addClusterMarker(cluster) {
+      let marker = L.marker([cluster.lat, cluster.lng], {
+                      icon: L.divIcon({
+                        className: 'minimap-bookmark-cluster',
+                        html: '<div>' + cluster.members.length + '</div>',
+                        iconSize: [22, 22],
+                        iconAnchor: [11, 25]
+                      })
+                    }).addTo(this._bookmarkLayer);
+
+      // Zoom to the members of the cluster when clicked.
+      L.DomEvent.on(marker, 'click', (e) => {
+        let bounds = L.latLngBounds(cluster.members.map((i) => {
+          let bookmark = this._bookmarks.bookmarks[i];
+          return [bookmark.lat, bookmark.lng];
+        }));
+        this._map.fitBounds(bounds, {padding: [30, 30]});
+        L.DomEvent.stop(e);
+      });
     }
 
     // These are quite a crude conversions from the minimap zoom level to observer height. It
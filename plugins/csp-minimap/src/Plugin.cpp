@@ -12,6 +12,11 @@
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-utils/convert.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <unordered_map>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 EXPORT_FN cs::core::PluginBase* create() {
@@ -76,6 +81,83 @@ void to_json(nlohmann::json& j, Plugin::Settings::Map const& o) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Bookmarks closer than this many pixels on the map are grouped to a cluster.
+constexpr double CLUSTER_RADIUS = 40.0;
+
+// Clusters are computed for the zoom levels zero to this.
+constexpr int MAX_ZOOM = 18;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Projects a position given in degrees to Leaflet's pixel coordinates at zoom level zero. This is
+// what L.CRS.EPSG3857 and L.CRS.EPSG4326 do.
+glm::dvec2 project(glm::dvec2 const& lngLat, Plugin::Settings::ProjectionType projection) {
+  if (projection == Plugin::Settings::ProjectionType::eMercator) {
+    double const maxLat = 85.0511287798;
+    double       lat    = glm::radians(glm::clamp(lngLat.y, -maxLat, maxLat));
+    return {256.0 * (0.5 + lngLat.x / 360.0),
+        256.0 * (0.5 - std::log(std::tan(glm::pi<double>() / 4.0 + lat / 2.0)) /
+                           (2.0 * glm::pi<double>()))};
+  }
+
+  return {256.0 * (1.0 + lngLat.x / 180.0), 256.0 * (0.5 - lngLat.y / 180.0)};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Groups the given pixel positions greedily: Each position joins the first cluster whose first
+// position is closer than CLUSTER_RADIUS, else it starts a new cluster. A grid with cells of the
+// cluster radius is used to find the candidate clusters. The indices of the members of each
+// cluster are returned.
+std::vector<std::vector<uint32_t>> computeClusters(std::vector<glm::dvec2> const& positions) {
+  std::vector<std::vector<uint32_t>>                     clusters;
+  std::unordered_map<uint64_t, std::vector<std::size_t>> grid;
+
+  auto getCell = [](glm::dvec2 const& p) {
+    return glm::ivec2(glm::floor(p / CLUSTER_RADIUS));
+  };
+
+  auto getKey = [](glm::ivec2 const& cell) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32U) |
+           static_cast<uint64_t>(static_cast<uint32_t>(cell.y));
+  };
+
+  for (uint32_t i = 0; i < positions.size(); ++i) {
+    glm::ivec2 cell = getCell(positions[i]);
+    bool       done = false;
+
+    for (int y = cell.y - 1; y <= cell.y + 1 && !done; ++y) {
+      for (int x = cell.x - 1; x <= cell.x + 1 && !done; ++x) {
+        auto candidates = grid.find(getKey({x, y}));
+        if (candidates == grid.end()) {
+          continue;
+        }
+
+        for (std::size_t c : candidates->second) {
+          if (glm::distance(positions[clusters[c].front()], positions[i]) < CLUSTER_RADIUS) {
+            clusters[c].push_back(i);
+            done = true;
+            break;
+          }
+        }
+      }
+    }
+
+    if (!done) {
+      grid[getKey(cell)].push_back(clusters.size());
+      clusters.push_back({i});
+    }
+  }
+
+  return clusters;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "defaultMap", o.mDefaultMap);
   cs::core::Settings::deserialize(j, "maps", o.mMaps);
@@ -92,13 +174,15 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-minimap")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // Add resources to gui.
   mGuiManager->executeJavascriptFile("../share/resources/gui/third-party/js/leaflet.js");
-  mGuiManager->executeJavascriptFile(
-      "../share/resources/gui/third-party/js/leaflet.markercluster.js");
   mGuiManager->addCSS("third-party/css/leaflet.css");
 
   mGuiManager->addCSS("css/csp-minimap.css");
@@ -124,14 +208,21 @@ void Plugin::init() {
   // Remove deleted bookmarks.
   mOnBookmarkRemovedConnection = mGuiManager->onBookmarkRemoved().connect(
       [this](uint32_t bookmarkID, cs::core::Settings::Bookmark const& /*bookmark*/) {
-        mGuiManager->getGui()->callJavascript("CosmoScout.minimap.removeBookmark", bookmarkID);
+        auto marker = std::find_if(mMarkers.begin(), mMarkers.end(),
+            [bookmarkID](Marker const& m) { return m.mBookmarkID == bookmarkID; });
+
+        if (marker != mMarkers.end()) {
+          mMarkers.erase(marker);
+          mMarkersDirty = true;
+        }
       });
 
   // Update bookmarks and map layers if active body changes.
   mActiveObjectConnection = mSolarSystem->pActiveObject.connectAndTouch(
       [this](std::shared_ptr<const cs::scene::CelestialObject> const& body) {
         // First remove all bookmarks.
-        mGuiManager->getGui()->callJavascript("CosmoScout.minimap.removeBookmarks");
+        mMarkers.clear();
+        mMarkersDirty = true;
         mGuiManager->getGui()->callJavascript("CosmoScout.minimap.configure", "");
 
         if (body) {
@@ -139,9 +230,11 @@ void Plugin::init() {
           auto mapSettings = mPluginSettings.mMaps.find(body->getCenterName());
           if (mapSettings != mPluginSettings.mMaps.end()) {
             nlohmann::json json = mapSettings->second;
+            mProjection         = mapSettings->second.mProjection;
             mGuiManager->getGui()->callJavascript("CosmoScout.minimap.configure", json.dump());
           } else if (mPluginSettings.mDefaultMap.has_value()) {
             nlohmann::json json = mPluginSettings.mDefaultMap.value();
+            mProjection         = mPluginSettings.mDefaultMap->mProjection;
             mGuiManager->getGui()->callJavascript("CosmoScout.minimap.configure", json.dump());
           }
 
@@ -187,6 +280,15 @@ void Plugin::deInit() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::update() {
+  if (mMarkersDirty) {
+    sendMarkers();
+    mMarkersDirty = false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::onAddBookmark(std::shared_ptr<const cs::scene::CelestialObject> const& activeObject,
     uint32_t bookmarkID, cs::core::Settings::Bookmark const& bookmark) {
 
@@ -198,14 +300,57 @@ void Plugin::onAddBookmark(std::shared_ptr<const cs::scene::CelestialObject> con
           bookmark.mLocation.value().mPosition.value(), radii);
       p      = cs::utils::convert::toDegrees(p);
       auto c = bookmark.mColor.value_or(glm::vec3(0.8F, 0.8F, 1.0F)) * 255.F;
-      mGuiManager->getGui()->callJavascript("CosmoScout.minimap.addBookmark", bookmarkID,
-          fmt::format("rgb({}, {}, {})", c.r, c.g, c.b), p.x, p.y);
+      mMarkers.push_back({bookmarkID, fmt::format("rgb({}, {}, {})", c.r, c.g, c.b), p});
+      mMarkersDirty = true;
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::sendMarkers() {
+  nlohmann::json bookmarks = nlohmann::json::array();
+  nlohmann::json levels    = nlohmann::json::array();
+
+  std::vector<glm::dvec2> positions;
+  positions.reserve(mMarkers.size());
+
+  for (auto const& marker : mMarkers) {
+    bookmarks.push_back({{"id", marker.mBookmarkID}, {"color", marker.mColor},
+        {"lng", marker.mLngLat.x}, {"lat", marker.mLngLat.y}});
+    positions.push_back(project(marker.mLngLat, mProjection));
+  }
+
+  // Each zoom level doubles the size of the map in pixels. Clusters are shown at the mean position
+  // of their members.
+  std::vector<glm::dvec2> scaled(positions.size());
+
+  for (int zoom = 0; zoom <= MAX_ZOOM; ++zoom) {
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      scaled[i] = positions[i] * std::pow(2.0, zoom);
+    }
+
+    nlohmann::json level = nlohmann::json::array();
+
+    for (auto const& members : computeClusters(scaled)) {
+      glm::dvec2 center(0.0);
+      for (uint32_t m : members) {
+        center += mMarkers[m].mLngLat;
+      }
+      center /= static_cast<double>(members.size());
+
+      level.push_back({{"lng", center.x}, {"lat", center.y}, {"members", members}});
+    }
+
+    levels.push_back(std::move(level));
+  }
+
+  nlohmann::json json = {{"bookmarks", bookmarks}, {"levels", levels}};
+  mGuiManager->getGui()->callJavascript("CosmoScout.minimap.setBookmarks", json.dump());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::onLoad() {
   // Read settings from JSON.
   from_json(mAllSettings->mPlugins.at("csp-minimap"), mPluginSettings);
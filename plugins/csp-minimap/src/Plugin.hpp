@@ -12,13 +12,19 @@
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-scene/CelestialObject.hpp"
 
+#include <glm/glm.hpp>
 #include <map>
+#include <string>
 #include <vector>
 
 namespace csp::minimap {
 
 /// This adds a configurable 2D-Minimap to the user interface. It shows the current observer
 /// position, the bookmarks for the currently active body and allows adding new bookmarks.
+/// Bookmarks which are close to each other on the map are grouped to clusters. The clusters are
+/// computed here for all zoom levels at once and are sent to the user interface in a single call
+/// whenever the bookmarks change. The user interface only has to pick the clusters of its current
+/// zoom level.
 class Plugin : public cs::core::PluginBase {
  public:
   struct Settings {
@@ -53,15 +59,30 @@ class Plugin : public cs::core::PluginBase {
 
   void init() override;
   void deInit() override;
+  void update() override;
 
  private:
+  /// A bookmark which is shown on the minimap.
+  struct Marker {
+    uint32_t    mBookmarkID;
+    std::string mColor;
+    glm::dvec2  mLngLat; ///< In degrees.
+  };
+
   void onAddBookmark(std::shared_ptr<const cs::scene::CelestialObject> const& activeObject,
       uint32_t bookmarkID, cs::core::Settings::Bookmark const& bookmark);
+  void sendMarkers();
   void onLoad();
   void onSave();
 
   Settings mPluginSettings;
 
+  // The markers of the currently active body. If they changed during a frame, they are sent to the
+  // user interface in update().
+  std::vector<Marker>      mMarkers;
+  bool                     mMarkersDirty = false;
+  Settings::ProjectionType mProjection   = Settings::ProjectionType::eEquirectangular;
+
   int mActiveObjectConnection      = -1;
   int mOnBookmarkAddedConnection   = -1;
   int mOnBookmarkRemovedConnection = -1;
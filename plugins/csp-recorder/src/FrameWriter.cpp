@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "FrameWriter.hpp"
+
+#include "../../../src/cs-utils/utils.hpp"
+#include "logger.hpp"
+
+#include <VistaKernel/DisplayManager/VistaDisplayManager.h>
+#include <VistaKernel/DisplayManager/VistaWindow.h>
+#include <VistaKernel/VistaSystem.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#define CS_POPEN popen
+#define CS_CLOSE pclose
+#define CS_POPEN_MODE "w"
+#else
+#define CS_POPEN _popen
+#define CS_CLOSE _pclose
+#define CS_POPEN_MODE "wb"
+#endif
+
+namespace csp::recorder {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameWriter::FrameWriter(
+    std::string directory, std::string const& encoderCommand, uint32_t frameRate)
+    : mDirectory(std::move(directory)) {
+
+  auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+  window->GetWindowProperties()->GetSize(mWidth, mHeight);
+
+  if (encoderCommand.empty()) {
+    mThreadPool = std::make_unique<cs::utils::ThreadPool>(
+        std::max(1U, std::thread::hardware_concurrency()), "Frame Writer");
+  } else {
+    auto command = encoderCommand;
+    cs::utils::replaceString(command, "{width}", std::to_string(mWidth));
+    cs::utils::replaceString(command, "{height}", std::to_string(mHeight));
+    cs::utils::replaceString(command, "{fps}", std::to_string(frameRate));
+
+    // The encoder is started in the output directory, so that relative output files end up there.
+    command = "cd \"" + mDirectory + "\" && " + command;
+
+    logger().info("Starting encoder: {}", command);
+
+    mEncoder = std::unique_ptr<FILE, int (*)(FILE*)>(
+        CS_POPEN(command.c_str(), CS_POPEN_MODE), [](FILE* f) { return CS_CLOSE(f); });
+
+    if (!mEncoder) {
+      throw std::runtime_error("Failed to start encoder '" + command + "'!");
+    }
+
+    mThreadPool = std::make_unique<cs::utils::ThreadPool>(1, "Frame Writer");
+  }
+
+  for (auto& slot : mSlots) {
+    glGenBuffers(1, &slot.mBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.mBuffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(mWidth) * mHeight * 3, nullptr,
+        GL_STREAM_READ);
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameWriter::~FrameWriter() {
+
+  // Write all frames which are still being read.
+  while (mSlots.at(mOldestSlot).mFence) {
+    glClientWaitSync(mSlots.at(mOldestSlot).mFence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+    write(mSlots.at(mOldestSlot));
+  }
+
+  for (auto& slot : mSlots) {
+    glDeleteBuffers(1, &slot.mBuffer);
+  }
+
+  // The destructor of the ThreadPool waits for all pending tasks. Afterwards, the encoder can be
+  // closed.
+  mThreadPool.reset();
+  mEncoder.reset();
+
+  logger().info("Wrote {} frames.", mFrameCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameWriter::capture() {
+
+  // If all slots are in use, we have to wait for the oldest one. This only happens if the GPU is
+  // several frames behind.
+  if (mSlots.at(mNextSlot).mFence) {
+    glClientWaitSync(mSlots.at(mNextSlot).mFence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+    write(mSlots.at(mNextSlot));
+  }
+
+  auto& slot = mSlots.at(mNextSlot);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.mBuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, mWidth, mHeight, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.mFrame = mFrameCount++;
+  mNextSlot   = (mNextSlot + 1) % READBACK_LATENCY;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameWriter::update() {
+
+  // The fences are polled without waiting, so this never stalls.
+  while (mSlots.at(mOldestSlot).mFence) {
+    auto status = glClientWaitSync(mSlots.at(mOldestSlot).mFence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      break;
+    }
+
+    write(mSlots.at(mOldestSlot));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t FrameWriter::getPendingFrames() const {
+  auto inFlight = static_cast<uint32_t>(std::count_if(
+      mSlots.begin(), mSlots.end(), [](Slot const& slot) { return slot.mFence != nullptr; }));
+
+  return inFlight + mThreadPool->getPendingTaskCount() + mThreadPool->getRunningTaskCount();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameWriter::write(Slot& slot) {
+  glDeleteSync(slot.mFence);
+  slot.mFence = nullptr;
+  mOldestSlot = (mOldestSlot + 1) % READBACK_LATENCY;
+
+  auto bytes = static_cast<std::size_t>(mWidth) * static_cast<std::size_t>(mHeight) * 3;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.mBuffer);
+  auto const* data = static_cast<std::byte const*>(glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto pixels = std::make_shared<std::vector<std::byte>>(data, data + bytes);
+
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if (mEncoder) {
+    mThreadPool->enqueue([this, pixels]() {
+      if (std::fwrite(pixels->data(), 1, pixels->size(), mEncoder.get()) != pixels->size()) {
+        logger().error("Failed to write frame to the encoder!");
+      }
+    });
+  } else {
+    auto file = mDirectory + "/frame_" + std::to_string(slot.mFrame) + ".png";
+
+    mThreadPool->enqueue([this, pixels, file]() {
+      // OpenGL stores the rows bottom to top. They are flipped here, as the global
+      // stbi_flip_vertically_on_write() is not thread-safe.
+      auto                   rowSize = static_cast<std::size_t>(mWidth) * 3;
+      std::vector<std::byte> flipped(pixels->size());
+
+      for (std::size_t y(0); y < static_cast<std::size_t>(mHeight); ++y) {
+        std::copy_n(pixels->begin() + static_cast<std::ptrdiff_t>(y * rowSize), rowSize,
+            flipped.end() - static_cast<std::ptrdiff_t>((y + 1) * rowSize));
+      }
+
+      if (stbi_write_png(file.c_str(), mWidth, mHeight, 3, flipped.data(), mWidth * 3) == 0) {
+        logger().error("Failed to write frame '{}'!", file);
+      }
+    });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::recorder
@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_RECORDER_FRAME_WRITER_HPP
+#define CSP_RECORDER_FRAME_WRITER_HPP
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#include <GL/glew.h>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace csp::recorder {
+
+/// The FrameWriter reads the contents of the window asynchronously and writes them to disk. The
+/// pixels are read into a ring of pixel buffer objects, so the main thread never waits for the
+/// GPU. The frames are then either written as a PNG sequence by a pool of worker threads or the raw
+/// RGB data is piped to the standard input of a video encoder like FFmpeg.
+class FrameWriter {
+ public:
+  /// If encoderCommand is empty, the frames are written as frame_<N>.png to the given directory.
+  /// Else the command is started in the given directory and the frames are written to its standard
+  /// input. The placeholders {width}, {height} and {fps} in the command are replaced by the size of
+  /// the window and the given frame rate. The frames are stored bottom to top, so an FFmpeg command
+  /// should look like this:
+  /// ffmpeg -y -f rawvideo -pix_fmt rgb24 -s {width}x{height} -r {fps} -i - -vf vflip out.mp4
+  /// Throws a std::runtime_error if the encoder cannot be started.
+  FrameWriter(std::string directory, std::string const& encoderCommand, uint32_t frameRate);
+
+  FrameWriter(FrameWriter const& other) = delete;
+  FrameWriter(FrameWriter&& other)      = delete;
+
+  FrameWriter& operator=(FrameWriter const& other) = delete;
+  FrameWriter& operator=(FrameWriter&& other)      = delete;
+
+  /// Waits until all frames have been written and closes the encoder.
+  ~FrameWriter();
+
+  /// Starts reading the current contents of the window. This does not wait for the GPU to finish
+  /// rendering, unless all pixel buffer objects are still in use.
+  void capture();
+
+  /// Hands all frames which have been read to the worker threads. This should be called once each
+  /// frame. It never waits for the GPU.
+  void update();
+
+  /// Returns the number of frames which have been captured but not yet been written. This can be
+  /// used to throttle the rendering if encoding is slower than rendering.
+  uint32_t getPendingFrames() const;
+
+ private:
+  // This many frames can be read at the same time.
+  static constexpr std::size_t READBACK_LATENCY = 3;
+
+  struct Slot {
+    uint32_t mBuffer = 0;
+    GLsync   mFence  = nullptr;
+    uint32_t mFrame  = 0;
+  };
+
+  // Copies the pixels of the oldest slot and enqueues them for writing.
+  void write(Slot& slot);
+
+  std::string mDirectory;
+  int32_t     mWidth  = 0;
+  int32_t     mHeight = 0;
+
+  std::array<Slot, READBACK_LATENCY> mSlots{};
+  std::size_t                        mOldestSlot = 0;
+  std::size_t                        mNextSlot   = 0;
+  uint32_t                           mFrameCount = 0;
+
+  // The encoder is fed by a single thread, as the frames have to be written in order.
+  std::unique_ptr<FILE, int (*)(FILE*)> mEncoder{nullptr, nullptr};
+  std::unique_ptr<cs::utils::ThreadPool> mThreadPool;
+};
+
+} // namespace csp::recorder
+
+#endif // CSP_RECORDER_FRAME_WRITER_HPP
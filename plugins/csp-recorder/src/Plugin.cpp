@@ -12,9 +12,12 @@
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-core/TimeControl.hpp"
 #include "../../../src/cs-utils/convert.hpp"
+#include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/logger.hpp"
+#include "FrameWriter.hpp"
 #include "logger.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,6 +43,10 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "recordObserver", o.mRecordObserver);
   cs::core::Settings::deserialize(j, "recordTime", o.mRecordTime);
   cs::core::Settings::deserialize(j, "recordExposure", o.mRecordExposure);
+  cs::core::Settings::deserialize(j, "outputDirectory", o.mOutputDirectory);
+  cs::core::Settings::deserialize(j, "encoderCommand", o.mEncoderCommand);
+  cs::core::Settings::deserialize(j, "frameRate", o.mFrameRate);
+  cs::core::Settings::deserialize(j, "renderDelay", o.mRenderDelay);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
@@ -47,6 +54,10 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "recordObserver", o.mRecordObserver);
   cs::core::Settings::serialize(j, "recordTime", o.mRecordTime);
   cs::core::Settings::serialize(j, "recordExposure", o.mRecordExposure);
+  cs::core::Settings::serialize(j, "outputDirectory", o.mOutputDirectory);
+  cs::core::Settings::serialize(j, "encoderCommand", o.mEncoderCommand);
+  cs::core::Settings::serialize(j, "frameRate", o.mFrameRate);
+  cs::core::Settings::serialize(j, "renderDelay", o.mRenderDelay);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -55,12 +66,16 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-recorder")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // Add the settings section to the side-bar.
   mGuiManager->addSettingsSectionToSideBarFromHTML(
-      "Recorder", "fiber_manual_record", "../share/resources/gui/recorder_settings.html");
+      "Recorder", "fiber_manual_record", "../share/resources/gui/recorder_settings.html", true);
 
   // Add the record-button to the timeline. We remove / add the button every time it's pressed in
   // order to change its icon from a circle to a square and back again.
@@ -69,7 +84,9 @@ void Plugin::init() {
 
   mGuiManager->getGui()->registerCallback(
       "recorder.toggleRecording", "Enables or disables recording.", std::function([this]() {
-        if (mRecording) {
+        if (mFrameWriter || mPlaying) {
+          logger().warn("Cannot record while a recording is being rendered or played back!");
+        } else if (mRecording) {
           mGuiManager->removeTimelineButton("Stop Recording");
           mGuiManager->addTimelineButton(
               "Start Recording", "fiber_manual_record", "recorder.toggleRecording");
@@ -81,6 +98,36 @@ void Plugin::init() {
         }
       }));
 
+  // Add a callback to render the last recording without csp-web-api.
+  mGuiManager->getGui()->registerCallback("recorder.renderRecording",
+      "Renders the last recording and writes the frames to the output directory.",
+      std::function([this]() { startRendering(); }));
+
+  // Add callbacks to load and play back tracks.
+  mGuiManager->getGui()->registerCallback("recorder.loadTrack",
+      "Loads the given .track file. It can then be played back or rendered.",
+      std::function([this](std::string&& file) { loadTrack(file); }));
+
+  mGuiManager->getGui()->registerCallback("recorder.togglePlayback",
+      "Starts or stops playing back the last recording in real time.", std::function([this]() {
+        if (mPlaying) {
+          stopPlayback();
+        } else {
+          startPlayback();
+        }
+      }));
+
+  mGuiManager->getGui()->registerCallback("recorder.seek",
+      "Jumps to the given number of seconds into the last recording.",
+      std::function([this](double seconds) {
+        if (mFrameWriter || mRecording || mTrack.empty()) {
+          return;
+        }
+
+        mPlaybackTime = std::clamp(seconds, 0.0, mTrack.getDuration());
+        applyFrame(mTrack.sample(mPlaybackTime));
+      }));
+
   // Add a callback to toggle recording of the observer transformation.
   mGuiManager->getGui()->registerCallback("recorder.setRecordObserver",
       "Enables or disables recording of the observer transformation.",
@@ -112,6 +159,16 @@ void Plugin::init() {
 
 void Plugin::update() {
 
+  if (mFrameWriter) {
+    updateRendering();
+    return;
+  }
+
+  if (mPlaying) {
+    updatePlayback();
+    return;
+  }
+
   if (mRecording) {
 
     // We are recording but haven't opened the output file - that means it's the very first frame of
@@ -120,6 +177,8 @@ void Plugin::update() {
 
       // Reset the frame counter.
       mFrameCounter = 0;
+      mTrack.clear();
+      mRecordingStart = std::chrono::steady_clock::now();
 
       // We use the current date as a filename.
       auto timeString =
@@ -130,6 +189,7 @@ void Plugin::update() {
       cs::utils::replaceString(timeString, "Z", "");
 
       mOutFile.open("recording-" + timeString + ".py");
+      mTrackFile = "recording-" + timeString + ".track";
 
       // Write the header of the file. This contains the functions which are then called for each
       // recorded frame.
@@ -161,7 +221,7 @@ def capture(file):
 
     // Now that the output file is initialized, we can write the information for each frame. Here we
     // write a call navigation.setBodyFull() setting the current full observer transformation.
-    if (mPluginSettings.mRecordTime.get()) {
+    if (mPluginSettings.mRecordObserver.get()) {
       mOutFile << fmt::format("runJS(\"CosmoScout.callbacks.navigation.setBodyFull('{}', '{}', "
                               "{}, {}, {}, {}, {}, {}, {}, 0);\")",
                       mAllSettings->mObserver.pCenter.get(), mAllSettings->mObserver.pFrame.get(),
@@ -191,11 +251,26 @@ def capture(file):
     // In any case, capture an image.
     mOutFile << "capture('frame_" << mFrameCounter++ << ".png')" << std::endl << std::endl;
 
+    // The frames are added to the track as well, so that they can be played back and rendered
+    // natively.
+    std::chrono::duration<double> timestamp = std::chrono::steady_clock::now() - mRecordingStart;
+    mTrack.add({timestamp.count(), mAllSettings->mObserver.pCenter.get(),
+        mAllSettings->mObserver.pFrame.get(), mAllSettings->mObserver.pPosition.get(),
+        mAllSettings->mObserver.pRotation.get(), mTimeControl->pSimulationTime.get(),
+        mAllSettings->mGraphics.pExposure.get()});
+
   } else {
 
     // Recording has stopped last frame, so close the output file.
     if (mOutFile.is_open()) {
       mOutFile.close();
+
+      try {
+        mTrack.save(mTrackFile);
+        logger().info("Saved {} frames to '{}'.", mTrack.size(), mTrackFile);
+      } catch (std::exception const& e) {
+        logger().error("Failed to save track: {}", e.what());
+      }
     }
   }
 }
@@ -208,11 +283,18 @@ void Plugin::deInit() {
   // Save settings as this plugin may get reloaded.
   onSave();
 
+  stopRendering();
+  stopPlayback();
+
   // Clean up the side-bar.
   mGuiManager->removeSettingsSection("Recorder");
 
   // Unregister all callbacks.
   mGuiManager->getGui()->unregisterCallback("recorder.toggleRecording");
+  mGuiManager->getGui()->unregisterCallback("recorder.renderRecording");
+  mGuiManager->getGui()->unregisterCallback("recorder.loadTrack");
+  mGuiManager->getGui()->unregisterCallback("recorder.togglePlayback");
+  mGuiManager->getGui()->unregisterCallback("recorder.seek");
   mGuiManager->getGui()->unregisterCallback("recorder.setRecordObserver");
   mGuiManager->getGui()->unregisterCallback("recorder.setRecordTime");
   mGuiManager->getGui()->unregisterCallback("recorder.setRecordExposure");
@@ -245,4 +327,191 @@ void Plugin::onSave() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::startRendering() {
+  if (mRecording || mFrameWriter || mPlaying) {
+    logger().warn("Cannot render while recording, rendering or playing back!");
+    return;
+  }
+
+  if (mTrack.empty()) {
+    logger().warn("There is no recording to render!");
+    return;
+  }
+
+  try {
+    auto directory = boost::filesystem::absolute(mPluginSettings.mOutputDirectory.get());
+    cs::utils::filesystem::createDirectoryRecursively(directory);
+
+    mFrameWriter = std::make_unique<FrameWriter>(directory.string(),
+        mPluginSettings.mEncoderCommand.value_or(""), mPluginSettings.mFrameRate.get());
+  } catch (std::exception const& e) {
+    logger().error("Failed to start rendering: {}", e.what());
+    return;
+  }
+
+  logger().info("Rendering {} seconds to '{}'...", mTrack.getDuration(),
+      mPluginSettings.mOutputDirectory.get());
+
+  // The simulation time is set for each frame, so it must not advance on its own.
+  mSavedTimeSpeed         = mAllSettings->pTimeSpeed.get();
+  mAllSettings->pTimeSpeed = 0.F;
+
+  // The recorded exposure is only used if auto exposure is disabled.
+  mSavedAutoExposure = mAllSettings->mGraphics.pEnableAutoExposure.get();
+  if (mPluginSettings.mRecordExposure.get()) {
+    mAllSettings->mGraphics.pEnableAutoExposure = false;
+  }
+
+  mRenderFrame = 0;
+  mRenderWait  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::stopRendering() {
+  if (!mFrameWriter) {
+    return;
+  }
+
+  // This waits until all frames have been written.
+  mFrameWriter.reset();
+
+  mAllSettings->pTimeSpeed                    = mSavedTimeSpeed;
+  mAllSettings->mGraphics.pEnableAutoExposure = mSavedAutoExposure;
+
+  logger().info("Rendering done.");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateRendering() {
+  mFrameWriter->update();
+
+  // The frame which has been applied mRenderDelay frames ago has been rendered in the previous
+  // frame, so we capture it now.
+  if (mRenderWait > 0 && --mRenderWait == 0) {
+    mFrameWriter->capture();
+    ++mRenderFrame;
+  }
+
+  if (mRenderWait > 0) {
+    return;
+  }
+
+  // The track is sampled at a fixed time step, so the video plays at the speed of the recording
+  // regardless of the frame rate during recording.
+  double timestamp =
+      static_cast<double>(mRenderFrame) / std::max(1U, mPluginSettings.mFrameRate.get());
+
+  if (timestamp > mTrack.getDuration()) {
+    stopRendering();
+    return;
+  }
+
+  // If the frames are encoded slower than they are rendered, we wait for the encoder so that the
+  // memory usage does not grow without bounds.
+  uint32_t const maxPendingFrames = 16;
+  if (mFrameWriter->getPendingFrames() > maxPendingFrames) {
+    return;
+  }
+
+  applyFrame(mTrack.sample(timestamp));
+
+  mRenderWait = std::max(1U, mPluginSettings.mRenderDelay.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::loadTrack(std::string const& file) {
+  if (mRecording || mFrameWriter || mPlaying) {
+    logger().warn("Cannot load a track while recording, rendering or playing back!");
+    return;
+  }
+
+  try {
+    mTrack = Track::load(file);
+    logger().info("Loaded {} frames from '{}'.", mTrack.size(), file);
+  } catch (std::exception const& e) {
+    logger().error("Failed to load track: {}", e.what());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::startPlayback() {
+  if (mRecording || mFrameWriter || mPlaying) {
+    logger().warn("Cannot play back while recording, rendering or playing back!");
+    return;
+  }
+
+  if (mTrack.empty()) {
+    logger().warn("There is no recording to play back!");
+    return;
+  }
+
+  // Start from the beginning if the previous playback has reached the end.
+  if (mPlaybackTime >= mTrack.getDuration()) {
+    mPlaybackTime = 0.0;
+  }
+
+  mSavedTimeSpeed          = mAllSettings->pTimeSpeed.get();
+  mAllSettings->pTimeSpeed = 0.F;
+
+  mSavedAutoExposure = mAllSettings->mGraphics.pEnableAutoExposure.get();
+  if (mPluginSettings.mRecordExposure.get()) {
+    mAllSettings->mGraphics.pEnableAutoExposure = false;
+  }
+
+  mPlaying            = true;
+  mLastPlaybackUpdate = std::chrono::steady_clock::now();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::stopPlayback() {
+  if (!mPlaying) {
+    return;
+  }
+
+  mPlaying = false;
+
+  mAllSettings->pTimeSpeed                    = mSavedTimeSpeed;
+  mAllSettings->mGraphics.pEnableAutoExposure = mSavedAutoExposure;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updatePlayback() {
+  auto                          now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt  = now - mLastPlaybackUpdate;
+  mLastPlaybackUpdate               = now;
+
+  mPlaybackTime = std::min(mPlaybackTime + dt.count(), mTrack.getDuration());
+  applyFrame(mTrack.sample(mPlaybackTime));
+
+  if (mPlaybackTime >= mTrack.getDuration()) {
+    stopPlayback();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::applyFrame(Track::Frame const& frame) {
+
+  // A duration of zero moves the observer immediately.
+  if (mPluginSettings.mRecordObserver.get()) {
+    mSolarSystem->flyObserverTo(frame.mCenter, frame.mFrame, frame.mPosition, frame.mRotation, 0.0);
+  }
+
+  if (mPluginSettings.mRecordTime.get()) {
+    mTimeControl->setTime(frame.mTime);
+  }
+
+  if (mPluginSettings.mRecordExposure.get()) {
+    mAllSettings->mGraphics.pExposure = frame.mExposure;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::recorder
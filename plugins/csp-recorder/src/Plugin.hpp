@@ -11,11 +11,17 @@
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-utils/Property.hpp"
+#include "Track.hpp"
 
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <optional>
 
 namespace csp::recorder {
 
+class FrameWriter;
+
 /// This plugin allows basic capturing of high-quality videos using csp-web-api. 'Basic' means that
 /// (for now) only the observer transformation, the simulation time and the exposure of the HDR mode
 /// is captured. This however, can be changed in the future.
@@ -24,6 +30,11 @@ namespace csp::recorder {
 /// frame using csp-web-api. This two-step approach has the advantage that recording can be done at
 /// high frame rates (with all settings reduced to the bare minimum) while capturing can be done at
 /// high resolution and high quality.
+/// Alternatively, the last recording can be rendered natively. Then each recorded frame is applied
+/// directly and the frames are read back asynchronously and written by the FrameWriter as a PNG
+/// sequence or piped to a video encoder. This does not require csp-web-api.
+/// Each recording is also stored as a binary Track next to the python script. A track can be
+/// loaded and played back in real time, and it is sampled at a fixed time step when rendering.
 class Plugin : public cs::core::PluginBase {
  public:
   struct Settings {
@@ -34,6 +45,20 @@ class Plugin : public cs::core::PluginBase {
     cs::utils::DefaultProperty<bool> mRecordObserver{true};
     cs::utils::DefaultProperty<bool> mRecordTime{true};
     cs::utils::DefaultProperty<bool> mRecordExposure{false};
+
+    /// The directory to which natively rendered frames are written.
+    cs::utils::DefaultProperty<std::string> mOutputDirectory{"recording"};
+
+    /// If set, natively rendered frames are piped to this command instead of being written as PNG
+    /// files. See FrameWriter for the supported placeholders.
+    std::optional<std::string> mEncoderCommand;
+
+    /// The frame rate which is passed to the encoder command.
+    cs::utils::DefaultProperty<uint32_t> mFrameRate{60};
+
+    /// The number of frames which are rendered for each recorded frame before it is captured. This
+    /// gives the data of the scene some time to load.
+    cs::utils::DefaultProperty<uint32_t> mRenderDelay{1};
   };
 
   void init() override;
@@ -44,12 +69,41 @@ class Plugin : public cs::core::PluginBase {
   void onLoad();
   void onSave();
 
+  void startRendering();
+  void stopRendering();
+  void updateRendering();
+
+  void loadTrack(std::string const& file);
+  void startPlayback();
+  void stopPlayback();
+  void updatePlayback();
+
+  // Applies the recorded properties of the given frame. The observer is moved immediately.
+  void applyFrame(Track::Frame const& frame);
+
   Settings mPluginSettings;
 
   bool          mRecording = false;
   std::ofstream mOutFile;
+  std::string   mTrackFile;
   uint32_t      mFrameCounter = 0;
 
+  // The last recording or the last loaded track.
+  Track                                 mTrack;
+  std::chrono::steady_clock::time_point mRecordingStart;
+
+  // Members for playing back the track in real time.
+  bool                                  mPlaying      = false;
+  double                                mPlaybackTime = 0.0;
+  std::chrono::steady_clock::time_point mLastPlaybackUpdate;
+
+  // Members for rendering the last recording natively.
+  std::unique_ptr<FrameWriter> mFrameWriter;
+  std::size_t                  mRenderFrame       = 0;
+  uint32_t                     mRenderWait        = 0;
+  float                        mSavedTimeSpeed    = 0.F;
+  bool                         mSavedAutoExposure = false;
+
   int mOnLoadConnection = -1;
   int mOnSaveConnection = -1;
 };
@@ -0,0 +1,213 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Track.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+namespace csp::recorder {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::array<char, 8> const MAGIC = {'C', 'S', 'T', 'R', 'A', 'C', 'K', '1'};
+
+// The flag byte of a frame is set to this if the SPICE center and frame names follow.
+uint8_t const ANCHOR_CHANGED = 1;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void write(std::ofstream& stream, T const& value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  stream.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+void write(std::ofstream& stream, std::string const& value) {
+  write(stream, static_cast<uint16_t>(value.size()));
+  stream.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+template <typename T>
+void read(std::ifstream& stream, T& value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+void read(std::ifstream& stream, std::string& value) {
+  uint16_t size = 0;
+  read(stream, size);
+  value.resize(size);
+  stream.read(value.data(), size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Track::add(Frame frame) {
+  mFrames.push_back(std::move(frame));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Track::clear() {
+  mFrames.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Track::empty() const {
+  return mFrames.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Track::size() const {
+  return mFrames.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double Track::getDuration() const {
+  return mFrames.empty() ? 0.0 : mFrames.back().mTimestamp;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Track::Frame Track::sample(double timestamp) const {
+  if (mFrames.empty()) {
+    return {};
+  }
+
+  // Find the first frame after the given timestamp.
+  auto next = std::upper_bound(mFrames.begin(), mFrames.end(), timestamp,
+      [](double t, Frame const& frame) { return t < frame.mTimestamp; });
+
+  if (next == mFrames.begin()) {
+    return mFrames.front();
+  }
+
+  if (next == mFrames.end()) {
+    return mFrames.back();
+  }
+
+  auto const& a = *(next - 1);
+  auto const& b = *next;
+
+  if (a.mCenter != b.mCenter || a.mFrame != b.mFrame) {
+    return a;
+  }
+
+  double alpha = (timestamp - a.mTimestamp) / (b.mTimestamp - a.mTimestamp);
+
+  Frame result      = a;
+  result.mTimestamp = timestamp;
+  result.mPosition  = glm::mix(a.mPosition, b.mPosition, alpha);
+  result.mRotation  = glm::slerp(a.mRotation, b.mRotation, alpha);
+  result.mTime      = a.mTime + (b.mTime - a.mTime) * alpha;
+  result.mExposure  = glm::mix(a.mExposure, b.mExposure, static_cast<float>(alpha));
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Track::save(std::string const& file) const {
+  std::ofstream stream(file, std::ios::binary);
+
+  if (!stream) {
+    throw std::runtime_error("Failed to open '" + file + "' for writing!");
+  }
+
+  stream.write(MAGIC.data(), MAGIC.size());
+
+  Frame const* previous = nullptr;
+
+  for (auto const& frame : mFrames) {
+    bool anchorChanged =
+        !previous || previous->mCenter != frame.mCenter || previous->mFrame != frame.mFrame;
+
+    write(stream, anchorChanged ? ANCHOR_CHANGED : uint8_t(0));
+
+    if (anchorChanged) {
+      write(stream, frame.mCenter);
+      write(stream, frame.mFrame);
+    }
+
+    write(stream, frame.mTimestamp);
+    write(stream, frame.mPosition);
+    write(stream, frame.mRotation);
+    write(stream, frame.mTime);
+    write(stream, frame.mExposure);
+
+    previous = &frame;
+  }
+
+  if (!stream) {
+    throw std::runtime_error("Failed to write '" + file + "'!");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Track Track::load(std::string const& file) {
+  std::ifstream stream(file, std::ios::binary);
+
+  if (!stream) {
+    throw std::runtime_error("Failed to open '" + file + "'!");
+  }
+
+  std::array<char, 8> magic{};
+  stream.read(magic.data(), magic.size());
+
+  if (!stream || magic != MAGIC) {
+    throw std::runtime_error("'" + file + "' is not a track file!");
+  }
+
+  Track   track;
+  Frame   frame;
+  uint8_t flags = 0;
+
+  while (stream.peek() != std::ifstream::traits_type::eof()) {
+    read(stream, flags);
+
+    if ((flags & ANCHOR_CHANGED) != 0) {
+      read(stream, frame.mCenter);
+      read(stream, frame.mFrame);
+    } else if (track.empty()) {
+      throw std::runtime_error("The first frame of '" + file + "' has no anchor!");
+    }
+
+    read(stream, frame.mTimestamp);
+    read(stream, frame.mPosition);
+    read(stream, frame.mRotation);
+    read(stream, frame.mTime);
+    read(stream, frame.mExposure);
+
+    if (!stream) {
+      throw std::runtime_error("'" + file + "' is truncated!");
+    }
+
+    track.add(frame);
+  }
+
+  return track;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::recorder
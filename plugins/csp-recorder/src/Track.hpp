@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_RECORDER_TRACK_HPP
+#define CSP_RECORDER_TRACK_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+#include <vector>
+
+namespace csp::recorder {
+
+/// A Track is a recorded sequence of observer poses, simulation times and exposures. It can be
+/// sampled at arbitrary points in time, so it can be played back at any frame rate and seeking is
+/// cheap.
+///
+/// Tracks are stored in a compact binary format: After an eight-byte magic number, each frame is
+/// stored as a flag byte, followed by the SPICE center and frame names if they have changed since
+/// the previous frame (each a uint16 length and the characters), followed by the timestamp, the
+/// position, the rotation (x, y, z, w) and the simulation time as doubles and the exposure as a
+/// float. All numbers are stored in the byte order of the machine.
+class Track {
+ public:
+  struct Frame {
+    /// Seconds since the start of the recording.
+    double mTimestamp = 0.0;
+
+    std::string mCenter;
+    std::string mFrame;
+    glm::dvec3  mPosition{0.0};
+    glm::dquat  mRotation{1.0, 0.0, 0.0, 0.0};
+
+    /// The simulation time in SPICE format.
+    double mTime     = 0.0;
+    float  mExposure = 0.F;
+  };
+
+  /// Appends a frame. The timestamps of the frames must increase monotonically.
+  void add(Frame frame);
+  void clear();
+
+  bool        empty() const;
+  std::size_t size() const;
+
+  /// Returns the timestamp of the last frame.
+  double getDuration() const;
+
+  /// Returns the state of the recording at the given timestamp. The two neighboring frames are
+  /// found with a binary search and interpolated. If they have different SPICE centers or frames,
+  /// the earlier frame is returned. The timestamp is clamped to the duration of the track.
+  Frame sample(double timestamp) const;
+
+  /// Writes the track in the binary format described above. Throws a std::runtime_error if the
+  /// file cannot be written.
+  void save(std::string const& file) const;
+
+  /// Reads a track from a file written by save(). Throws a std::runtime_error if the file cannot be
+  /// read or is not a track.
+  static Track load(std::string const& file);
+
+ private:
+  std::vector<Frame> mFrames;
+};
+
+} // namespace csp::recorder
+
+#endif // CSP_RECORDER_TRACK_HPP
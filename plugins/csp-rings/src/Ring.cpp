@@ -9,6 +9,7 @@
 
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-graphics/ShaderCache.hpp"
 #include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
 #include "../../../src/cs-utils/utils.hpp"
@@ -44,6 +45,7 @@ layout(location = 0) in vec2 iGridPos;
 // outputs
 out vec2 vTexCoords;
 out vec4 vPosition;
+out vec3 vLocalPosition;
 
 const float PI = 3.141592654;
 
@@ -53,8 +55,9 @@ void main() {
   vec2 vDir = vec2(sin(iGridPos.x * 2.0 * PI), cos(iGridPos.x * 2.0 * PI));
   vec2 vPos = mix(vDir * uRadii.x, vDir * uRadii.y, iGridPos.y);
 
-  vPosition   = uMatModel * vec4(vPos.x, 0, vPos.y, 1.0);
-  gl_Position =  uMatProjection * uMatView * vPosition;
+  vLocalPosition = vec3(vPos.x, 0, vPos.y);
+  vPosition      = uMatModel * vec4(vLocalPosition, 1.0);
+  gl_Position    = uMatProjection * uMatView * vPosition;
 }
 )";
 
@@ -65,12 +68,15 @@ uniform sampler2D uSurfaceTexture;
 uniform float uAmbientBrightness;
 uniform float uSunIlluminance;
 uniform float uLitSideVisible;
+uniform vec3 uSunDirection;
+uniform vec3 uPlanetRadii;
 
 ECLIPSE_SHADER_SNIPPET
 
 // inputs
 in vec2 vTexCoords;
 in vec4 vPosition;
+in vec3 vLocalPosition;
 
 // outputs
 layout(location = 0) out vec4 oColor;
@@ -82,8 +88,31 @@ vec3 SRGBtoLINEAR(vec3 srgbIn) {
   return mix(srgbIn / vec3(12.92), pow((srgbIn + vec3(0.055)) / vec3(1.055), vec3(2.4)), bLess);
 }
 
+// The shadow of the planet is computed analytically. In a space where the planet is a unit sphere,
+// the ray towards the Sun is tested for an intersection with it. The Sun is so far away that the
+// penumbra can be neglected, only the edge is anti-aliased.
+float getPlanetShadow() {
+  // Bodies without radii cast no shadow.
+  if (uPlanetRadii.x <= 0.0) {
+    return 1.0;
+  }
+
+  vec3 position = vLocalPosition / uPlanetRadii;
+  vec3 toSun    = normalize(uSunDirection / uPlanetRadii);
+
+  float t = -dot(position, toSun);
+  if (t < 0.0) {
+    return 1.0;
+  }
+
+  float dist = length(position + t * toSun);
+  float edge = fwidth(dist);
+  return smoothstep(1.0 - edge, 1.0 + edge, dist);
+}
+
 void main() {
-  oColor = texture(uSurfaceTexture, vTexCoords);
+  // The texture is a radial cross-section of the ring, so it is sampled along a single line.
+  oColor = texture(uSurfaceTexture, vec2(vTexCoords.x, 0.5));
 
   #ifdef ENABLE_HDR
     oColor.rgb = SRGBtoLINEAR(oColor.rgb) * uSunIlluminance / M_PI;
@@ -101,7 +130,8 @@ void main() {
         oColor.rgb = oColor.rgb * (1 - oColor.a) * 2.0;
       #endif
     }
-    oColor.rgb = oColor.rgb * getEclipseShadow(vPosition.xyz) + vec3(uAmbientBrightness);
+    oColor.rgb = oColor.rgb * getEclipseShadow(vPosition.xyz) * getPlanetShadow() +
+                 vec3(uAmbientBrightness);
   #endif
 }
 )";
@@ -113,7 +143,7 @@ Ring::Ring(std::shared_ptr<cs::core::Settings> settings,
     : mObjectName(std::move(objectName))
     , mSettings(std::move(settings))
     , mSolarSystem(std::move(solarSystem))
-    , mEclipseShadowReceiver(mSettings, mSolarSystem, true) {
+    , mEclipseShadowReceiver(mSettings, mSolarSystem, false) {
 
   // The geometry is a grid strip around the center of the SPICE frame.
   std::vector<glm::vec2> vertices(GRID_RESOLUTION * 2);
@@ -160,7 +190,7 @@ Ring::~Ring() {
 
 void Ring::configure(Plugin::Settings::Ring const& settings) {
   if (mRingSettings.mTexture != settings.mTexture) {
-    mTexture = cs::graphics::TextureLoader::loadFromFile(settings.mTexture);
+    mTexture = cs::graphics::TextureLoader::loadFromFileAsync(settings.mTexture);
   }
   mRingSettings = settings;
 
@@ -186,12 +216,10 @@ bool Ring::Do() {
     return true;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer("Rings");
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
 
   // (Re-)Create ring shader if necessary.
   if (mShaderDirty || mEclipseShadowReceiver.needsRecompilation()) {
-    mShader = VistaGLSLShader();
-
     std::string defines = "#version 330\n";
 
     if (mSettings->mGraphics.pEnableHDR.get()) {
@@ -206,26 +234,26 @@ bool Ring::Do() {
     cs::utils::replaceString(
         frag, "ECLIPSE_SHADER_SNIPPET", mEclipseShadowReceiver.getShaderSnippet());
 
-    mShader.InitVertexShaderFromString(defines + SPHERE_VERT);
-    mShader.InitFragmentShaderFromString(frag);
-    mShader.Link();
+    mShader = cs::graphics::ShaderCache::get().getShader(defines + SPHERE_VERT, frag);
 
-    mUniforms.modelMatrix       = mShader.GetUniformLocation("uMatModel");
-    mUniforms.viewMatrix        = mShader.GetUniformLocation("uMatView");
-    mUniforms.projectionMatrix  = mShader.GetUniformLocation("uMatProjection");
-    mUniforms.surfaceTexture    = mShader.GetUniformLocation("uSurfaceTexture");
-    mUniforms.radii             = mShader.GetUniformLocation("uRadii");
-    mUniforms.sunIlluminance    = mShader.GetUniformLocation("uSunIlluminance");
-    mUniforms.ambientBrightness = mShader.GetUniformLocation("uAmbientBrightness");
-    mUniforms.litSideVisible    = mShader.GetUniformLocation("uLitSideVisible");
+    mUniforms.modelMatrix       = mShader->GetUniformLocation("uMatModel");
+    mUniforms.viewMatrix        = mShader->GetUniformLocation("uMatView");
+    mUniforms.projectionMatrix  = mShader->GetUniformLocation("uMatProjection");
+    mUniforms.surfaceTexture    = mShader->GetUniformLocation("uSurfaceTexture");
+    mUniforms.radii             = mShader->GetUniformLocation("uRadii");
+    mUniforms.sunIlluminance    = mShader->GetUniformLocation("uSunIlluminance");
+    mUniforms.ambientBrightness = mShader->GetUniformLocation("uAmbientBrightness");
+    mUniforms.litSideVisible    = mShader->GetUniformLocation("uLitSideVisible");
+    mUniforms.sunDirection      = mShader->GetUniformLocation("uSunDirection");
+    mUniforms.planetRadii       = mShader->GetUniformLocation("uPlanetRadii");
 
     // We bind the eclipse shadow map to texture unit 1.
-    mEclipseShadowReceiver.init(&mShader, 1);
+    mEclipseShadowReceiver.init(mShader.get(), 1);
 
     mShaderDirty = false;
   }
 
-  mShader.Bind();
+  mShader->Bind();
 
   // Get modelview and projection matrices.
   std::array<GLfloat, 16> glMatV{};
@@ -240,8 +268,8 @@ bool Ring::Do() {
   glUniformMatrix4fv(mUniforms.viewMatrix, 1, GL_FALSE, glm::value_ptr(matV));
   glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
 
-  mShader.SetUniform(mUniforms.surfaceTexture, 0);
-  mShader.SetUniform(mUniforms.radii, mRingSettings.mInnerRadius, mRingSettings.mOuterRadius);
+  mShader->SetUniform(mUniforms.surfaceTexture, 0);
+  mShader->SetUniform(mUniforms.radii, mRingSettings.mInnerRadius, mRingSettings.mOuterRadius);
 
   float sunIlluminance(1.F);
   float ambientBrightness(mSettings->mGraphics.pAmbientBrightness.get());
@@ -291,9 +319,13 @@ bool Ring::Do() {
   float litSideVisible =
       (sunAngle > 0.0F && viewAngle > 0.0F) || (sunAngle < 0.0F && viewAngle < 0.0F) ? 1.0F : 0.0F;
 
-  mShader.SetUniform(mUniforms.sunIlluminance, sunIlluminance);
-  mShader.SetUniform(mUniforms.ambientBrightness, ambientBrightness);
-  mShader.SetUniform(mUniforms.litSideVisible, litSideVisible);
+  mShader->SetUniform(mUniforms.sunIlluminance, sunIlluminance);
+  mShader->SetUniform(mUniforms.ambientBrightness, ambientBrightness);
+  mShader->SetUniform(mUniforms.litSideVisible, litSideVisible);
+
+  glm::vec3 planetRadii = object->getRadii();
+  mShader->SetUniform(mUniforms.sunDirection, sunDirection[0], sunDirection[1], sunDirection[2]);
+  mShader->SetUniform(mUniforms.planetRadii, planetRadii[0], planetRadii[1], planetRadii[2]);
 
   mTexture->Bind(GL_TEXTURE0);
 
@@ -318,7 +350,7 @@ bool Ring::Do() {
   glDisable(GL_BLEND);
   glEnable(GL_CULL_FACE);
 
-  mShader.Release();
+  mShader->Release();
 
   return true;
 }
@@ -12,6 +12,7 @@
 
 #include "../../../src/cs-core/EclipseShadowReceiver.hpp"
 #include "../../../src/cs-scene/CelestialObject.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
@@ -57,11 +58,11 @@ class Ring : public cs::scene::CelestialObject, public IVistaOpenGLDraw {
 
   std::unique_ptr<VistaOpenGLNode> mGLNode;
 
-  Plugin::Settings::Ring        mRingSettings;
-  std::unique_ptr<VistaTexture> mTexture;
-  VistaGLSLShader               mShader;
-  VistaVertexArrayObject        mSphereVAO;
-  VistaBufferObject             mSphereVBO;
+  Plugin::Settings::Ring           mRingSettings;
+  std::shared_ptr<VistaTexture>    mTexture;
+  std::shared_ptr<VistaGLSLShader> mShader;
+  VistaVertexArrayObject           mSphereVAO;
+  VistaBufferObject                mSphereVBO;
 
   cs::core::EclipseShadowReceiver mEclipseShadowReceiver;
 
@@ -78,8 +79,12 @@ class Ring : public cs::scene::CelestialObject, public IVistaOpenGLDraw {
     uint32_t sunIlluminance    = 0;
     uint32_t ambientBrightness = 0;
     uint32_t litSideVisible    = 0;
+    uint32_t sunDirection      = 0;
+    uint32_t planetRadii       = 0;
   } mUniforms;
 
+  cs::utils::FrameStats::TimerId mTimerId = cs::utils::FrameStats::intern("Rings");
+
   static const char* SPHERE_VERT;
   static const char* SPHERE_FRAG;
 };
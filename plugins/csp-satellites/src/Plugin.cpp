@@ -45,10 +45,12 @@ void to_json(nlohmann::json& j, Plugin::Settings::Satellite const& o) {
 
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "satellites", o.mSatellites);
+  cs::core::Settings::deserialize(j, "environmentMapCache", o.mEnvironmentMapCache);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "satellites", o.mSatellites);
+  cs::core::Settings::serialize(j, "environmentMapCache", o.mEnvironmentMapCache);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -57,7 +59,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-satellites")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // Load settings.
@@ -85,8 +91,17 @@ void Plugin::deInit() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Plugin::update() {
+
+  // All satellites read their state from the same snapshot, so the Solar System is not queried
+  // once for each of them.
+  auto snapshot = mSolarSystem->getFrameSnapshot();
+
+  if (!snapshot) {
+    return;
+  }
+
   for (auto const& satellite : mSatellites) {
-    satellite->update();
+    satellite->update(*snapshot);
   }
 }
 
@@ -99,9 +114,19 @@ void Plugin::onLoad() {
   // Read settings from JSON.
   mPluginSettings = mAllSettings->mPlugins.at("csp-satellites");
 
+  // Satellites which share a model and an environment map are drawn together.
+  std::map<std::pair<std::string, std::string>, std::vector<std::string>> groups;
+
   for (auto const& settings : mPluginSettings.mSatellites) {
-    mSatellites.push_back(std::make_shared<Satellite>(
-        settings.second, settings.first, mSceneGraph, mAllSettings, mSolarSystem));
+    groups[{settings.second.mModelFile, settings.second.mEnvironmentMap}].push_back(
+        settings.first);
+  }
+
+  for (auto& group : groups) {
+    auto const& config = mPluginSettings.mSatellites.at(group.second.front());
+    mSatellites.push_back(std::make_shared<Satellite>(config, std::move(group.second),
+        mPluginSettings.mEnvironmentMapCache.value_or(""), mSceneGraph, mAllSettings,
+        mSolarSystem));
   }
 }
 
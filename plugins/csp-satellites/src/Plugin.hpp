@@ -39,6 +39,10 @@ class Plugin : public cs::core::PluginBase {
     };
 
     std::map<std::string, Satellite> mSatellites;
+
+    /// If set, the filtered environment maps for image based lighting are stored in this directory
+    /// so that they do not have to be computed again in later sessions.
+    std::optional<std::string> mEnvironmentMapCache;
   };
 
   void init() override;
@@ -25,14 +25,16 @@ namespace csp::satellites {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Satellite::Satellite(Plugin::Settings::Satellite const& config, std::string objectName,
+Satellite::Satellite(Plugin::Settings::Satellite const& config,
+    std::vector<std::string> objectNames, std::string const& environmentMapCache,
     VistaSceneGraph* sceneGraph, std::shared_ptr<cs::core::Settings> settings,
     std::shared_ptr<cs::core::SolarSystem> solarSystem)
     : mSceneGraph(sceneGraph)
     , mSettings(std::move(settings))
     , mSolarSystem(std::move(solarSystem))
-    , mModel(std::make_unique<cs::graphics::GltfLoader>(config.mModelFile, config.mEnvironmentMap))
-    , mObjectName(std::move(objectName)) {
+    , mModel(std::make_unique<cs::graphics::GltfLoader>(
+          config.mModelFile, config.mEnvironmentMap, environmentMapCache))
+    , mObjectNames(std::move(objectNames)) {
 
   mModel->setLightIntensity(15.0);
   mModel->setIBLIntensity(1.5);
@@ -56,29 +58,62 @@ Satellite::~Satellite() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Satellite::update() {
+void Satellite::update(cs::core::SolarSystem::FrameSnapshot const& snapshot) {
 
-  auto object  = mSolarSystem->getObject(mObjectName);
-  bool visible = object && object->getIsBodyVisible();
+  // The model is loaded in the background. Once it has been attached to the anchor, the sort key
+  // has to be set for the new nodes as well.
+  if (mModel->update()) {
+    VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+        mAnchor.get(), static_cast<int>(cs::utils::DrawOrder::eOpaqueItems));
+  }
+
+  // The observer-relative transformations have been computed by the Solar System for this frame.
+  // Invisible satellites are skipped entirely.
+  mTransforms.clear();
 
-  mAnchor->SetIsEnabled(visible);
+  for (auto const& name : mObjectNames) {
+    auto object = snapshot.mObjects.find(name);
+    if (object != snapshot.mObjects.end() && object->second.mIsBodyVisible) {
+      mTransforms.push_back(object->second.mObserverRelativeTransform);
+    }
+  }
 
-  if (visible) {
-    auto const& transform = object->getObserverRelativeTransform();
-    mAnchor->SetTransform(glm::value_ptr(transform), true);
+  if (mTransforms.empty() != mLastTransforms.empty()) {
+    mAnchor->SetIsEnabled(!mTransforms.empty());
+  }
 
-    float sunIlluminance(1.F);
+  // If neither the observer nor the satellites have moved, the scene graph and the instances do
+  // not have to be written.
+  bool moved = mTransforms != mLastTransforms;
+  std::swap(mTransforms, mLastTransforms);
 
-    auto sunDirection = glm::vec3(mSolarSystem->getSunDirection(transform[3]));
+  if (mLastTransforms.empty()) {
+    return;
+  }
 
-    mModel->setLightDirection(sunDirection.x, sunDirection.y, sunDirection.z);
+  auto const& transform = mLastTransforms.front();
 
-    if (mSettings->mGraphics.pEnableHDR.get()) {
-      mModel->setEnableHDR(true);
-      sunIlluminance = static_cast<float>(mSolarSystem->getSunIlluminance(transform[3]));
+  if (moved) {
+    if (mObjectNames.size() == 1) {
+      mAnchor->SetTransform(glm::value_ptr(transform), true);
+    } else {
+      // The anchor keeps its identity transformation, so the instances are placed relative to the
+      // observer.
+      mModel->setInstances(std::vector<glm::mat4>(mLastTransforms.begin(), mLastTransforms.end()));
     }
-    mModel->setLightIntensity(sunIlluminance);
   }
+
+  float sunIlluminance(1.F);
+
+  auto sunDirection = glm::vec3(mSolarSystem->getSunDirection(transform[3]));
+
+  mModel->setLightDirection(sunDirection.x, sunDirection.y, sunDirection.z);
+
+  if (mSettings->mGraphics.pEnableHDR.get()) {
+    mModel->setEnableHDR(true);
+    sunIlluminance = static_cast<float>(mSolarSystem->getSunIlluminance(transform[3]));
+  }
+  mModel->setLightIntensity(sunIlluminance);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,27 +11,29 @@
 #include "Plugin.hpp"
 
 #include "../../../src/cs-core/Settings.hpp"
+#include "../../../src/cs-core/SolarSystem.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <glm/glm.hpp>
 
 namespace cs::graphics {
 class GltfLoader;
 } // namespace cs::graphics
 
-namespace cs::core {
-class Settings;
-class SolarSystem;
-} // namespace cs::core
-
 class VistaTransformNode;
 
 namespace csp::satellites {
 
-/// A single satellite within the Solar System.
+/// All satellites within the Solar System which use the same model and environment map. If there
+/// is only one, it is positioned with a transformation node. Otherwise, all visible satellites are
+/// drawn with instancing, so that a large constellation costs one draw call per primitive of the
+/// model. In this case, they are lit as if they were all at the position of the first visible one.
 class Satellite {
  public:
-  Satellite(Plugin::Settings::Satellite const& config, std::string objectName,
-      VistaSceneGraph* sceneGraph, std::shared_ptr<cs::core::Settings> settings,
+  /// See Plugin::Settings::mEnvironmentMapCache for the environmentMapCache. It may be empty.
+  Satellite(Plugin::Settings::Satellite const& config, std::vector<std::string> objectNames,
+      std::string const& environmentMapCache, VistaSceneGraph* sceneGraph,
+      std::shared_ptr<cs::core::Settings> settings,
       std::shared_ptr<cs::core::SolarSystem> solarSystem);
 
   Satellite(Satellite const& other) = delete;
@@ -42,7 +44,9 @@ class Satellite {
 
   ~Satellite();
 
-  void update();
+  /// Positions the satellites according to the given snapshot of the Solar System. The scene graph
+  /// and the instance buffer are only written if the visible satellites have moved.
+  void update(cs::core::SolarSystem::FrameSnapshot const& snapshot);
 
  private:
   VistaSceneGraph*                          mSceneGraph;
@@ -51,7 +55,12 @@ class Satellite {
   std::unique_ptr<VistaTransformNode>       mAnchor;
   std::unique_ptr<cs::graphics::GltfLoader> mModel;
 
-  std::string mObjectName;
+  std::vector<std::string> mObjectNames;
+
+  // The transformations of the visible satellites of the current and of the last update(). These
+  // are kept to avoid allocations and redundant uploads.
+  std::vector<glm::dmat4> mTransforms;
+  std::vector<glm::dmat4> mLastTransforms;
 };
 } // namespace csp::satellites
 
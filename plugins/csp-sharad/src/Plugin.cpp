@@ -40,12 +40,18 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "anchor", o.mAnchor);
   cs::core::Settings::deserialize(j, "filePath", o.mFilePath);
   cs::core::Settings::deserialize(j, "enabled", o.mEnabled);
+  cs::core::Settings::deserialize(j, "textureDistance", o.mTextureDistance);
+  cs::core::Settings::deserialize(j, "maxRadargrams", o.mMaxRadargrams);
+  cs::core::Settings::deserialize(j, "cacheDirectory", o.mCacheDirectory);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "anchor", o.mAnchor);
   cs::core::Settings::serialize(j, "filePath", o.mFilePath);
   cs::core::Settings::serialize(j, "enabled", o.mEnabled);
+  cs::core::Settings::serialize(j, "textureDistance", o.mTextureDistance);
+  cs::core::Settings::serialize(j, "maxRadargrams", o.mMaxRadargrams);
+  cs::core::Settings::serialize(j, "cacheDirectory", o.mCacheDirectory);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -54,7 +60,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-sharad")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   mGuiManager->executeJavascriptFile("../share/resources/gui/js/csp-sharad.js");
@@ -66,18 +76,39 @@ void Plugin::init() {
       "Enables or disables the rendering of SHARAD profiles.",
       std::function([this](bool enable) { mPluginSettings.mEnabled = enable; }));
 
+  mGuiManager->getGui()->registerCallback("sharad.setProfileEnabled",
+      "Shows or hides the SHARAD profile with the given name.",
+      std::function([this](std::string&& name, bool enable) {
+        for (auto const& sharad : mSharads) {
+          if (sharad->getName() == name) {
+            sharad->setEnabled(enable);
+          }
+        }
+      }));
+
   mPluginSettings.mFilePath.connect([this](std::string const& filePath) {
     // Delete all old Sharad profiles first.
-    for (auto const& node : mSharadNodes) {
-      mSceneGraph->GetRoot()->DisconnectChild(node.get());
+    if (mRendererNode) {
+      mSceneGraph->GetRoot()->DisconnectChild(mRendererNode.get());
     }
 
     mSharads.clear();
-    mSharadNodes.clear();
+    mUnlistedSharads.clear();
+    mRendererNode.reset();
+    mRenderer.reset();
 
     // Clear UI list.
     mGuiManager->getGui()->callJavascript("CosmoScout.gui.clearHtml", "list-sharad");
 
+    // All profiles are drawn by one renderer.
+    mRenderer = std::make_unique<SharadRenderer>(mAllSettings, mGraphicsEngine, mSolarSystem,
+        mPluginSettings.mAnchor, mPluginSettings.mMaxRadargrams.get());
+
+    mRendererNode.reset(mSceneGraph->NewOpenGLNode(mSceneGraph->GetRoot(), mRenderer.get()));
+    VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+        mRendererNode.get(), static_cast<int>(cs::utils::DrawOrder::eOpaqueNonHDR) + 2);
+    mRendererNode->SetIsEnabled(mPluginSettings.mEnabled.get());
+
     // Then add new ones.
     boost::filesystem::path               dir(filePath);
     boost::filesystem::directory_iterator end_iter;
@@ -90,21 +121,13 @@ void Plugin::init() {
           std::string             ext(path.extension().string());
 
           if (ext == ".tab") {
-            std::string sName = file.substr(0, file.length() - 5);
-            auto        sharad =
-                std::make_shared<Sharad>(mAllSettings, mSolarSystem, mPluginSettings.mAnchor,
-                    filePath + sName + "_tiff.tif", filePath + sName + "_geom.tab");
-
-            auto* sharadNode = mSceneGraph->NewOpenGLNode(mSceneGraph->GetRoot(), sharad.get());
-            VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-                sharadNode, static_cast<int>(cs::utils::DrawOrder::eOpaqueNonHDR) + 2);
-            sharadNode->SetIsEnabled(mPluginSettings.mEnabled.get());
+            std::string sName  = file.substr(0, file.length() - 5);
+            auto        sharad = std::make_shared<Sharad>(sName, filePath + sName + "_tiff.tif",
+                filePath + sName + "_geom.tab", mPluginSettings.mCacheDirectory.get());
 
+            mRenderer->addProfile(sharad);
             mSharads.push_back(sharad);
-            mSharadNodes.emplace_back(sharadNode);
-
-            mGuiManager->getGui()->callJavascript(
-                "CosmoScout.sharad.add", sName, sharad->getStartTime() + 10);
+            mUnlistedSharads.push_back(sharad);
           }
         }
       }
@@ -112,8 +135,8 @@ void Plugin::init() {
   });
 
   mPluginSettings.mEnabled.connectAndTouch([this](bool val) {
-    for (auto const& node : mSharadNodes) {
-      node->SetIsEnabled(val);
+    if (mRendererNode) {
+      mRendererNode->SetIsEnabled(val);
     }
   });
 
@@ -139,14 +162,15 @@ void Plugin::deInit() {
   // Save settings as this plugin may get reloaded.
   onSave();
 
-  for (auto const& node : mSharadNodes) {
-    mSceneGraph->GetRoot()->DisconnectChild(node.get());
+  if (mRendererNode) {
+    mSceneGraph->GetRoot()->DisconnectChild(mRendererNode.get());
   }
 
   mGuiManager->removePluginTab("SHARAD Profiles");
 
   mSolarSystem->pActiveObject.disconnect(mActiveObjectConnection);
   mGuiManager->getGui()->unregisterCallback("sharad.setEnabled");
+  mGuiManager->getGui()->unregisterCallback("sharad.setProfileEnabled");
 
   mAllSettings->onLoad().disconnect(mOnLoadConnection);
   mAllSettings->onSave().disconnect(mOnSaveConnection);
@@ -157,8 +181,20 @@ void Plugin::deInit() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Plugin::update() {
-  for (auto const& sharad : mSharads) {
-    sharad->update(mTimeControl->pSimulationTime.get(), mSolarSystem->getObserver().getScale());
+  if (mRenderer) {
+    mRenderer->update(mTimeControl->pSimulationTime.get(), mSolarSystem->getObserver().getScale(),
+        mPluginSettings.mTextureDistance.get() * 1000.0);
+  }
+
+  // The start time of a profile is only known once it has been loaded.
+  for (auto it = mUnlistedSharads.begin(); it != mUnlistedSharads.end();) {
+    if ((*it)->getIsLoaded()) {
+      mGuiManager->getGui()->callJavascript(
+          "CosmoScout.sharad.add", (*it)->getName(), (*it)->getStartTime() + 10);
+      it = mUnlistedSharads.erase(it);
+    } else {
+      ++it;
+    }
   }
 }
 
@@ -10,6 +10,7 @@
 
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "Sharad.hpp"
+#include "SharadRenderer.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 
@@ -23,6 +24,17 @@ class Plugin : public cs::core::PluginBase {
     std::string                      mAnchor;
     cs::utils::Property<std::string> mFilePath;
     cs::utils::DefaultProperty<bool> mEnabled{false};
+
+    /// The radargram of a profile is loaded once it is closer to the observer than this distance
+    /// in kilometers. It is released again at twice this distance.
+    cs::utils::DefaultProperty<double> mTextureDistance{2000.0};
+
+    /// At most this many radargrams are kept on the GPU at the same time. Each requires about 5 MB.
+    cs::utils::DefaultProperty<uint32_t> mMaxRadargrams{32};
+
+    /// Path to the folder where the parsed geometry files are cached, can be absolute or relative
+    /// to the cosmoscout executable.
+    cs::utils::DefaultProperty<std::string> mCacheDirectory{"../share/cache/csp-sharad"};
   };
 
   void init() override;
@@ -33,9 +45,13 @@ class Plugin : public cs::core::PluginBase {
   void onLoad();
   void onSave();
 
-  Settings                                      mPluginSettings;
-  std::vector<std::shared_ptr<Sharad>>          mSharads;
-  std::vector<std::unique_ptr<VistaOpenGLNode>> mSharadNodes;
+  Settings                             mPluginSettings;
+  std::vector<std::shared_ptr<Sharad>> mSharads;
+  std::unique_ptr<SharadRenderer>      mRenderer;
+  std::unique_ptr<VistaOpenGLNode>     mRendererNode;
+
+  // The profiles are added to the user interface once their geometry has been loaded.
+  std::vector<std::shared_ptr<Sharad>> mUnlistedSharads;
 
   int mActiveObjectConnection = -1;
   int mOnLoadConnection       = -1;
@@ -7,125 +7,23 @@
 
 #include "Sharad.hpp"
 
-#include "../../../src/cs-core/SolarSystem.hpp"
-#include "../../../src/cs-graphics/TextureLoader.hpp"
-#include "../../../src/cs-scene/CelestialObserver.hpp"
-#include "../../../src/cs-utils/FrameStats.hpp"
 #include "../../../src/cs-utils/convert.hpp"
+#include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 #include "logger.hpp"
 
-#include <VistaKernel/GraphicsManager/VistaGroupNode.h>
-#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
-#include <VistaKernel/VistaSystem.h>
-#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
-#include <glm/gtc/type_ptr.hpp>
+#include <boost/filesystem.hpp>
 
+#include <chrono>
 #include <cstdio>
+#include <fstream>
 #include <utility>
 
 namespace csp::sharad {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const char* Sharad::VERT = R"(
-#version 330
-
-uniform mat4 uMatModelView;
-uniform mat4 uMatProjection;
-uniform float uHeightScale;
-uniform vec3 uRadii;
-
-// inputs
-layout(location = 0) in vec2  iLngLat;
-layout(location = 1) in vec2  iTexCoords;
-layout(location = 2) in float iTime;
-
-// outputs
-out vec3  vPositionVS;
-out vec4  vPositionSS;
-out vec2  vTexCoords;
-out float vTime;
-
-vec3 geodeticSurfaceNormal(vec2 lngLat) {
-  return vec3(cos(lngLat.y) * sin(lngLat.x), sin(lngLat.y),
-      cos(lngLat.y) * cos(lngLat.x));
-}
-
-vec3 toCartesian(vec2 lonLat, float height) {
-  vec3 n = geodeticSurfaceNormal(lonLat);
-  vec3 k = n * uRadii * uRadii;
-  float gamma = sqrt(dot(k, n));
-  return k / gamma + height * n;
-}
-
-void main()
-{
-    vTexCoords = iTexCoords;
-    vTime      = iTime;
-
-    float height = vTexCoords.y < 0.5 ? 10000 * uHeightScale: -10100 * uHeightScale;
-    vPositionVS  = (uMatModelView * vec4(toCartesian(iLngLat, height), 1.0)).xyz;
-    vPositionSS  = uMatProjection * vec4(vPositionVS, 1);
-    gl_Position  = vPositionSS;
-}
-)";
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-const char* Sharad::FRAG = R"(
-#version 330
-
-uniform mat4 uMatProjection;
-uniform sampler2DRect uDepthBuffer;
-uniform sampler2D uSharadTexture;
-uniform float uAmbientBrightness;
-uniform float uTime;
-uniform float uSceneScale;
-uniform vec2 uViewportPos;
-
-// inputs
-in vec3  vPositionVS;
-in vec4  vPositionSS;
-in vec2  vTexCoords;
-in float vTime;
-
-// outputs
-layout(location = 0) out vec4 oColor;
-
-void main()
-{
-    if (vTime > uTime)
-    {
-        discard;
-    }
-
-    float fDepth = texture(uDepthBuffer,  gl_FragCoord.xy - uViewportPos).r;
-    vec4 surfacePos = inverse(uMatProjection) * vec4(vPositionSS.xy / vPositionSS.w, 2*fDepth-1, 1);
-    float surfaceDistance = length(surfacePos.xyz / surfacePos.w);
-    float sharadDistance  = length(vPositionVS);
-    
-    if (sharadDistance < surfaceDistance)
-    {
-        discard;
-    }
-
-    float val = texture(uSharadTexture, vTexCoords).r;
-    val = mix(1, val, clamp((uTime - vTime), 0, 1));
-
-    oColor.r = pow(val,  0.5);
-    oColor.g = pow(val,  2.0);
-    oColor.b = pow(val, 10.0);
-    oColor.a = 1.0 - clamp((sharadDistance - surfaceDistance) * uSceneScale / 30000, 0.1, 1.0);
-}
-)";
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-std::unique_ptr<VistaTexture>                Sharad::mDepthBuffer     = nullptr;
-std::unique_ptr<Sharad::FramebufferCallback> Sharad::mPreCallback     = nullptr;
-std::unique_ptr<VistaOpenGLNode>             Sharad::mPreCallbackNode = nullptr;
-int                                          Sharad::mInstanceCount   = 0;
+namespace {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -150,46 +48,131 @@ struct ProfileRadarData {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Sharad::Sharad(std::shared_ptr<cs::core::Settings> settings,
-    std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string objectName,
-    std::string const& sTiffFile, std::string const& sTabFile)
-    : mSettings(std::move(settings))
-    , mSolarSystem(std::move(solarSystem))
-    , mTexture(cs::graphics::TextureLoader::loadFromFile(sTiffFile))
-    , mObjectName(std::move(objectName)) {
-
-  if (mInstanceCount == 0) {
-    mDepthBuffer = std::make_unique<VistaTexture>(GL_TEXTURE_RECTANGLE);
-    mDepthBuffer->Bind();
-    mDepthBuffer->SetWrapS(GL_CLAMP);
-    mDepthBuffer->SetWrapT(GL_CLAMP);
-    mDepthBuffer->SetMinFilter(GL_NEAREST);
-    mDepthBuffer->SetMagFilter(GL_NEAREST);
-    mDepthBuffer->Unbind();
-
-    mPreCallback = std::make_unique<FramebufferCallback>(mDepthBuffer.get());
-
-    auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
-    mPreCallbackNode = std::unique_ptr<VistaOpenGLNode>(
-        sceneGraph->NewOpenGLNode(sceneGraph->GetRoot(), mPreCallback.get()));
-
-    VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-        mPreCallbackNode.get(), static_cast<int>(cs::utils::DrawOrder::eOpaqueNonHDR) + 1);
+// The cache file starts with this header, followed by all samples of the profile. The size and the
+// modification time of the geometry file are stored so that the cache is rebuilt if it changes.
+struct CacheHeader {
+  uint32_t mMagic;
+  uint32_t mVersion;
+  uint64_t mSampleCount;
+  uint64_t mTabFileSize;
+  int64_t  mTabFileTime;
+};
+
+uint32_t const cacheMagic   = 0x43524853; // "SHRC"
+uint32_t const cacheVersion = 1;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Sharad::Sharad(std::string sName, std::string sTiffFile, std::string const& sTabFile,
+    std::string const& sCacheDirectory)
+    : mName(std::move(sName))
+    , mTiffFile(std::move(sTiffFile)) {
+
+  std::string sCacheFile =
+      sCacheDirectory + "/" + boost::filesystem::path(sTabFile).stem().string() + ".cache";
+
+  mSampleLoader = std::async(std::launch::async,
+      [sTabFile, sCacheFile]() { return loadSamples(sTabFile, sCacheFile); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& Sharad::getName() const {
+  return mName;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& Sharad::getTiffFile() const {
+  return mTiffFile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Sharad::getIsLoaded() {
+  if (mSampleLoader.valid() &&
+      mSampleLoader.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    mSamples  = mSampleLoader.get();
+    mIsLoaded = !mSamples.empty();
+  }
+
+  return mIsLoaded;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Sharad::Sample> const& Sharad::getSamples() const {
+  return mSamples;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double Sharad::getStartTime() const {
+  return mSamples.empty() ? 0.0 : mSamples.front().mTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Sharad::setEnabled(bool enabled) {
+  mEnabled = enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Sharad::getEnabled() const {
+  return mEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Sharad::setColorMap(glm::vec4 const& colorMap) {
+  mColorMap = colorMap;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec4 const& Sharad::getColorMap() const {
+  return mColorMap;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Sharad::Sample> Sharad::loadSamples(
+    std::string const& sTabFile, std::string const& sCacheFile) {
+
+  std::vector<Sample> samples;
+
+  if (readCache(sCacheFile, sTabFile, samples)) {
+    return samples;
   }
 
-  ++mInstanceCount;
+  samples = parseTabFile(sTabFile);
+
+  if (!samples.empty()) {
+    writeCache(sCacheFile, sTabFile, samples);
+  }
+
+  return samples;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Sharad::Sample> Sharad::parseTabFile(std::string const& sTabFile) {
 
   // Disables a warning in MSVC about using fopen_s and fscanf_s, which aren't supported in GCC.
   CS_WARNINGS_PUSH
   CS_DISABLE_MSVC_WARNING(4996)
 
-  // load metadata -----------------------------------------------------------
   // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
   FILE* pFile = fopen(sTabFile.c_str(), "r");
 
   if (pFile == nullptr) {
     logger().error("Failed to add Sharad data: Cannot open file '{}'!", sTabFile);
-    return;
+    return {};
   }
 
   std::vector<ProfileRadarData> meta;
@@ -208,191 +191,108 @@ Sharad::Sharad(std::shared_ptr<cs::core::Settings> settings,
 
   CS_WARNINGS_POP
 
-  mSamples = static_cast<int>(meta.size());
-
   // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
   fclose(pFile);
 
-  // create geometry ---------------------------------------------------------
-  struct Vertex {
-    glm::vec2 lngLat;
-    glm::vec2 tc;
-    float     time;
-  };
+  if (meta.size() < 2) {
+    logger().error("Failed to add Sharad data: File '{}' contains too few samples!", sTabFile);
+    return {};
+  }
 
-  std::vector<Vertex> vertices(mSamples * 2);
+  std::vector<Sample> samples(meta.size());
 
-  for (int i = 0; i < mSamples; ++i) {
-    double tTime = cs::utils::convert::time::toSpice(
+  for (std::size_t i = 0; i < meta.size(); ++i) {
+    samples[i].mLngLat =
+        cs::utils::convert::toRadians(glm::dvec2(meta[i].Longitude, meta[i].Latitude));
+    samples[i].mTime = cs::utils::convert::time::toSpice(
         boost::posix_time::ptime(boost::gregorian::date(meta[i].Year, meta[i].Month, meta[i].Day),
             boost::posix_time::hours(meta[i].Hour) + boost::posix_time::minutes(meta[i].Minute) +
                 boost::posix_time::seconds(meta[i].Second) +
                 boost::posix_time::milliseconds(meta[i].Millisecond)));
-
-    if (i == 0) {
-      mStartTime = tTime;
-    }
-
-    glm::vec2 lngLat(
-        cs::utils::convert::toRadians(glm::dvec2(meta[i].Longitude, meta[i].Latitude)));
-
-    float x    = 1.F * static_cast<float>(i) / (static_cast<float>(mSamples) - 1.F);
-    auto  time = static_cast<float>(tTime - mStartTime);
-
-    vertices[i * 2 + 0].lngLat = lngLat;
-    vertices[i * 2 + 0].tc     = glm::vec2(x, 1.F);
-    vertices[i * 2 + 0].time   = time;
-    vertices[i * 2 + 1].lngLat = lngLat;
-    vertices[i * 2 + 1].tc     = glm::vec2(x, 0.F);
-    vertices[i * 2 + 1].time   = time;
   }
 
-  mVBO.Bind(GL_ARRAY_BUFFER);
-  mVBO.BufferData(vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-  mVBO.Release();
-
-  mVAO.EnableAttributeArray(0);
-  mVAO.SpecifyAttributeArrayFloat(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0, &mVBO);
-
-  mVAO.EnableAttributeArray(1);
-  mVAO.SpecifyAttributeArrayFloat(
-      1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<GLuint>(offsetof(Vertex, tc)), &mVBO);
-
-  mVAO.EnableAttributeArray(2);
-  mVAO.SpecifyAttributeArrayFloat(
-      2, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<GLuint>(offsetof(Vertex, time)), &mVBO);
-
-  // create sphere shader ----------------------------------------------------
-  mShader.InitVertexShaderFromString(VERT);
-  mShader.InitFragmentShaderFromString(FRAG);
-  mShader.Link();
-
-  mUniforms.modelViewMatrix  = mShader.GetUniformLocation("uMatModelView");
-  mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
-  mUniforms.viewportPosition = mShader.GetUniformLocation("uViewportPos");
-  mUniforms.sharadTexture    = mShader.GetUniformLocation("uSharadTexture");
-  mUniforms.depthBuffer      = mShader.GetUniformLocation("uDepthBuffer");
-  mUniforms.sceneScale       = mShader.GetUniformLocation("uSceneScale");
-  mUniforms.heightScale      = mShader.GetUniformLocation("uHeightScale");
-  mUniforms.radii            = mShader.GetUniformLocation("uRadii");
-  mUniforms.time             = mShader.GetUniformLocation("uTime");
+  return samples;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Sharad::~Sharad() {
-  --mInstanceCount;
+bool Sharad::readCache(
+    std::string const& sCacheFile, std::string const& sTabFile, std::vector<Sample>& samples) {
 
-  if (mInstanceCount == 0) {
-    auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
-    sceneGraph->GetRoot()->DisconnectChild(mPreCallbackNode.get());
+  boost::system::error_code error;
+  auto                      fileSize = boost::filesystem::file_size(sCacheFile, error);
 
-    mPreCallback.reset(nullptr);
-    mDepthBuffer.reset(nullptr);
-    mPreCallbackNode.reset(nullptr);
+  if (error || fileSize < sizeof(CacheHeader)) {
+    return false;
   }
-}
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-double Sharad::getStartTime() const {
-  return mStartTime;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void Sharad::update(double tTime, double sceneScale) {
-  mCurrTime   = tTime;
-  mSceneScale = sceneScale;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-bool Sharad::Do() {
-  auto object = mSolarSystem->getObject(mObjectName);
+  std::ifstream file(sCacheFile.c_str(), std::ios::in | std::ios::binary);
 
-  if (object && object->getIsBodyVisible()) {
-    cs::utils::FrameStats::ScopedTimer timer("Sharad");
+  CacheHeader header{};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
 
-    mShader.Bind();
+  auto tabFileSize = boost::filesystem::file_size(sTabFile, error);
+  auto tabFileTime = boost::filesystem::last_write_time(sTabFile, error);
 
-    // get modelview and projection matrices
-    std::array<GLfloat, 16> glMatMV{};
-    std::array<GLfloat, 16> glMatP{};
-    glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
-    glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
-    auto matMV =
-        glm::make_mat4x4(glMatMV.data()) * glm::mat4(object->getObserverRelativeTransform());
-    glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glm::value_ptr(matMV));
-    glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
-
-    std::array<GLint, 4> iViewport{};
-    glGetIntegerv(GL_VIEWPORT, iViewport.data());
-    mShader.SetUniform(mUniforms.viewportPosition, static_cast<float>(iViewport.at(0)),
-        static_cast<float>(iViewport.at(1)));
-
-    auto radii = object->getRadii();
+  if (!file || error || header.mMagic != cacheMagic || header.mVersion != cacheVersion ||
+      header.mTabFileSize != tabFileSize || header.mTabFileTime != tabFileTime) {
+    return false;
+  }
 
-    mShader.SetUniform(mUniforms.sharadTexture, 0);
-    mShader.SetUniform(mUniforms.depthBuffer, 1);
-    mShader.SetUniform(mUniforms.sceneScale, static_cast<float>(mSceneScale));
-    mShader.SetUniform(mUniforms.heightScale, mSettings->mGraphics.pHeightScale.get());
-    mShader.SetUniform(mUniforms.radii, static_cast<float>(radii[0]), static_cast<float>(radii[1]),
-        static_cast<float>(radii[2]));
-    mShader.SetUniform(mUniforms.time, static_cast<float>(mCurrTime - mStartTime));
+  if (fileSize != sizeof(CacheHeader) + header.mSampleCount * sizeof(Sample)) {
+    logger().warn("Ignoring Sharad cache '{}': The file is truncated!", sCacheFile);
+    return false;
+  }
 
-    mTexture->Bind(GL_TEXTURE0);
-    mDepthBuffer->Bind(GL_TEXTURE1);
+  samples.resize(header.mSampleCount);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.read(reinterpret_cast<char*>(samples.data()),
+      static_cast<std::streamsize>(samples.size() * sizeof(Sample)));
 
-    glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT);
+  return static_cast<bool>(file);
+}
 
-    glEnable(GL_BLEND);
-    glDisable(GL_CULL_FACE);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    // glDepthFunc(GL_GEQUAL);
-    // glDepthMask(false);
-    glDisable(GL_DEPTH_TEST);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    // draw --------------------------------------------------------------------
-    mVAO.Bind();
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, mSamples * 2);
-    mVAO.Release();
+bool Sharad::writeCache(std::string const& sCacheFile, std::string const& sTabFile,
+    std::vector<Sample> const& samples) {
 
-    // clean up ----------------------------------------------------------------
-    glEnable(GL_CULL_FACE);
-    mTexture->Unbind(GL_TEXTURE0);
+  boost::system::error_code error;
 
-    glPopAttrib();
+  CacheHeader header{};
+  header.mMagic       = cacheMagic;
+  header.mVersion     = cacheVersion;
+  header.mSampleCount = samples.size();
+  header.mTabFileSize = boost::filesystem::file_size(sTabFile, error);
+  header.mTabFileTime = boost::filesystem::last_write_time(sTabFile, error);
 
-    mShader.Release();
+  try {
+    cs::utils::filesystem::createDirectoryRecursively(
+        boost::filesystem::path(sCacheFile).parent_path());
+  } catch (std::exception const& e) {
+    logger().warn("Failed to create Sharad cache directory: {}", e.what());
+    return false;
   }
 
-  return true;
-}
+  std::ofstream file;
+  file.open(sCacheFile.c_str(), std::ios::out | std::ios::binary);
+  if (file.is_open()) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.write(reinterpret_cast<const char*>(samples.data()),
+        static_cast<std::streamsize>(samples.size() * sizeof(Sample)));
+    file.close();
+
+    return !file.fail();
+  }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  logger().warn("Failed to write Sharad cache: Cannot open file '{}' for writing!", sCacheFile);
 
-bool Sharad::GetBoundingBox(VistaBoundingBox& /*bb*/) {
   return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Sharad::FramebufferCallback::FramebufferCallback(VistaTexture* pDepthBuffer)
-    : mDepthBuffer(pDepthBuffer) {
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-bool Sharad::FramebufferCallback::Do() {
-  std::array<GLint, 4> iViewport{};
-  glGetIntegerv(GL_VIEWPORT, iViewport.data());
-  mDepthBuffer->Bind();
-  glCopyTexImage2D(GL_TEXTURE_RECTANGLE, 0, GL_DEPTH_COMPONENT, iViewport.at(0), iViewport.at(1),
-      iViewport.at(2), iViewport.at(3), 0);
-  return true;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 } // namespace csp::sharad
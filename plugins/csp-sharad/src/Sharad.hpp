@@ -8,27 +8,29 @@
 #ifndef CSP_SHARAD_HPP
 #define CSP_SHARAD_HPP
 
-#include "../../../src/cs-core/Settings.hpp"
-#include "../../../src/cs-core/SolarSystem.hpp"
+#include <glm/glm.hpp>
 
-#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
-#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
-#include <VistaOGLExt/VistaBufferObject.h>
-#include <VistaOGLExt/VistaGLSLShader.h>
-#include <VistaOGLExt/VistaVertexArrayObject.h>
-
-#include <memory>
-
-class VistaTexture;
+#include <future>
+#include <string>
+#include <vector>
 
 namespace csp::sharad {
 
-/// Renders a single SHARAD image.
-class Sharad : public IVistaOpenGLDraw {
+/// A single SHARAD profile. The geometry file (*_geom.tab) is parsed on a background thread and the
+/// result is stored in a binary file in the cache directory, so that subsequent loads do not have
+/// to parse it again. The profile is drawn together with all other profiles by the SharadRenderer,
+/// which also loads the radargram (*_tiff.tif) once the profile comes close to the observer.
+class Sharad {
  public:
-  Sharad(std::shared_ptr<cs::core::Settings> settings,
-      std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string objectName,
-      std::string const& sTiffFile, std::string const& sTabFile);
+  /// One line of the geometry file. The layout of this struct is also the layout of the samples in
+  /// the binary cache.
+  struct Sample {
+    glm::vec2 mLngLat;
+    double    mTime;
+  };
+
+  Sharad(std::string sName, std::string sTiffFile, std::string const& sTabFile,
+      std::string const& sCacheDirectory);
 
   Sharad(Sharad const& other) = delete;
   Sharad(Sharad&& other)      = delete;
@@ -36,63 +38,43 @@ class Sharad : public IVistaOpenGLDraw {
   Sharad& operator=(Sharad const& other) = delete;
   Sharad& operator=(Sharad&& other) = delete;
 
-  ~Sharad();
+  ~Sharad() = default;
 
-  double getStartTime() const;
+  std::string const& getName() const;
+  std::string const& getTiffFile() const;
 
-  void update(double tTime, double sceneScale);
+  /// Returns true once the geometry file has been loaded. Before, there are no samples and
+  /// getStartTime() returns zero. This has to be called on the main thread.
+  bool                       getIsLoaded();
+  std::vector<Sample> const& getSamples() const;
+  double                     getStartTime() const;
 
-  bool Do() override;
-  bool GetBoundingBox(VistaBoundingBox& bb) override;
+  /// Disabled profiles are not drawn.
+  void setEnabled(bool enabled);
+  bool getEnabled() const;
 
- private:
-  class FramebufferCallback : public IVistaOpenGLDraw {
-   public:
-    explicit FramebufferCallback(VistaTexture* pDepthBuffer);
+  /// The red, green and blue channels are computed by raising the radargram intensity to these
+  /// powers. The fourth component is the opacity of the profile.
+  void             setColorMap(glm::vec4 const& colorMap);
+  glm::vec4 const& getColorMap() const;
 
-    bool Do() override;
-    bool GetBoundingBox(VistaBoundingBox& /*bb*/) override {
-      return true;
-    }
-
-   private:
-    VistaTexture* mDepthBuffer;
-  };
-
-  static std::unique_ptr<VistaTexture>        mDepthBuffer;
-  static std::unique_ptr<FramebufferCallback> mPreCallback;
-  static std::unique_ptr<VistaOpenGLNode>     mPreCallbackNode;
-  static int                                  mInstanceCount;
-
-  std::shared_ptr<cs::core::Settings>    mSettings;
-  std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
-  std::unique_ptr<VistaTexture>          mTexture;
-
-  std::string mObjectName;
-  double      mStartTime;
-
-  VistaGLSLShader        mShader;
-  VistaVertexArrayObject mVAO;
-  VistaBufferObject      mVBO;
-
-  struct {
-    uint32_t modelViewMatrix  = 0;
-    uint32_t projectionMatrix = 0;
-    uint32_t viewportPosition = 0;
-    uint32_t sharadTexture    = 0;
-    uint32_t depthBuffer      = 0;
-    uint32_t sceneScale       = 0;
-    uint32_t heightScale      = 0;
-    uint32_t radii            = 0;
-    uint32_t time             = 0;
-  } mUniforms;
-
-  int    mSamples;
-  double mCurrTime   = -1.0;
-  double mSceneScale = -1.0;
-
-  static const char* VERT;
-  static const char* FRAG;
+ private:
+  static std::vector<Sample> loadSamples(
+      std::string const& sTabFile, std::string const& sCacheFile);
+  static std::vector<Sample> parseTabFile(std::string const& sTabFile);
+  static bool readCache(std::string const& sCacheFile, std::string const& sTabFile,
+      std::vector<Sample>& samples);
+  static bool writeCache(std::string const& sCacheFile, std::string const& sTabFile,
+      std::vector<Sample> const& samples);
+
+  std::string mName;
+  std::string mTiffFile;
+  bool        mIsLoaded = false;
+  bool        mEnabled  = true;
+  glm::vec4   mColorMap{0.5F, 2.F, 10.F, 1.F};
+
+  std::future<std::vector<Sample>> mSampleLoader;
+  std::vector<Sample>              mSamples;
 };
 
 } // namespace csp::sharad
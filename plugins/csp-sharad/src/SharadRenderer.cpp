@@ -0,0 +1,660 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "SharadRenderer.hpp"
+
+#include "../../../src/cs-graphics/FramebufferCopy.hpp"
+#include "../../../src/cs-graphics/GpuMemory.hpp"
+#include "../../../src/cs-graphics/TextureLoader.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/convert.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+#include "logger.hpp"
+
+#include <VistaOGLExt/VistaTexture.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace csp::sharad {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The size of the layers of the radargram texture array. All radargrams are scaled to this size.
+GLsizei const RADARGRAM_WIDTH  = 4096;
+GLsizei const RADARGRAM_HEIGHT = 1024;
+GLsizei const RADARGRAM_LEVELS = 13;
+
+// At most this many radargrams are decoded at the same time, as each one requires a temporary
+// texture with its full resolution.
+std::size_t const MAX_CONCURRENT_LOADS = 2;
+
+// The number of samples per culled segment. A SHARAD profile usually consists of some ten thousand
+// samples, so this results in about hundred segments per profile.
+std::size_t const SEGMENT_SAMPLES = 256;
+
+// The profiles extend at most this far above or below the surface, see the vertex shader.
+double const PROFILE_EXTENT = 10100.0;
+
+uint32_t const SAMPLE_BINDING  = 0;
+uint32_t const PROFILE_BINDING = 1;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns false if the given sphere in view space is completely outside of the frustum of the given
+// projection matrix. The far plane is not tested.
+bool isInFrustum(glm::mat4 const& matP, glm::vec3 const& center, float radius) {
+  auto rows = glm::transpose(matP);
+
+  std::array<glm::vec4, 5> planes{rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+      rows[3] - rows[1], rows[3] + rows[2]};
+
+  return std::all_of(planes.begin(), planes.end(), [&](glm::vec4 const& plane) {
+    return glm::dot(glm::vec3(plane), center) + plane.w >= -radius * glm::length(glm::vec3(plane));
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* SharadRenderer::VERT = R"(
+#version 430
+
+struct Sample {
+  vec2  lngLat;
+  float time;
+  float texCoord;
+  uint  profile;
+  uint  padding;
+};
+
+layout(std430, binding = 0) readonly buffer SampleBuffer {
+  Sample uSamples[];
+};
+
+uniform mat4 uMatModelView;
+uniform mat4 uMatProjection;
+uniform float uHeightScale;
+uniform vec3 uRadii;
+
+// outputs
+out vec3  vPositionVS;
+out vec4  vPositionSS;
+out vec2  vTexCoords;
+out float vTime;
+flat out uint vProfile;
+
+vec3 geodeticSurfaceNormal(vec2 lngLat) {
+  return vec3(cos(lngLat.y) * sin(lngLat.x), sin(lngLat.y),
+      cos(lngLat.y) * cos(lngLat.x));
+}
+
+vec3 toCartesian(vec2 lonLat, float height) {
+  vec3 n = geodeticSurfaceNormal(lonLat);
+  vec3 k = n * uRadii * uRadii;
+  float gamma = sqrt(dot(k, n));
+  return k / gamma + height * n;
+}
+
+void main()
+{
+    // Each sample is drawn as two vertices, the even one at the bottom of the profile.
+    Sample s   = uSamples[gl_VertexID / 2];
+    vTexCoords = vec2(s.texCoord, gl_VertexID % 2 == 0 ? 1.0 : 0.0);
+    vTime      = s.time;
+    vProfile   = s.profile;
+
+    float height = vTexCoords.y < 0.5 ? 10000 * uHeightScale: -10100 * uHeightScale;
+    vPositionVS  = (uMatModelView * vec4(toCartesian(s.lngLat, height), 1.0)).xyz;
+    vPositionSS  = uMatProjection * vec4(vPositionVS, 1);
+    gl_Position  = vPositionSS;
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* SharadRenderer::FRAG = R"(
+#version 430
+
+struct Profile {
+  vec4  colorMap;
+  float time;
+  int   layer;
+  vec2  padding;
+};
+
+layout(std430, binding = 1) readonly buffer ProfileBuffer {
+  Profile uProfiles[];
+};
+
+uniform mat4 uMatProjection;
+uniform sampler2D uDepthBuffer;
+uniform sampler2DArray uRadargrams;
+uniform float uSceneScale;
+uniform vec2 uViewportPos;
+
+// inputs
+in vec3  vPositionVS;
+in vec4  vPositionSS;
+in vec2  vTexCoords;
+in float vTime;
+flat in uint vProfile;
+
+// outputs
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    Profile profile = uProfiles[vProfile];
+
+    if (vTime > profile.time)
+    {
+        discard;
+    }
+
+    float fDepth = texelFetch(uDepthBuffer, ivec2(gl_FragCoord.xy - uViewportPos), 0).r;
+    vec4 surfacePos = inverse(uMatProjection) * vec4(vPositionSS.xy / vPositionSS.w, 2*fDepth-1, 1);
+    float surfaceDistance = length(surfacePos.xyz / surfacePos.w);
+    float sharadDistance  = length(vPositionVS);
+
+    if (sharadDistance < surfaceDistance)
+    {
+        discard;
+    }
+
+    // Profiles whose radargram is not loaded are drawn with a constant value.
+    float val = 0.5;
+
+    if (profile.layer >= 0) {
+      val = texture(uRadargrams, vec3(vTexCoords, profile.layer)).r;
+    }
+
+    val = mix(1, val, clamp((profile.time - vTime), 0, 1));
+
+    oColor.rgb = pow(vec3(val), profile.colorMap.rgb);
+    oColor.a   = profile.colorMap.a *
+               (1.0 - clamp((sharadDistance - surfaceDistance) * uSceneScale / 30000, 0.1, 1.0));
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SharadRenderer::SharadRenderer(std::shared_ptr<cs::core::Settings> settings,
+    std::shared_ptr<cs::core::GraphicsEngine> graphicsEngine,
+    std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string objectName,
+    uint32_t maxRadargrams)
+    : mSettings(std::move(settings))
+    , mGraphicsEngine(std::move(graphicsEngine))
+    , mSolarSystem(std::move(solarSystem))
+    , mObjectName(std::move(objectName))
+    , mMaxRadargrams(maxRadargrams) {
+
+  glGenBuffers(1, &mSampleBuffer);
+  glGenBuffers(1, &mProfileBuffer);
+
+  mShader.InitVertexShaderFromString(VERT);
+  mShader.InitFragmentShaderFromString(FRAG);
+  mShader.Link();
+
+  mUniforms.modelViewMatrix  = mShader.GetUniformLocation("uMatModelView");
+  mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
+  mUniforms.viewportPosition = mShader.GetUniformLocation("uViewportPos");
+  mUniforms.radargrams       = mShader.GetUniformLocation("uRadargrams");
+  mUniforms.depthBuffer      = mShader.GetUniformLocation("uDepthBuffer");
+  mUniforms.sceneScale       = mShader.GetUniformLocation("uSceneScale");
+  mUniforms.heightScale      = mShader.GetUniformLocation("uHeightScale");
+  mUniforms.radii            = mShader.GetUniformLocation("uRadii");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SharadRenderer::~SharadRenderer() {
+  glDeleteBuffers(1, &mSampleBuffer);
+  glDeleteBuffers(1, &mProfileBuffer);
+  cs::graphics::GpuMemory::get().release("SHARAD Profiles", mBufferBytes);
+
+  if (mRadargramArray != 0) {
+    glDeleteTextures(1, &mRadargramArray);
+    cs::graphics::GpuMemory::get().release("SHARAD Radargrams", mArrayBytes);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::addProfile(std::shared_ptr<Sharad> profile) {
+  Profile p;
+  p.mSharad = std::move(profile);
+  mProfiles.push_back(std::move(p));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::update(double tTime, double sceneScale, double textureDistance) {
+  mCurrTime   = tTime;
+  mSceneScale = sceneScale;
+
+  for (uint32_t i = 0; i < mProfiles.size(); ++i) {
+    if (!mProfiles[i].mIsUploaded && mProfiles[i].mSharad->getIsLoaded()) {
+      uploadSamples(i);
+    }
+  }
+
+  updateRadargrams(textureDistance);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::uploadSamples(uint32_t profileIndex) {
+  auto&       profile   = mProfiles[profileIndex];
+  auto const& samples   = profile.mSharad->getSamples();
+  double      startTime = profile.mSharad->getStartTime();
+
+  profile.mIsUploaded = true;
+
+  if (samples.size() < 2) {
+    return;
+  }
+
+  std::vector<GpuSample> gpuSamples(samples.size());
+
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    gpuSamples[i].mLngLat   = samples[i].mLngLat;
+    gpuSamples[i].mTime     = static_cast<float>(samples[i].mTime - startTime);
+    gpuSamples[i].mTexCoord = static_cast<float>(i) / (static_cast<float>(samples.size()) - 1.F);
+    gpuSamples[i].mProfile  = profileIndex;
+    gpuSamples[i].mPadding  = 0;
+  }
+
+  // If the buffer is too small, a larger one is created and the samples of the already loaded
+  // profiles are copied on the GPU.
+  if (mSampleCount + samples.size() > mSampleCapacity) {
+    std::size_t capacity = std::max(2 * mSampleCapacity, mSampleCount + samples.size());
+
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(GpuSample)),
+        nullptr, GL_STATIC_DRAW);
+
+    if (mSampleCount > 0) {
+      glBindBuffer(GL_COPY_READ_BUFFER, mSampleBuffer);
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+          static_cast<GLsizeiptr>(mSampleCount * sizeof(GpuSample)));
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &mSampleBuffer);
+
+    mSampleBuffer   = buffer;
+    mSampleCapacity = capacity;
+
+    cs::graphics::GpuMemory::get().release("SHARAD Profiles", mBufferBytes);
+    mBufferBytes = mSampleCapacity * sizeof(GpuSample);
+    cs::graphics::GpuMemory::get().allocate("SHARAD Profiles", mBufferBytes);
+  }
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSampleBuffer);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+      static_cast<GLintptr>(mSampleCount * sizeof(GpuSample)),
+      static_cast<GLsizeiptr>(gpuSamples.size() * sizeof(GpuSample)), gpuSamples.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  // Consecutive segments share their boundary sample, so that there are no gaps between them.
+  for (std::size_t first = 0; first + 1 < samples.size(); first += SEGMENT_SAMPLES) {
+    std::size_t last = std::min(first + SEGMENT_SAMPLES, samples.size() - 1);
+
+    Segment segment;
+    segment.mStartTime = samples[first].mTime;
+    segment.mFirst     = static_cast<GLint>((mSampleCount + first) * 2);
+    segment.mCount     = static_cast<GLsizei>((last - first + 1) * 2);
+    profile.mSegments.push_back(segment);
+  }
+
+  mSampleCount += samples.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::updateSegmentBounds(
+    Profile& profile, glm::dvec3 const& radii, float heightScale) {
+
+  auto const& samples     = profile.mSharad->getSamples();
+  auto        firstSample = static_cast<std::size_t>(profile.mSegments.front().mFirst / 2);
+
+  for (auto& segment : profile.mSegments) {
+    auto first = static_cast<std::size_t>(segment.mFirst / 2) - firstSample;
+    auto last  = first + static_cast<std::size_t>(segment.mCount / 2);
+
+    glm::dvec3 minPos(std::numeric_limits<double>::max());
+    glm::dvec3 maxPos(std::numeric_limits<double>::lowest());
+
+    for (std::size_t i = first; i < last; ++i) {
+      auto pos = cs::utils::convert::toCartesian(glm::dvec2(samples[i].mLngLat), radii);
+      minPos   = glm::min(minPos, pos);
+      maxPos   = glm::max(maxPos, pos);
+    }
+
+    segment.mCenter = (minPos + maxPos) * 0.5;
+    segment.mRadius = 0.0;
+
+    for (std::size_t i = first; i < last; ++i) {
+      auto pos        = cs::utils::convert::toCartesian(glm::dvec2(samples[i].mLngLat), radii);
+      segment.mRadius = std::max(segment.mRadius, glm::distance(pos, segment.mCenter));
+    }
+
+    segment.mRadius += PROFILE_EXTENT * heightScale;
+  }
+
+  profile.mBoundsRadii       = radii;
+  profile.mBoundsHeightScale = heightScale;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::updateRadargrams(double textureDistance) {
+
+  // Radargrams which have been uploaded completely by the TextureLoader are copied to their layer.
+  for (auto& profile : mProfiles) {
+    if (profile.mRadargram &&
+        !cs::graphics::TextureLoader::getIsPending(profile.mRadargram.get())) {
+      copyRadargram(profile);
+    }
+  }
+
+  // The radargrams are released only at twice the loading distance. Else they would be loaded over
+  // and over again if the observer hovers around the texture distance. Profiles which have not
+  // been drawn in the last frame have an infinite distance.
+  std::vector<Profile*> candidates;
+
+  for (auto& profile : mProfiles) {
+    if (profile.mLayer >= 0 && profile.mClosestDistance > 2.0 * textureDistance) {
+      releaseRadargram(profile);
+    } else if (profile.mLayer < 0 && !profile.mRadargramFailed &&
+               profile.mClosestDistance < textureDistance) {
+      candidates.push_back(&profile);
+    }
+  }
+
+  if (candidates.empty()) {
+    return;
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [](Profile const* a, Profile const* b) {
+    return a->mClosestDistance < b->mClosestDistance;
+  });
+
+  if (mRadargramArray == 0) {
+    createRadargramArray();
+  }
+
+  auto loading = static_cast<std::size_t>(std::count_if(mProfiles.begin(), mProfiles.end(),
+      [](Profile const& profile) { return profile.mRadargram != nullptr; }));
+
+  // The closest profiles get a layer first. If all layers are in use, the remaining profiles are
+  // drawn without radargram until a layer is released.
+  for (auto* profile : candidates) {
+    if (loading >= MAX_CONCURRENT_LOADS || mFreeLayers.empty()) {
+      break;
+    }
+
+    profile->mLayer = mFreeLayers.back();
+    mFreeLayers.pop_back();
+
+    profile->mRadargram =
+        cs::graphics::TextureLoader::loadFromFileAsync(profile->mSharad->getTiffFile());
+
+    // This only happens if a *.tga file could not be loaded. It is not tried again.
+    if (!profile->mRadargram) {
+      releaseRadargram(*profile);
+      profile->mRadargramFailed = true;
+    }
+
+    ++loading;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::copyRadargram(Profile& profile) {
+  GLint width  = 0;
+  GLint height = 0;
+
+  profile.mRadargram->Bind();
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+  profile.mRadargram->Unbind();
+
+  // The radargram is copied into its layer with a filtered blit, which also converts between the
+  // different formats and resolutions. The coarser levels are computed from the next finer one, so
+  // that the other layers are not touched.
+  GLint previousReadFramebuffer = 0;
+  GLint previousDrawFramebuffer = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDrawFramebuffer);
+
+  std::array<GLuint, 2> framebuffers{};
+  glGenFramebuffers(2, framebuffers.data());
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+
+  glPushAttrib(GL_SCISSOR_BIT);
+  glDisable(GL_SCISSOR_TEST);
+
+  glFramebufferTexture2D(
+      GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, profile.mRadargram->GetId(), 0);
+  glFramebufferTextureLayer(
+      GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mRadargramArray, 0, profile.mLayer);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, RADARGRAM_WIDTH, RADARGRAM_HEIGHT,
+      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+  for (GLint level = 1; level < RADARGRAM_LEVELS; ++level) {
+    glFramebufferTextureLayer(
+        GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mRadargramArray, level - 1, profile.mLayer);
+    glFramebufferTextureLayer(
+        GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mRadargramArray, level, profile.mLayer);
+    glBlitFramebuffer(0, 0, std::max(RADARGRAM_WIDTH >> (level - 1), 1),
+        std::max(RADARGRAM_HEIGHT >> (level - 1), 1), 0, 0, std::max(RADARGRAM_WIDTH >> level, 1),
+        std::max(RADARGRAM_HEIGHT >> level, 1), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  }
+
+  glPopAttrib();
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFramebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDrawFramebuffer);
+  glDeleteFramebuffers(2, framebuffers.data());
+
+  // The full-resolution texture is not needed anymore.
+  profile.mRadargram.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::createRadargramArray() {
+  glGenTextures(1, &mRadargramArray);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, mRadargramArray);
+  glTexStorage3D(GL_TEXTURE_2D_ARRAY, RADARGRAM_LEVELS, GL_R8, RADARGRAM_WIDTH, RADARGRAM_HEIGHT,
+      static_cast<GLsizei>(mMaxRadargrams));
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  // The mipmap levels require another third of the memory of the first level.
+  mArrayBytes = static_cast<std::size_t>(RADARGRAM_WIDTH) *
+                static_cast<std::size_t>(RADARGRAM_HEIGHT) * mMaxRadargrams * 4 / 3;
+  cs::graphics::GpuMemory::get().allocate("SHARAD Radargrams", mArrayBytes);
+
+  // The layers are handed out starting with layer zero.
+  for (auto layer = static_cast<int32_t>(mMaxRadargrams) - 1; layer >= 0; --layer) {
+    mFreeLayers.push_back(layer);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharadRenderer::releaseRadargram(Profile& profile) {
+  if (profile.mLayer >= 0) {
+    mFreeLayers.push_back(profile.mLayer);
+  }
+
+  profile.mLayer = -1;
+  profile.mRadargram.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool SharadRenderer::Do() {
+  auto object = mSolarSystem->getObject(mObjectName);
+
+  for (auto& profile : mProfiles) {
+    profile.mClosestDistance = std::numeric_limits<double>::max();
+  }
+
+  if (mSampleCount == 0 || !object || !object->getIsBodyVisible()) {
+    return true;
+  }
+
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
+
+  auto radii       = object->getRadii();
+  auto heightScale = mSettings->mGraphics.pHeightScale.get();
+
+  // get modelview and projection matrices
+  std::array<GLfloat, 16> glMatMV{};
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+  auto matMV =
+      glm::make_mat4x4(glMatMV.data()) * glm::mat4(object->getObserverRelativeTransform());
+  auto matP  = glm::make_mat4x4(glMatP.data());
+  auto scale = glm::length(glm::vec3(matMV[0]));
+
+  // Collect the segments of all profiles which are already recorded and which are inside the view
+  // frustum. Profiles which are disabled or which have not started yet are skipped entirely.
+  mDrawFirsts.clear();
+  mDrawCounts.clear();
+  mGpuProfiles.resize(mProfiles.size());
+
+  for (std::size_t i = 0; i < mProfiles.size(); ++i) {
+    auto&  profile   = mProfiles[i];
+    auto&  sharad    = *profile.mSharad;
+    double startTime = sharad.getStartTime();
+
+    mGpuProfiles[i].mColorMap = sharad.getColorMap();
+    mGpuProfiles[i].mTime     = static_cast<float>(mCurrTime - startTime);
+    mGpuProfiles[i].mLayer    = profile.mRadargram ? -1 : profile.mLayer;
+    mGpuProfiles[i].mPadding  = glm::vec2(0.F);
+
+    if (profile.mSegments.empty() || !sharad.getEnabled() || mCurrTime < startTime) {
+      continue;
+    }
+
+    if (radii != profile.mBoundsRadii || heightScale != profile.mBoundsHeightScale) {
+      updateSegmentBounds(profile, radii, heightScale);
+    }
+
+    for (auto const& segment : profile.mSegments) {
+      if (segment.mStartTime > mCurrTime) {
+        break;
+      }
+
+      glm::vec3 center(matMV * glm::vec4(glm::vec3(segment.mCenter), 1.F));
+      float     radius = scale * static_cast<float>(segment.mRadius);
+
+      if (isInFrustum(matP, center, radius)) {
+        mDrawFirsts.push_back(segment.mFirst);
+        mDrawCounts.push_back(segment.mCount);
+
+        double distance = std::max(0.0, static_cast<double>(glm::length(center) - radius));
+        profile.mClosestDistance = std::min(profile.mClosestDistance, distance * mSceneScale);
+      }
+    }
+  }
+
+  if (mDrawFirsts.empty()) {
+    return true;
+  }
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mProfileBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+      static_cast<GLsizeiptr>(sizeof(GpuProfile) * mGpuProfiles.size()), mGpuProfiles.data(),
+      GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  mShader.Bind();
+
+  glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glm::value_ptr(matMV));
+  glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+
+  std::array<GLint, 4> iViewport{};
+  glGetIntegerv(GL_VIEWPORT, iViewport.data());
+  mShader.SetUniform(mUniforms.viewportPosition, static_cast<float>(iViewport.at(0)),
+      static_cast<float>(iViewport.at(1)));
+
+  mShader.SetUniform(mUniforms.radargrams, 0);
+  mShader.SetUniform(mUniforms.depthBuffer, 1);
+  mShader.SetUniform(mUniforms.sceneScale, static_cast<float>(mSceneScale));
+  mShader.SetUniform(mUniforms.heightScale, heightScale);
+  mShader.SetUniform(mUniforms.radii, static_cast<float>(radii[0]), static_cast<float>(radii[1]),
+      static_cast<float>(radii[2]));
+
+  VistaTexture* depthBuffer = mGraphicsEngine->getFramebufferCopy()->get(
+      cs::graphics::FramebufferCopy::Attachment::eDepth,
+      static_cast<int>(cs::utils::DrawOrder::eOpaqueNonHDR) + 2);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, mRadargramArray);
+  depthBuffer->Bind(GL_TEXTURE1);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SAMPLE_BINDING, mSampleBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PROFILE_BINDING, mProfileBuffer);
+
+  glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT);
+
+  glEnable(GL_BLEND);
+  glDisable(GL_CULL_FACE);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDisable(GL_DEPTH_TEST);
+
+  // draw --------------------------------------------------------------------
+  mVAO.Bind();
+  glMultiDrawArrays(GL_TRIANGLE_STRIP, mDrawFirsts.data(), mDrawCounts.data(),
+      static_cast<GLsizei>(mDrawFirsts.size()));
+  mVAO.Release();
+
+  // clean up ----------------------------------------------------------------
+  glPopAttrib();
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SAMPLE_BINDING, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PROFILE_BINDING, 0);
+
+  depthBuffer->Unbind(GL_TEXTURE1);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  mShader.Release();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool SharadRenderer::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::sharad
@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_SHARAD_SHARAD_RENDERER_HPP
+#define CSP_SHARAD_SHARAD_RENDERER_HPP
+
+#include "Sharad.hpp"
+
+#include "../../../src/cs-core/GraphicsEngine.hpp"
+#include "../../../src/cs-core/Settings.hpp"
+#include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <VistaOGLExt/VistaVertexArrayObject.h>
+#include <glm/glm.hpp>
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+class VistaTexture;
+
+namespace csp::sharad {
+
+/// Draws all SHARAD profiles of a planet as curtains hanging below the surface with a single draw
+/// call. The samples of all profiles are stored in one shader storage buffer, the parameters of
+/// each profile, like its current time and its color map, in another one which is updated once a
+/// frame. Each profile is split into segments along the ground track which are culled individually
+/// against the view frustum, the visible segments of all profiles are drawn with one
+/// glMultiDrawArrays() call.
+///
+/// The radargrams are stored in the layers of a texture array. A radargram is loaded once a visible
+/// segment of its profile comes closer to the observer than the texture distance given to update().
+/// It is decoded asynchronously by the TextureLoader and then scaled to the layer size with a
+/// filtered blit. Its layer is released again once the profile is farther away than twice this
+/// distance. Profiles without radargram are drawn in a uniform color.
+class SharadRenderer : public IVistaOpenGLDraw {
+ public:
+  /// At most maxRadargrams radargrams are resident on the GPU at the same time.
+  SharadRenderer(std::shared_ptr<cs::core::Settings> settings,
+      std::shared_ptr<cs::core::GraphicsEngine> graphicsEngine,
+      std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string objectName,
+      uint32_t maxRadargrams);
+
+  SharadRenderer(SharadRenderer const& other) = delete;
+  SharadRenderer(SharadRenderer&& other)      = delete;
+
+  SharadRenderer& operator=(SharadRenderer const& other) = delete;
+  SharadRenderer& operator=(SharadRenderer&& other) = delete;
+
+  ~SharadRenderer() override;
+
+  /// Profiles are drawn as soon as their geometry has been loaded.
+  void addProfile(std::shared_ptr<Sharad> profile);
+
+  /// This has to be called once a frame on the main thread. The textureDistance is given in meters.
+  void update(double tTime, double sceneScale, double textureDistance);
+
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  /// A sample as it is stored in the shader storage buffer (std430 layout). Each sample results
+  /// in two vertices, one at the top and one at the bottom of the curtain.
+  struct GpuSample {
+    glm::vec2 mLngLat;
+    float     mTime;
+    float     mTexCoord;
+    uint32_t  mProfile;
+    uint32_t  mPadding;
+  };
+
+  /// The per-profile parameters as they are stored in the shader storage buffer (std430 layout).
+  struct GpuProfile {
+    glm::vec4 mColorMap;
+    float     mTime;
+    int32_t   mLayer;
+    glm::vec2 mPadding;
+  };
+
+  /// A part of a profile which is culled as a whole. The bounding sphere is given in planet
+  /// coordinates, mFirst and mCount refer to the vertices of the segment.
+  struct Segment {
+    glm::dvec3 mCenter{0.0};
+    double     mRadius    = 0.0;
+    double     mStartTime = 0.0;
+    GLint      mFirst     = 0;
+    GLsizei    mCount     = 0;
+  };
+
+  struct Profile {
+    std::shared_ptr<Sharad> mSharad;
+    bool                    mIsUploaded = false;
+    std::vector<Segment>    mSegments;
+    glm::dvec3              mBoundsRadii{0.0};
+    float                   mBoundsHeightScale = -1.F;
+
+    // The layer of the radargram in the texture array. While the radargram is being loaded,
+    // mRadargram is set and the layer is reserved already.
+    int32_t                       mLayer = -1;
+    std::shared_ptr<VistaTexture> mRadargram;
+    bool                          mRadargramFailed = false;
+
+    // The distance in meters between the observer and the closest visible segment during the last
+    // frame.
+    double mClosestDistance = std::numeric_limits<double>::max();
+  };
+
+  void uploadSamples(uint32_t profileIndex);
+  void updateSegmentBounds(Profile& profile, glm::dvec3 const& radii, float heightScale);
+  void updateRadargrams(double textureDistance);
+  void copyRadargram(Profile& profile);
+  void createRadargramArray();
+  void releaseRadargram(Profile& profile);
+
+  std::shared_ptr<cs::core::Settings>       mSettings;
+  std::shared_ptr<cs::core::GraphicsEngine> mGraphicsEngine;
+  std::shared_ptr<cs::core::SolarSystem>    mSolarSystem;
+  std::string                               mObjectName;
+
+  std::vector<Profile>    mProfiles;
+  std::vector<GpuProfile> mGpuProfiles;
+  std::vector<GLint>      mDrawFirsts;
+  std::vector<GLsizei>    mDrawCounts;
+
+  uint32_t    mSampleBuffer   = 0;
+  std::size_t mSampleCount    = 0;
+  std::size_t mSampleCapacity = 0;
+  uint32_t    mProfileBuffer  = 0;
+  std::size_t mBufferBytes    = 0;
+
+  uint32_t             mRadargramArray = 0;
+  uint32_t             mMaxRadargrams  = 0;
+  std::size_t          mArrayBytes     = 0;
+  std::vector<int32_t> mFreeLayers;
+
+  VistaGLSLShader        mShader;
+  VistaVertexArrayObject mVAO;
+
+  struct {
+    uint32_t modelViewMatrix  = 0;
+    uint32_t projectionMatrix = 0;
+    uint32_t viewportPosition = 0;
+    uint32_t radargrams       = 0;
+    uint32_t depthBuffer      = 0;
+    uint32_t sceneScale       = 0;
+    uint32_t heightScale      = 0;
+    uint32_t radii            = 0;
+  } mUniforms;
+
+  cs::utils::FrameStats::TimerId mTimerId = cs::utils::FrameStats::intern("Sharad");
+
+  double mCurrTime   = -1.0;
+  double mSceneScale = -1.0;
+
+  static const char* VERT;
+  static const char* FRAG;
+};
+
+} // namespace csp::sharad
+
+#endif // CSP_SHARAD_SHARAD_RENDERER_HPP
@@ -75,7 +75,15 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  // All bodies are culled and drawn together in one render pass.
+  mDrawList = std::make_shared<cs::core::DrawList>(mGraphicsEngine, mSolarSystem, "Simple Bodies",
+      static_cast<int>(cs::utils::DrawOrder::ePlanets));
+
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-simple-bodies")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // Load settings.
@@ -96,6 +104,8 @@ void Plugin::deInit() {
     unregisterBody(name);
   }
 
+  mDrawList.reset();
+
   mAllSettings->onLoad().disconnect(mOnLoadConnection);
   mAllSettings->onSave().disconnect(mOnSaveConnection);
 
@@ -140,7 +150,7 @@ void Plugin::onLoad() {
       continue;
     }
 
-    auto simpleBody = std::make_shared<SimpleBody>(mAllSettings, mSolarSystem);
+    auto simpleBody = std::make_shared<SimpleBody>(mAllSettings, mSolarSystem, mDrawList);
     simpleBody->setObjectName(settings.first);
     simpleBody->configure(settings.second);
 
@@ -15,6 +15,10 @@
 #include <optional>
 #include <string>
 
+namespace cs::core {
+class DrawList;
+} // namespace cs::core
+
 namespace csp::simplebodies {
 
 class SimpleBody;
@@ -56,6 +60,7 @@ class Plugin : public cs::core::PluginBase {
   void unregisterBody(std::string const& name);
 
   Settings                                           mPluginSettings;
+  std::shared_ptr<cs::core::DrawList>                mDrawList;
   std::map<std::string, std::shared_ptr<SimpleBody>> mSimpleBodies;
 
   int mOnLoadConnection = -1;
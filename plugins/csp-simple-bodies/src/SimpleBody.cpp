@@ -9,26 +9,120 @@
 
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-graphics/ShaderCache.hpp"
 #include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
-#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
-#include <VistaKernel/GraphicsManager/VistaTransformNode.h>
-#include <VistaKernel/VistaSystem.h>
-#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
-#include <VistaMath/VistaBoundingBox.h>
 #include <VistaOGLExt/VistaOGLUtils.h>
 
+#include <cstdint>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/component_wise.hpp>
+#include <map>
 #include <utility>
 
 namespace csp::simplebodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const uint32_t GRID_RESOLUTION_X = 200;
-const uint32_t GRID_RESOLUTION_Y = 100;
+namespace {
+
+// The sphere is drawn with the first of these grids whose minimum radius is smaller than the
+// apparent radius of the body in pixels.
+struct SphereLOD {
+  uint32_t mResolutionX;
+  uint32_t mResolutionY;
+  double   mMinPixelRadius;
+};
+
+const std::array<SphereLOD, SimpleBody::SPHERE_LOD_COUNT> SPHERE_LODS = {{
+    {200, 100, 100.0},
+    {64, 32, 20.0},
+    {16, 8, 0.0},
+}};
+
+// Bodies with a smaller apparent radius in pixels are drawn as a single point.
+const double IMPOSTOR_PIXEL_RADIUS = 1.0;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct SimpleBody::SphereMesh {
+  SphereMesh(uint32_t resolutionX, uint32_t resolutionY);
+
+  VistaVertexArrayObject mVAO;
+  VistaBufferObject      mVBO;
+  VistaBufferObject      mIBO;
+  GLsizei                mIndexCount = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SimpleBody::SphereMesh::SphereMesh(uint32_t resolutionX, uint32_t resolutionY) {
+
+  // For rendering the sphere, we create a 2D-grid which is warped into a sphere in the vertex
+  // shader. The vertex positions are directly used as texture coordinates.
+  std::vector<float>    vertices(resolutionX * resolutionY * 2);
+  std::vector<unsigned> indices((resolutionX - 1) * (2 + 2 * resolutionY));
+
+  for (uint32_t x = 0; x < resolutionX; ++x) {
+    for (uint32_t y = 0; y < resolutionY; ++y) {
+      vertices[(x * resolutionY + y) * 2 + 0] = 1.F / (resolutionX - 1) * x;
+      vertices[(x * resolutionY + y) * 2 + 1] = 1.F / (resolutionY - 1) * y;
+    }
+  }
+
+  uint32_t index = 0;
+
+  for (uint32_t x = 0; x < resolutionX - 1; ++x) {
+    indices[index++] = x * resolutionY;
+    for (uint32_t y = 0; y < resolutionY; ++y) {
+      indices[index++] = x * resolutionY + y;
+      indices[index++] = (x + 1) * resolutionY + y;
+    }
+    indices[index] = indices[index - 1];
+    ++index;
+  }
+
+  mIndexCount = static_cast<GLsizei>(indices.size());
+
+  mVAO.Bind();
+
+  mVBO.Bind(GL_ARRAY_BUFFER);
+  mVBO.BufferData(vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+  mIBO.Bind(GL_ELEMENT_ARRAY_BUFFER);
+  mIBO.BufferData(indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
+
+  mVAO.EnableAttributeArray(0);
+  mVAO.SpecifyAttributeArrayFloat(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0, &mVBO);
+
+  mVAO.Release();
+  mIBO.Release();
+  mVBO.Release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<SimpleBody::SphereMesh> SimpleBody::getSphereMesh(
+    uint32_t resolutionX, uint32_t resolutionY) {
+
+  // The meshes are only referenced weakly, so they are deleted together with the last body. This
+  // is important as the plugin may be unloaded while the OpenGL context still exists.
+  static std::map<std::pair<uint32_t, uint32_t>, std::weak_ptr<SphereMesh>> cache;
+
+  auto& cached = cache[{resolutionX, resolutionY}];
+  auto  mesh   = cached.lock();
+
+  if (!mesh) {
+    mesh   = std::make_shared<SphereMesh>(resolutionX, resolutionY);
+    cached = mesh;
+  }
+
+  return mesh;
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -232,51 +326,72 @@ void main() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-SimpleBody::SimpleBody(std::shared_ptr<cs::core::Settings> settings,
-    std::shared_ptr<cs::core::SolarSystem>                 solarSystem)
-    : mSettings(std::move(settings))
-    , mSolarSystem(std::move(solarSystem))
-    , mEclipseShadowReceiver(mSettings, mSolarSystem, false) {
+const char* SimpleBody::IMPOSTOR_VERT = R"(
+uniform vec3 uPosition;
+uniform mat4 uMatView;
+uniform mat4 uMatProjection;
 
-  // For rendering the sphere, we create a 2D-grid which is warped into a sphere in the vertex
-  // shader. The vertex positions are directly used as texture coordinates.
-  std::vector<float>    vertices(GRID_RESOLUTION_X * GRID_RESOLUTION_Y * 2);
-  std::vector<unsigned> indices((GRID_RESOLUTION_X - 1) * (2 + 2 * GRID_RESOLUTION_Y));
+void main() {
+  gl_Position = uMatProjection * uMatView * vec4(uPosition, 1);
+}
+)";
 
-  for (uint32_t x = 0; x < GRID_RESOLUTION_X; ++x) {
-    for (uint32_t y = 0; y < GRID_RESOLUTION_Y; ++y) {
-      vertices[(x * GRID_RESOLUTION_Y + y) * 2 + 0] = 1.F / (GRID_RESOLUTION_X - 1) * x;
-      vertices[(x * GRID_RESOLUTION_Y + y) * 2 + 1] = 1.F / (GRID_RESOLUTION_Y - 1) * y;
-    }
-  }
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  uint32_t index = 0;
+const char* SimpleBody::IMPOSTOR_FRAG = R"(
+uniform sampler2D uSurfaceTexture;
+uniform float uAmbientBrightness;
+uniform float uSunIlluminance;
+uniform float uLitFraction;
+uniform float uCoverage;
 
-  for (uint32_t x = 0; x < GRID_RESOLUTION_X - 1; ++x) {
-    indices[index++] = x * GRID_RESOLUTION_Y;
-    for (uint32_t y = 0; y < GRID_RESOLUTION_Y; ++y) {
-      indices[index++] = x * GRID_RESOLUTION_Y + y;
-      indices[index++] = (x + 1) * GRID_RESOLUTION_Y + y;
-    }
-    indices[index] = indices[index - 1];
-    ++index;
-  }
+// outputs
+layout(location = 0) out vec3 oColor;
 
-  mSphereVAO.Bind();
+const float PI = 3.141592654;
+const float E  = 2.718281828;
 
-  mSphereVBO.Bind(GL_ARRAY_BUFFER);
-  mSphereVBO.BufferData(vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+vec3 SRGBtoLINEAR(vec3 srgbIn) {
+  vec3 bLess = step(vec3(0.04045),srgbIn);
+  return mix( srgbIn/vec3(12.92), pow((srgbIn+vec3(0.055))/vec3(1.055),vec3(2.4)), bLess );
+}
+
+void main() {
+    // The last mipmap level contains the average color of the surface.
+    oColor = textureLod(uSurfaceTexture, vec2(0.5), 100.0).rgb;
+
+    #ifdef ENABLE_HDR
+      float ambient = pow(uAmbientBrightness, E);
+      oColor = SRGBtoLINEAR(oColor) * uSunIlluminance / PI;
+    #else
+      float ambient = uAmbientBrightness;
+      oColor = oColor * uSunIlluminance;
+    #endif
+
+    #ifdef ENABLE_LIGHTING
+      oColor = mix(oColor * uLitFraction, oColor, ambient);
+    #endif
+
+    // The body only covers a part of the pixel.
+    oColor *= uCoverage;
+}
+)";
 
-  mSphereIBO.Bind(GL_ELEMENT_ARRAY_BUFFER);
-  mSphereIBO.BufferData(indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  mSphereVAO.EnableAttributeArray(0);
-  mSphereVAO.SpecifyAttributeArrayFloat(
-      0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0, &mSphereVBO);
+SimpleBody::SimpleBody(std::shared_ptr<cs::core::Settings> settings,
+    std::shared_ptr<cs::core::SolarSystem>                 solarSystem,
+    std::shared_ptr<cs::core::DrawList>                    drawList)
+    : mSettings(std::move(settings))
+    , mSolarSystem(std::move(solarSystem))
+    , mDrawList(std::move(drawList))
+    , mEclipseShadowReceiver(mSettings, mSolarSystem, false) {
 
-  mSphereVAO.Release();
-  mSphereIBO.Release();
-  mSphereVBO.Release();
+  // The sphere meshes are shared by all bodies.
+  for (std::size_t i(0); i < SPHERE_LOD_COUNT; ++i) {
+    mSphereLODs.at(i) =
+        getSphereMesh(SPHERE_LODS.at(i).mResolutionX, SPHERE_LODS.at(i).mResolutionY);
+  }
 
   // Recreate the shader if lighting or HDR rendering mode are toggled.
   mEnableLightingConnection = mSettings->mGraphics.pEnableLighting.connect(
@@ -284,11 +399,7 @@ SimpleBody::SimpleBody(std::shared_ptr<cs::core::Settings> settings,
   mEnableHDRConnection =
       mSettings->mGraphics.pEnableHDR.connect([this](bool /*enabled*/) { mShaderDirty = true; });
 
-  // Add to scenegraph.
-  VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
-  mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
-  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-      mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::ePlanets));
+  mDrawList->add(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -297,19 +408,21 @@ SimpleBody::~SimpleBody() {
   mSettings->mGraphics.pEnableLighting.disconnect(mEnableLightingConnection);
   mSettings->mGraphics.pEnableHDR.disconnect(mEnableHDRConnection);
 
-  VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
-  pSG->GetRoot()->DisconnectChild(mGLNode.get());
+  mDrawList->remove(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SimpleBody::configure(Plugin::Settings::SimpleBody const& settings) {
   if (mSimpleBodySettings.mTexture != settings.mTexture) {
-    mTexture = cs::graphics::TextureLoader::loadFromFile(settings.mTexture);
+    mTexture = cs::graphics::TextureLoader::loadFromFileAsync(settings.mTexture);
+
+    // Only the coarse mip levels are loaded until the body is seen from closer, see Do().
+    cs::graphics::TextureLoader::setRequiredWidth(mTexture.get(), 0.0);
   }
 
   if (settings.mRing && mSimpleBodySettings.mRing->mTexture != settings.mRing->mTexture) {
-    mRingTexture = cs::graphics::TextureLoader::loadFromFile(settings.mRing->mTexture);
+    mRingTexture = cs::graphics::TextureLoader::loadFromFileAsync(settings.mRing->mTexture);
   }
 
   if (mSimpleBodySettings.mPrimeMeridianInCenter != settings.mPrimeMeridianInCenter) {
@@ -322,7 +435,9 @@ void SimpleBody::configure(Plugin::Settings::SimpleBody const& settings) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SimpleBody::setObjectName(std::string objectName) {
-  mObjectName = std::move(objectName);
+  mObjectName    = std::move(objectName);
+  mUpdateTimerId = cs::utils::FrameStats::intern("Update " + mObjectName);
+  mDrawTimerId   = cs::utils::FrameStats::intern("Draw " + mObjectName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -382,25 +497,38 @@ void SimpleBody::update() {
 
   if (parent && parent->getIsBodyVisible()) {
     cs::utils::FrameStats::ScopedTimer timer(
-        "Update " + parent->getCenterName(), cs::utils::FrameStats::TimerMode::eCPU);
+        mUpdateTimerId, cs::utils::FrameStats::TimerMode::eCPU);
     mEclipseShadowReceiver.update(*parent);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool SimpleBody::Do() {
-  auto parent = mSolarSystem->getObject(mObjectName);
+double SimpleBody::getBoundingRadius(cs::scene::CelestialObject const& object) const {
+  double radius = glm::compMax(object.getRadii());
 
-  if (!parent || !parent->getIsBodyVisible()) {
-    return true;
+  if (mSimpleBodySettings.mRing) {
+    radius = std::max(radius, mSimpleBodySettings.mRing->mOuterRadius);
   }
 
-  cs::utils::FrameStats::ScopedTimer timer("Draw " + parent->getCenterName());
+  return radius;
+}
 
-  if (mShaderDirty || mEclipseShadowReceiver.needsRecompilation()) {
-    mShader = VistaGLSLShader();
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t SimpleBody::getStateKey() const {
+  return reinterpret_cast<uintptr_t>(mShader.get());
+}
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SimpleBody::draw() {
+  // The DrawList only calls this if the object exists and is visible.
+  auto parent = mSolarSystem->getObject(mObjectName);
+
+  cs::utils::FrameStats::ScopedTimer timer(mDrawTimerId);
+
+  if (mShaderDirty || mEclipseShadowReceiver.needsRecompilation()) {
     // (Re-)create sphere shader.
     std::string defines = "#version 430\n";
 
@@ -426,32 +554,41 @@ bool SimpleBody::Do() {
     cs::utils::replaceString(
         frag, "ECLIPSE_SHADER_SNIPPET", mEclipseShadowReceiver.getShaderSnippet());
 
-    mShader.InitVertexShaderFromString(vert);
-    mShader.InitFragmentShaderFromString(frag);
-    mShader.Link();
+    mShader = cs::graphics::ShaderCache::get().getShader(vert, frag);
 
-    mUniforms.sunDirection      = mShader.GetUniformLocation("uSunDirection");
-    mUniforms.sunIlluminance    = mShader.GetUniformLocation("uSunIlluminance");
-    mUniforms.ambientBrightness = mShader.GetUniformLocation("uAmbientBrightness");
-    mUniforms.modelMatrix       = mShader.GetUniformLocation("uMatModel");
-    mUniforms.viewMatrix        = mShader.GetUniformLocation("uMatView");
-    mUniforms.projectionMatrix  = mShader.GetUniformLocation("uMatProjection");
-    mUniforms.surfaceTexture    = mShader.GetUniformLocation("uSurfaceTexture");
-    mUniforms.radii             = mShader.GetUniformLocation("uRadii");
+    mUniforms.sunDirection      = mShader->GetUniformLocation("uSunDirection");
+    mUniforms.sunIlluminance    = mShader->GetUniformLocation("uSunIlluminance");
+    mUniforms.ambientBrightness = mShader->GetUniformLocation("uAmbientBrightness");
+    mUniforms.modelMatrix       = mShader->GetUniformLocation("uMatModel");
+    mUniforms.viewMatrix        = mShader->GetUniformLocation("uMatView");
+    mUniforms.projectionMatrix  = mShader->GetUniformLocation("uMatProjection");
+    mUniforms.surfaceTexture    = mShader->GetUniformLocation("uSurfaceTexture");
+    mUniforms.radii             = mShader->GetUniformLocation("uRadii");
 
     if (mSimpleBodySettings.mRing) {
-      mUniforms.ringTexture = mShader.GetUniformLocation("uRingTexture");
-      mUniforms.ringRadii   = mShader.GetUniformLocation("uRingRadii");
+      mUniforms.ringTexture = mShader->GetUniformLocation("uRingTexture");
+      mUniforms.ringRadii   = mShader->GetUniformLocation("uRingRadii");
     }
 
     // We bind the eclipse shadow map to texture unit 2.
-    mEclipseShadowReceiver.init(&mShader, 2);
+    mEclipseShadowReceiver.init(mShader.get(), 2);
+
+    // The impostor shader does not need the ring and eclipse shadows.
+    mImpostorShader = cs::graphics::ShaderCache::get().getShader(
+        defines + IMPOSTOR_VERT, defines + IMPOSTOR_FRAG);
+
+    mImpostorUniforms.position          = mImpostorShader->GetUniformLocation("uPosition");
+    mImpostorUniforms.viewMatrix        = mImpostorShader->GetUniformLocation("uMatView");
+    mImpostorUniforms.projectionMatrix  = mImpostorShader->GetUniformLocation("uMatProjection");
+    mImpostorUniforms.surfaceTexture    = mImpostorShader->GetUniformLocation("uSurfaceTexture");
+    mImpostorUniforms.sunIlluminance    = mImpostorShader->GetUniformLocation("uSunIlluminance");
+    mImpostorUniforms.ambientBrightness = mImpostorShader->GetUniformLocation("uAmbientBrightness");
+    mImpostorUniforms.litFraction       = mImpostorShader->GetUniformLocation("uLitFraction");
+    mImpostorUniforms.coverage          = mImpostorShader->GetUniformLocation("uCoverage");
 
     mShaderDirty = false;
   }
 
-  mShader.Bind();
-
   glm::vec3 sunDirection(1, 0, 0);
   float     sunIlluminance(1.F);
   float     ambientBrightness(mSettings->mGraphics.pAmbientBrightness.get());
@@ -480,10 +617,6 @@ bool SimpleBody::Do() {
         glm::inverse(transform) * glm::dvec4(mSolarSystem->getSunDirection(transform[3]), 0.0);
   }
 
-  mShader.SetUniform(mUniforms.sunDirection, sunDirection[0], sunDirection[1], sunDirection[2]);
-  mShader.SetUniform(mUniforms.sunIlluminance, sunIlluminance);
-  mShader.SetUniform(mUniforms.ambientBrightness, ambientBrightness);
-
   // Get modelview and projection matrices.
   std::array<GLfloat, 16> glMatV{};
   std::array<GLfloat, 16> glMatP{};
@@ -491,12 +624,70 @@ bool SimpleBody::Do() {
   glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
   auto matM = glm::mat4(transform);
   auto matV = glm::make_mat4x4(glMatV.data());
+
+  // The apparent radius of the body in pixels decides how detailed it is drawn.
+  std::array<GLint, 4> viewport{};
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
+
+  double pixelRadius = glm::compMax(parent->getRadii()) * glm::length(transform[0]) /
+                       glm::length(transform[3].xyz()) * glMatP[5] * viewport[3] * 0.5;
+
+  // The finer mip levels of the surface texture are loaded once they are required. The texture
+  // wraps around the body once, close to the surface the texel density depends on the altitude.
+  {
+    double radius   = glm::compMax(parent->getRadii()) * glm::length(transform[0]);
+    double altitude = std::max(glm::length(transform[3].xyz()) - radius, 0.001 * radius);
+    double pixels   = 2.0 * glm::pi<double>() * radius / altitude * glMatP[5] * viewport[3] * 0.5;
+    cs::graphics::TextureLoader::setRequiredWidth(mTexture.get(), pixels);
+  }
+
+  if (pixelRadius < IMPOSTOR_PIXEL_RADIUS) {
+    mImpostorShader->Bind();
+
+    // The brightness of the point is chosen so that the body emits the same amount of light as if
+    // it were drawn as a sphere. For a Lambertian sphere, the lit part of the disc is about
+    // (1 + cos(phase)) / 2 and the average brightness of a fully lit disc is two thirds of the
+    // brightness at its center.
+    float litFraction = 1.F;
+    if (parent != mSolarSystem->getSun()) {
+      glm::dvec3 toSun      = mSolarSystem->getSunDirection(transform[3]);
+      glm::dvec3 toObserver = glm::normalize(-transform[3].xyz());
+      litFraction = static_cast<float>((1.0 + glm::dot(toSun, toObserver)) / 3.0);
+    }
+
+    glm::vec3 position(transform[3]);
+    mImpostorShader->SetUniform(mImpostorUniforms.position, position[0], position[1], position[2]);
+    mImpostorShader->SetUniform(mImpostorUniforms.sunIlluminance, sunIlluminance);
+    mImpostorShader->SetUniform(mImpostorUniforms.ambientBrightness, ambientBrightness);
+    mImpostorShader->SetUniform(mImpostorUniforms.litFraction, litFraction);
+    mImpostorShader->SetUniform(mImpostorUniforms.coverage,
+        static_cast<float>(glm::pi<double>() * pixelRadius * pixelRadius));
+    glUniformMatrix4fv(mImpostorUniforms.viewMatrix, 1, GL_FALSE, glm::value_ptr(matV));
+    glUniformMatrix4fv(mImpostorUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
+
+    mImpostorShader->SetUniform(mImpostorUniforms.surfaceTexture, 0);
+    mTexture->Bind(GL_TEXTURE0);
+
+    glDrawArrays(GL_POINTS, 0, 1);
+
+    mTexture->Unbind(GL_TEXTURE0);
+    mImpostorShader->Release();
+
+    return;
+  }
+
+  mShader->Bind();
+
+  mShader->SetUniform(mUniforms.sunDirection, sunDirection[0], sunDirection[1], sunDirection[2]);
+  mShader->SetUniform(mUniforms.sunIlluminance, sunIlluminance);
+  mShader->SetUniform(mUniforms.ambientBrightness, ambientBrightness);
+
   glUniformMatrix4fv(mUniforms.modelMatrix, 1, GL_FALSE, glm::value_ptr(matM));
   glUniformMatrix4fv(mUniforms.viewMatrix, 1, GL_FALSE, glm::value_ptr(matV));
   glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
 
   glm::vec3 radii = parent->getRadii();
-  mShader.SetUniform(mUniforms.radii, radii[0], radii[1], radii[2]);
+  mShader->SetUniform(mUniforms.radii, radii[0], radii[1], radii[2]);
 
   // Set the texture wrapping on the x-axis to repeat, so we can easily deal with textures, where
   // the prime meridian is not in the center.
@@ -504,27 +695,33 @@ bool SimpleBody::Do() {
   glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &wrapMode);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 
-  mShader.SetUniform(mUniforms.surfaceTexture, 0);
+  mShader->SetUniform(mUniforms.surfaceTexture, 0);
   mTexture->Bind(GL_TEXTURE0);
 
   if (mSimpleBodySettings.mRing) {
-    mShader.SetUniform(mUniforms.ringRadii,
+    mShader->SetUniform(mUniforms.ringRadii,
         static_cast<float>(mSimpleBodySettings.mRing->mInnerRadius * parent->getScale() /
                            mSolarSystem->getObserver().getScale()),
         static_cast<float>(mSimpleBodySettings.mRing->mOuterRadius * parent->getScale() /
                            mSolarSystem->getObserver().getScale()));
-    mShader.SetUniform(mUniforms.ringTexture, 1);
+    mShader->SetUniform(mUniforms.ringTexture, 1);
     mRingTexture->Bind(GL_TEXTURE1);
   }
 
   // Initialize eclipse shadow-related uniforms and textures.
   mEclipseShadowReceiver.preRender();
 
-  // Draw.
-  mSphereVAO.Bind();
-  glDrawElements(GL_TRIANGLE_STRIP, (GRID_RESOLUTION_X - 1) * (2 + 2 * GRID_RESOLUTION_Y),
-      GL_UNSIGNED_INT, nullptr);
-  mSphereVAO.Release();
+  // Draw. Bodies which are far away are drawn with fewer vertices.
+  std::size_t lod = 0;
+  while (pixelRadius < SPHERE_LODS.at(lod).mMinPixelRadius) {
+    ++lod;
+  }
+
+  auto const& sphere = mSphereLODs.at(lod);
+
+  sphere->mVAO.Bind();
+  glDrawElements(GL_TRIANGLE_STRIP, sphere->mIndexCount, GL_UNSIGNED_INT, nullptr);
+  sphere->mVAO.Release();
 
   // Reset eclipse shadow-related texture units.
   mEclipseShadowReceiver.postRender();
@@ -536,17 +733,9 @@ bool SimpleBody::Do() {
     mRingTexture->Unbind();
   }
 
-  mShader.Release();
+  mShader->Release();
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
-
-  return true;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-bool SimpleBody::GetBoundingBox(VistaBoundingBox& /*bb*/) {
-  return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -8,18 +8,19 @@
 #ifndef CSP_SIMPLE_BODIES_SIMPLE_PLANET_HPP
 #define CSP_SIMPLE_BODIES_SIMPLE_PLANET_HPP
 
-#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
-#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaTexture.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include "../../../src/cs-core/DrawList.hpp"
 #include "../../../src/cs-core/EclipseShadowReceiver.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-scene/CelestialSurface.hpp"
 #include "../../../src/cs-scene/IntersectableObject.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 
+#include <array>
 #include <memory>
 
 #include "Plugin.hpp"
@@ -31,13 +32,17 @@ class SolarSystem;
 namespace csp::simplebodies {
 
 /// This is just a sphere with a texture, attached to the given SPICE frame. The texture should be
-/// in equirectangular projection.
+/// in equirectangular projection. All bodies are drawn by the DrawList of the Plugin.
 class SimpleBody : public cs::scene::CelestialSurface,
                    public cs::scene::IntersectableObject,
-                   public IVistaOpenGLDraw {
+                   public cs::core::DrawList::Drawable {
  public:
+  /// The number of sphere meshes with different resolutions. Smaller bodies use coarser meshes.
+  static constexpr std::size_t SPHERE_LOD_COUNT = 3;
+
   SimpleBody(std::shared_ptr<cs::core::Settings> settings,
-      std::shared_ptr<cs::core::SolarSystem>     solarSystem);
+      std::shared_ptr<cs::core::SolarSystem>     solarSystem,
+      std::shared_ptr<cs::core::DrawList>        drawList);
 
   SimpleBody(SimpleBody const& other) = delete;
   SimpleBody(SimpleBody&& other)      = default;
@@ -52,7 +57,7 @@ class SimpleBody : public cs::scene::CelestialSurface,
 
   /// The body is attached to this object.
   void               setObjectName(std::string objectName);
-  std::string const& getObjectName() const;
+  std::string const& getObjectName() const override;
 
   void update();
 
@@ -63,26 +68,36 @@ class SimpleBody : public cs::scene::CelestialSurface,
   /// Interface implementation of CelestialSurface.
   double getHeight(glm::dvec2 lngLat) const override;
 
-  /// Interface implementation of IVistaOpenGLDraw.
-  bool Do() override;
-  bool GetBoundingBox(VistaBoundingBox& bb) override;
+  /// Interface implementation of DrawList::Drawable. The bounding sphere includes the ring and the
+  /// state key is the address of the sphere shader.
+  double   getBoundingRadius(cs::scene::CelestialObject const& object) const override;
+  uint64_t getStateKey() const override;
+  void     draw() override;
 
  private:
   std::shared_ptr<cs::core::Settings>    mSettings;
   std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
+  std::shared_ptr<cs::core::DrawList>    mDrawList;
+
+  std::string                    mObjectName;
+  cs::utils::FrameStats::TimerId mUpdateTimerId{};
+  cs::utils::FrameStats::TimerId mDrawTimerId{};
+
+  Plugin::Settings::SimpleBody     mSimpleBodySettings;
+  std::shared_ptr<VistaTexture>    mTexture;
+  std::shared_ptr<VistaGLSLShader> mShader;
 
-  std::string mObjectName;
+  // A grid which is warped into a sphere in the vertex shader. The meshes are shared by all
+  // bodies, the shaders are shared by the ShaderCache.
+  struct SphereMesh;
+  static std::shared_ptr<SphereMesh> getSphereMesh(uint32_t resolutionX, uint32_t resolutionY);
 
-  std::unique_ptr<VistaOpenGLNode> mGLNode;
+  std::array<std::shared_ptr<SphereMesh>, SPHERE_LOD_COUNT> mSphereLODs;
 
-  Plugin::Settings::SimpleBody  mSimpleBodySettings;
-  std::unique_ptr<VistaTexture> mTexture;
-  VistaGLSLShader               mShader;
-  VistaVertexArrayObject        mSphereVAO;
-  VistaBufferObject             mSphereVBO;
-  VistaBufferObject             mSphereIBO;
+  // Bodies which are smaller than a pixel are drawn as a single point with this shader.
+  std::shared_ptr<VistaGLSLShader> mImpostorShader;
 
-  std::unique_ptr<VistaTexture> mRingTexture;
+  std::shared_ptr<VistaTexture> mRingTexture;
 
   cs::core::EclipseShadowReceiver mEclipseShadowReceiver;
 
@@ -104,8 +119,21 @@ class SimpleBody : public cs::scene::CelestialSurface,
     uint32_t ringRadii         = 0;
   } mUniforms;
 
+  struct {
+    uint32_t position          = 0;
+    uint32_t viewMatrix        = 0;
+    uint32_t projectionMatrix  = 0;
+    uint32_t surfaceTexture    = 0;
+    uint32_t sunIlluminance    = 0;
+    uint32_t ambientBrightness = 0;
+    uint32_t litFraction       = 0;
+    uint32_t coverage          = 0;
+  } mImpostorUniforms;
+
   static const char* SPHERE_VERT;
   static const char* SPHERE_FRAG;
+  static const char* IMPOSTOR_VERT;
+  static const char* IMPOSTOR_FRAG;
 };
 
 } // namespace csp::simplebodies
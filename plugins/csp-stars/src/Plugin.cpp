@@ -37,6 +37,31 @@ namespace csp::stars {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Returns the catalogs which are configured in the given settings.
+std::map<Stars::CatalogType, std::string> getCatalogs(Plugin::Settings const& settings) {
+  std::map<Stars::CatalogType, std::string> catalogs;
+
+  if (settings.mHipparcosCatalog) {
+    catalogs[Stars::CatalogType::eHipparcos] = *settings.mHipparcosCatalog;
+  }
+
+  if (settings.mTychoCatalog) {
+    catalogs[Stars::CatalogType::eTycho] = *settings.mTychoCatalog;
+  }
+
+  if (settings.mTycho2Catalog) {
+    catalogs[Stars::CatalogType::eTycho2] = *settings.mTycho2Catalog;
+  }
+
+  return catalogs;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "celestialGridTexture", o.mCelestialGridTexture);
   cs::core::Settings::deserialize(j, "starFiguresTexture", o.mStarFiguresTexture);
@@ -54,6 +79,12 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "drawMode", o.mDrawMode);
   cs::core::Settings::deserialize(j, "size", o.mSize);
   cs::core::Settings::deserialize(j, "magnitudeRange", o.mMagnitudeRange);
+  cs::core::Settings::deserialize(j, "maxGPUStars", o.mMaxGPUStars);
+  cs::core::Settings::deserialize(j, "enableSplatting", o.mEnableSplatting);
+  cs::core::Settings::deserialize(j, "splatMagnitude", o.mSplatMagnitude);
+  cs::core::Settings::deserialize(j, "enableCubemap", o.mEnableCubemap);
+  cs::core::Settings::deserialize(j, "cubemapResolution", o.mCubemapResolution);
+  cs::core::Settings::deserialize(j, "cubemapMagnitude", o.mCubemapMagnitude);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
@@ -73,6 +104,25 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "drawMode", o.mDrawMode);
   cs::core::Settings::serialize(j, "size", o.mSize);
   cs::core::Settings::serialize(j, "magnitudeRange", o.mMagnitudeRange);
+  cs::core::Settings::serialize(j, "maxGPUStars", o.mMaxGPUStars);
+  cs::core::Settings::serialize(j, "enableSplatting", o.mEnableSplatting);
+  cs::core::Settings::serialize(j, "splatMagnitude", o.mSplatMagnitude);
+  cs::core::Settings::serialize(j, "enableCubemap", o.mEnableCubemap);
+  cs::core::Settings::serialize(j, "cubemapResolution", o.mCubemapResolution);
+  cs::core::Settings::serialize(j, "cubemapMagnitude", o.mCubemapMagnitude);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::prepare(nlohmann::json const& pluginSettings) {
+
+  // Reading the star cache, or parsing the catalogs if there is no valid cache yet, takes most of
+  // the startup time of this plugin. The stars are only uploaded in onLoad().
+  Settings settings;
+  from_json(pluginSettings, settings);
+
+  mPreparedCatalogs = Stars::loadCatalogs(getCatalogs(settings),
+      settings.mCacheFile.value_or("star_cache.dat"), settings.mMaxGPUStars.get());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -81,7 +131,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-stars")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // Create the Stars object based on the settings.
@@ -99,6 +153,13 @@ void Plugin::init() {
   mPluginSettings.mEnabled.connect([this](bool val) { mStarsNode->SetIsEnabled(val); });
   mPluginSettings.mDrawMode.connect([this](Stars::DrawMode val) { mStars->setDrawMode(val); });
   mPluginSettings.mSize.connect([this](float val) { mStars->setSolidAngle(val * 0.0001F); });
+  mPluginSettings.mEnableSplatting.connect([this](bool val) { mStars->setEnableSplatting(val); });
+  mPluginSettings.mSplatMagnitude.connect([this](float val) { mStars->setSplatMagnitude(val); });
+  mPluginSettings.mEnableCubemap.connect([this](bool val) { mStars->setEnableCubemap(val); });
+  mPluginSettings.mCubemapResolution.connect(
+      [this](uint32_t val) { mStars->setCubemapResolution(val); });
+  mPluginSettings.mCubemapMagnitude.connect(
+      [this](float val) { mStars->setCubemapMagnitude(val); });
   mPluginSettings.mMagnitudeRange.connect([this](glm::vec2 const& val) {
     mStars->setMinMagnitude(val.x);
     mStars->setMaxMagnitude(val.y);
@@ -106,7 +167,7 @@ void Plugin::init() {
 
   // Add the stars user interface components to the CosmoScout user interface.
   mGuiManager->addSettingsSectionToSideBarFromHTML(
-      "Stars", "star", "../share/resources/gui/stars_settings.html");
+      "Stars", "star", "../share/resources/gui/stars_settings.html", true);
 
   mGuiManager->executeJavascriptFile("../share/resources/gui/js/csp-stars.js");
 
@@ -264,22 +325,19 @@ void Plugin::onLoad() {
   mStars->setStarFiguresColor(VistaColor(bg2.r, bg2.g, bg2.b, bg2.a));
 
   mStars->setCacheFile(mPluginSettings.mCacheFile.value_or("star_cache.dat"));
+  mStars->setMaxGPUStars(mPluginSettings.mMaxGPUStars.get());
 
-  std::map<Stars::CatalogType, std::string> catalogs;
-
-  if (mPluginSettings.mHipparcosCatalog) {
-    catalogs[Stars::CatalogType::eHipparcos] = *mPluginSettings.mHipparcosCatalog;
-  }
-
-  if (mPluginSettings.mTychoCatalog) {
-    catalogs[Stars::CatalogType::eTycho] = *mPluginSettings.mTychoCatalog;
-  }
+  auto catalogs = getCatalogs(mPluginSettings);
 
-  if (mPluginSettings.mTycho2Catalog) {
-    catalogs[Stars::CatalogType::eTycho2] = *mPluginSettings.mTycho2Catalog;
+  // Use the stars loaded by prepare() unless the settings have been changed in the meantime.
+  if (mPreparedCatalogs && mPreparedCatalogs->mCatalogs == catalogs &&
+      mPreparedCatalogs->mCacheFile == mStars->getCacheFile()) {
+    mStars->setCatalogData(std::move(*mPreparedCatalogs));
+  } else {
+    mStars->setCatalogs(catalogs);
   }
 
-  mStars->setCatalogs(catalogs);
+  mPreparedCatalogs.reset();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,8 +40,24 @@ class Plugin : public cs::core::PluginBase {
     cs::utils::DefaultProperty<Stars::DrawMode> mDrawMode{Stars::DrawMode::eSmoothDisc};
     cs::utils::DefaultProperty<float>           mSize{0.05F};
     cs::utils::DefaultProperty<glm::vec2>       mMagnitudeRange{glm::vec2(-5.F, 15.F)};
+
+    /// If a catalog contains more stars than this, the stars are streamed to the GPU. This limits
+    /// the graphics memory used for stars to 28 bytes per star. Zero disables streaming.
+    cs::utils::DefaultProperty<uint32_t> mMaxGPUStars{0};
+
+    /// If enabled, stars fainter than mSplatMagnitude are accumulated by a compute shader instead
+    /// of being drawn according to mDrawMode. This is much faster for dense catalogs.
+    cs::utils::DefaultProperty<bool>  mEnableSplatting{false};
+    cs::utils::DefaultProperty<float> mSplatMagnitude{6.F};
+
+    /// If enabled, the background and all stars fainter than mCubemapMagnitude are rendered into
+    /// a cubemap which is only updated when the stars change. This is not used when streaming.
+    cs::utils::DefaultProperty<bool>     mEnableCubemap{false};
+    cs::utils::DefaultProperty<uint32_t> mCubemapResolution{1024};
+    cs::utils::DefaultProperty<float>    mCubemapMagnitude{4.F};
   };
 
+  void prepare(nlohmann::json const& pluginSettings) override;
   void init() override;
   void deInit() override;
 
@@ -52,6 +68,7 @@ class Plugin : public cs::core::PluginBase {
   void onSave();
 
   Settings                            mPluginSettings;
+  std::optional<Stars::CatalogData>   mPreparedCatalogs;
   std::unique_ptr<Stars>              mStars;
   std::unique_ptr<VistaTransformNode> mStarsTransform;
   std::unique_ptr<VistaOpenGLNode>    mStarsNode;
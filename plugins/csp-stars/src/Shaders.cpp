@@ -44,6 +44,28 @@ float W = 11.2;
 vec3 Uncharted2Tonemap(vec3 x) {
   return ((x*(A*x+C*B)+D*E)/(x*(A*x+B)+D*F))-E/F;
 }
+
+float getSolidAngle(vec3 a, vec3 b, vec3 c) {
+    return 2 * atan(abs(dot(a, cross(b, c))) / (1 + dot(a, b) + dot(a, c) + dot(b, c)));
+}
+
+float getSolidAngleOfPixel(vec4 screenSpacePosition, vec2 resolution, mat4 invProjection) {
+    vec2 pixel = vec2(1.0) / resolution;
+    vec4 pixelCorners[4] = vec4[4](
+        screenSpacePosition + vec4(- pixel.x, - pixel.y, 0, 0),
+        screenSpacePosition + vec4(+ pixel.x, - pixel.y, 0, 0),
+        screenSpacePosition + vec4(+ pixel.x, + pixel.y, 0, 0),
+        screenSpacePosition + vec4(- pixel.x, + pixel.y, 0, 0)
+    );
+
+    for (int i=0; i<4; ++i) {
+        pixelCorners[i] = invProjection * pixelCorners[i];
+        pixelCorners[i].xyz = normalize(pixelCorners[i].xyz);
+    }
+
+    return getSolidAngle(pixelCorners[0].xyz, pixelCorners[1].xyz, pixelCorners[2].xyz)
+         + getSolidAngle(pixelCorners[0].xyz, pixelCorners[2].xyz, pixelCorners[3].xyz);
+}
 )";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -89,6 +111,7 @@ uniform mat4  uMatP;
 uniform float uSolidAngle;
 uniform float uMinMagnitude;
 uniform float uMaxMagnitude;
+uniform vec2  uDrawMagnitudes;
 
 // outputs
 out vec3  iColor;
@@ -104,6 +127,11 @@ void main() {
         return;
     }
 
+    // The other stars are splatted by the compute shader below or stored in the cubemap.
+    if (iMagnitude <= uDrawMagnitudes.x || iMagnitude > uDrawMagnitudes.y) {
+        return;
+    }
+
     float dist = length(gl_in[0].gl_Position.xyz);
     vec3 y = vec3(0, 1, 0);
     vec3 z = gl_in[0].gl_Position.xyz / dist;
@@ -263,41 +291,172 @@ uniform vec2 uResolution;
 uniform float uMinMagnitude;
 uniform float uMaxMagnitude;
 uniform float uSolidAngle;
+uniform vec2  uDrawMagnitudes;
 
 // outputs
 out vec4 oLuminance;
 
-float getSolidAngle(vec3 a, vec3 b, vec3 c) {
-    return 2 * atan(abs(dot(a, cross(b, c))) / (1 + dot(a, b) + dot(a, c) + dot(b, c)));
+void main() {
+    if (vMagnitude > uMaxMagnitude || vMagnitude < uMinMagnitude) {
+        discard;
+    }
+
+    // The other stars are splatted or stored in the cubemap.
+    if (vMagnitude <= uDrawMagnitudes.x || vMagnitude > uDrawMagnitudes.y) {
+        discard;
+    }
+
+    float solidAngle = getSolidAngleOfPixel(vScreenSpacePos, uResolution, uInvP);
+    float luminance = magnitudeToLuminance(vMagnitude, solidAngle);
+
+    oLuminance = vec4(vColor * luminance * uLuminanceMultiplicator, 1.0);
+
+    #ifndef ENABLE_HDR
+        oLuminance.rgb = Uncharted2Tonemap(oLuminance.rgb * uSolidAngle * 5e8);
+    #endif
 }
+)";
 
-float getSolidAngleOfPixel(vec4 screenSpacePosition, vec2 resolution, mat4 invProjection) {
-    vec2 pixel = vec2(1.0) / resolution;
-    vec4 pixelCorners[4] = vec4[4](
-        screenSpacePosition + vec4(- pixel.x, - pixel.y, 0, 0),
-        screenSpacePosition + vec4(+ pixel.x, - pixel.y, 0, 0),
-        screenSpacePosition + vec4(+ pixel.x, + pixel.y, 0, 0),
-        screenSpacePosition + vec4(- pixel.x, + pixel.y, 0, 0)
-    );
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    for (int i=0; i<4; ++i) {
-        pixelCorners[i] = invProjection * pixelCorners[i];
-        pixelCorners[i].xyz = normalize(pixelCorners[i].xyz);
+// Each invocation splats one star. The invocations are distributed over the ranges of visible
+// stars: for each range, the buffer contains the index of its first star in the vertex buffer and
+// the number of stars in all preceding ranges.
+const char* Stars::cStarsSplatComp = R"(
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer StarBuffer {
+    float uStars[];
+};
+
+layout(std430, binding = 1) readonly buffer RangeBuffer {
+    uvec2 uRanges[];
+};
+
+layout(std430, binding = 2) buffer SplatBuffer {
+    uint uSplats[];
+};
+
+// uniforms
+uniform uint  uStarCount;
+uniform uint  uRangeCount;
+uniform vec2  uResolution;
+uniform mat4  uMatMV;
+uniform mat4  uMatP;
+uniform mat4  uInvMV;
+uniform float uMinMagnitude;
+uniform float uMaxMagnitude;
+uniform vec2  uSplatMagnitudes;
+uniform float uFluxScale;
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+
+    if (index >= uStarCount) {
+        return;
     }
 
-    return getSolidAngle(pixelCorners[0].xyz, pixelCorners[1].xyz, pixelCorners[2].xyz)
-         + getSolidAngle(pixelCorners[0].xyz, pixelCorners[2].xyz, pixelCorners[3].xyz);
+    // Find the last range which starts before this invocation.
+    uint lo = 0;
+    uint hi = uRangeCount - 1;
+    while (lo < hi) {
+        uint mid = (lo + hi + 1) / 2;
+        if (uRanges[mid].y <= index) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    uint star = (uRanges[lo].x + index - uRanges[lo].y) * 7;
+
+    vec3  inPos          = vec3(uStars[star], uStars[star + 1], uStars[star + 2]);
+    vec3  inColor        = vec3(uStars[star + 3], uStars[star + 4], uStars[star + 5]);
+    float inAbsMagnitude = uStars[star + 6];
+
+    const float parsecToMeter = 3.08567758e16;
+    vec3 observerPos = (uInvMV * vec4(0, 0, 0, 1) / parsecToMeter).xyz;
+
+    float magnitude = getApparentMagnitude(inAbsMagnitude, length(inPos - observerPos));
+
+    // Brighter stars are drawn by the normal pipeline.
+    if (magnitude > uMaxMagnitude || magnitude < uMinMagnitude ||
+        magnitude <= uSplatMagnitudes.x || magnitude > uSplatMagnitudes.y) {
+        return;
+    }
+
+    vec4 screenSpacePos = uMatP * uMatMV * vec4(inPos * parsecToMeter, 1);
+
+    if (screenSpacePos.w <= 0) {
+        return;
+    }
+
+    ivec2 pixel = ivec2(floor((screenSpacePos.xy / screenSpacePos.w * 0.5 + 0.5) * uResolution));
+
+    if (any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, ivec2(uResolution)))) {
+        return;
+    }
+
+    // The flux is proportional to 10^(-0.4 * magnitude). It is stored as fixed-point value so that
+    // integer atomics can be used, uFluxScale is chosen so that the brightest splatted stars of
+    // many stars in one pixel do not overflow.
+    uvec3 flux  = uvec3(SRGBtoLINEAR(inColor) * pow(10.0, -0.4 * magnitude) * uFluxScale + 0.5);
+    uint  first = (uint(pixel.y) * uint(uResolution.x) + uint(pixel.x)) * 3;
+
+    atomicAdd(uSplats[first],     flux.r);
+    atomicAdd(uSplats[first + 1], flux.g);
+    atomicAdd(uSplats[first + 2], flux.b);
 }
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* Stars::cStarsSplatResolveVert = R"(
+// inputs
+layout(location = 0) in vec2 vPosition;
 
 void main() {
-    if (vMagnitude > uMaxMagnitude || vMagnitude < uMinMagnitude) {
-        discard;
-    }
+    gl_Position = vec4(vPosition, 1, 1);
+}
+)";
 
-    float solidAngle = getSolidAngleOfPixel(vScreenSpacePos, uResolution, uInvP);
-    float luminance = magnitudeToLuminance(vMagnitude, solidAngle);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    oLuminance = vec4(vColor * luminance * uLuminanceMultiplicator, 1.0);
+// This converts the accumulated flux of each pixel to luminance and resets the pixel for the next
+// frame.
+const char* Stars::cStarsSplatResolveFrag = R"(
+layout(std430, binding = 2) buffer SplatBuffer {
+    uint uSplats[];
+};
+
+// uniforms
+uniform vec2  uResolution;
+uniform ivec2 uViewportOffset;
+uniform mat4  uInvP;
+uniform float uFluxScale;
+uniform float uLuminanceMultiplicator;
+uniform float uSolidAngle;
+
+// outputs
+out vec4 oLuminance;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy) - uViewportOffset;
+    uint  first = (uint(pixel.y) * uint(uResolution.x) + uint(pixel.x)) * 3;
+
+    vec3 flux = vec3(uSplats[first], uSplats[first + 1], uSplats[first + 2]) / uFluxScale;
+
+    uSplats[first]     = 0;
+    uSplats[first + 1] = 0;
+    uSplats[first + 2] = 0;
+
+    // This is magnitudeToLuminance() with the flux instead of the magnitude.
+    const float steradiansToSquareArcSecs = 4.25e10;
+    vec4  screenSpacePos = vec4((vec2(pixel) + 0.5) / uResolution * 2.0 - 1.0, 0, 1);
+    float solidAngle     = getSolidAngleOfPixel(screenSpacePos, uResolution, uInvP);
+    vec3  luminance      = 10.8e4 * flux / (solidAngle * steradiansToSquareArcSecs);
+
+    oLuminance = vec4(luminance * uLuminanceMultiplicator, 1.0);
 
     #ifndef ENABLE_HDR
         oLuminance.rgb = Uncharted2Tonemap(oLuminance.rgb * uSolidAngle * 5e8);
@@ -307,6 +466,26 @@ void main() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// This draws the cubemap containing the background and the faint stars, see
+// Stars::updateCubemap(). It uses cBackgroundVert as vertex shader.
+const char* Stars::cStarsCubemapFrag = R"(
+// inputs
+in vec3 vView;
+
+// uniforms
+uniform samplerCube uCubemap;
+uniform float       uLuminanceMultiplicator;
+
+// outputs
+layout(location = 0) out vec3 vOutColor;
+
+void main() {
+    vOutColor = texture(uCubemap, normalize(vView)).rgb * uLuminanceMultiplicator;
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 const char* Stars::cBackgroundVert = R"(
 // inputs
 layout(location = 0) in vec2 vPosition;
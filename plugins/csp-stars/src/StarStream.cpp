@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "StarStream.hpp"
+
+#include "../../../src/cs-utils/TrackedMemoryResource.hpp"
+
+#include <VistaOGLExt/VistaBufferObject.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace csp::stars {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// maximum number of blocks which are uploaded to the vertex buffer in one frame
+std::size_t const maxUploadsPerFrame = 16;
+
+// maximum number of blocks which are waiting for the worker thread
+std::size_t const maxLoadingBlocks = 64;
+
+// slots which have been drawn during this many frames are not replaced, this accounts for
+// multiple calls to update() per frame, for example for stereo rendering
+uint64_t const evictionDelay = 4;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarStream::StarStream(std::string const& cacheFile, std::size_t vertexOffset,
+    std::size_t starCount, std::size_t starElementCount, std::size_t maxStars,
+    VistaBufferObject* buffer)
+    : mMapping(cacheFile.c_str(), boost::interprocess::read_only)
+    , mRegion(mMapping, boost::interprocess::read_only)
+    , mStarCount(starCount)
+    , mStarElementCount(starElementCount)
+    , mBuffer(buffer)
+    , mSlots((maxStars + sBlockSize - 1) / sBlockSize)
+    , mThreadPool(1, "Star Stream") {
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto const* data = static_cast<char const*>(mRegion.get_address()) + vertexOffset;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  mVertices = reinterpret_cast<float const*>(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarStream::getCapacity() const {
+  return mSlots.size() * sBlockSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StarStream::update(std::vector<GLint>& firsts, std::vector<GLsizei>& counts) {
+  ++mFrame;
+
+  uploadLoadedBlocks();
+
+  std::vector<GLint>   residentFirsts;
+  std::vector<GLsizei> residentCounts;
+
+  // Slots which are drawn in this frame must not be replaced, so no more blocks are requested than
+  // there are slots left.
+  std::size_t reservedSlots = mLoadingBlocks.size();
+
+  // All ranges are traversed block by block in parallel, so that the brightest stars of all cells
+  // are requested first.
+  for (std::size_t depth = 0;; ++depth) {
+    bool done = true;
+
+    for (std::size_t i = 0; i < firsts.size(); ++i) {
+      auto first      = static_cast<std::size_t>(firsts[i]);
+      auto end        = first + static_cast<std::size_t>(counts[i]);
+      auto block      = first / sBlockSize + depth;
+      auto blockStart = block * sBlockSize;
+
+      if (blockStart >= end) {
+        continue;
+      }
+
+      done = false;
+
+      auto it = mResidentBlocks.find(block);
+
+      if (it != mResidentBlocks.end()) {
+        auto& slot = mSlots[it->second];
+
+        if (slot.mLastUsed != mFrame) {
+          slot.mLastUsed = mFrame;
+          ++reservedSlots;
+        }
+
+        auto start = std::max(first, blockStart);
+        auto stop  = std::min(end, blockStart + sBlockSize);
+
+        residentFirsts.push_back(static_cast<GLint>(it->second * sBlockSize + start - blockStart));
+        residentCounts.push_back(static_cast<GLsizei>(stop - start));
+
+      } else if (reservedSlots < mSlots.size() && mLoadingBlocks.size() < maxLoadingBlocks &&
+                 mLoadingBlocks.find(block) == mLoadingBlocks.end()) {
+        requestBlock(block, depth == 0);
+        ++reservedSlots;
+      }
+    }
+
+    if (done) {
+      break;
+    }
+  }
+
+  firsts = std::move(residentFirsts);
+  counts = std::move(residentCounts);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StarStream::uploadLoadedBlocks() {
+  std::size_t uploads = 0;
+
+  mBuffer->Bind(GL_ARRAY_BUFFER);
+
+  for (auto it = mLoadingBlocks.begin();
+       it != mLoadingBlocks.end() && uploads < maxUploadsPerFrame;) {
+    if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      ++it;
+      continue;
+    }
+
+    auto vertices = it->second.get();
+
+    // Free slots have never been used, so they are found first. If the least recently drawn slot
+    // is still in use, the block is dropped. It will be requested again once a slot becomes free.
+    auto slot = std::min_element(mSlots.begin(), mSlots.end(),
+        [](Slot const& a, Slot const& b) { return a.mLastUsed < b.mLastUsed; });
+
+    if (slot->mBlock == sNoBlock || slot->mLastUsed + evictionDelay < mFrame) {
+      if (slot->mBlock != sNoBlock) {
+        mResidentBlocks.erase(slot->mBlock);
+      }
+
+      auto index      = static_cast<std::size_t>(slot - mSlots.begin());
+      slot->mBlock    = it->first;
+      slot->mLastUsed = mFrame;
+
+      glBufferSubData(GL_ARRAY_BUFFER,
+          static_cast<GLintptr>(index * sBlockSize * mStarElementCount * sizeof(float)),
+          static_cast<GLsizeiptr>(vertices.size() * sizeof(float)), vertices.data());
+
+      mResidentBlocks[it->first] = index;
+      ++uploads;
+    }
+
+    it = mLoadingBlocks.erase(it);
+  }
+
+  mBuffer->Release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StarStream::requestBlock(std::size_t block, bool urgent) {
+  auto first = block * sBlockSize;
+  auto size  = std::min(sBlockSize, mStarCount - first) * mStarElementCount;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  float const* source = mVertices + first * mStarElementCount;
+
+  // Copying the data faults the mapped pages in, so this is done on the worker thread.
+  auto priority =
+      urgent ? cs::utils::ThreadPool::Priority::eHigh : cs::utils::ThreadPool::Priority::eNormal;
+
+  static auto* resource = &cs::utils::TrackedMemoryResource::get("Star Stream");
+
+  mLoadingBlocks.emplace(block, mThreadPool.enqueue(priority, [source, size]() {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return std::pmr::vector<float>(source, source + size, resource);
+  }));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::stars
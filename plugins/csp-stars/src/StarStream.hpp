@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_STARS_STAR_STREAM_HPP
+#define CSP_STARS_STAR_STREAM_HPP
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#include <GL/glew.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <future>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VistaBufferObject;
+
+namespace csp::stars {
+
+/// Streams the vertex data of a star cache file into a vertex buffer of fixed size. This allows
+/// showing catalogs which do not fit into graphics memory.
+///
+/// The stars of the cache file are split into blocks of sBlockSize consecutive stars. The vertex
+/// buffer is split into slots of the same size, each slot holds one block. Blocks which are
+/// requested but not resident are copied from the memory-mapped cache file on a worker thread and
+/// uploaded on the main thread during the next calls to update(). If all slots are occupied, the
+/// block which has not been drawn for the longest time is replaced.
+///
+/// As the stars of each sky cell are sorted by magnitude, the first blocks of each requested range
+/// contain the brightest stars of a cell. These are loaded first, so that faint stars appear last.
+class StarStream {
+ public:
+  static constexpr std::size_t sBlockSize = 4096;
+
+  /// The vertex data of starCount stars with the given number of floats each is read from the
+  /// given file, starting at vertexOffset bytes. The buffer has to be allocated for getCapacity()
+  /// stars. Throws a std::exception if the file cannot be mapped.
+  StarStream(std::string const& cacheFile, std::size_t vertexOffset, std::size_t starCount,
+      std::size_t starElementCount, std::size_t maxStars, VistaBufferObject* buffer);
+
+  StarStream(StarStream const& other) = delete;
+  StarStream(StarStream&& other)      = delete;
+
+  StarStream& operator=(StarStream const& other) = delete;
+  StarStream& operator=(StarStream&& other)      = delete;
+
+  ~StarStream() = default;
+
+  /// The number of stars the vertex buffer has to hold. This is maxStars rounded up to a multiple
+  /// of sBlockSize.
+  std::size_t getCapacity() const;
+
+  /// Uploads the blocks which have been loaded in the meantime and requests the blocks of the given
+  /// ranges of stars. The ranges are given as indices into the cache file and are replaced by the
+  /// ranges of the vertex buffer which contain the resident parts of them.
+  void update(std::vector<GLint>& firsts, std::vector<GLsizei>& counts);
+
+ private:
+  struct Slot {
+    std::size_t mBlock    = sNoBlock;
+    uint64_t    mLastUsed = 0;
+  };
+
+  static constexpr std::size_t sNoBlock = static_cast<std::size_t>(-1);
+
+  void uploadLoadedBlocks();
+  void requestBlock(std::size_t block, bool urgent);
+
+  boost::interprocess::file_mapping  mMapping;
+  boost::interprocess::mapped_region mRegion;
+
+  float const*       mVertices = nullptr;
+  std::size_t        mStarCount;
+  std::size_t        mStarElementCount;
+  VistaBufferObject* mBuffer;
+
+  std::vector<Slot>                            mSlots;
+  std::unordered_map<std::size_t, std::size_t> mResidentBlocks;
+
+  // The blocks are copied into memory of the "Star Stream" subsystem of the
+  // cs::utils::TrackedMemoryResource before they are uploaded.
+  std::unordered_map<std::size_t, std::future<std::pmr::vector<float>>> mLoadingBlocks;
+
+  /// The number of calls to update(), used to find the least recently drawn slots.
+  uint64_t mFrame = 0;
+
+  /// This is declared last as its destructor waits for the running tasks, which read from the
+  /// mapped region.
+  cs::utils::ThreadPool mThreadPool;
+};
+
+} // namespace csp::stars
+
+#endif // CSP_STARS_STAR_STREAM_HPP
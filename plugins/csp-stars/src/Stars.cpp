@@ -9,15 +9,16 @@
 
 #include "logger.hpp"
 
+#include "../../../src/cs-graphics/GpuMemory.hpp"
 #include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "../../../src/cs-utils/Tracing.hpp"
 
 #ifdef _WIN32
 #include <Windows.h>
 #endif
 
-#include <VistaInterProcComm/Connections/VistaByteBufferDeSerializer.h>
-#include <VistaInterProcComm/Connections/VistaByteBufferSerializer.h>
 #include <VistaKernel/GraphicsManager/VistaGeometryFactory.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
@@ -28,9 +29,21 @@
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 #include <VistaTools/tinyXML/tinyxml.h>
 
+#include <algorithm>
 #include <array>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <charconv>
+#include <cstring>
 #include <fstream>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <numeric>
+#include <string_view>
+#include <thread>
 
 namespace csp::stars {
 
@@ -40,11 +53,72 @@ namespace {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-template <typename T>
-bool fromString(std::string const& v, T& out) {
-  std::istringstream iss(v);
-  iss >> out;
-  return (iss.rdstate() & std::stringstream::failbit) == 0;
+// Parses an integer which may be preceded by spaces. Returns false if there is no number at all.
+bool parseInt(std::string_view v, int& out) {
+  auto start = std::min(v.find_first_not_of(' '), v.size());
+  return std::from_chars(v.data() + start, v.data() + v.size(), out).ec == std::errc();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Parses a decimal number like "-12.345" or "1.5E-3" which may be preceded by spaces. Returns false
+// if there is no number at all. std::from_chars cannot be used here, as not all supported compilers
+// implement it for floating point numbers.
+bool parseFloat(std::string_view v, float& out) {
+  std::size_t i = std::min(v.find_first_not_of(' '), v.size());
+
+  auto isDigit = [&v](std::size_t j) { return j < v.size() && v[j] >= '0' && v[j] <= '9'; };
+
+  bool negative = false;
+  if (i < v.size() && (v[i] == '-' || v[i] == '+')) {
+    negative = v[i] == '-';
+    ++i;
+  }
+
+  // further digits are only accumulated in the exponent to prevent an overflow
+  uint64_t const maxMantissa = 100000000000000000;
+
+  uint64_t mantissa = 0;
+  int      exponent = 0;
+  int      digits   = 0;
+
+  for (; isDigit(i); ++i, ++digits) {
+    if (mantissa < maxMantissa) {
+      mantissa = mantissa * 10 + static_cast<uint64_t>(v[i] - '0');
+    } else {
+      ++exponent;
+    }
+  }
+
+  if (i < v.size() && v[i] == '.') {
+    for (++i; isDigit(i); ++i, ++digits) {
+      if (mantissa < maxMantissa) {
+        mantissa = mantissa * 10 + static_cast<uint64_t>(v[i] - '0');
+        --exponent;
+      }
+    }
+  }
+
+  if (digits == 0) {
+    return false;
+  }
+
+  if (i < v.size() && (v[i] == 'e' || v[i] == 'E')) {
+    std::size_t j = i + 1;
+    if (j < v.size() && v[j] == '+') {
+      ++j;
+    }
+
+    int e{};
+    if (std::from_chars(v.data() + j, v.data() + v.size(), e).ec == std::errc()) {
+      exponent += e;
+    }
+  }
+
+  double value = static_cast<double>(mantissa) * std::pow(10.0, exponent);
+  out          = static_cast<float>(negative ? -value : value);
+
+  return true;
 }
 
 // spectral colors from B-V index -0.4 to 2.0 in steps of 0.05
@@ -64,6 +138,151 @@ const std::array sSpectralColors = {VistaColor(0x9bb2ff), VistaColor(0x9eb5ff),
     VistaColor(0xffb765), VistaColor(0xffa94b), VistaColor(0xff9523), VistaColor(0xff7b00),
     VistaColor(0xff5200)};
 
+// number of floats per star in the vertex buffer and in the cache file: position, color, magnitude
+std::size_t const starElementCount = 7;
+
+// The sky is partitioned into the cells of a cube map with this many cells along each edge of a
+// face. The stars are sorted by cell and, within each cell, by their apparent magnitude as seen
+// from the sun. The stars of each cell are grouped into bins of one magnitude starting at
+// minBinMagnitude, the first and the last bin are open-ended.
+uint32_t const cellResolution    = 8;
+uint32_t const cellCount         = 6 * cellResolution * cellResolution;
+uint32_t const magnitudeBinCount = 32;
+float const    minBinMagnitude   = -2.F;
+
+// Culling is only possible if the observer is close to the sun, as the cells and the magnitude
+// bins are computed for an observer at the origin. This is given in parsecs.
+float const maxCullingDistance = 0.001F;
+
+// The nearest stars are more than one parsec away. The directions towards them change by less than
+// this angle if the observer moves by maxCullingDistance.
+float const cellMargin = 0.01F;
+
+// The cubemap is rendered again if the observer moved by more than this many parsecs. The
+// directions towards the nearest stars then change by about 0.0001 radians, which is roughly a
+// texel of a cubemap with a resolution of 1024.
+float const maxCubemapOffset = 0.0001F;
+
+// This is used as magnitude limit for the brightest and the faintest stars.
+float const magnitudeLimit = 1000.F;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the cell of the cube map which contains the given direction.
+uint32_t getCell(glm::vec3 const& direction) {
+  glm::vec3 a = glm::abs(direction);
+  uint32_t  face{};
+  glm::vec2 uv;
+
+  if (a.x >= a.y && a.x >= a.z) {
+    face = direction.x > 0.F ? 0 : 1;
+    uv   = glm::vec2(direction.y, direction.z) / a.x;
+  } else if (a.y >= a.z) {
+    face = direction.y > 0.F ? 2 : 3;
+    uv   = glm::vec2(direction.x, direction.z) / a.y;
+  } else {
+    face = direction.z > 0.F ? 4 : 5;
+    uv   = glm::vec2(direction.x, direction.y) / a.z;
+  }
+
+  auto cell = glm::min(glm::uvec2((uv * 0.5F + 0.5F) * static_cast<float>(cellResolution)),
+      glm::uvec2(cellResolution - 1));
+
+  return (face * cellResolution + cell.x) * cellResolution + cell.y;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the normalized direction towards the given point on a face of the cube map. uv are in
+// [-1, 1].
+glm::vec3 getCubeMapDirection(uint32_t face, glm::vec2 const& uv) {
+  float     sign = face % 2 == 0 ? 1.F : -1.F;
+  glm::vec3 result;
+
+  if (face < 2) {
+    result = glm::vec3(sign, uv.x, uv.y);
+  } else if (face < 4) {
+    result = glm::vec3(uv.x, sign, uv.y);
+  } else {
+    result = glm::vec3(uv.x, uv.y, sign);
+  }
+
+  return glm::normalize(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t getMagnitudeBin(float magnitude) {
+  float bin = std::floor(magnitude - minBinMagnitude);
+  return static_cast<uint32_t>(std::clamp(bin, 0.F, static_cast<float>(magnitudeBinCount - 1)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The cache file starts with this header, followed by the vertex buffer data of all stars and the
+// index of the first star of each magnitude bin of each cell, see Stars::mBinStarts.
+struct CacheHeader {
+  uint32_t mMagic;
+  uint32_t mVersion;
+  uint32_t mCatalogs;
+  uint32_t mStarCount;
+  uint64_t mCatalogHash;
+};
+
+uint32_t const cacheMagic = 0x43525453; // "STRC"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// 64-bit FNV-1a. In contrast to std::hash, this is guaranteed to be the same on all platforms.
+uint64_t hash(void const* data, std::size_t size, uint64_t seed = 0xcbf29ce484222325) {
+  auto const* bytes = static_cast<unsigned char const*>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    seed ^= bytes[i];      // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    seed *= 0x100000001b3; // NOLINT(readability-magic-numbers)
+  }
+  return seed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Compiles and links the given compute shader. Throws a std::runtime_error on failure.
+uint32_t createComputeProgram(std::string const& source) {
+  auto        shader  = glCreateShader(GL_COMPUTE_SHADER);
+  const char* pSource = source.c_str();
+  glShaderSource(shader, 1, &pSource, nullptr);
+  glCompileShader(shader);
+
+  int rvalue = 0;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto logLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    std::vector<char> v(logLength);
+    glGetShaderInfoLog(shader, logLength, nullptr, v.data());
+    glDeleteShader(shader);
+    throw std::runtime_error(
+        "Failed to compile the star splatting shader: " + std::string(v.begin(), v.end()));
+  }
+
+  auto program = glCreateProgram();
+  glAttachShader(program, shader);
+  glLinkProgram(program);
+  glDeleteShader(shader);
+
+  glGetProgramiv(program, GL_LINK_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto logLength = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+    std::vector<char> v(logLength);
+    glGetProgramInfoLog(program, logLength, nullptr, v.data());
+    glDeleteProgram(program);
+    throw std::runtime_error(
+        "Failed to link the star splatting shader: " + std::string(v.begin(), v.end()));
+  }
+
+  return program;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 } // namespace
@@ -80,53 +299,126 @@ const std::array<std::array<int, Stars::NUM_COLUMNS>, Stars::NUM_CATALOGS> Stars
 
 // Increase this if the cache format changed and is incompatible now. This will
 // force a reload.
-const int Stars::cCacheVersion = 3;
+const int Stars::cCacheVersion = 5;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Stars::~Stars() {
+  glDeleteProgram(mSplatProgram);
+  glDeleteBuffers(1, &mSplatRangesBuffer);
+  glDeleteBuffers(1, &mSplatBuffer);
+
+  glDeleteTextures(1, &mCubemap);
+  glDeleteFramebuffers(1, &mCubemapFramebuffer);
+
+  auto& memory = cs::graphics::GpuMemory::get();
+  memory.release("Stars",
+      sizeof(uint32_t) * 3 * static_cast<std::size_t>(mSplatBufferSize.x * mSplatBufferSize.y));
+  memory.release("Stars", 6 * 4 * sizeof(uint16_t) * mCubemapTextureSize * mCubemapTextureSize);
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Stars::setCatalogs(std::map<Stars::CatalogType, std::string> catalogs) {
   if (mCatalogs != catalogs) {
+    setCatalogData(loadCatalogs(std::move(catalogs), mCacheFile, mMaxGPUStars));
+  }
+}
 
-    mCatalogs = std::move(catalogs);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    // Clear stars first.
-    mStars.clear();
+Stars::CatalogData Stars::loadCatalogs(
+    std::map<CatalogType, std::string> catalogs, std::string cacheFile, std::size_t maxGPUStars) {
+  CatalogData data;
+  data.mCatalogs  = std::move(catalogs);
+  data.mCacheFile = std::move(cacheFile);
 
-    // Read star catalogs.
-    if (!readStarCache(mCacheFile)) {
-      std::map<CatalogType, std::string>::const_iterator it;
+  // The cache file contains the vertex buffer data, so it is used directly if it is valid. Else the
+  // star catalogs are read.
+  if (readStarCache(data, maxGPUStars)) {
+    return data;
+  }
 
-      it = mCatalogs.find(CatalogType::eHipparcos);
-      if (it != mCatalogs.end()) {
-        readStarsFromCatalog(it->first, it->second);
-      }
+  std::vector<Star> stars;
+  std::map<CatalogType, std::string>::const_iterator it;
 
-      it = mCatalogs.find(CatalogType::eTycho);
-      if (it != mCatalogs.end()) {
-        readStarsFromCatalog(it->first, it->second);
-      }
+  bool hasHipparcos = data.mCatalogs.find(CatalogType::eHipparcos) != data.mCatalogs.end();
 
-      it = mCatalogs.find(CatalogType::eTycho2);
-      if (it != mCatalogs.end()) {
-        // do not load tycho and tycho 2
-        if (mCatalogs.find(CatalogType::eTycho) == mCatalogs.end()) {
-          readStarsFromCatalog(it->first, it->second);
-        } else {
-          logger().warn("Failed to load Tycho2 catalog: Tycho already loaded!");
-        }
-      }
+  it = data.mCatalogs.find(CatalogType::eHipparcos);
+  if (it != data.mCatalogs.end()) {
+    readStarsFromCatalog(it->first, it->second, false, stars);
+  }
 
-      if (!mStars.empty()) {
-        writeStarCache(mCacheFile);
-      } else {
-        logger().warn("Loaded no stars! Stars will not work properly.");
-      }
+  it = data.mCatalogs.find(CatalogType::eTycho);
+  if (it != data.mCatalogs.end()) {
+    readStarsFromCatalog(it->first, it->second, hasHipparcos, stars);
+  }
+
+  it = data.mCatalogs.find(CatalogType::eTycho2);
+  if (it != data.mCatalogs.end()) {
+    // do not load tycho and tycho 2
+    if (data.mCatalogs.find(CatalogType::eTycho) == data.mCatalogs.end()) {
+      readStarsFromCatalog(it->first, it->second, hasHipparcos, stars);
+    } else {
+      logger().warn("Failed to load Tycho2 catalog: Tycho already loaded!");
+    }
+  }
+
+  data.mVertices  = getStarVertices(stars, data.mBinStarts);
+  data.mStarCount = stars.size();
+
+  if (stars.empty()) {
+    logger().warn("Loaded no stars! Stars will not work properly.");
+    return data;
+  }
+
+  // Large catalogs are streamed from the cache file. If it cannot be written, all stars are
+  // uploaded anyway.
+  if (writeStarCache(data) && maxGPUStars > 0 && stars.size() > maxGPUStars) {
+    data.mVertices = {};
+    data.mStreamed = true;
+  }
+
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::setCatalogData(CatalogData data) {
+  mCatalogs  = std::move(data.mCatalogs);
+  mBinStarts = std::move(data.mBinStarts);
+  mStarStream.reset();
+
+  // The cubemap has to be rendered again with the new stars.
+  mCubemapHash = 0;
+
+  if (data.mStreamed && mMaxGPUStars > 0) {
+    try {
+      mStarStream = std::make_unique<StarStream>(data.mCacheFile, sizeof(CacheHeader),
+          data.mStarCount, starElementCount, mMaxGPUStars, &mStarVBO);
+
+      logger().info("Streaming a total of {} stars, {} of them fit into the vertex buffer.",
+          data.mStarCount, mStarStream->getCapacity());
+    } catch (std::exception const& e) {
+      logger().warn("Failed to stream stars from '{}': {}", data.mCacheFile, e.what());
     }
+  }
 
-    // Create buffers,
-    buildStarVAO();
-    buildBackgroundVAO();
+  if (mStarStream) {
+    // The vertex buffer is filled by the StarStream.
+    buildStarVAO(nullptr, mStarStream->getCapacity());
+  } else {
+    // If the stars cannot be streamed, all of them are uploaded.
+    if (data.mStreamed) {
+      data       = loadCatalogs(mCatalogs, data.mCacheFile, 0);
+      mBinStarts = std::move(data.mBinStarts);
+    }
+
+    buildStarVAO(data.mVertices.data(), data.mStarCount);
   }
+
+  // Create buffers,
+  buildBackgroundVAO();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -149,6 +441,18 @@ std::string const& Stars::getCacheFile() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Stars::setMaxGPUStars(std::size_t value) {
+  mMaxGPUStars = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Stars::getMaxGPUStars() const {
+  return mMaxGPUStars;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Stars::setDrawMode(Stars::DrawMode value) {
   if (mDrawMode != value) {
     mShaderDirty = true;
@@ -173,6 +477,72 @@ void Stars::setEnableHDR(bool value) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Stars::setEnableSplatting(bool value) {
+  if (mEnableSplatting != value) {
+    mShaderDirty     = true;
+    mEnableSplatting = value;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Stars::getEnableSplatting() const {
+  return mEnableSplatting;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::setSplatMagnitude(float value) {
+  mSplatMagnitude = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float Stars::getSplatMagnitude() const {
+  return mSplatMagnitude;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::setEnableCubemap(bool value) {
+  if (mEnableCubemap != value) {
+    mShaderDirty   = true;
+    mEnableCubemap = value;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Stars::getEnableCubemap() const {
+  return mEnableCubemap;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::setCubemapResolution(uint32_t value) {
+  mCubemapResolution = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t Stars::getCubemapResolution() const {
+  return mCubemapResolution;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::setCubemapMagnitude(float value) {
+  mCubemapMagnitude = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float Stars::getCubemapMagnitude() const {
+  return mCubemapMagnitude;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Stars::setSolidAngle(float value) {
   mSolidAngle = value;
 }
@@ -269,7 +639,7 @@ void Stars::setStarTexture(std::string const& filename) {
     if (filename.empty()) {
       mStarTexture.reset();
     } else {
-      mStarTexture = cs::graphics::TextureLoader::loadFromFile(filename);
+      mStarTexture = cs::graphics::TextureLoader::loadFromFileAsync(filename);
     }
   }
 }
@@ -282,7 +652,7 @@ void Stars::setCelestialGridTexture(std::string const& filename) {
     if (filename.empty()) {
       mCelestialGridTexture.reset();
     } else {
-      mCelestialGridTexture = cs::graphics::TextureLoader::loadFromFile(filename);
+      mCelestialGridTexture = cs::graphics::TextureLoader::loadFromFileAsync(filename);
     }
   }
 }
@@ -295,7 +665,7 @@ void Stars::setStarFiguresTexture(std::string const& filename) {
     if (filename.empty()) {
       mStarFiguresTexture.reset();
     } else {
-      mStarFiguresTexture = cs::graphics::TextureLoader::loadFromFile(filename);
+      mStarFiguresTexture = cs::graphics::TextureLoader::loadFromFileAsync(filename);
     }
   }
 }
@@ -303,6 +673,8 @@ void Stars::setStarFiguresTexture(std::string const& filename) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool Stars::Do() {
+  CS_TRACE_ZONE("Stars::Do");
+
   // Add a lower bound to the scene brightness value so that we can show the stars with the
   // mLuminanceMultiplicator even if we are in full daylight.
   float sceneBrightness = (1.F - mApproximateSceneBrightness) + 0.001F;
@@ -312,9 +684,9 @@ bool Stars::Do() {
     return true;
   }
 
-  cs::utils::FrameStats::ScopedTimer             timer("Render Stars");
-  cs::utils::FrameStats::ScopedSamplesCounter    samplesCounter("Render Stars");
-  cs::utils::FrameStats::ScopedPrimitivesCounter primitivesCounter("Render Stars");
+  cs::utils::FrameStats::ScopedTimer             timer(mTimerId);
+  cs::utils::FrameStats::ScopedSamplesCounter    samplesCounter(mTimerId);
+  cs::utils::FrameStats::ScopedPrimitivesCounter primitivesCounter(mTimerId);
 
   // save current state of the OpenGL state machine
   glPushAttrib(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT);
@@ -326,12 +698,64 @@ bool Stars::Do() {
   // get matrices
   std::array<GLfloat, 16> glMat{};
   glGetFloatv(GL_MODELVIEW_MATRIX, glMat.data());
-  VistaTransformMatrix matModelView(glMat.data(), true);
+  glm::mat4 matMV = glm::make_mat4(glMat.data());
 
   glGetFloatv(GL_PROJECTION_MATRIX, glMat.data());
-  VistaTransformMatrix matProjection(glMat.data(), true);
+  glm::mat4 matP = glm::make_mat4(glMat.data());
 
   if (mShaderDirty) {
+    // The splatting shaders require OpenGL 4.3. If they cannot be compiled, all stars are drawn
+    // according to the draw mode.
+    glDeleteProgram(mSplatProgram);
+    mSplatProgram       = 0;
+    mSplatResolveShader = VistaGLSLShader();
+
+    if (mEnableSplatting) {
+      try {
+        std::string splatDefines = "#version 430\n";
+        if (mEnableHDR) {
+          splatDefines += "#define ENABLE_HDR\n";
+        }
+
+        mSplatProgram = createComputeProgram(splatDefines + cStarsSnippets + cStarsSplatComp);
+
+        mSplatResolveShader.InitVertexShaderFromString(splatDefines + cStarsSplatResolveVert);
+        mSplatResolveShader.InitFragmentShaderFromString(
+            splatDefines + cStarsSnippets + cStarsSplatResolveFrag);
+        mSplatResolveShader.Link();
+
+        mUniforms.splatStarCount       = glGetUniformLocation(mSplatProgram, "uStarCount");
+        mUniforms.splatRangeCount      = glGetUniformLocation(mSplatProgram, "uRangeCount");
+        mUniforms.splatResolution      = glGetUniformLocation(mSplatProgram, "uResolution");
+        mUniforms.splatMVMatrix        = glGetUniformLocation(mSplatProgram, "uMatMV");
+        mUniforms.splatPMatrix         = glGetUniformLocation(mSplatProgram, "uMatP");
+        mUniforms.splatInverseMVMatrix = glGetUniformLocation(mSplatProgram, "uInvMV");
+        mUniforms.splatMinMagnitude    = glGetUniformLocation(mSplatProgram, "uMinMagnitude");
+        mUniforms.splatMaxMagnitude    = glGetUniformLocation(mSplatProgram, "uMaxMagnitude");
+        mUniforms.splatFluxScale       = glGetUniformLocation(mSplatProgram, "uFluxScale");
+        mUniforms.splatMagnitudes      = glGetUniformLocation(mSplatProgram, "uSplatMagnitudes");
+
+        mUniforms.resolveResolution = mSplatResolveShader.GetUniformLocation("uResolution");
+        mUniforms.resolveViewportOffset =
+            mSplatResolveShader.GetUniformLocation("uViewportOffset");
+        mUniforms.resolveInversePMatrix = mSplatResolveShader.GetUniformLocation("uInvP");
+        mUniforms.resolveFluxScale      = mSplatResolveShader.GetUniformLocation("uFluxScale");
+        mUniforms.resolveLuminanceMul =
+            mSplatResolveShader.GetUniformLocation("uLuminanceMultiplicator");
+        mUniforms.resolveSolidAngle = mSplatResolveShader.GetUniformLocation("uSolidAngle");
+
+        if (mSplatRangesBuffer == 0) {
+          glGenBuffers(1, &mSplatRangesBuffer);
+        }
+
+      } catch (std::exception const& e) {
+        logger().warn("Disabling star splatting: {}", e.what());
+        glDeleteProgram(mSplatProgram);
+        mSplatProgram    = 0;
+        mEnableSplatting = false;
+      }
+    }
+
     std::string defines = "#version 330\n";
 
     if (mEnableHDR) {
@@ -385,55 +809,113 @@ bool Stars::Do() {
     mUniforms.starPMatrix         = mStarShader.GetUniformLocation("uMatP");
     mUniforms.starInverseMVMatrix = mStarShader.GetUniformLocation("uInvMV");
     mUniforms.starInversePMatrix  = mStarShader.GetUniformLocation("uInvP");
+    mUniforms.starDrawMagnitudes  = mStarShader.GetUniformLocation("uDrawMagnitudes");
+
+    mCubemapShader = VistaGLSLShader();
+    if (mEnableCubemap) {
+      mCubemapShader.InitVertexShaderFromString(defines + cBackgroundVert);
+      mCubemapShader.InitFragmentShaderFromString(defines + cStarsCubemapFrag);
+      mCubemapShader.Link();
+
+      mUniforms.cubemapInverseMVMatrix  = mCubemapShader.GetUniformLocation("uInvMV");
+      mUniforms.cubemapInverseMVPMatrix = mCubemapShader.GetUniformLocation("uInvMVP");
+      mUniforms.cubemapTexture          = mCubemapShader.GetUniformLocation("uCubemap");
+      mUniforms.cubemapLuminanceMul =
+          mCubemapShader.GetUniformLocation("uLuminanceMultiplicator");
+    }
+
+    // The shaders have changed, so the cubemap has to be rendered again.
+    mCubemapHash = 0;
 
     mShaderDirty = false;
   }
 
-  // draw background
-  if ((mCelestialGridTexture && mBackgroundColor1[3] != 0.F) ||
-      (mStarFiguresTexture && mBackgroundColor2[3] != 0.F)) {
-    mBackgroundVAO.Bind();
-    mBackgroundShader.Bind();
-    mBackgroundShader.SetUniform(mUniforms.bgTexture, 0);
+  std::array<int, 4> viewport{};
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
+
+  float starLuminance       = mLuminanceMultiplicator * (mEnableHDR ? 1.F : sceneBrightness);
+  float backgroundLuminance = mLuminanceMultiplicator * (mEnableHDR ? 0.001F : sceneBrightness);
+
+  if (mEnableCubemap && !mStarStream) {
+    // In HDR mode, the luminance scales linearly with mLuminanceMultiplicator. Hence the cubemap is
+    // rendered without it and scaled when it is drawn. Else the tonemapped values are stored in the
+    // cubemap, so it has to be rendered again whenever the luminance changes.
+    float cubemapLuminance = mEnableHDR ? mLuminanceMultiplicator : 1.F;
+
+    updateCubemap(matMV, starLuminance / cubemapLuminance, backgroundLuminance / cubemapLuminance);
+    drawCubemap(matMV, matP, cubemapLuminance);
+
+    drawStars(matMV, matP, viewport, glm::vec2(-magnitudeLimit, mCubemapMagnitude), false,
+        starLuminance);
+  } else {
+    drawBackground(matMV, matP, backgroundLuminance);
+    drawStars(matMV, matP, viewport, glm::vec2(-magnitudeLimit, magnitudeLimit), mEnableSplatting,
+        starLuminance);
+  }
 
-    float fadeOut =
-        mEnableHDR ? 0.001F * mLuminanceMultiplicator : mLuminanceMultiplicator * sceneBrightness;
+  glDepthMask(GL_TRUE);
+  glPopAttrib();
 
-    VistaTransformMatrix matMVNoTranslation = matModelView;
+  return true;
+}
 
-    // reduce jitter
-    matMVNoTranslation[0][3] = 0.F;
-    matMVNoTranslation[1][3] = 0.F;
-    matMVNoTranslation[2][3] = 0.F;
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    VistaTransformMatrix matMVP(matProjection * matMVNoTranslation);
-    VistaTransformMatrix matInverseMVP(matMVP.GetInverted());
-    VistaTransformMatrix matInverseMV(matMVNoTranslation.GetInverted());
+void Stars::drawBackground(
+    glm::mat4 const& matModelView, glm::mat4 const& matProjection, float luminanceMultiplicator) {
 
-    glUniformMatrix4fv(mUniforms.bgInverseMVPMatrix, 1, GL_FALSE, matInverseMVP.GetData());
-    glUniformMatrix4fv(mUniforms.bgInverseMVMatrix, 1, GL_FALSE, matInverseMV.GetData());
+  bool drawCelestialGrid = mCelestialGridTexture && mBackgroundColor1[3] != 0.F;
+  bool drawStarFigures   = mStarFiguresTexture && mBackgroundColor2[3] != 0.F;
 
-    if (mCelestialGridTexture && mBackgroundColor1[3] != 0.F) {
-      mBackgroundShader.SetUniform(mUniforms.bgColor, mBackgroundColor1[0], mBackgroundColor1[1],
-          mBackgroundColor1[2], mBackgroundColor1[3] * fadeOut);
-      mCelestialGridTexture->Bind(GL_TEXTURE0);
-      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-      mCelestialGridTexture->Unbind(GL_TEXTURE0);
-    }
+  if (!drawCelestialGrid && !drawStarFigures) {
+    return;
+  }
 
-    if (mStarFiguresTexture && mBackgroundColor2[3] != 0.F) {
-      mBackgroundShader.SetUniform(mUniforms.bgColor, mBackgroundColor2[0], mBackgroundColor2[1],
-          mBackgroundColor2[2], mBackgroundColor2[3] * fadeOut);
-      mStarFiguresTexture->Bind(GL_TEXTURE0);
-      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-      mStarFiguresTexture->Unbind(GL_TEXTURE0);
-    }
+  mBackgroundVAO.Bind();
+  mBackgroundShader.Bind();
+  mBackgroundShader.SetUniform(mUniforms.bgTexture, 0);
 
-    mBackgroundShader.Release();
-    mBackgroundVAO.Release();
+  // reduce jitter
+  glm::mat4 matMVNoTranslation = matModelView;
+  matMVNoTranslation[3]        = glm::vec4(0.F, 0.F, 0.F, 1.F);
+
+  glm::mat4 matInverseMVP = glm::inverse(matProjection * matMVNoTranslation);
+  glm::mat4 matInverseMV  = glm::inverse(matMVNoTranslation);
+
+  glUniformMatrix4fv(mUniforms.bgInverseMVPMatrix, 1, GL_FALSE, glm::value_ptr(matInverseMVP));
+  glUniformMatrix4fv(mUniforms.bgInverseMVMatrix, 1, GL_FALSE, glm::value_ptr(matInverseMV));
+
+  if (drawCelestialGrid) {
+    mBackgroundShader.SetUniform(mUniforms.bgColor, mBackgroundColor1[0], mBackgroundColor1[1],
+        mBackgroundColor1[2], mBackgroundColor1[3] * luminanceMultiplicator);
+    mCelestialGridTexture->Bind(GL_TEXTURE0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    mCelestialGridTexture->Unbind(GL_TEXTURE0);
+  }
+
+  if (drawStarFigures) {
+    mBackgroundShader.SetUniform(mUniforms.bgColor, mBackgroundColor2[0], mBackgroundColor2[1],
+        mBackgroundColor2[2], mBackgroundColor2[3] * luminanceMultiplicator);
+    mStarFiguresTexture->Bind(GL_TEXTURE0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    mStarFiguresTexture->Unbind(GL_TEXTURE0);
   }
 
-  // draw stars
+  mBackgroundShader.Release();
+  mBackgroundVAO.Release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::drawStars(glm::mat4 const& matModelView, glm::mat4 const& matProjection,
+    std::array<int, 4> const& viewport, glm::vec2 const& magnitudes, bool splat,
+    float luminanceMultiplicator) {
+
+  // Stars which are brighter than this are drawn according to the draw mode, the others are
+  // splatted.
+  float splatMagnitude =
+      splat ? std::clamp(mSplatMagnitude, magnitudes.x, magnitudes.y) : magnitudes.y;
+
   mStarVAO.Bind();
   mStarShader.Bind();
 
@@ -449,9 +931,6 @@ bool Stars::Do() {
     glDisable(GL_POINT_SMOOTH);
   }
 
-  std::array<int, 4> viewport{};
-  glGetIntegerv(GL_VIEWPORT, viewport.data());
-
   mStarShader.SetUniform(mUniforms.starResolution, static_cast<float>(viewport.at(2)),
       static_cast<float>(viewport.at(3)));
 
@@ -461,29 +940,43 @@ bool Stars::Do() {
   mStarShader.SetUniform(mUniforms.starMinMagnitude, mMinMagnitude);
   mStarShader.SetUniform(mUniforms.starMaxMagnitude, mMaxMagnitude);
   mStarShader.SetUniform(mUniforms.starSolidAngle, mSolidAngle);
+  mStarShader.SetUniform(mUniforms.starDrawMagnitudes, magnitudes.x, splatMagnitude);
+  mStarShader.SetUniform(mUniforms.starLuminanceMul, luminanceMultiplicator);
+
+  glm::mat4 matInverseMV = glm::inverse(matModelView);
+  glm::mat4 matInverseP  = glm::inverse(matProjection);
+
+  glUniformMatrix4fv(mUniforms.starMVMatrix, 1, GL_FALSE, glm::value_ptr(matModelView));
+  glUniformMatrix4fv(mUniforms.starPMatrix, 1, GL_FALSE, glm::value_ptr(matProjection));
+  glUniformMatrix4fv(mUniforms.starInverseMVMatrix, 1, GL_FALSE, glm::value_ptr(matInverseMV));
+  glUniformMatrix4fv(mUniforms.starInversePMatrix, 1, GL_FALSE, glm::value_ptr(matInverseP));
+
+  // Only the stars of the visible cells which are bright enough are drawn.
+  if (getVisibleCells(matModelView, matProjection, magnitudes, splatMagnitude)) {
+    if (mStarStream) {
+      mStarStream->update(mDrawFirsts, mDrawCounts);
+      mSplatFirsts = mDrawFirsts;
+      mSplatCounts = mDrawCounts;
+    }
 
-  float fadeOut = mEnableHDR ? 1.F : sceneBrightness;
-  mStarShader.SetUniform(mUniforms.starLuminanceMul, mLuminanceMultiplicator * fadeOut);
-
-  VistaTransformMatrix matInverseMV(matModelView.GetInverted());
-  VistaTransformMatrix matInverseP(matProjection.GetInverted());
-
-  glUniformMatrix4fv(mUniforms.starMVMatrix, 1, GL_FALSE, matModelView.GetData());
-  glUniformMatrix4fv(mUniforms.starPMatrix, 1, GL_FALSE, matProjection.GetData());
-  glUniformMatrix4fv(mUniforms.starInverseMVMatrix, 1, GL_FALSE, matInverseMV.GetData());
-  glUniformMatrix4fv(mUniforms.starInversePMatrix, 1, GL_FALSE, matInverseP.GetData());
+    glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+        static_cast<GLsizei>(mDrawFirsts.size()));
+  } else {
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mStarCount));
 
-  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mStars.size()));
+    mSplatFirsts.assign(1, 0);
+    mSplatCounts.assign(1, static_cast<GLsizei>(mStarCount));
+  }
 
   mStarTexture->Unbind(GL_TEXTURE0);
 
   mStarShader.Release();
   mStarVAO.Release();
 
-  glDepthMask(GL_TRUE);
-  glPopAttrib();
-
-  return true;
+  if (splat && splatMagnitude < magnitudes.y) {
+    drawSplattedStars(matModelView, matProjection, viewport,
+        glm::vec2(splatMagnitude, magnitudes.y), luminanceMultiplicator);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -501,221 +994,315 @@ bool Stars::GetBoundingBox(VistaBoundingBox& oBoundingBox) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool Stars::readStarsFromCatalog(CatalogType type, std::string const& filename) {
-  bool success = false;
+bool Stars::readStarsFromCatalog(CatalogType type, std::string const& filename,
+    bool skipHipparcos, std::vector<Star>& stars) {
   logger().info("Reading star catalog '{}'.", filename);
 
-  std::ifstream file;
+  boost::system::error_code error;
+  auto                      fileSize = boost::filesystem::file_size(filename, error);
+
+  if (error) {
+    logger().error("Failed to load stars: Cannot open catalog file '{}'!", filename);
+    return false;
+  }
+
+  if (fileSize == 0) {
+    logger().info("Read a total of {} stars.", stars.size());
+    return true;
+  }
+
+  // The catalog is mapped into memory and split into chunks at line boundaries. The chunks are
+  // parsed in parallel and the results are appended in the original order afterwards.
+  boost::interprocess::file_mapping  mapping;
+  boost::interprocess::mapped_region region;
 
   try {
-    file.open(filename.c_str(), std::ifstream::in);
-  } catch (std::exception& e) {
+    mapping = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+    region  = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only);
+  } catch (std::exception const& e) {
     logger().error("Failed to open catalog file '{}': {}", filename, e.what());
+    return false;
   }
 
-  if (file.is_open()) {
-    int  lineCount = 0;
-    bool loadHipparcos(mCatalogs.find(CatalogType::eHipparcos) != mCatalogs.end());
+  std::string_view data(static_cast<char const*>(region.get_address()), region.get_size());
+
+  auto const& columns = cColumnMapping.at(cs::utils::enumCast(type));
+  int const   vmagCol = columns.at(cs::utils::enumCast(CatalogColumn::eVmag));
+  int const   bmagCol = columns.at(cs::utils::enumCast(CatalogColumn::eBmag));
+  int const   rectCol = columns.at(cs::utils::enumCast(CatalogColumn::eRect));
+  int const   declCol = columns.at(cs::utils::enumCast(CatalogColumn::eDecl));
+  int const   paraCol = columns.at(cs::utils::enumCast(CatalogColumn::ePara));
+  int const   hippCol = columns.at(cs::utils::enumCast(CatalogColumn::eHipp));
+  int const   maxCol  = std::max(12, *std::max_element(columns.begin(), columns.end()));
+
+  auto parseChunk = [&](std::string_view chunk) {
+    std::vector<Star>             result;
+    std::vector<std::string_view> items;
 
-    // read line by line
-    while (!file.eof()) {
-      // get line
-      ++lineCount;
-      std::string line;
-      getline(file, line);
+    while (!chunk.empty()) {
+      auto             lineEnd = chunk.find('\n');
+      std::string_view line    = chunk.substr(0, lineEnd);
+      chunk.remove_prefix(lineEnd == std::string_view::npos ? chunk.size() : lineEnd + 1);
 
-      // parse line:
       // separate complete items consisting of "val0|val1|...|valN|" into vector of value strings
-      std::vector<std::string> items = cs::utils::splitString(line, '|');
+      items.clear();
+      for (std::size_t start = 0;;) {
+        auto end = line.find('|', start);
+        items.push_back(line.substr(start, end - start));
 
-      // convert value strings to int/double/float and save in star data structure
-      // expecting Hipparcos or Tycho-1 catalog and more than 12 columns
-      if (items.size() > 12) {
-        // skip if part of hipparcos catalogue
-        int tmp{};
-        if (type != CatalogType::eHipparcos && loadHipparcos &&
-            fromString<int>(items[cColumnMapping.at(cs::utils::enumCast(type))
-                                      .at(cs::utils::enumCast(CatalogColumn::eHipp))],
-                tmp)) {
-          continue;
+        if (end == std::string_view::npos) {
+          break;
         }
 
-        // store star data
-        bool successStoreData(true);
-
-        Star star{};
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eVmag)]],
-            star.mVMagnitude);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eBmag)]],
-            star.mBMagnitude);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eRect)]],
-            star.mAscension);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eDecl)]],
-            star.mDeclination);
-
-        if (cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::ePara)] > 0) {
-          if (!fromString<float>(items[cColumnMapping.at(cs::utils::enumCast(type))
-                                           .at(cs::utils::enumCast(CatalogColumn::ePara))],
-                  star.mParallax)) {
-            star.mParallax = 0;
-          }
-        } else {
-          star.mParallax = 0;
-        }
+        start = end + 1;
+      }
 
-        if (successStoreData) {
-          star.mAscension   = (360.F + 90.F - star.mAscension) / 180.F * Vista::Pi;
-          star.mDeclination = star.mDeclination / 180.F * Vista::Pi;
+      // expecting Hipparcos or Tycho-1 catalog and more than 12 columns
+      if (static_cast<int>(items.size()) <= maxCol) {
+        continue;
+      }
 
-          mStars.emplace_back(star);
-        }
+      // skip if part of hipparcos catalogue
+      int hipp{};
+      if (skipHipparcos && parseInt(items[hippCol], hipp)) {
+        continue;
       }
 
-      // print progress status
-      if (mStars.size() % 10000 == 0) {
-        logger().info("Read {} stars so far...", mStars.size());
+      Star star{};
+      bool successStoreData = parseFloat(items[vmagCol], star.mVMagnitude) &&
+                              parseFloat(items[bmagCol], star.mBMagnitude) &&
+                              parseFloat(items[rectCol], star.mAscension) &&
+                              parseFloat(items[declCol], star.mDeclination);
+
+      if (paraCol < 0 || !parseFloat(items[paraCol], star.mParallax)) {
+        star.mParallax = 0;
+      }
+
+      if (successStoreData) {
+        star.mAscension   = (360.F + 90.F - star.mAscension) / 180.F * Vista::Pi;
+        star.mDeclination = star.mDeclination / 180.F * Vista::Pi;
+
+        result.emplace_back(star);
       }
     }
-    file.close();
-    success = true;
 
-    logger().info("Read a total of {} stars.", mStars.size());
-  } else {
-    logger().error("Failed to load stars: Cannot open catalog file '{}'!", filename);
+    return result;
+  };
+
+  // Use several chunks per thread so that the load is balanced even if some chunks contain many
+  // rejected lines.
+  std::size_t threadCount = std::max(1U, std::thread::hardware_concurrency());
+  std::size_t chunkCount  = std::min<std::size_t>(threadCount * 4, data.size() / 4096 + 1);
+
+  cs::utils::ThreadPool                       pool(threadCount);
+  std::vector<std::future<std::vector<Star>>> results;
+  results.reserve(chunkCount);
+
+  std::size_t chunkStart = 0;
+
+  for (std::size_t i = 1; i <= chunkCount && chunkStart < data.size(); ++i) {
+    std::size_t chunkEnd = data.size();
+
+    // Each chunk but the last ends after the first line break following its nominal end.
+    if (i < chunkCount) {
+      chunkEnd = data.find('\n', std::max(chunkStart, data.size() * i / chunkCount));
+      chunkEnd = chunkEnd == std::string_view::npos ? data.size() : chunkEnd + 1;
+    }
+
+    auto chunk = data.substr(chunkStart, chunkEnd - chunkStart);
+    results.emplace_back(pool.enqueue([&parseChunk, chunk]() { return parseChunk(chunk); }));
+
+    chunkStart = chunkEnd;
+  }
+
+  // Wait for all tasks before retrieving any result, get() may throw an exception.
+  for (auto& result : results) {
+    result.wait();
+  }
+
+  for (auto& result : results) {
+    auto chunkStars = result.get();
+    stars.insert(stars.end(), chunkStars.begin(), chunkStars.end());
   }
 
-  return success;
+  logger().info("Read a total of {} stars.", stars.size());
+
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Stars::writeStarCache(const std::string& sCacheFile) const {
-  VistaType::uint32 catalogs = 0;
-  for (auto const& mCatalog : mCatalogs) {
-    catalogs += static_cast<uint32_t>(std::pow(2, static_cast<int>(mCatalog.first)));
+uint32_t Stars::getCatalogFlags(std::map<CatalogType, std::string> const& catalogs) {
+  uint32_t flags = 0;
+  for (auto const& catalog : catalogs) {
+    flags |= 1U << static_cast<uint32_t>(catalog.first);
   }
 
-  VistaByteBufferSerializer serializer;
-  serializer.WriteInt32(
-      static_cast<VistaType::uint32>(cCacheVersion)); // cache format version number
-  serializer.WriteInt32(catalogs);                    // cache format version number
-  serializer.WriteInt32(static_cast<VistaType::uint32>(
-      mStars.size())); // write number of stars to front of byte stream
+  return flags;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  for (const auto& mStar : mStars) {
-    // serialize star data into byte stream
-    serializer.WriteFloat32(mStar.mVMagnitude);
-    serializer.WriteFloat32(mStar.mBMagnitude);
-    serializer.WriteFloat32(mStar.mAscension);
-    serializer.WriteFloat32(mStar.mDeclination);
-    serializer.WriteFloat32(mStar.mParallax);
+uint64_t Stars::getCatalogHash(std::map<CatalogType, std::string> const& catalogs) {
+
+  // Hashing the contents of the catalogs would take about as long as parsing them. Hence the path,
+  // the size and the modification time of each catalog file are hashed instead.
+  uint64_t result = hash(nullptr, 0);
+
+  for (auto const& [type, file] : catalogs) {
+    boost::system::error_code error;
+    auto                      size = boost::filesystem::file_size(file, error);
+    auto                      time = boost::filesystem::last_write_time(file, error);
+
+    result = hash(&type, sizeof(type), result);
+    result = hash(file.data(), file.size(), result);
+    result = hash(&size, sizeof(size), result);
+    result = hash(&time, sizeof(time), result);
   }
 
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Stars::writeStarCache(CatalogData const& data) {
+  CacheHeader header{};
+  header.mMagic       = cacheMagic;
+  header.mVersion     = static_cast<uint32_t>(cCacheVersion);
+  header.mCatalogs    = getCatalogFlags(data.mCatalogs);
+  header.mStarCount   = static_cast<uint32_t>(data.mVertices.size() / starElementCount);
+  header.mCatalogHash = getCatalogHash(data.mCatalogs);
+
   // open file
   std::ofstream file;
-  file.open(sCacheFile.c_str(), std::ios::out | std::ios::binary);
+  file.open(data.mCacheFile.c_str(), std::ios::out | std::ios::binary);
   if (file.is_open()) {
-    // write serialized star data
-    logger().info("Writing {} stars ({} bytes) into '{}'.", mStars.size(),
-        serializer.GetBufferSize(), sCacheFile);
+    std::size_t size = data.mVertices.size() * sizeof(float);
+
+    // write header and vertex data
+    logger().info("Writing {} stars ({} bytes) into '{}'.", header.mStarCount,
+        sizeof(CacheHeader) + size + data.mBinStarts.size() * sizeof(uint32_t), data.mCacheFile);
 
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    file.write(reinterpret_cast<const char*>(serializer.GetBuffer()), serializer.GetBufferSize());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.write(
+        reinterpret_cast<const char*>(data.mVertices.data()), static_cast<std::streamsize>(size));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.write(reinterpret_cast<const char*>(data.mBinStarts.data()),
+        static_cast<std::streamsize>(data.mBinStarts.size() * sizeof(uint32_t)));
     file.close();
-  } else {
-    logger().error(
-        "Failed to write binary star data: Cannot open file '{}' for writing!", sCacheFile);
+
+    return !file.fail();
   }
+
+  logger().error(
+      "Failed to write binary star data: Cannot open file '{}' for writing!", data.mCacheFile);
+
+  return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool Stars::readStarCache(const std::string& sCacheFile) {
-  bool success = false;
+bool Stars::readStarCache(CatalogData& data, std::size_t maxGPUStars) {
+  boost::system::error_code error;
+  auto                      fileSize = boost::filesystem::file_size(data.mCacheFile, error);
 
-  // open file
-  std::ifstream file;
-  file.open(sCacheFile.c_str(),
-      std::ios::in | std::ios::binary | std::ios::ate); // ate = set read pointer to end
-  if (file.is_open()) {
+  if (error || fileSize < sizeof(CacheHeader)) {
+    return false;
+  }
 
-    // read binary data from file
-    int                          size = static_cast<int>(file.tellg());
-    std::vector<VistaType::byte> data(size);
+  // The file is mapped into memory and the data is copied directly from there.
+  boost::interprocess::file_mapping  mapping;
+  boost::interprocess::mapped_region region;
 
-    // set read pointer to the beginning of file stream
-    file.seekg(0, std::ios::beg);
+  try {
+    mapping =
+        boost::interprocess::file_mapping(data.mCacheFile.c_str(), boost::interprocess::read_only);
+    region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only);
+  } catch (std::exception const& e) {
+    logger().warn("Failed to map star cache '{}': {}", data.mCacheFile, e.what());
+    return false;
+  }
 
-    // read file stream into char array 'data'
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    file.read(reinterpret_cast<char*>(&data[0]), size);
-    file.close();
+  auto const* bytes = static_cast<char const*>(region.get_address());
 
-    // de-serialize byte stream
-    VistaType::uint32 cacheVersion = 0;
-    VistaType::uint32 catalogs     = 0;
-    VistaType::uint32 numStars     = 0;
+  CacheHeader header{};
+  std::memcpy(&header, bytes, sizeof(CacheHeader));
 
-    VistaByteBufferDeSerializer deserializer;
-    deserializer.SetBuffer(&data[0], size); // prepare for de-serialization
-    deserializer.ReadInt32(cacheVersion);   // read cache format version number
-    deserializer.ReadInt32(catalogs);       // read which catalogs were loaded
-    deserializer.ReadInt32(numStars);       // read number of stars from front of byte stream
+  if (header.mMagic != cacheMagic || header.mVersion != static_cast<uint32_t>(cCacheVersion) ||
+      header.mCatalogs != getCatalogFlags(data.mCatalogs) ||
+      header.mCatalogHash != getCatalogHash(data.mCatalogs)) {
+    return false;
+  }
 
-    if (cacheVersion != cCacheVersion) {
-      return false;
-    }
+  std::size_t verticesSize  = header.mStarCount * starElementCount * sizeof(float);
+  std::size_t binStartsSize = (cellCount * magnitudeBinCount + 1) * sizeof(uint32_t);
 
-    VistaType::uint32 catalogsToLoad = 0;
-    for (const auto& mCatalog : mCatalogs) {
-      catalogsToLoad += static_cast<uint32_t>(std::pow(2, static_cast<int>(mCatalog.first)));
-    }
+  if (fileSize != sizeof(CacheHeader) + verticesSize + binStartsSize) {
+    logger().warn("Ignoring star cache '{}': The file is truncated!", data.mCacheFile);
+    return false;
+  }
 
-    if (catalogs != catalogsToLoad) {
-      return false;
-    }
+  data.mStarCount = header.mStarCount;
+  data.mBinStarts.resize(cellCount * magnitudeBinCount + 1);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(data.mBinStarts.data(), bytes + sizeof(CacheHeader) + verticesSize, binStartsSize);
 
-    for (unsigned int num = 0; num < numStars; ++num) {
-      Star star{};
-      deserializer.ReadFloat32(star.mVMagnitude);
-      deserializer.ReadFloat32(star.mBMagnitude);
-      deserializer.ReadFloat32(star.mAscension);
-      deserializer.ReadFloat32(star.mDeclination);
-      deserializer.ReadFloat32(star.mParallax);
+  // The vertices of large catalogs are read by the StarStream later.
+  if (maxGPUStars > 0 && header.mStarCount > maxGPUStars) {
+    data.mStreamed = true;
+    return true;
+  }
 
-      mStars.emplace_back(star);
+  data.mVertices.resize(header.mStarCount * starElementCount);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(data.mVertices.data(), bytes + sizeof(CacheHeader), verticesSize);
 
-      // print progress status
-      if (mStars.size() % 100000 == 0) {
-        logger().info("Read {} stars so far...", mStars.size());
-      }
-    }
+  logger().info("Read a total of {} stars.", header.mStarCount);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<float> Stars::getStarVertices(
+    std::vector<Star>& stars, std::vector<uint32_t>& binStarts) {
 
-    success = true;
+  // Sort the stars by cell and magnitude bin. Within each bin, the stars are sorted by magnitude so
+  // that the brightest stars come first.
+  auto getDirection = [](Star const& star) {
+    return glm::vec3(glm::cos(star.mDeclination) * glm::cos(star.mAscension),
+        glm::sin(star.mDeclination), glm::cos(star.mDeclination) * glm::sin(star.mAscension));
+  };
 
-    logger().info("Read a total of {} stars.", mStars.size());
+  std::vector<uint32_t> bins(stars.size());
+  for (std::size_t i = 0; i < stars.size(); ++i) {
+    bins[i] = getCell(getDirection(stars[i])) * magnitudeBinCount +
+              getMagnitudeBin(stars[i].mVMagnitude);
   }
 
-  return success;
-}
+  std::vector<std::size_t> order(stars.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+    return bins[a] < bins[b] || (bins[a] == bins[b] && stars[a].mVMagnitude < stars[b].mVMagnitude);
+  });
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<Star> sorted(stars.size());
+  binStarts.assign(cellCount * magnitudeBinCount + 1, 0);
+
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    sorted[i] = stars[order[i]];
+    ++binStarts[bins[order[i]] + 1];
+  }
+
+  std::partial_sum(binStarts.begin(), binStarts.end(), binStarts.begin());
+  stars = std::move(sorted);
 
-void Stars::buildStarVAO() {
-  int                c(0);
-  const int          iElementCount(7);
-  std::vector<float> data(iElementCount * mStars.size());
+  std::size_t        c(0);
+  std::vector<float> data(starElementCount * stars.size());
 
-  for (auto it = mStars.begin(); it != mStars.end(); ++it, c += iElementCount) {
+  for (auto it = stars.begin(); it != stars.end(); ++it, c += starElementCount) {
     // use B and V magnitude to retrieve the according color
     const float minIdx(-0.4F);
     const float maxIdx(2.0F);
@@ -745,24 +1332,424 @@ void Stars::buildStarVAO() {
     data[c + 6] = it->mVMagnitude - 5.F * std::log10(fDist / 10.F);
   }
 
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::buildStarVAO(void const* vertices, std::size_t starCount) {
+  mStarCount = starCount;
+
+  // Compute the center direction and the angular radius of each cell.
+  mCellBounds.resize(cellCount);
+
+  for (uint32_t cell = 0; cell < cellCount; ++cell) {
+    uint32_t  face = cell / (cellResolution * cellResolution);
+    glm::vec2 min  = glm::vec2(cell / cellResolution % cellResolution, cell % cellResolution) /
+                    static_cast<float>(cellResolution) * 2.F - 1.F;
+    glm::vec2 max  = min + 2.F / static_cast<float>(cellResolution);
+
+    glm::vec3 center = getCubeMapDirection(face, (min + max) * 0.5F);
+    float     radius = 0.F;
+
+    for (auto const& uv : {min, max, glm::vec2(min.x, max.y), glm::vec2(max.x, min.y)}) {
+      radius = std::max(radius, std::acos(std::clamp(
+                                    glm::dot(center, getCubeMapDirection(face, uv)), -1.F, 1.F)));
+    }
+
+    mCellBounds.at(cell) = glm::vec4(center, radius);
+  }
+
+  auto stride = static_cast<GLsizei>(starElementCount * sizeof(float));
+
+  // Without vertex data, the buffer is only allocated and filled later by the StarStream.
   mStarVBO.Bind(GL_ARRAY_BUFFER);
-  mStarVBO.BufferData(iElementCount * mStars.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+  mStarVBO.BufferData(
+      static_cast<GLsizeiptr>(starCount * starElementCount * sizeof(float)), vertices,
+      vertices ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
   mStarVBO.Release();
 
   // star positions
   mStarVAO.EnableAttributeArray(0);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      0, 3, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 0, &mStarVBO);
+  mStarVAO.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, stride, 0, &mStarVBO);
 
   // color
   mStarVAO.EnableAttributeArray(1);
   mStarVAO.SpecifyAttributeArrayFloat(
-      1, 3, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 3 * sizeof(float), &mStarVBO);
+      1, 3, GL_FLOAT, GL_FALSE, stride, 3 * sizeof(float), &mStarVBO);
 
   // magnitude
   mStarVAO.EnableAttributeArray(2);
   mStarVAO.SpecifyAttributeArrayFloat(
-      2, 1, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 6 * sizeof(float), &mStarVBO);
+      2, 1, GL_FLOAT, GL_FALSE, stride, 6 * sizeof(float), &mStarVBO);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Stars::getVisibleCells(glm::mat4 const& matModelView, glm::mat4 const& matProjection,
+    glm::vec2 const& magnitudes, float splatMagnitude) {
+  if (mBinStarts.size() != cellCount * magnitudeBinCount + 1) {
+    return false;
+  }
+
+  const float parsecToMeter = 3.08567758e16F;
+  glm::vec3   observerPos(glm::inverse(matModelView)[3]);
+
+  // Far away from the sun, the cells cannot be culled anymore.
+  bool cullCells = glm::length(observerPos) / parsecToMeter <= maxCullingDistance;
+
+  // Compute a cone around the view direction which contains the entire frustum.
+  glm::mat4                inverseProjection = glm::inverse(matProjection);
+  std::array<glm::vec3, 4> corners;
+  glm::vec3                axis(0.F);
+
+  for (std::size_t i = 0; i < corners.size(); ++i) {
+    glm::vec4 corner =
+        inverseProjection * glm::vec4(i % 2 == 0 ? -1.F : 1.F, i < 2 ? -1.F : 1.F, 0.F, 1.F);
+    corners.at(i) = glm::normalize(glm::vec3(corner) / corner.w);
+    axis += corners.at(i);
+  }
+
+  axis = glm::normalize(axis);
+
+  float frustumAngle = 0.F;
+  for (auto const& corner : corners) {
+    frustumAngle = std::max(frustumAngle, std::acos(std::clamp(glm::dot(axis, corner), -1.F, 1.F)));
+  }
+
+  // The magnitude bins are open-ended, so the bin containing the upper magnitude limit is the last
+  // one which has to be drawn. As the bins are computed for an observer at the sun, all bins have
+  // to be drawn if the cells cannot be culled, else stars which appear brighter from the observer
+  // than from the sun would be missing.
+  uint32_t lastBin =
+      cullCells ? getMagnitudeBin(std::min(magnitudes.y, mMaxMagnitude)) : magnitudeBinCount - 1;
+  glm::mat3 rotation = glm::mat3(matModelView);
+
+  // The bins containing the lower limit and the splat magnitude are included in both adjacent
+  // ranges, the shaders select the stars of these bins by their magnitude. As the bins are computed
+  // for an observer at the sun, this is only possible if the cells can be culled. Streamed ranges
+  // cannot be split, as they are replaced by the resident ranges.
+  bool     splitRanges = cullCells && !mStarStream;
+  uint32_t firstBin    = splitRanges ? std::min(getMagnitudeBin(magnitudes.x), lastBin) : 0;
+  uint32_t splatBin    = std::clamp(getMagnitudeBin(splatMagnitude), firstBin, lastBin);
+
+  mDrawFirsts.clear();
+  mDrawCounts.clear();
+  mSplatFirsts.clear();
+  mSplatCounts.clear();
+
+  for (uint32_t cell = 0; cell < cellCount; ++cell) {
+    uint32_t first = mBinStarts[cell * magnitudeBinCount + firstBin];
+    uint32_t last  = mBinStarts[cell * magnitudeBinCount + lastBin + 1];
+
+    if (first == last) {
+      continue;
+    }
+
+    auto const& bounds    = mCellBounds.at(cell);
+    glm::vec3   direction = glm::normalize(rotation * glm::vec3(bounds));
+    float       angle     = std::acos(std::clamp(glm::dot(axis, direction), -1.F, 1.F));
+
+    if (cullCells && angle > frustumAngle + bounds.w + cellMargin) {
+      continue;
+    }
+
+    if (splitRanges) {
+      uint32_t splatFirst = mBinStarts[cell * magnitudeBinCount + splatBin];
+      uint32_t drawLast   = mBinStarts[cell * magnitudeBinCount + splatBin + 1];
+
+      if (drawLast > first) {
+        mDrawFirsts.push_back(static_cast<GLint>(first));
+        mDrawCounts.push_back(static_cast<GLsizei>(drawLast - first));
+      }
+
+      if (last > splatFirst) {
+        mSplatFirsts.push_back(static_cast<GLint>(splatFirst));
+        mSplatCounts.push_back(static_cast<GLsizei>(last - splatFirst));
+      }
+    } else {
+      mDrawFirsts.push_back(static_cast<GLint>(first));
+      mDrawCounts.push_back(static_cast<GLsizei>(last - first));
+    }
+  }
+
+  if (!splitRanges) {
+    mSplatFirsts = mDrawFirsts;
+    mSplatCounts = mDrawCounts;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::drawSplattedStars(glm::mat4 const& matModelView, glm::mat4 const& matProjection,
+    std::array<int, 4> const& viewport, glm::vec2 const& magnitudes,
+    float luminanceMultiplicator) {
+
+  CS_TRACE_ZONE("Stars::drawSplattedStars");
+
+  glm::ivec2 size(viewport.at(2), viewport.at(3));
+
+  if (size.x <= 0 || size.y <= 0) {
+    return;
+  }
+
+  // The accumulation buffer has to be zero initially. Afterwards, it is reset by the full-screen
+  // pass. It is only enlarged, so that rendering the cubemap faces does not reallocate it.
+  if (size.x * size.y > mSplatBufferSize.x * mSplatBufferSize.y) {
+    auto& memory = cs::graphics::GpuMemory::get();
+    memory.release("Stars",
+        sizeof(uint32_t) * 3 * static_cast<std::size_t>(mSplatBufferSize.x * mSplatBufferSize.y));
+
+    mSplatBufferSize = size;
+    std::vector<uint32_t> zeros(3 * static_cast<std::size_t>(size.x * size.y), 0U);
+
+    if (mSplatBuffer == 0) {
+      glGenBuffers(1, &mSplatBuffer);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSplatBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+        static_cast<GLsizeiptr>(zeros.size() * sizeof(uint32_t)), zeros.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    memory.allocate("Stars", zeros.size() * sizeof(uint32_t));
+  }
+
+  // For each range, store its first star and the number of stars in all preceding ranges.
+  std::vector<glm::uvec2> ranges;
+  ranges.reserve(mSplatFirsts.size());
+
+  uint32_t starCount = 0;
+  for (std::size_t i = 0; i < mSplatFirsts.size(); ++i) {
+    if (mSplatCounts[i] > 0) {
+      ranges.emplace_back(static_cast<uint32_t>(mSplatFirsts[i]), starCount);
+      starCount += static_cast<uint32_t>(mSplatCounts[i]);
+    }
+  }
+
+  if (starCount > 0) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSplatRangesBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+        static_cast<GLsizeiptr>(ranges.size() * sizeof(glm::uvec2)), ranges.data(),
+        GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // The brightest splatted stars are stored as 2^24, so that 256 of them can be accumulated in
+    // one pixel. Fainter stars get correspondingly smaller values.
+    float fluxScale = 16777216.F * std::pow(10.F, 0.4F * std::max(magnitudes.x, mMinMagnitude));
+
+    glm::mat4 matInverseMV = glm::inverse(matModelView);
+
+    glUseProgram(mSplatProgram);
+    glUniform1ui(static_cast<GLint>(mUniforms.splatStarCount), starCount);
+    glUniform1ui(
+        static_cast<GLint>(mUniforms.splatRangeCount), static_cast<uint32_t>(ranges.size()));
+    glUniform2f(static_cast<GLint>(mUniforms.splatResolution), static_cast<float>(size.x),
+        static_cast<float>(size.y));
+    glUniformMatrix4fv(
+        static_cast<GLint>(mUniforms.splatMVMatrix), 1, GL_FALSE, glm::value_ptr(matModelView));
+    glUniformMatrix4fv(
+        static_cast<GLint>(mUniforms.splatPMatrix), 1, GL_FALSE, glm::value_ptr(matProjection));
+    glUniformMatrix4fv(static_cast<GLint>(mUniforms.splatInverseMVMatrix), 1, GL_FALSE,
+        glm::value_ptr(matInverseMV));
+    glUniform1f(static_cast<GLint>(mUniforms.splatMinMagnitude), mMinMagnitude);
+    glUniform1f(static_cast<GLint>(mUniforms.splatMaxMagnitude), mMaxMagnitude);
+    glUniform2f(static_cast<GLint>(mUniforms.splatMagnitudes), magnitudes.x, magnitudes.y);
+    glUniform1f(static_cast<GLint>(mUniforms.splatFluxScale), fluxScale);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mStarVBO.GetId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mSplatRangesBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mSplatBuffer);
+
+    uint32_t const groupSize = 256;
+    glDispatchCompute((starCount + groupSize - 1) / groupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(0);
+
+    // Now add the accumulated luminance to the framebuffer and reset the accumulation buffer.
+    glm::mat4 matInverseP = glm::inverse(matProjection);
+
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    mBackgroundVAO.Bind();
+    mSplatResolveShader.Bind();
+    mSplatResolveShader.SetUniform(
+        mUniforms.resolveResolution, static_cast<float>(size.x), static_cast<float>(size.y));
+    mSplatResolveShader.SetUniform(mUniforms.resolveViewportOffset, viewport.at(0), viewport.at(1));
+    mSplatResolveShader.SetUniform(mUniforms.resolveFluxScale, fluxScale);
+    mSplatResolveShader.SetUniform(mUniforms.resolveLuminanceMul, luminanceMultiplicator);
+    mSplatResolveShader.SetUniform(mUniforms.resolveSolidAngle, mSolidAngle);
+    glUniformMatrix4fv(static_cast<GLint>(mUniforms.resolveInversePMatrix), 1, GL_FALSE,
+        glm::value_ptr(matInverseP));
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    mSplatResolveShader.Release();
+    mBackgroundVAO.Release();
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::updateCubemap(glm::mat4 const& matModelView, float starLuminanceMultiplicator,
+    float backgroundLuminanceMultiplicator) {
+
+  const float parsecToMeter = 3.08567758e16F;
+  glm::vec3   observerPos(glm::inverse(matModelView)[3]);
+
+  // All parameters which affect the content of the cubemap are hashed. Textures which are still
+  // loading are included, so that the cubemap is rendered again once they have been uploaded.
+  uint64_t state = hash(&mStarCount, sizeof(mStarCount));
+  auto     add   = [&state](auto const& value) { state = hash(&value, sizeof(value), state); };
+
+  add(mCubemapResolution);
+  add(mCubemapMagnitude);
+  add(mMinMagnitude);
+  add(mMaxMagnitude);
+  add(mSolidAngle);
+  add(mSplatMagnitude);
+  add(mEnableSplatting);
+  add(starLuminanceMultiplicator);
+  add(backgroundLuminanceMultiplicator);
+
+  for (int i = 0; i < 4; ++i) {
+    add(mBackgroundColor1[i]);
+    add(mBackgroundColor2[i]);
+  }
+
+  for (auto const* texture :
+      {mStarTexture.get(), mCelestialGridTexture.get(), mStarFiguresTexture.get()}) {
+    add(texture);
+    add(cs::graphics::TextureLoader::getIsPending(texture));
+  }
+
+  bool moved = glm::length(observerPos - mCubemapPosition) / parsecToMeter > maxCubemapOffset;
+
+  if (state == mCubemapHash && !moved) {
+    return;
+  }
+
+  CS_TRACE_ZONE("Stars::updateCubemap");
+
+  mCubemapHash     = state;
+  mCubemapPosition = observerPos;
+
+  uint32_t size = std::max(mCubemapResolution, 1U);
+
+  if (mCubemapTextureSize != size) {
+    auto& memory = cs::graphics::GpuMemory::get();
+    memory.release("Stars", 6 * 4 * sizeof(uint16_t) * mCubemapTextureSize * mCubemapTextureSize);
+
+    if (mCubemap == 0) {
+      glGenTextures(1, &mCubemap);
+      glGenFramebuffers(1, &mCubemapFramebuffer);
+    }
+
+    mCubemapTextureSize = size;
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, mCubemap);
+
+    for (uint32_t face = 0; face < 6; ++face) {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA16F,
+          static_cast<GLsizei>(size), static_cast<GLsizei>(size), 0, GL_RGBA, GL_HALF_FLOAT,
+          nullptr);
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    memory.allocate("Stars", 6 * 4 * sizeof(uint16_t) * size * size);
+  }
+
+  // The view directions and up vectors of the cubemap faces in the order of the OpenGL face
+  // targets.
+  std::array<std::array<glm::vec3, 2>, 6> const faces{
+      std::array{glm::vec3(1.F, 0.F, 0.F), glm::vec3(0.F, -1.F, 0.F)},
+      std::array{glm::vec3(-1.F, 0.F, 0.F), glm::vec3(0.F, -1.F, 0.F)},
+      std::array{glm::vec3(0.F, 1.F, 0.F), glm::vec3(0.F, 0.F, 1.F)},
+      std::array{glm::vec3(0.F, -1.F, 0.F), glm::vec3(0.F, 0.F, -1.F)},
+      std::array{glm::vec3(0.F, 0.F, 1.F), glm::vec3(0.F, -1.F, 0.F)},
+      std::array{glm::vec3(0.F, 0.F, -1.F), glm::vec3(0.F, -1.F, 0.F)}};
+
+  glm::mat4 matProjection = glm::infinitePerspective(glm::half_pi<float>(), 1.F, 1.F);
+
+  std::array<int, 4> viewport{0, 0, static_cast<int>(size), static_cast<int>(size)};
+
+  GLint drawFramebuffer = 0;
+  GLint readFramebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+
+  glPushAttrib(GL_VIEWPORT_BIT);
+  glViewport(0, 0, viewport.at(2), viewport.at(3));
+  glBindFramebuffer(GL_FRAMEBUFFER, mCubemapFramebuffer);
+
+  for (uint32_t face = 0; face < 6; ++face) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mCubemap, 0);
+
+    glClearColor(0.F, 0.F, 0.F, 0.F);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    auto const& [direction, up] = faces.at(face);
+    glm::mat4 matModelViewFace = glm::lookAt(glm::vec3(0.F), direction, up) *
+                                 glm::translate(glm::mat4(1.F), -observerPos);
+
+    drawBackground(matModelViewFace, matProjection, backgroundLuminanceMultiplicator);
+    drawStars(matModelViewFace, matProjection, viewport,
+        glm::vec2(mCubemapMagnitude, magnitudeLimit), mEnableSplatting,
+        starLuminanceMultiplicator);
+  }
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(drawFramebuffer));
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(readFramebuffer));
+  glPopAttrib();
+
+  glBlendFunc(GL_ONE, GL_ONE);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stars::drawCubemap(
+    glm::mat4 const& matModelView, glm::mat4 const& matProjection, float luminanceMultiplicator) {
+
+  // The cubemap is sampled with the view direction in the coordinate system of the stars.
+  glm::mat4 matMVNoTranslation = matModelView;
+  matMVNoTranslation[3]        = glm::vec4(0.F, 0.F, 0.F, 1.F);
+
+  glm::mat4 matInverseMVP = glm::inverse(matProjection * matMVNoTranslation);
+  glm::mat4 matInverseMV  = glm::inverse(matMVNoTranslation);
+
+  mBackgroundVAO.Bind();
+  mCubemapShader.Bind();
+
+  glUniformMatrix4fv(static_cast<GLint>(mUniforms.cubemapInverseMVPMatrix), 1, GL_FALSE,
+      glm::value_ptr(matInverseMVP));
+  glUniformMatrix4fv(static_cast<GLint>(mUniforms.cubemapInverseMVMatrix), 1, GL_FALSE,
+      glm::value_ptr(matInverseMV));
+  mCubemapShader.SetUniform(mUniforms.cubemapTexture, 0);
+  mCubemapShader.SetUniform(mUniforms.cubemapLuminanceMul, luminanceMultiplicator);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, mCubemap);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+  mCubemapShader.Release();
+  mBackgroundVAO.Release();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
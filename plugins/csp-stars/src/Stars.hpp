@@ -15,8 +15,12 @@
 #include <VistaOGLExt/VistaTexture.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include "../../../src/cs-utils/FrameStats.hpp"
 #include "../../../src/cs-utils/utils.hpp"
+#include "StarStream.hpp"
 
+#include <array>
+#include <glm/glm.hpp>
 #include <map>
 #include <memory>
 #include <vector>
@@ -50,18 +54,58 @@ class Stars : public IVistaOpenGLDraw {
 
   enum class DrawMode { ePoint, eSmoothPoint, eDisc, eSmoothDisc, eScaledDisc, eSprite };
 
+  Stars() = default;
+
+  Stars(Stars const& other) = delete;
+  Stars(Stars&& other)      = delete;
+
+  Stars& operator=(Stars const& other) = delete;
+  Stars& operator=(Stars&& other)      = delete;
+
+  ~Stars() override;
+
+  /// The stars of a set of catalogs as returned by loadCatalogs(). The vertex data is stored in the
+  /// same layout as in the vertex buffer.
+  struct CatalogData {
+    std::map<CatalogType, std::string> mCatalogs;
+    std::string                        mCacheFile;
+    std::vector<float>                 mVertices;
+    std::vector<uint32_t>              mBinStarts;
+    std::size_t                        mStarCount = 0;
+
+    /// If set, mVertices is empty as the stars have to be streamed from mCacheFile.
+    bool mStreamed = false;
+  };
+
   /// It is possible to load multiple catalogs, currently Hipparcos and any of Tycho or Tycho2 can
   /// be loaded together. Stars which are in both catalogs will be loaded from Hipparcos. Once
   /// loaded, the stars will be written to a binary cache file. Subsequent instantiations of this
   /// class with the same call to setCatalogs() will use the stars from the cache file rather from
-  /// the catalogs.
+  /// the catalogs. This is the same as calling setCatalogData() with the result of loadCatalogs().
   void setCatalogs(std::map<CatalogType, std::string> catalogs);
   std::map<CatalogType, std::string> const& getCatalogs() const;
 
+  /// Reads the stars of the given catalogs, either from the cache file or from the catalogs
+  /// themselves. In the latter case, the cache file is written. If there are more than maxGPUStars
+  /// stars, their vertices are not read at all, as they will be streamed. This requires no OpenGL
+  /// context, so it can be called on a worker thread.
+  static CatalogData loadCatalogs(std::map<CatalogType, std::string> catalogs,
+      std::string cacheFile, std::size_t maxGPUStars);
+
+  /// Uploads the stars returned by loadCatalogs() to the GPU. If they are streamed, the current
+  /// value of getMaxGPUStars() is used as the capacity of the vertex buffer.
+  void setCatalogData(CatalogData data);
+
   /// Subsequent calls to setCatalogs() will use this cache file. Defaults to "star_cache.dat".
   void               setCacheFile(std::string cacheFile);
   std::string const& getCacheFile() const;
 
+  /// If the catalogs loaded by subsequent calls to setCatalogs() contain more stars than this, the
+  /// vertex buffer only holds this many stars. The stars of the visible cells are then streamed
+  /// from the cache file, brighter stars first. Zero disables streaming. Defaults to zero.
+  void        setMaxGPUStars(std::size_t value);
+  std::size_t getMaxGPUStars() const;
+
   /// Specifies how the stars should be drawn.
   void     setDrawMode(DrawMode value);
   DrawMode getDrawMode() const;
@@ -73,6 +117,38 @@ class Stars : public IVistaOpenGLDraw {
   void  setSolidAngle(float value);
   float getSolidAngle() const;
 
+  /// If enabled, stars fainter than the splat magnitude are not drawn as points or quads. Instead,
+  /// a compute shader adds their luminance to the pixel they fall into. The accumulated luminance
+  /// is then added to the framebuffer with a single full-screen pass. As most stars of large
+  /// catalogs are much smaller than a pixel, this removes most of the rasterization and blending
+  /// work. Requires OpenGL 4.3. Splatting is disabled by default.
+  void setEnableSplatting(bool value);
+  bool getEnableSplatting() const;
+
+  /// Stars with an apparent magnitude above this value are splatted if splatting is enabled.
+  /// Brighter stars are drawn according to the draw mode. Default is 6.f.
+  void  setSplatMagnitude(float value);
+  float getSplatMagnitude() const;
+
+  /// If enabled, the sky background and all stars fainter than the cubemap magnitude are rendered
+  /// into a cubemap which is then drawn with a single full-screen pass. Only the brighter stars
+  /// are drawn as usual. The cubemap is rendered again if any parameter of the stars changes or if
+  /// the observer moves far enough for the nearest stars to shift. For an observer inside the
+  /// solar system, this happens only in the high dynamic range mode when the magnitude limits,
+  /// the draw mode or the catalogs change. The cubemap is not used if stars are streamed. It is
+  /// disabled by default.
+  void setEnableCubemap(bool value);
+  bool getEnableCubemap() const;
+
+  /// The edge length of each face of the cubemap in pixels. Default is 1024.
+  void     setCubemapResolution(uint32_t value);
+  uint32_t getCubemapResolution() const;
+
+  /// Stars with an apparent magnitude above this value are stored in the cubemap if it is enabled.
+  /// Default is 4.f.
+  void  setCubemapMagnitude(float value);
+  float getCubemapMagnitude() const;
+
   /// When set to true, stars will be drawn with true luminance values. Else their brightness will
   /// be between 0 and 1.
   void setEnableHDR(bool value);
@@ -128,26 +204,78 @@ class Stars : public IVistaOpenGLDraw {
     float mParallax;
   };
 
-  /// Reads star data from binary file.
-  bool readStarsFromCatalog(CatalogType type, std::string const& filename);
-
-  /// Writes internal star data read from catalog into a binary file.
-  void writeStarCache(const std::string& cacheFile) const;
-
-  /// Reads star data from binary file.
-  bool readStarCache(const std::string& cacheFile);
-
-  /// Build vertex array objects from given star list.
-  void buildStarVAO();
+  /// Reads star data from a catalog file and appends it to the given list. If skipHipparcos is
+  /// set, stars with a Hipparcos number are ignored.
+  static bool readStarsFromCatalog(CatalogType type, std::string const& filename,
+      bool skipHipparcos, std::vector<Star>& stars);
+
+  /// Returns a bit mask of the given catalog types.
+  static uint32_t getCatalogFlags(std::map<CatalogType, std::string> const& catalogs);
+
+  /// Returns a hash of the paths, sizes and modification times of the given catalog files. The
+  /// cache file is only used if this matches the hash stored in it.
+  static uint64_t getCatalogHash(std::map<CatalogType, std::string> const& catalogs);
+
+  /// Writes the vertex data and the bin starts into data.mCacheFile. Returns false if the file
+  /// cannot be written.
+  static bool writeStarCache(CatalogData const& data);
+
+  /// Maps data.mCacheFile into memory and copies its bin starts and, unless there are more than
+  /// maxGPUStars stars, its vertex data to the given object. Returns false if the file does not
+  /// exist or does not match data.mCatalogs.
+  static bool readStarCache(CatalogData& data, std::size_t maxGPUStars);
+
+  /// Sorts the given stars by sky cell and magnitude and computes the vertex buffer data for them.
+  /// binStarts will contain the index of the first star of each magnitude bin of each cell.
+  static std::vector<float> getStarVertices(
+      std::vector<Star>& stars, std::vector<uint32_t>& binStarts);
+
+  /// Fills mDrawFirsts and mDrawCounts with the ranges of stars which are inside the frustum and
+  /// have a magnitude in (magnitudes.x, splatMagnitude]. mSplatFirsts and mSplatCounts receive the
+  /// stars in (splatMagnitude, magnitudes.y]. If the observer is too far away from the sun, all
+  /// stars brighter than mMaxMagnitude are included in both. Returns false if there is no cell
+  /// index at all.
+  bool getVisibleCells(glm::mat4 const& matModelView, glm::mat4 const& matProjection,
+      glm::vec2 const& magnitudes, float splatMagnitude);
+
+  /// Draws the celestial grid and the star figures. The alpha of their colors is multiplied with
+  /// the given value.
+  void drawBackground(
+      glm::mat4 const& matModelView, glm::mat4 const& matProjection, float luminanceMultiplicator);
+
+  /// Draws all stars with a magnitude in (magnitudes.x, magnitudes.y]. If splat is set, the stars
+  /// fainter than mSplatMagnitude are splatted.
+  void drawStars(glm::mat4 const& matModelView, glm::mat4 const& matProjection,
+      std::array<int, 4> const& viewport, glm::vec2 const& magnitudes, bool splat,
+      float luminanceMultiplicator);
+
+  /// Adds the luminance of the stars in mSplatFirsts and mSplatCounts with a magnitude in
+  /// (magnitudes.x, magnitudes.y] to the accumulation buffer and draws the buffer to the
+  /// framebuffer.
+  void drawSplattedStars(glm::mat4 const& matModelView, glm::mat4 const& matProjection,
+      std::array<int, 4> const& viewport, glm::vec2 const& magnitudes,
+      float luminanceMultiplicator);
+
+  /// Renders the background and the stars fainter than mCubemapMagnitude into the six faces of
+  /// mCubemap if anything changed since the last call.
+  void updateCubemap(glm::mat4 const& matModelView, float starLuminanceMultiplicator,
+      float backgroundLuminanceMultiplicator);
+
+  /// Draws mCubemap with a full-screen pass.
+  void drawCubemap(
+      glm::mat4 const& matModelView, glm::mat4 const& matProjection, float luminanceMultiplicator);
+
+  /// Build vertex array objects from the given vertex data.
+  void buildStarVAO(void const* vertices, std::size_t starCount);
   void buildBackgroundVAO();
 
-  std::unique_ptr<VistaTexture> mStarTexture;
+  std::shared_ptr<VistaTexture> mStarTexture;
   std::string                   mStarTextureFile;
 
-  std::unique_ptr<VistaTexture> mCelestialGridTexture;
+  std::shared_ptr<VistaTexture> mCelestialGridTexture;
   std::string                   mCelestialGridTextureFile;
 
-  std::unique_ptr<VistaTexture> mStarFiguresTexture;
+  std::shared_ptr<VistaTexture> mStarFiguresTexture;
   std::string                   mStarFiguresTextureFile;
 
   std::string mCacheFile = "star_cache.dat";
@@ -161,18 +289,61 @@ class Stars : public IVistaOpenGLDraw {
   VistaVertexArrayObject mBackgroundVAO;
   VistaBufferObject      mBackgroundVBO;
 
-  std::vector<Star>                  mStars;
+  std::size_t                        mStarCount = 0;
   std::map<CatalogType, std::string> mCatalogs;
 
+  /// If set, mStarVBO only contains the blocks of stars which are currently streamed in.
+  std::size_t                 mMaxGPUStars = 0;
+  std::unique_ptr<StarStream> mStarStream;
+
+  /// The stars are partitioned into cells of a cube map around the sun. The stars of each cell are
+  /// sorted by their magnitude and grouped into bins of one magnitude. This contains the index of
+  /// the first star of each bin of each cell, followed by the total number of stars. mCellBounds
+  /// contains the center direction (xyz) and the angular radius (w) of each cell.
+  std::vector<uint32_t>  mBinStarts;
+  std::vector<glm::vec4> mCellBounds;
+
+  /// The ranges of stars which are drawn in the current frame. If splatting is enabled, the
+  /// stars in mSplatFirsts and mSplatCounts are splatted. If possible, the first ranges end at the
+  /// magnitude bin of mSplatMagnitude and the second ranges start there. Else both contain all
+  /// visible stars and the shaders select the stars by their magnitude.
+  std::vector<GLint>   mDrawFirsts;
+  std::vector<GLsizei> mDrawCounts;
+  std::vector<GLint>   mSplatFirsts;
+  std::vector<GLsizei> mSplatCounts;
+
+  /// The content of mCubemap depends on all parameters which are included in mCubemapHash and on
+  /// the position of the observer in meters when it was rendered.
+  uint32_t        mCubemap            = 0;
+  uint32_t        mCubemapFramebuffer = 0;
+  uint32_t        mCubemapTextureSize = 0;
+  uint64_t        mCubemapHash        = 0;
+  glm::vec3       mCubemapPosition{0.F};
+  VistaGLSLShader mCubemapShader;
+
+  /// The compute shader reads the stars directly from mStarVBO. mSplatRangesBuffer contains the
+  /// first star and the number of preceding stars of each range. mSplatBuffer contains three
+  /// fixed-point values per pixel of the viewport, these are reset during the full-screen pass.
+  uint32_t        mSplatProgram      = 0;
+  uint32_t        mSplatRangesBuffer = 0;
+  uint32_t        mSplatBuffer       = 0;
+  glm::ivec2      mSplatBufferSize{0};
+  VistaGLSLShader mSplatResolveShader;
+
   DrawMode mDrawMode = DrawMode::eScaledDisc;
 
-  bool  mShaderDirty                = true;
-  bool  mEnableHDR                  = true;
-  float mSolidAngle                 = 0.000005F;
-  float mMinMagnitude               = -5.F;
-  float mMaxMagnitude               = 15.F;
-  float mLuminanceMultiplicator     = 1.F;
-  float mApproximateSceneBrightness = 1.F;
+  bool     mShaderDirty                = true;
+  bool     mEnableHDR                  = true;
+  bool     mEnableSplatting            = false;
+  float    mSplatMagnitude             = 6.F;
+  bool     mEnableCubemap              = false;
+  uint32_t mCubemapResolution          = 1024;
+  float    mCubemapMagnitude           = 4.F;
+  float    mSolidAngle                 = 0.000005F;
+  float    mMinMagnitude               = -5.F;
+  float    mMaxMagnitude               = 15.F;
+  float    mLuminanceMultiplicator     = 1.F;
+  float    mApproximateSceneBrightness = 1.F;
 
   struct {
     uint32_t bgInverseMVMatrix  = 0;
@@ -191,8 +362,34 @@ class Stars : public IVistaOpenGLDraw {
     uint32_t starPMatrix         = 0;
     uint32_t starInverseMVMatrix = 0;
     uint32_t starInversePMatrix  = 0;
+    uint32_t starDrawMagnitudes  = 0;
+
+    uint32_t splatStarCount       = 0;
+    uint32_t splatRangeCount      = 0;
+    uint32_t splatResolution      = 0;
+    uint32_t splatMVMatrix        = 0;
+    uint32_t splatPMatrix         = 0;
+    uint32_t splatInverseMVMatrix = 0;
+    uint32_t splatMinMagnitude    = 0;
+    uint32_t splatMaxMagnitude    = 0;
+    uint32_t splatFluxScale       = 0;
+    uint32_t splatMagnitudes      = 0;
+
+    uint32_t resolveResolution     = 0;
+    uint32_t resolveViewportOffset = 0;
+    uint32_t resolveInversePMatrix = 0;
+    uint32_t resolveFluxScale      = 0;
+    uint32_t resolveLuminanceMul   = 0;
+    uint32_t resolveSolidAngle     = 0;
+
+    uint32_t cubemapInverseMVMatrix  = 0;
+    uint32_t cubemapInverseMVPMatrix = 0;
+    uint32_t cubemapTexture          = 0;
+    uint32_t cubemapLuminanceMul     = 0;
   } mUniforms;
 
+  cs::utils::FrameStats::TimerId mTimerId = cs::utils::FrameStats::intern("Render Stars");
+
   static const int cCacheVersion;
 
   static constexpr size_t NUM_CATALOGS = cs::utils::enumCast(CatalogType::eCount);
@@ -206,6 +403,10 @@ class Stars : public IVistaOpenGLDraw {
   static const char* cStarsVert;
   static const char* cStarsFrag;
   static const char* cStarsGeom;
+  static const char* cStarsSplatComp;
+  static const char* cStarsSplatResolveVert;
+  static const char* cStarsSplatResolveFrag;
+  static const char* cStarsCubemapFrag;
   static const char* cBackgroundVert;
   static const char* cBackgroundFrag;
 };
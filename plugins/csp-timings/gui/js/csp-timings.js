@@ -29,6 +29,27 @@ class TimingsApi extends IApi {
   _sampleData    = [];
   _primitiveData = [];
 
+  /**
+   * This contains an array of [<thread-name>, <ranges>] for each frame, where <ranges> is
+   * structured like the per-frame data sets of _cpuTimeData.
+   */
+  _threadData = [];
+
+  /**
+   * This contains an array of [<subsystem>, <bytes>] for each frame.
+   */
+  _memoryData = [];
+
+  /**
+   * This contains an array of [<subsystem>, <bytes>] with the tracked heap memory for each frame.
+   */
+  _heapData = [];
+
+  /**
+   * This contains an array of [<plugin>, <cpu-ms>, <gpu-ms>, <thread-ms>, <bytes>] for each frame.
+   */
+  _pluginData = [];
+
   /**
    * The index of the currently shown frame data. Should be in the range [0 ... maxStoredFrames-1]
    * with 0 being the most recent frame.
@@ -74,11 +95,18 @@ class TimingsApi extends IApi {
   }
 
   /**
-   * Both arguments should be JSON strings containing an array for each nesting level. Each element
-   * of these should contain an array of timing ranges. Each timing range is an array of three
-   * elements: [<name>, <frame-relative-start>, <frame-relative-end>].
+   * The first two arguments should be JSON strings containing an array for each nesting level.
+   * Each element of these should contain an array of timing ranges. Each timing range is an array
+   * of three elements: [<name>, <frame-relative-start>, <frame-relative-end>]. The last argument
+   * contains an array of [<thread-name>, <ranges>] for each thread other than the main thread,
+   * where <ranges> is structured like the CPU data. The memory data contains an array of
+   * [<subsystem>, <bytes>] with the GPU memory allocated by each subsystem. The plugin data
+   * contains an array of [<plugin>, <cpu-ms>, <gpu-ms>, <thread-ms>, <bytes>] with the costs
+   * attributed to each plugin, ranked by the maximum of the CPU and GPU time. The heap data is
+   * structured like the memory data and contains the tracked heap memory of each subsystem.
    */
-  setData(gpuData, cpuData, sampleCounts, primitiveCounts) {
+  setData(gpuData, cpuData, sampleCounts, primitiveCounts, threadData, memoryData, pluginData,
+      heapData) {
     const container = document.getElementById('timings');
 
     // Only update the graph if it's not hovered.
@@ -87,6 +115,10 @@ class TimingsApi extends IApi {
       this._cpuTimeData.unshift(JSON.parse(cpuData));
       this._sampleData.unshift(JSON.parse(sampleCounts));
       this._primitiveData.unshift(JSON.parse(primitiveCounts));
+      this._threadData.unshift(threadData ? JSON.parse(threadData) : []);
+      this._memoryData.unshift(memoryData ? JSON.parse(memoryData) : []);
+      this._pluginData.unshift(pluginData ? JSON.parse(pluginData) : []);
+      this._heapData.unshift(heapData ? JSON.parse(heapData) : []);
 
       if (this._gpuTimeData.length > maxStoredFrames) {
         this._gpuTimeData.pop();
@@ -104,6 +136,22 @@ class TimingsApi extends IApi {
         this._primitiveData.pop();
       }
 
+      if (this._threadData.length > maxStoredFrames) {
+        this._threadData.pop();
+      }
+
+      if (this._memoryData.length > maxStoredFrames) {
+        this._memoryData.pop();
+      }
+
+      if (this._pluginData.length > maxStoredFrames) {
+        this._pluginData.pop();
+      }
+
+      if (this._heapData.length > maxStoredFrames) {
+        this._heapData.pop();
+      }
+
       this._redraw();
     }
   }
@@ -115,16 +163,24 @@ class TimingsApi extends IApi {
     // Get the containers to draw to.
     const gpuContainer        = document.querySelector("#gpu-graph")
     const cpuContainer        = document.querySelector("#cpu-graph")
+    const threadsContainer    = document.querySelector("#threads-graph")
     const samplesContainer    = document.querySelector("#samples-graph")
     const primitivesContainer = document.querySelector("#primitives-graph")
+    const memoryContainer     = document.querySelector("#memory-graph")
+    const heapContainer       = document.querySelector("#heap-graph")
+    const pluginsContainer    = document.querySelector("#plugins-graph")
     const gridContainer       = document.querySelector("#grid")
     const fpsContainer        = document.querySelector('#fps-counter');
 
     // First clear the containers completely.
     CosmoScout.gui.clearHtml(gpuContainer);
     CosmoScout.gui.clearHtml(cpuContainer);
+    CosmoScout.gui.clearHtml(threadsContainer);
     CosmoScout.gui.clearHtml(samplesContainer);
     CosmoScout.gui.clearHtml(primitivesContainer);
+    CosmoScout.gui.clearHtml(memoryContainer);
+    CosmoScout.gui.clearHtml(heapContainer);
+    CosmoScout.gui.clearHtml(pluginsContainer);
     CosmoScout.gui.clearHtml(gridContainer);
 
     if (this._frameIndex < this._gpuTimeData.length &&
@@ -149,6 +205,11 @@ class TimingsApi extends IApi {
       this._drawTimeBars(gpuContainer, gpuData, maxTime);
       this._drawTimeBars(cpuContainer, cpuData, maxTime);
 
+      // Below, the ranges of all other threads are drawn on the same time axis.
+      if (this._frameIndex < this._threadData.length) {
+        this._drawThreads(threadsContainer, this._threadData[this._frameIndex], maxTime);
+      }
+
       let sampleData = this._sampleData[this._frameIndex];
       sampleData.sort((a, b) => b[1] - a[1]);
       sampleData.length = Math.min(sampleData.length, 5);
@@ -165,6 +226,28 @@ class TimingsApi extends IApi {
         this._drawCounterBars(primitivesContainer, primitiveData, primitiveData[0][1]);
       }
 
+      if (this._frameIndex < this._memoryData.length) {
+        let memoryData = this._memoryData[this._frameIndex];
+        memoryData.sort((a, b) => b[1] - a[1]);
+
+        if (memoryData.length > 0) {
+          this._drawCounterBars(memoryContainer, memoryData, memoryData[0][1]);
+        }
+      }
+
+      if (this._frameIndex < this._heapData.length) {
+        let heapData = this._heapData[this._frameIndex];
+        heapData.sort((a, b) => b[1] - a[1]);
+
+        if (heapData.length > 0 && heapData[0][1] > 0) {
+          this._drawCounterBars(heapContainer, heapData, heapData[0][1]);
+        }
+      }
+
+      if (this._frameIndex < this._pluginData.length) {
+        this._drawPlugins(pluginsContainer, this._pluginData[this._frameIndex]);
+      }
+
     } else {
       fpsContainer.innerHTML = "There is no data available for this frame.";
     }
@@ -195,8 +278,8 @@ class TimingsApi extends IApi {
         for (let j = 0; j < level.length; j++) {
           let name     = level[j][0];
           let duration = CosmoScout.utils.formatNumber((level[j][2] - level[j][1]) * 0.001);
-          let start    = (level[j][1] * 0.001) / maxTime * 100;
-          let end      = (level[j][2] * 0.001) / maxTime * 100;
+          let start    = Math.min((level[j][1] * 0.001) / maxTime * 100, 100);
+          let end      = Math.min((level[j][2] * 0.001) / maxTime * 100, 100);
 
           html +=
               `<div class="bar" data-tooltip="${name} (${duration} ms)" style="--tooltip-offset:${
@@ -213,6 +296,24 @@ class TimingsApi extends IApi {
     container.appendChild(content.content);
   }
 
+  /**
+   * Draw a flame chart for each thread. The name of the thread is shown above its timing ranges.
+   *
+   * @param {div}    container The container into which the threads are drawn.
+   * @param {array}  data      The parsed thread data passed to setData().
+   * @param {number} maxTime   The maximum x-value of the graph.
+   */
+  _drawThreads(container, data, maxTime) {
+    for (let i = 0; i < data.length; i++) {
+      const name = document.createElement('div');
+      name.classList.add('thread-name');
+      name.textContent = data[i][0];
+      container.appendChild(name);
+
+      this._drawTimeBars(container, data[i][1], maxTime);
+    }
+  }
+
   /**
    * Draw the bars of counter query results as small containers with a relative with and position.
    *
@@ -245,6 +346,45 @@ class TimingsApi extends IApi {
     container.appendChild(content.content);
   }
 
+  /**
+   * Draw the costs of each plugin as a name with the individual costs and a bar with a width
+   * relative to the maximum of the CPU and GPU time of the most expensive plugin.
+   *
+   * @param {div}    container The container into which the plugins are drawn.
+   * @param {array}  data      The parsed plugin data passed to setData().
+   */
+  _drawPlugins(container, data) {
+
+    // The data is already sorted by cost. Only the most expensive plugins are shown.
+    const maxPlugins = 10;
+    let maxCost      = 0;
+
+    for (let i = 0; i < data.length; i++) {
+      maxCost = Math.max(maxCost, data[i][1], data[i][2]);
+    }
+
+    // This string will contain all the HTML of the graph.
+    let html = "";
+
+    for (let i = 0; i < Math.min(data.length, maxPlugins); i++) {
+      let [name, cpuTime, gpuTime, threadTime, bytes] = data[i];
+
+      let costs = `CPU ${cpuTime.toFixed(2)} ms, GPU ${gpuTime.toFixed(2)} ms, Threads ${
+          threadTime.toFixed(2)} ms, ${CosmoScout.utils.formatSuffixed(bytes)}B`;
+      let width = maxCost > 0 ? Math.max(cpuTime, gpuTime) / maxCost * 100 : 0;
+
+      html += `<div class='plugin-name'>${name}: ${costs}</div>`;
+      html += `<div class='level'><div class="bar" data-tooltip="${name} (${
+          costs})" style="--tooltip-offset:${width / 2}%; width: ${
+          width}%; background-color: ${this._colorHash.hex(name)}"></div></div>`;
+    }
+
+    // Add the HTML to the document.
+    const content     = document.createElement('template');
+    content.innerHTML = html;
+    container.appendChild(content.content);
+  }
+
   /**
    * Draw a grid with major and minor ticks.
    *
@@ -9,10 +9,13 @@
 
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/PluginBase.hpp"
+#include "../../../src/cs-graphics/GpuMemory.hpp"
+#include "../../../src/cs-utils/TrackedMemoryResource.hpp"
 #include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 #include "logger.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -33,12 +36,35 @@ namespace csp::timings {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the current date in a form which can be used as part of a file name.
+std::string getTimeString() {
+  auto timeString =
+      cs::utils::convert::time::toString(boost::posix_time::microsec_clock::local_time());
+  cs::utils::replaceString(timeString, ":", "-");
+  cs::utils::replaceString(timeString, ".", "-");
+  cs::utils::replaceString(timeString, "T", "-");
+  cs::utils::replaceString(timeString, "Z", "");
+  return timeString;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "useLocalGui", o.mUseLocalGui);
+  cs::core::Settings::deserialize(j, "traceDuration", o.mTraceDuration);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "useLocalGui", o.mUseLocalGui);
+  cs::core::Settings::serialize(j, "traceDuration", o.mTraceDuration);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -47,7 +73,11 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-timings")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   // The {mainUIZoom} will be ignored when loading the file from disc. This basically prevents all
@@ -139,6 +169,25 @@ void Plugin::init() {
       "Shows or hides the on-screen timer statistics.",
       std::function([this](bool enable) { mEnableStatistics = enable; }));
 
+  // These can also be called via the /run-js endpoint of csp-web-api, for example to grab a trace
+  // of the last seconds right after something unexpected happened.
+  mGuiManager->getGui()->registerCallback("timings.saveTrace",
+      "Saves the frame timings of the last seconds to a file which can be opened with "
+      "chrome://tracing or https://ui.perfetto.dev.",
+      std::function([this]() { saveTrace(); }));
+
+  mGuiManager->getGui()->registerCallback("timings.addTraceMarker",
+      "Adds a marker with the given name to the current frame of the trace.",
+      std::function([this](std::string&& name) { mTraceBuffer.addMarker(std::move(name)); }));
+
+  mPluginSettings.mTraceDuration.connectAndTouch([this](double duration) {
+    mTraceBuffer.setDuration(duration);
+
+    if (duration <= 0.0) {
+      mTraceBuffer.clear();
+    }
+  });
+
   // Load settings.
   onLoad();
 
@@ -153,6 +202,12 @@ void Plugin::update() {
   mGuiItem->setIsEnabled(
       mEnableStatistics && cs::utils::FrameStats::get().pEnableMeasurements.get());
 
+  // Keep the frame timings of the last seconds so that they can be saved at any time.
+  if (cs::utils::FrameStats::get().pEnableMeasurements.get() &&
+      mPluginSettings.mTraceDuration.get() > 0.0) {
+    mTraceBuffer.addFrame(cs::utils::FrameStats::get());
+  }
+
   // If frame timings are enabled, we may have to record them or update the on-screen statistics.
   if (cs::utils::FrameStats::get().pEnableMeasurements.get() &&
       (mEnableRecording || mEnableStatistics)) {
@@ -178,13 +233,15 @@ void Plugin::update() {
 
       for (auto const& timerQueryResult : timerQueryResults) {
         if (timerQueryResult.mGPUEnd - timerQueryResult.mGPUStart >= minTimeNanos) {
-          gpuRanges[timerQueryResult.mNestingLevel].emplace_back(timerQueryResult.mName,
+          gpuRanges[timerQueryResult.mNestingLevel].emplace_back(
+              cs::utils::FrameStats::getName(timerQueryResult.mId),
               static_cast<uint32_t>(timerQueryResult.mGPUStart - gpuFrameStart) / 1000,
               static_cast<uint32_t>(timerQueryResult.mGPUEnd - gpuFrameStart) / 1000);
         }
 
         if (timerQueryResult.mCPUEnd - timerQueryResult.mCPUStart >= minTimeNanos) {
-          cpuRanges[timerQueryResult.mNestingLevel].emplace_back(timerQueryResult.mName,
+          cpuRanges[timerQueryResult.mNestingLevel].emplace_back(
+              cs::utils::FrameStats::getName(timerQueryResult.mId),
               static_cast<uint32_t>(timerQueryResult.mCPUStart - cpuFrameStart) / 1000,
               static_cast<uint32_t>(timerQueryResult.mCPUEnd - cpuFrameStart) / 1000);
         }
@@ -197,7 +254,7 @@ void Plugin::update() {
     // Send the timing information to the statistics GUI item.
     if (mEnableStatistics) {
       auto rangeToJSON = [](std::vector<std::vector<TimerRange>> const& ranges) {
-        nlohmann::json json;
+        nlohmann::json json = nlohmann::json::array();
 
         for (auto const& level : ranges) {
           nlohmann::json levelJSON;
@@ -211,22 +268,93 @@ void Plugin::update() {
           json.push_back(levelJSON);
         }
 
-        return json.dump();
+        return json;
       };
 
       auto countToJSON = [](std::vector<cs::utils::FrameStats::CounterQueryResult> const& counts) {
         nlohmann::json json;
 
         for (auto const& count : counts) {
-          json.push_back({count.mName, count.mCount});
+          json.push_back({cs::utils::FrameStats::getName(count.mId), count.mCount});
         }
 
         return json.dump();
       };
 
-      mGuiItem->callJavascript("CosmoScout.timings.setData", rangeToJSON(gpuRanges),
-          rangeToJSON(cpuRanges), countToJSON(samplesQueryResults),
-          countToJSON(primitivesQueryResults));
+      // The ranges of the other threads are shown relative to the start of the same frame. Ranges
+      // which have been started in an earlier frame are clipped.
+      nlohmann::json threadsJSON = nlohmann::json::array();
+
+      if (!timerQueryResults.empty()) {
+        auto cpuFrameStart = timerQueryResults[0].mCPUStart;
+
+        for (auto const& thread : cs::utils::FrameStats::get().getThreadTimerResults()) {
+          std::vector<std::vector<TimerRange>> threadRanges;
+
+          for (auto const& result : thread.mResults) {
+            if (result.mEnd - result.mStart < minTimeNanos || result.mEnd < cpuFrameStart) {
+              continue;
+            }
+
+            if (threadRanges.size() <= result.mNestingLevel) {
+              threadRanges.resize(result.mNestingLevel + 1);
+            }
+
+            threadRanges[result.mNestingLevel].emplace_back(
+                cs::utils::FrameStats::getName(result.mId),
+                static_cast<uint32_t>(std::max(result.mStart - cpuFrameStart, int64_t{0})) / 1000,
+                static_cast<uint32_t>(result.mEnd - cpuFrameStart) / 1000);
+          }
+
+          if (!threadRanges.empty()) {
+            threadsJSON.push_back({thread.mThreadName, rangeToJSON(threadRanges)});
+          }
+        }
+      }
+
+      // The GPU memory is shown per subsystem in bytes.
+      nlohmann::json memoryJSON = nlohmann::json::array();
+      for (auto const& [subsystem, bytes] : cs::graphics::GpuMemory::get().getUsages()) {
+        memoryJSON.push_back({subsystem, bytes});
+      }
+
+      // The heap memory is shown for each subsystem which uses a TrackedMemoryResource.
+      nlohmann::json heapJSON = nlohmann::json::array();
+      for (auto const& [subsystem, statistics] :
+          cs::utils::TrackedMemoryResource::getAllStatistics()) {
+        heapJSON.push_back({subsystem, statistics.mBytes});
+      }
+
+      // The costs of each plugin are shown in milliseconds and bytes. They are sorted by the
+      // maximum of the CPU and GPU time. Plugins which only use GPU memory are appended.
+      auto ownerTimes = cs::utils::FrameStats::accumulateOwnerTimes(
+          timerQueryResults, cs::utils::FrameStats::get().getThreadTimerResults());
+      auto ownerUsages = cs::graphics::GpuMemory::get().getOwnerUsages();
+
+      nlohmann::json pluginsJSON = nlohmann::json::array();
+      for (auto const& times : ownerTimes) {
+        auto const& name  = cs::utils::FrameStats::getName(times.mOwner);
+        auto        usage = ownerUsages.find(name);
+        std::size_t bytes = 0;
+
+        if (usage != ownerUsages.end()) {
+          bytes = usage->second;
+          ownerUsages.erase(usage);
+        }
+
+        pluginsJSON.push_back({name, static_cast<double>(times.mCPUTime) * 1e-6,
+            static_cast<double>(times.mGPUTime) * 1e-6,
+            static_cast<double>(times.mThreadTime) * 1e-6, bytes});
+      }
+
+      for (auto const& [name, bytes] : ownerUsages) {
+        pluginsJSON.push_back({name, 0.0, 0.0, 0.0, bytes});
+      }
+
+      mGuiItem->callJavascript("CosmoScout.timings.setData", rangeToJSON(gpuRanges).dump(),
+          rangeToJSON(cpuRanges).dump(), countToJSON(samplesQueryResults),
+          countToJSON(primitivesQueryResults), threadsJSON.dump(), memoryJSON.dump(),
+          pluginsJSON.dump(), heapJSON.dump());
     }
 
     // Store the frame timing if we are in recording-mode.
@@ -241,14 +369,7 @@ void Plugin::update() {
   if (!mEnableRecording && !mRecordedGPURanges.empty()) {
 
     // We use the current date as a directory name.
-    auto timeString =
-        cs::utils::convert::time::toString(boost::posix_time::microsec_clock::local_time());
-    cs::utils::replaceString(timeString, ":", "-");
-    cs::utils::replaceString(timeString, ".", "-");
-    cs::utils::replaceString(timeString, "T", "-");
-    cs::utils::replaceString(timeString, "Z", "");
-
-    std::string directory = "csp-timings/" + timeString;
+    std::string directory = "csp-timings/" + getTimeString();
     cs::utils::filesystem::createDirectoryRecursively(
         boost::filesystem::system_complete(directory));
 
@@ -333,6 +454,8 @@ void Plugin::deInit() {
   mGuiManager->getGui()->unregisterCallback("timings.setEnableTimerQueries");
   mGuiManager->getGui()->unregisterCallback("timings.setEnableRecording");
   mGuiManager->getGui()->unregisterCallback("timings.setEnableStatistics");
+  mGuiManager->getGui()->unregisterCallback("timings.saveTrace");
+  mGuiManager->getGui()->unregisterCallback("timings.addTraceMarker");
 
   // Remove the statistic GUI item. We don't exactly know whether it was attached locally or
   // globally, so we just attempt to remove it in both cases.
@@ -366,4 +489,21 @@ void Plugin::onSave() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::saveTrace() {
+  std::string directory = "csp-timings";
+  cs::utils::filesystem::createDirectoryRecursively(boost::filesystem::system_complete(directory));
+
+  std::string fileName = directory + "/trace-" + getTimeString() + ".json";
+
+  try {
+    mTraceBuffer.save(fileName);
+    logger().info("Saved trace of the last {} seconds to '{}'.", mTraceBuffer.getDuration(),
+        boost::filesystem::system_complete(fileName).string());
+  } catch (std::exception const& e) {
+    logger().error("Failed to save trace: {}", e.what());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::timings
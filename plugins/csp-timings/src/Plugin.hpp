@@ -12,6 +12,7 @@
 #include "../../../src/cs-gui/GuiItem.hpp"
 #include "../../../src/cs-utils/DefaultProperty.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
+#include "TraceBuffer.hpp"
 
 #include <fstream>
 #include <list>
@@ -26,6 +27,11 @@ class Plugin : public cs::core::PluginBase {
     /// If the statistics are shown on the local GUI area, they are drawn on each screen in a
     /// clustered setup.
     cs::utils::DefaultProperty<bool> mUseLocalGui{false};
+
+    /// While the timer queries are enabled, the frame timings of this many seconds are kept in
+    /// memory so that they can be saved as a trace at any time. Set this to zero to disable the
+    /// trace buffer.
+    cs::utils::DefaultProperty<double> mTraceDuration{30.0};
   };
 
   void init() override;
@@ -50,6 +56,9 @@ class Plugin : public cs::core::PluginBase {
   void onLoad();
   void onSave();
 
+  /// Writes the contents of the trace buffer to csp-timings/trace-<current date>.json.
+  void saveTrace();
+
   Settings mPluginSettings;
 
   /// This store the statistics GUI element.
@@ -68,6 +77,9 @@ class Plugin : public cs::core::PluginBase {
   /// Sample queries do not support nesting.
   std::vector<int64_t> mTimestamps;
 
+  /// Contains the frame timings of the last mTraceDuration seconds.
+  TraceBuffer mTraceBuffer;
+
   int mOnLoadConnection      = -1;
   int mOnSaveConnection      = -1;
   int mFrameTimingConnection = -1;
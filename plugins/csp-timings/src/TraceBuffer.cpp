@@ -0,0 +1,209 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TraceBuffer.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+namespace csp::timings {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The trace uses microseconds relative to the first recorded event.
+double toTraceTime(int64_t time, int64_t origin) {
+  return static_cast<double>(time - origin) * 0.001;
+}
+
+// Names are written as JSON strings, this takes care of any required escaping.
+std::string toJSONString(std::string const& value) {
+  return nlohmann::json(value).dump();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceBuffer::setDuration(double seconds) {
+  mDuration = seconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double TraceBuffer::getDuration() const {
+  return mDuration;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceBuffer::addFrame(cs::utils::FrameStats& stats) {
+  auto const& timerResults = stats.getTimerQueryResults();
+
+  // The first range always covers the entire frame. If there is none or if this frame has been
+  // added before, there is nothing to do.
+  if (timerResults.empty() ||
+      (!mFrames.empty() && mFrames.back().mTime == timerResults[0].mCPUStart)) {
+    return;
+  }
+
+  Frame frame;
+  frame.mTime = timerResults[0].mCPUStart;
+
+  // The GPU timestamps use a different clock. We align the start of the frame on the GPU with its
+  // start on the CPU.
+  int64_t gpuOffset = timerResults[0].mCPUStart - timerResults[0].mGPUStart;
+
+  for (auto const& result : timerResults) {
+    if (result.mMode != cs::utils::FrameStats::TimerMode::eGPU) {
+      frame.mRanges.push_back({result.mId, 0, result.mCPUStart, result.mCPUEnd});
+    }
+
+    if (result.mMode != cs::utils::FrameStats::TimerMode::eCPU) {
+      frame.mRanges.push_back(
+          {result.mId, 1, result.mGPUStart + gpuOffset, result.mGPUEnd + gpuOffset});
+    }
+  }
+
+  for (auto const& thread : stats.getThreadTimerResults()) {
+    if (thread.mResults.empty()) {
+      continue;
+    }
+
+    uint32_t track = getTrack(thread.mThreadName);
+
+    for (auto const& result : thread.mResults) {
+      frame.mRanges.push_back({result.mId, track, result.mStart, result.mEnd});
+    }
+  }
+
+  for (auto const& result : stats.getSamplesQueryResults()) {
+    frame.mCounters.push_back({result.mId, false, frame.mTime, result.mCount});
+  }
+
+  for (auto const& result : stats.getPrimitivesQueryResults()) {
+    frame.mCounters.push_back({result.mId, true, frame.mTime, result.mCount});
+  }
+
+  mFrames.push_back(std::move(frame));
+
+  discardOldData(mFrames.back().mTime);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceBuffer::addMarker(std::string name) {
+  auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  mMarkers.push_back({std::move(name), now});
+
+  discardOldData(now);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceBuffer::clear() {
+  mFrames.clear();
+  mMarkers.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceBuffer::save(std::string const& fileName) const {
+  std::ofstream file(fileName);
+
+  if (!file) {
+    throw std::runtime_error("Failed to open '" + fileName + "' for writing!");
+  }
+
+  int64_t origin = 0;
+  if (!mFrames.empty()) {
+    origin = mFrames.front().mTime;
+  }
+  if (!mMarkers.empty() && (mFrames.empty() || mMarkers.front().mTime < origin)) {
+    origin = mMarkers.front().mTime;
+  }
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  // First, the names of all tracks are written as metadata events.
+  for (std::size_t i = 0; i < mTrackNames.size(); ++i) {
+    file << (i == 0 ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+         << ",\"name\":\"thread_name\",\"args\":{\"name\":" << toJSONString(mTrackNames[i])
+         << "}}";
+  }
+
+  // The names of the ranges and counters are only converted once.
+  std::map<cs::utils::FrameStats::TimerId, std::string> names;
+  auto getName = [&names](cs::utils::FrameStats::TimerId id) -> std::string const& {
+    auto it = names.find(id);
+    if (it == names.end()) {
+      it = names.emplace(id, toJSONString(cs::utils::FrameStats::getName(id))).first;
+    }
+    return it->second;
+  };
+
+  for (auto const& frame : mFrames) {
+    for (auto const& range : frame.mRanges) {
+      file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << range.mTrack
+           << ",\"name\":" << getName(range.mId) << ",\"ts\":" << toTraceTime(range.mStart, origin)
+           << ",\"dur\":" << static_cast<double>(range.mEnd - range.mStart) * 0.001 << "}";
+    }
+
+    for (auto const& counter : frame.mCounters) {
+      file << ",\n{\"ph\":\"C\",\"pid\":1,\"name\":"
+           << (counter.mIsPrimitivesCounter ? "\"Primitives\"" : "\"Samples\"")
+           << ",\"ts\":" << toTraceTime(counter.mTime, origin) << ",\"args\":{"
+           << getName(counter.mId) << ":" << counter.mCount << "}}";
+    }
+  }
+
+  for (auto const& marker : mMarkers) {
+    file << ",\n{\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"name\":"
+         << toJSONString(marker.mName) << ",\"ts\":" << toTraceTime(marker.mTime, origin) << "}";
+  }
+
+  file << "\n]}\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TraceBuffer::getTrack(std::string const& name) {
+  auto it = mTracks.find(name);
+  if (it != mTracks.end()) {
+    return it->second;
+  }
+
+  auto track = static_cast<uint32_t>(mTrackNames.size());
+  mTrackNames.push_back(name);
+  mTracks.emplace(name, track);
+  return track;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceBuffer::discardOldData(int64_t now) {
+  auto oldest = now - static_cast<int64_t>(mDuration * 1e9);
+
+  while (!mFrames.empty() && mFrames.front().mTime < oldest) {
+    mFrames.pop_front();
+  }
+
+  while (!mMarkers.empty() && mMarkers.front().mTime < oldest) {
+    mMarkers.pop_front();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::timings
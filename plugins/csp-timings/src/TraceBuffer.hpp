@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_TIMINGS_TRACE_BUFFER_HPP
+#define CSP_TIMINGS_TRACE_BUFFER_HPP
+
+#include "../../../src/cs-utils/FrameStats.hpp"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace csp::timings {
+
+/// The TraceBuffer continuously records the results of the FrameStats of each frame: The CPU and
+/// GPU ranges of the main thread, the CPU ranges of all other threads, the samples and primitives
+/// counters and any custom markers. Only the frames of the last few seconds are kept, older frames
+/// are discarded. At any time, the recorded data can be written to a file in the Chrome Trace Event
+/// format, which can be opened with chrome://tracing or https://ui.perfetto.dev.
+class TraceBuffer {
+ public:
+  /// Frames which are older than this many seconds are discarded.
+  void   setDuration(double seconds);
+  double getDuration() const;
+
+  /// Adds the results which are currently returned by the given FrameStats. This should be called
+  /// once per frame.
+  void addFrame(cs::utils::FrameStats& stats);
+
+  /// Adds an instant event with the given name at the current time. This is shown across all
+  /// threads in the trace.
+  void addMarker(std::string name);
+
+  /// Discards all recorded frames and markers.
+  void clear();
+
+  /// Writes all recorded frames and markers to the given file. Throws a std::runtime_error if the
+  /// file cannot be written.
+  void save(std::string const& fileName) const;
+
+ private:
+  /// All timestamps are in nanoseconds and use the clock of the CPU timings of the FrameStats.
+  struct Range {
+    cs::utils::FrameStats::TimerId mId{};
+    uint32_t                       mTrack{};
+    int64_t                        mStart{};
+    int64_t                        mEnd{};
+  };
+
+  struct Counter {
+    cs::utils::FrameStats::TimerId mId{};
+    bool                           mIsPrimitivesCounter{};
+    int64_t                        mTime{};
+    int64_t                        mCount{};
+  };
+
+  struct Marker {
+    std::string mName;
+    int64_t     mTime{};
+  };
+
+  struct Frame {
+    int64_t              mTime{};
+    std::vector<Range>   mRanges;
+    std::vector<Counter> mCounters;
+  };
+
+  /// Returns the index of the track with the given name. New tracks are added as required.
+  uint32_t getTrack(std::string const& name);
+
+  /// Removes all frames and markers which are older than mDuration.
+  void discardOldData(int64_t now);
+
+  double                          mDuration = 30.0;
+  std::deque<Frame>               mFrames;
+  std::deque<Marker>              mMarkers;
+  std::vector<std::string>        mTrackNames{"Main Thread", "GPU"};
+  std::map<std::string, uint32_t> mTracks{{"Main Thread", 0}, {"GPU", 1}};
+};
+
+} // namespace csp::timings
+
+#endif // CSP_TIMINGS_TRACE_BUFFER_HPP
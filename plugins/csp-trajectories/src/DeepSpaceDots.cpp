@@ -5,7 +5,7 @@
 // SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
 // SPDX-License-Identifier: MIT
 
-#include "DeepSpaceDot.hpp"
+#include "DeepSpaceDots.hpp"
 
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
@@ -17,17 +17,46 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
-#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <utility>
 
 namespace csp::trajectories {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const char* DeepSpaceDot::QUAD_VERT = R"(
-#version 330
+namespace {
+
+// The shader storage buffer binding points of the object transformations and the instances.
+uint32_t const TRANSFORM_BINDING = 0;
+uint32_t const INSTANCE_BINDING  = 1;
+
+// The half height of a dot in normalized device coordinates.
+float const DOT_SIZE = 0.0075F;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* DeepSpaceDots::QUAD_VERT = R"(
+#version 430
+
+struct Instance {
+  vec4  color;
+  uint  transformIndex;
+  float size;
+  vec2  padding;
+};
+
+layout(std430, binding = 0) readonly buffer ObjectTransforms {
+  mat4 uObjectTransforms[];
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+  Instance uInstances[];
+};
 
 out vec2 vTexCoords;
+flat out vec3 vColor;
 
 uniform float uAspect;
 uniform mat4 uMatModelView;
@@ -35,7 +64,10 @@ uniform mat4 uMatProjection;
 
 void main()
 {
-    vec4 pos = uMatModelView * vec4(0, 0, 0, 1);
+    Instance instance = uInstances[gl_InstanceID];
+    vColor = instance.color.rgb;
+
+    vec4 pos = uMatModelView * uObjectTransforms[instance.transformIndex][3];
 
     pos = uMatProjection * pos;
 
@@ -46,7 +78,7 @@ void main()
 
     pos /= pos.w;
 
-    float h = 0.0075;
+    float h = instance.size;
     float w = h / uAspect;
 
     switch (gl_VertexID) {
@@ -74,12 +106,11 @@ void main()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const char* DeepSpaceDot::QUAD_FRAG = R"(
-#version 330
-
-uniform vec3 uColor;
+const char* DeepSpaceDots::QUAD_FRAG = R"(
+#version 430
 
 in vec2 vTexCoords;
+flat in vec3 vColor;
 
 layout(location = 0) out vec4 oColor;
 
@@ -87,14 +118,14 @@ void main()
 {
     float dist = length(vTexCoords);
     float blob = pow(dist, 10.0);
-    oColor  = mix(vec4(uColor, 1.0), vec4(0), blob);
+    oColor  = mix(vec4(vColor, 1.0), vec4(0), blob);
 }
 )";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DeepSpaceDot::DeepSpaceDot(std::shared_ptr<Plugin::Settings> pluginSettings,
-    std::shared_ptr<cs::core::SolarSystem>                   solarSystem)
+DeepSpaceDots::DeepSpaceDots(std::shared_ptr<Plugin::Settings> pluginSettings,
+    std::shared_ptr<cs::core::SolarSystem>                     solarSystem)
     : mPluginSettings(std::move(pluginSettings))
     , mSolarSystem(std::move(solarSystem)) {
 
@@ -104,9 +135,10 @@ DeepSpaceDot::DeepSpaceDot(std::shared_ptr<Plugin::Settings> pluginSettings,
 
   mUniforms.modelViewMatrix  = mShader.GetUniformLocation("uMatModelView");
   mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
-  mUniforms.color            = mShader.GetUniformLocation("uColor");
   mUniforms.aspect           = mShader.GetUniformLocation("uAspect");
 
+  glGenBuffers(1, &mInstanceBuffer);
+
   // Add to scenegraph.
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
@@ -116,36 +148,67 @@ DeepSpaceDot::DeepSpaceDot(std::shared_ptr<Plugin::Settings> pluginSettings,
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DeepSpaceDot::~DeepSpaceDot() {
+DeepSpaceDots::~DeepSpaceDots() {
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   pSG->GetRoot()->DisconnectChild(mGLNode.get());
+
+  glDeleteBuffers(1, &mInstanceBuffer);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void DeepSpaceDot::setObjectName(std::string objectName) {
-  mObjectName = std::move(objectName);
+void DeepSpaceDots::setDots(std::vector<Dot> dots) {
+  mDots = std::move(dots);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::string const& DeepSpaceDot::getObjectName() const {
-  return mObjectName;
+std::vector<DeepSpaceDots::Dot> const& DeepSpaceDots::getDots() const {
+  return mDots;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool DeepSpaceDot::Do() {
+bool DeepSpaceDots::Do() {
   if (!mPluginSettings->mEnablePlanetMarks.get()) {
     return true;
   }
 
-  auto object = mSolarSystem->getObject(mObjectName);
-  if (!object || !object->getIsOrbitVisible()) {
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
+
+  // Collect the dots of all visible objects. The transformation indices may change from frame to
+  // frame, so they are retrieved each time.
+  mInstances.clear();
+
+  for (auto const& dot : mDots) {
+    auto object = mSolarSystem->getObject(dot.mObjectName);
+    if (!object || !object->getIsOrbitVisible()) {
+      continue;
+    }
+
+    auto transformIndex = mSolarSystem->getObjectTransformIndex(dot.mObjectName);
+    if (!transformIndex) {
+      continue;
+    }
+
+    glm::vec4 color(dot.mColor[0], dot.mColor[1], dot.mColor[2], 1.F);
+    mInstances.push_back({color, *transformIndex, DOT_SIZE, glm::vec2(0.F)});
+  }
+
+  if (mInstances.empty()) {
     return true;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer("Dot of " + mObjectName);
+  // The storage is orphaned each frame and only grows, like the object transformation buffer.
+  mInstanceCapacity = std::max(mInstanceCapacity, mInstances.size());
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mInstanceBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+      static_cast<GLsizeiptr>(sizeof(Instance) * mInstanceCapacity), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+      static_cast<GLsizeiptr>(sizeof(Instance) * mInstances.size()), mInstances.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
   // get viewport to draw dot with correct aspect ration
   std::array<GLint, 4> viewport{};
   glGetIntegerv(GL_VIEWPORT, viewport.data());
@@ -156,19 +219,21 @@ bool DeepSpaceDot::Do() {
   std::array<GLfloat, 16> glMatP{};
   glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
   glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
-  auto matMV = glm::make_mat4x4(glMatMV.data()) * glm::mat4(object->getObserverRelativeTransform());
 
   glEnable(GL_BLEND);
   glDepthMask(GL_FALSE);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  // draw simple dot
+  // draw all dots at once
   mShader.Bind();
-  glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glm::value_ptr(matMV));
+  mSolarSystem->bindObjectTransforms(TRANSFORM_BINDING);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, mInstanceBuffer);
+  glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
   glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
-  mShader.SetUniform(mUniforms.color, pColor.get()[0], pColor.get()[1], pColor.get()[2]);
   mShader.SetUniform(mUniforms.aspect, fAspect);
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(mInstances.size()));
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TRANSFORM_BINDING, 0);
   mShader.Release();
 
   glDisable(GL_BLEND);
@@ -179,7 +244,7 @@ bool DeepSpaceDot::Do() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool DeepSpaceDot::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+bool DeepSpaceDots::GetBoundingBox(VistaBoundingBox& /*bb*/) {
   return false;
 }
 
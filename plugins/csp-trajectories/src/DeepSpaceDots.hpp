@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_TRAJECTORIES_DEEP_SPACE_DOTS_HPP
+#define CSP_TRAJECTORIES_DEEP_SPACE_DOTS_HPP
+
+#include "Plugin.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
+
+#include <VistaBase/VistaColor.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <glm/glm.hpp>
+
+namespace csp::trajectories {
+
+/// A deep space dot is a simple marker indicating the position of an object, when it is too
+/// small to see. This class draws the dots of all objects with a single instanced draw call. The
+/// positions are read from the observer-relative transformations provided by the SolarSystem, the
+/// color of each dot is uploaded together with the index of its transformation once a frame.
+class DeepSpaceDots : public IVistaOpenGLDraw {
+ public:
+  struct Dot {
+    std::string mObjectName; ///< The dot is attached to this body.
+    VistaColor  mColor;      ///< The color of the marker.
+  };
+
+  DeepSpaceDots(std::shared_ptr<Plugin::Settings> pluginSettings,
+      std::shared_ptr<cs::core::SolarSystem>      solarSystem);
+
+  DeepSpaceDots(DeepSpaceDots const& other) = delete;
+  DeepSpaceDots(DeepSpaceDots&& other)      = delete;
+
+  DeepSpaceDots& operator=(DeepSpaceDots const& other) = delete;
+  DeepSpaceDots& operator=(DeepSpaceDots&& other) = delete;
+
+  ~DeepSpaceDots() override;
+
+  /// Replaces all dots.
+  void                    setDots(std::vector<Dot> dots);
+  std::vector<Dot> const& getDots() const;
+
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  /// The per-instance data as it is stored in the shader storage buffer (std430 layout).
+  struct Instance {
+    glm::vec4 mColor;
+    uint32_t  mTransformIndex;
+    float     mSize;
+    glm::vec2 mPadding;
+  };
+
+  std::shared_ptr<Plugin::Settings>      mPluginSettings;
+  std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
+  std::vector<Dot>                       mDots;
+  std::vector<Instance>                  mInstances;
+  uint32_t                               mInstanceBuffer   = 0;
+  std::size_t                            mInstanceCapacity = 0;
+  VistaGLSLShader                        mShader;
+
+  std::unique_ptr<VistaOpenGLNode> mGLNode;
+
+  struct {
+    uint32_t modelViewMatrix  = 0;
+    uint32_t projectionMatrix = 0;
+    uint32_t aspect           = 0;
+  } mUniforms;
+
+  cs::utils::FrameStats::TimerId mTimerId = cs::utils::FrameStats::intern("DeepSpaceDots");
+
+  static const char* QUAD_VERT;
+  static const char* QUAD_FRAG;
+};
+
+} // namespace csp::trajectories
+
+#endif // CSP_TRAJECTORIES_DEEP_SPACE_DOTS_HPP
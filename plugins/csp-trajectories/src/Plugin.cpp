@@ -7,8 +7,8 @@
 
 #include "Plugin.hpp"
 
-#include "DeepSpaceDot.hpp"
-#include "SunFlare.hpp"
+#include "DeepSpaceDots.hpp"
+#include "SunFlares.hpp"
 #include "Trajectory.hpp"
 #include "logger.hpp"
 
@@ -85,11 +85,15 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-trajectories")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   mGuiManager->addSettingsSectionToSideBarFromHTML("Trajectories", "radio_button_unchecked",
-      "../share/resources/gui/trajectories-settings.html");
+      "../share/resources/gui/trajectories-settings.html", true);
 
   mGuiManager->getGui()->registerCallback("trajectories.setEnableTrajectories",
       "Enables or disables the rendering of trajectories.",
@@ -140,9 +144,27 @@ void Plugin::deInit() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::optional<cs::core::PluginBase::AsyncUpdateAccess> Plugin::getAsyncUpdateAccess() const {
+  // Sampling the trajectories queries SPICE, which counts as a write of the SolarSystem.
+  AsyncUpdateAccess access;
+  access.mReads  = static_cast<uint32_t>(Resource::eTimeControl);
+  access.mWrites = static_cast<uint32_t>(Resource::eSolarSystem);
+  return access;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateAsync() {
+  for (auto const& trajectory : mTrajectories) {
+    trajectory->updateAsync(mTimeControl->pSimulationTime.get(), mTimeControl->pIsScrubbing.get());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::update() {
   for (auto const& trajectory : mTrajectories) {
-    trajectory->update(mTimeControl->pSimulationTime.get());
+    trajectory->update();
   }
 }
 
@@ -153,61 +175,34 @@ void Plugin::onLoad() {
   // Read settings from JSON.
   from_json(mAllSettings->mPlugins.at("csp-trajectories"), *mPluginSettings);
 
-  size_t flareCount      = 0;
-  size_t dotCount        = 0;
   size_t trajectoryCount = 0;
 
   for (auto const& settings : mPluginSettings->mTrajectories) {
-    if (settings.second.mDrawFlare.value_or(false)) {
-      ++flareCount;
-    }
-    if (settings.second.mDrawDot.value_or(false)) {
-      ++dotCount;
-    }
     if (settings.second.mTrail) {
       ++trajectoryCount;
     }
   }
 
-  // We just recreate all SunFlares and DeepSpaceDots as they are quite cheap to construct. So
-  // delete all existing ones first.
-  mSunFlares.resize(flareCount);
-  mDeepSpaceDots.resize(dotCount);
   mTrajectories.resize(trajectoryCount);
 
-  size_t flareIndex      = 0;
-  size_t dotIndex        = 0;
   size_t trajectoryIndex = 0;
 
-  // Now we go through all configured trajectories and create all required SunFlares and
-  // DeepSpaceDots.
+  std::vector<SunFlares::Flare>   flares;
+  std::vector<DeepSpaceDots::Dot> dots;
+
+  // Now we go through all configured trajectories and collect all required SunFlares and
+  // DeepSpaceDots. They are drawn with one instanced draw call each.
   for (auto const& settings : mPluginSettings->mTrajectories) {
+    VistaColor color(settings.second.mColor.r, settings.second.mColor.g, settings.second.mColor.b);
 
     // Add the SunFlare.
     if (settings.second.mDrawFlare.value_or(false)) {
-      if (!mSunFlares[flareIndex]) {
-        mSunFlares[flareIndex] =
-            std::make_unique<SunFlare>(mAllSettings, mPluginSettings, mSolarSystem);
-      }
-
-      mSunFlares[flareIndex]->setObjectName(settings.first);
-      mSunFlares[flareIndex]->pColor =
-          VistaColor(settings.second.mColor.r, settings.second.mColor.g, settings.second.mColor.b);
-
-      ++flareIndex;
+      flares.push_back({settings.first, color});
     }
 
     // Add the DeepSpaceDot.
     if (settings.second.mDrawDot.value_or(false)) {
-      if (!mDeepSpaceDots[dotIndex]) {
-        mDeepSpaceDots[dotIndex] = std::make_unique<DeepSpaceDot>(mPluginSettings, mSolarSystem);
-      }
-
-      mDeepSpaceDots[dotIndex]->setObjectName(settings.first);
-      mDeepSpaceDots[dotIndex]->pColor =
-          VistaColor(settings.second.mColor.r, settings.second.mColor.g, settings.second.mColor.b);
-
-      ++dotIndex;
+      dots.push_back({settings.first, color});
     }
 
     // Then create all new trajectories.
@@ -228,6 +223,17 @@ void Plugin::onLoad() {
       ++trajectoryIndex;
     }
   }
+
+  if (!mSunFlares) {
+    mSunFlares = std::make_unique<SunFlares>(mAllSettings, mPluginSettings, mSolarSystem);
+  }
+
+  if (!mDeepSpaceDots) {
+    mDeepSpaceDots = std::make_unique<DeepSpaceDots>(mPluginSettings, mSolarSystem);
+  }
+
+  mSunFlares->setFlares(std::move(flares));
+  mDeepSpaceDots->setDots(std::move(dots));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -17,8 +17,8 @@
 
 namespace csp::trajectories {
 
-class DeepSpaceDot;
-class SunFlare;
+class DeepSpaceDots;
+class SunFlares;
 class Trajectory;
 
 /// This plugin is providing HUD elements that display trajectories and markers for orbiting
@@ -41,8 +41,9 @@ class Plugin : public cs::core::PluginBase {
         /// The length of the trail in days.
         double mLength{};
 
-        /// The amount of samples that make up the trail. The higher the better it looks, but the
-        /// worse the performance gets.
+        /// The maximum amount of samples that make up the trail. They are placed adaptively, so
+        /// that strongly curved parts and parts close to the observer receive more samples. The
+        /// higher the better it looks, but the worse the performance gets.
         int32_t mSamples{};
 
         /// The name of the anchor this trail is drawn relative to.
@@ -77,16 +78,19 @@ class Plugin : public cs::core::PluginBase {
 
   void init() override;
   void deInit() override;
-  void update() override;
+
+  std::optional<AsyncUpdateAccess> getAsyncUpdateAccess() const override;
+  void                             updateAsync() override;
+  void                             update() override;
 
  private:
   void onLoad();
   void onSave();
 
-  std::shared_ptr<Settings>                  mPluginSettings = std::make_shared<Settings>();
-  std::vector<std::unique_ptr<Trajectory>>   mTrajectories;
-  std::vector<std::unique_ptr<DeepSpaceDot>> mDeepSpaceDots;
-  std::vector<std::unique_ptr<SunFlare>>     mSunFlares;
+  std::shared_ptr<Settings>                mPluginSettings = std::make_shared<Settings>();
+  std::vector<std::unique_ptr<Trajectory>> mTrajectories;
+  std::unique_ptr<DeepSpaceDots>           mDeepSpaceDots;
+  std::unique_ptr<SunFlares>               mSunFlares;
 
   int mOnLoadConnection = -1;
   int mOnSaveConnection = -1;
@@ -5,7 +5,7 @@
 // SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
 // SPDX-License-Identifier: MIT
 
-#include "SunFlare.hpp"
+#include "SunFlares.hpp"
 
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
@@ -18,17 +18,46 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
-#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <utility>
 
 namespace csp::trajectories {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const char* SunFlare::QUAD_VERT = R"(
-#version 330
+namespace {
+
+// The shader storage buffer binding points of the object transformations and the instances.
+uint32_t const TRANSFORM_BINDING = 0;
+uint32_t const INSTANCE_BINDING  = 1;
+
+// The size of a flare in meters of the observer-relative space.
+float const FLARE_SIZE = 10e10F;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* SunFlares::QUAD_VERT = R"(
+#version 430
+
+struct Instance {
+  vec4  color;
+  uint  transformIndex;
+  float size;
+  vec2  padding;
+};
+
+layout(std430, binding = 0) readonly buffer ObjectTransforms {
+  mat4 uObjectTransforms[];
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+  Instance uInstances[];
+};
 
 out vec2 vTexCoords;
+flat out vec3 vColor;
 
 uniform float uAspect;
 uniform mat4 uMatModelView;
@@ -36,9 +65,14 @@ uniform mat4 uMatProjection;
 
 void main()
 {
-    vec4 posVS  = uMatModelView * vec4(0, 0, 0, 1);
+    Instance instance = uInstances[gl_InstanceID];
+    vColor = instance.color.rgb;
+
+    mat4 matModelView = uMatModelView * uObjectTransforms[instance.transformIndex];
+
+    vec4 posVS  = matModelView * vec4(0, 0, 0, 1);
     vec4 posP   = uMatProjection * posVS;
-    float scale = length(uMatModelView[0]) / length(posVS.xyz);
+    float scale = length(matModelView[0]) / length(posVS.xyz);
 
     if (posP.w < 0) {
         gl_Position = vec4(0);
@@ -47,7 +81,7 @@ void main()
 
     posP /= posP.w;
 
-    float h = scale * 10e10;
+    float h = scale * instance.size;
     float w = h / uAspect;
 
     posP.z = -0.9999;
@@ -77,12 +111,11 @@ void main()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const char* SunFlare::QUAD_FRAG = R"(
-#version 330
-
-uniform vec3 uColor;
+const char* SunFlares::QUAD_FRAG = R"(
+#version 430
 
 in vec2 vTexCoords;
+flat in vec3 vColor;
 
 layout(location = 0) out vec3 oColor;
 
@@ -91,20 +124,20 @@ void main()
     // sun disc
     float dist = length(vTexCoords) * 100;
     float glow = exp(1.0 - dist);
-    oColor = uColor * glow;
+    oColor = vColor * glow;
     
     // sun glow
     dist = min(1.0, length(vTexCoords));
     glow = 1.0 - pow(dist, 0.05);
-    oColor += uColor * glow * 2;
+    oColor += vColor * glow * 2;
 }
 )";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-SunFlare::SunFlare(std::shared_ptr<cs::core::Settings> settings,
-    std::shared_ptr<Plugin::Settings>                  pluginSettings,
-    std::shared_ptr<cs::core::SolarSystem>             solarSystem)
+SunFlares::SunFlares(std::shared_ptr<cs::core::Settings> settings,
+    std::shared_ptr<Plugin::Settings>                    pluginSettings,
+    std::shared_ptr<cs::core::SolarSystem>               solarSystem)
     : mSettings(std::move(settings))
     , mPluginSettings(std::move(pluginSettings))
     , mSolarSystem(std::move(solarSystem)) {
@@ -115,9 +148,10 @@ SunFlare::SunFlare(std::shared_ptr<cs::core::Settings> settings,
 
   mUniforms.modelViewMatrix  = mShader.GetUniformLocation("uMatModelView");
   mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
-  mUniforms.color            = mShader.GetUniformLocation("uColor");
   mUniforms.aspect           = mShader.GetUniformLocation("uAspect");
 
+  glGenBuffers(1, &mInstanceBuffer);
+
   // Add to scenegraph.
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
@@ -127,36 +161,67 @@ SunFlare::SunFlare(std::shared_ptr<cs::core::Settings> settings,
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-SunFlare::~SunFlare() {
+SunFlares::~SunFlares() {
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   pSG->GetRoot()->DisconnectChild(mGLNode.get());
+
+  glDeleteBuffers(1, &mInstanceBuffer);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void SunFlare::setObjectName(std::string objectName) {
-  mObjectName = std::move(objectName);
+void SunFlares::setFlares(std::vector<Flare> flares) {
+  mFlares = std::move(flares);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::string const& SunFlare::getObjectName() const {
-  return mObjectName;
+std::vector<SunFlares::Flare> const& SunFlares::getFlares() const {
+  return mFlares;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool SunFlare::Do() {
+bool SunFlares::Do() {
   if (!mPluginSettings->mEnableSunFlares.get() || mSettings->mGraphics.pEnableHDR.get()) {
     return true;
   }
 
-  auto object = mSolarSystem->getObject(mObjectName);
-  if (!object || !object->getIsInExistence()) {
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
+
+  // Collect the flares of all existing objects. The transformation indices may change from frame
+  // to frame, so they are retrieved each time.
+  mInstances.clear();
+
+  for (auto const& flare : mFlares) {
+    auto object = mSolarSystem->getObject(flare.mObjectName);
+    if (!object || !object->getIsInExistence()) {
+      continue;
+    }
+
+    auto transformIndex = mSolarSystem->getObjectTransformIndex(flare.mObjectName);
+    if (!transformIndex) {
+      continue;
+    }
+
+    glm::vec4 color(flare.mColor[0], flare.mColor[1], flare.mColor[2], 1.F);
+    mInstances.push_back({color, *transformIndex, FLARE_SIZE, glm::vec2(0.F)});
+  }
+
+  if (mInstances.empty()) {
     return true;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer("SunFlare");
+  // The storage is orphaned each frame and only grows, like the object transformation buffer.
+  mInstanceCapacity = std::max(mInstanceCapacity, mInstances.size());
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mInstanceBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+      static_cast<GLsizeiptr>(sizeof(Instance) * mInstanceCapacity), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+      static_cast<GLsizeiptr>(sizeof(Instance) * mInstances.size()), mInstances.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
   // get viewport to draw dot with correct aspect ration
   std::array<GLint, 4> viewport{};
   glGetIntegerv(GL_VIEWPORT, viewport.data());
@@ -167,20 +232,22 @@ bool SunFlare::Do() {
   std::array<GLfloat, 16> glMatP{};
   glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
   glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
-  auto matMV = glm::make_mat4x4(glMatMV.data()) * glm::mat4(object->getObserverRelativeTransform());
 
   glEnable(GL_BLEND);
   glBlendFunc(GL_ONE, GL_ONE);
   glDepthMask(GL_FALSE);
 
-  // draw simple dot
+  // draw all flares at once
   mShader.Bind();
-  glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glm::value_ptr(matMV));
+  mSolarSystem->bindObjectTransforms(TRANSFORM_BINDING);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, mInstanceBuffer);
+  glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
   glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
-  mShader.SetUniform(mUniforms.color, pColor.get()[0], pColor.get()[1], pColor.get()[2]);
   mShader.SetUniform(mUniforms.aspect, fAspect);
 
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(mInstances.size()));
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TRANSFORM_BINDING, 0);
   mShader.Release();
 
   glDisable(GL_BLEND);
@@ -191,7 +258,7 @@ bool SunFlare::Do() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool SunFlare::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+bool SunFlares::GetBoundingBox(VistaBoundingBox& /*bb*/) {
   return false;
 }
 
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_TRAJECTORIES_SUN_FLARES_HPP
+#define CSP_TRAJECTORIES_SUN_FLARES_HPP
+
+#include "Plugin.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
+
+#include <VistaBase/VistaColor.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <glm/glm.hpp>
+
+namespace cs::core {
+class Settings;
+} // namespace cs::core
+
+namespace csp::trajectories {
+
+/// Adds an artificial flare effect around objects. Only makes sense for stars, but if you want
+/// you can make anything glow like a christmas light :D. The SunFlares are hidden when HDR
+/// rendering is enabled. All flares are drawn with a single instanced draw call, see DeepSpaceDots
+/// for details.
+class SunFlares : public IVistaOpenGLDraw {
+ public:
+  struct Flare {
+    std::string mObjectName; ///< The flare is attached to this body.
+    VistaColor  mColor;      ///< The color of the flare.
+  };
+
+  SunFlares(std::shared_ptr<cs::core::Settings> settings,
+      std::shared_ptr<Plugin::Settings>         pluginSettings,
+      std::shared_ptr<cs::core::SolarSystem>    solarSystem);
+
+  SunFlares(SunFlares const& other) = delete;
+  SunFlares(SunFlares&& other)      = delete;
+
+  SunFlares& operator=(SunFlares const& other) = delete;
+  SunFlares& operator=(SunFlares&& other) = delete;
+
+  ~SunFlares() override;
+
+  /// Replaces all flares.
+  void                      setFlares(std::vector<Flare> flares);
+  std::vector<Flare> const& getFlares() const;
+
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  /// The per-instance data as it is stored in the shader storage buffer (std430 layout).
+  struct Instance {
+    glm::vec4 mColor;
+    uint32_t  mTransformIndex;
+    float     mSize;
+    glm::vec2 mPadding;
+  };
+
+  std::shared_ptr<cs::core::Settings>    mSettings;
+  std::shared_ptr<Plugin::Settings>      mPluginSettings;
+  std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
+  std::vector<Flare>                     mFlares;
+  std::vector<Instance>                  mInstances;
+  uint32_t                               mInstanceBuffer   = 0;
+  std::size_t                            mInstanceCapacity = 0;
+  VistaGLSLShader                        mShader;
+
+  std::unique_ptr<VistaOpenGLNode> mGLNode;
+
+  struct {
+    uint32_t modelViewMatrix  = 0;
+    uint32_t projectionMatrix = 0;
+    uint32_t aspect           = 0;
+  } mUniforms;
+
+  cs::utils::FrameStats::TimerId mTimerId = cs::utils::FrameStats::intern("SunFlares");
+
+  static const char* QUAD_VERT;
+  static const char* QUAD_FRAG;
+};
+
+} // namespace csp::trajectories
+
+#endif // CSP_TRAJECTORIES_SUN_FLARES_HPP
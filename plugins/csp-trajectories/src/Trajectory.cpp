@@ -17,10 +17,122 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace csp::trajectories {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the adaptive step is at most this many times longer than the step of uniform sampling
+double const maxStepFactor = 8.0;
+
+// the adaptive step is at most this many times shorter than the step of uniform sampling
+double const minStepFactor = 1.0 / 16.0;
+
+// a step is refined if its midpoint deviates more than this from the chord, as seen from the
+// observer in radians
+double const maxScreenError = 0.001;
+
+// while scrubbing through time, trajectories are resampled with this many times fewer samples
+uint32_t const previewSampleDivisor = 8;
+
+// a step is also refined if its midpoint deviates more than this from the chord, relative to the
+// length of the chord
+double const maxRelativeError = 0.01;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Samples the position of target relative to parent, beginning after the given sample, until the
+/// given end time has been passed. No samples beyond the limit are computed. Each step adds the
+/// midpoint and the endpoint of the step. The step is halved if the midpoint deviates too much from
+/// the chord and doubled if it deviates only little. The samples are returned in the order in which
+/// they are computed. Sampling stops early if SPICE data is missing or maxSamples is reached.
+std::vector<glm::dvec4> sampleAdaptively(cs::scene::CelestialAnchor const& parent,
+    cs::scene::CelestialAnchor const& target, glm::dvec4 last, double end, double limit,
+    glm::dvec3 const& observer, double minStep, double maxStep, double& step,
+    std::size_t maxSamples) {
+
+  std::vector<glm::dvec4> samples;
+  double                  direction = end > last.w ? 1.0 : -1.0;
+
+  while ((end - last.w) * direction > 0.0 && samples.size() < maxSamples) {
+    double endTime = last.w + direction * step;
+
+    if ((endTime - limit) * direction > 0.0) {
+      endTime = limit;
+    }
+
+    if (endTime == last.w) {
+      break;
+    }
+
+    double     midTime = 0.5 * (last.w + endTime);
+    glm::dvec3 midPos;
+    glm::dvec3 endPos;
+
+    try {
+      midPos = parent.getRelativePosition(midTime, target);
+      endPos = parent.getRelativePosition(endTime, target);
+    } catch (...) {
+      // Getting the relative transformation may fail due to insufficient SPICE data.
+      break;
+    }
+
+    double deviation = glm::distance(midPos, 0.5 * (glm::dvec3(last) + endPos));
+    double tolerance = std::min(maxScreenError * glm::distance(midPos, observer),
+        maxRelativeError * glm::distance(glm::dvec3(last), endPos));
+
+    if (deviation > tolerance && step > minStep) {
+      step = std::max(0.5 * step, minStep);
+      continue;
+    }
+
+    samples.emplace_back(midPos, midTime);
+    samples.emplace_back(endPos, endTime);
+    last = samples.back();
+
+    if (deviation < 0.25 * tolerance) {
+      step = std::min(2.0 * step, maxStep);
+    }
+  }
+
+  return samples;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Samples the trajectory from start to end, starting with the given step.
+std::vector<glm::dvec4> sampleTrajectory(cs::scene::CelestialAnchor const& parent,
+    cs::scene::CelestialAnchor const& target, double start, double end, glm::dvec3 const& observer,
+    double minStep, double maxStep, double step, std::size_t maxSamples) {
+
+  std::vector<glm::dvec4> samples;
+
+  try {
+    samples.emplace_back(parent.getRelativePosition(start, target), start);
+  } catch (...) {
+    // Getting the relative transformation may fail due to insufficient SPICE data.
+    return samples;
+  }
+
+  auto rest = sampleAdaptively(
+      parent, target, samples.back(), end, end, observer, minStep, maxStep, step, maxSamples - 1);
+  samples.insert(samples.end(), rest.begin(), rest.end());
+
+  return samples;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Trajectory::Trajectory(std::shared_ptr<Plugin::Settings> pluginSettings,
     std::shared_ptr<cs::core::SolarSystem>               solarSystem)
     : mPluginSettings(std::move(pluginSettings))
@@ -28,6 +140,9 @@ Trajectory::Trajectory(std::shared_ptr<Plugin::Settings> pluginSettings,
 
   pLength.connect([this](double val) {
     mPoints.clear();
+    mTrajectory.clear();
+    mPendingSamples = {};
+    mChanges        = {};
     mTrajectory.setMaxAge(val * 24 * 60 * 60);
   });
 
@@ -36,7 +151,12 @@ Trajectory::Trajectory(std::shared_ptr<Plugin::Settings> pluginSettings,
     mTrajectory.setEndColor(glm::vec4(val, 0.F));
   });
 
-  pSamples.connect([this](uint32_t /*value*/) { mPoints.clear(); });
+  pSamples.connect([this](uint32_t /*value*/) {
+    mPoints.clear();
+    mTrajectory.clear();
+    mPendingSamples = {};
+    mChanges        = {};
+  });
 
   // Add to scenegraph.
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
@@ -54,114 +174,174 @@ Trajectory::~Trajectory() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Trajectory::update(double tTime) {
+void Trajectory::updateAsync(double tTime, bool preview) {
   if (!mPluginSettings->mEnableTrajectories.get()) {
     return;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer(
-      "Trajectory of " + mTargetName, cs::utils::FrameStats::TimerMode::eCPU);
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId, cs::utils::FrameStats::TimerMode::eCPU);
 
   auto parent = mSolarSystem->getObject(mParentName);
   auto target = mSolarSystem->getObject(mTargetName);
 
   if (parent && target && parent->getIsInExistence() && target->getIsOrbitVisible()) {
+
+    // Replace the samples once the resampled trajectory is ready.
+    if (mPendingSamples.valid() &&
+        mPendingSamples.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      mPoints           = mPendingSamples.get();
+      mChanges.mReplace = true;
+    }
+
     double dLengthSeconds = pLength.get() * 24.0 * 60.0 * 60.0;
-    double dSampleLength  = dLengthSeconds / pSamples.get();
+    auto   sampleCount    = preview ? std::max(pSamples.get() / previewSampleDivisor, 2U)
+                                    : pSamples.get();
+    auto   maxSamples     = static_cast<std::size_t>(sampleCount);
+
+    // Each step adds two samples.
+    double uniformStep = 2.0 * dLengthSeconds / sampleCount;
+    double minStep     = uniformStep * minStepFactor;
+    double maxStep     = uniformStep * maxStepFactor;
+
+    // Only recalculate if there is not too much change from frame to frame. The trajectory is not
+    // modified while it is resampled.
+    if (std::abs(mLastFrameTime - tTime) <= dLengthSeconds / 10.0 && !mPendingSamples.valid()) {
+      auto startExistence = glm::max(parent->getExistence()[0], target->getExistence()[0]);
+      auto endExistence   = glm::min(parent->getExistence()[1], target->getExistence()[1]);
 
-    // only recalculate if there is not too much change from frame to frame
-    if (std::abs(mLastFrameTime - tTime) <= dLengthSeconds / 10.0) {
-      // make sure to re-sample entire trajectory if complete reset is required
-      bool completeRecalculation = false;
+      double start = glm::clamp(tTime - dLengthSeconds, startExistence, endExistence);
+      double end   = glm::clamp(tTime, startExistence, endExistence);
 
-      if (mPoints.size() != pSamples.get()) {
-        mPoints.resize(pSamples.get());
-        completeRecalculation = true;
-      }
+      // The position of the observer in the coordinate system of the parent.
+      glm::dvec3 observer(glm::inverse(parent->getObserverRelativeTransform())[3]);
 
-      if (tTime > mLastSampleTime + dLengthSeconds || tTime < mLastSampleTime - dLengthSeconds) {
-        completeRecalculation = true;
-      }
+      bool forward = mLastUpdateTime < tTime;
 
-      auto startExistence = glm::max(parent->getExistence()[0], target->getExistence()[0]);
-      auto endExistence   = glm::min(parent->getExistence()[1], target->getExistence()[1]);
+      // make sure to re-sample entire trajectory if complete reset is required
+      bool completeRecalculation =
+          mPoints.empty() || mPoints.back().w < start || mPoints.front().w > end;
 
-      if (mLastUpdateTime < tTime) {
-        if (completeRecalculation) {
-          mLastSampleTime = tTime - dLengthSeconds - dSampleLength;
-          mStartIndex     = 0;
-        }
+      // Refine a preview once the user stopped scrubbing.
+      completeRecalculation = completeRecalculation || (mIsPreview && !preview);
 
-        while (mLastSampleTime < tTime) {
-          mLastSampleTime += dSampleLength;
+      if (completeRecalculation) {
+        logger().debug("Recalculating trajectory for {}.", mTargetName);
 
-          try {
-            double     tSampleTime = glm::clamp(mLastSampleTime, startExistence, endExistence);
-            glm::dvec3 pos         = parent->getRelativePosition(tSampleTime, *target);
-            mPoints[mStartIndex]   = glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
+        mStep      = uniformStep;
+        mIsPreview = preview;
+
+        mPendingSamples = mSolarSystem->getEphemerisService().enqueue(
+            [parent = cs::scene::CelestialAnchor(*parent),   // NOLINT(cppcoreguidelines-slicing)
+                target = cs::scene::CelestialAnchor(*target), // NOLINT(cppcoreguidelines-slicing)
+                start, end, observer, minStep, maxStep, step = mStep, maxSamples]() {
+              return sampleTrajectory(
+                  parent, target, start, end, observer, minStep, maxStep, step, maxSamples);
+            });
 
-            mStartIndex = (mStartIndex + 1) % static_cast<int>(pSamples.get());
-          } catch (...) {
-            // Getting the relative transformation may fail due to insufficient SPICE data.
-          }
-        }
       } else {
-        if (completeRecalculation) {
-          mLastSampleTime = tTime + dLengthSeconds + dSampleLength;
-          mStartIndex     = 0;
+        mStep = glm::clamp(mStep, minStep, maxStep);
+
+        // Extend the trajectory in the direction of time. The trajectory always includes one
+        // sample beyond the current time, which is replaced by the tip.
+        if (forward && mPoints.back().w < end) {
+          auto samples = sampleAdaptively(*parent, *target, mPoints.back(), end, endExistence,
+              observer, minStep, maxStep, mStep, maxSamples);
+          mPoints.insert(mPoints.end(), samples.begin(), samples.end());
+          mChanges.mPushBack = std::move(samples);
+        } else if (!forward && mPoints.front().w > start) {
+          auto samples = sampleAdaptively(*parent, *target, mPoints.front(), start,
+              startExistence, observer, minStep, maxStep, mStep, maxSamples);
+          std::reverse(samples.begin(), samples.end());
+          mPoints.insert(mPoints.begin(), samples.begin(), samples.end());
+          mChanges.mPushFront = std::move(samples);
         }
 
-        while (mLastSampleTime - dSampleLength > tTime) {
-          mLastSampleTime -= dSampleLength;
+        // Remove samples which are not required anymore, keeping one on either side.
+        auto first = std::upper_bound(mPoints.begin(), mPoints.end(), start,
+            [](double time, glm::dvec4 const& p) { return time < p.w; });
+        if (first - mPoints.begin() > 1) {
+          mChanges.mPopFront += static_cast<std::size_t>(first - mPoints.begin() - 1);
+          mPoints.erase(mPoints.begin(), first - 1);
+        }
 
-          try {
-            double tSampleTime =
-                glm::clamp(mLastSampleTime - dLengthSeconds, startExistence, endExistence);
-            glm::dvec3 pos = parent->getRelativePosition(tSampleTime, *target);
-            mPoints[(mStartIndex - 1 + pSamples.get()) % pSamples.get()] =
-                glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
+        auto last = std::lower_bound(mPoints.begin(), mPoints.end(), end,
+            [](glm::dvec4 const& p, double time) { return p.w < time; });
+        if (mPoints.end() - last > 1) {
+          mChanges.mPopBack += static_cast<std::size_t>(mPoints.end() - last - 1);
+          mPoints.erase(last + 1, mPoints.end());
+        }
 
-            mStartIndex = (mStartIndex - 1 + static_cast<int>(pSamples.get())) %
-                          static_cast<int>(pSamples.get());
-          } catch (...) {
-            // Getting the relative transformation may fail due to insufficient SPICE data.
+        // Stay within the sample budget by removing the oldest samples.
+        if (mPoints.size() > maxSamples) {
+          auto excess = static_cast<std::ptrdiff_t>(mPoints.size() - maxSamples);
+          if (forward) {
+            mChanges.mPopFront += static_cast<std::size_t>(excess);
+            mPoints.erase(mPoints.begin(), mPoints.begin() + excess);
+          } else {
+            mChanges.mPopBack += static_cast<std::size_t>(excess);
+            mPoints.erase(mPoints.end() - excess, mPoints.end());
           }
         }
       }
 
       mLastUpdateTime = tTime;
-
-      if (completeRecalculation) {
-        logger().debug("Recalculating trajectory for {}.", mTargetName);
-      }
     }
 
     mLastFrameTime = tTime;
 
     if (!mPoints.empty()) {
-      glm::dvec3 tip = mPoints[mStartIndex];
+      glm::dvec3 tip = mPoints.back();
       try {
         tip = parent->getRelativePosition(tTime, *target);
       } catch (...) {
         // Getting the relative transformation may fail due to insufficient SPICE data.
       }
 
-      mTrajectory.upload(parent->getObserverRelativeTransform(), tTime, mPoints, tip, mStartIndex);
+      mChanges.mIsVisible         = true;
+      mChanges.mRelativeTransform = parent->getObserverRelativeTransform();
+      mChanges.mTime              = tTime;
+      mChanges.mTip               = tip;
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Trajectory::update() {
+  if (mChanges.mReplace) {
+    mTrajectory.setPoints(mPoints);
+  } else {
+    mTrajectory.pushBack(mChanges.mPushBack);
+    mTrajectory.pushFront(mChanges.mPushFront);
+    mTrajectory.popFront(mChanges.mPopFront);
+    mTrajectory.popBack(mChanges.mPopBack);
+  }
+
+  if (mChanges.mIsVisible) {
+    mTrajectory.update(mChanges.mRelativeTransform, mChanges.mTime, mChanges.mTip);
+  }
+
+  mChanges = {};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Trajectory::setTargetName(std::string objectName) {
   mPoints.clear();
-  mTargetName = std::move(objectName);
+  mTrajectory.clear();
+  mPendingSamples = {};
+  mChanges        = {};
+  mTargetName     = std::move(objectName);
+  mTimerId        = cs::utils::FrameStats::intern("Trajectory of " + mTargetName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Trajectory::setParentName(std::string objectName) {
   mPoints.clear();
+  mTrajectory.clear();
+  mPendingSamples = {};
+  mChanges        = {};
   mParentName = std::move(objectName);
 }
 
@@ -188,7 +368,7 @@ bool Trajectory::Do() {
   auto target = mSolarSystem->getObject(mTargetName);
 
   if (parent->getIsInExistence() && target->getIsOrbitVisible()) {
-    cs::utils::FrameStats::ScopedTimer timer("Trajectory of " + mTargetName);
+    cs::utils::FrameStats::ScopedTimer timer(mTimerId);
     mTrajectory.Do();
   }
 
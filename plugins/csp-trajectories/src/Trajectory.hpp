@@ -12,10 +12,13 @@
 
 #include "../../../src/cs-scene/CelestialObject.hpp"
 #include "../../../src/cs-scene/Trajectory.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 
 #include <VistaBase/VistaColor.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <future>
 #include <memory>
+#include <vector>
 
 namespace csp::trajectories {
 
@@ -25,7 +28,8 @@ class Trajectory : public IVistaOpenGLDraw {
   /// The length of the trajectory in days.
   cs::utils::Property<double> pLength = 1.0;
 
-  /// The trajectory is drawn using this many linear pieces.
+  /// The trajectory is drawn using at most this many samples. They are placed adaptively: parts of
+  /// the trajectory which are strongly curved or close to the observer receive more samples.
   cs::utils::Property<uint32_t> pSamples = 100;
 
   /// The color of the trajectory.
@@ -42,8 +46,15 @@ class Trajectory : public IVistaOpenGLDraw {
 
   ~Trajectory() override;
 
-  /// This is called by the Plugin.
-  void update(double tTime);
+  /// This is called by the Plugin on a worker thread. It samples the trajectory, which queries
+  /// SPICE, but it does not call OpenGL. If preview is set, for example while the user scrubs
+  /// through time, the trajectory is resampled with fewer samples. Once preview is false again, it
+  /// is resampled with the full number of samples.
+  void updateAsync(double tTime, bool preview);
+
+  /// This is called by the Plugin on the main thread after updateAsync(). It uploads the samples
+  /// which have changed.
+  void update();
 
   /// The trajectory visualizes the path of this body.
   void               setTargetName(std::string objectName);
@@ -66,11 +77,43 @@ class Trajectory : public IVistaOpenGLDraw {
   std::string mTargetName;
   std::string mParentName;
 
+  /// The interned name of the timer, this is updated together with mTargetName.
+  cs::utils::FrameStats::TimerId mTimerId{};
+
+  /// The samples sorted by time. The w component contains the time of each sample. All changes are
+  /// mirrored to the ring buffer of mTrajectory, so that only new samples are uploaded.
   std::vector<glm::dvec4> mPoints;
-  int                     mStartIndex     = 0;
-  double                  mLastSampleTime = 0.0;
   double                  mLastUpdateTime = -1.0;
   double                  mLastFrameTime  = 0.0;
+
+  /// The current step of the adaptive sampling in seconds.
+  double mStep = 0.0;
+
+  /// True if mPoints or mPendingSamples contain a preview with a reduced number of samples.
+  bool mIsPreview = false;
+
+  /// If the entire trajectory is resampled, this is done by the EphemerisService. The new samples
+  /// replace the previous ones once they are ready, until then the previous samples are drawn.
+  std::future<std::vector<glm::dvec4>> mPendingSamples;
+
+  /// The changes made to mPoints by updateAsync() which still have to be applied to mTrajectory by
+  /// update(). The points are pushed before they are popped.
+  struct Changes {
+    /// If set, all points of mTrajectory are replaced by mPoints and the other changes are ignored.
+    bool                    mReplace = false;
+    std::vector<glm::dvec4> mPushBack;
+    std::vector<glm::dvec4> mPushFront;
+    std::size_t             mPopFront = 0;
+    std::size_t             mPopBack  = 0;
+
+    /// The arguments of cs::scene::Trajectory::update(). They are only valid if mIsVisible is set.
+    bool       mIsVisible = false;
+    glm::dmat4 mRelativeTransform{1.0};
+    double     mTime = 0.0;
+    glm::dvec3 mTip{0.0};
+  };
+
+  Changes mChanges;
 };
 
 } // namespace csp::trajectories
@@ -164,7 +164,7 @@ bool FloorGrid::Do() {
     return true;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer("VRAccessibility-FloorGrid");
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
 
   mShader.Bind();
 
@@ -11,6 +11,7 @@
 #include "Plugin.hpp"
 
 #include "../../../src/cs-scene/CelestialObject.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
@@ -75,6 +76,9 @@ class FloorGrid : public IVistaOpenGLDraw {
     uint32_t color            = 0;
   } mUniforms;
 
+  cs::utils::FrameStats::TimerId mTimerId =
+      cs::utils::FrameStats::intern("VRAccessibility-FloorGrid");
+
   static const char* VERT_SHADER;
   static const char* FRAG_SHADER;
 }; // class FloorGrid
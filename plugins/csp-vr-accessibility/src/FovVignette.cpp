@@ -79,6 +79,13 @@ FovVignette::FovVignette(std::shared_ptr<cs::core::SolarSystem> solarSystem,
   mUniforms.dynamicVertical.radii  = mShaderDynRadVertOnly.GetUniformLocation("uRadii");
   mUniforms.dynamicVertical.debug  = mShaderDynRadVertOnly.GetUniformLocation("uDebug");
 
+  mShaderOccluder.InitVertexShaderFromString(VERT_SHADER);
+  mShaderOccluder.InitFragmentShaderFromString(FRAG_SHADER_OCCLUDER);
+  mShaderOccluder.Link();
+  mUniforms.occluder.aspect       = mShaderOccluder.GetUniformLocation("uAspect");
+  mUniforms.occluder.radius       = mShaderOccluder.GetUniformLocation("uRadius");
+  mUniforms.occluder.verticalOnly = mShaderOccluder.GetUniformLocation("uVerticalOnly");
+
   // add to scenegraph
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
 
@@ -90,6 +97,13 @@ FovVignette::FovVignette(std::shared_ptr<cs::core::SolarSystem> solarSystem,
   VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
       mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::eGui) - 1);
 
+  // The occluder has to be drawn after the HDR buffer has been cleared but before anything else.
+  mOccluder = std::make_unique<Occluder>(*this);
+  mOccluderNode.reset(pSG->NewOpenGLNode(platform, mOccluder.get()));
+
+  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+      mOccluderNode.get(), static_cast<int>(cs::utils::DrawOrder::eClearHDRBuffer) + 1);
+
   // init animation housekeeping
   mFadeAnimation            = cs::utils::AnimatedValue(0.0F, 0.0F, 0.0, 0.0);
   mFadeAnimation.mDirection = cs::utils::AnimationDirection::eLinear;
@@ -102,6 +116,26 @@ FovVignette::~FovVignette() {
                        ->GetPlatformFor(GetVistaSystem()->GetDisplayManager()->GetDisplaySystem())
                        ->GetPlatformNode();
   platform->DisconnectChild(mGLNode.get());
+  platform->DisconnectChild(mOccluderNode.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FovVignette::Occluder::Occluder(FovVignette& vignette)
+    : mVignette(vignette) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FovVignette::Occluder::Do() {
+  mVignette.drawOccluder();
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FovVignette::Occluder::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+  return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -118,7 +152,7 @@ bool FovVignette::Do() {
     return true;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer("VRAccessibility-FovVignette");
+  cs::utils::FrameStats::ScopedTimer timer(mTimerId);
 
   std::array<GLint, 4> viewport{};
   glGetIntegerv(GL_VIEWPORT, viewport.data());
@@ -140,8 +174,7 @@ bool FovVignette::Do() {
     glUniform4fv(uniformLocs.color, 1,
         glm::value_ptr(Plugin::GetColorFromHexString(mVignetteSettings.mColor.get())));
 
-    // override current radius  if debug enabled
-    auto radii = mVignetteSettings.mDebug.get() ? mVignetteSettings.mRadii.get() : mCurrentRadii;
+    auto radii = getRadii();
     shader.SetUniform(uniformLocs.radii, radii[0], radii[1]);
     shader.SetUniform(uniformLocs.debug, mVignetteSettings.mDebug.get());
   } else {
@@ -190,6 +223,64 @@ bool FovVignette::GetBoundingBox(VistaBoundingBox& bb) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void FovVignette::drawOccluder() {
+  if (!mVignetteSettings.mEnabled.get() || !mVignetteSettings.mOccludePeriphery.get()) {
+    return;
+  }
+
+  // Only where the vignette is fully opaque, the scene does not have to be drawn. The static
+  // vignette is only opaque once it has completely faded in.
+  auto color = Plugin::GetColorFromHexString(mVignetteSettings.mColor.get());
+  bool faded = !mVignetteSettings.mUseDynamicRadius.get() && !mVignetteSettings.mDebug.get() &&
+               mFadeAnimation.get(getNow()) < 1.F;
+
+  if (color.a < 1.F || faded) {
+    return;
+  }
+
+  cs::utils::FrameStats::ScopedTimer timer(mOccluderTimerId);
+
+  std::array<GLint, 4> viewport{};
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
+  float aspect = static_cast<float>(viewport.at(3)) / static_cast<float>(viewport.at(2));
+
+  // The vignette is fully opaque beyond its outer radius.
+  mShaderOccluder.Bind();
+  mShaderOccluder.SetUniform(mUniforms.occluder.aspect, aspect);
+  mShaderOccluder.SetUniform(mUniforms.occluder.radius, getRadii()[1]);
+  mShaderOccluder.SetUniform(
+      mUniforms.occluder.verticalOnly, mVignetteSettings.mUseVerticalOnly.get());
+
+  // Only the depth is written. As all later fragments in this region will fail the depth test,
+  // their shading is skipped.
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glEnable(GL_DEPTH_TEST);
+  glDepthFunc(GL_ALWAYS);
+  glDepthMask(true);
+  glColorMask(false, false, false, false);
+
+  mVAO.Bind();
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  mVAO.Release();
+
+  glPopAttrib();
+
+  mShaderOccluder.Release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec2 FovVignette::getRadii() const {
+  // The dynamic vignette uses its current radii unless the debug mode is enabled.
+  if (mVignetteSettings.mUseDynamicRadius.get() && !mVignetteSettings.mDebug.get()) {
+    return mCurrentRadii;
+  }
+
+  return mVignetteSettings.mRadii.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 float FovVignette::getNewRadius(
     float innerOuterRadius, float normVelocity, float lastRadius, float dT) {
 
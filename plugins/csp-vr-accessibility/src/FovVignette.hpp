@@ -12,6 +12,7 @@
 
 #include "../../../src/cs-scene/CelestialObject.hpp"
 #include "../../../src/cs-utils/AnimatedValue.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 
 #include <VistaKernel/DisplayManager/VistaViewport.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
@@ -38,7 +39,7 @@ class FovVignette : public IVistaOpenGLDraw {
       Plugin::Settings::Vignette&                    vignetteSettings);
 
   FovVignette(FovVignette const& other) = delete;
-  FovVignette(FovVignette&& other)      = default;
+  FovVignette(FovVignette&& other)      = delete;
 
   FovVignette& operator=(FovVignette const& other) = delete;
   FovVignette& operator=(FovVignette&& other) = delete;
@@ -56,6 +57,24 @@ class FovVignette : public IVistaOpenGLDraw {
   bool GetBoundingBox(VistaBoundingBox& bb) override;
 
  private:
+  /// This is drawn right after the HDR buffer has been cleared. If the periphery shall be occluded,
+  /// it writes the closest possible depth where the vignette will be fully opaque.
+  class Occluder : public IVistaOpenGLDraw {
+   public:
+    explicit Occluder(FovVignette& vignette);
+
+    bool Do() override;
+    bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+   private:
+    FovVignette& mVignette;
+  };
+
+  void drawOccluder();
+
+  /// Returns the radii which are currently used for the vignette.
+  glm::vec2 getRadii() const;
+
   float  getNewRadius(float innerOuterRadius, float normVelocity, float lastRadius, float dT);
   double getNow();
 
@@ -63,6 +82,8 @@ class FovVignette : public IVistaOpenGLDraw {
   std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
 
   std::unique_ptr<VistaOpenGLNode> mGLNode;
+  std::unique_ptr<Occluder>        mOccluder;
+  std::unique_ptr<VistaOpenGLNode> mOccluderNode;
 
   cs::utils::AnimatedValue<float> mFadeAnimation;
   double                          mLastChange   = std::numeric_limits<double>::max();
@@ -75,6 +96,7 @@ class FovVignette : public IVistaOpenGLDraw {
   VistaGLSLShader             mShaderDynRad;
   VistaGLSLShader             mShaderFadeVertOnly;
   VistaGLSLShader             mShaderDynRadVertOnly;
+  VistaGLSLShader             mShaderOccluder;
   VistaVertexArrayObject      mVAO;
   VistaBufferObject           mVBO;
 
@@ -94,13 +116,25 @@ class FovVignette : public IVistaOpenGLDraw {
       uint32_t debug  = 0;
     } fade, fadeVertical;
 
+    struct {
+      uint32_t aspect       = 0;
+      uint32_t radius       = 0;
+      uint32_t verticalOnly = 0;
+    } occluder;
+
   } mUniforms;
 
+  cs::utils::FrameStats::TimerId mTimerId =
+      cs::utils::FrameStats::intern("VRAccessibility-FovVignette");
+  cs::utils::FrameStats::TimerId mOccluderTimerId =
+      cs::utils::FrameStats::intern("VRAccessibility-FovVignette-Occluder");
+
   static const char* VERT_SHADER;
   static const char* FRAG_SHADER_FADE;
   static const char* FRAG_SHADER_DYNRAD;
   static const char* FRAG_SHADER_FADE_VERTONLY;
   static const char* FRAG_SHADER_DYNRAD_VERTONLY;
+  static const char* FRAG_SHADER_OCCLUDER;
 }; // class FloorGrid
 } // namespace csp::vraccessibility
 
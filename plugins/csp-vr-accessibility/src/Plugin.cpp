@@ -67,6 +67,7 @@ void from_json(nlohmann::json const& j, Plugin::Settings::Vignette& o) {
   cs::core::Settings::deserialize(j, "velocityThresholds", o.mVelocityThresholds);
   cs::core::Settings::deserialize(j, "useDynamicRadius", o.mUseDynamicRadius);
   cs::core::Settings::deserialize(j, "useVerticalOnly", o.mUseVerticalOnly);
+  cs::core::Settings::deserialize(j, "occludePeriphery", o.mOccludePeriphery);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings::Vignette const& o) {
@@ -79,6 +80,7 @@ void to_json(nlohmann::json& j, Plugin::Settings::Vignette const& o) {
   cs::core::Settings::serialize(j, "velocityThresholds", o.mVelocityThresholds);
   cs::core::Settings::serialize(j, "useDynamicRadius", o.mUseDynamicRadius);
   cs::core::Settings::serialize(j, "useVerticalOnly", o.mUseVerticalOnly);
+  cs::core::Settings::serialize(j, "occludePeriphery", o.mOccludePeriphery);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -98,7 +100,11 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
 void Plugin::init() {
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-vr-accessibility")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect(
       [this]() { mAllSettings->mPlugins["csp-vr-accessibility"] = *mPluginSettings; });
 
@@ -76,6 +76,11 @@ class Plugin : public cs::core::PluginBase {
 
       /// The toggle to use only vertical vignetting.
       cs::utils::DefaultProperty<bool> mUseVerticalOnly{false};
+
+      /// If set to true, the depth buffer is filled where the vignette is fully opaque before the
+      /// scene is drawn. Thereby, the terrain and other depth-tested geometry is not shaded in the
+      /// hidden periphery.
+      cs::utils::DefaultProperty<bool> mOccludePeriphery{false};
     };
 
     /// The container for the Grid Settings
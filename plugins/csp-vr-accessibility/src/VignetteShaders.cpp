@@ -165,4 +165,37 @@ void main() {
 }
 )";
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader which writes the depth where the vignette is fully opaque
+
+const char* FovVignette::FRAG_SHADER_OCCLUDER = R"(
+#version 330
+
+uniform float uAspect;
+uniform float uRadius;
+uniform bool  uVerticalOnly;
+
+// inputs
+in vec2 vTexCoords;
+in vec3 vPosition;
+
+void main() {
+  float dist = 0;
+  if (uVerticalOnly) {
+    if (vPosition.y > 0) {
+      dist = vPosition.y;
+    } else {
+      dist = vPosition.y * -0.7;
+    }
+  } else {
+    dist = sqrt(vPosition.x * vPosition.x + uAspect * uAspect * vPosition.y * vPosition.y);
+  }
+
+  if (dist < uRadius) { discard; }
+
+  // As a reversed depth buffer is used, this is the closest possible depth.
+  gl_FragDepth = 1.0;
+}
+)";
+
 } // namespace csp::vraccessibility
@@ -11,6 +11,7 @@
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-scene/CelestialObserver.hpp"
+#include "../../../src/cs-utils/Metrics.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 #include "logger.hpp"
@@ -24,6 +25,9 @@
 #include <VistaKernel/VistaFrameLoop.h>
 #include <VistaKernel/VistaSystem.h>
 #include <curlpp/cURLpp.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 #include <sstream>
 #include <tiffio.h>
@@ -99,6 +103,105 @@ void tiffWriteToVector(std::vector<std::byte>& out, std::vector<T>& in, uint32_t
       [](char& c) { return static_cast<std::byte>(c); });
 }
 
+// OpenGL stores the rows of an image bottom to top, all image formats top to bottom.
+void flipRows(std::vector<std::byte>& image, size_t rowSize) {
+  size_t rows = image.size() / rowSize;
+  for (size_t i(0); i < rows / 2; ++i) {
+    std::swap_ranges(image.begin() + static_cast<std::ptrdiff_t>(i * rowSize),
+        image.begin() + static_cast<std::ptrdiff_t>((i + 1) * rowSize),
+        image.begin() + static_cast<std::ptrdiff_t>((rows - i - 1) * rowSize));
+  }
+}
+
+// Encodes the pixels read by glReadPixels() in the requested format. If depth is true, the pixels
+// contain the depth buffer as floats, else 8-bit RGB values. For depth tiffs, the depth values are
+// converted to meters with the given inverse projection matrix and the scale of the scene. This
+// does not use any OpenGL or CosmoScout VR state, so it can be called by the server's worker
+// thread.
+std::vector<std::byte> encodeCapture(std::vector<std::byte> pixels, int32_t width,
+    int32_t height, bool depth, std::string const& format, glm::mat4 const& matInvP,
+    double sceneScale) {
+
+  std::vector<std::byte> result;
+
+  auto pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+
+  if (depth) {
+    std::vector<float> capture(pixelCount);
+    std::memcpy(capture.data(), pixels.data(), pixelCount * sizeof(float));
+
+    if (format == "tiff") {
+
+      // If a tiff image is requested, we convert the depth buffer to meters.
+      glm::vec2 pixel(1.F / static_cast<float>(width), 1.F / static_cast<float>(height));
+
+      for (size_t i(0); i < capture.size(); ++i) {
+        auto coords = glm::vec2(i % width, i / width) * pixel + 0.5F * pixel;
+        auto pos    = matInvP * glm::vec4(2.F * coords - 1.F, 2.F * capture[i] - 1.F, 1.F);
+
+        float dist = static_cast<float>((glm::length(pos.xyz() / pos.w) * sceneScale));
+        capture[i] = std::isinf(dist) ? std::numeric_limits<float>::max() : dist;
+      }
+
+      // Now write the tiff image.
+      tiffWriteToVector(result, capture, width, height, 1, 32);
+
+    } else {
+      // Capture format is png or jpeg, let's convert the depth to 8-bit.
+      std::vector<std::byte> captureByte(pixelCount);
+      for (size_t i(0); i < capture.size(); ++i) {
+        // The funny cast is required for MSVC 14.1 which does not like casting floating point
+        // numbers to std::byte.
+        captureByte[i] = static_cast<std::byte>(static_cast<uint8_t>(capture[i] * 255.0));
+      }
+
+      flipRows(captureByte, static_cast<size_t>(width));
+
+      if (format == "png") {
+        stbi_write_png_to_func(
+            &stbWriteToVector, &result, width, height, 1, captureByte.data(), width);
+      } else {
+        stbi_write_jpg_to_func(
+            &stbWriteToVector, &result, width, height, 1, captureByte.data(), 80);
+      }
+    }
+
+  } else {
+
+    // Encoding color images is pretty straight-forward.
+    if (format == "tiff") {
+      tiffWriteToVector(result, pixels, width, height, 3, 8);
+    } else {
+      flipRows(pixels, static_cast<size_t>(width) * 3);
+
+      if (format == "png") {
+        stbi_write_png_to_func(
+            &stbWriteToVector, &result, width, height, 3, pixels.data(), width * 3);
+      } else {
+        stbi_write_jpg_to_func(&stbWriteToVector, &result, width, height, 3, pixels.data(), 80);
+      }
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// At most this many clients can be connected to the /events endpoint at the same time. Each of
+// them occupies one thread of the server.
+uint32_t const MAX_EVENT_CLIENTS = 4;
+
+// The number of events which are buffered for the /events endpoint.
+size_t const MAX_EVENTS = 1000;
+
+// The server uses one thread for each client of the /events endpoint. All other requests are
+// processed one after another, they lock this mutex.
+std::mutex& requestMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // A simple wrapper class which basically allows registering of lambdas as endpoint handlers for
@@ -110,6 +213,7 @@ class GetHandler : public CivetHandler {
   }
 
   bool handleGet(CivetServer* /*server*/, mg_connection* conn) override {
+    std::lock_guard<std::mutex> lock(requestMutex());
     mHandler(conn);
     return true;
   }
@@ -129,6 +233,26 @@ class PostHandler : public CivetHandler {
   }
 
   bool handlePost(CivetServer* /*server*/, mg_connection* conn) override {
+    std::lock_guard<std::mutex> lock(requestMutex());
+    mHandler(conn);
+    return true;
+  }
+
+ private:
+  std::function<void(mg_connection*)> mHandler;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This one handles GET requests which are answered with a stream of events. These do not lock the
+// request mutex, as they are running until the client disconnects.
+class StreamHandler : public CivetHandler {
+ public:
+  explicit StreamHandler(std::function<void(mg_connection*)> handler)
+      : mHandler(std::move(handler)) {
+  }
+
+  bool handleGet(CivetServer* /*server*/, mg_connection* conn) override {
     mHandler(conn);
     return true;
   }
@@ -152,6 +276,27 @@ T getParam(mg_connection* conn, std::string const& name, T const& defaultValue)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Answers a /run-js, /run-js-batch or /load request. If the parameter "wait" is set to "true",
+// this waits until the main thread executed the command, so that clients can send their next
+// command without guessing how long the previous one takes. Note that JavaScript is executed
+// asynchronously by the user interface, so only its execution may have started at that point.
+void sendCommandResponse(mg_connection* conn, std::future<void>& done) {
+  if (done.valid() && getParam<std::string>(conn, "wait", "false") == "true") {
+    try {
+      done.get();
+    } catch (std::future_error const&) {
+      mg_send_http_error(conn, 503, "The server has been stopped before the request was done!");
+      return;
+    }
+  }
+
+  std::string response = "Done.\r\n";
+  mg_send_http_ok(conn, "text/plain", response.length());
+  mg_write(conn, response.data(), response.length());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -163,11 +308,13 @@ namespace csp::webapi {
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "port", o.mPort);
   cs::core::Settings::deserialize(j, "page", o.mPage);
+  cs::core::Settings::deserialize(j, "commandTimeBudget", o.mCommandTimeBudget);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "port", o.mPort);
   cs::core::Settings::serialize(j, "page", o.mPage);
+  cs::core::Settings::serialize(j, "commandTimeBudget", o.mCommandTimeBudget);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -185,12 +332,19 @@ void Plugin::init() {
             {spdlog::level::trace, "T"}, {spdlog::level::debug, "D"}, {spdlog::level::info, "I"},
             {spdlog::level::warn, "W"}, {spdlog::level::err, "E"}, {spdlog::level::critical, "C"}};
 
-        std::lock_guard<std::mutex> lock(mLogMutex);
-        mLogMessages.push_front("[" + mapping.at(level) + "] " + logger + message);
+        {
+          std::lock_guard<std::mutex> lock(mLogMutex);
+          mLogMessages.push_front("[" + mapping.at(level) + "] " + logger + message);
 
-        if (mLogMessages.size() > 1000) {
-          mLogMessages.pop_back();
+          if (mLogMessages.size() > 1000) {
+            mLogMessages.pop_back();
+          }
         }
+
+        // The logger names are padded with dots, these are not sent to the /events clients.
+        auto           name = logger.substr(0, logger.find_last_not_of(". ") + 1);
+        nlohmann::json data{{"level", mapping.at(level)}, {"logger", name}, {"message", message}};
+        pushEvent("log", data.dump(), level, name);
       });
 
   // Return the landing page when the root document is requested. If not landing page is configured,
@@ -225,6 +379,89 @@ void Plugin::init() {
     mg_write(conn, response.data(), response.length());
   }));
 
+  // Clients connected to /events receive log messages and changes of the observer and the
+  // simulation time as server-sent events until they disconnect. This way, they do not have to
+  // poll the /log endpoint. The parameter "log" is the minimum level of the log messages ("off"
+  // disables them), "logger" only sends messages of loggers whose name starts with the given
+  // string, and "state=false" disables the state events.
+  mHandlers.emplace("/events", std::make_unique<StreamHandler>([this](mg_connection* conn) {
+    auto logLevel  = spdlog::level::from_str(getParam<std::string>(conn, "log", "info"));
+    auto logger    = getParam<std::string>(conn, "logger", "");
+    auto sendState = getParam<std::string>(conn, "state", "true") == "true";
+
+    // Each client occupies one thread of the server. At least one thread has to remain for the
+    // other endpoints.
+    if (++mEventClients > MAX_EVENT_CLIENTS) {
+      --mEventClients;
+      mg_send_http_error(conn, 503, "Too many clients are connected to /events!");
+      return;
+    }
+
+    mg_printf(conn, "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: text/event-stream\r\n"
+                    "Cache-Control: no-cache\r\n"
+                    "Connection: close\r\n\r\n");
+
+    std::unique_lock<std::mutex> lock(mEventsMutex);
+
+    std::string response;
+    if (sendState && !mLastState.empty()) {
+      response = "event: state\ndata: " + mLastState.dump() + "\n\n";
+    }
+
+    uint64_t nextId = mNextEventId;
+
+    while (!mEventsClosed) {
+      for (auto const& event : mEvents) {
+        if (event.mId < nextId) {
+          continue;
+        }
+
+        bool accepted = sendState;
+        if (event.mType == "log") {
+          accepted = logLevel != spdlog::level::off && event.mLevel >= logLevel &&
+                     event.mLogger.rfind(logger, 0) == 0;
+        }
+
+        if (accepted) {
+          response += "event: " + event.mType + "\ndata: " + event.mData + "\n\n";
+        }
+      }
+
+      nextId = mNextEventId;
+
+      // The events are written without holding the lock. If the client does not receive any
+      // event for some time, a comment is sent in order to detect whether it is still connected.
+      lock.unlock();
+      if (response.empty()) {
+        response = ":\n\n";
+      }
+
+      if (mg_write(conn, response.data(), response.length()) <= 0) {
+        lock.lock();
+        break;
+      }
+
+      response.clear();
+      lock.lock();
+
+      mEventsChanged.wait_for(lock, std::chrono::seconds(5),
+          [this, nextId]() { return mEventsClosed || mNextEventId != nextId; });
+    }
+
+    lock.unlock();
+    --mEventClients;
+  }));
+
+  // Return all runtime performance counters in the Prometheus text format for /metrics requests.
+  // The collectors of the Metrics are thread-safe, so this does not have to wait for the main
+  // thread.
+  mHandlers.emplace("/metrics", std::make_unique<GetHandler>([](mg_connection* conn) {
+    std::string response = cs::utils::Metrics::get().collect();
+    mg_send_http_ok(conn, "text/plain; version=0.0.4; charset=utf-8", response.length());
+    mg_write(conn, response.data(), response.length());
+  }));
+
   // Return a json object containing the current scene settings.
   mHandlers.emplace("/save", std::make_unique<GetHandler>([this](mg_connection* conn) {
     // This string will contain the json data at the end of this method.
@@ -239,21 +476,22 @@ void Plugin::init() {
       // Plugin::update() method further below.
       mSaveDone.wait(lock);
 
-      response = mSaveSettings;
+      // The main thread only creates the json tree, formatting it is done on this thread.
+      if (!mSaveSettings.is_null()) {
+        response = mSaveSettings.dump(2);
+      }
+      mSaveSettings = nullptr;
     }
 
     mg_send_http_ok(conn, "application/json", response.length());
     mg_write(conn, response.data(), response.length());
   }));
 
-  // Allows uploading of the current scene settings.
+  // Allows uploading of the current scene settings. The settings are applied in the main thread
+  // in the order in which they were received relative to /run-js requests.
   mHandlers.emplace("/load", std::make_unique<PostHandler>([this](mg_connection* conn) {
-    std::lock_guard<std::mutex> lock(mLoadMutex);
-    mLoadSettings = CivetServer::getPostData(conn);
-
-    std::string response = "Done.\r\n";
-    mg_send_http_ok(conn, "text/plain", response.length());
-    mg_write(conn, response.data(), response.length());
+    auto done = pushCommand(CommandType::eLoad, CivetServer::getPostData(conn));
+    sendCommandResponse(conn, done);
   }));
 
   // The /capture endpoint is a little bit more involved. As it takes several frames for the
@@ -272,6 +510,7 @@ void Plugin::init() {
     mCaptureGui    = getParam<std::string>(conn, "gui", "auto");
     mCaptureDepth  = getParam<std::string>(conn, "depth", "false") == "true";
     mCaptureFormat = getParam<std::string>(conn, "format", mCaptureDepth ? "tiff" : "png");
+    mCaptureTiles  = std::clamp(getParam<int32_t>(conn, "tiles", 1), 1, 8);
 
     // Validate format parameter.
     if (mCaptureFormat != "png" && mCaptureFormat != "jpeg" && mCaptureFormat != "tiff") {
@@ -280,6 +519,12 @@ void Plugin::init() {
       return;
     }
 
+    // The depth values can only be converted to meters with the projection of a single tile.
+    if (mCaptureDepth && mCaptureTiles > 1) {
+      mg_send_http_error(conn, 422, "Tiled captures are only supported for color images!");
+      return;
+    }
+
     // Validate gui parameter.
     if (mCaptureGui != "auto" && mCaptureGui != "true" && mCaptureGui != "false") {
       mg_send_http_error(
@@ -289,25 +534,56 @@ void Plugin::init() {
 
     // This tells the main thread that a capture request is pending.
     mCaptureRequested = true;
+    mCaptureReady     = false;
 
     // Now we use a condition variable to wait for the capture. It is actually captured in the
     // Plugin::update() method further below.
-    mCaptureDone.wait(lock);
+    mCaptureDone.wait(lock, [this]() { return mCaptureReady; });
+
+    // The pixels have been read. They are encoded here, so that neither the main thread has to wait
+    // for the encoding nor does the main thread have to wait for the lock while we are encoding.
+    auto pixels  = std::move(mCapture);
+    auto width   = mCaptureWidth;
+    auto height  = mCaptureHeight;
+    auto depth   = mCaptureDepth;
+    auto format  = mCaptureFormat;
+    auto matInvP = mCaptureInverseProjection;
+    auto scale   = mCaptureSceneScale;
+    lock.unlock();
+
+    auto image = encodeCapture(std::move(pixels), width, height, depth, format, matInvP, scale);
 
     // The capture has been captured, return the result!
-    mg_send_http_ok(conn, ("image/" + mCaptureFormat).c_str(), mCapture.size());
-    mg_write(conn, mCapture.data(), mCapture.size());
+    mg_send_http_ok(conn, ("image/" + format).c_str(), image.size());
+    mg_write(conn, image.data(), image.size());
   }));
 
   // All POST requests received on /run-js are stored in a queue. They are executed in the main
   // thread in the Plugin::update() method further below.
   mHandlers.emplace("/run-js", std::make_unique<PostHandler>([this](mg_connection* conn) {
-    std::lock_guard<std::mutex> lock(mJavaScriptCallsMutex);
-    mJavaScriptCalls.push(CivetServer::getPostData(conn));
+    auto done = pushCommand(CommandType::eJavaScript, CivetServer::getPostData(conn));
+    sendCommandResponse(conn, done);
+  }));
 
-    std::string response = "Done.\r\n";
-    mg_send_http_ok(conn, "text/plain", response.length());
-    mg_write(conn, response.data(), response.length());
+  // The body of /run-js-batch requests is a json array of strings. Each string is executed like
+  // a /run-js request, in the given order.
+  mHandlers.emplace("/run-js-batch", std::make_unique<PostHandler>([this](mg_connection* conn) {
+    std::vector<std::string> calls;
+
+    try {
+      calls = nlohmann::json::parse(CivetServer::getPostData(conn)).get<std::vector<std::string>>();
+    } catch (std::exception const& e) {
+      mg_send_http_error(conn, 422, "Expected a json array of strings: %s", e.what());
+      return;
+    }
+
+    // Only the last command has to be waited for, as all commands are executed in order.
+    std::future<void> done;
+    for (auto& call : calls) {
+      done = pushCommand(CommandType::eJavaScript, std::move(call));
+    }
+
+    sendCommandResponse(conn, done);
   }));
 
   mOnLoadConnection = mAllSettings->onLoad().connect([this]() { mReloadRequired = true; });
@@ -333,6 +609,12 @@ void Plugin::deInit() {
 
   quitServer();
 
+  if (mCaptureFence) {
+    glDeleteSync(mCaptureFence);
+  }
+
+  glDeleteBuffers(1, &mCapturePBO);
+
   logger().info("Unloading done.");
 }
 
@@ -340,16 +622,9 @@ void Plugin::deInit() {
 
 void Plugin::update() {
 
-  // Execute all /run-js requests received since the last call to update().
-  {
-    std::lock_guard<std::mutex> lock(mJavaScriptCallsMutex);
-    while (!mJavaScriptCalls.empty()) {
-      auto request = mJavaScriptCalls.front();
-      mJavaScriptCalls.pop();
-      logger().debug("Executing '/run-js' request: '{}'", request);
-      mGuiManager->getGui()->executeJavascript(request);
-    }
-  }
+  // Execute the /run-js and /load requests received since the last call to update() as long as
+  // the time budget allows.
+  executeCommands();
 
   // Execute any pending /save request.
   {
@@ -357,31 +632,16 @@ void Plugin::update() {
     if (mSaveRequested) {
       logger().debug("Executing '/save' request.");
       try {
-        mSaveSettings = mAllSettings->saveToJson();
+        mSaveSettings = mAllSettings->saveToJsonObject();
       } catch (std::exception const& e) {
         logger().error("Failed to write settings: {}", e.what());
-        mSaveSettings = "";
+        mSaveSettings = nullptr;
       }
       mSaveDone.notify_one();
       mSaveRequested = false;
     }
   }
 
-  // Execute any pending /load request.
-  {
-    std::lock_guard<std::mutex> lock(mLoadMutex);
-    if (!mLoadSettings.empty()) {
-      logger().debug("Executing '/load' request.");
-      try {
-        mAllSettings->loadFromJson(mLoadSettings);
-      } catch (std::exception const& e) {
-        logger().error("Failed to read settings: {}", e.what());
-        mSaveSettings = "";
-      }
-      mLoadSettings.clear();
-    }
-  }
-
   // If a screen shot has been requested, we first resize the image to the given size. Then we wait
   // mCaptureDelay frames until we actually read the pixels.
   {
@@ -395,99 +655,153 @@ void Plugin::update() {
       if (mCaptureGui != "auto") {
         mAllSettings->pEnableUserInterface = mCaptureGui == "true";
       }
+      mCaptureTile      = -1;
       mCaptureRequested = false;
     }
 
-    // Now we waited several frames. We read the pixels, encode the data as png and notify the
-    // server's worker thread that the screen shot is done.
-    if (mCaptureAtFrame > 0 &&
-        mCaptureAtFrame == GetVistaSystem()->GetFrameLoop()->GetFrameCount()) {
+    auto frame = GetVistaSystem()->GetFrameLoop()->GetFrameCount();
 
-      auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
-      window->GetWindowProperties()->GetSize(mCaptureWidth, mCaptureHeight);
+    // Once the pixels of a tile have been read, we copy them from the pixel buffer object. When the
+    // last tile has been copied, we notify the server's worker thread, which will encode the image.
+    // The fence is polled without waiting, so this never stalls.
+    if (mCaptureFence) {
+      auto status = glClientWaitSync(mCaptureFence, 0, 0);
 
-      logger().debug("Capturing capture for /capture request: resolution = {}x{}, show gui = {}, "
-                     "depth = {}, format = {}",
-          mCaptureWidth, mCaptureHeight, mCaptureGui, mCaptureDepth, mCaptureFormat);
+      if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+        glDeleteSync(mCaptureFence);
+        mCaptureFence = nullptr;
 
-      // We encode image data in the main thread as this is not thread-safe.
-      stbi_flip_vertically_on_write(1);
+        size_t pixelSize = mCaptureDepth ? sizeof(float) : 3;
+        size_t rowSize   = static_cast<size_t>(mCaptureTileWidth) * pixelSize;
+        size_t bytes     = rowSize * static_cast<size_t>(mCaptureTileHeight);
 
-      // Clear last data first.
-      mCapture.clear();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mCapturePBO);
+        auto const* data = static_cast<std::byte const*>(glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT));
 
-      if (mCaptureDepth) {
+        if (mCaptureTiles == 1) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+          mCapture.assign(data, data + bytes);
+        } else {
+          // Copy the rows of the tile to their position in the stitched image. Both are stored
+          // bottom to top.
+          auto   tileX      = static_cast<size_t>(mCaptureReadTile % mCaptureTiles);
+          auto   tileY      = static_cast<size_t>(mCaptureReadTile / mCaptureTiles);
+          size_t imageRow   = rowSize * static_cast<size_t>(mCaptureTiles);
+          size_t tileOffset = tileY * static_cast<size_t>(mCaptureTileHeight) * imageRow +
+                              tileX * rowSize;
+
+          for (size_t y(0); y < static_cast<size_t>(mCaptureTileHeight); ++y) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            std::memcpy(&mCapture[tileOffset + y * imageRow], data + y * rowSize, rowSize);
+          }
+        }
 
-        // Capture the depth component.
-        std::vector<float> capture(mCaptureWidth * mCaptureHeight);
-        glReadPixels(
-            0, 0, mCaptureWidth, mCaptureHeight, GL_DEPTH_COMPONENT, GL_FLOAT, capture.data());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-        if (mCaptureFormat == "tiff") {
+        // The capture has been done, notify the worker thread.
+        if (mCaptureReadTile == mCaptureTiles * mCaptureTiles - 1) {
+          mCaptureWidth  = mCaptureTileWidth * mCaptureTiles;
+          mCaptureHeight = mCaptureTileHeight * mCaptureTiles;
+          mCaptureReady  = true;
+          mCaptureDone.notify_one();
+        }
+      }
+    }
 
-          // If a tiff image is requested, we convert the depth buffer to meters.
-          std::array<GLfloat, 16> glMatP{};
-          glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
-          auto      matInvP = glm::inverse(glm::make_mat4x4(glMatP.data()));
-          glm::vec2 pixel(1.F / mCaptureWidth, 1.F / mCaptureHeight);
+    // Now we waited several frames. For tiled captures, we zoom into the first tile and wait again.
+    if (mCaptureAtFrame > 0 && frame >= mCaptureAtFrame && mCaptureTile < 0) {
+      auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+      window->GetWindowProperties()->GetSize(mCaptureTileWidth, mCaptureTileHeight);
 
-          for (size_t i(0); i < capture.size(); ++i) {
-            auto coords = glm::vec2(i % mCaptureWidth, i / mCaptureWidth) * pixel + 0.5F * pixel;
-            auto pos    = matInvP * glm::vec4(2.F * coords - 1.F, 2.F * capture[i] - 1.F, 1.F);
+      logger().debug("Capturing capture for /capture request: resolution = {}x{}, tiles = {}, "
+                     "show gui = {}, depth = {}, format = {}",
+          mCaptureTileWidth * mCaptureTiles, mCaptureTileHeight * mCaptureTiles,
+          mCaptureTiles * mCaptureTiles, mCaptureGui, mCaptureDepth, mCaptureFormat);
 
-            float dist = static_cast<float>(
-                (glm::length(pos.xyz() / pos.w) * mSolarSystem->getObserver().getScale()));
-            capture[i] = std::isinf(dist) ? std::numeric_limits<float>::max() : dist;
-          }
+      mCaptureTile = 0;
+      mCapture.clear();
 
-          // Now write the tiff image.
-          tiffWriteToVector(mCapture, capture, mCaptureWidth, mCaptureHeight, 1, 32);
+      if (mCaptureTiles > 1) {
+        auto* viewport = GetVistaSystem()->GetDisplayManager()->GetViewports().begin()->second;
+        viewport->GetProjection()->GetProjectionProperties()->GetProjPlaneExtents(
+            mCaptureExtents[0], mCaptureExtents[1], mCaptureExtents[2], mCaptureExtents[3]);
 
-        } else {
-          // Capture format is png or jpeg, let's convert the depth to 8-bit.
-          std::vector<std::byte> captureByte(mCaptureWidth * mCaptureHeight);
-          for (size_t i(0); i < capture.size(); ++i) {
-            // The funny cast is required for MSVC 14.1 which does not like casting floating point
-            // numbers to std::byte.
-            captureByte[i] = static_cast<std::byte>(static_cast<uint8_t>(capture[i] * 255.0));
-          }
+        // The sensor size control would reset the projection plane each frame. The exposure is
+        // fixed, else each tile would have a different brightness.
+        mCaptureSensorSizeControl = mAllSettings->pEnableSensorSizeControl.get();
+        mCaptureAutoExposure      = mAllSettings->mGraphics.pEnableAutoExposure.get();
+        mAllSettings->pEnableSensorSizeControl       = false;
+        mAllSettings->mGraphics.pEnableAutoExposure = false;
 
-          if (mCaptureFormat == "png") {
-            stbi_write_png_to_func(&stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 1,
-                captureByte.data(), mCaptureWidth);
-          } else {
-            stbi_write_jpg_to_func(&stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 1,
-                captureByte.data(), 80);
-          }
-        }
+        mCapture.resize(static_cast<size_t>(mCaptureTileWidth) * mCaptureTileHeight * 3 *
+                        mCaptureTiles * mCaptureTiles);
 
-      } else {
+        setCaptureTile(0);
+        mCaptureAtFrame = frame + mCaptureDelay;
+      }
+    }
 
-        // Capturing color images is pretty straight-forward.
-        std::vector<std::byte> capture(mCaptureWidth * mCaptureHeight * 3);
-        glReadPixels(0, 0, mCaptureWidth, mCaptureHeight, GL_RGB, GL_UNSIGNED_BYTE, &capture[0]);
+    // We start reading the pixels of the current tile into the pixel buffer object. This does not
+    // wait for the GPU to finish rendering. If the previous tile is still being read, we try again
+    // in the next frame.
+    if (mCaptureAtFrame > 0 && frame >= mCaptureAtFrame && mCaptureTile >= 0 && !mCaptureFence) {
+      auto pixelCount =
+          static_cast<size_t>(mCaptureTileWidth) * static_cast<size_t>(mCaptureTileHeight);
+      auto bytes = pixelCount * (mCaptureDepth ? sizeof(float) : 3);
 
-        if (mCaptureFormat == "tiff") {
-          tiffWriteToVector(mCapture, capture, mCaptureWidth, mCaptureHeight, 3, 8);
-        } else if (mCaptureFormat == "png") {
-          stbi_write_png_to_func(&stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 3,
-              capture.data(), mCaptureWidth * 3);
-        } else {
-          stbi_write_jpg_to_func(
-              &stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 3, capture.data(), 80);
-        }
+      if (mCapturePBO == 0) {
+        glGenBuffers(1, &mCapturePBO);
+      }
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, mCapturePBO);
+      glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_READ);
+
+      // The rows of RGB images are tightly packed.
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+      if (mCaptureDepth) {
+        glReadPixels(
+            0, 0, mCaptureTileWidth, mCaptureTileHeight, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+      } else {
+        glReadPixels(
+            0, 0, mCaptureTileWidth, mCaptureTileHeight, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
       }
 
-      // Restore stb image state to default.
-      stbi_flip_vertically_on_write(0);
+      glPixelStorei(GL_PACK_ALIGNMENT, 4);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+      mCaptureFence    = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      mCaptureReadTile = mCaptureTile;
 
-      mCaptureAtFrame = 0;
+      // These are required for converting the depth buffer to meters.
+      std::array<GLfloat, 16> glMatP{};
+      glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+      mCaptureInverseProjection = glm::inverse(glm::make_mat4x4(glMatP.data()));
+      mCaptureSceneScale        = mSolarSystem->getObserver().getScale();
 
-      // The capture has been done, notify the worker thread,
-      mCaptureDone.notify_one();
+      // The read has been queued before any further rendering, so we can directly zoom into the
+      // next tile. After the last tile, the original projection plane is restored.
+      if (++mCaptureTile < mCaptureTiles * mCaptureTiles) {
+        setCaptureTile(mCaptureTile);
+        mCaptureAtFrame = frame + mCaptureDelay;
+      } else {
+        if (mCaptureTiles > 1) {
+          auto* viewport = GetVistaSystem()->GetDisplayManager()->GetViewports().begin()->second;
+          viewport->GetProjection()->GetProjectionProperties()->SetProjPlaneExtents(
+              mCaptureExtents[0], mCaptureExtents[1], mCaptureExtents[2], mCaptureExtents[3]);
+          mAllSettings->pEnableSensorSizeControl       = mCaptureSensorSizeControl;
+          mAllSettings->mGraphics.pEnableAutoExposure = mCaptureAutoExposure;
+        }
+
+        mCaptureAtFrame = 0;
+      }
     }
   }
 
+  pushStateChanges();
+
   // In this plugin, we cannot call this directly when the onLoad signal of the settings is fired,
   // since reloading can cause our server to be restarted. And as reloading can be triggered from a
   // /load request, this could lead to a deadlock.
@@ -504,14 +818,160 @@ void Plugin::onSave() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::future<void> Plugin::pushCommand(CommandType type, std::string data) {
+  Command command{type, std::move(data), {}};
+  auto    done = command.mDone.get_future();
+
+  // While the server is stopped, the command is discarded. Then the future reports a broken
+  // promise.
+  std::lock_guard<std::mutex> lock(mCommandsMutex);
+  if (!mCommandsClosed) {
+    mCommands.push(std::move(command));
+  }
+
+  return done;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::executeCommands() {
+  auto start  = std::chrono::steady_clock::now();
+  auto budget = std::chrono::duration<double, std::milli>(mPluginSettings.mCommandTimeBudget.get());
+
+  while (true) {
+    Command command;
+
+    // The lock is not held while the command is executed, so that the server can queue further
+    // commands in the meantime.
+    {
+      std::lock_guard<std::mutex> lock(mCommandsMutex);
+      if (mCommands.empty()) {
+        return;
+      }
+      command = std::move(mCommands.front());
+      mCommands.pop();
+    }
+
+    if (command.mType == CommandType::eJavaScript) {
+      logger().debug("Executing '/run-js' request: '{}'", command.mData);
+      mGuiManager->getGui()->executeJavascript(command.mData);
+    } else {
+      logger().debug("Executing '/load' request.");
+      try {
+        // This makes sure that each changed setting is applied only once.
+        cs::core::Settings::Transaction transaction(*mAllSettings);
+        mAllSettings->loadFromJson(command.mData);
+      } catch (std::exception const& e) {
+        logger().error("Failed to read settings: {}", e.what());
+      }
+    }
+
+    command.mDone.set_value();
+
+    if (std::chrono::steady_clock::now() - start > budget) {
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::pushEvent(
+    std::string type, std::string data, spdlog::level::level_enum level, std::string logger) {
+  {
+    std::lock_guard<std::mutex> lock(mEventsMutex);
+    mEvents.push_back(
+        {mNextEventId++, std::move(type), std::move(data), level, std::move(logger)});
+
+    if (mEvents.size() > MAX_EVENTS) {
+      mEvents.pop_front();
+    }
+  }
+
+  mEventsChanged.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::pushStateChanges() {
+
+  // If no client is connected, we do not have to compute anything. The next client will receive
+  // the complete state as its first event.
+  if (mEventClients == 0) {
+    std::lock_guard<std::mutex> lock(mEventsMutex);
+    mLastState.clear();
+    return;
+  }
+
+  auto const& observer = mSolarSystem->getObserver();
+  auto const& position = observer.getPosition();
+  auto const& rotation = observer.getRotation();
+
+  nlohmann::json state{{"center", observer.getCenterName()}, {"frame", observer.getFrameName()},
+      {"position", {position.x, position.y, position.z}},
+      {"rotation", {rotation.x, rotation.y, rotation.z, rotation.w}},
+      {"simulationTime", mTimeControl->pSimulationTime.get()},
+      {"timeSpeed", mAllSettings->pTimeSpeed.get()}};
+
+  // Only the values which changed since the last frame are sent.
+  nlohmann::json changes;
+
+  {
+    std::lock_guard<std::mutex> lock(mEventsMutex);
+    for (auto const& [key, value] : state.items()) {
+      auto last = mLastState.find(key);
+      if (last == mLastState.end() || *last != value) {
+        changes[key] = value;
+      }
+    }
+
+    mLastState = std::move(state);
+  }
+
+  if (!changes.is_null()) {
+    pushEvent("state", changes.dump());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::setCaptureTile(int32_t tile) {
+  double tileX = tile % mCaptureTiles;
+  double tileY = tile / mCaptureTiles;
+  double tiles = mCaptureTiles;
+
+  auto [left, right, bottom, top] = mCaptureExtents;
+  double width                    = (right - left) / tiles;
+  double height                   = (top - bottom) / tiles;
+
+  auto* viewport = GetVistaSystem()->GetDisplayManager()->GetViewports().begin()->second;
+  viewport->GetProjection()->GetProjectionProperties()->SetProjPlaneExtents(left + tileX * width,
+      left + (tileX + 1) * width, bottom + tileY * height, bottom + (tileY + 1) * height);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::startServer(uint16_t port) {
 
   // First quit the server as it may be running already.
   quitServer();
 
   try {
-    // We start the server with one thread only, as we do not want to process requests in parallel.
-    std::vector<std::string> options{"listening_ports", std::to_string(port), "num_threads", "1"};
+    // Except for the /events endpoint, we do not want to process requests in parallel. Hence there
+    // is one thread for the clients of /events and one for all other requests.
+    std::vector<std::string> options{"listening_ports", std::to_string(port), "num_threads",
+        std::to_string(MAX_EVENT_CLIENTS + 1)};
+
+    {
+      std::lock_guard<std::mutex> lock(mEventsMutex);
+      mEventsClosed = false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mCommandsMutex);
+      mCommandsClosed = false;
+    }
+
     mServer = std::make_unique<CivetServer>(options);
 
     for (auto const& handler : mHandlers) {
@@ -524,6 +984,21 @@ void Plugin::startServer(uint16_t port) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Plugin::quitServer() {
+  // The clients of the /events endpoint have to be woken up, as the server waits for all of its
+  // threads to finish.
+  {
+    std::lock_guard<std::mutex> lock(mEventsMutex);
+    mEventsClosed = true;
+  }
+  mEventsChanged.notify_all();
+
+  // The same is true for clients waiting for their commands. These will report an error.
+  {
+    std::lock_guard<std::mutex> lock(mCommandsMutex);
+    mCommands       = {};
+    mCommandsClosed = true;
+  }
+
   try {
     if (mServer) {
       mServer.reset();
@@ -11,11 +11,19 @@
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-utils/DefaultProperty.hpp"
 
+#include <GL/glew.h>
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
 #include <deque>
+#include <future>
+#include <glm/glm.hpp>
+#include <mutex>
+#include <nlohmann/json.hpp>
 #include <optional>
 #include <queue>
+#include <spdlog/spdlog.h>
 #include <unordered_map>
 
 class CivetServer;
@@ -36,6 +44,11 @@ class Plugin : public cs::core::PluginBase {
     /// executable. Note that no other files are served by the server, so the given html file should
     /// not depend on other local resources.
     std::optional<std::string> mPage;
+
+    /// Commands received on /run-js, /run-js-batch and /load are executed in the order they were
+    /// received. Each frame, commands are executed until this many milliseconds have passed. At
+    /// least one command is executed per frame.
+    cs::utils::DefaultProperty<double> mCommandTimeBudget{2.0};
   };
 
   void init() override;
@@ -46,6 +59,27 @@ class Plugin : public cs::core::PluginBase {
  private:
   void onSave();
 
+  /// Appends an event to the buffer of the /events endpoint and wakes up all connected clients.
+  /// The level and the logger name are only used for log messages. This is called on the main
+  /// thread.
+  void pushEvent(std::string type, std::string data,
+      spdlog::level::level_enum level = spdlog::level::off, std::string logger = "");
+
+  /// Sends the changes of the observer and of the simulation time since the last call to all
+  /// clients connected to /events.
+  void pushStateChanges();
+
+  /// Appends a command to the queue which is executed in update(). The returned future becomes
+  /// ready once the command has been executed on the main thread.
+  enum class CommandType { eJavaScript, eLoad };
+  std::future<void> pushCommand(CommandType type, std::string data);
+
+  /// Executes queued commands until the time budget of this frame is used up.
+  void executeCommands();
+
+  /// Sets the projection plane extents for the given tile of a tiled capture.
+  void setCaptureTile(int32_t tile);
+
   void startServer(uint16_t port);
   void quitServer();
 
@@ -63,26 +97,69 @@ class Plugin : public cs::core::PluginBase {
   std::string             mCaptureGui       = "auto";
   bool                    mCaptureDepth     = false;
   std::string             mCaptureFormat;
+  int32_t                 mCaptureTiles   = 1;
   int32_t                 mCaptureAtFrame = 0;
-  std::vector<std::byte>  mCapture;
+
+  // For tiled captures, the projection plane is split into mCaptureTiles x mCaptureTiles tiles
+  // which are rendered one after another at the current window size. mCaptureTile is the tile which
+  // is rendered next, or -1 if the capture has not started yet.
+  int32_t               mCaptureTile       = -1;
+  int32_t               mCaptureReadTile   = 0;
+  int32_t               mCaptureTileWidth  = 0;
+  int32_t               mCaptureTileHeight = 0;
+  std::array<double, 4> mCaptureExtents{};
+  bool                  mCaptureSensorSizeControl = false;
+  bool                  mCaptureAutoExposure      = false;
+
+  // The pixels are read asynchronously into this pixel buffer object. Once the fence is signaled,
+  // they are copied to mCapture and encoded by the server's worker thread.
+  uint32_t               mCapturePBO   = 0;
+  GLsync                 mCaptureFence = nullptr;
+  bool                   mCaptureReady = false;
+  glm::mat4              mCaptureInverseProjection{1.F};
+  double                 mCaptureSceneScale = 1.0;
+  std::vector<std::byte> mCapture;
 
   // Members for the /log endpoint
   std::mutex              mLogMutex;
   std::deque<std::string> mLogMessages;
 
+  // Members for the /events endpoint. Events are numbered consecutively and each client remembers
+  // the number of the last event it has sent. Only the most recent events are buffered, so clients
+  // which cannot keep up miss some events. mLastState contains the state which has been sent last;
+  // new clients receive it as their first event.
+  struct Event {
+    uint64_t                  mId{};
+    std::string               mType;
+    std::string               mData;
+    spdlog::level::level_enum mLevel{};
+    std::string               mLogger;
+  };
+
+  std::mutex              mEventsMutex;
+  std::condition_variable mEventsChanged;
+  std::deque<Event>       mEvents;
+  uint64_t                mNextEventId  = 0;
+  bool                    mEventsClosed = false;
+  nlohmann::json          mLastState;
+  std::atomic<uint32_t>   mEventClients{0};
+
   // Members for the /save endpoint
   std::mutex              mSaveMutex;
   std::condition_variable mSaveDone;
   bool                    mSaveRequested = false;
-  std::string             mSaveSettings;
+  nlohmann::json          mSaveSettings;
 
-  // Members for the /load endpoint
-  std::mutex  mLoadMutex;
-  std::string mLoadSettings;
+  // Members for the /run-js, /run-js-batch and /load endpoints
+  struct Command {
+    CommandType        mType{};
+    std::string        mData;
+    std::promise<void> mDone;
+  };
 
-  // Members for the /run-js endpoint
-  std::mutex              mJavaScriptCallsMutex;
-  std::queue<std::string> mJavaScriptCalls;
+  std::mutex          mCommandsMutex;
+  std::queue<Command> mCommands;
+  bool                mCommandsClosed = false;
 
   int  mOnLoadConnection       = -1;
   int  mOnSaveConnection       = -1;
@@ -42,6 +42,7 @@ NLOHMANN_JSON_SERIALIZE_ENUM(
                                   {WebMapService::CacheMode::eAlways, "always"},
                                   {WebMapService::CacheMode::eUpdateSequence, "updateSequence"},
                                   {WebMapService::CacheMode::eNever, "never"},
+                                  {WebMapService::CacheMode::eRevalidate, "revalidate"},
                               })
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -83,6 +84,8 @@ void to_json(nlohmann::json& j, Plugin::Settings::Body const& o) {
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "preFetch", o.mPrefetchCount);
   cs::core::Settings::deserialize(j, "maxTextureSize", o.mMaxTextureSize);
+  cs::core::Settings::deserialize(j, "enableTiling", o.mEnableTiling);
+  cs::core::Settings::deserialize(j, "textureCacheSize", o.mTextureCacheSize);
   cs::core::Settings::deserialize(j, "mapCache", o.mMapCache);
   cs::core::Settings::deserialize(j, "capabilityCache", o.mCapabilityCache);
   cs::core::Settings::deserialize(j, "useCapabilityCache", o.mUseCapabilityCache);
@@ -92,6 +95,8 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "preFetch", o.mPrefetchCount);
   cs::core::Settings::serialize(j, "maxTextureSize", o.mMaxTextureSize);
+  cs::core::Settings::serialize(j, "enableTiling", o.mEnableTiling);
+  cs::core::Settings::serialize(j, "textureCacheSize", o.mTextureCacheSize);
   cs::core::Settings::serialize(j, "mapCache", o.mMapCache);
   cs::core::Settings::serialize(j, "capabilityCache", o.mCapabilityCache);
   cs::core::Settings::serialize(j, "useCapabilityCache", o.mUseCapabilityCache);
@@ -103,7 +108,11 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
 void Plugin::init() {
   logger().info("Loading plugin...");
 
-  mOnLoadConnection = mAllSettings->onLoad().connect([this]() { onLoad(); });
+  mOnLoadConnection = mAllSettings->onLoad().connect([this]() {
+    if (mAllSettings->hasPluginChangedOnLoad("csp-wms-overlays")) {
+      onLoad();
+    }
+  });
   mOnSaveConnection = mAllSettings->onSave().connect([this]() { onSave(); });
 
   mGuiManager->addPluginTabToSideBarFromHTML(
@@ -463,6 +472,17 @@ void Plugin::deInit() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Plugin::update() {
+  // Servers are added as soon as their capabilities are available.
+  std::vector<std::pair<std::string, WebMapService>> loadedWms;
+  {
+    std::unique_lock<std::mutex> lock(mWmsInsertMutex);
+    std::swap(loadedWms, mLoadedWms);
+  }
+
+  for (auto& [body, wms] : loadedWms) {
+    addWMSServer(body, std::move(wms));
+  }
+
   std::vector<std::string> finishedBodies;
   for (auto const& creationThreads : mWmsCreationThreads) {
     int running  = creationThreads.second.getRunningTaskCount();
@@ -532,19 +552,33 @@ void Plugin::onLoad() {
     }
 
     auto wmsOverlay = std::make_shared<TextureOverlayRenderer>(
-        settings.first, mSolarSystem, mTimeControl, mAllSettings, mPluginSettings);
+        settings.first, mSolarSystem, mTimeControl, mGraphicsEngine, mAllSettings, mPluginSettings);
 
     mWMSOverlays.emplace(settings.first, wmsOverlay);
 
     mWmsCreationThreads.emplace(settings.first, settings.second.mWms.size());
     mWmsCreationProgress.emplace(settings.first, 0);
     for (auto const& wmsUrl : settings.second.mWms) {
-      mWmsCreationThreads.at(settings.first).enqueue([this, settings, wmsUrl]() {
+      mWmsCreationThreads.at(settings.first).enqueue([this, body = settings.first, wmsUrl]() {
+        auto cacheMode = mPluginSettings->mUseCapabilityCache.get();
+        auto cacheDir  = mPluginSettings->mCapabilityCache.get();
+
         try {
-          WebMapService                wms(wmsUrl, mPluginSettings->mUseCapabilityCache.get(),
-              mPluginSettings->mCapabilityCache.get());
-          std::unique_lock<std::mutex> lock(mWmsInsertMutex);
-          mWms[settings.first].push_back(std::move(wms));
+          WebMapService wms(wmsUrl, cacheMode, cacheDir);
+          bool revalidate = cacheMode == WebMapService::CacheMode::eRevalidate && wms.isFromCache();
+
+          {
+            std::unique_lock<std::mutex> lock(mWmsInsertMutex);
+            mLoadedWms.emplace_back(body, std::move(wms));
+          }
+
+          // The cached capabilities are already shown, if they turn out to be outdated, the
+          // server is replaced.
+          if (revalidate && WebMapService::revalidateCache(wmsUrl, cacheDir)) {
+            WebMapService                updated(wmsUrl, cacheMode, cacheDir);
+            std::unique_lock<std::mutex> lock(mWmsInsertMutex);
+            mLoadedWms.emplace_back(body, std::move(updated));
+          }
         } catch (std::exception const& e) {
           logger().warn("Failed to parse capabilities for '{}': '{}'!", wmsUrl, e.what());
         }
@@ -570,6 +604,40 @@ Plugin::Settings::Body& Plugin::getBodySettings(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::addWMSServer(std::string const& bodyName, WebMapService wms) {
+  auto& servers = mWms[bodyName];
+  auto  server  = std::find_if(servers.begin(), servers.end(),
+      [&wms](WebMapService const& other) { return other.getUrl() == wms.getUrl(); });
+
+  bool replaced = server != servers.end();
+  if (replaced) {
+    server = servers.erase(server);
+  }
+  server = servers.emplace(server, std::move(wms));
+
+  auto overlay = mWMSOverlays.find(bodyName);
+  if (overlay == mWMSOverlays.end()) {
+    return;
+  }
+
+  auto const& settings = getBodySettings(overlay->second);
+  bool        active   = server->getTitle() == settings.mActiveServer.get();
+
+  if (isActiveOverlay(overlay->second) && !replaced) {
+    mGuiManager->getGui()->callJavascript("CosmoScout.gui.addDropdownValue",
+        "wmsOverlays.setServer", server->getTitle(), server->getTitle(), active);
+  }
+
+  // The configured server is activated right away, so its layers are available before all other
+  // servers have been loaded. Revalidated capabilities replace the active server.
+  auto const& activeServer = mActiveServers[bodyName];
+  if (active && (!activeServer || replaced)) {
+    setWMSServer(overlay->second, server->getTitle());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::initOverlay(std::string const& bodyName, Settings::Body& settings) {
   auto overlay = mWMSOverlays.at(bodyName);
 
@@ -16,8 +16,11 @@
 #include "../../../src/cs-utils/ThreadPool.hpp"
 
 #include <chrono>
+#include <list>
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace csp::wmsoverlays {
 
@@ -58,6 +61,15 @@ class Plugin : public cs::core::PluginBase {
     /// available in certain sizes, those won't be influenced by this setting.
     cs::utils::DefaultProperty<int> mMaxTextureSize{1024};
 
+    /// Specifies whether time-independent layers are loaded as a quadtree of tiles. Only the tiles
+    /// which are visible are requested, at a level matching mMaxTextureSize. Layers which do not
+    /// allow subsets or have a fixed size are always loaded as a single texture.
+    cs::utils::DefaultProperty<bool> mEnableTiling{true};
+
+    /// The maximum amount of memory in megabytes which is used for the textures of time-dependent
+    /// layers. If more textures are loaded, the least recently used ones are discarded.
+    cs::utils::DefaultProperty<int> mTextureCacheSize{512};
+
     /// If automatic bounds update is enabled, the bounds will be updated when the observer stopped
     /// moving for this amount of milliseconds.
     cs::utils::DefaultProperty<int> mUpdateBoundsDelay{1000};
@@ -93,6 +105,9 @@ class Plugin : public cs::core::PluginBase {
 
   void initOverlay(std::string const& bodyName, Settings::Body& settings);
 
+  /// Adds a server whose capabilities have been loaded. A server with the same URL is replaced.
+  void addWMSServer(std::string const& bodyName, WebMapService wms);
+
   void setWMSServer(
       std::shared_ptr<TextureOverlayRenderer> const& wmsOverlay, std::string const& name);
   void resetWMSServer(std::shared_ptr<TextureOverlayRenderer> const& wmsOverlay);
@@ -124,7 +139,11 @@ class Plugin : public cs::core::PluginBase {
   std::map<std::string, cs::utils::ThreadPool> mWmsCreationThreads;
   std::map<std::string, int>                   mWmsCreationProgress;
   std::map<std::string, std::shared_ptr<TextureOverlayRenderer>> mWMSOverlays;
-  std::map<std::string, std::vector<WebMapService>>              mWms;
+  std::map<std::string, std::list<WebMapService>>                mWms;
+
+  /// Servers which have been loaded by the creation threads since the last update(). They are
+  /// protected by mWmsInsertMutex.
+  std::vector<std::pair<std::string, WebMapService>> mLoadedWms;
 
   std::shared_ptr<TextureOverlayRenderer> mActiveOverlay;
   /// The currently active WebMapService for each center name.
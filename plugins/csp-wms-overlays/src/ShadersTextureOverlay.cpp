@@ -52,7 +52,7 @@ const std::string TextureOverlayRenderer::SURFACE_VERT = R"(
 const std::string TextureOverlayRenderer::SURFACE_FRAG = R"(
     out vec4 FragColor;
 
-    uniform sampler2DRect uDepthBuffer;
+    uniform sampler2D uDepthBuffer;
     uniform sampler2D     uFirstTexture;
     uniform sampler2D     uSecondTexture;
 
@@ -60,6 +60,15 @@ const std::string TextureOverlayRenderer::SURFACE_FRAG = R"(
     uniform bool          uUseFirstTexture;
     uniform bool          uUseSecondTexture;
 
+    // Each tile is described by its bounds in radians (minLon, maxLon, minLat, maxLat) and its
+    // size in pixels and layer in uTiles. The tiles are sorted by level, finest first.
+    uniform sampler2DArray uTiles;
+    uniform bool          uUseTiles;
+    uniform int           uTileCount;
+    uniform float         uTileSize;
+    uniform vec4          uTileBounds[MAX_TILES];
+    uniform vec3          uTileInfos[MAX_TILES];
+
     uniform dmat4         uMatInvMVP;
 
     uniform dvec2         uLonRange;
@@ -104,8 +113,7 @@ const std::string TextureOverlayRenderer::SURFACE_FRAG = R"(
     // ===========================================================================
     void main()
     {
-        vec2  vTexcoords = texcoord*textureSize(uDepthBuffer);
-        float fDepth     = texture(uDepthBuffer, vTexcoords).r;
+        float fDepth = texture(uDepthBuffer, texcoord).r;
 
         if (fDepth == 1.0) 
         {
@@ -122,7 +130,27 @@ const std::string TextureOverlayRenderer::SURFACE_FRAG = R"(
                 vec2 newCoords = vec2(float(norm_u), float(1.0 - norm_v));
 
                 vec4 color = vec4(0.);
-                if (uUseFirstTexture) {
+                if (uUseTiles) {
+                  int i = 0;
+                  while (i < uTileCount && (lnglat.x < uTileBounds[i].x ||
+                         lnglat.x > uTileBounds[i].y || lnglat.y < uTileBounds[i].z ||
+                         lnglat.y > uTileBounds[i].w)) {
+                    ++i;
+                  }
+
+                  if (i == uTileCount) {
+                    discard;
+                  }
+
+                  vec4 b      = uTileBounds[i];
+                  vec2 size   = uTileInfos[i].xy;
+                  vec2 tileUV = vec2((lnglat.x - b.x) / (b.y - b.x),
+                                     1.0 - (lnglat.y - b.z) / (b.w - b.z));
+
+                  // The tile only covers the first size.x * size.y texels of its layer.
+                  tileUV = clamp(tileUV * size, vec2(0.5), size - 0.5) / uTileSize;
+                  color  = texture(uTiles, vec3(tileUV, uTileInfos[i].z));
+                } else if (uUseFirstTexture) {
                   color = texture(uFirstTexture, newCoords);
 
                   // Fade second texture in.
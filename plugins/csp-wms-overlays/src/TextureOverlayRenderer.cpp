@@ -10,9 +10,11 @@
 
 #include "logger.hpp"
 
+#include "../../../src/cs-core/GraphicsEngine.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-core/TimeControl.hpp"
+#include "../../../src/cs-graphics/FramebufferCopy.hpp"
 #include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-scene/IntersectableObject.hpp"
 #include "../../../src/cs-utils/utils.hpp"
@@ -37,15 +39,39 @@
 #include <functional>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 namespace csp::wmsoverlays {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// The length of the longer side of each tile in pixels.
+int const tileSize = 256;
+
+// The number of tiles which can be kept in GPU memory at the same time.
+int const maxTileCount = 128;
+
+// The maximum number of tiles which can be drawn in one frame. This has to be less than
+// maxTileCount, so that there are always tiles which can be replaced.
+int const maxDrawnTiles = 64;
+
+// The finest level of the quadtree.
+int const maxTileLevel = 16;
+
+// The maximum number of tile requests which are pending at the same time.
+std::size_t const maxPendingTiles = 16;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 TextureOverlayRenderer::TextureOverlayRenderer(std::string objectName,
     std::shared_ptr<cs::core::SolarSystem>                 solarSystem,
     std::shared_ptr<cs::core::TimeControl>                 timeControl,
+    std::shared_ptr<cs::core::GraphicsEngine>              graphicsEngine,
     std::shared_ptr<cs::core::Settings> settings, std::shared_ptr<Plugin::Settings> pluginSettings)
     : mSettings(std::move(settings))
     , mPluginSettings(std::move(pluginSettings))
@@ -53,27 +79,13 @@ TextureOverlayRenderer::TextureOverlayRenderer(std::string objectName,
     , mWMSTexture(GL_TEXTURE_2D)
     , mSecondWMSTexture(GL_TEXTURE_2D)
     , mSolarSystem(std::move(solarSystem))
-    , mTimeControl(std::move(timeControl)) {
+    , mTimeControl(std::move(timeControl))
+    , mGraphicsEngine(std::move(graphicsEngine)) {
 
   auto object = mSolarSystem->getObject(mObjectName);
   mMinBounds  = -object->getRadii();
   mMaxBounds  = object->getRadii();
 
-  // create textures ---------------------------------------------------------
-  for (auto const& viewport : GetVistaSystem()->GetDisplayManager()->GetViewports()) {
-    // Texture for previous renderer depth buffer
-    const auto [buffer, success] =
-        mDepthBufferData.try_emplace(viewport.second, GL_TEXTURE_RECTANGLE);
-    if (success) {
-      buffer->second.Bind();
-      buffer->second.SetWrapS(GL_CLAMP);
-      buffer->second.SetWrapT(GL_CLAMP);
-      buffer->second.SetMinFilter(GL_NEAREST);
-      buffer->second.SetMagFilter(GL_NEAREST);
-      buffer->second.Unbind();
-    }
-  }
-
   mWMSTexture.Bind();
   mWMSTexture.SetWrapS(GL_CLAMP_TO_EDGE);
   mWMSTexture.SetWrapT(GL_CLAMP_TO_EDGE);
@@ -90,6 +102,11 @@ TextureOverlayRenderer::TextureOverlayRenderer(std::string objectName,
       mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::ePlanets) + 10);
 
   pBounds.connect([this](Bounds const& value) {
+    // Tiles are selected for the new bounds in the next frame, cached tiles remain valid.
+    if (useTiles()) {
+      return;
+    }
+
     clearTextures();
     if (mActiveWMSLayer->getSettings().mTimeIntervals.empty()) {
       WebMapTextureLoader::Request request = getRequest();
@@ -99,6 +116,10 @@ TextureOverlayRenderer::TextureOverlayRenderer(std::string objectName,
   });
 
   mPluginSettings->mMaxTextureSize.connect([this](int value) {
+    if (useTiles()) {
+      return;
+    }
+
     clearTextures();
     if (mActiveWMSLayer->getSettings().mTimeIntervals.empty()) {
       WebMapTextureLoader::Request request = getRequest();
@@ -121,6 +142,7 @@ TextureOverlayRenderer::~TextureOverlayRenderer() {
   mSettings->mGraphics.pEnableHDR.disconnect(mHDRConnection);
 
   clearTextures();
+  glDeleteTextures(1, &mTileArray);
 
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   pSG->GetRoot()->DisconnectChild(mGLNode.get());
@@ -187,10 +209,61 @@ void TextureOverlayRenderer::setStyle(std::string style) {
 void TextureOverlayRenderer::clearTextures() {
   mTextures.clear();
   mTexturesBuffer.clear();
+  mTextureBytes = 0;
   mWrongTextures.clear();
 
   mCurrentTexture       = "";
   mCurrentSecondTexture = "";
+
+  clearTiles();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TextureOverlayRenderer::getTextureBytes(WebMapTexture const& texture) {
+  // The textures are always loaded with four channels.
+  return static_cast<std::size_t>(texture.mWidth) * static_cast<std::size_t>(texture.mHeight) * 4;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextureOverlayRenderer::evictTextures() {
+  std::size_t budget =
+      static_cast<std::size_t>(std::max(mPluginSettings->mTextureCacheSize.get(), 0)) * 1024 * 1024;
+
+  // The textures which have been used in this frame are never evicted, so the budget may be
+  // exceeded if it is smaller than the pre-fetch range.
+  while (mTextureBytes > budget) {
+    auto lru = mTextures.end();
+    for (auto it = mTextures.begin(); it != mTextures.end(); ++it) {
+      if (it->second.mLastUsed < mFrameCount && it->first != mCurrentTexture &&
+          it->first != mCurrentSecondTexture &&
+          (lru == mTextures.end() || it->second.mLastUsed < lru->second.mLastUsed)) {
+        lru = it;
+      }
+    }
+
+    if (lru == mTextures.end()) {
+      break;
+    }
+
+    mTextureBytes -= getTextureBytes(lru->second.mTexture);
+    mTextures.erase(lru);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextureOverlayRenderer::clearTiles() {
+  mTiles.clear();
+  mTilesBuffer.clear();
+  mWrongTiles.clear();
+  mDrawnTiles.clear();
+
+  mFreeTileLayers.clear();
+  for (int i = maxTileCount - 1; i >= 0; --i) {
+    mFreeTileLayers.push_back(i);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -353,6 +426,11 @@ WebMapTextureLoader::Request TextureOverlayRenderer::getRequest() {
 
 void TextureOverlayRenderer::getTimeIndependentTexture(
     WebMapTextureLoader::Request const& request) {
+  if (useTiles()) {
+    mWMSTextureUsed = false;
+    return;
+  }
+
   if (mActiveWMSLayer && mActiveWMSLayer->isRequestable()) {
     std::optional<WebMapTexture> texture = mTextureLoader.loadTexture(*mActiveWMS, *mActiveWMSLayer,
         request, mPluginSettings->mMapCache.get(),
@@ -368,6 +446,129 @@ void TextureOverlayRenderer::getTimeIndependentTexture(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool TextureOverlayRenderer::useTiles() const {
+  if (!mPluginSettings->mEnableTiling.get() || !mActiveWMS || !mActiveWMSLayer ||
+      !mActiveWMSLayer->isRequestable()) {
+    return false;
+  }
+
+  auto const& settings = mActiveWMSLayer->getSettings();
+  return settings.mTimeIntervals.empty() && !settings.mNoSubsets && !settings.mFixedWidth &&
+         !settings.mFixedHeight;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextureOverlayRenderer::updateTiles() {
+  if (mTileArray == 0) {
+    glGenTextures(1, &mTileArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTileArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tileSize, tileSize, maxTileCount, 0, GL_RGBA,
+        GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    clearTiles();
+  }
+
+  // Upload all tiles which have been loaded since the last frame. If the texture array is full,
+  // the least recently used tile is replaced. The tile of level zero is never replaced, as it is
+  // drawn wherever no finer tile is available.
+  auto tileIt = mTilesBuffer.begin();
+  while (tileIt != mTilesBuffer.end()) {
+    if (tileIt->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      ++tileIt;
+      continue;
+    }
+
+    std::optional<WebMapTexture> texture = tileIt->second.get();
+
+    if (!texture || texture->mWidth > tileSize || texture->mHeight > tileSize) {
+      mWrongTiles.insert(tileIt->first);
+      tileIt = mTilesBuffer.erase(tileIt);
+      continue;
+    }
+
+    if (mFreeTileLayers.empty()) {
+      auto lru = mTiles.end();
+      for (auto it = mTiles.begin(); it != mTiles.end(); ++it) {
+        if (it->first.mLevel > 0 &&
+            (lru == mTiles.end() || it->second.mLastUsed < lru->second.mLastUsed)) {
+          lru = it;
+        }
+      }
+      mFreeTileLayers.push_back(lru->second.mLayer);
+      mTiles.erase(lru);
+    }
+
+    int layer = mFreeTileLayers.back();
+    mFreeTileLayers.pop_back();
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTileArray);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, texture->mWidth, texture->mHeight, 1,
+        GL_RGBA, GL_UNSIGNED_BYTE, texture->mData.get());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    mTiles[tileIt->first] = {layer, texture->mWidth, texture->mHeight, mFrameCount};
+    tileIt                = mTilesBuffer.erase(tileIt);
+  }
+
+  // Select the tiles for the current bounds. If there are too many, a coarser level is used.
+  Bounds const& layerBounds = mActiveWMSLayer->getSettings().mBounds;
+  int           level       = getTileLevel(
+      pBounds.get(), layerBounds, tileSize, mPluginSettings->mMaxTextureSize.get(), maxTileLevel);
+  std::vector<WebMapTileId> requiredTiles = getTilesInBounds(level, pBounds.get(), layerBounds);
+
+  while (level > 0 && requiredTiles.size() > static_cast<std::size_t>(maxDrawnTiles)) {
+    requiredTiles = getTilesInBounds(--level, pBounds.get(), layerBounds);
+  }
+
+  // Each required tile which is not loaded yet is replaced by its closest loaded ancestor.
+  std::set<WebMapTileId> drawnTiles;
+  for (auto tile : requiredTiles) {
+    while (tile.mLevel > 0 && mTiles.find(tile) == mTiles.end()) {
+      tile = tile.getParent();
+    }
+
+    auto it = mTiles.find(tile);
+    if (it != mTiles.end()) {
+      it->second.mLastUsed = mFrameCount;
+      drawnTiles.insert(tile);
+    }
+  }
+
+  mDrawnTiles.assign(drawnTiles.begin(), drawnTiles.end());
+  std::sort(mDrawnTiles.begin(), mDrawnTiles.end(),
+      [](WebMapTileId const& a, WebMapTileId const& b) { return a.mLevel > b.mLevel; });
+
+  // Request the missing tiles. The tile of level zero is requested first.
+  requiredTiles.insert(requiredTiles.begin(), WebMapTileId{});
+
+  for (auto const& tile : requiredTiles) {
+    if (mTilesBuffer.size() >= maxPendingTiles) {
+      break;
+    }
+
+    if (mTiles.count(tile) > 0 || mTilesBuffer.count(tile) > 0 || mWrongTiles.count(tile) > 0) {
+      continue;
+    }
+
+    WebMapTextureLoader::Request request;
+    request.mMaxSize = tileSize;
+    request.mStyle   = mStyle;
+    request.mBounds  = getTileBounds(tile, layerBounds);
+    request.mTile    = tile;
+
+    mTilesBuffer.emplace(tile, mTextureLoader.loadTextureAsync(*mActiveWMS, *mActiveWMSLayer,
+                                   request, mPluginSettings->mMapCache.get(), true));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TextureOverlayRenderer::requestUpdateBounds() {
   mUpdateLonLatRange = true;
 }
@@ -393,6 +594,8 @@ bool TextureOverlayRenderer::Do() {
       defines += "#define ENABLE_LIGHTING\n";
     }
 
+    defines += "#define MAX_TILES " + std::to_string(maxDrawnTiles) + "\n";
+
     mShader.InitGeometryShaderFromString(SURFACE_GEOM);
     mShader.InitVertexShaderFromString(SURFACE_VERT);
     mShader.InitFragmentShaderFromString(defines + SURFACE_FRAG);
@@ -407,15 +610,30 @@ bool TextureOverlayRenderer::Do() {
     return false;
   }
 
+  ++mFrameCount;
+
+  bool tiled = useTiles();
+
+  if (tiled) {
+    updateTiles();
+  }
+
   if (mActiveWMSLayer && !mActiveWMSLayer->getSettings().mTimeIntervals.empty()) {
     // Get the current time. Pre-fetch times are related to this.
     boost::posix_time::ptime time =
         cs::utils::convert::time::toPosix(mTimeControl->pSimulationTime.get());
 
     // Select WMS textures to be downloaded. If no pre-fetch is set, only sellect the texture for
-    // the current timestep.
-    for (int preFetch = -mPluginSettings->mPrefetchCount.get();
-         preFetch <= mPluginSettings->mPrefetchCount.get(); preFetch++) {
+    // the current timestep. Textures are only pre-fetched in the direction in which time passes,
+    // if time is paused, both directions are pre-fetched. The following sample is always required
+    // for interpolation.
+    int   prefetchCount = mPluginSettings->mPrefetchCount.get();
+    float timeSpeed     = mSettings->pTimeSpeed.get();
+    int   firstSample   = timeSpeed > 0.F ? 0 : -prefetchCount;
+    int   lastSample    = timeSpeed < 0.F ? std::min(prefetchCount, 1) : prefetchCount;
+    bool  scrubbing     = mTimeControl->pIsScrubbing.get();
+
+    for (int preFetch = firstSample; preFetch <= lastSample; preFetch++) {
 
       // Get the start time of the WMS sample.
       boost::posix_time::ptime sampleStartTime =
@@ -431,9 +649,15 @@ bool TextureOverlayRenderer::Do() {
       auto loadedTexture    = mTextures.find(timeString);
       auto wrongTexture     = std::find(mWrongTextures.begin(), mWrongTextures.end(), timeString);
 
-      // Only load textures that aren't stored yet.
+      // Textures in the pre-fetch range are the last to be evicted from the cache.
+      if (loadedTexture != mTextures.end()) {
+        loadedTexture->second.mLastUsed = mFrameCount;
+      }
+
+      // Only load textures that aren't stored yet. While the user scrubs through time, only
+      // cached textures are shown, the missing ones are requested once the user stops.
       if (requestedTexture == mTexturesBuffer.end() && loadedTexture == mTextures.end() &&
-          wrongTexture == mWrongTextures.end() && inInterval) {
+          wrongTexture == mWrongTextures.end() && inInterval && !scrubbing) {
         // Load WMS texture.
         WebMapTextureLoader::Request request;
         request.mMaxSize = mPluginSettings->mMaxTextureSize.get();
@@ -455,8 +679,8 @@ bool TextureOverlayRenderer::Do() {
         std::optional<WebMapTexture> texture = texIt->second.get();
 
         if (texture.has_value()) {
-          mTextures.insert(
-              std::pair<std::string, WebMapTexture>(texIt->first, std::move(texture.value())));
+          mTextureBytes += getTextureBytes(texture.value());
+          mTextures.emplace(texIt->first, CachedTexture{std::move(texture.value()), mFrameCount});
         } else {
           mWrongTextures.emplace_back(texIt->first);
         }
@@ -467,6 +691,8 @@ bool TextureOverlayRenderer::Do() {
       }
     }
 
+    evictTextures();
+
     // Get the current time.
     time = cs::utils::convert::time::toPosix(mTimeControl->pSimulationTime.get());
     boost::posix_time::ptime sampleStartTime =
@@ -485,8 +711,8 @@ bool TextureOverlayRenderer::Do() {
       // Only update if we have a new texture.
       if (mCurrentTexture != timeString) {
         mWMSTextureUsed = true;
-        mWMSTexture.UploadTexture(
-            tex->second.mWidth, tex->second.mHeight, tex->second.mData.get(), false);
+        mWMSTexture.UploadTexture(tex->second.mTexture.mWidth, tex->second.mTexture.mHeight,
+            tex->second.mTexture.mData.get(), false);
         mCurrentTexture = timeString;
       }
     } // Use default planet texture instead.
@@ -512,8 +738,8 @@ bool TextureOverlayRenderer::Do() {
       if (isAfterInInterval && tex != mTextures.end()) {
         // Only update if we ha a new second texture.
         if (mCurrentSecondTexture != utils::timeToString(mCurrentInterval.mFormat, sampleAfter)) {
-          mSecondWMSTexture.UploadTexture(
-              tex->second.mWidth, tex->second.mHeight, tex->second.mData.get(), false);
+          mSecondWMSTexture.UploadTexture(tex->second.mTexture.mWidth,
+              tex->second.mTexture.mHeight, tex->second.mTexture.mData.get(), false);
           mCurrentSecondTexture = utils::timeToString(mCurrentInterval.mFormat, sampleAfter);
           mSecondWMSTextureUsed = true;
         }
@@ -533,16 +759,10 @@ bool TextureOverlayRenderer::Do() {
   glDepthMask(GL_FALSE);
   glEnable(GL_BLEND);
 
-  // copy depth buffer from previous rendering
-  std::array<GLint, 4> iViewport{};
-  glGetIntegerv(GL_VIEWPORT, iViewport.data());
-
-  auto* viewport = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
-  VistaTexture& depthBuffer = mDepthBufferData.at(viewport);
-
-  depthBuffer.Bind();
-  glCopyTexImage2D(GL_TEXTURE_RECTANGLE, 0, GL_DEPTH_COMPONENT, iViewport[0], iViewport[1],
-      iViewport[2], iViewport[3], 0);
+  // get the depth buffer from previous rendering, all overlays share the same copy
+  VistaTexture* depthBuffer = mGraphicsEngine->getFramebufferCopy()->get(
+      cs::graphics::FramebufferCopy::Attachment::eDepth,
+      static_cast<int>(cs::utils::DrawOrder::ePlanets) + 10);
 
   auto object    = mSolarSystem->getObject(mObjectName);
   auto radii     = object->getRadii();
@@ -562,7 +782,7 @@ bool TextureOverlayRenderer::Do() {
   mShader.Bind();
 
   // Only bind the enabled textures.
-  depthBuffer.Bind(GL_TEXTURE0);
+  depthBuffer->Bind(GL_TEXTURE0);
   if (mWMSTextureUsed) {
     mWMSTexture.Bind(GL_TEXTURE1);
 
@@ -582,15 +802,44 @@ bool TextureOverlayRenderer::Do() {
   GLint loc = mShader.GetUniformLocation("uMatInvMVP");
   glUniformMatrix4dv(loc, 1, GL_FALSE, glm::value_ptr(matInvMVP));
 
-  // Double precision bounds
-  loc = mShader.GetUniformLocation("uLatRange");
+  // Double precision bounds. Tiles cover the entire layer.
+  Bounds bounds = tiled ? mActiveWMSLayer->getSettings().mBounds : getBounds();
+  loc           = mShader.GetUniformLocation("uLatRange");
   glUniform2dv(loc, 1,
-      glm::value_ptr(
-          cs::utils::convert::toRadians(glm::dvec2(getBounds().mMinLat, getBounds().mMaxLat))));
+      glm::value_ptr(cs::utils::convert::toRadians(glm::dvec2(bounds.mMinLat, bounds.mMaxLat))));
   loc = mShader.GetUniformLocation("uLonRange");
   glUniform2dv(loc, 1,
-      glm::value_ptr(
-          cs::utils::convert::toRadians(glm::dvec2(getBounds().mMinLon, getBounds().mMaxLon))));
+      glm::value_ptr(cs::utils::convert::toRadians(glm::dvec2(bounds.mMinLon, bounds.mMaxLon))));
+
+  mShader.SetUniform(mShader.GetUniformLocation("uUseTiles"), tiled);
+
+  if (tiled) {
+    std::vector<glm::vec4> tileBounds;
+    std::vector<glm::vec3> tileInfos;
+
+    for (auto const& id : mDrawnTiles) {
+      Bounds      b    = getTileBounds(id, mActiveWMSLayer->getSettings().mBounds);
+      Tile const& tile = mTiles.at(id);
+      tileBounds.emplace_back(cs::utils::convert::toRadians(
+          glm::dvec4(b.mMinLon, b.mMaxLon, b.mMinLat, b.mMaxLat)));
+      tileInfos.emplace_back(tile.mWidth, tile.mHeight, tile.mLayer);
+    }
+
+    auto count = static_cast<GLsizei>(mDrawnTiles.size());
+    mShader.SetUniform(mShader.GetUniformLocation("uTileCount"), static_cast<int>(count));
+    mShader.SetUniform(mShader.GetUniformLocation("uTileSize"), static_cast<float>(tileSize));
+    mShader.SetUniform(mShader.GetUniformLocation("uTiles"), 3);
+
+    if (count > 0) {
+      glUniform4fv(mShader.GetUniformLocation("uTileBounds"), count,
+          glm::value_ptr(tileBounds.front()));
+      glUniform3fv(
+          mShader.GetUniformLocation("uTileInfos"), count, glm::value_ptr(tileInfos.front()));
+    }
+
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTileArray);
+  }
 
   glm::vec3 sunDirection(1, 0, 0);
   float     sunIlluminance(1.F);
@@ -632,7 +881,13 @@ bool TextureOverlayRenderer::Do() {
   // Dummy draw
   glDrawArrays(GL_POINTS, 0, 1);
 
-  depthBuffer.Unbind(GL_TEXTURE0);
+  if (tiled) {
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+  }
+
+  depthBuffer->Unbind(GL_TEXTURE0);
   if (mWMSTextureUsed) {
     mWMSTexture.Unbind(GL_TEXTURE1);
 
@@ -12,6 +12,7 @@
 #include "WebMapLayer.hpp"
 #include "WebMapService.hpp"
 #include "WebMapTextureLoader.hpp"
+#include "WebMapTile.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 #include <VistaMath/VistaBoundingBox.h>
@@ -21,6 +22,8 @@
 #include <array>
 #include <functional>
 #include <future>
+#include <map>
+#include <set>
 #include <unordered_map>
 
 // FORWARD DEFINITIONS
@@ -33,20 +36,23 @@ namespace cs::core {
 class SolarSystem;
 class TimeControl;
 class Settings;
+class GraphicsEngine;
 } // namespace cs::core
 
 namespace csp::wmsoverlays {
 
 /// Class which gets a geo-referenced texture and overlays if onto the previous rendered scene.
-/// Therefore it copies the depth buffer first. Second, in the shader it does an inverse projection
-/// to get the cartesian coordinates. This coordinates are transformed to latitude and longitude to
-/// do the lookup in the geo-referenced texture. The value is then overlayed on that pixel position.
+/// Therefore it uses the shared copy of the depth buffer provided by the GraphicsEngine first.
+/// Second, in the shader it does an inverse projection to get the cartesian coordinates. This
+/// coordinates are transformed to latitude and longitude to do the lookup in the geo-referenced
+/// texture. The value is then overlayed on that pixel position.
 class TextureOverlayRenderer : public IVistaOpenGLDraw {
  public:
   TextureOverlayRenderer(std::string objectName, std::shared_ptr<cs::core::SolarSystem> solarSystem,
-      std::shared_ptr<cs::core::TimeControl> timeControl,
-      std::shared_ptr<cs::core::Settings>    settings,
-      std::shared_ptr<Plugin::Settings>      pluginSettings);
+      std::shared_ptr<cs::core::TimeControl>    timeControl,
+      std::shared_ptr<cs::core::GraphicsEngine> graphicsEngine,
+      std::shared_ptr<cs::core::Settings>       settings,
+      std::shared_ptr<Plugin::Settings>         pluginSettings);
   ~TextureOverlayRenderer() override;
 
   /// Returns the SPICE name of the body to which this renderer is assigned.
@@ -93,6 +99,23 @@ class TextureOverlayRenderer : public IVistaOpenGLDraw {
   /// Synchronously loads a texture for a time-independent map.
   void getTimeIndependentTexture(WebMapTextureLoader::Request const& request);
 
+  /// Returns true if the active layer is displayed with tiles instead of a single texture.
+  bool useTiles() const;
+
+  /// Uploads all tiles which have been loaded, selects the tiles which are drawn in this frame and
+  /// requests missing tiles for the current bounds.
+  void updateTiles();
+
+  /// Removes all tiles.
+  void clearTiles();
+
+  /// Removes the least recently used textures of time-dependent layers until the total size of the
+  /// loaded textures is below mTextureCacheSize.
+  void evictTextures();
+
+  /// Returns the size of the pixel data of the given texture in bytes.
+  static std::size_t getTextureBytes(WebMapTexture const& texture);
+
   std::shared_ptr<cs::core::Settings> mSettings;
   std::shared_ptr<Plugin::Settings>   mPluginSettings;
   Plugin::Settings::Body              mSimpleWMSOverlaySettings;
@@ -110,16 +133,42 @@ class TextureOverlayRenderer : public IVistaOpenGLDraw {
   /// Code for the fragment shader
   static const std::string SURFACE_FRAG;
 
-  /// Store one buffer per viewport
-  std::unordered_map<VistaViewport*, VistaTexture> mDepthBufferData;
-
   /// Stores all textures, for which the request ist still pending.
   std::map<std::string, std::future<std::optional<WebMapTexture>>> mTexturesBuffer;
+  struct CachedTexture {
+    WebMapTexture mTexture;
+    uint64_t      mLastUsed; ///< The last frame in which the texture was in the pre-fetch range.
+  };
+
   /// Stores all successfully loaded textures.
-  std::map<std::string, WebMapTexture> mTextures;
+  std::map<std::string, CachedTexture> mTextures;
+  /// The total size of all textures in mTextures.
+  std::size_t mTextureBytes = 0;
   /// Stores textures, for which loading failed.
   std::vector<std::string> mWrongTextures;
 
+  struct Tile {
+    int      mLayer;    ///< The layer of mTileArray containing the tile.
+    int      mWidth;    ///< The size of the tile in pixels.
+    int      mHeight;   ///< The size of the tile in pixels.
+    uint64_t mLastUsed; ///< The last frame in which the tile was drawn.
+  };
+
+  /// Stores all tiles, for which the request is still pending.
+  std::map<WebMapTileId, std::future<std::optional<WebMapTexture>>> mTilesBuffer;
+  /// Stores all tiles which have been uploaded to mTileArray.
+  std::map<WebMapTileId, Tile> mTiles;
+  /// Stores tiles, for which loading failed.
+  std::set<WebMapTileId> mWrongTiles;
+  /// The tiles which are drawn in this frame, finest level first.
+  std::vector<WebMapTileId> mDrawnTiles;
+  /// The layers of mTileArray which are not used by any tile.
+  std::vector<int> mFreeTileLayers;
+  /// A texture array containing all loaded tiles.
+  uint32_t mTileArray = 0;
+  /// Used for determining the least recently used tiles and textures.
+  uint64_t mFrameCount = 0;
+
   /// Name of the currently active style.
   std::string mStyle;
 
@@ -151,8 +200,9 @@ class TextureOverlayRenderer : public IVistaOpenGLDraw {
   /// Loader used to request map textures.
   WebMapTextureLoader mTextureLoader;
 
-  std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
-  std::shared_ptr<cs::core::TimeControl> mTimeControl;
+  std::shared_ptr<cs::core::SolarSystem>    mSolarSystem;
+  std::shared_ptr<cs::core::TimeControl>    mTimeControl;
+  std::shared_ptr<cs::core::GraphicsEngine> mGraphicsEngine;
 
   /// Lower Corner of the bounding volume for the planet.
   glm::vec3 mMinBounds;
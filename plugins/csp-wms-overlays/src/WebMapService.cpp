@@ -9,25 +9,40 @@
 #include "WebMapException.hpp"
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/HttpClient.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
 #include <regex>
 
+#include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
-#include <curlpp/Easy.hpp>
-#include <curlpp/Options.hpp>
 
 namespace csp::wmsoverlays {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Returns the value of the ETag header of the given response, if there is one.
+std::optional<std::string> getETag(cs::utils::HttpClient::Response const& response) {
+  auto it = response.mHeaders.find("etag");
+  if (it == response.mHeaders.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 WebMapService::WebMapService(std::string url, CacheMode cacheMode, std::string cacheDir)
     : mUrl(std::move(url))
     , mCacheMode(cacheMode)
     , mCacheDir(std::move(cacheDir))
-    , mCacheFileName(std::regex_replace(mUrl, std::regex("[/:*]"), "_") + ".xml")
+    , mCacheFileName(getCacheFileName(mUrl))
     , mTitle(parseTitle())
     , mSettings(parseSettings())
     , mMapFormats(parseMapFormats())
@@ -86,6 +101,82 @@ bool WebMapService::isFormatSupported(std::string const& format) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool WebMapService::isFromCache() const {
+  return mFromCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool WebMapService::revalidateCache(std::string const& url, std::string const& cacheDir) {
+  boost::filesystem::path cacheFilePath(
+      boost::filesystem::path(cacheDir) / boost::filesystem::path(getCacheFileName(url)));
+  std::string etagFile = cacheFilePath.string() + ".etag";
+
+  if (!boost::filesystem::exists(cacheFilePath)) {
+    return false;
+  }
+
+  // The server only sends the document if it has changed since it was cached. Servers which do
+  // not support ETags may still support the modification time.
+  cs::utils::HttpClient::Request request;
+  request.mUrl             = getGetCapabilitiesUrl(url).str();
+  request.mIfModifiedSince = boost::filesystem::last_write_time(cacheFilePath);
+  if (boost::filesystem::exists(etagFile)) {
+    request.mHeaders.push_back("If-None-Match: " + cs::utils::filesystem::loadToString(etagFile));
+  }
+
+  cs::utils::HttpClient::Response response;
+  try {
+    response = cs::utils::HttpClient::get().perform(request);
+  } catch (std::exception const& e) {
+    logger().warn("Failed to revalidate cached capabilities for '{}': '{}'!", url, e.what());
+    return false;
+  }
+
+  long responseCode = response.mResponseCode;
+  if (responseCode == 304) {
+    logger().debug("Cached capabilities for '{}' are up to date.", url);
+    return false;
+  }
+
+  if (responseCode != 200) {
+    logger().warn("Failed to revalidate cached capabilities for '{}': Received response code {}!",
+        url, responseCode);
+    return false;
+  }
+
+  std::string const&         docString = response.mBody;
+  std::optional<std::string> etag      = getETag(response);
+
+  // Some servers ignore the conditions and always send the full document.
+  if (docString == cs::utils::filesystem::loadToString(cacheFilePath.string())) {
+    return false;
+  }
+
+  VistaXML::TiXmlDocument doc;
+  doc.Parse(docString.c_str());
+  if (doc.Error() || doc.FirstChildElement("WMS_Capabilities") == nullptr) {
+    logger().warn("Failed to revalidate cached capabilities for '{}': Received an invalid "
+                  "capabilities document!",
+        url);
+    return false;
+  }
+
+  cs::utils::filesystem::writeStringToFile(cacheFilePath.string(), docString);
+
+  if (etag) {
+    cs::utils::filesystem::writeStringToFile(etagFile, *etag);
+  } else if (boost::filesystem::exists(etagFile)) {
+    boost::filesystem::remove(etagFile);
+  }
+
+  logger().info("Updated cached capabilities for '{}'.", url);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 VistaXML::TiXmlElement* WebMapService::getCapabilities() {
   if (!mDoc.has_value()) {
     std::optional<std::string> docString;
@@ -93,11 +184,13 @@ VistaXML::TiXmlElement* WebMapService::getCapabilities() {
 
     // Check cache for capability document according to cache mode
     switch (mCacheMode) {
-    case CacheMode::eAlways: {
+    case CacheMode::eAlways:
+    case CacheMode::eRevalidate: {
       saveToCache   = true;
       auto cacheDoc = getCapabilitiesFromCache();
       if (cacheDoc.has_value()) {
-        mDoc = cacheDoc.value();
+        mDoc       = cacheDoc.value();
+        mFromCache = true;
       }
       break;
     }
@@ -155,6 +248,11 @@ VistaXML::TiXmlElement* WebMapService::getCapabilities() {
         }
       }
       cs::utils::filesystem::writeStringToFile(cacheFilePath.string(), docString.value());
+
+      // The ETag is used for revalidating the cached file.
+      if (mETag) {
+        cs::utils::filesystem::writeStringToFile(cacheFilePath.string() + ".etag", *mETag);
+      }
     }
   }
   VistaXML::TiXmlElement* capabilities = mDoc->FirstChildElement("WMS_Capabilities");
@@ -204,18 +302,15 @@ WebMapService::checkUpdateSequence(VistaXML::TiXmlDocument cacheDoc) {
   const char*             updateSequence = root->Attribute("updateSequence");
   if (updateSequence != nullptr) {
     // A sequence number was found, now check if it is the most recent one
-    std::stringstream url = getGetCapabilitiesUrl();
+    std::stringstream url = getGetCapabilitiesUrl(mUrl);
     url << "&UPDATESEQUENCE=" << updateSequence;
 
-    std::stringstream resStream;
-    curlpp::Easy      request;
-    request.setOpt(curlpp::options::Url(url.str()));
-    request.setOpt(curlpp::options::WriteStream(&resStream));
-    request.setOpt(curlpp::options::NoSignal(true));
-    request.setOpt(curlpp::options::SslVerifyPeer(false));
+    cs::utils::HttpClient::Request request;
+    request.mUrl = url.str();
 
+    cs::utils::HttpClient::Response response;
     try {
-      request.perform();
+      response = cs::utils::HttpClient::get().perform(request);
     } catch (std::exception const& e) {
       logger().warn("Failed to perform WMS Capabilities request while checking cache validity "
                     "for '{}': '{}'!",
@@ -223,7 +318,7 @@ WebMapService::checkUpdateSequence(VistaXML::TiXmlDocument cacheDoc) {
       return {};
     }
 
-    const std::string       resString = resStream.str();
+    const std::string&      resString = response.mBody;
     VistaXML::TiXmlDocument resDoc;
     resDoc.Parse(resString.c_str());
     if (resDoc.Error()) {
@@ -256,24 +351,23 @@ WebMapService::checkUpdateSequence(VistaXML::TiXmlDocument cacheDoc) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::tuple<VistaXML::TiXmlDocument, std::string> WebMapService::requestCapabilities() {
-  std::stringstream url = getGetCapabilitiesUrl();
+  std::stringstream url = getGetCapabilitiesUrl(mUrl);
 
-  std::stringstream xmlStream;
-  curlpp::Easy      request;
-  request.setOpt(curlpp::options::Url(url.str()));
-  request.setOpt(curlpp::options::WriteStream(&xmlStream));
-  request.setOpt(curlpp::options::NoSignal(true));
-  request.setOpt(curlpp::options::SslVerifyPeer(false));
+  cs::utils::HttpClient::Request request;
+  request.mUrl = url.str();
 
+  cs::utils::HttpClient::Response response;
   try {
-    request.perform();
+    response = cs::utils::HttpClient::get().perform(request);
   } catch (std::exception const& e) {
     std::stringstream message;
     message << "WMS capabilities request failed for '" << mUrl << "': '" << e.what() << "'";
     throw std::runtime_error(message.str());
   }
 
-  std::string             docString = xmlStream.str();
+  mETag = getETag(response);
+
+  std::string             docString = std::move(response.mBody);
   VistaXML::TiXmlDocument doc;
   doc.Parse(docString.c_str());
   if (doc.Error()) {
@@ -374,9 +468,9 @@ std::vector<std::string> WebMapService::parseMapFormats() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::stringstream WebMapService::getGetCapabilitiesUrl() const {
+std::stringstream WebMapService::getGetCapabilitiesUrl(std::string const& url) {
   std::stringstream urlStream;
-  urlStream << mUrl;
+  urlStream << url;
   urlStream << "?SERVICE=WMS";
   urlStream << "&VERSION=1.3.0";
   urlStream << "&REQUEST=GetCapabilities";
@@ -385,4 +479,10 @@ std::stringstream WebMapService::getGetCapabilitiesUrl() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::string WebMapService::getCacheFileName(std::string const& url) {
+  return std::regex_replace(url, std::regex("[/:*]"), "_") + ".xml";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::wmsoverlays
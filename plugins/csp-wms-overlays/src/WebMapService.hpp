@@ -30,7 +30,11 @@ class WebMapService {
     /// Check if cached files are up to date using their update sequence.
     eUpdateSequence,
     /// Never use cached files, always request new capabilities from the server.
-    eNever
+    eNever,
+    /// Use available cached files immediately. Whether they are up to date can be checked
+    /// afterwards with revalidateCache(), which uses the ETag and the modification time of the
+    /// cached file for a conditional request.
+    eRevalidate
   };
 
   /// Struct for storing general WMS settings.
@@ -65,6 +69,15 @@ class WebMapService {
   /// Checks if the service can return maps of the given MIME type.
   bool isFormatSupported(std::string const& format) const;
 
+  /// Returns true if the capabilities have been loaded from the cache.
+  bool isFromCache() const;
+
+  /// Requests the capabilities of the WMS at the given URL if they have changed since they were
+  /// stored in the cache directory. Returns true if the cached file has been replaced, in this
+  /// case a new WebMapService should be created for the URL. This is a blocking call, so it should
+  /// be called on a worker thread.
+  static bool revalidateCache(std::string const& url, std::string const& cacheDir);
+
  private:
   VistaXML::TiXmlElement*  getCapabilities();
   WebMapLayer              parseRootLayer();
@@ -85,9 +98,12 @@ class WebMapService {
   /// Returns the document as a parsed TiXmlDocument and as a raw string for caching.
   std::tuple<VistaXML::TiXmlDocument, std::string> requestCapabilities();
 
-  std::stringstream getGetCapabilitiesUrl() const;
+  static std::stringstream getGetCapabilitiesUrl(std::string const& url);
+  static std::string       getCacheFileName(std::string const& url);
 
   std::optional<VistaXML::TiXmlDocument> mDoc;
+  bool                                   mFromCache = false;
+  std::optional<std::string>             mETag;
 
   const std::string mUrl;
   const CacheMode   mCacheMode;
@@ -11,6 +11,7 @@
 
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/HttpClient.hpp"
 #include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
@@ -18,22 +19,52 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/range/algorithm/replace_copy_if.hpp>
-#include <curlpp/Infos.hpp>
-#include <curlpp/Options.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image.h>
 #include <stb_image_write.h>
 
+#include <algorithm>
 #include <fstream>
+#include <future>
+#include <thread>
 
 namespace csp::wmsoverlays {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WebMapTexture::Deleter::operator()(unsigned char* data) const {
+  stbi_image_free(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct WebMapTextureLoader::AsyncLoad {
+  WebMapService                              mWms;
+  WebMapLayer                                mLayer;
+  Request                                    mRequest;
+  std::string                                mUrl;
+  boost::filesystem::path                    mCachePath;
+  bool                                       mSaveToCache{};
+  int                                        mAttempt{};
+  std::promise<std::optional<WebMapTexture>> mPromise;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 WebMapTextureLoader::WebMapTextureLoader()
-    : mThreadPool(32) {
+    : mThreadPool(std::max(1U, std::thread::hardware_concurrency()), "WMS Loader") {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+WebMapTextureLoader::~WebMapTextureLoader() {
+
+  // The running requests are aborted by their progress callbacks once mShuttingDown is set.
+  std::unique_lock<std::mutex> lock(mRequestsMutex);
+  mShuttingDown = true;
+  mRequestsCondition.wait(lock, [this]() { return mPendingRequests == 0; });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -41,8 +72,109 @@ WebMapTextureLoader::WebMapTextureLoader()
 std::future<std::optional<WebMapTexture>> WebMapTextureLoader::loadTextureAsync(
     WebMapService const& wms, WebMapLayer const& layer, Request const& request,
     std::string const& mapCache, bool saveToCache) {
-  return mThreadPool.enqueue(
-      [=]() { return loadTexture(wms, layer, request, mapCache, saveToCache); });
+
+  auto load = std::make_shared<AsyncLoad>(
+      AsyncLoad{wms, layer, request, "", {}, saveToCache, 0, {}});
+
+  auto future = load->mPromise.get_future();
+
+  // Looking up the cache and creating the URL is done on the thread pool, the request itself is
+  // performed by the HttpClient without blocking a thread of the pool.
+  mThreadPool.enqueue([this, load, mapCache]() {
+    try {
+      load->mCachePath = getCachePath(load->mWms, load->mLayer, load->mRequest, mapCache);
+
+      // The file is already there, we can return it.
+      if (load->mSaveToCache && boost::filesystem::exists(load->mCachePath) &&
+          boost::filesystem::file_size(load->mCachePath) > 0) {
+        load->mPromise.set_value(loadTextureFromFile(load->mCachePath.string()));
+        return;
+      }
+
+      load->mUrl = getRequestUrl(load->mWms, load->mLayer, load->mRequest);
+    } catch (std::exception const& e) {
+      logger().warn("Failed to load WMS texture: '{}'!", e.what());
+      load->mPromise.set_value(std::nullopt);
+      return;
+    }
+
+    logger().debug("Performing WMS request '{}'.", load->mUrl);
+    requestTextureAsync(load);
+  });
+
+  return future;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebMapTextureLoader::requestTextureAsync(std::shared_ptr<AsyncLoad> const& load) {
+  {
+    std::unique_lock<std::mutex> lock(mRequestsMutex);
+
+    // No new requests are started once the destructor waits for the running ones.
+    if (mShuttingDown) {
+      lock.unlock();
+      load->mPromise.set_value(std::nullopt);
+      return;
+    }
+
+    ++mPendingRequests;
+  }
+
+  cs::utils::HttpClient::Request request;
+  request.mUrl              = load->mUrl;
+  request.mProgressCallback = [this](double /*unused*/, double /*unused*/) {
+    return mShuttingDown.load();
+  };
+
+  // This is executed on the I/O thread of the HttpClient, so it only checks the response. The
+  // texture is decoded on the thread pool.
+  cs::utils::HttpClient::get().performAsync(std::move(request),
+      [this, load](cs::utils::HttpClient::Response response, std::exception_ptr const& error) {
+        auto status = ResponseStatus::eRetry;
+
+        if (error) {
+          try {
+            std::rethrow_exception(error);
+          } catch (std::exception const& e) {
+            logger().warn("Failed to perform WMS request '{}': '{}'!", load->mUrl, e.what());
+          }
+        } else {
+          status = checkResponse(
+              load->mWms, load->mLayer, load->mUrl, response.mContentType, response.mBody);
+        }
+
+        if (status == ResponseStatus::eValid) {
+          mThreadPool.enqueue([this, load, data = std::move(response.mBody)]() {
+            // The file is written while the same bytes are decoded.
+            std::future<void> saved;
+            if (load->mSaveToCache) {
+              saved = std::async(std::launch::async,
+                  [this, &load, &data]() { saveTextureToFile(load->mCachePath, data); });
+            }
+
+            load->mPromise.set_value(loadTextureFromMemory(data));
+
+            if (saved.valid()) {
+              saved.wait();
+            }
+          });
+        } else if (status == ResponseStatus::eRetry && ++load->mAttempt < MAX_ATTEMPTS) {
+          logger().debug("Retrying...");
+          requestTextureAsync(load);
+        } else {
+          if (status == ResponseStatus::eRetry) {
+            logger().warn("Could not get a valid response for WMS request '{}'!", load->mUrl);
+          }
+          load->mPromise.set_value(std::nullopt);
+        }
+
+        // The destructor may destroy the condition variable as soon as it sees no pending
+        // requests, so it has to be notified while the mutex is still held.
+        std::unique_lock<std::mutex> lock(mRequestsMutex);
+        --mPendingRequests;
+        mRequestsCondition.notify_all();
+      });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -60,85 +192,60 @@ std::optional<WebMapTexture> WebMapTextureLoader::loadTexture(WebMapService cons
   }
 
   // The file is corrupt or not available, we have to request it
-  auto textureStream = requestTexture(wms, layer, request);
-  if (!textureStream.has_value()) {
+  auto textureData = requestTexture(wms, layer, request);
+  if (!textureData.has_value()) {
     return {};
   }
 
+  // The file is written while the same bytes are decoded.
+  std::future<void> saved;
   if (saveToCache) {
-    saveTextureToFile(cachePath, textureStream.value());
+    saved = std::async(std::launch::async,
+        [this, &cachePath, &textureData]() { saveTextureToFile(cachePath, *textureData); });
+  }
+
+  std::optional<WebMapTexture> texture = loadTextureFromMemory(textureData.value());
+
+  if (saved.valid()) {
+    saved.wait();
   }
 
-  std::optional<WebMapTexture> texture = loadTextureFromStream(textureStream.value());
   return texture;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::optional<std::stringstream> WebMapTextureLoader::requestTexture(
+std::optional<std::string> WebMapTextureLoader::requestTexture(
     WebMapService const& wms, WebMapLayer const& layer, Request const& wmsrequest) {
 
   std::string url = getRequestUrl(wms, layer, wmsrequest);
 
   logger().debug("Performing WMS request '{}'.", url);
 
-  int maxRetries = 3;
-  for (int i = 0; i < maxRetries; i++) {
+  for (int i = 0; i < MAX_ATTEMPTS; i++) {
     if (i > 0) {
       logger().debug("Retrying...");
     }
 
-    std::stringstream out(std::ios_base::out | std::ios_base::in | std::ios_base::binary);
-
-    curlpp::Easy request;
-    request.setOpt(curlpp::options::Url(url));
-    request.setOpt(curlpp::options::WriteStream(&out));
-    request.setOpt(curlpp::options::NoSignal(true));
-    request.setOpt(curlpp::options::SslVerifyPeer(false));
+    cs::utils::HttpClient::Request request;
+    request.mUrl = url;
 
+    cs::utils::HttpClient::Response response;
     try {
-      request.perform();
+      response = cs::utils::HttpClient::get().perform(request);
     } catch (std::exception& e) {
       logger().warn("Failed to perform WMS request '{}': '{}'!", url, e.what());
       continue;
     }
 
-    std::string contentType = curlpp::Info<CURLINFO_CONTENT_TYPE, std::string>::get(request);
-    // Remove suffix and parameter from content type
-    size_t suffixPos    = contentType.find('+');
-    size_t parameterPos = contentType.find(';');
-    if (suffixPos != std::string::npos) {
-      contentType = contentType.substr(0, suffixPos);
-    } else if (parameterPos != std::string::npos) {
-      contentType = contentType.substr(0, parameterPos);
-    }
-    if (contentType == "NULL") {
-      // No content type was set in the response. This error typically persists only for a short
-      // amount of time, so the request can be retried.
-      logger().debug("Could not determine response content type.");
-      continue;
+    auto status = checkResponse(wms, layer, url, response.mContentType, response.mBody);
+    if (status == ResponseStatus::eFailed) {
+      return {};
     }
-    if (contentType == "text/xml") {
-      // A WMS exception might have occurred.
-      try {
-        // If there was a valid WMS exception, the problem probably can't be fixed with a retry.
-        // => Return an empty object to cancel the request.
-        WebMapExceptionReport e(out.str());
-        logger().warn("WMS Exception occurred for WMS request '{}': '{}'!", url, e.what());
-        return {};
-      } catch (std::exception const& e) {
-        // If parsing the document fails, this might be due to connection problems
-        // or corrupted data.
-        // => Retry the request.
-        logger().debug("Could not create WebMapExceptionReport: '{}'.", e.what());
-        continue;
-      }
-      continue;
-    } else if (contentType != getMimeType(wms, layer)) {
-      logger().debug("Received response of invalid MIME type '{}'.", contentType);
+    if (status == ResponseStatus::eRetry) {
       continue;
     }
-    return std::move(out);
+    return std::move(response.mBody);
   }
   logger().warn("Could not get a valid response for WMS request '{}'!", url);
   return {};
@@ -146,8 +253,49 @@ std::optional<std::stringstream> WebMapTextureLoader::requestTexture(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+WebMapTextureLoader::ResponseStatus WebMapTextureLoader::checkResponse(WebMapService const& wms,
+    WebMapLayer const& layer, std::string const& url, std::string const& contentType,
+    std::string const& body) {
+
+  // Remove suffix from content type
+  std::string type      = contentType;
+  size_t      suffixPos = type.find('+');
+  if (suffixPos != std::string::npos) {
+    type = type.substr(0, suffixPos);
+  }
+  if (type.empty()) {
+    // No content type was set in the response. This error typically persists only for a short
+    // amount of time, so the request can be retried.
+    logger().debug("Could not determine response content type.");
+    return ResponseStatus::eRetry;
+  }
+  if (type == "text/xml") {
+    // A WMS exception might have occurred.
+    try {
+      // If there was a valid WMS exception, the problem probably can't be fixed with a retry.
+      // => Return an empty object to cancel the request.
+      WebMapExceptionReport e(body);
+      logger().warn("WMS Exception occurred for WMS request '{}': '{}'!", url, e.what());
+      return ResponseStatus::eFailed;
+    } catch (std::exception const& e) {
+      // If parsing the document fails, this might be due to connection problems
+      // or corrupted data.
+      // => Retry the request.
+      logger().debug("Could not create WebMapExceptionReport: '{}'.", e.what());
+      return ResponseStatus::eRetry;
+    }
+  }
+  if (type != getMimeType(wms, layer)) {
+    logger().debug("Received response of invalid MIME type '{}'.", type);
+    return ResponseStatus::eRetry;
+  }
+  return ResponseStatus::eValid;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void WebMapTextureLoader::saveTextureToFile(
-    boost::filesystem::path const& file, std::stringstream const& data) {
+    boost::filesystem::path const& file, std::string const& data) {
   {
     std::unique_lock<std::mutex> lock(mTextureMutex);
 
@@ -176,7 +324,7 @@ void WebMapTextureLoader::saveTextureToFile(
       return;
     }
 
-    out << data.rdbuf();
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
   }
 
   boost::filesystem::perms filePerms =
@@ -192,7 +340,7 @@ std::optional<WebMapTexture> WebMapTextureLoader::loadTextureFromFile(std::strin
   int width, height, bpp;
   int channels = 4;
 
-  std::unique_ptr<unsigned char> pixels(
+  std::unique_ptr<unsigned char, WebMapTexture::Deleter> pixels(
       stbi_load(fileName.c_str(), &width, &height, &bpp, channels));
 
   if (!pixels) {
@@ -206,14 +354,14 @@ std::optional<WebMapTexture> WebMapTextureLoader::loadTextureFromFile(std::strin
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::optional<WebMapTexture> WebMapTextureLoader::loadTextureFromStream(
-    std::stringstream const& stream) {
+std::optional<WebMapTexture> WebMapTextureLoader::loadTextureFromMemory(
+    std::string const& data) {
   int width, height, bpp;
   int channels = 4;
 
-  std::unique_ptr<unsigned char> pixels(
-      stbi_load_from_memory(reinterpret_cast<unsigned char*>(stream.str().data()),
-          static_cast<int>(stream.str().size()), &width, &height, &bpp, channels));
+  std::unique_ptr<unsigned char, WebMapTexture::Deleter> pixels(
+      stbi_load_from_memory(reinterpret_cast<unsigned char const*>(data.data()),
+          static_cast<int>(data.size()), &width, &height, &bpp, channels));
 
   if (!pixels) {
     logger().warn("Failed to load texture from memory with stbi!");
@@ -255,10 +403,16 @@ boost::filesystem::path WebMapTextureLoader::getCachePath(WebMapService const& w
     cacheDir << request.mStyle << "/";
   }
 
+  if (request.mTile.has_value()) {
+    cacheDir << "tiles/";
+  }
+
   std::stringstream cacheFile(cacheDir.str());
 
   // Add time string to cache file name if time is specified
-  if (request.mTime.has_value()) {
+  if (request.mTile.has_value()) {
+    cacheFile << cacheDir.str() << request.mTile->toString() << "." << fileFormat;
+  } else if (request.mTime.has_value()) {
     std::string timeForFile = request.mTime.value();
     std::replace(timeForFile.begin(), timeForFile.end(), '/', '-');
     std::replace(timeForFile.begin(), timeForFile.end(), ':', '-');
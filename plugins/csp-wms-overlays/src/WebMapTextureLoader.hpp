@@ -10,24 +10,37 @@
 
 #include "WebMapLayer.hpp"
 #include "WebMapService.hpp"
+#include "WebMapTile.hpp"
 
 #include "../../../src/cs-utils/ThreadPool.hpp"
 
 #include <boost/filesystem.hpp>
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 
 namespace csp::wmsoverlays {
 
 /// Struct for storing texture data along with some metadata.
 struct WebMapTexture {
-  std::unique_ptr<unsigned char> mData;
+  /// Frees pixel data which has been allocated by stb_image.
+  struct Deleter {
+    void operator()(unsigned char* data) const;
+  };
+
+  std::unique_ptr<unsigned char, Deleter> mData;
   int                            mWidth;
   int                            mHeight;
 };
 
-/// Class for requesting map textures from Web Map Services.
+/// Class for requesting map textures from Web Map Services. Asynchronous requests do not block a
+/// thread of the loader while waiting for the server: The requests are performed by the I/O thread
+/// of the cs::utils::HttpClient and the received textures are decoded on the thread pool.
 class WebMapTextureLoader {
  public:
   /// Struct for defining parameters for a request to a WMS.
@@ -36,11 +49,24 @@ class WebMapTextureLoader {
     std::string                mStyle;
     Bounds                     mBounds;
     std::optional<std::string> mTime;
+
+    /// If set, the texture is a tile of the layer and the bounds have to be the bounds of this
+    /// tile. Tiles are stored in the map cache separately.
+    std::optional<WebMapTileId> mTile;
   };
 
-  /// Creates a new ThreadPool with the specified amount of threads.
+  /// Creates a new ThreadPool with one thread per core.
   WebMapTextureLoader();
 
+  /// Aborts all running requests and waits until they have finished.
+  ~WebMapTextureLoader();
+
+  WebMapTextureLoader(WebMapTextureLoader const& other) = delete;
+  WebMapTextureLoader(WebMapTextureLoader&& other)      = delete;
+
+  WebMapTextureLoader& operator=(WebMapTextureLoader const& other) = delete;
+  WebMapTextureLoader& operator=(WebMapTextureLoader&& other)      = delete;
+
   /// Async WMS texture loader.
   /// Returns an empty optional if loading the texture failed.
   std::future<std::optional<WebMapTexture>> loadTextureAsync(WebMapService const& wms,
@@ -53,20 +79,39 @@ class WebMapTextureLoader {
       Request const& request, std::string const& mapCache, bool saveToCache);
 
  private:
+  /// The state of one call to loadTextureAsync(). This is defined in the source file.
+  struct AsyncLoad;
+
+  /// The result of checking the response to a texture request.
+  enum class ResponseStatus { eValid, eRetry, eFailed };
+
+  /// Maximum number of attempts for requesting a texture.
+  static constexpr int MAX_ATTEMPTS = 3;
+
+  /// Checks whether the given response to the given URL contains a texture for the given layer.
+  /// If not, it is reported whether the request should be retried.
+  static ResponseStatus checkResponse(WebMapService const& wms, WebMapLayer const& layer,
+      std::string const& url, std::string const& contentType, std::string const& body);
+
+  /// Starts the next attempt of the given asynchronous request. Once the response is there, the
+  /// texture is decoded on the thread pool.
+  void requestTextureAsync(std::shared_ptr<AsyncLoad> const& load);
+
   /// Requests a map texture from a WMS.
-  /// Returns a binary stream of the texture file if the request succeeds.
+  /// Returns the encoded texture file if the request succeeds. The data is received directly into
+  /// the returned buffer, so that it can be decoded and saved without any further copies.
   /// Returns an empty optional if the request fails.
-  std::optional<std::stringstream> requestTexture(
+  std::optional<std::string> requestTexture(
       WebMapService const& wms, WebMapLayer const& layer, Request const& request);
 
-  /// Saves a binary stream of a texture file to the given path.
-  void saveTextureToFile(boost::filesystem::path const& file, std::stringstream const& data);
+  /// Saves an encoded texture file to the given path.
+  void saveTextureToFile(boost::filesystem::path const& file, std::string const& data);
 
   /// Loads WMS texture from a file using stbi.
   static std::optional<WebMapTexture> loadTextureFromFile(std::string const& fileName);
 
-  /// Loads WMS texture from a stream using stbi.
-  static std::optional<WebMapTexture> loadTextureFromStream(std::stringstream const& stream);
+  /// Decodes a WMS texture from an encoded texture file in memory using stbi.
+  static std::optional<WebMapTexture> loadTextureFromMemory(std::string const& data);
 
   /// Constructs a path for loading/saving the texture requested with the given parameters.
   boost::filesystem::path getCachePath(WebMapService const& wms, WebMapLayer const& layer,
@@ -82,7 +127,15 @@ class WebMapTextureLoader {
   const std::map<std::string, std::string> mMimeToExtension = {
       {"image/png", "png"}, {"image/jpeg", "jpg"}};
 
-  std::mutex            mTextureMutex;
+  std::mutex mTextureMutex;
+
+  // The number of asynchronous requests which are currently performed by the HttpClient. Their
+  // callbacks access this object, so the destructor waits until this drops to zero.
+  int                     mPendingRequests = 0;
+  std::atomic<bool>       mShuttingDown{false};
+  std::mutex              mRequestsMutex;
+  std::condition_variable mRequestsCondition;
+
   cs::utils::ThreadPool mThreadPool;
 };
 
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "WebMapTile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+namespace csp::wmsoverlays {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+WebMapTileId WebMapTileId::getParent() const {
+  return {mLevel - 1, mX / 2, mY / 2};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string WebMapTileId::toString() const {
+  return std::to_string(mLevel) + "_" + std::to_string(mX) + "_" + std::to_string(mY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Bounds getTileBounds(WebMapTileId const& tile, Bounds const& layerBounds) {
+  double count      = std::pow(2.0, tile.mLevel);
+  double tileWidth  = (layerBounds.mMaxLon - layerBounds.mMinLon) / count;
+  double tileHeight = (layerBounds.mMaxLat - layerBounds.mMinLat) / count;
+
+  return {layerBounds.mMinLon + tile.mX * tileWidth,
+      layerBounds.mMinLon + (tile.mX + 1) * tileWidth, layerBounds.mMinLat + tile.mY * tileHeight,
+      layerBounds.mMinLat + (tile.mY + 1) * tileHeight};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int getTileLevel(Bounds const& visibleBounds, Bounds const& layerBounds, int tileSize,
+    int targetSize, int maxLevel) {
+  double layerWidth  = layerBounds.mMaxLon - layerBounds.mMinLon;
+  double layerHeight = layerBounds.mMaxLat - layerBounds.mMinLat;
+
+  double visibleWidth =
+      std::clamp(visibleBounds.mMaxLon - visibleBounds.mMinLon, 1e-9, layerWidth);
+  double visibleHeight = std::clamp(
+      std::min(visibleBounds.mMaxLat, layerBounds.mMaxLat) -
+          std::max(visibleBounds.mMinLat, layerBounds.mMinLat),
+      1e-9, layerHeight);
+
+  // This is how many times the visible part is smaller than the entire layer.
+  double zoom = std::max(layerWidth / visibleWidth, layerHeight / visibleHeight);
+
+  int level = static_cast<int>(std::ceil(std::log2(zoom * targetSize / tileSize)));
+  return std::clamp(level, 0, maxLevel);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<WebMapTileId> getTilesInBounds(
+    int level, Bounds const& visibleBounds, Bounds const& layerBounds) {
+  int    count      = 1 << level;
+  double tileWidth  = (layerBounds.mMaxLon - layerBounds.mMinLon) / count;
+  double tileHeight = (layerBounds.mMaxLat - layerBounds.mMinLat) / count;
+
+  auto toIndex = [count](double value) {
+    return std::clamp(static_cast<int>(std::floor(value)), 0, count - 1);
+  };
+
+  int minY = toIndex((visibleBounds.mMinLat - layerBounds.mMinLat) / tileHeight);
+  int maxY = toIndex((visibleBounds.mMaxLat - layerBounds.mMinLat) / tileHeight);
+
+  // The visible bounds are also checked shifted by a full turn in both directions, so that both
+  // sides of the date line are covered.
+  std::set<WebMapTileId> tiles;
+  for (double shift : {-360.0, 0.0, 360.0}) {
+    double minLon = visibleBounds.mMinLon + shift;
+    double maxLon = visibleBounds.mMaxLon + shift;
+
+    if (maxLon <= layerBounds.mMinLon || minLon >= layerBounds.mMaxLon ||
+        visibleBounds.mMaxLat <= layerBounds.mMinLat ||
+        visibleBounds.mMinLat >= layerBounds.mMaxLat) {
+      continue;
+    }
+
+    int minX = toIndex((minLon - layerBounds.mMinLon) / tileWidth);
+    int maxX = toIndex((maxLon - layerBounds.mMinLon) / tileWidth);
+
+    for (int x = minX; x <= maxX; ++x) {
+      for (int y = minY; y <= maxY; ++y) {
+        tiles.insert({level, x, y});
+      }
+    }
+  }
+
+  return {tiles.begin(), tiles.end()};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::wmsoverlays
@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_WMS_OVERLAYS_WEB_MAP_TILE_HPP
+#define CSP_WMS_OVERLAYS_WEB_MAP_TILE_HPP
+
+#include "utils.hpp"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace csp::wmsoverlays {
+
+/// Identifies a tile in a quadtree over the bounds of a WMS layer. Level zero consists of a single
+/// tile covering the entire layer, on each following level the tiles of the previous level are
+/// split into four. Similar to the TileId of csp-lod-bodies, but the tiles are rectangles in
+/// longitude and latitude, as the WMS requests are made in geographic coordinates.
+struct WebMapTileId {
+  int mLevel = 0;
+  int mX     = 0; ///< Index along the longitude axis, starting at the western edge.
+  int mY     = 0; ///< Index along the latitude axis, starting at the southern edge.
+
+  bool operator<(WebMapTileId const& other) const {
+    return std::tie(mLevel, mX, mY) < std::tie(other.mLevel, other.mX, other.mY);
+  }
+
+  bool operator==(WebMapTileId const& other) const {
+    return mLevel == other.mLevel && mX == other.mX && mY == other.mY;
+  }
+
+  /// Returns the tile of the previous level which contains this tile. Must not be called for
+  /// level zero.
+  WebMapTileId getParent() const;
+
+  /// This is used as file name in the map cache.
+  std::string toString() const;
+};
+
+/// Returns the geographic bounds in degrees of the given tile.
+Bounds getTileBounds(WebMapTileId const& tile, Bounds const& layerBounds);
+
+/// Returns the level at which tiles with the given size in pixels have to be loaded so that the
+/// visible part of the layer is covered by approximately targetSize pixels along its longer axis.
+/// The result is clamped to [0, maxLevel].
+int getTileLevel(Bounds const& visibleBounds, Bounds const& layerBounds, int tileSize,
+    int targetSize, int maxLevel);
+
+/// Returns all tiles of the given level which intersect the visible bounds. The visible bounds may
+/// cross the date line, in this case their longitudes exceed 180 degrees.
+std::vector<WebMapTileId> getTilesInBounds(
+    int level, Bounds const& visibleBounds, Bounds const& layerBounds);
+
+} // namespace csp::wmsoverlays
+
+#endif // CSP_WMS_OVERLAYS_WEB_MAP_TILE_HPP
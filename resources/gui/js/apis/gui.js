@@ -24,6 +24,16 @@ class GuiApi extends IApi {
    */
   _templates = new Map();
 
+  /**
+   * Calls which target elements of lazily added sidebar sections which have not been opened yet.
+   * Calls with the same key replace each other, so only the latest value of each input is kept.
+   *
+   * @see {executeDeferredCalls}
+   * @type {Map<string, Function>}
+   * @private
+   */
+  _deferredCalls = new Map();
+
   /**
    * Initialize third party drop downs,
    * add input event listener,
@@ -402,6 +412,11 @@ class GuiApi extends IApi {
   initSliderOptions(callbackName, options) {
     const slider = document.querySelector(`[data-callback="${callbackName}"]`);
 
+    if (this._deferIfMissing(slider, `init:${callbackName}`,
+            () => this.initSliderOptions(callbackName, options))) {
+      return;
+    }
+
     if (typeof noUiSlider === 'undefined') {
       console.warn('\'noUiSlider\' is not defined!');
       return;
@@ -416,11 +431,15 @@ class GuiApi extends IApi {
 
     slider.noUiSlider.on(event, (values, handle, unencoded) => {
       let callback = CosmoScout.callbacks.find(callbackName);
-      if (callback !== undefined) {
-        if (Array.isArray(unencoded)) {
-          callback(unencoded[0], unencoded[1]);
+      if (callback) {
+        let args = Array.isArray(unencoded) ? [unencoded[0], unencoded[1]] : [unencoded];
+
+        // Sliders fire many events while being dragged. If the callback has been registered from
+        // C++, only the last of these events is executed each frame.
+        if (callback.id !== undefined) {
+          window.callNativeCoalesced(callback.id, ...args);
         } else {
-          callback(unencoded);
+          callback(...args);
         }
       }
     });
@@ -484,6 +503,11 @@ class GuiApi extends IApi {
   setSliderValue(callbackName, emitCallbacks, ...value) {
     const slider = document.querySelector(`[data-callback="${callbackName}"]`);
 
+    if (this._deferIfMissing(slider, `value:${callbackName}`,
+            () => this.setSliderValue(callbackName, emitCallbacks, ...value))) {
+      return;
+    }
+
     if (slider !== null && typeof slider.noUiSlider !== 'undefined') {
       if (!slider.matches(":active")) {
         if (value.length === 1) {
@@ -504,6 +528,20 @@ class GuiApi extends IApi {
    */
   clearDropdown(callbackName) {
     const dropdown = document.querySelector(`[data-callback="${callbackName}"]`);
+
+    if (dropdown === null) {
+      // Options which have been added before are cleared as well.
+      this._deferredCalls.forEach((call, key) => {
+        if (key.startsWith(`option:${callbackName}:`)) {
+          this._deferredCalls.delete(key);
+        }
+      });
+    }
+
+    if (this._deferIfMissing(
+            dropdown, `clear:${callbackName}`, () => this.clearDropdown(callbackName))) {
+      return;
+    }
     CosmoScout.gui.clearHtml(dropdown);
 
     $(dropdown).selectpicker('refresh');
@@ -519,6 +557,12 @@ class GuiApi extends IApi {
    */
   addDropdownValue(callbackName, value, text, selected = false) {
     const dropdown = document.querySelector(`[data-callback="${callbackName}"]`);
+
+    if (this._deferIfMissing(dropdown, `option:${callbackName}:${value}`,
+            () => this.addDropdownValue(callbackName, value, text, selected))) {
+      return;
+    }
+
     const option   = document.createElement('option');
 
     option.value       = value;
@@ -542,6 +586,12 @@ class GuiApi extends IApi {
    */
   setDropdownValue(callbackName, value, emitCallbacks) {
     const dropdown = document.querySelector(`[data-callback="${callbackName}"]`);
+
+    if (this._deferIfMissing(dropdown, `value:${callbackName}`,
+            () => this.setDropdownValue(callbackName, value, emitCallbacks))) {
+      return;
+    }
+
     $(dropdown).selectpicker('val', value);
 
     if (emitCallbacks) {
@@ -568,6 +618,11 @@ class GuiApi extends IApi {
   setCheckboxValue(callbackName, value, emitCallbacks) {
     const element = document.querySelector(`[data-callback="${callbackName}"]`);
 
+    if (this._deferIfMissing(element, `value:${callbackName}`,
+            () => this.setCheckboxValue(callbackName, value, emitCallbacks))) {
+      return;
+    }
+
     if (element !== null) {
       element.checked = value;
 
@@ -587,11 +642,52 @@ class GuiApi extends IApi {
   setTextboxValue(id, value) {
     const element = document.querySelector(`.item-${id} .text-input`);
 
+    if (this._deferIfMissing(element, `text:${id}`, () => this.setTextboxValue(id, value))) {
+      return;
+    }
+
     if (element !== null) {
       element.value = value;
     }
   }
 
+  /**
+   * Executes all calls which have been deferred because their elements were not in the DOM. This is
+   * called by the sidebar whenever the content of a lazily added section has been inserted. Calls
+   * for elements of sections which are still not opened are deferred again.
+   *
+   * @see {_deferIfMissing}
+   */
+  executeDeferredCalls() {
+    const calls         = this._deferredCalls;
+    this._deferredCalls = new Map();
+    calls.forEach(call => call());
+  }
+
+  /**
+   * If the given element is null while there are lazily added sidebar sections which have not been
+   * opened yet, the element most likely belongs to one of these. In this case, the given call is
+   * stored under the given key and true is returned.
+   *
+   * @param element {HTMLElement|null} The element the call is targeting
+   * @param key {string} Calls with the same key replace each other
+   * @param call {Function} The call to execute once the element may be available
+   * @return {boolean} True if the call has been deferred
+   * @private
+   */
+  _deferIfMissing(element, key, call) {
+    // Not all pages which use this API have a sidebar.
+    if (element !== null || CosmoScout.sidebar === undefined ||
+        !CosmoScout.sidebar.hasLazyContent()) {
+      return false;
+    }
+
+    // The key is removed first, so that the call is moved to the end of the execution order.
+    this._deferredCalls.delete(key);
+    this._deferredCalls.set(key, call);
+    return true;
+  }
+
   /**
    * Triggers an artificial change event on a given HTML element.
    *
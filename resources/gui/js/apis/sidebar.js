@@ -32,6 +32,15 @@ class SidebarApi extends IApi {
    */
   _sidebarTab;
 
+  /**
+   * The contents of lazily added tabs and sections which have not been opened yet. They are keyed
+   * by the id of the collapsible element which will receive the content.
+   *
+   * @type {Map<string, string>}
+   * @private
+   */
+  _lazyContent = new Map();
+
   /**
    * Loads all templates and needed container refs
    */
@@ -42,49 +51,52 @@ class SidebarApi extends IApi {
   }
 
   /**
-   * Add a plugin tab to the sidebar
+   * Add a plugin tab to the sidebar. If lazy is set, the content is only added to the DOM once the
+   * tab is opened for the first time. Calls to CosmoScout.gui which target elements of the content
+   * are deferred until then.
    *
    * @param tabName {string}
    * @param icon {string}
    * @param content {string}
+   * @param lazy {boolean}
    */
-  addPluginTab(tabName, icon, content) {
-    const tab = CosmoScout.gui.loadTemplateContent('sidebar-plugin-tab-template');
-    if (tab === false) {
-      console.warn('"#sidebar-plugin-tab-template" could not be loaded!');
-      return;
-    }
-
-    tab.id        = "sidebar-tab-" + this._makeId(tabName);
-    tab.innerHTML = tab.innerHTML.replace(/%NAME%/g, tabName)
-                        .replace(/%ICON%/g, icon)
-                        .replace(/%ID%/g, tab.id)
-                        .replace(/%CONTENT%/g, content);
+  addPluginTab(tabName, icon, content, lazy = false) {
+    const tab = this._createSection(
+        'sidebar-plugin-tab-template', "sidebar-tab-" + this._makeId(tabName), tabName, icon,
+        content, "collapse-", lazy);
 
-    this._sidebar.insertBefore(tab, this._sidebarTab);
+    if (tab !== false) {
+      this._sidebar.insertBefore(tab, this._sidebarTab);
+    }
   }
 
   /**
-   * Add a new section to the settings tab
+   * Add a new section to the settings tab. If lazy is set, the content is only added to the DOM
+   * once the section is opened for the first time.
    *
+   * @see {addPluginTab}
    * @param sectionName {string}
    * @param icon {string}
    * @param content {string}
+   * @param lazy {boolean}
    */
-  addSettingsSection(sectionName, icon, content) {
-    const tab = CosmoScout.gui.loadTemplateContent('sidebar-settings-section-template');
-    if (tab === false) {
-      console.warn('"#sidebar-settings-section-template" could not be loaded!');
-      return;
-    }
+  addSettingsSection(sectionName, icon, content, lazy = false) {
+    const tab = this._createSection('sidebar-settings-section-template',
+        "sidebar-settings-" + this._makeId(sectionName), sectionName, icon, content,
+        "collapseSettings-", lazy);
 
-    tab.id        = "sidebar-settings-" + this._makeId(sectionName);
-    tab.innerHTML = tab.innerHTML.replace(/%NAME%/g, sectionName)
-                        .replace(/%ICON%/g, icon)
-                        .replace(/%ID%/g, tab.id)
-                        .replace(/%CONTENT%/g, content);
+    if (tab !== false) {
+      this._settings.appendChild(tab);
+    }
+  }
 
-    this._settings.appendChild(tab);
+  /**
+   * Returns true if there are lazily added tabs or sections which have not been opened yet.
+   *
+   * @return {boolean}
+   */
+  hasLazyContent() {
+    return this._lazyContent.size > 0;
   }
 
   /**
@@ -94,6 +106,7 @@ class SidebarApi extends IApi {
    */
   removePluginTab(tabName) {
     const id = "sidebar-tab-" + this._makeId(tabName);
+    this._lazyContent.delete("collapse-" + id);
     document.getElementById(id).remove();
   }
 
@@ -104,6 +117,7 @@ class SidebarApi extends IApi {
    */
   removeSettingsSection(pluginName) {
     const id = "sidebar-settings-" + this._makeId(pluginName);
+    this._lazyContent.delete("collapseSettings-" + id);
     document.getElementById(id).remove();
   }
 
@@ -139,6 +153,69 @@ class SidebarApi extends IApi {
     $("#maximum-scene-luminance").text(CosmoScout.utils.formatNumber(parseFloat(value)));
   }
 
+  /**
+   * Creates a tab or section from the given template. If lazy is set, the content is stored and
+   * inserted into the collapsible element "bodyPrefix + id" when it is shown for the first time.
+   *
+   * @see {addPluginTab}
+   * @see {addSettingsSection}
+   * @param templateId {string}
+   * @param id {string}
+   * @param name {string}
+   * @param icon {string}
+   * @param content {string}
+   * @param bodyPrefix {string}
+   * @param lazy {boolean}
+   * @return {HTMLElement|boolean}
+   * @private
+   */
+  _createSection(templateId, id, name, icon, content, bodyPrefix, lazy) {
+    const tab = CosmoScout.gui.loadTemplateContent(templateId);
+    if (tab === false) {
+      console.warn(`"#${templateId}" could not be loaded!`);
+      return false;
+    }
+
+    tab.id        = id;
+    tab.innerHTML = tab.innerHTML.replace(/%NAME%/g, name)
+                        .replace(/%ICON%/g, icon)
+                        .replace(/%ID%/g, tab.id)
+                        .replace(/%CONTENT%/g, lazy ? '' : content);
+
+    if (lazy) {
+      const bodyId = bodyPrefix + id;
+      this._lazyContent.set(bodyId, content);
+
+      // Bootstrap measures the height of the content only after this event, so the collapse
+      // animation works as usual.
+      $(tab.querySelector(`#${CSS.escape(bodyId)}`))
+          .one('show.bs.collapse', () => this._loadLazyContent(bodyId));
+    }
+
+    return tab;
+  }
+
+  /**
+   * Inserts the stored content of a lazily added tab or section, initializes its inputs and
+   * executes all calls to CosmoScout.gui which have been deferred.
+   *
+   * @see {_createSection}
+   * @param bodyId {string}
+   * @private
+   */
+  _loadLazyContent(bodyId) {
+    const content = this._lazyContent.get(bodyId);
+    if (content === undefined) {
+      return;
+    }
+
+    this._lazyContent.delete(bodyId);
+    document.getElementById(bodyId).innerHTML = content;
+
+    CosmoScout.gui.initInputs();
+    CosmoScout.gui.executeDeferredCalls();
+  }
+
   /**
    * @see {addPluginTab}
    * @see {addSettingsSection}
@@ -157,6 +157,11 @@ class TimelineApi extends IApi {
    */
   _dragDistance = false;
 
+  /**
+   * True while the user drags the timeline. The TimeControl is notified about changes.
+   */
+  _isScrubbing = false;
+
   /**
    * @type {Date}
    */
@@ -710,10 +715,17 @@ class TimelineApi extends IApi {
         this._setSpeed(0);
       }
 
+      if (!this._isScrubbing) {
+        this._isScrubbing = true;
+        CosmoScout.callbacks.time.setScrubbing(true);
+      }
+
       this._centerTime = new Date(properties.start.getTime() / 2 + properties.end.getTime() / 2);
       this._timeline.setCustomTime(this._centerTime, this._timeId);
 
-      window.callNative("time.setDate", this._centerTime.toISOString());
+      // Only the last date of each frame is applied.
+      window.callNativeCoalesced(
+          CosmoScout.callbacks.time.setDate.id, this._centerTime.toISOString());
     }
   }
 
@@ -727,6 +739,11 @@ class TimelineApi extends IApi {
     if (properties.byUser) {
       this._setSpeed(this._beforeDragSpeed);
       this._beforeDragSpeed = 0;
+
+      if (this._isScrubbing) {
+        this._isScrubbing = false;
+        CosmoScout.callbacks.time.setScrubbing(false);
+      }
     }
   }
 
@@ -13,11 +13,18 @@ const int   ECLIPSE_MAX_BODIES = 4;
 const float ECLIPSE_PI         = 3.14159265358979323846;
 
 // The first three components of uEclipseSun and the individual uEclipseOccluders are its position,
-// the last component contains its radius.
-uniform vec4      uEclipseSun;
-uniform int       uEclipseNumOccluders;
-uniform vec4      uEclipseOccluders[ECLIPSE_MAX_BODIES];
-uniform sampler2D uEclipseShadowMaps[ECLIPSE_MAX_BODIES];
+// the last component contains its radius. The shadow maps of all occluders are stored in the layers
+// of uEclipseShadowMaps, uEclipseShadowMapLayers contains the layer of each occluder. The block is
+// uploaded once each frame by the EclipseShadowReceiver, its layout has to match the one defined
+// there. uEclipseShadowMapLayers has one component per body.
+layout(std140) uniform EclipseShadows {
+  vec4  uEclipseSun;
+  vec4  uEclipseOccluders[ECLIPSE_MAX_BODIES];
+  ivec4 uEclipseShadowMapLayers;
+  int   uEclipseNumOccluders;
+};
+
+uniform sampler2DArray uEclipseShadowMaps;
 
 // ------------------------------------------------------------------------------- intersection math
 
@@ -233,7 +240,7 @@ vec3 getEclipseShadow(vec3 position) {
     if (!textureIncludesUmbra && y < 0) {
       light = vec3(0.0);
     } else if (x >= 0.0 && x <= 1.0 && y >= 0.0 && y <= 1.0) {
-      light *= texture(uEclipseShadowMaps[i], vec2(x, 1 - y)).rgb;
+      light *= texture(uEclipseShadowMaps, vec3(x, 1 - y, uEclipseShadowMapLayers[i])).rgb;
     }
   }
 #endif
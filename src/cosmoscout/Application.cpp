@@ -19,16 +19,21 @@
 #include "../cs-scene/CelestialSurface.hpp"
 #include "../cs-utils/Downloader.hpp"
 #include "../cs-utils/FrameStats.hpp"
+#include "../cs-utils/HttpClient.hpp"
+#include "../cs-utils/Property.hpp"
+#include "../cs-utils/ThreadPool.hpp"
 #include "../cs-utils/convert.hpp"
 #include "../cs-utils/filesystem.hpp"
 #include "../cs-utils/logger.hpp"
 #include "../cs-utils/utils.hpp"
+#include "Benchmark.hpp"
 #include "GetSelectionStateNode.hpp"
 #include "ObserverNavigationNode.hpp"
 #include "logger.hpp"
 #include "x11utils.hpp"
 
 #include <VistaBase/VistaTimeUtils.h>
+#include <VistaDataFlowNet/VdfnGraph.h>
 #include <VistaInterProcComm/Cluster/VistaClusterDataSync.h>
 #include <VistaKernel/Cluster/VistaClusterMode.h>
 #include <VistaKernel/DisplayManager/GlutWindowImp/VistaGlutWindowingToolkit.h>
@@ -37,10 +42,16 @@
 #include <VistaKernel/EventManager/VistaSystemEvent.h>
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
 #include <VistaKernel/GraphicsManager/VistaTransformNode.h>
+#include <VistaKernel/InteractionManager/VistaInteractionContext.h>
+#include <VistaKernel/InteractionManager/VistaInteractionManager.h>
 #include <VistaKernel/VistaSystem.h>
 #include <VistaOGLExt/VistaShaderRegistry.h>
+#include <algorithm>
+#include <chrono>
 #include <curlpp/cURLpp.hpp>
 #include <memory>
+#include <thread>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -62,8 +73,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Application::Application(std::shared_ptr<cs::core::Settings> settings)
-    : mSettings(std::move(settings)) {
+Application::Application(
+    std::shared_ptr<cs::core::Settings> settings, std::string benchmarkScript)
+    : mSettings(std::move(settings))
+    , mBenchmarkScript(std::move(benchmarkScript)) {
 
   mSettings->onLoad().connect([this]() { onLoad(); });
 
@@ -116,6 +129,16 @@ bool Application::Init(VistaSystem* pVistaSystem) {
   mDragNavigation =
       std::make_unique<cs::core::DragNavigation>(mSolarSystem, mInputManager, mTimeControl);
 
+  if (!mBenchmarkScript.empty()) {
+    try {
+      mBenchmark =
+          std::make_unique<Benchmark>(mBenchmarkScript, mSettings, mSolarSystem, mTimeControl);
+    } catch (std::runtime_error const& e) {
+      logger().error("Failed to load benchmark: {}", e.what());
+      return false;
+    }
+  }
+
   // The ObserverNavigationNode is used by several DFN networks to move the celestial observer.
   VdfnNodeFactory* pNodeFactory = VdfnNodeFactory::GetSingleton();
   pNodeFactory->SetNodeCreator( // NOLINTNEXTLINE: TODO is this a memory leak?
@@ -123,6 +146,15 @@ bool Application::Init(VistaSystem* pVistaSystem) {
   pNodeFactory->SetNodeCreator( // NOLINTNEXTLINE: TODO is this a memory leak?
       "GetSelectionStateNode", new GetSelectionStateNodeCreate(mInputManager.get()));
 
+  // If there is an interaction context which only applies the head pose, it can be evaluated
+  // again right before rendering. See FrameUpdate() for details.
+  auto* interactionManager = GetVistaSystem()->GetInteractionManager();
+  auto* headPoseContext =
+      interactionManager->GetInteractionContextByRoleId(interactionManager->GetRoleId("HEADPOSE"));
+  if (headPoseContext) {
+    mHeadPoseGraph = headPoseContext->GetTransformGraph();
+  }
+
   // Setup user interface callbacks.
   registerGuiCallbacks();
 
@@ -156,6 +188,11 @@ bool Application::Init(VistaSystem* pVistaSystem) {
         "CosmoScout.gui.hideElement", "#enableSensorSizeControl", !enable);
   });
 
+  // All network requests of CosmoScout VR and its plugins share this limit.
+  mSettings->pMaxConnectionsPerHost.connectAndTouch([](uint32_t count) {
+    cs::utils::HttpClient::get().setMaxConnectionsPerHost(std::max(1U, count));
+  });
+
   mSettings->pSpiceKernel.connect([](auto /*unused*/) {
     logger().warn("Reloading the SPICE kernels at runtime is not yet supported!");
   });
@@ -179,6 +216,7 @@ void Application::Quit() {
 
   // De-init all plugins first.
   for (auto const& plugin : mPlugins) {
+    cs::utils::FrameStats::ScopedOwner owner(plugin.second.mOwnerId);
     plugin.second.mPlugin->deInit();
   }
 
@@ -195,6 +233,7 @@ void Application::Quit() {
   // Make sure all shared pointers have been cleared nicely. Print a warning if some references are
   // still hanging around.
   mDragNavigation.reset();
+  mBenchmark.reset();
 
   auto assertCleanUp = [](std::string const& name, size_t count) {
     if (count > 1) {
@@ -271,17 +310,43 @@ void Application::FrameUpdate() {
 
   // loading and saving ----------------------------------------------------------------------------
 
-  if (!mSettingsToSave.empty()) {
+  // The settings are written on a worker thread. Further saves are deferred until the previous
+  // file has been written.
+  if (mSaveTask.valid() &&
+      mSaveTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
     try {
-      mSettings->saveToFile(mSettingsToSave);
+      mSaveTask.get();
     } catch (std::exception const& e) {
-      logger().warn("Failed to save settings to '{}': {}", mSettingsToSave, e.what());
+      logger().warn("Failed to save settings to '{}': {}", mSaveTaskFile, e.what());
+    }
+  }
+
+  if (!mSaveTask.valid()) {
+    auto   now      = std::chrono::steady_clock::now();
+    double interval = mSettings->pAutosaveInterval.get();
+
+    if (mSettingsToSave.empty() && interval > 0.0 &&
+        std::chrono::duration<double>(now - mLastAutosave).count() > interval) {
+      mSettingsToSave = mSettings->pAutosaveFile.get();
+      mLastAutosave   = now;
+    }
+
+    if (!mSettingsToSave.empty()) {
+      try {
+        mSaveTask     = mSettings->saveToFileAsync(mSettingsToSave);
+        mSaveTaskFile = mSettingsToSave;
+      } catch (std::exception const& e) {
+        logger().warn("Failed to save settings to '{}': {}", mSettingsToSave, e.what());
+      }
+      mSettingsToSave = "";
     }
-    mSettingsToSave = "";
   }
 
   if (!mSettingsToLoad.empty()) {
     try {
+      // All changed Properties emit their change signals only once at the beginning of the next
+      // frame.
+      cs::core::Settings::Transaction transaction(*mSettings);
       mSettings->loadFromFile(mSettingsToLoad);
     } catch (std::exception const& e) {
       logger().warn("Failed to load settings from '{}': {}", mSettingsToLoad, e.what());
@@ -324,17 +389,19 @@ void Application::FrameUpdate() {
   int32_t const waitFrames = 25;
   if (GetFrameCount() == waitFrames) {
     if (!mSettings->mDownloadData.empty()) {
-      // Download datasets in parallel. We use 10 threads to download the data.
+      // Download datasets in parallel. We use 10 threads to download the data. Files which are
+      // required by the SolarSystem are downloaded first, as everything else waits for them. Files
+      // which are only required by some plugins are downloaded while the others are initialized.
       mDownloader = std::make_unique<cs::utils::Downloader>(10);
       for (auto const& download : mSettings->mDownloadData) {
-        mDownloader->download(download.mUrl, download.mFile);
+        mDownloader->download(download.mUrl, download.mFile,
+            download.mPlugins ? cs::utils::ThreadPool::Priority::eNormal
+                              : cs::utils::ThreadPool::Priority::eHigh,
+            download.mSha256);
       }
 
       // If all files were already downloaded, this could have gone quite quickly...
-      if (mDownloader->hasFinished()) {
-        mDownloadedData = true;
-        mDownloader.reset(nullptr);
-      } else {
+      if (!mDownloader->hasFinished()) {
         // Show to the user what's going on.
         mGuiManager->setLoadingScreenStatus("Downloading data...");
       }
@@ -345,13 +412,18 @@ void Application::FrameUpdate() {
     }
   }
 
-  // Until everything is downloaded, update the progressbar accordingly.
+  // Until the data required by the SolarSystem is downloaded, update the progressbar accordingly.
   if (!mDownloadedData && mDownloader) {
     mGuiManager->setLoadingScreenProgress(static_cast<float>(mDownloader->getProgress()), false);
+
+    mDownloadedData = std::all_of(mSettings->mDownloadData.begin(),
+        mSettings->mDownloadData.end(), [this](auto const& download) {
+          return download.mPlugins || mDownloader->hasFinished(download.mFile);
+        });
   }
 
-  // Once the data download has finished, we can delete our downloader.
-  if (!mDownloadedData && mDownloader && mDownloader->hasFinished()) {
+  // Once all downloads have finished, we can delete our downloader.
+  if (mDownloader && mDownloader->hasFinished()) {
     mDownloadedData = true;
     mDownloader.reset(nullptr);
   }
@@ -370,45 +442,67 @@ void Application::FrameUpdate() {
     connectSlots();
 
     // Store the frame at which we should start loading the plugins.
-    mStartPluginLoadingAtFrame = GetFrameCount();
+    mNextPluginLoadingFrame = GetFrameCount() + 25;
+
+    for (auto const& plugin : mPlugins) {
+      mPluginsToInit.insert(plugin.first);
+    }
   }
 
   // load plugins at application startup -----------------------------------------------------------
 
-  // Once all data has been downloaded and the SolarSystem has been initialized, we can start
-  // loading the plugins.
+  // Once the SolarSystem has been initialized, we can start loading the plugins. Each plugin is
+  // initialized as soon as the files it requires have been downloaded.
   if (mDownloadedData && !mLoadedAllPlugins) {
 
+    // The expensive preparation of the plugins can run in parallel while the plugins are
+    // initialized one after another. Plugins are prepared once their data has been downloaded.
+    preparePlugins();
+
     // Before loading the first plugin and between loading the individual plugins, we will draw some
     // frames. This allows the loading screen to update the status message and move the progress
     // bar. For now, we wait a hard-coded number of 25 frames before and between loading of the
     // plugins.
     const int32_t cLoadingDelay = 25;
 
-    // Every 25th frame something happens. At frame X we will show the name of the plugin on the
-    // loading screen which will be loaded at frame X+25. At frame X+25 we will load the according
-    // plugin and also update the loading screen to display the name of the plugin which is going to
-    // be loaded at frame X+50. And so on.
-    if (((GetFrameCount() - mStartPluginLoadingAtFrame) % cLoadingDelay) == 0) {
+    if (GetFrameCount() >= mNextPluginLoadingFrame) {
 
-      // Calculate the index of the plugin which should be loaded this frame.
-      int32_t pluginToLoad = (GetFrameCount() - mStartPluginLoadingAtFrame) / cLoadingDelay - 1;
+      // Plugins are loaded in alphabetical order, but plugins which are still waiting for their
+      // data or for one of their dependencies are postponed.
+      auto plugin = std::find_if(mPluginsToInit.begin(), mPluginsToInit.end(),
+          [this](std::string const& name) { return canInitPlugin(name); });
 
-      if (pluginToLoad >= 0 && pluginToLoad < static_cast<int32_t>(mPlugins.size())) {
+      // If all remaining plugins have their data but none of them can be initialized, they depend
+      // on each other. In this case, the cycle is broken at the first of them.
+      if (plugin == mPluginsToInit.end() && !mPluginsToInit.empty() &&
+          std::all_of(mPluginsToInit.begin(), mPluginsToInit.end(),
+              [this](std::string const& name) { return hasDownloadedDataFor(name); })) {
+        plugin = mPluginsToInit.begin();
+        logger().warn("Plugin '{}' has a cyclic dependency! It is initialized anyway.", *plugin);
+      }
 
-        // Get an iterator pointing to the plugin handle.
-        auto plugin = mPlugins.begin();
-        std::advance(plugin, pluginToLoad);
+      if (plugin != mPluginsToInit.end()) {
+        initPlugin(*plugin);
+        mPluginsToInit.erase(plugin);
+        mNextPluginLoadingFrame = GetFrameCount() + cLoadingDelay;
 
-        initPlugin(plugin->first);
+      } else if (!mPluginsToInit.empty()) {
+        // All remaining plugins are waiting for data, so we check again in a few frames.
+        mNextPluginLoadingFrame = GetFrameCount() + cLoadingDelay / 5;
 
-      } else if (pluginToLoad == static_cast<int32_t>(mPlugins.size())) {
+      } else {
 
         logger().info("Ready for Takeoff!");
 
         // Once all plugins have been loaded, we set a boolean indicating this state.
         mLoadedAllPlugins = true;
 
+        printPluginInitTimes();
+
+        // All plugins have waited for their preparation, so the worker threads are not needed
+        // anymore.
+        mPluginPreparePool.reset();
+
         // Update the loading screen status.
         mGuiManager->setLoadingScreenStatus("Ready for Takeoff");
         mGuiManager->setLoadingScreenProgress(100.F, true);
@@ -423,12 +517,19 @@ void Application::FrameUpdate() {
 
       // If there is a plugin going to be loaded after the next cLoadingDelay frames, display its
       // name on the loading screen and update the progress accordingly.
-      if (pluginToLoad + 1 < static_cast<int32_t>(mPlugins.size())) {
-        auto plugin = mPlugins.begin();
-        std::advance(plugin, pluginToLoad + 1);
-        mGuiManager->setLoadingScreenStatus("Loading " + plugin->first + " ...");
-        mGuiManager->setLoadingScreenProgress(
-            100.F * static_cast<float>(pluginToLoad + 1) / mPlugins.size(), true);
+      if (!mLoadedAllPlugins && !mPluginsToInit.empty()) {
+        auto next = std::find_if(mPluginsToInit.begin(), mPluginsToInit.end(),
+            [this](std::string const& name) { return canInitPlugin(name); });
+
+        if (next != mPluginsToInit.end()) {
+          mGuiManager->setLoadingScreenStatus("Loading " + *next + " ...");
+        } else {
+          mGuiManager->setLoadingScreenStatus("Downloading data for " + *mPluginsToInit.begin() +
+                                              " ...");
+        }
+
+        auto loaded = static_cast<float>(mPlugins.size() - mPluginsToInit.size());
+        mGuiManager->setLoadingScreenProgress(100.F * loaded / mPlugins.size(), true);
       }
     }
   }
@@ -441,8 +542,24 @@ void Application::FrameUpdate() {
       mGuiManager->enableLoadingScreen(false);
     }
 
+    // In benchmark mode, the observer is moved along the benchmark's camera paths once the loading
+    // screen has been hidden. This has to happen before the SolarSystem is updated.
+    if (mBenchmark && GetFrameCount() >= mHideLoadingScreenAtFrame) {
+      bool isLoading = std::any_of(mPlugins.begin(), mPlugins.end(),
+          [](auto const& plugin) { return plugin.second.mPlugin->getIsLoading(); });
+      mBenchmark->update(isLoading);
+    }
+
     // update CosmoScout VR classes ----------------------------------------------------------------
 
+    // Properties in deferred mode which have been changed during the last frame emit their change
+    // signals now.
+    {
+      cs::utils::FrameStats::ScopedTimer timer(
+          "Emit Deferred Properties", cs::utils::FrameStats::TimerMode::eCPU);
+      cs::utils::emitDeferredPropertyChanges();
+    }
+
     // Update the InputManager.
     {
       cs::utils::FrameStats::ScopedTimer timer(
@@ -499,11 +616,19 @@ void Application::FrameUpdate() {
       }
     }
 
+    // Plugins which do CPU-heavy work in updateAsync() are updated in parallel first.
+    {
+      cs::utils::FrameStats::ScopedTimer timer(
+          "Update Plugins Async", cs::utils::FrameStats::TimerMode::eCPU);
+      updatePluginsAsync();
+    }
+
     // Update the individual plugins.
     {
       cs::utils::FrameStats::ScopedTimer timer("Update Plugins");
       for (auto const& plugin : mPlugins) {
-        cs::utils::FrameStats::ScopedTimer timer("Update " + plugin.first);
+        cs::utils::FrameStats::ScopedOwner owner(plugin.second.mOwnerId);
+        cs::utils::FrameStats::ScopedTimer timer(plugin.second.mUpdateTimerId);
 
         try {
           plugin.second.mPlugin->update();
@@ -518,11 +643,16 @@ void Application::FrameUpdate() {
       cs::utils::FrameStats::ScopedTimer timer(
           "Scene Sync", cs::utils::FrameStats::TimerMode::eCPU);
 
+      // Everything is sent in a single message, as each call to SyncData() requires a round trip
+      // through the network. The names of the observer's SPICE frame and center are only appended
+      // if they changed since the last frame.
       struct SyncMessage {
         glm::dvec3 mPosition;
         glm::dquat mRotation;
         double     mScale;
         double     mTime;
+        uint16_t   mFrameNameLength;
+        uint16_t   mCenterNameLength;
       } syncMessage{};
 
       syncMessage.mPosition = mSolarSystem->getObserver().getPosition();
@@ -533,18 +663,35 @@ void Application::FrameUpdate() {
       std::string frame(mSolarSystem->getObserver().getFrameName());
       std::string center(mSolarSystem->getObserver().getCenterName());
 
-      {
-        std::vector<VistaType::byte> data(sizeof(SyncMessage));
-        std::memcpy(&data[0], &syncMessage, sizeof(SyncMessage));
-        mSceneSync->SyncData(data);
-        std::memcpy(&syncMessage, &data[0], sizeof(SyncMessage));
+      bool anchorChanged = frame != mLastSyncedFrame || center != mLastSyncedCenter;
+
+      if (anchorChanged) {
+        syncMessage.mFrameNameLength  = static_cast<uint16_t>(frame.size());
+        syncMessage.mCenterNameLength = static_cast<uint16_t>(center.size());
       }
 
-      mSceneSync->SyncData(frame);
-      mSceneSync->SyncData(center);
+      std::vector<VistaType::byte> data(sizeof(SyncMessage));
+      std::memcpy(data.data(), &syncMessage, sizeof(SyncMessage));
 
-      mSolarSystem->getObserver().setFrameName(frame);
-      mSolarSystem->getObserver().setCenterName(center);
+      if (anchorChanged) {
+        data.insert(data.end(), frame.begin(), frame.end());
+        data.insert(data.end(), center.begin(), center.end());
+      }
+
+      mSceneSync->SyncData(data);
+
+      // From here on, the data of the leader is used on all nodes.
+      std::memcpy(&syncMessage, data.data(), sizeof(SyncMessage));
+
+      if (syncMessage.mFrameNameLength > 0 || syncMessage.mCenterNameLength > 0) {
+        auto names = data.begin() + sizeof(SyncMessage);
+        mLastSyncedFrame.assign(names, names + syncMessage.mFrameNameLength);
+        mLastSyncedCenter.assign(names + syncMessage.mFrameNameLength,
+            names + syncMessage.mFrameNameLength + syncMessage.mCenterNameLength);
+      }
+
+      mSolarSystem->getObserver().setFrameName(mLastSyncedFrame);
+      mSolarSystem->getObserver().setCenterName(mLastSyncedCenter);
 
       mSolarSystem->getObserver().setPosition(syncMessage.mPosition);
       mSolarSystem->getObserver().setRotation(syncMessage.mRotation);
@@ -556,7 +703,12 @@ void Application::FrameUpdate() {
     // Update the GraphicsEngine.
     {
       cs::utils::FrameStats::ScopedTimer timer("Update Graphics Engine");
-      mGraphicsEngine->update(glm::normalize(mSolarSystem->pSunPosition.get()));
+      glm::dmat4 referenceTransform(1.0);
+      if (mSolarSystem->pActiveObject.get()) {
+        referenceTransform = mSolarSystem->pActiveObject.get()->getObserverRelativeTransform();
+      }
+
+      mGraphicsEngine->update(glm::normalize(mSolarSystem->pSunPosition.get()), referenceTransform);
     }
   }
 
@@ -612,7 +764,8 @@ void Application::FrameUpdate() {
           angle = -angle;
         }
 
-        mGuiManager->getGui()->callJavascript("CosmoScout.timeline.setNorthDirection", angle);
+        mGuiManager->getGui()->callJavascriptCoalesced(
+            "CosmoScout.timeline.setNorthDirection", angle);
 
       } catch (std::exception const& e) {
         // Getting the relative transformation may fail due to insufficient SPICE data.
@@ -620,11 +773,24 @@ void Application::FrameUpdate() {
       }
     }
 
+    // Forward all messages logged since the last frame to the user interface and other listeners.
+    cs::utils::emitLogMessages();
+
     mGuiManager->update();
   }
 
   // update vista classes --------------------------------------------------------------------------
 
+  // The head pose has been read by the interaction contexts at the beginning of the frame. Since
+  // then, the head may have moved. All shaders get their view matrix from the scene graph when
+  // they are drawn, so moving the platform according to the latest tracking data right here
+  // shortens the time between the head movement and the displayed image for the entire scene. The
+  // graph only sets the platform transformation, so evaluating it twice per frame is harmless.
+  if (mHeadPoseGraph && mSettings->pEnableLateHeadTracking.get()) {
+    cs::utils::FrameStats::ScopedTimer timer("Late Head Tracking");
+    mHeadPoseGraph->EvaluateGraph(GetVistaSystem()->GetFrameClock());
+  }
+
   {
     cs::utils::FrameStats::ScopedTimer timer("Rendering");
     m_pDisplayManager->DrawFrame();
@@ -648,6 +814,11 @@ void Application::FrameUpdate() {
     cs::utils::FrameStats::ScopedTimer timer("FrameRate RecordTime");
     m_pFrameRate->RecordTime();
   }
+
+  // Once the benchmark report has been written, there is nothing left to do.
+  if (mBenchmark && mBenchmark->getIsFinished()) {
+    Quit();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -685,6 +856,11 @@ void Application::testLoadAllPlugins() {
 
 void Application::onLoad() {
 
+  // Plugins only reconfigure themselves if their settings or any celestial object have changed.
+  auto const& changes = mSettings->getLoadChanges();
+  logger().debug("Loaded settings: {} plugin(s) and {} object(s) changed.", changes.mPlugins.size(),
+      changes.mObjects.size());
+
   // First unload all plugins which are not required anymore.
   for (auto const& plugin : mPlugins) {
     if (mSettings->mPlugins.find(plugin.first) == mSettings->mPlugins.end()) {
@@ -732,8 +908,15 @@ void Application::openPlugin(std::string const& name) {
 
         logger().info("Opening plugin '{}'.", name);
 
-        // Actually call the plugin's constructor and add the returned pointer to out list.
-        mPlugins.insert(std::pair<std::string, Plugin>(name, {pluginHandle, pluginConstructor()}));
+        // Actually call the plugin's constructor and add the returned pointer to out list. The
+        // update timers are interned within the plugin's ScopedOwner, so they are attributed to it.
+        cs::utils::FrameStats::ScopedOwner owner(name);
+
+        Plugin newPlugin{pluginHandle, pluginConstructor()};
+        newPlugin.mUpdateTimerId      = cs::utils::FrameStats::intern("Update " + name);
+        newPlugin.mAsyncUpdateTimerId = cs::utils::FrameStats::intern("Update Async " + name);
+        newPlugin.mOwnerId            = *cs::utils::FrameStats::getCurrentOwner();
+        mPlugins.emplace(name, std::move(newPlugin));
       } else {
         logger().warn("Failed to load plugin '{}': {}", name, LIBERROR());
       }
@@ -747,22 +930,103 @@ void Application::openPlugin(std::string const& name) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+nlohmann::json Application::getPluginSettings(std::string const& name) const {
+  auto settings = mSettings->mPlugins.find(name);
+  return settings != mSettings->mPlugins.end() ? settings->second : nlohmann::json::object();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Application::preparePlugins() {
+  if (!mPluginPreparePool) {
+    mPluginPreparePool = std::make_unique<cs::utils::ThreadPool>(
+        std::max(1U, std::thread::hardware_concurrency()), "Plugin Preparation");
+  }
+
+  for (auto const& name : mPluginsToInit) {
+    auto& plugin = mPlugins.at(name);
+
+    if (!plugin.mIsInitialized && !plugin.mPrepared.valid() && hasDownloadedDataFor(name)) {
+
+      // The task is executed within the plugin's ScopedOwner as it is enqueued within it.
+      cs::utils::FrameStats::ScopedOwner owner(plugin.mOwnerId);
+
+      plugin.mPlugin->setAPI(mSettings, mSolarSystem, mGuiManager, mInputManager,
+          GetVistaSystem()->GetGraphicsManager()->GetSceneGraph(), mGraphicsEngine, mTimeControl);
+
+      plugin.mPrepared = mPluginPreparePool->enqueue(
+          [p = plugin.mPlugin, settings = getPluginSettings(name)]() { p->prepare(settings); });
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Application::hasDownloadedDataFor(std::string const& plugin) const {
+  if (!mDownloader) {
+    return true;
+  }
+
+  return std::none_of(mSettings->mDownloadData.begin(), mSettings->mDownloadData.end(),
+      [this, &plugin](auto const& download) {
+        return download.mPlugins &&
+               std::find(download.mPlugins->begin(), download.mPlugins->end(), plugin) !=
+                   download.mPlugins->end() &&
+               !mDownloader->hasFinished(download.mFile);
+      });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Application::canInitPlugin(std::string const& plugin) const {
+  if (!hasDownloadedDataFor(plugin)) {
+    return false;
+  }
+
+  auto dependencies = mPlugins.at(plugin).mPlugin->getDependencies();
+
+  return std::none_of(dependencies.begin(), dependencies.end(),
+      [this](std::string const& dependency) { return mPluginsToInit.count(dependency) > 0; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Application::initPlugin(std::string const& name) {
   auto plugin = mPlugins.find(name);
 
   if (plugin != mPlugins.end()) {
     if (!plugin->second.mIsInitialized) {
+      cs::utils::FrameStats::ScopedOwner owner(plugin->second.mOwnerId);
 
-      // First provide the plugin with all required class instances.
-      plugin->second.mPlugin->setAPI(mSettings, mSolarSystem, mGuiManager, mInputManager,
-          GetVistaSystem()->GetGraphicsManager()->GetSceneGraph(), mGraphicsEngine, mTimeControl);
+      // First provide the plugin with all required class instances. If the plugin is currently
+      // being prepared, this has been done by preparePlugins() already.
+      if (!plugin->second.mPrepared.valid()) {
+        plugin->second.mPlugin->setAPI(mSettings, mSolarSystem, mGuiManager, mInputManager,
+            GetVistaSystem()->GetGraphicsManager()->GetSceneGraph(), mGraphicsEngine, mTimeControl);
+      }
 
       // Then do the actual initialization. This may actually take a while and the application will
       // become unresponsive in the meantime.
       try {
+        auto start = std::chrono::steady_clock::now();
+
+        // Rethrows any exception thrown by prepare() on the worker thread.
+        if (plugin->second.mPrepared.valid()) {
+          plugin->second.mPrepared.get();
+        } else {
+          plugin->second.mPlugin->prepare(getPluginSettings(name));
+        }
+
         plugin->second.mPlugin->init();
         plugin->second.mIsInitialized = true;
 
+        plugin->second.mInitTime =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count();
+
+        logger().debug(
+            "Initialized plugin '{}' in {:.1f} ms.", plugin->first, plugin->second.mInitTime);
+
         // Plugin finished loading -> init its custom components.
         mGuiManager->getGui()->callJavascript("CosmoScout.gui.initInputs");
       } catch (std::exception const& e) {
@@ -776,11 +1040,124 @@ void Application::initPlugin(std::string const& name) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Application::updatePluginsAsync() {
+  using AsyncUpdateAccess = cs::core::PluginBase::AsyncUpdateAccess;
+
+  struct Batch {
+    AsyncUpdateAccess                                    mAccess;
+    std::vector<std::pair<std::string const*, Plugin*>> mPlugins;
+  };
+
+  // Each plugin is added to the first batch it does not conflict with. A plugin conflicts with a
+  // batch if it writes anything the batch accesses or if it accesses anything the batch writes.
+  std::vector<Batch> batches;
+
+  for (auto& [name, plugin] : mPlugins) {
+    if (!plugin.mIsInitialized) {
+      continue;
+    }
+
+    auto access = plugin.mPlugin->getAsyncUpdateAccess();
+    if (!access) {
+      continue;
+    }
+
+    auto batch = std::find_if(batches.begin(), batches.end(), [&access](Batch const& b) {
+      return (access->mWrites & (b.mAccess.mReads | b.mAccess.mWrites)) == 0 &&
+             ((access->mReads | access->mWrites) & b.mAccess.mWrites) == 0;
+    });
+
+    if (batch == batches.end()) {
+      batch = batches.emplace(batches.end());
+    }
+
+    batch->mAccess.mReads |= access->mReads;
+    batch->mAccess.mWrites |= access->mWrites;
+    batch->mPlugins.emplace_back(&name, &plugin);
+  }
+
+  if (batches.empty()) {
+    return;
+  }
+
+  if (!mPluginUpdatePool && std::thread::hardware_concurrency() > 1) {
+    mPluginUpdatePool = std::make_unique<cs::utils::ThreadPool>(
+        std::thread::hardware_concurrency() - 1, "Plugin Update");
+  }
+
+  auto update = [](std::string const& name, Plugin& plugin) {
+    cs::utils::FrameStats::ScopedOwner owner(plugin.mOwnerId);
+    cs::utils::FrameStats::ScopedTimer timer(
+        plugin.mAsyncUpdateTimerId, cs::utils::FrameStats::TimerMode::eCPU);
+
+    try {
+      plugin.mPlugin->updateAsync();
+    } catch (std::runtime_error const& e) {
+      logger().warn("Failed to update plugin '{}' asynchronously: {}", name, e.what());
+    }
+  };
+
+  for (auto const& batch : batches) {
+
+    // The first plugin of each batch is updated on the main thread, the others on worker threads.
+    std::vector<std::future<void>> futures;
+
+    if (mPluginUpdatePool) {
+      for (std::size_t i = 1; i < batch.mPlugins.size(); ++i) {
+        auto [name, plugin] = batch.mPlugins[i];
+        futures.push_back(mPluginUpdatePool->enqueue(
+            cs::utils::ThreadPool::Priority::eHigh, [&update, name = name, plugin = plugin]() {
+              update(*name, *plugin);
+            }));
+      }
+    }
+
+    update(*batch.mPlugins.front().first, *batch.mPlugins.front().second);
+
+    if (!mPluginUpdatePool) {
+      for (std::size_t i = 1; i < batch.mPlugins.size(); ++i) {
+        update(*batch.mPlugins[i].first, *batch.mPlugins[i].second);
+      }
+    }
+
+    for (auto& future : futures) {
+      future.wait();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Application::printPluginInitTimes() const {
+  std::vector<std::pair<double, std::string>> initTimes;
+  double                                      totalTime = 0.0;
+
+  for (auto const& [name, plugin] : mPlugins) {
+    if (plugin.mIsInitialized) {
+      initTimes.emplace_back(plugin.mInitTime, name);
+      totalTime += plugin.mInitTime;
+    }
+  }
+
+  std::sort(initTimes.rbegin(), initTimes.rend());
+
+  // The content which plugins add to the user interface is parsed by the browser asynchronously,
+  // so this is not included here.
+  logger().info("Initialized {} plugins in {:.1f} ms:", initTimes.size(), totalTime);
+
+  for (auto const& [time, name] : initTimes) {
+    logger().info("  {:<30} {:>8.1f} ms", name, time);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Application::deinitPlugin(std::string const& name) {
   auto plugin = mPlugins.find(name);
 
   if (plugin != mPlugins.end()) {
     if (plugin->second.mIsInitialized) {
+      cs::utils::FrameStats::ScopedOwner owner(plugin->second.mOwnerId);
       plugin->second.mPlugin->deInit();
       plugin->second.mIsInitialized = false;
     } else {
@@ -799,6 +1176,11 @@ void Application::closePlugin(std::string const& name) {
   if (plugin != mPlugins.end()) {
     logger().info("Closing plugin '{}'.", plugin->first);
 
+    // The plugin may still be prepared on a worker thread.
+    if (plugin->second.mPrepared.valid()) {
+      plugin->second.mPrepared.wait();
+    }
+
     auto* handle           = plugin->second.mHandle;
     auto  pluginDestructor = // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
         reinterpret_cast<void (*)(cs::core::PluginBase*)>(LIBFUNC(handle, "destroy"));
@@ -807,6 +1189,7 @@ void Application::closePlugin(std::string const& name) {
     CLOSELIB(handle);
 
     mPlugins.erase(plugin);
+    mPluginsToInit.erase(name);
 
   } else {
     logger().warn("Failed to close plugin '{}': No plugin loaded with this name!", name);
@@ -1244,12 +1627,14 @@ void Application::registerGuiCallbacks() {
 
   // Update the side bar field showing the average luminance of the scene.
   mGraphicsEngine->pAverageLuminance.connect([this](float value) {
-    mGuiManager->getGui()->callJavascript("CosmoScout.sidebar.setAverageSceneLuminance", value);
+    mGuiManager->getGui()->callJavascriptCoalesced(
+        "CosmoScout.sidebar.setAverageSceneLuminance", value);
   });
 
   // Update the side bar field showing the maximum luminance of the scene.
   mGraphicsEngine->pMaximumLuminance.connect([this](float value) {
-    mGuiManager->getGui()->callJavascript("CosmoScout.sidebar.setMaximumSceneLuminance", value);
+    mGuiManager->getGui()->callJavascriptCoalesced(
+        "CosmoScout.sidebar.setMaximumSceneLuminance", value);
   });
 
   // Adjusts the amount of ambient lighting.
@@ -1468,6 +1853,12 @@ void Application::registerGuiCallbacks() {
       "Sets the multiplier for the simulation time speed.",
       std::function([this](double speed) { mSettings->pTimeSpeed = static_cast<float>(speed); }));
 
+  // Tells the TimeControl whether the user is currently dragging the timeline.
+  mGuiManager->getGui()->registerCallback("time.setScrubbing",
+      "Call this with true when the user starts dragging the timeline and with false once the user "
+      "stops. In between, time-dependent systems may show a less detailed preview.",
+      std::function([this](bool scrubbing) { mTimeControl->pIsScrubbing = scrubbing; }));
+
   // navigation callbacks --------------------------------------------------------------------------
 
   // Sets the observer position to the given cartesian coordinates.
@@ -1736,5 +2127,6 @@ void Application::unregisterGuiCallbacks() {
   mGuiManager->getGui()->unregisterCallback("time.reset");
   mGuiManager->getGui()->unregisterCallback("time.set");
   mGuiManager->getGui()->unregisterCallback("time.setDate");
+  mGuiManager->getGui()->unregisterCallback("time.setScrubbing");
   mGuiManager->getGui()->unregisterCallback("time.setSpeed");
 }
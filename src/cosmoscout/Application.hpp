@@ -8,9 +8,14 @@
 #ifndef CS_APPLICATION_HPP
 #define CS_APPLICATION_HPP
 
+#include "../cs-utils/FrameStats.hpp"
+
 #include <VistaKernel/VistaFrameLoop.h>
+#include <chrono>
+#include <future>
 #include <limits>
 #include <map>
+#include <nlohmann/json.hpp>
 #include <memory>
 #include <set>
 
@@ -23,6 +28,8 @@
 #endif
 
 class IVistaClusterDataSync;
+class VdfnGraph;
+class Benchmark;
 
 namespace cs::core {
 class PluginBase;
@@ -41,6 +48,7 @@ class MouseRay;
 
 namespace cs::utils {
 class Downloader;
+class ThreadPool;
 } // namespace cs::utils
 
 /// This is the core class of CosmoScout VR. The application and all plugins are initialized and
@@ -84,8 +92,11 @@ class Downloader;
 ///      - Cleanup curl
 class Application : public VistaFrameLoop {
  public:
-  /// This does only inititlize curl.
-  explicit Application(std::shared_ptr<cs::core::Settings> settings);
+  /// This does only inititlize curl. If a benchmark script is given, the camera is moved along the
+  /// paths of this script once all plugins have been loaded and the application quits once the
+  /// benchmark report has been written. See the Benchmark class for details.
+  explicit Application(
+      std::shared_ptr<cs::core::Settings> settings, std::string benchmarkScript = "");
   ~Application() override;
 
   /// Initializes the Application. Should only be called by ViSTA.
@@ -105,6 +116,22 @@ class Application : public VistaFrameLoop {
     COSMOSCOUT_LIBTYPE    mHandle;
     cs::core::PluginBase* mPlugin        = nullptr;
     bool                  mIsInitialized = false;
+
+    /// The time in milliseconds the last call to init() took. This includes the time the main
+    /// thread had to wait for prepare().
+    double mInitTime = 0.0;
+
+    /// Set while prepare() is running on a worker thread, see preparePlugins().
+    std::future<void> mPrepared;
+
+    /// The interned names of the timers which measure the plugin's update() and updateAsync().
+    cs::utils::FrameStats::TimerId mUpdateTimerId{};
+    cs::utils::FrameStats::TimerId mAsyncUpdateTimerId{};
+
+    /// The interned name of the plugin. All methods of the plugin are called within a
+    /// cs::utils::FrameStats::ScopedOwner of this, so that its timers, thread pool tasks, and GPU
+    /// memory are attributed to the plugin.
+    cs::utils::FrameStats::TimerId mOwnerId{};
   };
 
   /// Called whenever the settings are (re-)loaded;
@@ -113,9 +140,35 @@ class Application : public VistaFrameLoop {
   /// Opens a plugin from a shared library. Only the create() method of the plugin is called.
   void openPlugin(std::string const& name);
 
-  /// Calls setAPI() and init() on the given plugin. openPlugin() has to be called before.
+  /// Returns a copy of the settings of the given plugin. This is passed to PluginBase::prepare().
+  nlohmann::json getPluginSettings(std::string const& name) const;
+
+  /// Calls setAPI() on all opened plugins which are not initialized yet and runs their prepare()
+  /// method on worker threads. Plugins whose downloads have not finished yet are skipped. This is
+  /// called each frame while the plugins are initialized at startup.
+  void preparePlugins();
+
+  /// Returns true if all files in the download list which are required by the given plugin are
+  /// available.
+  bool hasDownloadedDataFor(std::string const& plugin) const;
+
+  /// Returns true if the given plugin can be initialized at startup. This is the case if its data
+  /// has been downloaded and if none of its dependencies is still waiting for initialization.
+  bool canInitPlugin(std::string const& plugin) const;
+
+  /// Calls setAPI(), prepare() and init() on the given plugin. openPlugin() has to be called
+  /// before. If preparePlugins() has been called before, this waits for prepare() instead.
   void initPlugin(std::string const& name);
 
+  /// Calls updateAsync() on all initialized plugins which provide it. The plugins are grouped into
+  /// batches whose declared accesses do not conflict. The plugins of a batch are updated in
+  /// parallel on mPluginUpdatePool and the main thread, one batch after another.
+  void updatePluginsAsync();
+
+  /// Prints the time each plugin took to initialize, the slowest plugin first. This is called once
+  /// all plugins have been loaded at startup.
+  void printPluginInitTimes() const;
+
   /// Calls deinit() on the given plugin. initPlugin() has to be called before.
   void deinitPlugin(std::string const& name);
 
@@ -175,13 +228,30 @@ class Application : public VistaFrameLoop {
   std::unique_ptr<cs::core::DragNavigation> mDragNavigation;
   std::map<std::string, Plugin>             mPlugins;
   std::unique_ptr<cs::utils::Downloader>    mDownloader;
+  std::unique_ptr<cs::utils::ThreadPool>    mPluginPreparePool;
+  std::unique_ptr<cs::utils::ThreadPool>    mPluginUpdatePool;
   std::unique_ptr<IVistaClusterDataSync>    mSceneSync;
   std::unique_ptr<cs::graphics::MouseRay>   mMouseRay;
+  std::unique_ptr<Benchmark>                mBenchmark;
+  std::string                               mBenchmarkScript;
+
+  // The graph of the interaction context with the role "HEADPOSE". It is evaluated once more right
+  // before rendering, see Settings::pEnableLateHeadTracking. This is nullptr if there is no such
+  // context, for example on desktop setups.
+  VdfnGraph* mHeadPoseGraph = nullptr;
+
+  // The observer's SPICE frame and center which have been synchronized last. They are only sent
+  // across the network when they change.
+  std::string mLastSyncedFrame;
+  std::string mLastSyncedCenter;
+
+  bool mDownloadedData           = false;
+  bool mLoadedAllPlugins         = false;
+  int  mNextPluginLoadingFrame   = 0;
+  int  mHideLoadingScreenAtFrame = 0;
 
-  bool mDownloadedData            = false;
-  bool mLoadedAllPlugins          = false;
-  int  mStartPluginLoadingAtFrame = 0;
-  int  mHideLoadingScreenAtFrame  = 0;
+  // The plugins which have not been initialized at startup yet.
+  std::set<std::string> mPluginsToInit;
 
   int mOnMessageConnection = -1;
 
@@ -196,8 +266,12 @@ class Application : public VistaFrameLoop {
   // For deferred reloading of settings.
   std::string mSettingsToLoad;
 
-  // For deferred writing of settings.
-  std::string mSettingsToSave;
+  // For deferred writing of settings. The file which is currently written on a worker thread is
+  // stored as well, for error reporting.
+  std::string                           mSettingsToSave;
+  std::future<void>                     mSaveTask;
+  std::string                           mSaveTaskFile;
+  std::chrono::steady_clock::time_point mLastAutosave = std::chrono::steady_clock::now();
 };
 
 #endif // CS_APPLICATION_HPP
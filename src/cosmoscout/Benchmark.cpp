@@ -0,0 +1,501 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Benchmark.hpp"
+
+#include "../cs-core/Settings.hpp"
+#include "../cs-core/SolarSystem.hpp"
+#include "../cs-core/TimeControl.hpp"
+#include "../cs-utils/AnimatedValue.hpp"
+#include "../cs-utils/FrameStats.hpp"
+#include "../cs-utils/convert.hpp"
+#include "../cs-utils/filesystem.hpp"
+#include "cs-version.hpp"
+#include "logger.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/DisplayManager/VistaDisplayManager.h>
+#include <VistaKernel/DisplayManager/VistaWindow.h>
+#include <VistaKernel/VistaSystem.h>
+#include <nlohmann/json.hpp>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// FrameStats::pFrameTime is based on the last-but-one frame. Hence the frame time of a keyframe is
+// available this many frames after the keyframe has been applied.
+constexpr std::size_t FRAME_TIME_LATENCY = 2;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Reads the observer transformations from a Python script written by the csp-recorder plugin.
+// Each call to navigation.setBodyFull() becomes one keyframe, all other lines are ignored. This
+// also ignores the recorded simulation time, as the benchmark uses a fixed simulation time.
+std::vector<Benchmark::Keyframe> loadRecording(std::string const& file) {
+  std::ifstream input(file);
+
+  if (!input) {
+    throw std::runtime_error("Failed to open recording '" + file + "'!");
+  }
+
+  std::regex const setBodyFull(R"(setBodyFull\('([^']*)', '([^']*)', ([^,]+), ([^,]+), ([^,]+), )"
+                               R"(([^,]+), ([^,]+), ([^,]+), ([^,]+),)");
+
+  std::vector<Benchmark::Keyframe> keyframes;
+  std::string                      line;
+  std::smatch                      match;
+
+  while (std::getline(input, line)) {
+    if (std::regex_search(line, match, setBodyFull)) {
+      Benchmark::Keyframe keyframe;
+      keyframe.mCenter   = match[1];
+      keyframe.mFrame    = match[2];
+      keyframe.mPosition =
+          glm::dvec3(std::stod(match[3]), std::stod(match[4]), std::stod(match[5]));
+      keyframe.mRotation = glm::dquat(
+          std::stod(match[9]), std::stod(match[6]), std::stod(match[7]), std::stod(match[8]));
+      keyframes.push_back(std::move(keyframe));
+    }
+  }
+
+  if (keyframes.empty()) {
+    throw std::runtime_error("The recording '" + file + "' contains no observer transformations!");
+  }
+
+  return keyframes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Interpolates between the given poses the same way as SolarSystem::flyObserverTo() does. However,
+// the animation is based on the frame index instead of the real time, so that the same frames are
+// rendered regardless of the frame rate.
+std::vector<Benchmark::Keyframe> interpolateFlight(std::string const& center,
+    std::string const& frame, glm::dvec3 const& startPosition, glm::dquat startRotation,
+    glm::dvec3 const& endPosition, glm::dquat const& endRotation, std::size_t frames) {
+
+  if (frames < 2) {
+    throw std::runtime_error("A flight must consist of at least two frames!");
+  }
+
+  // Else the interpolation would take the long way around the sphere.
+  if (glm::dot(startRotation, endRotation) < 0.0) {
+    startRotation = -startRotation;
+  }
+
+  auto const lastFrame = static_cast<double>(frames - 1);
+
+  cs::utils::AnimatedValue<glm::dvec3> position(startPosition, endPosition, 0.0, lastFrame);
+  cs::utils::AnimatedValue<glm::dquat> rotation(startRotation, endRotation, 0.0, lastFrame);
+
+  std::vector<Benchmark::Keyframe> keyframes(frames);
+
+  for (std::size_t i = 0; i < frames; ++i) {
+    keyframes[i].mCenter   = center;
+    keyframes[i].mFrame    = frame;
+    keyframes[i].mPosition = position.get(static_cast<double>(i));
+    keyframes[i].mRotation = rotation.get(static_cast<double>(i));
+  }
+
+  return keyframes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the given percentile of the sorted values using the nearest-rank method.
+double getPercentile(std::vector<double> const& sortedValues, double percentile) {
+  if (sortedValues.empty()) {
+    return 0.0;
+  }
+
+  auto rank = static_cast<std::size_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(sortedValues.size())));
+
+  return sortedValues[std::clamp<std::size_t>(rank, 1, sortedValues.size()) - 1];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string getGLString(GLenum name) {
+  auto const* value = glGetString(name);
+  return value ? reinterpret_cast<char const*>(value) : ""; // NOLINT
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Benchmark::Benchmark(std::string const& scriptFile, std::shared_ptr<cs::core::Settings> settings,
+    std::shared_ptr<cs::core::SolarSystem> solarSystem,
+    std::shared_ptr<cs::core::TimeControl> timeControl)
+    : mSettings(std::move(settings))
+    , mSolarSystem(std::move(solarSystem))
+    , mTimeControl(std::move(timeControl)) {
+
+  std::ifstream input(scriptFile);
+
+  if (!input) {
+    throw std::runtime_error("Failed to open benchmark script '" + scriptFile + "'!");
+  }
+
+  try {
+    nlohmann::json script;
+    input >> script;
+
+    std::optional<std::string> simulationTime;
+    std::optional<int>         warmupRuns;
+    std::optional<int>         settleFrames;
+    std::optional<double>      loadingTimeout;
+    std::optional<std::string> report;
+    std::optional<std::string> imageDirectory;
+    std::optional<glm::ivec2>  resolution;
+
+    cs::core::Settings::deserialize(script, "simulationTime", simulationTime);
+    cs::core::Settings::deserialize(script, "warmupRuns", warmupRuns);
+    cs::core::Settings::deserialize(script, "settleFrames", settleFrames);
+    cs::core::Settings::deserialize(script, "loadingTimeout", loadingTimeout);
+    cs::core::Settings::deserialize(script, "report", report);
+    cs::core::Settings::deserialize(script, "imageDirectory", imageDirectory);
+    cs::core::Settings::deserialize(script, "resolution", resolution);
+    cs::core::Settings::deserialize(script, "userInterface", mUserInterface);
+
+    mSimulationTime = simulationTime.value_or("");
+    mWarmupRuns     = std::max(0, warmupRuns.value_or(mWarmupRuns));
+    mSettleFrames   = std::max(1, settleFrames.value_or(mSettleFrames));
+    mLoadingTimeout = loadingTimeout.value_or(mLoadingTimeout);
+    mReportFile     = report.value_or(mReportFile);
+    mImageDirectory = imageDirectory.value_or("");
+    mResolution     = resolution.value_or(mResolution);
+
+    for (auto const& j : script.at("segments")) {
+      Segment segment;
+      cs::core::Settings::deserialize(j, "name", segment.mName);
+
+      std::optional<std::string> image;
+      cs::core::Settings::deserialize(j, "image", image);
+      segment.mImage = image.value_or("segment-" + std::to_string(mSegments.size()) + ".png");
+
+      std::optional<std::string> recording;
+      cs::core::Settings::deserialize(j, "recording", recording);
+
+      if (recording) {
+        segment.mKeyframes = loadRecording(*recording);
+      } else {
+        std::string center;
+        std::string frame;
+        glm::dvec3  startPosition{};
+        glm::dquat  startRotation{};
+        glm::dvec3  endPosition{};
+        glm::dquat  endRotation{};
+        std::size_t frames{};
+
+        cs::core::Settings::deserialize(j, "center", center);
+        cs::core::Settings::deserialize(j, "frame", frame);
+        cs::core::Settings::deserialize(j.at("start"), "position", startPosition);
+        cs::core::Settings::deserialize(j.at("start"), "rotation", startRotation);
+        cs::core::Settings::deserialize(j.at("end"), "position", endPosition);
+        cs::core::Settings::deserialize(j.at("end"), "rotation", endRotation);
+        cs::core::Settings::deserialize(j, "frames", frames);
+
+        segment.mKeyframes = interpolateFlight(center, frame, startPosition,
+            glm::normalize(startRotation), endPosition, glm::normalize(endRotation), frames);
+      }
+
+      mSegments.push_back(std::move(segment));
+    }
+
+  } catch (std::exception const& e) {
+    throw std::runtime_error(
+        "Failed to parse benchmark script '" + scriptFile + "': " + std::string(e.what()));
+  }
+
+  if (mSegments.empty()) {
+    throw std::runtime_error("The benchmark script '" + scriptFile + "' contains no segments!");
+  }
+
+  if (!mImageDirectory.empty()) {
+    cs::utils::filesystem::createDirectoryRecursively(mImageDirectory);
+  }
+
+  mResults.reserve(mSegments.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::update(bool isLoading) {
+  if (mPhase == Phase::eFinished) {
+    return;
+  }
+
+  // The simulation time is paused for the whole benchmark, so that the bodies do not move.
+  if (!mStarted) {
+    mStarted              = true;
+    mSettings->pTimeSpeed = 0.F;
+
+    if (!mSimulationTime.empty()) {
+      mTimeControl->setTime(cs::utils::convert::time::toSpice(mSimulationTime));
+    }
+
+    if (mUserInterface) {
+      mSettings->pEnableUserInterface = *mUserInterface;
+    }
+
+    // All windows are resized, so that the same number of pixels is rendered on each machine.
+    if (mResolution.x > 0 && mResolution.y > 0) {
+      for (auto const& window : GetVistaSystem()->GetDisplayManager()->GetWindows()) {
+        window.second->GetWindowProperties()->SetSize(mResolution.x, mResolution.y);
+      }
+    }
+
+    cs::utils::FrameStats::get().pEnableMeasurements = true;
+
+    logger().info("Starting benchmark with {} segments.", mSegments.size());
+    startSegment(0);
+  }
+
+  auto const& keyframes = mSegments[mCurrentSegment].mKeyframes;
+
+  switch (mPhase) {
+  case Phase::eWarmup:
+    applyKeyframe(keyframes[mFrame]);
+
+    if (++mFrame == keyframes.size()) {
+      mFrame = 0;
+
+      if (++mWarmupRun >= mWarmupRuns) {
+        startLoading();
+      }
+    }
+    break;
+
+  case Phase::eLoading: {
+    mSettledFrames = isLoading ? 0 : mSettledFrames + 1;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - mLoadingStart;
+    bool                          timeout = elapsed.count() > mLoadingTimeout;
+
+    if (mSettledFrames >= mSettleFrames || timeout) {
+      if (timeout) {
+        logger().warn("Data of segment '{}' is still loading after {} seconds. Measuring anyway.",
+            mSegments[mCurrentSegment].mName, mLoadingTimeout);
+      }
+
+      Result result;
+      result.mName        = mSegments[mCurrentSegment].mName;
+      result.mLoadingTime = elapsed.count();
+      result.mTimedOut    = timeout;
+      result.mFrameTimes.reserve(keyframes.size());
+      mResults.push_back(std::move(result));
+
+      mPhase = Phase::eMeasuring;
+      mFrame = 0;
+    }
+    break;
+  }
+
+  case Phase::eMeasuring:
+    if (mFrame >= FRAME_TIME_LATENCY) {
+      mResults.back().mFrameTimes.push_back(cs::utils::FrameStats::get().pFrameTime.get());
+      recordTimers();
+    }
+
+    // The last keyframe has been rendered in the previous frame.
+    if (mFrame == keyframes.size() && !mImageDirectory.empty()) {
+      saveImage();
+    }
+
+    if (mFrame < keyframes.size()) {
+      applyKeyframe(keyframes[mFrame]);
+    }
+
+    if (++mFrame == keyframes.size() + FRAME_TIME_LATENCY) {
+      finishSegment();
+    }
+    break;
+
+  case Phase::eFinished:
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Benchmark::getIsFinished() const {
+  return mPhase == Phase::eFinished;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::applyKeyframe(Keyframe const& keyframe) {
+  // A duration of zero moves the observer immediately.
+  mSolarSystem->flyObserverTo(
+      keyframe.mCenter, keyframe.mFrame, keyframe.mPosition, keyframe.mRotation, 0.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::recordTimers() {
+  auto& timers = mResults.back().mTimers;
+
+  // The timer query results are one frame behind as well, like the frame time.
+  for (auto const& range : cs::utils::FrameStats::get().getTimerQueryResults()) {
+    auto& timer = timers[cs::utils::FrameStats::getName(range.mId)];
+    timer.mCPUTime += static_cast<double>(range.mCPUEnd - range.mCPUStart) * 1e-6;
+    timer.mGPUTime += static_cast<double>(range.mGPUEnd - range.mGPUStart) * 1e-6;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::saveImage() {
+  auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+
+  int width  = 0;
+  int height = 0;
+  window->GetWindowProperties()->GetSize(width, height);
+
+  std::vector<std::byte> pixels(static_cast<std::size_t>(width) * height * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+  std::string file = mImageDirectory + "/" + mSegments[mCurrentSegment].mImage;
+
+  stbi_flip_vertically_on_write(1);
+  if (stbi_write_png(file.c_str(), width, height, 3, pixels.data(), width * 3) == 0) {
+    logger().error("Failed to write benchmark image to '{}'!", file);
+  } else {
+    mResults.back().mImage = file;
+  }
+  stbi_flip_vertically_on_write(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::startSegment(std::size_t index) {
+  mCurrentSegment = index;
+  mFrame          = 0;
+  mWarmupRun      = 0;
+
+  logger().info("Benchmarking segment '{}'...", mSegments[index].mName);
+
+  if (mWarmupRuns > 0) {
+    mPhase = Phase::eWarmup;
+  } else {
+    startLoading();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::startLoading() {
+  applyKeyframe(mSegments[mCurrentSegment].mKeyframes.front());
+
+  mPhase         = Phase::eLoading;
+  mSettledFrames = 0;
+  mLoadingStart  = std::chrono::steady_clock::now();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::finishSegment() {
+  auto& result = mResults.back();
+  std::sort(result.mFrameTimes.begin(), result.mFrameTimes.end());
+
+  logger().info("Segment '{}': p50 = {:.2f} ms, p95 = {:.2f} ms, p99 = {:.2f} ms", result.mName,
+      getPercentile(result.mFrameTimes, 50.0), getPercentile(result.mFrameTimes, 95.0),
+      getPercentile(result.mFrameTimes, 99.0));
+
+  if (mCurrentSegment + 1 < mSegments.size()) {
+    startSegment(mCurrentSegment + 1);
+  } else {
+    writeReport();
+    mPhase = Phase::eFinished;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::writeReport() const {
+  nlohmann::json report;
+  report["version"]        = CS_PROJECT_VERSION;
+  report["renderer"]       = getGLString(GL_RENDERER);
+  report["vendor"]         = getGLString(GL_VENDOR);
+  report["glVersion"]      = getGLString(GL_VERSION);
+  report["simulationTime"] =
+      cs::utils::convert::time::toString(mTimeControl->pSimulationTime.get());
+  report["segments"]       = nlohmann::json::array();
+
+  for (auto const& result : mResults) {
+    auto const& times = result.mFrameTimes;
+
+    double mean = 0.0;
+    if (!times.empty()) {
+      mean = std::accumulate(times.begin(), times.end(), 0.0) / static_cast<double>(times.size());
+    }
+
+    // All frame times are given in milliseconds.
+    nlohmann::json frameTime;
+    frameTime["min"]  = times.empty() ? 0.0 : times.front();
+    frameTime["mean"] = mean;
+    frameTime["p50"]  = getPercentile(times, 50.0);
+    frameTime["p95"]  = getPercentile(times, 95.0);
+    frameTime["p99"]  = getPercentile(times, 99.0);
+    frameTime["max"]  = times.empty() ? 0.0 : times.back();
+
+    // The FrameStats timings are given as mean values per frame in milliseconds.
+    nlohmann::json timers = nlohmann::json::object();
+    auto           frames = static_cast<double>(std::max<std::size_t>(times.size(), 1));
+
+    for (auto const& [name, timer] : result.mTimers) {
+      timers[name] = {{"cpu", timer.mCPUTime / frames}, {"gpu", timer.mGPUTime / frames}};
+    }
+
+    nlohmann::json segment;
+    segment["name"]           = result.mName;
+    segment["frames"]         = times.size();
+    segment["loadingTime"]    = result.mLoadingTime;
+    segment["loadingTimeout"] = result.mTimedOut;
+    segment["frameTime"]      = frameTime;
+    segment["timers"]         = timers;
+
+    if (!result.mImage.empty()) {
+      segment["image"] = result.mImage;
+    }
+
+    report["segments"].push_back(segment);
+  }
+
+  std::ofstream output(mReportFile);
+
+  if (!output) {
+    logger().error("Failed to write benchmark report to '{}'!", mReportFile);
+    return;
+  }
+
+  output << report.dump(2) << std::endl;
+
+  logger().info("Benchmark report has been written to '{}'.", mReportFile);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
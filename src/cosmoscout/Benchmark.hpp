@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_BENCHMARK_HPP
+#define CS_BENCHMARK_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cs::core {
+class Settings;
+class SolarSystem;
+class TimeControl;
+} // namespace cs::core
+
+/// The Benchmark is used if CosmoScout VR is started with the --benchmark <script> command line
+/// option. It moves the observer along the camera paths given in the script, measures the frame
+/// times and writes a JSON report. Once the report has been written, the application quits. This
+/// allows comparing the performance of different builds, settings or driver versions objectively.
+///
+/// The script is a JSON file like this:
+/// {
+///   "simulationTime": "2022-06-21T12:00:00.000", // The simulation time is fixed to this value.
+///   "warmupRuns": 1,        // Each path is flown this often before it is measured.
+///   "settleFrames": 10,     // For this many frames, no plugin may be loading before measuring.
+///   "loadingTimeout": 120,  // Measuring starts after this many seconds in any case.
+///   "report": "benchmark-report.json",
+///   "resolution": [1280, 720],  // Optional, the window is resized to this resolution.
+///   "userInterface": false,     // Optional, whether the user interface should be shown.
+///   "imageDirectory": "images", // Optional, the last frame of each segment is saved there.
+///   "segments": [
+///     {
+///       "name": "Approach Earth",
+///       "center": "Earth",
+///       "frame": "IAU_Earth",
+///       "start": {"position": [0, 0, 2e7], "rotation": [0, 0, 0, 1]},
+///       "end": {"position": [0, 0, 7e6], "rotation": [0, 0, 0, 1]},
+///       "frames": 600
+///     },
+///     {
+///       "name": "Recorded Flight",
+///       "recording": "recording-2022-06-21-12-00-00-000.py",
+///       "image": "recorded-flight.png" // Optional, defaults to segment-<index>.png.
+///     }
+///   ]
+/// }
+///
+/// A segment is either a flight between two poses like SolarSystem::flyObserverTo() or a recording
+/// of the csp-recorder plugin. Flights are interpolated over the given number of frames and each
+/// recorded observer transformation is shown for one frame. This way, exactly the same images are
+/// rendered in each run, regardless of how fast they are rendered.
+///
+/// Each segment is processed in three phases:
+///   1. The path is flown warmupRuns times, so that the tile caches contain all data required for
+///      the path.
+///   2. The observer is moved to the start of the path and the benchmark waits until no plugin
+///      reports to be loading data (see cs::core::PluginBase::getIsLoading()).
+///   3. The path is flown once more and the frame time of each frame is recorded. The
+///      FrameStats timings are recorded as well. If an image directory is given, the last frame of
+///      the path is saved as PNG image, so that it can be compared to a reference image.
+///
+/// Together with the vista_headless.ini and the run_headless.sh script, this can be used to track
+/// the rendering performance on continuous integration machines without a display.
+class Benchmark {
+ public:
+  /// One observer transformation. It is shown for exactly one frame.
+  struct Keyframe {
+    std::string mCenter;
+    std::string mFrame;
+    glm::dvec3  mPosition;
+    glm::dquat  mRotation;
+  };
+
+  /// Reads the given script. Throws a std::runtime_error if the script or one of the recordings it
+  /// refers to cannot be read.
+  Benchmark(std::string const& scriptFile, std::shared_ptr<cs::core::Settings> settings,
+      std::shared_ptr<cs::core::SolarSystem> solarSystem,
+      std::shared_ptr<cs::core::TimeControl> timeControl);
+
+  Benchmark(Benchmark const& other) = delete;
+  Benchmark(Benchmark&& other)      = delete;
+
+  Benchmark& operator=(Benchmark const& other) = delete;
+  Benchmark& operator=(Benchmark&& other)      = delete;
+
+  ~Benchmark() = default;
+
+  /// This is called once a frame by the Application once the loading screen has been hidden. It
+  /// has to be called before the SolarSystem is updated. isLoading should be true if any plugin is
+  /// still loading data.
+  void update(bool isLoading);
+
+  /// Returns true once all segments have been measured and the report has been written.
+  bool getIsFinished() const;
+
+ private:
+  enum class Phase { eWarmup, eLoading, eMeasuring, eFinished };
+
+  struct Segment {
+    std::string           mName;
+    std::string           mImage;
+    std::vector<Keyframe> mKeyframes;
+  };
+
+  /// The accumulated time of all FrameStats ranges with the same name in milliseconds.
+  struct TimerResult {
+    double mCPUTime = 0.0;
+    double mGPUTime = 0.0;
+  };
+
+  struct Result {
+    std::string mName;
+    double      mLoadingTime = 0.0;
+    bool        mTimedOut    = false;
+    std::string mImage;
+
+    /// The frame times in milliseconds, sorted in ascending order.
+    std::vector<double> mFrameTimes;
+
+    /// The summed FrameStats timings of all measured frames.
+    std::map<std::string, TimerResult> mTimers;
+  };
+
+  void applyKeyframe(Keyframe const& keyframe);
+  void recordTimers();
+  void saveImage();
+  void startSegment(std::size_t index);
+  void startLoading();
+  void finishSegment();
+  void writeReport() const;
+
+  std::shared_ptr<cs::core::Settings>    mSettings;
+  std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
+  std::shared_ptr<cs::core::TimeControl> mTimeControl;
+
+  std::string          mSimulationTime;
+  int                  mWarmupRuns     = 1;
+  int                  mSettleFrames   = 10;
+  double               mLoadingTimeout = 120.0;
+  std::string          mReportFile     = "benchmark-report.json";
+  std::string          mImageDirectory;
+  glm::ivec2           mResolution{0, 0};
+  std::optional<bool>  mUserInterface;
+  std::vector<Segment> mSegments;
+  std::vector<Result>  mResults;
+
+  bool        mStarted        = false;
+  Phase       mPhase          = Phase::eWarmup;
+  std::size_t mCurrentSegment = 0;
+  std::size_t mFrame          = 0;
+  int         mWarmupRun      = 0;
+  int         mSettledFrames  = 0;
+
+  std::chrono::steady_clock::time_point mLoadingStart;
+};
+
+#endif // CS_BENCHMARK_HPP
@@ -9,6 +9,7 @@
 
 #include "../cs-core/SolarSystem.hpp"
 #include "../cs-gui/GuiItem.hpp"
+#include "../cs-utils/convert.hpp"
 
 #include <VistaAspects/VistaPropertyAwareable.h>
 
@@ -144,10 +145,21 @@ bool ObserverNavigationNode::DoEvalNode() {
   vTranslation.z *= mMaxLinearSpeed[2];
   vTranslation *= mLinearSpeed.get(dTtime);
 
+  auto& oObs = mSolarSystem->getObserver();
+
+  // Report the velocity of the observer so that data can be prefetched along its path. The offset
+  // is a one-time change and therefore not part of the velocity. Once the observer stops moving,
+  // the velocity is reset once.
+  if (vTranslation != glm::dvec3(0.0) || mIsMovingObserver) {
+    double now =
+        cs::utils::convert::time::toSpice(boost::posix_time::microsec_clock::universal_time());
+    oObs.setVelocity(oObs.getRotation() * vTranslation * oObs.getScale(), now);
+    mIsMovingObserver = vTranslation != glm::dvec3(0.0);
+  }
+
   vTranslation *= dDeltaTime;
   vTranslation += vOffset;
 
-  auto& oObs = mSolarSystem->getObserver();
   oObs.setPosition(oObs.getPosition() + oObs.getRotation() * vTranslation * oObs.getScale());
 
   auto       qRotation     = mAngularDirection;
@@ -61,6 +61,7 @@ class ObserverNavigationNode : public IVdfnNode {
   const double                     mLinearDeceleration;
 
   double mLastTime;
+  bool   mIsMovingObserver = false;
 };
 
 class ObserverNavigationNodeCreate : public VdfnNodeFactory::IVdfnNodeCreator {
@@ -48,6 +48,7 @@ int main(int argc, char** argv) {
 
   // These are the default values for the options.
   std::string settingsFile   = "../share/config/simple_desktop.json";
+  std::string benchmarkFile;
   bool        runTests       = false;
   bool        printHelp      = false;
   bool        printVistaHelp = false;
@@ -56,6 +57,9 @@ int main(int argc, char** argv) {
   cs::utils::CommandLine args("Welcome to CosmoScout VR! Here are the available options:");
   args.addArgument({"-s", "--settings"}, &settingsFile,
       "JSON file containing settings (default: " + settingsFile + ")");
+  args.addArgument({"-b", "--benchmark"}, &benchmarkFile,
+      "JSON file describing camera paths along which the frame times are measured. A report is "
+      "written once all paths have been flown, then CosmoScout VR quits.");
   args.addArgument({"-h", "--help"}, &printHelp, "Print this help.");
   args.addArgument({"-v", "--vistahelp"}, &printVistaHelp, "Print help for vista options.");
 
@@ -127,7 +131,7 @@ int main(int argc, char** argv) {
     pVistaSystem->SetIniSearchPaths({"../share/config/vista"});
 
     // The Application contains a lot of initialization code and the frame update.
-    Application app(settings);
+    Application app(settings, benchmarkFile);
     pVistaSystem->SetFrameLoop(&app, true);
 
     // Now run the program!
@@ -17,6 +17,7 @@
 #include <VistaDataFlowNet/VdfnObjectRegistry.h>
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
 #include <VistaKernel/VistaSystem.h>
+#include <cmath>
 #include <glm/gtx/io.hpp>
 #include <utility>
 
@@ -41,6 +42,14 @@ std::optional<double> IntersectSphere(glm::dvec3 const& origin, glm::dvec3 const
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// The kinetic smoothing is simulated with this many steps per second, regardless of the frame rate.
+double const STEPS_PER_SECOND = 60.0;
+
+// When the observer is released, its rotation per step is reduced by this factor each step.
+double const SMOOTHING = 0.8;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace
 
 namespace cs::core {
@@ -53,15 +62,40 @@ DragNavigation::DragNavigation(std::shared_ptr<cs::core::SolarSystem> pSolarSyst
     : mSolarSystem(std::move(pSolarSystem))
     , mInputManager(std::move(pInputManager))
     , mTimeControl(std::move(pTimeControl))
-
-{
+    , mTimestep(1.0 / STEPS_PER_SECOND) {
   mSelectionTrans = dynamic_cast<VistaTransformNode*>(
       GetVistaSystem()->GetGraphicsManager()->GetSceneGraph()->GetNode("SELECTION_NODE"));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+double DragNavigation::advanceKineticRotation(uint32_t steps) {
+  // The part of the current step which has been applied during the last frame has to be removed,
+  // as it is contained in the first of the completed steps.
+  double angle = -mPartialAngle;
+
+  for (uint32_t i = 0; i < steps; ++i) {
+    mTargetAngle *= SMOOTHING;
+    angle += mTargetAngle;
+  }
+
+  // Then the part of the next step which has already elapsed is added, so that the motion is smooth
+  // even if the frame rate is higher than the simulation rate.
+  mPartialAngle = mTimestep.getAlpha() * mTargetAngle * SMOOTHING;
+
+  return angle + mPartialAngle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void DragNavigation::update() {
+  double now = utils::convert::time::toSpice(boost::posix_time::microsec_clock::universal_time());
+
+  // The smoothing is simulated in fixed steps. The number of steps which elapsed since the last
+  // frame determines how much the angles decay during this frame.
+  uint32_t steps = mTimestep.advance(now);
+  double   decay = std::pow(SMOOTHING, steps);
+
   // current observer transform of this frame
   glm::dvec3 observerPos = mSolarSystem->getObserver().getPosition();
   glm::dquat observerRot = mSolarSystem->getObserver().getRotation();
@@ -134,7 +168,9 @@ void DragNavigation::update() {
     return;
   }
 
-  double const smoothThreshold = 0.8;
+  // While dragging, this is the total rotation since the interaction started. Else it is the
+  // rotation which is applied during this frame.
+  double rotationAngle = 0.0;
 
   if (mInputManager->pButtons[0].get() || mInputManager->pButtons[1].get()) {
     glm::dvec3 endVec;
@@ -208,6 +244,9 @@ void DragNavigation::update() {
         mCurrentAngleDiff   = 0;
         mDoKineticSmoothOut = false;
       }
+
+      rotationAngle = mTargetAngle;
+      mPartialAngle = 0.0;
     } else {
       // Update camera for smoothing out even though button is pressed but
       // outside the ideal sphere
@@ -219,10 +258,11 @@ void DragNavigation::update() {
         // Reduce inertia a little.
         mTargetAngle      = mCurrentAngleDiff * 0.5;
         mCurrentAngleDiff = 0.0;
+        mPartialAngle     = 0.0;
       }
 
       // Smooth out remaining rotation do be done
-      mTargetAngle        = smoothThreshold * mTargetAngle;
+      rotationAngle       = advanceKineticRotation(steps);
       mDoKineticSmoothOut = true;
     }
   } else {
@@ -235,30 +275,45 @@ void DragNavigation::update() {
         mTargetAngle = 0.0;
       }
       mCurrentAngleDiff = 0.0;
+      mPartialAngle     = 0.0;
     }
 
     // Smooth out remaining rotation do be done
-    mTargetAngle = smoothThreshold * mTargetAngle;
+    rotationAngle = advanceKineticRotation(steps);
 
     double const epsilon = 0.001;
     if (std::abs(mTargetAngle) < epsilon) {
       mTargetAngle      = 0.0;
+      mPartialAngle     = 0.0;
       mLocalRotation    = false;
       mDoRollCorrection = false;
     }
   }
 
   // Softly increasing the absolute rotation angle value
-  mCurrentAngleDiff = smoothThreshold * mCurrentAngleDiff;
+  mCurrentAngleDiff = decay * mCurrentAngleDiff;
 
   // apply observer position change if rotating planet
   if (!mLocalRotation) {
     glm::dvec3 newObserverPos =
-        (glm::rotate(mTargetAngle, mCurrentAxis) * glm::dvec4(mStartObserverPos, 1.0)).xyz();
+        (glm::rotate(rotationAngle, mCurrentAxis) * glm::dvec4(mStartObserverPos, 1.0)).xyz();
     mSolarSystem->getObserver().setPosition(newObserverPos);
+
+    // Report the velocity of the observer so that data can be prefetched along its path. Once the
+    // observer stops moving, the velocity is reset once.
+    double dt = now - mLastUpdateTime;
+    if (newObserverPos != observerPos && dt > 0.0) {
+      mSolarSystem->getObserver().setVelocity((newObserverPos - observerPos) / dt, now);
+      mIsMovingObserver = true;
+    } else if (mIsMovingObserver) {
+      mSolarSystem->getObserver().setVelocity(glm::dvec3(0.0), now);
+      mIsMovingObserver = false;
+    }
   }
 
-  glm::dquat newObserverRot = glm::angleAxis(mTargetAngle, mCurrentAxis) * mStartObserverRot;
+  mLastUpdateTime = now;
+
+  glm::dquat newObserverRot = glm::angleAxis(rotationAngle, mCurrentAxis) * mStartObserverRot;
 
   if (mLocalRotation && mSolarSystem->pActiveObject.get()) {
     // perform roll correction if observer is close to planet (10% of
@@ -10,6 +10,8 @@
 
 #include "cs_core_export.hpp"
 
+#include "../cs-utils/FixedTimestep.hpp"
+
 #include <VistaKernel/VistaKernelConfig.h>
 
 #include <VistaBase/VistaVectorMath.h>
@@ -32,6 +34,11 @@ class SolarSystem;
 
 /// This class contains the logic for picking, dragging and rotating planets. It is used for the
 /// mouse interaction as well as the flystick and HTC-Vive interaction.
+///
+/// When the planet is released, it keeps rotating for a while and slows down gradually. This
+/// kinetic smoothing is simulated with a fixed time step, so the motion is the same regardless of
+/// the frame rate. The resulting velocity of the observer is reported with
+/// CelestialObserver::setVelocity().
 class CS_CORE_EXPORT DragNavigation {
  public:
   DragNavigation(std::shared_ptr<cs::core::SolarSystem> pSolarSystem,
@@ -49,6 +56,10 @@ class CS_CORE_EXPORT DragNavigation {
   void update();
 
  private:
+  /// Advances the rotation of a released planet by the given number of simulation steps and returns
+  /// the angle by which the observer has to be rotated during this frame.
+  double advanceKineticRotation(uint32_t steps);
+
   std::shared_ptr<cs::core::SolarSystem>  mSolarSystem;
   std::shared_ptr<cs::core::InputManager> mInputManager;
   std::shared_ptr<cs::core::TimeControl>  mTimeControl;
@@ -64,6 +75,11 @@ class CS_CORE_EXPORT DragNavigation {
   double     mCurrentAngleDiff            = 0.0;
   glm::dvec3 mCurrentAxis                 = glm::dvec3(1.0, 0.0, 0.0);
 
+  utils::FixedTimestep mTimestep;
+  double               mPartialAngle     = 0.0;
+  double               mLastUpdateTime   = 0.0;
+  bool                 mIsMovingObserver = false;
+
   glm::dvec3 mStartIntersection = glm::dvec3(0.0);
   glm::dvec3 mStartRayDir       = glm::dvec3(0.0);
   glm::dvec3 mStartObserverPos  = glm::dvec3(0.0);
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "DrawList.hpp"
+
+#include "../cs-scene/CelestialObject.hpp"
+#include "GraphicsEngine.hpp"
+#include "SolarSystem.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <array>
+#include <glm/gtc/matrix_access.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/component_wise.hpp>
+
+namespace cs::core {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double DrawList::Drawable::getBoundingRadius(scene::CelestialObject const& object) const {
+  return glm::compMax(object.getRadii());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t DrawList::Drawable::getStateKey() const {
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DrawList::DrawList(std::shared_ptr<GraphicsEngine> graphicsEngine,
+    std::shared_ptr<SolarSystem> solarSystem, std::string const& name, int sortKey)
+    : mGraphicsEngine(std::move(graphicsEngine))
+    , mSolarSystem(std::move(solarSystem)) {
+
+  // Nothing has to be done if there are no drawables.
+  mRenderPass = mGraphicsEngine->addRenderPass(
+      name, sortKey, [this]() { draw(); }, [this]() { return !mDrawables.empty(); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DrawList::~DrawList() {
+  mGraphicsEngine->removeRenderPass(mRenderPass);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DrawList::add(Drawable* drawable) {
+  mDrawables.push_back(drawable);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DrawList::remove(Drawable* drawable) {
+  mDrawables.erase(
+      std::remove(mDrawables.begin(), mDrawables.end(), drawable), mDrawables.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DrawList::draw() {
+  std::array<GLfloat, 16> glMatV{};
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMatV.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+
+  glm::dmat4 matVP =
+      glm::dmat4(glm::make_mat4x4(glMatP.data())) * glm::dmat4(glm::make_mat4x4(glMatV.data()));
+
+  // We only use the four side planes of the view frustum. They all pass through the observer, so
+  // together they also reject everything behind the observer. The far plane of the reversed,
+  // infinite projection is at infinity and the near plane is so close to the observer that it
+  // would not cull anything anyways.
+  std::array<glm::dvec4, 4> planes{
+      glm::row(matVP, 3) + glm::row(matVP, 0),
+      glm::row(matVP, 3) - glm::row(matVP, 0),
+      glm::row(matVP, 3) + glm::row(matVP, 1),
+      glm::row(matVP, 3) - glm::row(matVP, 1),
+  };
+
+  for (auto& plane : planes) {
+    plane /= glm::length(glm::dvec3(plane));
+  }
+
+  mVisibleEntries.clear();
+
+  for (auto* drawable : mDrawables) {
+    auto object = mSolarSystem->getObject(drawable->getObjectName());
+
+    if (!object || !object->getIsBodyVisible()) {
+      continue;
+    }
+
+    auto const& transform = object->getObserverRelativeTransform();
+    glm::dvec3  center(transform[3]);
+
+    double radius = drawable->getBoundingRadius(*object) * glm::length(glm::dvec3(transform[0]));
+
+    bool visible = std::all_of(planes.begin(), planes.end(), [&](glm::dvec4 const& plane) {
+      return glm::dot(glm::dvec3(plane), center) + plane.w > -radius;
+    });
+
+    if (visible) {
+      mVisibleEntries.push_back({drawable, drawable->getStateKey(), glm::length(center) - radius});
+    }
+  }
+
+  // Drawables which share a state are drawn one after another. Within each state, closer drawables
+  // are drawn first, so that the ones behind them are rejected by the depth test before they are
+  // shaded.
+  std::sort(mVisibleEntries.begin(), mVisibleEntries.end(), [](Entry const& a, Entry const& b) {
+    if (a.mStateKey != b.mStateKey) {
+      return a.mStateKey < b.mStateKey;
+    }
+    return a.mDistance < b.mDistance;
+  });
+
+  for (auto const& entry : mVisibleEntries) {
+    entry.mDrawable->draw();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::core
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_CORE_DRAW_LIST_HPP
+#define CS_CORE_DRAW_LIST_HPP
+
+#include "cs_core_export.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cs::scene {
+class CelestialObject;
+} // namespace cs::scene
+
+namespace cs::core {
+
+class GraphicsEngine;
+class SolarSystem;
+
+/// Usually, each drawable object adds its own VistaOpenGLNode to the scene graph and is drawn
+/// whenever ViSTA traverses it. A DrawList instead collects many objects of the same kind in one
+/// render pass. For each view, it culls the registered drawables against the view frustum using a
+/// bounding sphere around their CelestialObject, sorts the remaining ones by their state key and
+/// draws them front-to-back within each state. This way, objects which share a shader are drawn
+/// one after another and objects outside the view frustum do not cost anything.
+/// All objects which are not registered with a DrawList are still traversed by ViSTA as before.
+class CS_CORE_EXPORT DrawList {
+ public:
+  /// All objects which should be drawn by a DrawList have to be derived from Drawable.
+  class CS_CORE_EXPORT Drawable {
+   public:
+    /// The drawable is culled with a bounding sphere around this object. If the object does not
+    /// exist or if its getIsBodyVisible() returns false, draw() is not called at all.
+    virtual std::string const& getObjectName() const = 0;
+
+    /// The radius of the bounding sphere in meters. The default implementation returns the largest
+    /// radius of the object. Drawables which extend beyond this, such as rings, have to override
+    /// this.
+    virtual double getBoundingRadius(scene::CelestialObject const& object) const;
+
+    /// Drawables with the same state key are drawn one after another. Typically, this is derived
+    /// from the address of the shader which is used by draw(). The default implementation returns
+    /// zero.
+    virtual uint64_t getStateKey() const;
+
+    /// This will be called once for each view in which the bounding sphere is visible. The
+    /// GL_MODELVIEW matrix will contain the view matrix, just like in IVistaOpenGLDraw::Do().
+    virtual void draw() = 0;
+
+    virtual ~Drawable() = default;
+  };
+
+  /// Creates a new render pass with the given name and sort key. The name is also used for the
+  /// timer in the FrameStats.
+  DrawList(std::shared_ptr<GraphicsEngine> graphicsEngine,
+      std::shared_ptr<SolarSystem> solarSystem, std::string const& name, int sortKey);
+
+  DrawList(DrawList const& other) = delete;
+  DrawList(DrawList&& other)      = delete;
+
+  DrawList& operator=(DrawList const& other) = delete;
+  DrawList& operator=(DrawList&& other) = delete;
+
+  ~DrawList();
+
+  /// Drawables have to be removed before they are destroyed.
+  void add(Drawable* drawable);
+  void remove(Drawable* drawable);
+
+ private:
+  void draw();
+
+  struct Entry {
+    Drawable* mDrawable;
+    uint64_t  mStateKey;
+    double    mDistance;
+  };
+
+  std::shared_ptr<GraphicsEngine> mGraphicsEngine;
+  std::shared_ptr<SolarSystem>    mSolarSystem;
+  std::vector<Drawable*>          mDrawables;
+
+  // This is reused for each view, so that no memory has to be allocated during drawing.
+  std::vector<Entry> mVisibleEntries;
+
+  int mRenderPass = -1;
+};
+
+} // namespace cs::core
+
+#endif // CS_CORE_DRAW_LIST_HPP
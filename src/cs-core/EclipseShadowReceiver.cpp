@@ -15,7 +15,7 @@
 #include "SolarSystem.hpp"
 
 #include <VistaOGLExt/VistaGLSLShader.h>
-#include <glm/gtc/type_ptr.hpp>
+#include <cstring>
 #include <utility>
 
 namespace cs::core {
@@ -31,8 +31,14 @@ EclipseShadowReceiver::EclipseShadowReceiver(std::shared_ptr<Settings> settings,
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+EclipseShadowReceiver::~EclipseShadowReceiver() {
+  glDeleteBuffers(1, &mUniformBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool EclipseShadowReceiver::needsRecompilation() const {
-  return mLastEclipseShadowMode != mSettings->mGraphics.pEclipseShadowMode.get();
+  return mLastEclipseShadowMode != getEffectiveMode();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -45,11 +51,11 @@ std::string EclipseShadowReceiver::getShaderSnippet() const {
 
   // Inject the current eclipse mode into a copy of the string.
   auto copy = code;
-  cs::utils::replaceString(copy, "ECLIPSE_MODE",
-      cs::utils::toString(static_cast<int>(mSettings->mGraphics.pEclipseShadowMode.get())));
+  cs::utils::replaceString(
+      copy, "ECLIPSE_MODE", cs::utils::toString(static_cast<int>(getEffectiveMode())));
 
   // Store the last use mode. This is required for needsRecompilation().
-  mLastEclipseShadowMode = mSettings->mGraphics.pEclipseShadowMode.get();
+  mLastEclipseShadowMode = getEffectiveMode();
 
   return copy;
 }
@@ -60,10 +66,13 @@ void EclipseShadowReceiver::init(VistaGLSLShader* shader, uint32_t textureOffset
   mShader        = shader;
   mTextureOffset = textureOffset;
 
-  mUniforms.sun          = glGetUniformLocation(shader->GetProgram(), "uEclipseSun");
-  mUniforms.numOccluders = glGetUniformLocation(shader->GetProgram(), "uEclipseNumOccluders");
-  mUniforms.occluders    = glGetUniformLocation(shader->GetProgram(), "uEclipseOccluders");
-  mUniforms.shadowMaps   = glGetUniformLocation(shader->GetProgram(), "uEclipseShadowMaps");
+  mUniforms.shadowMaps = glGetUniformLocation(shader->GetProgram(), "uEclipseShadowMaps");
+
+  // The block is not active if the shader does not compute any eclipse shadows.
+  GLuint blockIndex = glGetUniformBlockIndex(shader->GetProgram(), "EclipseShadows");
+  if (blockIndex != GL_INVALID_INDEX) {
+    glUniformBlockBinding(shader->GetProgram(), blockIndex, UNIFORM_BUFFER_BINDING);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -72,21 +81,42 @@ void EclipseShadowReceiver::update(scene::CelestialObject const& shadowReceiver)
 
   // No eclipse computation required if lighting is disabled.
   if (!mSettings->mGraphics.pEnableLighting.get()) {
-    mShadowMaps.clear();
+    mCasters.clear();
     return;
   }
 
-  // Acquire a list of all potentially relevant eclipse shadow maps.
-  mShadowMaps = mSolarSystem->getEclipseShadowMaps(shadowReceiver, mAllowSelfShadowing);
+  // Acquire a list of all potentially relevant eclipse shadow casters. Their positions and radii
+  // have already been computed by the SolarSystem for this frame.
+  mSolarSystem->getEclipseShadowCasters(shadowReceiver, mAllowSelfShadowing, mCasters);
+
+  if (mCasters.size() > MAX_BODIES) {
+    mCasters.resize(MAX_BODIES);
+  }
+
+  UniformBlock block;
+  block.mSun          = mSolarSystem->getEclipseSun();
+  block.mNumOccluders = static_cast<int32_t>(mCasters.size());
+
+  for (size_t i(0); i < mCasters.size(); ++i) {
+    block.mOccluders.at(i)                                = mCasters[i].mSphere;
+    block.mShadowMapLayers[static_cast<glm::length_t>(i)] = mCasters[i].mShadowMap->mLayer;
+  }
 
-  // For each shadow-casting body, we store the observer-relative position and the observer-relative
-  // radius. For now, all occluders are considered to be spheres.
-  for (size_t i(0); i < mShadowMaps.size() && i < MAX_BODIES; ++i) {
-    auto object = mSolarSystem->getObject(mShadowMaps[i]->mOccluder);
-    auto pos    = object->getObserverRelativePosition();
+  // The uniform buffer is only updated if something has changed.
+  if (mUniformBlockDirty || std::memcmp(&block, &mUniformBlock, sizeof(UniformBlock)) != 0) {
+    mUniformBlock      = block;
+    mUniformBlockDirty = false;
+
+    if (mUniformBuffer == 0) {
+      glGenBuffers(1, &mUniformBuffer);
+      glBindBuffer(GL_UNIFORM_BUFFER, mUniformBuffer);
+      glBufferData(GL_UNIFORM_BUFFER, sizeof(UniformBlock), &mUniformBlock, GL_DYNAMIC_DRAW);
+    } else {
+      glBindBuffer(GL_UNIFORM_BUFFER, mUniformBuffer);
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(UniformBlock), &mUniformBlock);
+    }
 
-    mOccluders[i] = glm::vec4(
-        pos, object->getRadii()[0] * object->getScale() / mSolarSystem->getObserver().getScale());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
   }
 }
 
@@ -94,34 +124,41 @@ void EclipseShadowReceiver::update(scene::CelestialObject const& shadowReceiver)
 
 void EclipseShadowReceiver::preRender() const {
 
-  mShader->SetUniform(mUniforms.numOccluders, static_cast<int>(mShadowMaps.size()));
-
-  // Bind all eclipse shadow maps and upload the respective caster positions and radii.
-  if (!mShadowMaps.empty()) {
-    std::array<int, MAX_BODIES> shadowMapBindings{};
+  // Bind the texture array containing all eclipse shadow maps and the uniform buffer with the
+  // respective caster positions, radii and layers. The textures are only required in the
+  // texture-based modes.
+  if (!mCasters.empty()) {
+    auto mode = mSettings->mGraphics.pEclipseShadowMode.get();
 
-    for (size_t i(0); i < mShadowMaps.size() && i < MAX_BODIES; ++i) {
-      shadowMapBindings[i] = static_cast<int>(i + mTextureOffset);
-      mShadowMaps[i]->mTexture->Bind(GL_TEXTURE0 + shadowMapBindings[i]);
+    if (mode == EclipseShadowMode::eTexture || mode == EclipseShadowMode::eFastTexture) {
+      glActiveTexture(GL_TEXTURE0 + mTextureOffset);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, mCasters[0].mShadowMap->mAtlas->getTexture());
+      glActiveTexture(GL_TEXTURE0);
     }
 
-    glUniform4fv(mUniforms.occluders, MAX_BODIES, glm::value_ptr(mOccluders[0]));
-    glUniform1iv(mUniforms.shadowMaps, MAX_BODIES, shadowMapBindings.data());
-
-    // Also, the Sun's position and radius is required.
-    auto sunPos    = mSolarSystem->pSunPosition.get();
-    auto sunRadius = mSolarSystem->getSun()->getRadii()[0] / mSolarSystem->getObserver().getScale();
-    mShader->SetUniform(mUniforms.sun, static_cast<float>(sunPos.x), static_cast<float>(sunPos.y),
-        static_cast<float>(sunPos.z), static_cast<float>(sunRadius));
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BUFFER_BINDING, mUniformBuffer);
+    mShader->SetUniform(mUniforms.shadowMaps, static_cast<int>(mTextureOffset));
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void EclipseShadowReceiver::postRender() const {
-  for (size_t i = 0; i < mShadowMaps.size(); ++i) {
-    mShadowMaps[i]->mTexture->Unbind(GL_TEXTURE0 + static_cast<int>(i + mTextureOffset));
+  if (!mCasters.empty()) {
+    glActiveTexture(GL_TEXTURE0 + mTextureOffset);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EclipseShadowMode EclipseShadowReceiver::getEffectiveMode() const {
+  if (mCasters.empty()) {
+    return EclipseShadowMode::eNone;
   }
+
+  return mSettings->mGraphics.pEclipseShadowMode.get();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
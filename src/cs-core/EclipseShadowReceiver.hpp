@@ -8,6 +8,7 @@
 #ifndef CS_CORE_ECLIPSE_SHADOW_RECEIVER_HPP
 #define CS_CORE_ECLIPSE_SHADOW_RECEIVER_HPP
 
+#include "SolarSystem.hpp"
 #include "cs_core_export.hpp"
 
 #include <array>
@@ -22,13 +23,8 @@ class CelestialObject;
 class CelestialObserver;
 } // namespace cs::scene
 
-namespace cs::graphics {
-struct EclipseShadowMap;
-}
-
 namespace cs::core {
 
-class SolarSystem;
 class Settings;
 
 /// There are multiple ways to compute the eclipse shadow. Which one is used depends on the settings
@@ -51,7 +47,9 @@ enum class EclipseShadowMode {
 };
 
 /// Every object which should be able to receive eclipse shadows, should own an
-/// EclipseShadowReceiver.
+/// EclipseShadowReceiver. The positions of all shadow casters are computed once each frame by the
+/// SolarSystem. In update(), the receiver picks the casters which are relevant for its object and
+/// uploads them to a uniform buffer, so that preRender() only has to bind this buffer.
 class CS_CORE_EXPORT EclipseShadowReceiver {
  public:
   /// Creates a new EclipseShadowReceiver. The given CelestialObject will be used to compute all
@@ -62,8 +60,18 @@ class CS_CORE_EXPORT EclipseShadowReceiver {
   EclipseShadowReceiver(std::shared_ptr<Settings> settings,
       std::shared_ptr<SolarSystem> solarSystem, bool allowSelfShadowing);
 
+  EclipseShadowReceiver(EclipseShadowReceiver const& other) = delete;
+  EclipseShadowReceiver(EclipseShadowReceiver&& other)      = delete;
+
+  EclipseShadowReceiver& operator=(EclipseShadowReceiver const& other) = delete;
+  EclipseShadowReceiver& operator=(EclipseShadowReceiver&& other) = delete;
+
+  ~EclipseShadowReceiver();
+
   /// This will return true if mGraphics.pEclipseShadowMode has been changed since the last call to
-  /// getShaderSnippet().
+  /// getShaderSnippet(). As the snippet contains no eclipse code as long as no occluder may cast a
+  /// shadow onto the receiver, this will also return true once an eclipse becomes possible or
+  /// impossible in update().
   bool needsRecompilation() const;
 
   /// Returns a GLSL snippet with the "vec3 getEclipseShadow(vec3 position)" method which should be
@@ -72,23 +80,40 @@ class CS_CORE_EXPORT EclipseShadowReceiver {
   std::string getShaderSnippet() const;
 
   /// This should be called once the shader has been compiled. The textureOffset will be used for
-  /// binding the eclipse shadow maps. There should be at least MAX_BODIES free texture units at
-  /// this point.
+  /// binding the texture array containing all eclipse shadow maps.
   void init(VistaGLSLShader* shader, uint32_t textureOffset);
 
-  /// This should be called once each frame.
+  /// This should be called once each frame. This uploads the relevant shadow casters to the uniform
+  /// buffer, so it has to be called on the main thread.
   void update(scene::CelestialObject const& shadowReceiver);
 
-  /// This should be called before rendering the object. It will set all uniforms and bind the
-  /// eclipse shadow maps.
+  /// This should be called before rendering the object. It will bind the uniform buffer and the
+  /// eclipse shadow maps. In the texture-based modes, this loads the shadow maps when they are
+  /// required for the first time.
   void preRender() const;
 
-  /// This should be called after rendering the object. It will unbind all eclipse shadow maps.
+  /// This should be called after rendering the object. It will unbind the eclipse shadow maps.
   void postRender() const;
 
  private:
   static constexpr size_t MAX_BODIES = 4;
 
+  /// The uniform buffer is bound to this binding point right before the object is drawn.
+  static constexpr uint32_t UNIFORM_BUFFER_BINDING = 0;
+
+  /// The layout of the EclipseShadows uniform block in eclipseShadows.glsl (std140).
+  struct UniformBlock {
+    glm::vec4                         mSun{};
+    std::array<glm::vec4, MAX_BODIES> mOccluders{};
+    glm::ivec4                        mShadowMapLayers{};
+    int32_t                           mNumOccluders = 0;
+    std::array<int32_t, 3>            mPadding{};
+  };
+
+  /// Returns eNone if no occluder may currently cast a shadow onto the receiver, else the mode
+  /// configured in the settings.
+  EclipseShadowMode getEffectiveMode() const;
+
   std::shared_ptr<Settings>    mSettings;
   std::shared_ptr<SolarSystem> mSolarSystem;
   bool                         mAllowSelfShadowing;
@@ -96,15 +121,14 @@ class CS_CORE_EXPORT EclipseShadowReceiver {
   VistaGLSLShader* mShader        = nullptr;
   uint32_t         mTextureOffset = 0;
 
-  std::array<glm::vec4, MAX_BODIES>                        mOccluders{};
-  std::vector<std::shared_ptr<graphics::EclipseShadowMap>> mShadowMaps;
+  std::vector<SolarSystem::EclipseShadowCaster> mCasters;
+  UniformBlock                                  mUniformBlock;
+  uint32_t                                      mUniformBuffer     = 0;
+  bool                                          mUniformBlockDirty = true;
 
   mutable EclipseShadowMode mLastEclipseShadowMode = EclipseShadowMode::eNone;
 
   struct {
-    int sun;
-    int numOccluders;
-    int occluders;
     int shadowMaps;
   } mUniforms;
 };
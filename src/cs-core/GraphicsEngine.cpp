@@ -9,9 +9,14 @@
 
 #include "../cs-graphics/ClearHDRBufferNode.hpp"
 #include "../cs-graphics/EclipseShadowMap.hpp"
+#include "../cs-graphics/FramebufferCopy.hpp"
+#include "../cs-graphics/GpuMemory.hpp"
 #include "../cs-graphics/SetupGLNode.hpp"
+#include "../cs-graphics/ShaderCache.hpp"
+#include "../cs-graphics/TemporalAntiAliasing.hpp"
 #include "../cs-graphics/TextureLoader.hpp"
 #include "../cs-graphics/ToneMappingNode.hpp"
+#include "../cs-utils/FrameStats.hpp"
 #include "../cs-utils/utils.hpp"
 #include "logger.hpp"
 
@@ -24,11 +29,32 @@
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 
 namespace cs::core {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// The dynamic quality is published in steps of this size.
+float const qualityStep = 0.1F;
+
+// The dynamic quality is only increased if it has not been decreased for this many frames.
+int const qualityIncreaseDelay = 120;
+
+// Each time the GPU memory is under pressure, the resolution of the HDR buffer is reduced by this
+// amount, down to the given minimum.
+float const memoryResolutionStep     = 0.1F;
+float const minMemoryResolutionScale = 0.5F;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void GLAPIENTRY MessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
     GLsizei length, const GLchar* message, const void* userParams) {
 
@@ -70,8 +96,8 @@ void GLAPIENTRY MessageCallback(GLenum source, GLenum type, GLuint id, GLenum se
 GraphicsEngine::GraphicsEngine(std::shared_ptr<core::Settings> settings)
     : mSettings(std::move(settings))
     , mShadowMap(std::make_shared<graphics::ShadowMap>())
-    , mFallbackEclipseShadowMap(
-          graphics::TextureLoader::loadFromFile("../share/resources/textures/fallbackShadow.hdr")) {
+    , mFramebufferCopy(std::make_shared<graphics::FramebufferCopy>())
+    , mEclipseShadowAtlas(std::make_shared<graphics::EclipseShadowAtlas>()) {
 
   // Tell the user what's going on.
   logger().debug("Creating GraphicsEngine.");
@@ -102,11 +128,43 @@ GraphicsEngine::GraphicsEngine(std::shared_ptr<core::Settings> settings)
   // Attach the debug callback to print the messages.
   glDebugMessageCallback(MessageCallback, static_cast<void*>(mSettings.get()));
 
+  // setup shader cache ----------------------------------------------------------------------------
+
+  if (mSettings->mGraphics.mShaderCacheDirectory) {
+    graphics::ShaderCache::get().setBinaryDirectory(*mSettings->mGraphics.mShaderCacheDirectory);
+  }
+
+  // setup GPU memory budget ----------------------------------------------------------------------
+
+  uint32_t const megabyte = 1024 * 1024;
+
+  mSettings->mGraphics.pGpuMemoryBudget.connectAndTouch([megabyte](uint32_t value) {
+    graphics::GpuMemory::get().setBudget(static_cast<std::size_t>(value) * megabyte);
+  });
+
+  mSettings->mGraphics.pGpuMemoryReserve.connectAndTouch([megabyte](uint32_t value) {
+    graphics::GpuMemory::get().setReserve(static_cast<std::size_t>(value) * megabyte);
+  });
+
+  // The HDR buffer is the only large resource of the core which can be downscaled at runtime.
+  mGpuMemoryConnection =
+      graphics::GpuMemory::get().onPressure().connect([this](std::size_t /*excess*/) {
+        if (mMemoryResolutionScale > minMemoryResolutionScale) {
+          mMemoryResolutionScale =
+              std::max(mMemoryResolutionScale - memoryResolutionStep, minMemoryResolutionScale);
+          logger().warn("GPU memory is low! Reducing the resolution of the HDR buffer to {}%.",
+              std::lround(mMemoryResolutionScale * 100.F));
+        }
+      });
+
   // setup shadows ---------------------------------------------------------------------------------
 
   mShadowMap->setEnabled(false);
   mShadowMap->setResolution(static_cast<uint32_t>(mSettings->mGraphics.pShadowMapResolution.get()));
   mShadowMap->setBias(mSettings->mGraphics.pShadowMapBias.get() * 0.0001F);
+  mShadowMap->setCascadeUpdateInterval(
+      static_cast<uint32_t>(std::max(mSettings->mGraphics.pShadowMapUpdateInterval.get(), 1)));
+  mShadowMap->setLayeredRendering(mSettings->mGraphics.pEnableLayeredShadowMap.get());
   pSG->NewOpenGLNode(pSG->GetRoot(), mShadowMap.get());
 
   calculateCascades();
@@ -133,31 +191,29 @@ GraphicsEngine::GraphicsEngine(std::shared_ptr<core::Settings> settings)
   mSettings->mGraphics.pShadowMapExtension.connect(
       [this](glm::vec2 /*unused*/) { calculateCascades(); });
 
+  mSettings->mGraphics.pShadowMapUpdateInterval.connect([this](int val) {
+    mShadowMap->setCascadeUpdateInterval(static_cast<uint32_t>(std::max(val, 1)));
+  });
+
+  mSettings->mGraphics.pEnableLayeredShadowMap.connect(
+      [this](bool val) { mShadowMap->setLayeredRendering(val); });
+
   // setup eclipse shadows -------------------------------------------------------------------------
 
-  // Load the eclipse shadow maps of all configured bodies. If a body has no specific texture, the
-  // fallback texture is used instead.
+  // Register the eclipse shadow maps of all configured bodies. If a body has no specific texture,
+  // the fallback texture is used instead. The textures are only loaded once they are needed.
   if (mSettings->mGraphics.mEclipseShadowMaps.has_value()) {
     for (auto const& s : mSettings->mGraphics.mEclipseShadowMaps.value()) {
       auto shadowMap       = std::make_shared<graphics::EclipseShadowMap>();
       shadowMap->mOccluder = s.first;
-
-      if (s.second.mTexture) {
-        shadowMap->mTexture = graphics::TextureLoader::loadFromFile(*s.second.mTexture);
-        shadowMap->mTexture->SetWrapS(GL_CLAMP_TO_EDGE);
-        shadowMap->mTexture->SetWrapT(GL_CLAMP_TO_EDGE);
-      } else {
-        shadowMap->mTexture = mFallbackEclipseShadowMap;
-      }
+      shadowMap->mAtlas    = mEclipseShadowAtlas;
+      shadowMap->mLayer    = mEclipseShadowAtlas->addTexture(
+          s.second.mTexture.value_or("../share/resources/textures/fallbackShadow.hdr"));
 
       mEclipseShadowMaps.push_back(shadowMap);
     }
   }
 
-  // Also, the fallback shadow map should use texture clamping.
-  mFallbackEclipseShadowMap->SetWrapS(GL_CLAMP_TO_EDGE);
-  mFallbackEclipseShadowMap->SetWrapT(GL_CLAMP_TO_EDGE);
-
   // setup HDR buffer ------------------------------------------------------------------------------
   int multiSamples = GetVistaSystem()
                          ->GetDisplayManager()
@@ -168,30 +224,36 @@ GraphicsEngine::GraphicsEngine(std::shared_ptr<core::Settings> settings)
 
   mHDRBuffer = std::make_shared<graphics::HDRBuffer>(multiSamples);
 
-  // Create a node which clears the HDRBuffer at the beginning of a frame (this will be enabled only
-  // if HDR rendering is enabled).
-  mClearNode        = std::make_shared<graphics::ClearHDRBufferNode>(mHDRBuffer);
-  auto* clearGLNode = pSG->NewOpenGLNode(pSG->GetRoot(), mClearNode.get());
-  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-      clearGLNode, static_cast<int>(utils::DrawOrder::eClearHDRBuffer));
-
-  mSetupGLNode      = std::make_shared<graphics::SetupGLNode>();
-  auto* setupGLNode = pSG->NewOpenGLNode(pSG->GetRoot(), mSetupGLNode.get());
-  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-      setupGLNode, static_cast<int>(utils::DrawOrder::eSetupOpenGL));
-
-  // Create a node which performas tonemapping of the HDRBuffer at the end of a frame (this will be
-  // enabled only if HDR rendering is enabled).
-  mToneMappingNode        = std::make_shared<graphics::ToneMappingNode>(mHDRBuffer);
-  auto* toneMappingGLNode = pSG->NewOpenGLNode(pSG->GetRoot(), mToneMappingNode.get());
-  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
-      toneMappingGLNode, static_cast<int>(utils::DrawOrder::eToneMapping));
+  // The HDRBuffer is cleared at the beginning of a frame and tone mapped to the screen at the end
+  // of a frame. Both passes are only required if HDR rendering is enabled.
+  auto isHDREnabled = [this]() { return mSettings->mGraphics.pEnableHDR.get(); };
+
+  mClearNode = std::make_shared<graphics::ClearHDRBufferNode>(mHDRBuffer);
+  addRenderPass("Clear HDR Buffer", static_cast<int>(utils::DrawOrder::eClearHDRBuffer),
+      [this]() { mClearNode->Do(); }, isHDREnabled);
+
+  mSetupGLNode = std::make_shared<graphics::SetupGLNode>();
+  addRenderPass("Setup OpenGL", static_cast<int>(utils::DrawOrder::eSetupOpenGL),
+      [this]() { mSetupGLNode->Do(); });
+
+  mToneMappingNode = std::make_shared<graphics::ToneMappingNode>(mHDRBuffer);
+  addRenderPass("Tonemapping", static_cast<int>(utils::DrawOrder::eToneMapping),
+      [this]() { mToneMappingNode->Do(); }, isHDREnabled);
+
+  // The projection is jittered for the temporal anti-aliasing of the HDR buffer only. Everything
+  // which is drawn directly to the screen after tone mapping has to use the original projection, as
+  // it would shimmer otherwise.
+  addRenderPass("Remove Projection Jitter", static_cast<int>(utils::DrawOrder::eToneMapping) + 1,
+      [this]() { removeProjectionJitter(); }, isHDREnabled);
 
   mSettings->mGraphics.pGlareIntensity.connectAndTouch(
       [this](float val) { mToneMappingNode->setGlareIntensity(val); });
 
-  mSettings->mGraphics.pGlareQuality.connectAndTouch(
-      [this](uint32_t val) { mHDRBuffer->setGlareQuality(val); });
+  mSettings->mGraphics.pHDRBufferFormat.connectAndTouch(
+      [this](graphics::HDRBuffer::Format format) { mHDRBuffer->setFormat(format); });
+
+  mSettings->mGraphics.pEnableTemporalAntiAliasing.connectAndTouch(
+      [this](bool enable) { mHDRBuffer->setEnableTemporalAntiAliasing(enable); });
 
   mSettings->mGraphics.pGlareMode.connectAndTouch(
       [this](graphics::HDRBuffer::GlareMode mode) { mHDRBuffer->setGlareMode(mode); });
@@ -215,10 +277,13 @@ GraphicsEngine::GraphicsEngine(std::shared_ptr<core::Settings> settings)
     mToneMappingNode->setMaxAutoExposure(val[1]);
   });
 
-  mSettings->mGraphics.pEnableHDR.connectAndTouch([clearGLNode, toneMappingGLNode](bool enabled) {
-    clearGLNode->SetIsEnabled(enabled);
-    toneMappingGLNode->SetIsEnabled(enabled);
-  });
+  mSettings->mGraphics.pAutoExposureMode.connectAndTouch(
+      [this](graphics::ToneMappingNode::AutoExposureMode mode) {
+        mToneMappingNode->setAutoExposureMode(mode);
+      });
+
+  mSettings->mGraphics.pAutoExposurePercentiles.connectAndTouch(
+      [this](glm::vec2 val) { mToneMappingNode->setAutoExposurePercentiles(val); });
 
   mSettings->mGraphics.pEnableAutoExposure.connectAndTouch(
       [this](bool enabled) { mToneMappingNode->setEnableAutoExposure(enabled); });
@@ -232,15 +297,91 @@ GraphicsEngine::GraphicsEngine(std::shared_ptr<core::Settings> settings)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// A render pass adds itself to the root of the scene graph and removes itself again on
+/// destruction.
+class GraphicsEngine::RenderPass : public IVistaOpenGLDraw {
+ public:
+  RenderPass(std::string const& name, int sortKey, std::function<void()> draw,
+      std::function<bool()> isRequired)
+      : mTimerId(utils::FrameStats::intern(name))
+      , mDraw(std::move(draw))
+      , mIsRequired(std::move(isRequired)) {
+
+    auto* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+    mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
+    VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mGLNode.get(), sortKey);
+  }
+
+  RenderPass(RenderPass const& other) = delete;
+  RenderPass(RenderPass&& other)      = delete;
+
+  RenderPass& operator=(RenderPass const& other) = delete;
+  RenderPass& operator=(RenderPass&& other) = delete;
+
+  ~RenderPass() override {
+    auto* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+    pSG->GetRoot()->DisconnectChild(mGLNode.get());
+  }
+
+  bool Do() override {
+    if (mIsRequired && !mIsRequired()) {
+      return true;
+    }
+
+    utils::FrameStats::ScopedTimer timer(mTimerId);
+    mDraw();
+
+    return true;
+  }
+
+  // Passes like the tone mapping cover the entire screen, so they must never be culled.
+  bool GetBoundingBox(VistaBoundingBox& oBoundingBox) override {
+    float min(std::numeric_limits<float>::lowest());
+    float max(std::numeric_limits<float>::max());
+
+    std::array fMin{min, min, min};
+    std::array fMax{max, max, max};
+
+    oBoundingBox.SetBounds(fMin.data(), fMax.data());
+
+    return true;
+  }
+
+ private:
+  utils::FrameStats::TimerId       mTimerId;
+  std::function<void()>            mDraw;
+  std::function<bool()>            mIsRequired;
+  std::unique_ptr<VistaOpenGLNode> mGLNode;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 GraphicsEngine::~GraphicsEngine() {
   try {
     // Tell the user what's going on.
     logger().debug("Deleting GraphicsEngine.");
+    graphics::GpuMemory::get().onPressure().disconnect(mGpuMemoryConnection);
   } catch (...) {}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+int GraphicsEngine::addRenderPass(std::string const& name, int sortKey,
+    std::function<void()> draw, std::function<bool()> isRequired) {
+  int id = mNextRenderPassId++;
+  mRenderPasses.emplace(
+      id, std::make_shared<RenderPass>(name, sortKey, std::move(draw), std::move(isRequired)));
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GraphicsEngine::removeRenderPass(int id) {
+  mRenderPasses.erase(id);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void GraphicsEngine::registerCaster(graphics::ShadowCaster* caster) {
   mShadowMap->registerCaster(caster);
 }
@@ -253,8 +394,9 @@ void GraphicsEngine::unregisterCaster(graphics::ShadowCaster* caster) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GraphicsEngine::update(glm::vec3 const& sunDirection) {
+void GraphicsEngine::update(glm::vec3 const& sunDirection, glm::dmat4 const& referenceTransform) {
   mShadowMap->setSunDirection(VistaVector3D(sunDirection.x, sunDirection.y, sunDirection.z));
+  mHDRBuffer->setTemporalAntiAliasingReference(referenceTransform);
 
   // Update projection. When the sensor size control is enabled, we will calculate the projection
   // plane extents based on the screens aspect ratio, the given sensor diagonal and sensor focal
@@ -287,6 +429,150 @@ void GraphicsEngine::update(glm::vec3 const& sunDirection) {
     pAverageLuminance = mToneMappingNode->getLastAverageLuminance();
     pMaximumLuminance = mToneMappingNode->getLastMaximumLuminance();
   }
+
+  // Query the available GPU memory. This may ask the subsystems to free some of their resources.
+  graphics::GpuMemory::get().update();
+
+  updateDynamicQuality();
+  updateProjectionJitter();
+
+  // Textures which are loaded in the background become sharper over the next frames.
+  {
+    utils::FrameStats::ScopedTimer timer("Upload Textures");
+    graphics::TextureLoader::uploadPendingTextures(
+        static_cast<std::size_t>(mSettings->mGraphics.pTextureUploadBudget.get()) * 1024 * 1024);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GraphicsEngine::updateProjectionJitter() {
+  bool enabled = mSettings->mGraphics.pEnableHDR.get() &&
+                 mSettings->mGraphics.pEnableTemporalAntiAliasing.get() &&
+                 mHDRBuffer->getMultiSamples() == 0;
+
+  glm::vec2 jitter = graphics::TemporalAntiAliasing::getJitter(mJitterFrame++);
+
+  for (auto const& viewport : GetVistaSystem()->GetDisplayManager()->GetViewports()) {
+    auto* pProjProps = viewport.second->GetProjection()->GetProjectionProperties();
+    auto& applied    = mProjectionJitter[viewport.second];
+
+    std::array<double, 4> extents{};
+    pProjProps->GetProjPlaneExtents(extents[0], extents[1], extents[2], extents[3]);
+
+    // Remove the previous offset, unless the extents have been set again since then.
+    if (extents == applied.mExtents) {
+      extents[0] -= applied.mOffset.x;
+      extents[1] -= applied.mOffset.x;
+      extents[2] -= applied.mOffset.y;
+      extents[3] -= applied.mOffset.y;
+    }
+
+    applied.mOffset     = glm::dvec2(0.0);
+    applied.mClipOffset = glm::dvec2(0.0);
+
+    // Shift the projection plane by the jitter offset. The offset is given in pixels of the HDR
+    // buffer.
+    if (enabled) {
+      int sizeX = 0;
+      int sizeY = 0;
+      viewport.second->GetViewportProperties()->GetSize(sizeX, sizeY);
+
+      double     scale = mHDRBuffer->getResolutionScale();
+      glm::dvec2 size(sizeX * scale, sizeY * scale);
+
+      glm::dvec2 extent(extents[1] - extents[0], extents[3] - extents[2]);
+      applied.mOffset = glm::dvec2(jitter) * extent / size;
+
+      // Normalized device coordinates span two units across the viewport. Shifting the projection
+      // plane moves the image in the opposite direction, so this offset undoes the jitter.
+      applied.mClipOffset = 2.0 * glm::dvec2(jitter) / size;
+    }
+
+    extents[0] += applied.mOffset.x;
+    extents[1] += applied.mOffset.x;
+    extents[2] += applied.mOffset.y;
+    extents[3] += applied.mOffset.y;
+
+    pProjProps->SetProjPlaneExtents(extents[0], extents[1], extents[2], extents[3]);
+    applied.mExtents = extents;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GraphicsEngine::removeProjectionJitter() {
+  auto* viewport = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
+  auto  applied  = mProjectionJitter.find(viewport);
+
+  if (applied == mProjectionJitter.end() || applied->second.mClipOffset == glm::dvec2(0.0)) {
+    return;
+  }
+
+  // The projection of the viewport cannot be changed in the middle of its traversal, so the offset
+  // is removed from the current OpenGL projection matrix instead. It is translated in clip space,
+  // which is the same as a translation in normalized device coordinates. The projection matrix is
+  // loaded again at the beginning of the next traversal, so it does not have to be restored.
+  std::array<GLdouble, 16> projection{};
+  glGetDoublev(GL_PROJECTION_MATRIX, projection.data());
+
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+  glTranslated(applied->second.mClipOffset.x, applied->second.mClipOffset.y, 0.0);
+  glMultMatrixd(projection.data());
+  glMatrixMode(GL_MODELVIEW);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GraphicsEngine::updateDynamicQuality() {
+  auto const& graphics = mSettings->mGraphics;
+
+  if (!graphics.pEnableDynamicQuality.get()) {
+    mDynamicQuality = 1.F;
+    pDynamicQuality = 1.F;
+  } else {
+    // The quality is adapted to the frame time of the last-but-one frame, which is the most recent
+    // one with GPU timings available. Within the frame time range, nothing changes. The quality is
+    // reduced quickly if the frame time is too high, but it is increased only slowly and only if it
+    // has not been reduced for a while.
+    auto      frameTime = static_cast<float>(utils::FrameStats::get().pFrameTime.get());
+    glm::vec2 timeRange = graphics.pDynamicQualityFrameTimeRange.get();
+
+    ++mFramesSinceQualityDecrease;
+
+    if (frameTime > timeRange.y) {
+      mDynamicQuality -= std::min(0.1F, 0.01F * (frameTime - timeRange.y));
+      mFramesSinceQualityDecrease = 0;
+    } else if (frameTime < timeRange.x && mFramesSinceQualityDecrease > qualityIncreaseDelay) {
+      mDynamicQuality += std::min(0.01F, 0.001F * (timeRange.x - frameTime));
+    }
+
+    mDynamicQuality = glm::clamp(mDynamicQuality, 0.F, 1.F);
+
+    // Many of the quality knobs re-create resources or recompile shaders when they are changed.
+    // Therefore the quality is published in steps, and only once the internal value is clearly
+    // closer to another step.
+    if (std::abs(mDynamicQuality - pDynamicQuality.get()) > 0.75F * qualityStep) {
+      pDynamicQuality = std::round(mDynamicQuality / qualityStep) * qualityStep;
+    }
+  }
+
+  float quality = pDynamicQuality.get();
+
+  // The resolution of the HDR buffer is interpolated in the configured range.
+  float scale = graphics.pHDRResolutionScale.get();
+
+  if (graphics.pEnableDynamicQuality.get()) {
+    glm::vec2 scaleRange = graphics.pDynamicResolutionScaleRange.get();
+    scale                = glm::mix(scaleRange.x, scaleRange.y, quality);
+  }
+
+  mHDRBuffer->setResolutionScale(std::min(scale, mMemoryResolutionScale));
+
+  // The glare quality is reduced down to zero.
+  mHDRBuffer->setGlareQuality(static_cast<uint32_t>(
+      std::lround(quality * static_cast<float>(graphics.pGlareQuality.get()))));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -303,6 +589,12 @@ std::shared_ptr<graphics::HDRBuffer> GraphicsEngine::getHDRBuffer() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<graphics::FramebufferCopy> GraphicsEngine::getFramebufferCopy() const {
+  return mFramebufferCopy;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::vector<std::shared_ptr<graphics::EclipseShadowMap>> const&
 GraphicsEngine::getEclipseShadowMaps() const {
   return mEclipseShadowMaps;
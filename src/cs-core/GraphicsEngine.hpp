@@ -13,11 +13,19 @@
 #include "../cs-utils/Property.hpp"
 #include "Settings.hpp"
 
+#include <array>
+#include <functional>
 #include <glm/glm.hpp>
+#include <map>
 #include <memory>
+#include <string>
+
+class VistaViewport;
 
 namespace cs::graphics {
 struct EclipseShadowMap;
+class EclipseShadowAtlas;
+class FramebufferCopy;
 class ClearHDRBufferNode;
 class ToneMappingNode;
 class SetupGLNode;
@@ -35,6 +43,12 @@ class CS_CORE_EXPORT GraphicsEngine {
   utils::Property<float> pAverageLuminance           = 1.F;
   utils::Property<float> pMaximumLuminance           = 1.F;
 
+  /// A value in [0, 1] which is reduced by the dynamic quality controller if the frame time exceeds
+  /// the dynamicQualityFrameTimeRange. It changes in steps of 0.1 only. The GraphicsEngine uses it
+  /// to scale the resolution of the HDR buffer and the glare quality, plugins may use it to reduce
+  /// the quality of expensive effects. This is always one if enableDynamicQuality is false.
+  utils::Property<float> pDynamicQuality = 1.F;
+
   explicit GraphicsEngine(std::shared_ptr<Settings> settings);
 
   GraphicsEngine(GraphicsEngine const& other) = default;
@@ -49,27 +63,71 @@ class CS_CORE_EXPORT GraphicsEngine {
   void registerCaster(graphics::ShadowCaster* caster);
   void unregisterCaster(graphics::ShadowCaster* caster);
 
-  /// The light direction in world space.
-  void update(glm::vec3 const& sunDirection);
+  /// Adds a render pass to the scene graph. Render passes are drawn once for each view in the
+  /// order of their sort keys, which are usually based on utils::DrawOrder. Each pass is measured
+  /// by a FrameStats timer with the given name. If isRequired is given, it is called before each
+  /// draw and the pass is skipped if it returns false, for example because nothing uses the output
+  /// of the pass. The returned ID can be passed to removeRenderPass().
+  int addRenderPass(std::string const& name, int sortKey, std::function<void()> draw,
+      std::function<bool()> isRequired = {});
+  void removeRenderPass(int id);
+
+  /// The light direction in world space. The reference transform is the observer-relative
+  /// transformation of the object the observer is moving around. The temporal anti-aliasing assumes
+  /// the scene to be static relative to this object.
+  void update(
+      glm::vec3 const& sunDirection, glm::dmat4 const& referenceTransform = glm::dmat4(1.0));
 
   std::shared_ptr<graphics::ShadowMap> getShadowMap() const;
   std::shared_ptr<graphics::HDRBuffer> getHDRBuffer() const;
 
+  /// Drawables which need to read the current depth or color of the framebuffer should use these
+  /// shared copies instead of copying the framebuffer themselves. See graphics::FramebufferCopy for
+  /// details.
+  std::shared_ptr<graphics::FramebufferCopy> getFramebufferCopy() const;
+
   /// Returns a list of all available eclipse shadow maps. You can use the eclipse shadow API of the
   /// SolarSystem to get all relevant eclipse shadow maps for a given position in space.
   std::vector<std::shared_ptr<graphics::EclipseShadowMap>> const& getEclipseShadowMaps() const;
 
  private:
+  class RenderPass;
+
   void calculateCascades();
+  void updateDynamicQuality();
+  void updateProjectionJitter();
+  void removeProjectionJitter();
+
+  // The sub-pixel offset which has been applied to the projection of a viewport for the temporal
+  // anti-aliasing. The extents are stored to detect whether they have been changed by someone else
+  // in the meantime. mClipOffset is the same offset in normalized device coordinates; it is used to
+  // undo the jitter for everything which is drawn after the HDR buffer has been resolved.
+  struct ProjectionJitter {
+    glm::dvec2            mOffset{0.0};
+    glm::dvec2            mClipOffset{0.0};
+    std::array<double, 4> mExtents{};
+  };
 
   std::shared_ptr<core::Settings>                          mSettings;
   std::shared_ptr<graphics::ShadowMap>                     mShadowMap;
   std::shared_ptr<graphics::HDRBuffer>                     mHDRBuffer;
+  std::shared_ptr<graphics::FramebufferCopy>               mFramebufferCopy;
   std::shared_ptr<graphics::ClearHDRBufferNode>            mClearNode;
   std::shared_ptr<graphics::SetupGLNode>                   mSetupGLNode;
   std::shared_ptr<graphics::ToneMappingNode>               mToneMappingNode;
   std::vector<std::shared_ptr<graphics::EclipseShadowMap>> mEclipseShadowMaps;
-  std::shared_ptr<VistaTexture>                            mFallbackEclipseShadowMap;
+  std::shared_ptr<graphics::EclipseShadowAtlas>            mEclipseShadowAtlas;
+  std::map<int, std::shared_ptr<RenderPass>>               mRenderPasses;
+  int                                                      mNextRenderPassId = 0;
+  float                                                    mDynamicQuality            = 1.F;
+  int                                                      mFramesSinceQualityDecrease = 0;
+  std::map<VistaViewport*, ProjectionJitter>               mProjectionJitter;
+  uint64_t                                                 mJitterFrame               = 0;
+
+  // The resolution scale of the HDR buffer is limited to this value if the GPU memory has been
+  // under pressure, see graphics::GpuMemory::onPressure().
+  float mMemoryResolutionScale = 1.F;
+  int   mGpuMemoryConnection   = -1;
 };
 
 } // namespace cs::core
@@ -42,7 +42,8 @@ GuiManager::GuiManager(
   logger().debug("Creating GuiManager.");
 
   // Initialize the Chromium Embedded Framework.
-  gui::init();
+  gui::init(mSettings->pEnableAcceleratedGui.get(), mSettings->pGuiRendererProcessLimit.get(),
+      mSettings->pGuiBrowserPoolSize.get());
 
   // Connect to load and save events.
   mOnLoadConnection = mSettings->onLoad().connect([this]() { onLoad(); });
@@ -392,50 +393,55 @@ void GuiManager::enableLoadingScreen(bool enable) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GuiManager::setLoadingScreenStatus(std::string const& sStatus) const {
-  mCosmoScoutGui->callJavascript("CosmoScout.loadingScreen.setStatus", sStatus);
+  mCosmoScoutGui->callJavascriptCoalesced("CosmoScout.loadingScreen.setStatus", sStatus);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GuiManager::setLoadingScreenProgress(float percent, bool animate) const {
-  mCosmoScoutGui->callJavascript("CosmoScout.loadingScreen.setProgress", percent, animate);
+  mCosmoScoutGui->callJavascriptCoalesced("CosmoScout.loadingScreen.setProgress", percent, animate);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GuiManager::update() {
+  // Pause the painting of items which have not been drawn recently and paint items which are small
+  // on screen less often.
+  gui::GuiItem::updateFrameRates();
+
   // Update all entities of the Chromium Embedded Framework.
   gui::update();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GuiManager::addPluginTabToSideBar(
-    std::string const& name, std::string const& icon, std::string const& content) {
-  mCosmoScoutGui->callJavascript("CosmoScout.sidebar.addPluginTab", name, icon, content);
+void GuiManager::addPluginTabToSideBar(std::string const& name, std::string const& icon,
+    std::string const& content, bool lazy) {
+  mCosmoScoutGui->callJavascript("CosmoScout.sidebar.addPluginTab", name, icon, content, lazy);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GuiManager::addPluginTabToSideBarFromHTML(
-    std::string const& name, std::string const& icon, std::string const& htmlFile) {
+void GuiManager::addPluginTabToSideBarFromHTML(std::string const& name, std::string const& icon,
+    std::string const& htmlFile, bool lazy) {
   std::string content = utils::filesystem::loadToString(htmlFile);
-  addPluginTabToSideBar(name, icon, content);
+  addPluginTabToSideBar(name, icon, content, lazy);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GuiManager::addSettingsSectionToSideBar(
-    std::string const& name, std::string const& icon, std::string const& content) {
-  mCosmoScoutGui->callJavascript("CosmoScout.sidebar.addSettingsSection", name, icon, content);
+void GuiManager::addSettingsSectionToSideBar(std::string const& name, std::string const& icon,
+    std::string const& content, bool lazy) {
+  mCosmoScoutGui->callJavascript(
+      "CosmoScout.sidebar.addSettingsSection", name, icon, content, lazy);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GuiManager::addSettingsSectionToSideBarFromHTML(
-    std::string const& name, std::string const& icon, std::string const& htmlFile) {
+    std::string const& name, std::string const& icon, std::string const& htmlFile, bool lazy) {
   std::string content = utils::filesystem::loadToString(htmlFile);
-  addSettingsSectionToSideBar(name, icon, content);
+  addSettingsSectionToSideBar(name, icon, content, lazy);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -50,7 +50,11 @@ class InputManager;
 /// you can use - for example - to register callbacks which will be executed when a button is
 /// pressed in the UI.
 /// Plugins can add content to the sidebar. This is done with the methods addPluginTabToSideBar()
-/// and addSettingsSectionToSideBar().
+/// and addSettingsSectionToSideBar(). If the content is added lazily, it is only parsed by the
+/// browser once the tab or section is opened for the first time. This reduces the startup time when
+/// many plugins are loaded. Calls to CosmoScout.gui.initSlider(), setSliderValue(),
+/// setCheckboxValue() and the like which target elements of such content are deferred until then.
+/// Plugins which access their elements in other ways should not use lazy content.
 ///
 /// This class should only be instantiated once - this is done by the Application class and this
 /// instance is then passed to all plugins.
@@ -141,30 +145,34 @@ class CS_CORE_EXPORT GuiManager {
   /// @param name     The title of the tab.
   /// @param icon     The name of the Material icon.
   /// @param content  The HTML that describes the tabs contents.
-  void addPluginTabToSideBar(
-      std::string const& name, std::string const& icon, std::string const& content);
+  /// @param lazy     If set, the content is added once the tab is opened for the first time.
+  void addPluginTabToSideBar(std::string const& name, std::string const& icon,
+      std::string const& content, bool lazy = false);
 
   /// Adds a new tab to the side bar.
   ///
   /// @param name      The title of the tab.
   /// @param icon      The name of the Material icon.
   /// @param htmlFile  The HTML file that describes the tabs contents.
-  void addPluginTabToSideBarFromHTML(
-      std::string const& name, std::string const& icon, std::string const& htmlFile);
+  /// @param lazy      If set, the content is added once the tab is opened for the first time.
+  void addPluginTabToSideBarFromHTML(std::string const& name, std::string const& icon,
+      std::string const& htmlFile, bool lazy = false);
 
   /// Adds a new section to the settings tab.
   ///
   /// @param name     The title of the section.
   /// @param content  The HTML that describes the sections contents.
-  void addSettingsSectionToSideBar(
-      std::string const& name, std::string const& icon, std::string const& content);
+  /// @param lazy     If set, the content is added once the section is opened for the first time.
+  void addSettingsSectionToSideBar(std::string const& name, std::string const& icon,
+      std::string const& content, bool lazy = false);
 
   /// Adds a new section to the settings tab.
   ///
   /// @param name      The title of the section.
   /// @param htmlFile  The HTML file that describes the sections contents.
-  void addSettingsSectionToSideBarFromHTML(
-      std::string const& name, std::string const& icon, std::string const& htmlFile);
+  /// @param lazy      If set, the content is added once the section is opened for the first time.
+  void addSettingsSectionToSideBarFromHTML(std::string const& name, std::string const& icon,
+      std::string const& htmlFile, bool lazy = false);
 
   void removePluginTab(std::string const& name);
   void removeSettingsSection(std::string const& name);
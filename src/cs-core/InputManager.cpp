@@ -35,10 +35,24 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
+#include <algorithm>
+#include <glm/gtx/component_wise.hpp>
+#include <limits>
+
 namespace cs::core {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// The bounding spheres used for picking are this much larger than the largest radius of an object.
+// This ensures that they contain all terrain.
+double const BOUNDING_SPHERE_MARGIN = 1.1;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 /// Helper function that converts the character on the keyboard to an int expected by ViSTA.
 constexpr int vistaKeyCode(char c) {
   return c - 'a' + 1;
@@ -225,6 +239,21 @@ void InputManager::unregisterSelectable(IVistaNode* pNode) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void InputManager::update() {
+
+  // Inject the scroll events of this frame to the same item which HandleEvent() used to receive
+  // them directly.
+  if (mPendingScroll != 0) {
+    auto* item = pActiveGuiItem.get() ? pActiveGuiItem.get() : pHoveredGuiItem.get();
+    if (item && item->getCanScroll()) {
+      gui::MouseEvent mouseEvent;
+      mouseEvent.mType = gui::MouseEvent::Type::eScroll;
+      mouseEvent.mY    = mPendingScroll * 20;
+      item->injectMouseEvent(mouseEvent);
+    }
+
+    mPendingScroll = 0;
+  }
+
   auto* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
 
   // Set position and orientation of selection ray.
@@ -237,21 +266,71 @@ void InputManager::update() {
   pIntentionNode->GetWorldOrientation(qOrientation);
   VistaVector3D v3Direction = qOrientation.GetViewDir();
 
-  // Test the Intention Node for Intersection with planets.
-  Intersection intersection;
+  glm::dvec3 rayOrigin(v3Position[0], v3Position[1], v3Position[2]);
+  glm::dvec3 rayDir(glm::normalize(glm::dvec3(v3Direction[0], v3Direction[1], v3Direction[2])));
+
+  // Test the Intention Node for Intersection with planets. In a broad phase, all objects whose
+  // bounding sphere is missed by the ray are rejected. The remaining candidates are sorted by the
+  // distance at which the ray enters their bounding sphere.
+  mPickCandidates.clear();
+
   for (auto const& [name, object] : mSettings->mObjects) {
-    if (object->getIntersectableObject()) {
-      glm::dvec3 pos(0.0, 0.0, 0.0);
+    if (!object->getIntersectableObject()) {
+      continue;
+    }
+
+    // The radii do not include the terrain, hence a generous margin is added. Objects without
+    // radii cannot be bounded and are always tested.
+    double radius = glm::compMax(object->getRadii()) *
+                    glm::length(object->getObserverRelativeTransform()[0]) * BOUNDING_SPHERE_MARGIN;
+
+    if (radius <= 0.0) {
+      mPickCandidates.push_back({0.0, &name, object});
+      continue;
+    }
+
+    glm::dvec3 toCenter = object->getObserverRelativePosition() - rayOrigin;
+    double     tCenter  = glm::dot(toCenter, rayDir);
+    double     centerSq = glm::dot(toCenter, toCenter);
+    double     missSq   = centerSq - tCenter * tCenter;
+
+    // The ray passes the sphere or the sphere is behind the ray origin.
+    if (missSq > radius * radius || (tCenter < 0.0 && centerSq > radius * radius)) {
+      continue;
+    }
+
+    double tEnter = std::max(0.0, tCenter - std::sqrt(radius * radius - missSq));
+    mPickCandidates.push_back({tEnter, &name, object});
+  }
+
+  std::sort(mPickCandidates.begin(), mPickCandidates.end(),
+      [](PickCandidate const& a, PickCandidate const& b) { return a.mDistance < b.mDistance; });
+
+  // In the narrow phase, the candidates are intersected in order. Once a candidate's bounding
+  // sphere is farther away than the closest hit so far, no other candidate can be closer.
+  Intersection intersection;
+  double       closestHit = std::numeric_limits<double>::max();
+
+  for (auto const& candidate : mPickCandidates) {
+    if (candidate.mDistance > closestHit) {
+      break;
+    }
+
+    glm::dvec3 pos(0.0, 0.0, 0.0);
+
+    if (candidate.mObject->getIntersectableObject()->getIntersection(rayOrigin, rayDir, pos)) {
 
-      bool intersects = object->getIntersectableObject()->getIntersection(
-          glm::dvec3(v3Position[0], v3Position[1], v3Position[2]),
-          glm::dvec3(v3Direction[0], v3Direction[1], v3Direction[2]), pos);
+      // The intersection point is given in the coordinate system of the object.
+      double distance =
+          glm::length(glm::dvec3(candidate.mObject->getObserverRelativeTransform() *
+                                 glm::dvec4(pos, 1.0)) -
+                      rayOrigin);
 
-      if (intersects) {
-        intersection.mObject     = object;
-        intersection.mObjectName = name;
+      if (distance < closestHit) {
+        closestHit               = distance;
+        intersection.mObject     = candidate.mObject;
+        intersection.mObjectName = *candidate.mName;
         intersection.mPosition   = pos;
-        break;
       }
     }
   }
@@ -563,14 +642,11 @@ void InputManager::HandleEvent(VistaEvent* pEvent) {
         }
       }
 
+      // Scroll events are coalesced and injected once per frame in update().
       if (tag == "scroll_wheel") {
         TVdfnPort<int>* port(dynamic_cast<TVdfnPort<int>*>(node->GetInPort("value")));
-        auto*           item = pActiveGuiItem.get() ? pActiveGuiItem.get() : pHoveredGuiItem.get();
-        if (port && item && item->getCanScroll()) {
-          gui::MouseEvent mouseEvent;
-          mouseEvent.mType = gui::MouseEvent::Type::eScroll;
-          mouseEvent.mY    = port->GetValue() * 20;
-          item->injectMouseEvent(mouseEvent);
+        if (port) {
+          mPendingScroll += port->GetValue();
         }
       }
     }
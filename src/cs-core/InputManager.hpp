@@ -22,6 +22,7 @@
 #include <glm/glm.hpp>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -151,13 +152,15 @@ class CS_CORE_EXPORT InputManager : public VistaKeyboardSystemControl::IVistaDir
   void unregisterSelectable(gui::ScreenSpaceGuiArea* pGui);
 
   /// This method computes the intersection between the mouse ray (SELECTION_NODE) and all
-  /// registered objects.
+  /// registered objects. The scroll events received since the last call are injected as one
+  /// event, so that high-resolution scroll wheels do not cause more events than frames.
   void update();
 
   // overrides of ViSTA base classes ---------------------------------------------------------------
 
   /// This is used to handle events emitted from DFN networks. That is button press and scroll wheel
-  /// events. These are directly injected to the pHoveredGuiItem.
+  /// events. Button events are directly injected to the pHoveredGuiItem, scroll events are
+  /// accumulated until the next call to update().
   void HandleEvent(VistaEvent* pEvent) override;
 
   /// This is used to inject key presses to the pHoveredGuiItem. The ESC key is handled differently,
@@ -171,9 +174,20 @@ class CS_CORE_EXPORT InputManager : public VistaKeyboardSystemControl::IVistaDir
   std::unordered_set<VistaNodeAdapter*>        mAdapters;
   std::unordered_set<gui::ScreenSpaceGuiArea*> mScreenSpaceGuis;
   boost::posix_time::ptime                     mClickTime;
+  int                                          mPendingScroll = 0;
 
   VistaOpenGLNode* mActiveWorldSpaceGuiNode{};
 
+  // A CelestialObject whose bounding sphere is hit by the mouse ray. The candidates are stored in a
+  // member so that no memory is allocated each frame.
+  struct PickCandidate {
+    double                                        mDistance = 0.0;
+    std::string const*                            mName     = nullptr;
+    std::shared_ptr<const scene::CelestialObject> mObject;
+  };
+
+  std::vector<PickCandidate> mPickCandidates;
+
   int mRemoveObjectConnection = -1;
 };
 
@@ -10,7 +10,12 @@
 
 #include "cs_core_export.hpp"
 
+#include <cstdint>
 #include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
 
 #ifdef __linux__
 #define EXPORT_FN extern "C" __attribute__((visibility("default")))
@@ -52,18 +57,79 @@ class CS_CORE_EXPORT PluginBase {
       VistaSceneGraph* sceneGraph, std::shared_ptr<GraphicsEngine> graphicsEngine,
       std::shared_ptr<TimeControl> timeControl);
 
+  /// Override this function to do expensive work which requires neither OpenGL nor the user
+  /// interface, for example reading large files. At application startup, this is called on a worker
+  /// thread, so that the preparation of all plugins runs in parallel. It receives a copy of the
+  /// plugin's section of the settings. Do not access any of the members below here, as the main
+  /// thread may use them at the same time. When a plugin is reloaded later, this is called on the
+  /// main thread directly before init().
+  virtual void prepare(nlohmann::json const& /*pluginSettings*/){};
+
+  /// Override this function if your plugin requires other plugins to be initialized before its
+  /// init() is called, for example because it uses the objects they create. Return the names of
+  /// these plugins. Plugins which are not loaded are ignored. This may be called before setAPI().
+  virtual std::vector<std::string> getDependencies() const {
+    return {};
+  }
+
   /// Override this function to initialize your plugin. It will be called directly after
-  /// application startup and before the update loop starts.
+  /// application startup and before the update loop starts. The plugins are initialized one after
+  /// another on the main thread in alphabetical order, each once its prepare() has finished and all
+  /// of its dependencies have been initialized.
   virtual void init(){};
 
   /// Override this function for cleaning up after yourself, when the plugin terminates. We don't
   /// want our app littered :)
   virtual void deInit(){};
 
+  /// The parts of the application state which updateAsync() may access.
+  enum class Resource : uint32_t {
+    /// The SolarSystem and its celestial objects. As SPICE is not thread-safe, any call which may
+    /// query SPICE, for example computing the position of an object, counts as a write. Reading
+    /// SolarSystem::getFrameSnapshot() does not count as an access, so prefer this where possible.
+    eSolarSystem = 1U << 0U,
+
+    /// The TimeControl. Reading the simulation time counts as a read.
+    eTimeControl = 1U << 1U,
+
+    /// The Settings, except for the plugin's own settings object.
+    eSettings = 1U << 2U,
+
+    /// The InputManager, for example the currently hovered object.
+    eInputManager = 1U << 3U,
+  };
+
+  /// The resources which updateAsync() reads and writes, as combinations of Resource flags.
+  struct AsyncUpdateAccess {
+    uint32_t mReads  = 0;
+    uint32_t mWrites = 0;
+  };
+
+  /// Override this together with updateAsync() if your plugin does CPU-heavy work each frame which
+  /// does not require OpenGL, the user interface or the scene graph. Return the resources which
+  /// updateAsync() accesses. Plugins which return std::nullopt, which is the default, have no
+  /// asynchronous update.
+  virtual std::optional<AsyncUpdateAccess> getAsyncUpdateAccess() const {
+    return std::nullopt;
+  }
+
+  /// This is called each frame before update(). Plugins whose accesses do not conflict run this
+  /// concurrently on worker threads, while the main thread waits. A write of a resource conflicts
+  /// with any other access to it; concurrent reads are fine. The results should be applied to
+  /// OpenGL objects or the user interface in update(), which is always called on the main thread.
+  virtual void updateAsync(){};
+
   /// Override this function if you want to do something in every frame. See the Application class
   /// for more details on when this method is actually called.
   virtual void update(){};
 
+  /// Override this function if your plugin loads data in the background which is required for the
+  /// current view, for example terrain tiles. It should return true as long as such data is still
+  /// being loaded. This is used by the benchmark mode to wait until the scene is complete.
+  virtual bool getIsLoading() const {
+    return false;
+  }
+
  protected:
   std::shared_ptr<Settings>       mAllSettings;
   std::shared_ptr<SolarSystem>    mSolarSystem;
@@ -13,6 +13,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 
 namespace nlohmann {
 
@@ -34,67 +36,133 @@ namespace cs::utils {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+cs::scene::CelestialObject parseObject(nlohmann::json const& j) {
+  cs::scene::CelestialObject object;
+
+  // First, we parse the required parameters.
+  std::string                center, frame;
+  std::array<std::string, 2> existence;
+  cs::core::Settings::deserialize(j, "center", center);
+  cs::core::Settings::deserialize(j, "frame", frame);
+  cs::core::Settings::deserialize(j, "existence", existence);
+
+  object.setCenterName(center);
+  object.setFrameName(frame);
+  object.setExistenceAsStrings(existence);
+
+  // All others are optional.
+  std::optional<glm::dvec3> position, radii;
+  std::optional<glm::dquat> rotation;
+  std::optional<double>     scale, bodyCullingRadius, orbitCullingRadius;
+  std::optional<bool>       trackable, collidable;
+  cs::core::Settings::deserialize(j, "position", position);
+  cs::core::Settings::deserialize(j, "rotation", rotation);
+  cs::core::Settings::deserialize(j, "scale", scale);
+  cs::core::Settings::deserialize(j, "radii", radii);
+  cs::core::Settings::deserialize(j, "bodyCullingRadius", bodyCullingRadius);
+  cs::core::Settings::deserialize(j, "orbitCullingRadius", orbitCullingRadius);
+  cs::core::Settings::deserialize(j, "trackable", trackable);
+  cs::core::Settings::deserialize(j, "collidable", collidable);
+
+  if (position.has_value()) {
+    object.setPosition(position.value());
+  }
+  if (rotation.has_value()) {
+    object.setRotation(rotation.value());
+  }
+  if (scale.has_value()) {
+    object.setScale(scale.value());
+  }
+  if (radii.has_value()) {
+    object.setRadii(radii.value());
+  }
+  if (bodyCullingRadius.has_value()) {
+    object.setBodyCullingRadius(bodyCullingRadius.value());
+  }
+  if (orbitCullingRadius.has_value()) {
+    object.setOrbitCullingRadius(orbitCullingRadius.value());
+  }
+  if (trackable.has_value()) {
+    object.setIsTrackable(trackable.value());
+  }
+  if (collidable.has_value()) {
+    object.setIsCollidable(collidable.value());
+  }
+
+  return object;
+}
+
+nlohmann::json writeObject(cs::scene::CelestialObject const& object) {
+  nlohmann::json i;
+
+  cs::core::Settings::serialize(i, "center", object.getCenterName());
+  cs::core::Settings::serialize(i, "frame", object.getFrameName());
+  cs::core::Settings::serialize(i, "existence", object.getExistenceAsStrings());
+
+  if (object.getPosition() != glm::dvec3(0.0, 0.0, 0.0)) {
+    cs::core::Settings::serialize(i, "position", object.getPosition());
+  }
+  if (object.getRotation() != glm::dquat(1.0, 0.0, 0.0, 0.0)) {
+    cs::core::Settings::serialize(i, "rotation", object.getRotation());
+  }
+  if (object.getScale() != 1.0) {
+    cs::core::Settings::serialize(i, "scale", object.getScale());
+  }
+  if (object.hasCustomRadii()) {
+    cs::core::Settings::serialize(i, "radii", object.getRadii());
+  }
+  if (object.getBodyCullingRadius() != 0) {
+    cs::core::Settings::serialize(i, "bodyCullingRadius", object.getBodyCullingRadius());
+  }
+  if (object.getOrbitCullingRadius() != 0) {
+    cs::core::Settings::serialize(i, "orbitCullingRadius", object.getOrbitCullingRadius());
+  }
+  if (!object.getIsTrackable()) {
+    cs::core::Settings::serialize(i, "trackable", object.getIsTrackable());
+  }
+  if (!object.getIsCollidable()) {
+    cs::core::Settings::serialize(i, "collidable", object.getIsCollidable());
+  }
+
+  return i;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void from_json(nlohmann::json const&                                               j,
     ObservableMap<std::string, std::shared_ptr<const cs::scene::CelestialObject>>& o) {
 
-  o.clear();
+  // Remove all objects which are not present anymore.
+  std::vector<std::string> removed;
+  for (auto const& [name, object] : o) {
+    if (j.find(name) == j.end()) {
+      removed.push_back(name);
+    }
+  }
+
+  for (auto const& name : removed) {
+    o.erase(name);
+  }
 
+  // Objects which have not changed are kept. This way, plugins do not have to re-attach their
+  // surfaces and intersectables to them when another scene is loaded.
   for (auto const& el : j.items()) {
-    std::string                name = el.key();
-    nlohmann::json             data = el.value();
-    cs::scene::CelestialObject object;
-
-    // First, we parse the required parameters.
-    std::string                center, frame;
-    std::array<std::string, 2> existence;
-    cs::core::Settings::deserialize(data, "center", center);
-    cs::core::Settings::deserialize(data, "frame", frame);
-    cs::core::Settings::deserialize(data, "existence", existence);
-
-    object.setCenterName(center);
-    object.setFrameName(frame);
-    object.setExistenceAsStrings(existence);
-
-    // All others are optional.
-    std::optional<glm::dvec3> position, radii;
-    std::optional<glm::dquat> rotation;
-    std::optional<double>     scale, bodyCullingRadius, orbitCullingRadius;
-    std::optional<bool>       trackable, collidable;
-    cs::core::Settings::deserialize(data, "position", position);
-    cs::core::Settings::deserialize(data, "rotation", rotation);
-    cs::core::Settings::deserialize(data, "scale", scale);
-    cs::core::Settings::deserialize(data, "radii", radii);
-    cs::core::Settings::deserialize(data, "bodyCullingRadius", bodyCullingRadius);
-    cs::core::Settings::deserialize(data, "orbitCullingRadius", orbitCullingRadius);
-    cs::core::Settings::deserialize(data, "trackable", trackable);
-    cs::core::Settings::deserialize(data, "collidable", collidable);
-
-    if (position.has_value()) {
-      object.setPosition(position.value());
-    }
-    if (rotation.has_value()) {
-      object.setRotation(rotation.value());
-    }
-    if (scale.has_value()) {
-      object.setScale(scale.value());
-    }
-    if (radii.has_value()) {
-      object.setRadii(radii.value());
-    }
-    if (bodyCullingRadius.has_value()) {
-      object.setBodyCullingRadius(bodyCullingRadius.value());
-    }
-    if (orbitCullingRadius.has_value()) {
-      object.setOrbitCullingRadius(orbitCullingRadius.value());
-    }
-    if (trackable.has_value()) {
-      object.setIsTrackable(trackable.value());
-    }
-    if (collidable.has_value()) {
-      object.setIsCollidable(collidable.value());
+    auto object   = parseObject(el.value());
+    auto existing = o.find(el.key());
+
+    if (existing != o.end()) {
+      if (writeObject(*existing->second) == writeObject(object)) {
+        continue;
+      }
+
+      o.erase(el.key());
     }
 
-    o.insert(name, std::make_shared<cs::scene::CelestialObject>(object));
+    o.insert(el.key(), std::make_shared<cs::scene::CelestialObject>(object));
   }
 }
 
@@ -104,39 +172,7 @@ void to_json(nlohmann::json&
   j.clear();
 
   for (auto const& [name, object] : o) {
-
-    nlohmann::json i;
-
-    cs::core::Settings::serialize(i, "center", object->getCenterName());
-    cs::core::Settings::serialize(i, "frame", object->getFrameName());
-    cs::core::Settings::serialize(i, "existence", object->getExistenceAsStrings());
-
-    if (object->getPosition() != glm::dvec3(0.0, 0.0, 0.0)) {
-      cs::core::Settings::serialize(i, "position", object->getPosition());
-    }
-    if (object->getRotation() != glm::dquat(1.0, 0.0, 0.0, 0.0)) {
-      cs::core::Settings::serialize(i, "rotation", object->getRotation());
-    }
-    if (object->getScale() != 1.0) {
-      cs::core::Settings::serialize(i, "scale", object->getScale());
-    }
-    if (object->hasCustomRadii()) {
-      cs::core::Settings::serialize(i, "radii", object->getRadii());
-    }
-    if (object->getBodyCullingRadius() != 0) {
-      cs::core::Settings::serialize(i, "bodyCullingRadius", object->getBodyCullingRadius());
-    }
-    if (object->getOrbitCullingRadius() != 0) {
-      cs::core::Settings::serialize(i, "orbitCullingRadius", object->getOrbitCullingRadius());
-    }
-    if (!object->getIsTrackable()) {
-      cs::core::Settings::serialize(i, "trackable", object->getIsTrackable());
-    }
-    if (!object->getIsCollidable()) {
-      cs::core::Settings::serialize(i, "collidable", object->getIsCollidable());
-    }
-
-    j[name] = i;
+    j[name] = writeObject(*object);
   }
 }
 
@@ -245,11 +281,15 @@ void to_json(nlohmann::json& j, Settings::Bookmark const& o) {
 void from_json(nlohmann::json const& j, Settings::DownloadData& o) {
   Settings::deserialize(j, "url", o.mUrl);
   Settings::deserialize(j, "file", o.mFile);
+  Settings::deserialize(j, "plugins", o.mPlugins);
+  Settings::deserialize(j, "sha256", o.mSha256);
 }
 
 void to_json(nlohmann::json& j, Settings::DownloadData const& o) {
   Settings::serialize(j, "url", o.mUrl);
   Settings::serialize(j, "file", o.mFile);
+  Settings::serialize(j, "plugins", o.mPlugins);
+  Settings::serialize(j, "sha256", o.mSha256);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -296,6 +336,13 @@ void from_json(nlohmann::json const& j, Settings::Graphics& o) {
   Settings::deserialize(j, "mainUIScale", o.pMainUIScale);
   Settings::deserialize(j, "heightScale", o.pHeightScale);
   Settings::deserialize(j, "enableHDR", o.pEnableHDR);
+  Settings::deserialize(j, "hdrBufferFormat", o.pHDRBufferFormat);
+  Settings::deserialize(j, "hdrResolutionScale", o.pHDRResolutionScale);
+  Settings::deserialize(j, "enableTemporalAntiAliasing", o.pEnableTemporalAntiAliasing);
+  Settings::deserialize(j, "enableDynamicQuality", o.pEnableDynamicQuality);
+  Settings::deserialize(j, "dynamicQualityFrameTimeRange", o.pDynamicQualityFrameTimeRange);
+  Settings::deserialize(j, "dynamicResolutionScaleRange", o.pDynamicResolutionScaleRange);
+  Settings::deserialize(j, "enableOcclusionCulling", o.pEnableOcclusionCulling);
   Settings::deserialize(j, "enableLighting", o.pEnableLighting);
   Settings::deserialize(j, "lightingQuality", o.pLightingQuality);
   Settings::deserialize(j, "enableShadows", o.pEnableShadows);
@@ -307,9 +354,13 @@ void from_json(nlohmann::json const& j, Settings::Graphics& o) {
   Settings::deserialize(j, "shadowMapRange", o.pShadowMapRange);
   Settings::deserialize(j, "shadowMapExtension", o.pShadowMapExtension);
   Settings::deserialize(j, "shadowMapSplitDistribution", o.pShadowMapSplitDistribution);
+  Settings::deserialize(j, "shadowMapUpdateInterval", o.pShadowMapUpdateInterval);
+  Settings::deserialize(j, "enableLayeredShadowMap", o.pEnableLayeredShadowMap);
   Settings::deserialize(j, "enableAutoExposure", o.pEnableAutoExposure);
   Settings::deserialize(j, "exposure", o.pExposure);
   Settings::deserialize(j, "autoExposureRange", o.pAutoExposureRange);
+  Settings::deserialize(j, "autoExposureMode", o.pAutoExposureMode);
+  Settings::deserialize(j, "autoExposurePercentiles", o.pAutoExposurePercentiles);
   Settings::deserialize(j, "exposureCompensation", o.pExposureCompensation);
   Settings::deserialize(j, "exposureAdaptionSpeed", o.pExposureAdaptionSpeed);
   Settings::deserialize(j, "sensorDiagonal", o.pSensorDiagonal);
@@ -323,7 +374,11 @@ void from_json(nlohmann::json const& j, Settings::Graphics& o) {
   Settings::deserialize(j, "enableBicubicGlareFiltering", o.pEnableBicubicGlareFilter);
   Settings::deserialize(j, "fixedSunDirection", o.pFixedSunDirection);
   Settings::deserialize(j, "eclipseShadowMaps", o.mEclipseShadowMaps);
+  Settings::deserialize(j, "shaderCacheDirectory", o.mShaderCacheDirectory);
   Settings::deserialize(j, "eclipseShadowMode", o.pEclipseShadowMode);
+  Settings::deserialize(j, "textureUploadBudget", o.pTextureUploadBudget);
+  Settings::deserialize(j, "gpuMemoryBudget", o.pGpuMemoryBudget);
+  Settings::deserialize(j, "gpuMemoryReserve", o.pGpuMemoryReserve);
 }
 
 void to_json(nlohmann::json& j, Settings::Graphics const& o) {
@@ -332,6 +387,13 @@ void to_json(nlohmann::json& j, Settings::Graphics const& o) {
   Settings::serialize(j, "mainUIScale", o.pMainUIScale);
   Settings::serialize(j, "heightScale", o.pHeightScale);
   Settings::serialize(j, "enableHDR", o.pEnableHDR);
+  Settings::serialize(j, "hdrBufferFormat", o.pHDRBufferFormat);
+  Settings::serialize(j, "hdrResolutionScale", o.pHDRResolutionScale);
+  Settings::serialize(j, "enableTemporalAntiAliasing", o.pEnableTemporalAntiAliasing);
+  Settings::serialize(j, "enableDynamicQuality", o.pEnableDynamicQuality);
+  Settings::serialize(j, "dynamicQualityFrameTimeRange", o.pDynamicQualityFrameTimeRange);
+  Settings::serialize(j, "dynamicResolutionScaleRange", o.pDynamicResolutionScaleRange);
+  Settings::serialize(j, "enableOcclusionCulling", o.pEnableOcclusionCulling);
   Settings::serialize(j, "enableLighting", o.pEnableLighting);
   Settings::serialize(j, "lightingQuality", o.pLightingQuality);
   Settings::serialize(j, "enableShadows", o.pEnableShadows);
@@ -343,9 +405,13 @@ void to_json(nlohmann::json& j, Settings::Graphics const& o) {
   Settings::serialize(j, "shadowMapRange", o.pShadowMapRange);
   Settings::serialize(j, "shadowMapExtension", o.pShadowMapExtension);
   Settings::serialize(j, "shadowMapSplitDistribution", o.pShadowMapSplitDistribution);
+  Settings::serialize(j, "shadowMapUpdateInterval", o.pShadowMapUpdateInterval);
+  Settings::serialize(j, "enableLayeredShadowMap", o.pEnableLayeredShadowMap);
   Settings::serialize(j, "enableAutoExposure", o.pEnableAutoExposure);
   Settings::serialize(j, "exposure", o.pExposure);
   Settings::serialize(j, "autoExposureRange", o.pAutoExposureRange);
+  Settings::serialize(j, "autoExposureMode", o.pAutoExposureMode);
+  Settings::serialize(j, "autoExposurePercentiles", o.pAutoExposurePercentiles);
   Settings::serialize(j, "exposureCompensation", o.pExposureCompensation);
   Settings::serialize(j, "exposureAdaptionSpeed", o.pExposureAdaptionSpeed);
   Settings::serialize(j, "sensorDiagonal", o.pSensorDiagonal);
@@ -359,7 +425,11 @@ void to_json(nlohmann::json& j, Settings::Graphics const& o) {
   Settings::serialize(j, "enableBicubicGlareFiltering", o.pEnableBicubicGlareFilter);
   Settings::serialize(j, "fixedSunDirection", o.pFixedSunDirection);
   Settings::serialize(j, "eclipseShadowMaps", o.mEclipseShadowMaps);
+  Settings::serialize(j, "shaderCacheDirectory", o.mShaderCacheDirectory);
   Settings::serialize(j, "eclipseShadowMode", o.pEclipseShadowMode);
+  Settings::serialize(j, "textureUploadBudget", o.pTextureUploadBudget);
+  Settings::serialize(j, "gpuMemoryBudget", o.pGpuMemoryBudget);
+  Settings::serialize(j, "gpuMemoryReserve", o.pGpuMemoryReserve);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -369,12 +439,17 @@ void from_json(nlohmann::json const& j, Settings& o) {
   Settings::deserialize(j, "resetDate", o.mResetDate);
   Settings::deserialize(j, "observer", o.mObserver);
   Settings::deserialize(j, "spiceKernel", o.pSpiceKernel);
+  Settings::deserialize(j, "ephemerisInterpolationError", o.pEphemerisInterpolationError);
   Settings::deserialize(j, "sceneScale", o.mSceneScale);
   Settings::deserialize(j, "guiPosition", o.mGuiPosition);
   Settings::deserialize(j, "graphics", o.mGraphics);
   Settings::deserialize(j, "enableUserInterface", o.pEnableUserInterface);
+  Settings::deserialize(j, "enableAcceleratedGui", o.pEnableAcceleratedGui);
+  Settings::deserialize(j, "guiRendererProcessLimit", o.pGuiRendererProcessLimit);
+  Settings::deserialize(j, "guiBrowserPoolSize", o.pGuiBrowserPoolSize);
   Settings::deserialize(j, "enableMouseRay", o.pEnableMouseRay);
   Settings::deserialize(j, "enableSensorSizeControl", o.pEnableSensorSizeControl);
+  Settings::deserialize(j, "enableLateHeadTracking", o.pEnableLateHeadTracking);
   Settings::deserialize(j, "logLevelFile", o.pLogLevelFile);
   Settings::deserialize(j, "logLevelConsole", o.pLogLevelConsole);
   Settings::deserialize(j, "logLevelScreen", o.pLogLevelScreen);
@@ -385,6 +460,9 @@ void from_json(nlohmann::json const& j, Settings& o) {
   Settings::deserialize(j, "maxDate", o.pMaxDate);
   Settings::deserialize(j, "timeSpeed", o.pTimeSpeed);
   Settings::deserialize(j, "downloadData", o.mDownloadData);
+  Settings::deserialize(j, "maxConnectionsPerHost", o.pMaxConnectionsPerHost);
+  Settings::deserialize(j, "autosaveInterval", o.pAutosaveInterval);
+  Settings::deserialize(j, "autosaveFile", o.pAutosaveFile);
   Settings::deserialize(j, "bookmarks", o.mBookmarks);
   Settings::deserialize(j, "commandHistory", o.mCommandHistory);
 }
@@ -394,12 +472,17 @@ void to_json(nlohmann::json& j, Settings const& o) {
   Settings::serialize(j, "resetDate", o.mResetDate);
   Settings::serialize(j, "observer", o.mObserver);
   Settings::serialize(j, "spiceKernel", o.pSpiceKernel);
+  Settings::serialize(j, "ephemerisInterpolationError", o.pEphemerisInterpolationError);
   Settings::serialize(j, "sceneScale", o.mSceneScale);
   Settings::serialize(j, "guiPosition", o.mGuiPosition);
   Settings::serialize(j, "graphics", o.mGraphics);
   Settings::serialize(j, "enableUserInterface", o.pEnableUserInterface);
+  Settings::serialize(j, "enableAcceleratedGui", o.pEnableAcceleratedGui);
+  Settings::serialize(j, "guiRendererProcessLimit", o.pGuiRendererProcessLimit);
+  Settings::serialize(j, "guiBrowserPoolSize", o.pGuiBrowserPoolSize);
   Settings::serialize(j, "enableMouseRay", o.pEnableMouseRay);
   Settings::serialize(j, "enableSensorSizeControl", o.pEnableSensorSizeControl);
+  Settings::serialize(j, "enableLateHeadTracking", o.pEnableLateHeadTracking);
   Settings::serialize(j, "logLevelFile", o.pLogLevelFile);
   Settings::serialize(j, "logLevelConsole", o.pLogLevelConsole);
   Settings::serialize(j, "logLevelScreen", o.pLogLevelScreen);
@@ -410,12 +493,101 @@ void to_json(nlohmann::json& j, Settings const& o) {
   Settings::serialize(j, "maxDate", o.pMaxDate);
   Settings::serialize(j, "timeSpeed", o.pTimeSpeed);
   Settings::serialize(j, "downloadData", o.mDownloadData);
+  Settings::serialize(j, "maxConnectionsPerHost", o.pMaxConnectionsPerHost);
+  Settings::serialize(j, "autosaveInterval", o.pAutosaveInterval);
+  Settings::serialize(j, "autosaveFile", o.pAutosaveFile);
   Settings::serialize(j, "bookmarks", o.mBookmarks);
   Settings::serialize(j, "commandHistory", o.mCommandHistory);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Settings::Transaction::Transaction(Settings& settings)
+    : mSettings(settings) {
+
+  // The state before the outermost transaction is compared to the state after it.
+  if (mSettings.mTransactionDepth++ == 0) {
+    mSettings.mTransactionSnapshot = mSettings;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Settings::Transaction::~Transaction() {
+  if (--mSettings.mTransactionDepth > 0) {
+    return;
+  }
+
+  ChangeSet changes;
+
+  try {
+    nlohmann::json const  current  = mSettings;
+    nlohmann::json const& previous = mSettings.mTransactionSnapshot;
+
+    auto compare = [](nlohmann::json const& a, nlohmann::json const& b,
+                       std::set<std::string>& changedKeys) {
+      for (auto const& item : a.items()) {
+        auto other = b.find(item.key());
+        if (other == b.end() || *other != item.value()) {
+          changedKeys.insert(item.key());
+        }
+      }
+      for (auto const& item : b.items()) {
+        if (a.find(item.key()) == a.end()) {
+          changedKeys.insert(item.key());
+        }
+      }
+    };
+
+    compare(previous, current, changes.mSections);
+
+    if (changes.mSections.count("plugins") > 0) {
+      compare(previous.value("plugins", nlohmann::json::object()),
+          current.value("plugins", nlohmann::json::object()), changes.mPlugins);
+    }
+
+  } catch (std::exception const& e) {
+    logger().warn("Failed to determine the settings changed by a transaction: {}", e.what());
+  }
+
+  mSettings.mTransactionSnapshot = nullptr;
+
+  if (changes.mSections.empty()) {
+    return;
+  }
+
+  // Transactions which end in the same frame are reported together.
+  if (mSettings.mPendingChangeSet) {
+    mSettings.mPendingChangeSet->mSections.merge(changes.mSections);
+    mSettings.mPendingChangeSet->mPlugins.merge(changes.mPlugins);
+  } else {
+    mSettings.mPendingChangeSet = std::move(changes);
+
+    // The change set is emitted by utils::emitDeferredPropertyChanges() after all Properties which
+    // have been enqueued before.
+    utils::detail::enqueueDeferredEmission(&mSettings, &Settings::emitChangeSet);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Settings::~Settings() {
+  if (mPendingChangeSet) {
+    utils::detail::dequeueDeferredEmission(this);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Settings::emitChangeSet(void* settings) {
+  auto* self    = static_cast<Settings*>(settings);
+  auto  changes = std::move(*self->mPendingChangeSet);
+  self->mPendingChangeSet.reset();
+  self->mOnChange.emit(changes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 utils::Signal<> const& Settings::onLoad() const {
   return mOnLoad;
 }
@@ -424,41 +596,134 @@ utils::Signal<> const& Settings::onSave() const {
   return mOnSave;
 }
 
+utils::Signal<Settings::ChangeSet> const& Settings::onChange() const {
+  return mOnChange;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Settings::loadFromFile(std::string const& fileName) {
-  std::ifstream i(fileName);
+  std::ifstream i(fileName, std::ios::binary);
 
   if (!i) {
     throw std::runtime_error("Cannot open file: '" + fileName + "'!");
   }
 
-  nlohmann::json settings;
-  i >> settings;
+  // Parsing from a contiguous buffer is much faster than parsing from the stream character by
+  // character.
+  std::string json((std::istreambuf_iterator<char>(i)), std::istreambuf_iterator<char>());
 
-  from_json(settings, *this);
-
-  // Notify listeners that values might have changed.
-  mOnLoad.emit();
+  load(nlohmann::json::parse(json));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Settings::loadFromJson(std::string const& json) {
+  load(nlohmann::json::parse(json));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Settings::load(nlohmann::json const& settings) {
+
+  // Let the plugins store their current state, so that it can be compared to the new settings.
+  mOnSave.emit();
+
+  ChangeSet changes;
+
+  auto newPlugins = settings.value("plugins", nlohmann::json::object());
+
+  for (auto const& [name, plugin] : mPlugins) {
+    auto other = newPlugins.find(name);
+    if (other == newPlugins.end() || *other != plugin) {
+      changes.mPlugins.insert(name);
+    }
+  }
+
+  for (auto const& item : newPlugins.items()) {
+    if (mPlugins.find(item.key()) == mPlugins.end()) {
+      changes.mPlugins.insert(item.key());
+    }
+  }
+
+  // Unchanged objects are kept by the deserialization, so changed objects can be found by
+  // comparing the pointers.
+  std::map<std::string, std::shared_ptr<const cs::scene::CelestialObject>> oldObjects(
+      mObjects.begin(), mObjects.end());
 
-  nlohmann::json settings = nlohmann::json::parse(json);
   from_json(settings, *this);
 
+  for (auto const& [name, object] : mObjects) {
+    auto old = oldObjects.find(name);
+    if (old == oldObjects.end() || old->second != object) {
+      changes.mObjects.insert(name);
+    }
+    if (old != oldObjects.end()) {
+      oldObjects.erase(old);
+    }
+  }
+
+  for (auto const& [name, object] : oldObjects) {
+    changes.mObjects.insert(name);
+  }
+
+  mLoadChanges = std::move(changes);
+
   // Notify listeners that values might have changed.
   mOnLoad.emit();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Settings::ChangeSet const& Settings::getLoadChanges() const {
+  return mLoadChanges;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Settings::hasPluginChangedOnLoad(std::string const& plugin) const {
+  return !mLoadChanges.mObjects.empty() || mLoadChanges.mPlugins.count(plugin) > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Settings::saveToFile(std::string const& fileName) const {
+  writeToFile(saveToJsonObject(), fileName);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::future<void> Settings::saveToFileAsync(std::string const& fileName) const {
+  return std::async(std::launch::async,
+      [settings = saveToJsonObject(), fileName]() { writeToFile(settings, fileName); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string Settings::saveToJson() const {
+  // Use an indentation of two space.
+  std::ostringstream o;
+  o << std::setw(2) << saveToJsonObject();
+
+  return o.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+nlohmann::json Settings::saveToJsonObject() const {
   // Tell listeners that the settings are about to be saved.
   mOnSave.emit();
 
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Settings::writeToFile(nlohmann::json const& settings, std::string const& fileName) {
+  // Files may be written from several worker threads.
+  static std::mutex           mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+
   // Write to a temporary file first.
   std::ofstream o(fileName + ".tmp");
 
@@ -466,7 +731,6 @@ void Settings::saveToFile(std::string const& fileName) const {
     throw std::runtime_error("Cannot open file: '" + fileName + "'!");
   }
 
-  nlohmann::json settings = *this;
   o << std::setw(2) << settings;
 
   o.close();
@@ -480,21 +744,6 @@ void Settings::saveToFile(std::string const& fileName) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::string Settings::saveToJson() const {
-  // Tell listeners that the settings are about to be saved.
-  mOnSave.emit();
-
-  nlohmann::json settings = *this;
-
-  // Use an indentation of two space.
-  std::ostringstream o;
-  o << std::setw(2) << settings;
-
-  return o.str();
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 Settings::DeserializationException::DeserializationException(
     std::string property, std::string jsonError)
     : mProperty(std::move(property))
@@ -22,11 +22,13 @@
 #include <cstdint>
 #include <deque>
 #include <exception>
+#include <future>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <map>
 #include <nlohmann/json.hpp>
 #include <optional>
+#include <set>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <vector>
@@ -119,6 +121,57 @@ class CS_CORE_EXPORT Settings {
  public:
   // -----------------------------------------------------------------------------------------------
 
+  /// The parts of the settings which have been modified during a Transaction or by the last call to
+  /// loadFromFile() or loadFromJson().
+  struct ChangeSet {
+
+    /// The top-level keys of all changed settings, for example "observer" or "plugins".
+    std::set<std::string> mSections;
+
+    /// The names of all plugins whose settings have been changed, added or removed.
+    std::set<std::string> mPlugins;
+
+    /// The names of all celestial objects which have been changed, added or removed. This is only
+    /// filled by loadFromFile() and loadFromJson().
+    std::set<std::string> mObjects;
+  };
+
+  /// While a Transaction exists, Properties which are modified on the main thread do not emit their
+  /// change signals right away (see utils::PropertyTransaction). Instead, each changed Property
+  /// emits its change signal once with its final value at the beginning of the next frame. After
+  /// this, the onChange signal is emitted once with all parts of the settings which have been
+  /// changed. This avoids redundant reconfiguration if many settings are changed at once, for
+  /// example when a scene is loaded with loadFromFile(). Transactions can be nested, only the
+  /// outermost one is considered.
+  class CS_CORE_EXPORT Transaction {
+   public:
+    explicit Transaction(Settings& settings);
+
+    Transaction(Transaction const& other) = delete;
+    Transaction(Transaction&& other)      = delete;
+
+    Transaction& operator=(Transaction const& other) = delete;
+    Transaction& operator=(Transaction&& other)      = delete;
+
+    ~Transaction();
+
+   private:
+    Settings&                  mSettings;
+    utils::PropertyTransaction mPropertyTransaction;
+  };
+
+  Settings() = default;
+
+  Settings(Settings const& other) = default;
+  Settings(Settings&& other)      = default;
+
+  Settings& operator=(Settings const& other) = default;
+  Settings& operator=(Settings&& other)      = default;
+
+  ~Settings();
+
+  // -----------------------------------------------------------------------------------------------
+
   /// This Signal is emitted when the settings are reloaded from file. You can connect a function
   /// to check whether something has changed compared to the last settings state. The very first
   /// onLoad will be emitted before any Plugin or core class is initialized, so don't rely on that
@@ -131,22 +184,49 @@ class CS_CORE_EXPORT Settings {
   /// else other handlers will not be called properly!
   utils::Signal<> const& onSave() const;
 
+  /// This signal is emitted at the beginning of the frame after a Transaction has been completed.
+  /// At this point, all Properties which have been changed during the transaction have emitted
+  /// their change signals. It is not emitted if nothing has changed.
+  utils::Signal<ChangeSet> const& onChange() const;
+
   /// Initializes all members from a given JSON file. Once reading finished, the onLoad signal will
-  /// be emitted.
+  /// be emitted. At run-time, this should be wrapped in a Transaction.
   void loadFromFile(std::string const& fileName);
 
   /// Initializes all members from a given JSON object. Once reading finished, the onLoad signal
-  /// will be emitted.
+  /// will be emitted. At run-time, this should be wrapped in a Transaction.
   void loadFromJson(std::string const& json);
 
+  /// Returns the parts of the settings which have been changed by the last call to loadFromFile()
+  /// or loadFromJson(). Before loading, the onSave signal is emitted so that the new settings are
+  /// compared to the current state of the plugins. Unchanged celestial objects are kept, so their
+  /// pointers remain valid.
+  ChangeSet const& getLoadChanges() const;
+
+  /// Returns true if the settings of the given plugin or any celestial object have been changed by
+  /// the last call to loadFromFile() or loadFromJson(). Plugins use this in their onLoad handler to
+  /// skip their reconfiguration if a scene is loaded which does not affect them.
+  bool hasPluginChangedOnLoad(std::string const& plugin) const;
+
   /// Writes the current settings to a JSON file. Before the state is written to file, the onSave
   /// signal will be emitted.
   void saveToFile(std::string const& fileName) const;
 
+  /// Same as saveToFile(), but only the onSave signal and the conversion to a JSON object happen on
+  /// the calling thread. Formatting and writing the file is done on a worker thread, as this can
+  /// take several milliseconds for large scenes. The returned future becomes ready once the file
+  /// has been written; any error is rethrown by its get() method. If several saves are pending at
+  /// the same time, the files are written one after another.
+  std::future<void> saveToFileAsync(std::string const& fileName) const;
+
   /// Writes the current settings to a JSON object. Before the state is stored, the onSave
   /// signal will be emitted.
   std::string saveToJson() const;
 
+  /// Same as saveToJson(), but the settings are not formatted. This can be used to format them on
+  /// another thread.
+  nlohmann::json saveToJsonObject() const;
+
   // -----------------------------------------------------------------------------------------------
 
   /// Defines the initial simulation time. Should be either "today" or in the format
@@ -296,9 +376,25 @@ class CS_CORE_EXPORT Settings {
   /// The file name of the meta kernel for SPICE.
   utils::Property<std::string> pSpiceKernel;
 
+  /// If greater than zero, the positions of all celestial objects relative to the observer are
+  /// interpolated from Chebyshev series which deviate at most this many meters from SPICE.
+  utils::DefaultProperty<double> pEphemerisInterpolationError{0.0};
+
   /// If set to false, the user interface is completely hidden.
   utils::DefaultProperty<bool> pEnableUserInterface{true};
 
+  /// If set to true, the web pages of the user interface are rendered on the GPU and shared as
+  /// textures. This is only supported on Windows and only read at startup.
+  utils::DefaultProperty<bool> pEnableAcceleratedGui{false};
+
+  /// If set to a value larger than zero, all web pages of the user interface share at most this
+  /// many renderer processes. This is only read at startup.
+  utils::DefaultProperty<uint32_t> pGuiRendererProcessLimit{0};
+
+  /// The browsers of this many destroyed web views are kept for reuse by new web views showing
+  /// pages of the same origin. This is only read at startup.
+  utils::DefaultProperty<uint32_t> pGuiBrowserPoolSize{4};
+
   /// If set to true, a ray is shown emerging from your input device.
   utils::DefaultProperty<bool> pEnableMouseRay{false};
 
@@ -306,14 +402,39 @@ class CS_CORE_EXPORT Settings {
   /// frustum. In a VR setup, this should usually be set to 'false'.
   utils::DefaultProperty<bool> pEnableSensorSizeControl{true};
 
+  /// If set to true, the platform is moved according to the latest head tracking data once more
+  /// right before rendering. This requires an interaction context with the role "HEADPOSE" whose
+  /// graph can be evaluated several times per frame, see config/base/vista/interaction_hmd.ini.
+  utils::DefaultProperty<bool> pEnableLateHeadTracking{true};
+
   /// A list of files which shall be downloaded before the application starts.
   struct DownloadData {
     std::string mUrl;
     std::string mFile;
+
+    /// The names of the plugins which require this file. If this is given, the file is downloaded
+    /// in the background while the SolarSystem and the other plugins are initialized, and only the
+    /// given plugins wait for it. Files without this list are required by the SolarSystem (for
+    /// example SPICE kernels), so they are downloaded first and everything waits for them.
+    std::optional<std::vector<std::string>> mPlugins;
+
+    /// The SHA-256 hash of the file as hexadecimal string. If this is given, the downloaded file is
+    /// discarded if its hash does not match.
+    std::optional<std::string> mSha256;
   };
 
   std::vector<DownloadData> mDownloadData;
 
+  /// At most this many HTTP requests are performed concurrently to the same server. This applies
+  /// to all plugins together.
+  utils::DefaultProperty<uint32_t> pMaxConnectionsPerHost{8};
+
+  /// If greater than zero, the settings are written to pAutosaveFile every this many seconds. The
+  /// file is written on a worker thread, so this does not cause frame drops. Starting CosmoScout VR
+  /// with this file restores the scene, for example after a crash.
+  utils::DefaultProperty<double>      pAutosaveInterval{0.0};
+  utils::DefaultProperty<std::string> pAutosaveFile{"autosave.json"};
+
   /// If the (optional) object is given in the configuration file, the user interface is not drawn
   /// in full-screen but rather at the given viewspace postion.
   struct GuiPosition {
@@ -372,6 +493,40 @@ class CS_CORE_EXPORT Settings {
     /// time. Defaults to false.
     utils::DefaultProperty<bool> pEnableHDR{false};
 
+    /// The format of the color attachments of the HDR buffer. The reduced-precision formats save
+    /// memory bandwidth in all HDR passes.
+    utils::DefaultProperty<graphics::HDRBuffer::Format> pHDRBufferFormat{
+        graphics::HDRBuffer::Format::eRGBA32F};
+
+    /// The resolution of the HDR buffer relative to the viewport size. It is upscaled during tone
+    /// mapping. This has no effect if the dynamic quality is enabled.
+    utils::DefaultProperty<float> pHDRResolutionScale{1.F};
+
+    /// If set to true, the projection is jittered by a sub-pixel amount each frame and the HDR
+    /// buffer is blended with the reprojected previous frames before tone mapping. This is a much
+    /// cheaper alternative to multi-sampling and has no effect if multi-sampling is enabled.
+    utils::DefaultProperty<bool> pEnableTemporalAntiAliasing{false};
+
+    /// If set to true, the GraphicsEngine reduces its pDynamicQuality if the frame time exceeds the
+    /// upper bound of pDynamicQualityFrameTimeRange and increases it again if the frame time falls
+    /// below the lower bound. This scales the resolution of the HDR buffer within
+    /// pDynamicResolutionScaleRange and the glare quality between zero and pGlareQuality.
+    /// Plugins may reduce the quality of their effects as well, for example the LOD factor of
+    /// csp-lod-bodies and the resolution of csp-atmospheres.
+    utils::DefaultProperty<bool> pEnableDynamicQuality{false};
+
+    /// The dynamic quality tries to keep the frame time in this range. Given in milliseconds.
+    utils::DefaultProperty<glm::vec2> pDynamicQualityFrameTimeRange{glm::vec2(14.F, 16.F)};
+
+    /// The range of the resolution of the HDR buffer relative to the viewport size which is used by
+    /// the dynamic quality.
+    utils::DefaultProperty<glm::vec2> pDynamicResolutionScaleRange{glm::vec2(0.5F, 1.F)};
+
+    /// If set to true, bodies and trajectories which are completely hidden behind another body are
+    /// not drawn. The bodies are approximated by spheres for this test, see
+    /// SolarSystem::updateOcclusion().
+    utils::DefaultProperty<bool> pEnableOcclusionCulling{true};
+
     /// If set to false, all shading computations should be disabled.
     utils::DefaultProperty<bool> pEnableLighting{true};
 
@@ -409,6 +564,15 @@ class CS_CORE_EXPORT Settings {
     /// An exponent for controlling the distribution of shadow map cascades.
     utils::DefaultProperty<float> pShadowMapSplitDistribution{1.F};
 
+    /// All but the first shadow map cascade are only updated every n-th frame. Cascades which have
+    /// not changed are never updated.
+    utils::DefaultProperty<int> pShadowMapUpdateInterval{1};
+
+    /// If set to true, all shadow map cascades are drawn in a single pass if the graphics driver
+    /// supports it. Terrain tiles are then selected once for all cascades, which may result in a
+    /// lower terrain resolution in the first cascade.
+    utils::DefaultProperty<bool> pEnableLayeredShadowMap{false};
+
     /// If set to true, the exposure of the virtual camera will be computed automatically. Has no
     /// effect if HDR rendering is disabled.
     utils::DefaultProperty<bool> pEnableAutoExposure{true};
@@ -421,6 +585,15 @@ class CS_CORE_EXPORT Settings {
     /// (EV).
     utils::DefaultProperty<glm::vec2> pAutoExposureRange{glm::vec2(-12.F, 9.F)};
 
+    /// Specifies how the auto exposure is computed. The histogram mode runs entirely on the GPU but
+    /// meters each viewport separately. Use the average mode for cluster setups.
+    utils::DefaultProperty<graphics::ToneMappingNode::AutoExposureMode> pAutoExposureMode{
+        graphics::ToneMappingNode::AutoExposureMode::eHistogram};
+
+    /// The histogram-based auto exposure only considers pixels with a luminance between these two
+    /// percentiles. Both values should be in the range 0-1.
+    utils::DefaultProperty<glm::vec2> pAutoExposurePercentiles{glm::vec2(0.5F, 0.95F)};
+
     /// An additional exposure control which is applied after auto exposure. Has no effect if HDR
     /// rendering is disabled. Measured in exposure values (EV).
     utils::DefaultProperty<float> pExposureCompensation{0.F};
@@ -469,6 +642,23 @@ class CS_CORE_EXPORT Settings {
 
     /// The eclipse shadow rendering mode.
     utils::DefaultProperty<EclipseShadowMode> pEclipseShadowMode{EclipseShadowMode::eFastTexture};
+
+    /// If set, linked shader programs are stored as binaries in this directory and loaded from
+    /// there when the same shader is requested from the graphics::ShaderCache again.
+    std::optional<std::string> mShaderCacheDirectory;
+
+    /// Textures which are loaded in the background are uploaded to the GPU in parts of at most
+    /// this many megabytes per frame. See graphics::TextureLoader::loadFromFileAsync().
+    utils::DefaultProperty<uint32_t> pTextureUploadBudget{32};
+
+    /// The GPU memory which should be used by CosmoScout VR and its plugins in megabytes. Zero
+    /// means that there is no limit apart from the available video memory. See
+    /// graphics::GpuMemory.
+    utils::DefaultProperty<uint32_t> pGpuMemoryBudget{0};
+
+    /// If the driver reports less available video memory than this many megabytes, subsystems are
+    /// asked to free some of their resources. This is only supported on NVIDIA and AMD GPUs.
+    utils::DefaultProperty<uint32_t> pGpuMemoryReserve{256};
   };
 
   Graphics mGraphics;
@@ -545,8 +735,23 @@ class CS_CORE_EXPORT Settings {
       nlohmann::json& j, std::string const& property, utils::DefaultProperty<T> const& target);
 
  private:
-  mutable utils::Signal<> mOnLoad;
-  mutable utils::Signal<> mOnSave;
+  static void emitChangeSet(void* settings);
+
+  /// Formats the given settings and writes them to a temporary file which then replaces the given
+  /// file. This can be called from any thread.
+  static void writeToFile(nlohmann::json const& settings, std::string const& fileName);
+
+  /// Deserializes the given settings and records what has changed in mLoadChanges.
+  void load(nlohmann::json const& settings);
+
+  mutable utils::Signal<>          mOnLoad;
+  mutable utils::Signal<>          mOnSave;
+  mutable utils::Signal<ChangeSet> mOnChange;
+
+  int                      mTransactionDepth = 0;
+  nlohmann::json           mTransactionSnapshot;
+  std::optional<ChangeSet> mPendingChangeSet;
+  ChangeSet                mLoadChanges;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,8 +10,11 @@
 #include "SolarSystem.hpp"
 
 #include "../cs-graphics/EclipseShadowMap.hpp"
+#include "../cs-graphics/ObjectTransformBuffer.hpp"
 #include "../cs-scene/CelestialSurface.hpp"
+#include "../cs-scene/EphemerisCache.hpp"
 #include "../cs-utils/FrameStats.hpp"
+#include "../cs-utils/Tracing.hpp"
 #include "../cs-utils/convert.hpp"
 #include "../cs-utils/utils.hpp"
 #include "GraphicsEngine.hpp"
@@ -26,7 +29,9 @@
 #include <VistaKernel/GraphicsManager/VistaTransformNode.h>
 #include <VistaKernel/VistaSystem.h>
 #include <cspice/SpiceUsr.h>
+#include <cmath>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/component_wise.hpp>
 #include <glm/gtx/quaternion.hpp>
 
 namespace cs::core {
@@ -38,7 +43,8 @@ SolarSystem::SolarSystem(std::shared_ptr<Settings> settings,
     : mSettings(std::move(settings))
     , mGraphicsEngine(std::move(graphicsEngine))
     , mTimeControl(std::move(timeControl))
-    , mSun(getObject("Sun")) {
+    , mSun(getObject("Sun"))
+    , mObjectTransformBuffer(std::make_unique<graphics::ObjectTransformBuffer>()) {
 
   // Tell the user what's going on.
   logger().debug("Creating SolarSystem.");
@@ -116,71 +122,56 @@ double SolarSystem::getSunLuminance() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::shared_ptr<graphics::EclipseShadowMap>> SolarSystem::getEclipseShadowMaps(
-    scene::CelestialObject const& receiver, bool allowSelfShadowing) const {
+void SolarSystem::getEclipseShadowCasters(scene::CelestialObject const& receiver,
+    bool allowSelfShadowing, std::vector<EclipseShadowCaster>& casters) const {
 
-  std::vector<std::shared_ptr<graphics::EclipseShadowMap>> result;
+  casters.clear();
 
-  // Loop through all registered eclipse shadow casters and test if they are casting a shadow onto
-  // the given receiver. All involved objects are considered to be spheres.
-  for (auto const& shadowMap : mGraphicsEngine->getEclipseShadowMaps()) {
-    auto occluder = getObject(shadowMap->mOccluder);
+  // Test the receiver against the shadow cones of all registered eclipse shadow casters. All
+  // involved objects are considered to be spheres.
+  for (auto const& cone : mEclipseShadowCones) {
 
     // Avoid self-shadowing.
-    if (allowSelfShadowing || receiver.getCenterName() != occluder->getCenterName()) {
-
-      // Get observer-centric positions.
-      auto pSun = mSun->getObserverRelativePosition() * mObserver.getScale();
-      auto pRec = receiver.getObserverRelativePosition() * mObserver.getScale();
-      auto pOcc = occluder->getObserverRelativePosition() * mObserver.getScale();
-
-      // Convert to receiver-centric.
-      pSun = pSun - pOcc;
-      pRec = pRec - pOcc;
-
-      double dSun = glm::length(pSun);
-      double dRec = glm::length(pRec);
-
-      // Do not consider cases where the receiver is really far away.
-      if (dRec > 0.1 * dSun) {
-        continue;
-      }
-
-      // Do not consider cases where the receiver is in front of the caster.
-      if (glm::dot(pSun / dSun, pRec / dRec) > 0) {
-        continue;
-      }
+    if (!allowSelfShadowing && receiver.getCenterName() == cone.mOccluder->getCenterName()) {
+      continue;
+    }
 
-      double rOcc = occluder->getRadii()[0];
-      double rRec = receiver.getRadii()[0];
-      double rSun = mSun->getRadii()[0];
+    // Get the occluder-centric position of the receiver.
+    glm::dvec3 pRec =
+        receiver.getObserverRelativePosition() * mObserver.getScale() - cone.mOccluderPosition;
+    double dRec = glm::length(pRec);
 
-      // Compute distances to the tips of the umbra and penumbra cones.
-      double dUmbra    = dSun * rOcc / (rSun - rOcc);
-      double dPenumbra = dSun * rOcc / (rSun + rOcc);
+    // Do not consider cases where the receiver is really far away.
+    if (dRec > 0.1 * cone.mSunDistance) {
+      continue;
+    }
 
-      // Compute slopes of the penumbra cone.
-      double mPenumbra = rOcc / std::sqrt(dPenumbra * dUmbra - rOcc * rOcc);
+    // Do not consider cases where the receiver is in front of the caster.
+    if (glm::dot(cone.mSunToOccluder, pRec / dRec) < 0) {
+      continue;
+    }
 
-      // Project the vector from the occluder to the receiver onto the sun-occluder axis.
-      auto toOcc        = -pRec;
-      auto sunToOccNorm = -pSun / dSun;
-      auto toOccProj    = glm::dot(toOcc, sunToOccNorm) * sunToOccNorm;
+    // Project the vector from the occluder to the receiver onto the sun-occluder axis.
+    auto toOcc     = -pRec;
+    auto toOccProj = glm::dot(toOcc, cone.mSunToOccluder) * cone.mSunToOccluder;
 
-      // Get position in shadow space.
-      double posX = glm::length(toOccProj);
-      double posY = glm::length(toOcc - toOccProj);
+    // Get position in shadow space.
+    double posX = glm::length(toOccProj);
+    double posY = glm::length(toOcc - toOccProj);
 
-      // Distances of the penumbra and umbra cones from the sun-occluder axis at posX.
-      double penumbra = mPenumbra * (posX + dPenumbra);
+    // Distance of the penumbra cone from the sun-occluder axis at posX.
+    double penumbra = cone.mPenumbraSlope * (posX + cone.mPenumbraTipDistance);
 
-      if (posY < penumbra + rRec) {
-        result.push_back(shadowMap);
-      }
+    if (posY < penumbra + receiver.getRadii()[0]) {
+      casters.push_back(cone.mCaster);
     }
   }
+}
 
-  return result;
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec4 const& SolarSystem::getEclipseSun() const {
+  return mEclipseSun;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -203,6 +194,12 @@ scene::CelestialObserver const& SolarSystem::getObserver() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+scene::EphemerisService& SolarSystem::getEphemerisService() {
+  return mEphemerisService;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void SolarSystem::fixObserverFrame(double lastWorkingSimulationTime) {
   // We try getting the position of the observer relative to the origin of the Solar System. If this
   // fails, something is wrong with our observer frame.
@@ -223,19 +220,53 @@ void SolarSystem::fixObserverFrame(double lastWorkingSimulationTime) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::update() {
+  CS_TRACE_ZONE("SolarSystem::update");
+
   double simulationTime(mTimeControl->pSimulationTime.get());
   double realTime(
       utils::convert::time::toSpice(boost::posix_time::microsec_clock::universal_time()));
   mObserver.updateMovementAnimation(realTime);
 
+  // The SPICE queries of the last frame will most likely not be needed anymore, unless the
+  // simulation time is paused.
+  if (simulationTime != mLastSimulationTime) {
+    scene::EphemerisCache::clear();
+    mLastSimulationTime = simulationTime;
+  }
+
+  // Fit series to the positions of all existing objects if interpolation is enabled.
+  std::vector<std::string> targets;
+  for (auto const& [name, object] : mSettings->mObjects) {
+    auto existence = object->getExistence();
+    if (simulationTime > existence[0] && simulationTime < existence[1]) {
+      targets.push_back(object->getCenterName());
+    }
+  }
+
+  {
+    CS_TRACE_ZONE("Ephemeris Interpolation");
+    CS_TRACE_PLOT("Existing Objects", static_cast<int64_t>(targets.size()));
+    mEphemerisInterpolator.setMaxError(mSettings->pEphemerisInterpolationError.get());
+    mEphemerisInterpolator.update(simulationTime, mObserver, targets);
+  }
+
   // First, update all celestial object positions.
   for (auto const& [name, object] : mSettings->mObjects) {
-    utils::FrameStats::ScopedTimer timer(
-        "Update " + object->getCenterName() + " / " + object->getFrameName(),
-        utils::FrameStats::TimerMode::eCPU);
+    // The name of this timer is only assembled if measurements are enabled.
+    auto timerId = utils::FrameStats::get().pEnableMeasurements.get()
+                       ? utils::FrameStats::intern(
+                             "Update " + object->getCenterName() + " / " + object->getFrameName())
+                       : utils::FrameStats::TimerId{};
+    utils::FrameStats::ScopedTimer timer(timerId, utils::FrameStats::TimerMode::eCPU);
     object->update(simulationTime, mObserver);
   }
 
+  // Then hide all objects which are behind other bodies.
+  {
+    CS_TRACE_ZONE("Occlusion Culling");
+    updateOcclusion();
+  }
+
   // Update sun position. If a fixed Sun direction is enabled, we must calculate an artificial
   // position in the current SPICE frame at the same distance as the true Sun would be.
   auto fixedSunDist2 = glm::length2(mSettings->mGraphics.pFixedSunDirection.get());
@@ -249,6 +280,12 @@ void SolarSystem::update() {
     pSunPosition = mSun->getObserverRelativePosition();
   }
 
+  // Compute the shadow cones of all eclipse shadow casters for this frame.
+  {
+    CS_TRACE_ZONE("Eclipse Shadow Cones");
+    updateEclipseShadowCones();
+  }
+
   // Calculate luminous power of the Sun. This can be calculated by multiplying the illuminance at
   // the average distance of Earth with the surface area of a sphere with a radius of the average
   // distance of Earth.
@@ -285,6 +322,210 @@ void SolarSystem::update() {
   mSettings->mObserver.pFrame    = mObserver.getFrameName();
   mSettings->mObserver.pPosition = mObserver.getPosition();
   mSettings->mObserver.pRotation = mObserver.getRotation();
+
+  publishFrameSnapshot();
+  updateObjectTransforms();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SolarSystem::updateOcclusion() {
+
+  // The occlusion of the last frame must not influence the visibility of the occluders.
+  for (auto const& [name, object] : mSettings->mObjects) {
+    object->setIsBodyOccluded(false);
+    object->setIsOrbitOccluded(false);
+  }
+
+  if (!mSettings->mGraphics.pEnableOcclusionCulling.get()) {
+    return;
+  }
+
+  // An occluder is a visible body with known radii. Its smallest radius is reduced a bit, as the
+  // terrain may be below the ellipsoid. All values are observer-relative and in meters.
+  struct Occluder {
+    scene::CelestialObject const* mObject;
+    glm::dvec3                    mDirection;
+    double                        mDistance;
+    double                        mAngularRadius;
+  };
+
+  double const occluderRadiusFactor = 0.99;
+
+  std::vector<Occluder> occluders;
+
+  for (auto const& [name, object] : mSettings->mObjects) {
+    auto radii = object->getRadii() * object->getScale();
+    if (!object->getIsBodyVisible() || glm::compMin(radii) <= 0.0) {
+      continue;
+    }
+
+    glm::dvec3 position = object->getObserverRelativePosition() * mObserver.getScale();
+    double     distance = glm::length(position);
+    double     radius   = glm::compMin(radii) * occluderRadiusFactor;
+
+    // Nothing can be hidden if the observer is inside the occluder.
+    if (distance > radius) {
+      occluders.push_back(
+          {object.get(), position / distance, distance, std::asin(radius / distance)});
+    }
+  }
+
+  if (occluders.empty()) {
+    return;
+  }
+
+  // A sphere is hidden if it is behind the center of an occluder and if it is completely contained
+  // in the cone which encloses the occluder as seen from the observer.
+  auto isOccluded = [&occluders](scene::CelestialObject const* object, glm::dvec3 const& position,
+                        double radius) {
+    double distance = glm::length(position);
+    if (distance <= radius) {
+      return false;
+    }
+
+    glm::dvec3 direction     = position / distance;
+    double     angularRadius = std::asin(radius / distance);
+
+    for (auto const& occluder : occluders) {
+      if (occluder.mObject == object || distance - radius <= occluder.mDistance) {
+        continue;
+      }
+
+      double angle = std::acos(glm::clamp(glm::dot(direction, occluder.mDirection), -1.0, 1.0));
+      if (angle + angularRadius <= occluder.mAngularRadius) {
+        return true;
+      }
+    }
+
+    return false;
+  };
+
+  for (auto const& [name, object] : mSettings->mObjects) {
+    if (!object->getIsInExistence() || !object->getHasValidPosition()) {
+      continue;
+    }
+
+    glm::dvec3 position = object->getObserverRelativePosition() * mObserver.getScale();
+
+    // Objects without a culling radius are considered to be points.
+    double bodyRadius =
+        std::max(object->getBodyCullingRadius(), glm::compMax(object->getRadii())) *
+        object->getScale();
+    object->setIsBodyOccluded(isOccluded(object.get(), position, bodyRadius));
+
+    // Trajectories without a culling radius are never hidden, as their extent is unknown.
+    if (object->getOrbitCullingRadius() > 0.0) {
+      double orbitRadius = 2.0 * object->getOrbitCullingRadius() * object->getScale();
+      object->setIsOrbitOccluded(isOccluded(object.get(), position, orbitRadius));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SolarSystem::publishFrameSnapshot() {
+  CS_TRACE_ZONE("Publish Frame Snapshot");
+
+  // Reusing the previous snapshot avoids allocating the object map each frame. It may only be
+  // reused if no other thread holds a reference to it.
+  std::shared_ptr<FrameSnapshot> snapshot;
+  if (mSpareFrameSnapshot && mSpareFrameSnapshot.use_count() == 1) {
+    snapshot = std::move(mSpareFrameSnapshot);
+  } else {
+    snapshot = std::make_shared<FrameSnapshot>();
+  }
+
+  auto previous = std::atomic_load(&mFrameSnapshot);
+
+  snapshot->mFrame            = previous ? previous->mFrame + 1 : 0;
+  snapshot->mSimulationTime   = mTimeControl->pSimulationTime.get();
+  snapshot->mObserverCenter   = mObserver.getCenterName();
+  snapshot->mObserverFrame    = mObserver.getFrameName();
+  snapshot->mObserverPosition = mObserver.getPosition();
+  snapshot->mObserverRotation = mObserver.getRotation();
+  snapshot->mObserverScale    = mObserver.getScale();
+  snapshot->mSunPosition      = pSunPosition.get();
+  snapshot->mSunLuminousPower = pSunLuminousPower.get();
+
+  for (auto const& [name, object] : mSettings->mObjects) {
+    auto& entry                      = snapshot->mObjects[name];
+    entry.mObserverRelativeTransform = object->getObserverRelativeTransform();
+    entry.mRadii                     = object->getRadii();
+    entry.mIsInExistence             = object->getIsInExistence();
+    entry.mHasValidPosition          = object->getHasValidPosition();
+    entry.mIsBodyVisible             = object->getIsBodyVisible();
+  }
+
+  // Objects may have been removed since the reused snapshot was created.
+  if (snapshot->mObjects.size() != mSettings->mObjects.size()) {
+    for (auto it = snapshot->mObjects.begin(); it != snapshot->mObjects.end();) {
+      if (mSettings->mObjects.find(it->first) == mSettings->mObjects.end()) {
+        it = snapshot->mObjects.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::atomic_store(&mFrameSnapshot, std::shared_ptr<const FrameSnapshot>(snapshot));
+  mSpareFrameSnapshot = std::const_pointer_cast<FrameSnapshot>(previous);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const SolarSystem::FrameSnapshot> SolarSystem::getFrameSnapshot() const {
+  return std::atomic_load(&mFrameSnapshot);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SolarSystem::updateObjectTransforms() {
+  CS_TRACE_ZONE("Upload Object Transforms");
+
+  // Objects keep their index as long as no object is removed. New objects are appended.
+  auto assignTransforms = [this]() {
+    for (auto const& [name, object] : mSettings->mObjects) {
+      auto     nextIndex = static_cast<uint32_t>(mObjectTransformIndices.size());
+      uint32_t index     = mObjectTransformIndices.try_emplace(name, nextIndex).first->second;
+
+      if (index >= mObjectTransforms.size()) {
+        mObjectTransforms.resize(index + 1);
+      }
+
+      mObjectTransforms[index] = glm::mat4(object->getObserverRelativeTransform());
+    }
+  };
+
+  assignTransforms();
+
+  // If there are more indices than objects, some objects have been removed. In this case, all
+  // indices are assigned again.
+  if (mObjectTransformIndices.size() != mSettings->mObjects.size()) {
+    mObjectTransformIndices.clear();
+    mObjectTransforms.clear();
+    assignTransforms();
+  }
+
+  mObjectTransformBuffer->upload(mObjectTransforms);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SolarSystem::bindObjectTransforms(uint32_t binding) const {
+  mObjectTransformBuffer->bind(binding);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<uint32_t> SolarSystem::getObjectTransformIndex(std::string const& objectName) const {
+  auto it = mObjectTransformIndices.find(objectName);
+
+  if (it == mObjectTransformIndices.end()) {
+    return std::nullopt;
+  }
+
+  return it->second;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -546,6 +787,8 @@ void SolarSystem::flyObserverTo(
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::printFrames() {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
   SPICEINT_CELL(ids, 1000); // NOLINT: Creates a c-array.
   bltfrm_c(SPICE_FRMTYP_ALL, &ids);
 
@@ -581,6 +824,7 @@ void SolarSystem::printFrames() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::init(std::string const& sSpiceMetaFile) {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
 
   std::string actionReturn = "RETURN";
   // Continue execution on errors.
@@ -601,6 +845,9 @@ void SolarSystem::init(std::string const& sSpiceMetaFile) {
     throw std::runtime_error(msg.data());
   }
 
+  scene::EphemerisCache::clear();
+  scene::EphemerisCache::clearSeries();
+
   mIsInitialized = true;
 }
 
@@ -613,7 +860,11 @@ bool SolarSystem::getIsInitialized() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::deinit() {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
   kclear_c();
+  scene::EphemerisCache::clear();
+  scene::EphemerisCache::clearSeries();
   mIsInitialized = false;
 }
 
@@ -690,4 +941,49 @@ std::vector<glm::dvec4> SolarSystem::calculateTrajectory(std::string const& sCen
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void SolarSystem::updateEclipseShadowCones() {
+  mEclipseShadowCones.clear();
+
+  // The Sun and the casters are passed to the shaders in scene units.
+  double sceneScale = 1.0 / mObserver.getScale();
+  mEclipseSun = glm::vec4(pSunPosition.get(), mSun->getRadii()[0] * sceneScale);
+
+  for (auto const& shadowMap : mGraphicsEngine->getEclipseShadowMaps()) {
+    auto occluder = getObject(shadowMap->mOccluder);
+
+    if (!occluder) {
+      continue;
+    }
+
+    // Get observer-centric positions.
+    auto pSun = mSun->getObserverRelativePosition() * mObserver.getScale();
+    auto pOcc = occluder->getObserverRelativePosition() * mObserver.getScale();
+
+    double dSun = glm::length(pSun - pOcc);
+    double rOcc = occluder->getRadii()[0];
+    double rSun = mSun->getRadii()[0];
+
+    // Compute distances to the tips of the umbra and penumbra cones.
+    double dUmbra    = dSun * rOcc / (rSun - rOcc);
+    double dPenumbra = dSun * rOcc / (rSun + rOcc);
+
+    EclipseShadowCone cone;
+    cone.mCaster.mShadowMap   = shadowMap;
+    cone.mCaster.mSphere      = glm::vec4(occluder->getObserverRelativePosition(),
+        rOcc * occluder->getScale() * sceneScale);
+    cone.mOccluder            = occluder;
+    cone.mOccluderPosition    = pOcc;
+    cone.mSunToOccluder       = (pOcc - pSun) / dSun;
+    cone.mSunDistance         = dSun;
+    cone.mPenumbraTipDistance = dPenumbra;
+
+    // Compute slopes of the penumbra cone.
+    cone.mPenumbraSlope = rOcc / std::sqrt(dPenumbra * dUmbra - rOcc * rOcc);
+
+    mEclipseShadowCones.push_back(std::move(cone));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::core
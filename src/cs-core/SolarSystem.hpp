@@ -12,15 +12,22 @@
 
 #include "../cs-scene/CelestialObject.hpp"
 #include "../cs-scene/CelestialObserver.hpp"
+#include "../cs-scene/EphemerisInterpolator.hpp"
+#include "../cs-scene/EphemerisService.hpp"
 #include "../cs-utils/Property.hpp"
 
 #include <chrono>
 #include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace cs::graphics {
 struct EclipseShadowMap;
-}
+class ObjectTransformBuffer;
+} // namespace cs::graphics
 
 namespace cs::core {
 
@@ -33,6 +40,38 @@ class GraphicsEngine;
 /// the application.
 class CS_CORE_EXPORT SolarSystem {
  public:
+  /// An immutable copy of the simulation state at the end of one call to update(). Each frame, a
+  /// new snapshot is published. Code which holds a snapshot can read it from any thread without
+  /// synchronization, even while the main thread already simulates the next frame. This is meant
+  /// for work which runs concurrently to the main thread, for example PluginBase::updateAsync() or
+  /// render-side code which should not depend on the mutable CelestialObjects.
+  struct FrameSnapshot {
+    struct Object {
+      glm::dmat4 mObserverRelativeTransform{1.0};
+      glm::dvec3 mRadii{0.0};
+      bool       mIsInExistence    = false;
+      bool       mHasValidPosition = false;
+      bool       mIsBodyVisible    = false;
+    };
+
+    /// Increases by one with each snapshot.
+    uint64_t mFrame = 0;
+
+    double mSimulationTime = 0.0;
+
+    std::string mObserverCenter;
+    std::string mObserverFrame;
+    glm::dvec3  mObserverPosition{0.0};
+    glm::dquat  mObserverRotation{1.0, 0.0, 0.0, 0.0};
+    double      mObserverScale = 1.0;
+
+    glm::dvec3 mSunPosition{0.0};
+    float      mSunLuminousPower = 1.F;
+
+    /// The state of all celestial objects, keyed by the names used in the settings.
+    std::unordered_map<std::string, Object> mObjects;
+  };
+
   /// The object which the observer is attached to. The observer will follow this bodies motions.
   utils::Property<std::shared_ptr<const scene::CelestialObject>> pActiveObject;
 
@@ -119,11 +158,25 @@ class CS_CORE_EXPORT SolarSystem {
 
   // Eclipse Shadow API ----------------------------------------------------------------------------
 
-  /// Returns all eclipse shadow casters which may cast a shadow on the given object. If
-  /// allowSelfShadowing is set to true, this will also return the eclipse shadow map of the given
-  /// body (if there is one).
-  std::vector<std::shared_ptr<graphics::EclipseShadowMap>> getEclipseShadowMaps(
-      scene::CelestialObject const& receiver, bool allowSelfShadowing) const;
+  /// An eclipse shadow caster as it is passed to the eclipse shaders.
+  struct EclipseShadowCaster {
+    std::shared_ptr<graphics::EclipseShadowMap> mShadowMap;
+
+    /// The observer-relative position and the radius of the caster in scene units.
+    glm::vec4 mSphere;
+  };
+
+  /// Stores all eclipse shadow casters which may cast a shadow on the given object in the given
+  /// vector. If allowSelfShadowing is set to true, this will also return the eclipse shadow caster
+  /// of the given body (if there is one). The shadow cones and spheres of all casters are computed
+  /// once each frame in update() and are shared by all receivers, so this only tests the bounding
+  /// sphere of the receiver against these cones.
+  void getEclipseShadowCasters(scene::CelestialObject const& receiver, bool allowSelfShadowing,
+      std::vector<EclipseShadowCaster>& casters) const;
+
+  /// The observer-relative position and the radius of the Sun in scene units as it is passed to
+  /// the eclipse shaders. This is computed once each frame in update().
+  glm::vec4 const& getEclipseSun() const;
 
   // Observer API ----------------------------------------------------------------------------------
 
@@ -132,6 +185,26 @@ class CS_CORE_EXPORT SolarSystem {
   scene::CelestialObserver&       getObserver();
   scene::CelestialObserver const& getObserver() const;
 
+  /// Returns the snapshot which has been published by the last call to update(). This may be called
+  /// from any thread. It returns nullptr before the first update().
+  std::shared_ptr<const FrameSnapshot> getFrameSnapshot() const;
+
+  /// Binds a shader storage buffer which contains the observer-relative transformations of all
+  /// celestial objects to the given binding point. They are uploaded with single precision once
+  /// each frame in update(), so drawables do not have to upload them as uniforms. See
+  /// graphics::ObjectTransformBuffer for the corresponding GLSL declaration.
+  void bindObjectTransforms(uint32_t binding) const;
+
+  /// Returns the index of the given object's transformation in the buffer bound by
+  /// bindObjectTransforms(). Indices change when objects are removed, so this should be called
+  /// each frame. Returns std::nullopt if there is no such object.
+  std::optional<uint32_t> getObjectTransformIndex(std::string const& objectName) const;
+
+  // Ephemeris API ---------------------------------------------------------------------------------
+
+  /// Use this to evaluate many SPICE queries asynchronously on a worker thread.
+  scene::EphemerisService& getEphemerisService();
+
   /// It may happen that our observer is in a SPICE frame we do not have data for. If this is the
   /// case, this call will bring it back to Solar System Barycenter / J2000 which should be
   /// always available. To compute the position and orientation relative to this origin we need a
@@ -214,9 +287,50 @@ class CS_CORE_EXPORT SolarSystem {
   std::shared_ptr<TimeControl>                  mTimeControl;
   scene::CelestialObserver                      mObserver;
   std::shared_ptr<const scene::CelestialObject> mSun;
-
-  bool mIsInitialized              = false;
-  bool mSpiceFrameChangedLastFrame = false;
+  scene::EphemerisService                       mEphemerisService;
+  scene::EphemerisInterpolator                  mEphemerisInterpolator{mEphemerisService};
+
+  /// The penumbra cone of an eclipse shadow caster. All vectors are observer-relative and in
+  /// meters, except for the sphere of the caster which is in scene units.
+  struct EclipseShadowCone {
+    EclipseShadowCaster                           mCaster;
+    std::shared_ptr<const scene::CelestialObject> mOccluder;
+    glm::dvec3                                    mOccluderPosition;
+    glm::dvec3                                    mSunToOccluder;
+    double                                        mSunDistance;
+    double                                        mPenumbraTipDistance;
+    double                                        mPenumbraSlope;
+  };
+
+  void updateEclipseShadowCones();
+
+  /// Marks all objects whose body or trajectory is completely hidden behind another body as
+  /// occluded, see CelestialObject::setIsBodyOccluded(). All bodies are considered to be spheres.
+  void updateOcclusion();
+
+  /// Creates and publishes the snapshot of the current frame.
+  void publishFrameSnapshot();
+
+  /// Uploads the observer-relative transformations of all objects to mObjectTransformBuffer.
+  void updateObjectTransforms();
+
+  // Accessed with std::atomic_load() and std::atomic_store(), as it is read by other threads.
+  std::shared_ptr<const FrameSnapshot> mFrameSnapshot;
+
+  // The snapshot before the current one. If no other thread holds it anymore, its memory is reused
+  // for the next snapshot.
+  std::shared_ptr<FrameSnapshot> mSpareFrameSnapshot;
+
+  std::unique_ptr<graphics::ObjectTransformBuffer> mObjectTransformBuffer;
+  std::unordered_map<std::string, uint32_t>        mObjectTransformIndices;
+  std::vector<glm::mat4>                           mObjectTransforms;
+
+  std::vector<EclipseShadowCone> mEclipseShadowCones;
+  glm::vec4                      mEclipseSun{0.F};
+
+  bool   mIsInitialized              = false;
+  bool   mSpiceFrameChangedLastFrame = false;
+  double mLastSimulationTime         = 0.0;
 
   // These are used for measuring the observer speed.
   glm::dvec3                                     mLastPosition = glm::dvec3(0.0);
@@ -83,7 +83,9 @@ void TimeControl::update() {
       }
     }
 
-    mLastUpdate = now;
+    mLastUpdate         = now;
+    mLastSimulationTime = pSimulationTime.get();
+    mJumpPending        = false;
 
     mInitialized = true;
   }
@@ -105,7 +107,19 @@ void TimeControl::update() {
   }
 
   mLastUpdate = now;
-} // namespace cs::core
+
+  if (mJumpPending) {
+    mLastTimeChange = TimeChange::eJump;
+    mOnTimeJump.emit(mLastSimulationTime, pSimulationTime.get());
+  } else if (pSimulationTime.get() != mLastSimulationTime) {
+    mLastTimeChange = TimeChange::eContinuous;
+  } else {
+    mLastTimeChange = TimeChange::eNone;
+  }
+
+  mLastSimulationTime = pSimulationTime.get();
+  mJumpPending        = false;
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -116,9 +130,11 @@ void TimeControl::setTime(double tTime, double duration, double threshold) {
   if (tTime >= pMaxDate || tTime <= pMinDate) {
     pSimulationTime       = std::clamp(tTime, pMinDate, pMaxDate);
     mSettings->pTimeSpeed = 0.f;
+    mJumpPending          = true;
   } else if (duration <= 0.0 || difference > std::abs(threshold) || threshold <= 0) {
     // Make no animation for very large time changes.
     pSimulationTime = tTime;
+    mJumpPending    = true;
   } else {
     double const reduction = 0.2;
     double const inverse   = 1.0 - reduction;
@@ -152,4 +168,16 @@ void TimeControl::resetTime(double duration, double threshold) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+TimeControl::TimeChange TimeControl::getLastTimeChange() const {
+  return mLastTimeChange;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+utils::Signal<double, double> const& TimeControl::onTimeJump() const {
+  return mOnTimeJump;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::core
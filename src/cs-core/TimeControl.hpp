@@ -12,6 +12,7 @@
 
 #include "../cs-utils/AnimatedValue.hpp"
 #include "../cs-utils/Property.hpp"
+#include "../cs-utils/Signal.hpp"
 
 #include <memory>
 
@@ -21,11 +22,26 @@ class Settings;
 /// The keeper of time. You can control the simulation time with this class. You can
 /// accelerate/decelerate the flow of time or jump to specific points in time.
 /// All time units are in Barycentric Dynamical Time (TDB).
+///
+/// Systems which do expensive work when the time changes can distinguish between a continuous
+/// advance of the time and a jump with getLastTimeChange() and onTimeJump(). After a jump, they
+/// should spread their recalculation over several frames. While pIsScrubbing is set, they should
+/// only do a cheap preview and refine it once the user stops scrubbing.
 class CS_CORE_EXPORT TimeControl {
  public:
+  /// Describes how the simulation time changed during the last call to update().
+  enum class TimeChange {
+    eNone,       ///< The simulation time did not change.
+    eContinuous, ///< The time advanced according to the time speed or during a transition.
+    eJump        ///< The time was set to a new value without a transition.
+  };
+
   /// The current time in TDB. Consider this to be read-only.
   utils::Property<double> pSimulationTime = 0.0;
 
+  /// This is true while the user drags the timeline. It is set by the user interface.
+  utils::Property<bool> pIsScrubbing = false;
+
   explicit TimeControl(std::shared_ptr<Settings> settings);
 
   TimeControl(TimeControl const& other) = delete;
@@ -65,6 +81,14 @@ class CS_CORE_EXPORT TimeControl {
   ///                  time exceeds this threshold, no transition will be made.
   void resetTime(double duration = 0.0, double threshold = 48.0 * 60.0 * 60.0);
 
+  /// Returns how the simulation time changed during the last call to update(). If the time was
+  /// set without a transition at any point since the previous update(), this returns eJump.
+  TimeChange getLastTimeChange() const;
+
+  /// This is emitted in update() if the simulation time jumped since the previous update(). The
+  /// parameters are the previous and the new simulation time.
+  utils::Signal<double, double> const& onTimeJump() const;
+
  private:
   bool   mInitialized = false;
   double mLastUpdate  = 0.0;
@@ -74,6 +98,14 @@ class CS_CORE_EXPORT TimeControl {
   utils::AnimatedValue<double> mAnimatedTime;
   bool                         mAnimationInProgress = false;
 
+  /// The simulation time at the end of the previous update() and whether it has been set without
+  /// a transition since then.
+  double     mLastSimulationTime = 0.0;
+  bool       mJumpPending        = false;
+  TimeChange mLastTimeChange     = TimeChange::eNone;
+
+  utils::Signal<double, double> mOnTimeJump;
+
   std::shared_ptr<Settings> mSettings;
 };
 
@@ -10,17 +10,19 @@
 
 #include "cs_graphics_export.hpp"
 
-#include <VistaOGLExt/VistaTexture.h>
 #include <boost/filesystem.hpp>
 #include <glm/glm.hpp>
 
-#include <memory>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace cs::graphics {
 
-/// A color map specified by a json file.
+/// A color map specified by a json file. This is a lightweight handle to a layer of the texture
+/// array of the ColorMapRegistry, so creating several ColorMaps from the same file or with the same
+/// content does not use any additional GPU memory. Shaders have to sample the color map with a
+/// sampler1DArray and the layer returned by getLayer().
 class CS_GRAPHICS_EXPORT ColorMap {
  public:
   /// Creates a ColorMap from a json string.
@@ -28,12 +30,15 @@ class CS_GRAPHICS_EXPORT ColorMap {
   /// Creates a ColorMap from the json file at sJsonPath.
   explicit ColorMap(boost::filesystem::path const& sJsonPath);
 
-  /// Binds the color map for use in rendering.
+  /// Binds the texture array containing all color maps for use in rendering.
   void bind(unsigned unit);
 
-  /// Unbinds the color map after rendering.
+  /// Unbinds the texture array after rendering.
   void unbind(unsigned unit);
 
+  /// Returns the layer of this color map in the texture array.
+  uint32_t getLayer() const;
+
   /// Returns the color map as a vector of RGBA values.
   std::vector<glm::vec4> getRawData();
 
@@ -41,10 +46,7 @@ class CS_GRAPHICS_EXPORT ColorMap {
   bool getUsesAlpha() const;
 
  private:
-  int                           mResolution = 256;
-  std::unique_ptr<VistaTexture> mTexture;
-  std::vector<glm::vec4>        mRawData;
-  bool                          mUsesAlpha = false;
+  uint32_t mLayer = 0;
 };
 
 } // namespace cs::graphics
@@ -0,0 +1,303 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "ColorMapRegistry.hpp"
+
+#include "../cs-utils/Sha256.hpp"
+#include "../cs-utils/doctest.hpp"
+#include "GpuMemory.hpp"
+
+#include <GL/glew.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ColorMapData {
+  std::map<float, glm::vec3> rgbStops;
+  std::map<float, float>     alphaStops;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void from_json(nlohmann::json const& j, ColorMapData& s) {
+  auto rgb = j.at("RGB");
+  for (nlohmann::json::iterator it = rgb.begin(); it != rgb.end(); ++it) {
+    glm::vec3 value;
+    for (int i = 0; i < 3; ++i) {
+      value[i] = it.value().at(i);
+    }
+
+    s.rgbStops[std::stof(it.key())] = value;
+  }
+
+  auto alpha = j.at("Alpha");
+  for (nlohmann::json::iterator it = alpha.begin(); it != alpha.end(); ++it) {
+    s.alphaStops[std::stof(it.key())] = it.value();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+T interpolate(float key, const std::map<float, T>& map) {
+  if (map.find(key) != map.end()) {
+    return map.at(key);
+  }
+
+  if (key < map.begin()->first) {
+    return map.begin()->second;
+  }
+
+  if (key > map.rbegin()->first) {
+    return map.rbegin()->second;
+  }
+
+  auto lower = map.lower_bound(key) == map.begin() ? map.begin() : --(map.lower_bound(key));
+  auto upper = map.upper_bound(key);
+
+  return lower->second + (upper->second - lower->second) * float(key - lower->first) /
+                             std::fabs(upper->first - lower->first);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::vec4> mergeColorMapData(ColorMapData const& colorMapData, uint32_t resolution) {
+  std::vector<glm::vec4> colors(resolution);
+  for (size_t i(0); i < colors.size(); ++i) {
+    float     key   = static_cast<float>(i) / static_cast<float>(colors.size() - 1);
+    glm::vec3 color = interpolate(key, colorMapData.rgbStops);
+    float     alpha = interpolate(key, colorMapData.alphaStops);
+    colors[i]       = glm::vec4(color, alpha);
+  }
+
+  return colors;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::vec4> parseColorMap(nlohmann::json const& json) {
+  try {
+    ColorMapData colorMapData = json;
+    return mergeColorMapData(colorMapData, ColorMapRegistry::RESOLUTION);
+  } catch (std::exception const& e) {
+    throw std::runtime_error("Failed to parse color map: " + std::string(e.what()));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ColorMapRegistry& ColorMapRegistry::get() {
+  static ColorMapRegistry instance;
+  return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ColorMapRegistry::addFromString(std::string const& sJsonString) {
+  nlohmann::json json;
+
+  try {
+    json = nlohmann::json::parse(sJsonString);
+  } catch (std::exception const& e) {
+    throw std::runtime_error("Failed to parse color map: " + std::string(e.what()));
+  }
+
+  return add(parseColorMap(json));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ColorMapRegistry::addFromFile(boost::filesystem::path const& sJsonPath) {
+  boost::system::error_code error;
+  auto canonicalPath = boost::filesystem::weakly_canonical(sJsonPath, error).string();
+
+  if (error) {
+    canonicalPath = sJsonPath.string();
+  }
+
+  auto file = mFiles.find(canonicalPath);
+  if (file != mFiles.end()) {
+    return file->second;
+  }
+
+  std::ifstream stream(sJsonPath.string());
+  if (!stream) {
+    throw std::runtime_error("Failed to open color map '" + sJsonPath.string() + "'!");
+  }
+
+  nlohmann::json json;
+
+  try {
+    stream >> json;
+  } catch (std::exception const& e) {
+    throw std::runtime_error(
+        "Failed to parse color map '" + sJsonPath.string() + "': " + std::string(e.what()));
+  }
+
+  uint32_t layer        = add(parseColorMap(json));
+  mFiles[canonicalPath] = layer;
+
+  return layer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ColorMapRegistry::getLayerCount() const {
+  return static_cast<uint32_t>(mEntries.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::vec4> const& ColorMapRegistry::getRawData(uint32_t layer) const {
+  return mEntries.at(layer).mRawData;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ColorMapRegistry::getUsesAlpha(uint32_t layer) const {
+  return mEntries.at(layer).mUsesAlpha;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ColorMapRegistry::bind(unsigned unit) {
+  if (mTextureLayers != mEntries.size()) {
+    uploadTexture();
+  }
+
+  glActiveTexture(unit);
+  glBindTexture(GL_TEXTURE_1D_ARRAY, mTexture);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ColorMapRegistry::unbind(unsigned unit) {
+  glActiveTexture(unit);
+  glBindTexture(GL_TEXTURE_1D_ARRAY, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ColorMapRegistry::add(std::vector<glm::vec4> colors) {
+
+  // Color maps are identified by the hash of their sampled colors. This way, files with different
+  // formatting or key order but the same stops share a layer.
+  utils::Sha256 sha;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  sha.update(reinterpret_cast<char const*>(colors.data()), colors.size() * sizeof(glm::vec4));
+  auto hash = sha.getHexDigest();
+
+  auto existing = mHashes.find(hash);
+  if (existing != mHashes.end()) {
+    return existing->second;
+  }
+
+  Entry entry;
+  entry.mUsesAlpha =
+      std::any_of(colors.begin(), colors.end(), [](glm::vec4 const& c) { return c.a < 1.F; });
+  entry.mRawData = std::move(colors);
+
+  auto layer = static_cast<uint32_t>(mEntries.size());
+  mEntries.push_back(std::move(entry));
+  mHashes[hash] = layer;
+
+  return layer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ColorMapRegistry::uploadTexture() {
+  if (mEntries.empty()) {
+    return;
+  }
+
+  std::vector<glm::vec4> data;
+  data.reserve(RESOLUTION * mEntries.size());
+
+  for (auto const& entry : mEntries) {
+    data.insert(data.end(), entry.mRawData.begin(), entry.mRawData.end());
+  }
+
+  if (mTexture == 0) {
+    glGenTextures(1, &mTexture);
+  }
+
+  mTextureLayers = static_cast<uint32_t>(mEntries.size());
+
+  glBindTexture(GL_TEXTURE_1D_ARRAY, mTexture);
+  glTexImage2D(GL_TEXTURE_1D_ARRAY, 0, GL_RGBA8, static_cast<GLsizei>(RESOLUTION),
+      static_cast<GLsizei>(mTextureLayers), 0, GL_RGBA, GL_FLOAT, data.data());
+  glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glBindTexture(GL_TEXTURE_1D_ARRAY, 0);
+
+  GpuMemory::get().release("Color Maps", mTextureBytes);
+  mTextureBytes = std::size_t(RESOLUTION) * mTextureLayers * 4;
+  GpuMemory::get().allocate("Color Maps", mTextureBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::ColorMapRegistry::interpolate") {
+  std::map<float, glm::vec3> stops = {{0.F, glm::vec3(1.F, 1.F, 0.F)},
+      {0.5F, glm::vec3(1.F, 0.F, 0.F)}, {1.0F, glm::vec3(1.F, 0.F, 1.F)}};
+
+  CHECK(interpolate(0.F, stops) == glm::vec3(1.F, 1.F, 0.F));
+  CHECK(interpolate(0.25F, stops) == glm::vec3(1.F, 0.5F, 0.F));
+  CHECK(interpolate(2.F, stops) == glm::vec3(1.F, 0.F, 1.F));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::ColorMapRegistry::addFromString") {
+  auto& registry = ColorMapRegistry::get();
+
+  std::string const opaque = R"({"RGB": {"0.0": [0, 0, 0], "1.0": [1, 1, 1]},
+                                 "Alpha": {"0.0": 1, "1.0": 1}})";
+
+  // The same stops in a different order and formatting.
+  std::string const reordered = R"({"Alpha": {"1.0": 1, "0.0": 1},
+                                    "RGB": {"1.0": [1, 1, 1], "0.0": [0, 0, 0]}})";
+
+  std::string const transparent = R"({"RGB": {"0.0": [0, 0, 0], "1.0": [1, 1, 1]},
+                                      "Alpha": {"0.0": 0, "1.0": 1}})";
+
+  uint32_t first  = registry.addFromString(opaque);
+  uint32_t second = registry.addFromString(reordered);
+  uint32_t third  = registry.addFromString(transparent);
+
+  CHECK_EQ(first, second);
+  CHECK_NE(first, third);
+  CHECK_FALSE(registry.getUsesAlpha(first));
+  CHECK(registry.getUsesAlpha(third));
+  CHECK_EQ(registry.getRawData(first).size(), ColorMapRegistry::RESOLUTION);
+  CHECK_EQ(registry.getRawData(first).back(), glm::vec4(1.F));
+
+  CHECK_THROWS_AS(registry.addFromString("{}"), std::runtime_error);
+  CHECK_THROWS_AS(registry.addFromFile("this-file-does-not-exist.json"), std::runtime_error);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
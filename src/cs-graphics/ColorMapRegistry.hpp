@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_COLOR_MAP_REGISTRY_HPP
+#define CS_GRAPHICS_COLOR_MAP_REGISTRY_HPP
+
+#include "cs_graphics_export.hpp"
+
+#include <boost/filesystem.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cs::graphics {
+
+/// This is a singleton class which stores all color maps used by CosmoScout VR and its plugins in
+/// the layers of one GL_TEXTURE_1D_ARRAY. Color maps are deduplicated: adding the same file twice
+/// or two files with the same content results in the same layer. Shaders sample the array with a
+/// sampler1DArray, passing the layer returned by add() as second texture coordinate.
+///
+/// The texture array is (re-)created lazily in bind() whenever color maps have been added since
+/// the last call. Hence color maps can be added at any time, but this should happen during
+/// initialization as a rebuild uploads all layers. All methods have to be called from the main
+/// thread.
+class CS_GRAPHICS_EXPORT ColorMapRegistry {
+ public:
+  /// The number of samples of each color map.
+  static const uint32_t RESOLUTION = 256;
+
+  static ColorMapRegistry& get();
+
+  ColorMapRegistry(ColorMapRegistry const& other) = delete;
+  ColorMapRegistry(ColorMapRegistry&& other)      = delete;
+
+  ColorMapRegistry& operator=(ColorMapRegistry const& other) = delete;
+  ColorMapRegistry& operator=(ColorMapRegistry&& other)      = delete;
+
+  /// The texture array is not deleted as the OpenGL context does not exist anymore when static
+  /// objects are destroyed.
+  ~ColorMapRegistry() = default;
+
+  /// Adds the color map given as json string or json file and returns its layer in the texture
+  /// array. If the same file or a color map with the same content has been added before, the
+  /// existing layer is returned. Throws a std::runtime_error if the color map cannot be parsed.
+  uint32_t addFromString(std::string const& sJsonString);
+  uint32_t addFromFile(boost::filesystem::path const& sJsonPath);
+
+  /// Returns the number of distinct color maps.
+  uint32_t getLayerCount() const;
+
+  /// Returns the color map stored in the given layer as a vector of RGBA values.
+  std::vector<glm::vec4> const& getRawData(uint32_t layer) const;
+
+  /// Returns true if the alpha channel of the given color map is not everywhere set to one.
+  bool getUsesAlpha(uint32_t layer) const;
+
+  /// Binds the texture array to the given texture unit (e.g. GL_TEXTURE0 + 3). If color maps have
+  /// been added since the last call, the texture array is recreated first.
+  void bind(unsigned unit);
+  void unbind(unsigned unit);
+
+ private:
+  ColorMapRegistry() = default;
+
+  uint32_t add(std::vector<glm::vec4> colors);
+  void     uploadTexture();
+
+  struct Entry {
+    std::vector<glm::vec4> mRawData;
+    bool                   mUsesAlpha = false;
+  };
+
+  std::vector<Entry> mEntries;
+
+  // These map canonical file paths and SHA-256 hashes of the sampled colors to layers.
+  std::unordered_map<std::string, uint32_t> mFiles;
+  std::unordered_map<std::string, uint32_t> mHashes;
+
+  uint32_t    mTexture       = 0;
+  uint32_t    mTextureLayers = 0;
+  std::size_t mTextureBytes  = 0;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_COLOR_MAP_REGISTRY_HPP
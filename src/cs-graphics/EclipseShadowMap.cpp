@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "EclipseShadowMap.hpp"
+
+#include "GpuMemory.hpp"
+#include "TextureLoader.hpp"
+#include "logger.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <array>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EclipseShadowAtlas::~EclipseShadowAtlas() {
+  glDeleteTextures(1, &mTexture);
+  GpuMemory::get().release("Eclipse Shadow Maps", mBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int32_t EclipseShadowAtlas::addTexture(std::string const& fileName) {
+  auto it = std::find(mFileNames.begin(), mFileNames.end(), fileName);
+
+  if (it == mFileNames.end()) {
+    it = mFileNames.insert(mFileNames.end(), fileName);
+  }
+
+  return static_cast<int32_t>(it - mFileNames.begin());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t EclipseShadowAtlas::getTexture() {
+  if (mLoaded) {
+    return mTexture;
+  }
+
+  mLoaded = true;
+
+  if (mFileNames.empty()) {
+    return mTexture;
+  }
+
+  logger().debug("Loading {} eclipse shadow maps.", mFileNames.size());
+
+  // Load all textures and determine the largest resolution.
+  std::vector<std::unique_ptr<VistaTexture>> textures;
+  std::vector<std::array<GLsizei, 2>>        sizes;
+  GLsizei                                    width  = 1;
+  GLsizei                                    height = 1;
+
+  for (auto const& fileName : mFileNames) {
+    auto& texture = textures.emplace_back(TextureLoader::loadFromFile(fileName));
+    auto& size    = sizes.emplace_back();
+
+    if (texture) {
+      texture->Bind();
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &size[0]);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &size[1]);
+      texture->Unbind();
+
+      width  = std::max(width, size[0]);
+      height = std::max(height, size[1]);
+    }
+  }
+
+  glGenTextures(1, &mTexture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32F, width, height,
+      static_cast<GLsizei>(mFileNames.size()));
+
+  mBytes = static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * mFileNames.size() *
+           4 * sizeof(float);
+  GpuMemory::get().allocate("Eclipse Shadow Maps", mBytes);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  // The textures are copied into their layers with a filtered blit, which also converts between
+  // the different formats and resolutions.
+  GLint previousReadFramebuffer = 0;
+  GLint previousDrawFramebuffer = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDrawFramebuffer);
+
+  std::array<GLuint, 2> framebuffers{};
+  glGenFramebuffers(2, framebuffers.data());
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+
+  glPushAttrib(GL_SCISSOR_BIT);
+  glDisable(GL_SCISSOR_TEST);
+
+  for (size_t i = 0; i < textures.size(); ++i) {
+    if (!textures[i]) {
+      logger().warn("Failed to load eclipse shadow map '{}'!", mFileNames[i]);
+      continue;
+    }
+
+    glFramebufferTexture2D(
+        GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i]->GetId(), 0);
+    glFramebufferTextureLayer(
+        GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mTexture, 0, static_cast<GLint>(i));
+    glBlitFramebuffer(0, 0, sizes[i][0], sizes[i][1], 0, 0, width, height, GL_COLOR_BUFFER_BIT,
+        GL_LINEAR);
+  }
+
+  glPopAttrib();
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFramebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDrawFramebuffer);
+  glDeleteFramebuffers(2, framebuffers.data());
+
+  return mTexture;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
@@ -8,18 +8,53 @@
 #ifndef CS_GRAPHICS_ECLIPSE_SHADOW_MAP_HPP
 #define CS_GRAPHICS_ECLIPSE_SHADOW_MAP_HPP
 
-#include <VistaOGLExt/VistaTexture.h>
+#include "cs_graphics_export.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace cs::graphics {
 
+/// All eclipse shadow maps are stored in the layers of one texture array, so that a receiver only
+/// has to bind a single texture. The textures are not loaded before getTexture() is called for the
+/// first time, which usually happens once an eclipse is geometrically possible. Textures with
+/// a differing resolution are scaled to the resolution of the largest one.
+class CS_GRAPHICS_EXPORT EclipseShadowAtlas {
+ public:
+  EclipseShadowAtlas() = default;
+
+  EclipseShadowAtlas(EclipseShadowAtlas const& other) = delete;
+  EclipseShadowAtlas(EclipseShadowAtlas&& other)      = delete;
+
+  EclipseShadowAtlas& operator=(EclipseShadowAtlas const& other) = delete;
+  EclipseShadowAtlas& operator=(EclipseShadowAtlas&& other)      = delete;
+
+  ~EclipseShadowAtlas();
+
+  /// Adds the given file to the atlas and returns its layer. Files which have been added before
+  /// share their layer. This has to be called before getTexture().
+  int32_t addTexture(std::string const& fileName);
+
+  /// Returns the GL_TEXTURE_2D_ARRAY containing all added textures. It is loaded on the first call.
+  uint32_t getTexture();
+
+ private:
+  std::vector<std::string> mFileNames;
+  uint32_t                 mTexture = 0;
+  std::size_t              mBytes   = 0;
+  bool                     mLoaded  = false;
+};
+
 /// This struct stores information required for each eclipse shadow map. This is an anchor name (as
-/// used by the core::SolarSystem::getObject() method) as well as the actual shadow texture.
+/// used by the core::SolarSystem::getObject() method) as well as the layer of the actual shadow
+/// texture in the shared atlas.
 struct EclipseShadowMap {
-  std::string                   mOccluder;
-  std::shared_ptr<VistaTexture> mTexture;
+  std::string                         mOccluder;
+  std::shared_ptr<EclipseShadowAtlas> mAtlas;
+  int32_t                             mLayer = 0;
 };
 
 } // namespace cs::graphics
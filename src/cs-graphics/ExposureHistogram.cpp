@@ -0,0 +1,394 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "ExposureHistogram.hpp"
+
+#include "../cs-utils/FrameStats.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Each work group of the histogram pass processes a tile of this many pixels in both directions.
+// Each invocation reads 2x2 pixels.
+int const TILE_SIZE = 32;
+
+// The histogram covers the luminance values which result in an exposure inside the exposure range
+// plus this many EV on both sides.
+float const HISTOGRAM_MARGIN = 4.F;
+
+// Both passes use one invocation per bin.
+static_assert(ExposureHistogram::sBinCount == 256, "The shaders assume 256 invocations per group.");
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Compiles and links the given compute shader. Throws a std::runtime_error on failure.
+GLuint createComputeProgram(std::string const& source) {
+  auto        shader  = glCreateShader(GL_COMPUTE_SHADER);
+  const char* pSource = source.c_str();
+  glShaderSource(shader, 1, &pSource, nullptr);
+  glCompileShader(shader);
+
+  int rvalue = 0;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto log_length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+    std::vector<char> v(log_length);
+    glGetShaderInfoLog(shader, log_length, nullptr, v.data());
+    std::string log(begin(v), end(v));
+    glDeleteShader(shader);
+    throw std::runtime_error(std::string("ERROR: Failed to compile shader\n") + log);
+  }
+
+  auto program = glCreateProgram();
+  glAttachShader(program, shader);
+  glLinkProgram(program);
+  glDeleteShader(shader);
+
+  glGetProgramiv(program, GL_LINK_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto log_length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
+    std::vector<char> v(log_length);
+    glGetProgramInfoLog(program, log_length, nullptr, v.data());
+    std::string log(begin(v), end(v));
+    glDeleteProgram(program);
+    throw std::runtime_error(std::string("ERROR: Failed to link compute shader\n") + log);
+  }
+
+  return program;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const char* sComputeHistogram = R"(
+  layout (local_size_x = 16, local_size_y = 16) in;
+
+  #if NUM_MULTISAMPLES > 0
+    layout (HDR_BUFFER_FORMAT, binding = 0) readonly uniform image2DMS uInHDRBuffer;
+  #else
+    layout (HDR_BUFFER_FORMAT, binding = 0) readonly uniform image2D uInHDRBuffer;
+  #endif
+
+  // As luminance values are positive, the bit patterns of the maximum luminance can be compared as
+  // unsigned integers.
+  layout (std430, binding = 0) coherent buffer Histogram {
+    uint uMaximumBits;
+    uint uBins[NUM_BINS];
+  };
+
+  // The minimum logarithmic luminance and the size of the logarithmic luminance range.
+  uniform vec2 uLogRange;
+
+  shared uint sBins[NUM_BINS];
+  shared uint sMaximumBits;
+
+  void addPixel(ivec2 pos) {
+    if (any(greaterThanEqual(pos, imageSize(uInHDRBuffer)))) {
+      return;
+    }
+
+    #if NUM_MULTISAMPLES > 0
+      vec3 color = vec3(0.0);
+      for (int i = 0; i < NUM_MULTISAMPLES; ++i) {
+        color += imageLoad(uInHDRBuffer, pos, i).rgb;
+      }
+      color /= NUM_MULTISAMPLES;
+    #else
+      vec3 color = imageLoad(uInHDRBuffer, pos).rgb;
+    #endif
+
+    float luminance = max(max(color.r, color.g), color.b);
+
+    // The first bin contains all black pixels, the others are distributed logarithmically.
+    uint bin = 0;
+    if (luminance > 0.0) {
+      float t = clamp((log2(luminance) - uLogRange.x) / uLogRange.y, 0.0, 1.0);
+      bin     = 1 + min(uint(t * (NUM_BINS - 1)), NUM_BINS - 2);
+      atomicMax(sMaximumBits, floatBitsToUint(luminance));
+    }
+
+    atomicAdd(sBins[bin], 1);
+  }
+
+  void main() {
+    uint index = gl_LocalInvocationIndex;
+
+    sBins[index] = 0;
+    if (index == 0) {
+      sMaximumBits = 0;
+    }
+
+    memoryBarrierShared();
+    barrier();
+
+    ivec2 pos = ivec2(gl_GlobalInvocationID.xy) * 2;
+    addPixel(pos);
+    addPixel(pos + ivec2(0, 1));
+    addPixel(pos + ivec2(1, 0));
+    addPixel(pos + ivec2(1, 1));
+
+    memoryBarrierShared();
+    barrier();
+
+    if (sBins[index] > 0) {
+      atomicAdd(uBins[index], sBins[index]);
+    }
+
+    if (index == 0) {
+      atomicMax(uMaximumBits, sMaximumBits);
+    }
+  }
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const char* sComputeAdaption = R"(
+  layout (local_size_x = NUM_BINS) in;
+
+  layout (std430, binding = 0) coherent buffer Histogram {
+    uint uMaximumBits;
+    uint uBins[NUM_BINS];
+  };
+
+  layout (std430, binding = 1) coherent buffer Exposure {
+    float uExposure;
+    float uAverageLuminance;
+    float uMaximumLuminance;
+  };
+
+  uniform vec2  uLogRange;
+  uniform vec2  uPercentiles;
+  uniform vec2  uExposureRange;
+  uniform float uAdaption;
+  uniform bool  uReset;
+  uniform float uResetExposure;
+
+  shared uint sCounts[NUM_BINS];
+  shared vec2 sWeighted[NUM_BINS];
+
+  void main() {
+    uint index = gl_LocalInvocationIndex;
+
+    // Black pixels are not taken into account. The histogram is reset for the next frame.
+    uint count     = index == 0 ? 0 : uBins[index];
+    uBins[index]   = 0;
+    sCounts[index] = count;
+
+    // Compute the inclusive prefix sum of the counts.
+    for (uint offset = 1; offset < NUM_BINS; offset <<= 1) {
+      memoryBarrierShared();
+      barrier();
+
+      uint other = index >= offset ? sCounts[index - offset] : 0;
+
+      memoryBarrierShared();
+      barrier();
+
+      sCounts[index] += other;
+    }
+
+    memoryBarrierShared();
+    barrier();
+
+    // Each bin contributes with the pixels which lie between the two percentiles.
+    float total  = float(sCounts[NUM_BINS - 1]);
+    float end    = float(sCounts[index]);
+    float start  = end - float(count);
+    float weight = max(0.0, min(end, uPercentiles.y * total) - max(start, uPercentiles.x * total));
+
+    float logLuminance = uLogRange.x + (float(index) - 0.5) / float(NUM_BINS - 1) * uLogRange.y;
+    sWeighted[index]   = vec2(weight * logLuminance, weight);
+
+    for (uint stride = NUM_BINS / 2; stride > 0; stride >>= 1) {
+      memoryBarrierShared();
+      barrier();
+
+      if (index < stride) {
+        sWeighted[index] += sWeighted[index + stride];
+      }
+    }
+
+    memoryBarrierShared();
+    barrier();
+
+    if (index == 0) {
+      if (uReset) {
+        uExposure = uResetExposure;
+      }
+
+      // Time-dependent visual adaptation for fast realistic image display
+      // (https://dl.acm.org/citation.cfm?id=344810). If there are only black pixels, the exposure
+      // is not changed.
+      if (sWeighted[0].y > 0.0) {
+        float average     = sWeighted[0].x / sWeighted[0].y;
+        float target      = clamp(-average, uExposureRange.x, uExposureRange.y);
+        uExposure         = mix(uExposure, target, uAdaption);
+        uAverageLuminance = exp2(average);
+      }
+
+      uExposure         = clamp(uExposure, uExposureRange.x, uExposureRange.y);
+      uMaximumLuminance = uintBitsToFloat(uMaximumBits);
+      uMaximumBits      = 0;
+    }
+  }
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ExposureHistogram::ExposureHistogram(uint32_t hdrBufferSamples, int hdrBufferWidth,
+    int hdrBufferHeight, HDRBuffer::Format hdrBufferFormat, float initialExposure)
+    : mHDRBufferSamples(hdrBufferSamples)
+    , mHDRBufferWidth(hdrBufferWidth)
+    , mHDRBufferHeight(hdrBufferHeight)
+    , mInitialExposure(initialExposure)
+    , mHDRBufferFormat(hdrBufferFormat) {
+
+  // Create the histogram. It starts with the bits of the maximum luminance.
+  std::vector<uint32_t> zeros(1 + sBinCount, 0U);
+
+  glGenBuffers(1, &mHistogramBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mHistogramBuffer);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER,
+      static_cast<GLsizeiptr>(sizeof(uint32_t) * zeros.size()), zeros.data(), 0);
+
+  // Create the persistently mapped buffer for the exposure, the average and the maximum luminance.
+  std::array<float, 3> exposure{mInitialExposure, 0.F, 0.F};
+
+  GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glGenBuffers(1, &mExposureBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mExposureBuffer);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(exposure), exposure.data(), flags);
+  mExposure = static_cast<float*>(
+      glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(exposure), flags));
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  // Create the compute shaders.
+  std::string defines = "#version 430\n";
+  defines += "#define NUM_BINS " + std::to_string(sBinCount) + "\n";
+
+  std::string histogramDefines = defines;
+  histogramDefines += "#define NUM_MULTISAMPLES " + std::to_string(mHDRBufferSamples) + "\n";
+  histogramDefines +=
+      "#define HDR_BUFFER_FORMAT " + HDRBuffer::getImageFormatQualifier(mHDRBufferFormat) + "\n";
+
+  mHistogramProgram = createComputeProgram(histogramDefines + sComputeHistogram);
+  mAdaptionProgram  = createComputeProgram(defines + sComputeAdaption);
+
+  mUniforms.histogramLogRange = glGetUniformLocation(mHistogramProgram, "uLogRange");
+  mUniforms.adaptionLogRange  = glGetUniformLocation(mAdaptionProgram, "uLogRange");
+  mUniforms.percentiles       = glGetUniformLocation(mAdaptionProgram, "uPercentiles");
+  mUniforms.exposureRange     = glGetUniformLocation(mAdaptionProgram, "uExposureRange");
+  mUniforms.adaption          = glGetUniformLocation(mAdaptionProgram, "uAdaption");
+  mUniforms.reset             = glGetUniformLocation(mAdaptionProgram, "uReset");
+  mUniforms.resetExposure     = glGetUniformLocation(mAdaptionProgram, "uResetExposure");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ExposureHistogram::~ExposureHistogram() {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mExposureBuffer);
+  glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  glDeleteBuffers(1, &mHistogramBuffer);
+  glDeleteBuffers(1, &mExposureBuffer);
+  glDeleteProgram(mHistogramProgram);
+  glDeleteProgram(mAdaptionProgram);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ExposureHistogram::update(VistaTexture* hdrBufferComposite, glm::vec2 const& exposureRange,
+    glm::vec2 const& percentiles, float adaption, std::optional<float> const& resetExposure) {
+
+  utils::FrameStats::ScopedTimer timer("Compute Exposure Histogram");
+
+  // An exposure of ev maps a luminance of 2^-ev to one.
+  glm::vec2 logRange(-exposureRange.y - HISTOGRAM_MARGIN,
+      exposureRange.y - exposureRange.x + 2.F * HISTOGRAM_MARGIN);
+
+  // Sort all pixels into the histogram. --------------------------------------------------------
+
+  glUseProgram(mHistogramProgram);
+  glUniform2f(static_cast<GLint>(mUniforms.histogramLogRange), logRange.x, logRange.y);
+
+  glBindImageTexture(0, hdrBufferComposite->GetId(), 0, GL_FALSE, 0, GL_READ_ONLY,
+      HDRBuffer::getInternalFormat(mHDRBufferFormat));
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mHistogramBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mExposureBuffer);
+
+  // Make sure that the previous frame's adaption has finished resetting the histogram.
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+  glDispatchCompute(static_cast<uint32_t>((mHDRBufferWidth + TILE_SIZE - 1) / TILE_SIZE),
+      static_cast<uint32_t>((mHDRBufferHeight + TILE_SIZE - 1) / TILE_SIZE), 1);
+
+  // Compute the average luminance between the percentiles and adapt the exposure. ----------------
+
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  bool  reset = resetExposure.has_value() || !mInitialized;
+  float ev    = resetExposure.value_or(mInitialExposure);
+
+  glUseProgram(mAdaptionProgram);
+  glUniform2f(static_cast<GLint>(mUniforms.adaptionLogRange), logRange.x, logRange.y);
+  glUniform2f(static_cast<GLint>(mUniforms.percentiles), percentiles.x, percentiles.y);
+  glUniform2f(static_cast<GLint>(mUniforms.exposureRange), exposureRange.x, exposureRange.y);
+  glUniform1f(static_cast<GLint>(mUniforms.adaption), adaption);
+  glUniform1i(static_cast<GLint>(mUniforms.reset), static_cast<int>(reset));
+  glUniform1f(static_cast<GLint>(mUniforms.resetExposure), ev);
+  glDispatchCompute(1, 1, 1);
+
+  // The tone mapping reads the exposure from the buffer and the user interface through the
+  // persistent mapping.
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+
+  mInitialized = true;
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+  glUseProgram(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ExposureHistogram::bindExposureBuffer(uint32_t binding) const {
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mExposureBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ExposureHistogram::getLastExposure() const {
+  return mExposure[0]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ExposureHistogram::getLastAverageLuminance() const {
+  return mExposure[1]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ExposureHistogram::getLastMaximumLuminance() const {
+  return mExposure[2]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
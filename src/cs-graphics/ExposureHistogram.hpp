@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_EXPOSURE_HISTOGRAM_HPP
+#define CS_GRAPHICS_EXPOSURE_HISTOGRAM_HPP
+
+#include "HDRBuffer.hpp"
+
+#include <VistaOGLExt/VistaTexture.h>
+#include <glm/glm.hpp>
+#include <optional>
+
+namespace cs::graphics {
+
+/// The ExposureHistogram computes the auto-exposure of one viewport entirely on the GPU. A first
+/// compute pass sorts the logarithmic luminance of all pixels of the HDR buffer into a histogram.
+/// A second pass, running in a single work group, computes the average logarithmic luminance of
+/// all pixels between two percentiles of this histogram and adapts the current exposure towards
+/// it. Black pixels are not taken into account. As the brightest pixels are excluded, the exposure
+/// is robust against small and very bright objects like the sun.
+///
+/// The exposure is stored in a small shader storage buffer which the ToneMappingNode reads
+/// directly, so no data has to be transferred to the CPU. The buffer is persistently mapped, so
+/// that the current values can still be shown in the user interface. These may be a few frames
+/// old.
+class CS_GRAPHICS_EXPORT ExposureHistogram {
+ public:
+  /// The exposure buffer starts with the given exposure in EV.
+  ExposureHistogram(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight,
+      HDRBuffer::Format hdrBufferFormat = HDRBuffer::Format::eRGBA32F,
+      float initialExposure = 0.F);
+  ~ExposureHistogram();
+
+  ExposureHistogram(ExposureHistogram const& other) = delete;
+  ExposureHistogram(ExposureHistogram&& other)      = delete;
+
+  ExposureHistogram& operator=(ExposureHistogram const& other) = delete;
+  ExposureHistogram& operator=(ExposureHistogram&& other)      = delete;
+
+  /// Meters the given HDR buffer and adapts the exposure. This should only be called once a frame.
+  /// The exposure is clamped to exposureRange (in EV). The average luminance is computed from the
+  /// pixels between the two given percentiles, which should be in [0, 1]. adaption is the fraction
+  /// of the difference between the current and the target exposure which is applied in this
+  /// frame. If resetExposure is set, the exposure is set to this value before the adaption.
+  void update(VistaTexture* hdrBufferComposite, glm::vec2 const& exposureRange,
+      glm::vec2 const& percentiles, float adaption,
+      std::optional<float> const& resetExposure = std::nullopt);
+
+  /// Binds the buffer containing the exposure to the given shader storage buffer binding point.
+  /// It contains the exposure in EV as its first float.
+  void bindExposureBuffer(uint32_t binding) const;
+
+  /// Returns the most recent results which are visible to the CPU. The exposure is given in EV.
+  /// The average luminance is the one computed between the percentiles.
+  float getLastExposure() const;
+  float getLastAverageLuminance() const;
+  float getLastMaximumLuminance() const;
+
+  /// The number of bins of the histogram. The first bin contains black pixels.
+  static constexpr uint32_t sBinCount = 256;
+
+ private:
+  GLuint   mHistogramBuffer  = 0;
+  GLuint   mExposureBuffer   = 0;
+  float*   mExposure         = nullptr;
+  GLuint   mHistogramProgram = 0;
+  GLuint   mAdaptionProgram  = 0;
+  uint32_t mHDRBufferSamples = 0;
+  int      mHDRBufferWidth   = 0;
+  int      mHDRBufferHeight  = 0;
+  float    mInitialExposure  = 0.F;
+  bool     mInitialized      = false;
+
+  HDRBuffer::Format mHDRBufferFormat;
+
+  struct {
+    uint32_t histogramLogRange = 0;
+    uint32_t adaptionLogRange  = 0;
+    uint32_t percentiles       = 0;
+    uint32_t exposureRange     = 0;
+    uint32_t adaption          = 0;
+    uint32_t reset             = 0;
+    uint32_t resetExposure     = 0;
+  } mUniforms;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_EXPOSURE_HISTOGRAM_HPP
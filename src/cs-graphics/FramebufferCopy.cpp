@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "FramebufferCopy.hpp"
+
+#include "GpuMemory.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/DisplayManager/VistaDisplayManager.h>
+#include <VistaKernel/VistaFrameLoop.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaOGLExt/VistaTexture.h>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FramebufferCopy::~FramebufferCopy() {
+  for (auto const& [viewport, copies] : mCopies) {
+    for (auto const& copy : copies) {
+      GpuMemory::get().release("Framebuffer Copies", copy.mBytes);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VistaTexture* FramebufferCopy::get(Attachment attachment, int stage) {
+  auto* viewport = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
+  auto& copy     = mCopies[viewport].at(static_cast<std::size_t>(attachment));
+  int   frame    = GetVistaSystem()->GetFrameLoop()->GetFrameCount();
+
+  if (copy.mIsValid && copy.mFrame == frame && copy.mStage == stage) {
+    return copy.mTexture.get();
+  }
+
+  std::array<GLint, 4> iViewport{};
+  glGetIntegerv(GL_VIEWPORT, iViewport.data());
+
+  if (!copy.mTexture) {
+    copy.mTexture = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
+    copy.mTexture->Bind();
+    copy.mTexture->SetWrapS(GL_CLAMP_TO_EDGE);
+    copy.mTexture->SetWrapT(GL_CLAMP_TO_EDGE);
+    copy.mTexture->SetMinFilter(GL_NEAREST);
+    copy.mTexture->SetMagFilter(GL_NEAREST);
+  } else {
+    copy.mTexture->Bind();
+  }
+
+  // The storage is only redefined if the viewport size changed, glCopyTexSubImage2D() below reuses
+  // it otherwise.
+  if (copy.mWidth != iViewport.at(2) || copy.mHeight != iViewport.at(3)) {
+    copy.mWidth  = iViewport.at(2);
+    copy.mHeight = iViewport.at(3);
+
+    if (attachment == Attachment::eDepth) {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, copy.mWidth, copy.mHeight, 0,
+          GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    } else {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, copy.mWidth, copy.mHeight, 0, GL_RGBA, GL_FLOAT,
+          nullptr);
+    }
+
+    GpuMemory::get().release("Framebuffer Copies", copy.mBytes);
+    copy.mBytes = static_cast<std::size_t>(copy.mWidth) * static_cast<std::size_t>(copy.mHeight) *
+                  (attachment == Attachment::eDepth ? 4 : 8);
+    GpuMemory::get().allocate("Framebuffer Copies", copy.mBytes);
+  }
+
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, iViewport.at(0), iViewport.at(1), copy.mWidth,
+      copy.mHeight);
+  copy.mTexture->Unbind();
+
+  copy.mFrame   = frame;
+  copy.mStage   = stage;
+  copy.mIsValid = true;
+
+  return copy.mTexture.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FramebufferCopy::invalidate(Attachment attachment) {
+  auto* viewport = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_pViewport;
+  mCopies[viewport].at(static_cast<std::size_t>(attachment)).mIsValid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_FRAMEBUFFER_COPY_HPP
+#define CS_GRAPHICS_FRAMEBUFFER_COPY_HPP
+
+#include "cs_graphics_export.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+class VistaTexture;
+class VistaViewport;
+
+namespace cs::graphics {
+
+/// Many drawables need to read the depth or the color of what has been drawn before, for example
+/// atmospheres or overlays which are projected onto the surface of a planet. As a texture cannot be
+/// sampled while it is attached to the framebuffer which is drawn to, they need a copy. This class
+/// provides these copies for all drawables, so that each frame only one copy is made per viewport
+/// and stage instead of one per drawable.
+///
+/// A stage is an arbitrary integer, usually the sort key of the calling drawable. All drawables
+/// which request a copy with the same stage in the same frame get the same texture. Requesting a
+/// copy with another stage updates the texture, so drawables of later stages see everything drawn
+/// in between. If a drawable modifies the framebuffer and drawables of the same stage need to see
+/// the result, it has to call invalidate().
+///
+/// The textures are GL_TEXTURE_2D textures with the size of the viewport. Their storage is only
+/// reallocated if this size changes. The depth copy uses GL_DEPTH_COMPONENT24, the color copy
+/// GL_RGBA16F, so that HDR values are preserved. The currently bound read framebuffer must not be
+/// multisampled. The HDRBuffer attachments can be sampled directly, so this is mostly useful if HDR
+/// rendering is disabled or if a drawable cannot handle multisampled textures.
+///
+/// The GraphicsEngine owns one instance of this class which can be accessed by all plugins.
+class CS_GRAPHICS_EXPORT FramebufferCopy {
+ public:
+  enum class Attachment { eDepth = 0, eColor = 1 };
+
+  FramebufferCopy() = default;
+  ~FramebufferCopy();
+
+  FramebufferCopy(FramebufferCopy const& other) = delete;
+  FramebufferCopy(FramebufferCopy&& other)      = delete;
+
+  FramebufferCopy& operator=(FramebufferCopy const& other) = delete;
+  FramebufferCopy& operator=(FramebufferCopy&& other) = delete;
+
+  /// Returns a texture which contains the given attachment of the currently bound framebuffer in
+  /// the current viewport. The copy is only made if there is no valid copy for the current frame,
+  /// viewport and stage yet. This must be called during rendering.
+  VistaTexture* get(Attachment attachment, int stage);
+
+  /// Makes sure that the next call to get() for the given attachment in the current viewport makes
+  /// a new copy, even if the stage stays the same.
+  void invalidate(Attachment attachment);
+
+ private:
+  struct Copy {
+    std::unique_ptr<VistaTexture> mTexture;
+    int                           mWidth   = 0;
+    int                           mHeight  = 0;
+    int                           mFrame   = -1;
+    int                           mStage   = 0;
+    bool                          mIsValid = false;
+    std::size_t                   mBytes   = 0;
+  };
+
+  std::unordered_map<VistaViewport*, std::array<Copy, 2>> mCopies;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_FRAMEBUFFER_COPY_HPP
@@ -25,14 +25,17 @@ static const char* sGlareShader = R"(
   layout (local_size_x = 16, local_size_y = 16) in;
 
   #if NUM_MULTISAMPLES > 0
-    layout (rgba32f, binding = 0) readonly uniform image2DMS uInHDRBuffer;
+    layout (HDR_BUFFER_FORMAT, binding = 0) readonly uniform image2DMS uInHDRBuffer;
   #else
-    layout (rgba32f, binding = 0) readonly uniform image2D uInHDRBuffer;
+    layout (HDR_BUFFER_FORMAT, binding = 0) readonly uniform image2D uInHDRBuffer;
   #endif
 
   layout (rgba32f, binding = 1) readonly  uniform image2D uInGlare;
   layout (rgba32f, binding = 2) writeonly uniform image2D uOutGlare;
 
+  // This is bound to the same texture as uInGlare. It is used for hardware-filtered look-ups.
+  layout (binding = 0) uniform sampler2D uInGlareSampler;
+
   uniform int  uPass;
   uniform int  uLevel;
   uniform mat4 uMatP;
@@ -40,6 +43,10 @@ static const char* sGlareShader = R"(
 
   const float PI = 3.14159265359;
 
+  // uPass == 2 downsamples the HDR buffer into the base level of the glare mipmap. Then uPass == 0
+  // and uPass == 1 blur each level in two directions.
+  const int PASS_DOWNSAMPLE = 2;
+
   // Makes four texture look-ups in the input HDRBuffer at the four pixels corresponding to
   // the pixel position in the base layer of the output mipmap pyramid.
   // For performance reasons, we only use one sample for multisample inputs.
@@ -58,21 +65,6 @@ static const char* sGlareShader = R"(
     return col;
   }
 
-  // Calls the method above four times in order to allow for bilinear interpolation. This is
-  // required for floating point positions and results in sixteen texture look-ups.
-  vec3 sampleHDRBuffer(vec2 pos) {
-    ivec2 ipos = ivec2(pos);
-    vec3 tl = sampleHDRBuffer(ipos);
-    vec3 tr = sampleHDRBuffer(ipos + ivec2(1, 0));
-    vec3 bl = sampleHDRBuffer(ipos + ivec2(0, 1));
-    vec3 br = sampleHDRBuffer(ipos + ivec2(1, 1));
-    vec2 f  = fract(pos);
-    vec3 tA = mix(tl, tr, f.x);
-    vec3 tB = mix(bl, br, f.x);
-    return mix(tA, tB, f.y);
-  }
-
-
   // Makes four texture look-ups in the input layer of the glare mipmap at the four pixels
   // corresponding to the pixel position in the current layer of the mipmap pyramid.
   vec3 sampleHigherLevel(ivec2 pos) {
@@ -83,38 +75,18 @@ static const char* sGlareShader = R"(
     return col;
   }
 
-  // Calls the method above four times in order to allow for bilinear interpolation. This is
-  // required for floating point positions and results in sixteen texture look-ups.
-  vec3 sampleHigherLevel(vec2 pos) {
-    ivec2 ipos = ivec2(pos);
-    vec3 tl = sampleHigherLevel(ipos);
-    vec3 tr = sampleHigherLevel(ipos + ivec2(1, 0));
-    vec3 bl = sampleHigherLevel(ipos + ivec2(0, 1));
-    vec3 br = sampleHigherLevel(ipos + ivec2(1, 1));
-    vec2 f  = fract(pos);
-    vec3 tA = mix(tl, tr, f.x);
-    vec3 tB = mix(bl, br, f.x);
-    return mix(tA, tB, f.y);
-  }
-
   // Makes just one texture look-ups in the input layer of the glare mipmap at the given
   // pixel position.
   vec3 sampleSameLevel(ivec2 pos) {
     return imageLoad(uInGlare, pos).rgb;
   }
 
-  // Calls the method above four times in order to allow for bilinear interpolation. This is
-  // required for floating point positions and results in four texture look-ups.
-  vec3 sampleSameLevel(vec2 pos) {
-    ivec2 ipos = ivec2(pos);
-    vec3 tl = sampleSameLevel(ipos);
-    vec3 tr = sampleSameLevel(ipos + ivec2(1, 0));
-    vec3 bl = sampleSameLevel(ipos + ivec2(0, 1));
-    vec3 br = sampleSameLevel(ipos + ivec2(1, 1));
-    vec2 f  = fract(pos);
-    vec3 tA = mix(tl, tr, f.x);
-    vec3 tB = mix(bl, br, f.x);
-    return mix(tA, tB, f.y);
+  // Makes one bilinearly filtered look-up in the input layer of the glare mipmap. The position is
+  // given in pixels of the current layer of the mipmap pyramid. This samples the next-higher
+  // layer in the first passes of all layers but the base layer, and the same layer otherwise.
+  vec3 sampleInput(vec2 pos, vec2 outputSize) {
+    float inputLevel = uPass == 0 ? max(uLevel - 1, 0) : uLevel;
+    return textureLod(uInGlareSampler, (pos + 0.5) / outputSize, inputLevel).rgb;
   }
 
   // Rotates the given vector around a given axis.
@@ -128,48 +100,81 @@ static const char* sGlareShader = R"(
     return 1.0 / (sigma*sqrt(2*PI)) * exp(-0.5*pow(value/sigma, 2));
   }
 
+  // Take an odd number of samples to make sure that we sample the center value.
+  const int SAMPLES = 2*(GLARE_QUALITY+1)+1;
+
+  // The first glare variant computes a symmetrical gaussian blur in screen space. It is separated
+  // into a vertical and horizontal component which are computed in different passes.
+  // If uPass == 0, horizontal blurring happens, if uPass == 1, vertical blurring happens.
+  // This is not perspectively correct but very fast.
+  //
+  // Each work group first loads the input values of its 16x16 pixels and of RADIUS pixels on
+  // either side in blur direction into shared memory. This way, each input value is loaded only
+  // once per work group instead of once per sample.
+
+  #ifdef GLAREMODE_SYMMETRIC_GAUSS
+    const int RADIUS      = SAMPLES / 2;
+    const int TILE_LENGTH = 16 + 2 * RADIUS;
+
+    shared vec3 sTile[16 * TILE_LENGTH];
+
+    // This has to be called by all invocations of the work group as it contains a barrier.
+    vec3 getSymmetricGlare() {
+      ivec2 local  = ivec2(gl_LocalInvocationID.xy);
+      ivec2 origin = ivec2(gl_WorkGroupID.xy) * 16;
+      ivec2 dir    = uPass == 0 ? ivec2(1, 0) : ivec2(0, 1);
+      int   along  = uPass == 0 ? local.x : local.y;
+      int   across = uPass == 0 ? local.y : local.x;
+
+      // If we are writing to level zero, we sample the downsampled HDR buffer at the same level.
+      // For all successive levels we sample the previous level in the first passes and the same
+      // level in the second passes.
+      for (int i = along; i < TILE_LENGTH; i += 16) {
+        ivec2 pos = origin + across * (ivec2(1) - dir) + (i - RADIUS) * dir;
+        if (uPass == 0 && uLevel > 0) {
+          sTile[across * TILE_LENGTH + i] = sampleHigherLevel(pos);
+        } else {
+          sTile[across * TILE_LENGTH + i] = sampleSameLevel(pos);
+        }
+      }
+
+      memoryBarrierShared();
+      barrier();
+
+      vec3  glare       = vec3(0);
+      float totalWeight = 0;
+
+      for (int i = -RADIUS; i <= RADIUS; ++i) {
+        float weight = getGauss(1, i);
+        glare += sTile[across * TILE_LENGTH + along + RADIUS + i] * weight;
+        totalWeight += weight;
+      }
+
+      return glare / totalWeight;
+    }
+  #endif
 
   void main() {
 
     ivec2 pixelPos   = ivec2(gl_GlobalInvocationID.xy);
     ivec2 outputSize = imageSize(uOutGlare);
 
-    // Discard any threads outside the output layer.
-    if (pixelPos.x >= outputSize.x || pixelPos.y >= outputSize.y) {
+    // The base level of the glare mipmap is a downsampled version of the HDR buffer.
+    if (uPass == PASS_DOWNSAMPLE) {
+      if (pixelPos.x < outputSize.x && pixelPos.y < outputSize.y) {
+        imageStore(uOutGlare, pixelPos, vec4(sampleHDRBuffer(pixelPos), 0.0));
+      }
       return;
     }
 
-    // Take an odd number of samples to make sure that we sample the center value.
-    const float samples = 2*(GLARE_QUALITY+1)+1;
-
-    // These values will contain the accumulated glare values.
-    vec3  glare       = vec3(0);
-    float totalWeight = 0;
-
-    // The first glare variant computes a symmetrical gaussian blur in screen space. It is separated
-    // into a vertical and horizontal component which are computed in different passes.
-    // If uPass == 0, horizontal blurring happens, if uPass == 1, vertical blurring happens.
-    // This is not perspectively correct but very fast.
-
     #ifdef GLAREMODE_SYMMETRIC_GAUSS
-      for (float i = 0; i < samples; ++i) {
-        float offset = i - floor(samples/2);
-        float weight = getGauss(1, offset);
-        totalWeight += weight;
-
-        // If we are writing to level zero, we have to sample the input HDR buffer. For all
-        // successive levels we sample the previous level in the first passes and the same level
-        // in the second passes.
-        if (uPass == 0 && uLevel == 0) {
-          glare += sampleHDRBuffer(pixelPos+ivec2(offset, 0)) * weight;
-        } else if (uPass == 0) {
-          glare += sampleHigherLevel(pixelPos+ivec2(offset, 0)) * weight;
-        } else {
-          glare += sampleSameLevel(pixelPos+ivec2(0, offset)) * weight;
-        }
-      }
+      vec3 glare = getSymmetricGlare();
     #endif
 
+    // Discard any threads outside the output layer.
+    if (pixelPos.x >= outputSize.x || pixelPos.y >= outputSize.y) {
+      return;
+    }
 
     // The second variant computes an asymmetric perspectively correct gaussian decomposed into two
     // components which can be roughly described as radial and circular. A naive implementation with
@@ -194,6 +199,10 @@ static const char* sGlareShader = R"(
 
     #ifdef GLAREMODE_ASYMMETRIC_GAUSS
 
+      // These values will contain the accumulated glare values.
+      vec3  glare       = vec3(0);
+      float totalWeight = 0;
+
       // Reproject the current pixel position to view space.
       vec2 posClipSpace = 2.0 * vec2(gl_GlobalInvocationID.xy) / vec2(outputSize) - 1.0;
       vec4 posViewSpace = uMatInvP * vec4(posClipSpace, 0.0, 1.0);
@@ -228,8 +237,8 @@ static const char* sGlareShader = R"(
 
       // Rotate the view vector to the current pixel several times around the rotation axis
       // in order to sample the vicinity.
-      for (float i = 0; i < samples; ++i) {
-        float angle  = totalAngle * i / (samples-1) - totalAngle * 0.5;
+      for (float i = 0; i < SAMPLES; ++i) {
+        float angle  = totalAngle * i / (SAMPLES-1) - totalAngle * 0.5;
         float sigma  = totalAngle / MAX_LEVELS;
         float weight = getGauss(sigma, angle);
 
@@ -240,36 +249,30 @@ static const char* sGlareShader = R"(
         // Convert to texture space.
         vec2 samplePos = (0.5*pos.xy + 0.5)*outputSize;
 
-        // If we are writing to level zero, we have to sample the input HDR buffer. For all
-        // successive levels we sample the previous level in the first passes and the same level
-        // in the second passes.
-        if (uPass == 0 && uLevel == 0) {
-          glare += sampleHDRBuffer(samplePos) * weight;
-        } else if (uPass == 0) {
-          glare += sampleHigherLevel(samplePos) * weight;
-        } else {
-          glare += sampleSameLevel(samplePos) * weight;
-        }
+        // The samples are filtered by the texture units, so each sample is a single look-up.
+        glare += sampleInput(samplePos, vec2(outputSize)) * weight;
 
         totalWeight += weight;
       }
-    #endif
 
-    // Make sure that we do not add energy.
-    glare /= totalWeight;
+      // Make sure that we do not add energy.
+      glare /= totalWeight;
+    #endif
 
     // Finally store the glare value in the output layer of the glare mipmap.
     imageStore(uOutGlare, pixelPos, vec4(glare, 0.0));
   }
 )";
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+////////
 
-GlareMipMap::GlareMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight)
+GlareMipMap::GlareMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight,
+    HDRBuffer::Format hdrBufferFormat)
     : VistaTexture(GL_TEXTURE_2D)
     , mHDRBufferSamples(hdrBufferSamples)
     , mHDRBufferWidth(hdrBufferWidth)
     , mHDRBufferHeight(hdrBufferHeight)
+    , mHDRBufferFormat(hdrBufferFormat)
     , mTemporaryTarget(new VistaTexture(GL_TEXTURE_2D)) {
 
   // Create glare mipmap storage. The texture has half the size of the HDR buffer (rounded down) in
@@ -291,6 +294,10 @@ GlareMipMap::GlareMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrB
 
   // Create storage for temporary glare target (this is used for the vertical blurring passes).
   mTemporaryTarget->Bind();
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexStorage2D(GL_TEXTURE_2D, mMaxLevels, GL_RGBA32F, iWidth, iHeight);
   mTemporaryTarget->Unbind();
 }
@@ -314,6 +321,8 @@ void GlareMipMap::update(
     auto        shader = glCreateShader(GL_COMPUTE_SHADER);
     std::string source = "#version 430\n";
     source += "#define NUM_MULTISAMPLES " + std::to_string(mHDRBufferSamples) + "\n";
+    source += "#define HDR_BUFFER_FORMAT " + HDRBuffer::getImageFormatQualifier(mHDRBufferFormat) +
+              "\n";
     source += "#define GLARE_QUALITY " + std::to_string(glareQuality) + "\n";
     source += "#define MAX_LEVELS " + std::to_string(mMaxLevels) + "\n";
 
@@ -367,14 +376,15 @@ void GlareMipMap::update(
   }
 
   // We update the glare mipmap with several passes. First, the base level is filled with a
-  // downsampled and horizontally blurred version of the HDRBuffer. Then, this is blurred
-  // vertically. Then it's downsampled and horizontally blurred once more. And so on.
+  // downsampled version of the HDRBuffer. This is blurred horizontally and then vertically. Then
+  // it's downsampled and horizontally blurred once more, then vertically. And so on.
   // In the asymmetric case, its not strictly horizontal and vertical - see the shader above for
   // details.
 
   glUseProgram(mComputeProgram);
 
-  glBindImageTexture(0, hdrBufferComposite->GetId(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+  glBindImageTexture(0, hdrBufferComposite->GetId(), 0, GL_FALSE, 0, GL_READ_ONLY,
+      HDRBuffer::getInternalFormat(mHDRBufferFormat));
 
   // The asymmetric variant requires the projection and the inverse projection matrices.
   if (glareMode == HDRBuffer::GlareMode::eAsymmetricGauss) {
@@ -386,6 +396,22 @@ void GlareMipMap::update(
     glUniformMatrix4fv(mUniforms.inverseProjectionMatrix, 1, GL_FALSE, glm::value_ptr(matInvP));
   }
 
+  // Returns the number of work groups required in the given direction of the given level.
+  auto getNumGroups = [](int hdrBufferSize, int level) {
+    int size = static_cast<int>(
+        std::max(1.0, std::floor(static_cast<double>(static_cast<int>(hdrBufferSize / 2)) /
+                                 std::pow(2, level))));
+    return static_cast<uint32_t>(std::ceil(1.0 * size / 16));
+  };
+
+  // Downsample the HDR buffer into the base level. This is the only pass which reads the HDR
+  // buffer, so multisampled buffers are resolved only once.
+  glUniform1i(mUniforms.level, 0);
+  glUniform1i(mUniforms.pass, 2);
+  glBindImageTexture(2, GetId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  glDispatchCompute(getNumGroups(mHDRBufferWidth, 0), getNumGroups(mHDRBufferHeight, 0), 1);
+
   for (int level(0); level < mMaxLevels; ++level) {
     glUniform1i(mUniforms.level, level);
 
@@ -396,7 +422,7 @@ void GlareMipMap::update(
       int           outputLevel = level;
 
       // level  pass   input   inputLevel output outputLevel     blur      samplesHigherLevel
-      //   0     0   hdrbuffer    0        temp      0        horizontal          true
+      //   0     0     this       0        temp      0        horizontal          false
       //   0     1     temp       0        this      0         vertical           false
       //   1     0     this       0        temp      1        horizontal          true
       //   1     1     temp       1        this      1         vertical           false
@@ -416,22 +442,20 @@ void GlareMipMap::update(
 
       glUniform1i(mUniforms.pass, pass);
 
-      int width = static_cast<int>(
-          std::max(1.0, std::floor(static_cast<double>(static_cast<int>(mHDRBufferWidth / 2)) /
-                                   std::pow(2, level))));
-      int height = static_cast<int>(
-          std::max(1.0, std::floor(static_cast<double>(static_cast<int>(mHDRBufferHeight / 2)) /
-                                   std::pow(2, level))));
-
       glBindImageTexture(1, input->GetId(), inputLevel, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
       glBindImageTexture(2, output->GetId(), outputLevel, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
-      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-      glDispatchCompute(static_cast<uint32_t>(std::ceil(1.0 * width / 16)),
-          static_cast<uint32_t>(std::ceil(1.0 * height / 16)), 1);
+      // The asymmetric variant reads the input with hardware filtering.
+      input->Bind(GL_TEXTURE0);
+
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+      glDispatchCompute(
+          getNumGroups(mHDRBufferWidth, level), getNumGroups(mHDRBufferHeight, level), 1);
     }
   }
 
+  mTemporaryTarget->Unbind(GL_TEXTURE0);
+
   glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
   glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
   glBindImageTexture(2, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
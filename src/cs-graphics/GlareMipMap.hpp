@@ -18,9 +18,14 @@ namespace cs::graphics {
 /// Whenever update() is called, all mipmap levels are updated using compute shaders in several
 /// passes to contain a blurred version of the given texture. The blur radius increases with the
 /// mipmap level.
+///
+/// The given texture is downsampled into the base level first, so that it is read only once. The
+/// symmetric glare loads tiles of the input into shared memory, so each input pixel is read only
+/// once per work group. The asymmetric glare uses hardware-filtered texture look-ups.
 class CS_GRAPHICS_EXPORT GlareMipMap : public VistaTexture {
  public:
-  GlareMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight);
+  GlareMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight,
+      HDRBuffer::Format hdrBufferFormat = HDRBuffer::Format::eRGBA32F);
   ~GlareMipMap() override;
 
   GlareMipMap(GlareMipMap const& other) = delete;
@@ -40,6 +45,7 @@ class CS_GRAPHICS_EXPORT GlareMipMap : public VistaTexture {
   int                  mMaxLevels        = 0;
   int                  mHDRBufferWidth   = 0;
   int                  mHDRBufferHeight  = 0;
+  HDRBuffer::Format    mHDRBufferFormat  = HDRBuffer::Format::eRGBA32F;
   HDRBuffer::GlareMode mLastGlareMode    = HDRBuffer::GlareMode::eSymmetricGauss;
   uint32_t             mLastGlareQuality = 0;
 
@@ -7,6 +7,8 @@
 
 #include "GltfLoader.hpp"
 
+#include "logger.hpp"
+
 #ifdef _WIN32
 
 #ifndef NOMINMAX
@@ -25,7 +27,6 @@
 
 #include <VistaInterProcComm/Connections/VistaByteBufferDeSerializer.h>
 
-#include <fstream>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "internal/gltfmodel.hpp"
@@ -34,58 +35,40 @@ namespace cs::graphics {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-namespace {
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
+GltfLoader::GltfLoader(const std::string& sGltfFile, const std::string& cubemapFilepath,
+    std::string environmentCacheDirectory)
+    : mShared(std::make_shared<internal::GltfShared>())
+    , mGltfFile(sGltfFile)
+    , mCubemapFile(cubemapFilepath)
+    , mEnvironmentCacheDirectory(std::move(environmentCacheDirectory)) {
 
-template <typename T>
-bool FromString(std::string const& v, T& out) {
-  std::istringstream iss(v);
-  iss >> out;
-  return (iss.rdstate() & std::stringstream::failbit) == 0;
+  // If another instance of the same model exists, its resources are available right away.
+  update();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::string GetFilePathExtension(const std::string& FileName) {
-  if (FileName.find_last_of('.') != std::string::npos) {
-    return FileName.substr(FileName.find_last_of('.') + 1);
+bool GltfLoader::update() {
+  if (isLoaded()) {
+    return false;
   }
 
-  return "";
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  try {
+    mShared->mResources = internal::getGltfResources(
+        mGltfFile, mCubemapFile, mEnvironmentCacheDirectory);
+  } catch (std::exception const& e) {
+    logger().error("Failed to load glTF model '{}': {}", mGltfFile, e.what());
+    mFailed = true;
+    return false;
+  }
 
-} // namespace
+  return mShared->mResources && mSceneGraph && buildNodes();
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-GltfLoader::GltfLoader(const std::string& sGltfFile, const std::string& cubemapFilepath)
-    : mShared(std::make_shared<internal::GltfShared>()) {
-  tinygltf::TinyGLTF loader;
-  std::string        err;
-  std::string        warn;
-  std::string        ext = GetFilePathExtension(sGltfFile);
-
-  bool ret = false;
-  if (ext == "glb") {
-    // Assume binary glTF.
-    ret = loader.LoadBinaryFromFile(&mShared->mTinyGltfModel, &err, &warn, sGltfFile);
-  } else {
-    // Assume ascii glTF.
-    ret = loader.LoadASCIIFromFile(&mShared->mTinyGltfModel, &err, &warn, sGltfFile);
-  }
-
-  if (!err.empty()) {
-    throw std::runtime_error(err);
-  }
-  if (!ret) {
-    std::string msg("Failed to load .glTF: ");
-    throw std::runtime_error(msg + sGltfFile);
-  }
-
-  mShared->init(mShared->mTinyGltfModel, cubemapFilepath);
+bool GltfLoader::isLoaded() const {
+  return mShared->mResources || mFailed;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -132,6 +115,18 @@ void GltfLoader::setIBLIntensity(float intensity) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void GltfLoader::setMaxLodError(float pixels) {
+  mShared->m_maxLodError = pixels;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GltfLoader::setInstances(std::vector<glm::mat4> const& transformations) {
+  mShared->setInstances(transformations);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void apply_transform(VistaTransformNode& vista_transform, tinygltf::Node const& node) {
   if (node.matrix.size() == 16) {
     glm::mat4 mat = glm::make_mat4(node.matrix.data());
@@ -168,23 +163,37 @@ void build_node(VistaSceneGraph& sg, std::shared_ptr<internal::GltfShared> const
   apply_transform(*transform_node, tinygltf_node);
   transform_node->SetName(tinygltf_node.name);
   for (int i : tinygltf_node.children) {
-    build_node(sg, shared, transform_node, shared->mTinyGltfModel.nodes[i]);
+    build_node(sg, shared, transform_node, shared->mResources->mTinyGltfModel.nodes[i]);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool GltfLoader::attachTo(VistaSceneGraph* pSG, VistaTransformNode* parent) {
-  if (mShared->mTinyGltfModel.scenes.empty()) {
+  mSceneGraph = pSG;
+  mParent     = parent;
+
+  if (!mShared->mResources) {
+    return !mFailed;
+  }
+
+  return buildNodes();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool GltfLoader::buildNodes() {
+  auto const& model = mShared->mResources->mTinyGltfModel;
+
+  if (model.scenes.empty()) {
     return false;
   }
 
-  auto const& scene = (mShared->mTinyGltfModel.defaultScene >= 0)
-                          ? mShared->mTinyGltfModel.scenes[mShared->mTinyGltfModel.defaultScene]
-                          : mShared->mTinyGltfModel.scenes.front();
+  auto const& scene =
+      (model.defaultScene >= 0) ? model.scenes[model.defaultScene] : model.scenes.front();
 
   for (int i : scene.nodes) {
-    build_node(*pSG, mShared, parent, mShared->mTinyGltfModel.nodes[i]);
+    build_node(*mSceneGraph, mShared, mParent, model.nodes[i]);
   }
   return true;
 }
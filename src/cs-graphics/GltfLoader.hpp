@@ -16,6 +16,7 @@
 #include <glm/glm.hpp>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 class VistaVector3D;
@@ -34,11 +35,23 @@ struct GltfShared;
 }
 
 /// If added to the scene graph, this will draw a Gltf 2.0 model.
+///
+/// The model is loaded in two stages. Parsing the files and decoding all images happens on a
+/// background thread which is started by the constructor. Once this is done, update() uploads the
+/// data to the GPU and adds the model to the scene graph. Until then, nothing is drawn.
+///
+/// All instances which load the same glTF and cubemap files share the parsed model and all GPU
+/// resources, so further instances of a model are available immediately. The filtered environment
+/// maps for image based lighting are additionally shared by all models which use the same cubemap.
+/// Only the lighting parameters are specific to each instance.
 // TODO maybe rename to GltfModel, because it does a lot more than loading an gltf model.
 class CS_GRAPHICS_EXPORT GltfLoader {
  public:
-  /// Creates a gltf model from the gltf and cubemap files.
-  GltfLoader(const std::string& sGltfFile, const std::string& cubemapFilepath);
+  /// Starts loading a gltf model from the gltf and cubemap files in the background. Filtering the
+  /// cubemap for image based lighting takes a while. If an environmentCacheDirectory is given, the
+  /// filtered maps are stored there as KTX files and loaded from there in later sessions.
+  GltfLoader(const std::string& sGltfFile, const std::string& cubemapFilepath,
+      std::string environmentCacheDirectory = "");
 
   GltfLoader(GltfLoader const& other) = delete;
   GltfLoader(GltfLoader&& other)      = delete;
@@ -48,6 +61,15 @@ class CS_GRAPHICS_EXPORT GltfLoader {
 
   ~GltfLoader() = default;
 
+  /// This has to be called regularly on the main thread until isLoaded() returns true. Once the
+  /// background stage has finished, this uploads the model to the GPU and attaches it to the scene
+  /// graph if attachTo() has been called before. Returns true if the model has been attached
+  /// during this call. If loading fails, an error is logged and the model will never be drawn.
+  bool update();
+
+  /// Returns true once update() has uploaded the model or if loading has failed.
+  bool isLoaded() const;
+
   void setLightColor(float r, float g, float b);
   void setLightDirection(float x, float y, float z);
   void setLightDirection(VistaVector3D const& dir);
@@ -56,15 +78,37 @@ class CS_GRAPHICS_EXPORT GltfLoader {
 
   void setIBLIntensity(float intensity);
 
+  /// Large primitives are simplified when they are loaded. The coarsest level of detail whose
+  /// vertices are off by at most the given number of pixels is drawn. Zero disables the levels of
+  /// detail. The default is one pixel.
+  void setMaxLodError(float pixels);
+
+  /// Draws the model once for each of the given transformations with a single draw call per
+  /// primitive. The transformations are applied on top of the transformation of the parent given
+  /// to attachTo(), so for example observer-relative transformations can be used if the parent is
+  /// the root node. All instances share the lighting parameters and are never culled. An empty
+  /// list, which is the default, disables instancing. This has to be called on the main thread.
+  void setInstances(std::vector<glm::mat4> const& transformations);
+
   /// Please make sure that the supplied matrix is orthogonal.
   ///   transpose(m) == inverse(m);
   void rotateIBL(glm::mat3 const& m);
 
-  /// Attaches the model to the VistaSceneGraph for rendering.
+  /// Attaches the model to the VistaSceneGraph for rendering. If the model has not been loaded
+  /// yet, it will be attached by update() once it is ready. Returns false if the loaded model
+  /// contains no scene.
   bool attachTo(VistaSceneGraph* sg, VistaTransformNode* parent);
 
  private:
+  bool buildNodes();
+
   std::shared_ptr<internal::GltfShared> mShared;
+  std::string                           mGltfFile;
+  std::string                           mCubemapFile;
+  std::string                           mEnvironmentCacheDirectory;
+  bool                                  mFailed     = false;
+  VistaSceneGraph*                      mSceneGraph = nullptr;
+  VistaTransformNode*                   mParent     = nullptr;
 };
 
 } // namespace cs::graphics
@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "GpuMemory.hpp"
+
+#include "../cs-utils/FrameStats.hpp"
+#include "../cs-utils/Metrics.hpp"
+#include "logger.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// After onPressure() has been emitted, it is not emitted again for this number of calls to
+// update(). The driver usually reports freed memory with some delay.
+uint32_t const pressureInterval = 60;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GpuMemory& GpuMemory::get() {
+  static GpuMemory instance;
+  return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GpuMemory::GpuMemory()
+    : mUpdatesSincePressure(pressureInterval) {
+
+  // The usages of all subsystems and the values reported by the driver are published when the
+  // metrics are requested.
+  mCollectorId = utils::Metrics::get().addCollector([this](utils::Metrics& metrics) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto const& [subsystem, bytes] : mUsages) {
+      metrics
+          .getSample("cosmoscout_gpu_memory_bytes", utils::Metrics::Type::eGauge,
+              "The GPU memory allocated by the subsystems.", {{"subsystem", subsystem}})
+          .set(static_cast<double>(bytes));
+    }
+
+    if (mDedicatedMemory) {
+      metrics
+          .getSample("cosmoscout_gpu_memory_dedicated_bytes", utils::Metrics::Type::eGauge,
+              "The dedicated video memory as reported by the driver.")
+          .set(static_cast<double>(*mDedicatedMemory));
+    }
+
+    if (mAvailableMemory) {
+      metrics
+          .getSample("cosmoscout_gpu_memory_available_bytes", utils::Metrics::Type::eGauge,
+              "The currently available video memory as reported by the driver.")
+          .set(static_cast<double>(*mAvailableMemory));
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GpuMemory::~GpuMemory() {
+  utils::Metrics::get().removeCollector(mCollectorId);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuMemory::allocate(std::string const& subsystem, std::size_t bytes) {
+  auto owner = utils::FrameStats::getCurrentOwner();
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mUsages[subsystem] += bytes;
+
+  if (owner && mOwners.find(subsystem) == mOwners.end()) {
+    mOwners.emplace(subsystem, utils::FrameStats::getName(*owner));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuMemory::release(std::string const& subsystem, std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto& usage = mUsages[subsystem];
+
+  if (bytes > usage) {
+    logger().warn("Subsystem '{}' released more GPU memory than it allocated!", subsystem);
+    usage = 0;
+  } else {
+    usage -= bytes;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t GpuMemory::getUsage(std::string const& subsystem) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto it = mUsages.find(subsystem);
+  return it == mUsages.end() ? 0 : it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, std::size_t> GpuMemory::getUsages() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mUsages;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, std::size_t> GpuMemory::getOwnerUsages() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  std::map<std::string, std::size_t> usages;
+  for (auto const& [subsystem, owner] : mOwners) {
+    usages[owner] += mUsages.at(subsystem);
+  }
+
+  return usages;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t GpuMemory::getTotalUsage() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  std::size_t total = 0;
+  for (auto const& usage : mUsages) {
+    total += usage.second;
+  }
+
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuMemory::setBudget(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mBudget = bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t GpuMemory::getBudget() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuMemory::setReserve(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mReserve = bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t GpuMemory::getReserve() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mReserve;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<std::size_t> GpuMemory::getDedicatedMemory() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mDedicatedMemory;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<std::size_t> GpuMemory::getAvailableMemory() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mAvailableMemory;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t GpuMemory::getRemainingBudget() const {
+  std::size_t total     = getTotalUsage();
+  std::size_t remaining = std::numeric_limits<std::size_t>::max();
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mBudget > 0) {
+    remaining = mBudget > total ? mBudget - total : 0;
+  }
+
+  if (mAvailableMemory) {
+    std::size_t available = *mAvailableMemory > mReserve ? *mAvailableMemory - mReserve : 0;
+    remaining             = std::min(remaining, available);
+  }
+
+  return remaining;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t GpuMemory::getExcess() const {
+  std::size_t total  = getTotalUsage();
+  std::size_t excess = 0;
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mBudget > 0 && total > mBudget) {
+    excess = total - mBudget;
+  }
+
+  if (mAvailableMemory && *mAvailableMemory < mReserve) {
+    excess = std::max(excess, mReserve - *mAvailableMemory);
+  }
+
+  return excess;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuMemory::update() {
+
+  // Both extensions report kilobytes. GL_ATI_meminfo reports the free memory of the texture pool
+  // in the first of four values, it does not report the total memory.
+  if (GLEW_NVX_gpu_memory_info) {
+    GLint dedicated = 0;
+    GLint available = 0;
+    glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+    glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDedicatedMemory = static_cast<std::size_t>(dedicated) * 1024;
+    mAvailableMemory = static_cast<std::size_t>(available) * 1024;
+
+  } else if (GLEW_ATI_meminfo) {
+    std::array<GLint, 4> info{};
+    glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, info.data());
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mAvailableMemory = static_cast<std::size_t>(info[0]) * 1024;
+  }
+
+  if (++mUpdatesSincePressure < pressureInterval) {
+    return;
+  }
+
+  std::size_t excess = getExcess();
+
+  if (excess > 0) {
+    logger().debug("GPU memory is under pressure, {} MiB should be freed.", excess / 1024 / 1024);
+    mUpdatesSincePressure = 0;
+    mOnPressure.emit(excess);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+utils::Signal<std::size_t> const& GpuMemory::onPressure() const {
+  return mOnPressure;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
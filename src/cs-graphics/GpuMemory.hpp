@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_GPU_MEMORY_HPP
+#define CS_GRAPHICS_GPU_MEMORY_HPP
+
+#include "cs_graphics_export.hpp"
+
+#include "../cs-utils/Signal.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace cs::graphics {
+
+/// This is a singleton class which keeps track of the GPU memory allocated by the different
+/// subsystems of CosmoScout VR and its plugins, for example the HDR buffer or the tile textures of
+/// csp-lod-bodies. Subsystems report their allocations with allocate() and release(). The numbers
+/// are published to the cs::utils::Metrics, one sample of "cosmoscout_gpu_memory_bytes" per
+/// subsystem.
+///
+/// If the driver supports GL_NVX_gpu_memory_info or GL_ATI_meminfo, the available video memory is
+/// queried in update() as well. The memory is under pressure if the tracked allocations exceed the
+/// budget or if the driver reports less available memory than the reserve. In this case,
+/// onPressure() is emitted and subsystems should free or downscale some of their resources.
+/// Subsystems which allocate large resources should check getRemainingBudget() beforehand.
+///
+/// Each subsystem is attributed to the cs::utils::FrameStats owner which is current during its
+/// first allocation, so that the memory used by each plugin can be reported.
+///
+/// All methods except update() are thread-safe.
+class CS_GRAPHICS_EXPORT GpuMemory {
+ public:
+  static GpuMemory& get();
+
+  GpuMemory(GpuMemory const& other) = delete;
+  GpuMemory(GpuMemory&& other)      = delete;
+
+  GpuMemory& operator=(GpuMemory const& other) = delete;
+  GpuMemory& operator=(GpuMemory&& other)      = delete;
+
+  ~GpuMemory();
+
+  /// Adds or removes the given number of bytes to the usage of a subsystem. The subsystem names
+  /// should be short and human-readable, like "HDR Buffer".
+  void allocate(std::string const& subsystem, std::size_t bytes);
+  void release(std::string const& subsystem, std::size_t bytes);
+
+  /// Returns the number of bytes currently allocated by the given subsystem or by all subsystems.
+  std::size_t                        getUsage(std::string const& subsystem) const;
+  std::map<std::string, std::size_t> getUsages() const;
+  std::size_t                        getTotalUsage() const;
+
+  /// Returns the number of bytes currently allocated by the subsystems of each owner, see
+  /// cs::utils::FrameStats::ScopedOwner. Subsystems without an owner are not included.
+  std::map<std::string, std::size_t> getOwnerUsages() const;
+
+  /// The tracked allocations should not use more than this number of bytes. Zero means that there
+  /// is no limit, this is the default.
+  void        setBudget(std::size_t bytes);
+  std::size_t getBudget() const;
+
+  /// The memory is under pressure if the driver reports less available video memory than this.
+  /// This accounts for allocations which are not tracked, for example by the window system.
+  void        setReserve(std::size_t bytes);
+  std::size_t getReserve() const;
+
+  /// The dedicated and the currently available video memory as reported by the driver during the
+  /// last call to update(). This is std::nullopt if the driver does not support any of the
+  /// extensions mentioned above.
+  std::optional<std::size_t> getDedicatedMemory() const;
+  std::optional<std::size_t> getAvailableMemory() const;
+
+  /// Returns the number of bytes which can be allocated without exceeding the budget or the
+  /// reserve. If neither is known, the maximum value of std::size_t is returned.
+  std::size_t getRemainingBudget() const;
+
+  /// Returns the number of bytes which should be freed. This is zero if the memory is not under
+  /// pressure.
+  std::size_t getExcess() const;
+
+  /// Queries the available memory from the driver and emits onPressure() if the memory is under
+  /// pressure. The signal is emitted at most every few calls, so that freed memory is reported by
+  /// the driver before more is freed. This is called once a frame by the GraphicsEngine on the main
+  /// thread.
+  void update();
+
+  /// This is emitted with the result of getExcess() if the memory is under pressure.
+  utils::Signal<std::size_t> const& onPressure() const;
+
+ private:
+  GpuMemory();
+
+  mutable std::mutex                 mMutex;
+  std::map<std::string, std::size_t> mUsages;
+  std::map<std::string, std::string> mOwners;
+  std::size_t                        mBudget  = 0;
+  std::size_t                        mReserve = 256 * 1024 * 1024;
+  std::optional<std::size_t>         mDedicatedMemory;
+  std::optional<std::size_t>         mAvailableMemory;
+
+  utils::Signal<std::size_t> mOnPressure;
+  uint32_t                   mUpdatesSincePressure = 0;
+  int                        mCollectorId          = -1;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_GPU_MEMORY_HPP
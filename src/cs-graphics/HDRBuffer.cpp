@@ -7,8 +7,11 @@
 
 #include "HDRBuffer.hpp"
 
+#include "ExposureHistogram.hpp"
 #include "GlareMipMap.hpp"
+#include "GpuMemory.hpp"
 #include "LuminanceMipMap.hpp"
+#include "TemporalAntiAliasing.hpp"
 #include "logger.hpp"
 
 #include <VistaKernel/DisplayManager/VistaDisplayManager.h>
@@ -16,8 +19,11 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaOGLExt/VistaFramebufferObj.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
+#include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 
 namespace cs::graphics {
 
@@ -25,7 +31,7 @@ namespace cs::graphics {
 
 HDRBuffer::HDRBuffer(uint32_t multiSamples, bool highPrecision)
     : mMultiSamples(multiSamples)
-    , mHighPrecision(highPrecision) {
+    , mFormat(highPrecision ? Format::eRGBA32F : Format::eRGBA16F) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -33,6 +39,9 @@ HDRBuffer::HDRBuffer(uint32_t multiSamples, bool highPrecision)
 HDRBuffer::~HDRBuffer() {
   // Destructor must not be inline as the std::unique_ptrs would otherwise not accept incomplete
   // types in the header.
+  for (auto const& hdrBuffer : mHDRBufferData) {
+    GpuMemory::get().release("HDR Buffer", hdrBuffer.second.mBytes);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -43,16 +52,55 @@ uint32_t HDRBuffer::getMultiSamples() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void HDRBuffer::setFormat(Format format) {
+  mFormat = format;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HDRBuffer::Format HDRBuffer::getFormat() const {
+  return mFormat;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HDRBuffer::setResolutionScale(float scale) {
+  mResolutionScale = std::clamp(scale, 0.1F, 1.F);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float HDRBuffer::getResolutionScale() const {
+  return mResolutionScale;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::array<int, 2> HDRBuffer::getCurrentSize() const {
+  auto const& hdrBuffer = getCurrentHDRBuffer();
+  return {hdrBuffer.mWidth, hdrBuffer.mHeight};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void HDRBuffer::bind() {
 
   // There is a different framebuffer object for each viewport. Here wee retrieve the current one.
   auto& hdrBuffer = getCurrentHDRBuffer();
   auto  size      = getCurrentViewPortSize();
 
-  // If the size changed, we have to re-create the framebuffer object and its attachments.
-  if (size[0] != hdrBuffer.mWidth || size[1] != hdrBuffer.mHeight) {
+  // The attachments may be smaller than the viewport.
+  for (auto& s : size) {
+    s = std::max(1, static_cast<int>(std::lround(static_cast<float>(s) * mResolutionScale)));
+  }
+
+  // If the size or the format changed, we have to re-create the framebuffer object and its
+  // attachments.
+  if (size[0] != hdrBuffer.mWidth || size[1] != hdrBuffer.mHeight ||
+      mFormat != hdrBuffer.mFormat) {
     hdrBuffer.mWidth  = size[0];
     hdrBuffer.mHeight = size[1];
+    hdrBuffer.mFormat = mFormat;
 
     // Create new framebuffer object.
     hdrBuffer.mFBO.reset(new VistaFramebufferObj());
@@ -82,23 +130,51 @@ void HDRBuffer::bind() {
       hdrBuffer.mFBO->Attach(texture.get(), attachment);
     };
 
+    auto internalFormat = static_cast<int>(getInternalFormat(mFormat));
+
     // Add HDR-attachment ping-pong A.
-    addAttachment(hdrBuffer.mColorAttachments[0], GL_COLOR_ATTACHMENT0,
-        mHighPrecision ? GL_RGBA32F : GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    addAttachment(
+        hdrBuffer.mColorAttachments[0], GL_COLOR_ATTACHMENT0, internalFormat, GL_RGBA, GL_FLOAT);
 
     // Add HDR-attachment ping-pong B.
-    addAttachment(hdrBuffer.mColorAttachments[1], GL_COLOR_ATTACHMENT1,
-        mHighPrecision ? GL_RGBA32F : GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    addAttachment(
+        hdrBuffer.mColorAttachments[1], GL_COLOR_ATTACHMENT1, internalFormat, GL_RGBA, GL_FLOAT);
 
     // Add depth-attachment.
     addAttachment(hdrBuffer.mDepthAttachment, GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24,
         GL_DEPTH_COMPONENT, GL_FLOAT);
 
     // Create luminance mipmaps.
-    hdrBuffer.mLuminanceMipMap.reset(new LuminanceMipMap(mMultiSamples, size[0], size[1]));
+    hdrBuffer.mLuminanceMipMap.reset(
+        new LuminanceMipMap(mMultiSamples, size[0], size[1], mFormat));
+
+    // Create the exposure histogram. It starts with the most recent exposure so that resizing a
+    // viewport does not cause a visible jump.
+    hdrBuffer.mExposureHistogram.reset(
+        new ExposureHistogram(mMultiSamples, size[0], size[1], mFormat, mExposure));
 
     // Create glare mipmaps.
-    hdrBuffer.mGlareMipMap.reset(new GlareMipMap(mMultiSamples, size[0], size[1]));
+    hdrBuffer.mGlareMipMap.reset(new GlareMipMap(mMultiSamples, size[0], size[1], mFormat));
+
+    // The history of the temporal anti-aliasing is re-created with the new size when it is used
+    // the next time.
+    for (auto& temporalAntiAliasing : hdrBuffer.mTemporalAntiAliasing) {
+      temporalAntiAliasing.reset();
+    }
+
+    // Report the size of the two color attachments and the depth attachment. The mipmaps are
+    // comparatively small and therefore not included.
+    std::size_t colorBytes = 16;
+    if (mFormat != Format::eRGBA32F) {
+      colorBytes = mFormat == Format::eRGBA16F ? 8 : 4;
+    }
+
+    std::size_t pixels = static_cast<std::size_t>(size[0]) * static_cast<std::size_t>(size[1]) *
+                         std::max(mMultiSamples, 1U);
+
+    GpuMemory::get().release("HDR Buffer", hdrBuffer.mBytes);
+    hdrBuffer.mBytes = pixels * (2 * colorBytes + 4);
+    GpuMemory::get().allocate("HDR Buffer", hdrBuffer.mBytes);
   }
 
   // Bind the framebuffer object for writing.
@@ -150,6 +226,32 @@ void HDRBuffer::doPingPong() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void HDRBuffer::preserveOutside(std::array<int, 4> const& rect) {
+  auto& hdrBuffer = getCurrentHDRBuffer();
+
+  int x0 = std::clamp(rect.at(0), 0, hdrBuffer.mWidth);
+  int y0 = std::clamp(rect.at(1), 0, hdrBuffer.mHeight);
+  int x1 = std::clamp(rect.at(0) + rect.at(2), x0, hdrBuffer.mWidth);
+  int y1 = std::clamp(rect.at(1) + rect.at(3), y0, hdrBuffer.mHeight);
+
+  // The four stripes below, above, left and right of the rectangle. Empty stripes are skipped.
+  std::array<std::array<int, 4>, 4> stripes = {{{0, 0, hdrBuffer.mWidth, y0},
+      {0, y1, hdrBuffer.mWidth, hdrBuffer.mHeight}, {0, y0, x0, y1},
+      {x1, y0, hdrBuffer.mWidth, y1}}};
+
+  // The write attachment is already selected as draw buffer by bind().
+  glReadBuffer(hdrBuffer.mCompositePinpongState == 0 ? GL_COLOR_ATTACHMENT1 : GL_COLOR_ATTACHMENT0);
+
+  for (auto const& s : stripes) {
+    if (s.at(2) > s.at(0) && s.at(3) > s.at(1)) {
+      glBlitFramebuffer(s.at(0), s.at(1), s.at(2), s.at(3), s.at(0), s.at(1), s.at(2), s.at(3),
+          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void HDRBuffer::clear() {
   bind();
 
@@ -220,6 +322,32 @@ std::array<int, 2> HDRBuffer::getCurrentViewPortPos() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+uint32_t HDRBuffer::getInternalFormat(Format format) {
+  switch (format) {
+  case Format::eRGBA16F:
+    return GL_RGBA16F;
+  case Format::eR11G11B10F:
+    return GL_R11F_G11F_B10F;
+  default:
+    return GL_RGBA32F;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string HDRBuffer::getImageFormatQualifier(Format format) {
+  switch (format) {
+  case Format::eRGBA16F:
+    return "rgba16f";
+  case Format::eR11G11B10F:
+    return "r11f_g11f_b10f";
+  default:
+    return "rgba32f";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void HDRBuffer::calculateLuminance() {
   auto&         hdrBuffer = getCurrentHDRBuffer();
   VistaTexture* composite = nullptr;
@@ -252,6 +380,115 @@ float HDRBuffer::getMaximumLuminance() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void HDRBuffer::calculateExposure(glm::vec2 const& exposureRange, glm::vec2 const& percentiles,
+    float adaption, std::optional<float> const& resetExposure) {
+  auto&         hdrBuffer = getCurrentHDRBuffer();
+  VistaTexture* composite = nullptr;
+
+  if (hdrBuffer.mCompositePinpongState == 0) {
+    composite = hdrBuffer.mColorAttachments.at(0).get();
+  } else {
+    composite = hdrBuffer.mColorAttachments.at(1).get();
+  }
+
+  hdrBuffer.mExposureHistogram->update(
+      composite, exposureRange, percentiles, adaption, resetExposure);
+
+  mExposure       = hdrBuffer.mExposureHistogram->getLastExposure();
+  mMeteredAverage = hdrBuffer.mExposureHistogram->getLastAverageLuminance();
+  mMeteredMaximum = hdrBuffer.mExposureHistogram->getLastMaximumLuminance();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HDRBuffer::bindExposureBuffer(uint32_t binding) const {
+  getCurrentHDRBuffer().mExposureHistogram->bindExposureBuffer(binding);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float HDRBuffer::getExposure() const {
+  return mExposure;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float HDRBuffer::getMeteredAverageLuminance() const {
+  return mMeteredAverage;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float HDRBuffer::getMeteredMaximumLuminance() const {
+  return mMeteredMaximum;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HDRBuffer::setEnableTemporalAntiAliasing(bool enable) {
+  mEnableTemporalAntiAliasing = enable;
+
+  if (!enable) {
+    for (auto& hdrBuffer : mHDRBufferData) {
+      for (auto& temporalAntiAliasing : hdrBuffer.second.mTemporalAntiAliasing) {
+        temporalAntiAliasing.reset();
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool HDRBuffer::getEnableTemporalAntiAliasing() const {
+  return mEnableTemporalAntiAliasing;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HDRBuffer::setTemporalAntiAliasingReference(glm::dmat4 const& transform) {
+  mTemporalAntiAliasingReference = transform;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HDRBuffer::resolveTemporalAntiAliasing() {
+  if (!mEnableTemporalAntiAliasing || mMultiSamples > 0) {
+    return;
+  }
+
+  auto& hdrBuffer = getCurrentHDRBuffer();
+
+  bool rightEye = GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_eEyeRenderMode ==
+                  VistaDisplayManager::RenderInfo::ERM_RIGHT;
+  auto& temporalAntiAliasing = hdrBuffer.mTemporalAntiAliasing.at(rightEye ? 1 : 0);
+
+  if (!temporalAntiAliasing) {
+    temporalAntiAliasing =
+        std::make_unique<TemporalAntiAliasing>(hdrBuffer.mWidth, hdrBuffer.mHeight, mFormat);
+  }
+
+  std::array<GLfloat, 16> glMatV{};
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMatV.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+
+  glm::dmat4 matV = glm::make_mat4x4(glMatV.data());
+  glm::dmat4 matP = glm::make_mat4x4(glMatP.data());
+
+  VistaTexture* composite = nullptr;
+
+  if (hdrBuffer.mCompositePinpongState == 0) {
+    composite = hdrBuffer.mColorAttachments.at(0).get();
+  } else {
+    composite = hdrBuffer.mColorAttachments.at(1).get();
+  }
+
+  temporalAntiAliasing->update(
+      composite, hdrBuffer.mDepthAttachment.get(), matP * matV * mTemporalAntiAliasingReference);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void HDRBuffer::updateGlareMipMap() {
   auto&         hdrBuffer = getCurrentHDRBuffer();
   VistaTexture* composite = nullptr;
@@ -10,9 +10,13 @@
 
 #include "cs_graphics_export.hpp"
 
+#include <glm/glm.hpp>
+
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 #include <unordered_map>
 
 class VistaFramebufferObj;
@@ -24,12 +28,14 @@ namespace cs::graphics {
 
 class LuminanceMipMap;
 class GlareMipMap;
+class ExposureHistogram;
+class TemporalAntiAliasing;
 
 /// The HDRBuffer is used as render target when HDR rendering is enabled. It contains an framebuffer
 /// object for each viewport. Each framebuffer object has two color attachments containing luminance
 /// values (which can be used in a ping-pong fashion) and a depth attachment. It also contains a
-/// LuminanceMipMap to compute the average brightness for auto-exposure and a GlareMipMap for a
-/// glare-effect.
+/// LuminanceMipMap to compute the average brightness for auto-exposure, an ExposureHistogram which
+/// computes the auto-exposure entirely on the GPU and a GlareMipMap for a glare-effect.
 class CS_GRAPHICS_EXPORT HDRBuffer {
  public:
   /// There are different possibilities for computing the glare. The simplest being a symmetrical
@@ -37,6 +43,11 @@ class CS_GRAPHICS_EXPORT HDRBuffer {
   /// addition, the glare quality must be set to a higher value to get acceptable results.
   enum class GlareMode { eSymmetricGauss, eAsymmetricGauss };
 
+  /// The format of the color attachments. The reduced-precision formats save a lot of memory
+  /// bandwidth in all passes which read the HDRBuffer. eR11G11B10F has no alpha channel, so nothing
+  /// may rely on the destination alpha when this is used.
+  enum class Format { eRGBA32F, eRGBA16F, eR11G11B10F };
+
   /// When highPrecision is set to false, only 16bit color buffers are used.
   explicit HDRBuffer(uint32_t multiSamples, bool highPrecision = true);
 
@@ -53,6 +64,22 @@ class CS_GRAPHICS_EXPORT HDRBuffer {
   /// further below.
   uint32_t getMultiSamples() const;
 
+  /// The format of the color attachments. The attachments of each viewport are re-created the next
+  /// time bind() is called.
+  void   setFormat(Format format);
+  Format getFormat() const;
+
+  /// The size of the attachments relative to the viewport size in the range (0, 1]. The
+  /// ToneMappingNode upscales the result to the viewport. As the attachments are re-created
+  /// whenever this changes, it should not be changed every frame.
+  void  setResolutionScale(float scale);
+  float getResolutionScale() const;
+
+  /// Returns the size of the attachments of the currently rendered viewport. This is the viewport
+  /// size multiplied by the resolution scale. This is only valid once bind() has been called for
+  /// the current viewport.
+  std::array<int, 2> getCurrentSize() const;
+
   /// Binds DEPTH and one ping-pong target for writing.
   void bind();
 
@@ -62,6 +89,13 @@ class CS_GRAPHICS_EXPORT HDRBuffer {
   /// Subsequent calls to bind() will use the ping-pong targets the other way around.
   void doPingPong();
 
+  /// Copies everything outside the given rectangle from the current read attachment to the current
+  /// write attachment. The rectangle is given as x, y, width and height in pixels of the HDRBuffer.
+  /// Drawables which call doPingPong() but only draw to a part of the write attachment, for example
+  /// by using a scissor rectangle, have to call this after bind() so that the rest of the image is
+  /// preserved.
+  void preserveOutside(std::array<int, 4> const& rect);
+
   /// Clears all attachments, that is DEPTH to 1.0, and HDR_0 and HDR_1 to vec3(0).
   void clear();
 
@@ -76,6 +110,39 @@ class CS_GRAPHICS_EXPORT HDRBuffer {
   float getTotalLuminance() const;
   float getMaximumLuminance() const;
 
+  /// Meters the current viewport with its ExposureHistogram and adapts its exposure. The exposure
+  /// is given in EV and stays on the GPU, use bindExposureBuffer() to access it in a shader. See
+  /// ExposureHistogram::update() for a description of the parameters.
+  void calculateExposure(glm::vec2 const& exposureRange, glm::vec2 const& percentiles,
+      float adaption, std::optional<float> const& resetExposure = std::nullopt);
+
+  /// Binds the exposure buffer of the current viewport to the given shader storage buffer binding
+  /// point. The first float of the buffer is the exposure in EV.
+  void bindExposureBuffer(uint32_t binding) const;
+
+  /// Get the most recent results of calculateExposure() which are visible to the CPU. These may be
+  /// a few frames old and should only be used for displaying them in the user interface.
+  float getExposure() const;
+  float getMeteredAverageLuminance() const;
+  float getMeteredMaximumLuminance() const;
+
+  /// If enabled, resolveTemporalAntiAliasing() blends the composite of each viewport with the
+  /// anti-aliased images of the previous frames. This has no effect if the HDRBuffer uses
+  /// multi-sampling. Disabling this releases the history buffers.
+  void setEnableTemporalAntiAliasing(bool enable);
+  bool getEnableTemporalAntiAliasing() const;
+
+  /// The points of the scene are assumed to be static in the reference frame given by this
+  /// transformation when they are reprojected into the previous frame. It should be set once a
+  /// frame to the observer-relative transformation of the object the observer is moving around.
+  void setTemporalAntiAliasingReference(glm::dmat4 const& transform);
+
+  /// Blends the current composite with the history of the current viewport and eye. This uses the
+  /// current OpenGL projection and modelview matrices for reprojection, so the projection must be
+  /// jittered each frame, see TemporalAntiAliasing::getJitter(). This should be called after all
+  /// opaque objects have been drawn and does nothing if temporal anti-aliasing is disabled.
+  void resolveTemporalAntiAliasing();
+
   /// Update and access the GlareMipMap.
   void          updateGlareMipMap();
   VistaTexture* getGlareMipMap() const;
@@ -107,6 +174,11 @@ class CS_GRAPHICS_EXPORT HDRBuffer {
   static std::array<int, 2> getCurrentViewPortSize();
   static std::array<int, 2> getCurrentViewPortPos();
 
+  /// Returns the OpenGL internal format and the GLSL image format qualifier of the given format.
+  /// These are used by the LuminanceMipMap and the GlareMipMap to access the color attachments.
+  static uint32_t    getInternalFormat(Format format);
+  static std::string getImageFormatQualifier(Format format);
+
  private:
   // There is one of these structs for each viewport. That means, we have a separate framebuffer
   // object, GlareMipMap and LuminanceMipMap for each viewport. This is mainly because viewports
@@ -116,14 +188,22 @@ class CS_GRAPHICS_EXPORT HDRBuffer {
     std::array<std::unique_ptr<VistaTexture>, 2> mColorAttachments;
     std::unique_ptr<VistaTexture>                mDepthAttachment;
     std::unique_ptr<LuminanceMipMap>             mLuminanceMipMap;
+    std::unique_ptr<ExposureHistogram>           mExposureHistogram;
     std::unique_ptr<GlareMipMap>                 mGlareMipMap;
 
+    // The temporal anti-aliasing is created on demand. There is one for each eye.
+    std::array<std::unique_ptr<TemporalAntiAliasing>, 2> mTemporalAntiAliasing;
+
     // Stores the original viewport position and size.
     std::array<int, 4> mCachedViewport{};
     int                mWidth                 = 0;
     int                mHeight                = 0;
+    Format             mFormat                = Format::eRGBA32F;
     int                mCompositePinpongState = 0;
     bool               mIsBound               = false;
+
+    // The size of the attachments as reported to the GpuMemory.
+    std::size_t mBytes = 0;
   };
 
   // Helper methods to retrieve the current HDRBufferData struct based on the viewport we are
@@ -136,9 +216,16 @@ class CS_GRAPHICS_EXPORT HDRBuffer {
   std::unordered_map<VistaViewport*, HDRBufferData> mHDRBufferData;
   float                                             mTotalLuminance   = 1.F;
   float                                             mMaximumLuminance = 1.F;
+  float                                             mExposure         = 0.F;
+  float                                             mMeteredAverage   = 1.F;
+  float                                             mMeteredMaximum   = 1.F;
+  float                                             mResolutionScale  = 1.F;
+
+  bool       mEnableTemporalAntiAliasing = false;
+  glm::dmat4 mTemporalAntiAliasingReference{1.0};
 
   const uint32_t mMultiSamples;
-  const bool     mHighPrecision;
+  Format         mFormat;
 };
 
 } // namespace cs::graphics
@@ -19,120 +19,160 @@ namespace cs::graphics {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Each work group reduces a tile of this many pixels in both directions. Each invocation reads
+// 2x2 pixels.
+int const TILE_SIZE = 32;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 static const char* sComputeAverage = R"(
   layout (local_size_x = 16, local_size_y = 16) in;
 
   #if NUM_MULTISAMPLES > 0
-    layout (rgba32f, binding = 0) readonly uniform image2DMS uInHDRBuffer;
+    layout (HDR_BUFFER_FORMAT, binding = 0) readonly uniform image2DMS uInHDRBuffer;
   #else
-    layout (rgba32f, binding = 0) readonly uniform image2D uInHDRBuffer;
+    layout (HDR_BUFFER_FORMAT, binding = 0) readonly uniform image2D uInHDRBuffer;
   #endif
 
-  layout (rg32f, binding = 1) readonly uniform image2D uInLuminance;
-  layout (rg32f, binding = 2) writeonly uniform image2D uOutLuminance;
+  // The total and maximum luminance of each work group. The last work group to finish reduces
+  // these to the final result.
+  layout (std430, binding = 0) coherent buffer Partials {
+    uint uFinishedGroups;
+    vec2 uPartials[];
+  };
+
+  layout (std430, binding = 1) writeonly buffer Results {
+    vec2 uResults[];
+  };
 
-  uniform int uLevel;
+  uniform int uSlot;
+
+  shared vec2 sLuminance[256];
+  shared bool sIsLastGroup;
+
+  void sampleHDRBuffer(inout vec2 totalMax, ivec2 pos) {
+    if (any(greaterThanEqual(pos, imageSize(uInHDRBuffer)))) {
+      return;
+    }
 
-  void sampleHDRBuffer(inout float oMaximumLuminance, inout float oTotalLuminance, ivec2 offset) {
     #if NUM_MULTISAMPLES > 0
       vec3 color = vec3(0.0);
       for (int i = 0; i < NUM_MULTISAMPLES; ++i) {
-        color += imageLoad(uInHDRBuffer, ivec2(gl_GlobalInvocationID.xy*2 + offset), i).rgb;
+        color += imageLoad(uInHDRBuffer, pos, i).rgb;
       }
       color /= NUM_MULTISAMPLES;
     #else
-      vec3 color = imageLoad(uInHDRBuffer, ivec2(gl_GlobalInvocationID.xy*2 + offset)).rgb;
+      vec3 color = imageLoad(uInHDRBuffer, pos).rgb;
     #endif
 
     float val = max(max(color.r, color.g), color.b);
-    oTotalLuminance += val;
-    oMaximumLuminance = max(oMaximumLuminance, val);
+    totalMax.x += val;
+    totalMax.y = max(totalMax.y, val);
   }
 
-  void samplePyramid(inout float oMaximumLuminance, inout float oTotalLuminance, ivec2 offset) {
-    vec2 totalMax = imageLoad(uInLuminance, ivec2(gl_GlobalInvocationID.xy*2 + offset)).rg;
-    oTotalLuminance += totalMax.r;
-    oMaximumLuminance = max(oMaximumLuminance, totalMax.g);
+  // Reduces the values of all invocations in sLuminance to sLuminance[0].
+  void reduceSharedMemory(uint index, vec2 totalMax) {
+    sLuminance[index] = totalMax;
+
+    for (uint stride = 128; stride > 0; stride >>= 1) {
+      memoryBarrierShared();
+      barrier();
+
+      if (index < stride) {
+        vec2 other = sLuminance[index + stride];
+        sLuminance[index] = vec2(sLuminance[index].x + other.x, max(sLuminance[index].y, other.y));
+      }
+    }
+
+    memoryBarrierShared();
+    barrier();
   }
 
   void main() {
-    ivec2 storePos = ivec2(gl_GlobalInvocationID.xy);
-    ivec2 size     = imageSize(uOutLuminance);
+    uint  index = gl_LocalInvocationIndex;
+    ivec2 pos   = ivec2(gl_GlobalInvocationID.xy) * 2;
 
-    if (storePos.x >= size.x || storePos.y >= size.y) {
-      return;
+    vec2 totalMax = vec2(0.0);
+    sampleHDRBuffer(totalMax, pos);
+    sampleHDRBuffer(totalMax, pos + ivec2(0, 1));
+    sampleHDRBuffer(totalMax, pos + ivec2(1, 0));
+    sampleHDRBuffer(totalMax, pos + ivec2(1, 1));
+
+    reduceSharedMemory(index, totalMax);
+
+    uint numGroups = gl_NumWorkGroups.x * gl_NumWorkGroups.y;
+
+    // Store the result of this work group and check whether all other work groups have finished.
+    if (index == 0) {
+      uPartials[gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x] = sLuminance[0];
+      memoryBarrierBuffer();
+      sIsLastGroup = atomicAdd(uFinishedGroups, 1) == numGroups - 1;
     }
 
-    float oTotalLuminance = 0;
-    float oMaximumLuminance = 0;
-    
-    if (uLevel == 0) {
-      sampleHDRBuffer(oMaximumLuminance, oTotalLuminance, ivec2(0, 0));
-      sampleHDRBuffer(oMaximumLuminance, oTotalLuminance, ivec2(0, 1));
-      sampleHDRBuffer(oMaximumLuminance, oTotalLuminance, ivec2(1, 0));
-      sampleHDRBuffer(oMaximumLuminance, oTotalLuminance, ivec2(1, 1));
-    } else {
-      samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(0, 0));
-      samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(0, 1));
-      samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(1, 0));
-      samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(1, 1));
-
-      // handle cases close to right and top edge
-      ivec2 maxCoords = imageSize(uInLuminance) - ivec2(1);
-      if (gl_GlobalInvocationID.x*2 == maxCoords.x - 2) {
-        samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(2,0));
-        samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(2,1));
-      }
+    memoryBarrierShared();
+    barrier();
 
-      if (gl_GlobalInvocationID.y*2 == maxCoords.y - 2) {
-        samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(0,2));
-        samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(1,2));
+    if (!sIsLastGroup) {
+      return;
+    }
 
-        if (gl_GlobalInvocationID.x*2 == maxCoords.x - 2) {
-          samplePyramid(oMaximumLuminance, oTotalLuminance, ivec2(2,2));
-        }
-      }
+    // The last work group reduces the results of all work groups.
+    totalMax = vec2(0.0);
+    for (uint i = index; i < numGroups; i += 256) {
+      vec2 partial = uPartials[i];
+      totalMax     = vec2(totalMax.x + partial.x, max(totalMax.y, partial.y));
     }
 
-    imageStore(uOutLuminance, storePos, vec4(oTotalLuminance, oMaximumLuminance, 0.0, 0.0));
+    reduceSharedMemory(index, totalMax);
+
+    if (index == 0) {
+      uResults[uSlot]  = sLuminance[0];
+      uFinishedGroups = 0;
+    }
   }
 )";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-LuminanceMipMap::LuminanceMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight)
-    : VistaTexture(GL_TEXTURE_2D)
-    , mHDRBufferSamples(hdrBufferSamples)
+LuminanceMipMap::LuminanceMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth,
+    int hdrBufferHeight, HDRBuffer::Format hdrBufferFormat)
+    : mHDRBufferSamples(hdrBufferSamples)
     , mHDRBufferWidth(hdrBufferWidth)
-    , mHDRBufferHeight(hdrBufferHeight) {
-
-  // Create luminance mipmap storage. The texture has half the size of the HDR buffer (rounded down)
-  // in both directions.
-  int iWidth  = mHDRBufferWidth / 2;
-  int iHeight = mHDRBufferHeight / 2;
-
-  // Compute the number of available mipmap levels.
-  mMaxLevels =
-      static_cast<int>(std::max(1.0, std::floor(std::log2(std::max(iWidth, iHeight))) + 1));
-
-  Bind();
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-  glTexStorage2D(GL_TEXTURE_2D, mMaxLevels, GL_RG32F, iWidth, iHeight);
-
-  // Create pixel buffer object for luminance read-back.
-  glGenBuffers(1, &mPBO);
-  glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBO);
-  glBufferStorage(GL_PIXEL_PACK_BUFFER, sizeof(float) * 2, nullptr, GL_MAP_READ_BIT);
-  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    , mHDRBufferHeight(hdrBufferHeight)
+    , mHDRBufferFormat(hdrBufferFormat) {
+
+  // Create the buffer for the results of the individual work groups. It starts with the counter of
+  // finished work groups which is padded to the alignment of a vec2.
+  auto numGroups = static_cast<std::size_t>((mHDRBufferWidth + TILE_SIZE - 1) / TILE_SIZE) *
+                   static_cast<std::size_t>((mHDRBufferHeight + TILE_SIZE - 1) / TILE_SIZE);
+  std::vector<float> zeros(2 + 2 * numGroups, 0.F);
+
+  glGenBuffers(1, &mPartialsBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mPartialsBuffer);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(sizeof(float) * zeros.size()),
+      zeros.data(), 0);
+
+  // Create the persistently mapped buffer for luminance read-back. It contains the total and the
+  // maximum luminance for each slot.
+  GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glGenBuffers(1, &mResultsBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mResultsBuffer);
+  glBufferStorage(
+      GL_SHADER_STORAGE_BUFFER, sizeof(float) * 2 * sReadbackLatency, zeros.data(), flags);
+  mResults = static_cast<float*>(glMapBufferRange(
+      GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * 2 * sReadbackLatency, flags));
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
   // Create the compute shader.
   auto        shader = glCreateShader(GL_COMPUTE_SHADER);
   std::string source = "#version 430\n";
   source += "#define NUM_MULTISAMPLES " + std::to_string(mHDRBufferSamples) + "\n";
+  source += "#define HDR_BUFFER_FORMAT " + HDRBuffer::getImageFormatQualifier(mHDRBufferFormat) +
+            "\n";
   source += sComputeAverage;
   const char* pSource = source.c_str();
   glShaderSource(shader, 1, &pSource, nullptr);
@@ -166,13 +206,24 @@ LuminanceMipMap::LuminanceMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth,
     throw std::runtime_error(std::string("ERROR: Failed to link compute shader\n") + log);
   }
 
-  mUniforms.level = glGetUniformLocation(mComputeProgram, "uLevel");
+  mUniforms.slot = glGetUniformLocation(mComputeProgram, "uSlot");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 LuminanceMipMap::~LuminanceMipMap() {
-  glDeleteBuffers(1, &mPBO);
+  for (auto& fence : mFences) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mResultsBuffer);
+  glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  glDeleteBuffers(1, &mPartialsBuffer);
+  glDeleteBuffers(1, &mResultsBuffer);
   glDeleteProgram(mComputeProgram);
 }
 
@@ -182,15 +233,21 @@ void LuminanceMipMap::update(VistaTexture* hdrBufferComposite) {
 
   utils::FrameStats::ScopedTimer timer("Compute Scene Luminance");
 
-  // Read the luminance values from the last frame. ------------------------------------------------
-  glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBO);
+  // Read the luminance values of all finished computations. ---------------------------------------
+  // The fences are polled without waiting, so this never stalls.
+  while (mFences.at(mOldestSlot)) {
+    auto status = glClientWaitSync(mFences.at(mOldestSlot), 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      break;
+    }
+
+    glDeleteSync(mFences.at(mOldestSlot));
+    mFences.at(mOldestSlot) = nullptr;
 
-  // Map the pixel buffer object and read the two values.
-  if (mDataAvailable) {
-    auto* data            = static_cast<float*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
-    mLastTotalLuminance   = data[0]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    mLastMaximumLuminance = data[1]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    mLastTotalLuminance = mResults[2 * mOldestSlot];
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    mLastMaximumLuminance = mResults[2 * mOldestSlot + 1];
 
     if (std::isnan(mLastTotalLuminance)) {
       mLastTotalLuminance = 0.0;
@@ -199,46 +256,42 @@ void LuminanceMipMap::update(VistaTexture* hdrBufferComposite) {
     if (std::isnan(mLastMaximumLuminance)) {
       mLastMaximumLuminance = 0.0;
     }
-  }
-
-  // Update current luminance mipmap. --------------------------------------------------------------
-
-  glUseProgram(mComputeProgram);
-
-  glBindImageTexture(0, hdrBufferComposite->GetId(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-
-  // We loop through all levels always reading from the last level.
-  for (int i(0); i < mMaxLevels; ++i) {
-    int width  = static_cast<int>(std::max(1.0,
-        std::floor(static_cast<double>(static_cast<int>(mHDRBufferWidth / 2)) / std::pow(2, i))));
-    int height = static_cast<int>(std::max(1.0,
-        std::floor(static_cast<double>(static_cast<int>(mHDRBufferHeight / 2)) / std::pow(2, i))));
 
-    glUniform1i(mUniforms.level, i);
-    glBindImageTexture(2, GetId(), i, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
-
-    // For the first level, hdrBufferComposite will be used for reading, all other levels use the
-    // previous level as input.
-    if (i > 0) {
-      glBindImageTexture(1, GetId(), i - 1, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
-    }
-
-    // Make sure writing has finished.
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-    glDispatchCompute(static_cast<uint32_t>(std::ceil(1.0 * width / 16)),
-        static_cast<uint32_t>(std::ceil(1.0 * height / 16)), 1);
+    mDataAvailable = true;
+    mOldestSlot    = (mOldestSlot + 1) % sReadbackLatency;
   }
 
-  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
-  glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT);
+  // If all slots are still in flight, the GPU is far behind. We skip this frame's computation
+  // instead of waiting.
+  if (mFences.at(mNextSlot)) {
+    return;
+  }
 
-  // Copy the top mipmap level to the PBO for readback in the next frame.
-  Bind();
-  glGetTexImage(GL_TEXTURE_2D, mMaxLevels - 1, GL_RG, GL_FLOAT, nullptr);
-  Unbind();
-  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  // Compute the current luminance. ----------------------------------------------------------------
 
-  mDataAvailable = true;
+  glUseProgram(mComputeProgram);
+  glUniform1i(mUniforms.slot, static_cast<int>(mNextSlot));
+
+  glBindImageTexture(0, hdrBufferComposite->GetId(), 0, GL_FALSE, 0, GL_READ_ONLY,
+      HDRBuffer::getInternalFormat(mHDRBufferFormat));
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mPartialsBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mResultsBuffer);
+
+  // Make sure that the previous computation has finished writing the partial results.
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+  glDispatchCompute(static_cast<uint32_t>((mHDRBufferWidth + TILE_SIZE - 1) / TILE_SIZE),
+      static_cast<uint32_t>((mHDRBufferHeight + TILE_SIZE - 1) / TILE_SIZE), 1);
+
+  // The results are read through the persistent mapping, so they have to be made visible to the
+  // client before the fence is signaled.
+  glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+  mFences.at(mNextSlot) = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  mNextSlot             = (mNextSlot + 1) % sReadbackLatency;
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+  glUseProgram(0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,17 +11,23 @@
 #include "HDRBuffer.hpp"
 
 #include <VistaOGLExt/VistaTexture.h>
-#include <memory>
+#include <array>
 
 namespace cs::graphics {
 
-/// The LuminanceMipMap is a texture with full mipmap levels which are used to calculate the total
-/// and maximum luminance of the current scene by parallel reduction. It's a 32bit RG texture of
-/// half the given width and height.
-class CS_GRAPHICS_EXPORT LuminanceMipMap : public VistaTexture {
+/// The LuminanceMipMap calculates the total and maximum luminance of the current scene by parallel
+/// reduction. Despite its name, it does not use a mipmap anymore: A single compute dispatch reduces
+/// the HDR buffer in shared memory per work group and the last work group which finishes reduces
+/// the results of all work groups. An atomic counter is used to detect this last work group.
+///
+/// The results are written to a persistently mapped buffer with several slots. They are read back
+/// once a fence signals that the GPU has finished the computation, so the CPU never waits for the
+/// GPU.
+class CS_GRAPHICS_EXPORT LuminanceMipMap {
  public:
-  LuminanceMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight);
-  ~LuminanceMipMap() override;
+  LuminanceMipMap(uint32_t hdrBufferSamples, int hdrBufferWidth, int hdrBufferHeight,
+      HDRBuffer::Format hdrBufferFormat = HDRBuffer::Format::eRGBA32F);
+  ~LuminanceMipMap();
 
   LuminanceMipMap(LuminanceMipMap const& other) = delete;
   LuminanceMipMap(LuminanceMipMap&& other)      = delete;
@@ -29,34 +35,44 @@ class CS_GRAPHICS_EXPORT LuminanceMipMap : public VistaTexture {
   LuminanceMipMap& operator=(LuminanceMipMap const& other) = delete;
   LuminanceMipMap& operator=(LuminanceMipMap&& other) = delete;
 
-  /// Perform the parallel reduction of luminance values. This is a costly operation and should only
-  /// be called once a frame.
+  /// Perform the parallel reduction of luminance values. This should only be called once a frame.
+  /// If the GPU is more than sReadbackLatency frames behind, the computation is skipped.
   void update(VistaTexture* hdrBufferComposite);
 
-  /// Returns true once data has been retrieved from the GPU. This will be one frame after the first
-  /// call to update().
+  /// Returns true once data has been retrieved from the GPU. This will usually be one frame after
+  /// the first call to update().
   bool getIsDataAvailable() const;
 
-  /// Get the results of the last but one call to update(). The data is read back from the GPU one
-  /// frame after the computation in order to reduce synchronization requirements. In order to get
-  /// the average luminance, you have to divide getLastTotalLuminance() by (hdrBufferWidth *
-  /// hdrBufferHeight).
+  /// Get the most recent results which have been read back from the GPU. These are usually one to
+  /// sReadbackLatency frames old. In order to get the average luminance, you have to divide
+  /// getLastTotalLuminance() by (hdrBufferWidth * hdrBufferHeight).
   float getLastTotalLuminance() const;
   float getLastMaximumLuminance() const;
 
+  /// The number of computations which may be in flight at the same time.
+  static constexpr std::size_t sReadbackLatency = 3;
+
  private:
-  GLuint   mPBO                  = 0;
+  GLuint   mPartialsBuffer       = 0;
+  GLuint   mResultsBuffer        = 0;
+  float*   mResults              = nullptr;
   GLuint   mComputeProgram       = 0;
   uint32_t mHDRBufferSamples     = 0;
   float    mLastTotalLuminance   = 0.F;
   float    mLastMaximumLuminance = 0.F;
-  int      mMaxLevels            = 0;
   int      mHDRBufferWidth       = 0;
   int      mHDRBufferHeight      = 0;
   bool     mDataAvailable        = false;
 
+  HDRBuffer::Format mHDRBufferFormat;
+
+  // One fence for each slot of the results buffer. A slot is in flight if its fence is not null.
+  std::array<GLsync, sReadbackLatency> mFences{};
+  std::size_t                          mNextSlot   = 0;
+  std::size_t                          mOldestSlot = 0;
+
   struct {
-    uint32_t level = 0;
+    uint32_t slot = 0;
   } mUniforms;
 };
 
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "ObjectTransformBuffer.hpp"
+
+#include <algorithm>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ObjectTransformBuffer::ObjectTransformBuffer() {
+  glGenBuffers(1, &mBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ObjectTransformBuffer::~ObjectTransformBuffer() {
+  glDeleteBuffers(1, &mBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ObjectTransformBuffer::upload(std::vector<glm::mat4> const& transforms) {
+  mSize = transforms.size();
+
+  // The storage only grows, so that adding a few objects does not reallocate it each time.
+  mCapacity = std::max(mCapacity, mSize);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(sizeof(glm::mat4) * mCapacity),
+      nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+      static_cast<GLsizeiptr>(sizeof(glm::mat4) * mSize), transforms.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ObjectTransformBuffer::bind(uint32_t binding) const {
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ObjectTransformBuffer::getSize() const {
+  return mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
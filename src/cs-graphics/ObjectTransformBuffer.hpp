@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_OBJECT_TRANSFORM_BUFFER_HPP
+#define CS_GRAPHICS_OBJECT_TRANSFORM_BUFFER_HPP
+
+#include "cs_graphics_export.hpp"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace cs::graphics {
+
+/// A shader storage buffer which contains single-precision transformation matrices. The
+/// SolarSystem uses this to upload the observer-relative transformations of all celestial objects
+/// once each frame, so that drawables can read them in their shaders instead of uploading them as
+/// uniforms. In GLSL, the buffer can be declared like this:
+///
+/// layout(std430, binding = 0) readonly buffer ObjectTransforms {
+///   mat4 uObjectTransforms[];
+/// };
+class CS_GRAPHICS_EXPORT ObjectTransformBuffer {
+ public:
+  ObjectTransformBuffer();
+  ~ObjectTransformBuffer();
+
+  ObjectTransformBuffer(ObjectTransformBuffer const& other) = delete;
+  ObjectTransformBuffer(ObjectTransformBuffer&& other)      = delete;
+
+  ObjectTransformBuffer& operator=(ObjectTransformBuffer const& other) = delete;
+  ObjectTransformBuffer& operator=(ObjectTransformBuffer&& other) = delete;
+
+  /// Replaces the contents of the buffer. The previous storage is orphaned, so this does not wait
+  /// for draw calls which still read the old matrices.
+  void upload(std::vector<glm::mat4> const& transforms);
+
+  /// Binds the buffer to the given shader storage buffer binding point.
+  void bind(uint32_t binding) const;
+
+  /// The number of matrices which have been uploaded last.
+  std::size_t getSize() const;
+
+ private:
+  GLuint      mBuffer   = 0;
+  std::size_t mSize     = 0;
+  std::size_t mCapacity = 0;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_OBJECT_TRANSFORM_BUFFER_HPP
@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "ShaderCache.hpp"
+
+#include "../cs-utils/filesystem.hpp"
+#include "logger.hpp"
+
+#include <GL/glew.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ShaderCache& ShaderCache::get() {
+  static ShaderCache instance;
+  return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ShaderCache::ShaderCache() {
+  GLint numFormats = 0;
+  if (GLEW_ARB_get_program_binary) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  }
+  mSupportsBinaries = numFormats > 0;
+
+  // The binaries are only valid for the driver which created them.
+  for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    auto const* value = glGetString(name);
+    if (value) {
+      mDriverId += reinterpret_cast<char const*>(value);
+    }
+  }
+
+  // Let the driver decide how many threads it uses for compiling and linking.
+  if (GLEW_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ShaderCache::setBinaryDirectory(std::string const& directory) {
+  mBinaryDirectory = directory;
+
+  if (mBinaryDirectory.empty()) {
+    return;
+  }
+
+  if (!mSupportsBinaries) {
+    logger().warn("Shader binaries will not be stored in '{}': The OpenGL driver does not support "
+                  "program binaries!",
+        mBinaryDirectory);
+    return;
+  }
+
+  try {
+    if (!boost::filesystem::exists(mBinaryDirectory)) {
+      utils::filesystem::createDirectoryRecursively(mBinaryDirectory);
+    }
+  } catch (std::exception const& e) {
+    logger().warn("Shader binaries will not be stored: Failed to create directory '{}': {}",
+        mBinaryDirectory, e.what());
+    mBinaryDirectory.clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& ShaderCache::getBinaryDirectory() const {
+  return mBinaryDirectory;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<VistaGLSLShader> ShaderCache::getShader(
+    std::string const& vertexSource, std::string const& fragmentSource) {
+  return getShaderImpl(vertexSource, "", fragmentSource);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<VistaGLSLShader> ShaderCache::getShader(std::string const& vertexSource,
+    std::string const& geometrySource, std::string const& fragmentSource) {
+  return getShaderImpl(vertexSource, geometrySource, fragmentSource);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ShaderCache::clear() {
+  mShaders.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<VistaGLSLShader> ShaderCache::getShaderImpl(std::string const& vertexSource,
+    std::string const& geometrySource, std::string const& fragmentSource) {
+
+  // The stages are separated by a character which cannot occur in GLSL code, so that moving code
+  // from one stage to another results in a different key.
+  std::size_t hash =
+      std::hash<std::string>{}(vertexSource + '\0' + geometrySource + '\0' + fragmentSource);
+
+  auto it = mShaders.find(hash);
+  if (it != mShaders.end()) {
+    return it->second;
+  }
+
+  auto shader = std::make_shared<VistaGLSLShader>();
+  shader->InitVertexShaderFromString(vertexSource);
+  if (!geometrySource.empty()) {
+    shader->InitGeometryShaderFromString(geometrySource);
+  }
+  shader->InitFragmentShaderFromString(fragmentSource);
+
+  // VistaGLSLShader compiles the stages when they are attached, so a stored binary only saves the
+  // linking. On most drivers, this is the most expensive part.
+  if (!loadBinary(*shader, hash)) {
+    if (mSupportsBinaries && !mBinaryDirectory.empty() && shader->GetProgram() != 0) {
+      glProgramParameteri(shader->GetProgram(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    shader->Link();
+    storeBinary(*shader, hash);
+  }
+
+  mShaders.emplace(hash, shader);
+
+  return shader;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ShaderCache::loadBinary(VistaGLSLShader& shader, std::size_t hash) const {
+  if (!mSupportsBinaries || mBinaryDirectory.empty() || shader.GetProgram() == 0) {
+    return false;
+  }
+
+  std::ifstream file(getBinaryFile(hash), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  GLenum format = 0;
+  if (!file.read(reinterpret_cast<char*>(&format), sizeof(format))) {
+    return false;
+  }
+
+  std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  if (data.empty()) {
+    return false;
+  }
+
+  glProgramBinary(shader.GetProgram(), format, data.data(), static_cast<GLsizei>(data.size()));
+
+  // The driver rejects binaries of other driver versions, in this case the program is linked from
+  // the attached stages.
+  GLint success = GL_FALSE;
+  glGetProgramiv(shader.GetProgram(), GL_LINK_STATUS, &success);
+
+  if (success != GL_TRUE) {
+    logger().debug("Ignoring outdated shader binary '{}'.", getBinaryFile(hash));
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ShaderCache::storeBinary(VistaGLSLShader& shader, std::size_t hash) const {
+  if (!mSupportsBinaries || mBinaryDirectory.empty() || shader.GetProgram() == 0) {
+    return;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(shader.GetProgram(), GL_PROGRAM_BINARY_LENGTH, &length);
+
+  if (length <= 0) {
+    return;
+  }
+
+  GLenum            format = 0;
+  std::vector<char> data(static_cast<std::size_t>(length));
+  glGetProgramBinary(shader.GetProgram(), length, nullptr, &format, data.data());
+
+  std::ofstream file(getBinaryFile(hash), std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<char const*>(&format), sizeof(format));
+  file.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+  if (!file) {
+    logger().warn("Failed to store shader binary '{}'!", getBinaryFile(hash));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string ShaderCache::getBinaryFile(std::size_t hash) const {
+  std::size_t fileHash = std::hash<std::string>{}(std::to_string(hash) + mDriverId);
+  return mBinaryDirectory + "/" + std::to_string(fileHash) + ".bin";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
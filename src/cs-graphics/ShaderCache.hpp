@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_SHADER_CACHE_HPP
+#define CS_GRAPHICS_SHADER_CACHE_HPP
+
+#include "cs_graphics_export.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class VistaGLSLShader;
+
+namespace cs::graphics {
+
+/// This is a singleton class which keeps all linked shader programs of the main thread. Many
+/// shaders are assembled at runtime by prepending #defines to their sources, so toggling a setting
+/// like HDR rendering or lighting requires a different program. With this cache, each distinct
+/// combination of sources is compiled only once, switching back to a previously used variant is
+/// free.
+///
+/// If a binary directory is set, linked programs are additionally stored there with
+/// glGetProgramBinary() and loaded with glProgramBinary() when the same sources are requested in a
+/// later session. The binaries are specific to the OpenGL renderer and driver version, so these
+/// are part of the file names. If the driver rejects a binary, the program is compiled from source.
+///
+/// If GL_KHR_parallel_shader_compile is available, the driver is allowed to use multiple threads
+/// for compiling and linking.
+class CS_GRAPHICS_EXPORT ShaderCache {
+ public:
+  static ShaderCache& get();
+
+  ShaderCache(ShaderCache const& other) = delete;
+  ShaderCache(ShaderCache&& other)      = delete;
+
+  ShaderCache& operator=(ShaderCache const& other) = delete;
+  ShaderCache& operator=(ShaderCache&& other)      = delete;
+
+  ~ShaderCache() = default;
+
+  /// Linked programs are stored in and loaded from this directory. It is created if it does not
+  /// exist. An empty string disables the persistence, this is the default.
+  void               setBinaryDirectory(std::string const& directory);
+  std::string const& getBinaryDirectory() const;
+
+  /// Returns a linked program for the given sources. If a program for exactly these sources has
+  /// been requested before, the same instance is returned. The returned shader must not be
+  /// re-initialized by the caller.
+  std::shared_ptr<VistaGLSLShader> getShader(
+      std::string const& vertexSource, std::string const& fragmentSource);
+
+  /// Like above, with an additional geometry shader.
+  std::shared_ptr<VistaGLSLShader> getShader(std::string const& vertexSource,
+      std::string const& geometrySource, std::string const& fragmentSource);
+
+  /// Removes all programs from the in-memory cache. Programs which are still in use stay valid.
+  /// The binaries on disk are not removed.
+  void clear();
+
+ private:
+  ShaderCache();
+
+  std::shared_ptr<VistaGLSLShader> getShaderImpl(std::string const& vertexSource,
+      std::string const& geometrySource, std::string const& fragmentSource);
+
+  bool loadBinary(VistaGLSLShader& shader, std::size_t hash) const;
+  void storeBinary(VistaGLSLShader& shader, std::size_t hash) const;
+
+  std::string getBinaryFile(std::size_t hash) const;
+
+  std::unordered_map<std::size_t, std::shared_ptr<VistaGLSLShader>> mShaders;
+
+  std::string mBinaryDirectory;
+  std::string mDriverId;
+  bool        mSupportsBinaries = false;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_SHADER_CACHE_HPP
@@ -8,11 +8,12 @@
 #include "Shadows.hpp"
 
 #include "../cs-utils/FrameStats.hpp"
+#include "GpuMemory.hpp"
 #include "logger.hpp"
 
+#include <GL/glew.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
-#include <VistaOGLExt/VistaFramebufferObj.h>
-#include <VistaOGLExt/VistaTexture.h>
+#include <algorithm>
 #include <array>
 
 namespace cs::graphics {
@@ -31,6 +32,18 @@ ShadowMap* ShadowCaster::getShadowMap() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool ShadowCaster::getIsShadowDirty() const {
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ShadowCaster::getSupportsLayeredRendering() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 ShadowMap::~ShadowMap() {
   cleanUp();
 }
@@ -40,6 +53,7 @@ ShadowMap::~ShadowMap() {
 void ShadowMap::registerCaster(ShadowCaster* caster) {
   caster->setShadowMap(this);
   mShadowCasters.insert(caster);
+  mCascadesDirty.assign(mCascadesDirty.size(), true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -47,6 +61,7 @@ void ShadowMap::registerCaster(ShadowCaster* caster) {
 void ShadowMap::deregisterCaster(ShadowCaster* caster) {
   caster->setShadowMap(nullptr);
   mShadowCasters.erase(caster);
+  mCascadesDirty.assign(mCascadesDirty.size(), true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -151,8 +166,33 @@ bool ShadowMap::getFreezeCascades() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void ShadowMap::setCascadeUpdateInterval(unsigned interval) {
+  mUpdateInterval = std::max(interval, 1U);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+unsigned ShadowMap::getCascadeUpdateInterval() const {
+  return mUpdateInterval;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ShadowMap::setLayeredRendering(bool enable) {
+  mLayeredRendering = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ShadowMap::getLayeredRendering() const {
+  return mLayeredRendering;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void ShadowMap::setEnabled(bool enable) {
   mEnabled = enable;
+  mCascadesDirty.assign(mCascadesDirty.size(), true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -169,8 +209,8 @@ std::vector<float> const& ShadowMap::getCascadeSplits() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<VistaTexture*> const& ShadowMap::getMaps() const {
-  return mShadowMaps;
+uint32_t ShadowMap::getTexture() const {
+  return mTexture;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -181,6 +221,18 @@ std::vector<VistaTransformMatrix> const& ShadowMap::getShadowMatrices() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool ShadowMap::getIsRenderingLayered() const {
+  return mIsRenderingLayered;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> const& ShadowMap::getUpdatedCascades() const {
+  return mUpdatedCascades;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool ShadowMap::Do() {
   if (!mEnabled) {
     return true;
@@ -196,34 +248,61 @@ bool ShadowMap::Do() {
       mSplits = {0.1F, 5.F, 20.F, 50.F, 100.F};
     }
 
-    // create shadow maps for all cascades
-    for (size_t i = 0; i < mSplits.size() - 1; ++i) {
-      // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
-      mShadowMapFBOs.push_back(new VistaFramebufferObj());
-
-      // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
-      mShadowMaps.push_back(new VistaTexture(GL_TEXTURE_2D));
-      mShadowMatrices.emplace_back(VistaTransformMatrix());
-
-      mShadowMaps[i]->Bind();
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, mResolution, mResolution, 0,
-          GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-
-      mShadowMapFBOs[i]->Attach(mShadowMaps[i], GL_DEPTH_ATTACHMENT);
-      mShadowMaps[i]->Unbind();
+    auto cascades = static_cast<GLsizei>(mSplits.size() - 1);
+
+    // all cascades are stored in the layers of one depth texture array
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, static_cast<GLsizei>(mResolution),
+        static_cast<GLsizei>(mResolution), cascades);
+
+    // GL_DEPTH_COMPONENT24 is usually stored with four bytes per texel.
+    mBytes = static_cast<std::size_t>(mResolution) * mResolution * cascades * 4;
+    GpuMemory::get().allocate("Shadow Map", mBytes);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    // one framebuffer for each cascade, and one with all layers attached for layered rendering
+    mFramebuffers.resize(mSplits.size());
+    glGenFramebuffers(static_cast<GLsizei>(mFramebuffers.size()), mFramebuffers.data());
+
+    for (GLsizei i = 0; i <= cascades; ++i) {
+      glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffers.at(static_cast<size_t>(i)));
+
+      if (i < cascades) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mTexture, 0, i);
+      } else {
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mTexture, 0);
+      }
+
+      glDrawBuffer(GL_NONE);
+      glReadBuffer(GL_NONE);
     }
 
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+
+    mShadowMatrices.resize(mSplits.size() - 1);
+    mCascadesDirty.assign(mSplits.size() - 1, true);
+
     mFBODirty = false;
   }
 
-  // save current viewport
-  std::array<GLint, 4> iOrigViewport{};
-  glGetIntegerv(GL_VIEWPORT, iOrigViewport.data());
+  // if any caster has changed, all cascades have to be re-rendered eventually
+  bool castersDirty = std::any_of(mShadowCasters.begin(), mShadowCasters.end(),
+      [](ShadowCaster* caster) { return caster->getIsShadowDirty(); });
+
+  if (castersDirty) {
+    mCascadesDirty.assign(mCascadesDirty.size(), true);
+  }
+
+  ++mFrameCount;
 
   // get view matrix - as this shadowmap should be attached to
   // scenegraph root, we can just use the modelview matrix here
@@ -275,11 +354,18 @@ bool ShadowMap::Do() {
             lightMatrix * (transform * VistaVector3D(1, -1, slicePosition, 1)).GetHomogenized()});
   }
 
-  // ow we render all registered shadow casters into the shadow maps
-  for (size_t i = 0; i < mSplits.size() - 1; ++i) {
-    // bind the fbo
-    mShadowMapFBOs[i]->Bind();
+  // the light-space bounds of all cascades which are updated in this frame, these are used for
+  // the projection of a layered pass
+  std::array<float, 6> unionBounds{std::numeric_limits<float>::max(),
+      std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max(),
+      std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max(),
+      std::numeric_limits<float>::lowest()};
+
+  std::vector<VistaTransformMatrix> projections;
+  mUpdatedCascades.clear();
 
+  // first we determine the projection of each cascade and whether it needs to be updated
+  for (size_t i = 0; i < mSplits.size() - 1; ++i) {
     // setup sun projection matrix
     float r = std::numeric_limits<float>::lowest();
     float t = std::numeric_limits<float>::lowest();
@@ -320,60 +406,120 @@ bool ShadowMap::Do() {
     t = y + h * 0.5F;
 
     // create the orthographic projection matrix
-    VistaTransformMatrix projection(2.0F / (r - l), 0.0, 0.0, -(r + l) / (r - l), 0.0,
-        2.0F / (t - b), 0.0, -(t + b) / (t - b), 0.0, 0.0, -2.0F / (n - f), -(n + f) / (n - f), 0.0,
-        0.0, 0.0, 1.0);
+    projections.emplace_back(2.0F / (r - l), 0.0, 0.0, -(r + l) / (r - l), 0.0, 2.0F / (t - b),
+        0.0, -(t + b) / (t - b), 0.0, 0.0, -2.0F / (n - f), -(n + f) / (n - f), 0.0, 0.0, 0.0, 1.0);
+
+    VistaTransformMatrix shadowMatrix = projections.back() * lightMatrix;
+
+    bool frustumChanged = !std::equal(shadowMatrix.GetData(), shadowMatrix.GetData() + 16,
+        mShadowMatrices[i].GetData());
+
+    // cascades whose frustum and casters have not changed can be reused as they are
+    if (!mCascadesDirty[i] && !frustumChanged) {
+      continue;
+    }
+
+    // all but the first cascade are only updated every mUpdateInterval frames, staggered by their
+    // index; until then, they keep their previous matrix and contents
+    if (i > 0 && (mFrameCount + i) % mUpdateInterval != 0) {
+      continue;
+    }
 
     // these matrices are used by the shadow receivers to calculate the
     // lookup position in the shadow maps
-    mShadowMatrices.at(i) = projection * lightMatrix;
+    mShadowMatrices[i] = shadowMatrix;
+    mCascadesDirty[i]  = false;
+    mUpdatedCascades.push_back(static_cast<uint32_t>(i));
+
+    unionBounds[0] = std::min(unionBounds[0], l);
+    unionBounds[1] = std::max(unionBounds[1], r);
+    unionBounds[2] = std::min(unionBounds[2], b);
+    unionBounds[3] = std::max(unionBounds[3], t);
+    unionBounds[4] = std::min(unionBounds[4], f);
+    unionBounds[5] = std::max(unionBounds[5], n);
+  }
 
-    // save current projection matrix
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
+  if (mUpdatedCascades.empty()) {
+    return true;
+  }
 
-    // load sun projection
-    glLoadMatrixf(projection.GetData());
+  // all cascades can be drawn in one pass if the casters support it
+  mIsRenderingLayered =
+      mLayeredRendering && GLEW_ARB_shader_viewport_layer_array &&
+      std::all_of(mShadowCasters.begin(), mShadowCasters.end(),
+          [](ShadowCaster* caster) { return caster->getSupportsLayeredRendering(); });
 
-    // save current modelview matrix
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
+  // save current viewport and framebuffer
+  std::array<GLint, 4> iOrigViewport{};
+  glGetIntegerv(GL_VIEWPORT, iOrigViewport.data());
+
+  GLint previousFramebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
 
-    // setup viewport
-    glViewport(0, 0, mResolution, mResolution);
+  // setup viewport
+  glViewport(0, 0, mResolution, mResolution);
 
-    // clear fbo
-    glClearDepth(1.0f);
-    glClear(GL_DEPTH_BUFFER_BIT);
+  // setup "normal" GL state (we are not using the reverse infinite projection for the shadows)
+  glDepthFunc(GL_LESS);
+  glDisable(GL_CULL_FACE);
+  glClearDepth(1.0f);
 
-    // setup "normal" GL state (we are not using the reverse infinite projection for the shadows)
-    glDepthFunc(GL_LESS);
-    glDisable(GL_CULL_FACE);
+  // save current projection and modelview matrix
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+
+  // draws all shadow casters with the given projection
+  auto drawCasters = [&](VistaTransformMatrix const& projection) {
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(projection.GetData());
+    glMatrixMode(GL_MODELVIEW);
 
-    // draw all shadow casters
     for (auto* caster : mShadowCasters) {
       glLoadMatrixf(lightMatrix.GetData());
       caster->drawForShadowMap();
     }
+  };
 
-    // restore previous projection matrix
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
+  if (mIsRenderingLayered) {
+    // the layers cannot be cleared individually through the layered framebuffer
+    for (auto i : mUpdatedCascades) {
+      glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffers[i]);
+      glClear(GL_DEPTH_BUFFER_BIT);
+    }
 
-    // restore previous modelview matrix
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
+    // the casters are drawn once with a projection enclosing all updated cascades, they have to
+    // use getShadowMatrices() to draw into the individual layers
+    auto const& [l, r, b, t, f, n] = unionBounds;
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffers.back());
+    drawCasters(VistaTransformMatrix(2.0F / (r - l), 0.0, 0.0, -(r + l) / (r - l), 0.0,
+        2.0F / (t - b), 0.0, -(t + b) / (t - b), 0.0, 0.0, -2.0F / (n - f), -(n + f) / (n - f),
+        0.0, 0.0, 0.0, 1.0));
+
+    mIsRenderingLayered = false;
+  } else {
+    // now we render all registered shadow casters into the shadow maps
+    for (auto i : mUpdatedCascades) {
+      glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffers[i]);
+      glClear(GL_DEPTH_BUFFER_BIT);
+      drawCasters(projections[i]);
+    }
+  }
 
-    // restore GL state for reverse infinite projection
-    glDepthFunc(GL_GEQUAL);
-    glClearDepth(0.0f);
-    glEnable(GL_CULL_FACE);
+  // restore previous projection and modelview matrix
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
+  glPopMatrix();
 
-    // unbind fbo again
-    mShadowMapFBOs[i]->Release();
-  }
+  // restore GL state for reverse infinite projection
+  glDepthFunc(GL_GEQUAL);
+  glClearDepth(0.0f);
+  glEnable(GL_CULL_FACE);
 
-  // restore previous viewport
+  // restore previous framebuffer and viewport
+  glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
   glViewport(iOrigViewport.at(0), iOrigViewport.at(1), iOrigViewport.at(2), iOrigViewport.at(3));
 
   return true;
@@ -395,17 +541,16 @@ bool ShadowMap::GetBoundingBox(VistaBoundingBox& oBoundingBox) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void ShadowMap::cleanUp() {
-  for (auto& map : mShadowMaps) {
-    delete map; // NOLINT(cppcoreguidelines-owning-memory)
-  }
-
-  for (auto& fbo : mShadowMapFBOs) {
-    delete fbo; // NOLINT(cppcoreguidelines-owning-memory)
-  }
+  glDeleteTextures(1, &mTexture);
+  glDeleteFramebuffers(static_cast<GLsizei>(mFramebuffers.size()), mFramebuffers.data());
+  GpuMemory::get().release("Shadow Map", mBytes);
 
-  mShadowMapFBOs.clear();
-  mShadowMaps.clear();
+  mTexture = 0;
+  mBytes   = 0;
+  mFramebuffers.clear();
   mShadowMatrices.clear();
+  mCascadesDirty.clear();
+  mUpdatedCascades.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -13,11 +13,11 @@
 #include <VistaBase/VistaTransformMatrix.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <set>
 #include <vector>
 
-class VistaTexture;
-class VistaFramebufferObj;
 class VistaNode;
 
 namespace cs::graphics {
@@ -32,6 +32,20 @@ class CS_GRAPHICS_EXPORT ShadowCaster {
   /// matrix will contain the light's view matrix.
   virtual void drawForShadowMap() = 0;
 
+  /// Should return true if the shadow of this object may have changed since the last call to
+  /// drawForShadowMap(), for example because the object has moved or its geometry has changed. If
+  /// no registered caster is dirty, the ShadowMap may reuse cascades whose light-space frustum has
+  /// not changed. The default implementation always returns true.
+  virtual bool getIsShadowDirty() const;
+
+  /// Should return true if drawForShadowMap() is able to draw into all cascades at once. In this
+  /// case, ShadowMap::getIsRenderingLayered() may return true during drawForShadowMap(). The
+  /// object then has to be drawn into each layer given by ShadowMap::getUpdatedCascades() by
+  /// writing gl_Layer and using the corresponding matrix of ShadowMap::getShadowMatrices(). The
+  /// projection matrix will enclose all these cascades, so it can be used for culling. The default
+  /// implementation returns false.
+  virtual bool getSupportsLayeredRendering() const;
+
   /// Called by registerCaster() from the shadow map.
   void       setShadowMap(ShadowMap* pShadowMap);
   ShadowMap* getShadowMap() const;
@@ -41,7 +55,7 @@ class CS_GRAPHICS_EXPORT ShadowCaster {
 };
 
 /// This shadow map implements parallel split cascaded shadow maps with percentage closer
-/// filtering.
+/// filtering. The cascades are stored in the layers of one depth texture array.
 class CS_GRAPHICS_EXPORT ShadowMap : public IVistaOpenGLDraw {
  public:
   ShadowMap() = default;
@@ -82,6 +96,21 @@ class CS_GRAPHICS_EXPORT ShadowMap : public IVistaOpenGLDraw {
   void  setBias(float bias);
   float getBias() const;
 
+  /// The first cascade is updated each frame. All other cascades are only updated every n-th
+  /// frame, in a staggered fashion so that not all of them are updated in the same frame. A
+  /// cascade which is not updated keeps its previous shadow matrix, so its shadows stay correct as
+  /// long as the casters do not move. Independent of this, cascades are not re-rendered at all if
+  /// neither their frustum nor any of the shadow casters have changed. Defaults to 1.
+  void     setCascadeUpdateInterval(unsigned interval);
+  unsigned getCascadeUpdateInterval() const;
+
+  /// If enabled and all registered casters support it, all cascades which need to be updated are
+  /// drawn in one pass into the layers of the shadow map. This requires the extension
+  /// GL_ARB_shader_viewport_layer_array, else the cascades are drawn one after another. Defaults to
+  /// false.
+  void setLayeredRendering(bool enable);
+  bool getLayeredRendering() const;
+
   /// For debugging, disables cascade updates.
   void setFreezeCascades(bool freeze);
   bool getFreezeCascades() const;
@@ -90,29 +119,47 @@ class CS_GRAPHICS_EXPORT ShadowMap : public IVistaOpenGLDraw {
   void setEnabled(bool enable);
   bool getEnabled() const;
 
-  /// Returns all shadow maps which have been generated this frame and the matrices which should be
-  /// used to perform lookups.
-  std::vector<VistaTexture*> const&        getMaps() const;
+  /// Returns the GL_TEXTURE_2D_ARRAY containing one layer for each cascade and the matrices which
+  /// should be used to perform lookups in the layers.
+  uint32_t                                 getTexture() const;
   std::vector<VistaTransformMatrix> const& getShadowMatrices() const;
 
+  /// These are only valid during ShadowCaster::drawForShadowMap(). The first returns true if all
+  /// cascades returned by the second are drawn in a single pass.
+  bool                         getIsRenderingLayered() const;
+  std::vector<uint32_t> const& getUpdatedCascades() const;
+
   bool Do() override;
   bool GetBoundingBox(VistaBoundingBox& oBoundingBox) override;
 
  private:
   void cleanUp();
 
-  std::vector<VistaTexture*>        mShadowMaps;
+  uint32_t                          mTexture = 0;
+  std::size_t                       mBytes   = 0;
   std::vector<VistaTransformMatrix> mShadowMatrices;
-  std::vector<VistaFramebufferObj*> mShadowMapFBOs;
   std::set<ShadowCaster*>           mShadowCasters;
   VistaVector3D                     mSunDirection = VistaVector3D(0, 1, 0);
   unsigned                          mResolution   = 1024;
   std::vector<float>                mSplits;
-  float                             mSunNearClipOffset = -500.0F;
-  float                             mSunFarClipOffset  = 500.0F;
-  float                             mBias              = 0.0001F;
-  bool                              mFreezeCascades    = false;
-  bool                              mEnabled           = true;
+  float                             mSunNearClipOffset  = -500.0F;
+  float                             mSunFarClipOffset   = 500.0F;
+  float                             mBias               = 0.0001F;
+  bool                              mFreezeCascades     = false;
+  bool                              mEnabled            = true;
+  unsigned                          mUpdateInterval     = 1;
+  unsigned                          mFrameCount         = 0;
+  bool                              mLayeredRendering   = false;
+  bool                              mIsRenderingLayered = false;
+
+  /// One framebuffer for each layer of mTexture, the last one has all layers attached.
+  std::vector<uint32_t> mFramebuffers;
+
+  /// The cascades which are drawn in the current frame.
+  std::vector<uint32_t> mUpdatedCascades;
+
+  /// Set for each cascade which has to be re-rendered, even though its frustum has not changed.
+  std::vector<bool> mCascadesDirty;
 
   VistaTransformMatrix matProjection, matView;
 
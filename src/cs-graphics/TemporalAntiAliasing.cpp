@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TemporalAntiAliasing.hpp"
+
+#include "../cs-utils/FrameStats.hpp"
+#include "../cs-utils/doctest.hpp"
+#include "GpuMemory.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Returns the index-th element of the Halton sequence with the given base. The result is in the
+// range [0, 1).
+float halton(uint32_t index, uint32_t base) {
+  float result   = 0.F;
+  float fraction = 1.F;
+
+  while (index > 0) {
+    fraction /= static_cast<float>(base);
+    result += fraction * static_cast<float>(index % base);
+    index /= base;
+  }
+
+  return result;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const char* sComputeResolve = R"(
+  layout (local_size_x = 16, local_size_y = 16) in;
+
+  layout (binding = 0) uniform sampler2D uComposite;
+  layout (binding = 1) uniform sampler2D uDepth;
+  layout (binding = 2) uniform sampler2D uHistory;
+
+  layout (HDR_BUFFER_FORMAT, binding = 0) writeonly uniform image2D uOutHistory;
+
+  // Transforms from the current frame's normalized device coordinates to the previous frame's clip
+  // space.
+  uniform mat4  uReprojection;
+  uniform float uBlendWeight;
+  uniform bool  uResetHistory;
+
+  void main() {
+    ivec2 size = imageSize(uOutHistory);
+    ivec2 pos  = ivec2(gl_GlobalInvocationID.xy);
+
+    if (any(greaterThanEqual(pos, size))) {
+      return;
+    }
+
+    vec4 current = texelFetch(uComposite, pos, 0);
+
+    // The color range of the 3x3 neighborhood is used to reject stale history values. The closest
+    // depth of the neighborhood is used for reprojection, so that the edges of foreground objects
+    // are reprojected with the motion of the foreground.
+    vec3  minColor = current.rgb;
+    vec3  maxColor = current.rgb;
+    float depth    = texelFetch(uDepth, pos, 0).r;
+
+    for (int x = -1; x <= 1; ++x) {
+      for (int y = -1; y <= 1; ++y) {
+        ivec2 p     = clamp(pos + ivec2(x, y), ivec2(0), size - 1);
+        vec3  color = texelFetch(uComposite, p, 0).rgb;
+        minColor    = min(minColor, color);
+        maxColor    = max(maxColor, color);
+        depth       = min(depth, texelFetch(uDepth, p, 0).r);
+      }
+    }
+
+    vec4 result = current;
+
+    if (!uResetHistory) {
+      vec3 ndc      = vec3((vec2(pos) + 0.5) / vec2(size), depth) * 2.0 - 1.0;
+      vec4 lastClip = uReprojection * vec4(ndc, 1.0);
+      vec2 lastUV   = lastClip.xy / lastClip.w * 0.5 + 0.5;
+
+      if (lastClip.w > 0.0 && all(greaterThanEqual(lastUV, vec2(0.0))) &&
+          all(lessThanEqual(lastUV, vec2(1.0)))) {
+        vec3 history = clamp(texture(uHistory, lastUV).rgb, minColor, maxColor);
+        result.rgb   = mix(history, current.rgb, uBlendWeight);
+      }
+    }
+
+    imageStore(uOutHistory, pos, result);
+  }
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TemporalAntiAliasing::TemporalAntiAliasing(
+    int hdrBufferWidth, int hdrBufferHeight, HDRBuffer::Format hdrBufferFormat)
+    : mHDRBufferWidth(hdrBufferWidth)
+    , mHDRBufferHeight(hdrBufferHeight)
+    , mHDRBufferFormat(hdrBufferFormat) {
+
+  // Create the two history textures. They are used in a ping-pong fashion.
+  auto internalFormat = static_cast<GLenum>(HDRBuffer::getInternalFormat(mHDRBufferFormat));
+
+  for (auto& history : mHistory) {
+    history = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
+    history->Bind();
+    glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, mHDRBufferWidth, mHDRBufferHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    history->Unbind();
+  }
+
+  std::size_t pixelBytes = 16;
+  if (mHDRBufferFormat != HDRBuffer::Format::eRGBA32F) {
+    pixelBytes = mHDRBufferFormat == HDRBuffer::Format::eRGBA16F ? 8 : 4;
+  }
+
+  mBytes = 2 * pixelBytes * static_cast<std::size_t>(mHDRBufferWidth) *
+           static_cast<std::size_t>(mHDRBufferHeight);
+  GpuMemory::get().allocate("Temporal Anti-Aliasing", mBytes);
+
+  // Create the compute shader.
+  auto        shader = glCreateShader(GL_COMPUTE_SHADER);
+  std::string source = "#version 430\n";
+  source += "#define HDR_BUFFER_FORMAT " + HDRBuffer::getImageFormatQualifier(mHDRBufferFormat) +
+            "\n";
+  source += sComputeResolve;
+  const char* pSource = source.c_str();
+  glShaderSource(shader, 1, &pSource, nullptr);
+  glCompileShader(shader);
+
+  int rvalue = 0;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto log_length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+    std::vector<char> v(log_length);
+    glGetShaderInfoLog(shader, log_length, nullptr, v.data());
+    std::string log(begin(v), end(v));
+    glDeleteShader(shader);
+    throw std::runtime_error(std::string("ERROR: Failed to compile shader\n") + log);
+  }
+
+  mComputeProgram = glCreateProgram();
+  glAttachShader(mComputeProgram, shader);
+  glLinkProgram(mComputeProgram);
+  glDeleteShader(shader);
+
+  glGetProgramiv(mComputeProgram, GL_LINK_STATUS, &rvalue);
+  if (rvalue != GL_TRUE) {
+    auto log_length = 0;
+    glGetProgramiv(mComputeProgram, GL_INFO_LOG_LENGTH, &log_length);
+    std::vector<char> v(log_length);
+    glGetProgramInfoLog(mComputeProgram, log_length, nullptr, v.data());
+    std::string log(begin(v), end(v));
+
+    throw std::runtime_error(std::string("ERROR: Failed to link compute shader\n") + log);
+  }
+
+  mUniforms.reprojection = glGetUniformLocation(mComputeProgram, "uReprojection");
+  mUniforms.blendWeight  = glGetUniformLocation(mComputeProgram, "uBlendWeight");
+  mUniforms.resetHistory = glGetUniformLocation(mComputeProgram, "uResetHistory");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TemporalAntiAliasing::~TemporalAntiAliasing() {
+  GpuMemory::get().release("Temporal Anti-Aliasing", mBytes);
+  glDeleteProgram(mComputeProgram);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TemporalAntiAliasing::update(VistaTexture* hdrBufferComposite, VistaTexture* hdrBufferDepth,
+    glm::dmat4 const& viewProjection) {
+
+  utils::FrameStats::ScopedTimer timer("Temporal Anti-Aliasing");
+
+  // The reprojection is computed in double precision, as the reference frame may be very far away
+  // from the observer.
+  glm::mat4 reprojection(mLastViewProjection * glm::inverse(viewProjection));
+
+  auto& lastHistory = mHistory.at(mCurrentHistory);
+  auto& nextHistory = mHistory.at((mCurrentHistory + 1) % 2);
+
+  glUseProgram(mComputeProgram);
+  glUniformMatrix4fv(
+      static_cast<GLint>(mUniforms.reprojection), 1, GL_FALSE, glm::value_ptr(reprojection));
+  glUniform1f(static_cast<GLint>(mUniforms.blendWeight), sBlendWeight);
+  glUniform1i(static_cast<GLint>(mUniforms.resetHistory), static_cast<int>(!mHistoryValid));
+
+  hdrBufferComposite->Bind(GL_TEXTURE0);
+  hdrBufferDepth->Bind(GL_TEXTURE1);
+  lastHistory->Bind(GL_TEXTURE2);
+
+  glBindImageTexture(0, nextHistory->GetId(), 0, GL_FALSE, 0, GL_WRITE_ONLY,
+      HDRBuffer::getInternalFormat(mHDRBufferFormat));
+
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  glDispatchCompute(static_cast<uint32_t>((mHDRBufferWidth + 15) / 16),
+      static_cast<uint32_t>((mHDRBufferHeight + 15) / 16), 1);
+
+  // Replace the composite with the anti-aliased image.
+  glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  glCopyImageSubData(nextHistory->GetId(), GL_TEXTURE_2D, 0, 0, 0, 0, hdrBufferComposite->GetId(),
+      GL_TEXTURE_2D, 0, 0, 0, 0, mHDRBufferWidth, mHDRBufferHeight, 1);
+
+  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+  lastHistory->Unbind(GL_TEXTURE2);
+  hdrBufferDepth->Unbind(GL_TEXTURE1);
+  hdrBufferComposite->Unbind(GL_TEXTURE0);
+  glUseProgram(0);
+
+  mCurrentHistory     = (mCurrentHistory + 1) % 2;
+  mHistoryValid       = true;
+  mLastViewProjection = viewProjection;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TemporalAntiAliasing::reset() {
+  mHistoryValid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec2 TemporalAntiAliasing::getJitter(uint64_t frame) {
+  auto index = static_cast<uint32_t>(frame % sJitterCount) + 1;
+  return glm::vec2(halton(index, 2), halton(index, 3)) - 0.5F;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::TemporalAntiAliasing::getJitter") {
+  CHECK_EQ(TemporalAntiAliasing::getJitter(0), glm::vec2(0.F, 1.F / 3.F - 0.5F));
+  CHECK_EQ(TemporalAntiAliasing::getJitter(1), glm::vec2(-0.25F, 2.F / 3.F - 0.5F));
+  CHECK_EQ(TemporalAntiAliasing::getJitter(TemporalAntiAliasing::sJitterCount),
+      TemporalAntiAliasing::getJitter(0));
+
+  for (uint64_t i = 0; i < TemporalAntiAliasing::sJitterCount; ++i) {
+    auto jitter = TemporalAntiAliasing::getJitter(i);
+    CHECK(jitter.x >= -0.5F);
+    CHECK(jitter.x < 0.5F);
+    CHECK(jitter.y >= -0.5F);
+    CHECK(jitter.y < 0.5F);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_TEMPORAL_ANTI_ALIASING_HPP
+#define CS_GRAPHICS_TEMPORAL_ANTI_ALIASING_HPP
+
+#include "HDRBuffer.hpp"
+
+#include <VistaOGLExt/VistaTexture.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+
+namespace cs::graphics {
+
+/// The TemporalAntiAliasing accumulates the jittered frames of one eye of one viewport in a history
+/// buffer. Each pixel of the current frame is reprojected into the previous frame using its depth.
+/// The history is sampled at the reprojected position, clamped to the color range of the pixel's
+/// 3x3 neighborhood in the current frame and blended with the current color. The result is written
+/// back to the composite of the HDRBuffer, so that all following passes see the anti-aliased image.
+///
+/// This is much cheaper than multi-sampled HDR attachments, as all attachments keep one sample per
+/// pixel. It requires the projection to be jittered by a sub-pixel amount each frame, see
+/// getJitter().
+class CS_GRAPHICS_EXPORT TemporalAntiAliasing {
+ public:
+  TemporalAntiAliasing(int hdrBufferWidth, int hdrBufferHeight,
+      HDRBuffer::Format hdrBufferFormat = HDRBuffer::Format::eRGBA32F);
+  ~TemporalAntiAliasing();
+
+  TemporalAntiAliasing(TemporalAntiAliasing const& other) = delete;
+  TemporalAntiAliasing(TemporalAntiAliasing&& other)      = delete;
+
+  TemporalAntiAliasing& operator=(TemporalAntiAliasing const& other) = delete;
+  TemporalAntiAliasing& operator=(TemporalAntiAliasing&& other)      = delete;
+
+  /// Blends the given composite with the history and writes the result back to the composite. The
+  /// composite and the depth must not be multi-sampled. viewProjection transforms points from a
+  /// reference frame to clip space. The points of the scene are assumed to be static in this
+  /// reference frame; everything else moving relative to it is handled by the neighborhood
+  /// clamping only. This should be called once a frame.
+  void update(VistaTexture* hdrBufferComposite, VistaTexture* hdrBufferDepth,
+      glm::dmat4 const& viewProjection);
+
+  /// Discards the history. The next call to update() will not blend with previous frames.
+  void reset();
+
+  /// Returns the sub-pixel offset for the given frame in pixels. The offsets follow a Halton (2, 3)
+  /// sequence in the range [-0.5, 0.5] which repeats every sJitterCount frames.
+  static glm::vec2 getJitter(uint64_t frame);
+
+  /// The number of different jitter offsets.
+  static constexpr uint32_t sJitterCount = 8;
+
+  /// The weight of the current frame when it is blended with the history.
+  static constexpr float sBlendWeight = 0.1F;
+
+ private:
+  std::array<std::unique_ptr<VistaTexture>, 2> mHistory;
+  int                                          mCurrentHistory = 0;
+  bool                                         mHistoryValid   = false;
+  glm::dmat4                                   mLastViewProjection{1.0};
+
+  GLuint            mComputeProgram  = 0;
+  int               mHDRBufferWidth  = 0;
+  int               mHDRBufferHeight = 0;
+  HDRBuffer::Format mHDRBufferFormat = HDRBuffer::Format::eRGBA32F;
+  std::size_t       mBytes           = 0;
+
+  struct {
+    uint32_t reprojection = 0;
+    uint32_t blendWeight  = 0;
+    uint32_t resetHistory = 0;
+  } mUniforms;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_TEMPORAL_ANTI_ALIASING_HPP
@@ -7,6 +7,8 @@
 
 #include "TextureLoader.hpp"
 
+#include "../cs-utils/ThreadPool.hpp"
+#include "GpuMemory.hpp"
 #include "logger.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -19,8 +21,15 @@
 #undef STB_IMAGE_WRITE_IMPLEMENTATION
 #undef STB_IMAGE_RESIZE_IMPLEMENTATION
 
+#include <GL/glew.h>
 #include <VistaOGLExt/VistaOGLUtils.h>
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+#include <gli/gli.hpp>
+#include <list>
+#include <optional>
 #include <tiffio.h>
 #include <vector>
 
@@ -28,26 +37,98 @@ namespace cs::graphics {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::unique_ptr<VistaTexture> TextureLoader::loadFromFile(std::string const& sFileName) {
+namespace {
 
-  std::string suffix = sFileName.substr(sFileName.rfind('.'));
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  if (suffix == ".tga") {
-    // load with vista
-    logger().debug("Loading Texture '{}' with Vista.", sFileName);
-    return std::unique_ptr<VistaTexture>(VistaOGLUtils::LoadTextureFromTga(sFileName));
+// A decoded image with all information required for uploading it to OpenGL. The mip levels are
+// stored from fine to coarse. This does not depend on an OpenGL context, so it can be created on
+// any thread.
+struct ImageData {
+  struct Level {
+    int                        mWidth  = 0;
+    int                        mHeight = 0;
+    std::vector<unsigned char> mData;
+  };
+
+  GLenum mInternalFormat = GL_RGBA;
+  GLenum mFormat         = GL_RGBA;
+  GLenum mType           = GL_UNSIGNED_BYTE;
+  bool   mCompressed     = false;
+
+  std::array<GLint, 4> mSwizzles{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+  std::vector<Level>   mLevels;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Appends successively halved versions of the first level until a size of 1x1 is reached. The
+// components are either unsigned bytes or floats.
+void generateMipmaps(ImageData& image, int channels) {
+  while (image.mLevels.back().mWidth > 1 || image.mLevels.back().mHeight > 1) {
+    auto const& input = image.mLevels.back();
+
+    ImageData::Level output;
+    output.mWidth  = std::max(input.mWidth / 2, 1);
+    output.mHeight = std::max(input.mHeight / 2, 1);
+
+    if (image.mType == GL_FLOAT) {
+      output.mData.resize(
+          static_cast<std::size_t>(output.mWidth * output.mHeight * channels) * sizeof(float));
+      stbir_resize_float(reinterpret_cast<float const*>(input.mData.data()), input.mWidth,
+          input.mHeight, 0, reinterpret_cast<float*>(output.mData.data()), output.mWidth,
+          output.mHeight, 0, channels);
+    } else {
+      output.mData.resize(static_cast<std::size_t>(output.mWidth * output.mHeight * channels));
+      stbir_resize_uint8(input.mData.data(), input.mWidth, input.mHeight, 0, output.mData.data(),
+          output.mWidth, output.mHeight, 0, channels);
+    }
+
+    image.mLevels.push_back(std::move(output));
   }
+}
 
-  std::unique_ptr<VistaTexture> result = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Decodes the given file. For *.dds, *.ktx and *.kmg files, the mip levels stored in the file are
+// used. For all other formats, the mip levels are computed if withMipmaps is set. Throws a
+// std::runtime_error if the file cannot be loaded. *.tga files are not supported.
+ImageData decodeImage(std::string const& fileName, bool withMipmaps) {
+  std::string suffix = fileName.substr(fileName.rfind('.'));
+  ImageData   image;
+
+  if (suffix == ".dds" || suffix == ".ktx" || suffix == ".kmg") {
+    logger().debug("Loading Texture '{}' with gli.", fileName);
 
-  if (suffix == ".tiff" || suffix == ".tif") {
-    // load with tifflib
-    logger().debug("Loading Texture '{}' with libtiff.", sFileName);
+    gli::texture2d texture(gli::load(fileName));
+    if (texture.empty()) {
+      throw std::runtime_error("Failed to load '" + fileName + "' with gli!");
+    }
+
+    gli::gl GL(gli::gl::PROFILE_GL33);
+    auto    format = GL.translate(texture.format(), texture.swizzles());
+
+    image.mInternalFormat = format.Internal;
+    image.mFormat         = format.External;
+    image.mType           = format.Type;
+    image.mCompressed     = gli::is_compressed(texture.format());
+
+    for (std::size_t i = 0; i < 4; ++i) {
+      image.mSwizzles.at(i) = format.Swizzles[static_cast<glm::length_t>(i)];
+    }
 
-    auto* data = TIFFOpen(sFileName.c_str(), "r");
+    for (std::size_t level = 0; level < texture.levels(); ++level) {
+      auto const* data = static_cast<unsigned char const*>(texture.data(0, 0, level));
+      image.mLevels.push_back({texture.extent(level).x, texture.extent(level).y,
+          std::vector<unsigned char>(data, data + texture.size(level))});
+    }
+
+  } else if (suffix == ".tiff" || suffix == ".tif") {
+    logger().debug("Loading Texture '{}' with libtiff.", fileName);
+
+    auto* data = TIFFOpen(fileName.c_str(), "r");
     if (!data) {
-      logger().error("Failed to load '{}' with libtiff!", sFileName);
-      return nullptr;
+      throw std::runtime_error("Failed to load '" + fileName + "' with libtiff!");
     }
 
     uint32 width{};
@@ -62,76 +143,338 @@ std::unique_ptr<VistaTexture> TextureLoader::loadFromFile(std::string const& sFi
     TIFFGetField(data, TIFFTAG_SAMPLESPERPIXEL, &channels);
 
     if (bpp != 8) {
-      logger().error(
-          "Failed to load '{}' with libtiff: Only 8 bit per sample are supported right now!",
-          sFileName);
-      return nullptr;
+      TIFFClose(data);
+      throw std::runtime_error("Failed to load '" + fileName +
+                               "' with libtiff: Only 8 bit per sample are supported right now!");
     }
 
-    std::vector<char> pixels(width * height * channels);
+    ImageData::Level level{static_cast<int>(width), static_cast<int>(height),
+        std::vector<unsigned char>(width * height * channels)};
 
     for (unsigned y = 0; y < height; y++) {
-      TIFFReadScanline(data, &pixels[width * channels * y], y);
+      TIFFReadScanline(data, &level.mData[width * channels * y], y);
     }
 
-    GLenum ePixelFormat = GL_RGBA;
+    TIFFClose(data);
 
     if (channels == 1) {
-      ePixelFormat = GL_RED;
+      image.mFormat = GL_RED;
     } else if (channels == 2) {
-      ePixelFormat = GL_RG;
+      image.mFormat = GL_RG;
     } else if (channels == 3) {
-      ePixelFormat = GL_RGB;
+      image.mFormat = GL_RGB;
     }
 
-    result->UploadTexture(width, height, pixels.data(), true, ePixelFormat);
+    image.mInternalFormat = image.mFormat;
+    image.mLevels.push_back(std::move(level));
 
-    TIFFClose(data);
+    if (withMipmaps) {
+      generateMipmaps(image, channels);
+    }
 
-  } else if (suffix == ".hdr") {
+  } else {
+    bool hdr = suffix == ".hdr";
 
-    // load with stb image
-    logger().debug("Loading HDR Texture '{}' with stbi.", sFileName);
+    logger().debug("Loading {}Texture '{}' with stbi.", hdr ? "HDR " : "", fileName);
 
     int width{};
     int height{};
     int bpp{};
     int channels = 4;
 
-    float* pixels = stbi_loadf(sFileName.c_str(), &width, &height, &bpp, channels);
+    void* pixels = hdr ? static_cast<void*>(
+                             stbi_loadf(fileName.c_str(), &width, &height, &bpp, channels))
+                       : static_cast<void*>(
+                             stbi_load(fileName.c_str(), &width, &height, &bpp, channels));
 
     if (!pixels) {
-      logger().error("Failed to load '{}' with stbi!", sFileName);
-      return nullptr;
+      throw std::runtime_error("Failed to load '" + fileName + "' with stbi!");
     }
 
-    result->Bind();
-    gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA32F, width, height, GL_RGBA, GL_FLOAT, pixels);
+    std::size_t size = static_cast<std::size_t>(width * height * channels) *
+                       (hdr ? sizeof(float) : sizeof(unsigned char));
 
+    auto const* data = static_cast<unsigned char const*>(pixels);
+    image.mLevels.push_back({width, height, std::vector<unsigned char>(data, data + size)});
     stbi_image_free(pixels);
 
+    if (hdr) {
+      image.mInternalFormat = GL_RGBA32F;
+      image.mType           = GL_FLOAT;
+    }
+
+    if (withMipmaps) {
+      generateMipmaps(image, channels);
+    }
+  }
+
+  return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Uploads the given rows of one mip level to the currently bound texture. If firstRow is zero, the
+// storage of the level is (re-)specified first. Compressed levels are always uploaded at once.
+void uploadRows(ImageData const& image, std::size_t level, int firstRow, int rowCount) {
+  auto const& data  = image.mLevels.at(level);
+  auto        glLvl = static_cast<GLint>(level);
+
+  if (image.mCompressed) {
+    glCompressedTexImage2D(GL_TEXTURE_2D, glLvl, image.mInternalFormat, data.mWidth, data.mHeight,
+        0, static_cast<GLsizei>(data.mData.size()), data.mData.data());
+    return;
+  }
+
+  if (firstRow == 0) {
+    glTexImage2D(GL_TEXTURE_2D, glLvl, static_cast<GLint>(image.mInternalFormat), data.mWidth,
+        data.mHeight, 0, image.mFormat, image.mType, nullptr);
+  }
+
+  std::size_t rowSize = data.mData.size() / static_cast<std::size_t>(data.mHeight);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, glLvl, 0, firstRow, data.mWidth, rowCount, image.mFormat,
+      image.mType, data.mData.data() + rowSize * static_cast<std::size_t>(firstRow));
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Sets the filtering and the swizzling of the currently bound texture.
+void setTextureParameters(ImageData const& image) {
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, image.mSwizzles[0]);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, image.mSwizzles[1]);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, image.mSwizzles[2]);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, image.mSwizzles[3]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A texture returned by loadFromFileAsync() which has not been uploaded completely.
+struct PendingTexture {
+  std::weak_ptr<VistaTexture> mTexture;
+  std::string                 mFileName;
+  std::future<ImageData>      mDecodedImage;
+
+  // Once decoding has finished, the levels are uploaded from mLevel down to zero. Each level may
+  // take several frames, mRow is the first row which has not been uploaded yet.
+  std::optional<ImageData> mImage;
+  int                      mLevel = 0;
+  int                      mRow   = 0;
+
+  // This is only set for streamed textures, see TextureLoader::setRequiredWidth().
+  std::optional<double> mRequiredWidth;
+};
+
+// Returns true if the level of the given texture which would be uploaded next is needed. This is
+// always the case for textures which are not streamed and for the coarsest level. Finer levels of
+// streamed textures are needed if the next coarser level is narrower than the required width and
+// if the level fits into the GPU memory budget.
+bool isNextLevelRequired(PendingTexture const& pending) {
+  auto const& levels = pending.mImage->mLevels;
+  auto        level  = static_cast<std::size_t>(pending.mLevel);
+
+  if (!pending.mRequiredWidth || level + 1 >= levels.size()) {
+    return true;
+  }
+
+  return levels[level + 1].mWidth < *pending.mRequiredWidth &&
+         levels[level].mData.size() <= GpuMemory::get().getRemainingBudget();
+}
+
+// Textures are decoded on a few threads only, so that loading many large textures does not
+// require too much memory at the same time.
+cs::utils::ThreadPool& getThreadPool() {
+  static cs::utils::ThreadPool pool(2, "Texture Loader");
+  return pool;
+}
+
+// This is only accessed on the main thread.
+std::list<PendingTexture>& getPendingTextures() {
+  static std::list<PendingTexture> textures;
+  return textures;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<VistaTexture> TextureLoader::loadFromFile(std::string const& sFileName) {
+
+  std::string suffix = sFileName.substr(sFileName.rfind('.'));
+
+  if (suffix == ".tga") {
+    // load with vista
+    logger().debug("Loading Texture '{}' with Vista.", sFileName);
+    return std::unique_ptr<VistaTexture>(VistaOGLUtils::LoadTextureFromTga(sFileName));
+  }
+
+  ImageData image;
+
+  try {
+    image = decodeImage(sFileName, false);
+  } catch (std::exception const& e) {
+    logger().error("{}", e.what());
+    return nullptr;
+  }
+
+  std::unique_ptr<VistaTexture> result = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
+  result->Bind();
+
+  setTextureParameters(image);
+
+  for (std::size_t level = 0; level < image.mLevels.size(); ++level) {
+    uploadRows(image, level, 0, image.mLevels[level].mHeight);
+  }
+
+  // Files without mip levels get them generated on the GPU.
+  if (image.mLevels.size() == 1 && !image.mCompressed) {
+    glGenerateMipmap(GL_TEXTURE_2D);
   } else {
-    // load with stb image
-    logger().debug("Loading Texture '{}' with stbi.", sFileName);
+    glTexParameteri(
+        GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.mLevels.size() - 1));
+  }
 
-    int width{};
-    int height{};
-    int bpp{};
-    int channels = 4;
+  result->Unbind();
 
-    unsigned char* pixels = stbi_load(sFileName.c_str(), &width, &height, &bpp, channels);
+  return result;
+}
 
-    if (!pixels) {
-      logger().error("Failed to load '{}' with stbi!", sFileName);
-      return nullptr;
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<VistaTexture> TextureLoader::loadFromFileAsync(std::string const& sFileName) {
+  std::string suffix = sFileName.substr(sFileName.rfind('.'));
+
+  // Vista can only load *.tga files directly to the GPU.
+  if (suffix == ".tga") {
+    return loadFromFile(sFileName);
+  }
+
+  auto texture = std::make_shared<VistaTexture>(GL_TEXTURE_2D);
+
+  // Until the first mip level has been uploaded, the texture contains a single transparent texel.
+  std::array<unsigned char, 4> placeholder{};
+  texture->Bind();
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  texture->Unbind();
+
+  PendingTexture pending;
+  pending.mTexture      = texture;
+  pending.mFileName     = sFileName;
+  pending.mDecodedImage = getThreadPool().enqueue(
+      [sFileName]() { return decodeImage(sFileName, true); });
+
+  getPendingTextures().push_back(std::move(pending));
+
+  return texture;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextureLoader::setRequiredWidth(VistaTexture const* texture, double pixels) {
+  for (auto& pending : getPendingTextures()) {
+    if (pending.mTexture.lock().get() == texture) {
+      pending.mRequiredWidth = std::max(pending.mRequiredWidth.value_or(0.0), pixels);
+      return;
     }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    result->UploadTexture(width, height, pixels);
+void TextureLoader::uploadPendingTextures(std::size_t maxBytes) {
+  auto& textures = getPendingTextures();
+  auto  it       = textures.begin();
 
-    stbi_image_free(pixels);
+  while (it != textures.end() && maxBytes > 0) {
+    auto texture = it->mTexture.lock();
+
+    // The texture has been deleted before it has been loaded completely.
+    if (!texture) {
+      it = textures.erase(it);
+      continue;
+    }
+
+    if (!it->mImage) {
+      if (it->mDecodedImage.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        ++it;
+        continue;
+      }
+
+      try {
+        it->mImage = it->mDecodedImage.get();
+        it->mLevel = static_cast<int>(it->mImage->mLevels.size()) - 1;
+        it->mRow   = 0;
+      } catch (std::exception const& e) {
+        logger().error("Failed to load texture '{}': {}", it->mFileName, e.what());
+        it = textures.erase(it);
+        continue;
+      }
+    }
+
+    // Levels of streamed textures which are not needed yet are held back.
+    if (it->mRow == 0 && !isNextLevelRequired(*it)) {
+      ++it;
+      continue;
+    }
+
+    auto& image = *it->mImage;
+    auto& level = image.mLevels.at(static_cast<std::size_t>(it->mLevel));
+
+    // Upload as many rows as the remaining budget allows, but at least one.
+    std::size_t rowSize  = level.mData.size() / static_cast<std::size_t>(level.mHeight);
+    int         rowCount = image.mCompressed
+                               ? level.mHeight
+                               : std::clamp(static_cast<int>(maxBytes / rowSize), 1,
+                                     level.mHeight - it->mRow);
+
+    texture->Bind();
+    uploadRows(image, static_cast<std::size_t>(it->mLevel), it->mRow, rowCount);
+
+    maxBytes -= std::min(maxBytes, rowSize * static_cast<std::size_t>(rowCount));
+    it->mRow += rowCount;
+
+    // Once a level is complete, sampling is restricted to it and the coarser levels.
+    if (it->mRow >= level.mHeight) {
+      setTextureParameters(image);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, it->mLevel);
+      glTexParameteri(
+          GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.mLevels.size() - 1));
+
+      level.mData = {};
+      --it->mLevel;
+      it->mRow = 0;
+    }
+
+    texture->Unbind();
+
+    if (it->mLevel < 0) {
+      logger().debug("Finished uploading texture '{}'.", it->mFileName);
+      it = textures.erase(it);
+    }
   }
+}
 
-  return result;
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TextureLoader::getPendingTextureCount() {
+  return getPendingTextures().size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TextureLoader::getIsPending(VistaTexture const* texture) {
+  auto const& textures = getPendingTextures();
+
+  return std::any_of(textures.begin(), textures.end(), [texture](PendingTexture const& pending) {
+    return pending.mTexture.lock().get() == texture;
+  });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
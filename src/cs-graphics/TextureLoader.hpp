@@ -11,6 +11,7 @@
 #include "cs_graphics_export.hpp"
 
 #include <VistaOGLExt/VistaTexture.h>
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -18,9 +19,42 @@ namespace cs::graphics {
 /// For loading VistaTextures.
 class CS_GRAPHICS_EXPORT TextureLoader {
  public:
-  /// Loads a VistaTexture from the given file. This support *.tga, *.tif, *.hdr as well as all
-  /// image formats supported by stb_image (including *.bmp, *.jpeg and *.png).
+  /// Loads a VistaTexture from the given file. This support *.tga, *.tif, *.hdr, *.dds, *.ktx and
+  /// *.kmg as well as all image formats supported by stb_image (including *.bmp, *.jpeg and
+  /// *.png). The mipmaps stored in *.dds, *.ktx and *.kmg files are used as they are, for all other
+  /// formats they are generated. Returns nullptr if the file cannot be loaded.
   static std::unique_ptr<VistaTexture> loadFromFile(std::string const& sFileName);
+
+  /// Like loadFromFile(), but this returns immediately. The returned texture contains a single
+  /// transparent texel at first. The file is decoded and its mipmaps are computed on a background
+  /// thread. Then uploadPendingTextures() uploads the mip levels during the following frames,
+  /// starting with the coarsest one, so that the texture becomes sharper over time. If loading
+  /// fails, an error is logged and the texture stays transparent. *.tga files are loaded
+  /// synchronously. This has to be called on the main thread.
+  static std::shared_ptr<VistaTexture> loadFromFileAsync(std::string const& sFileName);
+
+  /// Turns a texture returned by loadFromFileAsync() into a streamed texture. Its finer mip levels
+  /// are then only uploaded when they are required for drawing it with the given number of pixels
+  /// along its width, and only if they fit into the remaining budget of the GpuMemory. The
+  /// coarsest level is always uploaded. This can be called every frame, the largest width passed
+  /// so far is used, as uploaded levels are never released. The decoded levels which are held
+  /// back stay in system memory until they are uploaded or the texture is deleted. Textures which
+  /// have been uploaded completely are not affected. This has to be called on the main thread.
+  static void setRequiredWidth(VistaTexture const* texture, double pixels);
+
+  /// Uploads the data of textures returned by loadFromFileAsync(). At most maxBytes are uploaded
+  /// per call, large mip levels are split into several parts. This is called once per frame by
+  /// the GraphicsEngine.
+  static void uploadPendingTextures(std::size_t maxBytes);
+
+  /// Returns the number of textures returned by loadFromFileAsync() which have not been uploaded
+  /// completely yet. This includes streamed textures with levels which are held back.
+  static std::size_t getPendingTextureCount();
+
+  /// Returns true if the given texture has been returned by loadFromFileAsync() and has not been
+  /// uploaded completely yet. This is also false if loading the texture failed. Streamed textures
+  /// stay pending while some of their levels are held back, see setRequiredWidth().
+  static bool getIsPending(VistaTexture const* texture);
 };
 
 } // namespace cs::graphics
@@ -7,7 +7,6 @@
 
 #include "ToneMappingNode.hpp"
 
-#include "../cs-utils/FrameStats.hpp"
 #include "HDRBuffer.hpp"
 
 #include <VistaInterProcComm/Cluster/VistaClusterDataCollect.h>
@@ -24,6 +23,7 @@
 
 #include <glm/glm.hpp>
 #include <limits>
+#include <optional>
 #include <utility>
 
 namespace cs::graphics {
@@ -151,6 +151,15 @@ static const char* sFragmentShader = R"(
 
   uniform float uExposure;
   uniform float uGlareIntensity;
+  uniform bool  uUpscale;
+
+  // With histogram-based auto-exposure, the exposure in EV is computed by the ExposureHistogram of
+  // the HDRBuffer. uExposure then only contains the exposure compensation.
+  #ifdef GPU_AUTO_EXPOSURE
+    layout (std430, binding = 0) readonly buffer Exposure {
+      float uAutoExposure;
+    };
+  #endif
 
   layout(location = 0) out vec3 oColor;
 
@@ -241,6 +250,22 @@ static const char* sFragmentShader = R"(
            (g1(fuv.y) * (g0x * textureLod(tex, p2, lod) + g1x * textureLod(tex, p3, lod)));
   }
 
+  // Bilinear interpolation of the HDR buffer, which uses nearest-neighbor filtering. This is used
+  // if the HDR buffer has a lower resolution than the viewport.
+  vec3 texture2D_bilinear(sampler2D tex, vec2 uv) {
+    ivec2 maxPos = textureSize(tex, 0) - 1;
+    vec2  pos    = uv * textureSize(tex, 0) - 0.5;
+    ivec2 iPos   = ivec2(floor(pos));
+    vec2  f      = pos - iPos;
+
+    vec3 tl = texelFetch(tex, clamp(iPos, ivec2(0), maxPos), 0).rgb;
+    vec3 tr = texelFetch(tex, clamp(iPos + ivec2(1, 0), ivec2(0), maxPos), 0).rgb;
+    vec3 bl = texelFetch(tex, clamp(iPos + ivec2(0, 1), ivec2(0), maxPos), 0).rgb;
+    vec3 br = texelFetch(tex, clamp(iPos + ivec2(1, 1), ivec2(0), maxPos), 0).rgb;
+
+    return mix(mix(tl, tr, f.x), mix(bl, br, f.x), f.y);
+  }
+
   void main() {
     #if NUM_MULTISAMPLES > 0
       vec3 color = vec3(0.0);
@@ -255,7 +280,9 @@ static const char* sFragmentShader = R"(
       }
       gl_FragDepth = depth;
     #else
-      vec3 color = texelFetch(uComposite, ivec2(vTexcoords * textureSize(uComposite, 0)), 0).rgb;
+      vec3 color = uUpscale
+          ? texture2D_bilinear(uComposite, vTexcoords)
+          : texelFetch(uComposite, ivec2(vTexcoords * textureSize(uComposite, 0)), 0).rgb;
       gl_FragDepth = texelFetch(uDepth, ivec2(vTexcoords * textureSize(uDepth, 0)), 0).r;
     #endif
 
@@ -283,19 +310,25 @@ static const char* sFragmentShader = R"(
       color = mix(color, glare/totalWeight, pow(uGlareIntensity, 2.0));
     }
 
+    #ifdef GPU_AUTO_EXPOSURE
+      float exposure = uExposure * exp2(uAutoExposure);
+    #else
+      float exposure = uExposure;
+    #endif
+
     // Filmic
     #if TONE_MAPPING_MODE == 2
-      color = Uncharted2Tonemap(uExposure*color);
+      color = Uncharted2Tonemap(exposure*color);
       vec3 whiteScale = vec3(1.0)/Uncharted2Tonemap(vec3(W));
       oColor = linear_to_srgb(color*whiteScale);
     
     // Gamma only
     #elif TONE_MAPPING_MODE == 1
-      oColor = linear_to_srgb(uExposure*color);
+      oColor = linear_to_srgb(exposure*color);
 
     // None
     #else
-      oColor = uExposure * color;
+      oColor = exposure * color;
     #endif
   }
 )";
@@ -391,7 +424,12 @@ float ToneMappingNode::getExposureAdaptionSpeed() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void ToneMappingNode::setEnableAutoExposure(bool value) {
-  mEnableAutoExposure = value;
+  if (mEnableAutoExposure != value) {
+    mEnableAutoExposure = value;
+    mAutoExposure       = mExposure;
+    mResetExposure      = true;
+    mShaderDirty        = true;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -402,6 +440,35 @@ bool ToneMappingNode::getEnableAutoExposure() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void ToneMappingNode::setAutoExposureMode(AutoExposureMode mode) {
+  if (mAutoExposureMode != mode) {
+    mAutoExposureMode = mode;
+    mAutoExposure     = mExposure;
+    mResetExposure    = true;
+    mShaderDirty      = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ToneMappingNode::AutoExposureMode ToneMappingNode::getAutoExposureMode() const {
+  return mAutoExposureMode;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ToneMappingNode::setAutoExposurePercentiles(glm::vec2 const& percentiles) {
+  mAutoExposurePercentiles = glm::clamp(percentiles, glm::vec2(0.F), glm::vec2(1.F));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec2 const& ToneMappingNode::getAutoExposurePercentiles() const {
+  return mAutoExposurePercentiles;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void ToneMappingNode::setGlareIntensity(float intensity) {
   mGlareIntensity = intensity;
 }
@@ -445,6 +512,10 @@ ToneMappingNode::ToneMappingMode ToneMappingNode::getToneMappingMode() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 float ToneMappingNode::getLastAverageLuminance() const {
+  if (useHistogram()) {
+    return mHDRBuffer->getMeteredAverageLuminance();
+  }
+
   if (mGlobalLuminanceData.mPixelCount > 0 && mGlobalLuminanceData.mTotalLuminance > 0) {
     return mGlobalLuminanceData.mTotalLuminance /
            static_cast<float>(mGlobalLuminanceData.mPixelCount);
@@ -455,6 +526,10 @@ float ToneMappingNode::getLastAverageLuminance() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 float ToneMappingNode::getLastMaximumLuminance() const {
+  if (useHistogram()) {
+    return mHDRBuffer->getMeteredMaximumLuminance();
+  }
+
   if (mGlobalLuminanceData.mMaximumLuminance > 0) {
     return mGlobalLuminanceData.mMaximumLuminance;
   }
@@ -465,8 +540,6 @@ float ToneMappingNode::getLastMaximumLuminance() const {
 
 bool ToneMappingNode::ToneMappingNode::Do() {
 
-  utils::FrameStats::ScopedTimer timer("Tonemapping");
-
   if (mShaderDirty) {
 
     std::string defines = "#version 430\n";
@@ -479,6 +552,10 @@ bool ToneMappingNode::ToneMappingNode::Do() {
     defines +=
         "#define TONE_MAPPING_MODE " + std::to_string(static_cast<int>(mToneMappingMode)) + "\n";
 
+    if (useHistogram()) {
+      defines += "#define GPU_AUTO_EXPOSURE\n";
+    }
+
     mShader = std::make_unique<VistaGLSLShader>();
     mShader->InitVertexShaderFromString(defines + sVertexShader);
     mShader->InitFragmentShaderFromString(defines + sFragmentShader);
@@ -486,22 +563,42 @@ bool ToneMappingNode::ToneMappingNode::Do() {
 
     mUniforms.exposure       = mShader->GetUniformLocation("uExposure");
     mUniforms.glareIntensity = mShader->GetUniformLocation("uGlareIntensity");
+    mUniforms.upscale        = mShader->GetUniformLocation("uUpscale");
 
     mShaderDirty = false;
   }
 
+  // This has to happen first, as the luminance and the glare should be computed from the
+  // anti-aliased image.
+  mHDRBuffer->resolveTemporalAntiAliasing();
+
   bool doCalculateExposure =
       GetVistaSystem()->GetDisplayManager()->GetCurrentRenderInfo()->m_eEyeRenderMode !=
       VistaDisplayManager::RenderInfo::ERM_RIGHT;
 
-  if (doCalculateExposure && mEnableAutoExposure) {
+  // The histogram-based auto-exposure is computed entirely on the GPU. We only read back the
+  // exposure of a previous frame for the user interface.
+  if (doCalculateExposure && useHistogram()) {
+    auto  frameTime = static_cast<float>(GetVistaSystem()->GetFrameLoop()->GetAverageLoopTime());
+    float adaption  = 1.F - std::exp(-mExposureAdaptionSpeed * frameTime);
+
+    std::optional<float> resetExposure;
+    if (mResetExposure) {
+      resetExposure = mExposure;
+    }
+
+    mHDRBuffer->calculateExposure(glm::vec2(mMinAutoExposure, mMaxAutoExposure),
+        mAutoExposurePercentiles, adaption, resetExposure);
+    mExposure = mHDRBuffer->getExposure();
+
+  } else if (doCalculateExposure && mEnableAutoExposure) {
     mHDRBuffer->calculateLuminance();
 
     // We accumulate all luminance values of this frame (can be multiple viewports and / or multiple
     // eyes). These values will be send to the master in VSE_POSTGRAPHICS and accumulated for all
     // clients. The result is stored in mGlobalLuminanceData and is in the next frame used for
     // exposure calculation
-    auto size = mHDRBuffer->getCurrentViewPortSize();
+    auto size = mHDRBuffer->getCurrentSize();
     mLocalLuminanceData.mPixelCount += size.at(0) * size.at(1);
     mLocalLuminanceData.mTotalLuminance += mHDRBuffer->getTotalLuminance();
     mLocalLuminanceData.mMaximumLuminance += mHDRBuffer->getMaximumLuminance();
@@ -520,11 +617,17 @@ bool ToneMappingNode::ToneMappingNode::Do() {
     mHDRBuffer->updateGlareMipMap();
   }
 
-  if (doCalculateExposure && mEnableAutoExposure) {
+  if (doCalculateExposure && mEnableAutoExposure && !useHistogram()) {
     mExposure = glm::clamp(mAutoExposure, mMinAutoExposure, mMaxAutoExposure);
   }
 
-  float exposure = std::pow(2.F, mExposure + mExposureCompensation);
+  float exposure = std::pow(2.F, mExposureCompensation);
+
+  if (useHistogram()) {
+    mHDRBuffer->bindExposureBuffer(0);
+  } else {
+    exposure *= std::pow(2.F, mExposure);
+  }
 
   mHDRBuffer->unbind();
   mHDRBuffer->getCurrentWriteAttachment()->Bind(GL_TEXTURE0);
@@ -534,14 +637,26 @@ bool ToneMappingNode::ToneMappingNode::Do() {
   mShader->Bind();
   mShader->SetUniform(mUniforms.exposure, exposure);
   mShader->SetUniform(mUniforms.glareIntensity, mGlareIntensity);
+  mShader->SetUniform(
+      mUniforms.upscale, static_cast<int>(mHDRBuffer->getResolutionScale() < 1.F));
 
   glDrawArrays(GL_TRIANGLES, 0, 3);
 
+  if (useHistogram()) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  }
+
   return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool ToneMappingNode::useHistogram() const {
+  return mEnableAutoExposure && mAutoExposureMode == AutoExposureMode::eHistogram;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool ToneMappingNode::GetBoundingBox(VistaBoundingBox& oBoundingBox) {
   float      min(std::numeric_limits<float>::min());
   float      max(std::numeric_limits<float>::max());
@@ -561,6 +676,9 @@ void ToneMappingNode::HandleEvent(VistaEvent* pEvent) {
   // accumulated for all clients. The result is stored in mGlobalLuminanceData and is in the next
   // frame used for exposure calculation.
   if (pEvent->GetId() == VistaSystemEvent::VSE_POSTGRAPHICS) {
+    // All viewports have been reset to the current exposure during this frame.
+    mResetExposure = false;
+
     std::vector<std::vector<VistaType::byte>> globalData;
     std::vector<VistaType::byte>              localData(sizeof(LuminanceData));
 
@@ -14,6 +14,7 @@
 
 #include <VistaKernel/EventManager/VistaEventHandler.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <glm/glm.hpp>
 #include <memory>
 
 class VistaGLSLShader;
@@ -27,11 +28,21 @@ namespace cs::graphics {
 /// Auto-exposure is implemented using the LuminanceMipMap of the HDRBuffer, an artificial glare can
 /// be added using the GlareMipMap of the HDRBuffer.
 /// In order to compute the exposure when auto-exposure is enabled, the total luminance values of
-/// all connected cluster slaves are taken into account.
+/// all connected cluster slaves are taken into account. Alternatively, the exposure can be computed
+/// from a luminance histogram entirely on the GPU using the ExposureHistogram of the HDRBuffer. In
+/// this case, each viewport is metered on its own, so cluster setups which need a consistent
+/// exposure across all displays should use AutoExposureMode::eAverage.
+/// If the HDRBuffer has a lower resolution than the viewport, it is upscaled with bilinear
+/// filtering.
 class CS_GRAPHICS_EXPORT ToneMappingNode : public IVistaOpenGLDraw, public VistaEventHandler {
  public:
   enum class ToneMappingMode { eNone = 0, eGammaOnly = 1, eFilmic = 2 };
 
+  /// eAverage reads the average luminance of all viewports back to the CPU and synchronizes it
+  /// across the cluster, eHistogram meters each viewport on the GPU and ignores the darkest and
+  /// brightest pixels as given by the auto-exposure percentiles.
+  enum class AutoExposureMode { eAverage = 0, eHistogram = 1 };
+
   /// The node will draw to the backbuffer using the contents from the given HDRBuffer.
   explicit ToneMappingNode(std::shared_ptr<HDRBuffer> hdrBuffer);
 
@@ -72,6 +83,17 @@ class CS_GRAPHICS_EXPORT ToneMappingNode : public IVistaOpenGLDraw, public Vista
   void setEnableAutoExposure(bool value);
   bool getEnableAutoExposure() const;
 
+  /// Selects how the auto-exposure is computed. When this is changed, the adaption starts from the
+  /// current exposure.
+  void             setAutoExposureMode(AutoExposureMode mode);
+  AutoExposureMode getAutoExposureMode() const;
+
+  /// The histogram-based auto-exposure averages the logarithmic luminance of all pixels between
+  /// these two percentiles. Both values are clamped to [0, 1]. The default range excludes the
+  /// darker half of the image and the brightest five percent of the pixels.
+  void             setAutoExposurePercentiles(glm::vec2 const& percentiles);
+  glm::vec2 const& getAutoExposurePercentiles() const;
+
   /// Controls the amount of artificial glare. Should be in the range [0-1]. If set to zero, the
   /// GlareMipMap will not be updated which will increase performance.
   void  setGlareIntensity(float intensity);
@@ -86,7 +108,8 @@ class CS_GRAPHICS_EXPORT ToneMappingNode : public IVistaOpenGLDraw, public Vista
   void            setToneMappingMode(ToneMappingMode mode);
   ToneMappingMode getToneMappingMode() const;
 
-  /// Returns the average and maximum luminance across all connected cluster nodes.
+  /// Returns the average and maximum luminance across all connected cluster nodes. In histogram
+  /// mode, these are the values of the last metered viewport of this node.
   float getLastAverageLuminance() const;
   float getLastMaximumLuminance() const;
 
@@ -96,6 +119,8 @@ class CS_GRAPHICS_EXPORT ToneMappingNode : public IVistaOpenGLDraw, public Vista
   void HandleEvent(VistaEvent* event) override;
 
  private:
+  bool useHistogram() const;
+
   std::shared_ptr<HDRBuffer> mHDRBuffer;
 
   bool            mShaderDirty              = true;
@@ -110,6 +135,10 @@ class CS_GRAPHICS_EXPORT ToneMappingNode : public IVistaOpenGLDraw, public Vista
   bool            mEnableBicubicGlareFilter = true;
   ToneMappingMode mToneMappingMode          = ToneMappingMode::eFilmic;
 
+  AutoExposureMode mAutoExposureMode        = AutoExposureMode::eHistogram;
+  glm::vec2        mAutoExposurePercentiles = glm::vec2(0.5F, 0.95F);
+  bool             mResetExposure           = true;
+
   std::unique_ptr<VistaGLSLShader> mShader;
 
   struct LuminanceData {
@@ -122,6 +151,7 @@ class CS_GRAPHICS_EXPORT ToneMappingNode : public IVistaOpenGLDraw, public Vista
     uint32_t exposure       = 0;
     uint32_t glareIntensity = 0;
     uint32_t glareQuality   = 0;
+    uint32_t upscale        = 0;
   } mUniforms;
 
   LuminanceData mLocalLuminanceData;
@@ -11,7 +11,9 @@
 #include <GL/glew.h>
 
 #include "../../cs-utils/FrameStats.hpp"
+#include "../../cs-utils/filesystem.hpp"
 #include "../logger.hpp"
+#include "mesh_optimizer.hpp"
 #include "pbr_fragment_shader.hpp"
 #include "pbr_vertex_shader.hpp"
 #include "stb_image_helper.hpp"
@@ -23,8 +25,13 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaMath/VistaBoundingBox.h>
 #include <algorithm>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstring>
 #include <fstream>
+#include <future>
 #include <gli/gli.hpp>
+#include <set>
 #include <utility>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -55,31 +62,18 @@ tinygltf::Sampler defaultTinygltfSampler() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const char* vertex_shader_source = R"(
-#version 330
-out vec2 texCoord;
-void main() {
-  texCoord = vec2(float(gl_VertexID / 2) * 2.0, float(gl_VertexID % 2) * 2.0);
-  gl_Position = vec4 (float(gl_VertexID / 2) * 4 - 1, float(gl_VertexID % 2) * 4 - 1, 0, 1);
-}
-)";
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-const char* filter_fragment_source = R"(
+const char* compute_prefilter_ggx = R"(
 #version 430
 #extension GL_NV_shadow_samplers_cube : enable
+layout (rgba16f, binding = 0) writeonly uniform imageCube u_OutputCubemap;
+layout (local_size_x = 16, local_size_y = 16) in;
 
 uniform samplerCube u_InputCubemap;
 uniform int u_Level;
 uniform int u_MipLevels;
-uniform int u_Face;
-
-in vec2 texCoord;
 
 #define saturate(x) clamp(x, 0, 1)
 #define PI 3.14159265359
-out vec4 FragColor;
 
 vec3 sRGB_to_linear2(vec3 c)
 {
@@ -184,35 +178,42 @@ vec3 remapSign[6] = vec3[](
   vec3( -1, -1, -1)
 );
 
-ivec3 Index = remapIndices[u_Face];
-vec3 Sign = remapSign[u_Face];
-
 void main() {
+  ivec3 storePos = ivec3(gl_GlobalInvocationID);
+  ivec2 size = imageSize(u_OutputCubemap);
+
+  if (storePos.x >= size.x || storePos.y >= size.y) {
+      return;
+  }
+
+  // The z component of the invocation ID selects the face of the cubemap.
+  ivec3 Index = remapIndices[storePos.z];
+  vec3 Sign = remapSign[storePos.z];
+  vec2 texCoord = (vec2(storePos.xy) + vec2(0.5)) / vec2(size);
+
   float Roughness = float(u_Level) / float(u_MipLevels);
 
   vec3 dir = vec3(texCoord * 2.0 - 1.0, 1.0);
   vec3 R = Sign * vec3(dir[Index.x], dir[Index.y], dir[Index.z]);
   R = normalize(R);
 
-  FragColor = vec4(PrefilterEnvMap(Roughness, R), 1.0);
+  imageStore(u_OutputCubemap, storePos, vec4(PrefilterEnvMap(Roughness, R), 1.0));
 }
 )";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const char* irradiance_fragment_source = R"(
+const char* compute_irradiance = R"(
 #version 430
 #extension GL_NV_shadow_samplers_cube : enable
+layout (rgba16f, binding = 0) writeonly uniform imageCube u_OutputCubemap;
+layout (local_size_x = 16, local_size_y = 16) in;
 
 uniform samplerCube u_InputCubemap;
-uniform int u_Face;
 
 #define saturate(x) clamp(x, 0, 1)
 #define PI 3.14159265359
 
-in vec2 texCoord;
-out vec4 FragColor;
-
 vec3 sRGB_to_linear(vec3 c)
 {
   return mix(vec3(c * (1.0 / 12.92)),
@@ -238,10 +239,19 @@ vec3 remapSign[6] = vec3[](
   vec3( -1, -1, -1)
 );
 
-ivec3 Index = remapIndices[u_Face];
-vec3 Sign = remapSign[u_Face];
-
 void main() {
+  ivec3 storePos = ivec3(gl_GlobalInvocationID);
+  ivec2 size = imageSize(u_OutputCubemap);
+
+  if (storePos.x >= size.x || storePos.y >= size.y) {
+      return;
+  }
+
+  // The z component of the invocation ID selects the face of the cubemap.
+  ivec3 Index = remapIndices[storePos.z];
+  vec3 Sign = remapSign[storePos.z];
+  vec2 texCoord = (vec2(storePos.xy) + vec2(0.5)) / vec2(size);
+
   vec3 dir = vec3(texCoord * 2.0 - 1.0, 1.0);
   vec3 R = Sign * vec3(dir[Index.x], dir[Index.y], dir[Index.z]);
   R = normalize(R);
@@ -271,7 +281,7 @@ void main() {
   }
   irradiance = PI * irradiance * (1.0 / float(nrSamples));
 
-  FragColor = vec4(irradiance, 1.0);
+  imageStore(u_OutputCubemap, storePos, vec4(irradiance, 1.0));
 }
 )";
 
@@ -417,20 +427,6 @@ GLuint createShader(GLenum shaderType, std::string const& srcbuf) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int createProgram(const char* vs, const char* fs) {
-  auto vsh = createShader(GL_VERTEX_SHADER, vs);
-  auto fsh = createShader(GL_FRAGMENT_SHADER, fs);
-  auto p   = glCreateProgram();
-  glAttachShader(p, vsh);
-  glAttachShader(p, fsh);
-  glLinkProgram(p);
-  glDeleteShader(vsh);
-  glDeleteShader(fsh);
-  return p;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 GLuint createCompute(const char* cs) {
   auto sh      = createShader(GL_COMPUTE_SHADER, cs);
   auto program = glCreateProgram();
@@ -549,6 +545,9 @@ GLProgramInfo getProgramInfo(unsigned int program) {
   info.u_ModelMatrix_loc  = glGetUniformLocation(program, "u_ModelMatrix");
   info.u_NormalMatrix_loc = glGetUniformLocation(program, "u_NormalMatrix");
 
+  info.u_UseInstances_loc         = glGetUniformLocation(program, "u_UseInstances");
+  info.u_ViewProjectionMatrix_loc = glGetUniformLocation(program, "u_ViewProjectionMatrix");
+
   info.u_LightDirection_loc = glGetUniformLocation(program, "u_LightDirection");
   info.u_LightColor_loc     = glGetUniformLocation(program, "u_LightColor");
   info.u_EnableHDR_loc      = glGetUniformLocation(program, "u_EnableHDR");
@@ -610,6 +609,23 @@ Buffer getOrCreateBufferObject(std::map<int, Buffer>& bufferMap, tinygltf::Model
   return {target, ptr};
 }
 
+std::shared_ptr<GLuint> createCubemapSampler() {
+  std::shared_ptr<GLuint> sampler(new GLuint(0), [](GLuint* ptr) {
+    if (*ptr != 0u) {
+      glDeleteSamplers(1, ptr);
+    }
+  });
+  glGenSamplers(1, sampler.get());
+  glSamplerParameteri(*sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glSamplerParameteri(*sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glSamplerParameteri(*sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glSamplerParameteri(*sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glSamplerParameteri(*sampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  return sampler;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Texture uploadCubemap(gli::texture_cube const& gliTex) {
   gli::gl GL(gli::gl::PROFILE_GL33);
   auto    format = GL.translate(gliTex.format(), gliTex.swizzles());
@@ -655,216 +671,124 @@ Texture uploadCubemap(gli::texture_cube const& gliTex) {
   glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
   CheckGLErrors("uploadCubemap");
 
-  std::shared_ptr<GLuint> specularEnvMapSampler(new GLuint(0), [](GLuint* ptr) {
-    if (*ptr != 0u) {
-      glDeleteSamplers(1, ptr);
-    }
-  });
-  glGenSamplers(1, specularEnvMapSampler.get());
-  glSamplerParameteri(*specularEnvMapSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  //*specularEnvMapSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glSamplerParameteri(*specularEnvMapSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glSamplerParameteri(*specularEnvMapSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glSamplerParameteri(*specularEnvMapSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glSamplerParameteri(*specularEnvMapSampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-  return Texture{GL_TEXTURE_CUBE_MAP, specularEnvMapSampler, ptr};
+  return Texture{GL_TEXTURE_CUBE_MAP, createCubemapSampler(), ptr};
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-gli::texture_cube prefilterCubemapGGX(gli::texture_cube const& inputCubemap, std::size_t levels) {
-  auto vao = 0U;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
-
-  auto program = createProgram(vertex_shader_source, filter_fragment_source);
-  glUseProgram(static_cast<GLuint>(program));
-  CheckGLErrors("after glUseProgram");
-  auto info        = get_active_uniforms(static_cast<GLuint>(program));
-  auto uniformVars = info.first;
-  auto textureVars = info.second;
-
-  auto inputCubemapTex = uploadCubemap(inputCubemap);
-
-  auto formatInternal = gli::gl::internal_format::INTERNAL_RGB16F;
-  auto formatExternal = gli::gl::external_format::EXTERNAL_RGB;
-  auto formatType     = gli::gl::type_format::TYPE_F16;
+// Creates an uninitialized RGBA16F cubemap. This is used as output image for the filtering compute
+// shaders, image load / store does not support three-channel formats.
+Texture createCubemap(int width, int height, std::size_t levels) {
+  std::shared_ptr<GLuint> ptr(new GLuint(0), [](GLuint* ptr) {
+    if (*ptr != 0u) {
+      glDeleteTextures(1, ptr);
+    }
+  });
+  glGenTextures(1, ptr.get());
+  glBindTexture(GL_TEXTURE_CUBE_MAP, *ptr);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+  glTexStorage2D(GL_TEXTURE_CUBE_MAP, static_cast<GLsizei>(levels), GL_RGBA16F, width, height);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  CheckGLErrors("createCubemap");
 
-  gli::gl GL(gli::gl::PROFILE_GL33);
-  auto    gliFormat = GL.find(formatInternal, formatExternal, formatType);
+  return Texture{GL_TEXTURE_CUBE_MAP, createCubemapSampler(), ptr};
+}
 
-  auto width  = inputCubemap.extent().x;
-  auto height = inputCubemap.extent().y;
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  gli::texture_cube filteredGliTex(gliFormat, glm::ivec2(width, height), levels);
+// Runs the given filtering compute shader for each mip level of the output cubemap. All six faces
+// of a level are written by a single dispatch, the shader selects the face with
+// gl_GlobalInvocationID.z. If a uniform "u_Level" exists, it is set to the current level.
+Texture filterCubemap(GLuint program, Texture const& inputCubemapTex, int width, int height,
+    std::size_t levels) {
 
-  auto it = textureVars.find("u_InputCubemap");
-  if (it != textureVars.end()) {
+  // The result stays on the GPU, it is written directly into the texture which is used for
+  // shading.
+  auto outputCubemapTex = createCubemap(width, height, levels);
 
-    auto fbo = 0U;
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glUseProgram(program);
 
-    auto outputCubemapTex = uploadCubemap(filteredGliTex);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X,
-        *outputCubemapTex.image, 0);
-    GLenum drawBuffers = GL_COLOR_ATTACHMENT0;
-    glDrawBuffers(1, &drawBuffers);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(inputCubemapTex.target, *inputCubemapTex.image);
+  glBindSampler(0, *inputCubemapTex.sampler);
+  glUniform1i(glGetUniformLocation(program, "u_InputCubemap"), 0);
 
-    if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_FRAMEBUFFER)) {
-      logger().error("Failed to filter GLTF cubemap: Invalid FBO!");
-    }
+  auto levelLocation = glGetUniformLocation(program, "u_Level");
 
-    auto inputCubemapTexVar = it->second;
-    glActiveTexture(GL_TEXTURE0 + inputCubemapTexVar.unit);
-    glBindTexture(inputCubemapTex.target, *inputCubemapTex.image);
-    glBindSampler(inputCubemapTexVar.unit, *inputCubemapTex.sampler);
+  for (std::size_t level = 0; level < levels; ++level) {
+    auto extent = glm::max(glm::ivec2(width, height) >> static_cast<int>(level), 1);
 
-    auto mipLevelsIterator = uniformVars.find("u_MipLevels");
-    if (mipLevelsIterator != uniformVars.end()) {
-      glUniform1i(mipLevelsIterator->second.location, static_cast<GLint>(levels));
+    if (levelLocation >= 0) {
+      glUniform1i(levelLocation, static_cast<GLint>(level));
     }
 
-    for (std::size_t level = 0; level < levels; ++level) {
-      auto extent         = filteredGliTex.extent(level);
-      auto uLevelIterator = uniformVars.find("u_Level");
-      if (uLevelIterator != uniformVars.end()) {
-        glUniform1i(uLevelIterator->second.location, static_cast<GLint>(level));
-      }
-
-      for (std::size_t face = 0; face < 6; ++face) {
-        auto target = static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target,
-            *outputCubemapTex.image, static_cast<GLint>(level));
-
-        uLevelIterator = uniformVars.find("u_Face");
-        if (uLevelIterator != uniformVars.end()) {
-          glUniform1i(uLevelIterator->second.location, static_cast<GLint>(face));
-        }
+    glBindImageTexture(0, *outputCubemapTex.image, static_cast<GLint>(level), GL_TRUE, 0,
+        GL_WRITE_ONLY, GL_RGBA16F);
+    glDispatchCompute(static_cast<GLuint>(extent.x + 15) / 16,
+        static_cast<GLuint>(extent.y + 15) / 16, 6);
+  }
 
-        glViewport(0, 0, extent.x, extent.y);
-        glScissor(0, 0, extent.x, extent.y);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-      }
-    }
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+  glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
 
-    glActiveTexture(GL_TEXTURE0 + inputCubemapTexVar.unit);
-    glBindTexture(inputCubemapTex.target, 0);
-    glBindSampler(inputCubemapTexVar.unit, 0);
+  glBindTexture(inputCubemapTex.target, 0);
+  glBindSampler(0, 0);
+  glUseProgram(0);
+  CheckGLErrors("filterCubemap");
 
-    glUseProgram(0);
-    glBindVertexArray(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(1, &fbo);
-
-    // Fetch cubemap
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(outputCubemapTex.target, *outputCubemapTex.image);
-    for (std::size_t level = 0; level < filteredGliTex.levels(); ++level) {
-      for (std::size_t face = 0; face < filteredGliTex.faces(); ++face) {
-        auto target = static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face);
-        glGetTexImage(target, static_cast<GLint>(level), formatExternal,
-            formatType, // GL_FLOAT,
-            filteredGliTex[face][level].data());
-        CheckGLErrors("after glGetTexImage");
-      }
-    }
-    glBindTexture(outputCubemapTex.target, 0);
-  }
-  glDeleteVertexArrays(1, &vao);
-  glDeleteProgram(static_cast<GLuint>(program));
-  return filteredGliTex;
+  return outputCubemapTex;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-gli::texture_cube irradianceCubemap(gli::texture_cube const& inputCubemap, int width, int height) {
-  GLuint vao = 0;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
-
-  auto program = createProgram(vertex_shader_source, irradiance_fragment_source);
-  glUseProgram(static_cast<GLuint>(program));
-  CheckGLErrors("after glUseProgram");
-  auto info        = get_active_uniforms(static_cast<GLuint>(program));
-  auto uniformVars = info.first;
-  auto textureVars = info.second;
-
-  auto inputCubemapTex = uploadCubemap(inputCubemap);
-
-  auto formatInternal = gli::gl::internal_format::INTERNAL_RGB16F;
-  auto formatExternal = gli::gl::external_format::EXTERNAL_RGB;
-  auto formatType     = gli::gl::type_format::TYPE_F16;
+Texture prefilterCubemapGGX(
+    Texture const& inputCubemapTex, int width, int height, std::size_t levels) {
+  auto program = createCompute(compute_prefilter_ggx);
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "u_MipLevels"), static_cast<GLint>(levels));
 
-  gli::gl GL(gli::gl::PROFILE_GL33);
-  auto    gliFormat = GL.find(formatInternal, formatExternal, formatType);
+  auto outputCubemapTex = filterCubemap(program, inputCubemapTex, width, height, levels);
 
-  gli::texture_cube filteredGliTex(gliFormat, glm::ivec2(width, height), 1);
+  glDeleteProgram(program);
+  return outputCubemapTex;
+}
 
-  auto it = textureVars.find("u_InputCubemap");
-  if (it != textureVars.end()) {
-    auto fbo = 0U;
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    auto outputCubemapTex = uploadCubemap(filteredGliTex);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X,
-        *outputCubemapTex.image, 0);
-    GLenum drawBuffers = GL_COLOR_ATTACHMENT0;
-    glDrawBuffers(1, &drawBuffers);
+Texture irradianceCubemap(Texture const& inputCubemapTex, int width, int height) {
+  auto program          = createCompute(compute_irradiance);
+  auto outputCubemapTex = filterCubemap(program, inputCubemapTex, width, height, 1);
 
-    if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_FRAMEBUFFER)) {
-      logger().error("Failed to filter GLTF cubemap: Invalid FBO!");
-    }
+  glDeleteProgram(program);
+  return outputCubemapTex;
+}
 
-    auto inputCubemapTexVar = it->second;
-    glActiveTexture(GL_TEXTURE0 + inputCubemapTexVar.unit);
-    glBindTexture(inputCubemapTex.target, *inputCubemapTex.image);
-    glBindSampler(inputCubemapTexVar.unit, *inputCubemapTex.sampler);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    auto level = 0;
-    for (auto face = 0U; face < 6U; ++face) {
-      auto target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
-      glFramebufferTexture2D(
-          GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target, *outputCubemapTex.image, level);
+// Reads a cubemap which has been created with createCubemap() back from the GPU. This is only done
+// once for storing the filtered environment maps on disk.
+gli::texture_cube downloadCubemap(Texture const& cubemapTex, int width, int height,
+    std::size_t levels) {
+  gli::texture_cube result(gli::FORMAT_RGBA16_SFLOAT_PACK16, gli::extent2d(width, height), levels);
 
-      auto faceIterator = uniformVars.find("u_Face");
-      if (faceIterator != uniformVars.end()) {
-        glUniform1i(faceIterator->second.location, face);
-      }
+  glBindTexture(GL_TEXTURE_CUBE_MAP, *cubemapTex.image);
 
-      glViewport(0, 0, width, height);
-      glScissor(0, 0, width, height);
-      glDrawArrays(GL_TRIANGLES, 0, 3);
+  for (std::size_t level = 0; level < levels; ++level) {
+    for (std::size_t face = 0; face < 6; ++face) {
+      auto target = static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face);
+      glGetTexImage(target, static_cast<GLint>(level), GL_RGBA, GL_HALF_FLOAT,
+          result.data(0, face, level));
     }
+  }
 
-    glActiveTexture(GL_TEXTURE0 + inputCubemapTexVar.unit);
-    glBindTexture(inputCubemapTex.target, 0);
-    glBindSampler(inputCubemapTexVar.unit, 0);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  CheckGLErrors("downloadCubemap");
 
-    glUseProgram(0);
-    glBindVertexArray(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(1, &fbo);
-
-    // Fetch cubemap
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(outputCubemapTex.target, *outputCubemapTex.image);
-    for (auto lvl = 0U; lvl < filteredGliTex.levels(); ++lvl) {
-      for (auto face = 0U; face < filteredGliTex.faces(); ++face) {
-        auto target = static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face);
-        glGetTexImage(target, lvl, formatExternal,
-            formatType, // GL_FLOAT,
-            filteredGliTex[face][lvl].data());
-        CheckGLErrors("after glGetTexImage");
-      }
-    }
-    glBindTexture(outputCubemapTex.target, 0);
-  }
-  glDeleteVertexArrays(1, &vao);
-  glDeleteProgram(static_cast<GLuint>(program));
-  return filteredGliTex;
+  return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -966,10 +890,17 @@ Texture createBrdfLUT(int width, int height) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GltfShared::buildMeshes(tinygltf::Model const& gltf) {
-  for (auto const& gltfMesh : gltf.meshes) {
-    Mesh mesh;
-    for (auto const& primitive : gltfMesh.primitives) {
+void GltfResources::buildMeshes(
+    tinygltf::Model const& gltf, std::vector<std::vector<std::vector<PrimitiveLod>>> const& lods) {
+
+  // Buffer views which are used by several primitives are uploaded only once.
+  std::map<int, Buffer> bufferMap;
+
+  for (std::size_t m = 0; m < gltf.meshes.size(); ++m) {
+    auto const& gltfMesh = gltf.meshes[m];
+    Mesh        mesh;
+    for (std::size_t p = 0; p < gltfMesh.primitives.size(); ++p) {
+      auto const& primitive = gltfMesh.primitives[p];
       auto it = primitive.attributes.find("POSITION");
 
       if (it != primitive.attributes.end()) {
@@ -987,7 +918,7 @@ void GltfShared::buildMeshes(tinygltf::Model const& gltf) {
           mesh.maxPos[2] = std::max(mesh.maxPos[2], float(a.maxValues[2]));
         }
       }
-      mesh.primitives.push_back(createMeshPrimitive(gltf, primitive));
+      mesh.primitives.push_back(createMeshPrimitive(gltf, primitive, lods.at(m).at(p), bufferMap));
     }
     mMeshes.push_back(mesh);
   }
@@ -995,12 +926,14 @@ void GltfShared::buildMeshes(tinygltf::Model const& gltf) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Primitive GltfShared::createMeshPrimitive(
-    tinygltf::Model const& gltf, tinygltf::Primitive const& primitive) {
+Primitive GltfResources::createMeshPrimitive(tinygltf::Model const& gltf,
+    tinygltf::Primitive const& primitive, std::vector<PrimitiveLod> const& lods,
+    std::map<int, Buffer>& bufferMap) {
   Primitive myPrimitive;
   myPrimitive.hasIndices = primitive.indices >= 0;
 
-  std::string definesVS = "#version 330\n";
+  // The vertex shader reads the instance transformations from a shader storage buffer.
+  std::string definesVS = "#version 430\n";
   std::string definesFS = "#version 330\n";
 
   definesFS += "#define USE_IBL\n#define USE_TEX_LOD\n";
@@ -1108,7 +1041,6 @@ Primitive GltfShared::createMeshPrimitive(
   glBindVertexArray(*myPrimitive.vaoPtr);
 
   // Assume TEXTURE_2D target for the texture object.
-  std::map<int, Buffer> bufferMap;
   for (auto const& pair : primitive.attributes) {
     auto const&               attrName = pair.first;
     tinygltf::Accessor const& accessor = gltf.accessors[pair.second];
@@ -1142,6 +1074,7 @@ Primitive GltfShared::createMeshPrimitive(
     myPrimitive.indicesCount = indexAccessor.count,
     myPrimitive.indicesType  = indexAccessor.componentType,
     myPrimitive.byteOffset   = indexAccessor.byteOffset;
+    myPrimitive.indexBuffer  = buffer.id;
   }
 
   // done recording VAO
@@ -1154,6 +1087,23 @@ Primitive GltfShared::createMeshPrimitive(
     }
   }
 
+  // The levels of detail are not part of the VAO, they are bound when they are drawn.
+  for (auto const& lod : lods) {
+    auto ptr = std::shared_ptr<GLuint>(new GLuint(0), [](GLuint* ptr) {
+      if (*ptr != 0u) {
+        glDeleteBuffers(1, ptr);
+      }
+    });
+
+    glGenBuffers(1, ptr.get());
+    glBindBuffer(GL_ARRAY_BUFFER, *ptr);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(lod.mIndices.size() * sizeof(uint32_t)),
+        lod.mIndices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    myPrimitive.lods.push_back({ptr, lod.mIndices.size(), lod.mError});
+  }
+
   CheckGLErrors("createMeshPrimitive");
   return myPrimitive;
 }
@@ -1162,7 +1112,7 @@ Primitive GltfShared::createMeshPrimitive(
 
 // Hierarchically draw nodes
 void Primitive::draw(glm::mat4 const& projMat, glm::mat4 const& viewMat, glm::mat4 const& modelMat,
-    GltfShared const& shared) const {
+    GltfShared const& shared, float maxError) const {
   if (programPtr) {
     glUseProgram(*programPtr);
   }
@@ -1175,6 +1125,17 @@ void Primitive::draw(glm::mat4 const& projMat, glm::mat4 const& viewMat, glm::ma
   glUniformMatrix3fv(programInfo.u_NormalMatrix_loc, 1, GL_FALSE, glm::value_ptr(normalMat));
 
   glUniformMatrix4fv(programInfo.u_MVPMatrix_loc, 1, GL_FALSE, glm::value_ptr(mvp));
+
+  auto instanceCount = static_cast<GLsizei>(shared.mInstanceCount);
+  glUniform1i(programInfo.u_UseInstances_loc, instanceCount > 0);
+
+  if (instanceCount > 0) {
+    auto viewProjection = projMat * viewMat;
+    glUniformMatrix4fv(
+        programInfo.u_ViewProjectionMatrix_loc, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, *shared.mInstanceBuffer);
+  }
+
   glUniform3fv(programInfo.u_LightDirection_loc, 1, glm::value_ptr(shared.m_lightDirection));
   glUniform3fv(programInfo.u_LightColor_loc, 1,
       glm::value_ptr(shared.m_lightColor * shared.m_lightIntensity));
@@ -1202,17 +1163,35 @@ void Primitive::draw(glm::mat4 const& projMat, glm::mat4 const& viewMat, glm::ma
 
   if (vaoPtr) {
     glBindVertexArray(*vaoPtr);
-    if (hasIndices) {
-      glDrawElements(static_cast<GLenum>(mode), static_cast<GLsizei>(indicesCount),
+
+    Lod const* lod = nullptr;
+    for (auto const& l : lods) {
+      if (l.error <= maxError) {
+        lod = &l;
+      }
+    }
+
+    if (lod) {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *lod->indexBuffer);
+      glDrawElementsInstanced(static_cast<GLenum>(mode), static_cast<GLsizei>(lod->indicesCount),
+          GL_UNSIGNED_INT, nullptr, std::max(instanceCount, 1));
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *indexBuffer);
+    } else if (hasIndices) {
+      glDrawElementsInstanced(static_cast<GLenum>(mode), static_cast<GLsizei>(indicesCount),
           static_cast<GLenum>(indicesType),
           // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          static_cast<char*>(nullptr) + byteOffset);
+          static_cast<char*>(nullptr) + byteOffset, std::max(instanceCount, 1));
     } else {
-      glDrawArrays(static_cast<GLenum>(mode), 0, static_cast<GLsizei>(verticesCount));
+      glDrawArraysInstanced(static_cast<GLenum>(mode), 0, static_cast<GLsizei>(verticesCount),
+          std::max(instanceCount, 1));
     }
     glBindVertexArray(0);
   }
 
+  if (instanceCount > 0) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  }
+
   for (auto const& pair : textures) {
     glActiveTexture(GL_TEXTURE0 + pair.second.unit);
     glBindTexture(pair.first.target, 0);
@@ -1224,18 +1203,272 @@ void Primitive::draw(glm::mat4 const& projMat, glm::mat4 const& viewMat, glm::ma
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GltfShared::init(tinygltf::Model const& gltf, std::string const& cubemapFilepath) {
+// The environment maps are stored as "<prefix>-diffuse.ktx" and "<prefix>-specular.ktx". The
+// prefix changes whenever the cubemap file is modified.
+std::string getEnvironmentCacheFile(
+    std::string const& environmentCacheDirectory, std::string const& cubemapFile) {
+  auto        modified = boost::filesystem::last_write_time(cubemapFile);
+  auto        size     = boost::filesystem::file_size(cubemapFile);
+  std::size_t hash     = std::hash<std::string>{}(
+      cubemapFile + '\0' + std::to_string(modified) + '\0' + std::to_string(size));
+  return environmentCacheDirectory + "/" + std::to_string(hash);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Stores the filtered environment maps so that the next session can load them directly. Failing
+// to do so is not an error, the maps will be filtered again next time.
+void storeEnvironment(std::string const& environmentCacheFile, Environment const& environment,
+    int specularWidth, int specularHeight, std::size_t specularLevels) {
+  try {
+    auto directory = boost::filesystem::path(environmentCacheFile).parent_path();
+    if (!boost::filesystem::exists(directory)) {
+      cs::utils::filesystem::createDirectoryRecursively(directory);
+    }
+
+    auto diffuse  = downloadCubemap(environment.mDiffuseEnvMap, 32, 32, 1);
+    auto specular = downloadCubemap(
+        environment.mSpecularEnvMap, specularWidth, specularHeight, specularLevels);
+
+    if (!gli::save_ktx(diffuse, environmentCacheFile + "-diffuse.ktx") ||
+        !gli::save_ktx(specular, environmentCacheFile + "-specular.ktx")) {
+      throw std::runtime_error("Failed to write file!");
+    }
+  } catch (std::exception const& e) {
+    logger().warn("Failed to store environment maps at '{}': {}", environmentCacheFile, e.what());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::vector<uint32_t> optimizeVertexCache(unsigned char* data, std::size_t count) {
+  std::vector<uint32_t> indices(count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    T index{};
+    std::memcpy(&index, data + i * sizeof(T), sizeof(T)); // NOLINT(*-pointer-arithmetic)
+    indices[i] = index;
+  }
+
+  optimizeVertexCache(indices);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    auto index = static_cast<T>(indices[i]);
+    std::memcpy(data + i * sizeof(T), &index, sizeof(T)); // NOLINT(*-pointer-arithmetic)
+  }
+
+  return indices;
+}
+
+// Returns the positions of the given accessor. Returns an empty vector if they are not stored as
+// floats, for example if they are quantized.
+std::vector<glm::vec3> readPositions(tinygltf::Model const& model, int accessorIndex) {
+  auto const& accessor = model.accessors[accessorIndex];
+
+  if (accessor.bufferView < 0 || accessor.type != TINYGLTF_TYPE_VEC3 ||
+      accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.count == 0) {
+    return {};
+  }
+
+  auto const& bufferView = model.bufferViews[accessor.bufferView];
+  auto const& buffer     = model.buffers[bufferView.buffer];
+  std::size_t stride     = bufferView.byteStride != 0 ? bufferView.byteStride : sizeof(glm::vec3);
+  std::size_t offset     = bufferView.byteOffset + accessor.byteOffset;
+
+  if (offset + (accessor.count - 1) * stride + sizeof(glm::vec3) > buffer.data.size()) {
+    return {};
+  }
+
+  std::vector<glm::vec3> positions(accessor.count);
+
+  for (std::size_t i = 0; i < accessor.count; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::memcpy(&positions[i], buffer.data.data() + offset + i * stride, sizeof(glm::vec3));
+  }
+
+  return positions;
+}
+
+// Creates up to three levels of detail with vertex clustering. Each level has to have at most half
+// of the triangles of the previous level, else it is not worth the additional memory.
+std::vector<PrimitiveLod> createLods(
+    std::vector<uint32_t> const& indices, std::vector<glm::vec3> const& positions) {
+
+  glm::vec3 minPos(std::numeric_limits<float>::max());
+  glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+
+  for (uint32_t index : indices) {
+    minPos = glm::min(minPos, positions[index]);
+    maxPos = glm::max(maxPos, positions[index]);
+  }
+
+  auto  size   = maxPos - minPos;
+  float extent = std::max({size.x, size.y, size.z});
+
+  std::vector<PrimitiveLod> lods;
+  std::size_t               triangleCount = indices.size() / 3;
+
+  for (float cellCount : {128.F, 32.F, 8.F}) {
+    float cellSize = extent / cellCount;
+    auto  lod      = simplifyMesh(indices, positions, cellSize);
+
+    if (lod.empty()) {
+      break;
+    }
+
+    if (lod.size() / 3 <= triangleCount / 2) {
+      triangleCount = lod.size() / 3;
+      lods.push_back({std::move(lod), cellSize * std::sqrt(3.F)});
+    }
+  }
+
+  return lods;
+}
+
+// Reorders the indices of all indexed triangle lists for the post-transform vertex cache and
+// creates the levels of detail of large primitives. The indices are written back to the buffers of
+// the model, so they are uploaded as before. Index accessors which are shared by several
+// primitives are processed only once.
+void optimizeMeshes(GltfData& data) {
+  // Smaller primitives are cheap enough to be drawn at full detail.
+  const std::size_t minLodTriangles = 1024;
+
+  auto&         model = data.mModel;
+  std::set<int> optimizedAccessors;
+
+  data.mLods.resize(model.meshes.size());
+
+  for (std::size_t m = 0; m < model.meshes.size(); ++m) {
+    auto const& mesh = model.meshes[m];
+    data.mLods[m].resize(mesh.primitives.size());
+
+    for (std::size_t p = 0; p < mesh.primitives.size(); ++p) {
+      auto const& primitive = mesh.primitives[p];
+
+      if (primitive.indices < 0 ||
+          (primitive.mode != TINYGLTF_MODE_TRIANGLES && primitive.mode != -1) ||
+          !optimizedAccessors.insert(primitive.indices).second) {
+        continue;
+      }
+
+      auto const& accessor = model.accessors[primitive.indices];
+
+      if (accessor.bufferView < 0) {
+        continue;
+      }
+
+      auto const& bufferView    = model.bufferViews[accessor.bufferView];
+      auto&       buffer        = model.buffers[bufferView.buffer];
+      auto        componentSize = static_cast<std::size_t>(
+          tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType)));
+      std::size_t offset = bufferView.byteOffset + accessor.byteOffset;
+
+      // Indices have to be tightly packed, anything else is not valid glTF.
+      if ((bufferView.byteStride != 0 && bufferView.byteStride != componentSize) ||
+          offset + accessor.count * componentSize > buffer.data.size()) {
+        logger().warn("Skipping vertex cache optimization of accessor {}: Invalid index data!",
+            primitive.indices);
+        continue;
+      }
+
+      auto* indexData = buffer.data.data() + offset; // NOLINT(*-pointer-arithmetic)
+
+      std::vector<uint32_t> indices;
+
+      if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
+        indices = optimizeVertexCache<uint8_t>(indexData, accessor.count);
+      } else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+        indices = optimizeVertexCache<uint16_t>(indexData, accessor.count);
+      } else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
+        indices = optimizeVertexCache<uint32_t>(indexData, accessor.count);
+      }
+
+      auto position = primitive.attributes.find("POSITION");
+
+      if (indices.size() < minLodTriangles * 3 || position == primitive.attributes.end()) {
+        continue;
+      }
+
+      auto positions = readPositions(model, position->second);
+
+      if (!positions.empty() &&
+          *std::max_element(indices.begin(), indices.end()) < positions.size()) {
+        data.mLods[m][p] = createLods(indices, positions);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GltfData loadGltfData(std::string const& gltfFile, std::string const& cubemapFile,
+    std::string const& environmentCacheDirectory) {
+  GltfData data;
+
+  tinygltf::TinyGLTF loader;
+  std::string        err;
+  std::string        warn;
+
+  bool ret = false;
+  if (cs::utils::endsWith(gltfFile, ".glb")) {
+    // Assume binary glTF.
+    ret = loader.LoadBinaryFromFile(&data.mModel, &err, &warn, gltfFile);
+  } else {
+    // Assume ascii glTF.
+    ret = loader.LoadASCIIFromFile(&data.mModel, &err, &warn, gltfFile);
+  }
+
+  if (!err.empty()) {
+    throw std::runtime_error(err);
+  }
+  if (!ret) {
+    throw std::runtime_error("Failed to load .glTF: " + gltfFile);
+  }
 
-  // save current viewport
-  std::array<GLint, 4> current_viewport{};
-  glGetIntegerv(GL_VIEWPORT, current_viewport.data());
+  // Compressed geometry cannot be decoded. Without the extension, the model would be rendered
+  // with garbage vertex data.
+  for (auto const& extension : data.mModel.extensionsRequired) {
+    if (extension == "EXT_meshopt_compression" || extension == "KHR_draco_mesh_compression") {
+      throw std::runtime_error("Failed to load .glTF: " + gltfFile + " requires " + extension +
+                               ", which is not supported! Please export it without compression.");
+    }
+  }
+
+  optimizeMeshes(data);
 
   {
-    std::ifstream f(cubemapFilepath.c_str());
+    std::ifstream f(cubemapFile.c_str());
     if (!f.good()) {
-      throw std::runtime_error("GltfShared: Cannot open cubemap: " + cubemapFilepath);
+      throw std::runtime_error("GltfShared: Cannot open cubemap: " + cubemapFile);
     }
   }
+
+  data.mCubemapFile = cubemapFile;
+
+  if (!environmentCacheDirectory.empty()) {
+    data.mEnvironmentCacheFile = getEnvironmentCacheFile(environmentCacheDirectory, cubemapFile);
+
+    // gli returns an empty texture if a file does not exist.
+    data.mDiffuseEnvMap =
+        gli::texture_cube(gli::load(data.mEnvironmentCacheFile + "-diffuse.ktx"));
+    data.mSpecularEnvMap =
+        gli::texture_cube(gli::load(data.mEnvironmentCacheFile + "-specular.ktx"));
+  }
+
+  if (data.mDiffuseEnvMap.empty() || data.mSpecularEnvMap.empty()) {
+    data.mCubemap = gli::texture_cube(gli::load(cubemapFile));
+  }
+
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GltfResources::init(GltfData data) {
+  mTinyGltfModel   = std::move(data.mModel);
+  auto const& gltf  = mTinyGltfModel;
+
   std::vector<std::shared_ptr<unsigned int>> sharedImages;
   for (auto const& i : gltf.images) {
     sharedImages.emplace_back(createGPUimage(i, true));
@@ -1257,35 +1490,134 @@ void GltfShared::init(tinygltf::Model const& gltf, std::string const& cubemapFil
     mTextures.emplace_back(Texture{GL_TEXTURE_2D, sampler, sharedImages.at(t.source)});
   }
 
-  mBrdfLUTindex = static_cast<int>(mTextures.size());
-  mTextures.push_back(createBrdfLUT(512, 512));
+  // Filtering the cubemap is by far the most expensive part of the upload. As the result only
+  // depends on the cubemap, it is shared by all models which are alive at the same time.
+  static std::map<std::string, std::weak_ptr<Environment>> environments;
+
+  mEnvironment = environments[data.mCubemapFile].lock();
+
+  if (!mEnvironment) {
+    mEnvironment = std::make_shared<Environment>();
 
-  glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-  gli::texture_cube inputGliTex(gli::load(cubemapFilepath));
+    mEnvironment->mBrdfLUT = createBrdfLUT(512, 512);
+
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    if (!data.mDiffuseEnvMap.empty() && !data.mSpecularEnvMap.empty()) {
+      mEnvironment->mDiffuseEnvMap  = uploadCubemap(data.mDiffuseEnvMap);
+      mEnvironment->mSpecularEnvMap = uploadCubemap(data.mSpecularEnvMap);
+    } else {
+      auto inputCubemapTex = uploadCubemap(data.mCubemap);
+      auto extent          = data.mCubemap.extent();
+
+      mEnvironment->mDiffuseEnvMap = irradianceCubemap(inputCubemapTex, 32, 32);
+      mEnvironment->mSpecularEnvMap =
+          prefilterCubemapGGX(inputCubemapTex, extent.x, extent.y, 10);
+
+      if (!data.mEnvironmentCacheFile.empty()) {
+        storeEnvironment(data.mEnvironmentCacheFile, *mEnvironment, extent.x, extent.y, 10);
+      }
+    }
+
+    environments[data.mCubemapFile] = mEnvironment;
+  }
+
+  mBrdfLUTindex = static_cast<int>(mTextures.size());
+  mTextures.push_back(mEnvironment->mBrdfLUT);
 
   // diffuse env map
   mDiffuseEnvMapIndex = static_cast<int>(mTextures.size());
-  auto diffuseGliTex  = irradianceCubemap(inputGliTex, 32, 32);
-  mTextures.push_back(uploadCubemap(diffuseGliTex));
+  mTextures.push_back(mEnvironment->mDiffuseEnvMap);
 
   // specular env map
   mSpecularEnvMapIndex = static_cast<int>(mTextures.size());
-  auto specularGliTex  = prefilterCubemapGGX(inputGliTex, 10);
-  mTextures.push_back(uploadCubemap(specularGliTex));
+  mTextures.push_back(mEnvironment->mSpecularEnvMap);
+
+  buildMeshes(gltf, data.mLods);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<GltfResources const> getGltfResources(std::string const& gltfFile,
+    std::string const& cubemapFile, std::string const& environmentCacheDirectory) {
 
-  buildMeshes(gltf);
+  struct CacheEntry {
+    std::shared_future<std::shared_ptr<GltfData>> mData;
+    std::weak_ptr<GltfResources const>            mResources;
+  };
 
-  // reset current viewport
-  glViewport(current_viewport[0], current_viewport[1], current_viewport[2], current_viewport[3]);
-  glScissor(current_viewport[0], current_viewport[1], current_viewport[2], current_viewport[3]);
+  static std::map<std::string, CacheEntry> cache;
+
+  std::string key   = gltfFile + "\n" + cubemapFile;
+  auto&       entry = cache[key];
+
+  if (auto resources = entry.mResources.lock()) {
+    return resources;
+  }
+
+  // Either no instance of this model has been loaded yet, or all of them have been deleted since.
+  if (!entry.mData.valid()) {
+    entry.mData =
+        std::async(std::launch::async, [gltfFile, cubemapFile, environmentCacheDirectory]() {
+          return std::make_shared<GltfData>(
+              loadGltfData(gltfFile, cubemapFile, environmentCacheDirectory));
+        }).share();
+  }
+
+  if (entry.mData.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return nullptr;
+  }
+
+  std::shared_ptr<GltfData> data;
+
+  try {
+    data = entry.mData.get();
+  } catch (...) {
+    // A later instance will try again.
+    cache.erase(key);
+    throw;
+  }
+
+  // The data is moved into the resources, it is not needed anymore once they exist.
+  entry.mData = {};
+
+  auto resources = std::make_shared<GltfResources>();
+  resources->init(std::move(*data));
+  entry.mResources = resources;
+
+  return resources;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GltfShared::setInstances(std::vector<glm::mat4> const& transformations) {
+  if (!mInstanceBuffer) {
+    mInstanceBuffer = std::shared_ptr<GLuint>(new GLuint(0), [](GLuint* ptr) {
+      if (*ptr != 0u) {
+        glDeleteBuffers(1, ptr);
+      }
+    });
+    glGenBuffers(1, mInstanceBuffer.get());
+  }
+
+  // The buffer is re-specified each time, so the driver does not have to wait for draw calls of
+  // the previous frame which may still use the old data.
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, *mInstanceBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+      static_cast<GLsizeiptr>(transformations.size() * sizeof(glm::mat4)), transformations.data(),
+      GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  CheckGLErrors("setInstances");
+
+  mInstanceCount = transformations.size();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Mesh::draw(glm::mat4 const& projMat, glm::mat4 const& viewMat, glm::mat4 const& modelMat,
-    GltfShared const& shared) const {
+    GltfShared const& shared, float maxError) const {
   for (auto const& p : primitives) {
-    p.draw(projMat, viewMat, modelMat, shared);
+    p.draw(projMat, viewMat, modelMat, shared, maxError);
   }
 }
 
@@ -1320,7 +1652,33 @@ bool VistaGltfNode::Do() {
   glDisable(GL_CULL_FACE);
 
   if (mMeshIndex >= 0 && mShared) {
-    mShared->mMeshes[mMeshIndex].draw(projMat, viewMat, modelMat, *mShared);
+    auto const& mesh = mShared->mResources->mMeshes[mMeshIndex];
+
+    // The level of detail is chosen so that no vertex is off by more than m_maxLodError pixels.
+    // This uses the point of the bounding sphere which is closest to the observer. Instances may be
+    // much closer than the model itself, so these are always drawn at full detail.
+    float maxError = 0.F;
+
+    if (mShared->mInstanceCount == 0 && mShared->m_maxLodError > 0.F) {
+      glm::vec3 center = (mesh.minPos + mesh.maxPos) * 0.5F;
+      float     radius = glm::length(mesh.maxPos - mesh.minPos) * 0.5F;
+      float     scale  = std::max({glm::length(glm::vec3(modelViewMat[0])),
+          glm::length(glm::vec3(modelViewMat[1])), glm::length(glm::vec3(modelViewMat[2]))});
+
+      glm::vec3 viewCenter = modelViewMat * glm::vec4(center, 1.F);
+      float     distance   = glm::length(viewCenter) - radius * scale;
+
+      if (distance > 0.F) {
+        std::array<GLint, 4> viewport{};
+        glGetIntegerv(GL_VIEWPORT, viewport.data());
+
+        float pixelsPerUnit =
+            scale * projMat[1][1] * static_cast<float>(viewport[3]) * 0.5F / distance;
+        maxError = mShared->m_maxLodError / pixelsPerUnit;
+      }
+    }
+
+    mesh.draw(projMat, viewMat, modelMat, *mShared, maxError);
   }
 
   glEnable(GL_CULL_FACE);
@@ -1331,9 +1689,14 @@ bool VistaGltfNode::Do() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool VistaGltfNode::GetBoundingBox(VistaBoundingBox& bb) {
+  // The instances may be spread over a large volume, so these are never culled.
+  if (mShared && mShared->mInstanceCount > 0) {
+    return false;
+  }
+
   if (mMeshIndex >= 0 && mShared) {
-    auto& mi = mShared->mMeshes[mMeshIndex].minPos;
-    auto& ma = mShared->mMeshes[mMeshIndex].maxPos;
+    auto const& mi = mShared->mResources->mMeshes[mMeshIndex].minPos;
+    auto const& ma = mShared->mResources->mMeshes[mMeshIndex].maxPos;
     bb.SetBounds(glm::value_ptr(mi), glm::value_ptr(ma));
   }
 
@@ -9,12 +9,14 @@
 #define CS_GRAPHICS_GLTFMODEL_HPP
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <gli/texture_cube.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <string>
 #include <tiny_gltf.h>
 #include <vector>
 
@@ -59,6 +61,8 @@ struct GLProgramInfo {
   int u_MVPMatrix_loc{};
   int u_ModelMatrix_loc{};
   int u_NormalMatrix_loc{};
+  int u_UseInstances_loc{};
+  int u_ViewProjectionMatrix_loc{};
 
   // Fragmentshader
   int u_LightDirection_loc{};
@@ -102,9 +106,10 @@ struct Buffer {
 /// An OpenGL primitive for rendering a vertex array.
 struct Primitive {
 
-  /// The rendering of the vertex array.
+  /// The rendering of the vertex array. The coarsest level of detail whose error is not larger
+  /// than maxError (in model space) is drawn.
   void draw(glm::mat4 const& projMat, glm::mat4 const& viewMat, glm::mat4 const& modelMat,
-      GltfShared const& shared) const;
+      GltfShared const& shared, float maxError = 0.F) const;
 
   bool hasIndices = false;  ///< Determines if glDrawElements or glDrawArrays will be called.
   int  mode       = 0x0004; ///< GL_TRIANGLES;
@@ -114,6 +119,18 @@ struct Primitive {
   int    indicesType   = 0x1403; ///< GL_UNSIGNED_SHORT;
   size_t byteOffset{};
 
+  /// A simplified index buffer for the same vertices, see simplifyMesh().
+  struct Lod {
+    std::shared_ptr<unsigned int> indexBuffer;
+    size_t                        indicesCount = 0;
+    float                         error        = 0.F; ///< In model space.
+  };
+
+  /// The levels of detail of indexed primitives, ordered from fine to coarse. These always use
+  /// GL_UNSIGNED_INT indices. If one of them is drawn, the indexBuffer is bound again afterwards.
+  std::vector<Lod>              lods;
+  std::shared_ptr<unsigned int> indexBuffer;
+
   GLProgramInfo programInfo;
 
   glm::vec4 baseColorFactor{};
@@ -128,7 +145,7 @@ struct Primitive {
 /// Manages all primitives belonging to a mesh.
 struct Mesh {
   void draw(glm::mat4 const& projMat, glm::mat4 const& viewMat, glm::mat4 const& modelMat,
-      GltfShared const& shared) const;
+      GltfShared const& shared, float maxError = 0.F) const;
 
   /// All primitives belonging to the model.
   std::vector<Primitive> primitives;
@@ -138,27 +155,101 @@ struct Mesh {
   glm::vec3 maxPos = glm::vec3(std::numeric_limits<float>::max());
 };
 
-/// Represents a GLTF model.
-struct GltfShared {
-  void init(tinygltf::Model const& gltf, const std::string& cubemapFilepath);
+/// A simplified index list of a primitive, see simplifyMesh().
+struct PrimitiveLod {
+  std::vector<uint32_t> mIndices;
+
+  /// The maximum distance by which a vertex has been moved in model space.
+  float mError = 0.F;
+};
+
+/// Everything which can be loaded without an OpenGL context. Parsing the glTF file also decodes
+/// all of its images.
+struct GltfData {
+  tinygltf::Model   mModel;
+  std::string       mCubemapFile;
+  gli::texture_cube mCubemap;
+
+  /// The common path prefix of the cached environment maps. Empty if these are not cached.
+  std::string mEnvironmentCacheFile;
+
+  /// The filtered environment maps, if they have been found in the cache. In this case, mCubemap
+  /// is not loaded as it is only needed for filtering.
+  gli::texture_cube mDiffuseEnvMap;
+  gli::texture_cube mSpecularEnvMap;
+
+  /// The levels of detail of each primitive of each mesh, ordered from fine to coarse. This is
+  /// empty for primitives which are not simplified.
+  std::vector<std::vector<std::vector<PrimitiveLod>>> mLods;
+};
+
+/// Loads the glTF and cubemap files. This does not use OpenGL and can be called on any thread.
+/// The triangles of all indexed meshes are reordered for the vertex cache of the GPU, see
+/// optimizeVertexCache(), and simplified levels of detail are created for large primitives.
+/// Throws a std::runtime_error if one of the files cannot be loaded or if the model uses
+/// compressed geometry. If environmentCacheDirectory is not empty, the filtered environment maps
+/// are loaded from there if they have been stored by a previous session.
+GltfData loadGltfData(std::string const& gltfFile, std::string const& cubemapFile,
+    std::string const& environmentCacheDirectory = "");
+
+/// The textures for image based lighting. These only depend on the cubemap, so they are shared by
+/// all models using the same cubemap.
+struct Environment {
+  Texture mBrdfLUT;
+  Texture mDiffuseEnvMap;
+  Texture mSpecularEnvMap;
+};
+
+/// All data and GPU resources of a loaded GLTF model. These are shared by all instances of the
+/// same model, see getGltfResources().
+struct GltfResources {
+  /// Uploads the given data to the GPU. This has to be called on the main thread.
+  void init(GltfData data);
 
  private:
-  void      buildMeshes(tinygltf::Model const& gltf);
-  Primitive createMeshPrimitive(tinygltf::Model const& gltf, tinygltf::Primitive const& primitive);
+  void buildMeshes(
+      tinygltf::Model const& gltf, std::vector<std::vector<std::vector<PrimitiveLod>>> const& lods);
+  Primitive createMeshPrimitive(tinygltf::Model const& gltf, tinygltf::Primitive const& primitive,
+      std::vector<PrimitiveLod> const& lods, std::map<int, Buffer>& bufferMap);
 
  public:
-  glm::vec3            m_lightColor     = glm::vec3(0.0F, 0.0F, 0.0F);
-  glm::vec3            m_lightDirection = glm::vec3(0.0F, 0.0F, 1.0F);
-  float                m_lightIntensity = 1.0F;
-  bool                 m_enableHDR      = false;
-  float                m_IBLIntensity   = 1.0F;
-  glm::mat3            m_IBLrotation    = glm::mat3(1.0F);
-  tinygltf::Model      mTinyGltfModel;
-  std::vector<Texture> mTextures;
-  std::vector<Mesh>    mMeshes;
-  int                  mBrdfLUTindex        = -1;
-  int                  mDiffuseEnvMapIndex  = -1;
-  int                  mSpecularEnvMapIndex = -1;
+  tinygltf::Model              mTinyGltfModel;
+  std::vector<Texture>         mTextures;
+  std::vector<Mesh>            mMeshes;
+  std::shared_ptr<Environment> mEnvironment;
+  int                          mBrdfLUTindex        = -1;
+  int                          mDiffuseEnvMapIndex  = -1;
+  int                          mSpecularEnvMapIndex = -1;
+};
+
+/// Returns the resources of the model with the given glTF and cubemap files. All instances of the
+/// same model share these as long as at least one of them is alive. If the resources are not
+/// available, this starts loading the files in the background (unless another instance already
+/// did this) and returns nullptr. Once the background stage has finished, the next call uploads
+/// the data to the GPU. Throws a std::runtime_error if loading has failed. This has to be called
+/// on the main thread. See loadGltfData() for the environmentCacheDirectory.
+std::shared_ptr<GltfResources const> getGltfResources(std::string const& gltfFile,
+    std::string const& cubemapFile, std::string const& environmentCacheDirectory = "");
+
+/// Represents an instance of a GLTF model. The lighting parameters are specific to each instance.
+struct GltfShared {
+  /// Uploads the transformations for instanced drawing, see GltfLoader::setInstances(). This has
+  /// to be called on the main thread.
+  void setInstances(std::vector<glm::mat4> const& transformations);
+
+  glm::vec3                            m_lightColor     = glm::vec3(0.0F, 0.0F, 0.0F);
+  glm::vec3                            m_lightDirection = glm::vec3(0.0F, 0.0F, 1.0F);
+  float                                m_lightIntensity = 1.0F;
+  bool                                 m_enableHDR      = false;
+  float                                m_IBLIntensity   = 1.0F;
+  glm::mat3                            m_IBLrotation    = glm::mat3(1.0F);
+  float                                m_maxLodError    = 1.0F; ///< In pixels.
+  std::shared_ptr<GltfResources const> mResources;
+
+  /// A shader storage buffer with one matrix per instance. If mInstanceCount is zero, the model is
+  /// drawn once without instancing.
+  std::shared_ptr<unsigned int> mInstanceBuffer;
+  std::size_t                   mInstanceCount = 0;
 };
 
 /// A Vista wrapper for the GLTF model responsible for rendering.
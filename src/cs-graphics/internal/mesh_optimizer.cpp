@@ -0,0 +1,382 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "mesh_optimizer.hpp"
+
+#include "../../cs-utils/doctest.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+namespace cs::graphics::internal {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// These are the values suggested by Tom Forsyth. The simulated cache is larger than the actual
+// caches of most GPUs, this gives better results for a wide range of hardware.
+constexpr int   CACHE_SIZE          = 32;
+constexpr float CACHE_DECAY_POWER   = 1.5F;
+constexpr float LAST_TRIANGLE_SCORE = 0.75F;
+constexpr float VALENCE_BOOST_SCALE = 2.0F;
+constexpr float VALENCE_BOOST_POWER = 0.5F;
+
+// Vertices which have just been used and vertices which are used by only a few of the remaining
+// triangles get a high score. cachePosition is -1 if the vertex is not in the cache.
+float getVertexScore(int cachePosition, uint32_t remainingTriangles) {
+  if (remainingTriangles == 0) {
+    return -1.F;
+  }
+
+  float score = 0.F;
+
+  if (cachePosition >= 0) {
+    // The three vertices of the last triangle get a fixed score, else triangles which share an
+    // edge with the last triangle would be preferred over triangles which use the same vertices.
+    if (cachePosition < 3) {
+      score = LAST_TRIANGLE_SCORE;
+    } else {
+      float scale = 1.F / static_cast<float>(CACHE_SIZE - 3);
+      score = std::pow(1.F - static_cast<float>(cachePosition - 3) * scale, CACHE_DECAY_POWER);
+    }
+  }
+
+  score += VALENCE_BOOST_SCALE *
+           std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+
+  return score;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void optimizeVertexCache(std::vector<uint32_t>& indices) {
+  std::size_t triangleCount = indices.size() / 3;
+
+  if (triangleCount < 2) {
+    return;
+  }
+
+  std::size_t vertexCount = *std::max_element(indices.begin(), indices.end()) + 1;
+
+  // Store the triangles of each vertex in one array. The triangles of vertex v are stored at
+  // [offsets[v], offsets[v] + remaining[v]). Emitted triangles are moved behind this range.
+  std::vector<uint32_t> offsets(vertexCount + 1, 0);
+  std::vector<uint32_t> remaining(vertexCount, 0);
+
+  for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+    ++remaining[indices[i]];
+  }
+
+  for (std::size_t v = 0; v < vertexCount; ++v) {
+    offsets[v + 1] = offsets[v] + remaining[v];
+  }
+
+  std::vector<uint32_t> triangles(triangleCount * 3);
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+  for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+    triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<int>   cachePositions(vertexCount, -1);
+  std::vector<float> vertexScores(vertexCount);
+
+  for (std::size_t v = 0; v < vertexCount; ++v) {
+    vertexScores[v] = getVertexScore(-1, remaining[v]);
+  }
+
+  auto getTriangleScore = [&](std::size_t t) {
+    return vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+           vertexScores[indices[t * 3 + 2]];
+  };
+
+  // The first triangle is the best one of the entire mesh. Afterwards, only the triangles of the
+  // vertices in the cache are considered.
+  std::size_t bestTriangle = 0;
+  float       bestScore    = -1.F;
+
+  for (std::size_t t = 0; t < triangleCount; ++t) {
+    float score = getTriangleScore(t);
+    if (score > bestScore) {
+      bestScore    = score;
+      bestTriangle = t;
+    }
+  }
+
+  std::vector<bool>     emitted(triangleCount, false);
+  std::vector<uint32_t> result;
+  std::vector<uint32_t> cache;
+  std::vector<uint32_t> newCache;
+  std::size_t           nextUnemitted = 0;
+
+  result.reserve(indices.size());
+  cache.reserve(CACHE_SIZE + 3);
+  newCache.reserve(CACHE_SIZE + 3);
+
+  while (result.size() < triangleCount * 3) {
+
+    // If none of the cached vertices has triangles left, continue with the next triangle in the
+    // original order.
+    if (bestScore < 0.F) {
+      while (emitted[nextUnemitted]) {
+        ++nextUnemitted;
+      }
+      bestTriangle = nextUnemitted;
+    }
+
+    emitted[bestTriangle] = true;
+    newCache.clear();
+
+    for (std::size_t i = 0; i < 3; ++i) {
+      uint32_t v = indices[bestTriangle * 3 + i];
+      result.push_back(v);
+
+      auto begin = triangles.begin() + offsets[v];
+      auto end   = begin + remaining[v];
+      std::iter_swap(std::find(begin, end, static_cast<uint32_t>(bestTriangle)), end - 1);
+      --remaining[v];
+
+      if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+        newCache.push_back(v);
+      }
+    }
+
+    // The vertices of the emitted triangle move to the front of the cache, the others are pushed
+    // back. Vertices beyond the cache size are evicted.
+    for (uint32_t v : cache) {
+      if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+        newCache.push_back(v);
+      }
+    }
+
+    for (std::size_t i = 0; i < newCache.size(); ++i) {
+      uint32_t v        = newCache[i];
+      cachePositions[v] = i < static_cast<std::size_t>(CACHE_SIZE) ? static_cast<int>(i) : -1;
+      vertexScores[v]   = getVertexScore(cachePositions[v], remaining[v]);
+    }
+
+    bestScore = -1.F;
+
+    for (uint32_t v : newCache) {
+      for (uint32_t j = 0; j < remaining[v]; ++j) {
+        uint32_t t     = triangles[offsets[v] + j];
+        float    score = getTriangleScore(t);
+        if (score > bestScore) {
+          bestScore    = score;
+          bestTriangle = t;
+        }
+      }
+    }
+
+    if (newCache.size() > static_cast<std::size_t>(CACHE_SIZE)) {
+      newCache.resize(CACHE_SIZE);
+    }
+
+    std::swap(cache, newCache);
+  }
+
+  std::copy(result.begin(), result.end(), indices.begin());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> simplifyMesh(std::vector<uint32_t> const& indices,
+    std::vector<glm::vec3> const& positions, float cellSize) {
+  std::size_t triangleCount = indices.size() / 3;
+
+  if (triangleCount == 0 || cellSize <= 0.F) {
+    return {};
+  }
+
+  glm::vec3 minPos(std::numeric_limits<float>::max());
+
+  for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+    minPos = glm::min(minPos, positions[indices[i]]);
+  }
+
+  // Each cell is identified by its integer coordinates, 21 bits are used for each axis.
+  auto getCell = [&](uint32_t v) {
+    auto     cell = glm::clamp(glm::floor((positions[v] - minPos) / cellSize), 0.F, 2097151.F);
+    uint64_t x    = static_cast<uint64_t>(cell.x);
+    uint64_t y    = static_cast<uint64_t>(cell.y);
+    uint64_t z    = static_cast<uint64_t>(cell.z);
+    return x | (y << 21U) | (z << 42U);
+  };
+
+  struct Cluster {
+    glm::vec3 mSum{0.F};
+    uint32_t  mCount          = 0;
+    uint32_t  mVertex         = 0;
+    float     mVertexDistance = std::numeric_limits<float>::max();
+  };
+
+  std::unordered_map<uint64_t, Cluster>  clusters;
+  std::unordered_map<uint32_t, uint64_t> cells;
+
+  for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+    uint32_t v = indices[i];
+    if (cells.find(v) == cells.end()) {
+      auto  cell    = getCell(v);
+      auto& cluster = clusters[cell];
+      cells[v]      = cell;
+
+      cluster.mSum += positions[v];
+      ++cluster.mCount;
+    }
+  }
+
+  // Choose the vertex which is closest to the average of its cluster as representative.
+  for (auto const& [v, cell] : cells) {
+    auto& cluster  = clusters[cell];
+    float distance = glm::distance(positions[v], cluster.mSum / static_cast<float>(cluster.mCount));
+    if (distance < cluster.mVertexDistance) {
+      cluster.mVertexDistance = distance;
+      cluster.mVertex         = v;
+    }
+  }
+
+  std::vector<uint32_t> result;
+
+  for (std::size_t t = 0; t < triangleCount; ++t) {
+    uint32_t a = clusters[cells[indices[t * 3]]].mVertex;
+    uint32_t b = clusters[cells[indices[t * 3 + 1]]].mVertex;
+    uint32_t c = clusters[cells[indices[t * 3 + 2]]].mVertex;
+
+    if (a != b && b != c && c != a) {
+      result.insert(result.end(), {a, b, c});
+    }
+  }
+
+  optimizeVertexCache(result);
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float computeACMR(std::vector<uint32_t> const& indices, std::size_t cacheSize) {
+  std::size_t triangleCount = indices.size() / 3;
+
+  if (triangleCount == 0) {
+    return 0.F;
+  }
+
+  std::deque<uint32_t> cache;
+  std::size_t          misses = 0;
+
+  for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+    if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end()) {
+      ++misses;
+      cache.push_back(indices[i]);
+
+      if (cache.size() > cacheSize) {
+        cache.pop_front();
+      }
+    }
+  }
+
+  return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::internal::optimizeVertexCache") {
+
+  // A grid of 32x32 quads with the triangles in random order.
+  uint32_t                              size = 32;
+  std::vector<std::array<uint32_t, 3>> shuffled;
+
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t x = 0; x < size; ++x) {
+      uint32_t i = y * (size + 1) + x;
+      shuffled.push_back({i, i + 1, i + size + 1});
+      shuffled.push_back({i + 1, i + size + 2, i + size + 1});
+    }
+  }
+
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+  std::vector<uint32_t> indices;
+  for (auto const& triangle : shuffled) {
+    indices.insert(indices.end(), triangle.begin(), triangle.end());
+  }
+
+  // A dangling index is kept at the end.
+  indices.push_back(7);
+
+  auto optimized = indices;
+  optimizeVertexCache(optimized);
+
+  REQUIRE_EQ(optimized.size(), indices.size());
+  CHECK_EQ(optimized.back(), 7);
+  CHECK_LT(computeACMR(optimized), 0.8F);
+  CHECK_LT(computeACMR(optimized), computeACMR(indices) * 0.5F);
+
+  // The triangles must be the same, including their winding.
+  std::vector<std::array<uint32_t, 3>> result;
+  for (std::size_t i = 0; i + 2 < optimized.size(); i += 3) {
+    result.push_back({optimized[i], optimized[i + 1], optimized[i + 2]});
+  }
+
+  std::sort(shuffled.begin(), shuffled.end());
+  std::sort(result.begin(), result.end());
+  CHECK_EQ(result, shuffled);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::internal::simplifyMesh") {
+
+  // A flat grid of 64x64 quads with a size of 1x1.
+  uint32_t               size = 64;
+  std::vector<glm::vec3> positions;
+  std::vector<uint32_t>  indices;
+
+  for (uint32_t y = 0; y <= size; ++y) {
+    for (uint32_t x = 0; x <= size; ++x) {
+      positions.emplace_back(static_cast<float>(x) / static_cast<float>(size),
+          static_cast<float>(y) / static_cast<float>(size), 0.F);
+    }
+  }
+
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t x = 0; x < size; ++x) {
+      uint32_t i = y * (size + 1) + x;
+      indices.insert(indices.end(), {i, i + 1, i + size + 1, i + 1, i + size + 2, i + size + 1});
+    }
+  }
+
+  // Cells smaller than the quads do not change anything.
+  CHECK_EQ(simplifyMesh(indices, positions, 0.001F).size(), indices.size());
+
+  // With cells of four quads, the vertex count per axis is reduced by four.
+  auto lod = simplifyMesh(indices, positions, 4.F / static_cast<float>(size));
+  CHECK_GT(lod.size(), 0);
+  CHECK_LE(lod.size(), indices.size() / 12);
+
+  // With a single cell, everything collapses.
+  CHECK(simplifyMesh(indices, positions, 2.F).empty());
+
+  // All triangles of the simplified mesh have to face in the same direction as the original.
+  for (std::size_t i = 0; i < lod.size(); i += 3) {
+    auto normal = glm::cross(positions[lod[i + 1]] - positions[lod[i]],
+        positions[lod[i + 2]] - positions[lod[i]]);
+    CHECK_GE(normal.z, 0.F);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics::internal
@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GRAPHICS_MESH_OPTIMIZER
+#define CS_GRAPHICS_MESH_OPTIMIZER
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace cs::graphics::internal {
+
+/// Reorders the triangles of the given triangle list so that the post-transform vertex cache of
+/// the GPU is hit more often. This uses Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+/// The set of triangles and the winding of each triangle are not changed. If the number of indices
+/// is not a multiple of three, the remaining indices are kept at the end. This runs in linear time
+/// and does not use OpenGL, so it can be called on any thread.
+void optimizeVertexCache(std::vector<uint32_t>& indices);
+
+/// Simplifies the given triangle list by vertex clustering. The bounding box of the referenced
+/// positions is divided into cubic cells of the given size and all vertices of a cell are merged
+/// into the vertex which is closest to their average. Triangles which collapse are removed. The
+/// returned indices refer to the same vertices, so all levels of detail can share the vertex
+/// attributes. Each vertex moves by at most the diagonal of a cell. The result is optimized with
+/// optimizeVertexCache(). All indices have to be smaller than the number of positions.
+std::vector<uint32_t> simplifyMesh(std::vector<uint32_t> const& indices,
+    std::vector<glm::vec3> const& positions, float cellSize);
+
+/// Returns the average number of vertex shader invocations per triangle (the average cache miss
+/// ratio) for a FIFO vertex cache of the given size. This is 3.0 in the worst case, values below
+/// 1.0 are common for well-ordered meshes.
+float computeACMR(std::vector<uint32_t> const& indices, std::size_t cacheSize = 16);
+
+} // namespace cs::graphics::internal
+
+#endif // CS_GRAPHICS_MESH_OPTIMIZER
@@ -29,6 +29,14 @@ uniform mat4 u_ModelMatrix;
 //uniform mat4 u_ProjectionMatrix;
 uniform mat3 u_NormalMatrix;
 
+// If u_UseInstances is set, the model is drawn once for each matrix in this buffer. The matrices
+// are applied on top of u_ModelMatrix and u_ViewProjectionMatrix is used instead of u_MVPMatrix.
+layout(std430, binding = 0) readonly buffer InstanceBuffer {
+  mat4 u_InstanceMatrices[];
+};
+uniform bool u_UseInstances;
+uniform mat4 u_ViewProjectionMatrix;
+
 out vec3 v_Position;
 out vec2 v_UV;
 
@@ -42,17 +50,25 @@ out vec3 v_Normal;
 
 void main()
 {
-  vec4 pos = u_ModelMatrix * a_Position;
+  mat4 modelMatrix  = u_ModelMatrix;
+  mat3 normalMatrix = u_NormalMatrix;
+
+  if (u_UseInstances) {
+    modelMatrix  = u_InstanceMatrices[gl_InstanceID] * u_ModelMatrix;
+    normalMatrix = transpose(inverse(mat3(modelMatrix)));
+  }
+
+  vec4 pos = modelMatrix * a_Position;
   v_Position = vec3(pos.xyz) / pos.w;
 
   #ifdef HAS_NORMALS
   #ifdef HAS_TANGENTS
-  vec3 normalW = normalize(u_NormalMatrix * a_Normal);
-  vec3 tangentW = normalize(u_NormalMatrix * a_Tangent.xyz);
+  vec3 normalW = normalize(normalMatrix * a_Normal);
+  vec3 tangentW = normalize(normalMatrix * a_Tangent.xyz);
   vec3 bitangentW = cross(normalW, tangentW) * a_Tangent.w;
   v_TBN = mat3(tangentW, bitangentW, normalW);
   #else // HAS_TANGENTS != 1
-  v_Normal = normalize(u_NormalMatrix * a_Normal);
+  v_Normal = normalize(normalMatrix * a_Normal);
   #endif
   #endif
 
@@ -62,7 +78,11 @@ void main()
   v_UV = vec2(0.0);
   #endif
 
-  gl_Position = u_MVPMatrix * a_Position; // needs w for proper perspective correction
+  if (u_UseInstances) {
+    gl_Position = u_ViewProjectionMatrix * pos;
+  } else {
+    gl_Position = u_MVPMatrix * a_Position; // needs w for proper perspective correction
+  }
 }
 
 )";
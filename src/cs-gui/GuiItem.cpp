@@ -8,13 +8,90 @@
 #include "GuiItem.hpp"
 
 #include "GuiArea.hpp"
+#include "gui.hpp"
 
 #include <VistaOGLExt/VistaTexture.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
 
 namespace cs::gui {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the texture buffers are allocated in multiples of this many bytes
+std::size_t const bufferCapacityBucket = 4 * 1024 * 1024;
+
+// items which have not been drawn for this many frames are hidden
+int const hiddenAfterFrames = 10;
+
+// items which are small on screen are painted at a lower frame rate, but at least at this rate
+int const minFrameRate = 5;
+
+// all existing items, for updateFrameRates()
+std::unordered_set<GuiItem*> allItems;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GLbitfield getBufferFlags() {
+
+  // With accelerated painting, the buffers are written by the GPU and read by GetColor().
+  if (getIsAcceleratedPaintEnabled()) {
+    return GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  }
+
+  // Else the modified ranges are flushed explicitly after they have been written.
+  return GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void copyRect(uint8_t* destination, uint8_t const* source, Rect const& rect, int width) {
+  if (rect.mWidth > 0.5 * width) {
+    // When the rect is almost the whole screen width we just copy the rest of the width
+    // too. This is faster since we only need one efficient std::memcpy call.
+
+    size_t startOffset = rect.mY * width * 4 * sizeof(uint8_t);
+    size_t extend      = rect.mHeight * width * 4 * sizeof(uint8_t);
+
+    // NOLINTNEXTLINE: This is performance critical.
+    std::memcpy(destination + startOffset, source + startOffset, extend);
+  } else {
+    // We copy each row of the changed region over individually, since they are not
+    // guaranteed to have continuous memory.
+    //
+    // ################################################################################
+    // ##############################+--------------------------------------+##########
+    // ####################### i = 0 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+    // ####################### i = 1 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+    // ####################### i = 2 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+    // ####################### i = 3 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+    // ####################### i = 4 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+    // ####################### i = 5 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+    // ##############################+--------------------------------------+##########
+    // ################################################################################
+    // ################################################################################
+    for (int i = 0; i < rect.mHeight; ++i) {
+      size_t startOffset = ((rect.mY + i) * width + rect.mX) * 4 * sizeof(uint8_t);
+      size_t extend      = rect.mWidth * 4 * sizeof(uint8_t);
+
+      // NOLINTNEXTLINE: This is performance critical.
+      std::memcpy(destination + startOffset, source + startOffset, extend);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 GuiItem::GuiItem(std::string const& url, bool allowLocalFileAccess)
     : WebView(url, 100, 100, allowLocalFileAccess)
     , mAreaWidth(1)
@@ -42,30 +119,35 @@ GuiItem::GuiItem(std::string const& url, bool allowLocalFileAccess)
   setRequestKeyboardFocusCallback(
       [this](bool requested) { mIsKeyboardInputElementFocused = requested; });
 
-  glGenBuffers(1, &mTextureBuffer);
-  glBindBuffer(GL_TEXTURE_BUFFER, mTextureBuffer);
-  size_t bufferSize{4 * sizeof(uint8_t) * getWidth() * getHeight()};
-
-  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
-  glBufferStorage(GL_TEXTURE_BUFFER, bufferSize, nullptr, flags);
-  mBufferData = static_cast<uint8_t*>(glMapBufferRange(GL_TEXTURE_BUFFER, 0, bufferSize, flags));
-
-  glGenTextures(1, &mTexture);
+  for (auto& buffer : mTextureBuffers) {
+    glGenTextures(1, &buffer.mTexture);
+  }
 
-  glBindTexture(GL_TEXTURE_BUFFER, mTexture);
-  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA8, mTextureBuffer);
+  reserveTextureBuffers(4 * sizeof(uint8_t) * getWidth() * getHeight());
 
-  glBindBuffer(GL_TEXTURE_BUFFER, 0);
-  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  allItems.insert(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 GuiItem::~GuiItem() {
-  glBindBuffer(GL_TEXTURE_BUFFER, mTextureBuffer);
-  glUnmapBuffer(GL_TEXTURE_BUFFER);
-  glDeleteBuffers(1, &mTextureBuffer);
-  glDeleteTextures(1, &mTexture);
+  allItems.erase(this);
+
+  clearSharedTextures();
+
+  for (auto& buffer : mTextureBuffers) {
+    if (buffer.mFence) {
+      glDeleteSync(buffer.mFence);
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer.mBuffer);
+    glUnmapBuffer(GL_TEXTURE_BUFFER);
+    glDeleteBuffers(1, &buffer.mBuffer);
+    glDeleteTextures(1, &buffer.mTexture);
+  }
+
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
   // seems to be necessary as OnPaint can be called by some other thread even
   // if this object is already deleted
   setDrawCallback([](DrawEvent const& /*unused*/) { return nullptr; });
@@ -191,6 +273,42 @@ bool GuiItem::getIsEnabled() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Rect const& GuiItem::getChangedRegion() const {
+  return mChangedRegion;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GuiItem::clearChangedRegion() {
+  mChangedRegion = {};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GuiItem::markDrawn(float screenScale) {
+  mDrawnScale = std::max(mDrawnScale, std::clamp(screenScale, 0.F, 1.F));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GuiItem::updateFrameRates() {
+  for (auto* item : allItems) {
+    bool drawn = item->mDrawnScale >= 0.F;
+
+    item->mFramesSinceDrawn = drawn ? 0 : item->mFramesSinceDrawn + 1;
+    item->setIsHidden(!item->getIsEnabled() || item->mFramesSinceDrawn > hiddenAfterFrames);
+
+    if (drawn) {
+      auto frameRate = static_cast<int>(std::ceil(item->mDrawnScale * sMaxFrameRate));
+      item->setFrameRate(std::max(frameRate, minFrameRate));
+    }
+
+    item->mDrawnScale = -1.F;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool GuiItem::getIsKeyboardInputElementFocused() const {
   return mIsKeyboardInputElementFocused;
 }
@@ -219,29 +337,178 @@ bool GuiItem::calculateMousePosition(int areaX, int areaY, int& x, int& y) {
 
 uint8_t* GuiItem::updateTexture(DrawEvent const& event) {
   if (event.mResized) {
-    glBindBuffer(GL_TEXTURE_BUFFER, mTextureBuffer);
-    glUnmapBuffer(GL_TEXTURE_BUFFER);
-    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    reserveTextureBuffers(4 * sizeof(uint8_t) * event.mWidth * event.mHeight);
+
+    mTextureSizeX = event.mWidth;
+    mTextureSizeY = event.mHeight;
 
-    glDeleteBuffers(1, &mTextureBuffer);
-    glGenBuffers(1, &mTextureBuffer);
-    glBindBuffer(GL_TEXTURE_BUFFER, mTextureBuffer);
+    // The content of all buffers is laid out for the previous size.
+    for (auto& buffer : mTextureBuffers) {
+      buffer.mDirtyRegion = {0, 0, mTextureSizeX, mTextureSizeY};
+    }
 
-    size_t     bufferSize{4 * sizeof(uint8_t) * event.mWidth * event.mHeight};
-    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
-    glBufferStorage(GL_TEXTURE_BUFFER, bufferSize, nullptr, flags);
-    mBufferData = static_cast<uint8_t*>(glMapBufferRange(GL_TEXTURE_BUFFER, 0, bufferSize, flags));
+    // The shared textures of the previous size will not be used anymore.
+    clearSharedTextures();
+  }
 
-    glBindTexture(GL_TEXTURE_BUFFER, mTexture);
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA8, mTextureBuffer);
+  // Write to the buffer which has been drawn least recently. Usually, the GPU will have finished
+  // drawing it long ago.
+  auto& buffer = mTextureBuffers.at((mCurrentBuffer + 1) % mTextureBuffers.size());
 
-    glBindBuffer(GL_TEXTURE_BUFFER, 0);
-    glBindTexture(GL_TEXTURE_BUFFER, 0);
-    mTextureSizeX = event.mWidth;
-    mTextureSizeY = event.mHeight;
+  if (buffer.mFence) {
+    uint64_t const timeout = 1000000000;
+    glClientWaitSync(buffer.mFence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    glDeleteSync(buffer.mFence);
+    buffer.mFence = nullptr;
+  }
+
+  // The region which has been changed in this paint.
+  Rect dirtyRegion{};
+  for (auto const& rect : event.mDirtyRects) {
+    dirtyRegion = getBoundingBox(dirtyRegion, rect);
+  }
+
+  if (event.mSharedHandle) {
+    dirtyRegion = {0, 0, mTextureSizeX, mTextureSizeY};
+    copySharedTexture(event.mSharedHandle, buffer.mBuffer);
+
+  } else if (event.mData) {
+    // Bring the buffer up to date. Besides the regions of this paint, this includes all regions
+    // which have been written to the other buffers since this buffer has been written last.
+    copyRect(buffer.mData, event.mData, buffer.mDirtyRegion, mTextureSizeX);
+
+    for (auto const& rect : event.mDirtyRects) {
+      copyRect(buffer.mData, event.mData, rect, mTextureSizeX);
+    }
+
+    // Make the written rows visible to the GPU.
+    Rect   written = getBoundingBox(buffer.mDirtyRegion, dirtyRegion);
+    size_t offset  = 4 * sizeof(uint8_t) * written.mY * mTextureSizeX;
+    size_t length  = 4 * sizeof(uint8_t) * written.mHeight * mTextureSizeX;
+
+    if (length > 0) {
+      glBindBuffer(GL_TEXTURE_BUFFER, buffer.mBuffer);
+      glFlushMappedBufferRange(GL_TEXTURE_BUFFER, offset, length);
+      glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+  }
+
+  buffer.mDirtyRegion = {};
+
+  // This is collected for the GuiAreas which cache the composited items.
+  if (event.mResized) {
+    mChangedRegion = {0, 0, mTextureSizeX, mTextureSizeY};
+  } else {
+    mChangedRegion = getBoundingBox(mChangedRegion, dirtyRegion);
+  }
+
+  for (auto& other : mTextureBuffers) {
+    if (&other != &buffer) {
+      other.mDirtyRegion = getBoundingBox(other.mDirtyRegion, dirtyRegion);
+    }
+  }
+
+  // The previous buffer must not be written until all draw calls issued so far have finished.
+  auto& previous = mTextureBuffers.at(mCurrentBuffer);
+  if (previous.mFence) {
+    glDeleteSync(previous.mFence);
+  }
+  previous.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  mCurrentBuffer = (mCurrentBuffer + 1) % mTextureBuffers.size();
+
+  return buffer.mData;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GuiItem::reserveTextureBuffers(std::size_t size) {
+  if (size <= mBufferCapacity) {
+    return;
+  }
+
+  // Allocate some more memory so that the buffers do not have to be recreated for each small
+  // increase of the size.
+  mBufferCapacity = (size / bufferCapacityBucket + 1) * bufferCapacityBucket;
+
+  GLbitfield flags = getBufferFlags();
+
+  for (auto& buffer : mTextureBuffers) {
+    if (buffer.mFence) {
+      glDeleteSync(buffer.mFence);
+      buffer.mFence = nullptr;
+    }
+
+    if (buffer.mBuffer) {
+      glBindBuffer(GL_TEXTURE_BUFFER, buffer.mBuffer);
+      glUnmapBuffer(GL_TEXTURE_BUFFER);
+      glDeleteBuffers(1, &buffer.mBuffer);
+    }
+
+    glGenBuffers(1, &buffer.mBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer.mBuffer);
+    glBufferStorage(GL_TEXTURE_BUFFER, mBufferCapacity, nullptr, flags);
+    buffer.mData = static_cast<uint8_t*>(
+        glMapBufferRange(GL_TEXTURE_BUFFER, 0, mBufferCapacity, flags));
+
+    glBindTexture(GL_TEXTURE_BUFFER, buffer.mTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA8, buffer.mBuffer);
+  }
+
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GuiItem::copySharedTexture(void* sharedHandle, uint32_t buffer) {
+#ifdef _WIN32
+  auto it = mSharedTextures.find(sharedHandle);
+
+  if (it == mSharedTextures.end()) {
+    SharedTexture texture;
+    glCreateMemoryObjectsEXT(1, &texture.mMemory);
+
+    GLint dedicated = GL_TRUE;
+    glMemoryObjectParameterivEXT(texture.mMemory, GL_DEDICATED_MEMORY_OBJECT_EXT, &dedicated);
+
+    GLuint64 size = 4 * sizeof(uint8_t) * mTextureSizeX * mTextureSizeY;
+    glImportMemoryWin32HandleEXT(
+        texture.mMemory, size, GL_HANDLE_TYPE_D3D11_IMAGE_KMT_EXT, sharedHandle);
+
+    glGenTextures(1, &texture.mTexture);
+    glBindTexture(GL_TEXTURE_2D, texture.mTexture);
+    glTexStorageMem2DEXT(
+        GL_TEXTURE_2D, 1, GL_RGBA8, mTextureSizeX, mTextureSizeY, texture.mMemory, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    it = mSharedTextures.emplace(sharedHandle, texture).first;
+  }
+
+  // The D3D11 texture contains BGRA data, just like the buffer of software rendering. As it is
+  // imported as RGBA, the bytes are copied unchanged.
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+  glBindTexture(GL_TEXTURE_2D, it->second.mTexture);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#else
+  (void)sharedHandle;
+  (void)buffer;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GuiItem::clearSharedTextures() {
+#ifdef _WIN32
+  for (auto const& [handle, texture] : mSharedTextures) {
+    glDeleteTextures(1, &texture.mTexture);
+    glDeleteMemoryObjectsEXT(1, &texture.mMemory);
   }
+#endif
 
-  return mBufferData;
+  mSharedTextures.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -298,7 +565,7 @@ void GuiItem::updateSizes() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 uint32_t GuiItem::getTexture() const {
-  return mTexture;
+  return mTextureBuffers.at(mCurrentBuffer).mTexture;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
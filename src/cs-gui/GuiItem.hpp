@@ -10,6 +10,10 @@
 
 #include "WebView.hpp"
 
+#include <GL/glew.h>
+#include <array>
+#include <unordered_map>
+
 class VistaTexture;
 
 namespace cs::gui {
@@ -66,6 +70,22 @@ class CS_GUI_EXPORT GuiItem : public WebView {
   void setIsEnabled(bool bEnabled);
   bool getIsEnabled() const;
 
+  /// The region of the texture in pixels which has changed since clearChangedRegion() has been
+  /// called last. The origin is the top left corner. This is used by GuiAreas which cache the
+  /// composited items.
+  Rect const& getChangedRegion() const;
+  void        clearChangedRegion();
+
+  /// This has to be called whenever the item is drawn, the GuiAreas do this. The screen scale is
+  /// the size of the item on screen relative to its size in pixels. Items are painted at a frame
+  /// rate proportional to this. Items which are disabled or have not been drawn for some frames
+  /// are hidden, so that they are not painted at all.
+  void markDrawn(float screenScale = 1.F);
+
+  /// Adjusts the frame rate and hidden state of all items according to how they have been drawn
+  /// since the last call. This is called by the GuiManager once each frame.
+  static void updateFrameRates();
+
   /// Returns true when an HTML element is focused which can receive keyboard input.
   bool getIsKeyboardInputElementFocused() const;
 
@@ -82,16 +102,44 @@ class CS_GUI_EXPORT GuiItem : public WebView {
   /// Gets called, when the parent GuiArea changes size.
   void onAreaResize(int width, int height);
 
-  /// @return The current HTML output as an OpenGL texture.
+  /// @return The current HTML output as an OpenGL buffer texture.
   uint32_t getTexture() const;
 
  private:
   uint8_t* updateTexture(DrawEvent const& event);
   void     updateSizes();
 
-  uint32_t mTextureBuffer{};
-  uint32_t mTexture{};
-  uint8_t* mBufferData = nullptr;
+  /// Makes sure that each texture buffer can hold the given number of bytes.
+  void reserveTextureBuffers(std::size_t size);
+
+  /// Copies the shared texture of an accelerated paint into the given buffer on the GPU.
+  void copySharedTexture(void* sharedHandle, uint32_t buffer);
+  void clearSharedTextures();
+
+  /// The pixels are written alternately to one of these buffers, while the GPU draws the most
+  /// recently written one. A buffer is only written once the GPU has finished drawing it.
+  struct TextureBuffer {
+    uint32_t mBuffer{};
+    uint32_t mTexture{};
+    uint8_t* mData  = nullptr;
+    GLsync   mFence = nullptr;
+
+    /// The bounding box of all regions which have been written to the other buffers since this
+    /// buffer has been written last.
+    Rect mDirtyRegion{};
+  };
+
+  std::array<TextureBuffer, 3> mTextureBuffers;
+  std::size_t                  mCurrentBuffer  = 0;
+  std::size_t                  mBufferCapacity = 0;
+
+  /// The shared textures of accelerated painting, imported as OpenGL textures.
+  struct SharedTexture {
+    uint32_t mMemory{};
+    uint32_t mTexture{};
+  };
+
+  std::unordered_map<void*, SharedTexture> mSharedTextures;
 
   // in pixels
   int mTextureSizeX = 0;
@@ -108,6 +156,13 @@ class CS_GUI_EXPORT GuiItem : public WebView {
   bool mIsRelSizeX, mIsRelSizeY, mIsRelPositionX, mIsRelPositionY, mIsRelOffsetX, mIsRelOffsetY;
   bool mIsEnabled                     = true;
   bool mIsKeyboardInputElementFocused = false;
+
+  Rect mChangedRegion{};
+
+  // The largest screen scale passed to markDrawn() since the last updateFrameRates(). This is
+  // negative if the item has not been drawn since then.
+  float mDrawnScale       = -1.F;
+  int   mFramesSinceDrawn = 0;
 };
 
 } // namespace cs::gui
@@ -20,6 +20,9 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace cs::gui {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -71,6 +74,40 @@ void main() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+const char* const ScreenSpaceGuiArea::CACHE_VERT = R"(
+vec2 positions[4] = vec2[](
+    vec2(-1.0,  1.0),
+    vec2( 1.0,  1.0),
+    vec2(-1.0, -1.0),
+    vec2( 1.0, -1.0)
+);
+
+out vec2 vTexCoords;
+
+void main() {
+  vec2 p = positions[gl_VertexID];
+  vTexCoords = p * 0.5 + 0.5;
+  gl_Position = vec4(p, 0, 1);
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const ScreenSpaceGuiArea::CACHE_FRAG = R"(
+in vec2 vTexCoords;
+
+uniform sampler2D cache;
+
+layout(location = 0) out vec4 vOutColor;
+
+void main() {
+  vOutColor = texture(cache, vTexCoords);
+  if (vOutColor.a == 0.0) discard;
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 ScreenSpaceGuiArea::ScreenSpaceGuiArea(VistaViewport* pViewport)
     : mViewport(pViewport) {
   Observe(mViewport->GetViewportProperties());
@@ -79,6 +116,13 @@ ScreenSpaceGuiArea::ScreenSpaceGuiArea(VistaViewport* pViewport)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+ScreenSpaceGuiArea::~ScreenSpaceGuiArea() {
+  glDeleteFramebuffers(1, &mCacheFramebuffer);
+  glDeleteTextures(1, &mCacheTexture);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 int ScreenSpaceGuiArea::getWidth() const {
   return mWidth;
 }
@@ -107,19 +151,28 @@ bool ScreenSpaceGuiArea::Do() {
     mUniforms.texSize  = mShader.GetUniformLocation("texSize");
     mUniforms.texture  = mShader.GetUniformLocation("texture");
 
+    mCacheShader = VistaGLSLShader();
+    mCacheShader.InitVertexShaderFromString(defines + CACHE_VERT);
+    mCacheShader.InitFragmentShaderFromString(defines + CACHE_FRAG);
+    mCacheShader.Link();
+
+    mUniforms.cache = mCacheShader.GetUniformLocation("cache");
+
     mShaderDirty = false;
   }
 
-  glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+  std::array<GLint, 4> viewport{};
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glDepthMask(GL_FALSE);
-  glDisable(GL_DEPTH_TEST);
+  if (viewport.at(2) != mCacheWidth || viewport.at(3) != mCacheHeight) {
+    resizeCache(viewport.at(2), viewport.at(3));
+  }
 
-  mShader.Bind();
+  // Collect the items which are drawn back-to-front and the region of the cache which has changed.
+  // The region is in pixels of the cache with the origin in the lower left corner.
+  std::vector<std::pair<GuiItem*, std::array<float, 4>>> layout;
+  Rect                                                   dirtyRegion{};
 
-  // draw back-to-front
   auto const& items = getItems();
   for (auto item = items.rbegin(); item != items.rend(); ++item) {
     auto* guiItem = *item;
@@ -127,14 +180,83 @@ bool ScreenSpaceGuiArea::Do() {
     bool textureRightSize = guiItem->getWidth() == guiItem->getTextureSizeX() &&
                             guiItem->getHeight() == guiItem->getTextureSizeY();
 
-    if (guiItem->getIsEnabled() && textureRightSize) {
-      float posX = guiItem->getRelPositionX() + guiItem->getRelOffsetX();
-      float posY = 1 - guiItem->getRelPositionY() - guiItem->getRelOffsetY();
-      mShader.SetUniform(mUniforms.position, posX, posY);
+    // The item has to be painted even if the texture has the wrong size, else it would never get
+    // the right size.
+    if (guiItem->getIsEnabled()) {
+      guiItem->markDrawn();
+    }
 
+    if (guiItem->getIsEnabled() && textureRightSize) {
+      float posX   = guiItem->getRelPositionX() + guiItem->getRelOffsetX();
+      float posY   = 1 - guiItem->getRelPositionY() - guiItem->getRelOffsetY();
       float scaleX = guiItem->getRelSizeX();
       float scaleY = guiItem->getRelSizeY();
-      mShader.SetUniform(mUniforms.scale, scaleX, scaleY);
+      layout.push_back({guiItem, {posX, posY, scaleX, scaleY}});
+
+      Rect const& changed = guiItem->getChangedRegion();
+
+      if (changed.mWidth > 0 && changed.mHeight > 0) {
+        float left   = (posX - 0.5F * scaleX) * static_cast<float>(mCacheWidth);
+        float top    = (posY + 0.5F * scaleY) * static_cast<float>(mCacheHeight);
+        float pixelX = scaleX * static_cast<float>(mCacheWidth) /
+                       static_cast<float>(guiItem->getTextureSizeX());
+        float pixelY = scaleY * static_cast<float>(mCacheHeight) /
+                       static_cast<float>(guiItem->getTextureSizeY());
+
+        // One pixel is added on each side to account for rounding.
+        int x0 = static_cast<int>(std::floor(left + static_cast<float>(changed.mX) * pixelX)) - 1;
+        int x1 = static_cast<int>(
+                     std::ceil(left + static_cast<float>(changed.mX + changed.mWidth) * pixelX)) +
+                 1;
+        int y0 = static_cast<int>(std::floor(
+                     top - static_cast<float>(changed.mY + changed.mHeight) * pixelY)) -
+                 1;
+        int y1 = static_cast<int>(std::ceil(top - static_cast<float>(changed.mY) * pixelY)) + 1;
+
+        dirtyRegion = getBoundingBox(dirtyRegion, {x0, y0, x1 - x0, y1 - y0});
+      }
+
+      guiItem->clearChangedRegion();
+    }
+  }
+
+  // If items have been added, removed, moved or resized, everything is composited again.
+  if (layout != mCachedLayout) {
+    mCachedLayout = layout;
+    dirtyRegion   = {0, 0, mCacheWidth, mCacheHeight};
+  }
+
+  int x0 = std::max(dirtyRegion.mX, 0);
+  int y0 = std::max(dirtyRegion.mY, 0);
+  int x1 = std::min(dirtyRegion.mX + dirtyRegion.mWidth, mCacheWidth);
+  int y1 = std::min(dirtyRegion.mY + dirtyRegion.mHeight, mCacheHeight);
+
+  glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT |
+               GL_VIEWPORT_BIT);
+
+  glEnable(GL_BLEND);
+  glDepthMask(GL_FALSE);
+  glDisable(GL_DEPTH_TEST);
+
+  if (x1 > x0 && y1 > y0) {
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mCacheFramebuffer);
+
+    glViewport(0, 0, mCacheWidth, mCacheHeight);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x0, y0, x1 - x0, y1 - y0);
+    glClearColor(0.F, 0.F, 0.F, 0.F);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // The cache stores premultiplied colors, so that it can be blended in one step.
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    mShader.Bind();
+
+    for (auto const& [guiItem, rect] : mCachedLayout) {
+      mShader.SetUniform(mUniforms.position, rect.at(0), rect.at(1));
+      mShader.SetUniform(mUniforms.scale, rect.at(2), rect.at(3));
 
       glUniform2i(mUniforms.texSize, guiItem->getTextureSizeX(), guiItem->getTextureSizeY());
 
@@ -146,9 +268,26 @@ bool ScreenSpaceGuiArea::Do() {
 
       glBindTexture(GL_TEXTURE_BUFFER, 0);
     }
+
+    mShader.Release();
+
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glViewport(viewport.at(0), viewport.at(1), viewport.at(2), viewport.at(3));
   }
 
-  mShader.Release();
+  // Now draw the cache with a single quad.
+  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+  mCacheShader.Bind();
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, mCacheTexture);
+  mCacheShader.SetUniform(mUniforms.cache, 0);
+
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  mCacheShader.Release();
 
   glPopAttrib();
 
@@ -190,6 +329,39 @@ void ScreenSpaceGuiArea::ObserverUpdate(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void ScreenSpaceGuiArea::resizeCache(int width, int height) {
+  mCacheWidth  = width;
+  mCacheHeight = height;
+
+  if (mCacheFramebuffer == 0) {
+    glGenFramebuffers(1, &mCacheFramebuffer);
+    glGenTextures(1, &mCacheTexture);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, mCacheTexture);
+  glTexImage2D(
+      GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  // The cache has the size of the viewport and is drawn pixel-aligned, so it needs no mipmaps.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  GLint framebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mCacheFramebuffer);
+  glFramebufferTexture2D(
+      GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mCacheTexture, 0);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+  // The content of the cache is lost.
+  mCachedLayout.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void ScreenSpaceGuiArea::onViewportChange() {
   mViewport->GetViewportProperties()->GetSize(mWidth, mHeight);
   updateItems();
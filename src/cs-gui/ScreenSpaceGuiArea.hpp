@@ -13,6 +13,7 @@
 #include <VistaAspects/VistaObserver.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
+#include <array>
 #include <vector>
 
 class VistaTransformNode;
@@ -42,12 +43,13 @@ class CS_GUI_EXPORT ScreenSpaceGuiArea : public GuiArea,
   ScreenSpaceGuiArea& operator=(ScreenSpaceGuiArea const& other) = delete;
   ScreenSpaceGuiArea& operator=(ScreenSpaceGuiArea&& other) = delete;
 
-  ~ScreenSpaceGuiArea() override = default;
+  ~ScreenSpaceGuiArea() override;
 
   int getWidth() const override;
   int getHeight() const override;
 
-  /// Draws the UI to screen.
+  /// Draws the UI to screen. The items are composited into a texture which is then drawn with a
+  /// single quad. Only the regions of this texture which have changed are composited again.
   bool Do() override;
   bool GetBoundingBox(VistaBoundingBox& oBoundingBox) override;
 
@@ -57,6 +59,8 @@ class CS_GUI_EXPORT ScreenSpaceGuiArea : public GuiArea,
  private:
   virtual void onViewportChange();
 
+  void resizeCache(int width, int height);
+
   VistaViewport*  mViewport;
   VistaGLSLShader mShader;
   bool            mShaderDirty           = true;
@@ -69,10 +73,24 @@ class CS_GUI_EXPORT ScreenSpaceGuiArea : public GuiArea,
     uint32_t scale    = 0;
     uint32_t texSize  = 0;
     uint32_t texture  = 0;
+    uint32_t cache    = 0;
   } mUniforms;
 
+  // The composited items with premultiplied alpha.
+  VistaGLSLShader mCacheShader;
+  uint32_t        mCacheFramebuffer = 0;
+  uint32_t        mCacheTexture     = 0;
+  int             mCacheWidth       = 0;
+  int             mCacheHeight      = 0;
+
+  // The items which have been composited into the cache with their position and scale. If this
+  // changes, the entire cache is composited again.
+  std::vector<std::pair<GuiItem*, std::array<float, 4>>> mCachedLayout;
+
   static const char* const QUAD_VERT;
   static const char* const QUAD_FRAG;
+  static const char* const CACHE_VERT;
+  static const char* const CACHE_FRAG;
 };
 
 } // namespace cs::gui
@@ -7,15 +7,83 @@
 
 #include "WebView.hpp"
 
+#include "gui.hpp"
 #include "internal/WebViewClient.hpp"
 
 #include <include/cef_app.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
 #include <thread>
+#include <unordered_set>
 
 namespace cs::gui {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// all WebViews which have calls which have not been sent to the browser yet
+std::unordered_set<WebView const*> pendingWebViews;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Browsers of destroyed WebViews which can be reused. The browser settings cannot be changed after
+// creation, hence the key contains whether local file access is allowed. The oldest browser is at
+// the front.
+struct PooledBrowser {
+  std::string            mKey;
+  CefRefPtr<CefBrowser>  mBrowser;
+  detail::WebViewClient* mClient;
+};
+
+std::deque<PooledBrowser> browserPool;
+uint32_t                  browserPoolSize = 0;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns something like "https://example.com:8080" for the given URL. All file URLs have the same
+// origin "file://".
+std::string getPoolKey(std::string const& url, bool allowLocalFileAccess) {
+  std::size_t scheme = url.find("://");
+  std::string origin =
+      scheme == std::string::npos ? url : url.substr(0, url.find_first_of("/?#", scheme + 3));
+
+  return origin + (allowLocalFileAccess ? " (local file access)" : "");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void closeBrowser(CefRefPtr<CefBrowser> const& browser) {
+  auto host = browser->GetHost();
+  while (!host->TryCloseBrowser()) {
+    CefDoMessageLoopWork();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // The WebViewClient is magically deleted by the code above.
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Closes the oldest pooled browsers until the pool is not larger than browserPoolSize.
+void trimBrowserPool() {
+  while (browserPool.size() > browserPoolSize) {
+    auto browser = browserPool.front().mBrowser;
+    browserPool.pop_front();
+    closeBrowser(browser);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 class DevToolsClient : public CefClient {
  public:
   IMPLEMENT_REFCOUNTING(DevToolsClient);
@@ -24,7 +92,27 @@ class DevToolsClient : public CefClient {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 WebView::WebView(const std::string& url, int width, int height, bool allowLocalFileAccess)
-    : mClient(new detail::WebViewClient()) {
+    : mPoolKey(getPoolKey(url, allowLocalFileAccess)) {
+
+  // Reuse the most recently pooled browser of the same origin. It shares the renderer process with
+  // the previous page, so loading the new page is much cheaper than creating a new browser.
+  auto pooled = std::find_if(browserPool.rbegin(), browserPool.rend(),
+      [this](PooledBrowser const& browser) { return browser.mKey == mPoolKey; });
+
+  if (pooled != browserPool.rend()) {
+    mClient  = pooled->mClient;
+    mBrowser = pooled->mBrowser;
+    browserPool.erase(std::next(pooled).base());
+
+    WebView::resize(width, height);
+    mBrowser->GetHost()->SetWindowlessFrameRate(sMaxFrameRate);
+    mBrowser->GetHost()->SetZoomLevel(0.0);
+    mBrowser->GetHost()->WasHidden(false);
+    mBrowser->GetMainFrame()->LoadURL(url);
+    return;
+  }
+
+  mClient = new detail::WebViewClient(); // NOLINT(cppcoreguidelines-owning-memory)
   WebView::resize(width, height);
 
   CefWindowInfo info;
@@ -33,14 +121,16 @@ WebView::WebView(const std::string& url, int width, int height, bool allowLocalF
 
 #ifdef _MSC_VER
   info.SetAsWindowless(nullptr);
+
+  // If enabled, the pages are shared as D3D11 textures via RenderHandler::OnAcceleratedPaint().
+  info.shared_texture_enabled = getIsAcceleratedPaintEnabled();
 #else
   info.SetAsWindowless(0);
 #endif
 
   CefBrowserSettings browserSettings;
 
-  int const targetFrameRate             = 60;
-  browserSettings.windowless_frame_rate = targetFrameRate;
+  browserSettings.windowless_frame_rate = sMaxFrameRate;
   browserSettings.web_security          = allowLocalFileAccess ? STATE_DISABLED : STATE_ENABLED;
 
   mBrowser =
@@ -50,14 +140,27 @@ WebView::WebView(const std::string& url, int width, int height, bool allowLocalF
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 WebView::~WebView() {
-  auto host = mBrowser->GetHost();
-  while (!host->TryCloseBrowser()) {
-    CefDoMessageLoopWork();
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  pendingWebViews.erase(this);
+
+  if (browserPoolSize == 0) {
+    closeBrowser(mBrowser);
+    return;
   }
 
-  // magically called by the code above
-  // delete mClient;
+  // Keep the browser for reuse. The empty page frees the resources of the current page.
+  mClient->Reset();
+  mBrowser->GetHost()->WasHidden(true);
+  mBrowser->GetMainFrame()->LoadURL("about:blank");
+  browserPool.push_back({mPoolKey, mBrowser, mClient});
+
+  trimBrowserPool();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebView::setBrowserPoolSize(uint32_t size) {
+  browserPoolSize = size;
+  trimBrowserPool();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -163,6 +266,36 @@ void WebView::setCanScroll(bool canScroll) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WebView::setFrameRate(int frameRate) {
+  if (mFrameRate != frameRate) {
+    mFrameRate = frameRate;
+    mBrowser->GetHost()->SetWindowlessFrameRate(frameRate);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int WebView::getFrameRate() const {
+  return mFrameRate;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebView::setIsHidden(bool hidden) {
+  if (mIsHidden != hidden) {
+    mIsHidden = hidden;
+    mBrowser->GetHost()->WasHidden(hidden);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool WebView::getIsHidden() const {
+  return mIsHidden;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 int WebView::getWidth() const {
   return mClient->GetInternalRenderHandler()->GetWidth();
 }
@@ -259,12 +392,20 @@ void WebView::injectMouseEvent(MouseEvent const& event) {
 
   switch (event.mType) {
   case MouseEvent::Type::eMove:
+    // The InputManager injects a move event each frame while the page is hovered. If the pointer
+    // did not move, there is no need to send a message to the render process.
+    if (mMouseInside && event.mX == mMouseX && event.mY == mMouseY) {
+      break;
+    }
+
     cef_event.x = mMouseX = event.mX;
     cef_event.y = mMouseY = event.mY;
+    mMouseInside          = true;
     mBrowser->GetHost()->SendMouseMoveEvent(cef_event, false);
     break;
 
   case MouseEvent::Type::eLeave:
+    mMouseInside = false;
     mBrowser->GetHost()->SendMouseMoveEvent(cef_event, true);
     break;
 
@@ -341,26 +482,105 @@ void WebView::injectKeyEvent(KeyEvent const& event) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void WebView::callJavascriptImpl(
-    std::string const& function, std::vector<std::string> const& args) const {
+    std::string const& function, std::vector<std::string> const& args, bool coalesce) const {
   std::string call(function + "( ");
   for (auto&& s : args) {
     call += s + ",";
   }
   call.back() = ')';
 
-  CefRefPtr<CefFrame> frame = mBrowser->GetMainFrame();
-  frame->ExecuteJavaScript(call, frame->GetURL(), 0);
+  enqueueJavascript(std::move(call), coalesce ? function : "");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void WebView::executeJavascript(std::string const& code) const {
+  // The code may contain top-level declarations, so it cannot be wrapped into a try-block like the
+  // function calls. The pending calls are sent first to keep the order of execution.
+  flushJavascript();
+
   CefRefPtr<CefFrame> frame = mBrowser->GetMainFrame();
   frame->ExecuteJavaScript(code, frame->GetURL(), 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WebView::callJavascriptWithArray(
+    std::string const& function, std::vector<float> const& data) const {
+
+  // Binary values must not be empty, so there is no need for the binary message in this case.
+  if (data.empty()) {
+    enqueueJavascript(function + "(new Float32Array(0))", "");
+    return;
+  }
+
+  // The message is sent right away, so the pending calls are sent first to keep the order of
+  // execution.
+  flushJavascript();
+
+  CefRefPtr<CefProcessMessage> msg = CefProcessMessage::Create("callJavascriptWithArray");
+  msg->GetArgumentList()->SetString(0, function);
+  msg->GetArgumentList()->SetBinary(
+      1, CefBinaryValue::Create(data.data(), data.size() * sizeof(float)));
+  mBrowser->GetMainFrame()->SendProcessMessage(PID_RENDERER, msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebView::flushJavascript() const {
+  pendingWebViews.erase(this);
+
+  if (mPendingJavascript.empty()) {
+    return;
+  }
+
+  // Each call is executed in its own try-block, so that one failing call does not prevent the
+  // execution of the following calls. This mimics executing them one after another.
+  std::string script;
+  for (auto const& code : mPendingJavascript) {
+    if (!code.empty()) {
+      script += "try {\n" + code + "\n} catch (e) { console.error(e); }\n";
+    }
+  }
+
+  mPendingJavascript.clear();
+  mCoalescedCalls.clear();
+
+  CefRefPtr<CefFrame> frame = mBrowser->GetMainFrame();
+  frame->ExecuteJavaScript(script, frame->GetURL(), 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebView::flushAllJavascript() {
+  // flushJavascript() removes the WebView from the set, so we iterate over a copy.
+  auto webViews = pendingWebViews;
+  for (auto const* webView : webViews) {
+    webView->flushJavascript();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebView::enqueueJavascript(std::string code, std::string const& coalesceKey) const {
+  if (!coalesceKey.empty()) {
+    auto it = mCoalescedCalls.find(coalesceKey);
+    if (it != mCoalescedCalls.end()) {
+      // The earlier call is dropped and the latest call is executed at its new position, so that
+      // it is still executed after all calls which were made before it.
+      mPendingJavascript[it->second].clear();
+      it->second = mPendingJavascript.size();
+    } else {
+      mCoalescedCalls.emplace(coalesceKey, mPendingJavascript.size());
+    }
+  }
+
+  mPendingJavascript.push_back(std::move(code));
+  pendingWebViews.insert(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void WebView::registerCallback(
     std::string const& name, std::string const& comment, std::function<void()> const& callback) {
   registerJSCallbackImpl(name, comment, {},
@@ -398,7 +618,9 @@ void WebView::registerJSCallbackImpl(std::string const& name, std::string const&
       {std::type_index(typeid(std::string)), "string"},
       {std::type_index(typeid(std::optional<double>)), "optionalDouble"},
       {std::type_index(typeid(std::optional<bool>)), "optionalBool"},
-      {std::type_index(typeid(std::optional<std::string>)), "optionalString"}};
+      {std::type_index(typeid(std::optional<std::string>)), "optionalString"},
+      {std::type_index(typeid(std::vector<double>)), "array"},
+      {std::type_index(typeid(std::optional<std::vector<double>>)), "optionalArray"}};
 
   std::unordered_map<std::type_index, int> typeCounts;
 
@@ -414,9 +636,10 @@ void WebView::registerJSCallbackImpl(std::string const& name, std::string const&
     }
   }
 
-  // When executing the 'window.callNative()' method, we need the callback's name as first
-  // parameter.
-  std::string callSignature = "'" + name + "'" + (signature.empty() ? "" : ", " + signature);
+  // Register the actual 'window.callNative()' handler. The returned ID is passed as first
+  // parameter to 'window.callNative()', this is faster than passing the callback's name.
+  uint32_t    id            = mClient->RegisterJSCallback(name, callback);
+  std::string callSignature = std::to_string(id) + (signature.empty() ? "" : ", " + signature);
 
   // Format the comment. This is a bit more involved since we do line wrapping for long comments.
   std::string formattedComment = "  // ";
@@ -438,7 +661,8 @@ void WebView::registerJSCallbackImpl(std::string const& name, std::string const&
   // This registers the callback as a property of the CosmoScout.callbacks object. As the name may
   // contain multiple dots, this is a little tricky. We have to create multiple chained objects;
   // e.g. for the callback "notifications.print.warning", we first have to create the object
-  // "notifications", then "print" and then the function "warning".
+  // "notifications", then "print" and then the function "warning". The ID is stored on the
+  // function so that it can be used with 'window.callNativeCoalesced()'.
   std::string cmd = R"(
 if (typeof CosmoScout !== 'undefined') {
 let components = '$name'.split('.');
@@ -449,16 +673,15 @@ $comment
 
   window.callNative($callSignature);
 }
+CosmoScout.callbacks.$name.id = $id;
 })";
 
   utils::replaceString(cmd, "$name", name);
   utils::replaceString(cmd, "$comment", formattedComment);
   utils::replaceString(cmd, "$signature", signature);
   utils::replaceString(cmd, "$callSignature", callSignature);
+  utils::replaceString(cmd, "$id", std::to_string(id));
   executeJavascript(cmd);
-
-  // Register the actual 'window.callNative()' handler.
-  mClient->RegisterJSCallback(name, callback);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -18,6 +18,8 @@
 #include <iostream>
 #include <optional>
 #include <typeindex>
+#include <unordered_map>
+#include <vector>
 
 namespace cs::gui {
 
@@ -30,7 +32,9 @@ namespace cs::gui {
 /// individual WebViews of CosmoScout VR.
 class CS_GUI_EXPORT WebView {
  public:
-  /// Creates a new WebView for the given page at the location of the URL.
+  /// Creates a new WebView for the given page at the location of the URL. If the pool contains the
+  /// browser of a destroyed WebView which showed a page of the same origin with the same file
+  /// access, that browser is reused. Else a new browser is created.
   WebView(const std::string& url, int width, int height, bool allowLocalFileAccess = false);
 
   WebView(WebView const& other) = delete;
@@ -57,16 +61,51 @@ class CS_GUI_EXPORT WebView {
   /// @param a        The arguments of the function. Each arguments type must be convertible to a
   ///                 string be either providing a definition for core::utils::toString or by
   ///                 implementing the operator<<() for that type.
+  ///
+  /// The call is not executed right away. All calls of one frame are collected and sent to the
+  /// browser as one script by cs::gui::update(), in the order in which they were made. A call
+  /// which throws an exception does not prevent the execution of the following calls.
   template <typename... Args>
   void callJavascript(std::string const& function, Args&&... a) const {
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
     std::vector<std::string> args = {(utils::toString(a))...};
-    callJavascriptImpl(function, args);
+    callJavascriptImpl(function, args, false);
   }
 
-  /// Execute Javascript code.
+  /// Like callJavascript(), but if the same function is called again with this method before the
+  /// calls are sent to the browser, only the last of these calls is executed. Use this for
+  /// functions which only set a state, for example for updating a displayed value each frame.
+  template <typename... Args>
+  void callJavascriptCoalesced(std::string const& function, Args&&... a) const {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+    std::vector<std::string> args = {(utils::toString(a))...};
+    callJavascriptImpl(function, args, true);
+  }
+
+  /// Calls an existing Javascript function with a single Float32Array argument. Unlike with
+  /// callJavascript(), the data is not converted to a string: It is sent to the render process as
+  /// a binary message and wrapped into an ArrayBuffer there. Use this for large numeric data like
+  /// elevation profiles or timing series. The call is sent right away, after all pending calls of
+  /// callJavascript().
+  void callJavascriptWithArray(std::string const& function, std::vector<float> const& data) const;
+
+  /// Execute Javascript code. This is sent to the browser right away, after all pending calls of
+  /// callJavascript(). Hence, calling this often prevents the batching of the calls.
   void executeJavascript(std::string const& code) const;
 
+  /// Sends all pending calls of callJavascript() to the browser right away.
+  /// Usually there is no need to call this, it is done by cs::gui::update() once each frame.
+  void flushJavascript() const;
+
+  /// Calls flushJavascript() on all WebViews with pending calls.
+  static void flushAllJavascript();
+
+  /// When a WebView is destroyed, its browser is kept in a pool of the given size for reuse by a
+  /// later WebView instead of being closed. Pooled browsers show an empty page and are hidden. If
+  /// the pool is full, the least recently pooled browser is closed. Setting the size to zero
+  /// closes all pooled browsers. This is called by cs::gui::init() and cs::gui::cleanUp().
+  static void setBrowserPoolSize(uint32_t size);
+
   /// Register a callback which can be called from Javascript with the
   /// "window.callNative('callback_name', ... args ...)" function. Callbacks are also registered as
   /// CosmoScout.callbacks.callback_name(... args ...). For the latter to work, the WebView has to
@@ -76,7 +115,8 @@ class CS_GUI_EXPORT WebView {
   /// registerCallback() takes no arguments from the JavaScript side. There is another other
   /// versions below, which takes arbitrary arguments. JavaScript variables passed to the
   /// window.callNative function will be converted to C++ types. This works for doubles, bools and
-  /// std::strings.
+  /// std::strings. Arrays of numbers and typed arrays like Float32Array are received as
+  /// std::vector<double>.
   ///
   /// @param name     Name of the callback.
   /// @param comment  The comment will be visible when inspecting the CosmoScout.callbacks object
@@ -133,6 +173,16 @@ class CS_GUI_EXPORT WebView {
   virtual bool getCanScroll() const;
   virtual void setCanScroll(bool canScroll);
 
+  /// The number of times per second the page is painted at most. The default is sMaxFrameRate.
+  static constexpr int sMaxFrameRate = 60;
+  void                 setFrameRate(int frameRate);
+  int                  getFrameRate() const;
+
+  /// Hidden pages are not painted at all. Their JavaScript code still runs, but Chromium may
+  /// throttle timers and animation frames.
+  void setIsHidden(bool hidden);
+  bool getIsHidden() const;
+
   /// Returns the current size of the web page.
   virtual int getWidth() const;
   virtual int getHeight() const;
@@ -164,7 +214,8 @@ class CS_GUI_EXPORT WebView {
   /// Toggle the focused state for this page.
   virtual void injectFocusEvent(bool focus);
 
-  /// Forward a MouseEvent to the page.
+  /// Forward a MouseEvent to the page. Move events to the current mouse position are not sent
+  /// again, as the InputManager injects a move event every frame while the page is hovered.
   virtual void injectMouseEvent(MouseEvent const& event);
 
   /// Forward a KeyEvent to the page.
@@ -177,8 +228,8 @@ class CS_GUI_EXPORT WebView {
   void closeDevTools();
 
  private:
-  /// This ensures statically that all given template types are either bool, double, std::string or
-  /// std::string&&.
+  /// This ensures statically that all given template types are either bool, double, std::string,
+  /// std::string&& or std::vector<double>.
   template <typename... Args>
   static constexpr void assertJavaScriptTypes() {
     CS_WARNINGS_PUSH
@@ -188,16 +239,19 @@ class CS_GUI_EXPORT WebView {
     CS_WARNINGS_POP
   }
 
-  /// This ensures statically that the given template type is either bool, double, std::string or
-  /// std::string&&.
+  /// This ensures statically that the given template type is either bool, double, std::string,
+  /// std::string&& or std::vector<double>.
   template <typename T>
   static constexpr void assertJavaScriptType() {
     static_assert(
         std::is_same<T, double>() || std::is_same<T, bool>() || std::is_same<T, std::string>() ||
-            std::is_same<T, std::string&&>() || std::is_same<T, std::optional<double>>() ||
-            std::is_same<T, std::optional<bool>>() || std::is_same<T, std::optional<std::string>>(),
-        "Only doubles, bools and std::strings are supported for JavaScript callback parameters "
-        "(and std::optionals thereof)!");
+            std::is_same<T, std::string&&>() || std::is_same<T, std::vector<double>>() ||
+            std::is_same<T, std::vector<double>&&>() || std::is_same<T, std::optional<double>>() ||
+            std::is_same<T, std::optional<bool>>() ||
+            std::is_same<T, std::optional<std::string>>() ||
+            std::is_same<T, std::optional<std::vector<double>>>(),
+        "Only doubles, bools, std::strings and std::vector<double> are supported for JavaScript "
+        "callback parameters (and std::optionals thereof)!");
   }
 
   /// The UnderlyingValue struct is used to access the actual value in a std::optional<JSType>.
@@ -249,27 +303,41 @@ class CS_GUI_EXPORT WebView {
         });
   }
 
-  void callJavascriptImpl(std::string const& function, std::vector<std::string> const& args) const;
+  void callJavascriptImpl(
+      std::string const& function, std::vector<std::string> const& args, bool coalesce) const;
+  void enqueueJavascript(std::string code, std::string const& coalesceKey) const;
   void registerJSCallbackImpl(std::string const& name, std::string const& comment,
       std::vector<std::type_index>&&                                   types,
       std::function<void(std::vector<std::optional<JSType>>&&)> const& callback);
 
-  detail::WebViewClient* mClient;
+  detail::WebViewClient* mClient = nullptr;
   CefRefPtr<CefBrowser>  mBrowser;
 
+  // Browsers are only reused for WebViews with the same key, see WebView::WebView().
+  std::string mPoolKey;
+
   bool mInteractive = true;
   bool mCanScroll   = true;
+  bool mIsHidden    = false;
+  int  mFrameRate   = sMaxFrameRate;
 
   // Input state.
-  int mMouseX         = 0;
-  int mMouseY         = 0;
-  int mMouseModifiers = 0;
+  int  mMouseX         = 0;
+  int  mMouseY         = 0;
+  int  mMouseModifiers = 0;
+  bool mMouseInside    = false;
 
   // Time point for the last left mouse click
   std::chrono::steady_clock::time_point mLastClick;
 
   // Count number of left mouse button clicks
   int mClickCount = 1;
+
+  // Calls which have not been sent to the browser yet. Coalesced calls which have been replaced by
+  // a later call are left empty. mCoalescedCalls stores the index of the latest call of each
+  // function called with callJavascriptCoalesced().
+  mutable std::vector<std::string>                     mPendingJavascript;
+  mutable std::unordered_map<std::string, std::size_t> mCoalescedCalls;
 };
 
 } // namespace cs::gui
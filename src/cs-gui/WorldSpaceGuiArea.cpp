@@ -199,6 +199,10 @@ bool WorldSpaceGuiArea::Do() {
 
   glGetFloatv(GL_PROJECTION_MATRIX, glMat.data());
   glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMat.data());
+  glm::mat4 projectionMat = glm::make_mat4(glMat.data());
+
+  std::array<GLint, 4> viewport{};
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
 
   // draw back-to-front
   auto const& items = getItems();
@@ -208,13 +212,30 @@ bool WorldSpaceGuiArea::Do() {
     bool textureRightSize = guiItem->getWidth() == guiItem->getTextureSizeX() &&
                             guiItem->getHeight() == guiItem->getTextureSizeY();
 
-    if (guiItem->getIsEnabled() && textureRightSize) {
-      auto localMat = glm::translate(
-          modelViewMat, glm::vec3(guiItem->getRelPositionX() + guiItem->getRelOffsetX() - 0.5,
-                            -guiItem->getRelPositionY() - guiItem->getRelOffsetY() + 0.5, 0.0));
-      localMat =
-          glm::scale(localMat, glm::vec3(guiItem->getRelSizeX(), guiItem->getRelSizeY(), 1.F));
+    if (!guiItem->getIsEnabled()) {
+      continue;
+    }
+
+    auto localMat = glm::translate(
+        modelViewMat, glm::vec3(guiItem->getRelPositionX() + guiItem->getRelOffsetX() - 0.5,
+                          -guiItem->getRelPositionY() - guiItem->getRelOffsetY() + 0.5, 0.0));
+    localMat = glm::scale(localMat, glm::vec3(guiItem->getRelSizeX(), guiItem->getRelSizeY(), 1.F));
+
+    // The item is painted at a lower frame rate if it is small on screen. This is estimated from
+    // the projected height of the item. The item has to be painted even if the texture has the
+    // wrong size, else it would never get the right size.
+    glm::vec4 top    = projectionMat * localMat * glm::vec4(0.F, 0.5F, 0.F, 1.F);
+    glm::vec4 bottom = projectionMat * localMat * glm::vec4(0.F, -0.5F, 0.F, 1.F);
+
+    if (top.w > 0.F && bottom.w > 0.F && guiItem->getHeight() > 0) {
+      float pixels = 0.5F * static_cast<float>(viewport.at(3)) *
+                     glm::length(glm::vec2(top) / top.w - glm::vec2(bottom) / bottom.w);
+      guiItem->markDrawn(pixels / static_cast<float>(guiItem->getHeight()));
+    } else {
+      guiItem->markDrawn();
+    }
 
+    if (textureRightSize) {
       glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glm::value_ptr(localMat));
 
       glUniform2i(mUniforms.texSize, guiItem->getTextureSizeX(), guiItem->getTextureSizeY());
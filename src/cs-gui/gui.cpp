@@ -7,15 +7,19 @@
 
 #include "gui.hpp"
 
+#include "WebView.hpp"
 #include "internal/WebApp.hpp"
+#include "internal/WebViewClient.hpp"
 #include "logger.hpp"
 
+#include <GL/glew.h>
 #include <iostream>
 
 namespace cs::gui {
 
 namespace {
 CefRefPtr<detail::WebApp> app;
+bool                      isAcceleratedPaintEnabled = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -33,13 +37,33 @@ void executeWebProcess(int argc, char* argv[]) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void init() {
+void init(bool acceleratedPaint, uint32_t rendererProcessLimit, uint32_t browserPoolSize) {
 
   if (!app) {
     logger().error("Failed to initialize gui: Please call executeWebProcess() before init()!");
     return;
   }
 
+  if (acceleratedPaint) {
+#ifdef _WIN32
+    if (GLEW_EXT_memory_object_win32) {
+      isAcceleratedPaintEnabled = true;
+    } else {
+      logger().warn("Accelerated painting of the user interface is not supported by the graphics "
+                    "driver. Falling back to software rendering.");
+    }
+#else
+    logger().warn("Accelerated painting of the user interface is only supported on Windows. "
+                  "Falling back to software rendering.");
+#endif
+  }
+
+  // Shared textures are only available if CEF renders on the GPU.
+  app->SetHardwareAccelerated(isAcceleratedPaintEnabled);
+  app->SetRendererProcessLimit(rendererProcessLimit);
+
+  WebView::setBrowserPoolSize(browserPoolSize);
+
   // For some reason CefInitialize changes the global locale. We therefore store
   // it here and reset it at the end of this method.
   std::locale current_locale;
@@ -59,14 +83,23 @@ void init() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool getIsAcceleratedPaintEnabled() {
+  return isAcceleratedPaintEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void cleanUp() {
+  WebView::setBrowserPoolSize(0);
   CefShutdown();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void update() {
+  WebView::flushAllJavascript();
   CefDoMessageLoopWork();
+  detail::WebViewClient::FlushAllCoalescedCalls();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,8 @@
 
 #include "cs_gui_export.hpp"
 
+#include <cstdint>
+
 /// This namespace contains global functionality to interact with the user interface. The UI is a
 /// web application running in the Chromium Embedded Framework (CEF).
 namespace cs::gui {
@@ -19,13 +21,26 @@ namespace cs::gui {
 /// others it blocks until the child process has terminated.
 CS_GUI_EXPORT void executeWebProcess(int argc, char* argv[]); // NOLINT(modernize-avoid-c-arrays)
 
-/// Initializes CEF. Needs to be called after executeWebProcess().
-CS_GUI_EXPORT void init();
+/// Initializes CEF. Needs to be called after executeWebProcess(). If acceleratedPaint is set, CEF
+/// renders the web pages on the GPU and shares them as textures, so that they do not have to be
+/// copied through main memory. This is only supported on Windows with the
+/// GL_EXT_memory_object_win32 extension; else the web pages are rendered in software.
+///
+/// If rendererProcessLimit is larger than zero, all web pages share at most this many renderer
+/// processes. Up to browserPoolSize browsers of destroyed WebViews are kept for reuse, see
+/// WebView::WebView().
+CS_GUI_EXPORT void init(
+    bool acceleratedPaint = false, uint32_t rendererProcessLimit = 0, uint32_t browserPoolSize = 0);
+
+/// Returns true if init() has enabled accelerated painting.
+CS_GUI_EXPORT bool getIsAcceleratedPaintEnabled();
 
 /// Shuts down CEF.
 CS_GUI_EXPORT void cleanUp();
 
-/// Triggers the CEF update function. This should be called once a frame.
+/// Triggers the CEF update function. This should be called once a frame. It also executes the
+/// most recent of the coalesced callback calls made with window.callNativeCoalesced() since the
+/// last frame.
 CS_GUI_EXPORT void update();
 
 } // namespace cs::gui
@@ -7,25 +7,70 @@
 
 #include "JSHandler.hpp"
 
+#include <sstream>
+#include <vector>
+
 namespace cs::gui::detail {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Typed arrays like Float32Array are objects with indexed elements. Their prototype provides the
+// BYTES_PER_ELEMENT constant.
+bool isTypedArray(CefRefPtr<CefV8Value> const& value) {
+  return value->IsObject() && !value->IsArray() && value->HasValue("BYTES_PER_ELEMENT") &&
+         value->HasValue("length");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Copies the elements of a numeric array or typed array. Returns false if one of the elements is
+// not a number.
+bool getNumbers(CefRefPtr<CefV8Value> const& value, std::vector<double>& numbers) {
+  int length = value->IsArray() ? value->GetArrayLength()
+                                : static_cast<int>(value->GetValue("length")->GetUIntValue());
+
+  numbers.resize(length);
+  for (int i = 0; i < length; ++i) {
+    auto element = value->GetValue(i);
+    if (!element->IsDouble()) {
+      return false;
+    }
+    numbers[i] = element->GetDoubleValue();
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool JSHandler::Execute(const CefString& name, CefRefPtr<CefV8Value> /*object*/,
     const CefV8ValueList& arguments, CefRefPtr<CefV8Value>& /*retval*/, CefString& /*exception*/) {
 
-  if (name != "callNative") {
+  if (name != "callNative" && name != "callNativeCoalesced") {
     SendError("Unknown Javascript function name!");
     return false;
   }
 
   if (arguments.empty()) {
-    SendError("window.callNative function requires at least one argument!");
+    SendError("window." + name.ToString() + " function requires at least one argument!");
     return false;
   }
 
+  // The callback is either given by its ID or by its name.
   CefRefPtr<CefProcessMessage> msg = CefProcessMessage::Create(name);
-  msg->GetArgumentList()->SetString(0, arguments[0]->GetStringValue());
+  if (arguments[0]->IsUInt()) {
+    msg->GetArgumentList()->SetInt(0, static_cast<int>(arguments[0]->GetUIntValue()));
+  } else {
+    msg->GetArgumentList()->SetString(0, arguments[0]->GetStringValue());
+  }
 
   bool success(true);
 
@@ -38,10 +83,28 @@ bool JSHandler::Execute(const CefString& name, CefRefPtr<CefV8Value> /*object*/,
       msg->GetArgumentList()->SetString(i, arguments[i]->GetStringValue());
     } else if (arguments[i]->IsNull() || arguments[i]->IsUndefined()) {
       msg->GetArgumentList()->SetNull(i);
+    } else if (arguments[i]->IsArray() || isTypedArray(arguments[i])) {
+      // Arrays are sent as binary values of doubles. As binary values must not be empty, empty
+      // arrays are sent as empty lists.
+      std::vector<double> numbers;
+      if (getNumbers(arguments[i], numbers)) {
+        if (numbers.empty()) {
+          msg->GetArgumentList()->SetList(i, CefListValue::Create());
+        } else {
+          msg->GetArgumentList()->SetBinary(
+              i, CefBinaryValue::Create(numbers.data(), numbers.size() * sizeof(double)));
+        }
+      } else {
+        std::stringstream sstr;
+        sstr << "Failed to handle window.callNative call. Argument " << i
+             << " is an array which contains values other than numbers.";
+        SendError(sstr.str());
+        success = false;
+      }
     } else {
       std::stringstream sstr;
       sstr << "Failed to handle window.callNative call. Argument " << i
-           << " has an unsupported type. Only Double, Bool and String are "
+           << " has an unsupported type. Only Double, Bool, String and arrays of numbers are "
            << "supported.";
       SendError(sstr.str());
       success = false;
@@ -12,8 +12,9 @@
 
 namespace cs::gui::detail {
 
-/// Handles function calls from Javascript. Only functions with the name "callNative" and at
-/// least one argument are accepted.
+/// Handles function calls from Javascript. Only functions with the name "callNative" or
+/// "callNativeCoalesced" and at least one argument are accepted. The first argument is either the
+/// name or the ID of the callback.
 class JSHandler : public CefV8Handler {
 
  public:
@@ -21,8 +22,8 @@ class JSHandler : public CefV8Handler {
       : mBrowser(browser) {
   }
 
-  /// Handles function calls from Javascript. Only functions with the name "callNative" and at
-  /// least one argument are accepted.
+  /// Handles function calls from Javascript. Only functions with the name "callNative" or
+  /// "callNativeCoalesced" and at least one argument are accepted.
   bool Execute(const CefString& name, CefRefPtr<CefV8Value> object, const CefV8ValueList& arguments,
       CefRefPtr<CefV8Value>& retval, CefString& exception) override;
 
@@ -21,9 +21,17 @@ void LoadHandler::WaitForFinishedLoading() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LoadHandler::Reset() {
+  mInitialized = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void LoadHandler::OnLoadingStateChange(
-    CefRefPtr<CefBrowser> /*browser*/, bool isLoading, bool /*canGoBack*/, bool /*canGoForward*/) {
-  if (!isLoading) {
+    CefRefPtr<CefBrowser> browser, bool isLoading, bool /*canGoBack*/, bool /*canGoForward*/) {
+
+  // Pooled browsers show an empty page, this must not be mistaken for the page of the next WebView.
+  if (!isLoading && browser->GetMainFrame()->GetURL().ToString() != "about:blank") {
     mInitialized = true;
   }
 }
@@ -19,6 +19,10 @@ class LoadHandler : public CefLoadHandler {
   /// Lets pauses the execution until the browser has loaded its contents.
   void WaitForFinishedLoading() const;
 
+  /// Makes WaitForFinishedLoading() block until the next page has been loaded. This is used when a
+  /// browser is reused for another page.
+  void Reset();
+
   /// Gets called when the loading state changes. And halts the blocking of execution in
   /// WaitForFinishedLoading().
   void OnLoadingStateChange(
@@ -6,6 +6,8 @@
 // SPDX-License-Identifier: MIT
 
 #include "RenderHandler.hpp"
+#include "../../cs-utils/Metrics.hpp"
+#include "../../cs-utils/Tracing.hpp"
 #include "../logger.hpp"
 
 #include <GL/glew.h>
@@ -29,6 +31,17 @@ void RenderHandler::SetRequestKeyboardFocusCallback(RequestKeyboardFocusCallback
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void RenderHandler::Reset() {
+  mDrawCallback                 = nullptr;
+  mRequestKeyboardFocusCallback = nullptr;
+  mPixelData                    = nullptr;
+  mLastDrawWidth                = 0;
+  mLastDrawHeight               = 0;
+  mSharedTextureSizes.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void RenderHandler::Resize(int width, int height) {
   mWidth  = width;
   mHeight = height;
@@ -80,6 +93,19 @@ void RenderHandler::GetViewRect(CefRefPtr<CefBrowser> /*browser*/, CefRect& rect
 
 void RenderHandler::OnPaint(CefRefPtr<CefBrowser> /*browser*/, PaintElementType /*type*/,
     RectList const& dirtyRects, const void* b, int width, int height) {
+  CS_TRACE_ZONE("RenderHandler::OnPaint");
+  CS_TRACE_PLOT("GUI Dirty Rects", static_cast<int64_t>(dirtyRects.size()));
+
+  // This is called on CEF's UI thread, the rate can be derived from the counter.
+  static auto& paints = cs::utils::Metrics::get().getSample("cosmoscout_gui_paints_total",
+      cs::utils::Metrics::Type::eCounter, "The number of web pages painted by CEF.");
+  paints.add(1.0);
+
+  // Browsers in the pool of the WebView class have no draw callback.
+  if (!mDrawCallback) {
+    return;
+  }
+
   DrawEvent event{};
   event.mResized  = width != mLastDrawWidth || height != mLastDrawHeight;
   mLastDrawWidth  = width;
@@ -92,53 +118,56 @@ void RenderHandler::OnPaint(CefRefPtr<CefBrowser> /*browser*/, PaintElementType
     event.mHeight = height;
   }
 
+  event.mData = static_cast<uint8_t const*>(b);
+
+  if (!event.mResized) {
+    for (auto const& rect : dirtyRects) {
+      event.mDirtyRects.push_back({rect.x, rect.y, rect.width, rect.height});
+    }
+  }
+
+  // The draw callback copies the dirty regions and returns the pixel data for GetColor().
   mPixelData = mDrawCallback(event);
   if (!mPixelData) {
     std::cerr << "[" << __FILE__ << ":" << __LINE__
               << "] Error when initializing GUI Texture Buffer!" << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderHandler::OnAcceleratedPaint(CefRefPtr<CefBrowser> /*browser*/,
+    PaintElementType /*type*/, RectList const& /*dirtyRects*/, void* sharedHandle) {
+
+  if (!mDrawCallback) {
     return;
   }
 
+  auto [width, height] =
+      mSharedTextureSizes.try_emplace(sharedHandle, mWidth, mHeight).first->second;
+
+  DrawEvent event{};
+  event.mResized      = width != mLastDrawWidth || height != mLastDrawHeight;
+  event.mX            = 0;
+  event.mY            = 0;
+  event.mWidth        = width;
+  event.mHeight       = height;
+  event.mSharedHandle = sharedHandle;
+  mLastDrawWidth      = width;
+  mLastDrawHeight     = height;
+
+  // The textures of the previous size will not be used anymore. Their handles may be reused.
   if (event.mResized) {
-    size_t bufferSize = width * height * 4;
-    std::memcpy(mPixelData, b, bufferSize * sizeof(uint8_t));
-  } else {
-    for (auto const& rect : dirtyRects) {
-      if (rect.width > 0.5 * width) {
-        // When the rect is almost the whole screen width we just copy the rest of the width
-        // too. This is faster since we only need one efficient std::memcpy call.
-
-        size_t startOffset = rect.y * width * 4 * sizeof(uint8_t);
-        size_t extend      = rect.height * width * 4 * sizeof(uint8_t);
-
-        // NOLINTNEXTLINE: This is performance critical.
-        std::memcpy(mPixelData + startOffset, (uint8_t*)b + startOffset, extend);
-      } else {
-        // We copy each row of the changed region over individually, since they are not
-        // guaranteed to have continuous memory.
-        //
-        // ################################################################################
-        // ##############################+--------------------------------------+##########
-        // ####################### i = 0 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 1 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 2 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 3 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 4 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 5 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ##############################+--------------------------------------+##########
-        // ################################################################################
-        // ################################################################################
-        for (int i = 0; i < rect.height; ++i) {
-          size_t startOffset = ((rect.y + i) * width + rect.x) * 4 * sizeof(uint8_t);
-          size_t extend      = rect.width * 4 * sizeof(uint8_t);
-
-          // NOLINTNEXTLINE: This is performance critical.
-          std::memcpy(mPixelData + startOffset, (uint8_t*)b + startOffset, extend);
-        }
-      }
-    }
+    mSharedTextureSizes.clear();
+    mSharedTextureSizes.emplace(sharedHandle, std::make_pair(width, height));
   }
-} // namespace cs::gui::detail
+
+  // The texture is copied on the GPU, mPixelData will contain the result once this has finished.
+  mPixelData = mDrawCallback(event);
+  if (!mPixelData) {
+    logger().error("Error when initializing GUI Texture Buffer!");
+  }
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
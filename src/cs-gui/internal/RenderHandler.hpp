@@ -12,6 +12,7 @@
 
 #include <include/cef_client.h>
 #include <include/cef_render_handler.h>
+#include <unordered_map>
 
 namespace cs::gui::detail {
 
@@ -26,6 +27,10 @@ class RenderHandler : public CefRenderHandler {
   /// The given callback is fired when the active gui element wants to receive keyboard events.
   void SetRequestKeyboardFocusCallback(RequestKeyboardFocusCallback const& callback);
 
+  /// Removes both callbacks and forgets the pixel data, as it belongs to the draw callback. The
+  /// next paint will be reported as a resize, so that the whole page is copied.
+  void Reset();
+
   void Resize(int width, int height);
   bool GetColor(int x, int y, uint8_t& r, uint8_t& g, uint8_t& b, uint8_t& a) const;
 
@@ -39,6 +44,11 @@ class RenderHandler : public CefRenderHandler {
   void OnPaint(CefRefPtr<CefBrowser> browser, PaintElementType type, const RectList& dirtyRects,
       const void* buffer, int width, int height) override;
 
+  /// This is called instead of OnPaint() if accelerated painting is enabled. The draw callback
+  /// receives the shared texture handle and is responsible for copying the texture.
+  void OnAcceleratedPaint(CefRefPtr<CefBrowser> browser, PaintElementType type,
+      const RectList& dirtyRects, void* sharedHandle) override;
+
   void OnVirtualKeyboardRequested(CefRefPtr<CefBrowser> browser, TextInputMode input_mode) override;
 
  private:
@@ -54,6 +64,10 @@ class RenderHandler : public CefRenderHandler {
   RequestKeyboardFocusCallback mRequestKeyboardFocusCallback;
 
   uint8_t* mPixelData = nullptr;
+
+  /// CEF does not report the size of shared textures. Each texture has the size of the view at the
+  /// time it was painted first.
+  std::unordered_map<void*, std::pair<int, int>> mSharedTextureSizes;
 };
 
 } // namespace cs::gui::detail
@@ -9,16 +9,97 @@
 
 #include "JSHandler.hpp"
 
+#include <cstdlib>
+
 namespace cs::gui::detail {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// The memory of the ArrayBuffers created in OnProcessMessageReceived() is allocated with malloc()
+// and freed once V8 garbage-collects the buffer.
+class ArrayBufferReleaseCallback : public CefV8ArrayBufferReleaseCallback {
+ public:
+  void ReleaseBuffer(void* buffer) override {
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    std::free(buffer);
+  }
+
+ private:
+  IMPLEMENT_REFCOUNTING(ArrayBufferReleaseCallback);
+};
+
+void sendError(CefRefPtr<CefFrame> const& frame, std::string const& message) {
+  CefRefPtr<CefProcessMessage> msg = CefProcessMessage::Create("error");
+  msg->GetArgumentList()->SetString(0, message);
+  frame->SendProcessMessage(PID_BROWSER, msg);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void RenderProcessHandler::OnContextCreated(
     CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> /*frame*/, CefRefPtr<CefV8Context> context) {
 
-  CefRefPtr<CefV8Value> object = context->GetGlobal();
-  CefRefPtr<CefV8Value> func   = CefV8Value::CreateFunction("callNative", new JSHandler(browser));
+  CefRefPtr<CefV8Value>   object  = context->GetGlobal();
+  CefRefPtr<CefV8Handler> handler = new JSHandler(browser);
+
+  CefRefPtr<CefV8Value> func = CefV8Value::CreateFunction("callNative", handler);
   object->SetValue("callNative", func, V8_PROPERTY_ATTRIBUTE_NONE);
+
+  // Like callNative(), but only the most recent call of each callback per frame is executed.
+  func = CefV8Value::CreateFunction("callNativeCoalesced", handler);
+  object->SetValue("callNativeCoalesced", func, V8_PROPERTY_ATTRIBUTE_NONE);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool RenderProcessHandler::OnProcessMessageReceived(CefRefPtr<CefBrowser> /*browser*/,
+    CefRefPtr<CefFrame> frame, CefProcessId /*source_process*/,
+    CefRefPtr<CefProcessMessage> message) {
+
+  if (message->GetName() != "callJavascriptWithArray") {
+    return false;
+  }
+
+  std::string function = message->GetArgumentList()->GetString(0).ToString();
+  auto        binary   = message->GetArgumentList()->GetBinary(1);
+  auto        context  = frame->GetV8Context();
+
+  if (!context || !context->Enter()) {
+    return true;
+  }
+
+  // JavaScript functions cannot be called as constructors from here, so the Float32Array view is
+  // created by a small wrapper function. Evaluating the function name also resolves member
+  // functions like "CosmoScout.timings.setData".
+  CefRefPtr<CefV8Value>     wrapper;
+  CefRefPtr<CefV8Exception> exception;
+
+  if (context->Eval("(buffer) => " + function + "(new Float32Array(buffer))", "", 0, wrapper,
+          exception)) {
+    std::size_t bytes = binary->GetSize();
+
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    void* data = std::malloc(bytes);
+    binary->GetData(data, bytes, 0);
+
+    auto buffer = CefV8Value::CreateArrayBuffer(data, bytes, new ArrayBufferReleaseCallback());
+    wrapper->ExecuteFunction(nullptr, {buffer});
+
+    if (wrapper->HasException()) {
+      sendError(frame, "Failed to call '" + function +
+                           "': " + wrapper->GetException()->GetMessage().ToString());
+    }
+  } else {
+    sendError(frame, "Failed to call '" + function + "': " + exception->GetMessage().ToString());
+  }
+
+  context->Exit();
+
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -12,14 +12,20 @@
 
 namespace cs::gui::detail {
 
-/// Used to add the callNative method to the JS window object.
+/// Used to add the callNative method to the JS window object. It also receives the calls of
+/// WebView::callJavascriptWithArray().
 class RenderProcessHandler : public CefRenderProcessHandler {
  public:
   /// This is called for each new context. We use this callback to add the
-  /// callNative method to the window object.
+  /// callNative and callNativeCoalesced methods to the window object.
   void OnContextCreated(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame,
       CefRefPtr<CefV8Context> context) override;
 
+  /// Handles the "callJavascriptWithArray" messages sent by the browser process. The binary data
+  /// is wrapped in an ArrayBuffer and passed to the given function as a Float32Array.
+  bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame,
+      CefProcessId source_process, CefRefPtr<CefProcessMessage> message) override;
+
  private:
   IMPLEMENT_REFCOUNTING(RenderProcessHandler);
 };
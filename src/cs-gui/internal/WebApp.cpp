@@ -7,6 +7,8 @@
 
 #include "WebApp.hpp"
 
+#include <string>
+
 namespace cs::gui::detail {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -29,6 +31,18 @@ CefMainArgs const& WebApp::GetArgs() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WebApp::SetHardwareAccelerated(bool hardware_accelerated) {
+  mHardwareAccelerated = hardware_accelerated;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebApp::SetRendererProcessLimit(uint32_t limit) {
+  mRendererProcessLimit = limit;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void WebApp::OnBeforeCommandLineProcessing(
     const CefString& process_type, CefRefPtr<CefCommandLine> command_line) {
 
@@ -36,10 +50,28 @@ void WebApp::OnBeforeCommandLineProcessing(
     command_line->AppendSwitch("enable-overlay-scrollbar");
     command_line->AppendSwitch("enable-begin-frame-scheduling");
 
+    // None of these features are used by the user interface. Each of them would add memory usage
+    // to the browser or the renderer processes.
+    command_line->AppendSwitch("disable-extensions");
+    command_line->AppendSwitch("disable-pdf-extension");
+    command_line->AppendSwitch("disable-spell-checking");
+    command_line->AppendSwitch("disable-background-networking");
+    command_line->AppendSwitch("disable-component-update");
+
     if (!mHardwareAccelerated) {
       command_line->AppendSwitch("disable-gpu");
       command_line->AppendSwitch("disable-gpu-compositing");
     }
+
+    // Pages of the same site always share one process. With site isolation, pages of different
+    // sites would still get separate processes regardless of the limit.
+    command_line->AppendSwitch("process-per-site");
+
+    if (mRendererProcessLimit > 0) {
+      command_line->AppendSwitch("disable-site-isolation-trials");
+      command_line->AppendSwitchWithValue(
+          "renderer-process-limit", std::to_string(mRendererProcessLimit));
+    }
   }
 }
 
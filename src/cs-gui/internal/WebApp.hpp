@@ -12,6 +12,8 @@
 
 #include <include/cef_app.h>
 
+#include <cstdint>
+
 namespace cs::gui::detail {
 
 /// Implements the CefApp interface.
@@ -24,6 +26,14 @@ class WebApp : public CefApp {
 
   CefMainArgs const& GetArgs();
 
+  /// This can be used to change the value given to the constructor. It has to be called before
+  /// CefInitialize().
+  void SetHardwareAccelerated(bool hardware_accelerated);
+
+  /// If set to a value larger than zero, all browsers share at most this many renderer processes.
+  /// It has to be called before CefInitialize().
+  void SetRendererProcessLimit(uint32_t limit);
+
   /// Returns this.
   CefRefPtr<CefRenderProcessHandler> GetRenderProcessHandler() override {
     return mRenderProcessHandler;
@@ -41,6 +51,7 @@ class WebApp : public CefApp {
 
   CefMainArgs mArgs;
   bool        mHardwareAccelerated;
+  uint32_t    mRendererProcessLimit = 0;
 };
 
 } // namespace cs::gui::detail
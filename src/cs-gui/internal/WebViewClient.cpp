@@ -10,21 +10,38 @@
 #include "../logger.hpp"
 
 #include <fstream>
+#include <unordered_set>
 #include <utility>
 
 namespace cs::gui::detail {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// All WebViewClients which have coalesced calls which have not been executed yet.
+std::unordered_set<WebViewClient*> clientsWithCoalescedCalls;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 WebViewClient::~WebViewClient() {
-  try {
-    if (!mJSCallbacks.empty()) {
-      logger().warn(
-          "While destructing a WebViewClient there were still JavaScript callbacks registered:");
+  clientsWithCoalescedCalls.erase(this);
 
-      for (auto&& i : mJSCallbacks) {
-        logger().warn(" - {}", i.first);
-        i.second = [](auto /*unused*/) {};
+  try {
+    bool warned = false;
+
+    for (auto& callback : mJSCallbacks) {
+      if (callback.mFunction) {
+        if (!warned) {
+          logger().warn("While destructing a WebViewClient there were still JavaScript callbacks "
+                        "registered:");
+          warned = true;
+        }
+
+        logger().warn(" - {}", callback.mName);
+        callback.mFunction = [](auto /*unused*/) {};
       }
     }
   } catch (...) {}
@@ -36,30 +53,66 @@ bool WebViewClient::OnProcessMessageReceived(CefRefPtr<CefBrowser> /*browser*/,
     CefRefPtr<CefFrame> /*frame*/, CefProcessId /*source_process*/,
     CefRefPtr<CefProcessMessage> message) {
 
-  if (message->GetName() == "callNative") {
+  bool coalesce = message->GetName() == "callNativeCoalesced";
+
+  if (coalesce || message->GetName() == "callNative") {
+    auto arguments = message->GetArgumentList();
 
-    std::string name(message->GetArgumentList()->GetString(0).ToString());
-    auto        callback(mJSCallbacks.find(name));
+    // Callbacks can be called by their ID or by their name.
+    std::optional<uint32_t> id;
+    std::string             name;
 
-    if (callback == mJSCallbacks.end()) {
+    if (arguments->GetType(0) == VTYPE_INT) {
+      auto index = static_cast<uint32_t>(arguments->GetInt(0));
+      if (index < mJSCallbacks.size()) {
+        id   = index;
+        name = mJSCallbacks[index].mName;
+      } else {
+        name = std::to_string(index);
+      }
+    } else {
+      name    = arguments->GetString(0).ToString();
+      auto it = mJSCallbackIDs.find(name);
+      if (it != mJSCallbackIDs.end()) {
+        id = it->second;
+      }
+    }
+
+    if (!id || !mJSCallbacks[*id].mFunction) {
       logger().warn(
           "Cannot call function '{}': No callback is registered for this function name!", name);
       return true;
     }
 
     std::vector<std::optional<JSType>> args;
+    args.reserve(arguments->GetSize() - 1);
 
-    for (size_t i(1); i < message->GetArgumentList()->GetSize(); ++i) {
-      CefValueType type(message->GetArgumentList()->GetType(i));
+    for (size_t i(1); i < arguments->GetSize(); ++i) {
+      CefValueType type(arguments->GetType(i));
       switch (type) {
       case VTYPE_DOUBLE:
-        args.emplace_back(message->GetArgumentList()->GetDouble(i));
+        args.emplace_back(arguments->GetDouble(i));
+        break;
+      case VTYPE_INT:
+        args.emplace_back(static_cast<double>(arguments->GetInt(i)));
         break;
       case VTYPE_BOOL:
-        args.emplace_back(message->GetArgumentList()->GetBool(i));
+        args.emplace_back(arguments->GetBool(i));
         break;
       case VTYPE_STRING:
-        args.emplace_back(message->GetArgumentList()->GetString(i).ToString());
+        args.emplace_back(arguments->GetString(i).ToString());
+        break;
+      case VTYPE_BINARY: {
+        // Arrays of numbers are sent as binary values of doubles, see JSHandler::Execute().
+        auto                binary = arguments->GetBinary(i);
+        std::vector<double> numbers(binary->GetSize() / sizeof(double));
+        binary->GetData(numbers.data(), numbers.size() * sizeof(double), 0);
+        args.emplace_back(std::move(numbers));
+        break;
+      }
+      case VTYPE_LIST:
+        // Empty arrays are sent as empty lists.
+        args.emplace_back(std::vector<double>());
         break;
       case VTYPE_INVALID:
       case VTYPE_NULL:
@@ -71,7 +124,18 @@ bool WebViewClient::OnProcessMessageReceived(CefRefPtr<CefBrowser> /*browser*/,
       }
     }
 
-    callback->second(std::move(args));
+    auto& callback = mJSCallbacks[*id];
+
+    if (coalesce) {
+      if (!callback.mCoalescedArgs) {
+        mCoalescedCalls.push_back(*id);
+        clientsWithCoalescedCalls.insert(this);
+      }
+      callback.mCoalescedArgs = std::move(args);
+    } else {
+      FlushCoalescedCalls();
+      callback.mFunction(std::move(args));
+    }
 
     return true;
   }
@@ -85,15 +149,73 @@ bool WebViewClient::OnProcessMessageReceived(CefRefPtr<CefBrowser> /*browser*/,
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WebViewClient::RegisterJSCallback(
+uint32_t WebViewClient::RegisterJSCallback(
     std::string const& name, std::function<void(std::vector<std::optional<JSType>>&&)> callback) {
-  mJSCallbacks[name] = std::move(callback);
+  auto [it, isNew] =
+      mJSCallbackIDs.try_emplace(name, static_cast<uint32_t>(mJSCallbacks.size()));
+
+  if (isNew) {
+    mJSCallbacks.push_back({name, nullptr, std::nullopt});
+  }
+
+  mJSCallbacks[it->second].mFunction = std::move(callback);
+
+  return it->second;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void WebViewClient::UnregisterJSCallback(std::string const& name) {
-  mJSCallbacks.erase(name);
+  auto it = mJSCallbackIDs.find(name);
+  if (it != mJSCallbackIDs.end()) {
+    mJSCallbacks[it->second].mFunction = nullptr;
+    mJSCallbacks[it->second].mCoalescedArgs.reset();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebViewClient::Reset() {
+  clientsWithCoalescedCalls.erase(this);
+  mCoalescedCalls.clear();
+
+  for (auto& callback : mJSCallbacks) {
+    callback.mFunction = nullptr;
+    callback.mCoalescedArgs.reset();
+  }
+
+  mRenderHandler->Reset();
+  mDisplayHandler->SetCursorChangeCallback(nullptr);
+  mLoadHandler->Reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebViewClient::FlushAllCoalescedCalls() {
+  // FlushCoalescedCalls() removes the client from the set, so we iterate over a copy.
+  auto clients = clientsWithCoalescedCalls;
+  for (auto* client : clients) {
+    client->FlushCoalescedCalls();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebViewClient::FlushCoalescedCalls() {
+  clientsWithCoalescedCalls.erase(this);
+
+  // The callbacks may register or call other callbacks, so the list is swapped out first.
+  std::vector<uint32_t> ids;
+  std::swap(ids, mCoalescedCalls);
+
+  for (uint32_t id : ids) {
+    auto args = std::move(mJSCallbacks[id].mCoalescedArgs);
+    mJSCallbacks[id].mCoalescedArgs.reset();
+
+    if (args && mJSCallbacks[id].mFunction) {
+      mJSCallbacks[id].mFunction(std::move(*args));
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -21,8 +21,10 @@
 #include <include/cef_render_handler.h>
 #include <include/cef_v8.h>
 #include <include/wrapper/cef_stream_resource_handler.h>
+#include <deque>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace cs::gui::detail {
 
@@ -40,13 +42,26 @@ class WebViewClient : public CefClient {
   WebViewClient& operator=(WebViewClient&& other) = delete;
 
   /// Registers callback functions for Javascript. Registering the same name twice will override the
-  /// first callback.
-  void RegisterJSCallback(
+  /// first callback. The returned ID can be passed to window.callNative() instead of the name, this
+  /// avoids looking up the name for each call. The ID of a name never changes, even if it is
+  /// unregistered and registered again.
+  uint32_t RegisterJSCallback(
       std::string const& name, std::function<void(std::vector<std::optional<JSType>>&&)> callback);
 
   /// Unregisters a JavaScript callback.
   void UnregisterJSCallback(std::string const& name);
 
+  /// Unregisters all JavaScript callbacks, discards all pending coalesced calls and removes the
+  /// callbacks of the handlers. This is used when the browser is put into the pool of the WebView
+  /// class. The IDs of the callback names are kept.
+  void Reset();
+
+  /// Calls made with window.callNativeCoalesced() are not executed right away. Instead, only the
+  /// most recent call of each callback is executed when this is called. Any non-coalesced call
+  /// executes all pending coalesced calls of its WebViewClient first, so the order of execution is
+  /// kept. This is called by cs::gui::update() once a frame.
+  static void FlushAllCoalescedCalls();
+
   /// Returns the concrete implementation of the LifeSpanHandler.
   CefRefPtr<LifeSpanHandler> GetInternalLifeSpanHandler() {
     return mLifeSpanHandler;
@@ -103,8 +118,23 @@ class WebViewClient : public CefClient {
   CefRefPtr<LoadHandler>     mLoadHandler     = new LoadHandler();
   CefRefPtr<RequestHandler>  mRequestHandler  = new RequestHandler();
 
-  std::unordered_map<std::string, std::function<void(std::vector<std::optional<JSType>>&&)>>
-      mJSCallbacks;
+  struct JSCallback {
+    std::string                                               mName;
+    std::function<void(std::vector<std::optional<JSType>>&&)> mFunction;
+
+    // The arguments of the most recent coalesced call which has not been executed yet.
+    std::optional<std::vector<std::optional<JSType>>> mCoalescedArgs;
+  };
+
+  void FlushCoalescedCalls();
+
+  // The callbacks are indexed by their ID. Unregistered callbacks keep their slot with an empty
+  // function. A deque is used as callbacks may register further callbacks while being executed.
+  std::deque<JSCallback>                    mJSCallbacks;
+  std::unordered_map<std::string, uint32_t> mJSCallbackIDs;
+
+  // The IDs of all callbacks with coalesced calls in the order of their first call.
+  std::vector<uint32_t> mCoalescedCalls;
 };
 
 } // namespace cs::gui::detail
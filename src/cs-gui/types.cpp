@@ -7,12 +7,32 @@
 
 #include "types.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 namespace cs::gui {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Rect getBoundingBox(Rect const& a, Rect const& b) {
+  if (a.mWidth <= 0 || a.mHeight <= 0) {
+    return b;
+  }
+
+  if (b.mWidth <= 0 || b.mHeight <= 0) {
+    return a;
+  }
+
+  int x0 = std::min(a.mX, b.mX);
+  int y0 = std::min(a.mY, b.mY);
+  int x1 = std::max(a.mX + a.mWidth, b.mX + b.mWidth);
+  int y1 = std::max(a.mY + a.mHeight, b.mY + b.mHeight);
+
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::ostream& operator<<(std::ostream& os, Key key) {
   switch (key) {
   case Key::eUnknown:
@@ -18,6 +18,17 @@
 
 namespace cs::gui {
 
+/// A rectangular region of a web page in pixels.
+struct CS_GUI_EXPORT Rect {
+  int mX;
+  int mY;
+  int mWidth;
+  int mHeight;
+};
+
+/// Returns the smallest Rect containing both given Rects. Rects with zero area are ignored.
+CS_GUI_EXPORT Rect getBoundingBox(Rect const& a, Rect const& b);
+
 /// Data describing the new state of a part of the GUI, when it changed.
 struct CS_GUI_EXPORT DrawEvent {
   int            mX;       ///< The x coordinate of the redrawn area.
@@ -25,12 +36,21 @@ struct CS_GUI_EXPORT DrawEvent {
   int            mWidth;   ///< The width of the redrawn area.
   int            mHeight;  ///< The height of the redrawn area.
   bool           mResized; ///< If the event was triggered by a resize.
-  const uint8_t* mData;    ///< The new pixel data of the redrawn area.
+  const uint8_t* mData;    ///< The pixel data of the entire page.
+
+  /// The regions of mData which have changed. If mResized is set, the entire page has changed.
+  std::vector<Rect> mDirtyRects;
+
+  /// If accelerated painting is enabled, this is the handle of the shared D3D11 texture which
+  /// contains the entire page. Else it is nullptr.
+  void* mSharedHandle;
 };
 
 using DrawCallback = std::function<uint8_t*(const DrawEvent&)>;
 
-using JSType = std::variant<double, bool, std::string>;
+/// The types of the arguments which can be passed from JavaScript to C++ callbacks. Arrays of
+/// numbers and typed arrays like Float32Array are received as std::vector<double>.
+using JSType = std::variant<double, bool, std::string, std::vector<double>>;
 
 /// The visual appearance of the cursor.
 enum class CS_GUI_EXPORT Cursor : int {
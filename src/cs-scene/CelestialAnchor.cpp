@@ -7,12 +7,11 @@
 
 #include "CelestialAnchor.hpp"
 
+#include "EphemerisCache.hpp"
+
 #include <VistaKernel/GraphicsManager/VistaNodeBridge.h>
 
-#include <array>
-#include <cspice/SpiceUsr.h>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/component_wise.hpp>
 #include <optional>
 #include <unordered_map>
@@ -93,19 +92,13 @@ void CelestialAnchor::setScale(double dScale) {
 
 glm::dvec3 CelestialAnchor::getRelativePosition(double tTime, CelestialAnchor const& other) const {
   glm::dvec3 vOtherPos = other.getPosition() / 1000.0;
+  glm::dvec3 otherPos(vOtherPos[2], vOtherPos[0], vOtherPos[1]);
 
-  std::array<double, 6> relPos{};
-  double                timeOfLight{};
-  std::array            otherPos{vOtherPos[2], vOtherPos[0], vOtherPos[1]};
-  spkcpt_c(otherPos.data(), other.getCenterName().c_str(), other.getFrameName().c_str(), tTime,
-      mFrameName.c_str(), "OBSERVER", "NONE", mCenterName.c_str(), relPos.data(), &timeOfLight);
-
-  if (failed_c()) {
-    std::array<SpiceChar, 320> msg{};
-    getmsg_c("LONG", 320, msg.data());
-    reset_c();
-    throw std::runtime_error(msg.data());
-  }
+  // Without aberration correction, the position of other is the position of its center plus its
+  // offset rotated into our frame. Both are cached, as they are shared by many anchors.
+  glm::dvec3 relPos =
+      EphemerisCache::getPosition(other.getCenterName(), mCenterName, mFrameName, tTime) +
+      EphemerisCache::getRotation(other.getFrameName(), mFrameName, tTime) * otherPos;
 
   auto vRelPos = glm::dvec3(relPos[1], relPos[2], relPos[0]) * 1000.0;
 
@@ -116,26 +109,11 @@ glm::dvec3 CelestialAnchor::getRelativePosition(double tTime, CelestialAnchor co
 
 glm::dquat CelestialAnchor::getRelativeRotation(double tTime, CelestialAnchor const& other) const {
 
-  // get rotation from self to other
-  std::array<double[3], 3> rotMat{}; // NOLINT(modernize-avoid-c-arrays)
-  pxform_c(other.getFrameName().c_str(), mFrameName.c_str(), tTime, rotMat.data());
-
-  if (failed_c()) {
-    std::array<SpiceChar, 320> msg{};
-    getmsg_c("LONG", 320, msg.data());
-    reset_c();
-    throw std::runtime_error(msg.data());
-  }
+  // The rotation between the two frames is shared by all anchors in these frames, so it is cached.
+  glm::dquat rotation =
+      EphemerisCache::getRotationQuaternion(other.getFrameName(), mFrameName, tTime);
 
-  // convert to quaternion
-  std::array<double, 3> axis{};
-  double                angle{};
-
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay, modernize-avoid-c-arrays)
-  raxisa_c(rotMat.data(), axis.data(), &angle);
-
-  return glm::inverse(mRotation) * glm::angleAxis(angle, glm::dvec3(axis[1], axis[2], axis[0])) *
-         other.mRotation;
+  return glm::inverse(mRotation) * rotation * other.mRotation;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -151,13 +129,10 @@ glm::dmat4 CelestialAnchor::getRelativeTransform(double tTime, CelestialAnchor c
   glm::dvec3 pos   = getRelativePosition(tTime, other);
   glm::dquat rot   = getRelativeRotation(tTime, other);
 
-  double     angle = glm::angle(rot);
-  glm::dvec3 axis  = glm::axis(rot);
-
-  glm::dmat4 mat(1.0);
-  mat = glm::translate(mat, pos);
-  mat = glm::rotate(mat, angle, axis);
-  mat = glm::scale(mat, glm::dvec3(scale, scale, scale));
+  // This is the same as translating, rotating and scaling an identity matrix, but it does not need
+  // to convert the quaternion to an angle and an axis first.
+  glm::dmat4 mat(glm::mat3_cast(rot) * scale);
+  mat[3] = glm::dvec4(pos, 1.0);
 
   return mat;
 }
@@ -8,6 +8,7 @@
 #include "CelestialObject.hpp"
 
 #include "../cs-utils/convert.hpp"
+#include "../cs-utils/utils.hpp"
 #include "CelestialObserver.hpp"
 #include "logger.hpp"
 
@@ -18,6 +19,27 @@ namespace cs::scene {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// objects whose body and orbit are culled are updated only once in this many frames
+uint32_t const culledUpdateInterval = 8;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool isSameAnchor(CelestialAnchor const& a, CelestialAnchor const& b) {
+  return a.getPosition() == b.getPosition() && a.getRotation() == b.getRotation() &&
+         a.getScale() == b.getScale() && a.getCenterName() == b.getCenterName() &&
+         a.getFrameName() == b.getFrameName();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 CelestialObject::CelestialObject(std::string sCenterName, std::string sFrameName)
     : CelestialAnchor(std::move(sCenterName), std::move(sFrameName)) {
 }
@@ -61,6 +83,8 @@ glm::dvec3 const& CelestialObject::getRadii() const {
 
   // If no radii were given to the object, we try once to get them from SPICE.
   if (mRadii == glm::dvec3(0.0) && mRadiiFromSPICE == glm::dvec3(-1.0)) {
+    std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
     // get target id code
     SpiceInt     id{};
     SpiceBoolean found{};
@@ -163,8 +187,27 @@ void CelestialObject::setCenterName(std::string sCenterName) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void CelestialObject::update(double tTime, cs::scene::CelestialObserver const& oObs) const {
-  auto existence = getExistence();
-  mIsInExistence = (tTime > existence[0] && tTime < existence[1]);
+  auto existence     = getExistence();
+  bool isInExistence = (tTime > existence[0] && tTime < existence[1]);
+
+  if (mLastUpdateInputs && isInExistence == mIsInExistence) {
+    auto const& last = mLastUpdateInputs.value();
+
+    // Nothing has changed since the last update.
+    if (last.mTime == tTime && last.mBodyCullingRadius == mBodyCullingRadius &&
+        last.mOrbitCullingRadius == mOrbitCullingRadius && isSameAnchor(last.mObserver, oObs) &&
+        isSameAnchor(last.mObject, *this)) {
+      return;
+    }
+
+    // Objects which are too small to be seen are updated less frequently.
+    if (!mIsBodyVisible && !mIsOrbitVisible && ++mSkippedUpdates < culledUpdateInterval) {
+      return;
+    }
+  }
+
+  mSkippedUpdates = 0;
+  mIsInExistence  = isInExistence;
 
   if (getIsInExistence()) {
     try {
@@ -191,6 +234,9 @@ void CelestialObject::update(double tTime, cs::scene::CelestialObserver const& o
       mIsOrbitVisible = mOrbitCullingRadius * size / dist > 0.002;
     }
   }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-slicing)
+  mLastUpdateInputs = UpdateInputs{tTime, oObs, *this, mBodyCullingRadius, mOrbitCullingRadius};
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -208,13 +254,37 @@ bool CelestialObject::getHasValidPosition() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool CelestialObject::getIsBodyVisible() const {
-  return mIsBodyVisible && mIsInExistence && mHasValidPosition;
+  return mIsBodyVisible && mIsInExistence && mHasValidPosition && !mIsBodyOccluded;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool CelestialObject::getIsOrbitVisible() const {
-  return mIsOrbitVisible && mIsInExistence && mHasValidPosition;
+  return mIsOrbitVisible && mIsInExistence && mHasValidPosition && !mIsOrbitOccluded;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CelestialObject::getIsBodyOccluded() const {
+  return mIsBodyOccluded;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CelestialObject::setIsBodyOccluded(bool value) const {
+  mIsBodyOccluded = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CelestialObject::getIsOrbitOccluded() const {
+  return mIsOrbitOccluded;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CelestialObject::setIsOrbitOccluded(bool value) const {
+  mIsOrbitOccluded = value;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
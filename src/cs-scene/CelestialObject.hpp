@@ -11,6 +11,7 @@
 #include "CelestialAnchor.hpp"
 
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <optional>
 
@@ -94,6 +95,9 @@ class CS_SCENE_EXPORT CelestialObject : public CelestialAnchor {
   /// with the SolarSystem. This will update all time- and observer-dependent members. These are the
   /// observer-centric transformation, the result of getIsInExistence(), getIsBodyVisible(), and
   /// getIsOrbitVisible().
+  /// Nothing is recomputed if neither the time, nor the observer, nor this object have changed
+  /// since the last call. Objects whose body and orbit are both culled are only updated every few
+  /// calls.
   void update(double tTime, CelestialObserver const& oObs) const;
 
   /// @return true, if the current time is in between the start and end existence values.
@@ -105,14 +109,26 @@ class CS_SCENE_EXPORT CelestialObject : public CelestialAnchor {
 
   /// @return true, if the current distance to the observer suggests that the body could be visible
   /// (this is based on mBodyCullingRadius and updated during update()). This will also return false
-  /// if either getIsInExistence() or getHasValidPosition() returns false.
+  /// if either getIsInExistence() or getHasValidPosition() returns false or if the body is hidden
+  /// behind another body.
   bool getIsBodyVisible() const;
 
   /// @return true, if the current distance to the observer suggests that the bodies trajectory
   /// could be visible (this is based on mOrbitCullingRadius and updated during update()). This will
-  /// also return false if either getIsInExistence() or getHasValidPosition() returns false.
+  /// also return false if either getIsInExistence() or getHasValidPosition() returns false or if
+  /// the whole trajectory is hidden behind another body.
   bool getIsOrbitVisible() const;
 
+  /// These are set once a frame by the SolarSystem after all objects have been updated. The body is
+  /// occluded if a sphere with the body culling radius around it is completely hidden behind
+  /// another body. For the trajectory, a sphere with twice the orbit culling radius is used, as
+  /// this contains the entire orbit around the parent body. Occluded bodies and trajectories are
+  /// reported as invisible by getIsBodyVisible() and getIsOrbitVisible().
+  bool getIsBodyOccluded() const;
+  void setIsBodyOccluded(bool value) const;
+  bool getIsOrbitOccluded() const;
+  void setIsOrbitOccluded(bool value) const;
+
   /// Returns the current relative transformation to the observer. This is the matrix which
   /// transforms objects from the observer's coordinate system to the CelestialObject's coordinate
   /// system. This usually changes during a call to update().
@@ -179,6 +195,20 @@ class CS_SCENE_EXPORT CelestialObject : public CelestialAnchor {
   mutable bool       mIsBodyVisible               = false;
   mutable bool       mIsOrbitVisible              = false;
   mutable bool       mHasValidPosition            = false;
+  mutable bool       mIsBodyOccluded              = false;
+  mutable bool       mIsOrbitOccluded             = false;
+
+  // The inputs of the last call to update(). If they did not change, update() does nothing.
+  struct UpdateInputs {
+    double          mTime;
+    CelestialAnchor mObserver;
+    CelestialAnchor mObject;
+    double          mBodyCullingRadius;
+    double          mOrbitCullingRadius;
+  };
+
+  mutable std::optional<UpdateInputs> mLastUpdateInputs;
+  mutable uint32_t                    mSkippedUpdates = 0;
 };
 
 } // namespace cs::scene
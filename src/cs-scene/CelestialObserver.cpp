@@ -9,6 +9,8 @@
 
 #include "logger.hpp"
 
+#include <algorithm>
+
 namespace cs::scene {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27,6 +29,9 @@ void CelestialObserver::updateMovementAnimation(double tTime) {
     if (mAnimatedPosition.mEndTime < tTime) {
       mAnimationInProgress = false;
     }
+  } else if (tTime - mVelocityTime > 1.0) {
+    // Navigations which stopped moving the observer without resetting the velocity are ignored.
+    mVelocity = glm::dvec3(0.0);
   }
 }
 
@@ -51,6 +56,7 @@ void CelestialObserver::changeOrigin(
     std::string sCenterName, std::string sFrameName, double dSimulationTime) {
 
   mAnimationInProgress = false;
+  mVelocity            = glm::dvec3(0.0);
 
   cs::scene::CelestialAnchor target(sCenterName, sFrameName);
 
@@ -70,6 +76,7 @@ void CelestialObserver::moveTo(std::string const& sCenterName, std::string const
     glm::dvec3 const& position, glm::dquat const& rotation, double dSimulationTime,
     double dRealStartTime, double dRealEndTime) {
   mAnimationInProgress = false;
+  mVelocity            = glm::dvec3(0.0);
 
   // Perform no animation at all if end time is not greater than start time.
   if (dRealStartTime >= dRealEndTime) {
@@ -121,4 +128,39 @@ bool CelestialObserver::isAnimationInProgress() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+glm::dvec3 CelestialObserver::getAnimatedPosition(double dRealTime) const {
+  if (mAnimationInProgress) {
+    return mAnimatedPosition.get(dRealTime);
+  }
+
+  return mPosition + getVelocity(dRealTime) * std::max(dRealTime - mVelocityTime, 0.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dquat CelestialObserver::getAnimatedRotation(double dRealTime) const {
+  return mAnimationInProgress ? mAnimatedRotation.get(dRealTime) : mRotation;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CelestialObserver::setVelocity(glm::dvec3 const& velocity, double dRealTime) {
+  if (!mAnimationInProgress) {
+    mVelocity     = velocity;
+    mVelocityTime = dRealTime;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 CelestialObserver::getVelocity(double dRealTime) const {
+  if (mAnimationInProgress) {
+    return mAnimatedPosition.getDerivative(dRealTime);
+  }
+
+  return mVelocity;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::scene
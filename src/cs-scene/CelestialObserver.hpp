@@ -51,11 +51,32 @@ class CS_SCENE_EXPORT CelestialObserver : public CelestialAnchor {
   /// @return true, if the observer is currently being moved.
   bool isAnimationInProgress() const;
 
+  /// Returns the position and rotation the observer will have at the given time in the real world
+  /// (in TDB) if the current animation continues. If no animation is in progress, the current
+  /// velocity is extrapolated and the current rotation is returned.
+  glm::dvec3 getAnimatedPosition(double dRealTime) const;
+  glm::dquat getAnimatedRotation(double dRealTime) const;
+
+  /// The velocity of the observer in its current frame in meters per second. This is set by the
+  /// navigation which moves the observer, so that others can predict where the observer will be in
+  /// the near future, for example for prefetching data. The real world time (in TDB) at which the
+  /// velocity was computed has to be given as well. A velocity which has not been updated for more
+  /// than a second is considered to be zero. It is reset whenever the origin changes or an
+  /// animation is started and it is ignored during animations.
+  void setVelocity(glm::dvec3 const& velocity, double dRealTime);
+
+  /// Returns the velocity at the given time in the real world (in TDB). During animations, this is
+  /// the slope of the animation, else the velocity given to setVelocity() is returned.
+  glm::dvec3 getVelocity(double dRealTime) const;
+
  protected:
   utils::AnimatedValue<glm::dvec3> mAnimatedPosition;
   utils::AnimatedValue<glm::dquat> mAnimatedRotation;
 
   bool mAnimationInProgress = false;
+
+  glm::dvec3 mVelocity{0.0};
+  double     mVelocityTime = 0.0;
 };
 } // namespace cs::scene
 
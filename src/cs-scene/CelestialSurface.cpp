@@ -7,10 +7,40 @@
 
 #include "CelestialSurface.hpp"
 
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
 namespace cs::scene {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void CelestialSurface::getHeights(
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const {
+  heights.resize(lngLats.size());
+
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    heights[i] = getHeight(lngLats[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<CelestialSurface::HeightQuery const> CelestialSurface::requestHeights(
+    std::vector<glm::dvec2> lngLats) {
+  auto query      = std::make_shared<HeightQuery>();
+  query->mLngLats = std::move(lngLats);
+  getHeights(query->mLngLats, query->mHeights);
+  query->mReady = true;
+
+  return query;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CelestialSurface::warmUp(glm::dvec3 const& /*position*/, glm::dquat const& /*rotation*/) {
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 } // namespace cs::scene
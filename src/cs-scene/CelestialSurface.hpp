@@ -12,6 +12,7 @@
 
 #include <glm/fwd.hpp>
 #include <memory>
+#include <vector>
 
 namespace cs::scene {
 
@@ -24,10 +25,48 @@ class CelestialObserver;
 /// retrieve the altitude at a given location.
 class CS_SCENE_EXPORT CelestialSurface {
  public:
+  /// A batch of height queries which has been passed to requestHeights(). Once mReady is set,
+  /// mHeights contains one elevation in meters for each of the coordinates in mLngLats.
+  struct HeightQuery {
+    std::vector<glm::dvec2> mLngLats;
+    std::vector<double>     mHeights;
+    bool                    mReady = false;
+  };
+
   /// Returns the elevation in meters at a specific point on the surface.
   ///
   /// @param lngLat The coordinates on the surface in the Geographic Coordinate System format.
   virtual double getHeight(glm::dvec2 lngLat) const = 0;
+
+  /// Returns the elevation in meters at many points on the surface at once. The default
+  /// implementation calls getHeight() for each point, derived classes may provide a faster way.
+  ///
+  /// @param lngLats The coordinates on the surface in the Geographic Coordinate System format.
+  /// @param heights Receives the elevation for each of the given coordinates.
+  virtual void getHeights(
+      std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const;
+
+  /// Queues height queries which are answered asynchronously. Surfaces may collect the queries
+  /// of all callers and answer them together, usually during the next frame. Therefore this is
+  /// preferable to getHeights() whenever a result in the next frame is good enough. The returned
+  /// query has to be kept by the caller until it is ready; queries which are not referenced
+  /// anymore are discarded without being answered. This has to be called from the main thread.
+  /// The default implementation answers the query right away using getHeights().
+  ///
+  /// @param lngLats The coordinates on the surface in the Geographic Coordinate System format.
+  /// @return        The query which will receive the elevation for each of the given coordinates.
+  virtual std::shared_ptr<HeightQuery const> requestHeights(std::vector<glm::dvec2> lngLats);
+
+  /// Asks the surface to load the data required for showing it from the given observer position
+  /// and rotation, so that it is available once the observer actually gets there. This is used for
+  /// warming caches in the background; the data should be loaded with a low priority. It has to be
+  /// called once per frame for as long as the view is of interest. The default implementation does
+  /// nothing.
+  ///
+  /// @param position The observer position in the coordinate system of the CelestialObject.
+  /// @param rotation The observer rotation in the coordinate system of the CelestialObject.
+  /// @return         True once all data for the given view has been loaded.
+  virtual bool warmUp(glm::dvec3 const& position, glm::dquat const& rotation);
 };
 
 } // namespace cs::scene
@@ -0,0 +1,239 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "EphemerisCache.hpp"
+
+#include "../cs-utils/utils.hpp"
+
+#include <array>
+#include <boost/functional/hash.hpp>
+#include <deque>
+#include <cspice/SpiceUsr.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace cs::scene {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The cache is cleared if it contains more entries than this. This may happen if something queries
+// many different times during one frame, for example when sampling trajectories.
+std::size_t const maxEntries = 4096;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Query {
+  std::string mTarget;
+  std::string mObserver;
+  std::string mFrame;
+  double      mTime;
+
+  bool operator==(Query const& other) const {
+    return mTime == other.mTime && mTarget == other.mTarget && mObserver == other.mObserver &&
+           mFrame == other.mFrame;
+  }
+};
+
+struct QueryHash {
+  std::size_t operator()(Query const& query) const {
+    std::size_t result = 0;
+    boost::hash_combine(result, query.mTarget);
+    boost::hash_combine(result, query.mObserver);
+    boost::hash_combine(result, query.mFrame);
+    boost::hash_combine(result, query.mTime);
+    return result;
+  }
+};
+
+std::unordered_map<Query, glm::dvec3, QueryHash> positions; // NOLINT(cert-err58-cpp)
+std::unordered_map<Query, glm::dmat3, QueryHash> rotations; // NOLINT(cert-err58-cpp)
+std::unordered_map<Query, glm::dquat, QueryHash> quaternions; // NOLINT(cert-err58-cpp)
+
+// the interpolated positions, the time of the queries is always zero
+std::unordered_map<Query, std::deque<utils::ChebyshevSeries>, QueryHash> series; // NOLINT
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void throwSpiceError() {
+  std::array<SpiceChar, 320> msg{};
+  getmsg_c("LONG", 320, msg.data());
+  reset_c();
+  throw std::runtime_error(msg.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 EphemerisCache::getPosition(std::string const& target, std::string const& observer,
+    std::string const& frame, double tTime) {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  Query query{target, observer, frame, 0.0};
+
+  auto s = series.find(query);
+  if (s != series.end()) {
+    for (auto const& segment : s->second) {
+      if (tTime >= segment.getStart() && tTime <= segment.getEnd()) {
+        return segment.evaluate(tTime);
+      }
+    }
+  }
+
+  query.mTime = tTime;
+
+  auto it = positions.find(query);
+  if (it != positions.end()) {
+    return it->second;
+  }
+
+  glm::dvec3 position = computePosition(target, observer, frame, tTime);
+
+  if (positions.size() >= maxEntries) {
+    positions.clear();
+  }
+
+  positions.emplace(std::move(query), position);
+
+  return position;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 EphemerisCache::computePosition(std::string const& target, std::string const& observer,
+    std::string const& frame, double tTime) {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  glm::dvec3 position{};
+  double     timeOfLight{};
+  spkpos_c(target.c_str(), tTime, frame.c_str(), "NONE", observer.c_str(),
+      glm::value_ptr(position), &timeOfLight);
+
+  if (failed_c()) {
+    throwSpiceError();
+  }
+
+  return position;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dmat3 EphemerisCache::getRotation(
+    std::string const& from, std::string const& to, double tTime) {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  Query query{from, "", to, tTime};
+
+  auto it = rotations.find(query);
+  if (it != rotations.end()) {
+    return it->second;
+  }
+
+  std::array<double[3], 3> rotMat{}; // NOLINT(modernize-avoid-c-arrays)
+  pxform_c(from.c_str(), to.c_str(), tTime, rotMat.data());
+
+  if (failed_c()) {
+    throwSpiceError();
+  }
+
+  // SPICE matrices are stored row by row, glm matrices column by column.
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+  glm::dmat3 rotation = glm::transpose(glm::make_mat3(rotMat.data()[0]));
+
+  if (rotations.size() >= maxEntries) {
+    rotations.clear();
+  }
+
+  rotations.emplace(std::move(query), rotation);
+
+  return rotation;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dquat EphemerisCache::getRotationQuaternion(
+    std::string const& from, std::string const& to, double tTime) {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  Query query{from, "", to, tTime};
+
+  auto it = quaternions.find(query);
+  if (it != quaternions.end()) {
+    return it->second;
+  }
+
+  // This swaps the axes from SPICE order (x, y, z) to CosmoScout order (y, z, x).
+  glm::dmat3 const swizzle(0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0);
+
+  glm::dquat rotation =
+      glm::quat_cast(swizzle * getRotation(from, to, tTime) * glm::transpose(swizzle));
+
+  // q and -q describe the same rotation. This matches the angle in [0, pi] returned by raxisa_c().
+  if (rotation.w < 0.0) {
+    rotation = -rotation;
+  }
+
+  if (quaternions.size() >= maxEntries) {
+    quaternions.clear();
+  }
+
+  quaternions.emplace(std::move(query), rotation);
+
+  return rotation;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::clear() {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  positions.clear();
+  rotations.clear();
+  quaternions.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::addSeries(std::string const& target, std::string const& observer,
+    std::string const& frame, utils::ChebyshevSeries segment) {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  auto& segments = series[Query{target, observer, frame, 0.0}];
+  segments.push_back(std::move(segment));
+
+  if (segments.size() > sMaxSeries) {
+    segments.pop_front();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::removeSeries(
+    std::string const& target, std::string const& observer, std::string const& frame) {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  series.erase(Query{target, observer, frame, 0.0});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::clearSeries() {
+  std::lock_guard<std::recursive_mutex> lock(utils::getSpiceMutex());
+
+  series.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
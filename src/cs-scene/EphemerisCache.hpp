@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_SCENE_EPHEMERIS_CACHE_HPP
+#define CS_SCENE_EPHEMERIS_CACHE_HPP
+
+#include "cs_scene_export.hpp"
+
+#include "../cs-utils/ChebyshevSeries.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+
+namespace cs::scene {
+
+/// Caches the results of SPICE queries. Each CelestialAnchor::getRelativeTransform() requires the
+/// position of one SPICE object relative to another and the rotation between two frames. Many
+/// objects share the same centers and frames and the same queries are issued by the SolarSystem,
+/// by the trajectories and by many plugins for the same simulation time. With this cache, each
+/// distinct query is evaluated by SPICE only once. Only the parts which depend on the SPICE
+/// centers and frames are cached, the additional position, rotation and scale of the anchors are
+/// applied to the cached results on each query.
+///
+/// The results are keyed by the exact simulation time. The SolarSystem clears the cache whenever
+/// the simulation time changes, so it only holds the queries of the current simulation time. All
+/// vectors and matrices are in SPICE axis order and positions are given in kilometers.
+///
+/// Positions may also be interpolated from Chebyshev series which have been fitted to SPICE data,
+/// see addSeries(). The EphemerisInterpolator fits these on a worker thread.
+///
+/// All methods hold cs::utils::getSpiceMutex(), so they may be called from any thread.
+class CS_SCENE_EXPORT EphemerisCache {
+ public:
+  /// Returns the position of the target relative to the observer in the given frame, without any
+  /// aberration correction. This may throw a std::runtime_error if no sufficient SPICE data is
+  /// available.
+  static glm::dvec3 getPosition(std::string const& target, std::string const& observer,
+      std::string const& frame, double tTime);
+
+  /// Like getPosition(), but this always queries SPICE and does not store the result.
+  static glm::dvec3 computePosition(std::string const& target, std::string const& observer,
+      std::string const& frame, double tTime);
+
+  /// Returns the matrix which transforms vectors from the frame "from" to the frame "to". This may
+  /// throw a std::runtime_error if no sufficient SPICE data is available.
+  static glm::dmat3 getRotation(std::string const& from, std::string const& to, double tTime);
+
+  /// Like getRotation(), but the rotation is returned as a quaternion in CosmoScout's axis order.
+  /// The quaternion is derived from the matrix without any further SPICE calls and cached as well,
+  /// so all anchors which share the same pair of frames reuse it. The real part of the quaternion
+  /// is always positive.
+  static glm::dquat getRotationQuaternion(
+      std::string const& from, std::string const& to, double tTime);
+
+  /// Removes all cached results. This has to be called whenever SPICE kernels are loaded or
+  /// unloaded.
+  static void clear();
+
+  /// The number of series which are kept for each combination of target, observer and frame.
+  static constexpr std::size_t sMaxSeries = 4;
+
+  /// Positions of the target relative to the observer in the given frame will be evaluated from
+  /// the given series for all times in its interval. The series has to be in kilometers. If there
+  /// are more than sMaxSeries series for this combination, the oldest one is removed.
+  static void addSeries(std::string const& target, std::string const& observer,
+      std::string const& frame, utils::ChebyshevSeries series);
+
+  /// Removes the series of the given combination of target, observer and frame.
+  static void removeSeries(
+      std::string const& target, std::string const& observer, std::string const& frame);
+
+  /// Removes all series. This has to be called whenever SPICE kernels are loaded or unloaded.
+  static void clearSeries();
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_EPHEMERIS_CACHE_HPP
@@ -0,0 +1,217 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "EphemerisInterpolator.hpp"
+
+#include "EphemerisCache.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace cs::scene {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// number of coefficients of each series
+std::size_t const seriesCoefficients = 16;
+
+// segment length of newly added objects in seconds
+double const initialSegmentLength = 24.0 * 60.0 * 60.0;
+
+// objects fall back to SPICE once their segments would become shorter than this, in seconds
+double const minSegmentLength = 60.0;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisInterpolator::EphemerisInterpolator(EphemerisService& service)
+    : mService(service) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisInterpolator::~EphemerisInterpolator() {
+  clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisInterpolator::setMaxError(double meters) {
+  if (meters != mMaxError) {
+    clear();
+    mMaxError = meters;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double EphemerisInterpolator::getMaxError() const {
+  return mMaxError;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisInterpolator::update(
+    double tTime, CelestialAnchor const& observer, std::vector<std::string> const& targets) {
+
+  if (mMaxError <= 0.0) {
+    return;
+  }
+
+  // The next segment is fitted in the direction in which the time progresses.
+  if (tTime != mLastTime) {
+    mTimeForwards = tTime > mLastTime;
+    mLastTime     = tTime;
+  }
+
+  std::map<std::string, Track> tracks;
+
+  for (auto const& target : targets) {
+
+    // The position of the observer's center relative to itself is always zero.
+    if (target == observer.getCenterName()) {
+      continue;
+    }
+
+    auto key = target + "|" + observer.getCenterName() + "|" + observer.getFrameName();
+
+    if (tracks.find(key) != tracks.end()) {
+      continue;
+    }
+
+    Track track;
+
+    auto it = mTracks.find(key);
+    if (it != mTracks.end()) {
+      track = std::move(it->second);
+      mTracks.erase(it);
+    } else {
+      track.mTarget        = target;
+      track.mObserver      = observer.getCenterName();
+      track.mFrame         = observer.getFrameName();
+      track.mSegmentLength = initialSegmentLength;
+    }
+
+    // Hand the pending series to the EphemerisCache once it is ready.
+    if (track.mPendingSeries.valid() &&
+        track.mPendingSeries.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      try {
+        auto series = track.mPendingSeries.get();
+
+        if (series) {
+          EphemerisCache::addSeries(
+              track.mTarget, track.mObserver, track.mFrame, std::move(*series));
+          track.mFittedSegments.push_back(track.mPendingSegment);
+
+          if (track.mFittedSegments.size() > EphemerisCache::sMaxSeries) {
+            track.mFittedSegments.pop_front();
+          }
+
+        } else {
+          // The segments are too long for the required accuracy.
+          EphemerisCache::removeSeries(track.mTarget, track.mObserver, track.mFrame);
+          track.mFittedSegments.clear();
+          track.mSegmentLength *= 0.5;
+
+          if (track.mSegmentLength < minSegmentLength) {
+            logger().debug("Cannot interpolate position of {} relative to {} in {} accurately "
+                           "enough. Using SPICE instead.",
+                track.mTarget, track.mObserver, track.mFrame);
+            track.mFailed = true;
+          }
+        }
+      } catch (std::exception const& e) {
+        logger().debug("Cannot interpolate position of {} relative to {} in {}: {}", track.mTarget,
+            track.mObserver, track.mFrame, e.what());
+        track.mFailed = true;
+      }
+    }
+
+    if (!track.mFailed && !track.mPendingSeries.valid()) {
+      auto segment = static_cast<int64_t>(std::floor(tTime / track.mSegmentLength));
+      auto next    = segment + (mTimeForwards ? 1 : -1);
+
+      auto isFitted = [&track](int64_t s) {
+        return std::find(track.mFittedSegments.begin(), track.mFittedSegments.end(), s) !=
+               track.mFittedSegments.end();
+      };
+
+      if (!isFitted(segment)) {
+        requestSegment(track, segment);
+      } else if (!isFitted(next)) {
+        requestSegment(track, next);
+      }
+    }
+
+    tracks.emplace(key, std::move(track));
+  }
+
+  // Remove the series of all objects which have not been passed this time.
+  clear();
+  mTracks = std::move(tracks);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisInterpolator::clear() {
+  for (auto const& [key, track] : mTracks) {
+    EphemerisCache::removeSeries(track.mTarget, track.mObserver, track.mFrame);
+  }
+
+  mTracks.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisInterpolator::requestSegment(Track& track, int64_t segment) {
+  double start = static_cast<double>(segment) * track.mSegmentLength;
+  double end   = start + track.mSegmentLength;
+
+  track.mPendingSegment = segment;
+  track.mPendingSeries  = mService.enqueue([target = track.mTarget, observer = track.mObserver,
+                                               frame = track.mFrame, start, end,
+                                               maxError = mMaxError / 1000.0]() {
+    auto nodes = utils::ChebyshevSeries::getNodes(start, end, seriesCoefficients);
+
+    std::vector<glm::dvec3> samples;
+    samples.reserve(nodes.size());
+
+    for (double t : nodes) {
+      samples.push_back(EphemerisCache::computePosition(target, observer, frame, t));
+    }
+
+    std::optional<utils::ChebyshevSeries> series(std::in_place, start, end, samples);
+
+    // The deviation is largest in between the nodes and towards the ends of the segment.
+    std::vector<double> checks{start, end};
+    for (std::size_t i = 0; i + 1 < nodes.size(); ++i) {
+      checks.push_back(0.5 * (nodes[i] + nodes[i + 1]));
+    }
+
+    for (double t : checks) {
+      auto expected = EphemerisCache::computePosition(target, observer, frame, t);
+      if (glm::distance(series->evaluate(t), expected) > maxError) {
+        return std::optional<utils::ChebyshevSeries>();
+      }
+    }
+
+    return series;
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
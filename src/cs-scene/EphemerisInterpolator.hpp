@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_SCENE_EPHEMERIS_INTERPOLATOR_HPP
+#define CS_SCENE_EPHEMERIS_INTERPOLATOR_HPP
+
+#include "cs_scene_export.hpp"
+
+#include "../cs-utils/ChebyshevSeries.hpp"
+#include "EphemerisService.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cs::scene {
+
+/// Fits Chebyshev series to the positions of SPICE objects relative to the observer on the worker
+/// thread of the EphemerisService. The series are handed to the EphemerisCache, which then
+/// evaluates positions from them instead of querying SPICE.
+///
+/// Time is split into segments of equal length for each object. The segment containing the current
+/// simulation time and the next segment in the direction of time are fitted. If the fit of a
+/// segment deviates more than the maximum error from SPICE, the segment length of this object is
+/// halved. If the segments become too short, the object falls back to SPICE queries.
+class CS_SCENE_EXPORT EphemerisInterpolator {
+ public:
+  explicit EphemerisInterpolator(EphemerisService& service);
+
+  EphemerisInterpolator(EphemerisInterpolator const& other) = delete;
+  EphemerisInterpolator(EphemerisInterpolator&& other)      = delete;
+
+  EphemerisInterpolator& operator=(EphemerisInterpolator const& other) = delete;
+  EphemerisInterpolator& operator=(EphemerisInterpolator&& other)      = delete;
+
+  ~EphemerisInterpolator();
+
+  /// The maximum deviation of interpolated positions from SPICE in meters. Zero disables the
+  /// interpolation, this is the default.
+  void   setMaxError(double meters);
+  double getMaxError() const;
+
+  /// Fits series for the positions of the given SPICE objects relative to the center of the
+  /// observer in the frame of the observer around the given time. Series of objects which are not
+  /// passed anymore are removed. This is called by the SolarSystem once each frame.
+  void update(
+      double tTime, CelestialAnchor const& observer, std::vector<std::string> const& targets);
+
+ private:
+  struct Track {
+    std::string mTarget;
+    std::string mObserver;
+    std::string mFrame;
+
+    /// The length of the segments in seconds.
+    double mSegmentLength;
+
+    /// If set, the positions are always queried from SPICE.
+    bool mFailed = false;
+
+    /// The indices of the segments which have been fitted, in the same order as the series in the
+    /// EphemerisCache.
+    std::deque<int64_t> mFittedSegments;
+
+    int64_t                                            mPendingSegment = 0;
+    std::future<std::optional<utils::ChebyshevSeries>> mPendingSeries;
+  };
+
+  void clear();
+  void requestSegment(Track& track, int64_t segment);
+
+  EphemerisService&            mService;
+  std::map<std::string, Track> mTracks;
+  double                       mMaxError     = 0.0;
+  double                       mLastTime     = 0.0;
+  bool                         mTimeForwards = true;
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_EPHEMERIS_INTERPOLATOR_HPP
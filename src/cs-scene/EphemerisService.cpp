@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "EphemerisService.hpp"
+
+#include <utility>
+
+namespace cs::scene {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisService::EphemerisService()
+    : mWorker(1) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::future<std::vector<std::optional<glm::dvec3>>> EphemerisService::getRelativePositions(
+    CelestialAnchor origin, CelestialAnchor target, std::vector<double> times) {
+
+  return mWorker.enqueue(
+      [origin = std::move(origin), target = std::move(target), times = std::move(times)]() {
+        std::vector<std::optional<glm::dvec3>> positions;
+        positions.reserve(times.size());
+
+        for (double time : times) {
+          try {
+            positions.emplace_back(origin.getRelativePosition(time, target));
+          } catch (...) {
+            // Getting the relative position may fail due to insufficient SPICE data.
+            positions.emplace_back(std::nullopt);
+          }
+        }
+
+        return positions;
+      });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
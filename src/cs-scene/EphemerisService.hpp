@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_SCENE_EPHEMERIS_SERVICE_HPP
+#define CS_SCENE_EPHEMERIS_SERVICE_HPP
+
+#include "cs_scene_export.hpp"
+
+#include "../cs-utils/ThreadPool.hpp"
+#include "CelestialAnchor.hpp"
+
+#include <future>
+#include <optional>
+#include <vector>
+
+namespace cs::scene {
+
+/// Evaluates batches of SPICE queries on a dedicated worker thread. This can be used for work which
+/// requires many SPICE queries but whose result is not needed in the current frame, for example
+/// for resampling entire trajectories.
+///
+/// The worker holds cs::utils::getSpiceMutex() only for one query at a time. Hence the main thread
+/// can still query SPICE directly; it has to wait for at most one query of the worker.
+///
+/// The SolarSystem owns one instance of this, use SolarSystem::getEphemerisService() to access it.
+class CS_SCENE_EXPORT EphemerisService {
+ public:
+  EphemerisService();
+
+  EphemerisService(EphemerisService const& other) = delete;
+  EphemerisService(EphemerisService&& other)      = delete;
+
+  EphemerisService& operator=(EphemerisService const& other) = delete;
+  EphemerisService& operator=(EphemerisService&& other)      = delete;
+
+  ~EphemerisService() = default;
+
+  /// Computes origin.getRelativePosition(time, target) for each of the given times. The anchors are
+  /// copied, so changing them afterwards does not affect the result. The results are in the same
+  /// order as the times, they are std::nullopt for times without sufficient SPICE data.
+  std::future<std::vector<std::optional<glm::dvec3>>> getRelativePositions(
+      CelestialAnchor origin, CelestialAnchor target, std::vector<double> times);
+
+  /// Runs the given function on the worker thread. It has to hold cs::utils::getSpiceMutex()
+  /// whenever it calls CSPICE directly.
+  template <typename F>
+  auto enqueue(F&& f) {
+    return mWorker.enqueue(std::forward<F>(f));
+  }
+
+ private:
+  utils::ThreadPool mWorker;
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_EPHEMERIS_SERVICE_HPP
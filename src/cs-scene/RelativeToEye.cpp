@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "RelativeToEye.hpp"
+
+#include <GL/glew.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <tuple>
+
+namespace cs::scene {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+const char* SHADER_SNIPPET = R"(
+uniform mat3 uEyeRotation;
+uniform vec3 uEyeHigh;
+uniform vec3 uEyeLow;
+
+// The difference of the high parts is exact for nearby values, so the observer-relative position
+// has almost double precision.
+vec3 relativeToEye(vec3 high, vec3 low) {
+  precise vec3 relative = (high - uEyeHigh) + (low - uEyeLow);
+  return uEyeRotation * relative;
+}
+)";
+
+template <typename T>
+std::pair<T, T> splitImpl(glm::vec<T::length(), double> const& value) {
+  T high(value);
+  T low(value - glm::vec<T::length(), double>(high));
+  return {high, low};
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::pair<glm::vec3, glm::vec3> RelativeToEye::split(glm::dvec3 const& value) {
+  return splitImpl<glm::vec3>(value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::pair<glm::vec4, glm::vec4> RelativeToEye::split(glm::dvec4 const& value) {
+  return splitImpl<glm::vec4>(value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::vec3> RelativeToEye::splitInterleaved(std::vector<glm::dvec3> const& positions) {
+  std::vector<glm::vec3> result;
+  result.reserve(2 * positions.size());
+
+  for (auto const& position : positions) {
+    auto [high, low] = split(position);
+    result.push_back(high);
+    result.push_back(low);
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string RelativeToEye::getShaderSnippet() {
+  return SHADER_SNIPPET;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RelativeToEye::init(VistaGLSLShader* shader) {
+  mUniforms.rotation = shader->GetUniformLocation("uEyeRotation");
+  mUniforms.eyeHigh  = shader->GetUniformLocation("uEyeHigh");
+  mUniforms.eyeLow   = shader->GetUniformLocation("uEyeLow");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RelativeToEye::update(glm::dmat4 const& relativeTransform) {
+  glm::dvec3 eye(glm::inverse(relativeTransform)[3]);
+  std::tie(mEyeHigh, mEyeLow) = split(eye);
+
+  mRotation = glm::mat3(relativeTransform);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RelativeToEye::bind() const {
+  glUniformMatrix3fv(mUniforms.rotation, 1, GL_FALSE, glm::value_ptr(mRotation));
+  glUniform3fv(mUniforms.eyeHigh, 1, glm::value_ptr(mEyeHigh));
+  glUniform3fv(mUniforms.eyeLow, 1, glm::value_ptr(mEyeLow));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_SCENE_RELATIVE_TO_EYE_HPP
+#define CS_SCENE_RELATIVE_TO_EYE_HPP
+
+#include "cs_scene_export.hpp"
+
+#include <glm/glm.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+class VistaGLSLShader;
+
+namespace cs::scene {
+
+/// Vertices which are far away from the origin of their coordinate system, like the points of an
+/// orbit or of a path on the surface of a planet, cannot be stored in single precision without
+/// visible jitter. Transforming them to observer-centric coordinates on the CPU each frame is
+/// expensive, as all vertices have to be uploaded again whenever the observer moves.
+///
+/// This class implements a relative-to-eye scheme instead. Each position is split once into a high
+/// and a low single-precision part with split(). Both parts are uploaded, for example as two vertex
+/// attributes, and do not change anymore. Each frame, update() splits the position of the observer
+/// in the same coordinate system. The relativeToEye() function of the GLSL snippet returned by
+/// getShaderSnippet() subtracts the high and the low parts separately, which yields
+/// observer-relative positions with almost double precision, and rotates them into observer-centric
+/// coordinates. Hence, only three uniforms change when the observer moves.
+class CS_SCENE_EXPORT RelativeToEye {
+ public:
+  /// Splits a vector of doubles into two vectors of floats. The sum of both approximates the
+  /// original values with about 48 bits of mantissa.
+  static std::pair<glm::vec3, glm::vec3> split(glm::dvec3 const& value);
+  static std::pair<glm::vec4, glm::vec4> split(glm::dvec4 const& value);
+
+  /// Splits all given positions. The result contains the high and the low part of each position
+  /// one after another, so it can be uploaded as one vertex buffer with two interleaved attributes.
+  static std::vector<glm::vec3> splitInterleaved(std::vector<glm::dvec3> const& positions);
+
+  /// Returns a GLSL snippet with the "vec3 relativeToEye(vec3 high, vec3 low)" method which
+  /// returns the observer-centric position of a vertex given by the two parts returned by split().
+  /// It requires at least "#version 400", as it uses the precise qualifier.
+  static std::string getShaderSnippet();
+
+  /// This should be called once the shader has been linked. It queries the uniform locations used
+  /// by the snippet.
+  void init(VistaGLSLShader* shader);
+
+  /// This should be called once each frame. relativeTransform transforms from the coordinate
+  /// system of the vertices to observer-centric coordinates, it usually is the observer-relative
+  /// transformation of a CelestialObject.
+  void update(glm::dmat4 const& relativeTransform);
+
+  /// Uploads the uniforms set by update(). The shader has to be bound.
+  void bind() const;
+
+ private:
+  glm::mat3 mRotation{1.F};
+  glm::vec3 mEyeHigh{0.F};
+  glm::vec3 mEyeLow{0.F};
+
+  struct {
+    uint32_t rotation = 0;
+    uint32_t eyeHigh  = 0;
+    uint32_t eyeLow   = 0;
+  } mUniforms;
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_RELATIVE_TO_EYE_HPP
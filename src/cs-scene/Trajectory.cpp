@@ -10,40 +10,65 @@
 #include "../cs-utils/utils.hpp"
 
 #include <VistaKernel/DisplayManager/VistaProjection.h>
-#include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
+#include <algorithm>
 #include <array>
+#include <glm/gtc/type_ptr.hpp>
 
 namespace cs::scene {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static const char* SHADER_VERT = R"(
-#version 330
+#version 430
+
+struct Point {
+  vec4 high;
+  vec4 low;
+};
 
 // inputs
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in float inAge;
+layout(std430, binding = 0) readonly buffer PointBuffer {
+  Point uPoints[];
+};
 
 // uniforms
-uniform mat4 uMatModelView;
-uniform mat4 uMatProjection;
+uniform mat4  uMatModelView;
+uniform mat4  uMatProjection;
+uniform int   uStart;
+uniform int   uCapacity;
+uniform vec2  uTime;
+uniform vec3  uTip;
+uniform float uMaxAge;
 
 // outputs
 out float fAge;
 
+RELATIVE_TO_EYE_SNIPPET
+
 void main()
 {
-    fAge = inAge;
-    vec4 pos = uMatModelView * vec4(inPosition.xyz, 1);
+    Point point = uPoints[(uStart + gl_VertexID) % uCapacity];
+
+    fAge = ((uTime.x - point.high.w) + (uTime.y - point.low.w)) / uMaxAge;
+
+    vec3 position = uTip;
+
+    if (fAge > 0.0) {
+      position = relativeToEye(point.high.xyz, point.low.xyz);
+    } else {
+      fAge = 0.0;
+    }
+
+    vec4 pos = uMatModelView * vec4(position, 1);
     gl_Position = uMatProjection * pos;
 })";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static const char* SHADER_FRAG = R"(
-#version 330
+#version 430
 
 // inputs
 in float fAge;
@@ -70,82 +95,142 @@ Trajectory::Trajectory()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Trajectory::upload(glm::dmat4 const& relativeTransform, double dTime,
-    std::vector<glm::dvec4> const& vPoints, glm::dvec3 const& vTip, int startIndex) {
-  if (!vPoints.empty()) {
-    // transform all points to observer centric coordinates
-    std::vector<glm::vec4> points(vPoints.size());
+Trajectory::~Trajectory() {
+  if (mFence) {
+    glDeleteSync(mFence);
+  }
 
-    for (size_t i(0); i < vPoints.size(); ++i) {
-      int ringbufferIndex = (static_cast<int>(i) + startIndex) % static_cast<int>(vPoints.size());
+  if (mBuffer) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mBuffer);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glDeleteBuffers(1, &mBuffer);
+  }
+}
 
-      glm::dvec4 const& curr = vPoints[ringbufferIndex];
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      glm::dvec4 pos(curr.x, curr.y, curr.z, 1.0);
-      auto       age = static_cast<float>((dTime - curr.w) / mMaxAge);
+void Trajectory::setPoints(std::vector<glm::dvec4> const& points) {
+  waitForGpu();
 
-      if (curr.w >= dTime) {
-        pos = glm::dvec4(vTip, 1.0);
-        age = 0.F;
-      }
+  mStart      = 0;
+  mPointCount = 0;
+  pushBack(points);
+}
 
-      pos = relativeTransform * pos;
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      points[i] = glm::vec4(pos.x, pos.y, pos.z, age);
-    }
+void Trajectory::pushBack(std::vector<glm::dvec4> const& points) {
+  if (points.empty()) {
+    return;
+  }
 
-    if (mPointCount != vPoints.size()) {
-      mVBO = std::make_unique<VistaBufferObject>();
-      mVAO = std::make_unique<VistaVertexArrayObject>();
+  reserve(mPointCount + points.size());
+  waitForGpu();
 
-      mVAO->Bind();
+  for (std::size_t i(0); i < points.size(); ++i) {
+    write((mStart + mPointCount + i) % mCapacity, points[i]);
+  }
 
-      mVBO->Bind(GL_ARRAY_BUFFER);
-      mVBO->BufferData(points.size() * sizeof(glm::vec4), points.data(), GL_DYNAMIC_DRAW);
+  mPointCount += points.size();
+}
 
-      // positions
-      mVAO->EnableAttributeArray(0);
-      mVAO->SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0, mVBO.get());
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      // ages
-      mVAO->EnableAttributeArray(1);
-      mVAO->SpecifyAttributeArrayFloat(
-          1, 1, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), sizeof(glm::vec3), mVBO.get());
+void Trajectory::pushFront(std::vector<glm::dvec4> const& points) {
+  if (points.empty()) {
+    return;
+  }
 
-      mVAO->Release();
-      mVBO->Release();
-    } else {
-      mVBO->Bind(GL_ARRAY_BUFFER);
-      mVBO->BufferSubData(0, points.size() * sizeof(glm::vec4), points.data());
-      mVBO->Release();
-    }
+  reserve(mPointCount + points.size());
+  waitForGpu();
+
+  mStart = (mStart + mCapacity - points.size()) % mCapacity;
 
-    mPointCount = static_cast<int>(vPoints.size());
+  for (std::size_t i(0); i < points.size(); ++i) {
+    write((mStart + i) % mCapacity, points[i]);
   }
+
+  mPointCount += points.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::popFront(std::size_t count) {
+  count = std::min(count, mPointCount);
+
+  if (mCapacity > 0) {
+    mStart = (mStart + count) % mCapacity;
+  }
+
+  mPointCount -= count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::popBack(std::size_t count) {
+  mPointCount -= std::min(count, mPointCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::clear() {
+  mStart      = 0;
+  mPointCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Trajectory::getPointCount() const {
+  return mPointCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::update(glm::dmat4 const& relativeTransform, double dTime, glm::dvec3 const& vTip) {
+  mRelativeToEye.update(relativeTransform);
+
+  auto timeHigh = static_cast<float>(dTime);
+  mTime = glm::vec2(timeHigh, static_cast<float>(dTime - static_cast<double>(timeHigh)));
+
+  mTip = glm::vec3(relativeTransform * glm::dvec4(vTip, 1.0));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool Trajectory::Do() {
-  if (mPointCount > 0 && mVAO) {
+  if (mPointCount > 1) {
     if (mShaderDirty) {
       createShader();
       mShaderDirty = false;
     }
 
+    if (!mVAO) {
+      mVAO = std::make_unique<VistaVertexArrayObject>();
+    }
+
     glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_LINE_BIT);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_LINE_SMOOTH);
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
 
+    // The points are fetched from the ring buffer in the vertex shader, so no attributes are used.
     mVAO->Bind();
     mShader->Bind();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mBuffer);
 
     mShader->SetUniform(
         mUniforms.startColor, mStartColor[0], mStartColor[1], mStartColor[2], mStartColor[3]);
     mShader->SetUniform(mUniforms.endColor, mEndColor[0], mEndColor[1], mEndColor[2], mEndColor[3]);
 
+    glUniform1i(static_cast<GLint>(mUniforms.start), static_cast<GLint>(mStart));
+    glUniform1i(static_cast<GLint>(mUniforms.capacity), static_cast<GLint>(mCapacity));
+    mRelativeToEye.bind();
+    glUniform2fv(mUniforms.time, 1, glm::value_ptr(mTime));
+    glUniform3fv(mUniforms.tip, 1, glm::value_ptr(mTip));
+    mShader->SetUniform(mUniforms.maxAge, static_cast<float>(mMaxAge));
+
     // get modelview and projection matrices
     std::array<GLfloat, 16> glMatMV{};
     std::array<GLfloat, 16> glMatP{};
@@ -156,14 +241,22 @@ bool Trajectory::Do() {
 
     glLineWidth(mWidth);
 
-    uint32_t amountNoDepth = mPointCount / 2;
+    auto pointCount    = static_cast<GLsizei>(mPointCount);
+    auto amountNoDepth = pointCount / 2;
 
     glDepthMask(GL_FALSE);
     glDrawArrays(GL_LINE_STRIP, 0, amountNoDepth + 1);
     glDepthMask(GL_TRUE);
 
-    glDrawArrays(GL_LINE_STRIP, amountNoDepth, mPointCount - amountNoDepth);
+    glDrawArrays(GL_LINE_STRIP, amountNoDepth, pointCount - amountNoDepth);
+
+    // The next modification of the ring buffer has to wait until these draw calls are finished.
+    if (mFence) {
+      glDeleteSync(mFence);
+    }
+    mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
     mShader->Release();
     mVAO->Release();
 
@@ -187,6 +280,8 @@ void Trajectory::createShader() {
   std::string sVert(SHADER_VERT);
   std::string sFrag(SHADER_FRAG);
 
+  utils::replaceString(sVert, "RELATIVE_TO_EYE_SNIPPET", RelativeToEye::getShaderSnippet());
+
   mShader->InitVertexShaderFromString(sVert);
   mShader->InitFragmentShaderFromString(sFrag);
   mShader->Link();
@@ -195,6 +290,92 @@ void Trajectory::createShader() {
   mUniforms.endColor         = mShader->GetUniformLocation("cEndColor");
   mUniforms.modelViewMatrix  = mShader->GetUniformLocation("uMatModelView");
   mUniforms.projectionMatrix = mShader->GetUniformLocation("uMatProjection");
+  mUniforms.start            = mShader->GetUniformLocation("uStart");
+  mUniforms.capacity         = mShader->GetUniformLocation("uCapacity");
+  mUniforms.time             = mShader->GetUniformLocation("uTime");
+  mUniforms.tip              = mShader->GetUniformLocation("uTip");
+  mUniforms.maxAge           = mShader->GetUniformLocation("uMaxAge");
+
+  mRelativeToEye.init(mShader.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::reserve(std::size_t pointCount) {
+  // The capacity is always at least twice the number of points. Hence, points which are added at
+  // either end of the ring are written to slots which have not been part of the trajectory for a
+  // while. Additionally, waitForGpu() makes sure that no draw call still reads them.
+  if (2 * pointCount <= mCapacity) {
+    return;
+  }
+
+  std::size_t const minCapacity = 64;
+  std::size_t       capacity    = std::max(4 * pointCount, minCapacity);
+
+  uint32_t buffer = 0;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+  auto       size  = static_cast<GLsizeiptr>(capacity * sizeof(GpuPoint));
+  auto const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+  auto* data = static_cast<GpuPoint*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+
+  // Copy the existing points to the beginning of the new buffer. As the ring may wrap around, this
+  // requires up to two copies.
+  if (mBuffer) {
+    glBindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+
+    std::size_t first  = std::min(mPointCount, mCapacity - mStart);
+    std::size_t second = mPointCount - first;
+
+    if (first > 0) {
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+          static_cast<GLintptr>(mStart * sizeof(GpuPoint)), 0,
+          static_cast<GLsizeiptr>(first * sizeof(GpuPoint)));
+    }
+
+    if (second > 0) {
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+          static_cast<GLintptr>(first * sizeof(GpuPoint)),
+          static_cast<GLsizeiptr>(second * sizeof(GpuPoint)));
+    }
+
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &mBuffer);
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  // Draw calls of previous frames used the old buffer, so there is nothing to wait for.
+  if (mFence) {
+    glDeleteSync(mFence);
+    mFence = nullptr;
+  }
+
+  mBuffer   = buffer;
+  mData     = data;
+  mCapacity = capacity;
+  mStart    = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::write(std::size_t ringIndex, glm::dvec4 const& point) {
+  auto [high, low] = RelativeToEye::split(point);
+  mData[ringIndex] = {high, low};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::waitForGpu() {
+  if (mFence) {
+    uint64_t const timeout = 1000000000;
+    glClientWaitSync(mFence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    glDeleteSync(mFence);
+    mFence = nullptr;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -8,10 +8,11 @@
 #ifndef CS_SCENE_TRAJECTORY_HPP
 #define CS_SCENE_TRAJECTORY_HPP
 
+#include "RelativeToEye.hpp"
 #include "cs_scene_export.hpp"
 
+#include <GL/glew.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
-#include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
@@ -25,11 +26,17 @@ namespace cs::scene {
 /// This class is responsible for drawing trajectories. Trajectories are line segments which
 /// typically follow an object in space. It is most often used to draw orbit paths.
 /// A trajectories trail consists of a list of points in 3D space, where every 3D point is
-/// extended by a fourth value, which indicates its age. This is used to fade older
-/// points out. The lifetime of every point depends on the maxAge member.
+/// extended by a fourth value, which contains the time of the point. The age of a point is used to
+/// fade older points out. The lifetime of every point depends on the maxAge member.
 /// The color of every point is also dependent on the lifetime. It is controlled with the members
 /// startColor and endColor. A young point will have a color closer to the startColor and an old
 /// point, which is close to the maxAge will have a color closer to the endColor.
+///
+/// The points are stored in a persistently mapped ring buffer on the GPU. Points can be added and
+/// removed at both ends of the trajectory, which only writes the new points. They are stored in
+/// the coordinate system of the parent object with emulated double precision, the transformation
+/// to observer-centric coordinates is done in the vertex shader. Hence, moving the observer does
+/// not require uploading the points again.
 class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
  public:
   Trajectory();
@@ -40,13 +47,33 @@ class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
   Trajectory& operator=(Trajectory const& other) = delete;
   Trajectory& operator=(Trajectory&& other) = delete;
 
-  ~Trajectory() override = default;
+  ~Trajectory() override;
 
-  /// Transforms all points by relativeTransform and uploads them to the GPU. Call this every frame
-  /// in order to show the trajectory with observer centric coordinates. dTime determines the
-  /// current age of all points.
-  void upload(glm::dmat4 const& relativeTransform, double dTime,
-      std::vector<glm::dvec4> const& vPoints, glm::dvec3 const& vTip, int startIndex);
+  /// Replaces all points of the trajectory. The xyz components of each point contain its position
+  /// in the coordinate system of the parent object, the w component contains its time. The points
+  /// have to be sorted by time.
+  void setPoints(std::vector<glm::dvec4> const& points);
+
+  /// Adds points after the last point or before the first point of the trajectory. In both cases,
+  /// the given points have to be sorted by time.
+  void pushBack(std::vector<glm::dvec4> const& points);
+  void pushFront(std::vector<glm::dvec4> const& points);
+
+  /// Removes the given number of points from the beginning or the end of the trajectory.
+  void popFront(std::size_t count);
+  void popBack(std::size_t count);
+
+  /// Removes all points.
+  void clear();
+
+  /// Returns the current number of points.
+  std::size_t getPointCount() const;
+
+  /// Call this every frame in order to show the trajectory with observer centric coordinates.
+  /// relativeTransform transforms from the coordinate system of the parent object to observer
+  /// centric coordinates. dTime determines the current age of all points, all points with a time
+  /// after dTime are drawn at vTip. This only updates some uniforms, no points are uploaded.
+  void update(glm::dmat4 const& relativeTransform, double dTime, glm::dvec3 const& vTip);
 
   /// The method Do() gets the callback from scene graph during the rendering process.
   /// Renders the trajectory in its current state.
@@ -72,11 +99,34 @@ class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
   void  setWidth(float val);
 
  private:
+  /// Each point is stored in two single-precision vectors. The sum of both gives the position and
+  /// time with approximately double precision.
+  struct GpuPoint {
+    glm::vec4 mHigh;
+    glm::vec4 mLow;
+  };
+
   void createShader();
 
+  /// Makes sure that the ring buffer can hold the given number of points.
+  void reserve(std::size_t pointCount);
+
+  /// Writes the given point to the given position of the ring buffer.
+  void write(std::size_t ringIndex, glm::dvec4 const& point);
+
+  /// Waits until the GPU has finished the last draw call which read from the ring buffer.
+  void waitForGpu();
+
   std::unique_ptr<VistaGLSLShader>        mShader;
   std::unique_ptr<VistaVertexArrayObject> mVAO;
-  std::unique_ptr<VistaBufferObject>      mVBO;
+
+  /// The ring buffer, mStart is the index of the first point. mFence is created after each draw.
+  uint32_t    mBuffer     = 0;
+  GpuPoint*   mData       = nullptr;
+  GLsync      mFence      = nullptr;
+  std::size_t mCapacity   = 0;
+  std::size_t mStart      = 0;
+  std::size_t mPointCount = 0;
 
   double    mMaxAge{100000.F};
   glm::vec4 mStartColor;
@@ -85,13 +135,21 @@ class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
 
   bool mShaderDirty = true;
 
-  uint32_t mPointCount{0};
+  /// The values set by update().
+  RelativeToEye mRelativeToEye;
+  glm::vec2     mTime{0.F};
+  glm::vec3     mTip{0.F};
 
   struct {
     uint32_t startColor       = 0;
     uint32_t endColor         = 0;
     uint32_t modelViewMatrix  = 0;
     uint32_t projectionMatrix = 0;
+    uint32_t start            = 0;
+    uint32_t capacity         = 0;
+    uint32_t time             = 0;
+    uint32_t tip              = 0;
+    uint32_t maxAge           = 0;
   } mUniforms;
 };
 } // namespace cs::scene
@@ -59,7 +59,9 @@ class AnimatedValue {
   }
 
   /// @return Gives back an interpolated result according to the current settings and given time.
-  T get(double time) {
+  /// The easing curve is reduced to a single interpolation parameter, so this costs one call to
+  /// glm::mix() regardless of the direction of the animation.
+  T get(double time) const {
     if (time < mStartTime) {
       return mStartValue;
     }
@@ -68,49 +70,76 @@ class AnimatedValue {
       return mEndValue;
     }
 
-    double state = glm::clamp((time - mStartTime) / (mEndTime - mStartTime), 0.0, 1.0);
+    return glm::mix(mStartValue, mEndValue, getProgress(getState(time)));
+  }
+
+  /// @return The rate of change of the animated value per unit of time at the given time. This is
+  /// zero before and after the animation. This can only be used for double-precision scalars and
+  /// vectors, not for quaternions.
+  T getDerivative(double time) const {
+    if (time < mStartTime || time >= mEndTime) {
+      return T(0.0);
+    }
+
+    return (mEndValue - mStartValue) *
+           (getProgressDerivative(getState(time)) / (mEndTime - mStartTime));
+  }
 
+ protected:
+  double getState(double time) const {
+    return glm::clamp((time - mStartTime) / (mEndTime - mStartTime), 0.0, 1.0);
+  }
+
+  // Maps the linear state of the animation in [0...1] to the eased interpolation parameter. The
+  // eInOut and eOutIn directions use the first half of one curve and the second half of the other
+  // one, each scaled to one half of the value range.
+  double getProgress(double a) const {
     switch (mDirection) {
     case AnimationDirection::eLinear:
-      return updateLinear(state, mStartValue, mEndValue);
+      return a;
     case AnimationDirection::eIn:
-      return updateEaseIn(state, mStartValue, mEndValue);
+      return easeIn(a);
     case AnimationDirection::eOut:
-      return updateEaseOut(state, mStartValue, mEndValue);
+      return easeOut(a);
     case AnimationDirection::eInOut:
-      return updateEaseInOut(state, mStartValue, mEndValue);
+      return a < 0.5 ? 0.5 * easeIn(a * 2.0) : 0.5 + 0.5 * easeOut(a * 2.0 - 1.0);
     default: // AnimationDirection::eOutIn:
-      return updateEaseOutIn(state, mStartValue, mEndValue);
+      return a < 0.5 ? 0.5 * easeOut(a * 2.0) : 0.5 + 0.5 * easeIn(a * 2.0 - 1.0);
     }
   }
 
- protected:
-  T updateLinear(double a, T const& s, T const& e) {
-    return glm::mix(s, e, a);
+  // The derivative of getProgress() with respect to the state.
+  double getProgressDerivative(double a) const {
+    switch (mDirection) {
+    case AnimationDirection::eLinear:
+      return 1.0;
+    case AnimationDirection::eIn:
+      return easeInDerivative(a);
+    case AnimationDirection::eOut:
+      return easeOutDerivative(a);
+    case AnimationDirection::eInOut:
+      return a < 0.5 ? easeInDerivative(a * 2.0) : easeOutDerivative(a * 2.0 - 1.0);
+    default: // AnimationDirection::eOutIn:
+      return a < 0.5 ? easeOutDerivative(a * 2.0) : easeInDerivative(a * 2.0 - 1.0);
+    }
   }
 
-  T updateEaseIn(double a, T const& s, T const& e) {
-    return glm::mix(s, e, (std::pow(a, 4.0) * ((mExponent + 1) * a - mExponent)));
+  double easeIn(double a) const {
+    return std::pow(a, 4.0) * ((mExponent + 1) * a - mExponent);
   }
 
-  T updateEaseOut(double a, T const& s, T const& e) {
-    return glm::mix(s, e, (std::pow(a - 1, 4.0) * ((mExponent + 1) * (a - 1) + mExponent) + 1));
+  double easeInDerivative(double a) const {
+    return 4.0 * std::pow(a, 3.0) * ((mExponent + 1) * a - mExponent) +
+           std::pow(a, 4.0) * (mExponent + 1);
   }
 
-  T updateEaseInOut(double a, T const& s, T const& e) {
-    if (a < 0.5F) {
-      return updateEaseIn(a * 2, s, glm::mix(s, e, 0.5));
-    }
-
-    return updateEaseOut(a * 2 - 1, glm::mix(s, e, 0.5), e);
+  double easeOut(double a) const {
+    return std::pow(a - 1, 4.0) * ((mExponent + 1) * (a - 1) + mExponent) + 1;
   }
 
-  T updateEaseOutIn(double a, T const& s, T const& e) {
-    if (a < 0.5F) {
-      return updateEaseOut(a * 2, s, glm::mix(s, e, 0.5));
-    }
-
-    return updateEaseIn(a * 2 - 1, glm::mix(s, e, 0.5), e);
+  double easeOutDerivative(double a) const {
+    return 4.0 * std::pow(a - 1, 3.0) * ((mExponent + 1) * (a - 1) + mExponent) +
+           std::pow(a - 1, 4.0) * (mExponent + 1);
   }
 };
 
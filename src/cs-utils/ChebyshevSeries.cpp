@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "ChebyshevSeries.hpp"
+
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<double> ChebyshevSeries::getNodes(double start, double end, std::size_t count) {
+  std::vector<double> nodes(count);
+
+  for (std::size_t k = 0; k < count; ++k) {
+    double x = std::cos(glm::pi<double>() * (static_cast<double>(k) + 0.5) /
+                        static_cast<double>(count));
+    nodes[k] = 0.5 * (start + end) + 0.5 * (end - start) * x;
+  }
+
+  return nodes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ChebyshevSeries::ChebyshevSeries(double start, double end, std::vector<glm::dvec3> const& samples)
+    : mStart(start)
+    , mEnd(end)
+    , mCoefficients(samples.size(), glm::dvec3(0.0)) {
+
+  auto count = static_cast<double>(samples.size());
+
+  for (std::size_t j = 0; j < samples.size(); ++j) {
+    for (std::size_t k = 0; k < samples.size(); ++k) {
+      mCoefficients[j] += samples[k] * std::cos(glm::pi<double>() * static_cast<double>(j) *
+                                                (static_cast<double>(k) + 0.5) / count);
+    }
+
+    mCoefficients[j] *= 2.0 / count;
+  }
+
+  // With this, the series can be evaluated as the plain sum of all terms.
+  if (!mCoefficients.empty()) {
+    mCoefficients[0] *= 0.5;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double ChebyshevSeries::getStart() const {
+  return mStart;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double ChebyshevSeries::getEnd() const {
+  return mEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 ChebyshevSeries::evaluate(double t) const {
+  if (mCoefficients.empty()) {
+    return glm::dvec3(0.0);
+  }
+
+  // Map the time to [-1, 1] and use Clenshaw's recurrence.
+  double     x = (2.0 * t - mStart - mEnd) / (mEnd - mStart);
+  glm::dvec3 b1(0.0);
+  glm::dvec3 b2(0.0);
+
+  for (std::size_t j = mCoefficients.size() - 1; j > 0; --j) {
+    glm::dvec3 b0 = 2.0 * x * b1 - b2 + mCoefficients[j];
+    b2            = b1;
+    b1            = b0;
+  }
+
+  return x * b1 - b2 + mCoefficients[0];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
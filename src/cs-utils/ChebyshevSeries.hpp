@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_CHEBYSHEV_SERIES_HPP
+#define CS_UTILS_CHEBYSHEV_SERIES_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace cs::utils {
+
+/// Approximates a smooth vector-valued function on the interval [start, end] with a sum of
+/// Chebyshev polynomials. The series is fitted by sampling the function at the Chebyshev nodes of
+/// the interval, which are given by getNodes(). Evaluating a series of n coefficients requires
+/// about 2n multiply-adds.
+class CS_UTILS_EXPORT ChebyshevSeries {
+ public:
+  /// Returns the count times at which the function has to be sampled for fitting a series with
+  /// count coefficients to the interval [start, end].
+  static std::vector<double> getNodes(double start, double end, std::size_t count);
+
+  /// Computes the coefficients from the values of the function at getNodes(start, end,
+  /// samples.size()).
+  ChebyshevSeries(double start, double end, std::vector<glm::dvec3> const& samples);
+
+  double getStart() const;
+  double getEnd() const;
+
+  /// Evaluates the series at the given time, which should be inside [start, end].
+  glm::dvec3 evaluate(double t) const;
+
+ private:
+  double                  mStart;
+  double                  mEnd;
+  std::vector<glm::dvec3> mCoefficients;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_CHEBYSHEV_SERIES_HPP
@@ -7,62 +7,89 @@
 
 #include "Downloader.hpp"
 
+#include "HttpClient.hpp"
+#include "Sha256.hpp"
 #include "filesystem.hpp"
 #include "logger.hpp"
 
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <fstream>
+
 namespace cs::utils {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Files of at least this size are downloaded in chunks if the server supports range requests.
+uint64_t const CHUNKED_DOWNLOAD_SIZE = 64 * 1024 * 1024;
+
+// Large files are split into this many chunks.
+uint32_t const CHUNK_COUNT = 4;
+
+std::string getChunkFile(std::string const& file, uint32_t chunk) {
+  return file + ".part" + std::to_string(chunk);
+}
+
+// Adds the difference to the last reported value to the given counter.
+void addProgress(std::atomic<uint64_t>& counter, uint64_t& reported, double now) {
+  auto current = static_cast<uint64_t>(now);
+  if (current > reported) {
+    counter.fetch_add(current - reported, std::memory_order_relaxed);
+    reported = current;
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Downloader::Downloader(size_t threadCount)
-    : mThreadPool(threadCount) {
+    : mThreadPool(threadCount, "Downloader") {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Downloader::download(std::string const& url, std::string const& file) {
-  if (boost::filesystem::exists(file)) {
+void Downloader::download(std::string const& url, std::string const& file,
+    ThreadPool::Priority priority, std::optional<std::string> sha256) {
+  if (boost::filesystem::exists(file) || mDownloads.find(file) != mDownloads.end()) {
     return;
   }
 
-  std::unique_lock<std::mutex> lock(mProgressMutex);
-  size_t                       progressIndex = mProgress.size();
-  mProgress.emplace_back(0.0, 0.0);
+  auto& download   = *mDownloads.emplace(file, std::make_unique<Download>()).first->second;
+  download.mUrl    = url;
+  download.mFile   = file;
+  download.mSha256 = std::move(sha256);
 
-  // We download to a file with a .part suffix. Once the download is done, we will remove the
-  // suffix.
-  mThreadPool.enqueue([this, file, url, progressIndex]() {
-    logger().info("Downloading file '{}'...", file);
+  mThreadPool.enqueue(priority, [this, &download, priority]() {
+    logger().info("Downloading file '{}'...", download.mFile);
 
-    filesystem::downloadFile(
-        url, file + ".part", [this, progressIndex](double progress, double total) {
-          std::unique_lock<std::mutex> lock(mProgressMutex);
-          mProgress[progressIndex] = {progress, total};
-        });
-
-    std::rename((file + ".part").c_str(), file.c_str());
-    logger().info("Finished downloading file '{}'.", file);
+    try {
+      start(download, priority);
+    } catch (std::exception const& e) {
+      logger().error("Failed to download file '{}': {}", download.mFile, e.what());
+      download.mFinished = true;
+    }
   });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 double Downloader::getProgress() const {
-  std::unique_lock<std::mutex> lock(mProgressMutex);
-
   double progress = 0.0;
   double total    = 0.0;
 
-  for (auto const& p : mProgress) {
-    progress += p.first;
-    total += p.second;
+  for (auto const& [file, download] : mDownloads) {
+    progress += static_cast<double>(download->mReceivedBytes.load(std::memory_order_relaxed));
+    total += static_cast<double>(download->mTotalBytes.load(std::memory_order_relaxed));
   }
 
   if (total <= 0.0) {
     return 100.0;
   }
 
-  return progress / total * 100.0;
+  return std::min(progress / total, 1.0) * 100.0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -73,4 +100,189 @@ bool Downloader::hasFinished() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool Downloader::hasFinished(std::string const& file) const {
+  auto download = mDownloads.find(file);
+  return download == mDownloads.end() || download->second->mFinished;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Downloader::start(Download& download, ThreadPool::Priority priority) {
+  std::string partFile = download.mFile + ".part";
+
+  // First we find out the size of the file and whether the server supports range requests. A
+  // partial file of a previous attempt is always resumed as a whole.
+  if (!boost::filesystem::exists(partFile)) {
+    HttpClient::Response response;
+
+    try {
+      HttpClient::Request request;
+      request.mUrl      = download.mUrl;
+      request.mPriority = HttpClient::Priority::eLow;
+      request.mHeadOnly = true;
+      response          = HttpClient::get().perform(request);
+    } catch (std::exception const& e) {
+      // Some servers do not answer HEAD requests properly. We simply download the file in one
+      // piece then.
+      logger().debug("Failed to query the size of '{}': {}", download.mUrl, e.what());
+    }
+
+    auto     length = response.mHeaders.find("content-length");
+    auto     ranges = response.mHeaders.find("accept-ranges");
+    uint64_t size   = 0;
+
+    if (length != response.mHeaders.end()) {
+      try {
+        size = std::stoull(length->second);
+      } catch (std::exception const&) {
+        size = 0;
+      }
+    }
+
+    if (response.mResponseCode == 200 && size >= CHUNKED_DOWNLOAD_SIZE &&
+        ranges != response.mHeaders.end() && boost::iequals(ranges->second, "bytes")) {
+
+      download.mTotalBytes    = size;
+      download.mPendingChunks = CHUNK_COUNT;
+
+      uint64_t chunkSize = size / CHUNK_COUNT;
+
+      for (uint32_t i = 0; i < CHUNK_COUNT; ++i) {
+        uint64_t first = i * chunkSize;
+        uint64_t last  = i + 1 == CHUNK_COUNT ? size - 1 : (i + 1) * chunkSize - 1;
+
+        mThreadPool.enqueue(priority, [this, &download, i, first, last]() {
+          downloadChunk(download, i, first, last);
+        });
+      }
+
+      return;
+    }
+  }
+
+  uint64_t reported = 0;
+
+  filesystem::downloadFile(
+      download.mUrl, partFile,
+      [&download, &reported](double progress, double total) {
+        download.mTotalBytes.store(static_cast<uint64_t>(total), std::memory_order_relaxed);
+        addProgress(download.mReceivedBytes, reported, progress);
+      },
+      true);
+
+  finish(download);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Downloader::downloadChunk(Download& download, uint32_t chunk, uint64_t first, uint64_t last) {
+  std::string chunkFile = getChunkFile(download.mFile, chunk);
+
+  try {
+    // Resume the chunk if a previous attempt has been interrupted.
+    uint64_t offset = 0;
+    if (boost::filesystem::exists(chunkFile)) {
+      offset = boost::filesystem::file_size(chunkFile);
+    }
+
+    download.mReceivedBytes.fetch_add(offset, std::memory_order_relaxed);
+
+    if (first + offset <= last) {
+      std::ofstream stream(chunkFile, std::ofstream::out | std::ofstream::binary |
+                                          (offset > 0 ? std::ofstream::app : std::ofstream::trunc));
+
+      if (!stream) {
+        throw std::runtime_error("Failed to open " + chunkFile + "!");
+      }
+
+      uint64_t reported = 0;
+
+      HttpClient::Request request;
+      request.mUrl      = download.mUrl;
+      request.mPriority = HttpClient::Priority::eLow;
+      request.mOutput   = &stream;
+      request.mHeaders.push_back(
+          "Range: bytes=" + std::to_string(first + offset) + "-" + std::to_string(last));
+      request.mProgressCallback = [&download, &reported](double /*total*/, double now) {
+        addProgress(download.mReceivedBytes, reported, now);
+        return download.mFailed.load();
+      };
+
+      auto response = HttpClient::get().perform(request);
+
+      if (response.mResponseCode != 206) {
+        throw std::runtime_error(
+            "Unexpected HTTP response code " + std::to_string(response.mResponseCode) + "!");
+      }
+    }
+
+  } catch (std::exception const& e) {
+    logger().error("Failed to download chunk {} of '{}': {}", chunk, download.mFile, e.what());
+    download.mFailed = true;
+  }
+
+  if (download.mPendingChunks.fetch_sub(1) == 1) {
+    assemble(download, CHUNK_COUNT);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Downloader::assemble(Download& download, uint32_t chunkCount) {
+  try {
+    if (download.mFailed) {
+      throw std::runtime_error("Not all chunks could be downloaded!");
+    }
+
+    std::string partFile = download.mFile + ".part";
+
+    {
+      std::ofstream output(partFile, std::ofstream::out | std::ofstream::binary);
+
+      for (uint32_t i = 0; i < chunkCount; ++i) {
+        std::ifstream input(getChunkFile(download.mFile, i), std::ifstream::binary);
+        output << input.rdbuf();
+      }
+
+      if (!output) {
+        throw std::runtime_error("Failed to write " + partFile + "!");
+      }
+    }
+
+    for (uint32_t i = 0; i < chunkCount; ++i) {
+      boost::filesystem::remove(getChunkFile(download.mFile, i));
+    }
+
+    finish(download);
+
+  } catch (std::exception const& e) {
+    // The chunks are kept, so that they can be resumed next time.
+    logger().error("Failed to download file '{}': {}", download.mFile, e.what());
+    download.mFinished = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Downloader::finish(Download& download) {
+  std::string partFile = download.mFile + ".part";
+
+  if (download.mSha256) {
+    std::string hash = Sha256::hashFile(partFile);
+
+    if (!boost::iequals(hash, *download.mSha256)) {
+      boost::filesystem::remove(partFile);
+      throw std::runtime_error("The SHA-256 hash " + hash + " does not match the expected hash " +
+                               *download.mSha256 + "!");
+    }
+  }
+
+  std::rename(partFile.c_str(), download.mFile.c_str());
+  logger().info("Finished downloading file '{}'.", download.mFile);
+
+  download.mFinished = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::utils
@@ -12,9 +12,21 @@
 
 #include "ThreadPool.hpp"
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
 namespace cs::utils {
 
-/// This class can be used to download a set of files in parallel.
+/// This class can be used to download a set of files in parallel. Large files are split into
+/// several chunks which are downloaded in parallel with HTTP range requests, if the server supports
+/// this. Interrupted downloads are resumed from the partial files of the previous attempt.
+///
+/// download(), getProgress() and hasFinished() have to be called from the same thread. The worker
+/// threads report their progress with atomic counters, so querying the progress never waits for
+/// them.
 class CS_UTILS_EXPORT Downloader {
  public:
   /// This initializes the internal thread pool with the given number of threads.
@@ -22,8 +34,12 @@ class CS_UTILS_EXPORT Downloader {
 
   /// Queue a file to be downloaded. If a file with the given name already exists, nothing will be
   /// done. This method will return quickly, as the actual download is done in a separate thread.
-  ///  If the path to the destination file does not exist, it will be created.
-  void download(std::string const& url, std::string const& file);
+  /// If the path to the destination file does not exist, it will be created. Files with a higher
+  /// priority are started first. If the SHA-256 hash of the file is given as hexadecimal string,
+  /// the file is only kept if its hash matches.
+  void download(std::string const& url, std::string const& file,
+      ThreadPool::Priority       priority = ThreadPool::Priority::eNormal,
+      std::optional<std::string> sha256   = std::nullopt);
 
   /// Returns the total download progress in percent. If no file was downloaded, it will return 100.
   double getProgress() const;
@@ -31,11 +47,42 @@ class CS_UTILS_EXPORT Downloader {
   /// Returns true when the internal thread pool has no running or pending tasks.
   bool hasFinished() const;
 
+  /// Returns true if the given file is not queued or being downloaded anymore. This is also the
+  /// case if the download failed.
+  bool hasFinished(std::string const& file) const;
+
  private:
-  ThreadPool mThreadPool;
+  struct Download {
+    std::string                mUrl;
+    std::string                mFile;
+    std::optional<std::string> mSha256;
+
+    std::atomic<uint64_t> mReceivedBytes{0};
+    std::atomic<uint64_t> mTotalBytes{0};
+
+    /// The number of chunks which are still being downloaded, if the file is downloaded in chunks.
+    std::atomic<uint32_t> mPendingChunks{0};
+    std::atomic<bool>     mFailed{false};
+    std::atomic<bool>     mFinished{false};
+  };
+
+  /// Downloads the given file in one piece or starts the download of its chunks.
+  void start(Download& download, ThreadPool::Priority priority);
 
-  mutable std::mutex                     mProgressMutex;
-  std::vector<std::pair<double, double>> mProgress;
+  /// Downloads one chunk of a file. The last chunk which finishes calls assemble().
+  void downloadChunk(Download& download, uint32_t chunk, uint64_t first, uint64_t last);
+
+  /// Concatenates the chunks, verifies and renames the file.
+  void assemble(Download& download, uint32_t chunkCount);
+
+  /// Verifies the hash of the .part file and renames it.
+  static void finish(Download& download);
+
+  // The entries are only added by download(), so the worker threads can keep references to them.
+  // They are declared before the thread pool, so that they outlive the worker threads.
+  std::map<std::string, std::unique_ptr<Download>> mDownloads;
+
+  ThreadPool mThreadPool;
 };
 
 } // namespace cs::utils
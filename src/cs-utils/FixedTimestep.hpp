@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_FIXED_TIMESTEP_HPP
+#define CS_UTILS_FIXED_TIMESTEP_HPP
+
+#include <algorithm>
+#include <cstdint>
+
+namespace cs::utils {
+
+/// This decouples a simulation from the frame rate. Each frame, advance() is called with the
+/// current time and it returns how many steps of the fixed step size should be simulated. The
+/// remainder is carried over to the next frame, so over time the simulation runs at exactly one
+/// step per step size, regardless of how long the individual frames take.
+///
+/// If the frames take very long, at most maxSteps steps are simulated per frame. The surplus time
+/// is dropped, so that a single hiccup does not result in a huge jump.
+class FixedTimestep {
+ public:
+  /// @param stepSize The simulated time per step in seconds.
+  /// @param maxSteps The maximum number of steps returned by a single call to advance().
+  explicit FixedTimestep(double stepSize, uint32_t maxSteps = 10)
+      : mStepSize(stepSize)
+      , mMaxSteps(maxSteps) {
+  }
+
+  /// Returns the number of steps which should be simulated to catch up with the given time. The
+  /// first call after construction or reset() returns zero, as there is no previous time to compare
+  /// with.
+  uint32_t advance(double time) {
+    if (mLastTime < 0.0) {
+      mLastTime = time;
+      return 0;
+    }
+
+    mAccumulator += std::max(time - mLastTime, 0.0);
+    mLastTime = time;
+
+    auto steps = static_cast<uint32_t>(mAccumulator / mStepSize);
+
+    if (steps > mMaxSteps) {
+      steps        = mMaxSteps;
+      mAccumulator = 0.0;
+    } else {
+      mAccumulator -= steps * mStepSize;
+    }
+
+    return steps;
+  }
+
+  /// The next call to advance() will not return any steps.
+  void reset() {
+    mLastTime    = -1.0;
+    mAccumulator = 0.0;
+  }
+
+  /// The fraction of a step which has been accumulated but not yet been simulated. This is in the
+  /// range [0...1) and can be used to extrapolate the simulated state to the actual time.
+  double getAlpha() const {
+    return mAccumulator / mStepSize;
+  }
+
+  double getStepSize() const {
+    return mStepSize;
+  }
+
+ private:
+  double   mStepSize;
+  uint32_t mMaxSteps;
+  double   mLastTime    = -1.0;
+  double   mAccumulator = 0.0;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_FIXED_TIMESTEP_HPP
@@ -0,0 +1,521 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_FLAT_HASH_MAP_HPP
+#define CS_UTILS_FLAT_HASH_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CS_UTILS_FLAT_HASH_MAP_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace cs::utils {
+
+/// A hash map which stores all elements in one contiguous array using open addressing. Compared to
+/// std::unordered_map, which allocates one node per element, lookups touch far fewer cache lines
+/// and inserting does not allocate unless the table grows.
+///
+/// The layout follows the well-known "Swiss table" design: For each slot, there is one control
+/// byte which is either empty, deleted or contains seven bits of the hash of the stored key. A
+/// lookup compares the control bytes of sixteen consecutive slots at once (with SSE2 if
+/// available) and only compares the keys of the slots whose control byte matches. Groups are
+/// probed quadratically.
+///
+/// The interface is a subset of std::unordered_map. There are some important differences:
+///  - Inserting may move all elements, so all iterators, pointers and references are invalidated
+///    by insertions. Erasing an element only invalidates iterators to this element, so elements
+///    can be erased while iterating.
+///  - The map cannot be copied.
+///  - The hash values are mixed internally, so identity hashes like std::hash<int> can be used.
+template <typename K, typename V, typename Hash = std::hash<K>,
+    typename KeyEqual = std::equal_to<K>>
+class FlatHashMap {
+ public:
+  using key_type    = K;
+  using mapped_type = V;
+  using value_type  = std::pair<K const, V>;
+  using size_type   = std::size_t;
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = FlatHashMap::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using pointer   = std::conditional_t<Const, value_type const*, value_type*>;
+    using reference = std::conditional_t<Const, value_type const&, value_type&>;
+    using map_type  = std::conditional_t<Const, FlatHashMap const, FlatHashMap>;
+
+    Iterator() = default;
+
+    Iterator(map_type* map, std::size_t index)
+        : mMap(map)
+        , mIndex(index) {
+    }
+
+    /// Allows converting an iterator to a const_iterator.
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    Iterator(Iterator<false> const& other) // NOLINT(google-explicit-constructor)
+        : mMap(other.mMap)
+        , mIndex(other.mIndex) {
+    }
+
+    reference operator*() const {
+      return mMap->mSlots[mIndex];
+    }
+
+    pointer operator->() const {
+      return &mMap->mSlots[mIndex];
+    }
+
+    Iterator& operator++() {
+      mIndex = mMap->nextFull(mIndex + 1);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(Iterator const& other) const {
+      return mIndex == other.mIndex;
+    }
+
+    bool operator!=(Iterator const& other) const {
+      return mIndex != other.mIndex;
+    }
+
+   private:
+    friend class FlatHashMap;
+    friend class Iterator<!Const>;
+
+    map_type*   mMap   = nullptr;
+    std::size_t mIndex = 0;
+  };
+
+  using iterator       = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+
+  FlatHashMap(FlatHashMap const& other) = delete;
+  FlatHashMap& operator=(FlatHashMap const& other) = delete;
+
+  FlatHashMap(FlatHashMap&& other) noexcept {
+    swap(other);
+  }
+
+  FlatHashMap& operator=(FlatHashMap&& other) noexcept {
+    if (this != &other) {
+      FlatHashMap tmp(std::move(other));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  ~FlatHashMap() {
+    destroyAll();
+    deallocate();
+  }
+
+  iterator begin() {
+    return iterator(this, nextFull(0));
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, nextFull(0));
+  }
+
+  iterator end() {
+    return iterator(this, mCapacity);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, mCapacity);
+  }
+
+  std::size_t size() const {
+    return mSize;
+  }
+
+  bool empty() const {
+    return mSize == 0;
+  }
+
+  /// The number of slots. The table grows once more than 7/8 of them are used.
+  std::size_t capacity() const {
+    return mCapacity;
+  }
+
+  /// Ensures that the given number of elements can be stored without growing the table.
+  void reserve(std::size_t count) {
+    std::size_t capacity = mCapacity == 0 ? GROUP_WIDTH : mCapacity;
+    while (count > getMaxLoad(capacity)) {
+      capacity *= 2;
+    }
+
+    if (capacity != mCapacity) {
+      rehash(capacity);
+    }
+  }
+
+  /// Removes all elements. The capacity is kept.
+  void clear() {
+    destroyAll();
+
+    if (mCapacity > 0) {
+      std::memset(mCtrl, CTRL_EMPTY, mCapacity + GROUP_WIDTH);
+    }
+
+    mSize    = 0;
+    mDeleted = 0;
+  }
+
+  iterator find(K const& key) {
+    return iterator(this, findIndex(key));
+  }
+
+  const_iterator find(K const& key) const {
+    return const_iterator(this, findIndex(key));
+  }
+
+  std::size_t count(K const& key) const {
+    return findIndex(key) == mCapacity ? 0 : 1;
+  }
+
+  bool contains(K const& key) const {
+    return findIndex(key) != mCapacity;
+  }
+
+  /// Returns the value stored for the given key. Throws a std::out_of_range if there is none.
+  V& at(K const& key) {
+    std::size_t index = findIndex(key);
+    if (index == mCapacity) {
+      throw std::out_of_range("There is no element with the given key in the FlatHashMap!");
+    }
+    return mSlots[index].second;
+  }
+
+  V const& at(K const& key) const {
+    std::size_t index = findIndex(key);
+    if (index == mCapacity) {
+      throw std::out_of_range("There is no element with the given key in the FlatHashMap!");
+    }
+    return mSlots[index].second;
+  }
+
+  /// Inserts a value constructed from the given arguments if there is no element with the given
+  /// key yet. Returns an iterator to the element with this key and whether it has been inserted.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(K const& key, Args&&... args) {
+    std::size_t hash  = getHash(key);
+    std::size_t index = findIndex(key, hash);
+
+    if (index != mCapacity) {
+      return {iterator(this, index), false};
+    }
+
+    if (mSize + mDeleted + 1 > getMaxLoad(mCapacity)) {
+      // If many slots are occupied by deleted elements, the table is rehashed with the same size.
+      rehash(mSize + 1 > getMaxLoad(mCapacity) / 2 ? std::max(mCapacity * 2, GROUP_WIDTH)
+                                                   : mCapacity);
+    }
+
+    index = findInsertIndex(hash);
+
+    new (&mSlots[index]) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+
+    if (mCtrl[index] == CTRL_DELETED) {
+      --mDeleted;
+    }
+
+    setCtrl(index, getH2(hash));
+    ++mSize;
+
+    return {iterator(this, index), true};
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(K const& key, Args&&... args) {
+    return try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  V& operator[](K const& key) {
+    return try_emplace(key).first->second;
+  }
+
+  /// Removes the element the iterator points to and returns an iterator to the next element.
+  iterator erase(const_iterator it) {
+    eraseIndex(it.mIndex);
+    return iterator(this, nextFull(it.mIndex + 1));
+  }
+
+  iterator erase(iterator it) {
+    return erase(const_iterator(it));
+  }
+
+  /// Removes the element with the given key. Returns the number of removed elements.
+  std::size_t erase(K const& key) {
+    std::size_t index = findIndex(key);
+
+    if (index == mCapacity) {
+      return 0;
+    }
+
+    eraseIndex(index);
+    return 1;
+  }
+
+  void swap(FlatHashMap& other) noexcept {
+    std::swap(mCtrl, other.mCtrl);
+    std::swap(mSlots, other.mSlots);
+    std::swap(mCapacity, other.mCapacity);
+    std::swap(mSize, other.mSize);
+    std::swap(mDeleted, other.mDeleted);
+  }
+
+ private:
+  // The number of control bytes which are compared at once.
+  static constexpr std::size_t GROUP_WIDTH = 16;
+
+  // Full slots store the lower seven bits of the hash, so their control byte is never negative.
+  static constexpr int8_t CTRL_EMPTY   = -128;
+  static constexpr int8_t CTRL_DELETED = -2;
+
+  /// Bit masks of the slots in a group which match a given criterion.
+  class Group {
+   public:
+    explicit Group(int8_t const* ctrl) {
+#ifdef CS_UTILS_FLAT_HASH_MAP_SSE2
+      mCtrl = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ctrl));
+#else
+      std::memcpy(mCtrl, ctrl, GROUP_WIDTH);
+#endif
+    }
+
+    uint32_t match(int8_t value) const {
+#ifdef CS_UTILS_FLAT_HASH_MAP_SSE2
+      return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), mCtrl)));
+#else
+      uint32_t result = 0;
+      for (std::size_t i = 0; i < GROUP_WIDTH; ++i) {
+        result |= static_cast<uint32_t>(mCtrl[i] == value) << i;
+      }
+      return result;
+#endif
+    }
+
+    uint32_t matchEmpty() const {
+      return match(CTRL_EMPTY);
+    }
+
+    /// Empty and deleted slots are the only ones with a control byte smaller than -1.
+    uint32_t matchEmptyOrDeleted() const {
+#ifdef CS_UTILS_FLAT_HASH_MAP_SSE2
+      return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), mCtrl)));
+#else
+      uint32_t result = 0;
+      for (std::size_t i = 0; i < GROUP_WIDTH; ++i) {
+        result |= static_cast<uint32_t>(mCtrl[i] < -1) << i;
+      }
+      return result;
+#endif
+    }
+
+   private:
+#ifdef CS_UTILS_FLAT_HASH_MAP_SSE2
+    __m128i mCtrl;
+#else
+    int8_t mCtrl[GROUP_WIDTH];
+#endif
+  };
+
+  static std::size_t countTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<std::size_t>(__builtin_ctz(mask));
+#endif
+  }
+
+  static std::size_t getMaxLoad(std::size_t capacity) {
+    return capacity - capacity / 8;
+  }
+
+  /// The result of the user-provided hash function is mixed, so that both the upper bits used for
+  /// the probe position and the lower bits stored in the control bytes are well distributed.
+  std::size_t getHash(K const& key) const {
+    uint64_t hash = static_cast<uint64_t>(Hash{}(key));
+    hash ^= hash >> 33U;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33U;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33U;
+    return static_cast<std::size_t>(hash);
+  }
+
+  static int8_t getH2(std::size_t hash) {
+    return static_cast<int8_t>(hash & 0x7FU);
+  }
+
+  static std::size_t getH1(std::size_t hash) {
+    return hash >> 7U;
+  }
+
+  std::size_t findIndex(K const& key) const {
+    return findIndex(key, getHash(key));
+  }
+
+  /// Returns mCapacity if there is no element with the given key.
+  std::size_t findIndex(K const& key, std::size_t hash) const {
+    if (mCapacity == 0) {
+      return mCapacity;
+    }
+
+    std::size_t const mask = mCapacity - 1;
+    std::size_t       pos  = getH1(hash) & mask;
+    int8_t const      h2   = getH2(hash);
+
+    for (std::size_t probe = 1;; ++probe) {
+      Group group(mCtrl + pos);
+
+      for (uint32_t matches = group.match(h2); matches != 0; matches &= matches - 1) {
+        std::size_t index = (pos + countTrailingZeros(matches)) & mask;
+        if (KeyEqual{}(mSlots[index].first, key)) {
+          return index;
+        }
+      }
+
+      // The key would have been inserted into the first empty slot.
+      if (group.matchEmpty() != 0 || probe * GROUP_WIDTH > mCapacity) {
+        return mCapacity;
+      }
+
+      pos = (pos + probe * GROUP_WIDTH) & mask;
+    }
+  }
+
+  /// Returns the first empty or deleted slot on the probe sequence of the given hash. There has
+  /// to be at least one such slot.
+  std::size_t findInsertIndex(std::size_t hash) const {
+    std::size_t const mask = mCapacity - 1;
+    std::size_t       pos  = getH1(hash) & mask;
+
+    for (std::size_t probe = 1;; ++probe) {
+      uint32_t candidates = Group(mCtrl + pos).matchEmptyOrDeleted();
+
+      if (candidates != 0) {
+        return (pos + countTrailingZeros(candidates)) & mask;
+      }
+
+      pos = (pos + probe * GROUP_WIDTH) & mask;
+    }
+  }
+
+  /// Returns the index of the first full slot at or after the given index, or mCapacity.
+  std::size_t nextFull(std::size_t index) const {
+    while (index < mCapacity && mCtrl[index] < 0) {
+      ++index;
+    }
+    return index;
+  }
+
+  /// The first GROUP_WIDTH control bytes are mirrored at the end of the array, so that groups can
+  /// be loaded at any position without wrapping around.
+  void setCtrl(std::size_t index, int8_t value) {
+    mCtrl[index]                                                   = value;
+    mCtrl[((index - GROUP_WIDTH) & (mCapacity - 1)) + GROUP_WIDTH] = value;
+  }
+
+  void eraseIndex(std::size_t index) {
+    mSlots[index].~value_type();
+    setCtrl(index, CTRL_DELETED);
+    --mSize;
+    ++mDeleted;
+  }
+
+  void rehash(std::size_t capacity) {
+    int8_t*     oldCtrl     = mCtrl;
+    value_type* oldSlots    = mSlots;
+    std::size_t oldCapacity = mCapacity;
+
+    mCapacity = capacity;
+    mCtrl     = new int8_t[mCapacity + GROUP_WIDTH];
+    mSlots    = static_cast<value_type*>(
+        ::operator new(sizeof(value_type) * mCapacity, std::align_val_t(alignof(value_type))));
+    mDeleted  = 0;
+
+    std::memset(mCtrl, CTRL_EMPTY, mCapacity + GROUP_WIDTH);
+
+    for (std::size_t i = 0; i < oldCapacity; ++i) {
+      if (oldCtrl[i] >= 0) {
+        std::size_t hash  = getHash(oldSlots[i].first);
+        std::size_t index = findInsertIndex(hash);
+
+        new (&mSlots[index]) value_type(std::move(oldSlots[i]));
+        oldSlots[i].~value_type();
+        setCtrl(index, getH2(hash));
+      }
+    }
+
+    delete[] oldCtrl;
+    ::operator delete(oldSlots, std::align_val_t(alignof(value_type)));
+  }
+
+  void destroyAll() {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      for (std::size_t i = 0; i < mCapacity; ++i) {
+        if (mCtrl[i] >= 0) {
+          mSlots[i].~value_type();
+        }
+      }
+    }
+  }
+
+  void deallocate() {
+    delete[] mCtrl;
+    ::operator delete(mSlots, std::align_val_t(alignof(value_type)));
+    mCtrl     = nullptr;
+    mSlots    = nullptr;
+    mCapacity = 0;
+  }
+
+  int8_t*     mCtrl     = nullptr;
+  value_type* mSlots    = nullptr;
+  std::size_t mCapacity = 0;
+  std::size_t mSize     = 0;
+  std::size_t mDeleted  = 0;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_FLAT_HASH_MAP_HPP
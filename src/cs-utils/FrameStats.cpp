@@ -7,44 +7,293 @@
 
 #include "FrameStats.hpp"
 
+#include "Metrics.hpp"
 #include "logger.hpp"
 
 #include <GL/glew.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 
 namespace cs::utils {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-FrameStats::ScopedTimer::ScopedTimer(std::string name, TimerMode mode)
-    : mID(FrameStats::get().startTimerQuery(std::move(name), mode)) {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// All interned names. The deque does not move its elements when growing, so the references returned
+// by FrameStats::getName() stay valid. The map uses a transparent comparator so that it can be
+// searched with a std::string_view without creating a temporary std::string. The owner of each
+// name is stored at the same index as the name.
+struct NameTable {
+  std::mutex                                              mMutex;
+  std::deque<std::string>                                 mNames;
+  std::deque<std::optional<FrameStats::TimerId>>          mOwners;
+  std::map<std::string, FrameStats::TimerId, std::less<>> mIds;
+};
+
+NameTable& getNameTable() {
+  static NameTable table;
+  return table;
+}
+
+// The owner given to the innermost FrameStats::ScopedOwner of each thread.
+thread_local std::optional<FrameStats::TimerId> tCurrentOwner;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A range of any thread as seen by FrameStats::accumulateOwnerTimes().
+struct OwnedRange {
+  std::optional<FrameStats::TimerId> mOwner;
+  uint32_t                           mNestingLevel{};
+  int64_t                            mStart{};
+  int64_t                            mDuration{};
+};
+
+// Calls the given function for each range which belongs to an owner and which is not nested into a
+// range of the same owner. The ranges have to be sorted by their start time.
+template <typename F>
+void forEachOutermostRange(std::vector<OwnedRange> const& ranges, F&& f) {
+
+  // The owners of the currently open ranges, one for each nesting level. An unowned range inherits
+  // the owner of its parent.
+  std::vector<std::optional<FrameStats::TimerId>> stack;
+
+  for (auto const& range : ranges) {
+    stack.resize(std::min(stack.size(), static_cast<std::size_t>(range.mNestingLevel)));
+
+    auto parent = stack.empty() ? std::nullopt : stack.back();
+    bool nested = range.mOwner &&
+                  std::find(stack.begin(), stack.end(), range.mOwner) != stack.end();
+
+    if (range.mOwner && !nested) {
+      f(*range.mOwner, range.mDuration);
+    }
+
+    stack.resize(range.mNestingLevel, std::nullopt);
+    stack.push_back(range.mOwner ? range.mOwner : parent);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Each thread other than the main thread records its ranges into one of these. The ring buffer is
+// only written by the owning thread and only read by the main thread, so the head and tail indices
+// are all the synchronization needed. If the ring buffer is full, new ranges are discarded.
+struct ThreadBuffer {
+  static constexpr std::size_t CAPACITY = 1024;
+
+  std::array<FrameStats::ThreadTimerResult, CAPACITY> mRing{};
+  std::atomic<uint64_t>                                mHead{};
+  std::atomic<uint64_t>                                mTail{};
+  std::atomic<uint64_t>                                mDropped{};
+
+  // The TimerIds and start times of the currently running ranges. This is only accessed by the
+  // owning thread.
+  std::vector<std::pair<FrameStats::TimerId, int64_t>> mOpenRanges;
+
+  // This is protected by the mutex of the ThreadRegistry.
+  std::string mName;
+};
+
+// The buffers of all threads which have recorded at least one range. The registry keeps the buffers
+// of finished threads alive until their remaining ranges have been collected.
+struct ThreadRegistry {
+  std::mutex                                 mMutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> mBuffers;
+  uint32_t                                   mThreadCount{};
+};
+
+ThreadRegistry& getThreadRegistry() {
+  static ThreadRegistry registry;
+  return registry;
+}
+
+// The name given with FrameStats::setThreadName(). The buffer is only created once the thread
+// records its first range, as most threads will never do this.
+thread_local std::string                   tThreadName;
+thread_local std::shared_ptr<ThreadBuffer> tThreadBuffer;
+
+// This is set in the constructor of FrameStats. Before, no timings are recorded in any thread.
+std::atomic<std::thread::id> sMainThread{std::thread::id{}};
+
+// The pEnableMeasurements property must not be accessed from other threads, so its value is
+// mirrored here.
+std::atomic<bool> sEnableThreadMeasurements{false};
+
+ThreadBuffer& getThreadBuffer() {
+  if (!tThreadBuffer) {
+    tThreadBuffer = std::make_shared<ThreadBuffer>();
+    tThreadBuffer->mOpenRanges.reserve(32);
+
+    auto&                        registry = getThreadRegistry();
+    std::unique_lock<std::mutex> lock(registry.mMutex);
+    ++registry.mThreadCount;
+    tThreadBuffer->mName =
+        tThreadName.empty() ? "Thread " + std::to_string(registry.mThreadCount) : tThreadName;
+    registry.mBuffers.push_back(tThreadBuffer);
+  }
+
+  return *tThreadBuffer;
+}
+
+int64_t getCPUTime() {
+  return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+}
+
+bool isMainThread() {
+  return std::this_thread::get_id() == sMainThread.load(std::memory_order_relaxed);
+}
+
+int32_t startThreadTimer(FrameStats::TimerId id) {
+  auto& buffer = getThreadBuffer();
+  buffer.mOpenRanges.emplace_back(id, getCPUTime());
+  return static_cast<int32_t>(buffer.mOpenRanges.size() - 1);
+}
+
+void endThreadTimer(int32_t nestingLevel) {
+  if (nestingLevel < 0 || !tThreadBuffer ||
+      nestingLevel != static_cast<int32_t>(tThreadBuffer->mOpenRanges.size()) - 1) {
+    return;
+  }
+
+  auto& buffer     = *tThreadBuffer;
+  auto [id, start] = buffer.mOpenRanges.back();
+  buffer.mOpenRanges.pop_back();
+
+  uint64_t head = buffer.mHead.load(std::memory_order_relaxed);
+  if (head - buffer.mTail.load(std::memory_order_acquire) >= ThreadBuffer::CAPACITY) {
+    buffer.mDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  buffer.mRing.at(head % ThreadBuffer::CAPACITY) = {
+      id, static_cast<uint32_t>(nestingLevel), start, getCPUTime()};
+  buffer.mHead.store(head + 1, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The frame time and the timings of the individual ranges are published to the Metrics. The
+// samples of each range are only looked up once. This is only accessed by the main thread.
+struct RangeMetrics {
+  Metrics::Sample* mCPUTime{};
+  Metrics::Sample* mGPUTime{};
+  double           mCPUSum{};
+  double           mGPUSum{};
+  uint64_t         mFrame{};
+};
+
+struct FrameMetrics {
+  Metrics::Sample& mFrames = Metrics::get().getSample(
+      "cosmoscout_frames_total", Metrics::Type::eCounter, "The number of rendered frames.");
+  Metrics::Sample& mFrameTime = Metrics::get().getSample("cosmoscout_frame_time_seconds",
+      Metrics::Type::eGauge, "The maximum of the CPU and the GPU time of the last measured frame.");
+
+  std::unordered_map<FrameStats::TimerId, RangeMetrics> mRanges;
+  uint64_t                                              mFrameCount{};
+};
+
+FrameMetrics& getFrameMetrics() {
+  static FrameMetrics metrics;
+  return metrics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COSMOSCOUT_DISABLE_FRAME_STATS
+
+FrameStats::ScopedTimer::ScopedTimer(std::string_view name, TimerMode mode)
+    : mID(-1)
+    , mIsMainThread(isMainThread())
+#ifdef COSMOSCOUT_TRACING
+    , mZone(name)
+#endif
+{
+
+  // The name is only interned if the range is actually recorded.
+  if (mIsMainThread && FrameStats::get().pEnableMeasurements.get()) {
+    mID = FrameStats::get().startTimerQuery(FrameStats::intern(name), mode);
+  } else if (!mIsMainThread && sEnableThreadMeasurements.load(std::memory_order_relaxed)) {
+    mID = startThreadTimer(FrameStats::intern(name));
+  }
+}
+
+FrameStats::ScopedTimer::ScopedTimer(TimerId id, TimerMode mode)
+    : mID(-1)
+    , mIsMainThread(isMainThread())
+#ifdef COSMOSCOUT_TRACING
+    , mZone(FrameStats::getName(id))
+#endif
+{
+
+  if (mIsMainThread) {
+    mID = FrameStats::get().startTimerQuery(id, mode);
+  } else if (sEnableThreadMeasurements.load(std::memory_order_relaxed)) {
+    mID = startThreadTimer(id);
+  }
 }
 
 FrameStats::ScopedTimer::~ScopedTimer() {
-  FrameStats::get().endTimerQuery(mID);
+  if (mIsMainThread) {
+    FrameStats::get().endTimerQuery(mID);
+  } else {
+    endThreadTimer(mID);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-FrameStats::ScopedSamplesCounter::ScopedSamplesCounter(std::string name)
-    : mID(FrameStats::get().startSamplesQuery(std::move(name))) {
+// The counters use OpenGL queries, so they do nothing outside of the main thread.
+
+FrameStats::ScopedSamplesCounter::ScopedSamplesCounter(std::string_view name)
+    : mID(isMainThread() && FrameStats::get().pEnableMeasurements.get()
+              ? FrameStats::get().startSamplesQuery(FrameStats::intern(name))
+              : -1) {
+}
+
+FrameStats::ScopedSamplesCounter::ScopedSamplesCounter(TimerId id)
+    : mID(isMainThread() ? FrameStats::get().startSamplesQuery(id) : -1) {
 }
 
 FrameStats::ScopedSamplesCounter::~ScopedSamplesCounter() {
-  FrameStats::get().endSamplesQuery(mID);
+  if (mID >= 0) {
+    FrameStats::get().endSamplesQuery(mID);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-FrameStats::ScopedPrimitivesCounter::ScopedPrimitivesCounter(std::string name)
-    : mID(FrameStats::get().startPrimitivesQuery(std::move(name))) {
+FrameStats::ScopedPrimitivesCounter::ScopedPrimitivesCounter(std::string_view name)
+    : mID(isMainThread() && FrameStats::get().pEnableMeasurements.get()
+              ? FrameStats::get().startPrimitivesQuery(FrameStats::intern(name))
+              : -1) {
+}
+
+FrameStats::ScopedPrimitivesCounter::ScopedPrimitivesCounter(TimerId id)
+    : mID(isMainThread() ? FrameStats::get().startPrimitivesQuery(id) : -1) {
 }
 
 FrameStats::ScopedPrimitivesCounter::~ScopedPrimitivesCounter() {
-  FrameStats::get().endPrimitivesQuery(mID);
+  if (mID >= 0) {
+    FrameStats::get().endPrimitivesQuery(mID);
+  }
 }
 
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 FrameStats& FrameStats::get() {
@@ -54,8 +303,228 @@ FrameStats& FrameStats::get() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-FrameStats::FrameStats() {
+FrameStats::TimerId FrameStats::intern(std::string_view name) {
+  auto&                        table = getNameTable();
+  std::unique_lock<std::mutex> lock(table.mMutex);
+
+  // Names which have been interned before are only attributed to the current owner if they do not
+  // have an owner yet.
+  auto it = table.mIds.find(name);
+  if (it != table.mIds.end()) {
+    auto& owner = table.mOwners.at(static_cast<std::size_t>(it->second));
+    if (!owner) {
+      owner = tCurrentOwner;
+    }
+    return it->second;
+  }
+
+  auto id = static_cast<TimerId>(table.mNames.size());
+  table.mNames.emplace_back(name);
+  table.mOwners.emplace_back(tCurrentOwner);
+  table.mIds.emplace(table.mNames.back(), id);
+
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& FrameStats::getName(TimerId id) {
+  auto&                        table = getNameTable();
+  std::unique_lock<std::mutex> lock(table.mMutex);
+  return table.mNames.at(static_cast<std::size_t>(id));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameStats::ScopedOwner::ScopedOwner(std::string_view owner)
+    : mPreviousOwner(tCurrentOwner) {
+
+  // The owner's name is interned before it becomes the current owner, so that it does not own
+  // itself.
+  auto id       = FrameStats::intern(owner);
+  tCurrentOwner = id;
+}
+
+FrameStats::ScopedOwner::ScopedOwner(std::optional<TimerId> owner)
+    : mPreviousOwner(tCurrentOwner) {
+  tCurrentOwner = owner;
+}
+
+FrameStats::ScopedOwner::~ScopedOwner() {
+  tCurrentOwner = mPreviousOwner;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameStats::setOwner(TimerId id, TimerId owner) {
+  auto&                        table = getNameTable();
+  std::unique_lock<std::mutex> lock(table.mMutex);
+  table.mOwners.at(static_cast<std::size_t>(id)) = owner;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<FrameStats::TimerId> FrameStats::getOwner(TimerId id) {
+  auto&                        table = getNameTable();
+  std::unique_lock<std::mutex> lock(table.mMutex);
+  return table.mOwners.at(static_cast<std::size_t>(id));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<FrameStats::TimerId> FrameStats::getCurrentOwner() {
+  return tCurrentOwner;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FrameStats::OwnerTimes> FrameStats::accumulateOwnerTimes(
+    std::vector<TimerQueryResult> const& results,
+    std::vector<ThreadTimerResults> const& threadResults) {
+
+  std::map<TimerId, OwnerTimes> owners;
+
+  auto getOwnerTimes = [&owners](TimerId owner) -> OwnerTimes& {
+    auto& times  = owners[owner];
+    times.mOwner = owner;
+    return times;
+  };
+
+  // The owners of all ranges are retrieved at once, so that the mutex is locked only once.
+  auto getOwners = [](auto const& ranges) {
+    auto&                        table = getNameTable();
+    std::unique_lock<std::mutex> lock(table.mMutex);
+
+    std::vector<std::optional<TimerId>> result;
+    result.reserve(ranges.size());
+    for (auto const& range : ranges) {
+      result.push_back(table.mOwners.at(static_cast<std::size_t>(range.mId)));
+    }
+    return result;
+  };
+
+  // The ranges of the main thread are stored in the order in which they were started. The CPU and
+  // GPU times are accumulated separately, as not all ranges measure both.
+  auto                    mainOwners = getOwners(results);
+  std::vector<OwnedRange> cpuRanges;
+  std::vector<OwnedRange> gpuRanges;
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    auto const& r = results[i];
+
+    if (r.mMode != TimerMode::eGPU) {
+      cpuRanges.push_back({mainOwners[i], r.mNestingLevel, r.mCPUStart, r.mCPUEnd - r.mCPUStart});
+    }
+
+    if (r.mMode != TimerMode::eCPU) {
+      gpuRanges.push_back({mainOwners[i], r.mNestingLevel, r.mGPUStart, r.mGPUEnd - r.mGPUStart});
+    }
+  }
+
+  forEachOutermostRange(cpuRanges,
+      [&](TimerId owner, int64_t duration) { getOwnerTimes(owner).mCPUTime += duration; });
+  forEachOutermostRange(gpuRanges,
+      [&](TimerId owner, int64_t duration) { getOwnerTimes(owner).mGPUTime += duration; });
+
+  // The ranges of the other threads are stored in the order in which they were completed, so they
+  // have to be sorted first. Parents start before or at the same time as their children.
+  for (auto const& thread : threadResults) {
+    auto                    threadOwners = getOwners(thread.mResults);
+    std::vector<OwnedRange> ranges;
+    ranges.reserve(thread.mResults.size());
+
+    for (std::size_t i = 0; i < thread.mResults.size(); ++i) {
+      auto const& r = thread.mResults[i];
+      ranges.push_back({threadOwners[i], r.mNestingLevel, r.mStart, r.mEnd - r.mStart});
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](OwnedRange const& a, OwnedRange const& b) {
+      return std::tie(a.mStart, a.mNestingLevel) < std::tie(b.mStart, b.mNestingLevel);
+    });
+
+    forEachOutermostRange(ranges,
+        [&](TimerId owner, int64_t duration) { getOwnerTimes(owner).mThreadTime += duration; });
+  }
+
+  std::vector<OwnerTimes> result;
+  result.reserve(owners.size());
+  for (auto const& [owner, times] : owners) {
+    result.push_back(times);
+  }
+
+  std::stable_sort(result.begin(), result.end(), [](OwnerTimes const& a, OwnerTimes const& b) {
+    return std::max(a.mCPUTime, a.mGPUTime) > std::max(b.mCPUTime, b.mGPUTime);
+  });
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameStats::setThreadName(std::string name) {
+  tThreadName = std::move(name);
+
+  if (tThreadBuffer) {
+    std::unique_lock<std::mutex> lock(getThreadRegistry().mMutex);
+    tThreadBuffer->mName = tThreadName;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameStats::collectThreadTimerResults(std::vector<ThreadTimerResults>& results) {
+  auto&                        registry = getThreadRegistry();
+  std::unique_lock<std::mutex> lock(registry.mMutex);
+
+  // The vectors are reused, so that no memory has to be allocated once they have grown large
+  // enough.
+  results.resize(registry.mBuffers.size());
+
+  for (std::size_t i = 0; i < registry.mBuffers.size(); ++i) {
+    auto& buffer = *registry.mBuffers[i];
+    auto& result = results[i];
+
+    if (result.mThreadName != buffer.mName) {
+      result.mThreadName = buffer.mName;
+    }
+
+    result.mResults.clear();
+
+    uint64_t tail = buffer.mTail.load(std::memory_order_relaxed);
+    uint64_t head = buffer.mHead.load(std::memory_order_acquire);
+
+    for (; tail < head; ++tail) {
+      result.mResults.push_back(buffer.mRing.at(tail % ThreadBuffer::CAPACITY));
+    }
+
+    buffer.mTail.store(tail, std::memory_order_release);
+    result.mDroppedResults = buffer.mDropped.load(std::memory_order_relaxed);
+  }
+
+  // If the registry holds the last reference to a buffer, its thread has finished. As all its
+  // ranges have been collected above, it can be removed.
+  registry.mBuffers.erase(std::remove_if(registry.mBuffers.begin(), registry.mBuffers.end(),
+                              [](auto const& buffer) { return buffer.use_count() == 1; }),
+      registry.mBuffers.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameStats::FrameStats()
+    : mFullFrameTimerId(intern("Process Frame")) {
+
+  // The thread which creates the singleton is considered to be the main thread.
+  sMainThread = std::this_thread::get_id();
+
   pEnableMeasurements.connectAndTouch([this](bool enable) {
+    sEnableThreadMeasurements = enable;
+
+    if (!enable) {
+      for (auto& results : mThreadTimerResults) {
+        results.clear();
+      }
+    }
+
     for (auto& pool : mQueryPools) {
       if (enable) {
         pool = std::make_unique<QueryPool>(512);
@@ -71,10 +540,20 @@ FrameStats::FrameStats() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void FrameStats::startFrame() {
+  CS_TRACE_FRAME_MARK();
 
   // Advance the timer pool triple-buffer by one.
   mCurrentQueryPool = (mCurrentQueryPool + 1) % mQueryPools.size();
 
+  // The ranges which other threads have completed since the last call belong to the frame of the
+  // previous pool.
+  auto& threadResults = mThreadTimerResults.at((mCurrentQueryPool + 2) % mQueryPools.size());
+  if (pEnableMeasurements.get()) {
+    collectThreadTimerResults(threadResults);
+  } else {
+    threadResults.clear();
+  }
+
   // Fetch the query results for the oldest pool in our triple buffer. From this the getRanges()
   // call will read this frame.
   auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
@@ -90,13 +569,71 @@ void FrameStats::startFrame() {
     pFrameTime   = std::max(gpuTime, cpuTime);
   }
 
+  updateMetrics(timerResults);
+
   // Reset the new current pool.
   auto const& pool = mQueryPools.at(mCurrentQueryPool);
   pool->reset();
 
   // Start the "root" full frame timing. This is always done, even if pEnableMeasurements is set to
   // false. This is required to get data for the pFrameTime property.
-  mFullFrameTimingID = pool->startTimerQuery("Process Frame", FrameStats::TimerMode::eBoth);
+  mFullFrameTimingID = pool->startTimerQuery(mFullFrameTimerId, FrameStats::TimerMode::eBoth);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameStats::updateMetrics(std::vector<TimerQueryResult> const& timerResults) const {
+  auto& metrics = getFrameMetrics();
+  ++metrics.mFrameCount;
+
+  metrics.mFrames.add(1.0);
+  metrics.mFrameTime.set(pFrameTime.get() * 0.001);
+
+  // The timings of the individual ranges are only available if measurements are enabled. Ranges
+  // which occur several times in one frame are accumulated.
+  double const toSeconds = 0.000000001;
+
+  for (auto const& result : timerResults) {
+    auto& range = metrics.mRanges[result.mId];
+
+    if (!range.mCPUTime && result.mMode != TimerMode::eGPU) {
+      range.mCPUTime = &Metrics::get().getSample("cosmoscout_frame_stats_cpu_seconds",
+          Metrics::Type::eGauge, "The CPU time of the ranges of the FrameStats.",
+          {{"range", getName(result.mId)}});
+    }
+
+    if (!range.mGPUTime && result.mMode != TimerMode::eCPU) {
+      range.mGPUTime = &Metrics::get().getSample("cosmoscout_frame_stats_gpu_seconds",
+          Metrics::Type::eGauge, "The GPU time of the ranges of the FrameStats.",
+          {{"range", getName(result.mId)}});
+    }
+
+    if (range.mFrame != metrics.mFrameCount) {
+      range.mCPUSum = 0.0;
+      range.mGPUSum = 0.0;
+      range.mFrame  = metrics.mFrameCount;
+    }
+
+    range.mCPUSum += static_cast<double>(result.mCPUEnd - result.mCPUStart) * toSeconds;
+    range.mGPUSum += static_cast<double>(result.mGPUEnd - result.mGPUStart) * toSeconds;
+  }
+
+  // Ranges which have not been measured in this frame are reported as zero.
+  for (auto& [id, range] : metrics.mRanges) {
+    if (range.mFrame != metrics.mFrameCount) {
+      range.mCPUSum = 0.0;
+      range.mGPUSum = 0.0;
+      range.mFrame  = metrics.mFrameCount;
+    }
+
+    if (range.mCPUTime) {
+      range.mCPUTime->set(range.mCPUSum);
+    }
+
+    if (range.mGPUTime) {
+      range.mGPUTime->set(range.mGPUSum);
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -110,11 +647,11 @@ void FrameStats::endFrame() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t FrameStats::startTimerQuery(std::string name, FrameStats::TimerMode mode) {
+int32_t FrameStats::startTimerQuery(TimerId id, FrameStats::TimerMode mode) {
 
   // Only attempt to start the timing if pEnableMeasurements is set to true.
   if (pEnableMeasurements.get()) {
-    return mQueryPools.at(mCurrentQueryPool)->startTimerQuery(std::move(name), mode);
+    return mQueryPools.at(mCurrentQueryPool)->startTimerQuery(id, mode);
   }
 
   return -1;
@@ -122,11 +659,11 @@ int32_t FrameStats::startTimerQuery(std::string name, FrameStats::TimerMode mode
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t FrameStats::startSamplesQuery(std::string name) {
+int32_t FrameStats::startSamplesQuery(TimerId id) {
 
   // Only attempt to start the counting if pEnableMeasurements is set to true.
   if (pEnableMeasurements.get()) {
-    return mQueryPools.at(mCurrentQueryPool)->startSamplesQuery(std::move(name));
+    return mQueryPools.at(mCurrentQueryPool)->startSamplesQuery(id);
   }
 
   return -1;
@@ -134,11 +671,11 @@ int32_t FrameStats::startSamplesQuery(std::string name) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t FrameStats::startPrimitivesQuery(std::string name) {
+int32_t FrameStats::startPrimitivesQuery(TimerId id) {
 
   // Only attempt to start the counting if pEnableMeasurements is set to true.
   if (pEnableMeasurements.get()) {
-    return mQueryPools.at(mCurrentQueryPool)->startPrimitivesQuery(std::move(name));
+    return mQueryPools.at(mCurrentQueryPool)->startPrimitivesQuery(id);
   }
 
   return -1;
@@ -203,6 +740,15 @@ std::vector<FrameStats::CounterQueryResult> const& FrameStats::getPrimitivesQuer
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::vector<FrameStats::ThreadTimerResults> const& FrameStats::getThreadTimerResults() const {
+
+  // We return the ranges from the last-but-one frame.
+  auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
+  return mThreadTimerResults.at(oldestPool);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 QueryPool::QueryPool(std::size_t queryAllocationBucketSize)
     : mQueryAllocationBucketSize(queryAllocationBucketSize) {
 
@@ -213,6 +759,10 @@ QueryPool::QueryPool(std::size_t queryAllocationBucketSize)
   glGenQueries(static_cast<GLsizei>(queryAllocationBucketSize), mTimerQueries.mQueries.data());
   glGenQueries(static_cast<GLsizei>(queryAllocationBucketSize), mSamplesQueries.mQueries.data());
   glGenQueries(static_cast<GLsizei>(queryAllocationBucketSize), mPrimitivesQueries.mQueries.data());
+
+  mTimerQueryResults.reserve(mQueryAllocationBucketSize);
+  mSamplesQueryResults.reserve(mQueryAllocationBucketSize);
+  mPrimitivesQueryResults.reserve(mQueryAllocationBucketSize);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -242,11 +792,11 @@ void QueryPool::reset() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t QueryPool::startTimerQuery(std::string name, FrameStats::TimerMode mode) {
+int32_t QueryPool::startTimerQuery(FrameStats::TimerId id, FrameStats::TimerMode mode) {
 
   FrameStats::TimerQueryResult result;
   result.mMode         = mode;
-  result.mName         = std::move(name);
+  result.mId           = id;
   result.mNestingLevel = mCurrentNestingLevel++;
 
   // Start the GPU result if necessary.
@@ -259,7 +809,7 @@ int32_t QueryPool::startTimerQuery(std::string name, FrameStats::TimerMode mode)
     result.mCPUStart = std::chrono::high_resolution_clock::now().time_since_epoch().count();
   }
 
-  mTimerQueryResults.push_back(std::move(result));
+  mTimerQueryResults.push_back(result);
 
   // Return the index at which this result was inserted.
   return static_cast<int32_t>(mTimerQueryResults.size() - 1);
@@ -267,12 +817,12 @@ int32_t QueryPool::startTimerQuery(std::string name, FrameStats::TimerMode mode)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t QueryPool::startSamplesQuery(std::string name) {
+int32_t QueryPool::startSamplesQuery(FrameStats::TimerId id) {
   FrameStats::CounterQueryResult result;
-  result.mName       = std::move(name);
+  result.mId         = id;
   result.mQueryIndex = startSamplesQuery();
 
-  mSamplesQueryResults.push_back(std::move(result));
+  mSamplesQueryResults.push_back(result);
 
   // Return the index at which this result was inserted.
   return static_cast<int32_t>(mSamplesQueryResults.size() - 1);
@@ -280,12 +830,12 @@ int32_t QueryPool::startSamplesQuery(std::string name) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t QueryPool::startPrimitivesQuery(std::string name) {
+int32_t QueryPool::startPrimitivesQuery(FrameStats::TimerId id) {
   FrameStats::CounterQueryResult result;
-  result.mName       = std::move(name);
+  result.mId         = id;
   result.mQueryIndex = startPrimitivesQuery();
 
-  mPrimitivesQueryResults.push_back(std::move(result));
+  mPrimitivesQueryResults.push_back(result);
 
   // Return the index at which this result was inserted.
   return static_cast<int32_t>(mPrimitivesQueryResults.size() - 1);
@@ -350,9 +900,13 @@ void QueryPool::fetchQueries() {
   waitForQueries(mPrimitivesQueries);
 
   // Get the query results.
-  std::vector<uint64_t> timerQueryResults      = getQueryResults(mTimerQueries);
-  std::vector<uint64_t> samplesQueryResults    = getQueryResults(mSamplesQueries);
-  std::vector<uint64_t> primitivesQueryResults = getQueryResults(mPrimitivesQueries);
+  getQueryResults(mTimerQueries);
+  getQueryResults(mSamplesQueries);
+  getQueryResults(mPrimitivesQueries);
+
+  auto const& timerQueryResults      = mTimerQueries.mResults;
+  auto const& samplesQueryResults    = mSamplesQueries.mResults;
+  auto const& primitivesQueryResults = mPrimitivesQueries.mResults;
 
   for (std::size_t i = 0; i < mTimerQueryResults.size(); ++i) {
     if (mTimerQueryResults[i].mMode == FrameStats::TimerMode::eGPU ||
@@ -450,13 +1004,11 @@ void QueryPool::waitForQueries(Queries const& queries) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<uint64_t> QueryPool::getQueryResults(Queries const& queries) const {
-  std::vector<uint64_t> results(queries.mNextID);
+void QueryPool::getQueryResults(Queries& queries) {
+  queries.mResults.resize(queries.mNextID);
   for (std::size_t i = 0; i < queries.mNextID; ++i) {
-    glGetQueryObjectui64v(queries.mQueries[i], GL_QUERY_RESULT, &results[i]);
+    glGetQueryObjectui64v(queries.mQueries[i], GL_QUERY_RESULT, &queries.mResults[i]);
   }
-
-  return results;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
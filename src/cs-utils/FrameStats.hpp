@@ -9,27 +9,51 @@
 #define CS_UTILS_FRAME_STATS_HPP
 
 #include "Property.hpp"
+#include "Tracing.hpp"
 #include "cs_utils_export.hpp"
 
 #include <array>
 #include <chrono>
 #include <memory>
 #include <optional>
-#include <unordered_map>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace cs::utils {
 
 class QueryPool;
 
-/// This is a singleton class which can be used in the main thread to record CPU und GPU timings as
-/// well as generated fragments and primitives. For the timing, this class actively supports
+/// This is a singleton class which can be used to record CPU und GPU timings as well as generated
+/// fragments and primitives. For the timing, this class actively supports
 /// measuring nested ranges so it's perfectively fine to start ranges for large parts of the code
 /// and multiple smaller subranges for smaller parts. To measure the time spent on the CPU or the
 /// GPU by a specific block of code, simply create a FrameStats::ScopedTimer. This will start a
 /// measuring range in its constructor and and end the range in its destructor.
 /// The ScopedSamplesCounter and the ScopedPrimitivesCounter do not support nesting, so you have to
 /// ensure that you do not start two of them at the same time.
+///
+/// GPU timings and counters are only recorded in the main thread, which is the thread that first
+/// calls FrameStats::get(). A ScopedTimer created in any other thread only measures the CPU time.
+/// Each thread records its ranges into a lock-free ring buffer of its own, these are collected by
+/// the main thread once per frame and can be accessed via getThreadTimerResults(). Use
+/// setThreadName() to give a thread a meaningful name; the workers of a ThreadPool are named after
+/// their pool.
+///
+/// The names of all timers and counters are interned: Each distinct name is stored only once and
+/// the recorded results only refer to it by a TimerId. If a name is assembled at runtime, for
+/// example by appending the name of an object, it should be interned once with FrameStats::intern()
+/// and the resulting TimerId should be passed to the ScopedTimer. This way, no memory is allocated
+/// while measuring.
+///
+/// Timers can be attributed to an owner, for example the plugin which created them. While a
+/// FrameStats::ScopedOwner exists, all timers which are interned or started in the same thread and
+/// do not have an owner yet are permanently attributed to this owner. Tasks of a ThreadPool inherit
+/// the owner of the thread which enqueued them. accumulateOwnerTimes() sums up the time spent by
+/// each owner in one frame.
+///
+/// If CosmoScout VR is configured with -DCOSMOSCOUT_FRAME_STATS=Off, the scoped timers and counters
+/// are compiled to empty objects. Only the full frame time is measured in this case.
 class CS_UTILS_EXPORT FrameStats {
  public:
   /// Defines which timings should be measured.
@@ -39,13 +63,17 @@ class CS_UTILS_EXPORT FrameStats {
     eBoth
   };
 
+  /// An interned name of a timer or counter. Use FrameStats::intern() to create one and
+  /// FrameStats::getName() to retrieve the name again.
+  enum class TimerId : uint32_t {};
+
   /// This struct contains information on one specific timing range. It is used internally by the
   /// FrameStats singleton and can be accessed via its getTimerQueryResults() method.
   struct TimerQueryResult {
 
-    /// The name of the range as it was passed to the constructor of the ScopedTimer or the
-    /// FrameStats::startRange() method.
-    std::string mName;
+    /// The interned name of the range as it was passed to the constructor of the ScopedTimer or the
+    /// FrameStats::startTimerQuery() method. Use FrameStats::getName() to retrieve the name.
+    TimerId mId{};
 
     /// This contains the number of timing ranges which were active when this range was started.
     uint32_t mNestingLevel{};
@@ -66,22 +94,53 @@ class CS_UTILS_EXPORT FrameStats {
     std::size_t mEndQueryIndex{};
   };
 
+  /// This struct contains information on one timing range recorded in a thread other than the main
+  /// thread. These only contain CPU timings.
+  struct ThreadTimerResult {
+    TimerId mId{};
+
+    /// This contains the number of timing ranges which were active in the same thread when this
+    /// range was started.
+    uint32_t mNestingLevel{};
+
+    /// Timestamps in nanoseconds when the range started / ended. These use the same clock as
+    /// TimerQueryResult::mCPUStart and TimerQueryResult::mCPUEnd.
+    int64_t mStart{};
+    int64_t mEnd{};
+  };
+
+  /// All ranges of one thread which have been completed during one frame.
+  struct ThreadTimerResults {
+    std::string                    mThreadName;
+    std::vector<ThreadTimerResult> mResults;
+
+    /// The number of ranges of this thread which have been discarded so far as its ring buffer was
+    /// full.
+    uint64_t mDroppedResults{};
+  };
+
   /// This struct contains information on one specific counting range. It is used internally by the
   /// FrameStats singleton and is returned by the getSamplesQueryResults and
   /// mgetPrimitivesQueryResults methods.
   struct CounterQueryResult {
-    std::string mName;
+    TimerId     mId{};
     int64_t     mCount{};
     std::size_t mQueryIndex{};
   };
 
   /// A ScopedTimer is responsible for measuring CPU and GPU times during its entire existence. The
-  /// timer will start measuring upon creation and stop measuring on deletion.
+  /// timer will start measuring upon creation and stop measuring on deletion. If an external
+  /// profiler is enabled in Tracing.hpp, each ScopedTimer also records a zone of the same name
+  /// (unless the FrameStats are compiled out with COSMOSCOUT_DISABLE_FRAME_STATS).
   class CS_UTILS_EXPORT ScopedTimer {
    public:
-    /// @param name The name of the counter.
-    /// @param mode The mode of querying. See CounterMode for more info.
-    explicit ScopedTimer(std::string name, TimerMode mode = TimerMode::eBoth);
+    /// @param name The name of the timer. This is interned if measurements are enabled.
+    /// @param mode The mode of querying. See TimerMode for more info.
+    explicit ScopedTimer(std::string_view name, TimerMode mode = TimerMode::eBoth);
+
+    /// @param id   The interned name of the timer.
+    /// @param mode The mode of querying. See TimerMode for more info.
+    explicit ScopedTimer(TimerId id, TimerMode mode = TimerMode::eBoth);
 
     ScopedTimer(ScopedTimer const& other) = delete;
     ScopedTimer(ScopedTimer&& other)      = delete;
@@ -92,7 +151,51 @@ class CS_UTILS_EXPORT FrameStats {
     ~ScopedTimer();
 
    private:
+#ifndef COSMOSCOUT_DISABLE_FRAME_STATS
     int32_t mID;
+    bool    mIsMainThread;
+#ifdef COSMOSCOUT_TRACING
+    tracing::ScopedZone mZone;
+#endif
+#endif
+  };
+
+  /// While a ScopedOwner exists, all timers which are interned or started in the same thread and
+  /// which do not have an owner yet are attributed to the given owner. The previous owner of the
+  /// thread is restored when the ScopedOwner is destroyed, so they can be nested. If std::nullopt
+  /// is given, timers are not attributed to anyone in the meantime.
+  class CS_UTILS_EXPORT ScopedOwner {
+   public:
+    /// @param owner The name of the owner, for example the name of a plugin. This is interned.
+    explicit ScopedOwner(std::string_view owner);
+
+    /// @param owner The interned name of the owner.
+    explicit ScopedOwner(std::optional<TimerId> owner);
+
+    ScopedOwner(ScopedOwner const& other) = delete;
+    ScopedOwner(ScopedOwner&& other)      = delete;
+
+    ScopedOwner& operator=(ScopedOwner const& other) = delete;
+    ScopedOwner& operator=(ScopedOwner&& other)      = delete;
+
+    ~ScopedOwner();
+
+   private:
+    std::optional<TimerId> mPreviousOwner;
+  };
+
+  /// The time attributed to one owner during one frame in nanoseconds. Use FrameStats::getName()
+  /// to retrieve the name of the owner.
+  struct OwnerTimes {
+    TimerId mOwner{};
+
+    /// The CPU and GPU time of all ranges of the main thread which belong to the owner.
+    int64_t mCPUTime{};
+    int64_t mGPUTime{};
+
+    /// The CPU time of all ranges of other threads which belong to the owner. This includes the
+    /// tasks of thread pools which have been enqueued by the owner.
+    int64_t mThreadTime{};
   };
 
   /// A ScopedSamplesCounter is responsible for counting generated fragments during its entire
@@ -100,7 +203,10 @@ class CS_UTILS_EXPORT FrameStats {
   class CS_UTILS_EXPORT ScopedSamplesCounter {
    public:
     /// @param name The name of the counter.
-    explicit ScopedSamplesCounter(std::string name);
+    explicit ScopedSamplesCounter(std::string_view name);
+
+    /// @param id The interned name of the counter.
+    explicit ScopedSamplesCounter(TimerId id);
 
     ScopedSamplesCounter(ScopedSamplesCounter const& other) = delete;
     ScopedSamplesCounter(ScopedSamplesCounter&& other)      = delete;
@@ -111,7 +217,9 @@ class CS_UTILS_EXPORT FrameStats {
     ~ScopedSamplesCounter();
 
    private:
+#ifndef COSMOSCOUT_DISABLE_FRAME_STATS
     int32_t mID;
+#endif
   };
 
   /// A ScopedPrimitivesCounter is responsible for counting generated primitives during its entire
@@ -119,7 +227,10 @@ class CS_UTILS_EXPORT FrameStats {
   class CS_UTILS_EXPORT ScopedPrimitivesCounter {
    public:
     /// @param name The name of the counter.
-    explicit ScopedPrimitivesCounter(std::string name);
+    explicit ScopedPrimitivesCounter(std::string_view name);
+
+    /// @param id The interned name of the counter.
+    explicit ScopedPrimitivesCounter(TimerId id);
 
     ScopedPrimitivesCounter(ScopedPrimitivesCounter const& other) = delete;
     ScopedPrimitivesCounter(ScopedPrimitivesCounter&& other)      = delete;
@@ -130,12 +241,48 @@ class CS_UTILS_EXPORT FrameStats {
     ~ScopedPrimitivesCounter();
 
    private:
+#ifndef COSMOSCOUT_DISABLE_FRAME_STATS
     int32_t mID;
+#endif
   };
 
   /// Access the singleton instance.
   static FrameStats& get();
 
+  /// Returns the TimerId for the given name. Calling this multiple times with the same name will
+  /// always return the same TimerId. Interned names are never released. This is thread-safe, so
+  /// objects can intern the names of their timers in their constructors.
+  ///
+  /// The owner of a timer is determined when its name is interned. Hence, objects created by a
+  /// plugin should intern their timers on construction, for example in the default member
+  /// initializer of a TimerId. As plugins are initialized within their ScopedOwner, such timers
+  /// are attributed to the plugin. A name interned later, for example during drawing, may remain
+  /// without an owner.
+  static TimerId intern(std::string_view name);
+
+  /// Returns the name which has been interned as the given TimerId. This is thread-safe.
+  static std::string const& getName(TimerId id);
+
+  /// Attributes the given timer to the given owner. This replaces any previous owner. See
+  /// ScopedOwner for a way to attribute timers automatically.
+  static void setOwner(TimerId id, TimerId owner);
+
+  /// Returns the owner of the given timer or std::nullopt if it has not been attributed to anyone.
+  static std::optional<TimerId> getOwner(TimerId id);
+
+  /// Returns the owner given to the innermost ScopedOwner of the calling thread.
+  static std::optional<TimerId> getCurrentOwner();
+
+  /// Sums up the durations of the given ranges per owner. Ranges which are nested into a range of
+  /// the same owner are not counted twice. Ranges without an owner are ignored. The result is
+  /// sorted by the maximum of the CPU and GPU time in descending order.
+  static std::vector<OwnerTimes> accumulateOwnerTimes(std::vector<TimerQueryResult> const& results,
+      std::vector<ThreadTimerResults> const& threadResults);
+
+  /// Sets the name under which the ranges of the calling thread are reported in
+  /// getThreadTimerResults(). If this is not called, threads are named "Thread <n>".
+  static void setThreadName(std::string name);
+
   /// To enable or disable time measuring globally.
   Property<bool> pEnableMeasurements = false;
 
@@ -164,9 +311,9 @@ class CS_UTILS_EXPORT FrameStats {
   /// ScopedTimer, ScopedSamplesCounter, and ScopedPrimitivesCounter are often more easy to use. The
   /// returned ID will be >= 0 if the timing range was actually started and -1 if
   /// pEnableMeasurements is set to false.
-  int32_t startTimerQuery(std::string name, TimerMode mode = TimerMode::eBoth);
-  int32_t startSamplesQuery(std::string name);
-  int32_t startPrimitivesQuery(std::string name);
+  int32_t startTimerQuery(TimerId id, TimerMode mode = TimerMode::eBoth);
+  int32_t startSamplesQuery(TimerId id);
+  int32_t startPrimitivesQuery(TimerId id);
 
   /// Stops the query with the given ID. You can use this interface, however the ScopedTimer,
   /// ScopedSamplesCounter, and ScopedPrimitivesCounter are often more easy to use.
@@ -185,7 +332,19 @@ class CS_UTILS_EXPORT FrameStats {
   std::vector<CounterQueryResult> const& getSamplesQueryResults();
   std::vector<CounterQueryResult> const& getPrimitivesQueryResults();
 
+  /// Returns the ranges of all other threads which have been completed during the same frame as the
+  /// results returned by getTimerQueryResults(). Some of these ranges may have been started in
+  /// an earlier frame. Threads which did not complete any range are included with an empty list of
+  /// results. This will be empty if pEnableMeasurements is set to false.
+  std::vector<ThreadTimerResults> const& getThreadTimerResults() const;
+
  private:
+  /// Moves the ranges recorded by other threads into the given list.
+  static void collectThreadTimerResults(std::vector<ThreadTimerResults>& results);
+
+  /// Publishes the frame time and the timings of the given results to the Metrics.
+  void updateMetrics(std::vector<TimerQueryResult> const& timerResults) const;
+
   /// You should not need to instantiate this class. One singleton instance can be created with the
   /// static get() method above.
   FrameStats();
@@ -195,14 +354,52 @@ class CS_UTILS_EXPORT FrameStats {
   int32_t                                   mCurrentQueryPool{};
 
   int32_t mFullFrameTimingID{};
+  TimerId mFullFrameTimerId{};
+
+  /// The ranges of the other threads are triple-buffered as well, so that they belong to the same
+  /// frame as the results of the QueryPools.
+  std::array<std::vector<ThreadTimerResults>, 3> mThreadTimerResults;
 };
 
+#ifdef COSMOSCOUT_DISABLE_FRAME_STATS
+
+// If the frame statistics are compiled out, the scoped timers and counters do nothing at all. As
+// these are defined inline, the compiler can remove them entirely.
+
+inline FrameStats::ScopedTimer::ScopedTimer(std::string_view /*name*/, TimerMode /*mode*/) {
+}
+
+inline FrameStats::ScopedTimer::ScopedTimer(TimerId /*id*/, TimerMode /*mode*/) {
+}
+
+inline FrameStats::ScopedTimer::~ScopedTimer() = default;
+
+inline FrameStats::ScopedSamplesCounter::ScopedSamplesCounter(std::string_view /*name*/) {
+}
+
+inline FrameStats::ScopedSamplesCounter::ScopedSamplesCounter(TimerId /*id*/) {
+}
+
+inline FrameStats::ScopedSamplesCounter::~ScopedSamplesCounter() = default;
+
+inline FrameStats::ScopedPrimitivesCounter::ScopedPrimitivesCounter(std::string_view /*name*/) {
+}
+
+inline FrameStats::ScopedPrimitivesCounter::ScopedPrimitivesCounter(TimerId /*id*/) {
+}
+
+inline FrameStats::ScopedPrimitivesCounter::~ScopedPrimitivesCounter() = default;
+
+#endif
+
 /// The QueryPool is used in a triple-buffer fashion internally by the FrameStats class. You
 /// will not need to use this class directly.
 class CS_UTILS_EXPORT QueryPool {
  public:
   /// The QueryPool will allocate queryAllocationBucketSize GPU timer query objects initially.
-  /// Whenever this amount is exhausted, a new batch of this size will be allocated.
+  /// Whenever this amount is exhausted, a new batch of this size will be allocated. The same amount
+  /// of results is reserved, as the result arrays are kept across reset() calls, no memory will be
+  /// allocated during a frame once the pool has grown large enough.
   QueryPool(std::size_t queryAllocationBucketSize);
 
   /// Do not try to copy this class!
@@ -219,9 +416,9 @@ class CS_UTILS_EXPORT QueryPool {
 
   /// Starts a new query. The returned integer will always be >= 0 and can be used to end the
   /// range with the method below.
-  int32_t startTimerQuery(std::string name, FrameStats::TimerMode mode);
-  int32_t startSamplesQuery(std::string name);
-  int32_t startPrimitivesQuery(std::string name);
+  int32_t startTimerQuery(FrameStats::TimerId id, FrameStats::TimerMode mode);
+  int32_t startSamplesQuery(FrameStats::TimerId id);
+  int32_t startPrimitivesQuery(FrameStats::TimerId id);
 
   /// Ends a previously started query. This will do nothing if the given id is invalid.
   void endTimerQuery(int32_t id);
@@ -242,14 +439,17 @@ class CS_UTILS_EXPORT QueryPool {
   struct Queries {
     std::vector<uint32_t> mQueries;
     std::size_t           mNextID{};
+
+    /// The results of the first mNextID queries. This is reused in each frame.
+    std::vector<uint64_t> mResults;
   };
 
   std::size_t startTimerQuery();
   std::size_t startSamplesQuery();
   std::size_t startPrimitivesQuery();
 
-  void                  waitForQueries(Queries const& queries) const;
-  std::vector<uint64_t> getQueryResults(Queries const& queries) const;
+  void waitForQueries(Queries const& queries) const;
+  void getQueryResults(Queries& queries);
 
   std::size_t mQueryAllocationBucketSize{};
 
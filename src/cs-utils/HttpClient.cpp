@@ -0,0 +1,512 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "HttpClient.hpp"
+
+#include "FrameStats.hpp"
+#include "Metrics.hpp"
+#include "logger.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <curl/multi.h>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Options.hpp>
+
+#include <algorithm>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// All requests share one connection cache as well as the DNS and TLS session caches of libcurl.
+// This way, connections to a server are kept alive and reused for subsequent requests, even if
+// these are made by different plugins or threads.
+class CurlShare {
+ public:
+  static CURLSH* get() {
+    static CurlShare instance;
+    return instance.mShare;
+  }
+
+  CurlShare(CurlShare const& other) = delete;
+  CurlShare(CurlShare&& other)      = delete;
+
+  CurlShare& operator=(CurlShare const& other) = delete;
+  CurlShare& operator=(CurlShare&& other)      = delete;
+
+  ~CurlShare() {
+    curl_share_cleanup(mShare);
+  }
+
+ private:
+  CurlShare()
+      : mShare(curl_share_init()) {
+    curl_share_setopt(mShare, CURLSHOPT_LOCKFUNC, &CurlShare::lock);
+    curl_share_setopt(mShare, CURLSHOPT_UNLOCKFUNC, &CurlShare::unlock);
+    curl_share_setopt(mShare, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+
+  static void lock(
+      CURL* /*unused*/, curl_lock_data data, curl_lock_access /*unused*/, void* userData) {
+    static_cast<CurlShare*>(userData)->mMutexes.at(data).lock();
+  }
+
+  static void unlock(CURL* /*unused*/, curl_lock_data data, void* userData) {
+    static_cast<CurlShare*>(userData)->mMutexes.at(data).unlock();
+  }
+
+  CURLSH*                                     mShare;
+  std::array<std::mutex, CURL_LOCK_DATA_LAST> mMutexes;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Configures the given handle to use the shared caches and to negotiate HTTP/2 where possible, so
+// that concurrent requests to one server are multiplexed over a single connection.
+void configureHandle(curlpp::Easy& handle) {
+  CURL* curl = handle.getHandle();
+  curl_easy_setopt(curl, CURLOPT_SHARE, CurlShare::get());
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Each thread keeps its curl handle alive. Resetting a handle clears all options but keeps open
+// connections.
+curlpp::Easy& getCurlHandle() {
+  thread_local curlpp::Easy handle;
+
+  handle.reset();
+  configureHandle(handle);
+
+  return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Sets all options of the given request. The received data is written to the given response and
+// the number of received bytes is accumulated in receivedBytes. The request, the response and the
+// counter have to outlive the transfer.
+void setupHandle(curlpp::Easy& handle, HttpClient::Request const& request,
+    HttpClient::Response& response, uint64_t& receivedBytes) {
+  handle.setOpt(curlpp::options::Url(request.mUrl));
+  handle.setOpt(curlpp::options::NoSignal(true));
+  handle.setOpt(curlpp::options::SslVerifyPeer(false));
+
+  handle.setOpt(curlpp::options::WriteFunction(
+      [&request, &response, &receivedBytes, &handle](char* data, size_t size, size_t items) {
+        std::size_t length = size * items;
+
+        if (request.mOutput) {
+          request.mOutput->write(data, static_cast<std::streamsize>(length));
+        } else {
+          // The headers have been received when the first chunk arrives, so the buffer can be
+          // allocated once with the announced size. This is -1 if the server does not send it.
+          if (response.mBody.empty()) {
+            curl_off_t total = -1;
+            curl_easy_getinfo(handle.getHandle(), CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &total);
+            response.mBody.reserve(std::max(
+                static_cast<std::size_t>(std::max(total, curl_off_t{0})), length));
+          }
+          response.mBody.append(data, length);
+        }
+
+        receivedBytes += length;
+        return length;
+      }));
+
+  handle.setOpt(curlpp::options::HeaderFunction(
+      [&response, &receivedBytes](char* data, size_t size, size_t items) {
+        std::string header(data, size * items);
+
+        // If redirects are followed, only the headers of the last response are kept.
+        if (boost::starts_with(header, "HTTP/")) {
+          response.mHeaders.clear();
+        }
+
+        std::size_t colon = header.find(':');
+        if (colon != std::string::npos) {
+          response.mHeaders[boost::to_lower_copy(boost::trim_copy(header.substr(0, colon)))] =
+              boost::trim_copy(header.substr(colon + 1));
+        }
+
+        receivedBytes += header.size();
+        return size * items;
+      }));
+
+  if (!request.mHeaders.empty()) {
+    handle.setOpt(curlpp::options::HttpHeader(
+        std::list<std::string>(request.mHeaders.begin(), request.mHeaders.end())));
+  }
+
+  if (request.mHeadOnly) {
+    handle.setOpt(curlpp::options::NoBody(true));
+  }
+
+  if (request.mIfModifiedSince) {
+    handle.setOpt(curlpp::options::TimeCondition(CURL_TIMECOND_IFMODSINCE));
+    handle.setOpt(curlpp::options::TimeValue(static_cast<long>(*request.mIfModifiedSince)));
+  }
+
+  if (request.mProgressCallback) {
+    handle.setOpt(curlpp::options::NoProgress(false));
+    handle.setOpt(curlpp::options::ProgressFunction(
+        [&request](double total, double now, double /*unused*/, double /*unused*/) {
+          return request.mProgressCallback(total, now) ? 1 : 0;
+        }));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Stores the response code and the content type of a completed transfer in the given response.
+void readResponseInfo(curlpp::Easy& handle, HttpClient::Response& response) {
+  curl_easy_getinfo(handle.getHandle(), CURLINFO_RESPONSE_CODE, &response.mResponseCode);
+
+  char* contentType = nullptr;
+  curl_easy_getinfo(handle.getHandle(), CURLINFO_CONTENT_TYPE, &contentType);
+  if (contentType) {
+    response.mContentType = contentType;
+    response.mContentType =
+        boost::trim_copy(response.mContentType.substr(0, response.mContentType.find(';')));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct HttpClient::Transfer {
+  Request      mRequest;
+  Callback     mCallback;
+  std::string  mHost;
+  curlpp::Easy mHandle;
+  Response     mResponse;
+  uint64_t     mReceivedBytes = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpClient& HttpClient::get() {
+  static HttpClient instance;
+  return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpClient::HttpClient()
+    : mMulti(curl_multi_init()) {
+  mMetricsCollector = Metrics::get().addCollector([this](Metrics& metrics) {
+    for (auto const& [host, stats] : getStatistics()) {
+      Metrics::Labels labels{{"host", host}};
+
+      metrics
+          .getSample("cosmoscout_http_active_requests", Metrics::Type::eGauge,
+              "The number of HTTP requests which are currently being performed.", labels)
+          .set(static_cast<double>(stats.mActiveRequests));
+      metrics
+          .getSample("cosmoscout_http_pending_requests", Metrics::Type::eGauge,
+              "The number of HTTP requests which are waiting for a free connection.", labels)
+          .set(static_cast<double>(std::accumulate(
+              stats.mPendingRequests.begin(), stats.mPendingRequests.end(), 0U)));
+      metrics
+          .getSample("cosmoscout_http_requests_total", Metrics::Type::eCounter,
+              "The number of completed HTTP requests, including failed ones.", labels)
+          .set(static_cast<double>(stats.mFinishedRequests));
+      metrics
+          .getSample("cosmoscout_http_failed_requests_total", Metrics::Type::eCounter,
+              "The number of HTTP requests which could not be performed.", labels)
+          .set(static_cast<double>(stats.mFailedRequests));
+      metrics
+          .getSample("cosmoscout_http_received_bytes_total", Metrics::Type::eCounter,
+              "The number of bytes received via HTTP.", labels)
+          .set(static_cast<double>(stats.mReceivedBytes));
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpClient::~HttpClient() {
+  Metrics::get().removeCollector(mMetricsCollector);
+
+  {
+    std::unique_lock<std::mutex> lock(mHostMutex);
+    mStopIoThread = true;
+  }
+
+  if (mIoThread.joinable()) {
+    curl_multi_wakeup(mMulti);
+    mIoThread.join();
+  }
+
+  mQueuedTransfers.clear();
+  curl_multi_cleanup(mMulti);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpClient::setMaxConnectionsPerHost(uint32_t count) {
+  if (count == 0) {
+    throw std::invalid_argument("The number of connections per host must be greater than zero!");
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mHostMutex);
+    mMaxConnectionsPerHost = count;
+  }
+
+  mHostCondition.notify_all();
+  curl_multi_wakeup(mMulti);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t HttpClient::getMaxConnectionsPerHost() const {
+  std::unique_lock<std::mutex> lock(mHostMutex);
+  return mMaxConnectionsPerHost;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpClient::Response HttpClient::perform(Request const& request) {
+  FrameStats::ScopedTimer timer("HTTP Request", FrameStats::TimerMode::eCPU);
+
+  std::string host = getHost(request.mUrl);
+
+  acquireConnection(host, request.mPriority);
+
+  Response response;
+  uint64_t receivedBytes = 0;
+
+  try {
+    curlpp::Easy& handle = getCurlHandle();
+    setupHandle(handle, request, response, receivedBytes);
+    handle.perform();
+    readResponseInfo(handle, response);
+  } catch (std::exception const& e) {
+    releaseConnection(host, receivedBytes, true);
+    throw std::runtime_error("HTTP request to '" + request.mUrl + "' failed: " + e.what());
+  }
+
+  releaseConnection(host, receivedBytes, false);
+
+  return response;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpClient::performAsync(Request request, Callback callback) {
+  auto transfer       = std::make_unique<Transfer>();
+  transfer->mHost     = getHost(request.mUrl);
+  transfer->mRequest  = std::move(request);
+  transfer->mCallback = std::move(callback);
+
+  {
+    std::unique_lock<std::mutex> lock(mHostMutex);
+
+    auto& stats = mHosts[transfer->mHost];
+    ++stats.mPendingRequests.at(static_cast<std::size_t>(transfer->mRequest.mPriority));
+
+    mQueuedTransfers.push_back(std::move(transfer));
+
+    if (!mIoThread.joinable()) {
+      mIoThread = std::thread([this]() { runIoThread(); });
+    }
+  }
+
+  curl_multi_wakeup(mMulti);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, HttpClient::HostStatistics> HttpClient::getStatistics() const {
+  std::unique_lock<std::mutex> lock(mHostMutex);
+  return mHosts;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string HttpClient::getHost(std::string const& url) {
+  std::size_t start  = url.find("://");
+  start              = start == std::string::npos ? 0 : start + 3;
+  std::size_t end    = url.find_first_of("/?#", start);
+  std::string result = url.substr(start, end == std::string::npos ? end : end - start);
+
+  // Remove any user information.
+  std::size_t at = result.rfind('@');
+  if (at != std::string::npos) {
+    result = result.substr(at + 1);
+  }
+
+  return boost::to_lower_copy(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpClient::acquireConnection(std::string const& host, Priority priority) {
+  std::unique_lock<std::mutex> lock(mHostMutex);
+
+  auto& stats = mHosts[host];
+  auto  index = static_cast<std::size_t>(priority);
+
+  ++stats.mPendingRequests.at(index);
+
+  mHostCondition.wait(lock, [this, &stats, index]() { return canStart(stats, index); });
+
+  --stats.mPendingRequests.at(index);
+  ++stats.mActiveRequests;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpClient::releaseConnection(std::string const& host, uint64_t receivedBytes, bool failed) {
+  {
+    std::unique_lock<std::mutex> lock(mHostMutex);
+
+    auto& stats = mHosts[host];
+    --stats.mActiveRequests;
+    ++stats.mFinishedRequests;
+    stats.mReceivedBytes += receivedBytes;
+
+    if (failed) {
+      ++stats.mFailedRequests;
+    }
+  }
+
+  // Both, waiting synchronous requests and queued asynchronous requests may use the connection.
+  mHostCondition.notify_all();
+  curl_multi_wakeup(mMulti);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool HttpClient::canStart(HostStatistics const& stats, std::size_t priorityIndex) const {
+
+  // A request may only start if no request of a higher priority class is waiting for this host.
+  return stats.mActiveRequests < mMaxConnectionsPerHost &&
+         std::accumulate(stats.mPendingRequests.begin(),
+             stats.mPendingRequests.begin() + static_cast<std::ptrdiff_t>(priorityIndex), 0U) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpClient::runIoThread() {
+  std::map<CURL*, std::unique_ptr<Transfer>> activeTransfers;
+
+  while (true) {
+    std::vector<std::unique_ptr<Transfer>> startedTransfers;
+
+    {
+      std::unique_lock<std::mutex> lock(mHostMutex);
+
+      if (mStopIoThread) {
+        break;
+      }
+
+      // Queued transfers are started in the order of their priority. Within one priority class,
+      // the oldest transfer is started first.
+      std::stable_sort(
+          mQueuedTransfers.begin(), mQueuedTransfers.end(), [](auto const& a, auto const& b) {
+            return a->mRequest.mPriority < b->mRequest.mPriority;
+          });
+
+      for (auto it = mQueuedTransfers.begin(); it != mQueuedTransfers.end();) {
+        auto& stats = mHosts[(*it)->mHost];
+        auto  index = static_cast<std::size_t>((*it)->mRequest.mPriority);
+
+        // The own request is not counted as waiting request of a higher priority class.
+        if (canStart(stats, index)) {
+          --stats.mPendingRequests.at(index);
+          ++stats.mActiveRequests;
+          startedTransfers.push_back(std::move(*it));
+          it = mQueuedTransfers.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    for (auto& transfer : startedTransfers) {
+      Transfer& t = *transfer;
+      configureHandle(t.mHandle);
+      setupHandle(t.mHandle, t.mRequest, t.mResponse, t.mReceivedBytes);
+      curl_multi_add_handle(mMulti, t.mHandle.getHandle());
+      activeTransfers.emplace(t.mHandle.getHandle(), std::move(transfer));
+    }
+
+    int running = 0;
+    curl_multi_perform(mMulti, &running);
+
+    int      remaining = 0;
+    CURLMsg* message   = nullptr;
+    while ((message = curl_multi_info_read(mMulti, &remaining))) {
+      if (message->msg != CURLMSG_DONE) {
+        continue;
+      }
+
+      // The message is invalidated by curl_multi_remove_handle(), so everything we need from it is
+      // copied first.
+      CURL*    handle = message->easy_handle;
+      CURLcode result = message->data.result;
+
+      auto it = activeTransfers.find(handle);
+      if (it == activeTransfers.end()) {
+        continue;
+      }
+
+      std::unique_ptr<Transfer> transfer = std::move(it->second);
+      activeTransfers.erase(it);
+      curl_multi_remove_handle(mMulti, handle);
+
+      std::exception_ptr error;
+      if (result == CURLE_OK) {
+        readResponseInfo(transfer->mHandle, transfer->mResponse);
+      } else {
+        error = std::make_exception_ptr(
+            std::runtime_error("HTTP request to '" + transfer->mRequest.mUrl +
+                               "' failed: " + curl_easy_strerror(result)));
+        transfer->mResponse = Response();
+      }
+
+      releaseConnection(transfer->mHost, transfer->mReceivedBytes, error != nullptr);
+
+      try {
+        transfer->mCallback(std::move(transfer->mResponse), error);
+      } catch (std::exception const& e) {
+        logger().warn("Callback of HTTP request to '{}' failed: {}", transfer->mRequest.mUrl,
+            e.what());
+      }
+    }
+
+    // This returns as soon as there is activity on any of the connections or when curl_multi_wakeup
+    // is called because a new transfer has been queued or a connection has been released.
+    curl_multi_poll(mMulti, nullptr, 0, 1000, nullptr);
+  }
+
+  // Transfers which are still running are dropped.
+  for (auto const& [easy, transfer] : activeTransfers) {
+    curl_multi_remove_handle(mMulti, easy);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
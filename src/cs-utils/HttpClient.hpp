@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_HTTP_CLIENT_HPP
+#define CS_UTILS_HTTP_CLIENT_HPP
+
+#include "ThreadPool.hpp"
+#include "cs_utils_export.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cs::utils {
+
+/// This is a singleton class through which all HTTP requests of CosmoScout VR and its plugins
+/// should be made. Requests can be performed synchronously on the calling thread with perform() or
+/// asynchronously with performAsync(). The latter are all driven by one I/O thread, so loaders do
+/// not have to block one of their worker threads while waiting for the network. Instead, they can
+/// continue processing the received data on their own thread pool once the callback is invoked.
+///
+/// All requests share one connection cache as well as the DNS and TLS session caches of libcurl.
+/// Each thread keeps its curl handle alive, so connections to a server are reused for subsequent
+/// requests, even if these are made by different plugins. HTTP/2 is negotiated where possible.
+///
+/// The number of concurrent requests to the same host is limited. If all slots of a host are
+/// taken, requests wait until one becomes free. Waiting requests of a higher priority always get
+/// the next free slot, so that for example the download of datasets cannot delay the loading of
+/// currently visible map tiles.
+///
+/// For each host, the number of requests and received bytes is recorded. See getStatistics(). These
+/// statistics are published to the Metrics as well.
+class CS_UTILS_EXPORT HttpClient {
+ public:
+  /// Once all connections to a host are used, waiting requests are started in the order of their
+  /// priority class. These are the same as those of the ThreadPool, so that the priority of a
+  /// loading task can be passed on to its requests.
+  using Priority = ThreadPool::Priority;
+
+  static constexpr std::size_t PRIORITY_COUNT = ThreadPool::PRIORITY_COUNT;
+
+  struct Request {
+    std::string mUrl;
+    Priority    mPriority = Priority::eNormal;
+
+    /// Additional request headers like "If-None-Match: ...".
+    std::vector<std::string> mHeaders;
+
+    /// If set, the server only sends the document if it has been modified after this time.
+    std::optional<std::time_t> mIfModifiedSince;
+
+    /// If set, only the response headers are requested, for example to find out the size of a file
+    /// before downloading it.
+    bool mHeadOnly = false;
+
+    /// If set, the received data is written to this stream instead of Response::mBody.
+    std::ostream* mOutput = nullptr;
+
+    /// If set, this is called regularly with the total and the already received number of bytes.
+    /// The total is zero if it is not known. If the callback returns true, the request is aborted.
+    std::function<bool(double, double)> mProgressCallback;
+  };
+
+  struct Response {
+    /// The HTTP response code, for example 200 or 304.
+    long mResponseCode = 0;
+
+    /// The content type without any parameters, for example "image/png".
+    std::string mContentType;
+
+    /// The received data, unless Request::mOutput was set.
+    std::string mBody;
+
+    /// All received response headers. The names are converted to lower case.
+    std::map<std::string, std::string> mHeaders;
+  };
+
+  /// Some counters which can be used to monitor the network traffic of one host.
+  struct HostStatistics {
+    /// The number of requests which are currently being performed.
+    uint32_t mActiveRequests{};
+
+    /// The number of requests which are waiting for a free connection, per priority class.
+    std::array<uint32_t, PRIORITY_COUNT> mPendingRequests{};
+
+    /// The number of requests which have been completed, including failed ones.
+    uint64_t mFinishedRequests{};
+
+    /// The number of requests which could not be performed or have been aborted.
+    uint64_t mFailedRequests{};
+
+    /// The total number of bytes received from this host.
+    uint64_t mReceivedBytes{};
+  };
+
+  /// This is called once an asynchronous request has finished. If the request failed or has been
+  /// aborted, error contains a std::runtime_error and the response is empty.
+  using Callback = std::function<void(Response response, std::exception_ptr error)>;
+
+  static HttpClient& get();
+
+  HttpClient(HttpClient const& other) = delete;
+  HttpClient(HttpClient&& other)      = delete;
+
+  HttpClient& operator=(HttpClient const& other) = delete;
+  HttpClient& operator=(HttpClient&& other)      = delete;
+
+  ~HttpClient();
+
+  /// At most this many requests are performed concurrently to the same host. The default is 8. The
+  /// value must be greater than zero.
+  void     setMaxConnectionsPerHost(uint32_t count);
+  uint32_t getMaxConnectionsPerHost() const;
+
+  /// Performs the given request and blocks until the response has been received completely. This
+  /// is thread-safe. Throws a std::runtime_error if the transfer fails or if it has been aborted by
+  /// the progress callback. A response code other than 200 is not considered an error.
+  Response perform(Request const& request);
+
+  /// Starts the given request and returns immediately. The request is performed on the I/O thread
+  /// of the HttpClient together with all other asynchronous requests. The same limits and
+  /// priorities apply as for synchronous requests. Once the response has been received completely,
+  /// the callback is invoked on the I/O thread. It should return quickly, for example by enqueueing
+  /// the processing of the response to a ThreadPool, as it delays all other asynchronous requests.
+  ///
+  /// If Request::mOutput is set, the stream has to stay valid until the callback has been invoked.
+  /// The progress callback is invoked on the I/O thread as well. Requests which are still in flight
+  /// when the HttpClient is destroyed at application exit are dropped without invoking their
+  /// callbacks. This is thread-safe.
+  void performAsync(Request request, Callback callback);
+
+  /// Returns the statistics of all hosts to which requests have been made so far.
+  std::map<std::string, HostStatistics> getStatistics() const;
+
+  /// Returns the host part of the given URL, including the port if given. For example,
+  /// "https://maps.example.com:8080/wms?service=WMS" results in "maps.example.com:8080". If the
+  /// URL has no scheme, everything up to the first slash is returned.
+  static std::string getHost(std::string const& url);
+
+ private:
+  /// An asynchronous request. This is defined in the source file as it contains the curl handle.
+  struct Transfer;
+
+  HttpClient();
+
+  void acquireConnection(std::string const& host, Priority priority);
+  void releaseConnection(std::string const& host, uint64_t receivedBytes, bool failed);
+
+  /// Returns true if a request of the given priority may start a new connection to the host
+  /// described by the given statistics. This requires mHostMutex to be locked.
+  bool canStart(HostStatistics const& stats, std::size_t priorityIndex) const;
+
+  /// This is executed by mIoThread. It starts queued transfers whenever there are free connections
+  /// and drives all active transfers until the HttpClient is destroyed.
+  void runIoThread();
+
+  mutable std::mutex                    mHostMutex;
+  std::condition_variable               mHostCondition;
+  std::map<std::string, HostStatistics> mHosts;
+  uint32_t                              mMaxConnectionsPerHost = 8;
+  int                                   mMetricsCollector      = -1;
+
+  // Asynchronous requests which are waiting for a free connection. These are guarded by
+  // mHostMutex as well, as they are started based on the host statistics.
+  std::vector<std::unique_ptr<Transfer>> mQueuedTransfers;
+  bool                                   mStopIoThread = false;
+
+  // The curl multi handle (a CURLM*) which performs all asynchronous requests. The I/O thread is
+  // started with the first asynchronous request.
+  void*       mMulti = nullptr;
+  std::thread mIoThread;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_HTTP_CLIENT_HPP
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_MPSCQUEUE_HPP
+#define CS_UTILS_MPSCQUEUE_HPP
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace cs::utils {
+
+/// A lock-free, unbounded queue for handing over items from any number of producer threads to one
+/// single consumer thread. push() may be called concurrently from any thread, tryPop() must only
+/// be called from one thread at a time. Items are popped in the order in which they were pushed
+/// by each thread.
+///
+/// push() consists of one atomic exchange and one store; it never waits for the consumer or other
+/// producers. This makes the queue suitable for passing results from worker threads to the render
+/// thread without risking priority inversion. The implementation is based on the node-based MPSC
+/// queue by Dmitry Vyukov.
+template <typename T>
+class MPSCQueue {
+ public:
+  MPSCQueue()
+      : mHead(new Node)
+      , mTail(mHead.load(std::memory_order_relaxed)) {
+  }
+
+  MPSCQueue(MPSCQueue const& other) = delete;
+  MPSCQueue(MPSCQueue&& other)      = delete;
+
+  MPSCQueue& operator=(MPSCQueue const& other) = delete;
+  MPSCQueue& operator=(MPSCQueue&& other) = delete;
+
+  /// Destroys all remaining items. No other thread may access the queue anymore.
+  ~MPSCQueue() {
+    while (tryPop()) {
+    }
+
+    delete mTail; // NOLINT(cppcoreguidelines-owning-memory)
+  }
+
+  /// Appends an item to the queue. This is thread-safe.
+  void push(T item) {
+    auto* node   = new Node; // NOLINT(cppcoreguidelines-owning-memory)
+    node->mValue = std::move(item);
+
+    Node* previous = mHead.exchange(node, std::memory_order_acq_rel);
+    previous->mNext.store(node, std::memory_order_release);
+  }
+
+  /// Removes the oldest item from the queue. Returns std::nullopt if the queue is empty. An item
+  /// which is currently being pushed by another thread may not be visible yet. This must only be
+  /// called by the consumer thread.
+  std::optional<T> tryPop() {
+    Node* next = mTail->mNext.load(std::memory_order_acquire);
+
+    if (!next) {
+      return std::nullopt;
+    }
+
+    // The popped node becomes the new stub node, so its value is moved out.
+    std::optional<T> item = std::move(next->mValue);
+    next->mValue.reset();
+
+    delete mTail; // NOLINT(cppcoreguidelines-owning-memory)
+    mTail = next;
+
+    return item;
+  }
+
+  /// Returns true if there is no item which can be popped. This must only be called by the
+  /// consumer thread.
+  bool isEmpty() const {
+    return mTail->mNext.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  struct Node {
+    std::atomic<Node*> mNext{nullptr};
+    std::optional<T>   mValue;
+  };
+
+  // Producers append nodes at the head, the consumer removes them at the tail. The tail always
+  // points to a stub node whose value has already been popped.
+  std::atomic<Node*> mHead;
+  Node*              mTail;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_MPSCQUEUE_HPP
@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Metrics.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Metric names may contain letters, digits, underscores and colons; label names must not contain
+// colons. Neither may start with a digit.
+bool isValidName(std::string const& name, bool allowColons) {
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+    return false;
+  }
+
+  for (char c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && !(allowColons && c == ':')) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Backslashes and line feeds have to be escaped in help texts, label values additionally require
+// escaped double quotes.
+std::string escape(std::string const& value, bool escapeQuotes) {
+  std::string result;
+  result.reserve(value.size());
+
+  for (char c : value) {
+    if (c == '\\') {
+      result += "\\\\";
+    } else if (c == '\n') {
+      result += "\\n";
+    } else if (escapeQuotes && c == '"') {
+      result += "\\\"";
+    } else {
+      result += c;
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the physical memory in bytes which is currently used by this process.
+double getResidentMemory() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters{};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return static_cast<double>(counters.WorkingSetSize);
+  }
+  return 0.0;
+#else
+  // The second value in /proc/self/statm is the number of resident pages.
+  std::ifstream statm("/proc/self/statm");
+  std::size_t   size     = 0;
+  std::size_t   resident = 0;
+  if (statm >> size >> resident) {
+    return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE));
+  }
+  return 0.0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::Sample::set(double value) {
+  mValue.store(value, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::Sample::add(double value) {
+  double current = mValue.load(std::memory_order_relaxed);
+  while (!mValue.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double Metrics::Sample::get() const {
+  return mValue.load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Metrics& Metrics::get() {
+  static Metrics instance;
+  return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Metrics::Metrics() {
+  // The memory usage of the process is always available.
+  addCollector([](Metrics& metrics) {
+    metrics
+        .getSample("cosmoscout_resident_memory_bytes", Type::eGauge,
+            "Physical memory used by the CosmoScout VR process.")
+        .set(getResidentMemory());
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Metrics::Sample& Metrics::getSample(
+    std::string const& name, Type type, std::string const& help, Labels const& labels) {
+
+  if (!isValidName(name, true)) {
+    throw std::invalid_argument("Invalid metric name '" + name + "'!");
+  }
+
+  for (auto const& label : labels) {
+    if (!isValidName(label.first, false)) {
+      throw std::invalid_argument(
+          "Invalid label name '" + label.first + "' for metric '" + name + "'!");
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mFamiliesMutex);
+
+  auto family = mFamilies.find(name);
+  if (family == mFamilies.end()) {
+    family = mFamilies.emplace(name, Family{type, help, {}}).first;
+  } else if (family->second.mType != type) {
+    throw std::invalid_argument(
+        "Metric '" + name + "' has already been created with another type!");
+  }
+
+  auto& sample = family->second.mSamples[labels];
+  if (!sample) {
+    sample = std::make_unique<Sample>();
+  }
+
+  return *sample;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int Metrics::addCollector(Collector collector) {
+  std::lock_guard<std::mutex> lock(mCollectorsMutex);
+  mCollectors.emplace(mNextCollectorId, std::move(collector));
+  return mNextCollectorId++;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::removeCollector(int id) {
+  std::lock_guard<std::mutex> lock(mCollectorsMutex);
+  mCollectors.erase(id);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string Metrics::collect() {
+  {
+    std::lock_guard<std::mutex> lock(mCollectorsMutex);
+    for (auto const& [id, collector] : mCollectors) {
+      collector(*this);
+    }
+  }
+
+  // The decimal separator has to be a dot, regardless of the current locale.
+  std::ostringstream output;
+  output.imbue(std::locale::classic());
+  output << std::setprecision(17);
+
+  std::lock_guard<std::mutex> lock(mFamiliesMutex);
+
+  for (auto const& [name, family] : mFamilies) {
+    output << "# HELP " << name << " " << escape(family.mHelp, false) << "\n";
+    output << "# TYPE " << name << " " << (family.mType == Type::eCounter ? "counter" : "gauge")
+           << "\n";
+
+    for (auto const& [labels, sample] : family.mSamples) {
+      output << name;
+
+      if (!labels.empty()) {
+        output << "{";
+        for (auto it = labels.begin(); it != labels.end(); ++it) {
+          output << (it == labels.begin() ? "" : ",") << it->first << "=\""
+                 << escape(it->second, true) << "\"";
+        }
+        output << "}";
+      }
+
+      double value = sample->get();
+      if (std::isnan(value)) {
+        output << " NaN\n";
+      } else if (std::isinf(value)) {
+        output << (value > 0 ? " +Inf\n" : " -Inf\n");
+      } else {
+        output << " " << value << "\n";
+      }
+    }
+  }
+
+  return output.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_METRICS_HPP
+#define CS_UTILS_METRICS_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace cs::utils {
+
+/// This is a singleton registry of runtime performance counters, for example frame times, queue
+/// depths or memory usage. Any part of CosmoScout VR and its plugins can add samples to it, the
+/// csp-web-api plugin exposes all of them in the Prometheus text format on its /metrics endpoint.
+/// This way, many installations can be monitored remotely.
+///
+/// Each metric has a name like "cosmoscout_frame_time_seconds", a type and a help text. A metric
+/// may contain several samples which are distinguished by their labels, for example one sample
+/// per thread pool. The names should follow the Prometheus conventions: Use base units and end the
+/// names of counters with "_total".
+///
+/// There are two ways of providing values: Values which are known anyway, for example the frame
+/// time, are set on a Sample. Values which are expensive to compute or which are only known to
+/// some other thread-safe object can be gathered by a collector, which is only called when the
+/// metrics are requested.
+///
+/// All methods are thread-safe.
+class CS_UTILS_EXPORT Metrics {
+ public:
+  enum class Type {
+    eCounter, ///< A value which only increases, for example the number of rendered frames.
+    eGauge    ///< A value which can go up and down, for example the number of pending tasks.
+  };
+
+  /// Pairs of label names and values. The names are sorted, so that the order in which labels are
+  /// given does not matter.
+  using Labels = std::map<std::string, std::string>;
+
+  /// One value of a metric. Updating it is lock-free, so it can be done each frame. References to
+  /// samples stay valid until the end of the program.
+  class CS_UTILS_EXPORT Sample {
+   public:
+    void   set(double value);
+    void   add(double value);
+    double get() const;
+
+   private:
+    std::atomic<double> mValue{0.0};
+  };
+
+  /// Collectors are called from the thread which requests the metrics. They should update their
+  /// samples and must neither add nor remove collectors.
+  using Collector = std::function<void(Metrics& metrics)>;
+
+  static Metrics& get();
+
+  Metrics(Metrics const& other) = delete;
+  Metrics(Metrics&& other)      = delete;
+
+  Metrics& operator=(Metrics const& other) = delete;
+  Metrics& operator=(Metrics&& other)      = delete;
+
+  ~Metrics() = default;
+
+  /// Returns the sample of the given metric with the given labels. The metric and the sample are
+  /// created if necessary. Throws a std::invalid_argument if the name or a label name is not valid
+  /// or if the metric has already been created with a different type. The help text is only used
+  /// when the metric is created. As this requires a lookup, the returned reference should be stored
+  /// if the sample is updated often.
+  Sample& getSample(std::string const& name, Type type, std::string const& help,
+      Labels const& labels = {});
+
+  /// Adds a collector and returns an ID which can be used to remove it again. Once
+  /// removeCollector() returns, the collector is not running and will not be called again.
+  int  addCollector(Collector collector);
+  void removeCollector(int id);
+
+  /// Calls all collectors and returns all samples in the Prometheus text exposition format.
+  std::string collect();
+
+ private:
+  Metrics();
+
+  struct Family {
+    Type                                      mType;
+    std::string                               mHelp;
+    std::map<Labels, std::unique_ptr<Sample>> mSamples;
+  };
+
+  std::mutex                    mFamiliesMutex;
+  std::map<std::string, Family> mFamilies;
+
+  // This is locked while the collectors are running.
+  std::mutex               mCollectorsMutex;
+  std::map<int, Collector> mCollectors;
+  int                      mNextCollectorId = 0;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_METRICS_HPP
@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "MicroBenchmark.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <locale>
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MicroBenchmark::Result MicroBenchmark::report(
+    std::string const& name, std::vector<double> samples, uint64_t iterations) {
+
+  std::sort(samples.begin(), samples.end());
+
+  Result result;
+  result.mName       = name;
+  result.mIterations = iterations;
+  result.mMin        = samples.front();
+  result.mMedian     = samples[samples.size() / 2];
+  result.mMax        = samples.back();
+
+  logger().info("{:<50} {:>12.1f} ns (min {:.1f} ns, max {:.1f} ns, {} iterations)", name,
+      result.mMedian, result.mMin, result.mMax, iterations);
+
+  // NOLINTNEXTLINE(concurrency-mt-unsafe): The benchmarks are executed on one thread.
+  char const* reportFile = std::getenv("COSMOSCOUT_BENCHMARK_REPORT");
+
+  if (reportFile && *reportFile) {
+    std::ofstream output(reportFile, std::ios::app);
+
+    if (!output) {
+      logger().warn("Failed to append benchmark results to '{}'!", reportFile);
+      return result;
+    }
+
+    output.imbue(std::locale::classic());
+    output << std::setprecision(17) << R"({"name": ")" << name << R"(", "iterations": )"
+           << iterations << R"(, "min": )" << result.mMin << R"(, "median": )" << result.mMedian
+           << R"(, "max": )" << result.mMax << "}\n";
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+void useCharPointer(char const volatile* /*pointer*/) {
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
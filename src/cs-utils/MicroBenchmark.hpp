@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_MICRO_BENCHMARK_HPP
+#define CS_UTILS_MICRO_BENCHMARK_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cs::utils {
+
+/// A minimal harness for micro benchmarks. The benchmarks of CosmoScout VR are doctest test cases
+/// which are only compiled if CosmoScout VR is configured with -DCOSMOSCOUT_BENCHMARKS=On. They
+/// are tagged with "[benchmark]" and skipped by default, so they do not slow down the unit tests:
+///
+/// TEST_CASE("cs::utils::Signal::emit [benchmark]" * doctest::skip()) {
+///   Signal<int> signal;
+///   MicroBenchmark::run("Signal::emit", [&]() { signal.emit(42); });
+/// }
+///
+/// They can be executed with the run_benchmarks script. The results are printed to the log. If
+/// the environment variable COSMOSCOUT_BENCHMARK_REPORT is set, one JSON object per benchmark is
+/// appended to the file it points to, so that the results of different builds can be compared.
+class CS_UTILS_EXPORT MicroBenchmark {
+ public:
+  struct Result {
+    std::string mName;
+
+    /// The total number of times the function has been called.
+    uint64_t mIterations = 0;
+
+    /// The time in nanoseconds per item. The minimum is the most stable value, the median is the
+    /// most representative one.
+    double mMin    = 0.0;
+    double mMedian = 0.0;
+    double mMax    = 0.0;
+  };
+
+  /// Each sample calls the function this often, so that it takes at least this long.
+  static constexpr std::chrono::milliseconds MIN_SAMPLE_TIME{10};
+
+  /// The number of samples which are taken for each benchmark.
+  static constexpr std::size_t SAMPLE_COUNT = 15;
+
+  /// Calls the given function repeatedly and reports the time per call. If the function processes
+  /// several items at once, for example a batch of tasks, the time per item is reported instead.
+  template <typename F>
+  static Result run(std::string const& name, F&& function, uint64_t itemsPerCall = 1) {
+    using Clock = std::chrono::steady_clock;
+
+    // Find the number of calls per sample. This warms up the caches as well.
+    uint64_t calls = 1;
+    while (true) {
+      auto start = Clock::now();
+      for (uint64_t i = 0; i < calls; ++i) {
+        function();
+      }
+
+      if (Clock::now() - start >= MIN_SAMPLE_TIME) {
+        break;
+      }
+
+      calls *= 2;
+    }
+
+    std::vector<double> samples(SAMPLE_COUNT);
+
+    for (auto& sample : samples) {
+      auto start = Clock::now();
+      for (uint64_t i = 0; i < calls; ++i) {
+        function();
+      }
+
+      std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+      sample = elapsed.count() / static_cast<double>(calls * itemsPerCall);
+    }
+
+    return report(name, std::move(samples), calls * SAMPLE_COUNT);
+  }
+
+ private:
+  static Result report(std::string const& name, std::vector<double> samples, uint64_t iterations);
+};
+
+namespace detail {
+CS_UTILS_EXPORT void useCharPointer(char const volatile* pointer);
+} // namespace detail
+
+/// Prevents the compiler from optimizing away the computation of the given value in a benchmark.
+template <typename T>
+inline void doNotOptimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  detail::useCharPointer(&reinterpret_cast<char const volatile&>(value));
+#endif
+}
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_MICRO_BENCHMARK_HPP
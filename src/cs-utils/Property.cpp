@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Property.hpp"
+
+#include <vector>
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct DeferredEmission {
+  void* mProperty;
+  void (*mEmit)(void*);
+};
+
+// The Properties which have been changed in deferred mode since the last call to
+// emitDeferredPropertyChanges(). Entries of destroyed Properties are set to nullptr.
+std::vector<DeferredEmission>& getQueue() {
+  static std::vector<DeferredEmission> queue;
+  return queue;
+}
+
+// The number of PropertyTransactions which currently exist on this thread.
+thread_local int transactionDepth = 0;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PropertyTransaction::PropertyTransaction() {
+  ++transactionDepth;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PropertyTransaction::~PropertyTransaction() {
+  --transactionDepth;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PropertyTransaction::getIsActive() {
+  return transactionDepth > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void emitDeferredPropertyChanges() {
+  auto& queue = getQueue();
+
+  // Properties which are changed by the slots called here are enqueued again and will be emitted
+  // by the next call. This way, cyclic dependencies cannot cause an infinite loop.
+  std::size_t count = queue.size();
+
+  for (std::size_t i = 0; i < count; ++i) {
+    // The queue may be reallocated by the slots, so the entry is copied.
+    DeferredEmission emission = queue[i];
+    queue[i].mProperty        = nullptr;
+
+    if (emission.mProperty) {
+      emission.mEmit(emission.mProperty);
+    }
+  }
+
+  queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void enqueueDeferredEmission(void* property, void (*emit)(void*)) {
+  getQueue().push_back({property, emit});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void dequeueDeferredEmission(void* property) {
+  for (auto& emission : getQueue()) {
+    if (emission.mProperty == property) {
+      emission.mProperty = nullptr;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
@@ -14,6 +14,37 @@
 
 namespace cs::utils {
 
+/// Calls the slots of all Properties in deferred mode whose value has been changed since the last
+/// call. Each of these Properties emits its change signal only once with its most recent value.
+/// This is called once per frame by the Application. See Property::setDeferred() for details.
+CS_UTILS_EXPORT void emitDeferredPropertyChanges();
+
+/// While an instance of this class exists, all Properties which are modified on the thread which
+/// created the instance behave as if they were in deferred mode. This can be used to apply many
+/// changes at once, so that each Property emits its change signal only once with its final value
+/// at the next frame boundary. Transactions can be nested and must only be used on the main thread;
+/// Properties modified by other threads are not affected. See Property::setDeferred() for details.
+class CS_UTILS_EXPORT PropertyTransaction {
+ public:
+  PropertyTransaction();
+
+  PropertyTransaction(PropertyTransaction const& other) = delete;
+  PropertyTransaction(PropertyTransaction&& other)      = delete;
+
+  PropertyTransaction& operator=(PropertyTransaction const& other) = delete;
+  PropertyTransaction& operator=(PropertyTransaction&& other)      = delete;
+
+  ~PropertyTransaction();
+
+  /// Returns true if a PropertyTransaction exists on the calling thread.
+  static bool getIsActive();
+};
+
+namespace detail {
+CS_UTILS_EXPORT void enqueueDeferredEmission(void* property, void (*emit)(void*));
+CS_UTILS_EXPORT void dequeueDeferredEmission(void* property);
+} // namespace detail
+
 /// A Property encapsulates a value and may inform you on any changes applied to this value.
 /// All functions given to connect() will be called when the internal value is about to be changed.
 /// The new value is passed as parameter, to access the old value you can use the get() method, as
@@ -41,7 +72,9 @@ class Property {
       : mOnChange(std::move(other.mOnChange))
       , mConnection(other.mConnection)
       , mConnectionID(other.mConnectionID)
-      , mValue(other.mValue) {
+      , mValue(other.mValue)
+      , mIsDeferred(other.mIsDeferred) {
+    takeDeferredEmission(other);
   }
 
   Property& operator=(Property<T>&& other) noexcept {
@@ -50,6 +83,8 @@ class Property {
       mConnection   = other.mConnection;
       mConnectionID = other.mConnectionID;
       mValue        = other.mValue;
+      mIsDeferred   = other.mIsDeferred;
+      takeDeferredEmission(other);
     }
 
     return *this;
@@ -59,6 +94,10 @@ class Property {
     if (mConnection) {
       mConnection->disconnect(mConnectionID);
     }
+
+    if (mHasDeferredEmission) {
+      detail::dequeueDeferredEmission(this);
+    }
   };
 
   /// The given function is called when the internal value is about to be changed. The new value
@@ -107,14 +146,42 @@ class Property {
     mOnChange.disconnectAll();
   }
 
-  /// Sets the Property to a new value. onChange() will be emitted.
+  /// Sets the Property to a new value. onChange() will be emitted. In deferred mode or during a
+  /// PropertyTransaction, the value is changed immediately and onChange() will be emitted by
+  /// emitDeferredPropertyChanges().
   virtual void set(T const& value) {
     if (value != mValue) {
-      mOnChange.emit(value);
-      mValue = value;
+      if (mIsDeferred || PropertyTransaction::getIsActive()) {
+        mValue = value;
+        enqueueDeferredEmission();
+      } else {
+        mOnChange.emit(value);
+        mValue = value;
+      }
     }
   }
 
+  /// In deferred mode, set() changes the value immediately but does not call the connected
+  /// functions. They are called once with the most recent value when emitDeferredPropertyChanges()
+  /// is called, which happens once per frame. This coalesces changes of Properties which are
+  /// modified several times per frame. Be aware that get() already returns the new value when the
+  /// connected functions are called. The other methods, like setWithEmitForAllButOne() or touch(),
+  /// are not affected. Deferred mode must only be used for Properties which are modified on the
+  /// main thread. If deferred mode is disabled while a change is pending, it is emitted right away.
+  void setDeferred(bool enable) {
+    mIsDeferred = enable;
+
+    if (!enable && mHasDeferredEmission) {
+      detail::dequeueDeferredEmission(this);
+      emitDeferred(this);
+    }
+  }
+
+  /// Returns true if setDeferred(true) has been called.
+  bool getIsDeferred() const {
+    return mIsDeferred;
+  }
+
   /// Sets the Property to a new value. onChange() will be emitted for all but one connections.
   virtual void setWithEmitForAllButOne(T const& value, int excludeConnection) {
     if (value != mValue) {
@@ -182,6 +249,32 @@ class Property {
   mutable Property<T> const* mConnection{nullptr};
   mutable int                mConnectionID{-1};
   T                          mValue{}; // Default initialize (primitives => 0 | false).
+
+ private:
+  static void emitDeferred(void* property) {
+    auto* self                 = static_cast<Property<T>*>(property);
+    self->mHasDeferredEmission = false;
+    self->mOnChange.emit(self->mValue);
+  }
+
+  void enqueueDeferredEmission() {
+    if (!mHasDeferredEmission) {
+      mHasDeferredEmission = true;
+      detail::enqueueDeferredEmission(this, &Property<T>::emitDeferred);
+    }
+  }
+
+  // A pending emission of a moved-from Property is transferred to this Property.
+  void takeDeferredEmission(Property<T>& other) {
+    if (other.mHasDeferredEmission) {
+      detail::dequeueDeferredEmission(&other);
+      other.mHasDeferredEmission = false;
+      enqueueDeferredEmission();
+    }
+  }
+
+  bool mIsDeferred          = false;
+  bool mHasDeferredEmission = false;
 };
 
 /// Stream operators.
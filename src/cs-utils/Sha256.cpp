@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Sha256.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The round constants of SHA-256, see FIPS 180-4.
+std::array<uint32_t, 64> const K = {0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+    0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74,
+    0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3,
+    0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354,
+    0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+    0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3,
+    0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa,
+    0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32_t rotateRight(uint32_t value, uint32_t count) {
+  return (value >> count) | (value << (32U - count));
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Sha256::Sha256()
+    : mState({0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab,
+          0x5be0cd19}) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Sha256::update(char const* data, std::size_t size) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  auto const* bytes = reinterpret_cast<uint8_t const*>(data);
+
+  mLength += size;
+
+  for (std::size_t i = 0; i < size; ++i) {
+    mBuffer.at(mBufferSize++) = bytes[i];
+
+    if (mBufferSize == mBuffer.size()) {
+      processBlock(mBuffer.data());
+      mBufferSize = 0;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Sha256::update(std::string const& data) {
+  update(data.data(), data.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string Sha256::getHexDigest() {
+  uint64_t bitLength = mLength * 8;
+
+  // The message is padded with a one bit, zeros and its length in bits, so that the total length
+  // is a multiple of 64 bytes.
+  std::array<char, 72> padding{};
+  padding[0]              = static_cast<char>(0x80);
+  std::size_t zeroPadding = (mBufferSize < 56 ? 56 : 120) - mBufferSize;
+
+  for (std::size_t i = 0; i < 8; ++i) {
+    padding.at(zeroPadding + i) = static_cast<char>((bitLength >> (56 - 8 * i)) & 0xFF);
+  }
+
+  update(padding.data(), zeroPadding + 8);
+
+  std::string result;
+  result.reserve(64);
+
+  char const* digits = "0123456789abcdef";
+  for (uint32_t word : mState) {
+    for (int shift = 28; shift >= 0; shift -= 4) {
+      result += digits[(word >> shift) & 0xF];
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string Sha256::hashFile(std::string const& fileName) {
+  std::ifstream stream(fileName, std::ios::binary);
+
+  if (!stream) {
+    throw std::runtime_error("Failed to open '" + fileName + "' for hashing!");
+  }
+
+  Sha256            hash;
+  std::vector<char> buffer(1024 * 1024);
+
+  while (stream) {
+    stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    hash.update(buffer.data(), static_cast<std::size_t>(stream.gcount()));
+  }
+
+  if (stream.bad()) {
+    throw std::runtime_error("Failed to read '" + fileName + "' for hashing!");
+  }
+
+  return hash.getHexDigest();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Sha256::processBlock(uint8_t const* block) {
+  std::array<uint32_t, 64> w{};
+
+  for (std::size_t i = 0; i < 16; ++i) {
+    w.at(i) = (static_cast<uint32_t>(block[i * 4]) << 24U) |
+              (static_cast<uint32_t>(block[i * 4 + 1]) << 16U) |
+              (static_cast<uint32_t>(block[i * 4 + 2]) << 8U) |
+              static_cast<uint32_t>(block[i * 4 + 3]);
+  }
+
+  for (std::size_t i = 16; i < 64; ++i) {
+    uint32_t a  = w.at(i - 15);
+    uint32_t b  = w.at(i - 2);
+    uint32_t s0 = rotateRight(a, 7) ^ rotateRight(a, 18) ^ (a >> 3U);
+    uint32_t s1 = rotateRight(b, 17) ^ rotateRight(b, 19) ^ (b >> 10U);
+    w.at(i)     = w.at(i - 16) + s0 + w.at(i - 7) + s1;
+  }
+
+  auto s = mState;
+
+  for (std::size_t i = 0; i < 64; ++i) {
+    uint32_t s1    = rotateRight(s[4], 6) ^ rotateRight(s[4], 11) ^ rotateRight(s[4], 25);
+    uint32_t ch    = (s[4] & s[5]) ^ (~s[4] & s[6]);
+    uint32_t temp1 = s[7] + s1 + ch + K.at(i) + w.at(i);
+    uint32_t s0    = rotateRight(s[0], 2) ^ rotateRight(s[0], 13) ^ rotateRight(s[0], 22);
+    uint32_t maj   = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+    uint32_t temp2 = s0 + maj;
+
+    s[7] = s[6];
+    s[6] = s[5];
+    s[5] = s[4];
+    s[4] = s[3] + temp1;
+    s[3] = s[2];
+    s[2] = s[1];
+    s[1] = s[0];
+    s[0] = temp1 + temp2;
+  }
+
+  for (std::size_t i = 0; i < 8; ++i) {
+    mState.at(i) += s.at(i);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_SHA256_HPP
+#define CS_UTILS_SHA256_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace cs::utils {
+
+/// Computes the SHA-256 hash of a stream of data. This is used to verify downloaded files, so the
+/// data can be passed in pieces of any size. The result is the lower-case hexadecimal
+/// representation which is also printed by tools like sha256sum.
+class CS_UTILS_EXPORT Sha256 {
+ public:
+  Sha256();
+
+  /// Adds the given data to the hash. This must not be called after getHexDigest().
+  void update(char const* data, std::size_t size);
+  void update(std::string const& data);
+
+  /// Finishes the computation and returns the hash as 64 hexadecimal digits.
+  std::string getHexDigest();
+
+  /// Returns the hash of the given file. Throws a std::runtime_error if it cannot be read.
+  static std::string hashFile(std::string const& fileName);
+
+ private:
+  void processBlock(uint8_t const* block);
+
+  std::array<uint32_t, 8> mState{};
+  std::array<uint8_t, 64> mBuffer{};
+  std::size_t             mBufferSize = 0;
+  uint64_t                mLength     = 0;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_SHA256_HPP
@@ -8,9 +8,11 @@
 #ifndef CS_UTILS_SIGNAL_HPP
 #define CS_UTILS_SIGNAL_HPP
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
-#include <map>
+#include <utility>
+#include <vector>
 
 #include <cs_utils_export.hpp>
 #include <spdlog/spdlog.h>
@@ -22,6 +24,11 @@ CS_UTILS_EXPORT spdlog::logger& logger();
 /// A signal object may call multiple slots with the same signature. You can connect functions to
 /// the signal which will be called when the emit() method on the signal object is invoked. Any
 /// argument passed to emit() will be passed to the given functions.
+///
+/// The slots are stored in a vector which is sorted by connection ID, so emitting a signal neither
+/// allocates memory nor copies the arguments. Slots connected while the signal is being emitted
+/// will only be called by subsequent emissions, slots disconnected while the signal is being
+/// emitted are still called during the current emission.
 template <typename... Args>
 class Signal {
 
@@ -51,7 +58,13 @@ class Signal {
   /// Connects a std::function to the signal. The returned value can be used to disconnect the
   /// function again.
   int connect(std::function<void(Args...)> const& slot) const {
-    mSlots.insert(std::make_pair(++mCurrentID, slot));
+    // Appending to mSlots while iterating would invalidate the slot which is currently called.
+    if (mIsIterating) {
+      mSlotsToConnect.emplace_back(++mCurrentID, slot);
+    } else {
+      mSlots.emplace_back(++mCurrentID, slot);
+    }
+
     return mCurrentID;
   }
 
@@ -59,8 +72,9 @@ class Signal {
   void disconnect(int id) const {
     if (mIsIterating) {
       mSlotsToDisconnect.push_back(id);
+      eraseSlot(mSlotsToConnect, id);
     } else {
-      mSlots.erase(id);
+      eraseSlot(mSlots, id);
     }
   }
 
@@ -68,13 +82,14 @@ class Signal {
   void disconnectAll() const {
     if (mIsIterating) {
       mDisconnectAllRequested = true;
+      mSlotsToConnect.clear();
     } else {
       mSlots.clear();
     }
   }
 
   /// Calls all connected functions.
-  void emit(Args... p) {
+  void emit(Args const&... p) {
     if (mIsIterating) {
       logger().warn(
           "Recursive invocation of emit! To avoid a stack overflow, the recursive invocation was "
@@ -93,7 +108,7 @@ class Signal {
   }
 
   /// Calls all connected functions except for one.
-  void emitForAllButOne(int excludedConnectionID, Args... p) {
+  void emitForAllButOne(int excludedConnectionID, Args const&... p) {
     if (mIsIterating) {
       logger().warn(
           "Recursive invocation of emit! To avoid a stack overflow, the recursive invocation was "
@@ -114,10 +129,13 @@ class Signal {
   }
 
   /// Calls only one connected functions.
-  void emitFor(int connectionID, Args... p) {
-    auto const& it = mSlots.find(connectionID);
+  void emitFor(int connectionID, Args const&... p) {
+    auto it = findSlot(mSlots, connectionID);
     if (it != mSlots.end()) {
-      it->second(p...);
+      // The slot is copied, as it may connect further slots to this signal which would invalidate
+      // the iterator.
+      auto slot = it->second;
+      slot(p...);
     }
   }
 
@@ -130,20 +148,44 @@ class Signal {
   }
 
  private:
+  using Slots = std::vector<std::pair<int, std::function<void(Args...)>>>;
+
+  // The connection IDs increase monotonically, so the slots are always sorted by their ID.
+  static typename Slots::iterator findSlot(Slots& slots, int id) {
+    auto it = std::lower_bound(slots.begin(), slots.end(), id,
+        [](auto const& slot, int value) { return slot.first < value; });
+    return (it != slots.end() && it->first == id) ? it : slots.end();
+  }
+
+  static void eraseSlot(Slots& slots, int id) {
+    auto it = findSlot(slots, id);
+    if (it != slots.end()) {
+      slots.erase(it);
+    }
+  }
+
   void postEmitCleanUp() {
     if (mDisconnectAllRequested) {
       mSlots.clear();
       mDisconnectAllRequested = false;
     } else {
       for (int id : mSlotsToDisconnect) {
-        mSlots.erase(id);
+        eraseSlot(mSlots, id);
       }
-      mSlotsToDisconnect.clear();
     }
+
+    mSlotsToDisconnect.clear();
+
+    for (auto& slot : mSlotsToConnect) {
+      mSlots.push_back(std::move(slot));
+    }
+
+    mSlotsToConnect.clear();
   }
 
-  mutable std::map<int, std::function<void(Args...)>> mSlots;
-  mutable int                                         mCurrentID{0};
+  mutable Slots mSlots;
+  mutable Slots mSlotsToConnect;
+  mutable int   mCurrentID{0};
 
   mutable bool             mIsIterating            = false;
   mutable bool             mDisconnectAllRequested = false;
@@ -7,46 +7,117 @@
 
 #include "ThreadPool.hpp"
 
-#include <iostream>
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
 
 namespace cs::utils {
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace {
 
-ThreadPool::ThreadPool(size_t threads)
-    : mStop(false) {
-  for (size_t i = 0; i < threads; ++i) {
-    mWorkers.emplace_back([this] {
-      while (true) {
-        std::function<void()> task;
-        {
-          std::unique_lock<std::mutex> lock(mMutex);
+// These are used to find the queue of the current worker if a task is enqueued from within a task.
+thread_local ThreadPool const* sCurrentPool   = nullptr;
+thread_local size_t            sCurrentWorker = 0;
+
+// All existing pools are published to the Metrics by one collector. Pools with the same name are
+// accumulated. The collector holds the mutex while reading the pools, so a pool cannot be destroyed
+// while it is being read.
+struct PoolRegistry {
+  std::mutex                                    mMutex;
+  std::set<ThreadPool const*>                   mPools;
+  std::map<std::string, ThreadPool::Statistics> mLastStatistics;
 
-          mCondition.wait(lock, [this] { return mStop || !mTasks.empty(); });
+  PoolRegistry() {
+    Metrics::get().addCollector([this](Metrics& metrics) { collect(metrics); });
+  }
+
+  void collect(Metrics& metrics) {
+    std::lock_guard<std::mutex> lock(mMutex);
 
-          if (mStop && mTasks.empty()) {
-            return;
-          }
+    std::map<std::string, ThreadPool::Statistics> statistics;
 
-          task = std::move(mTasks.top());
-          mTasks.pop();
-          ++mRunningTasks;
-        }
+    // Pools which do not exist anymore are reported as idle.
+    for (auto const& last : mLastStatistics) {
+      statistics[last.first] = {};
+    }
 
-        task();
+    for (auto const* pool : mPools) {
+      auto  current = pool->getStatistics();
+      auto& total   = statistics[pool->getName()];
 
-        std::unique_lock<std::mutex> lock(mMutex);
-        --mRunningTasks;
+      total.mRunningTasks += current.mRunningTasks;
+      for (size_t p = 0; p < ThreadPool::PRIORITY_COUNT; ++p) {
+        total.mPendingTasks.at(p) += current.mPendingTasks.at(p);
+        total.mStartedTasks.at(p) += current.mStartedTasks.at(p);
       }
-    });
+    }
+
+    std::array<char const*, ThreadPool::PRIORITY_COUNT> const priorities{"high", "normal", "low"};
+
+    for (auto const& [name, total] : statistics) {
+      metrics
+          .getSample("cosmoscout_thread_pool_running_tasks", Metrics::Type::eGauge,
+              "The number of tasks which are currently being executed.", {{"pool", name}})
+          .set(static_cast<double>(total.mRunningTasks));
+
+      for (size_t p = 0; p < ThreadPool::PRIORITY_COUNT; ++p) {
+        Metrics::Labels labels{{"pool", name}, {"priority", priorities.at(p)}};
+        metrics
+            .getSample("cosmoscout_thread_pool_pending_tasks", Metrics::Type::eGauge,
+                "The number of tasks which are waiting for execution.", labels)
+            .set(static_cast<double>(total.mPendingTasks.at(p)));
+        metrics
+            .getSample("cosmoscout_thread_pool_started_tasks_total", Metrics::Type::eCounter,
+                "The number of tasks which have been started.", labels)
+            .set(static_cast<double>(total.mStartedTasks.at(p)));
+      }
+    }
+
+    mLastStatistics = std::move(statistics);
+  }
+};
+
+// The registry is never destroyed, as static pools may be destroyed after it.
+PoolRegistry& getPoolRegistry() {
+  static auto* registry = new PoolRegistry(); // NOLINT(cppcoreguidelines-owning-memory)
+  return *registry;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::ThreadPool(size_t threads, std::string name)
+    : mName(std::move(name))
+    , mTaskTimerId(FrameStats::intern(mName + " Task")) {
+
+  // We need at least one queue, even if there are no workers.
+  for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+    mQueues.emplace_back(std::make_unique<Queue>());
   }
+
+  for (size_t i = 0; i < threads; ++i) {
+    mWorkers.emplace_back([this, i] { work(i); });
+  }
+
+  auto&                       registry = getPoolRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+  registry.mPools.insert(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 ThreadPool::~ThreadPool() {
   {
-    std::unique_lock<std::mutex> lock(mMutex);
+    auto&                       registry = getPoolRegistry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    registry.mPools.erase(this);
+  }
+
+  {
+    Lock lock(mMutex);
     mStop = true;
   }
 
@@ -59,4 +130,226 @@ ThreadPool::~ThreadPool() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::string const& ThreadPool::getName() const {
+  return mName;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ThreadPool::getPendingTaskCount() const {
+  uint32_t count = 0;
+  for (auto const& pending : mPendingTasks) {
+    count += pending.load();
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ThreadPool::getPendingTaskCount(Priority priority) const {
+  return mPendingTasks.at(static_cast<size_t>(priority)).load();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ThreadPool::getRunningTaskCount() const {
+  return mRunningTasks.load();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::Statistics ThreadPool::getStatistics() const {
+  Statistics statistics;
+  statistics.mRunningTasks = mRunningTasks.load();
+  statistics.mStolenTasks  = mStolenTasks.load();
+
+  for (size_t p = 0; p < PRIORITY_COUNT; ++p) {
+    uint64_t started = mCounters.at(p).mStartedTasks.load();
+
+    statistics.mPendingTasks.at(p) = mPendingTasks.at(p).load();
+    statistics.mStartedTasks.at(p) = started;
+
+    if (started > 0) {
+      statistics.mAverageLatency.at(p) =
+          static_cast<double>(mCounters.at(p).mTotalLatency.load()) / started * 1e-6;
+    }
+
+    statistics.mMaximumLatency.at(p) =
+        static_cast<double>(mCounters.at(p).mMaximumLatency.load()) * 1e-6;
+  }
+
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::resetStatistics() {
+  for (auto& counters : mCounters) {
+    counters.mStartedTasks   = 0;
+    counters.mTotalLatency   = 0;
+    counters.mMaximumLatency = 0;
+  }
+
+  mStolenTasks = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameStats::TimerId ThreadPool::getTaskTimerId(std::optional<FrameStats::TimerId> const& owner) {
+  if (!owner) {
+    return mTaskTimerId;
+  }
+
+  auto it = mOwnerTaskTimerIds.find(*owner);
+  if (it != mOwnerTaskTimerIds.end()) {
+    return it->second;
+  }
+
+  // This is called within the ScopedOwner of the owner, so the new timer is attributed to it.
+  auto id = FrameStats::intern(mName + " Task (" + FrameStats::getName(*owner) + ")");
+  mOwnerTaskTimerIds.emplace(*owner, id);
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::push(Priority priority, std::function<void()> function) {
+  auto p     = static_cast<size_t>(priority);
+  auto owner = FrameStats::getCurrentOwner();
+
+  FrameStats::TimerId timerId{};
+
+  {
+    Lock lock(mMutex);
+    if (mStop) {
+      throw std::runtime_error("enqueue on stopped ThreadPool");
+    }
+
+    timerId = getTaskTimerId(owner);
+  }
+
+  // Tasks which are enqueued from within a task are added to the queue of the current worker. This
+  // improves locality as the new task will most likely work on similar data. All other tasks are
+  // distributed in a round-robin fashion.
+  size_t index = 0;
+  if (sCurrentPool == this) {
+    index = sCurrentWorker;
+  } else {
+    index = mNextQueue.fetch_add(1) % mQueues.size();
+  }
+
+  {
+    auto& queue = *mQueues[index];
+    Lock  lock(queue.mMutex);
+    queue.mTasks.at(p).push_back(
+        {std::move(function), std::chrono::steady_clock::now(), owner, timerId});
+
+    // The counters have to be incremented while the queue is locked. Else another worker could pop
+    // the task and decrement the counters before they have been incremented.
+    ++queue.mSizes.at(p);
+    ++mPendingTasks.at(p);
+  }
+
+  // Sleeping workers check the pending task count while holding mMutex. Locking it here ensures
+  // that we cannot notify the condition variable between a worker's check and its call to wait().
+  { Lock lock(mMutex); }
+
+  mCondition.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ThreadPool::pop(size_t worker, Task& task) {
+
+  // We search all queues for the highest-priority task. The worker's own queue is checked first,
+  // afterwards the other queues are searched in a round-robin fashion. Empty queues are skipped
+  // without locking their mutex.
+  for (size_t p = 0; p < PRIORITY_COUNT; ++p) {
+    if (mPendingTasks.at(p) == 0) {
+      continue;
+    }
+
+    for (size_t i = 0; i < mQueues.size(); ++i) {
+      auto& queue = *mQueues[(worker + i) % mQueues.size()];
+
+      if (queue.mSizes.at(p) == 0) {
+        continue;
+      }
+
+      Lock  lock(queue.mMutex);
+      auto& tasks = queue.mTasks.at(p);
+
+      if (tasks.empty()) {
+        continue;
+      }
+
+      task = std::move(tasks.front());
+      tasks.pop_front();
+
+      // The running task count is incremented first so that hasFinished() never returns true
+      // while a task is being moved from one state to the other.
+      ++mRunningTasks;
+      --queue.mSizes.at(p);
+      --mPendingTasks.at(p);
+      lock.unlock();
+
+      if (i > 0) {
+        ++mStolenTasks;
+      }
+
+      auto waited  = std::chrono::steady_clock::now() - task.mEnqueueTime;
+      auto latency = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+
+      auto& counters = mCounters.at(p);
+      ++counters.mStartedTasks;
+      counters.mTotalLatency += latency;
+
+      uint64_t maximum = counters.mMaximumLatency.load();
+      while (latency > maximum &&
+             !counters.mMaximumLatency.compare_exchange_weak(maximum, latency)) {
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::work(size_t worker) {
+  sCurrentPool   = this;
+  sCurrentWorker = worker;
+
+  FrameStats::setThreadName(mName + " #" + std::to_string(worker + 1));
+
+  while (true) {
+    Task task;
+
+    if (!pop(worker, task)) {
+      Lock lock(mMutex);
+
+      // The pool is only stopped once all pending tasks have been executed.
+      if (mStop && getPendingTaskCount() == 0) {
+        return;
+      }
+
+      mCondition.wait(lock, [this] { return mStop || getPendingTaskCount() > 0; });
+      continue;
+    }
+
+    {
+      FrameStats::ScopedOwner owner(task.mOwner);
+      FrameStats::ScopedTimer timer(task.mTimerId, FrameStats::TimerMode::eCPU);
+      task.mFunction();
+    }
+
+    --mRunningTasks;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::utils
@@ -8,25 +8,79 @@
 #ifndef CS_UTILS_THREADPOOL_HPP
 #define CS_UTILS_THREADPOOL_HPP
 
+#include "FrameStats.hpp"
+#include "Tracing.hpp"
 #include "cs_utils_export.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <stack>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
 namespace cs::utils {
 
-/// This is based on https://github.com/progschj/ThreadPool
+/// The ThreadPool executes work items on a fixed number of worker threads. Each worker owns a
+/// separate queue per priority class, so enqueueing and dequeueing rarely contend on the same
+/// mutex. Idle workers steal tasks from the queues of other workers. A worker will always execute
+/// the oldest task of the highest priority class available in any queue; hence low-priority work
+/// can never starve high-priority work. Within one priority class, tasks are executed roughly in
+/// the order in which they were enqueued.
+///
+/// Each executed task is recorded as a CPU range in the FrameStats. The workers are named after
+/// their pool, so that the ranges of different pools can be told apart. Tasks which are enqueued
+/// within a FrameStats::ScopedOwner are executed within the same owner and are recorded with a
+/// separate timer per owner, so their time is attributed to the owner. The mutexes are
+/// instrumented with CS_TRACE_MUTEX(), so contention can be analyzed with an external profiler.
+/// The queue depths of all pools are published to the Metrics, accumulated per pool name.
+/// The original version was based on https://github.com/progschj/ThreadPool
 class CS_UTILS_EXPORT ThreadPool {
  public:
-  /// Creates a new ThreadPool with the specified amount of threads.
-  explicit ThreadPool(size_t threads);
+  /// Each task is assigned to one of these priority classes.
+  enum class Priority {
+    eHigh,   ///< For work someone is waiting for, for example loading currently visible tiles.
+    eNormal, ///< The default priority, for example for prefetching data which may be needed soon.
+    eLow     ///< For background work, for example downloading datasets for later use.
+  };
+
+  static constexpr size_t PRIORITY_COUNT = 3;
+
+  /// Some counters which can be used to monitor the load of the ThreadPool. See getStatistics().
+  struct Statistics {
+    /// The number of tasks which are currently waiting for execution, per priority class.
+    std::array<uint32_t, PRIORITY_COUNT> mPendingTasks{};
+
+    /// The number of tasks which are currently being executed.
+    uint32_t mRunningTasks{};
+
+    /// The number of tasks which have been started since the last call to resetStatistics(), per
+    /// priority class.
+    std::array<uint64_t, PRIORITY_COUNT> mStartedTasks{};
+
+    /// The number of tasks which were executed by another worker than the one they were enqueued
+    /// to since the last call to resetStatistics().
+    uint64_t mStolenTasks{};
+
+    /// The average and maximum time in milliseconds tasks had to wait between being enqueued and
+    /// being started, per priority class. This is measured since the last call to
+    /// resetStatistics().
+    std::array<double, PRIORITY_COUNT> mAverageLatency{};
+    std::array<double, PRIORITY_COUNT> mMaximumLatency{};
+  };
+
+  /// Creates a new ThreadPool with the specified amount of threads. The name is used for the
+  /// workers and the tasks in the FrameStats.
+  explicit ThreadPool(size_t threads, std::string name = "ThreadPool");
 
   ThreadPool(ThreadPool const& other) = delete;
   ThreadPool(ThreadPool&& other)      = delete;
@@ -36,52 +90,103 @@ class CS_UTILS_EXPORT ThreadPool {
 
   virtual ~ThreadPool();
 
-  /// Adds a new work item to the pool.
+  /// Adds a new work item with Priority::eNormal to the pool.
   template <class F>
   auto enqueue(F&& f) -> std::future<typename std::invoke_result<F>::type> {
+    return enqueue(Priority::eNormal, std::forward<F>(f));
+  }
+
+  /// Adds a new work item with the given priority to the pool. Throws a std::runtime_error if the
+  /// pool is currently being destroyed.
+  template <class F>
+  auto enqueue(Priority priority, F&& f) -> std::future<typename std::invoke_result<F>::type> {
     using return_type = typename std::invoke_result<F>::type;
 
     auto task = std::make_shared<std::packaged_task<return_type()>>(
         [Func = std::forward<F>(f)] { return Func(); });
 
     std::future<return_type> res = task->get_future();
-    {
-      std::unique_lock<std::mutex> lock(mMutex);
-
-      if (mStop) {
-        throw std::runtime_error("enqueue on stopped ThreadPool");
-      }
-
-      mTasks.emplace([task]() { (*task)(); });
-    }
-    mCondition.notify_one();
+    push(priority, [task]() { (*task)(); });
     return res;
   }
 
+  /// Returns the name which has been passed to the constructor.
+  std::string const& getName() const;
+
   /// Returns the amount of tasks that await execution.
-  uint32_t getPendingTaskCount() const {
-    std::unique_lock<std::mutex> lock(mMutex);
-    return static_cast<uint32_t>(mTasks.size());
-  }
+  uint32_t getPendingTaskCount() const;
+
+  /// Returns the amount of tasks of the given priority class that await execution.
+  uint32_t getPendingTaskCount(Priority priority) const;
 
   /// Returns the number of tasks that currently are being executed.
-  uint32_t getRunningTaskCount() const {
-    std::unique_lock<std::mutex> lock(mMutex);
-    return mRunningTasks;
-  }
+  uint32_t getRunningTaskCount() const;
 
   /// Retruns true when there are no more tasks running or pending.
   bool hasFinished() const {
     return getPendingTaskCount() + getRunningTaskCount() == 0;
   }
 
+  /// Returns the current queue depths and the latency counters accumulated since the last call to
+  /// resetStatistics().
+  Statistics getStatistics() const;
+
+  /// Resets the accumulated counters of the statistics. The pending and running task counts are
+  /// not affected.
+  void resetStatistics();
+
  private:
-  std::vector<std::thread>          mWorkers;
-  std::stack<std::function<void()>> mTasks;
-  mutable std::mutex                mMutex;
-  std::condition_variable           mCondition;
-  bool                              mStop;
-  uint32_t                          mRunningTasks = 0;
+  using Lock = std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)>;
+
+  struct Task {
+    std::function<void()>                 mFunction;
+    std::chrono::steady_clock::time_point mEnqueueTime;
+    std::optional<FrameStats::TimerId>    mOwner;
+    FrameStats::TimerId                   mTimerId{};
+  };
+
+  /// Each worker owns one of these. The sizes are stored separately so that other workers can
+  /// check for available work without locking the mutex.
+  struct Queue {
+    CS_TRACE_MUTEX(std::mutex, mMutex);
+    std::array<std::deque<Task>, PRIORITY_COUNT>      mTasks;
+    std::array<std::atomic<uint32_t>, PRIORITY_COUNT> mSizes{};
+  };
+
+  /// Latency counters are accumulated in nanoseconds.
+  struct Counters {
+    std::atomic<uint64_t> mStartedTasks{};
+    std::atomic<uint64_t> mTotalLatency{};
+    std::atomic<uint64_t> mMaximumLatency{};
+  };
+
+  void push(Priority priority, std::function<void()> function);
+
+  // Returns the timer for the tasks of the given owner. mMutex has to be locked.
+  FrameStats::TimerId getTaskTimerId(std::optional<FrameStats::TimerId> const& owner);
+
+  bool pop(size_t worker, Task& task);
+  void work(size_t worker);
+
+  std::vector<std::thread>            mWorkers;
+  std::vector<std::unique_ptr<Queue>> mQueues;
+  std::atomic<size_t>                 mNextQueue{};
+
+  std::array<std::atomic<uint32_t>, PRIORITY_COUNT> mPendingTasks{};
+  std::atomic<uint32_t>                             mRunningTasks{};
+
+  std::array<Counters, PRIORITY_COUNT> mCounters;
+  std::atomic<uint64_t>                mStolenTasks{};
+
+  std::string         mName;
+  FrameStats::TimerId mTaskTimerId;
+
+  // The task timers of all owners which have enqueued tasks so far. This is protected by mMutex.
+  std::map<FrameStats::TimerId, FrameStats::TimerId> mOwnerTaskTimerIds;
+
+  mutable CS_TRACE_MUTEX(std::mutex, mMutex);
+  tracing::ConditionVariable mCondition;
+  bool                       mStop = false;
 };
 
 } // namespace cs::utils
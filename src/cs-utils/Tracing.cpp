@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "Tracing.hpp"
+
+#include <string>
+
+namespace cs::utils::tracing {
+
+#if defined(COSMOSCOUT_TRACY)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScopedZone::ScopedZone(std::string_view name) {
+  // Tracy copies the source location, so the name does not have to outlive the zone.
+  uint64_t location = ___tracy_alloc_srcloc_name(
+      __LINE__, __FILE__, sizeof(__FILE__) - 1, "", 0, name.data(), name.size(), 0);
+  mContext = ___tracy_emit_zone_begin_alloc(location, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScopedZone::~ScopedZone() {
+  ___tracy_emit_zone_end(mContext);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#elif defined(COSMOSCOUT_ITT)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+__itt_domain* getIttDomain() {
+  static __itt_domain* domain = __itt_domain_create(ITT_DOMAIN_NAME);
+  return domain;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void markFrame() {
+  // This is only called from the main thread.
+  static bool frameStarted = false;
+
+  if (frameStarted) {
+    __itt_frame_end_v3(getIttDomain(), nullptr);
+  }
+
+  __itt_frame_begin_v3(getIttDomain(), nullptr);
+  frameStarted = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScopedZone::ScopedZone(std::string_view name) {
+  // ITT keeps a table of all string handles, so creating the same handle again is only a lookup.
+  __itt_task_begin(getIttDomain(), __itt_null, __itt_null,
+      __itt_string_handle_create(std::string(name).c_str()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScopedZone::~ScopedZone() {
+  __itt_task_end(getIttDomain());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif
+
+} // namespace cs::utils::tracing
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_TRACING_HPP
+#define CS_UTILS_TRACING_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <string_view>
+
+// This header provides some macros which can be used to instrument the code for an external
+// profiler. The backend is chosen at compile time: If CosmoScout VR is configured with
+// -DCOSMOSCOUT_TRACY=On, the macros are mapped onto the Tracy profiler
+// (https://github.com/wolfpld/tracy), with -DCOSMOSCOUT_ITT=On they are mapped onto the ITT API of
+// Intel VTune. Else all macros expand to nothing (or to the plain mutex types), so they have no
+// overhead at all.
+//
+// CS_TRACE_ZONE("name")                 Records a zone from this line to the end of the scope. The
+//                                       name has to be a string literal.
+// CS_TRACE_PLOT("name", value)          Adds a value to the plot of the given name. The name has to
+//                                       be a string literal.
+// CS_TRACE_FRAME_MARK()                 Marks the end of a frame. This is called by the FrameStats.
+// CS_TRACE_MUTEX(type, name)            Declares a mutex of the given type whose contention can be
+//                                       analyzed in the profiler.
+// CS_TRACE_MUTEX_TYPE(type)             The type of a mutex declared with CS_TRACE_MUTEX(), for
+//                                       example std::unique_lock<CS_TRACE_MUTEX_TYPE(std::mutex)>.
+//
+// All FrameStats::ScopedTimers automatically create a zone as well. Locks of the instrumented
+// mutexes can only be waited on with cs::utils::tracing::ConditionVariable.
+
+#if defined(COSMOSCOUT_TRACY) && defined(COSMOSCOUT_ITT)
+#error "COSMOSCOUT_TRACY and COSMOSCOUT_ITT cannot be enabled at the same time."
+#endif
+
+#if defined(COSMOSCOUT_TRACY)
+
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyC.h>
+
+#define CS_TRACE_ZONE(name) ZoneScopedN(name)
+#define CS_TRACE_PLOT(name, value) TracyPlot(name, value)
+#define CS_TRACE_FRAME_MARK() FrameMark
+#define CS_TRACE_MUTEX(type, name) TracyLockable(type, name)
+#define CS_TRACE_MUTEX_TYPE(type) LockableBase(type)
+
+#elif defined(COSMOSCOUT_ITT)
+
+#include <ittnotify.h>
+
+#define CS_TRACE_CONCAT_IMPL(a, b) a##b
+#define CS_TRACE_CONCAT(a, b) CS_TRACE_CONCAT_IMPL(a, b)
+
+#define CS_TRACE_ZONE(name)                                                                        \
+  static __itt_string_handle* const CS_TRACE_CONCAT(csTraceHandle, __LINE__) =                     \
+      __itt_string_handle_create(name);                                                            \
+  cs::utils::tracing::IttZone const CS_TRACE_CONCAT(csTraceZone, __LINE__)(                        \
+      CS_TRACE_CONCAT(csTraceHandle, __LINE__))
+#define CS_TRACE_PLOT(name, value)                                                                 \
+  do {                                                                                             \
+    static __itt_counter const csTraceCounter = __itt_counter_create_typed(                       \
+        name, cs::utils::tracing::ITT_DOMAIN_NAME, __itt_metadata_double);                         \
+    double csTraceValue = static_cast<double>(value);                                              \
+    __itt_counter_set_value(csTraceCounter, &csTraceValue);                                        \
+  } while (false)
+#define CS_TRACE_FRAME_MARK() cs::utils::tracing::markFrame()
+#define CS_TRACE_MUTEX(type, name) type name
+#define CS_TRACE_MUTEX_TYPE(type) type
+
+#else
+
+#define CS_TRACE_ZONE(name)
+#define CS_TRACE_PLOT(name, value)
+#define CS_TRACE_FRAME_MARK()
+#define CS_TRACE_MUTEX(type, name) type name
+#define CS_TRACE_MUTEX_TYPE(type) type
+
+#endif
+
+#if defined(COSMOSCOUT_TRACY) || defined(COSMOSCOUT_ITT)
+#define COSMOSCOUT_TRACING
+#endif
+
+namespace cs::utils::tracing {
+
+/// Tracy wraps the instrumented mutexes, so in this case the generic condition variable is
+/// required.
+#if defined(COSMOSCOUT_TRACY)
+using ConditionVariable = std::condition_variable_any;
+#else
+using ConditionVariable = std::condition_variable;
+#endif
+
+#if defined(COSMOSCOUT_TRACING)
+
+/// Records a zone with a name which is only known at run time. This is used by the
+/// FrameStats::ScopedTimer; as the name has to be copied for each zone, CS_TRACE_ZONE() should be
+/// preferred where possible.
+class CS_UTILS_EXPORT ScopedZone {
+ public:
+  explicit ScopedZone(std::string_view name);
+
+  ScopedZone(ScopedZone const& other) = delete;
+  ScopedZone(ScopedZone&& other)      = delete;
+
+  ScopedZone& operator=(ScopedZone const& other) = delete;
+  ScopedZone& operator=(ScopedZone&& other)      = delete;
+
+  ~ScopedZone();
+
+ private:
+#if defined(COSMOSCOUT_TRACY)
+  TracyCZoneCtx mContext;
+#endif
+};
+
+#endif
+
+#if defined(COSMOSCOUT_ITT)
+
+/// All tasks, frames and counters are recorded in this domain.
+constexpr char const* ITT_DOMAIN_NAME = "CosmoScout VR";
+
+CS_UTILS_EXPORT __itt_domain* getIttDomain();
+
+/// Ends the current frame and begins the next one.
+CS_UTILS_EXPORT void markFrame();
+
+/// Used by CS_TRACE_ZONE(). The string handle is created only once per call site.
+class IttZone {
+ public:
+  explicit IttZone(__itt_string_handle* handle) {
+    __itt_task_begin(getIttDomain(), __itt_null, __itt_null, handle);
+  }
+
+  IttZone(IttZone const& other) = delete;
+  IttZone(IttZone&& other)      = delete;
+
+  IttZone& operator=(IttZone const& other) = delete;
+  IttZone& operator=(IttZone&& other)      = delete;
+
+  ~IttZone() {
+    __itt_task_end(getIttDomain());
+  }
+};
+
+#endif
+
+} // namespace cs::utils::tracing
+
+#endif // CS_UTILS_TRACING_HPP
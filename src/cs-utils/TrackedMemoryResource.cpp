@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TrackedMemoryResource.hpp"
+
+#include "Metrics.hpp"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace cs::utils {
+
+namespace {
+
+// All resources created with TrackedMemoryResource::get() are published to the Metrics by one
+// collector. The resources are never destroyed, so containers which are destroyed after the
+// registry can still release their memory.
+struct ResourceRegistry {
+  std::mutex                                                    mMutex;
+  std::map<std::string, std::unique_ptr<TrackedMemoryResource>> mResources;
+
+  ResourceRegistry() {
+    Metrics::get().addCollector([this](Metrics& metrics) { collect(metrics); });
+  }
+
+  void collect(Metrics& metrics) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto const& [subsystem, resource] : mResources) {
+      auto            statistics = resource->getStatistics();
+      Metrics::Labels labels{{"subsystem", subsystem}};
+
+      metrics
+          .getSample("cosmoscout_heap_bytes", Metrics::Type::eGauge,
+              "The heap memory allocated by the subsystems.", labels)
+          .set(static_cast<double>(statistics.mBytes));
+      metrics
+          .getSample("cosmoscout_heap_peak_bytes", Metrics::Type::eGauge,
+              "The maximum heap memory allocated by the subsystems at the same time.", labels)
+          .set(static_cast<double>(statistics.mPeakBytes));
+      metrics
+          .getSample("cosmoscout_heap_allocations", Metrics::Type::eGauge,
+              "The number of live heap allocations of the subsystems.", labels)
+          .set(static_cast<double>(statistics.mAllocations));
+      metrics
+          .getSample("cosmoscout_heap_allocations_total", Metrics::Type::eCounter,
+              "The number of heap allocations made by the subsystems.", labels)
+          .set(static_cast<double>(statistics.mTotalAllocations));
+    }
+  }
+};
+
+// The registry is never destroyed, as static containers may be destroyed after it.
+ResourceRegistry& getResourceRegistry() {
+  static auto* registry = new ResourceRegistry(); // NOLINT(cppcoreguidelines-owning-memory)
+  return *registry;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TrackedMemoryResource& TrackedMemoryResource::get(std::string const& subsystem) {
+  auto&                       registry = getResourceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+
+  auto& resource = registry.mResources[subsystem];
+  if (!resource) {
+    resource = std::make_unique<TrackedMemoryResource>(subsystem);
+  }
+
+  return *resource;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, TrackedMemoryResource::Statistics> TrackedMemoryResource::getAllStatistics() {
+  auto&                       registry = getResourceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+
+  std::map<std::string, Statistics> statistics;
+  for (auto const& [subsystem, resource] : registry.mResources) {
+    statistics.emplace(subsystem, resource->getStatistics());
+  }
+
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TrackedMemoryResource::TrackedMemoryResource(
+    std::string subsystem, std::pmr::memory_resource* upstream)
+    : mSubsystem(std::move(subsystem))
+    , mUpstream(upstream) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& TrackedMemoryResource::getSubsystem() const {
+  return mSubsystem;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TrackedMemoryResource::Statistics TrackedMemoryResource::getStatistics() const {
+  Statistics statistics;
+  statistics.mBytes            = mBytes.load(std::memory_order_relaxed);
+  statistics.mAllocations      = mAllocations.load(std::memory_order_relaxed);
+  statistics.mPeakBytes        = mPeakBytes.load(std::memory_order_relaxed);
+  statistics.mTotalAllocations = mTotalAllocations.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* TrackedMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+
+  // If the upstream resource throws, nothing is counted.
+  void* p = mUpstream->allocate(bytes, alignment);
+
+  auto current = mBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  mAllocations.fetch_add(1, std::memory_order_relaxed);
+  mTotalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+  auto peak = mPeakBytes.load(std::memory_order_relaxed);
+  while (current > peak &&
+         !mPeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+  }
+
+  return p;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrackedMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+  mUpstream->deallocate(p, bytes, alignment);
+  mBytes.fetch_sub(bytes, std::memory_order_relaxed);
+  mAllocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TrackedMemoryResource::do_is_equal(std::pmr::memory_resource const& other) const noexcept {
+
+  // Memory allocated from one resource may only be released by the same resource, else the
+  // counters would be wrong.
+  return this == &other;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
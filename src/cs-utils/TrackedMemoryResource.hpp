@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_TRACKED_MEMORY_RESOURCE_HPP
+#define CS_UTILS_TRACKED_MEMORY_RESOURCE_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+
+namespace cs::utils {
+
+/// A std::pmr::memory_resource which forwards all allocations to an upstream resource and counts
+/// the allocated bytes. This makes it possible to see how much heap memory the individual
+/// subsystems of CosmoScout VR use, which the global allocator cannot tell. Containers opt in by
+/// using a std::pmr container with the resource of their subsystem:
+///
+/// std::pmr::vector<float> data(&TrackedMemoryResource::get("LOD Tiles"));
+///
+/// The resources returned by get() are published to the cs::utils::Metrics, so their usage can be
+/// monitored with the /metrics endpoint of csp-web-api. csp-timings shows them next to the GPU
+/// memory. Memory which is still growing after hours indicates a leak in this subsystem.
+///
+/// All methods are thread-safe. Counting is lock-free, the overhead of each allocation is a few
+/// atomic operations.
+class CS_UTILS_EXPORT TrackedMemoryResource : public std::pmr::memory_resource {
+ public:
+  /// The counters of one resource.
+  struct Statistics {
+    /// The number of bytes and allocations which are currently allocated.
+    std::size_t mBytes{};
+    std::size_t mAllocations{};
+
+    /// The maximum number of bytes which have been allocated at the same time.
+    std::size_t mPeakBytes{};
+
+    /// The number of allocations which have been made so far.
+    uint64_t mTotalAllocations{};
+  };
+
+  /// Returns the resource of the given subsystem. It is created on first use and never destroyed,
+  /// so it can be used by static containers as well. The subsystem names should be short and
+  /// human-readable, like "LOD Tiles".
+  static TrackedMemoryResource& get(std::string const& subsystem);
+
+  /// Returns the counters of all resources which have been created with get().
+  static std::map<std::string, Statistics> getAllStatistics();
+
+  /// Resources which are created directly are not published anywhere. This is mainly useful for
+  /// tests or for tracking allocations from a custom upstream resource.
+  explicit TrackedMemoryResource(
+      std::string subsystem, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+  TrackedMemoryResource(TrackedMemoryResource const& other) = delete;
+  TrackedMemoryResource(TrackedMemoryResource&& other)      = delete;
+
+  TrackedMemoryResource& operator=(TrackedMemoryResource const& other) = delete;
+  TrackedMemoryResource& operator=(TrackedMemoryResource&& other)      = delete;
+
+  ~TrackedMemoryResource() override = default;
+
+  /// Returns the name which has been passed to the constructor.
+  std::string const& getSubsystem() const;
+
+  /// Returns the current counters of this resource.
+  Statistics getStatistics() const;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void  do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool  do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+
+  std::string                mSubsystem;
+  std::pmr::memory_resource* mUpstream;
+  std::atomic<std::size_t>   mBytes{};
+  std::atomic<std::size_t>   mAllocations{};
+  std::atomic<std::size_t>   mPeakBytes{};
+  std::atomic<uint64_t>      mTotalAllocations{};
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_TRACKED_MEMORY_RESOURCE_HPP
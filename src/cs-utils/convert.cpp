@@ -7,11 +7,17 @@
 
 #include "convert.hpp"
 
+#include "ThreadPool.hpp"
 #include "logger.hpp"
+#include "utils.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cspice/SpiceUsr.h>
+#include <future>
 #include <glm/gtc/type_ptr.hpp>
+#include <vector>
 
 namespace cs::utils::convert {
 
@@ -108,6 +114,218 @@ glm::dvec3 cartesianToNormal(glm::dvec3 const& cartesian, glm::dvec3 const& radi
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// The batch conversions process this many points at once. The coordinates of a block are stored as
+// structure of arrays, so that the loops below can be vectorized.
+constexpr std::size_t BLOCK_SIZE = 8;
+
+// If a ThreadPool is given, the input is split into chunks of this many points.
+constexpr std::size_t PARALLEL_CHUNK_SIZE = 4096;
+
+// The iterative search of scaleToGeodeticSurface() stops after this many iterations even if not
+// all points of a block have converged. Usually, two or three iterations are sufficient.
+constexpr int MAX_GEODETIC_ITERATIONS = 32;
+
+struct Block {
+  std::array<double, BLOCK_SIZE> x{};
+  std::array<double, BLOCK_SIZE> y{};
+  std::array<double, BLOCK_SIZE> z{};
+};
+
+// Loads up to BLOCK_SIZE points into the given block. Unused slots are filled with a point on the
+// surface of the ellipsoid, so they converge immediately.
+void loadBlock(glm::dvec3 const* points, std::size_t count, glm::dvec3 const& radii, Block& block) {
+  for (std::size_t i(0); i < BLOCK_SIZE; ++i) {
+    glm::dvec3 p = i < count ? points[i] : glm::dvec3(radii.x, 0.0, 0.0);
+    block.x[i]   = p.x;
+    block.y[i]   = p.y;
+    block.z[i]   = p.z;
+  }
+}
+
+// The same algorithm as scaleToGeodeticSurface() above, but for all points of a block at once.
+void scaleToGeodeticSurface(Block const& cartesian, glm::dvec3 const& radii, Block& surface) {
+  glm::dvec3 radii2        = radii * radii;
+  glm::dvec3 radii4        = radii2 * radii2;
+  glm::dvec3 oneOverRadii2 = 1.0 / radii2;
+
+  std::array<double, BLOCK_SIZE> alpha{};
+  std::array<double, BLOCK_SIZE> dx{};
+  std::array<double, BLOCK_SIZE> dy{};
+  std::array<double, BLOCK_SIZE> dz{};
+
+  for (std::size_t i(0); i < BLOCK_SIZE; ++i) {
+    double x = cartesian.x[i];
+    double y = cartesian.y[i];
+    double z = cartesian.z[i];
+
+    double beta = 1.0 / std::sqrt(x * x * oneOverRadii2.x + y * y * oneOverRadii2.y +
+                                  z * z * oneOverRadii2.z);
+    double nx   = beta * x * oneOverRadii2.x;
+    double ny   = beta * y * oneOverRadii2.y;
+    double nz   = beta * z * oneOverRadii2.z;
+    double n    = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+    alpha[i] = (1.0 - beta) * (std::sqrt(x * x + y * y + z * z) / n);
+  }
+
+  for (int iteration(0); iteration < MAX_GEODETIC_ITERATIONS; ++iteration) {
+    double maxError = 0.0;
+
+    for (std::size_t i(0); i < BLOCK_SIZE; ++i) {
+      double x2 = cartesian.x[i] * cartesian.x[i];
+      double y2 = cartesian.y[i] * cartesian.y[i];
+      double z2 = cartesian.z[i] * cartesian.z[i];
+
+      dx[i] = 1.0 + alpha[i] * oneOverRadii2.x;
+      dy[i] = 1.0 + alpha[i] * oneOverRadii2.y;
+      dz[i] = 1.0 + alpha[i] * oneOverRadii2.z;
+
+      double s = x2 / (radii2.x * dx[i] * dx[i]) + y2 / (radii2.y * dy[i] * dy[i]) +
+                 z2 / (radii2.z * dz[i] * dz[i]) - 1.0;
+
+      double dSdA = (x2 / (radii4.x * dx[i] * dx[i] * dx[i]) +
+                        y2 / (radii4.y * dy[i] * dy[i] * dy[i]) +
+                        z2 / (radii4.z * dz[i] * dz[i] * dz[i])) *
+                    -2.0;
+
+      maxError = std::max(maxError, std::abs(s));
+
+      // If all points have converged, the updated alpha is not used anymore.
+      alpha[i] -= s / dSdA;
+    }
+
+    if (maxError <= 1e-10) {
+      break;
+    }
+  }
+
+  for (std::size_t i(0); i < BLOCK_SIZE; ++i) {
+    surface.x[i] = cartesian.x[i] / dx[i];
+    surface.y[i] = cartesian.y[i] / dy[i];
+    surface.z[i] = cartesian.z[i] / dz[i];
+  }
+}
+
+// The same as surfaceToLngLat() above, but for the first count points of a block.
+void surfaceToLngLat(
+    Block const& surface, std::size_t count, glm::dvec3 const& radii, glm::dvec2* lngLat) {
+  glm::dvec3 oneOverRadii2 = 1.0 / (radii * radii);
+
+  Block normal;
+
+  for (std::size_t i(0); i < BLOCK_SIZE; ++i) {
+    double x   = surface.x[i] * oneOverRadii2.x;
+    double y   = surface.y[i] * oneOverRadii2.y;
+    double z   = surface.z[i] * oneOverRadii2.z;
+    double len = 1.0 / std::sqrt(x * x + y * y + z * z);
+
+    normal.x[i] = x * len;
+    normal.y[i] = y * len;
+    normal.z[i] = z * len;
+  }
+
+  for (std::size_t i(0); i < count; ++i) {
+    lngLat[i] = glm::dvec2(std::atan2(normal.x[i], normal.z[i]), std::asin(normal.y[i]));
+  }
+}
+
+// Calls f(begin, end) for consecutive ranges of at most BLOCK_SIZE points. If a pool is given and
+// there are many points, the ranges are processed in parallel in chunks of PARALLEL_CHUNK_SIZE.
+template <typename F>
+void forEachBlock(std::size_t count, ThreadPool* pool, F const& f) {
+  auto processRange = [&f](std::size_t begin, std::size_t end) {
+    for (std::size_t i(begin); i < end; i += BLOCK_SIZE) {
+      f(i, std::min(i + BLOCK_SIZE, end));
+    }
+  };
+
+  if (!pool || count <= PARALLEL_CHUNK_SIZE) {
+    processRange(0, count);
+    return;
+  }
+
+  std::vector<std::future<void>> chunks;
+
+  for (std::size_t i(0); i < count; i += PARALLEL_CHUNK_SIZE) {
+    std::size_t end = std::min(i + PARALLEL_CHUNK_SIZE, count);
+    chunks.push_back(pool->enqueue(
+        ThreadPool::Priority::eHigh, [&processRange, i, end]() { processRange(i, end); }));
+  }
+
+  for (auto& chunk : chunks) {
+    chunk.get();
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void scaleToGeodeticSurface(glm::dvec3 const* cartesian, glm::dvec3* surface, std::size_t count,
+    glm::dvec3 const& radii, ThreadPool* pool) {
+  forEachBlock(count, pool, [&](std::size_t begin, std::size_t end) {
+    Block in;
+    Block out;
+    loadBlock(cartesian + begin, end - begin, radii, in);
+    scaleToGeodeticSurface(in, radii, out);
+
+    for (std::size_t i(0); i < end - begin; ++i) {
+      surface[begin + i] = glm::dvec3(out.x[i], out.y[i], out.z[i]);
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void surfaceToLngLat(glm::dvec3 const* cartesian, glm::dvec2* lngLat, std::size_t count,
+    glm::dvec3 const& radii, ThreadPool* pool) {
+  forEachBlock(count, pool, [&](std::size_t begin, std::size_t end) {
+    Block in;
+    loadBlock(cartesian + begin, end - begin, radii, in);
+    surfaceToLngLat(in, end - begin, radii, lngLat + begin);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void cartesianToLngLat(glm::dvec3 const* cartesian, glm::dvec2* lngLat, std::size_t count,
+    glm::dvec3 const& radii, ThreadPool* pool) {
+  forEachBlock(count, pool, [&](std::size_t begin, std::size_t end) {
+    Block in;
+    Block surface;
+    loadBlock(cartesian + begin, end - begin, radii, in);
+    scaleToGeodeticSurface(in, radii, surface);
+    surfaceToLngLat(surface, end - begin, radii, lngLat + begin);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void cartesianToLngLatHeight(glm::dvec3 const* cartesian, glm::dvec3* lngLatHeight,
+    std::size_t count, glm::dvec3 const& radii, ThreadPool* pool) {
+  forEachBlock(count, pool, [&](std::size_t begin, std::size_t end) {
+    Block in;
+    Block surface;
+    loadBlock(cartesian + begin, end - begin, radii, in);
+    scaleToGeodeticSurface(in, radii, surface);
+
+    std::array<glm::dvec2, BLOCK_SIZE> lngLat{};
+    surfaceToLngLat(surface, end - begin, radii, lngLat.data());
+
+    for (std::size_t i(0); i < end - begin; ++i) {
+      glm::dvec3 point(in.x[i], in.y[i], in.z[i]);
+      glm::dvec3 dir    = point - glm::dvec3(surface.x[i], surface.y[i], surface.z[i]);
+      double     height = std::copysign(1.0, glm::dot(dir, point)) * glm::length(dir);
+
+      lngLatHeight[begin + i] = glm::dvec3(lngLat.at(i), height);
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace time {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -123,6 +341,8 @@ double toSpice(boost::posix_time::ptime const& tIn) {
 
   double dTime = (tIn - j2000).total_milliseconds() / secondsToMillis;
 
+  std::lock_guard<std::recursive_mutex> lock(getSpiceMutex());
+
   // Incorporate delta between ET and UTC.
   double ETUTCDelta = 0.0;
   deltet_c(dTime, "UTC", &ETUTCDelta);
@@ -177,6 +397,8 @@ boost::posix_time::ptime toPosix(double tIn) {
   auto const noon            = 12;
   auto const secondsToMillis = 1000;
 
+  std::lock_guard<std::recursive_mutex> lock(getSpiceMutex());
+
   // Incorporate delta between ET and UTC.
   double ETUTCDelta = 0.0;
   deltet_c(tIn, "ET", &ETUTCDelta);
@@ -16,6 +16,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <cstddef>
+
+namespace cs::utils {
+class ThreadPool;
+} // namespace cs::utils
+
 /// This namespace contains utility functions for converting numbers between different units of
 /// measuring. Most of the coordinate system conversion methods are based on the code from the
 /// excellent book "3D Engine Design for Virtual Globes" by Patrick Cozzi and Kevin Ring
@@ -99,6 +105,26 @@ CS_UTILS_EXPORT glm::dvec3 surfaceToNormal(glm::dvec3 const& cartesian, glm::dve
 /// operation, as it involes scaleToGeodeticSurface().
 CS_UTILS_EXPORT glm::dvec3 cartesianToNormal(glm::dvec3 const& cartesian, glm::dvec3 const& radii);
 
+/// Batch variants of the conversions above. Each converts count points from the input array and
+/// writes the results to the output array, which has to have room for count elements. The points
+/// are processed in small blocks which are stored as structure of arrays, so that the compiler can
+/// vectorize the arithmetic. The iterative search of scaleToGeodeticSurface() runs in lockstep for
+/// all points of a block until all of them have converged. Up to rounding, the results are the
+/// same as if the single-point variants were called in a loop.
+///
+/// If a ThreadPool is given, large inputs are split into chunks of several thousand points which
+/// are converted in parallel on the pool. The call blocks until all chunks are done, so it must
+/// not be made from a task running on the same pool.
+CS_UTILS_EXPORT void scaleToGeodeticSurface(glm::dvec3 const* cartesian, glm::dvec3* surface,
+    std::size_t count, glm::dvec3 const& radii, ThreadPool* pool = nullptr);
+CS_UTILS_EXPORT void surfaceToLngLat(glm::dvec3 const* cartesian, glm::dvec2* lngLat,
+    std::size_t count, glm::dvec3 const& radii, ThreadPool* pool = nullptr);
+CS_UTILS_EXPORT void cartesianToLngLat(glm::dvec3 const* cartesian, glm::dvec2* lngLat,
+    std::size_t count, glm::dvec3 const& radii, ThreadPool* pool = nullptr);
+CS_UTILS_EXPORT void cartesianToLngLatHeight(glm::dvec3 const* cartesian,
+    glm::dvec3* lngLatHeight, std::size_t count, glm::dvec3 const& radii,
+    ThreadPool* pool = nullptr);
+
 /// Time in CosmoScout VR is passed around in different formats.
 /// * Strings usually store time in the ISO format YYYY-MM-DDTHH:MM:SS.fffZ. The 'Z' suffix is not
 ///   really required on the C++ side, as time strings are always considered to be in UTC. This
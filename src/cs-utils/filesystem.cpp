@@ -7,14 +7,11 @@
 
 #include "filesystem.hpp"
 
+#include "HttpClient.hpp"
 #include "utils.hpp"
 
-#include <curlpp/Easy.hpp>
-#include <curlpp/Info.hpp>
-#include <curlpp/Infos.hpp>
-#include <curlpp/Options.hpp>
-
 #include <cmath>
+#include <fstream>
 #include <iostream>
 
 namespace cs::utils::filesystem {
@@ -89,27 +86,54 @@ void writeStringToFile(std::string const& filePath, std::string const& content)
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void downloadFile(std::string const& url, std::string const& destination,
-    std::function<void(double, double)> const& progressCallback) {
+    std::function<void(double, double)> const& progressCallback, bool resume) {
   createDirectoryRecursively(boost::filesystem::path(destination).parent_path());
-  std::ofstream stream(destination, std::ofstream::out | std::ofstream::binary);
 
-  if (!stream) {
-    throw std::runtime_error("Failed to open " + destination + " for downloading " + url + "!");
+  auto perform = [&](std::uintmax_t offset) {
+    auto mode = std::ofstream::out | std::ofstream::binary |
+                (offset > 0 ? std::ofstream::app : std::ofstream::trunc);
+    std::ofstream stream(destination, mode);
+
+    if (!stream) {
+      throw std::runtime_error("Failed to open " + destination + " for downloading " + url + "!");
+    }
+
+    HttpClient::Request request;
+    request.mUrl              = url;
+    request.mPriority         = HttpClient::Priority::eLow;
+    request.mOutput           = &stream;
+    request.mProgressCallback = [&](double total, double now) {
+      auto start = static_cast<double>(offset);
+      progressCallback(start + now, total > 0.0 ? start + total : 0.0);
+      return false;
+    };
+
+    if (offset > 0) {
+      request.mHeaders.push_back("Range: bytes=" + std::to_string(offset) + "-");
+    }
+
+    return HttpClient::get().perform(request).mResponseCode;
+  };
+
+  std::uintmax_t offset = 0;
+  if (resume && boost::filesystem::exists(destination)) {
+    offset = boost::filesystem::file_size(destination);
   }
 
-  curlpp::Easy request;
-  request.setOpt(curlpp::options::Url(url));
-  request.setOpt(curlpp::options::WriteStream(&stream));
-  request.setOpt(curlpp::options::NoSignal(true));
-  request.setOpt(curlpp::options::NoProgress(false));
-  request.setOpt(curlpp::options::SslVerifyPeer(false));
-  request.setOpt(curlpp::options::ProgressFunction(
-      [&](double a, double b, double /*unused*/, double /*unused*/) {
-        progressCallback(b, a);
-        return 0;
-      }));
-
-  request.perform();
+  long responseCode = perform(offset);
+
+  // The server sends the entire file if it does not support range requests. In this case, it has
+  // been appended to the partial file, so we have to start over.
+  if (offset > 0 && responseCode != 206) {
+    responseCode = perform(0);
+  }
+
+  // Error pages must not be resumed by the next attempt.
+  if (responseCode >= 400) {
+    boost::filesystem::remove(destination);
+    throw std::runtime_error(
+        "Failed to download " + url + ": HTTP response code " + std::to_string(responseCode) + "!");
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
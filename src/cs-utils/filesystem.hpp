@@ -46,8 +46,10 @@ CS_UTILS_EXPORT void writeStringToFile(std::string const& filePath, std::string
 /// be created. This will throw a std::runtime_error if something bad happend.
 /// progressCallback will be called regularly, the first parameter is the amount of downloaded
 /// bytes, the second the total amount to be downloaded.
+/// If resume is set and the destination file already exists, only the remaining part is requested
+/// with a range request. If the server does not support this, the file is downloaded again.
 CS_UTILS_EXPORT void downloadFile(std::string const& url, std::string const& destination,
-    std::function<void(double, double)> const& progressCallback);
+    std::function<void(double, double)> const& progressCallback, bool resume = false);
 
 } // namespace cs::utils::filesystem
 
@@ -7,10 +7,16 @@
 
 #include "logger.hpp"
 
+#include "MPSCQueue.hpp"
+
 #include <VistaBase/VistaStreamUtils.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/dist_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <cctype>
 #include <sstream>
+#include <unordered_map>
 #include <utility>
 
 namespace cs::utils {
@@ -45,14 +51,24 @@ class SpdlogBuffer : public std::streambuf {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// The messages are not emitted directly, as this sink is used by the logging thread. Instead, they
+// are queued and emitted on the main thread by emitLogMessages().
 class SignalSink : public spdlog::sinks::base_sink<std::mutex> {
  public:
   Signal<std::string, spdlog::level::level_enum, std::string> onLogMessage;
 
+  struct Message {
+    std::string               mLogger;
+    spdlog::level::level_enum mLevel{};
+    std::string               mMessage;
+  };
+
+  MPSCQueue<Message> mMessages;
+
  protected:
   void sink_it_(spdlog::details::log_msg const& msg) override {
-    onLogMessage.emit(std::string(msg.logger_name.begin(), msg.logger_name.end()), msg.level,
-        std::string(msg.payload.begin(), msg.payload.end()));
+    mMessages.push({std::string(msg.logger_name.begin(), msg.logger_name.end()), msg.level,
+        std::string(msg.payload.begin(), msg.payload.end())});
   }
 
   void flush_() override {
@@ -61,6 +77,98 @@ class SignalSink : public spdlog::sinks::base_sink<std::mutex> {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// This sink forwards messages to the signal, console and file sinks. Messages which are logged
+// more than MAX_MESSAGES_PER_SITE times per second from the same site are suppressed. A site is
+// identified by the logger, the level and the message with all digits removed, so that messages
+// like "Failed to load tile 3/42!" are aggregated. Once per second, the number of suppressed
+// messages is reported for each site. As this is only checked when a message is logged, the
+// reports are also flushed by emitLogMessages(), so that the end of a burst is reported as well.
+class RateLimitSink : public spdlog::sinks::dist_sink<std::mutex> {
+ public:
+  static constexpr uint32_t MAX_MESSAGES_PER_SITE = 10;
+
+  explicit RateLimitSink(std::vector<spdlog::sink_ptr> sinks)
+      : spdlog::sinks::dist_sink<std::mutex>(std::move(sinks)) {
+  }
+
+  // Reports the suppressed messages if the current window has expired.
+  void flushSuppressed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reportSuppressed(spdlog::log_clock::now());
+  }
+
+ protected:
+  void sink_it_(spdlog::details::log_msg const& msg) override {
+    reportSuppressed(msg.time);
+
+    std::string key(msg.logger_name.begin(), msg.logger_name.end());
+    key += std::to_string(static_cast<int>(msg.level));
+
+    for (char c : msg.payload) {
+      if (std::isdigit(static_cast<unsigned char>(c)) == 0) {
+        key += c;
+      }
+    }
+
+    auto& site = mSites[key];
+
+    if (site.mCount < MAX_MESSAGES_PER_SITE) {
+      ++site.mCount;
+      spdlog::sinks::dist_sink<std::mutex>::sink_it_(msg);
+    } else {
+      site.mLogger.assign(msg.logger_name.begin(), msg.logger_name.end());
+      site.mLevel = msg.level;
+      site.mMessage.assign(msg.payload.begin(), msg.payload.end());
+
+      ++site.mSuppressed;
+    }
+  }
+
+ private:
+  struct Site {
+    uint32_t mCount      = 0;
+    uint32_t mSuppressed = 0;
+
+    // The last suppressed message is reported together with the count.
+    std::string               mLogger;
+    spdlog::level::level_enum mLevel{};
+    std::string               mMessage;
+  };
+
+  // Once per second, the number of suppressed messages is reported and all counters are reset.
+  void reportSuppressed(spdlog::log_clock::time_point now) {
+    if (now - mWindowStart < std::chrono::seconds(1)) {
+      return;
+    }
+
+    mWindowStart = now;
+
+    for (auto const& [key, site] : mSites) {
+      if (site.mSuppressed > 0) {
+        auto text = fmt::format("{} (suppressed {} similar messages in the last second)",
+            site.mMessage, site.mSuppressed);
+        spdlog::details::log_msg report(site.mLogger, site.mLevel, text);
+        spdlog::sinks::dist_sink<std::mutex>::sink_it_(report);
+      }
+    }
+
+    mSites.clear();
+  }
+
+  std::unordered_map<std::string, Site> mSites;
+  spdlog::log_clock::time_point         mWindowStart;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<RateLimitSink> getRateLimitSink() {
+  static auto sink = std::make_shared<RateLimitSink>(std::vector<spdlog::sink_ptr>{
+      getLoggerSignalSink(), getLoggerCoutSink(), getLoggerFileSink()});
+  return sink;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -105,7 +213,30 @@ Signal<std::string, spdlog::level::level_enum, std::string> const& onLogMessage(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::unique_ptr<spdlog::logger> createLogger(std::string const& name) {
+void emitLogMessages() {
+  // Messages which have been suppressed in a window which has expired since then are reported
+  // first, so that their summary is emitted below.
+  getRateLimitSink()->flushSuppressed();
+
+  auto sink = std::dynamic_pointer_cast<SignalSink>(getLoggerSignalSink());
+
+  // If a connected slot logs something, its message will be emitted in the next call. Hence the
+  // number of messages per call is limited.
+  uint32_t const maxMessages = 1000;
+
+  for (uint32_t i(0); i < maxMessages; ++i) {
+    auto message = sink->mMessages.tryPop();
+    if (!message) {
+      break;
+    }
+
+    sink->onLogMessage.emit(message->mLogger, message->mLevel, message->mMessage);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<spdlog::logger> createLogger(std::string const& name) {
   size_t const prefixLength = 20;
 
   // Append some ... to the name of the logger to make the output more readable.
@@ -115,9 +246,12 @@ std::unique_ptr<spdlog::logger> createLogger(std::string const& name) {
   }
   paddedName.back() = ' ';
 
-  std::vector<spdlog::sink_ptr> sinks = {
-      getLoggerSignalSink(), getLoggerCoutSink(), getLoggerFileSink()};
-  auto logger = std::make_unique<spdlog::logger>(paddedName, sinks.begin(), sinks.end());
+  // All loggers share one thread which formats the messages and writes them to the sinks. If its
+  // queue is full, the oldest messages are dropped, so logging never blocks the calling thread.
+  static auto threadPool = std::make_shared<spdlog::details::thread_pool>(8192, 1);
+
+  auto logger = std::make_shared<spdlog::async_logger>(paddedName, getRateLimitSink(), threadPool,
+      spdlog::async_overflow_policy::overrun_oldest);
 
   // See https://github.com/gabime/spdlog/wiki/3.-Custom-formatting for formatting options.
   logger->set_pattern("%^[%L] %n%$%v"); // NOLINT(clang-analyzer-cplusplus.Move)
@@ -68,15 +68,22 @@ CS_UTILS_EXPORT spdlog::logger& logger();
 /// This creates the default logger for vista and is called at startup by the main() method.
 CS_UTILS_EXPORT void initVistaLogger();
 
-/// This signal is emitted whenever a message is logged with spdlog. The first argument is the
-/// logger's name, the second the log level, the last argument is the message.
+/// This signal is emitted for each message which has been logged with spdlog. The first argument is
+/// the logger's name, the second the log level, the last argument is the message. The messages are
+/// queued and emitted on the main thread by emitLogMessages().
 CS_UTILS_EXPORT Signal<std::string, spdlog::level::level_enum, std::string> const& onLogMessage();
 
+/// Emits onLogMessage() for all messages which have been logged since the last call. This is called
+/// once each frame by the Application.
+CS_UTILS_EXPORT void emitLogMessages();
+
 /// Call this method once from your plugin in order to create a new logger. The given name will
 /// be shown together with the log level in each message. The logger will print to the console and
 /// store it's messages in a file called cosmoscout.log. If you want to, you could store the
 /// returned logger in function static variable in order to create a singleton.
-CS_UTILS_EXPORT std::unique_ptr<spdlog::logger> createLogger(std::string const& name);
+/// The messages are written asynchronously by a background thread. Messages which are logged very
+/// often from the same site are aggregated, see the implementation for details.
+CS_UTILS_EXPORT std::shared_ptr<spdlog::logger> createLogger(std::string const& name);
 
 /// Adjust the log level for each sink seperately.
 CS_UTILS_EXPORT spdlog::sink_ptr getLoggerSignalSink();
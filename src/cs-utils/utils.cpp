@@ -12,7 +12,9 @@
 #include <VistaKernel/DisplayManager/VistaViewport.h>
 #include <VistaKernel/VistaSystem.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <iostream>
 #include <memory>
 
@@ -134,4 +136,31 @@ std::string exec(std::string const& cmd) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+int getFrontToBackSortKey(DrawOrder order, double distance) {
+
+  // Each factor of ten in distance uses five sort keys. The distances from 1e-6 to 1e14 are mapped
+  // to the 100 available keys, everything else is clamped.
+  double const keysPerDecade = 5.0;
+  double const minExponent   = -6.0;
+
+  // This also catches NaNs.
+  if (!(distance > 0.0)) {
+    return static_cast<int>(order);
+  }
+
+  double offset = (std::log10(distance) - minExponent) * keysPerDecade;
+  offset        = std::clamp(offset, 0.0, 99.0);
+
+  return static_cast<int>(order) + static_cast<int>(offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::recursive_mutex& getSpiceMutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::utils
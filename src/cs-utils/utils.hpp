@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -51,6 +52,13 @@ enum class CS_UTILS_EXPORT DrawOrder : int {
   eGui              = 900
 };
 
+/// Returns a sort key in the range [order, order + 100) for an opaque object at the given distance
+/// from the observer. Closer objects get smaller keys, so objects of the same DrawOrder are drawn
+/// front-to-back. Fragments of objects further away are then rejected by the early depth test
+/// instead of being shaded. The distance may be given in any unit, but all objects which are
+/// sorted against each other have to use the same unit.
+CS_UTILS_EXPORT int getFrontToBackSortKey(DrawOrder order, double distance);
+
 template <typename T>
 bool contains(T const& container, typename T::value_type const& item) {
   return std::find(std::begin(container), std::end(container), item) != std::end(container);
@@ -117,6 +125,11 @@ constexpr typename std::underlying_type<T>::type enumCast(T val) {
 /// Executes a system command and returns the output.
 std::string exec(std::string const& cmd);
 
+/// CSPICE is not thread-safe. Every call to a CSPICE function has to be made while holding this
+/// mutex, as SPICE queries may be evaluated on the worker thread of the cs::scene::EphemerisService.
+/// It is recursive, so that functions which hold it may call other functions which do the same.
+CS_UTILS_EXPORT std::recursive_mutex& getSpiceMutex();
+
 /// Can be used to check the operating system at compile time.
 enum class OS { eLinux, eWindows };
 
@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/FlatHashMap.hpp"
+#include "../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <unordered_map>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::FlatHashMap::find [benchmark]" * doctest::skip()) {
+  uint64_t const count = 10000;
+
+  FlatHashMap<uint64_t, uint64_t>        flat;
+  std::unordered_map<uint64_t, uint64_t> node;
+
+  for (uint64_t i = 0; i < count; ++i) {
+    flat[i * 7] = i;
+    node[i * 7] = i;
+  }
+
+  uint64_t key = 0;
+  uint64_t sum = 0;
+
+  MicroBenchmark::run("FlatHashMap::find", [&]() {
+    sum += flat.find(key)->second;
+    key = (key + 7) % (count * 7);
+    doNotOptimize(sum);
+  });
+
+  MicroBenchmark::run("std::unordered_map::find", [&]() {
+    sum += node.find(key)->second;
+    key = (key + 7) % (count * 7);
+    doNotOptimize(sum);
+  });
+}
+} // namespace cs::utils
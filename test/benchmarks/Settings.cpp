@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-core/Settings.hpp"
+#include "../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+#include "../../src/cs-utils/filesystem.hpp"
+
+#include <boost/filesystem.hpp>
+
+namespace cs::core {
+TEST_CASE("cs::core::Settings [benchmark]" * doctest::skip()) {
+
+  // The benchmarks are executed in the bin directory of the installation.
+  std::string const file = "../share/config/simple_desktop.json";
+
+  if (!boost::filesystem::exists(file)) {
+    WARN_MESSAGE(false, "The settings file '" + file + "' does not exist!");
+    return;
+  }
+
+  std::string const content = utils::filesystem::loadToString(file);
+
+  utils::MicroBenchmark::run("Settings parse JSON", [&]() {
+    auto json = nlohmann::json::parse(content);
+    utils::doNotOptimize(json);
+  });
+
+  utils::MicroBenchmark::run("Settings from_json", [&]() {
+    Settings settings;
+    from_json(nlohmann::json::parse(content), settings);
+    utils::doNotOptimize(settings);
+  });
+
+  Settings settings;
+  from_json(nlohmann::json::parse(content), settings);
+
+  utils::MicroBenchmark::run("Settings to_json", [&]() {
+    nlohmann::json json;
+    to_json(json, settings);
+    auto result = json.dump(2);
+    utils::doNotOptimize(result);
+  });
+}
+} // namespace cs::core
@@ -0,0 +1,28 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../src/cs-utils/Signal.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+namespace cs::utils {
+TEST_CASE("cs::utils::Signal::emit [benchmark]" * doctest::skip()) {
+  int sum = 0;
+
+  for (int slots : {1, 10, 100}) {
+    Signal<int> signal;
+    for (int i = 0; i < slots; ++i) {
+      signal.connect([&sum](int value) { sum += value; });
+    }
+
+    MicroBenchmark::run("Signal::emit (" + std::to_string(slots) + " slots)", [&]() {
+      signal.emit(1);
+      doNotOptimize(sum);
+    });
+  }
+}
+} // namespace cs::utils
@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/MicroBenchmark.hpp"
+#include "../../src/cs-utils/ThreadPool.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::ThreadPool::enqueue [benchmark]" * doctest::skip()) {
+
+  // The time per task includes enqueueing, executing and waiting for the result of trivial tasks,
+  // so this measures the overhead of the pool itself.
+  uint64_t const tasks = 1000;
+
+  for (size_t threads : {1U, 4U}) {
+    ThreadPool       pool(threads);
+    std::atomic<int> counter{0};
+
+    std::vector<std::future<void>> results;
+    results.reserve(tasks);
+
+    MicroBenchmark::run(
+        "ThreadPool::enqueue (" + std::to_string(threads) + " threads)",
+        [&]() {
+          for (uint64_t i = 0; i < tasks; ++i) {
+            results.emplace_back(pool.enqueue([&counter]() { ++counter; }));
+          }
+
+          for (auto& result : results) {
+            result.wait();
+          }
+
+          results.clear();
+        },
+        tasks);
+  }
+}
+} // namespace cs::utils
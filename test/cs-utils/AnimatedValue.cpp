@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/AnimatedValue.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <cmath>
+
+namespace cs::utils {
+
+TEST_CASE("cs::utils::AnimatedValue::get") {
+  for (auto direction : {AnimationDirection::eIn, AnimationDirection::eOut,
+           AnimationDirection::eInOut, AnimationDirection::eOutIn, AnimationDirection::eLinear}) {
+    AnimatedValue<double> value(10.0, 20.0, 1.0, 3.0, direction);
+
+    CHECK_EQ(value.get(0.0), 10.0);
+    CHECK_EQ(value.get(1.0), doctest::Approx(10.0));
+    CHECK_EQ(value.get(3.0), 20.0);
+    CHECK_EQ(value.get(4.0), 20.0);
+
+    // All directions except eIn and eOut are symmetric.
+    if (direction != AnimationDirection::eIn && direction != AnimationDirection::eOut) {
+      CHECK_EQ(value.get(2.0), doctest::Approx(15.0));
+    }
+  }
+
+  AnimatedValue<double> value(0.0, 1.0, 0.0, 1.0, AnimationDirection::eInOut);
+  CHECK_EQ(value.get(0.25), doctest::Approx(0.5 * std::pow(0.5, 4.0)));
+}
+
+TEST_CASE("cs::utils::AnimatedValue::getDerivative") {
+  for (auto direction : {AnimationDirection::eIn, AnimationDirection::eOut,
+           AnimationDirection::eInOut, AnimationDirection::eOutIn, AnimationDirection::eLinear}) {
+    AnimatedValue<glm::dvec3> value(
+        glm::dvec3(0.0), glm::dvec3(10.0, -5.0, 2.0), 2.0, 6.0, direction, 1.5);
+
+    // The derivative matches the central difference quotient of get().
+    for (double t = 2.1; t < 6.0; t += 0.3) {
+      double     h        = 1e-6;
+      glm::dvec3 expected = (value.get(t + h) - value.get(t - h)) / (2.0 * h);
+      CHECK_EQ(glm::distance(value.getDerivative(t), expected), doctest::Approx(0.0).epsilon(1e-5));
+    }
+
+    CHECK_EQ(value.getDerivative(1.0), glm::dvec3(0.0));
+    CHECK_EQ(value.getDerivative(7.0), glm::dvec3(0.0));
+  }
+}
+
+} // namespace cs::utils
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/ChebyshevSeries.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <cmath>
+
+namespace cs::utils {
+
+TEST_CASE("cs::utils::ChebyshevSeries::getNodes") {
+  auto nodes = ChebyshevSeries::getNodes(10.0, 20.0, 5);
+
+  CHECK_EQ(nodes.size(), 5);
+
+  // The nodes are symmetric around the center of the interval.
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    CHECK_GT(nodes[i], 10.0);
+    CHECK_LT(nodes[i], 20.0);
+    CHECK_EQ(nodes[i] + nodes[nodes.size() - 1 - i], doctest::Approx(30.0));
+  }
+}
+
+TEST_CASE("cs::utils::ChebyshevSeries::evaluate") {
+  double start = 100.0;
+  double end   = 200.0;
+
+  auto function = [](double t) {
+    return glm::dvec3(std::sin(t * 0.05), std::cos(t * 0.03), 0.001 * t * t - t);
+  };
+
+  std::vector<glm::dvec3> samples;
+  for (double t : ChebyshevSeries::getNodes(start, end, 16)) {
+    samples.push_back(function(t));
+  }
+
+  ChebyshevSeries series(start, end, samples);
+
+  CHECK_EQ(series.getStart(), start);
+  CHECK_EQ(series.getEnd(), end);
+
+  for (double t = start; t <= end; t += 7.0) {
+    CHECK_EQ(glm::distance(series.evaluate(t), function(t)), doctest::Approx(0.0).epsilon(1e-9));
+  }
+}
+
+TEST_CASE("cs::utils::ChebyshevSeries::evaluate with a single coefficient") {
+  ChebyshevSeries series(0.0, 1.0, {glm::dvec3(1.0, 2.0, 3.0)});
+
+  CHECK_EQ(series.evaluate(0.5), glm::dvec3(1.0, 2.0, 3.0));
+}
+
+} // namespace cs::utils
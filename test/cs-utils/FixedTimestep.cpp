@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/FixedTimestep.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+namespace cs::utils {
+
+TEST_CASE("cs::utils::FixedTimestep::advance") {
+  FixedTimestep timestep(0.25);
+
+  // The first call only stores the time.
+  CHECK_EQ(timestep.advance(10.0), 0);
+
+  // The remainder is carried over to the next call.
+  CHECK_EQ(timestep.advance(10.375), 1);
+  CHECK_EQ(timestep.getAlpha(), doctest::Approx(0.5));
+  CHECK_EQ(timestep.advance(10.5), 1);
+  CHECK_EQ(timestep.getAlpha(), doctest::Approx(0.0));
+
+  // Many small frames result in the same number of steps as one long frame.
+  uint32_t steps = 0;
+  for (int i = 1; i <= 101; ++i) {
+    steps += timestep.advance(10.5 + i * 0.01);
+  }
+  CHECK_EQ(steps, 4);
+
+  // Time going backwards does not result in any steps.
+  CHECK_EQ(timestep.advance(5.0), 0);
+}
+
+TEST_CASE("cs::utils::FixedTimestep::advance with long frames") {
+  FixedTimestep timestep(0.1, 5);
+
+  CHECK_EQ(timestep.advance(0.0), 0);
+
+  // At most five steps are returned and the surplus time is dropped.
+  CHECK_EQ(timestep.advance(2.0), 5);
+  CHECK_EQ(timestep.getAlpha(), doctest::Approx(0.0));
+  CHECK_EQ(timestep.advance(2.15), 1);
+
+  timestep.reset();
+  CHECK_EQ(timestep.advance(100.0), 0);
+}
+
+} // namespace cs::utils
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/FlatHashMap.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::FlatHashMap::try_emplace") {
+  FlatHashMap<std::string, int> map;
+
+  CHECK(map.empty());
+  CHECK(map.find("a") == map.end());
+
+  CHECK(map.try_emplace("a", 1).second);
+  CHECK(map.try_emplace("b", 2).second);
+  CHECK_FALSE(map.try_emplace("a", 3).second);
+
+  CHECK_EQ(map.size(), 2);
+  CHECK_EQ(map.at("a"), 1);
+  CHECK_EQ(map["b"], 2);
+  CHECK_EQ(map["c"], 0);
+  CHECK_EQ(map.size(), 3);
+  CHECK_THROWS_AS(map.at("d"), std::out_of_range);
+}
+
+TEST_CASE("cs::utils::FlatHashMap::erase") {
+  FlatHashMap<int, std::unique_ptr<int>> map;
+
+  for (int i = 0; i < 1000; ++i) {
+    map.try_emplace(i, std::make_unique<int>(i));
+  }
+
+  CHECK_EQ(map.erase(1000), 0);
+  CHECK_EQ(map.erase(0), 1);
+  CHECK_EQ(map.size(), 999);
+
+  // Erasing does not invalidate iterators to other elements.
+  for (auto it = map.begin(); it != map.end();) {
+    auto current = it++;
+    if (current->first % 2 == 0) {
+      map.erase(current);
+    }
+  }
+
+  CHECK_EQ(map.size(), 500);
+
+  int count = 0;
+  for (auto const& [key, value] : map) {
+    CHECK_EQ(key % 2, 1);
+    CHECK_EQ(*value, key);
+    ++count;
+  }
+
+  CHECK_EQ(count, 500);
+
+  map.clear();
+  CHECK(map.empty());
+  CHECK(map.begin() == map.end());
+}
+
+TEST_CASE("cs::utils::FlatHashMap compared to std::unordered_map") {
+  FlatHashMap<uint64_t, uint64_t>        map;
+  std::unordered_map<uint64_t, uint64_t> reference;
+
+  // Few distinct keys result in many deleted slots which have to be reused.
+  std::mt19937_64                         generator(42);
+  std::uniform_int_distribution<uint64_t> keys(0, 2000);
+
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t key = keys(generator);
+
+    if (generator() % 3 == 0) {
+      CHECK_EQ(map.erase(key), reference.erase(key));
+    } else {
+      map[key] += i;
+      reference[key] += i;
+    }
+  }
+
+  REQUIRE_EQ(map.size(), reference.size());
+
+  for (auto const& [key, value] : reference) {
+    auto it = map.find(key);
+    REQUIRE(it != map.end());
+    CHECK_EQ(it->second, value);
+  }
+}
+
+TEST_CASE("cs::utils::FlatHashMap::reserve") {
+  FlatHashMap<int, int> map;
+  map.reserve(1000);
+
+  auto capacity = map.capacity();
+  CHECK_GE(capacity, 1000);
+
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = i;
+  }
+
+  CHECK_EQ(map.capacity(), capacity);
+
+  FlatHashMap<int, int> moved(std::move(map));
+  CHECK_EQ(moved.size(), 1000);
+  CHECK_EQ(moved.at(999), 999);
+}
+} // namespace cs::utils
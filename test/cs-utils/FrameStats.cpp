@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/FrameStats.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::FrameStats::intern") {
+  auto a = FrameStats::intern("Test Timer A");
+  auto b = FrameStats::intern("Test Timer B");
+
+  CHECK_NE(a, b);
+  CHECK_EQ(FrameStats::intern(std::string("Test Timer ") + "A"), a);
+  CHECK_EQ(FrameStats::intern(std::string_view("Test Timer B")), b);
+
+  CHECK_EQ(FrameStats::getName(a), "Test Timer A");
+  CHECK_EQ(FrameStats::getName(b), "Test Timer B");
+}
+
+TEST_CASE("cs::utils::FrameStats::intern from multiple threads") {
+  int const threadCount = 4;
+  int const nameCount   = 1000;
+
+  std::vector<std::vector<FrameStats::TimerId>> ids(threadCount);
+  std::vector<std::thread>                      threads;
+
+  for (int t = 0; t < threadCount; ++t) {
+    threads.emplace_back([&ids, t]() {
+      for (int i = 0; i < nameCount; ++i) {
+        ids[t].push_back(FrameStats::intern("Concurrent Timer " + std::to_string(i)));
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // All threads must have received the same ID for the same name.
+  for (int t = 1; t < threadCount; ++t) {
+    CHECK_EQ(ids[t], ids[0]);
+  }
+
+  for (int i = 0; i < nameCount; ++i) {
+    CHECK_EQ(FrameStats::getName(ids[0][i]), "Concurrent Timer " + std::to_string(i));
+  }
+}
+
+TEST_CASE("cs::utils::FrameStats::ScopedOwner") {
+  auto unowned = FrameStats::intern("Unowned Timer");
+  auto plugin  = FrameStats::intern("Test Plugin");
+
+  CHECK_FALSE(FrameStats::getCurrentOwner());
+
+  {
+    FrameStats::ScopedOwner owner("Test Plugin");
+    CHECK_EQ(FrameStats::getCurrentOwner(), plugin);
+
+    auto owned = FrameStats::intern("Owned Timer");
+    CHECK_EQ(FrameStats::getOwner(owned), plugin);
+
+    // Names which have been interned before are claimed if they do not have an owner yet.
+    FrameStats::intern("Unowned Timer");
+    CHECK_EQ(FrameStats::getOwner(unowned), plugin);
+
+    {
+      FrameStats::ScopedOwner nested(std::nullopt);
+      CHECK_FALSE(FrameStats::getCurrentOwner());
+      CHECK_FALSE(FrameStats::getOwner(FrameStats::intern("Nested Timer")));
+    }
+
+    CHECK_EQ(FrameStats::getCurrentOwner(), plugin);
+  }
+
+  CHECK_FALSE(FrameStats::getCurrentOwner());
+  CHECK_FALSE(FrameStats::getOwner(plugin));
+}
+
+TEST_CASE("cs::utils::FrameStats::accumulateOwnerTimes") {
+  auto a = FrameStats::intern("Owner A");
+  auto b = FrameStats::intern("Owner B");
+
+  auto timerA      = FrameStats::intern("Owner A Timer");
+  auto timerA2     = FrameStats::intern("Owner A Nested Timer");
+  auto timerB      = FrameStats::intern("Owner B Timer");
+  auto timerGlobal = FrameStats::intern("Global Timer");
+  FrameStats::setOwner(timerA, a);
+  FrameStats::setOwner(timerA2, a);
+  FrameStats::setOwner(timerB, b);
+
+  auto range = [](FrameStats::TimerId id, uint32_t level, int64_t start, int64_t end,
+                   FrameStats::TimerMode mode) {
+    FrameStats::TimerQueryResult result;
+    result.mId           = id;
+    result.mNestingLevel = level;
+    result.mCPUStart     = start;
+    result.mCPUEnd       = end;
+    result.mGPUStart     = start;
+    result.mGPUEnd       = start + (end - start) / 2;
+    result.mMode         = mode;
+    return result;
+  };
+
+  // The nested range of owner A must not be counted twice. The range of owner B is nested into an
+  // unowned range.
+  std::vector<FrameStats::TimerQueryResult> results = {
+      range(timerA, 0, 0, 100, FrameStats::TimerMode::eBoth),
+      range(timerA2, 1, 10, 50, FrameStats::TimerMode::eBoth),
+      range(timerGlobal, 0, 100, 400, FrameStats::TimerMode::eBoth),
+      range(timerB, 1, 100, 400, FrameStats::TimerMode::eCPU),
+      range(timerA2, 0, 400, 420, FrameStats::TimerMode::eGPU),
+  };
+
+  // Thread ranges are stored in the order in which they were completed.
+  std::vector<FrameStats::ThreadTimerResults> threadResults(1);
+  threadResults[0].mResults = {{timerA2, 1, 10, 20}, {timerA, 0, 0, 30}, {timerB, 0, 40, 45}};
+
+  auto times = FrameStats::accumulateOwnerTimes(results, threadResults);
+
+  REQUIRE_EQ(times.size(), 2);
+
+  CHECK_EQ(times[0].mOwner, b);
+  CHECK_EQ(times[0].mCPUTime, 300);
+  CHECK_EQ(times[0].mGPUTime, 0);
+  CHECK_EQ(times[0].mThreadTime, 5);
+
+  CHECK_EQ(times[1].mOwner, a);
+  CHECK_EQ(times[1].mCPUTime, 100);
+  CHECK_EQ(times[1].mGPUTime, 60);
+  CHECK_EQ(times[1].mThreadTime, 30);
+}
+} // namespace cs::utils
@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/MPSCQueue.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::MPSCQueue::tryPop") {
+  MPSCQueue<std::unique_ptr<int>> queue;
+
+  CHECK(queue.isEmpty());
+  CHECK_FALSE(queue.tryPop());
+
+  queue.push(std::make_unique<int>(1));
+  queue.push(std::make_unique<int>(2));
+
+  CHECK_FALSE(queue.isEmpty());
+  CHECK_EQ(**queue.tryPop(), 1);
+  CHECK_EQ(**queue.tryPop(), 2);
+  CHECK(queue.isEmpty());
+
+  // Remaining items are destroyed with the queue.
+  queue.push(std::make_unique<int>(3));
+}
+
+TEST_CASE("cs::utils::MPSCQueue::push") {
+  MPSCQueue<int> queue;
+
+  int const threadCount = 4;
+  int const itemCount   = 10000;
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threadCount; ++t) {
+    producers.emplace_back([&queue, t]() {
+      for (int i = 0; i < itemCount; ++i) {
+        queue.push(t * itemCount + i);
+      }
+    });
+  }
+
+  // The items of each producer have to arrive in order.
+  std::vector<int> next(threadCount, 0);
+  int              received = 0;
+
+  while (received < threadCount * itemCount) {
+    if (auto item = queue.tryPop()) {
+      int thread = *item / itemCount;
+      CHECK_EQ(*item % itemCount, next[thread]);
+      ++next[thread];
+      ++received;
+    }
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  CHECK(queue.isEmpty());
+}
+} // namespace cs::utils
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/Metrics.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+namespace cs::utils {
+TEST_CASE("cs::utils::Metrics::getSample") {
+  auto& sample = Metrics::get().getSample("test_metrics_sample", Metrics::Type::eGauge, "Help.");
+  sample.set(2.0);
+  sample.add(0.5);
+  CHECK_EQ(sample.get(), 2.5);
+
+  // The same name and labels result in the same sample.
+  CHECK_EQ(&Metrics::get().getSample("test_metrics_sample", Metrics::Type::eGauge, ""), &sample);
+  CHECK_NE(
+      &Metrics::get().getSample("test_metrics_sample", Metrics::Type::eGauge, "", {{"a", "b"}}),
+      &sample);
+
+  CHECK_THROWS_AS(Metrics::get().getSample("test_metrics_sample", Metrics::Type::eCounter, ""),
+      std::invalid_argument);
+  CHECK_THROWS_AS(
+      Metrics::get().getSample("0_test_metrics", Metrics::Type::eGauge, ""), std::invalid_argument);
+  CHECK_THROWS_AS(Metrics::get().getSample("test metrics", Metrics::Type::eGauge, ""),
+      std::invalid_argument);
+  CHECK_THROWS_AS(
+      Metrics::get().getSample("test_metrics_labels", Metrics::Type::eGauge, "", {{"a:b", "c"}}),
+      std::invalid_argument);
+}
+
+TEST_CASE("cs::utils::Metrics::collect") {
+  Metrics::get()
+      .getSample("test_metrics_collect_total", Metrics::Type::eCounter, "Line\nbreak.",
+          {{"name", "say \"hi\""}, {"index", "1"}})
+      .set(42);
+
+  int id = Metrics::get().addCollector([](Metrics& metrics) {
+    metrics.getSample("test_metrics_collector", Metrics::Type::eGauge, "Collected.").set(1.5);
+  });
+
+  std::string output = Metrics::get().collect();
+  CHECK_NE(output.find("# HELP test_metrics_collect_total Line\\nbreak.\n"), std::string::npos);
+  CHECK_NE(output.find("# TYPE test_metrics_collect_total counter\n"), std::string::npos);
+  CHECK_NE(output.find("test_metrics_collect_total{index=\"1\",name=\"say \\\"hi\\\"\"} 42\n"),
+      std::string::npos);
+  CHECK_NE(output.find("test_metrics_collector 1.5\n"), std::string::npos);
+
+  // Once the collector is removed, its samples keep their last value.
+  Metrics::get().removeCollector(id);
+  Metrics::get().getSample("test_metrics_collector", Metrics::Type::eGauge, "").set(0.0);
+  CHECK_NE(Metrics::get().collect().find("test_metrics_collector 0\n"), std::string::npos);
+}
+} // namespace cs::utils
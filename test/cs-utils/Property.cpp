@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/Property.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <memory>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::Property::set") {
+  Property<int> a(1);
+
+  int oldValue = 0;
+  int newValue = 0;
+
+  a.connect([&](int value) {
+    oldValue = a.get();
+    newValue = value;
+  });
+
+  a.set(2);
+
+  CHECK(oldValue == 1);
+  CHECK(newValue == 2);
+  CHECK(a.get() == 2);
+}
+
+TEST_CASE("cs::utils::Property::setDeferred") {
+  Property<int> a(1);
+  a.setDeferred(true);
+
+  int count    = 0;
+  int newValue = 0;
+
+  a.connect([&](int value) {
+    ++count;
+    newValue = value;
+  });
+
+  a.set(2);
+  a.set(3);
+  a.set(4);
+
+  CHECK(a.get() == 4);
+  CHECK(count == 0);
+
+  emitDeferredPropertyChanges();
+
+  CHECK(count == 1);
+  CHECK(newValue == 4);
+
+  emitDeferredPropertyChanges();
+
+  CHECK(count == 1);
+}
+
+TEST_CASE("cs::utils::Property disable deferred mode with pending change") {
+  Property<int> a(1);
+  a.setDeferred(true);
+
+  int count = 0;
+  a.connect([&](int /*value*/) { ++count; });
+
+  a.set(2);
+  a.setDeferred(false);
+
+  CHECK(count == 1);
+
+  emitDeferredPropertyChanges();
+
+  CHECK(count == 1);
+}
+
+TEST_CASE("cs::utils::Property destroy deferred property with pending change") {
+  auto a = std::make_unique<Property<int>>(1);
+  a->setDeferred(true);
+  a->set(2);
+  a.reset();
+
+  CHECK_NOTHROW(emitDeferredPropertyChanges());
+}
+
+TEST_CASE("cs::utils::Property set deferred property while emitting") {
+  Property<int> a(1);
+  a.setDeferred(true);
+
+  int count = 0;
+  a.connect([&](int value) {
+    ++count;
+    a.set(value + 1);
+  });
+
+  a.set(2);
+  emitDeferredPropertyChanges();
+
+  CHECK(count == 1);
+  CHECK(a.get() == 3);
+
+  emitDeferredPropertyChanges();
+
+  CHECK(count == 2);
+  CHECK(a.get() == 4);
+}
+
+TEST_CASE("cs::utils::PropertyTransaction") {
+  Property<int> a(1);
+  Property<int> b(1);
+
+  int countA = 0;
+  int countB = 0;
+  a.connect([&](int /*value*/) { ++countA; });
+  b.connect([&](int /*value*/) { ++countB; });
+
+  {
+    PropertyTransaction outer;
+    a.set(2);
+
+    {
+      PropertyTransaction inner;
+      a.set(3);
+      b.set(2);
+    }
+
+    CHECK(PropertyTransaction::getIsActive());
+    CHECK(countA == 0);
+    CHECK(countB == 0);
+  }
+
+  CHECK_FALSE(PropertyTransaction::getIsActive());
+
+  emitDeferredPropertyChanges();
+
+  CHECK(countA == 1);
+  CHECK(countB == 1);
+
+  a.set(4);
+
+  CHECK(countA == 2);
+}
+
+} // namespace cs::utils
@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/Sha256.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+namespace cs::utils {
+TEST_CASE("cs::utils::Sha256::getHexDigest") {
+  auto hash = [](std::string const& data) {
+    Sha256 sha;
+    sha.update(data);
+    return sha.getHexDigest();
+  };
+
+  CHECK_EQ(hash(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  CHECK_EQ(hash("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+  // This fills exactly one block before padding, so the padding requires a second block.
+  CHECK_EQ(hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+TEST_CASE("cs::utils::Sha256::update") {
+  // The result must not depend on how the data is split.
+  Sha256 sha;
+  for (int i = 0; i < 1000; ++i) {
+    sha.update(std::string(1000, 'a'));
+  }
+
+  CHECK_EQ(sha.getHexDigest(), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+} // namespace cs::utils
@@ -212,4 +212,46 @@ TEST_CASE("cs::utils::Signal disconnect all slots while emitting for all but one
   CHECK_FALSE(test3);
 }
 
+TEST_CASE("cs::utils::Signal connect slot while emitting") {
+  int count1 = 0;
+  int count2 = 0;
+
+  Signal<bool> a;
+
+  a.connect([&](bool /*value*/) {
+    if (++count1 == 1) {
+      a.connect([&](bool /*value*/) { ++count2; });
+    }
+  });
+
+  a.emit(true);
+
+  CHECK(count1 == 1);
+  CHECK(count2 == 0);
+
+  a.emit(true);
+
+  CHECK(count1 == 2);
+  CHECK(count2 == 1);
+
+  a.disconnectAll();
+}
+
+TEST_CASE("cs::utils::Signal disconnect slot connected while emitting") {
+  int count = 0;
+
+  Signal<bool> a;
+
+  a.connect([&](bool /*value*/) {
+    int id = a.connect([&](bool /*value*/) { ++count; });
+    a.disconnect(id);
+  });
+
+  a.emit(true);
+  a.disconnectAll();
+  a.emit(true);
+
+  CHECK(count == 0);
+}
+
 } // namespace cs::utils
\ No newline at end of file
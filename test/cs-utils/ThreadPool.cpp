@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/ThreadPool.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <atomic>
+#include <optional>
+#include <string>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::ThreadPool::enqueue") {
+  ThreadPool pool(4);
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i) {
+    results.emplace_back(pool.enqueue([i]() { return i * i; }));
+  }
+
+  for (int i = 0; i < 100; ++i) {
+    CHECK_EQ(results[i].get(), i * i);
+  }
+}
+
+TEST_CASE("cs::utils::ThreadPool::enqueue(Priority)") {
+  ThreadPool pool(1);
+
+  // Block the only worker until all tasks have been enqueued.
+  std::promise<void> started;
+  std::promise<void> start;
+  auto               blocker = start.get_future().share();
+  pool.enqueue(ThreadPool::Priority::eLow, [&started, blocker]() {
+    started.set_value();
+    blocker.wait();
+  });
+  started.get_future().wait();
+
+  std::mutex  mutex;
+  std::string order;
+
+  auto append = [&](char c) {
+    return [&, c]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      order += c;
+    };
+  };
+
+  pool.enqueue(ThreadPool::Priority::eLow, append('e'));
+  pool.enqueue(ThreadPool::Priority::eNormal, append('c'));
+  pool.enqueue(ThreadPool::Priority::eHigh, append('a'));
+  pool.enqueue(ThreadPool::Priority::eNormal, append('d'));
+  pool.enqueue(ThreadPool::Priority::eHigh, append('b'));
+
+  CHECK_EQ(pool.getPendingTaskCount(ThreadPool::Priority::eHigh), 2);
+  CHECK_EQ(pool.getPendingTaskCount(ThreadPool::Priority::eNormal), 2);
+  CHECK_EQ(pool.getPendingTaskCount(ThreadPool::Priority::eLow), 1);
+
+  start.set_value();
+
+  while (!pool.hasFinished()) {
+    std::this_thread::yield();
+  }
+
+  CHECK_EQ(order, "abcde");
+}
+
+TEST_CASE("cs::utils::ThreadPool::getStatistics") {
+  ThreadPool pool(4);
+
+  std::atomic<int> counter = 0;
+
+  // Tasks enqueued from within a task are stolen by the idle workers.
+  pool.enqueue([&]() {
+        for (int i = 0; i < 50; ++i) {
+          pool.enqueue(ThreadPool::Priority::eLow, [&]() { ++counter; });
+        }
+      })
+      .wait();
+
+  while (!pool.hasFinished()) {
+    std::this_thread::yield();
+  }
+
+  auto statistics = pool.getStatistics();
+
+  CHECK_EQ(counter, 50);
+  CHECK_EQ(statistics.mRunningTasks, 0);
+  CHECK_EQ(statistics.mStartedTasks[static_cast<size_t>(ThreadPool::Priority::eNormal)], 1);
+  CHECK_EQ(statistics.mStartedTasks[static_cast<size_t>(ThreadPool::Priority::eLow)], 50);
+  CHECK_GE(statistics.mMaximumLatency[static_cast<size_t>(ThreadPool::Priority::eLow)],
+      statistics.mAverageLatency[static_cast<size_t>(ThreadPool::Priority::eLow)]);
+
+  pool.resetStatistics();
+  CHECK_EQ(pool.getStatistics().mStartedTasks[static_cast<size_t>(ThreadPool::Priority::eLow)], 0);
+}
+
+TEST_CASE("cs::utils::ThreadPool tasks inherit the owner") {
+  ThreadPool pool(2);
+
+  auto unowned = pool.enqueue([]() { return FrameStats::getCurrentOwner(); });
+
+  std::future<std::optional<FrameStats::TimerId>> owned;
+  {
+    FrameStats::ScopedOwner owner("Thread Pool Test Owner");
+    owned = pool.enqueue([]() { return FrameStats::getCurrentOwner(); });
+  }
+
+  CHECK_FALSE(unowned.get());
+  CHECK_EQ(owned.get(), FrameStats::intern("Thread Pool Test Owner"));
+}
+} // namespace cs::utils
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/TrackedMemoryResource.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <vector>
+
+namespace cs::utils {
+TEST_CASE("cs::utils::TrackedMemoryResource") {
+  TrackedMemoryResource resource("Test");
+
+  {
+    std::pmr::vector<int> a(100, &resource);
+    CHECK_EQ(resource.getStatistics().mBytes, 100 * sizeof(int));
+    CHECK_EQ(resource.getStatistics().mAllocations, 1);
+
+    {
+      std::pmr::vector<int> b(50, &resource);
+      CHECK_EQ(resource.getStatistics().mBytes, 150 * sizeof(int));
+      CHECK_EQ(resource.getStatistics().mAllocations, 2);
+    }
+
+    CHECK_EQ(resource.getStatistics().mBytes, 100 * sizeof(int));
+  }
+
+  auto statistics = resource.getStatistics();
+  CHECK_EQ(statistics.mBytes, 0);
+  CHECK_EQ(statistics.mAllocations, 0);
+  CHECK_EQ(statistics.mPeakBytes, 150 * sizeof(int));
+  CHECK_EQ(statistics.mTotalAllocations, 2);
+}
+
+TEST_CASE("cs::utils::TrackedMemoryResource::get") {
+  auto& a = TrackedMemoryResource::get("Test Subsystem A");
+  auto& b = TrackedMemoryResource::get("Test Subsystem B");
+
+  CHECK_NE(&a, &b);
+  CHECK_EQ(&TrackedMemoryResource::get("Test Subsystem A"), &a);
+  CHECK_EQ(a.getSubsystem(), "Test Subsystem A");
+  CHECK_FALSE(a.is_equal(b));
+
+  std::pmr::vector<char> data(42, &a);
+
+  auto statistics = TrackedMemoryResource::getAllStatistics();
+  CHECK_EQ(statistics.at("Test Subsystem A").mBytes, 42);
+  CHECK_EQ(statistics.at("Test Subsystem B").mBytes, 0);
+}
+} // namespace cs::utils
@@ -5,9 +5,12 @@
 // SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
 // SPDX-License-Identifier: MIT
 
+#include "../../src/cs-utils/ThreadPool.hpp"
 #include "../../src/cs-utils/convert.hpp"
 #include "../../src/cs-utils/doctest.hpp"
 
+#include <vector>
+
 namespace cs::utils {
 
 const double PI   = 3.14159265359;
@@ -47,4 +50,59 @@ TEST_CASE("cs::utils::toRadians") {
   CHECK_EQ(convert::toRadians<int32_t>(0), 0);
   CHECK_EQ(convert::toRadians<uint32_t>(0U), 0U);
 }
+
+TEST_CASE("cs::utils::convert::cartesianToLngLatHeight (batch)") {
+  glm::dvec3 const radii(6378137.0, 6356752.3, 6378137.0);
+
+  // Some points above, on and below the surface. The count is not a multiple of the block size.
+  std::vector<glm::dvec3> points;
+  for (int i = 0; i < 10003; ++i) {
+    double     t = i * 0.37;
+    glm::dvec3 direction(std::sin(t) * std::cos(t * 0.1), std::cos(t * 0.3), std::cos(t));
+    points.push_back(glm::normalize(direction) * radii * (0.5 + (i % 7) * 0.25));
+  }
+
+  std::vector<glm::dvec3> lngLatHeight(points.size());
+  std::vector<glm::dvec3> parallel(points.size());
+  std::vector<glm::dvec2> lngLat(points.size());
+
+  ThreadPool pool(4);
+  convert::cartesianToLngLatHeight(points.data(), lngLatHeight.data(), points.size(), radii);
+  convert::cartesianToLngLatHeight(
+      points.data(), parallel.data(), points.size(), radii, &pool);
+  convert::cartesianToLngLat(points.data(), lngLat.data(), points.size(), radii);
+
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    auto expected = convert::cartesianToLngLatHeight(points[i], radii);
+
+    CHECK_EQ(lngLatHeight[i].x, doctest::Approx(expected.x));
+    CHECK_EQ(lngLatHeight[i].y, doctest::Approx(expected.y));
+    CHECK_EQ(lngLatHeight[i].z, doctest::Approx(expected.z).scale(radii.x).epsilon(1e-9));
+    CHECK_EQ(parallel[i], lngLatHeight[i]);
+    CHECK_EQ(lngLat[i].x, lngLatHeight[i].x);
+    CHECK_EQ(lngLat[i].y, lngLatHeight[i].y);
+  }
+}
+
+TEST_CASE("cs::utils::convert::scaleToGeodeticSurface (batch)") {
+  glm::dvec3 const radii(3396190.0, 3376200.0, 3396190.0);
+
+  std::vector<glm::dvec3> points{{1e7, 2e6, -3e6}, {0.0, 5e6, 0.0}, {-1e5, 1e5, 2e5}};
+  std::vector<glm::dvec3> surface(points.size());
+  std::vector<glm::dvec2> lngLat(points.size());
+
+  convert::scaleToGeodeticSurface(points.data(), surface.data(), points.size(), radii);
+  convert::surfaceToLngLat(surface.data(), lngLat.data(), surface.size(), radii);
+
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    auto expected = convert::scaleToGeodeticSurface(points[i], radii);
+    CHECK_EQ(surface[i].x, doctest::Approx(expected.x));
+    CHECK_EQ(surface[i].y, doctest::Approx(expected.y));
+    CHECK_EQ(surface[i].z, doctest::Approx(expected.z));
+
+    auto expectedLngLat = convert::surfaceToLngLat(expected, radii);
+    CHECK_EQ(lngLat[i].x, doctest::Approx(expectedLngLat.x));
+    CHECK_EQ(lngLat[i].y, doctest::Approx(expectedLngLat.y));
+  }
+}
 } // namespace cs::utils
\ No newline at end of file
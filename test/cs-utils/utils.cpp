@@ -50,4 +50,18 @@ TEST_CASE("cs::utils::endsWith") {
   CHECK_UNARY_FALSE(endsWith("lorem ipsum", "abracadabra simsalabim"));
 }
 
+TEST_CASE("cs::utils::getFrontToBackSortKey") {
+  int planets = static_cast<int>(DrawOrder::ePlanets);
+  int opaque  = static_cast<int>(DrawOrder::eOpaqueItems);
+
+  CHECK_LT(getFrontToBackSortKey(DrawOrder::ePlanets, 1.0e3),
+      getFrontToBackSortKey(DrawOrder::ePlanets, 1.0e5));
+  CHECK_LE(getFrontToBackSortKey(DrawOrder::ePlanets, 1.0e5),
+      getFrontToBackSortKey(DrawOrder::ePlanets, 1.1e5));
+
+  CHECK_EQ(getFrontToBackSortKey(DrawOrder::ePlanets, 0.0), planets);
+  CHECK_EQ(getFrontToBackSortKey(DrawOrder::ePlanets, -1.0), planets);
+  CHECK_EQ(getFrontToBackSortKey(DrawOrder::ePlanets, 1.0e30), opaque - 1);
+}
+
 } // namespace cs::utils
\ No newline at end of file
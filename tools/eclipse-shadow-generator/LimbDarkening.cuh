@@ -8,7 +8,7 @@
 #ifndef LIMB_DARKENING_HPP
 #define LIMB_DARKENING_HPP
 
-#include <cuda_runtime.h>
+#include "cuda.cuh"
 
 /// This struct implements a simple wavelength-independent limb darkening model.
 class LimbDarkening {
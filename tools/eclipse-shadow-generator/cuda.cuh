@@ -0,0 +1,21 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CUDA_HPP
+#define CUDA_HPP
+
+// If no Cuda compiler is available, all sources are compiled as plain C++. The __host__ and
+// __device__ qualifiers are then removed and only the multi-threaded CPU implementation is
+// available.
+#ifdef ECLIPSE_SHADOW_GENERATOR_CPU_ONLY
+#define __host__
+#define __device__
+#else
+#include <cuda_runtime.h>
+#endif
+
+#endif // CUDA_HPP
@@ -15,11 +15,21 @@
 #include <stb_image.h>
 #include <stb_image_write.h>
 
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // This tool can be used to create the eclipse shadow maps used by CosmoScout VR. See the         //
 // README.md file in this directory for usage instructions!                                       //
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#ifndef ECLIPSE_SHADOW_GENERATOR_CPU_ONLY
+
 // This macro is used in multiple locations to check for Cuda errors.
 // https://stackoverflow.com/questions/14038589/what-is-the-canonical-way-to-check-for-errors-using-the-cuda-runtime-api
 #define gpuErrchk(ans)                                                                             \
@@ -33,81 +43,67 @@ inline void gpuAssert(cudaError_t code, const char* file, int line, bool abort =
   }
 }
 
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// This is used to pass the command line options to the Cuda kernel.
+// The different methods for computing the shadow map which can be selected with --mode.
+enum class Mode { eLimbDarkening, eCircles, eLinear, eSmoothstep };
+
+// This is used to pass the command line options to the Cuda kernel and to the CPU threads.
 struct ShadowSettings {
   uint32_t size            = 512;
   bool     includeUmbra    = false;
   double   mappingExponent = 1.0;
+  Mode     mode            = Mode::eLimbDarkening;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-__constant__ LimbDarkening  cLimbDarkening;
-__constant__ ShadowSettings cShadowSettings;
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-// Computes the shadow map by sampling the intersection area between circles representing the Sun
-// and the occluder. This makes use of the global limb darkening function.
-__global__ void computeLimbDarkeningShadow(float* shadowMap) {
-  uint32_t x = blockIdx.x * blockDim.x + threadIdx.x;
-  uint32_t y = blockIdx.y * blockDim.y + threadIdx.y;
-  uint32_t i = y * cShadowSettings.size + x;
-
-  if ((x >= cShadowSettings.size) || (y >= cShadowSettings.size)) {
-    return;
-  }
-
-  auto angles = math::mapPixelToAngles(glm::ivec2(x, y), cShadowSettings.size,
-      cShadowSettings.mappingExponent, cShadowSettings.includeUmbra);
-
+// Computes the shadow by sampling the intersection area between circles representing the Sun and
+// the occluder. This makes use of the given limb darkening function.
+__host__ __device__ float computeLimbDarkeningShadow(
+    glm::dvec2 const& angles, LimbDarkening const& limbDarkening) {
   double sunArea = math::getCircleArea(1.0);
 
-  shadowMap[i] = static_cast<float>(
-      1 - math::sampleCircleIntersection(1.0, angles.x, angles.y, cLimbDarkening) / sunArea);
+  return static_cast<float>(
+      1 - math::sampleCircleIntersection(1.0, angles.x, angles.y, limbDarkening) / sunArea);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Computes the shadow map by analytically computing the intersection area between circles
+// Computes the shadow by analytically computing the intersection area between circles
 // representing the Sun and the occluder. This does not use a limb darkening function.
-__global__ void computeCircleIntersectionShadow(float* shadowMap) {
-  uint32_t x = blockIdx.x * blockDim.x + threadIdx.x;
-  uint32_t y = blockIdx.y * blockDim.y + threadIdx.y;
-  uint32_t i = y * cShadowSettings.size + x;
-
-  if ((x >= cShadowSettings.size) || (y >= cShadowSettings.size)) {
-    return;
-  }
-
-  auto angles = math::mapPixelToAngles(glm::ivec2(x, y), cShadowSettings.size,
-      cShadowSettings.mappingExponent, cShadowSettings.includeUmbra);
-
+__host__ __device__ float computeCircleIntersectionShadow(glm::dvec2 const& angles) {
   double sunArea = math::getCircleArea(1.0);
 
-  shadowMap[i] =
-      static_cast<float>(1.0 - math::getCircleIntersection(1.0, angles.x, angles.y) / sunArea);
+  return static_cast<float>(1.0 - math::getCircleIntersection(1.0, angles.x, angles.y) / sunArea);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Computes the shadow map by assuming a linear brightness gradient from the outer edge of the
-// penumbra to the start of the umbra / antumbra. In the antumbra, the shadow intensity decreases
+// Computes the shadow by assuming a linear brightness gradient from the outer edge of the penumbra
+// to the start of the umbra / antumbra. In the antumbra, the shadow intensity decreases
 // quadratically. This does not use a limb darkening function.
-__global__ void computeLinearShadow(float* shadowMap) {
-  uint32_t x = blockIdx.x * blockDim.x + threadIdx.x;
-  uint32_t y = blockIdx.y * blockDim.y + threadIdx.y;
-  uint32_t i = y * cShadowSettings.size + x;
+__host__ __device__ float computeLinearShadow(glm::dvec2 const& angles) {
+  double phiSun = 1.0;
+  double phiOcc = angles[0];
+  double delta  = angles[1];
 
-  if ((x >= cShadowSettings.size) || (y >= cShadowSettings.size)) {
-    return;
-  }
+  double visiblePortion =
+      (delta - glm::abs(phiSun - phiOcc)) / (phiSun + phiOcc - glm::abs(phiSun - phiOcc));
+
+  double maxDepth = glm::min(1.0, glm::pow(phiOcc / phiSun, 2.0));
+
+  return static_cast<float>(1.0 - maxDepth * glm::clamp(1.0 - visiblePortion, 0.0, 1.0));
+}
 
-  auto angles = math::mapPixelToAngles(glm::ivec2(x, y), cShadowSettings.size,
-      cShadowSettings.mappingExponent, cShadowSettings.includeUmbra);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Computes the shadow by assuming a smoothstep-based brightness gradient from the outer edge of
+// the penumbra to the start of the umbra / antumbra. In the antumbra, the shadow intensity
+// decreases quadratically. This does not use a limb darkening function.
+__host__ __device__ float computeSmoothstepShadow(glm::dvec2 const& angles) {
   double phiSun = 1.0;
   double phiOcc = angles[0];
   double delta  = angles[1];
@@ -117,15 +113,44 @@ __global__ void computeLinearShadow(float* shadowMap) {
 
   double maxDepth = glm::min(1.0, glm::pow(phiOcc / phiSun, 2.0));
 
-  shadowMap[i] = static_cast<float>(1.0 - maxDepth * glm::clamp(1.0 - visiblePortion, 0.0, 1.0));
+  return static_cast<float>(
+      1.0 - maxDepth * glm::clamp(1.0 - glm::smoothstep(0.0, 1.0, visiblePortion), 0.0, 1.0));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Computes the shadow map by assuming a smoothstep-based brightness gradient from the outer edge of
-// the penumbra to the start of the umbra / antumbra. In the antumbra, the shadow intensity
-// decreases quadratically. This does not use a limb darkening function.
-__global__ void computeSmoothstepShadow(float* shadowMap) {
+// Computes the value of a single pixel of the shadow map. This is used by the Cuda kernel as well
+// as by the CPU implementation.
+__host__ __device__ float computeShadow(ShadowSettings const& settings,
+    LimbDarkening const& limbDarkening, uint32_t x, uint32_t y) {
+
+  auto angles = math::mapPixelToAngles(
+      glm::ivec2(x, y), settings.size, settings.mappingExponent, settings.includeUmbra);
+
+  switch (settings.mode) {
+  case Mode::eLimbDarkening:
+    return computeLimbDarkeningShadow(angles, limbDarkening);
+  case Mode::eCircles:
+    return computeCircleIntersectionShadow(angles);
+  case Mode::eLinear:
+    return computeLinearShadow(angles);
+  case Mode::eSmoothstep:
+    return computeSmoothstepShadow(angles);
+  }
+
+  return 1.F;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ECLIPSE_SHADOW_GENERATOR_CPU_ONLY
+
+__constant__ LimbDarkening  cLimbDarkening;
+__constant__ ShadowSettings cShadowSettings;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+__global__ void computeShadowKernel(float* shadowMap) {
   uint32_t x = blockIdx.x * blockDim.x + threadIdx.x;
   uint32_t y = blockIdx.y * blockDim.y + threadIdx.y;
   uint32_t i = y * cShadowSettings.size + x;
@@ -134,20 +159,98 @@ __global__ void computeSmoothstepShadow(float* shadowMap) {
     return;
   }
 
-  auto angles = math::mapPixelToAngles(glm::ivec2(x, y), cShadowSettings.size,
-      cShadowSettings.mappingExponent, cShadowSettings.includeUmbra);
+  shadowMap[i] = computeShadow(cShadowSettings, cLimbDarkening, x, y);
+}
 
-  double phiSun = 1.0;
-  double phiOcc = angles[0];
-  double delta  = angles[1];
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  double visiblePortion =
-      (delta - glm::abs(phiSun - phiOcc)) / (phiSun + phiOcc - glm::abs(phiSun - phiOcc));
+// Computes the entire shadow map with the Cuda kernel above.
+void computeShadowMapGPU(
+    ShadowSettings const& settings, LimbDarkening const& limbDarkening, std::vector<float>& map) {
 
-  double maxDepth = glm::min(1.0, glm::pow(phiOcc / phiSun, 2.0));
+  // Initialize the global Cuda symbols.
+  gpuErrchk(cudaMemcpyToSymbol(cShadowSettings, &settings, sizeof(ShadowSettings)));
+  gpuErrchk(cudaMemcpyToSymbol(cLimbDarkening, &limbDarkening, sizeof(LimbDarkening)));
 
-  shadowMap[i] = static_cast<float>(
-      1.0 - maxDepth * glm::clamp(1.0 - glm::smoothstep(0.0, 1.0, visiblePortion), 0.0, 1.0));
+  // Compute the 2D kernel size.
+  dim3     blockSize(16, 16);
+  uint32_t numBlocksX = (settings.size + blockSize.x - 1) / blockSize.x;
+  uint32_t numBlocksY = (settings.size + blockSize.y - 1) / blockSize.y;
+  dim3     gridSize   = dim3(numBlocksX, numBlocksY);
+
+  // Allocate the shared memory for the shadow map.
+  float* shadow = nullptr;
+  gpuErrchk(cudaMallocManaged(
+      &shadow, static_cast<size_t>(settings.size * settings.size) * sizeof(float)));
+
+  computeShadowKernel<<<gridSize, blockSize>>>(shadow);
+
+  gpuErrchk(cudaPeekAtLastError());
+  gpuErrchk(cudaDeviceSynchronize());
+
+  map.assign(shadow, shadow + static_cast<size_t>(settings.size * settings.size));
+
+  gpuErrchk(cudaFree(shadow));
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Computes the entire shadow map on the CPU. The rows of the map are distributed in an interleaved
+// fashion over the given number of threads, as the rows differ a lot in how expensive they are.
+void computeShadowMapCPU(ShadowSettings const& settings, LimbDarkening const& limbDarkening,
+    uint32_t threadCount, std::vector<float>& map) {
+
+  map.resize(static_cast<size_t>(settings.size * settings.size));
+
+  std::vector<std::thread> threads;
+
+  for (uint32_t t = 0; t < threadCount; ++t) {
+    threads.emplace_back([&, t]() {
+      for (uint32_t y = t; y < settings.size; y += threadCount) {
+        for (uint32_t x = 0; x < settings.size; ++x) {
+          map[y * settings.size + x] = computeShadow(settings, limbDarkening, x, y);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Reads the output files of all eclipse shadow maps from the "graphics.eclipseShadowMaps" section
+// of a CosmoScout VR settings file. Bodies without a "texture" use the built-in fallback texture
+// and are skipped.
+std::set<std::string> readBatchOutputs(std::string const& settingsFile) {
+  std::ifstream stream(settingsFile);
+
+  if (!stream) {
+    throw std::runtime_error("Cannot open file '" + settingsFile + "'!");
+  }
+
+  nlohmann::json settings;
+  stream >> settings;
+
+  std::set<std::string> outputs;
+
+  auto graphics = settings.find("graphics");
+  if (graphics == settings.end() || !graphics->contains("eclipseShadowMaps")) {
+    return outputs;
+  }
+
+  for (auto const& [body, shadowMap] : graphics->at("eclipseShadowMaps").items()) {
+    auto texture = shadowMap.find("texture");
+    if (texture != shadowMap.end()) {
+      outputs.insert(texture->get<std::string>());
+    }
+  }
+
+  return outputs;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -160,8 +263,17 @@ int main(int argc, char** argv) {
 
   std::string cOutput    = "shadow.hdr";
   std::string cMode      = "limb-darkening";
+  std::string cBatch     = "";
+  uint32_t    cThreads   = std::max(1U, std::thread::hardware_concurrency());
+  bool        cOverwrite = false;
   bool        cPrintHelp = false;
 
+#ifdef ECLIPSE_SHADOW_GENERATOR_CPU_ONLY
+  bool cUseCPU = true;
+#else
+  bool cUseCPU = false;
+#endif
+
   // First configure all possible command line options.
   cs::utils::CommandLine args(
       "Welcome to the shadow map generator! Here are the available options:");
@@ -180,6 +292,18 @@ int main(int argc, char** argv) {
       "umbra's end in the middle of the texture, larger values will shift this to the "
       "right. (default: " +
           std::to_string(settings.mappingExponent) + ").");
+  args.addArgument({"--batch"}, &cBatch,
+      "Instead of writing a single image to --output, write the shadow map to all textures given "
+      "in the eclipseShadowMaps section of this CosmoScout VR settings file. Existing files are "
+      "skipped.");
+  args.addArgument({"--overwrite"}, &cOverwrite,
+      "Also overwrite existing files in --batch mode (default: " + std::to_string(cOverwrite) +
+          ").");
+  args.addArgument({"--cpu"}, &cUseCPU,
+      "Compute the shadow map on the CPU instead of using Cuda (default: " +
+          std::to_string(cUseCPU) + ").");
+  args.addArgument({"--threads"}, &cThreads,
+      "The number of threads used by --cpu (default: " + std::to_string(cThreads) + ").");
   args.addArgument({"-h", "--help"}, &cPrintHelp, "Show this help message.");
 
   // Then do the actual parsing.
@@ -198,49 +322,80 @@ int main(int argc, char** argv) {
   }
 
   // Check whether a valid mode was given.
-  if (cMode != "limb-darkening" && cMode != "circles" && cMode != "linear" &&
-      cMode != "smoothstep") {
+  if (cMode == "limb-darkening") {
+    settings.mode = Mode::eLimbDarkening;
+  } else if (cMode == "circles") {
+    settings.mode = Mode::eCircles;
+  } else if (cMode == "linear") {
+    settings.mode = Mode::eLinear;
+  } else if (cMode == "smoothstep") {
+    settings.mode = Mode::eSmoothstep;
+  } else {
     std::cerr << "Invalid value given for --mode!" << std::endl;
 
     return 1;
   }
 
-  // Initialize the limb darkening model.
-  LimbDarkening limbDarkening;
-  limbDarkening.init();
+#ifdef ECLIPSE_SHADOW_GENERATOR_CPU_ONLY
+  if (!cUseCPU) {
+    std::cerr << "This version of the shadow map generator has been built without Cuda support!"
+              << std::endl;
 
-  // Initialize the global Cuda symbols.
-  cudaMemcpyToSymbol(cShadowSettings, &settings, sizeof(ShadowSettings));
-  cudaMemcpyToSymbol(cLimbDarkening, &limbDarkening, sizeof(LimbDarkening));
+    return 1;
+  }
+#endif
+
+  // Collect all files which should be written. In batch mode, all requested textures are written
+  // from the same shadow map, so it has to be computed only once.
+  std::set<std::string> outputs;
+
+  if (cBatch.empty()) {
+    outputs.insert(cOutput);
+  } else {
+    try {
+      outputs = readBatchOutputs(cBatch);
+    } catch (std::exception const& e) {
+      std::cerr << "Failed to read batch file: " << e.what() << std::endl;
+      return 1;
+    }
 
-  // Compute the 2D kernel size.
-  dim3     blockSize(16, 16);
-  uint32_t numBlocksX = (settings.size + blockSize.x - 1) / blockSize.x;
-  uint32_t numBlocksY = (settings.size + blockSize.y - 1) / blockSize.y;
-  dim3     gridSize   = dim3(numBlocksX, numBlocksY);
+    if (!cOverwrite) {
+      for (auto it = outputs.begin(); it != outputs.end();) {
+        it = std::ifstream(*it).good() ? outputs.erase(it) : std::next(it);
+      }
+    }
 
-  // Allocate the shared memory for the shadow map.
-  float* shadow = nullptr;
-  gpuErrchk(cudaMallocManaged(
-      &shadow, static_cast<size_t>(settings.size * settings.size) * sizeof(float)));
+    if (outputs.empty()) {
+      std::cout << "All shadow maps already exist." << std::endl;
+      return 0;
+    }
+  }
+
+  // Initialize the limb darkening model.
+  LimbDarkening limbDarkening;
+  limbDarkening.init();
 
   // Compute the shadow map based on the given mode.
-  if (cMode == "limb-darkening") {
-    computeLimbDarkeningShadow<<<gridSize, blockSize>>>(shadow);
-  } else if (cMode == "circles") {
-    computeCircleIntersectionShadow<<<gridSize, blockSize>>>(shadow);
-  } else if (cMode == "linear") {
-    computeLinearShadow<<<gridSize, blockSize>>>(shadow);
-  } else if (cMode == "smoothstep") {
-    computeSmoothstepShadow<<<gridSize, blockSize>>>(shadow);
+  std::vector<float> shadow;
+
+  if (cUseCPU) {
+    computeShadowMapCPU(settings, limbDarkening, std::max(1U, cThreads), shadow);
+  } else {
+#ifndef ECLIPSE_SHADOW_GENERATOR_CPU_ONLY
+    computeShadowMapGPU(settings, limbDarkening, shadow);
+#endif
   }
 
-  gpuErrchk(cudaPeekAtLastError());
-  gpuErrchk(cudaDeviceSynchronize());
+  // Finally write the output textures!
+  for (auto const& output : outputs) {
+    if (!stbi_write_hdr(output.c_str(), static_cast<int>(settings.size),
+            static_cast<int>(settings.size), 1, shadow.data())) {
+      std::cerr << "Failed to write '" << output << "'!" << std::endl;
+      return 1;
+    }
 
-  // Finally write the output texture!
-  stbi_write_hdr(
-      cOutput.c_str(), static_cast<int>(settings.size), static_cast<int>(settings.size), 1, shadow);
+    std::cout << "Written '" << output << "'." << std::endl;
+  }
 
   return 0;
 }
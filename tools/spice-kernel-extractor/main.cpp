@@ -0,0 +1,391 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/CommandLine.hpp"
+
+#include <boost/filesystem.hpp>
+#include <cspice/SpiceUsr.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPICE strings in text kernels may not be longer than this. Longer file names are split into
+// several strings using the continuation character '+'.
+const std::size_t MAX_KERNEL_STRING_LENGTH = 78;
+
+// This suffices for the file names, types and sources returned by kdata_c().
+const SpiceInt MAX_KERNEL_DATA_LENGTH = 1024;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Throws a std::runtime_error with the long SPICE error message if a SPICE call has failed.
+void checkSpiceError(std::string const& action) {
+  if (failed_c()) {
+    int32_t const maxSpiceErrorLength = 1841;
+
+    std::array<SpiceChar, maxSpiceErrorLength> msg{};
+    getmsg_c("LONG", maxSpiceErrorLength, msg.data());
+    reset_c();
+    throw std::runtime_error(action + ": " + msg.data());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The time interval in ephemeris time for which the position of a NAIF body is required.
+struct Interval {
+  double mStart;
+  double mEnd;
+};
+
+// Stores the union of the given interval and the existing interval of the body. Returns true if
+// the interval of the body has grown.
+bool addInterval(std::map<SpiceInt, Interval>& intervals, SpiceInt body, Interval interval) {
+  auto it = intervals.find(body);
+
+  if (it == intervals.end()) {
+    intervals.emplace(body, interval);
+    return true;
+  }
+
+  if (interval.mStart < it->second.mStart || interval.mEnd > it->second.mEnd) {
+    it->second.mStart = std::min(it->second.mStart, interval.mStart);
+    it->second.mEnd   = std::max(it->second.mEnd, interval.mEnd);
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// One segment of a loaded SPK file. The descriptor is the packed DAF summary which is required
+// by spksub_c().
+struct Segment {
+  SpiceInt                   mHandle;
+  std::array<SpiceDouble, 5> mDescriptor;
+  std::string                mIdentifier;
+  SpiceInt                   mTarget;
+  SpiceInt                   mCenter;
+  Interval                   mInterval;
+};
+
+// Returns all segments of the given SPK file in the order in which they are stored. SPICE
+// prefers later segments over earlier ones, so this order has to be kept when they are written.
+std::vector<Segment> readSegments(SpiceInt handle) {
+  std::vector<Segment> segments;
+
+  dafbfs_c(handle);
+
+  SpiceBoolean found = SPICEFALSE;
+  daffna_c(&found);
+
+  while (found && !failed_c()) {
+    Segment segment{};
+    segment.mHandle = handle;
+
+    std::array<SpiceDouble, 2> dc{};
+    std::array<SpiceInt, 6>    ic{};
+    dafgs_c(segment.mDescriptor.data());
+    dafus_c(segment.mDescriptor.data(), 2, 6, dc.data(), ic.data());
+
+    std::array<SpiceChar, 41> identifier{};
+    dafgn_c(static_cast<SpiceInt>(identifier.size()), identifier.data());
+
+    segment.mIdentifier = identifier.data();
+    segment.mTarget     = ic[0];
+    segment.mCenter     = ic[1];
+    segment.mInterval   = {dc[0], dc[1]};
+    segments.push_back(segment);
+
+    daffna_c(&found);
+  }
+
+  checkSpiceError("Failed to read the segments of an SPK file");
+
+  return segments;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Writes the given string as one or more SPICE strings. Each line of the result has one string.
+std::string toKernelString(std::string const& value) {
+  std::string result;
+
+  for (std::size_t i = 0; i < value.size(); i += MAX_KERNEL_STRING_LENGTH) {
+    bool last = i + MAX_KERNEL_STRING_LENGTH >= value.size();
+    result += "    '" + value.substr(i, MAX_KERNEL_STRING_LENGTH) + (last ? "'\n" : "+'\n");
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+
+  std::string cSettings  = "../share/config/simple_desktop.json";
+  std::string cOutput    = "../share/config/spice/extracted";
+  std::string cBodies    = "";
+  double      cMargin    = 1.0;
+  bool        cPrintHelp = false;
+
+  // First configure all possible command line options.
+  cs::utils::CommandLine args(
+      "Welcome to the SPICE kernel extractor! Here are the available options:");
+  args.addArgument({"-s", "--settings"}, &cSettings,
+      "The CosmoScout VR settings file to read the SPICE kernel and the objects from (default: \"" +
+          cSettings + "\").");
+  args.addArgument({"-o", "--output"}, &cOutput,
+      "The directory to write the extracted SPK file and the new meta kernel to (default: \"" +
+          cOutput + "\").");
+  args.addArgument({"-b", "--bodies"}, &cBodies,
+      "A comma-separated list of additional SPICE bodies which are required for the entire time "
+      "range of all objects, for example the targets of csp-trajectories.");
+  args.addArgument({"-m", "--margin"}, &cMargin,
+      "The number of days which are added before and after the existence of each object "
+      "(default: " +
+          std::to_string(cMargin) + ").");
+  args.addArgument({"-h", "--help"}, &cPrintHelp, "Show this help message.");
+
+  // Then do the actual parsing.
+  try {
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    args.parse(arguments);
+  } catch (std::runtime_error const& e) {
+    std::cerr << "Failed to parse command line arguments: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // When cPrintHelp was set to true, we print a help message and exit.
+  if (cPrintHelp) {
+    args.printHelp();
+    return 0;
+  }
+
+  // Continue execution on errors and disable the default error reports, the errors are reported
+  // by checkSpiceError() instead.
+  std::string actionReturn = "RETURN";
+  erract_c("SET", 0, actionReturn.data());
+
+  std::string actionNull = "NULL";
+  errdev_c("SET", 0, actionNull.data());
+
+  std::map<SpiceInt, Interval> intervals;
+  std::vector<std::string>     kernels;
+  std::vector<Segment>         segments;
+  uintmax_t                    spkBytes = 0;
+
+  try {
+    nlohmann::json settings;
+    std::ifstream  stream(cSettings);
+    if (!stream) {
+      throw std::runtime_error("Failed to open '" + cSettings + "'!");
+    }
+
+    stream >> settings;
+
+    // Load all kernels as CosmoScout VR does.
+    std::string metaKernel = settings.at("spiceKernel");
+    furnsh_c(metaKernel.c_str());
+    checkSpiceError("Failed to load '" + metaKernel + "'");
+
+    // The position of each object is required during its existence.
+    Interval total{std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+
+    for (auto const& [name, object] : settings.at("objects").items()) {
+      std::string                center    = object.at("center");
+      std::array<std::string, 2> existence = object.at("existence");
+
+      SpiceInt     body  = 0;
+      SpiceBoolean found = SPICEFALSE;
+      bodn2c_c(center.c_str(), &body, &found);
+      checkSpiceError("Failed to find the NAIF ID of '" + center + "'");
+
+      if (!found) {
+        std::cout << "Skipping object '" << name << "': Its center '" << center
+                  << "' is not a SPICE body." << std::endl;
+        continue;
+      }
+
+      Interval interval{};
+      str2et_c(existence[0].c_str(), &interval.mStart);
+      str2et_c(existence[1].c_str(), &interval.mEnd);
+      checkSpiceError("Failed to parse the existence of '" + name + "'");
+
+      interval.mStart -= cMargin * spd_c();
+      interval.mEnd += cMargin * spd_c();
+
+      addInterval(intervals, body, interval);
+
+      total.mStart = std::min(total.mStart, interval.mStart);
+      total.mEnd   = std::max(total.mEnd, interval.mEnd);
+    }
+
+    std::stringstream bodyStream(cBodies);
+    std::string       item;
+    while (std::getline(bodyStream, item, ',')) {
+      SpiceInt     body  = 0;
+      SpiceBoolean found = SPICEFALSE;
+      bodn2c_c(item.c_str(), &body, &found);
+      checkSpiceError("Failed to find the NAIF ID of '" + item + "'");
+
+      if (!found) {
+        throw std::runtime_error("'" + item + "' is not a SPICE body!");
+      }
+
+      addInterval(intervals, body, total);
+    }
+
+    // Collect the segments of all SPK files and the names of all other kernels in load order.
+    SpiceInt count = 0;
+    ktotal_c("ALL", &count);
+
+    for (SpiceInt i = 0; i < count; ++i) {
+      std::array<SpiceChar, MAX_KERNEL_DATA_LENGTH> file{};
+      std::array<SpiceChar, MAX_KERNEL_DATA_LENGTH> type{};
+      std::array<SpiceChar, MAX_KERNEL_DATA_LENGTH> source{};
+      SpiceInt                                      handle = 0;
+      SpiceBoolean                                  found  = SPICEFALSE;
+
+      kdata_c(i, "ALL", MAX_KERNEL_DATA_LENGTH, MAX_KERNEL_DATA_LENGTH, MAX_KERNEL_DATA_LENGTH,
+          file.data(), type.data(), source.data(), &handle, &found);
+      checkSpiceError("Failed to get the loaded kernels");
+
+      std::string fileName(file.data());
+      std::string fileType(type.data());
+
+      if (fileType == "META") {
+        continue;
+      }
+
+      if (fileType == "SPK") {
+        auto fileSegments = readSegments(handle);
+        segments.insert(segments.end(), fileSegments.begin(), fileSegments.end());
+        spkBytes += boost::filesystem::file_size(fileName);
+      } else {
+        kernels.push_back(boost::filesystem::absolute(fileName).string());
+      }
+    }
+  } catch (std::exception const& e) {
+    std::cerr << "Failed to read the kernels: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // The position of a target is computed relative to the center of its segment. Hence, the
+  // centers of all required segments are required for the same interval as well. This is repeated
+  // until no further intervals are added.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+
+    for (auto const& segment : segments) {
+      auto interval = intervals.find(segment.mTarget);
+
+      if (interval == intervals.end() || segment.mInterval.mEnd < interval->second.mStart ||
+          segment.mInterval.mStart > interval->second.mEnd) {
+        continue;
+      }
+
+      Interval clipped{std::max(segment.mInterval.mStart, interval->second.mStart),
+          std::min(segment.mInterval.mEnd, interval->second.mEnd)};
+
+      changed = addInterval(intervals, segment.mCenter, clipped) || changed;
+    }
+  }
+
+  // Write the required parts of all required segments to one SPK file.
+  boost::filesystem::path outputDirectory(cOutput);
+  auto                    spkFile  = (outputDirectory / "extracted.bsp").string();
+  auto                    metaFile = (outputDirectory / "extracted.txt").string();
+
+  try {
+    boost::filesystem::create_directories(outputDirectory);
+
+    // spkopn_c() fails if the file already exists.
+    boost::filesystem::remove(spkFile);
+
+    SpiceInt output = 0;
+    spkopn_c(spkFile.c_str(), "CosmoScout VR", 0, &output);
+    checkSpiceError("Failed to create '" + spkFile + "'");
+
+    std::size_t written = 0;
+
+    for (auto const& segment : segments) {
+      auto interval = intervals.find(segment.mTarget);
+
+      if (interval == intervals.end() || segment.mInterval.mEnd < interval->second.mStart ||
+          segment.mInterval.mStart > interval->second.mEnd) {
+        continue;
+      }
+
+      double start = std::max(segment.mInterval.mStart, interval->second.mStart);
+      double end   = std::min(segment.mInterval.mEnd, interval->second.mEnd);
+
+      // spksub_c() takes a non-const descriptor.
+      auto descriptor = segment.mDescriptor;
+      spksub_c(
+          segment.mHandle, descriptor.data(), segment.mIdentifier.c_str(), start, end, output);
+      checkSpiceError("Failed to extract the segment '" + segment.mIdentifier + "'");
+
+      ++written;
+    }
+
+    spkcls_c(output);
+    checkSpiceError("Failed to write '" + spkFile + "'");
+
+    std::cout << "Extracted " << written << " of " << segments.size() << " segments for "
+              << intervals.size() << " bodies. The SPK data has been reduced from "
+              << spkBytes / 1024 << " KiB to " << boost::filesystem::file_size(spkFile) / 1024
+              << " KiB." << std::endl;
+  } catch (std::exception const& e) {
+    std::cerr << "Failed to write the extracted kernel: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // All other kernels are loaded from their original location.
+  std::ofstream meta(metaFile);
+  meta << "KPL/MK\n\n";
+  meta << "This meta kernel has been written by the spice-kernel-extractor for " << cSettings
+       << ".\n\n";
+  meta << "\\begindata\n\nKERNELS_TO_LOAD = (\n";
+
+  for (auto const& kernel : kernels) {
+    meta << toKernelString(kernel);
+  }
+
+  meta << toKernelString(boost::filesystem::absolute(spkFile).string());
+  meta << ")\n\n\\begintext\n";
+
+  if (!meta) {
+    std::cerr << "Failed to write '" << metaFile << "'!" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Set \"spiceKernel\" to \"" << metaFile << "\" to use the extracted kernel."
+            << std::endl;
+
+  return 0;
+}
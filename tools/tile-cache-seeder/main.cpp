@@ -0,0 +1,462 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../plugins/csp-lod-bodies/src/HEALPix.hpp"
+#include "../../plugins/csp-lod-bodies/src/Plugin.hpp"
+#include "../../plugins/csp-lod-bodies/src/TileSourceWebMapService.hpp"
+#include "../../src/cs-core/Settings.hpp"
+#include "../../src/cs-utils/CommandLine.hpp"
+#include "../../src/cs-utils/convert.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace csp::lodbodies;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A longitude-latitude rectangle in radians. Regions crossing the date line are not supported,
+// they have to be split into two regions.
+struct Region {
+  glm::dvec2 mMin;
+  glm::dvec2 mMax;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// One dataset of a body which should be written to the cache.
+struct Job {
+  std::string                              mName;
+  Plugin::Settings::Dataset                mDataset;
+  TileDataType                             mType;
+  uint32_t                                 mResolution;
+  std::vector<TileId>                      mTiles;
+  std::shared_ptr<TileSourceWebMapService> mSource;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Spaces the requests to the servers so that not more than the given number of requests per
+// second are started. This is shared by all worker threads.
+class RateLimiter {
+ public:
+  explicit RateLimiter(double requestsPerSecond)
+      : mInterval(requestsPerSecond > 0.0 ? std::chrono::duration<double>(1.0 / requestsPerSecond)
+                                          : std::chrono::duration<double>(0.0)) {
+  }
+
+  void wait() {
+    if (mInterval.count() == 0.0) {
+      return;
+    }
+
+    std::chrono::steady_clock::time_point slot;
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto                        now = std::chrono::steady_clock::now();
+      mNextSlot                       = std::max(mNextSlot, now);
+      slot                            = mNextSlot;
+      mNextSlot += std::chrono::duration_cast<std::chrono::steady_clock::duration>(mInterval);
+    }
+
+    std::this_thread::sleep_until(slot);
+  }
+
+ private:
+  std::chrono::duration<double>         mInterval;
+  std::chrono::steady_clock::time_point mNextSlot;
+  std::mutex                            mMutex;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Parses a region given as "lngMin,latMin,lngMax,latMax" in degrees.
+Region parseRegion(std::string const& value) {
+  std::stringstream   stream(value);
+  std::vector<double> values;
+  std::string         item;
+
+  while (std::getline(stream, item, ',')) {
+    values.push_back(std::stod(item));
+  }
+
+  if (values.size() != 4 || values[0] >= values[2] || values[1] >= values[3]) {
+    throw std::runtime_error(
+        "Invalid region '" + value + "'! Expected lngMin,latMin,lngMax,latMax.");
+  }
+
+  return {cs::utils::convert::toRadians(glm::dvec2(values[0], values[1])),
+      cs::utils::convert::toRadians(glm::dvec2(values[2], values[3]))};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns a conservative longitude-latitude bounding rectangle of the given tile. Tiles touching
+// a pole or crossing the date line cover the entire longitude range.
+Region getBounds(TileId const& tileId) {
+  auto corners = HEALPix::getCornersLngLat(tileId);
+  auto center  = HEALPix::getCenterLngLat(tileId);
+
+  Region bounds{center, center};
+  for (auto const& corner : corners) {
+    bounds.mMin = glm::min(bounds.mMin, corner);
+    bounds.mMax = glm::max(bounds.mMax, corner);
+  }
+
+  double const poleLat = glm::half_pi<double>() - 1e-6;
+
+  if (bounds.mMax.x - bounds.mMin.x > glm::pi<double>() || bounds.mMax.y > poleLat ||
+      bounds.mMin.y < -poleLat) {
+    bounds.mMin.x = -glm::pi<double>();
+    bounds.mMax.x = glm::pi<double>();
+  }
+
+  // The edges of HEALPix tiles are curved in longitude-latitude space, so the rectangle is grown
+  // by a quarter of its size.
+  glm::dvec2 margin = (bounds.mMax - bounds.mMin) * 0.25;
+  bounds.mMin -= margin;
+  bounds.mMax += margin;
+
+  return bounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool overlaps(Region const& a, Region const& b) {
+  return a.mMin.x <= b.mMax.x && b.mMin.x <= a.mMax.x && a.mMin.y <= b.mMax.y &&
+         b.mMin.y <= a.mMax.y;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Recursively collects all tiles between minLevel and maxLevel which overlap any of the regions.
+// Children are only visited if their parent overlaps a region, so this also works for deep
+// levels of small regions.
+void collectTiles(TileId const& tileId, int minLevel, int maxLevel,
+    std::vector<Region> const& regions, std::vector<TileId>& tiles) {
+  auto bounds = getBounds(tileId);
+
+  if (std::none_of(regions.begin(), regions.end(),
+          [&](Region const& region) { return overlaps(region, bounds); })) {
+    return;
+  }
+
+  if (tileId.level() >= minLevel) {
+    tiles.push_back(tileId);
+  }
+
+  if (tileId.level() < maxLevel) {
+    for (glm::int64 child = 0; child < 4; ++child) {
+      collectTiles(TileId(tileId.level() + 1, tileId.patchIdx() * 4 + child), minLevel, maxLevel,
+          regions, tiles);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates a region around each bookmark of the given body. Only bookmarks with a position given
+// in the body-fixed frame of the body can be used.
+std::vector<Region> getBookmarkRegions(
+    nlohmann::json const& settings, std::string const& body, double radius) {
+  std::vector<Region> regions;
+
+  if (!settings.contains("bookmarks")) {
+    return regions;
+  }
+
+  auto const& object = settings.at("objects").at(body);
+  std::string center = object.at("center");
+  std::string frame  = object.at("frame");
+
+  for (auto const& j : settings.at("bookmarks")) {
+    cs::core::Settings::Bookmark bookmark;
+    from_json(j, bookmark);
+
+    if (!bookmark.mLocation || !bookmark.mLocation->mPosition ||
+        bookmark.mLocation->mCenter != center) {
+      continue;
+    }
+
+    if (bookmark.mLocation->mFrame != frame) {
+      std::cout << "Skipping bookmark '" << bookmark.mName << "': Its frame '"
+                << bookmark.mLocation->mFrame << "' is not the body-fixed frame '" << frame << "'."
+                << std::endl;
+      continue;
+    }
+
+    // The direction from the center of the body is sufficient, as the radius around the bookmark
+    // is much larger than the difference between geocentric and geodetic latitude.
+    auto lngLat =
+        cs::utils::convert::cartesianToLngLat(*bookmark.mLocation->mPosition, glm::dvec3(1.0));
+
+    double latRadius = cs::utils::convert::toRadians(radius);
+    double lngRadius = latRadius / std::max(std::cos(lngLat.y), 1e-3);
+
+    regions.push_back({lngLat - glm::dvec2(lngRadius, latRadius),
+        lngLat + glm::dvec2(lngRadius, latRadius)});
+
+    std::cout << "Using bookmark '" << bookmark.mName << "' at "
+              << cs::utils::convert::toDegrees(lngLat.x) << ", "
+              << cs::utils::convert::toDegrees(lngLat.y) << "." << std::endl;
+  }
+
+  return regions;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+
+  std::string cSettings       = "../share/config/simple_desktop.json";
+  std::string cBody           = "Earth";
+  std::string cDataset        = "";
+  std::string cRegion         = "";
+  int32_t     cMinLevel       = 0;
+  int32_t     cMaxLevel       = 8;
+  bool        cBookmarks      = false;
+  double      cBookmarkRadius = 1.0;
+  uint32_t    cThreads        = std::max(1U, std::thread::hardware_concurrency());
+  double      cRate           = 10.0;
+  bool        cPrintHelp      = false;
+
+  // First configure all possible command line options.
+  cs::utils::CommandLine args(
+      "Welcome to the tile cache seeder! Here are the available options:");
+  args.addArgument({"-s", "--settings"}, &cSettings,
+      "The CosmoScout VR settings file to read the datasets and cache settings from (default: \"" +
+          cSettings + "\").");
+  args.addArgument({"-b", "--body"}, &cBody,
+      "The name of the body in the csp-lod-bodies settings (default: \"" + cBody + "\").");
+  args.addArgument({"-d", "--dataset"}, &cDataset,
+      "Only seed the image or elevation dataset with this name. All datasets of the body are "
+      "seeded if this is not given.");
+  args.addArgument({"--region"}, &cRegion,
+      "Only seed tiles overlapping this region, given as lngMin,latMin,lngMax,latMax in degrees. "
+      "Multiple regions can be separated by semicolons. The entire body is seeded if neither "
+      "--region nor --bookmarks is given.");
+  args.addArgument({"--bookmarks"}, &cBookmarks,
+      "Seed the surroundings of all bookmarks of the body which have a position (default: " +
+          std::to_string(cBookmarks) + ").");
+  args.addArgument({"--bookmark-radius"}, &cBookmarkRadius,
+      "The radius in degrees around each bookmark (default: " + std::to_string(cBookmarkRadius) +
+          ").");
+  args.addArgument({"--min-level"}, &cMinLevel,
+      "The coarsest HEALPix level to seed (default: " + std::to_string(cMinLevel) + ").");
+  args.addArgument({"--max-level"}, &cMaxLevel,
+      "The finest HEALPix level to seed. This is limited to the maxLevel of each dataset "
+      "(default: " +
+          std::to_string(cMaxLevel) + ").");
+  args.addArgument({"--threads"}, &cThreads,
+      "The number of parallel downloads (default: " + std::to_string(cThreads) + ").");
+  args.addArgument({"--rate"}, &cRate,
+      "The maximum number of tiles requested per second, zero disables the limit (default: " +
+          std::to_string(cRate) + ").");
+  args.addArgument({"-h", "--help"}, &cPrintHelp, "Show this help message.");
+
+  // Then do the actual parsing.
+  try {
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    args.parse(arguments);
+  } catch (std::runtime_error const& e) {
+    std::cerr << "Failed to parse command line arguments: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // When cPrintHelp was set to true, we print a help message and exit.
+  if (cPrintHelp) {
+    args.printHelp();
+    return 0;
+  }
+
+  // Read the settings of the plugin and the regions to seed.
+  nlohmann::json                settings;
+  Plugin::Settings              pluginSettings;
+  Plugin::Settings::Body const* bodySettings = nullptr;
+  std::vector<Region>           regions;
+
+  try {
+    std::ifstream stream(cSettings);
+    if (!stream) {
+      throw std::runtime_error("Failed to open '" + cSettings + "'!");
+    }
+
+    stream >> settings;
+    from_json(settings.at("plugins").at("csp-lod-bodies"), pluginSettings);
+
+    auto body = pluginSettings.mBodies.find(cBody);
+    if (body == pluginSettings.mBodies.end()) {
+      throw std::runtime_error("There is no body '" + cBody + "' in the csp-lod-bodies settings!");
+    }
+
+    bodySettings = &body->second;
+
+    std::stringstream regionStream(cRegion);
+    std::string       item;
+    while (std::getline(regionStream, item, ';')) {
+      regions.push_back(parseRegion(item));
+    }
+
+    if (cBookmarks) {
+      auto bookmarkRegions = getBookmarkRegions(settings, cBody, cBookmarkRadius);
+      regions.insert(regions.end(), bookmarkRegions.begin(), bookmarkRegions.end());
+
+      if (bookmarkRegions.empty()) {
+        std::cout << "There are no bookmarks with a position on '" << cBody << "'." << std::endl;
+      }
+    }
+  } catch (std::exception const& e) {
+    std::cerr << "Failed to read the settings: " << e.what() << std::endl;
+    return 1;
+  }
+
+  if (regions.empty()) {
+    if (cBookmarks || !cRegion.empty()) {
+      return 0;
+    }
+
+    regions.push_back({glm::dvec2(-glm::pi<double>(), -glm::half_pi<double>()),
+        glm::dvec2(glm::pi<double>(), glm::half_pi<double>())});
+  }
+
+  // Create one job for each web map service dataset. Datasets read from GeoTIFF files do not
+  // need a cache and offline datasets cannot be downloaded.
+  std::vector<Job> jobs;
+
+  auto addJobs = [&](std::map<std::string, Plugin::Settings::Dataset> const& datasets,
+                     TileDataType type, uint32_t resolution) {
+    for (auto const& [name, dataset] : datasets) {
+      if (dataset.mFile || dataset.mURL == "offline" || (!cDataset.empty() && cDataset != name)) {
+        continue;
+      }
+
+      Job job{name, dataset, type, resolution, {}, nullptr};
+
+      int32_t maxLevel = std::min(cMaxLevel, static_cast<int32_t>(dataset.mMaxLevel));
+      for (glm::int64 basePatch = 0; basePatch < 12; ++basePatch) {
+        collectTiles(TileId(0, basePatch), cMinLevel, maxLevel, regions, job.mTiles);
+      }
+
+      // Sorting the tiles by their key requests coarse levels first, so that an interrupted run
+      // leaves a usable cache behind.
+      std::sort(job.mTiles.begin(), job.mTiles.end(),
+          [](TileId const& a, TileId const& b) { return a.key() < b.key(); });
+
+      job.mSource = std::make_shared<TileSourceWebMapService>(resolution);
+      job.mSource->setCacheDirectory(pluginSettings.mMapCache.get());
+      job.mSource->setTileCacheSize(pluginSettings.mTileCacheSize.get());
+      job.mSource->setCompressColorTiles(pluginSettings.mCompressTiles.get());
+      job.mSource->setCompressElevationTiles(pluginSettings.mCompressTiles.get());
+      job.mSource->setLayers(dataset.mLayers);
+      job.mSource->setUrl(dataset.mURL);
+      job.mSource->setDataType(type);
+
+      jobs.push_back(std::move(job));
+    }
+  };
+
+  addJobs(bodySettings->mImgDatasets, TileDataType::eColor,
+      pluginSettings.mTileResolutionIMG.get());
+  addJobs(bodySettings->mDemDatasets, TileDataType::eElevation,
+      pluginSettings.mTileResolutionDEM.get());
+
+  if (jobs.empty()) {
+    std::cerr << "There are no matching web map service datasets for '" << cBody << "'!"
+              << std::endl;
+    return 1;
+  }
+
+  RateLimiter rateLimiter(cRate);
+  bool        failed = false;
+
+  for (auto const& job : jobs) {
+    std::cout << "Seeding " << job.mTiles.size() << " tiles of '" << job.mName << "'..."
+              << std::endl;
+
+    auto cache = job.mSource->getTileCache();
+
+    if (cache && cache->getSlotCount() < job.mTiles.size()) {
+      std::cout << "Warning: The tile cache can only hold " << cache->getSlotCount()
+                << " tiles. Increase 'tileCacheSize' to keep all of them!" << std::endl;
+    }
+
+    std::atomic<size_t> nextTile{0};
+    std::atomic<size_t> cachedTiles{0};
+    std::atomic<size_t> loadedTiles{0};
+    std::atomic<size_t> failedTiles{0};
+
+    auto worker = [&]() {
+      for (size_t i = nextTile++; i < job.mTiles.size(); i = nextTile++) {
+        auto const& tileId = job.mTiles[i];
+
+        // Tiles which are already in the TileCache are skipped. This makes it possible to resume
+        // an interrupted run. Without a TileCache, the web map service source skips tiles whose
+        // files have been downloaded already.
+        if (cache) {
+          auto key = TileCache::getKey(tileId, job.mType, job.mResolution, job.mDataset.mURL,
+              job.mDataset.mLayers);
+
+          if (cache->read(key, [](void const* /*payload*/) {})) {
+            ++cachedTiles;
+            continue;
+          }
+        }
+
+        rateLimiter.wait();
+
+        // This downloads, decodes and stores the tile in the same way CosmoScout VR would do it.
+        if (job.mSource->loadTile(tileId)) {
+          ++loadedTiles;
+        } else {
+          ++failedTiles;
+        }
+
+        size_t done = cachedTiles + loadedTiles + failedTiles;
+        if (done % 100 == 0) {
+          std::cout << "  " << done << " / " << job.mTiles.size() << " tiles done." << std::endl;
+        }
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < std::max(1U, cThreads); ++i) {
+      threads.emplace_back(worker);
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    std::cout << "Finished '" << job.mName << "': " << loadedTiles << " loaded, " << cachedTiles
+              << " already cached, " << failedTiles << " failed." << std::endl;
+
+    failed = failed || failedTiles > 0;
+  }
+
+  return failed ? 1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////